@@ -24,10 +24,16 @@
 #ifndef IBACKEND_H
 #define IBACKEND_H
 
+#include <cstdint>
 #include <functional>
+#include <memory>
 
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "IInput.h"
 
 namespace Backend
 {
@@ -36,6 +42,29 @@ class IOutput;
 class IProfile;
 class IFilterInfo;
 
+/**
+ *  \brief     What probing a file tells about it.
+ */
+struct MediaInfo
+{
+    // In frames, at the profile's frame rate
+    int64_t         length = 0;
+    // The media's own frame rate, 0 when it has no video
+    double          fps = 0;
+    int             width = 0;
+    int             height = 0;
+    double          aspectRatio = 0;
+    std::string     videoCodec;
+    std::string     audioCodec;
+    int             nbVideoTracks = 0;
+    int             nbAudioTracks = 0;
+    // Of the default audio stream, 0 when it has no audio
+    int             sampleRate = 0;
+    int             nbChannels = 0;
+    // Backend specific, allows an input to be opened without probing the file again
+    std::map<std::string, std::string>  properties;
+};
+
 class IBackend
 {
     public:
@@ -47,13 +76,149 @@ class IBackend
             None
         };
         using LogHandler = std::function<void( LogLevel logLevel, const char* msg )>;
+        // Makes an OpenGL context current on the calling thread, false on failure
+        using GpuContextProvider = std::function<bool()>;
+        enum DecodePriority
+        {
+            // Plays in the timeline or the previews: shares the decode thread budget
+            Foreground,
+            // Thumbnails, waveforms and the other short lived accesses
+            Background
+        };
 
         virtual ~IBackend() = default;
+        // The project's profile
         virtual IProfile&                   profile() = 0;
+        /**
+         *  \brief     Returns a new profile, initialized as the project's one.
+         *
+         *  Changing it doesn't affect the project, nor the services created from other
+         *  profiles: an export renders in its own one, at its own size and frame rate.
+         */
+        virtual std::unique_ptr<IProfile>   createProfile() const = 0;
         virtual const std::map<std::string, IFilterInfo*>&    availableFilters() const = 0;
+        /**
+         *  \brief     The identifiers of all the registered filters, sorted, without
+         *             reading their metadata as availableFilters() does.
+         *
+         *  Some aren't meant to be used on their own: filterInfo() returns nullptr for
+         *  those, once it read their metadata.
+         */
+        virtual std::vector<std::string>                      filterIdentifiers() const = 0;
         virtual IFilterInfo*                                  filterInfo( const std::string& id ) const = 0;
 
         virtual void                        setLogHandler( LogHandler logHandler ) = 0;
+        /**
+         *  \brief     Messages below level are dropped by the backend itself, before
+         *             they get formatted or reach the handler.
+         */
+        virtual void                        setLogLevel( LogLevel level ) = 0;
+
+        /**
+         *  \brief     Returns an input opened on path, reusing an idle one when possible.
+         *
+         *  The input is exclusively owned by the caller until the returned pointer is
+         *  released, at which point it goes back to the backend's decoder cache.
+         *  Meant for short lived accesses such as thumbnails, waveforms or snapshots.
+         *  The seek precision is only honoured by the decoder when it opens, so idle
+         *  inputs are only reused for the same precision.
+         */
+        virtual std::shared_ptr<IInput>     acquireInput( const std::string& path,
+                                                          IInput::SeekPrecision precision = IInput::Exact ) = 0;
+
+        /**
+         *  \brief     Reads the properties of the media at path.
+         *
+         *  Only the demuxer gets opened, and closed before returning, none of the
+         *  filters an input would decode through are created.
+         *  \throws    InvalidServiceException if the file can't be opened.
+         */
+        virtual MediaInfo                   probe( const std::string& path ) = 0;
+
+        /**
+         *  \brief     Encodes a few blank frames to target using the given video codec.
+         *
+         *  Used to check whether an encoder is usable, which compiled in hardware
+         *  encoders often aren't without the matching device or driver.
+         *  \returns   false if the encoding failed or didn't complete in time. The caller
+         *             should still check that target isn't empty.
+         */
+        virtual bool                        probeVideoEncoder( const std::string& codec,
+                                                               const std::string& target ) = 0;
+
+        /**
+         *  \brief     Hardware decoding APIs which have a usable device on this machine.
+         */
+        virtual const std::vector<std::string>& availableHardwareDecoders() const = 0;
+        /**
+         *  \brief     Sets the hardware decoding API of the inputs opened from now on.
+         *
+         *  An empty api decodes in software. The decoder still falls back to software
+         *  when the device can't be initialized for a given stream.
+         */
+        virtual void                        setHardwareDecoding( const std::string& api ) = 0;
+        /**
+         *  \brief     Overrides the hardware decoding API for a single file.
+         *
+         *  "none" forces software decoding, and an empty api restores the global one.
+         */
+        virtual void                        setMediaHardwareDecoding( const std::string& path,
+                                                                      const std::string& api ) = 0;
+        /**
+         *  \returns   The API to use when opening path, or an empty string for software.
+         */
+        virtual std::string                 hardwareDecoding( const std::string& path ) const = 0;
+
+        /**
+         *  \brief     Sets the number of threads the decoders opened from now on share.
+         *
+         *  Background decoders get a single thread each. The foreground ones split what
+         *  is left of the budget evenly. 0 leaves each decoder pick its own threading.
+         */
+        virtual void                        setDecodeThreadBudget( int threads ) = 0;
+        /**
+         *  \brief     Overrides the budget's share for the decoders of a single file.
+         *
+         *  0 restores the budget.
+         */
+        virtual void                        setMediaDecodeThreads( const std::string& path,
+                                                                   int threads ) = 0;
+        /**
+         *  \returns   The number of threads to decode path with, or 0 for the decoder's
+         *             own choice.
+         */
+        virtual int                         decodeThreads( const std::string& path,
+                                                           DecodePriority priority ) const = 0;
+
+        /**
+         *  \brief     Makes the inputs opened from now on for path decode proxy instead.
+         *
+         *  An empty proxy removes it. \sa IInput::cloneOriginals()
+         */
+        virtual void                        setProxy( const std::string& path, const std::string& proxy ) = 0;
+        /**
+         *  \returns   The proxies, indexed by the path of their original media.
+         */
+        virtual std::unordered_map<std::string, std::string>    proxies() const = 0;
+        /**
+         *  \returns   The number of decoders alive, idle ones included. Clips cut from
+         *             the same input share its decoder, and aren't counted.
+         */
+        virtual uint32_t                    nbDecoders() const = 0;
+
+        /**
+         *  \returns   true if the filters and compositing can run on the graphics card.
+         */
+        virtual bool                        isGpuProcessingAvailable() const = 0;
+        /**
+         *  \brief     Processes the GPU capable filters on the graphics card, through OpenGL.
+         *
+         *  provider is called from each rendering thread before its first frame. Must
+         *  be called before any input or output gets created, and can't be undone.
+         *  \returns   false if GPU processing isn't available.
+         */
+        virtual bool                        setGpuProcessing( GpuContextProvider provider ) = 0;
+        virtual bool                        gpuProcessing() const = 0;
 };
 
 extern IBackend* instance();
@@ -56,6 +56,8 @@ namespace Backend
         virtual const std::string&  description() const = 0;
         virtual const std::string&  author() const = 0;
         virtual const std::vector<IParameterInfo*>& paramInfos() const = 0;
+        // Runs on the graphics card, and is only usable with IBackend::setGpuProcessing()
+        virtual bool                isGpu() const = 0;
     };
 
     class IFilter
@@ -25,6 +25,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
 
 namespace Backend
 {
@@ -41,6 +42,51 @@ namespace Backend
         virtual void    onErrorEncountered() = 0;
     };
 
+    /**
+     *  \brief  A decoded picture, owning the backend buffer it points to.
+     *
+     *  Frames are immutable once returned, and can be shared between threads. The
+     *  buffer stays valid for as long as a reference to the frame is held.
+     */
+    class IVideoFrame
+    {
+    public:
+        enum Format
+        {
+            // 8 bits per component, R G B A in memory order
+            RGBA,
+            // 8 bits planar: the Y plane, followed by the U and V planes at half
+            // the width and height. stride() is the Y plane's
+            YUV420P,
+            // 8 bits packed, Y U Y V in memory order: two bytes per pixel
+            YUV422,
+        };
+
+        virtual ~IVideoFrame() = default;
+        virtual const uint8_t*  data() const = 0;
+        virtual uint32_t        width() const = 0;
+        virtual uint32_t        height() const = 0;
+        // Number of bytes per line
+        virtual uint32_t        stride() const = 0;
+        virtual Format          format() const = 0;
+    };
+
+    /**
+     *  \brief  Decoded audio samples of a single frame, owning the backend buffer.
+     *
+     *  Samples are signed 16 bits, interleaved.
+     */
+    class IAudioFrame
+    {
+    public:
+        virtual ~IAudioFrame() = default;
+        virtual const int16_t*  samples() const = 0;
+        // Number of samples per channel
+        virtual uint32_t        nbSamples() const = 0;
+        virtual uint32_t        channels() const = 0;
+        virtual uint32_t        frequency() const = 0;
+    };
+
     class IInput
     {
     public:
@@ -51,7 +97,22 @@ namespace Backend
             Unlimited = -3
         };
 
+        enum SeekPrecision
+        {
+            // Land on the requested frame, decoding from the previous keyframe if needed
+            Exact,
+            // Land on the requested frame too, but skip the in-loop filters of the frames
+            // decoded to reach it. Cheaper on long GOP codecs, and slightly blocky: meant
+            // for the thumbnails of files which aren't indexed, and for scrubbing.
+            Fast
+        };
+
         virtual ~IInput() = default;
+        /**
+         *  \brief Replaces the callback, nullptr stops the notifications.
+         *
+         *  Position changes are reported at most at the display rate while playing.
+         */
         virtual void            setCallback( IInputEventCb* callback ) = 0;
 
         virtual const char*     path() const = 0;
@@ -64,6 +125,20 @@ namespace Backend
         // Absolute position in frames
         virtual std::unique_ptr<IInput>      cut( int64_t begin  = 0, int64_t end  = EndOfMedia ) = 0;
         virtual bool            isCut( ) const = 0 ;
+        // Deep copy of the whole producer graph, which can be consumed from another
+        // thread independently of this one
+        virtual std::unique_ptr<IInput>      clone() const = 0;
+        // Same as clone(), decoding the original medias instead of their proxies
+        virtual std::unique_ptr<IInput>      cloneOriginals() const = 0;
+        // Same as clone(), the copy rendering at the size and frame rate of profile. Its
+        // positions are converted to the profile's frame rate.
+        virtual std::unique_ptr<IInput>      clone( IProfile& profile ) const = 0;
+        // The whole producer graph and the profile, as an MLT XML document which melt
+        // can render. The original medias are referenced instead of their proxies.
+        virtual std::string     toXml() const = 0;
+        // The whole producer graph, as its copies are made from it, with the original
+        // medias. Two inputs with the same snapshot render the same frames.
+        virtual std::string     snapshot() const = 0;
 
         virtual bool            sameClip( IInput& that ) const = 0;
         virtual bool            runsInto( IInput& that ) const = 0;
@@ -78,6 +153,15 @@ namespace Backend
         // The position in frame relative to its beginning
         virtual int64_t         position() const = 0;
         virtual void            setPosition( int64_t position ) = 0;
+        /**
+         *  \brief Affects the frames decoded after the following setPosition() calls.
+         *
+         *  A file's decoder only reads it when it opens, on the first decoded frame: it
+         *  has to be set before that. On a sequence, it only switches its audio to the
+         *  PCM caches while scrubbing, as its clips' decoders are opened already.
+         */
+        virtual void            setSeekPrecision( SeekPrecision precision ) = 0;
+        virtual SeekPrecision   seekPrecision() const = 0;
 
         // The absolete position in frame
         virtual int64_t         frame() const = 0;
@@ -85,8 +169,15 @@ namespace Backend
         // Generates an 8-bit grayscale image at the current position
         virtual uint8_t*        waveform( uint32_t width, uint32_t height ) const = 0;
 
-        // Generates an 32-bit RGBA image at the current position
-        virtual uint8_t*        image( uint32_t width, uint32_t height ) const = 0;
+        // Decodes the audio of the frame at the current position, resampled as requested,
+        // or returns nullptr
+        virtual std::shared_ptr<IAudioFrame>    audio( uint32_t frequency, uint32_t channels ) const = 0;
+
+        // Decodes an image at the current position, or returns nullptr. Asking for the
+        // decoder's own format (usually YUV420P) spares a conversion.
+        // The returned size may differ from the requested one
+        virtual std::shared_ptr<IVideoFrame>    image( uint32_t width, uint32_t height,
+                                                       IVideoFrame::Format format = IVideoFrame::RGBA ) const = 0;
 
         virtual double          fps() const = 0;
         virtual double          aspectRatio() const = 0;
@@ -100,6 +191,9 @@ namespace Backend
         virtual void            playPause() = 0;
         virtual void            setPause( bool isPaused ) = 0;
         virtual bool            isPaused() const = 0;
+        // Playback speed, negative values play backward. 0 pauses
+        virtual void            setSpeed( double speed ) = 0;
+        virtual double          speed() const = 0;
         virtual void            nextFrame() = 0;
         virtual void            previousFrame() = 0;
 
@@ -111,6 +205,20 @@ namespace Backend
         virtual int             filterCount() const = 0;
         virtual bool            moveFilter( int from, int to ) = 0;
         virtual std::shared_ptr<IFilter>  filter( int index ) const = 0;
+
+        /**
+         *  \brief  The backend object implementing this input.
+         *
+         *  A single backend is built in, so every input it's given is one of its own,
+         *  and this replaces a dynamic_cast through the virtual base.
+         *  \sa     Backend/MLT/MLTBinding.h
+         */
+        template <typename T>
+        T*                      implementation() const { return static_cast<T*>( m_implementation ); }
+
+    protected:
+        // Set by the backend, to its own object
+        void*                   m_implementation = nullptr;
     };
 }
 
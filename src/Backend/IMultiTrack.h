@@ -42,6 +42,7 @@ namespace Backend
         virtual IInput*     track( int index ) const = 0;
         virtual int         count() const = 0;
         virtual void        addTransition( ITransition& transition, int aTrack = 0, int bTrack = 1 ) = 0;
+        virtual void        removeTransition( ITransition& transition ) = 0;
         virtual void        addFilter( IFilter& filter, int track = 0 ) = 0;
         virtual bool        connect( IInput& input ) = 0;
     };
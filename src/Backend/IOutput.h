@@ -26,10 +26,41 @@
 #include <string>
 #include <cstdint>
 #include <cstddef>
+#include <memory>
 
 namespace Backend
 {
     class IInput;
+    class IVideoFrame;
+
+    struct EncoderOptions
+    {
+        // Encoder names as known by libavcodec. Empty means the container's default
+        std::string     videoCodec;
+        std::string     audioCodec;
+        // Pixel format as known by libavutil. Empty picks the encoder's default
+        std::string     pixelFormat;
+        std::string     preset;
+        // Device node used by hardware encoders which need one, such as VAAPI's
+        std::string     hardwareDevice;
+        // Threads used by the codec itself, 0 lets it decide
+        int             encoderThreads = 0;
+        // Threads used to render the frames feeding the encoder
+        int             renderThreads = 1;
+        // Drop frames to keep up with real time, instead of maximizing throughput
+        bool            dropFrames = false;
+        // Maximum number of frames between two keyframes, 0 for the codec default
+        int             gopSize = 0;
+        // Write a fragmented mp4, which can be read while it is being written
+        bool            fragmented = false;
+        // Encode the video in two passes, the first one only analyzing it
+        bool            twoPass = false;
+        // The pass being encoded when twoPass is set: 1 writes the statistics to
+        // passLogFile, 2 reads them back. 0 encodes in a single pass
+        int             pass = 0;
+        // Without the "_2pass.log" suffix the encoder appends to it
+        std::string     passLogFile;
+    };
 
     class IOutputEventCb
     {
@@ -39,6 +70,53 @@ namespace Backend
         virtual void    onStopped() = 0;
         virtual void    onVolumeChanged() = 0;
         virtual void    onErrorEncountered() = 0;
+        // Frames dropped to keep up with real time, since the previous call
+        virtual void    onFramesDropped( uint32_t nbDropped ) = 0;
+        // Times the sound card ran out of samples to play, since the previous call
+        virtual void    onAudioUnderrun( uint32_t nbUnderruns ) = 0;
+    };
+
+    /**
+     *  \brief  Taps the frames an output consumes, without rendering them again.
+     *
+     *  Both methods are called from the output's thread.
+     */
+    class IOutputFrameCb
+    {
+    public:
+        virtual ~IOutputFrameCb() = default;
+        // Returns true to receive the image of the frame at position through onImage()
+        virtual bool    wantsImage( int64_t position ) = 0;
+        virtual void    onImage( std::shared_ptr<IVideoFrame> frame ) = 0;
+    };
+
+    /**
+     *  \brief  Receives a hash of the image of every frame an output consumes, as it was
+     *          rendered for the output, from the output's thread. \sa Tools::hashFrame()
+     */
+    class IOutputHashCb
+    {
+    public:
+        virtual ~IOutputHashCb() = default;
+        virtual void    onFrameHash( int64_t position, uint64_t hash ) = 0;
+    };
+
+    /**
+     *  \brief  Receives the audio of the frames an output consumes, in order, from the
+     *          output's thread.
+     */
+    class IOutputAudioCb
+    {
+    public:
+        virtual ~IOutputAudioCb() = default;
+        /**
+         *  \param  master  The interleaved samples of the frame, nullptr if they couldn't
+         *                  be rendered
+         *  \param  stems   nbStems buffers the size of master, one after the other, if the
+         *                  tracks were mixed into stems, nullptr otherwise.
+         */
+        virtual void    onAudio( int64_t position, const float* master, const float* stems,
+                                 uint32_t nbStems, uint32_t nbSamples, uint32_t nbChannels ) = 0;
     };
 
     class IOutput
@@ -54,6 +132,11 @@ namespace Backend
         virtual void    start() = 0;
         virtual void    stop() = 0;
         virtual bool    isStopped() const = 0;
+        /**
+         * @brief purge Drops the frames rendered ahead, so that the next seek is
+         *              shown without waiting for them.
+         */
+        virtual void    purge() = 0;
 
         virtual int     volume() const = 0;
         virtual void    setVolume( int volume ) = 0;
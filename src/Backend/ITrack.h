@@ -25,6 +25,7 @@
 
 #include "IInput.h"
 #include <string>
+#include <vector>
 
 namespace Backend
 {
@@ -38,6 +39,47 @@ namespace Backend
         virtual bool        append( IInput& input ) = 0;
         // src and dist are frames.
         virtual bool        move( int src, int dist ) = 0;
+        /**
+         *  \brief  Moves the clip playing at src so it starts at dist, in frames.
+         *
+         *  When the clip stays between its neighbours, only the blanks around it are
+         *  resized, and the clip is never taken out of the track.
+         */
+        virtual bool        reposition( int64_t src, int64_t dist ) = 0;
+
+        /**
+         *  Trimming edits. Each of them is done in a single pass over the track, and
+         *  fails without changing anything when a clip would go past the boundaries of
+         *  its media. Positions and deltas are frames.
+         */
+        // Removes the clip playing at position, and moves everything after it back
+        virtual bool        rippleRemove( int64_t position ) = 0;
+        // Inserts the input before what plays at startFrame, and moves it forward
+        virtual bool        rippleInsert( IInput& input, int64_t startFrame ) = 0;
+        // Moves the cut between the two entries meeting at position
+        virtual bool        roll( int64_t position, int64_t delta ) = 0;
+        // Shows another part of the clip's media, without moving nor resizing it
+        virtual bool        slip( int64_t position, int64_t delta ) = 0;
+        // Moves the clip, trimming its neighbours so that nothing else moves
+        virtual bool        slide( int64_t position, int64_t delta ) = 0;
+        /**
+         *  \brief  Replaces count clips, starting with the one playing at position, by
+         *          inputs laid end to end.
+         *
+         *  The clips must follow each other without blanks, and the inputs last as long
+         *  as them, so that nothing else moves. Splitting a clip in many pieces, or
+         *  joining them back, is then done in a single pass over the track.
+         */
+        virtual bool        replace( int64_t position, int count, const std::vector<IInput*>& inputs ) = 0;
+        /**
+         *  \brief  Inserts the inputs at startFrames, sorted and not overlapping each
+         *          other, in a single pass over the track.
+         *
+         *  They must all fit in the same blank, or after the end of the track. Fails
+         *  without changing anything otherwise.
+         */
+        virtual bool        insertMany( const std::vector<IInput*>& inputs,
+                                        const std::vector<int64_t>& startFrames ) = 0;
         virtual IInput*     clip( int index ) const = 0;
         virtual IInput*     clipAt( int64_t position ) const = 0 ;
         virtual bool        resizeClip( int clip, int64_t begin, int64_t end ) = 0;
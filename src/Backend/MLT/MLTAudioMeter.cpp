@@ -0,0 +1,170 @@
+/*****************************************************************************
+ * MLTAudioMeter.cpp: Audio levels of an input
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MLTAudioMeter.h"
+#include "MLTInput.h"
+
+#include <mlt++/MltProducer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+using namespace Backend::MLT;
+
+struct MLTAudioMeter::State
+{
+    Tools::SpscRing<Level, 64>  queue;
+    // Cleared when the filter is destroyed, along with its producer
+    std::atomic<bool>           attached;
+    // Only valid while attached
+    mlt_service                 producer;
+    mlt_filter                  filter;
+};
+
+namespace
+{
+
+const char  MeterProperty[] = "_vlmc_audio_meter";
+
+void
+destroy( void* data )
+{
+    auto state = static_cast<std::shared_ptr<MLTAudioMeter::State>*>( data );
+    ( *state )->attached = false;
+    delete state;
+}
+
+// Samples are read as floats in [-1, 1], interleaved or planar
+template <typename T>
+void
+measure( const T* samples, int nbSamples, int channels, bool planar, float scale,
+         MLTAudioMeter::Level& level )
+{
+    for ( int c = 0; c < (int)level.channels; ++c )
+    {
+        float peak = 0.f;
+        double sumSq = 0.;
+        auto s = planar == true ? samples + c * nbSamples : samples + c;
+        auto step = planar == true ? 1 : channels;
+        for ( int i = 0; i < nbSamples; ++i, s += step )
+        {
+            float v = *s * scale;
+            peak = std::max( peak, std::fabs( v ) );
+            sumSq += v * v;
+        }
+        level.peak[c] = peak;
+        level.meanSquare[c] = static_cast<float>( sumSq / nbSamples );
+    }
+}
+
+int
+getAudio( mlt_frame frame, void** buffer, mlt_audio_format* format, int* frequency,
+          int* channels, int* samples )
+{
+    auto filter = static_cast<mlt_filter>( mlt_frame_pop_audio( frame ) );
+    auto res = mlt_frame_get_audio( frame, buffer, format, frequency, channels, samples );
+    if ( res != 0 || *buffer == nullptr || *samples <= 0 || *channels <= 0 )
+        return res;
+    auto state = static_cast<std::shared_ptr<MLTAudioMeter::State>*>(
+                mlt_properties_get_data( MLT_FILTER_PROPERTIES( filter ), MeterProperty, nullptr ) );
+    if ( state == nullptr )
+        return res;
+
+    MLTAudioMeter::Level level;
+    level.position = mlt_frame_get_position( frame );
+    level.channels = std::min<uint32_t>( *channels, MLTAudioMeter::MaxChannels );
+    level.samples = *samples;
+    level.frequency = *frequency;
+    // Measure whatever the consumer asked for, rather than converting
+    switch ( *format )
+    {
+    case mlt_audio_s16:
+        measure( static_cast<const int16_t*>( *buffer ), *samples, *channels, false, 1.f / 32768, level );
+        break;
+    case mlt_audio_s32le:
+        measure( static_cast<const int32_t*>( *buffer ), *samples, *channels, false, 1.f / 2147483648.f, level );
+        break;
+    case mlt_audio_f32le:
+        measure( static_cast<const float*>( *buffer ), *samples, *channels, false, 1.f, level );
+        break;
+    case mlt_audio_float:
+        measure( static_cast<const float*>( *buffer ), *samples, *channels, true, 1.f, level );
+        break;
+    default:
+        return res;
+    }
+    ( *state )->queue.push( level );
+    return res;
+}
+
+mlt_frame
+process( mlt_filter filter, mlt_frame frame )
+{
+    mlt_frame_push_audio( frame, filter );
+    mlt_frame_push_audio( frame, reinterpret_cast<void*>( getAudio ) );
+    return frame;
+}
+
+}
+
+MLTAudioMeter::MLTAudioMeter( IInput& input )
+    : m_state( std::make_shared<State>() )
+{
+    m_state->attached = false;
+    m_state->producer = nullptr;
+    m_state->filter = nullptr;
+    auto mltInput = dynamic_cast<MLTInput*>( &input );
+    auto filter = mlt_filter_new();
+    if ( mltInput == nullptr || filter == nullptr )
+        return;
+    filter->process = process;
+    auto properties = MLT_FILTER_PROPERTIES( filter );
+    // Not written by the xml consumer, hence never copied to the exports
+    mlt_properties_set_int( properties, "_loader", 1 );
+    mlt_properties_set_int( properties, MLTInput::InternalFilterProperty, 1 );
+    mlt_properties_set_data( properties, MeterProperty, new std::shared_ptr<State>( m_state ), 0,
+                             destroy, nullptr );
+    m_state->producer = mltInput->producer()->get_service();
+    m_state->filter = filter;
+    m_state->attached = mlt_service_attach( m_state->producer, filter ) == 0;
+    // The producer holds its own reference
+    mlt_filter_close( filter );
+}
+
+MLTAudioMeter::~MLTAudioMeter()
+{
+    if ( m_state->attached == true )
+        mlt_service_detach( m_state->producer, m_state->filter );
+}
+
+bool
+MLTAudioMeter::isAttached() const
+{
+    return m_state->attached;
+}
+
+bool
+MLTAudioMeter::pop( Level& level )
+{
+    return m_state->queue.pop( level );
+}
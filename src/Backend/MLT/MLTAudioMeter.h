@@ -0,0 +1,82 @@
+/*****************************************************************************
+ * MLTAudioMeter.h: Audio levels of an input
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTAUDIOMETER_H
+#define MLTAUDIOMETER_H
+
+#include <cstdint>
+#include <memory>
+
+#include "Tools/SpscRing.h"
+
+namespace Backend
+{
+class IInput;
+
+namespace MLT
+{
+
+/**
+ *  \brief  Measures the audio played from an input, for the level meters.
+ *
+ *  Like the filter cache, the meter is an internal filter, attached after the input's
+ *  effects and never serialized. Its audio callback computes the peak and the mean
+ *  square of each channel of the frames, on the thread fetching their audio, and hands
+ *  them over through a lock-free queue: the audio is never held up by the reader, and
+ *  the measures are dropped when it falls behind.
+ *  The audio of an input is fetched by a single thread at a time, in order.
+ */
+class MLTAudioMeter
+{
+    public:
+        static const uint32_t   MaxChannels = 8;
+
+        struct Level
+        {
+            int64_t     position;
+            uint32_t    channels;
+            // Per channel
+            uint32_t    samples;
+            uint32_t    frequency;
+            // Linear, 1 is the full scale
+            float       peak[MaxChannels];
+            float       meanSquare[MaxChannels];
+        };
+
+        explicit MLTAudioMeter( IInput& input );
+        // Detaches the meter, if the input is still there
+        ~MLTAudioMeter();
+
+        // false once the input is gone, along with the meter's filter
+        bool            isAttached() const;
+        // Only called from a single thread
+        bool            pop( Level& level );
+
+    private:
+        struct State;
+        std::shared_ptr<State>  m_state;
+};
+
+}
+}
+
+#endif // MLTAUDIOMETER_H
@@ -0,0 +1,622 @@
+/*****************************************************************************
+ * MLTAudioMixer.cpp: Single pass mix of the audio tracks of a sequence
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MLTAudioMixer.h"
+#include "MLTInput.h"
+#include "MLTProfile.h"
+#include "Backend/IBackend.h"
+#include "Tools/AudioMix.h"
+#include "Tools/PcmCache.h"
+
+#include <mlt++/MltProducer.h>
+#include <mlt++/MltProfile.h>
+#include <mlt++/MltRepository.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace Backend::MLT;
+
+const char* const MLTAudioMixer::ServiceName = "vlmc_mixer";
+const char* const MLTAudioMixer::ScrubProperty = "_vlmc_scrub";
+
+namespace
+{
+
+const char  ConfigProperty[] = "_vlmc_mixer_config";
+const char  MixProperty[] = "_vlmc_mix";
+const char  ScrubSourcesProperty[] = "_vlmc_scrub_sources";
+const char  StemsProperty[] = "_vlmc_stems";
+// Gains change by steps of Block samples along a frame
+const int   Block = 64;
+
+// The parameters as parsed from the filter properties. Only used by the thread
+// fetching the frames.
+struct Config
+{
+    int                                 revision;
+    std::vector<float>                  gains;
+    std::vector<float>                  pans;
+    std::vector<MLTAudioMixer::Fade>    fades;
+    std::vector<MLTAudioMixer::ClipGain>    clipGains;
+    std::vector<int>                    stems;
+    uint32_t                            nbStems;
+};
+
+using ScrubSources = std::vector<MLTAudioMixer::ScrubSource>;
+
+// Swapped by the mixer while the audio thread reads them
+struct ScrubState
+{
+    std::shared_ptr<const ScrubSources>     sources;
+};
+
+// What a frame needs for its audio to be mixed, from whichever thread fetches it
+struct Mix
+{
+    std::vector<mlt_frame>  tracks;
+    // Per track, the left and right gains at the start of the frame, and of the next one
+    std::vector<float>      gains;
+    // Per track, where to read the audio from instead of the frame, when scrubbing
+    std::vector<const MLTAudioMixer::ScrubSource*>  scrub;
+    // Per track, the stem it is summed to as well, or -1
+    std::vector<int>        stems;
+    uint32_t                nbStems;
+    std::shared_ptr<const ScrubSources>     scrubSources;
+    int64_t                 position;
+    double                  fps;
+};
+
+template <typename T>
+void
+destroy( void* data )
+{
+    delete static_cast<T*>( data );
+}
+
+template <typename T>
+std::vector<T>
+parse( const char* str )
+{
+    std::vector<T>  values;
+    if ( str == nullptr )
+        return values;
+    std::istringstream  s( str );
+    s.imbue( std::locale::classic() );
+    T v;
+    while ( s >> v )
+        values.push_back( v );
+    return values;
+}
+
+const Config&
+config( mlt_filter filter )
+{
+    auto properties = MLT_FILTER_PROPERTIES( filter );
+    auto c = static_cast<Config*>( mlt_properties_get_data( properties, ConfigProperty, nullptr ) );
+    if ( c == nullptr )
+    {
+        c = new Config;
+        c->revision = -1;
+        mlt_properties_set_data( properties, ConfigProperty, c, 0, destroy<Config>, nullptr );
+    }
+    auto revision = mlt_properties_get_int( properties, "revision" );
+    if ( revision == c->revision )
+        return *c;
+    c->revision = revision;
+    c->gains = parse<float>( mlt_properties_get( properties, "gains" ) );
+    c->pans = parse<float>( mlt_properties_get( properties, "pans" ) );
+    c->fades.clear();
+    auto fades = parse<int64_t>( mlt_properties_get( properties, "fades" ) );
+    for ( size_t i = 0; i + 5 <= fades.size(); i += 5 )
+    {
+        c->fades.push_back( MLTAudioMixer::Fade{ (uint32_t)fades[i], (uint32_t)fades[i + 1],
+                                                 fades[i + 2], fades[i + 3], fades[i + 4] != 0 } );
+    }
+    c->clipGains.clear();
+    auto clipGains = parse<double>( mlt_properties_get( properties, "clipgains" ) );
+    for ( size_t i = 0; i + 4 <= clipGains.size(); i += 4 )
+    {
+        c->clipGains.push_back( MLTAudioMixer::ClipGain{ (uint32_t)clipGains[i], (int64_t)clipGains[i + 1],
+                                                         (int64_t)clipGains[i + 2], (float)clipGains[i + 3] } );
+    }
+    c->stems = parse<int>( mlt_properties_get( properties, "stems" ) );
+    c->nbStems = 0;
+    for ( auto s : c->stems )
+        c->nbStems = std::max<uint32_t>( c->nbStems, s + 1 );
+    return *c;
+}
+
+void
+trackGains( const Config& c, uint32_t track, int64_t position, float& left, float& right )
+{
+    auto gain = track < c.gains.size() ? c.gains[track] : 1.f;
+    auto pan = track < c.pans.size() ? c.pans[track] : 0.f;
+    for ( const auto& f : c.fades )
+    {
+        if ( ( f.aTrack != track && f.bTrack != track ) || position < f.begin || position >= f.end )
+            continue;
+        // The level of the bTrack, as the mix transitions used to do it, reached on the
+        // last frame
+        auto t = static_cast<float>( position - f.begin ) / std::max<int64_t>( 1, f.end - 1 - f.begin );
+        auto level = f.fadeOut == true ? 1.f - t : t;
+        gain *= f.bTrack == track ? level : 1.f - level;
+    }
+    for ( const auto& g : c.clipGains )
+    {
+        if ( g.track == track && position >= g.begin && position < g.end )
+            gain *= g.gain;
+    }
+    left = gain * std::min( 1.f, 1.f - pan );
+    right = gain * std::min( 1.f, 1.f + pan );
+}
+
+// Converts the samples to interleaved floats, with the mixer's channel count
+void
+toFloat( const void* buffer, mlt_audio_format format, int nbSamples, int channels,
+         int outChannels, float* out )
+{
+    for ( int c = 0; c < outChannels; ++c )
+    {
+        // Mono is sent to every channel, missing channels stay silent
+        auto sc = c < channels ? c : ( channels == 1 ? 0 : -1 );
+        if ( sc < 0 )
+        {
+            for ( int i = 0; i < nbSamples; ++i )
+                out[i * outChannels + c] = 0.f;
+            continue;
+        }
+        switch ( format )
+        {
+        case mlt_audio_s16:
+        {
+            auto s = static_cast<const int16_t*>( buffer ) + sc;
+            for ( int i = 0; i < nbSamples; ++i )
+                out[i * outChannels + c] = s[i * channels] / 32768.f;
+            break;
+        }
+        case mlt_audio_s32le:
+        {
+            auto s = static_cast<const int32_t*>( buffer ) + sc;
+            for ( int i = 0; i < nbSamples; ++i )
+                out[i * outChannels + c] = s[i * channels] / 2147483648.f;
+            break;
+        }
+        case mlt_audio_f32le:
+        {
+            auto s = static_cast<const float*>( buffer ) + sc;
+            for ( int i = 0; i < nbSamples; ++i )
+                out[i * outChannels + c] = s[i * channels];
+            break;
+        }
+        case mlt_audio_s32:
+        {
+            auto s = static_cast<const int32_t*>( buffer ) + sc * nbSamples;
+            for ( int i = 0; i < nbSamples; ++i )
+                out[i * outChannels + c] = s[i] / 2147483648.f;
+            break;
+        }
+        case mlt_audio_float:
+        {
+            auto s = static_cast<const float*>( buffer ) + sc * nbSamples;
+            for ( int i = 0; i < nbSamples; ++i )
+                out[i * outChannels + c] = s[i];
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+// Nearest sample resampling, which is enough for scrubbing
+void
+readScrubSource( const MLTAudioMixer::ScrubSource& source, int64_t position, double fps,
+                 int frequency, int nbSamples, int outChannels, float* out )
+{
+    thread_local std::vector<int16_t>   read;
+    thread_local std::vector<int16_t>   resampled;
+    const auto& pcm = *source.pcm;
+    auto channels = pcm.channels();
+    auto ratio = static_cast<double>( pcm.frequency() ) / frequency;
+    auto start = static_cast<int64_t>( ( source.offset + position - source.begin ) / fps * pcm.frequency() );
+    auto count = static_cast<int64_t>( std::ceil( nbSamples * ratio ) ) + 1;
+    read.resize( count * channels );
+    pcm.read( start, read.data(), count );
+    resampled.resize( nbSamples * channels );
+    for ( int i = 0; i < nbSamples; ++i )
+    {
+        auto s = std::min<int64_t>( static_cast<int64_t>( i * ratio ), count - 1 );
+        std::copy_n( read.data() + s * channels, channels, resampled.data() + i * channels );
+    }
+    toFloat( resampled.data(), mlt_audio_s16, nbSamples, channels, outChannels, out );
+}
+
+bool
+isSupported( mlt_audio_format format )
+{
+    return format == mlt_audio_s16 || format == mlt_audio_s32le || format == mlt_audio_f32le ||
+            format == mlt_audio_s32 || format == mlt_audio_float;
+}
+
+int
+getAudio( mlt_frame frame, void** buffer, mlt_audio_format* format, int* frequency,
+          int* channels, int* samples )
+{
+    auto mix = static_cast<Mix*>( mlt_properties_get_data( MLT_FRAME_PROPERTIES( frame ), MixProperty, nullptr ) );
+    // Without a sample count to produce, let the tractor provide the audio
+    if ( mix == nullptr || *samples <= 0 )
+        return mlt_frame_get_audio( frame, buffer, format, frequency, channels, samples );
+
+    auto outChannels = *channels > 0 ? *channels : 2;
+    auto outFrequency = *frequency > 0 ? *frequency : 48000;
+    auto nbSamples = *samples;
+    auto size = nbSamples * outChannels * (int)sizeof( float );
+    auto out = static_cast<float*>( mlt_pool_alloc( size ) );
+    std::fill( out, out + nbSamples * outChannels, 0.f );
+
+    thread_local std::vector<float>     scratch;
+    thread_local std::vector<float>     gains;
+    scratch.resize( nbSamples * outChannels );
+    gains.resize( outChannels );
+    std::unique_ptr<MLTAudioMixer::Stems>   stems;
+    if ( mix->nbStems > 0 )
+    {
+        stems.reset( new MLTAudioMixer::Stems );
+        stems->nbStems = mix->nbStems;
+        stems->nbSamples = nbSamples;
+        stems->nbChannels = outChannels;
+        stems->samples.assign( mix->nbStems * nbSamples * outChannels, 0.f );
+    }
+    for ( size_t t = 0; t < mix->tracks.size(); ++t )
+    {
+        auto track = mix->tracks[t];
+        const auto g = mix->gains.data() + t * 4;
+        if ( track == nullptr || ( g[0] == 0.f && g[1] == 0.f && g[2] == 0.f && g[3] == 0.f ) )
+            continue;
+        auto trackSamples = nbSamples;
+        if ( mix->scrub[t] != nullptr )
+        {
+            readScrubSource( *mix->scrub[t], mix->position, mix->fps, outFrequency, nbSamples,
+                             outChannels, scratch.data() );
+        }
+        else
+        {
+            void* trackBuffer = nullptr;
+            auto trackFormat = mlt_audio_f32le;
+            auto trackFrequency = outFrequency;
+            auto trackChannels = outChannels;
+            if ( mlt_frame_get_audio( track, &trackBuffer, &trackFormat, &trackFrequency,
+                                      &trackChannels, &trackSamples ) != 0 ||
+                 trackBuffer == nullptr || trackChannels <= 0 || trackSamples <= 0 ||
+                 trackFrequency != outFrequency || isSupported( trackFormat ) == false )
+                continue;
+            trackSamples = std::min( trackSamples, nbSamples );
+            toFloat( trackBuffer, trackFormat, trackSamples, trackChannels, outChannels, scratch.data() );
+        }
+
+        for ( int b = 0; b < trackSamples; b += Block )
+        {
+            auto len = std::min( Block, trackSamples - b );
+            auto r = ( b + len / 2.f ) / nbSamples;
+            auto left = g[0] + ( g[2] - g[0] ) * r;
+            auto right = g[1] + ( g[3] - g[1] ) * r;
+            for ( int c = 0; c < outChannels; ++c )
+                gains[c] = c == 0 ? left : c == 1 ? right : ( left + right ) / 2.f;
+            Tools::mixSamples( out + b * outChannels, scratch.data() + b * outChannels, len,
+                               outChannels, gains.data() );
+            if ( stems != nullptr && mix->stems[t] >= 0 )
+            {
+                auto stem = stems->samples.data() + ( mix->stems[t] * nbSamples + b ) * outChannels;
+                Tools::mixSamples( stem, scratch.data() + b * outChannels, len, outChannels, gains.data() );
+            }
+        }
+    }
+    if ( stems != nullptr )
+    {
+        mlt_properties_set_data( MLT_FRAME_PROPERTIES( frame ), StemsProperty, stems.release(), 0,
+                                 destroy<MLTAudioMixer::Stems>, nullptr );
+    }
+
+    mlt_frame_set_audio( frame, out, mlt_audio_f32le, size, mlt_pool_release );
+    *buffer = out;
+    *format = mlt_audio_f32le;
+    *frequency = outFrequency;
+    *channels = outChannels;
+    *samples = nbSamples;
+    return 0;
+}
+
+mlt_frame
+process( mlt_filter filter, mlt_frame frame )
+{
+    // The tractor keeps the frames of its tracks on the frame it returns, under
+    // "_<unique id>_<track>", followed by the frame marking the last track
+    auto producer = mlt_frame_get_original_producer( frame );
+    if ( producer == nullptr )
+        return frame;
+    auto id = mlt_properties_get( MLT_PRODUCER_PROPERTIES( producer ), "_unique_id" );
+    if ( id == nullptr )
+        return frame;
+    const auto& c = config( filter );
+    auto properties = MLT_FRAME_PROPERTIES( frame );
+    auto position = mlt_frame_get_position( frame );
+    auto prefix = std::string( "_" ) + id + "_";
+
+    std::unique_ptr<Mix> mix( new Mix );
+    mix->position = position;
+    mix->nbStems = c.nbStems;
+    mix->fps = mlt_profile_fps( mlt_service_profile( MLT_PRODUCER_SERVICE( producer ) ) );
+    auto scrubbing = mlt_properties_get_int( MLT_PRODUCER_PROPERTIES( mlt_producer_cut_parent( producer ) ),
+                                             MLTAudioMixer::ScrubProperty );
+    if ( scrubbing != 0 && mix->fps > 0 )
+    {
+        auto state = static_cast<ScrubState*>( mlt_properties_get_data( MLT_FILTER_PROPERTIES( filter ),
+                                                                        ScrubSourcesProperty, nullptr ) );
+        if ( state != nullptr )
+            mix->scrubSources = std::atomic_load( &state->sources );
+    }
+    for ( uint32_t i = 0; ; ++i )
+    {
+        auto track = static_cast<mlt_frame>( mlt_properties_get_data( properties,
+                                                  ( prefix + std::to_string( i ) ).c_str(), nullptr ) );
+        if ( track == nullptr )
+            break;
+        auto trackProperties = MLT_FRAME_PROPERTIES( track );
+        if ( mlt_properties_get_int( trackProperties, "last_track" ) != 0 )
+            break;
+        // Blank, muted or inactive tracks
+        if ( mlt_frame_is_test_audio( track ) != 0 || ( mlt_properties_get_int( trackProperties, "hide" ) & 2 ) != 0 )
+            track = nullptr;
+        mix->tracks.push_back( track );
+        const MLTAudioMixer::ScrubSource* scrub = nullptr;
+        if ( track != nullptr && mix->scrubSources != nullptr )
+        {
+            for ( const auto& s : *mix->scrubSources )
+            {
+                if ( s.track == i && position >= s.begin && position < s.end )
+                {
+                    scrub = &s;
+                    break;
+                }
+            }
+        }
+        mix->scrub.push_back( scrub );
+        mix->stems.push_back( i < c.stems.size() ? c.stems[i] : -1 );
+        float g[4];
+        trackGains( c, i, position, g[0], g[1] );
+        trackGains( c, i, position + 1, g[2], g[3] );
+        mix->gains.insert( mix->gains.end(), g, g + 4 );
+    }
+    // Not a tractor laid out as expected, its own audio is left alone
+    if ( mix->tracks.empty() == true )
+        return frame;
+    mlt_properties_set_data( properties, MixProperty, mix.release(), 0, destroy<Mix>, nullptr );
+    mlt_frame_push_audio( frame, reinterpret_cast<void*>( getAudio ) );
+    return frame;
+}
+
+// The mixer attached to producer, or to one of the tractors it is made of
+mlt_filter
+findMixer( mlt_producer producer )
+{
+    producer = mlt_producer_cut_parent( producer );
+    auto service = MLT_PRODUCER_SERVICE( producer );
+    for ( int i = 0; ; ++i )
+    {
+        auto filter = mlt_service_filter( service, i );
+        if ( filter == nullptr )
+            break;
+        auto name = mlt_properties_get( MLT_FILTER_PROPERTIES( filter ), "mlt_service" );
+        if ( name != nullptr && strcmp( name, MLTAudioMixer::ServiceName ) == 0 )
+            return filter;
+    }
+    if ( mlt_service_identify( service ) != tractor_type )
+        return nullptr;
+    auto multitrack = mlt_tractor_multitrack( static_cast<mlt_tractor>( producer->child ) );
+    for ( int i = 0; i < mlt_multitrack_count( multitrack ); ++i )
+    {
+        auto mixer = findMixer( mlt_multitrack_track( multitrack, i ) );
+        if ( mixer != nullptr )
+            return mixer;
+    }
+    return nullptr;
+}
+
+void*
+create( mlt_profile, mlt_service_type, const char*, const void* )
+{
+    auto filter = mlt_filter_new();
+    if ( filter == nullptr )
+        return nullptr;
+    filter->process = process;
+    mlt_properties_set_int( MLT_FILTER_PROPERTIES( filter ), MLTInput::InternalFilterProperty, 1 );
+    mlt_properties_set_data( MLT_FILTER_PROPERTIES( filter ), ScrubSourcesProperty, new ScrubState, 0,
+                             destroy<ScrubState>, nullptr );
+    return filter;
+}
+
+}
+
+void
+MLTAudioMixer::registerService( Mlt::Repository& repository )
+{
+    repository.register_service( mlt_service_filter_type, ServiceName, create );
+}
+
+bool
+MLTAudioMixer::setStems( IInput& multitrack, const std::vector<int>& trackStems )
+{
+    auto mltInput = dynamic_cast<MLTInput*>( &multitrack );
+    if ( mltInput == nullptr )
+        return false;
+    auto filter = findMixer( mltInput->producer()->get_producer() );
+    if ( filter == nullptr )
+        return false;
+    std::ostringstream  stems;
+    stems.imbue( std::locale::classic() );
+    for ( auto s : trackStems )
+        stems << s << ' ';
+    auto properties = MLT_FILTER_PROPERTIES( filter );
+    mlt_properties_set( properties, "stems", stems.str().c_str() );
+    mlt_properties_set_int( properties, "revision", mlt_properties_get_int( properties, "revision" ) + 1 );
+    return true;
+}
+
+const MLTAudioMixer::Stems*
+MLTAudioMixer::stems( mlt_frame_s* frame )
+{
+    auto properties = MLT_FRAME_PROPERTIES( frame );
+    auto s = static_cast<const Stems*>( mlt_properties_get_data( properties, StemsProperty, nullptr ) );
+    if ( s != nullptr )
+        return s;
+    // Looks through the frames of the tracks, as process() finds them
+    auto producer = mlt_frame_get_original_producer( frame );
+    if ( producer == nullptr )
+        return nullptr;
+    auto id = mlt_properties_get( MLT_PRODUCER_PROPERTIES( producer ), "_unique_id" );
+    if ( id == nullptr )
+        return nullptr;
+    auto prefix = std::string( "_" ) + id + "_";
+    for ( uint32_t i = 0; ; ++i )
+    {
+        auto track = static_cast<mlt_frame>( mlt_properties_get_data( properties,
+                                                  ( prefix + std::to_string( i ) ).c_str(), nullptr ) );
+        if ( track == nullptr || mlt_properties_get_int( MLT_FRAME_PROPERTIES( track ), "last_track" ) != 0 )
+            break;
+        s = stems( track );
+        if ( s != nullptr )
+            return s;
+    }
+    return nullptr;
+}
+
+MLTAudioMixer::MLTAudioMixer( IInput& multitrack )
+    : m_producer( nullptr )
+    , m_filter( nullptr )
+    , m_revision( 0 )
+{
+    auto mltInput = dynamic_cast<MLTInput*>( &multitrack );
+    auto& mltProfile = static_cast<MLTProfile&>( Backend::instance()->profile() );
+    if ( mltInput == nullptr )
+        return;
+    // Through the factory, so that the service name gets serialized
+    m_filter = mlt_factory_filter( mltProfile.m_profile->get_profile(), ServiceName, nullptr );
+    if ( m_filter == nullptr )
+        return;
+    m_producer = mltInput->producer()->get_service();
+    if ( mlt_service_attach( m_producer, m_filter ) != 0 )
+    {
+        mlt_filter_close( m_filter );
+        m_filter = nullptr;
+        return;
+    }
+    publish();
+}
+
+MLTAudioMixer::~MLTAudioMixer()
+{
+    if ( m_filter == nullptr )
+        return;
+    mlt_service_detach( m_producer, m_filter );
+    mlt_filter_close( m_filter );
+}
+
+void
+MLTAudioMixer::setGain( uint32_t trackId, float gain )
+{
+    if ( trackId >= m_gains.size() )
+        m_gains.resize( trackId + 1, 1.f );
+    m_gains[trackId] = gain;
+    publish();
+}
+
+void
+MLTAudioMixer::setPan( uint32_t trackId, float pan )
+{
+    if ( trackId >= m_pans.size() )
+        m_pans.resize( trackId + 1, 0.f );
+    m_pans[trackId] = std::max( -1.f, std::min( 1.f, pan ) );
+    publish();
+}
+
+void
+MLTAudioMixer::setFades( const std::vector<Fade>& fades )
+{
+    m_fades = fades;
+    publish();
+}
+
+void
+MLTAudioMixer::setClipGains( const std::vector<ClipGain>& gains )
+{
+    m_clipGains = gains;
+    publish();
+}
+
+void
+MLTAudioMixer::setScrubSources( std::vector<ScrubSource> sources )
+{
+    if ( m_filter == nullptr )
+        return;
+    auto state = static_cast<ScrubState*>( mlt_properties_get_data( MLT_FILTER_PROPERTIES( m_filter ),
+                                                                    ScrubSourcesProperty, nullptr ) );
+    if ( state == nullptr )
+        return;
+    std::shared_ptr<const ScrubSources> s = std::make_shared<ScrubSources>( std::move( sources ) );
+    std::atomic_store( &state->sources, s );
+}
+
+void
+MLTAudioMixer::publish()
+{
+    if ( m_filter == nullptr )
+        return;
+    auto toString = []( const std::vector<float>& values ) {
+        std::ostringstream  s;
+        s.imbue( std::locale::classic() );
+        for ( auto v : values )
+            s << v << ' ';
+        return s.str();
+    };
+    std::ostringstream  fades;
+    fades.imbue( std::locale::classic() );
+    for ( const auto& f : m_fades )
+        fades << f.aTrack << ' ' << f.bTrack << ' ' << f.begin << ' ' << f.end << ' ' << ( f.fadeOut ? 1 : 0 ) << ' ';
+
+    std::ostringstream  clipGains;
+    clipGains.imbue( std::locale::classic() );
+    for ( const auto& g : m_clipGains )
+        clipGains << g.track << ' ' << g.begin << ' ' << g.end << ' ' << g.gain << ' ';
+
+    auto properties = MLT_FILTER_PROPERTIES( m_filter );
+    mlt_properties_set( properties, "gains", toString( m_gains ).c_str() );
+    mlt_properties_set( properties, "pans", toString( m_pans ).c_str() );
+    mlt_properties_set( properties, "fades", fades.str().c_str() );
+    mlt_properties_set( properties, "clipgains", clipGains.str().c_str() );
+    // Last, so that the audio thread picks the new values up together
+    mlt_properties_set_int( properties, "revision", ++m_revision );
+}
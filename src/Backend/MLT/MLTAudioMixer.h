@@ -0,0 +1,169 @@
+/*****************************************************************************
+ * MLTAudioMixer.h: Single pass mix of the audio tracks of a sequence
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTAUDIOMIXER_H
+#define MLTAUDIOMIXER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct mlt_filter_s;
+struct mlt_frame_s;
+struct mlt_service_s;
+
+namespace Mlt
+{
+class Repository;
+}
+
+namespace Tools
+{
+class PcmCache;
+}
+
+namespace Backend
+{
+class IInput;
+
+namespace MLT
+{
+
+/**
+ *  \brief  Sums the audio of every track of a multitrack, in a single pass.
+ *
+ *  A tractor only plays the audio of its topmost track, unless transitions mix the
+ *  others in. Instead of a transition per pair of tracks, the mixer fetches the audio
+ *  of each track's frame and accumulates it, with the track's gain, pan and crossfades
+ *  applied, using MLT's float format all along.
+ *
+ *  The mixer is an internal filter of the multitrack, but unlike the other ones it is
+ *  serialized, as the exports need it as well: its parameters are stored in its
+ *  properties, and registerService() lets the xml producer create it back.
+ *
+ *  While the multitrack seeks to keyframes, which is what scrubbing does, the tracks
+ *  which have a scrub source are read from its PCM cache instead of being decoded.
+ *  \sa setScrubSources()
+ *
+ *  The tracks can also be assigned to stems: each frame then carries the sum of the
+ *  tracks of each stem, along with the master mix, which they add up to.
+ *  \sa setStems()
+ */
+class MLTAudioMixer
+{
+    public:
+        static const char* const    ServiceName;
+        // Set on the multitrack while its audio is read from the scrub sources
+        static const char* const    ScrubProperty;
+
+        // The audio of the bTrack fades in, or out, over the one of the aTrack
+        struct Fade
+        {
+            uint32_t    aTrack;
+            uint32_t    bTrack;
+            int64_t     begin;
+            int64_t     end;
+            bool        fadeOut;
+        };
+
+        // A linear gain applied to the audio of a track over [begin, end), on top of the
+        // track's own
+        struct ClipGain
+        {
+            uint32_t    track;
+            int64_t     begin;
+            int64_t     end;
+            float       gain;
+        };
+
+        // The audio of a track over [begin, end), as decoded in a PCM cache
+        struct ScrubSource
+        {
+            uint32_t    track;
+            int64_t     begin;
+            int64_t     end;
+            // The media frame played at begin
+            int64_t     offset;
+            std::shared_ptr<const Tools::PcmCache>  pcm;
+        };
+
+        // The audio of each stem of a frame, mixed along with the master
+        struct Stems
+        {
+            uint32_t            nbStems;
+            uint32_t            nbSamples;
+            uint32_t            nbChannels;
+            // Interleaved floats, one stem after the other
+            std::vector<float>  samples;
+        };
+
+        static void     registerService( Mlt::Repository& repository );
+        /**
+         *  \brief  Assigns the tracks of the mixer found in multitrack, which may be a
+         *          copy of the one it was created for, to stems.
+         *
+         *  \param  trackStems  The stem of each track, -1 for none. The tracks after the
+         *                      last one are in none.
+         *  \returns    false if multitrack has no mixer.
+         */
+        static bool     setStems( IInput& multitrack, const std::vector<int>& trackStems );
+        /**
+         *  \returns    The stems of frame, or of the tracks' frames it holds, once its
+         *              audio got fetched. nullptr if no stems were set. They belong to
+         *              the frame.
+         */
+        static const Stems*     stems( mlt_frame_s* frame );
+
+        explicit MLTAudioMixer( IInput& multitrack );
+        ~MLTAudioMixer();
+
+        // Linear, 1 by default
+        void            setGain( uint32_t trackId, float gain );
+        // From -1, left only, to 1, right only. 0 by default
+        void            setPan( uint32_t trackId, float pan );
+        void            setFades( const std::vector<Fade>& fades );
+        void            setClipGains( const std::vector<ClipGain>& gains );
+        /**
+         *  \brief  Replaces the scrub sources. This can be called while the audio plays.
+         *
+         *  The caches hold the media audio, without the clips' effects.
+         */
+        void            setScrubSources( std::vector<ScrubSource> sources );
+
+    private:
+        // Writes the parameters to the filter properties, where the audio thread reads them
+        void            publish();
+
+    private:
+        mlt_service_s*              m_producer;
+        mlt_filter_s*               m_filter;
+        int                         m_revision;
+        std::vector<float>          m_gains;
+        std::vector<float>          m_pans;
+        std::vector<Fade>           m_fades;
+        std::vector<ClipGain>       m_clipGains;
+};
+
+}
+}
+
+#endif // MLTAUDIOMIXER_H
@@ -27,17 +27,34 @@
 
 #include "MLTBackend.h"
 
+#include <mlt++/MltConsumer.h>
 #include <mlt++/MltFactory.h>
+#include <mlt++/MltFilter.h>
+#include <mlt++/MltProducer.h>
 #include <mlt++/MltProperties.h>
 #include <mlt++/MltRepository.h>
 #include <mlt++/MltService.h>
 
 #include <mlt/framework/mlt_log.h>
 
+#include "MLTAudioMixer.h"
 #include "MLTFilter.h"
+#include "MLTFrameBlend.h"
+#include "MLTInput.h"
+#include "MLTLut.h"
+#include "MLTMulticam.h"
+#include "MLTNestedSequence.h"
+#include "MLTOutput.h"
+#include "MLTTitle.h"
 
+#include <algorithm>
+#include <chrono>
 #include <mutex>
 #include <sstream>
+#include <thread>
+#ifndef _WIN32
+# include <unistd.h>
+#endif
 
 #include "Tools/VlmcDebug.h"
 #include "vlmc.h"
@@ -47,7 +64,6 @@ using namespace Backend::MLT;
 
 
 static Backend::IBackend::LogHandler    staticLogHandler;
-static std::mutex                       logMutex;
 
 IBackend*
 Backend::instance()
@@ -56,29 +72,51 @@ Backend::instance()
 }
 
 MLTBackend::MLTBackend()
+    : m_decodeThreadBudget( 0 )
+    , m_glslManager( nullptr )
 {
     m_mltRepo = Mlt::Factory::init();
     m_profile.setFrameRate( 2997, 100 );
 
-    for ( int i = 0; i < m_mltRepo->filters()->count(); ++i )
+    // Before listing the filters, as it is an effect
+    MLTLut::registerService( *m_mltRepo );
+    // Only the names: the metadata is read when a filter gets described
+    auto filters = std::unique_ptr<Mlt::Properties>( m_mltRepo->filters() );
+    for ( int i = 0; i < filters->count(); ++i )
     {
-        auto pro = std::unique_ptr<Mlt::Properties>( m_mltRepo->metadata( filter_type, m_mltRepo->filters()->get_name( i ) ) );
-        auto filterInfo = new MLTFilterInfo;
-        filterInfo->setProperties( pro.get() );
-        if ( filterInfo->identifier().empty() == true )
-        {
-            delete filterInfo;
-            continue;
-        }
-        m_availableFilters[ filterInfo->identifier() ] = filterInfo;
+        auto name = filters->get_name( i );
+        if ( name != nullptr )
+            m_filters[name] = new MLTFilterInfo( m_mltRepo, name );
     }
+    // After listing the filters, as it isn't an effect
+    MLTAudioMixer::registerService( *m_mltRepo );
+    MLTFrameBlend::registerService( *m_mltRepo );
+    MLTTitle::registerService( *m_mltRepo );
+    MLTMulticam::registerService( *m_mltRepo );
+    MLTNestedSequence::registerService( *m_mltRepo );
+
+    // There is no cheap way of asking libavcodec whether a device works without a
+    // stream to decode, so only check that the device is there.
+#if defined( __APPLE__ )
+    m_hardwareDecoders.push_back( "videotoolbox" );
+#elif defined( _WIN32 )
+    m_hardwareDecoders.push_back( "d3d11va" );
+#else
+    if ( access( "/dev/dri/renderD128", R_OK | W_OK ) == 0 )
+        m_hardwareDecoders.push_back( "vaapi" );
+    if ( access( "/dev/nvidiactl", R_OK | W_OK ) == 0 )
+        m_hardwareDecoders.push_back( "cuda" );
+#endif
 }
 
 MLTBackend::~MLTBackend()
 {
+    // The cached producers must be closed before the factory
+    m_inputCache.clear();
+    delete m_glslManager;
     Mlt::Factory::close();
 
-    for ( auto info : m_availableFilters )
+    for ( auto info : m_filters )
         delete info.second;
 }
 
@@ -88,21 +126,281 @@ MLTBackend::profile()
     return m_profile;
 }
 
+std::unique_ptr<IProfile>
+MLTBackend::createProfile() const
+{
+    return std::unique_ptr<IProfile>( new MLTProfile( m_profile ) );
+}
+
 const std::map<std::string, IFilterInfo*>&
 MLTBackend::availableFilters() const
 {
+    // Filters without metadata aren't meant to be used on their own
+    std::call_once( m_availableFiltersLoaded, [this]() {
+        for ( const auto& f : m_filters )
+        {
+            if ( f.second->isValid() == true )
+                m_availableFilters[f.first] = f.second;
+        }
+    } );
     return m_availableFilters;
 }
 
+std::vector<std::string>
+MLTBackend::filterIdentifiers() const
+{
+    std::vector<std::string>    ids;
+    ids.reserve( m_filters.size() );
+    for ( const auto& f : m_filters )
+        ids.push_back( f.first );
+    return ids;
+}
+
 IFilterInfo*
 MLTBackend::filterInfo( const std::string& id ) const
 {
-    auto it = m_availableFilters.find( id );
-    if ( it != m_availableFilters.end() )
+    auto it = m_filters.find( id );
+    if ( it != m_filters.end() && it->second->isValid() == true )
         return (*it).second;
     return nullptr;
 }
 
+std::shared_ptr<IInput>
+MLTBackend::acquireInput( const std::string& path, IInput::SeekPrecision precision )
+{
+    return m_inputCache.acquire( path, precision );
+}
+
+Backend::MediaInfo
+MLTBackend::probe( const std::string& path )
+{
+    if ( MLTInput::isImage( path.c_str() ) == true || MLTInput::isTitle( path.c_str() ) == true ||
+         MLTInput::isMulticam( path.c_str() ) == true || MLTInput::isNestedSequence( path.c_str() ) == true )
+    {
+        MLTInput    input( m_profile, path.c_str() );
+        return MLTInput::mediaInfo( input.probedProperties() );
+    }
+    // The bare avformat producer, without the normalizing filters the loader adds
+    Mlt::Producer   producer( *m_profile.m_profile, "avformat", path.c_str() );
+    if ( producer.is_valid() == false || producer.get_length() <= 0 )
+        throw InvalidServiceException();
+    return MLTInput::mediaInfo( MLTInput::probedProperties( producer ) );
+}
+
+const std::vector<std::string>&
+MLTBackend::availableHardwareDecoders() const
+{
+    return m_hardwareDecoders;
+}
+
+void
+MLTBackend::setHardwareDecoding( const std::string& api )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_hardwareDecodingMutex );
+        if ( m_hardwareDecoding == api )
+            return;
+        m_hardwareDecoding = api;
+    }
+    // Idle inputs were opened with the previous setting
+    m_inputCache.clear();
+}
+
+void
+MLTBackend::setMediaHardwareDecoding( const std::string& path, const std::string& api )
+{
+    std::lock_guard<std::mutex> lock( m_hardwareDecodingMutex );
+    if ( api.empty() == true )
+        m_mediaHardwareDecoding.erase( path );
+    else
+        m_mediaHardwareDecoding[path] = api;
+}
+
+std::string
+MLTBackend::hardwareDecoding( const std::string& path ) const
+{
+    std::string api;
+    {
+        std::lock_guard<std::mutex> lock( m_hardwareDecodingMutex );
+        auto it = m_mediaHardwareDecoding.find( path );
+        api = it != end( m_mediaHardwareDecoding ) ? it->second : m_hardwareDecoding;
+    }
+    if ( api.empty() == true || api == "none" )
+        return std::string();
+    if ( std::find( begin( m_hardwareDecoders ), end( m_hardwareDecoders ), api ) == end( m_hardwareDecoders ) )
+    {
+        vlmcWarning() << "Hardware decoding API" << api.c_str() << "isn't available, decoding in software";
+        return std::string();
+    }
+    return api;
+}
+
+void
+MLTBackend::setDecodeThreadBudget( int threads )
+{
+    if ( m_decodeThreadBudget.exchange( threads ) == threads )
+        return;
+    // Idle inputs were opened with the previous budget
+    m_inputCache.clear();
+}
+
+void
+MLTBackend::setMediaDecodeThreads( const std::string& path, int threads )
+{
+    std::lock_guard<std::mutex> lock( m_decodeThreadsMutex );
+    if ( threads <= 0 )
+        m_mediaDecodeThreads.erase( path );
+    else
+        m_mediaDecodeThreads[path] = threads;
+}
+
+int
+MLTBackend::decodeThreads( const std::string& path, DecodePriority priority ) const
+{
+    {
+        std::lock_guard<std::mutex> lock( m_decodeThreadsMutex );
+        auto it = m_mediaDecodeThreads.find( path );
+        if ( it != end( m_mediaDecodeThreads ) )
+            return it->second;
+    }
+    int budget = m_decodeThreadBudget;
+    if ( budget <= 0 )
+        return 0;
+    if ( priority == Background )
+        return 1;
+    // The background decoders are short lived, and only ever use a thread each
+    int left = budget - (int)MLTInput::nbSources( Background );
+    int foreground = std::max( 1, (int)MLTInput::nbSources( Foreground ) );
+    return std::max( 1, left / foreground );
+}
+
+void
+MLTBackend::setProxy( const std::string& path, const std::string& proxy )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_proxiesMutex );
+        if ( proxy.empty() == true )
+            m_proxies.erase( path );
+        else
+            m_proxies[path] = proxy;
+    }
+    // Idle inputs may still decode the previous file
+    m_inputCache.clear();
+}
+
+std::unordered_map<std::string, std::string>
+MLTBackend::proxies() const
+{
+    std::lock_guard<std::mutex> lock( m_proxiesMutex );
+    return m_proxies;
+}
+
+uint32_t
+MLTBackend::nbDecoders() const
+{
+    return MLTInput::nbSources();
+}
+
+bool
+MLTBackend::isGpuProcessingAvailable() const
+{
+    return m_filters.find( "glsl.manager" ) != end( m_filters );
+}
+
+bool
+MLTBackend::setGpuProcessing( GpuContextProvider provider )
+{
+    if ( m_glslManager != nullptr )
+        return true;
+    if ( isGpuProcessingAvailable() == false )
+        return false;
+    // Registers itself globally: from now on, the loader normalizes the producers
+    // through Movit's converters
+    auto manager = new Mlt::Filter( *m_profile.m_profile, "glsl.manager" );
+    if ( manager->is_valid() == false )
+    {
+        delete manager;
+        return false;
+    }
+    m_glslManager = manager;
+    m_gpuContextProvider = std::move( provider );
+    return true;
+}
+
+bool
+MLTBackend::gpuProcessing() const
+{
+    return m_glslManager != nullptr;
+}
+
+void
+MLTBackend::setupGpuThreads( Mlt::Consumer& consumer )
+{
+    if ( m_glslManager == nullptr )
+        return;
+    consumer.listen( "consumer-thread-started", this, (mlt_listener)MLTBackend::onRenderThreadStarted );
+    consumer.listen( "consumer-thread-stopped", this, (mlt_listener)MLTBackend::onRenderThreadStopped );
+}
+
+int
+MLTBackend::renderThreads( int wanted ) const
+{
+    return m_glslManager != nullptr ? 1 : wanted;
+}
+
+void
+MLTBackend::onRenderThreadStarted( void*, MLTBackend* self )
+{
+    if ( self->m_gpuContextProvider() == false )
+    {
+        vlmcCritical() << "Can't create an OpenGL context, the GPU filters won't render";
+        return;
+    }
+    self->m_glslManager->fire_event( "init glsl" );
+}
+
+void
+MLTBackend::onRenderThreadStopped( void*, MLTBackend* self )
+{
+    self->m_glslManager->fire_event( "close glsl" );
+}
+
+bool
+MLTBackend::probeVideoEncoder( const std::string& codec, const std::string& target )
+{
+    // A stuck driver must not hold the caller forever
+    const auto timeout = std::chrono::seconds( 10 );
+    try
+    {
+        MLTInput input( new Mlt::Producer( *m_profile.m_profile, "color", "black" ) );
+        input.setBoundaries( 0, 4 );
+
+        MLTFFmpegOutput output;
+        output.setTarget( target.c_str() );
+        output.setWidth( 320 );
+        output.setHeight( 240 );
+        EncoderOptions options;
+        options.videoCodec = codec;
+        output.setEncoderOptions( options );
+        if ( output.connect( input ) == false )
+            return false;
+        output.start();
+
+        auto start = std::chrono::steady_clock::now();
+        while ( output.isStopped() == false )
+        {
+            if ( std::chrono::steady_clock::now() - start > timeout )
+                return false;
+            std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+        }
+        return true;
+    }
+    catch ( InvalidServiceException& )
+    {
+        return false;
+    }
+}
+
 void
 MLTBackend::setLogHandler( IBackend::LogHandler logHandler )
 {
@@ -139,8 +437,6 @@ MLTBackend::setLogHandler( IBackend::LogHandler logHandler )
         else
             lvl = IBackend::Error;
 
-        std::lock_guard<std::mutex> lock( logMutex );
-
         if ( vasprintf( &buffer, format, vl ) < 0 )
             return;
 
@@ -153,3 +449,24 @@ MLTBackend::setLogHandler( IBackend::LogHandler logHandler )
         free( buffer );
     } );
 }
+
+void
+MLTBackend::setLogLevel( IBackend::LogLevel level )
+{
+    // MLT compares the level of a message before calling the handler
+    switch ( level )
+    {
+    case IBackend::Debug:
+        mlt_log_set_level( MLT_LOG_DEBUG );
+        break;
+    case IBackend::Warning:
+        mlt_log_set_level( MLT_LOG_WARNING );
+        break;
+    case IBackend::Error:
+        mlt_log_set_level( MLT_LOG_ERROR );
+        break;
+    case IBackend::None:
+        mlt_log_set_level( MLT_LOG_QUIET );
+        break;
+    }
+}
@@ -28,12 +28,19 @@
 #include "Tools/Singleton.hpp"
 
 #include "MLTProfile.h"
+#include "MLTInputCache.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 namespace Mlt
 {
 class Repository;
 class Profile;
 class Output;
+class Consumer;
+class Filter;
 }
 
 namespace Backend
@@ -47,24 +54,85 @@ class IFilterInfo;
 
 namespace MLT
 {
+class MLTFilterInfo;
+
 class MLTBackend : public IBackend, public Singleton<MLTBackend>
 {
     public:
         virtual IProfile&                   profile() override;
+        virtual std::unique_ptr<IProfile>   createProfile() const override;
 
 
         virtual const std::map<std::string, IFilterInfo*>&   availableFilters() const override;
+        virtual std::vector<std::string>                     filterIdentifiers() const override;
         virtual IFilterInfo*                                 filterInfo( const std::string& id ) const override;
 
         virtual void            setLogHandler( LogHandler logHandler ) override;
+        virtual void            setLogLevel( LogLevel level ) override;
+
+        virtual std::shared_ptr<IInput>     acquireInput( const std::string& path,
+                                                          IInput::SeekPrecision precision = IInput::Exact ) override;
+        virtual MediaInfo                   probe( const std::string& path ) override;
+        virtual bool                        probeVideoEncoder( const std::string& codec,
+                                                               const std::string& target ) override;
+
+        virtual const std::vector<std::string>& availableHardwareDecoders() const override;
+        virtual void                        setHardwareDecoding( const std::string& api ) override;
+        virtual void                        setMediaHardwareDecoding( const std::string& path,
+                                                                      const std::string& api ) override;
+        virtual std::string                 hardwareDecoding( const std::string& path ) const override;
+        virtual void                        setDecodeThreadBudget( int threads ) override;
+        virtual void                        setMediaDecodeThreads( const std::string& path,
+                                                                   int threads ) override;
+        virtual int                         decodeThreads( const std::string& path,
+                                                           DecodePriority priority ) const override;
+
+        virtual void                        setProxy( const std::string& path, const std::string& proxy ) override;
+        virtual std::unordered_map<std::string, std::string>    proxies() const override;
+        virtual uint32_t                    nbDecoders() const override;
+
+        virtual bool                        isGpuProcessingAvailable() const override;
+        virtual bool                        setGpuProcessing( GpuContextProvider provider ) override;
+        virtual bool                        gpuProcessing() const override;
+        /**
+         *  \brief     Initializes the OpenGL context of each of consumer's rendering
+         *             threads, when processing on the GPU.
+         */
+        void                                setupGpuThreads( Mlt::Consumer& consumer );
+        /**
+         *  \returns   The number of threads consumers may render with, out of the
+         *             wanted ones. Movit doesn't render frames in parallel.
+         */
+        int                                 renderThreads( int wanted ) const;
+
+    private:
+        static void                         onRenderThreadStarted( void* owner, MLTBackend* self );
+        static void                         onRenderThreadStopped( void* owner, MLTBackend* self );
 
     private:
         MLTBackend();
         ~MLTBackend();
         Mlt::Repository*    m_mltRepo;
         MLTProfile           m_profile;
-
-        std::map<std::string, IFilterInfo*>    m_availableFilters;
+        MLTInputCache        m_inputCache;
+
+        std::vector<std::string>                        m_hardwareDecoders;
+        std::string                                     m_hardwareDecoding;
+        std::unordered_map<std::string, std::string>    m_mediaHardwareDecoding;
+        mutable std::mutex                              m_hardwareDecodingMutex;
+        std::atomic<int>                                m_decodeThreadBudget;
+        std::unordered_map<std::string, int>            m_mediaDecodeThreads;
+        mutable std::mutex                              m_decodeThreadsMutex;
+        std::unordered_map<std::string, std::string>    m_proxies;
+        mutable std::mutex                              m_proxiesMutex;
+
+        std::map<std::string, MLTFilterInfo*>           m_filters;
+        mutable std::map<std::string, IFilterInfo*>     m_availableFilters;
+        mutable std::once_flag                          m_availableFiltersLoaded;
+
+        // Movit's shared state, non null when processing on the GPU
+        Mlt::Filter*                                    m_glslManager;
+        GpuContextProvider                              m_gpuContextProvider;
 
     friend Singleton_t::AllowInstantiation;
 };
@@ -0,0 +1,78 @@
+/*****************************************************************************
+ * MLTBinding.h: Static access to the MLT objects behind the backend interfaces
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTBINDING_H
+#define MLTBINDING_H
+
+#include "MLTFilter.h"
+#include "MLTInput.h"
+#include "MLTTransition.h"
+
+#include <cassert>
+
+namespace Backend
+{
+namespace MLT
+{
+
+/**
+ *  \brief  Return the MLT implementation of a backend interface.
+ *
+ *  MLT is the only backend built in, so this is decided at compile time. The timeline
+ *  edits and effect operations convert their arguments without RTTI lookups. Debug
+ *  builds still check the object's type.
+ */
+inline MLTInput&
+native( IInput& input )
+{
+    auto mltInput = input.implementation<MLTInput>();
+    assert( mltInput != nullptr && mltInput == dynamic_cast<MLTInput*>( &input ) );
+    return *mltInput;
+}
+
+inline const MLTInput&
+native( const IInput& input )
+{
+    auto mltInput = input.implementation<const MLTInput>();
+    assert( mltInput != nullptr && mltInput == dynamic_cast<const MLTInput*>( &input ) );
+    return *mltInput;
+}
+
+// IFilter and ITransition aren't virtual bases, a static_cast is enough
+inline MLTFilter&
+native( IFilter& filter )
+{
+    assert( dynamic_cast<MLTFilter*>( &filter ) != nullptr );
+    return static_cast<MLTFilter&>( filter );
+}
+
+inline MLTTransition&
+native( ITransition& transition )
+{
+    assert( dynamic_cast<MLTTransition*>( &transition ) != nullptr );
+    return static_cast<MLTTransition&>( transition );
+}
+
+}
+}
+
+#endif // MLTBINDING_H
@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * MLTDissolve.cpp: Cross fade between two tracks, without a generic compositor
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "MLTDissolve.h"
+#include "Tools/ImageBlend.h"
+
+#include <mlt++/MltTransition.h>
+#include <mlt/framework/mlt_frame.h>
+#include <mlt/framework/mlt_transition.h>
+
+#include <cstddef>
+#include <cstdint>
+
+using namespace Backend::MLT;
+
+namespace
+{
+
+int
+dissolveImage( mlt_frame aFrame, uint8_t** image, mlt_image_format* format, int* width,
+               int* height, int )
+{
+    auto bFrame = mlt_frame_pop_frame( aFrame );
+    auto weight = (uint32_t)mlt_frame_pop_service_int( aFrame );
+
+    // Both images in the same layout, there's no alpha channel to composite
+    *format = mlt_image_yuv422;
+    auto ret = mlt_frame_get_image( aFrame, image, format, width, height, 1 );
+    if ( ret != 0 || weight == 0 )
+        return ret;
+    uint8_t* bImage = nullptr;
+    auto bFormat = mlt_image_yuv422;
+    auto bWidth = *width;
+    auto bHeight = *height;
+    if ( mlt_frame_get_image( bFrame, &bImage, &bFormat, &bWidth, &bHeight, 0 ) != 0 ||
+         bImage == nullptr || bFormat != *format || bWidth != *width || bHeight != *height )
+        return 0;
+    // weight is b's share out of 256
+    Tools::blendImages( *image, bImage, (size_t)*width * *height * 2, weight );
+    return 0;
+}
+
+mlt_frame
+dissolveProcess( mlt_transition transition, mlt_frame aFrame, mlt_frame bFrame )
+{
+    auto position = mlt_transition_get_position( transition, aFrame );
+    auto length = mlt_transition_get_length( transition );
+    auto progress = length > 1 ? (double)position / ( length - 1 ) : 1.;
+    if ( mlt_properties_get_int( MLT_TRANSITION_PROPERTIES( transition ), "reverse" ) != 0 )
+        progress = 1. - progress;
+    mlt_frame_push_service_int( aFrame, (int)( progress * 256. + .5 ) );
+    mlt_frame_push_frame( aFrame, bFrame );
+    mlt_frame_push_get_image( aFrame, dissolveImage );
+    return aFrame;
+}
+
+Mlt::Transition*
+createDissolve( bool fadeOut )
+{
+    auto transition = mlt_transition_new();
+    if ( transition == nullptr )
+        return new Mlt::Transition( (mlt_transition)nullptr );
+    transition->process = dissolveProcess;
+    auto properties = MLT_TRANSITION_PROPERTIES( transition );
+    // What the xml consumer writes, and the clones recreate
+    mlt_properties_set( properties, "mlt_service", "luma" );
+    mlt_properties_set_int( properties, "reverse", fadeOut ? 1 : 0 );
+    auto wrapper = new Mlt::Transition( transition );
+    mlt_transition_close( transition );
+    return wrapper;
+}
+
+}
+
+MLTDissolve::MLTDissolve( bool fadeOut )
+    : MLTTransition( createDissolve( fadeOut ) )
+{
+}
@@ -0,0 +1,51 @@
+/*****************************************************************************
+ * MLTDissolve.h: Cross fade between two tracks, without a generic compositor
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTDISSOLVE_H
+#define MLTDISSOLVE_H
+
+#include "MLTTransition.h"
+
+namespace Backend
+{
+namespace MLT
+{
+
+/**
+ *  \brief Dissolves the a track into the b track, or the b track back into the a
+ *         track when fading out.
+ *
+ *  The most common transition by far: both images are fetched in the same YUV
+ *  layout and mixed per byte, in a loop the compiler vectorizes, instead of going
+ *  through luma's generic per pixel compositing. Serialized as the equivalent luma
+ *  dissolve, which the exports then render.
+ */
+class MLTDissolve : public MLTTransition
+{
+    public:
+        explicit MLTDissolve( bool fadeOut = false );
+};
+
+}
+}
+
+#endif // MLTDISSOLVE_H
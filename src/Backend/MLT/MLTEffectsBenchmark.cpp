@@ -0,0 +1,86 @@
+/*****************************************************************************
+ * MLTEffectsBenchmark.cpp: Measures the rendering cost of effect chains
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MLTEffectsBenchmark.h"
+
+#include "MLTBackend.h"
+#include "MLTFilter.h"
+#include "MLTInput.h"
+
+#include <mlt++/MltProducer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+#include "Tools/VlmcDebug.h"
+
+using namespace Backend::MLT;
+
+MLTEffectsBenchmark::MLTEffectsBenchmark( std::vector<std::string> filters, uint32_t nbFrames )
+    : m_filters( std::move( filters ) )
+    , m_nbFrames( std::max( 1u, nbFrames ) )
+{
+}
+
+MLTEffectsBenchmark::Result
+MLTEffectsBenchmark::run( uint32_t width, uint32_t height ) const
+{
+    auto& profile = static_cast<MLTProfile&>( MLTBackend::instance()->profile() );
+    // Noise is about as expensive to process as a decoded video, and doesn't need a file
+    MLTInput input( new Mlt::Producer( *profile.m_profile, "noise" ) );
+    input.setBoundaries( 0, m_nbFrames - 1 );
+
+    auto render = [&input, width, height, this]() {
+        auto start = std::chrono::steady_clock::now();
+        for ( uint32_t pos = 0; pos < m_nbFrames; ++pos )
+        {
+            input.setPosition( pos );
+            input.image( width, height );
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / m_nbFrames;
+    };
+
+    Result result{ width, height, render(), {}, 0. };
+    auto previous = result.sourceMsPerFrame;
+    // The filters must outlive the input's renders
+    std::vector<std::unique_ptr<MLTFilter>> filters;
+    for ( const auto& id : m_filters )
+    {
+        try
+        {
+            filters.emplace_back( new MLTFilter( id.c_str() ) );
+        }
+        catch ( InvalidServiceException& )
+        {
+            vlmcWarning() << "Can't create filter" << id.c_str() << ", skipping it";
+            continue;
+        }
+        input.attach( *filters.back() );
+        auto total = render();
+        result.filters.push_back( FilterTiming{ id, total - previous } );
+        previous = total;
+    }
+    result.fps = previous > 0. ? 1000. / previous : 0.;
+    return result;
+}
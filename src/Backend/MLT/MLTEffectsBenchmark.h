@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * MLTEffectsBenchmark.h: Measures the rendering cost of effect chains
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTEFFECTSBENCHMARK_H
+#define MLTEFFECTSBENCHMARK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Backend
+{
+namespace MLT
+{
+
+/**
+ *  \brief Renders a generated source through a chain of filters, and times each of them.
+ *
+ *  The filters are added one at a time, with their default parameters, and the whole
+ *  chain is rendered again each time: a filter's cost is the difference with the
+ *  chain rendered without it.
+ */
+class MLTEffectsBenchmark
+{
+    public:
+        struct FilterTiming
+        {
+            std::string identifier;
+            double      msPerFrame;
+        };
+
+        struct Result
+        {
+            uint32_t    width;
+            uint32_t    height;
+            // Generating the source frames, without any filter
+            double      sourceMsPerFrame;
+            std::vector<FilterTiming>   filters;
+            // Frames rendered per second through the whole chain
+            double      fps;
+        };
+
+        MLTEffectsBenchmark( std::vector<std::string> filters, uint32_t nbFrames );
+
+        /**
+         *  \brief Renders the chain at the given size. Unknown filters are skipped.
+         */
+        Result  run( uint32_t width, uint32_t height ) const;
+
+    private:
+        std::vector<std::string>    m_filters;
+        uint32_t                    m_nbFrames;
+};
+
+}
+}
+
+#endif // MLTEFFECTSBENCHMARK_H
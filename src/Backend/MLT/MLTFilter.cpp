@@ -27,12 +27,14 @@
 #include "MLTFilter.h"
 #include <mlt++/MltFilter.h>
 #include <mlt++/MltProducer.h>
+#include <mlt++/MltRepository.h>
 
 #include <cassert>
 #include <cstring>
 #include "Backend/IBackend.h"
 #include "MLTProfile.h"
 #include "MLTInput.h"
+#include "MLTBinding.h"
 
 using namespace Backend::MLT;
 
@@ -99,6 +101,13 @@ MLTParameterInfo::setProperties( Mlt::Properties* properties )
     m_maxValue      = makeString( properties->get( "maximum" ) );
 }
 
+MLTFilterInfo::MLTFilterInfo( Mlt::Repository* repository, const std::string& identifier )
+    : m_repository( repository )
+    , m_identifier( identifier )
+    , m_valid( false )
+{
+}
+
 MLTFilterInfo::~MLTFilterInfo()
 {
     for ( IParameterInfo* info : m_paramInfos )
@@ -115,34 +124,60 @@ MLTFilterInfo::identifier() const
 const std::string&
 MLTFilterInfo::name() const
 {
+    load();
     return m_name;
 }
 
 const std::string&
 MLTFilterInfo::description() const
 {
+    load();
     return m_description;
 }
 
 const std::string&
 MLTFilterInfo::author() const
 {
+    load();
     return m_author;
 }
 
 const std::vector<Backend::IParameterInfo*>&
 MLTFilterInfo::paramInfos() const
 {
+    load();
     return m_paramInfos;
 }
 
+bool
+MLTFilterInfo::isGpu() const
+{
+    return m_identifier.compare( 0, 6, "movit." ) == 0;
+}
+
+bool
+MLTFilterInfo::isValid() const
+{
+    load();
+    return m_valid;
+}
+
+void
+MLTFilterInfo::load() const
+{
+    std::call_once( m_loaded, [this]() {
+        std::unique_ptr<Mlt::Properties> properties( m_repository->metadata( filter_type, m_identifier.c_str() ) );
+        setProperties( properties.get() );
+    } );
+}
+
 void
-MLTFilterInfo::setProperties( Mlt::Properties* properties )
+MLTFilterInfo::setProperties( Mlt::Properties* properties ) const
 {
     if ( properties == nullptr )
         return;
 
-    m_identifier    = makeString( properties->get( "identifier" ) );
+    m_valid         = makeString( properties->get( "identifier" ) ).empty() == false;
     m_name          = makeString( properties->get( "title" ) );
     m_description   = makeString( properties->get( "description" ) );
     m_author        = makeString( properties->get( "creator" ) );
@@ -217,11 +252,10 @@ MLTFilter::identifier() const
 bool
 MLTFilter::connect( Backend::IInput& input, int index )
 {
-    MLTInput* mltInput = dynamic_cast<MLTInput*>( &input );
-    assert( mltInput );
-    m_connectedProducer.reset( new Mlt::Producer( mltInput->producer()->get_producer() ) );
+    auto& mltInput = native( input );
+    m_connectedProducer.reset( new Mlt::Producer( mltInput.producer()->get_producer() ) );
 
-    return !filter()->connect( *mltInput->producer(), index );
+    return !filter()->connect( *mltInput.producer(), index );
 }
 
 void
@@ -26,11 +26,14 @@
 #include "Backend/IFilter.h"
 #include "MLTService.h"
 
+#include <mutex>
+
 namespace Mlt
 {
 class Filter;
 class Properties;
 class Producer;
+class Repository;
 }
 
 namespace Backend
@@ -64,10 +67,16 @@ namespace MLT
         std::string             m_maxValue;
     };
 
+    /**
+     *  \brief Describes a filter, reading its metadata on first use.
+     *
+     *  Parsing the metadata of every filter of the repository adds up to a noticeable part
+     *  of the startup, and most runs don't need it.
+     */
     class MLTFilterInfo : public IFilterInfo
     {
     public:
-        MLTFilterInfo() = default;
+        MLTFilterInfo( Mlt::Repository* repository, const std::string& identifier );
         virtual ~MLTFilterInfo() override;
 
         virtual const std::string&  identifier() const override;
@@ -75,16 +84,25 @@ namespace MLT
         virtual const std::string&  description() const override;
         virtual const std::string&  author() const override;
         virtual const std::vector<IParameterInfo*>& paramInfos() const override;
+        virtual bool                isGpu() const override;
 
-        void                        setProperties( Mlt::Properties* properties );
+        // false if the filter has no metadata, and shouldn't be offered to the user
+        bool                        isValid() const;
+
+    private:
+        void                        load() const;
+        void                        setProperties( Mlt::Properties* properties ) const;
 
     private:
+        Mlt::Repository*        m_repository;
         std::string             m_identifier;
-        std::string             m_name;
-        std::string             m_author;
-        std::string             m_description;
+        mutable std::once_flag  m_loaded;
+        mutable bool            m_valid;
+        mutable std::string     m_name;
+        mutable std::string     m_author;
+        mutable std::string     m_description;
 
-        std::vector<IParameterInfo*> m_paramInfos;
+        mutable std::vector<IParameterInfo*> m_paramInfos;
     };
 
     class MLTFilter : public IFilter, public MLTService
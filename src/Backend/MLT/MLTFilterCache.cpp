@@ -0,0 +1,268 @@
+/*****************************************************************************
+ * MLTFilterCache.cpp: Keeps the last image of a filter chain
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MLTFilterCache.h"
+#include "MLTInput.h"
+#include "Tools/Metrics.h"
+
+#include <mlt++/MltFilter.h>
+#include <mlt++/MltProducer.h>
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace Backend::MLT;
+
+namespace
+{
+
+const char  CacheProperty[] = "_vlmc_filter_cache";
+
+struct Key
+{
+    mlt_position        position;
+    mlt_image_format    format;
+    int                 width;
+    int                 height;
+    size_t              parameters;
+
+    bool operator==( const Key& k ) const
+    {
+        return position == k.position && format == k.format && width == k.width &&
+                height == k.height && parameters == k.parameters;
+    }
+};
+
+struct State
+{
+    Key                         key;
+    mlt_image_format            format;
+    int                         width;
+    int                         height;
+    std::vector<uint8_t>        image;
+    std::vector<uint8_t>        alpha;
+    std::list<State*>::iterator lru;
+};
+
+// Shared by every cache, as the images are bounded as a whole. Most recently used first.
+std::mutex          mutex;
+std::list<State*>   lru;
+size_t              nbBytes = 0;
+size_t              nbImages = 0;
+
+// Called with the mutex held
+void
+publish()
+{
+    static auto& account = Tools::Metrics::memory( "backend.filterCache" );
+    account.set( nbBytes, nbImages );
+}
+
+void
+drop( State* state )
+{
+    if ( state->image.empty() == false )
+        --nbImages;
+    nbBytes -= state->image.size() + state->alpha.size();
+    std::vector<uint8_t>().swap( state->image );
+    std::vector<uint8_t>().swap( state->alpha );
+}
+
+void
+destroy( void* data )
+{
+    auto state = static_cast<State*>( data );
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        drop( state );
+        lru.erase( state->lru );
+        publish();
+    }
+    delete state;
+}
+
+// Whatever the filters before the cache are set to, animations included
+size_t
+parametersHash( mlt_filter cache )
+{
+    std::hash<std::string>  hash;
+    size_t                  res = 0;
+    // Set on attachment. The producer owns the cache, which can't outlive it.
+    auto producer = static_cast<mlt_service>( mlt_properties_get_data(
+                        MLT_FILTER_PROPERTIES( cache ), "_vlmc_producer", nullptr ) );
+    for ( int i = 0; producer != nullptr; ++i )
+    {
+        auto filter = mlt_service_filter( producer, i );
+        if ( filter == nullptr || filter == cache )
+            break;
+        auto properties = MLT_FILTER_PROPERTIES( filter );
+        for ( int j = 0; j < mlt_properties_count( properties ); ++j )
+        {
+            auto name = mlt_properties_get_name( properties, j );
+            auto value = mlt_properties_get_value( properties, j );
+            if ( name == nullptr || value == nullptr || name[0] == '_' )
+                continue;
+            res = res * 31 + hash( name );
+            res = res * 31 + hash( value );
+        }
+        res = res * 31 + i;
+    }
+    return res;
+}
+
+int
+getImage( mlt_frame frame, uint8_t** image, mlt_image_format* format, int* width,
+          int* height, int writable )
+{
+    auto filter = static_cast<mlt_filter>( mlt_frame_pop_service( frame ) );
+    auto state = static_cast<State*>( mlt_properties_get_data( MLT_FILTER_PROPERTIES( filter ),
+                                                               CacheProperty, nullptr ) );
+    Key key{ mlt_frame_original_position( frame ), *format, *width, *height,
+             parametersHash( filter ) };
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        if ( state->image.empty() == false && state->key == key )
+        {
+            auto buffer = static_cast<uint8_t*>( mlt_pool_alloc( state->image.size() ) );
+            memcpy( buffer, state->image.data(), state->image.size() );
+            mlt_frame_set_image( frame, buffer, state->image.size(), mlt_pool_release );
+            if ( state->alpha.empty() == false )
+            {
+                auto alpha = static_cast<uint8_t*>( mlt_pool_alloc( state->alpha.size() ) );
+                memcpy( alpha, state->alpha.data(), state->alpha.size() );
+                mlt_frame_set_alpha( frame, alpha, state->alpha.size(), mlt_pool_release );
+            }
+            *image = buffer;
+            *format = state->format;
+            *width = state->width;
+            *height = state->height;
+            lru.splice( lru.begin(), lru, state->lru );
+            return 0;
+        }
+    }
+
+    auto res = mlt_frame_get_image( frame, image, format, width, height, writable );
+    if ( res != 0 || *image == nullptr )
+        return res;
+    auto size = mlt_image_format_size( *format, *width, *height, nullptr );
+    int alphaSize = 0;
+    auto alpha = static_cast<uint8_t*>( mlt_properties_get_data( MLT_FRAME_PROPERTIES( frame ),
+                                                                 "alpha", &alphaSize ) );
+    if ( size <= 0 || size + alphaSize > (int)MLTFilterCache::MaxBytes / 2 )
+        return res;
+
+    std::lock_guard<std::mutex> lock( mutex );
+    drop( state );
+    state->key = key;
+    state->format = *format;
+    state->width = *width;
+    state->height = *height;
+    state->image.assign( *image, *image + size );
+    if ( alpha != nullptr && alphaSize > 0 )
+        state->alpha.assign( alpha, alpha + alphaSize );
+    nbBytes += state->image.size() + state->alpha.size();
+    ++nbImages;
+    lru.splice( lru.begin(), lru, state->lru );
+    for ( auto it = lru.rbegin(); nbBytes > MLTFilterCache::MaxBytes && it != lru.rend(); ++it )
+    {
+        if ( *it != state )
+            drop( *it );
+    }
+    publish();
+    return res;
+}
+
+mlt_frame
+process( mlt_filter filter, mlt_frame frame )
+{
+    mlt_frame_push_service( frame, filter );
+    mlt_frame_push_get_image( frame, getImage );
+    return frame;
+}
+
+}
+
+void
+MLTFilterCache::attach( Mlt::Producer& producer )
+{
+    // A track or a sequence gives the same source position to frames of different clips
+    if ( mlt_service_identify( producer.get_service() ) != producer_type )
+        return;
+    auto i = index( producer );
+    if ( i >= 0 )
+    {
+        if ( i != producer.filter_count() - 1 )
+            producer.move_filter( i, producer.filter_count() - 1 );
+        return;
+    }
+
+    auto filter = mlt_filter_new();
+    if ( filter == nullptr )
+        return;
+    filter->process = process;
+    auto properties = MLT_FILTER_PROPERTIES( filter );
+    // Not written by the xml consumer
+    mlt_properties_set_int( properties, "_loader", 1 );
+    mlt_properties_set_int( properties, MLTInput::InternalFilterProperty, 1 );
+    mlt_properties_set_data( properties, "_vlmc_producer", producer.get_service(), 0, nullptr, nullptr );
+
+    auto state = new State;
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        state->lru = lru.insert( lru.end(), state );
+    }
+    mlt_properties_set_data( properties, CacheProperty, state, 0, destroy, nullptr );
+
+    Mlt::Filter f( filter );
+    producer.attach( f );
+    // The producer holds its own reference
+    mlt_filter_close( filter );
+}
+
+void
+MLTFilterCache::detach( Mlt::Producer& producer )
+{
+    auto i = index( producer );
+    if ( i < 0 )
+        return;
+    std::unique_ptr<Mlt::Filter> filter( producer.filter( i ) );
+    producer.detach( *filter );
+}
+
+int
+MLTFilterCache::index( Mlt::Producer& producer )
+{
+    for ( int i = producer.filter_count() - 1; i >= 0; --i )
+    {
+        auto filter = mlt_service_filter( producer.get_service(), i );
+        if ( filter != nullptr &&
+             mlt_properties_get_data( MLT_FILTER_PROPERTIES( filter ), CacheProperty, nullptr ) != nullptr )
+            return i;
+    }
+    return -1;
+}
@@ -0,0 +1,71 @@
+/*****************************************************************************
+ * MLTFilterCache.h: Keeps the last image of a filter chain
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTFILTERCACHE_H
+#define MLTFILTERCACHE_H
+
+#include <cstddef>
+
+namespace Mlt
+{
+class Producer;
+}
+
+namespace Backend
+{
+namespace MLT
+{
+
+/**
+ *  \brief  Remembers the last image which went through the filters of a producer.
+ *
+ *  The cache is a filter attached after the others, whose image callback returns the
+ *  remembered image when the same source frame is asked for again, with the same size
+ *  and format, and none of the filters' properties changed in the meantime. The
+ *  filters before it, and the decoder, are then skipped altogether, which is what a
+ *  paused preview does on every refresh.
+ *
+ *  It's marked as a loader filter, so that it isn't serialized, and hence never copied
+ *  to the sequences cloned for exports. The images kept by all the caches are bounded
+ *  by MaxBytes, the least recently used ones being dropped first.
+ */
+class MLTFilterCache
+{
+    public:
+        static const size_t     MaxBytes = 128 * 1024 * 1024;
+
+        /**
+         *  \brief  Attaches a cache to producer, or moves its cache after the filters
+         *          attached since.
+         *
+         *  Tracks and sequences don't get one.
+         */
+        static void             attach( Mlt::Producer& producer );
+        static void             detach( Mlt::Producer& producer );
+        // The index of the producer's cache among its filters, or -1
+        static int              index( Mlt::Producer& producer );
+};
+
+}
+}
+
+#endif // MLTFILTERCACHE_H
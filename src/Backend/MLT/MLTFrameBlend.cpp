@@ -0,0 +1,168 @@
+/*****************************************************************************
+ * MLTFrameBlend.cpp: Frame blending for the slowed down clips
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MLTFrameBlend.h"
+
+#include <mlt++/MltRepository.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace Backend::MLT;
+
+const char* const MLTFrameBlend::ServiceName = "vlmc_frameblend";
+
+namespace
+{
+
+const char  StateProperty[] = "_vlmc_frameblend";
+
+// The filter's own decoder, and the frame it decoded last
+struct State
+{
+    explicit State( mlt_profile p ) : profile( p ), producer( nullptr ), position( -1 ) {}
+    ~State()
+    {
+        if ( producer != nullptr )
+            mlt_producer_close( producer );
+    }
+
+    std::mutex              mutex;
+    mlt_profile             profile;
+    std::string             resource;
+    mlt_producer            producer;
+    mlt_position            position;
+    int                     width;
+    int                     height;
+    std::vector<uint8_t>    image;
+};
+
+void
+destroyState( void* data )
+{
+    delete static_cast<State*>( data );
+}
+
+// Decodes the frame at position of the file, unless it was the last one. Must be called
+// with the lock held
+const uint8_t*
+sourceImage( State& state, const char* resource, mlt_position position, int width, int height )
+{
+    if ( state.position == position && state.width == width && state.height == height &&
+         state.resource == resource )
+        return state.image.data();
+    if ( state.producer == nullptr || state.resource != resource )
+    {
+        if ( state.producer != nullptr )
+            mlt_producer_close( state.producer );
+        state.resource = resource;
+        state.position = -1;
+        auto loader = "avformat:" + state.resource;
+        state.producer = mlt_factory_producer( state.profile, "loader", loader.c_str() );
+        if ( state.producer == nullptr )
+            return nullptr;
+    }
+    mlt_producer_seek( state.producer, position );
+    mlt_frame frame = nullptr;
+    if ( mlt_service_get_frame( MLT_PRODUCER_SERVICE( state.producer ), &frame, 0 ) != 0 ||
+         frame == nullptr )
+        return nullptr;
+    uint8_t* image = nullptr;
+    auto format = mlt_image_rgb24a;
+    auto w = width;
+    auto h = height;
+    auto res = mlt_frame_get_image( frame, &image, &format, &w, &h, 0 );
+    if ( res == 0 && image != nullptr && format == mlt_image_rgb24a && w == width && h == height )
+    {
+        state.image.assign( image, image + static_cast<size_t>( width ) * height * 4 );
+        state.position = position;
+        state.width = width;
+        state.height = height;
+    }
+    else
+        state.position = -1;
+    mlt_frame_close( frame );
+    return state.position == position ? state.image.data() : nullptr;
+}
+
+int
+getImage( mlt_frame frame, uint8_t** image, mlt_image_format* format, int* width, int* height,
+          int writable )
+{
+    auto filter = static_cast<mlt_filter>( mlt_frame_pop_service( frame ) );
+    auto properties = MLT_FILTER_PROPERTIES( filter );
+    auto state = static_cast<State*>( mlt_properties_get_data( properties, StateProperty, nullptr ) );
+    auto resource = mlt_properties_get( properties, "resource" );
+    auto speed = mlt_properties_get_double( properties, "speed" );
+    if ( state == nullptr || resource == nullptr || speed <= 0. || speed >= 1. )
+        return mlt_frame_get_image( frame, image, format, width, height, writable );
+    // timewarp shows the file's frame at the integral part of the position it maps to
+    auto position = mlt_frame_original_position( frame ) * speed;
+    auto shown = static_cast<mlt_position>( position );
+    auto weight = static_cast<int>( ( position - shown ) * 256 );
+    if ( weight == 0 )
+        return mlt_frame_get_image( frame, image, format, width, height, writable );
+
+    *format = mlt_image_rgb24a;
+    auto res = mlt_frame_get_image( frame, image, format, width, height, 1 );
+    if ( res != 0 || *image == nullptr || *format != mlt_image_rgb24a )
+        return res;
+    std::lock_guard<std::mutex> lock( state->mutex );
+    auto next = sourceImage( *state, resource, shown + 1, *width, *height );
+    // Past the end of the file, the frame is just repeated
+    if ( next == nullptr )
+        return 0;
+    auto dst = *image;
+    auto size = static_cast<size_t>( *width ) * *height * 4;
+    for ( size_t i = 0; i < size; ++i )
+        dst[i] = static_cast<uint8_t>( ( dst[i] * ( 256 - weight ) + next[i] * weight ) >> 8 );
+    return 0;
+}
+
+mlt_frame
+process( mlt_filter filter, mlt_frame frame )
+{
+    mlt_frame_push_service( frame, filter );
+    mlt_frame_push_get_image( frame, getImage );
+    return frame;
+}
+
+void*
+create( mlt_profile profile, mlt_service_type, const char*, const void* )
+{
+    auto filter = mlt_filter_new();
+    if ( filter == nullptr )
+        return nullptr;
+    filter->process = process;
+    mlt_properties_set_data( MLT_FILTER_PROPERTIES( filter ), StateProperty, new State( profile ),
+                             0, destroyState, nullptr );
+    return filter;
+}
+
+}
+
+void
+MLTFrameBlend::registerService( Mlt::Repository& repository )
+{
+    repository.register_service( mlt_service_filter_type, ServiceName, create );
+}
@@ -0,0 +1,58 @@
+/*****************************************************************************
+ * MLTFrameBlend.h: Frame blending for the slowed down clips
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTFRAMEBLEND_H
+#define MLTFRAMEBLEND_H
+
+namespace Mlt
+{
+class Repository;
+}
+
+namespace Backend
+{
+namespace MLT
+{
+
+/**
+ *  \brief  Smooths the slow motion of a timewarp producer, by blending each frame it
+ *          repeats with the next frame of the file.
+ *
+ *  The filter decodes the "resource" file itself, at the "speed" of the producer it is
+ *  attached to, and keeps the last frame it decoded: as a slowed down clip shows the
+ *  same pair of frames several times in a row, each of them is only decoded once.
+ *  Faster and reversed speeds are passed through.
+ *
+ *  Like the mixer, it isn't an effect: it is attached by MLTInput::retimed().
+ */
+class MLTFrameBlend
+{
+    public:
+        static const char* const    ServiceName;
+
+        static void                 registerService( Mlt::Repository& repository );
+};
+
+}
+}
+
+#endif // MLTFRAMEBLEND_H
@@ -26,36 +26,456 @@
 
 #include "MLTInput.h"
 #include "MLTProfile.h"
+#include "MLTAudioMixer.h"
 #include "MLTBackend.h"
+#include "MLTBinding.h"
 #include "MLTFilter.h"
-
+#include "MLTFilterCache.h"
+#include "MLTFrameBlend.h"
+#include "MLTMulticam.h"
+#include "MLTNestedSequence.h"
+#include "MLTTitle.h"
+#include "Tools/Metrics.h"
+#include "Tools/Multicam.h"
+#include "Tools/NestedSequence.h"
+#include "Tools/Title.h"
+#include "Tools/Trace.h"
+
+#include <mlt++/MltConsumer.h>
 #include <mlt++/MltFrame.h>
 #include <mlt++/MltFilter.h>
 #include <mlt++/MltProducer.h>
+#include <mlt++/MltPlaylist.h>
+#include <mlt++/MltTractor.h>
+#include <mlt++/MltTransition.h>
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <cassert>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
 
 using namespace Backend::MLT;
 
+const char* const MLTInput::InternalFilterProperty = "_vlmc_internal";
+
+namespace
+{
+
+// Case insensitive
+bool
+hasExtension( const char* path, const char* extension )
+{
+    std::string p( path );
+    auto len = strlen( extension );
+    if ( p.size() <= len )
+        return false;
+    for ( auto& c : p )
+        c = tolower( c );
+    return p.compare( p.size() - len, len, extension ) == 0;
+}
+
+bool
+isInternal( mlt_filter filter )
+{
+    return filter != nullptr &&
+            mlt_properties_get_int( MLT_FILTER_PROPERTIES( filter ), MLTInput::InternalFilterProperty ) != 0;
+}
+
+// Moves the internal filters after the ones attached since, keeping their order
+void
+raiseInternalFilters( Mlt::Producer& producer )
+{
+    auto count = producer.filter_count();
+    for ( int i = 0, seen = 0; seen < count; ++seen )
+    {
+        if ( isInternal( mlt_service_filter( producer.get_service(), i ) ) == true )
+            producer.move_filter( i, count - 1 );
+        else
+            ++i;
+    }
+}
+
+}
+
+MLTVideoFrame::MLTVideoFrame( Mlt::Frame* frame, const uint8_t* data, uint32_t width, uint32_t height,
+                              Format format )
+    : m_frame( frame )
+    , m_data( data )
+    , m_width( width )
+    , m_height( height )
+    , m_format( format )
+{
+}
+
+MLTVideoFrame::~MLTVideoFrame() = default;
+
+std::shared_ptr<MLTVideoFrame>
+MLTVideoFrame::fromFrame( Mlt::Frame* frame, int width, int height, Format format )
+{
+    // The buffer belongs to the frame, so both have to be kept together
+    std::unique_ptr<Mlt::Frame> imageFrame( frame );
+    mlt_image_format wanted;
+    switch ( format )
+    {
+    case YUV420P:
+        wanted = mlt_image_yuv420p;
+        break;
+    case YUV422:
+        wanted = mlt_image_yuv422;
+        break;
+    default:
+        wanted = mlt_image_rgb24a;
+        break;
+    }
+    uint8_t* buffer = nullptr;
+    mlt_image_format got = wanted;
+    if ( mlt_frame_get_image( imageFrame->get_frame(), &buffer, &got, &width, &height, 0 ) != 0 ||
+         buffer == nullptr || got != wanted )
+        return nullptr;
+    return std::make_shared<MLTVideoFrame>( imageFrame.release(), buffer, width, height, format );
+}
+
+const uint8_t*
+MLTVideoFrame::data() const
+{
+    return m_data;
+}
+
+uint32_t
+MLTVideoFrame::width() const
+{
+    return m_width;
+}
+
+uint32_t
+MLTVideoFrame::height() const
+{
+    return m_height;
+}
+
+uint32_t
+MLTVideoFrame::stride() const
+{
+    switch ( m_format )
+    {
+    case RGBA:
+        return m_width * 4;
+    case YUV422:
+        return m_width * 2;
+    default:
+        return m_width;
+    }
+}
+
+Backend::IVideoFrame::Format
+MLTVideoFrame::format() const
+{
+    return m_format;
+}
+
+MLTAudioFrame::MLTAudioFrame( Mlt::Frame* frame, const int16_t* samples, uint32_t nbSamples,
+                              uint32_t channels, uint32_t frequency )
+    : m_frame( frame )
+    , m_samples( samples )
+    , m_nbSamples( nbSamples )
+    , m_channels( channels )
+    , m_frequency( frequency )
+{
+}
+
+MLTAudioFrame::~MLTAudioFrame() = default;
+
+const int16_t*
+MLTAudioFrame::samples() const
+{
+    return m_samples;
+}
+
+uint32_t
+MLTAudioFrame::nbSamples() const
+{
+    return m_nbSamples;
+}
+
+uint32_t
+MLTAudioFrame::channels() const
+{
+    return m_channels;
+}
+
+uint32_t
+MLTAudioFrame::frequency() const
+{
+    return m_frequency;
+}
+
+std::atomic<uint32_t>   MLTInput::s_nbSources( 0 );
+std::atomic<uint32_t>   MLTInput::s_nbBackgroundSources( 0 );
+
+namespace
+{
+    // The producers' own memory isn't known, only how many are alive
+    Tools::Metrics::MemoryAccount&
+    inputsAccount()
+    {
+        static auto& account = Tools::Metrics::memory( "backend.inputs" );
+        return account;
+    }
+
+    Tools::Metrics::MemoryAccount&
+    sourcesAccount()
+    {
+        static auto& account = Tools::Metrics::memory( "backend.decoders" );
+        return account;
+    }
+}
+
 MLTInput::MLTInput()
     : m_producer( nullptr )
     , m_callback( nullptr )
     , m_paused( false )
+    , m_listening( false )
+    , m_seekPrecision( Exact )
     , m_nbVideoTracks( 0 )
     , m_nbAudioTracks( 0 )
+    , m_isSource( false )
+    , m_decodePriority( IBackend::Foreground )
 {
+    m_implementation = this;
+    inputsAccount().add( 0 );
+}
+
+void
+MLTInput::setSource()
+{
+    m_isSource = true;
+    ++s_nbSources;
+    sourcesAccount().add( 0 );
+}
 
+uint32_t
+MLTInput::nbSources()
+{
+    return s_nbSources;
+}
+
+uint32_t
+MLTInput::nbSources( IBackend::DecodePriority priority )
+{
+    uint32_t background = s_nbBackgroundSources;
+    uint32_t total = s_nbSources;
+    if ( priority == IBackend::Background )
+        return background;
+    return total > background ? total - background : 0;
 }
 
 void
-MLTInput::calcTracks()
+MLTInput::setDecodePriority( const char* path, IBackend::DecodePriority priority )
 {
-    char s[70];
+    if ( m_decodePriority == priority )
+        return;
+    if ( m_isSource == true )
+    {
+        if ( priority == IBackend::Background )
+            ++s_nbBackgroundSources;
+        else
+            --s_nbBackgroundSources;
+    }
+    m_decodePriority = priority;
+    setDecodeThreads( path );
+}
+
+namespace
+{
+
+struct StreamLayout
+{
+    int     nbVideoTracks;
+    int     nbAudioTracks;
+};
+
+// By resource. Filled when a file gets opened, and read by the cuts and clones of
+// its inputs, which would otherwise enumerate the streams again.
+std::mutex                                      layoutsMutex;
+std::unordered_map<std::string, StreamLayout>   layouts;
+
+// Number of consecutive files a "name%04d.png?begin=N" sequence is made of
+int64_t
+sequenceLength( const std::string& path )
+{
+    auto query = path.find( "?begin=" );
+    auto pattern = path.substr( 0, query );
+    int64_t first = query != std::string::npos ? atoll( path.c_str() + query + 7 ) : 1;
+    int64_t count = 0;
+    char name[4096];
+    for ( ;; ++count )
+    {
+        snprintf( name, sizeof( name ), pattern.c_str(), static_cast<int>( first + count ) );
+        if ( std::ifstream( name ).good() == false )
+            break;
+    }
+    return count;
+}
+
+}
+
+bool
+MLTInput::isImage( const char* path )
+{
+    static const char* const    extensions[] = { ".png", ".jpg", ".jpeg" };
+    std::string p( path );
+    p = p.substr( 0, p.find( '?' ) );
+    for ( auto& c : p )
+        c = tolower( c );
+    for ( auto ext : extensions )
+    {
+        auto len = strlen( ext );
+        if ( p.size() > len && p.compare( p.size() - len, len, ext ) == 0 )
+            return true;
+    }
+    return false;
+}
+
+bool
+MLTInput::isImageSequence( const char* path )
+{
+    return isImage( path ) == true && strchr( path, '%' ) != nullptr &&
+            strstr( path, "?begin=" ) != nullptr;
+}
+
+bool
+MLTInput::isTitle( const char* path )
+{
+    return hasExtension( path, Tools::Title::Extension );
+}
+
+bool
+MLTInput::isMulticam( const char* path )
+{
+    return hasExtension( path, Tools::Multicam::Extension );
+}
+
+bool
+MLTInput::isNestedSequence( const char* path )
+{
+    return hasExtension( path, Tools::NestedSequence::Extension );
+}
+
+const char*
+MLTInput::documentService( const char* path )
+{
+    if ( isTitle( path ) == true )
+        return MLTTitle::ServiceName;
+    if ( isMulticam( path ) == true )
+        return MLTMulticam::ServiceName;
+    if ( isNestedSequence( path ) == true )
+        return MLTNestedSequence::ServiceName;
+    return nullptr;
+}
+
+void
+MLTInput::openImage( IProfile& profile, const char* path, IInputEventCb* callback )
+{
+    // The image producers decode and scale a picture once, and then serve every frame,
+    // of this input and of its cuts, from their cache. Sequences are read a file per frame.
+    MLTProfile& mltProfile = static_cast<MLTProfile&>( profile );
+    for ( auto service : { "qimage:", "pixbuf:" } )
+    {
+        std::string temp = std::string( service ) + path;
+        m_producer = new Mlt::Producer( *mltProfile.m_profile, "loader", temp.c_str() );
+        if ( m_producer->is_valid() == true )
+            break;
+        delete m_producer;
+        m_producer = nullptr;
+    }
+    if ( m_producer == nullptr )
+        throw InvalidServiceException();
+    if ( isImageSequence( path ) == true )
+    {
+        m_producer->set( "ttl", 1 );
+        m_producer->set( "length", sequenceLength( path ) );
+    }
+    m_producer->set( "out", m_producer->get_length() - 1 );
+    // Described as a single video stream, as avformat would
+    m_producer->set( "video_index", 0 );
+    m_producer->set( "audio_index", -1 );
+    m_producer->set( "meta.media.nb_streams", 1 );
+    m_producer->set( "meta.media.0.stream.type", "video" );
+    std::string ext( path );
+    ext = ext.substr( 0, ext.find( '?' ) );
+    ext = ext.substr( ext.rfind( '.' ) + 1 );
+    for ( auto& c : ext )
+        c = tolower( c );
+    m_producer->set( "meta.media.0.codec.name", ext == "png" ? "png" : "mjpeg" );
+    setCallback( callback );
+    calcTracks( true );
+    if ( isValid() == false )
+        throw InvalidServiceException();
+    setSource();
+}
+
+void
+MLTInput::openDocument( IProfile& profile, const char* service, const char* path,
+                        IInputEventCb* callback )
+{
+    MLTProfile& mltProfile = static_cast<MLTProfile&>( profile );
+    m_producer = new Mlt::Producer( *mltProfile.m_profile, service, path );
+    if ( m_producer->is_valid() == false )
+    {
+        delete m_producer;
+        m_producer = nullptr;
+        throw InvalidServiceException();
+    }
+    // Titles are a single still video stream, as images are. Multicam clips also have
+    // the audio of their active angle, and nested sequences the mix of their tracks.
+    auto hasAudio = strcmp( service, MLTMulticam::ServiceName ) == 0 ||
+            strcmp( service, MLTNestedSequence::ServiceName ) == 0;
+    m_producer->set( "video_index", 0 );
+    m_producer->set( "audio_index", hasAudio == true ? 1 : -1 );
+    m_producer->set( "meta.media.nb_streams", hasAudio == true ? 2 : 1 );
+    m_producer->set( "meta.media.0.stream.type", "video" );
+    m_producer->set( "meta.media.0.codec.name", service );
+    if ( hasAudio == true )
+    {
+        m_producer->set( "meta.media.1.stream.type", "audio" );
+        m_producer->set( "meta.media.1.codec.name", service );
+    }
+    setCallback( callback );
+    calcTracks( true );
+    if ( isValid() == false )
+        throw InvalidServiceException();
+    setSource();
+}
+
+void
+MLTInput::calcTracks( bool opened )
+{
+    auto resource = producer()->get( "resource" );
+    if ( opened == false && resource != nullptr )
+    {
+        std::lock_guard<std::mutex> lock( layoutsMutex );
+        auto it = layouts.find( resource );
+        if ( it != layouts.end() )
+        {
+            m_nbVideoTracks = it->second.nbVideoTracks;
+            m_nbAudioTracks = it->second.nbAudioTracks;
+            // Cut from an audio only input
+            if ( producer()->parent().get_int( "video_index" ) < 0 )
+                m_nbVideoTracks = 0;
+            return;
+        }
+    }
+
     int  nbStreams = producer()->get_int( "meta.media.nb_streams" );
     for ( int i = 0; i < nbStreams; ++i )
     {
-        sprintf( s, "meta.media.%d.stream.type", i );
-        auto type = producer()->get( s );
+        auto type = producer()->get( ( "meta.media." + std::to_string( i ) + ".stream.type" ).c_str() );
 
         if ( type == nullptr )
             continue;
@@ -65,6 +485,11 @@ MLTInput::calcTracks()
         else if ( strcmp( type, "audio" ) == 0 )
             m_nbAudioTracks++;
     }
+    if ( nbStreams > 0 && resource != nullptr )
+    {
+        std::lock_guard<std::mutex> lock( layoutsMutex );
+        layouts[resource] = StreamLayout{ m_nbVideoTracks, m_nbAudioTracks };
+    }
 }
 
 MLTInput::MLTInput( Mlt::Producer* producer, IInputEventCb* callback )
@@ -72,21 +497,42 @@ MLTInput::MLTInput( Mlt::Producer* producer, IInputEventCb* callback )
 {
     m_producer = producer;
     setCallback( callback );
-    calcTracks();
+    calcTracks( false );
     if ( isValid() == false )
         throw InvalidServiceException();
+    // Cuts share their parent's decoder
+    if ( producer->is_cut() == false )
+        setSource();
 }
 
 MLTInput::MLTInput( IProfile& profile, const char* path, IInputEventCb* callback )
     : MLTInput()
 {
-    std::string temp = std::string( "avformat:" ) + path;
+    if ( isImage( path ) == true )
+    {
+        openImage( profile, path, callback );
+        return;
+    }
+    auto service = documentService( path );
+    if ( service != nullptr )
+    {
+        openDocument( profile, service, path, callback );
+        return;
+    }
+    // Decode the proxy instead, if there's one. The clips' boundaries still match,
+    // since proxies have the same duration.
+    auto proxies = Backend::instance()->proxies();
+    auto proxy = proxies.find( path );
+    std::string temp = std::string( "avformat:" ) + ( proxy != proxies.end() ? proxy->second : path );
     MLTProfile& mltProfile = static_cast<MLTProfile&>( profile );
     m_producer = new Mlt::Producer( *mltProfile.m_profile, "loader", temp.c_str() );
     setCallback( callback );
-    calcTracks();
+    calcTracks( true );
     if ( isValid() == false )
         throw InvalidServiceException();
+    setHardwareDecoding( path );
+    setSource();
+    setDecodeThreads( path );
 }
 
 MLTInput::MLTInput( const char* path, IInputEventCb* callback )
@@ -94,12 +540,153 @@ MLTInput::MLTInput( const char* path, IInputEventCb* callback )
 {
 }
 
+MLTInput::MLTInput( const char* path, const Properties& probed, IInputEventCb* callback )
+    : MLTInput()
+{
+    // Nothing to defer, images are cheap to open
+    if ( isImage( path ) == true )
+    {
+        openImage( Backend::instance()->profile(), path, callback );
+        return;
+    }
+    auto service = documentService( path );
+    if ( service != nullptr )
+    {
+        openDocument( Backend::instance()->profile(), service, path, callback );
+        return;
+    }
+    // The novalidate flavour of avformat defers opening the file to the first frame
+    std::string temp = std::string( "avformat-novalidate:" ) + path;
+    MLTProfile& mltProfile = static_cast<MLTProfile&>( Backend::instance()->profile() );
+    m_producer = new Mlt::Producer( *mltProfile.m_profile, "loader", temp.c_str() );
+    for ( const auto& p : probed )
+        m_producer->set( p.first.c_str(), p.second.c_str() );
+    m_producer->set( "out", m_producer->get_length() - 1 );
+    setCallback( callback );
+    calcTracks( true );
+    if ( isValid() == false )
+        throw InvalidServiceException();
+    setHardwareDecoding( path );
+    setSource();
+    setDecodeThreads( path );
+}
+
+MLTInput::Properties
+MLTInput::probedProperties() const
+{
+    return probedProperties( *producer() );
+}
+
+MLTInput::Properties
+MLTInput::probedProperties( Mlt::Producer& producer )
+{
+    static const char* const    names[] = { "length", "width", "height", "aspect_ratio",
+                                            "video_index", "audio_index" };
+    static const char           metaPrefix[] = "meta.media.";
+    Properties  res;
+    for ( int i = 0; i < producer.count(); ++i )
+    {
+        auto name = producer.get_name( i );
+        auto value = producer.get( i );
+        if ( name == nullptr || value == nullptr )
+            continue;
+        auto keep = strncmp( name, metaPrefix, sizeof( metaPrefix ) - 1 ) == 0;
+        for ( auto n : names )
+            keep = keep || strcmp( name, n ) == 0;
+        if ( keep == true )
+            res[name] = value;
+    }
+    return res;
+}
+
+Backend::MediaInfo
+MLTInput::mediaInfo( const Properties& probed )
+{
+    auto get = [&probed]( const std::string& name ) -> std::string {
+        auto it = probed.find( name );
+        return it != probed.end() ? it->second : std::string();
+    };
+    auto getInt = [&get]( const std::string& name ) {
+        return atoll( get( name ).c_str() );
+    };
+    auto codec = [&get]( const std::string& index ) {
+        auto i = get( index );
+        return i.empty() == true ? i : get( "meta.media." + i + ".codec.name" );
+    };
+
+    MediaInfo   info;
+    info.length = getInt( "length" );
+    info.width = getInt( "width" );
+    info.height = getInt( "height" );
+    info.aspectRatio = atof( get( "aspect_ratio" ).c_str() );
+    auto fpsDen = getInt( "meta.media.frame_rate_den" );
+    if ( fpsDen > 0 )
+        info.fps = static_cast<double>( getInt( "meta.media.frame_rate_num" ) ) / fpsDen;
+    info.videoCodec = codec( "video_index" );
+    info.audioCodec = codec( "audio_index" );
+    auto audioIndex = get( "audio_index" );
+    if ( audioIndex.empty() == false && atoi( audioIndex.c_str() ) >= 0 )
+    {
+        info.sampleRate = getInt( "meta.media." + audioIndex + ".codec.sample_rate" );
+        info.nbChannels = getInt( "meta.media." + audioIndex + ".codec.channels" );
+    }
+    auto nbStreams = getInt( "meta.media.nb_streams" );
+    for ( int i = 0; i < nbStreams; ++i )
+    {
+        auto type = get( "meta.media." + std::to_string( i ) + ".stream.type" );
+        if ( type == "video" )
+            ++info.nbVideoTracks;
+        else if ( type == "audio" )
+            ++info.nbAudioTracks;
+    }
+    info.properties = probed;
+    return info;
+}
+
+void
+MLTInput::setHardwareDecoding( const char* path )
+{
+    // Only read when the decoder gets opened, on the first decoded frame
+    auto hwaccel = Backend::instance()->hardwareDecoding( path );
+    if ( hwaccel.empty() == false )
+    {
+        m_producer->set( "hwaccel", hwaccel.c_str() );
+        if ( hwaccel == "vaapi" )
+            m_producer->set( "hwaccel_device", "/dev/dri/renderD128" );
+    }
+}
+
+void
+MLTInput::setDecodeThreads( const char* path )
+{
+    // As the hardware decoding, only read when the decoder gets opened. The share is
+    // computed with this decoder already counted.
+    auto threads = Backend::instance()->decodeThreads( path, m_decodePriority );
+    if ( threads > 0 )
+        m_producer->set( "threads", threads );
+}
+
 
 MLTInput::~MLTInput()
 {
+    if ( m_isSource == true )
+    {
+        --s_nbSources;
+        if ( m_decodePriority == IBackend::Background )
+            --s_nbBackgroundSources;
+        sourcesAccount().remove( 0 );
+    }
+    inputsAccount().remove( 0 );
     delete m_producer;
 }
 
+void
+MLTInput::disableVideo()
+{
+    m_producer->set( "video_index", -1 );
+    m_nbVideoTracks = 0;
+}
+
 Mlt::Producer*
 MLTInput::producer()
 {
@@ -127,27 +714,52 @@ MLTInput::service() const
 void
 MLTInput::onPropertyChanged( void*, MLTInput* self, const char* id )
 {
-    if ( self == nullptr || self->m_callback == nullptr )
+    if ( self == nullptr || self->m_callback == nullptr || id == nullptr )
         return;
 
-    if ( strcmp( id, "_position" ) == 0 )
+    // Fired for every property set on the producer while rendering, so the two we
+    // watch are told apart by their first character before comparing them.
+    switch ( id[0] )
     {
-        self->m_callback->onPositionChanged( self->position() );
-        if ( self->position() >= self->playableLength() - 1 )
-            self->m_callback->onEndReached();
+        case '_':
+            if ( strcmp( id, "_position" ) == 0 )
+                self->positionChanged();
+            break;
+        case 'l':
+            if ( strcmp( id, "length" ) == 0 )
+                self->m_callback->onLengthChanged( self->playableLength() );
+            break;
+        default:
+            break;
     }
-    else if ( strcmp( id, "length" ) == 0 )
-        self->m_callback->onLengthChanged( self->playableLength() );
+}
 
+void
+MLTInput::positionChanged()
+{
+    // No more often than the screen refreshes while playing. Seeks while paused are
+    // always reported, as nothing would come after them to show where they landed.
+    static const auto   interval = std::chrono::milliseconds( 16 );
+    auto pos = position();
+    auto now = std::chrono::steady_clock::now();
+    if ( m_paused == true || now - m_lastPositionNotification >= interval )
+    {
+        m_lastPositionNotification = now;
+        m_callback->onPositionChanged( pos );
+    }
+    if ( pos >= playableLength() - 1 )
+        m_callback->onEndReached();
 }
 
 void
 MLTInput::setCallback( Backend::IInputEventCb* callback )
 {
-    if ( callback == nullptr )
-        return;
-
     m_callback = callback;
+    // Inputs go through several owners when they're cached, which would otherwise
+    // stack up listeners
+    if ( callback == nullptr || m_listening == true )
+        return;
+    m_listening = true;
     producer()->listen( "property-changed", this, (mlt_listener)MLTInput::onPropertyChanged );
 }
 
@@ -193,31 +805,203 @@ MLTInput::setBoundaries( int64_t begin, int64_t end )
 std::unique_ptr<Backend::IInput>
 MLTInput::cut( int64_t begin, int64_t end )
 {
+    // MLT cuts a cut from its parent: whatever the depth of the cuts, all of them share
+    // the decoder of the input which opened the file
     return std::unique_ptr<IInput>( new MLTInput( producer()->cut( begin, end ) ) );
 }
 
+std::unique_ptr<Backend::IInput>
+MLTInput::generator( const char* service, const char* resource, int64_t length )
+{
+    auto& mltProfile = static_cast<MLTProfile&>( Backend::instance()->profile() );
+    std::unique_ptr<MLTInput> input( new MLTInput(
+                new Mlt::Producer( *mltProfile.m_profile, service, resource ) ) );
+    input->producer()->set( "length", (int)length );
+    input->producer()->set_in_and_out( 0, length - 1 );
+    // Generators don't describe their streams as files do
+    input->m_nbVideoTracks = 1;
+    return std::move( input );
+}
+
+std::unique_ptr<Backend::IInput>
+MLTInput::retimed( const char* path, double speed, bool frameBlending )
+{
+    auto proxies = Backend::instance()->proxies();
+    auto proxy = proxies.find( path );
+    std::string file = proxy != proxies.end() ? proxy->second : path;
+    // timewarp parses its speed in the C locale
+    std::ostringstream resource;
+    resource.imbue( std::locale::classic() );
+    resource << speed << ':' << file;
+    auto& mltProfile = static_cast<MLTProfile&>( Backend::instance()->profile() );
+    auto producer = new Mlt::Producer( *mltProfile.m_profile, "timewarp", resource.str().c_str() );
+    if ( producer->is_valid() == false )
+    {
+        delete producer;
+        throw InvalidServiceException();
+    }
+    std::unique_ptr<MLTInput> input( new MLTInput( producer ) );
+    if ( frameBlending == true )
+    {
+        Mlt::Filter blend( *mltProfile.m_profile, MLTFrameBlend::ServiceName );
+        blend.set( "resource", file.c_str() );
+        blend.set( "speed", speed );
+        blend.set( InternalFilterProperty, 1 );
+        producer->attach( blend );
+    }
+    return std::move( input );
+}
+
 bool
 MLTInput::isCut() const
 {
     return producer()->is_cut();
 }
 
+// As the xml consumer writes the properties' text
+static std::string
+xmlEscape( const std::string& str )
+{
+    std::string res;
+    for ( auto c : str )
+    {
+        switch ( c )
+        {
+        case '&': res += "&amp;"; break;
+        case '<': res += "&lt;"; break;
+        case '>': res += "&gt;"; break;
+        default: res += c;
+        }
+    }
+    return res;
+}
+
+std::unique_ptr<Backend::IInput>
+MLTInput::clone() const
+{
+    return duplicate( false, Backend::instance()->profile() );
+}
+
+std::unique_ptr<Backend::IInput>
+MLTInput::cloneOriginals() const
+{
+    return duplicate( true, Backend::instance()->profile() );
+}
+
+std::unique_ptr<Backend::IInput>
+MLTInput::clone( IProfile& profile ) const
+{
+    return duplicate( false, profile );
+}
+
+std::string
+MLTInput::toXml() const
+{
+    // melt doesn't know the mixer: a copy of the graph mixes its tracks with MLT's
+    // own transitions instead, without the track gains, pans and audio crossfades
+    auto copy = duplicate( true, Backend::instance()->profile() );
+    auto input = static_cast<MLTInput*>( copy.get() );
+    auto p = input->producer();
+    bool mixed = false;
+    for ( int i = p->filter_count() - 1; i >= 0; --i )
+    {
+        std::unique_ptr<Mlt::Filter> filter( p->filter( i ) );
+        auto service = filter != nullptr ? filter->get( "mlt_service" ) : nullptr;
+        if ( service == nullptr || strcmp( service, MLTAudioMixer::ServiceName ) != 0 )
+            continue;
+        p->detach( *filter );
+        mixed = true;
+    }
+    if ( mixed == true && p->type() == tractor_type )
+    {
+        auto& mltProfile = static_cast<MLTProfile&>( Backend::instance()->profile() );
+        Mlt::Tractor tractor( *p );
+        for ( int track = 1; track < tractor.count(); ++track )
+        {
+            Mlt::Transition mix( *mltProfile.m_profile, "mix" );
+            mix.set( "always_active", 1 );
+            mix.set( "sum", 1 );
+            tractor.plant_transition( mix, 0, track );
+        }
+    }
+    // The proxies were already replaced in the copy
+    return input->serialize( false );
+}
+
+std::string
+MLTInput::snapshot() const
+{
+    return serialize( true );
+}
+
+std::string
+MLTInput::serialize( bool originals, bool portable ) const
+{
+    auto& mltProfile = static_cast<MLTProfile&>( Backend::instance()->profile() );
+    Mlt::Consumer xml( *mltProfile.m_profile, "xml", "string" );
+    xml.set( "no_meta", 1 );
+    if ( portable == true )
+    {
+        // The in and out points, lengths and keyframes are then read back at the
+        // frame rate of the profile the document gets loaded in
+        xml.set( "no_profile", 1 );
+        xml.set( "time_format", "clock" );
+    }
+    xml.connect( *producer() );
+    xml.run();
+    auto str = xml.get( "string" );
+    if ( str == nullptr )
+        throw InvalidServiceException();
+
+    std::string document( str );
+    if ( originals == true )
+    {
+        for ( const auto& p : Backend::instance()->proxies() )
+        {
+            auto proxy = xmlEscape( p.second );
+            auto original = xmlEscape( p.first );
+            for ( auto pos = document.find( proxy ); pos != std::string::npos;
+                  pos = document.find( proxy, pos + original.size() ) )
+                document.replace( pos, proxy.size(), original );
+        }
+    }
+    return document;
+}
+
+std::unique_ptr<Backend::IInput>
+MLTInput::duplicate( bool originals, IProfile& profile ) const
+{
+    auto& mltProfile = static_cast<MLTProfile&>( profile );
+    // Round trip through the XML serialization, so that no service is shared.
+    // Clock times are rounded to the millisecond: they're only used when they must be.
+    auto& project = Backend::instance()->profile();
+    bool portable = &profile != &project &&
+            ( profile.frameRateNum() != project.frameRateNum() ||
+              profile.frameRateDen() != project.frameRateDen() );
+    auto document = serialize( originals, portable );
+    auto copy = new Mlt::Producer( *mltProfile.m_profile, "xml-string", document.c_str() );
+    if ( copy->is_valid() == false )
+    {
+        delete copy;
+        throw InvalidServiceException();
+    }
+    return std::unique_ptr<IInput>( new MLTInput( copy ) );
+}
+
 bool
 MLTInput::sameClip( Backend::IInput& that ) const
 {
-    MLTInput* input = dynamic_cast<MLTInput*>( &that );
-    assert( input );
+    auto& input = native( that );
 
-    return producer()->same_clip( *input->producer() );
+    return producer()->same_clip( *input.producer() );
 }
 
 bool
 MLTInput::runsInto( Backend::IInput& that ) const
 {
-    MLTInput* input = dynamic_cast<MLTInput*>( &that );
-    assert( input );
+    auto& input = native( that );
 
-    return producer()->runs_into( *input->producer() );
+    return producer()->runs_into( *input.producer() );
 }
 
 int64_t
@@ -232,6 +1016,12 @@ MLTInput::length() const
     return producer()->get_length();
 }
 
+void
+MLTInput::setLength( int64_t length )
+{
+    producer()->set( "length", (int)length );
+}
+
 const char*
 MLTInput::lengthTime() const
 {
@@ -247,9 +1037,44 @@ MLTInput::position() const
 void
 MLTInput::setPosition( int64_t position )
 {
+    Tools::Trace::add( Tools::Trace::SeekIssued, position, this );
     producer()->seek( position );
 }
 
+static void
+applySeekPrecision( Mlt::Producer& producer, Backend::IInput::SeekPrecision precision )
+{
+    bool fast = precision == Backend::IInput::Fast;
+    // The clips' decoders are opened already, only the audio can be served otherwise:
+    // the mixer reads it from the PCM caches.
+    if ( producer.type() == tractor_type )
+    {
+        producer.set( MLTAudioMixer::ScrubProperty, fast == true ? 1 : 0 );
+        return;
+    }
+    if ( producer.type() == playlist_type )
+        return;
+    // The avformat producer gives this to the decoder when it opens it, on the first
+    // frame. Skipping whole frames would make the seek land past the requested one,
+    // on the next keyframe, so only the deblocking gets skipped.
+    producer.parent().set( "skip_loop_filter", fast == true ? "all" : "default" );
+}
+
+void
+MLTInput::setSeekPrecision( SeekPrecision precision )
+{
+    if ( m_seekPrecision == precision )
+        return;
+    m_seekPrecision = precision;
+    applySeekPrecision( *producer(), precision );
+}
+
+Backend::IInput::SeekPrecision
+MLTInput::seekPrecision() const
+{
+    return m_seekPrecision;
+}
+
 int64_t
 MLTInput::frame() const
 {
@@ -263,11 +1088,41 @@ MLTInput::waveform( uint32_t width, uint32_t height ) const
     return waveformFrame->get_waveform( (int)width, (int)height );
 }
 
-uint8_t*
-MLTInput::image( uint32_t width, uint32_t height ) const
+std::shared_ptr<Backend::IAudioFrame>
+MLTInput::audio( uint32_t frequency, uint32_t channels ) const
 {
+    std::unique_ptr<Mlt::Frame> audioFrame( producer()->get_frame() );
+    if ( audioFrame == nullptr || audioFrame->is_valid() == false )
+        return nullptr;
+
+    mlt_audio_format format = mlt_audio_s16;
+    int freq = frequency;
+    int chans = channels;
+    int samples = mlt_sample_calculator( producer()->get_fps(), frequency, audioFrame->get_position() );
+    auto buffer = audioFrame->get_audio( format, freq, chans, samples );
+    if ( buffer == nullptr || format != mlt_audio_s16 || samples <= 0 )
+        return nullptr;
+    return std::make_shared<MLTAudioFrame>( audioFrame.release(), static_cast<const int16_t*>( buffer ),
+                                            samples, chans, freq );
+}
+
+std::shared_ptr<Backend::IVideoFrame>
+MLTInput::image( uint32_t width, uint32_t height, IVideoFrame::Format format ) const
+{
+    auto pos = producer()->position();
+    Tools::Trace::add( Tools::Trace::FrameRequested, pos, this );
+    auto start = std::chrono::steady_clock::now();
     std::unique_ptr<Mlt::Frame> imageFrame( producer()->get_frame() );
-    return imageFrame->fetch_image( mlt_image_rgb24a, (int)width, (int)height );
+    if ( imageFrame == nullptr || imageFrame->is_valid() == false )
+        return nullptr;
+    auto image = MLTVideoFrame::fromFrame( imageFrame.release(), width, height, format );
+    if ( image == nullptr )
+        return nullptr;
+    Tools::Trace::add( Tools::Trace::FrameDecoded, pos, this );
+    static auto& decodeTime = Tools::Metrics::histogram( "decode.frameTime" );
+    decodeTime.record( std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - start ).count() );
+    return image;
 }
 
 double
@@ -353,6 +1208,30 @@ MLTInput::setPause( bool isPaused )
     playPause();
 }
 
+void
+MLTInput::setSpeed( double speed )
+{
+    producer()->set_speed( speed );
+    bool paused = speed == 0.0;
+    if ( paused == m_paused )
+        return;
+    m_paused = paused;
+
+    if ( m_callback )
+    {
+        if ( m_paused == true )
+            m_callback->onPaused();
+        else
+            m_callback->onPlaying();
+    }
+}
+
+double
+MLTInput::speed() const
+{
+    return producer()->get_speed();
+}
+
 void
 MLTInput::nextFrame()
 {
@@ -385,19 +1264,25 @@ MLTInput::isBlank() const
 bool
 MLTInput::attach( Backend::IFilter& filter )
 {
-    MLTFilter* mltFilter = dynamic_cast<MLTFilter*>( &filter );
-    assert( mltFilter );
-    auto ret = producer()->attach( *mltFilter->filter() );
-    mltFilter->connect( *this );
+    auto& mltFilter = native( filter );
+    auto ret = producer()->attach( *mltFilter.filter() );
+    mltFilter.connect( *this );
+    raiseInternalFilters( *producer() );
+    // Where the preview finds the filtered images it already computed
+    MLTFilterCache::attach( *producer() );
+    updateFilters();
     return !ret;
 }
 
 bool
 MLTInput::detach( Backend::IFilter& filter )
 {
-    MLTFilter* mltFilter = dynamic_cast<MLTFilter*>( &filter );
-    assert( mltFilter );
-    return !producer()->detach( *mltFilter->filter() );
+    auto& mltFilter = native( filter );
+    auto ret = producer()->detach( *mltFilter.filter() );
+    if ( filterCount() == 0 )
+        MLTFilterCache::detach( *producer() );
+    updateFilters();
+    return !ret;
 }
 
 bool
@@ -406,23 +1291,57 @@ MLTInput::detach( int index )
     auto filter = producer()->filter( index );
     auto ret = producer()->detach( *filter );
     delete filter;
+    if ( filterCount() == 0 )
+        MLTFilterCache::detach( *producer() );
+    updateFilters();
     return !ret;
 }
 
 int
 MLTInput::filterCount() const
 {
-    return producer()->filter_count();
+    // The internal filters are always last, and aren't effects of the input
+    auto count = producer()->filter_count();
+    while ( count > 0 && isInternal( mlt_service_filter( producer()->get_service(), count - 1 ) ) == true )
+        --count;
+    return count;
 }
 
 bool
 MLTInput::moveFilter( int from, int to )
 {
-    return !producer()->move_filter( from, to );
+    auto ret = producer()->move_filter( from, to );
+    updateFilters();
+    return !ret;
 }
 
 std::shared_ptr<Backend::IFilter>
 MLTInput::filter( int index ) const
 {
-    return std::shared_ptr<Backend::IFilter>( new MLTFilter( producer()->filter( index ), producer() ) );
+    if ( index < 0 || index >= filterCount() )
+        return nullptr;
+    auto f = mlt_service_filter( producer()->get_service(), index );
+    if ( index >= (int)m_filters.size() || m_filters[index]->filter()->get_filter() != f )
+        updateFilters();
+    return m_filters[index];
+}
+
+void
+MLTInput::updateFilters() const
+{
+    std::vector<std::shared_ptr<MLTFilter>> filters;
+    auto count = filterCount();
+    filters.reserve( count );
+    for ( int i = 0; i < count; ++i )
+    {
+        auto f = mlt_service_filter( producer()->get_service(), i );
+        auto it = std::find_if( m_filters.begin(), m_filters.end(), [f]( const std::shared_ptr<MLTFilter>& w ) {
+            return w->filter()->get_filter() == f;
+        } );
+        if ( it != m_filters.end() )
+            filters.push_back( *it );
+        else
+            filters.push_back( std::make_shared<MLTFilter>( producer()->filter( i ), producer() ) );
+    }
+    m_filters.swap( filters );
 }
@@ -23,12 +23,21 @@
 #ifndef MLTINPUT_H
 #define MLTINPUT_H
 
+#include "Backend/IBackend.h"
 #include "Backend/IInput.h"
 #include "Backend/IProfile.h"
 #include "MLTService.h"
 
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
 namespace Mlt
 {
+class Frame;
 class Producer;
 }
 
@@ -36,6 +45,58 @@ namespace Backend
 {
 namespace MLT
 {
+class MLTFilter;
+
+class MLTVideoFrame : public IVideoFrame
+{
+    public:
+        // Takes ownership of the frame, which owns the image buffer
+        MLTVideoFrame( Mlt::Frame* frame, const uint8_t* data, uint32_t width, uint32_t height,
+                       Format format = RGBA );
+        ~MLTVideoFrame();
+
+        /**
+         *  \brief  Gets the frame's image in the requested format, converting it if needed.
+         *
+         *  Takes ownership of the frame. Returns nullptr if MLT can't provide that format.
+         */
+        static std::shared_ptr<MLTVideoFrame>   fromFrame( Mlt::Frame* frame, int width, int height,
+                                                           Format format );
+
+        virtual const uint8_t*  data() const override;
+        virtual uint32_t        width() const override;
+        virtual uint32_t        height() const override;
+        virtual uint32_t        stride() const override;
+        virtual Format          format() const override;
+
+    private:
+        std::unique_ptr<Mlt::Frame>     m_frame;
+        const uint8_t*                  m_data;
+        uint32_t                        m_width;
+        uint32_t                        m_height;
+        Format                          m_format;
+};
+
+class MLTAudioFrame : public IAudioFrame
+{
+    public:
+        // Takes ownership of the frame, which owns the samples buffer
+        MLTAudioFrame( Mlt::Frame* frame, const int16_t* samples, uint32_t nbSamples,
+                       uint32_t channels, uint32_t frequency );
+        ~MLTAudioFrame();
+
+        virtual const int16_t*  samples() const override;
+        virtual uint32_t        nbSamples() const override;
+        virtual uint32_t        channels() const override;
+        virtual uint32_t        frequency() const override;
+
+    private:
+        std::unique_ptr<Mlt::Frame>     m_frame;
+        const int16_t*                  m_samples;
+        uint32_t                        m_nbSamples;
+        uint32_t                        m_channels;
+        uint32_t                        m_frequency;
+};
 
 class MLTInput : virtual public IInput, public MLTService
 {
@@ -44,8 +105,81 @@ class MLTInput : virtual public IInput, public MLTService
         MLTInput( Mlt::Producer* input, IInputEventCb* callback = nullptr );
         MLTInput( const char* path, IInputEventCb* callback = nullptr );
         MLTInput( IProfile& profile, const char* path, IInputEventCb* callback = nullptr );
+        using Properties = std::map<std::string, std::string>;
+        /**
+         *  \brief Opens a file which was probed before, without probing it again.
+         *
+         *  The decoder is only opened once the first frame gets fetched, until then
+         *  the properties answer for it. \sa probedProperties()
+         */
+        MLTInput( const char* path, const Properties& probed, IInputEventCb* callback = nullptr );
         ~MLTInput();
 
+        // What probing the file told about it: its length, size and streams
+        Properties              probedProperties() const;
+        static Properties       probedProperties( Mlt::Producer& producer );
+        static MediaInfo        mediaInfo( const Properties& probed );
+
+        /**
+         *  \brief Tells if path is a still image, or a numbered image sequence such as
+         *         "frame%04d.png?begin=1", rather than a file for libavformat.
+         */
+        static bool             isImage( const char* path );
+        static bool             isImageSequence( const char* path );
+        /**
+         *  \brief Tells if path is a title file, rendered by the backend. \sa MLTTitle
+         */
+        static bool             isTitle( const char* path );
+        /**
+         *  \brief Tells if path is a multicam file, played by the backend. \sa MLTMulticam
+         */
+        static bool             isMulticam( const char* path );
+        /**
+         *  \brief Tells if path is a nested sequence file. \sa MLTNestedSequence
+         */
+        static bool             isNestedSequence( const char* path );
+
+        /**
+         *  \brief Returns the number of live inputs which opened a file, or were
+         *         deserialized, as opposed to the cuts sharing their decoder.
+         */
+        static uint32_t         nbSources();
+        // Same as nbSources(), with a given decode priority
+        static uint32_t         nbSources( IBackend::DecodePriority priority );
+
+        /**
+         *  \brief Moves the decoder to another share of the decode thread budget.
+         *
+         *  path is the file the input was opened on. Must be called before the first
+         *  frame gets decoded, when the decoder opens. Inputs open in the foreground.
+         */
+        void                    setDecodePriority( const char* path, IBackend::DecodePriority priority );
+
+        /**
+         *  \brief Opens a generated video source, such as "noise" or "color" and its
+         *         color, lasting length frames. For benchmarks, which need no media file,
+         *         and for the placeholders of the medias being opened.
+         */
+        static std::unique_ptr<IInput>  generator( const char* service, const char* resource,
+                                                   int64_t length );
+        /**
+         *  \brief Opens path played at speed, through a timewarp producer. A negative
+         *         speed plays it backward.
+         *
+         *  Its frame n shows the frame n * speed of the file, which is repeated when it's
+         *  slowed down, unless frameBlending is set, in which case it's blended with the
+         *  next one. \sa MLTFrameBlend
+         *  Throws InvalidServiceException if the file can't be opened.
+         */
+        static std::unique_ptr<IInput>  retimed( const char* path, double speed, bool frameBlending );
+
+        /**
+         *  \brief Set on the filters VLMC attaches for its own needs, such as the caches
+         *         and the audio meters. They are kept after the effects, and aren't
+         *         counted nor listed as filters of the input.
+         */
+        static const char* const        InternalFilterProperty;
+
         virtual Mlt::Producer*  producer();
         virtual Mlt::Producer*  producer() const;
 
@@ -54,6 +188,12 @@ class MLTInput : virtual public IInput, public MLTService
 
         static void             onPropertyChanged( void* owner, MLTInput* self, const char* id );
 
+        /**
+         *  \brief Ignores the video streams, which are then neither decoded nor
+         *         demuxed. Must be called before the first frame is fetched.
+         */
+        void                    disableVideo();
+
         virtual void            setCallback( IInputEventCb* callback ) override;
 
         virtual const char*     path() const override;
@@ -65,6 +205,11 @@ class MLTInput : virtual public IInput, public MLTService
 
         virtual std::unique_ptr<IInput>      cut( int64_t begin = 0, int64_t end = EndOfMedia ) override;
         virtual bool            isCut() const override;
+        virtual std::unique_ptr<IInput>      clone() const override;
+        virtual std::unique_ptr<IInput>      cloneOriginals() const override;
+        virtual std::unique_ptr<IInput>      clone( IProfile& profile ) const override;
+        virtual std::string     toXml() const override;
+        virtual std::string     snapshot() const override;
 
         virtual bool            sameClip( IInput& that ) const override;
         virtual bool            runsInto( IInput& that ) const override;
@@ -75,10 +220,19 @@ class MLTInput : virtual public IInput, public MLTService
         // The duration of the input regardless of begin and end points.
         virtual int64_t         length() const override;
         virtual const char*     lengthTime() const override;
+        /**
+         *  \brief Lets the input reach the frames appended to its file since it was
+         *         opened, without opening it again. The boundaries are left as is.
+         *
+         *  Cuts have a length of their own, which has to be set as well.
+         */
+        void                    setLength( int64_t length );
 
         // The position in frame relative to its beginning
         virtual int64_t         position() const override;
         virtual void            setPosition( int64_t position ) override;
+        virtual void            setSeekPrecision( SeekPrecision precision ) override;
+        virtual SeekPrecision   seekPrecision() const override;
 
         // The absolete position in frame
         virtual int64_t         frame() const override;
@@ -86,8 +240,10 @@ class MLTInput : virtual public IInput, public MLTService
         // Generates an 8-bit grayscale image at the current position
         virtual uint8_t*        waveform( uint32_t width, uint32_t height ) const override;
 
-        // Generates an 32-bit RGBA image at the current position
-        virtual uint8_t*        image( uint32_t width, uint32_t height ) const override;
+        virtual std::shared_ptr<IAudioFrame>    audio( uint32_t frequency, uint32_t channels ) const override;
+
+        virtual std::shared_ptr<IVideoFrame>    image( uint32_t width, uint32_t height,
+                                                       IVideoFrame::Format format = IVideoFrame::RGBA ) const override;
 
         virtual double          fps() const override;
         virtual double          aspectRatio() const override;
@@ -101,6 +257,8 @@ class MLTInput : virtual public IInput, public MLTService
         virtual void            playPause() override;
         virtual bool            isPaused() const override;
         virtual void            setPause( bool isPaused ) override;
+        virtual void            setSpeed( double speed ) override;
+        virtual double          speed() const override;
         virtual void            nextFrame() override;
         virtual void            previousFrame() override;
 
@@ -115,15 +273,60 @@ class MLTInput : virtual public IInput, public MLTService
     protected:
         MLTInput();
 
-        void                    calcTracks();
+        /**
+         *  \brief Counts the video and audio streams.
+         *
+         *  \param opened  true if the producer just opened its file, in which case the
+         *                 streams are enumerated and the result shared with the inputs
+         *                 later created on the same file.
+         */
+        void                    calcTracks( bool opened );
+        void                    positionChanged();
+        void                    setHardwareDecoding( const char* path );
+        void                    setDecodeThreads( const char* path );
+        void                    setSource();
+
+    private:
+        std::unique_ptr<IInput> duplicate( bool originals, IProfile& profile ) const;
+        /**
+         *  Throws InvalidServiceException if the graph can't be serialized.
+         *  A portable document has neither the profile nor positions in frames, so that
+         *  it can be loaded in a profile with another frame rate.
+         */
+        std::string             serialize( bool originals, bool portable = false ) const;
+        void                    openImage( IProfile& profile, const char* path, IInputEventCb* callback );
+        // The producer of a title or multicam file, nullptr for the other files
+        static const char*      documentService( const char* path );
+        void                    openDocument( IProfile& profile, const char* service, const char* path,
+                                              IInputEventCb* callback );
+        /**
+         *  \brief Matches m_filters with the producer's filters, keeping the wrappers of
+         *         the filters which are still attached.
+         *
+         *  Another input may wrap the same producer, so the list is checked against it
+         *  rather than trusted.
+         */
+        void                    updateFilters() const;
 
     private:
         Mlt::Producer*          m_producer;
         IInputEventCb*          m_callback;
         bool                    m_paused;
+        bool                    m_listening;
+        std::chrono::steady_clock::time_point   m_lastPositionNotification;
+        SeekPrecision           m_seekPrecision;
 
         int                     m_nbVideoTracks;
         int                     m_nbAudioTracks;
+        // Counted in s_nbSources
+        bool                    m_isSource;
+        // Counted in s_nbBackgroundSources when it's a source in the background
+        IBackend::DecodePriority    m_decodePriority;
+        // One per effect, in the producer's order
+        mutable std::vector<std::shared_ptr<MLTFilter>>  m_filters;
+
+        static std::atomic<uint32_t>    s_nbSources;
+        static std::atomic<uint32_t>    s_nbBackgroundSources;
 };
 
 }
@@ -0,0 +1,128 @@
+/*****************************************************************************
+ * MLTInputCache.cpp: Cache of opened Mlt::Producer, keyed by file path
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MLTInputCache.h"
+#include "MLTInput.h"
+
+using namespace Backend::MLT;
+
+// Rough estimate of what an opened decoder keeps around: a few reference frames
+static const size_t     EstimatedFramesPerInput = 4;
+
+MLTInputCache::MLTInputCache( size_t maxCount, size_t maxBytes )
+    : m_state( new State )
+{
+    m_state->maxCount = maxCount;
+    m_state->maxBytes = maxBytes;
+    m_state->bytes = 0;
+}
+
+MLTInputCache::~MLTInputCache()
+{
+    clear();
+}
+
+std::shared_ptr<Backend::IInput>
+MLTInputCache::acquire( const std::string& path, IInput::SeekPrecision precision )
+{
+    MLTInput* input = nullptr;
+    {
+        std::lock_guard<std::mutex> lock( m_state->mutex );
+        for ( auto it = m_state->idle.begin(); it != m_state->idle.end(); ++it )
+        {
+            if ( (*it).path != path || (*it).precision != precision )
+                continue;
+            input = (*it).input.release();
+            m_state->bytes -= (*it).cost;
+            m_state->idle.erase( it );
+            break;
+        }
+    }
+    if ( input == nullptr )
+    {
+        input = new MLTInput( path.c_str() );
+        // Thumbnails and waveforms mustn't take the threads of the playback decoders
+        input->setDecodePriority( path.c_str(), IBackend::Background );
+        // Before the first frame, while the decoder isn't opened yet
+        input->setSeekPrecision( precision );
+    }
+
+    std::weak_ptr<State> weakState = m_state;
+    return std::shared_ptr<IInput>( input, [weakState, path]( IInput* ptr )
+    {
+        auto state = weakState.lock();
+        if ( state == nullptr )
+            delete ptr;
+        else
+            state->release( path, static_cast<MLTInput*>( ptr ) );
+    } );
+}
+
+void
+MLTInputCache::setLimits( size_t maxCount, size_t maxBytes )
+{
+    std::lock_guard<std::mutex> lock( m_state->mutex );
+    m_state->maxCount = maxCount;
+    m_state->maxBytes = maxBytes;
+    m_state->evict();
+}
+
+void
+MLTInputCache::clear()
+{
+    std::list<Entry>    idle;
+    {
+        std::lock_guard<std::mutex> lock( m_state->mutex );
+        idle.swap( m_state->idle );
+        m_state->bytes = 0;
+    }
+    // Producers get closed here, outside of the lock
+}
+
+size_t
+MLTInputCache::cost( const MLTInput& input )
+{
+    if ( input.hasVideo() == false )
+        return 0;
+    return (size_t)input.width() * input.height() * 4 * EstimatedFramesPerInput;
+}
+
+void
+MLTInputCache::State::release( const std::string& path, MLTInput* input )
+{
+    input->setCallback( nullptr );
+    auto c = cost( *input );
+    std::lock_guard<std::mutex> lock( mutex );
+    idle.emplace_front( Entry{ path, input->seekPrecision(), std::unique_ptr<MLTInput>( input ), c } );
+    bytes += c;
+    evict();
+}
+
+void
+MLTInputCache::State::evict()
+{
+    while ( idle.empty() == false && ( idle.size() > maxCount || bytes > maxBytes ) )
+    {
+        bytes -= idle.back().cost;
+        idle.pop_back();
+    }
+}
@@ -0,0 +1,103 @@
+/*****************************************************************************
+ * MLTInputCache.h: Cache of opened Mlt::Producer, keyed by file path
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTINPUTCACHE_H
+#define MLTINPUTCACHE_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Backend/IInput.h"
+
+namespace Backend
+{
+
+namespace MLT
+{
+class MLTInput;
+
+/**
+ *  \brief  Keeps recently used inputs opened so that repeated accesses to the same file
+ *          only pay for a seek and a decode, instead of a full demuxer/decoder setup.
+ *
+ *  An input is checked out exclusively by acquire(), and goes back to the cache once
+ *  the last reference to it is dropped. Idle inputs are evicted in LRU order as soon as
+ *  the count or estimated memory limits are exceeded.
+ */
+class MLTInputCache
+{
+    public:
+        static const size_t         DefaultMaxCount = 16;
+        static const size_t         DefaultMaxBytes = 512 * 1024 * 1024;
+
+        MLTInputCache( size_t maxCount = DefaultMaxCount, size_t maxBytes = DefaultMaxBytes );
+        ~MLTInputCache();
+
+        /**
+         *  \brief  Checks out an input opened on path, opening a new one if none is idle.
+         *
+         *  Only the idle inputs opened with the same seek precision are reused, as their
+         *  decoders applied it when they opened. Throws InvalidServiceException if the
+         *  file can't be opened.
+         */
+        std::shared_ptr<IInput>     acquire( const std::string& path, IInput::SeekPrecision precision );
+
+        void                        setLimits( size_t maxCount, size_t maxBytes );
+        /**
+         *  \brief  Closes every idle input. Checked out inputs are deleted when released.
+         */
+        void                        clear();
+
+    private:
+        struct Entry
+        {
+            std::string                 path;
+            IInput::SeekPrecision       precision;
+            std::unique_ptr<MLTInput>   input;
+            size_t                      cost;
+        };
+
+        struct State
+        {
+            std::mutex          mutex;
+            // Most recently used first
+            std::list<Entry>    idle;
+            size_t              maxCount;
+            size_t              maxBytes;
+            size_t              bytes;
+
+            void                release( const std::string& path, MLTInput* input );
+            void                evict();
+        };
+
+        static size_t               cost( const MLTInput& input );
+
+        std::shared_ptr<State>      m_state;
+};
+
+}
+}
+
+#endif // MLTINPUTCACHE_H
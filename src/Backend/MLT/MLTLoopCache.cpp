@@ -0,0 +1,278 @@
+/*****************************************************************************
+ * MLTLoopCache.cpp: Keeps the images of a looped range in memory
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MLTLoopCache.h"
+#include "MLTBinding.h"
+#include "MLTInput.h"
+#include "Tools/Metrics.h"
+
+#include <mlt++/MltFilter.h>
+#include <mlt++/MltProducer.h>
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+using namespace Backend::MLT;
+
+namespace
+{
+
+const char  StateProperty[] = "_vlmc_loop_cache";
+
+struct Image
+{
+    // As requested, the image may be of another format or size
+    mlt_image_format        requestedFormat;
+    int                     requestedWidth;
+    int                     requestedHeight;
+    mlt_image_format        format;
+    int                     width;
+    int                     height;
+    std::vector<uint8_t>    image;
+    std::vector<uint8_t>    alpha;
+
+    size_t  size() const { return image.size() + alpha.size(); }
+};
+
+Tools::Metrics::MemoryAccount&
+account()
+{
+    static auto& account = Tools::Metrics::memory( "backend.loopCache" );
+    return account;
+}
+
+}
+
+struct MLTLoopCache::State
+{
+    std::mutex                      mutex;
+    int64_t                         begin = 0;
+    int64_t                         end = 0;
+    size_t                          maxBytes = 0;
+    size_t                          nbBytes = 0;
+    // Bumped by every invalidation, so that the images rendered meanwhile aren't kept
+    uint64_t                        generation = 0;
+    std::map<mlt_position, Image>   images;
+
+    // Called with the mutex held
+    void
+    drop( std::map<mlt_position, Image>::iterator begin, std::map<mlt_position, Image>::iterator end )
+    {
+        size_t  bytes = 0;
+        int64_t count = 0;
+        for ( auto it = begin; it != end; ++it, ++count )
+            bytes += it->second.size();
+        images.erase( begin, end );
+        nbBytes -= bytes;
+        ++generation;
+        account().remove( bytes, count );
+    }
+};
+
+namespace
+{
+
+void
+destroy( void* data )
+{
+    auto state = static_cast<MLTLoopCache::State*>( data );
+    {
+        std::lock_guard<std::mutex> lock( state->mutex );
+        state->drop( state->images.begin(), state->images.end() );
+    }
+    delete state;
+}
+
+int
+getImage( mlt_frame frame, uint8_t** image, mlt_image_format* format, int* width,
+          int* height, int writable )
+{
+    auto filter = static_cast<mlt_filter>( mlt_frame_pop_service( frame ) );
+    auto state = static_cast<MLTLoopCache::State*>( mlt_properties_get_data(
+                        MLT_FILTER_PROPERTIES( filter ), StateProperty, nullptr ) );
+    // The frames of a cut have the positions of the producer it was cut from
+    auto pos = mlt_frame_get_position( frame );
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock( state->mutex );
+        generation = state->generation;
+        auto it = state->images.end();
+        if ( pos >= state->begin && pos < state->end )
+            it = state->images.find( pos );
+        if ( it != state->images.end() && it->second.requestedFormat == *format &&
+             it->second.requestedWidth == *width && it->second.requestedHeight == *height )
+        {
+            const auto& img = it->second;
+            auto buffer = static_cast<uint8_t*>( mlt_pool_alloc( img.image.size() ) );
+            memcpy( buffer, img.image.data(), img.image.size() );
+            mlt_frame_set_image( frame, buffer, img.image.size(), mlt_pool_release );
+            if ( img.alpha.empty() == false )
+            {
+                auto alpha = static_cast<uint8_t*>( mlt_pool_alloc( img.alpha.size() ) );
+                memcpy( alpha, img.alpha.data(), img.alpha.size() );
+                mlt_frame_set_alpha( frame, alpha, img.alpha.size(), mlt_pool_release );
+            }
+            *image = buffer;
+            *format = img.format;
+            *width = img.width;
+            *height = img.height;
+            return 0;
+        }
+    }
+
+    Image img;
+    img.requestedFormat = *format;
+    img.requestedWidth = *width;
+    img.requestedHeight = *height;
+    auto res = mlt_frame_get_image( frame, image, format, width, height, writable );
+    if ( res != 0 || *image == nullptr )
+        return res;
+    auto size = mlt_image_format_size( *format, *width, *height, nullptr );
+    int alphaSize = 0;
+    auto alpha = static_cast<uint8_t*>( mlt_properties_get_data( MLT_FRAME_PROPERTIES( frame ),
+                                                                 "alpha", &alphaSize ) );
+    if ( size <= 0 )
+        return res;
+
+    std::lock_guard<std::mutex> lock( state->mutex );
+    // Changed while it was rendered
+    if ( generation != state->generation || pos < state->begin || pos >= state->end )
+        return res;
+    auto it = state->images.find( pos );
+    size_t previous = 0;
+    if ( it != state->images.end() )
+    {
+        // Rendered at another size since
+        previous = it->second.size();
+        account().remove( previous );
+    }
+    if ( state->nbBytes - previous + size + alphaSize > state->maxBytes )
+    {
+        if ( it != state->images.end() )
+            state->images.erase( it );
+        state->nbBytes -= previous;
+        return res;
+    }
+    img.format = *format;
+    img.width = *width;
+    img.height = *height;
+    img.image.assign( *image, *image + size );
+    if ( alpha != nullptr && alphaSize > 0 )
+        img.alpha.assign( alpha, alpha + alphaSize );
+    state->nbBytes = state->nbBytes - previous + img.size();
+    account().add( img.size() );
+    state->images[pos] = std::move( img );
+    return res;
+}
+
+mlt_frame
+process( mlt_filter filter, mlt_frame frame )
+{
+    mlt_frame_push_service( frame, filter );
+    mlt_frame_push_get_image( frame, getImage );
+    return frame;
+}
+
+}
+
+MLTLoopCache::MLTLoopCache( IInput& input, size_t maxBytes )
+    : m_producer( new Mlt::Producer( *native( input ).producer() ) )
+    , m_state( new State )
+{
+    m_state->maxBytes = maxBytes;
+    auto filter = mlt_filter_new();
+    if ( filter == nullptr )
+    {
+        delete m_state;
+        m_state = nullptr;
+        return;
+    }
+    filter->process = process;
+    auto properties = MLT_FILTER_PROPERTIES( filter );
+    // Not written by the xml consumer
+    mlt_properties_set_int( properties, "_loader", 1 );
+    mlt_properties_set_int( properties, MLTInput::InternalFilterProperty, 1 );
+    mlt_properties_set_data( properties, StateProperty, m_state, 0, destroy, nullptr );
+    m_filter.reset( new Mlt::Filter( filter ) );
+    // m_filter holds its own reference
+    mlt_filter_close( filter );
+    // After the sequence filters, so that they're cached too
+    m_producer->attach( *m_filter );
+}
+
+MLTLoopCache::~MLTLoopCache()
+{
+    if ( m_filter != nullptr )
+        m_producer->detach( *m_filter );
+}
+
+void
+MLTLoopCache::setRange( int64_t begin, int64_t end )
+{
+    if ( m_state == nullptr )
+        return;
+    begin += offset();
+    end += offset();
+    std::lock_guard<std::mutex> lock( m_state->mutex );
+    if ( begin == m_state->begin && end == m_state->end )
+        return;
+    m_state->begin = begin;
+    m_state->end = end;
+    m_state->drop( m_state->images.begin(), m_state->images.lower_bound( begin ) );
+    m_state->drop( m_state->images.lower_bound( end ), m_state->images.end() );
+}
+
+void
+MLTLoopCache::invalidate( int64_t begin, int64_t end )
+{
+    if ( m_state == nullptr )
+        return;
+    std::lock_guard<std::mutex> lock( m_state->mutex );
+    auto last = end < 0 ? m_state->images.end() : m_state->images.lower_bound( end + offset() );
+    m_state->drop( m_state->images.lower_bound( begin + offset() ), last );
+}
+
+void
+MLTLoopCache::clear()
+{
+    if ( m_state == nullptr )
+        return;
+    std::lock_guard<std::mutex> lock( m_state->mutex );
+    m_state->drop( m_state->images.begin(), m_state->images.end() );
+}
+
+size_t
+MLTLoopCache::nbFrames() const
+{
+    if ( m_state == nullptr )
+        return 0;
+    std::lock_guard<std::mutex> lock( m_state->mutex );
+    return m_state->images.size();
+}
+
+int64_t
+MLTLoopCache::offset() const
+{
+    return m_producer->is_cut() == true ? m_producer->get_in() : 0;
+}
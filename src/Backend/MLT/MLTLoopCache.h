@@ -0,0 +1,97 @@
+/*****************************************************************************
+ * MLTLoopCache.h: Keeps the images of a looped range in memory
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTLOOPCACHE_H
+#define MLTLOOPCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Mlt
+{
+class Filter;
+class Producer;
+}
+
+namespace Backend
+{
+class IInput;
+
+namespace MLT
+{
+
+/**
+ *  \brief  Pins the images of a range of an input in memory, while it gets looped.
+ *
+ *  A filter attached after the others of the input remembers the image of each frame
+ *  of the range the first time it's rendered, and hands it over on the following
+ *  passes: the decoders, the effects and the compositing aren't run again, however
+ *  expensive they are. Unlike MLTFilterCache, the images aren't evicted as others get
+ *  rendered, they are only dropped when the range changes or gets invalidated. Those
+ *  which don't fit in MaxBytes are rendered on every pass.
+ *  It's a loader filter too, which the exports never get a copy of.
+ *  The images are kept by position in the producer the input was cut from, so those
+ *  of a clip input survive the trims of the clip.
+ */
+class MLTLoopCache
+{
+    public:
+        static const size_t     MaxBytes = 1024 * 1024 * 1024;
+
+        explicit MLTLoopCache( IInput& input, size_t maxBytes = MaxBytes );
+        ~MLTLoopCache();
+
+        /**
+         *  \brief  Pins the frames [begin, end) from now on. The images outside of it
+         *          are dropped.
+         *
+         *  As for invalidate(), the positions are relative to the current beginning of
+         *  the input, which may be before its first frame or after its last one.
+         */
+        void                    setRange( int64_t begin, int64_t end );
+        /**
+         *  \brief  Drops the images of [begin, end), which have to be rendered again.
+         *          A negative end drops every image after begin.
+         */
+        void                    invalidate( int64_t begin, int64_t end );
+        // Drops every image, after the filters of the input changed
+        void                    clear();
+        size_t                  nbFrames() const;
+
+        // Owned by the filter, whose image callback runs on the output thread
+        struct  State;
+
+    private:
+        // A reference of its own, the input may be released first
+        std::unique_ptr<Mlt::Producer>  m_producer;
+        std::unique_ptr<Mlt::Filter>    m_filter;
+        // Converts the positions of the input to the ones of its frames
+        int64_t                 offset() const;
+        // Owned by the filter
+        State*                  m_state;
+};
+
+}
+}
+
+#endif // MLTLOOPCACHE_H
@@ -0,0 +1,144 @@
+/*****************************************************************************
+ * MLTLut.cpp: 3D LUT colour grading filter
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MLTLut.h"
+#include "Tools/Lut3D.h"
+
+#include <mlt++/MltRepository.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+using namespace Backend::MLT;
+
+const char* const MLTLut::ServiceName = "vlmc_lut";
+
+namespace
+{
+
+const char  StateProperty[] = "_vlmc_lut";
+
+// The table of the file the filter was last given, as frames can be rendered in parallel
+struct State
+{
+    std::mutex                          mutex;
+    std::string                         path;
+    std::shared_ptr<const Tools::Lut3D> lut;
+};
+
+void
+destroyState( void* data )
+{
+    delete static_cast<State*>( data );
+}
+
+std::shared_ptr<const Tools::Lut3D>
+lut( mlt_filter filter )
+{
+    auto properties = MLT_FILTER_PROPERTIES( filter );
+    auto state = static_cast<State*>( mlt_properties_get_data( properties, StateProperty, nullptr ) );
+    auto file = mlt_properties_get( properties, "file" );
+    if ( state == nullptr || file == nullptr || *file == 0 )
+        return nullptr;
+    std::lock_guard<std::mutex> lock( state->mutex );
+    if ( state->path != file )
+    {
+        state->path = file;
+        state->lut = Tools::Lut3D::load( state->path );
+        if ( state->lut == nullptr )
+            mlt_log_warning( MLT_FILTER_SERVICE( filter ), "Can't load LUT %s\n", file );
+    }
+    return state->lut;
+}
+
+int
+getImage( mlt_frame frame, uint8_t** image, mlt_image_format* format, int* width, int* height,
+          int writable )
+{
+    auto filter = static_cast<mlt_filter>( mlt_frame_pop_service( frame ) );
+    auto table = lut( filter );
+    if ( table == nullptr )
+        return mlt_frame_get_image( frame, image, format, width, height, writable );
+    // Alpha goes along with the colours, which keeps them 4 bytes aligned
+    *format = mlt_image_rgb24a;
+    auto res = mlt_frame_get_image( frame, image, format, width, height, 1 );
+    if ( res != 0 || *image == nullptr || *format != mlt_image_rgb24a )
+        return res;
+    table->applySliced( *image, static_cast<size_t>( *width ) * *height );
+    return 0;
+}
+
+mlt_frame
+process( mlt_filter filter, mlt_frame frame )
+{
+    mlt_frame_push_service( frame, filter );
+    mlt_frame_push_get_image( frame, getImage );
+    return frame;
+}
+
+void*
+create( mlt_profile, mlt_service_type, const char*, const void* arg )
+{
+    auto filter = mlt_filter_new();
+    if ( filter == nullptr )
+        return nullptr;
+    filter->process = process;
+    auto properties = MLT_FILTER_PROPERTIES( filter );
+    if ( arg != nullptr )
+        mlt_properties_set( properties, "file", static_cast<const char*>( arg ) );
+    mlt_properties_set_data( properties, StateProperty, new State, 0, destroyState, nullptr );
+    return filter;
+}
+
+// Described the way the yml files of the other filters are, as EffectHelper reads them
+mlt_properties
+metadata( mlt_service_type, const char*, void* )
+{
+    auto m = mlt_properties_new();
+    mlt_properties_set( m, "identifier", MLTLut::ServiceName );
+    mlt_properties_set( m, "title", "3D LUT" );
+    mlt_properties_set( m, "description", "Grades the colours through a 3D lookup table, "
+                                          "from a .cube file" );
+    mlt_properties_set( m, "creator", "VideoLAN" );
+
+    auto file = mlt_properties_new();
+    mlt_properties_set( file, "identifier", "file" );
+    mlt_properties_set( file, "title", "LUT file" );
+    mlt_properties_set( file, "type", "string" );
+    mlt_properties_set( file, "description", "The .cube file of the LUT" );
+    mlt_properties_set( file, "default", "" );
+
+    auto parameters = mlt_properties_new();
+    mlt_properties_set_data( parameters, "0", file, 0, (mlt_destructor)mlt_properties_close, nullptr );
+    mlt_properties_set_data( m, "parameters", parameters, 0, (mlt_destructor)mlt_properties_close, nullptr );
+    return m;
+}
+
+}
+
+void
+MLTLut::registerService( Mlt::Repository& repository )
+{
+    repository.register_service( mlt_service_filter_type, ServiceName, create );
+    repository.register_metadata( mlt_service_filter_type, ServiceName, metadata, nullptr );
+}
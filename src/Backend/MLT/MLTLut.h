@@ -0,0 +1,62 @@
+/*****************************************************************************
+ * MLTLut.h: 3D LUT colour grading filter
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTLUT_H
+#define MLTLUT_H
+
+namespace Mlt
+{
+class Repository;
+}
+
+namespace Backend
+{
+namespace MLT
+{
+
+/**
+ *  \brief  Grades the frames through a 3D LUT, read from the .cube file of its "file"
+ *          parameter.
+ *
+ *  This replaces a chain of colour filters by a single lookup per pixel, mapped with
+ *  vector instructions, and across slices of the frame in parallel. The tables are
+ *  shared, so the same LUT applied to many clips is only parsed once. \sa Tools::Lut3D
+ *
+ *  Unlike the mixer, it is an effect: registerService() describes it along with the
+ *  filters of the repository, so it can be added to clips, tracks and the sequence.
+ */
+class MLTLut
+{
+    public:
+        static const char* const    ServiceName;
+
+        /**
+         *  \brief  Registers the filter and its metadata. Must be called before the
+         *          filters are listed.
+         */
+        static void                 registerService( Mlt::Repository& repository );
+};
+
+}
+}
+
+#endif // MLTLUT_H
@@ -26,14 +26,17 @@
 
 #include "MLTMultiTrack.h"
 
+#include <mlt++/MltField.h>
 #include <mlt++/MltTractor.h>
 #include "MLTProfile.h"
 #include "MLTBackend.h"
+#include "MLTBinding.h"
 #include "MLTTransition.h"
 #include "MLTFilter.h"
 #include "Tools/VlmcDebug.h"
 
 #include <cassert>
+#include <memory>
 
 using namespace Backend::MLT;
 
@@ -87,17 +90,15 @@ MLTMultiTrack::refresh()
 bool
 MLTMultiTrack::setTrack( Backend::IInput& input, int index )
 {
-    MLTInput* mltInput = dynamic_cast<MLTInput*>( &input );
-    assert( mltInput );
-    return !tractor()->set_track( *mltInput->producer(), index );
+    auto& mltInput = native( input );
+    return !tractor()->set_track( *mltInput.producer(), index );
 }
 
 bool
 MLTMultiTrack::insertTrack( Backend::IInput& input, int index )
 {
-    MLTInput* mltInput = dynamic_cast<MLTInput*>( &input );
-    assert( mltInput );
-    return !tractor()->insert_track( *mltInput->producer(), index );
+    auto& mltInput = native( input );
+    return !tractor()->insert_track( *mltInput.producer(), index );
 }
 
 bool
@@ -121,21 +122,28 @@ MLTMultiTrack::count() const
 void
 MLTMultiTrack::addTransition( Backend::ITransition& transition, int aTrack, int bTrack )
 {
-    MLTTransition* mltTransition = dynamic_cast<MLTTransition*>( &transition );
-    tractor()->plant_transition( mltTransition->transition(), aTrack, bTrack );
+    auto& mltTransition = native( transition );
+    tractor()->plant_transition( mltTransition.transition(), aTrack, bTrack );
+}
+
+void
+MLTMultiTrack::removeTransition( Backend::ITransition& transition )
+{
+    auto& mltTransition = native( transition );
+    std::unique_ptr<Mlt::Field> field( tractor()->field() );
+    field->disconnect_service( *mltTransition.transition() );
 }
 
 void
 MLTMultiTrack::addFilter( Backend::IFilter& filter, int track )
 {
-    MLTFilter* mltFilter = dynamic_cast<MLTFilter*>( &filter );
-    tractor()->plant_filter( mltFilter->filter(), track );
+    auto& mltFilter = native( filter );
+    tractor()->plant_filter( mltFilter.filter(), track );
 }
 
 bool
 MLTMultiTrack::connect( Backend::IInput& input )
 {
-    MLTInput* mltInput = dynamic_cast<MLTInput*>( &input );
-    assert( mltInput );
-    return !tractor()->connect( *mltInput->producer() );
+    auto& mltInput = native( input );
+    return !tractor()->connect( *mltInput.producer() );
 }
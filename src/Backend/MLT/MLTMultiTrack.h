@@ -56,6 +56,7 @@ namespace MLT
         virtual IInput*     track( int index ) const override;
         virtual int         count() const override;
         virtual void        addTransition( ITransition& transition, int aTrack, int bTrack ) override;
+        virtual void        removeTransition( ITransition& transition ) override;
         virtual void        addFilter( IFilter& filter, int track ) override;
         virtual bool        connect( IInput& input ) override;
 
@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * MLTMulticam.cpp: Producer playing the active angle of a multicam clip
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MLTMulticam.h"
+
+#include "Backend/IBackend.h"
+#include "Tools/Multicam.h"
+
+#include <mlt++/MltRepository.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace Backend::MLT;
+
+const char* const MLTMulticam::ServiceName = "vlmc_multicam";
+
+namespace
+{
+
+const char  StateProperty[] = "_vlmc_multicam";
+
+// The angles' decoders, opened as they get shown
+struct State
+{
+    State( mlt_profile p, const Tools::Multicam& m )
+        : profile( p )
+        , multicam( m )
+        , producers( m.angles.size(), nullptr )
+        , black( nullptr )
+    {
+    }
+    ~State()
+    {
+        for ( auto p : producers )
+        {
+            if ( p != nullptr )
+                mlt_producer_close( p );
+        }
+        if ( black != nullptr )
+            mlt_producer_close( black );
+    }
+
+    std::mutex                  mutex;
+    mlt_profile                 profile;
+    const Tools::Multicam       multicam;
+    std::vector<mlt_producer>   producers;
+    mlt_producer                black;
+};
+
+void
+destroyState( void* data )
+{
+    delete static_cast<State*>( data );
+}
+
+// Must be called with the lock held
+mlt_producer
+angleProducer( State& state, int angle )
+{
+    auto& p = state.producers[angle];
+    if ( p == nullptr )
+    {
+        auto path = state.multicam.angles[angle].filePath.toStdString();
+        auto loader = "avformat:" + path;
+        p = mlt_factory_producer( state.profile, "loader", loader.c_str() );
+        // Only the active angle decodes, in the foreground
+        auto threads = Backend::instance()->decodeThreads( path, Backend::IBackend::Foreground );
+        if ( p != nullptr && threads > 0 )
+            mlt_properties_set_int( MLT_PRODUCER_PROPERTIES( p ), "threads", threads );
+    }
+    return p;
+}
+
+int
+getFrame( mlt_producer producer, mlt_frame* frame, int index )
+{
+    auto state = static_cast<State*>( mlt_properties_get_data( MLT_PRODUCER_PROPERTIES( producer ),
+                                                               StateProperty, nullptr ) );
+    if ( state == nullptr )
+        return 1;
+    auto position = mlt_producer_position( producer );
+    std::lock_guard<std::mutex> lock( state->mutex );
+    auto angle = state->multicam.activeAngle( position );
+    mlt_position sourcePosition = position - state->multicam.angles[angle].offset;
+    auto source = angleProducer( *state, angle );
+    if ( source != nullptr && ( sourcePosition < 0 || sourcePosition >= mlt_producer_get_length( source ) ) )
+        source = nullptr;
+    if ( source == nullptr )
+    {
+        if ( state->black == nullptr )
+            state->black = mlt_factory_producer( state->profile, "color", "#000000" );
+        source = state->black;
+        sourcePosition = 0;
+    }
+    *frame = nullptr;
+    if ( source != nullptr )
+    {
+        mlt_producer_seek( source, sourcePosition );
+        mlt_service_get_frame( MLT_PRODUCER_SERVICE( source ), frame, index );
+    }
+    if ( *frame == nullptr )
+        *frame = mlt_frame_init( MLT_PRODUCER_SERVICE( producer ) );
+    mlt_frame_set_position( *frame, position );
+    mlt_producer_prepare_next( producer );
+    return 0;
+}
+
+void*
+create( mlt_profile profile, mlt_service_type, const char*, const void* arg )
+{
+    auto path = static_cast<const char*>( arg );
+    Tools::Multicam multicam;
+    if ( path == nullptr || Tools::Multicam::load( QString::fromUtf8( path ), multicam ) == false )
+        return nullptr;
+    auto producer = mlt_producer_new( profile );
+    if ( producer == nullptr )
+        return nullptr;
+    producer->get_frame = getFrame;
+    auto properties = MLT_PRODUCER_PROPERTIES( producer );
+    mlt_properties_set( properties, "resource", path );
+    mlt_properties_set_int( properties, "length", static_cast<int>( multicam.nbFrames ) );
+    mlt_properties_set_int( properties, "out", static_cast<int>( multicam.nbFrames - 1 ) );
+    mlt_properties_set_int( properties, "width", profile->width );
+    mlt_properties_set_int( properties, "height", profile->height );
+    mlt_properties_set_data( properties, StateProperty, new State( profile, multicam ), 0,
+                             destroyState, nullptr );
+    return producer;
+}
+
+}
+
+void
+MLTMulticam::registerService( Mlt::Repository& repository )
+{
+    repository.register_service( mlt_service_producer_type, ServiceName, create );
+}
@@ -0,0 +1,57 @@
+/*****************************************************************************
+ * MLTMulticam.h: Producer playing the active angle of a multicam clip
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTMULTICAM_H
+#define MLTMULTICAM_H
+
+namespace Mlt
+{
+class Repository;
+}
+
+namespace Backend
+{
+namespace MLT
+{
+
+/**
+ *  \brief  Produces the frames of a multicam clip, from its "resource" multicam file.
+ *
+ *  Each frame is the one of the angle active at its position, at full resolution: the
+ *  other angles aren't decoded at all. An angle's decoder is only opened once it is
+ *  first shown, and then kept along with the producer, so that switching angles back
+ *  and forth doesn't open the files again. Frames outside of an angle are black.
+ *  Switching angles writes a new multicam file, which is opened as a new producer.
+ *  \sa Tools::Multicam, MulticamViewer
+ */
+class MLTMulticam
+{
+    public:
+        static const char* const    ServiceName;
+
+        static void                 registerService( Mlt::Repository& repository );
+};
+
+}
+}
+
+#endif // MLTMULTICAM_H
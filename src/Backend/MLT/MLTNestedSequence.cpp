@@ -0,0 +1,202 @@
+/*****************************************************************************
+ * MLTNestedSequence.cpp: Plays a nested sequence as a single producer
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MLTNestedSequence.h"
+
+#include "Backend/IBackend.h"
+#include "Tools/NestedSequence.h"
+#include "Tools/VlmcDebug.h"
+
+#include <mlt++/MltRepository.h>
+
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace Backend::MLT;
+
+const char* const MLTNestedSequence::ServiceName = "vlmc_sequence";
+const char* const MLTNestedSequence::FlattenedProperty = "vlmc.flattened";
+
+namespace
+{
+
+const char  StateProperty[] = "_vlmc_sequence";
+
+// The sequences being opened by this thread: the graph of a sequence creates the producers
+// of the sequences it contains before its own producer is returned.
+thread_local std::vector<std::string>   opening;
+
+/**
+ *  The producers the frames are pulled from. A producer can't render two positions at
+ *  once: each thread asking for a frame takes an idle one, and creates another one
+ *  when they are all busy, instead of waiting for the others.
+ */
+struct State
+{
+    State( mlt_profile p, std::string g )
+        : profile( p )
+        , graph( std::move( g ) )
+    {
+    }
+    ~State()
+    {
+        for ( auto p : idle )
+            mlt_producer_close( p );
+    }
+
+    mlt_producer
+    take( mlt_producer producer )
+    {
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            if ( idle.empty() == false )
+            {
+                auto p = idle.back();
+                idle.pop_back();
+                return p;
+            }
+        }
+        // The flattened render is only named while it can stand for the sequence, the
+        // exports get the resource in its place. \sa IInput::cloneOriginals()
+        auto properties = MLT_PRODUCER_PROPERTIES( producer );
+        auto resource = mlt_properties_get( properties, "resource" );
+        auto flattened = mlt_properties_get( properties, MLTNestedSequence::FlattenedProperty );
+        if ( flattened != nullptr && resource != nullptr && strcmp( flattened, resource ) != 0 &&
+             QFile::exists( QString::fromUtf8( flattened ) ) == true )
+        {
+            auto p = mlt_factory_producer( profile, "avformat", flattened );
+            if ( p != nullptr )
+                return p;
+            vlmcWarning() << "Can't decode the flattened sequence" << flattened;
+        }
+        opening.push_back( canonical );
+        auto p = mlt_factory_producer( profile, "xml-string", graph.c_str() );
+        opening.pop_back();
+        return p;
+    }
+
+    void
+    release( mlt_producer p )
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        idle.push_back( p );
+    }
+
+    mlt_profile                 profile;
+    std::string                 graph;
+    std::string                 canonical;
+    std::mutex                  mutex;
+    std::vector<mlt_producer>   idle;
+};
+
+void
+destroyState( void* data )
+{
+    delete static_cast<State*>( data );
+}
+
+int
+getFrame( mlt_producer producer, mlt_frame* frame, int index )
+{
+    auto state = static_cast<State*>( mlt_properties_get_data( MLT_PRODUCER_PROPERTIES( producer ),
+                                                               StateProperty, nullptr ) );
+    if ( state == nullptr )
+        return 1;
+    auto position = mlt_producer_position( producer );
+    *frame = nullptr;
+    auto inner = state->take( producer );
+    if ( inner != nullptr )
+    {
+        mlt_producer_seek( inner, position );
+        mlt_service_get_frame( MLT_PRODUCER_SERVICE( inner ), frame, index );
+        state->release( inner );
+    }
+    if ( *frame == nullptr )
+        *frame = mlt_frame_init( MLT_PRODUCER_SERVICE( producer ) );
+    mlt_frame_set_position( *frame, position );
+    mlt_producer_prepare_next( producer );
+    return 0;
+}
+
+void*
+create( mlt_profile profile, mlt_service_type, const char*, const void* arg )
+{
+    auto path = static_cast<const char*>( arg );
+    if ( path == nullptr )
+        return nullptr;
+    auto canonical = QFileInfo( QString::fromUtf8( path ) ).canonicalFilePath().toStdString();
+    if ( std::find( opening.begin(), opening.end(), canonical ) != opening.end() )
+    {
+        vlmcWarning() << "Refusing to open" << path << ": the sequence contains itself";
+        return nullptr;
+    }
+    Tools::NestedSequence sequence;
+    if ( Tools::NestedSequence::load( QString::fromUtf8( path ), sequence ) == false )
+        return nullptr;
+    std::unique_ptr<State> state( new State( profile, sequence.graph.toStdString() ) );
+    state->canonical = canonical;
+    // The render ProxyService optimized the sequence into, which is much cheaper to
+    // decode than compositing all of its tracks again
+    auto proxies = Backend::instance()->proxies();
+    auto flattened = proxies.find( path );
+    if ( flattened == proxies.end() )
+    {
+        // Checks the graph right away, the sequences it contains included
+        opening.push_back( canonical );
+        auto inner = mlt_factory_producer( profile, "xml-string", sequence.graph.constData() );
+        opening.pop_back();
+        if ( inner == nullptr )
+            return nullptr;
+        state->idle.push_back( inner );
+    }
+    auto producer = mlt_producer_new( profile );
+    if ( producer == nullptr )
+        return nullptr;
+    producer->get_frame = getFrame;
+    auto properties = MLT_PRODUCER_PROPERTIES( producer );
+    mlt_properties_set( properties, "resource", path );
+    mlt_properties_set_int( properties, "length", static_cast<int>( sequence.nbFrames ) );
+    mlt_properties_set_int( properties, "out", static_cast<int>( sequence.nbFrames - 1 ) );
+    mlt_properties_set_int( properties, "width", profile->width );
+    mlt_properties_set_int( properties, "height", profile->height );
+    mlt_properties_set_double( properties, "aspect_ratio", mlt_profile_sar( profile ) );
+    if ( flattened != proxies.end() )
+        mlt_properties_set( properties, MLTNestedSequence::FlattenedProperty, flattened->second.c_str() );
+    mlt_properties_set_data( properties, StateProperty, state.release(), 0,
+                             destroyState, nullptr );
+    return producer;
+}
+
+}
+
+void
+MLTNestedSequence::registerService( Mlt::Repository& repository )
+{
+    repository.register_service( mlt_service_producer_type, ServiceName, create );
+}
@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * MLTNestedSequence.h: Plays a nested sequence as a single producer
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTNESTEDSEQUENCE_H
+#define MLTNESTEDSEQUENCE_H
+
+namespace Mlt
+{
+class Repository;
+}
+
+namespace Backend
+{
+namespace MLT
+{
+
+/**
+ *  \brief  Produces the frames of a nested sequence, from its "resource" sequence file.
+ *
+ *  The composited tracks of the sequence are loaded from the serialized graph, and each
+ *  frame is the one the sequence renders at this position. A sequence which ends up
+ *  containing itself, directly or through other sequences, is refused: its producer
+ *  can't be created, as opposed to recursing endlessly.
+ *  Once ProxyService optimized the sequence, the preview decodes that flattened render
+ *  instead of compositing the tracks again. It is keyed by the content of the sequence
+ *  file, which is never edited: a new nesting writes a new file. The exports get the
+ *  original resource in its place, and composite the tracks. Each thread pulling frames
+ *  uses a producer of its own.
+ *  \sa Tools::NestedSequence
+ */
+class MLTNestedSequence
+{
+    public:
+        static const char* const    ServiceName;
+        // The path of the sequence's flattened render, decoded in place of its graph
+        static const char* const    FlattenedProperty;
+
+        static void                 registerService( Mlt::Repository& repository );
+};
+
+}
+}
+
+#endif // MLTNESTEDSEQUENCE_H
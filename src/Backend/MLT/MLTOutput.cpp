@@ -25,15 +25,26 @@
 #endif
 
 #include "MLTOutput.h"
+#include "MLTAudioMixer.h"
 #include "MLTInput.h"
 #include "MLTProfile.h"
 #include "MLTBackend.h"
+#include "MLTBinding.h"
+#include "Tools/FrameHash.h"
+#include "Tools/Metrics.h"
+#include "Tools/SharedFrameRing.h"
+#include "Tools/Trace.h"
 
 #include <mlt++/MltProducer.h>
 #include <mlt++/MltConsumer.h>
+#include <mlt++/MltFrame.h>
 #include <mlt++/MltProfile.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstring>
+#include <thread>
 
 using namespace Backend::MLT;
 
@@ -45,12 +56,26 @@ MLTOutput::MLTOutput()
 
 MLTOutput::MLTOutput( Backend::IProfile& profile, const char *id, Backend::IOutputEventCb* callback )
     : m_callback( callback )
+    , m_frameCallback( nullptr )
+    , m_frameFormat( IVideoFrame::RGBA )
+    , m_hashCallback( nullptr )
     , m_input( nullptr )
+    , m_encodes( strcmp( id, "avformat" ) == 0 )
+    , m_lastFrameDone( 0 )
+    , m_threadRole( Tools::ThreadRole::Export )
 {
     MLTProfile& mltProfile = static_cast<MLTProfile&>( profile );
     m_consumer = new Mlt::Consumer( *mltProfile.m_profile, id );
     if ( isValid() == false )
         throw InvalidServiceException();
+    MLTBackend::instance()->setupGpuThreads( *m_consumer );
+    auto prefix = QString( m_encodes == true ? "export." :
+                           strcmp( id, "null" ) == 0 ? "benchmark." : "playback." );
+    m_frameTime = &Tools::Metrics::histogram( prefix + "frameTime" );
+    m_frameInterval = &Tools::Metrics::histogram( prefix + "frameInterval" );
+    m_consumer->listen( "consumer-frame-render", this, (mlt_listener)MLTOutput::onFrameRender );
+    m_consumer->listen( "consumer-frame-show", this, (mlt_listener)MLTOutput::onFrameDone );
+    m_consumer->listen( "consumer-thread-started", this, (mlt_listener)MLTOutput::onRenderThreadStarted );
 }
 
 MLTOutput::~MLTOutput()
@@ -91,6 +116,19 @@ MLTOutput::onOutputStarted( void*, MLTOutput* self )
     self->m_callback->onPlaying();
 }
 
+void
+MLTOutput::onRenderThreadStarted( void*, MLTOutput* self )
+{
+    // The consumer starts new threads each time it starts
+    Tools::ThreadRole::apply( static_cast<Tools::ThreadRole::Role>( self->m_threadRole.load() ) );
+}
+
+void
+MLTOutput::setThreadRole( Tools::ThreadRole::Role role )
+{
+    m_threadRole = role;
+}
+
 void
 MLTOutput::onOutputStopped( void*, MLTOutput* self )
 {
@@ -99,6 +137,101 @@ MLTOutput::onOutputStopped( void*, MLTOutput* self )
     self->m_callback->onStopped();
 }
 
+void
+MLTOutput::onFrameShown( void*, MLTOutput* self, void* frame )
+{
+    if ( self->m_frameCallback == nullptr || frame == nullptr )
+        return;
+    auto mltFrame = static_cast<mlt_frame>( frame );
+    if ( self->m_frameCallback->wantsImage( mlt_frame_get_position( mltFrame ) ) == false )
+        return;
+
+    // The image was already rendered for the consumer, this only converts it
+    auto imageFrame = new Mlt::Frame( mltFrame );
+    auto w = imageFrame->get_int( "width" );
+    auto h = imageFrame->get_int( "height" );
+    auto image = MLTVideoFrame::fromFrame( imageFrame, w, h, self->m_frameFormat );
+    if ( image != nullptr )
+        self->m_frameCallback->onImage( std::move( image ) );
+}
+
+void
+MLTOutput::onFrameHashed( void*, MLTOutput* self, void* frame )
+{
+    if ( self->m_hashCallback == nullptr || frame == nullptr )
+        return;
+    auto mltFrame = static_cast<mlt_frame>( frame );
+    auto properties = MLT_FRAME_PROPERTIES( mltFrame );
+    // The image the frame was rendered to, untouched by the encoder
+    auto image = static_cast<const uint8_t*>( mlt_properties_get_data( properties, "image", nullptr ) );
+    if ( image == nullptr )
+        return;
+    auto format = static_cast<mlt_image_format>( mlt_properties_get_int( properties, "format" ) );
+    auto size = mlt_image_format_size( format, mlt_properties_get_int( properties, "width" ),
+                                       mlt_properties_get_int( properties, "height" ), nullptr );
+    if ( size <= 0 )
+        return;
+    self->m_hashCallback->onFrameHash( mlt_frame_get_position( mltFrame ),
+                                       Tools::hashFrame( image, size ) );
+}
+
+static int64_t
+nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+void
+MLTOutput::onFrameRender( void*, MLTOutput* self, void* frame )
+{
+    if ( frame == nullptr )
+        return;
+    auto mltFrame = static_cast<mlt_frame>( frame );
+    // Decoding, filtering and compositing all happen within the frame's rendering
+    Tools::Trace::add( Tools::Trace::FrameRequested, mlt_frame_get_position( mltFrame ), self );
+    mlt_properties_set_int64( MLT_FRAME_PROPERTIES( mltFrame ), "_vlmc_render_start", nowUs() );
+}
+
+void
+MLTOutput::onFrameDone( void*, MLTOutput* self, void* frame )
+{
+    if ( frame == nullptr )
+        return;
+    auto mltFrame = static_cast<mlt_frame>( frame );
+    Tools::Trace::add( self->m_encodes == true ? Tools::Trace::FrameEncoded : Tools::Trace::FrameDisplayed,
+                       mlt_frame_get_position( mltFrame ), self );
+    auto now = nowUs();
+    // Only the frames which went through the render threads are stamped
+    auto start = mlt_properties_get_int64( MLT_FRAME_PROPERTIES( mltFrame ), "_vlmc_render_start" );
+    if ( start > 0 )
+        self->m_frameTime->record( now - start );
+    auto last = self->m_lastFrameDone.exchange( now );
+    if ( last > 0 )
+        self->m_frameInterval->record( now - last );
+}
+
+void
+MLTOutput::setFrameCallback( Backend::IOutputFrameCb* callback, IVideoFrame::Format format )
+{
+    bool listening = m_frameCallback != nullptr;
+    m_frameCallback = callback;
+    m_frameFormat = format;
+    if ( callback == nullptr || listening == true )
+        return;
+    consumer()->listen( "consumer-frame-show", this, (mlt_listener)MLTOutput::onFrameShown );
+}
+
+void
+MLTOutput::setHashCallback( Backend::IOutputHashCb* callback )
+{
+    bool listening = m_hashCallback != nullptr;
+    m_hashCallback = callback;
+    if ( callback == nullptr || listening == true )
+        return;
+    consumer()->listen( "consumer-frame-show", this, (mlt_listener)MLTOutput::onFrameHashed );
+}
+
 void
 MLTOutput::setName( const char* name )
 {
@@ -115,9 +248,17 @@ MLTOutput::setCallback(Backend::IOutputEventCb *callback)
     consumer()->listen( "consumer-stopped", this, (mlt_listener)MLTOutput::onOutputStopped );
 }
 
+Backend::IOutputEventCb*
+MLTOutput::callback() const
+{
+    return m_callback;
+}
+
 void
 MLTOutput::start()
 {
+    // The interval from the previous run's last frame means nothing
+    m_lastFrameDone = 0;
     consumer()->start();
 }
 
@@ -133,6 +274,12 @@ MLTOutput::isStopped() const
     return consumer()->is_stopped();
 }
 
+void
+MLTOutput::purge()
+{
+    consumer()->purge();
+}
+
 int
 MLTOutput::volume() const
 {
@@ -148,10 +295,9 @@ MLTOutput::setVolume( int volume )
 bool
 MLTOutput::connect( Backend::IInput& input )
 {
-    MLTInput* mltInput = dynamic_cast<MLTInput*>( &input );
-    assert( mltInput );
-    m_input = mltInput;
-    return !consumer()->connect( *(mltInput->producer()) );
+    auto& mltInput = native( input );
+    m_input = &mltInput;
+    return !consumer()->connect( *(mltInput.producer()) );
 }
 
 bool
@@ -166,6 +312,199 @@ MLTSdlOutput::setWindowId( intptr_t id )
     consumer()->set( "window_id", std::to_string( id ).c_str() );
 }
 
+MLTPreviewOutput::MLTPreviewOutput( const char* id )
+    : MLTOutput( Backend::instance()->profile(), id )
+    , m_lastShownPosition( -1 )
+    , m_lastShownUs( 0 )
+    , m_audioUnderruns( 0 )
+{
+    setThreadRole( Tools::ThreadRole::Preview );
+    setScrubAudio( true );
+    // SDL's consumers set their default, in samples, when they are created
+    m_defaultAudioBuffer = consumer()->get_int( "audio_buffer" );
+    if ( m_defaultAudioBuffer <= 0 )
+        m_defaultAudioBuffer = 2048;
+    consumer()->listen( "consumer-frame-show", this, (mlt_listener)MLTPreviewOutput::onAudioFrameShown );
+}
+
+void
+MLTPreviewOutput::setAudioBuffer( int ms )
+{
+    auto samples = m_defaultAudioBuffer;
+    if ( ms > 0 )
+    {
+        auto frequency = std::max( 1, consumer()->get_int( "frequency" ) );
+        auto wanted = static_cast<int64_t>( frequency ) * ms / 1000;
+        samples = 256;
+        while ( samples < wanted && samples < 65536 )
+            samples *= 2;
+    }
+    if ( samples == consumer()->get_int( "audio_buffer" ) )
+        return;
+    consumer()->set( "audio_buffer", samples );
+    restart();
+}
+
+int
+MLTPreviewOutput::audioBuffer() const
+{
+    auto frequency = std::max( 1, consumer()->get_int( "frequency" ) );
+    return static_cast<int64_t>( consumer()->get_int( "audio_buffer" ) ) * 1000 / frequency;
+}
+
+int
+MLTPreviewOutput::audioUnderruns() const
+{
+    return m_audioUnderruns.load();
+}
+
+void
+MLTPreviewOutput::onAudioFrameShown( void*, MLTPreviewOutput* self, void* frame )
+{
+    if ( frame == nullptr )
+        return;
+    auto mltFrame = static_cast<mlt_frame>( frame );
+    auto pos = mlt_frame_get_position( mltFrame );
+    auto now = nowUs();
+    auto last = self->m_lastShownPosition;
+    auto lastUs = self->m_lastShownUs;
+    self->m_lastShownPosition = pos;
+    self->m_lastShownUs = now;
+    // Only while playing forward at normal speed: the frames skipped when late still
+    // had their audio played. Seeks and pauses start over.
+    auto fps = self->consumer()->get_double( "fps" );
+    if ( last < 0 || pos <= last || pos - last > fps ||
+         mlt_properties_get_double( MLT_FRAME_PROPERTIES( mltFrame ), "_speed" ) != 1.0 )
+        return;
+    auto frequency = std::max( 1, self->consumer()->get_int( "frequency" ) );
+    auto bufferUs = static_cast<int64_t>( self->consumer()->get_int( "audio_buffer" ) ) * 1000000 / frequency;
+    auto expectedUs = static_cast<int64_t>( ( pos - last ) * 1000000 / fps );
+    if ( now - lastUs - expectedUs <= bufferUs )
+        return;
+    self->m_audioUnderruns.fetch_add( 1 );
+    Tools::Metrics::counter( "playback.audioUnderruns" ).add();
+    if ( self->callback() != nullptr )
+        self->callback()->onAudioUnderrun( 1 );
+}
+
+void
+MLTPreviewOutput::setScrubAudio( bool enabled )
+{
+    consumer()->set( "scrub_audio", enabled == true ? 1 : 0 );
+}
+
+void
+MLTPreviewOutput::setScale( int divisor )
+{
+    auto& profile = Backend::instance()->profile();
+    divisor = std::max( 1, divisor );
+    // Keep the dimensions even, as required by the yuv420p based formats
+    consumer()->set( "width", std::max( 2, profile.width() / divisor ) & ~1 );
+    consumer()->set( "height", std::max( 2, profile.height() / divisor ) & ~1 );
+    restart();
+}
+
+void
+MLTPreviewOutput::setFramePolicy( FramePolicy policy, int threads )
+{
+    // MLT's real_time: the sign tells whether frames may be dropped, the
+    // magnitude is the number of rendering threads
+    threads = MLTBackend::instance()->renderThreads( std::max( 1, threads ) );
+    consumer()->set( "real_time", policy == DropLateFrames ? threads : -threads );
+    restart();
+}
+
+int
+MLTPreviewOutput::droppedFrames() const
+{
+    return consumer()->get_int( "drop_count" );
+}
+
+void
+MLTPreviewOutput::restart()
+{
+    if ( isStopped() == true )
+        return;
+    // The consumer only reads its settings when it starts. Restart it without notifying
+    // the user, the producer is left untouched and playback resumes where it was.
+    consumer()->block( this );
+    consumer()->stop();
+    consumer()->unblock( this );
+    consumer()->start();
+}
+
+MLTSdlAudioOutput::MLTSdlAudioOutput()
+    : MLTPreviewOutput( "sdl_audio" )
+{
+    // The sound card plays what its rendering threads produce
+    setThreadRole( Tools::ThreadRole::Audio );
+    // Have the rendering threads produce the format the display expects, so that
+    // fetching the image once the frame is due doesn't convert it again
+    consumer()->set( "mlt_image_format", "yuv420p" );
+}
+
+MLTSharedMemoryOutput::MLTSharedMemoryOutput( const QString& name, IVideoFrame::Format format )
+    : m_ring( new Tools::SharedFrameRing( name ) )
+    , m_forward( nullptr )
+    , m_position( 0 )
+    , m_forwardWants( false )
+{
+    MLTOutput::setFrameCallback( this, format );
+}
+
+MLTSharedMemoryOutput::~MLTSharedMemoryOutput()
+{
+    // Don't let the consumer call back into a half destroyed object
+    stop();
+}
+
+void
+MLTSharedMemoryOutput::setFrameCallback( Backend::IOutputFrameCb* callback, IVideoFrame::Format format )
+{
+    m_forward = callback;
+    if ( callback != nullptr )
+        MLTOutput::setFrameCallback( this, format );
+}
+
+void
+MLTSharedMemoryOutput::start()
+{
+    // Size the ring for the largest frames up front, rather than from the output's thread
+    auto& profile = Backend::instance()->profile();
+    m_ring->reserve( static_cast<uint64_t>( profile.width() ) * profile.height() * 4 );
+    MLTSdlAudioOutput::start();
+}
+
+bool
+MLTSharedMemoryOutput::wantsImage( int64_t position )
+{
+    m_position = position;
+    m_forwardWants = m_forward != nullptr && m_forward->wantsImage( position );
+    return true;
+}
+
+void
+MLTSharedMemoryOutput::onImage( std::shared_ptr<IVideoFrame> frame )
+{
+    auto fps = Backend::instance()->profile().fps();
+    auto pts = fps > 0 ? static_cast<int64_t>( m_position * 1000000 / fps ) : 0;
+    m_ring->publish( *frame, m_position, pts );
+    if ( m_forwardWants == true )
+        m_forward->onImage( std::move( frame ) );
+}
+
+MLTFFmpegOutput::MLTFFmpegOutput()
+    : MLTFFmpegOutput( Backend::instance()->profile() )
+{
+}
+
+MLTFFmpegOutput::MLTFFmpegOutput( IProfile& profile )
+    : MLTOutput( profile, "avformat" )
+{
+    // Stop once the input reaches its end, instead of waiting for more frames
+    consumer()->set( "terminate_on_pause", 1 );
+}
+
 void
 MLTFFmpegOutput::setTarget( const char* path )
 {
@@ -223,3 +562,239 @@ MLTFFmpegOutput::setAudioSampleRate( int rate )
 {
     consumer()->set( "frequency", rate );
 }
+
+void
+MLTFFmpegOutput::setGopSize( int frames )
+{
+    consumer()->set( "g", frames );
+}
+
+void
+MLTFFmpegOutput::setEncoderOptions( const EncoderOptions& options )
+{
+    if ( options.videoCodec.empty() == false )
+    {
+        consumer()->set( "vcodec", options.videoCodec.c_str() );
+        // MLT uploads the frames to the device itself
+        const std::string vaapi = "_vaapi";
+        if ( options.videoCodec.size() > vaapi.size() &&
+             options.videoCodec.compare( options.videoCodec.size() - vaapi.size(), vaapi.size(), vaapi ) == 0 )
+        {
+            consumer()->set( "vaapi_device", options.hardwareDevice.empty() == false ?
+                                 options.hardwareDevice.c_str() : "/dev/dri/renderD128" );
+        }
+    }
+    if ( options.audioCodec.empty() == false )
+        consumer()->set( "acodec", options.audioCodec.c_str() );
+    if ( options.pixelFormat.empty() == false )
+        consumer()->set( "pix_fmt", options.pixelFormat.c_str() );
+    // Unknown properties are forwarded to the codec as AVOptions
+    if ( options.preset.empty() == false )
+        consumer()->set( "preset", options.preset.c_str() );
+    if ( options.encoderThreads > 0 )
+        consumer()->set( "threads", options.encoderThreads );
+    // Positive values allow dropping frames, negative ones don't
+    int renderThreads = MLTBackend::instance()->renderThreads( std::max( 1, options.renderThreads ) );
+    consumer()->set( "real_time", options.dropFrames == true ? renderThreads : -renderThreads );
+    if ( options.gopSize > 0 )
+        setGopSize( options.gopSize );
+    // The header is written up front and the bytes already written are never
+    // patched afterward, so a reader can follow the file as it grows
+    if ( options.fragmented == true )
+        consumer()->set( "movflags", "+frag_keyframe+empty_moov+default_base_moof" );
+    if ( options.pass > 0 )
+    {
+        consumer()->set( "pass", options.pass );
+        consumer()->set( "passlogfile", options.passLogFile.c_str() );
+    }
+    if ( options.pass == 1 )
+    {
+        // Only the statistics are kept: nothing is muxed, and neither the audio nor
+        // the image quality matters as long as the frames keep their size
+        consumer()->set( "f", "null" );
+        consumer()->set( "an", 1 );
+        consumer()->set( "rescale", "nearest" );
+        consumer()->set( "deinterlace_method", "onefield" );
+        consumer()->set( "fastfirstpass", 1 );
+    }
+}
+
+namespace
+{
+    // Behind by more than this, the pace restarts from the current frame rather
+    // than sending the late frames in a burst
+    const int64_t   MaxStreamLagUs = 500000;
+}
+
+MLTStreamOutput::MLTStreamOutput( const char* url )
+    : m_origin( 0 )
+    , m_framesSent( 0 )
+    , m_dropped( 0 )
+{
+    setTarget( url );
+    consumer()->set( "f", strncmp( url, "rtmp", 4 ) == 0 ? "flv" : "mpegts" );
+    consumer()->set( "vcodec", "libx264" );
+    consumer()->set( "preset", "veryfast" );
+    consumer()->set( "tune", "zerolatency" );
+    // B frames are reordered, which delays every frame by as many
+    consumer()->set( "bf", 0 );
+    consumer()->set( "acodec", "aac" );
+    // A keyframe every 2 seconds, for the viewers joining the stream
+    auto fps = Backend::instance()->profile().fps();
+    setGopSize( std::max( 1, static_cast<int>( fps * 2 ) ) );
+    // Positive, so that the late frames are dropped
+    consumer()->set( "real_time", 1 );
+    setQueueSize( 5 );
+    consumer()->listen( "consumer-frame-show", this, (mlt_listener)MLTStreamOutput::onFrameSent );
+}
+
+void
+MLTStreamOutput::setQueueSize( int frames )
+{
+    frames = std::max( 1, frames );
+    consumer()->set( "buffer", frames );
+    consumer()->set( "prefill", 1 );
+}
+
+void
+MLTStreamOutput::start()
+{
+    m_origin = 0;
+    m_framesSent = 0;
+    MLTFFmpegOutput::start();
+}
+
+int64_t
+MLTStreamOutput::droppedFrames() const
+{
+    return m_dropped.load();
+}
+
+void
+MLTStreamOutput::onFrameSent( void*, MLTStreamOutput* self, void* frame )
+{
+    if ( frame == nullptr )
+        return;
+    // The consumer repeats the previous image in place of the ones it skipped
+    auto rendered = mlt_properties_get_int( MLT_FRAME_PROPERTIES( static_cast<mlt_frame>( frame ) ),
+                                            "rendered" );
+    if ( rendered == 0 )
+    {
+        self->m_dropped.fetch_add( 1 );
+        if ( self->callback() != nullptr )
+            self->callback()->onFramesDropped( 1 );
+    }
+
+    auto fps = self->consumer()->get_double( "fps" );
+    auto now = nowUs();
+    if ( fps <= 0 || self->m_origin == 0 )
+    {
+        self->m_origin = now;
+        self->m_framesSent = 1;
+        return;
+    }
+    auto due = self->m_origin + static_cast<int64_t>( self->m_framesSent * 1000000 / fps );
+    ++self->m_framesSent;
+    if ( now - due > MaxStreamLagUs )
+    {
+        self->m_origin = now;
+        self->m_framesSent = 1;
+    }
+    else if ( due > now )
+        std::this_thread::sleep_for( std::chrono::microseconds( due - now ) );
+}
+
+MLTNullOutput::MLTNullOutput( int threads )
+    : MLTOutput( Backend::instance()->profile(), "null" )
+    , m_audioCallback( nullptr )
+    , m_frequency( 0 )
+    , m_channels( 0 )
+    , m_fps( 0 )
+{
+    // Negative, so that no frame is ever dropped to keep up with the clock
+    consumer()->set( "real_time", -MLTBackend::instance()->renderThreads( std::max( 1, threads ) ) );
+    consumer()->set( "terminate_on_pause", 1 );
+}
+
+void
+MLTNullOutput::setSize( int width, int height )
+{
+    consumer()->set( "width", width );
+    consumer()->set( "height", height );
+}
+
+void
+MLTNullOutput::setAudioCallback( IOutputAudioCb* callback, int frequency, int channels )
+{
+    assert( m_audioCallback == nullptr );
+    m_audioCallback = callback;
+    m_frequency = frequency;
+    m_channels = channels;
+    m_fps = Backend::instance()->profile().fps();
+    consumer()->set( "video_off", 1 );
+    consumer()->set( "frequency", frequency );
+    consumer()->set( "channels", channels );
+    consumer()->listen( "consumer-frame-show", this, (mlt_listener)MLTNullOutput::onFrameAudio );
+}
+
+void
+MLTNullOutput::onFrameAudio( void*, MLTNullOutput* self, void* frame )
+{
+    if ( frame == nullptr )
+        return;
+    auto mltFrame = static_cast<mlt_frame>( frame );
+    auto position = mlt_frame_get_position( mltFrame );
+    // The same count the encoders would take, so that no sample gets lost over time
+    auto nbSamples = mlt_audio_calculate_frame_samples( self->m_fps, self->m_frequency, position );
+    auto samples = nbSamples;
+    auto format = mlt_audio_f32le;
+    auto frequency = self->m_frequency;
+    auto channels = self->m_channels;
+    void* buffer = nullptr;
+    if ( mlt_frame_get_audio( mltFrame, &buffer, &format, &frequency, &channels, &samples ) != 0 ||
+         format != mlt_audio_f32le || channels != self->m_channels || samples != nbSamples )
+        buffer = nullptr;
+    const float* stems = nullptr;
+    uint32_t nbStems = 0;
+    auto s = MLTAudioMixer::stems( mltFrame );
+    if ( buffer != nullptr && s != nullptr && s->nbSamples == (uint32_t)nbSamples &&
+         s->nbChannels == (uint32_t)channels )
+    {
+        stems = s->samples.data();
+        nbStems = s->nbStems;
+    }
+    self->m_audioCallback->onAudio( position, static_cast<const float*>( buffer ), stems, nbStems,
+                                    nbSamples, self->m_channels );
+}
+
+MLTMultiOutput::MLTMultiOutput()
+    : MLTMultiOutput( Backend::instance()->profile() )
+{
+}
+
+MLTMultiOutput::MLTMultiOutput( IProfile& profile )
+    : MLTOutput( profile, "multi" )
+    , m_nbOutputs( 0 )
+{
+    consumer()->set( "terminate_on_pause", 1 );
+}
+
+void
+MLTMultiOutput::addOutput( MLTFFmpegOutput& output )
+{
+    // The multi consumer creates the nested ones itself, from "<index>" and the
+    // "<index>.<property>" properties
+    auto prefix = std::to_string( m_nbOutputs++ );
+    consumer()->set( prefix.c_str(), output.consumer()->get( "mlt_service" ) );
+    auto properties = output.consumer();
+    for ( int i = 0; i < properties->count(); ++i )
+    {
+        auto name = properties->get_name( i );
+        auto value = properties->get( i );
+        // Skip the internal properties, which belong to the template consumer
+        if ( name == nullptr || value == nullptr || name[0] == '_' ||
+             std::string( name ).compare( 0, 4, "mlt_" ) == 0 )
+            continue;
+        consumer()->set( ( prefix + '.' + name ).c_str(), value );
+    }
+}
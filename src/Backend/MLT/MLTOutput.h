@@ -24,10 +24,15 @@
 #define MLTOUTPUT_H
 
 #include "MLTService.h"
+#include "Backend/IInput.h"
 #include "Backend/IOutput.h"
 #include "Backend/IBackend.h"
 #include "Backend/IProfile.h"
+#include "Tools/Metrics.h"
+#include "Tools/ThreadRole.h"
 
+#include <atomic>
+#include <memory>
 #include <string>
 
 namespace Mlt
@@ -35,6 +40,11 @@ namespace Mlt
 class Consumer;
 }
 
+namespace Tools
+{
+class SharedFrameRing;
+}
+
 namespace Backend
 {
 namespace MLT
@@ -56,13 +66,36 @@ class MLTOutput : public IOutput, public MLTService
 
         static void     onOutputStarted( void* owner, MLTOutput* self );
         static void     onOutputStopped( void* owner, MLTOutput* self );
+        static void     onFrameShown( void* owner, MLTOutput* self, void* frame );
+        static void     onFrameHashed( void* owner, MLTOutput* self, void* frame );
+        // Feed the metrics and the trace
+        static void     onFrameRender( void* owner, MLTOutput* self, void* frame );
+        static void     onFrameDone( void* owner, MLTOutput* self, void* frame );
+        // From each rendering thread of the consumer, as it starts
+        static void     onRenderThreadStarted( void* owner, MLTOutput* self );
 
         virtual void    setName( const char* name ) override;
         virtual void    setCallback( IOutputEventCb* callback ) override;
+        /**
+         *  \brief Must be called before start(). Frame images are provided in the
+         *         requested format, at the size they were rendered for the output.
+         *
+         *  Passing nullptr detaches the current callback. The output must be stopped.
+         */
+        virtual void    setFrameCallback( IOutputFrameCb* callback,
+                                          IVideoFrame::Format format = IVideoFrame::RGBA );
+        /**
+         *  \brief Must be called before start(). The image of each frame is hashed as
+         *         it is, in the output's format.
+         *
+         *  Passing nullptr detaches the current callback. The output must be stopped.
+         */
+        void            setHashCallback( IOutputHashCb* callback );
 
         virtual void    start() override;
         virtual void    stop() override;
         virtual bool    isStopped() const override;
+        virtual void    purge() override;
 
         virtual int     volume() const override;
         virtual void    setVolume( int volume ) override;
@@ -70,27 +103,183 @@ class MLTOutput : public IOutput, public MLTService
         virtual bool    connect( IInput& input ) override;
         virtual bool    isConnected() const override;
 
+    protected:
+        IOutputEventCb*     callback() const;
+        // Of the rendering threads started from now on. Exports by default
+        void                setThreadRole( Tools::ThreadRole::Role role );
+
     private:
         Mlt::Consumer*      m_consumer;
         IOutputEventCb*     m_callback;
+        IOutputFrameCb*     m_frameCallback;
+        IVideoFrame::Format m_frameFormat;
+        IOutputHashCb*      m_hashCallback;
         MLTInput*           m_input;
         std::string         m_name;
+        // Whether the frames shown are encoded rather than displayed, for the trace
+        bool                m_encodes;
+        Tools::Metrics::Histogram*  m_frameTime;
+        Tools::Metrics::Histogram*  m_frameInterval;
+        std::atomic<int64_t>        m_lastFrameDone;
+        std::atomic<int>            m_threadRole;
 };
 
-class MLTSdlOutput : public MLTOutput
+/**
+ *  \brief Common settings of the outputs used to preview the project.
+ */
+class MLTPreviewOutput : public MLTOutput
+{
+    public:
+        enum FramePolicy
+        {
+            // Keep in sync with the audio, skipping the frames rendered too late
+            DropLateFrames,
+            // Show every frame, slowing down when they can't be rendered in time
+            EveryFrame,
+        };
+
+        MLTPreviewOutput( const char* id );
+
+        /**
+         *  \brief Composites the preview at 1/divisor of the profile resolution.
+         *
+         *  The picture is still stretched to the window. Exports have their own
+         *  consumer, and keep the profile resolution. Can be called while playing.
+         */
+        void setScale( int divisor );
+        /**
+         *  \brief Sets how late frames are handled, and how many frames are
+         *         rendered in parallel. Can be called while playing.
+         */
+        void setFramePolicy( FramePolicy policy, int threads );
+        /**
+         *  \returns The number of frames the output dropped so far.
+         */
+        int  droppedFrames() const;
+        /**
+         *  \brief Plays the audio of the frames shown while seeking. Enabled by default.
+         */
+        void setScrubAudio( bool enabled );
+        /**
+         *  \brief Sets the sound card's buffer, in milliseconds. 0 restores SDL's default.
+         *
+         *  A larger buffer delays the audio when starting or scrubbing, a smaller one runs
+         *  dry sooner on a loaded machine. It is rounded up to a power of two samples, as
+         *  SDL expects. Can be called while playing.
+         */
+        void setAudioBuffer( int ms );
+        // In milliseconds, as rounded by setAudioBuffer()
+        int  audioBuffer() const;
+        /**
+         *  \returns The number of times the sound card ran out of samples so far.
+         *
+         *  SDL plays silence rather than reporting them, so an underrun is assumed when
+         *  a frame is shown later than the buffer could last. They are also reported
+         *  through IOutputEventCb::onAudioUnderrun().
+         */
+        int  audioUnderruns() const;
+
+    private:
+        static void onAudioFrameShown( void* owner, MLTPreviewOutput* self, void* frame );
+        void restart();
+
+    private:
+        int                     m_defaultAudioBuffer;
+        // Only accessed from the output's thread
+        int64_t                 m_lastShownPosition;
+        int64_t                 m_lastShownUs;
+        std::atomic<int>        m_audioUnderruns;
+};
+
+/**
+ *  \brief Renders the preview to a native window, through SDL.
+ */
+class MLTSdlOutput : public MLTPreviewOutput
 {
     public:
         MLTSdlOutput()
-            : MLTOutput( Backend::instance()->profile(), "sdl" ) { }
+            : MLTPreviewOutput( "sdl" ) { }
 
         void setWindowId( intptr_t id );
 };
 
+/**
+ *  \brief Plays the audio through SDL, and hands the video frames over to the
+ *         frame callback when they are due, for the caller to display them.
+ */
+class MLTSdlAudioOutput : public MLTPreviewOutput
+{
+    public:
+        MLTSdlAudioOutput();
+};
+
+/**
+ *  \brief Plays like MLTSdlAudioOutput, and also publishes every frame shown in a
+ *         shared-memory ring, for external monitors and scopes to read them.
+ *
+ *  The frame callback, if any, keeps receiving the frames it asks for, and the ring
+ *  holds them in the format it requested. \sa Tools::SharedFrameRing
+ */
+class MLTSharedMemoryOutput : public MLTSdlAudioOutput, private IOutputFrameCb
+{
+    public:
+        explicit MLTSharedMemoryOutput( const QString& name,
+                                        IVideoFrame::Format format = IVideoFrame::YUV420P );
+        ~MLTSharedMemoryOutput();
+
+        virtual void    setFrameCallback( IOutputFrameCb* callback,
+                                          IVideoFrame::Format format = IVideoFrame::RGBA ) override;
+        virtual void    start() override;
+
+    private:
+        virtual bool    wantsImage( int64_t position ) override;
+        virtual void    onImage( std::shared_ptr<IVideoFrame> frame ) override;
+
+    private:
+        std::unique_ptr<Tools::SharedFrameRing>     m_ring;
+        IOutputFrameCb*     m_forward;
+        // Only accessed from the output's thread, between wantsImage() and onImage()
+        int64_t             m_position;
+        bool                m_forwardWants;
+};
+
+/**
+ *  \brief Renders the input's frames as fast as possible, and discards them.
+ *
+ *  Measures the cost of rendering alone, without displaying nor encoding anything.
+ *  Each frame's time is recorded in the "benchmark.frameTime" and
+ *  "benchmark.frameInterval" metrics. The output stops at the end of the input.
+ */
+class MLTNullOutput : public MLTOutput
+{
+    public:
+        // threads is the number of frames rendered in parallel
+        explicit MLTNullOutput( int threads = 1 );
+
+        void    setSize( int width, int height );
+        /**
+         *  \brief Renders the audio only, which is handed to callback. No image is
+         *         rendered, so no video gets decoded. Must be called before start().
+         *  \sa    MLTAudioMixer::setStems()
+         */
+        void    setAudioCallback( IOutputAudioCb* callback, int frequency, int channels );
+
+    private:
+        static void onFrameAudio( void*, MLTNullOutput* self, void* frame );
+
+    private:
+        IOutputAudioCb*     m_audioCallback;
+        int                 m_frequency;
+        int                 m_channels;
+        double              m_fps;
+};
+
 class MLTFFmpegOutput : public MLTOutput
 {
     public:
-        MLTFFmpegOutput()
-            : MLTOutput( Backend::instance()->profile(), "avformat" ) { }
+        MLTFFmpegOutput();
+        // Encodes the frames rendered in profile, instead of the project's one
+        explicit MLTFFmpegOutput( IProfile& profile );
 
         void    setTarget( const char* path );
         void    setWidth( int width );
@@ -101,7 +290,65 @@ class MLTFFmpegOutput : public MLTOutput
         void    setAudioBitrate( int kbps );
         void    setChannels( int channels );
         void    setAudioSampleRate( int rate );
+        // Maximum number of frames between two keyframes
+        void    setGopSize( int frames );
+        void    setEncoderOptions( const EncoderOptions& options );
+
+};
 
+/**
+ *  \brief Encodes with low latency settings and pushes to a live RTMP or SRT server.
+ *
+ *  The frames are sent at the pace of the wall clock, and only a few of them are
+ *  rendered ahead of the encoder. When the rendering falls behind, frames are dropped
+ *  rather than delayed, and reported through IOutputEventCb::onFramesDropped.
+ *  The stream ends with the input.
+ */
+class MLTStreamOutput : public MLTFFmpegOutput
+{
+    public:
+        // rtmp:// urls are muxed as flv, the others (srt://, udp://) as mpegts
+        explicit MLTStreamOutput( const char* url );
+
+        // Maximum number of frames rendered ahead of the encoder
+        void        setQueueSize( int frames );
+        virtual void    start() override;
+        /**
+         *  \returns The number of frames dropped so far.
+         */
+        int64_t     droppedFrames() const;
+
+    private:
+        static void onFrameSent( void*, MLTStreamOutput* self, void* frame );
+
+    private:
+        // When the first frame was sent, in microseconds, and the frames sent since
+        int64_t                 m_origin;
+        int64_t                 m_framesSent;
+        std::atomic<int64_t>    m_dropped;
+};
+
+/**
+ *  \brief Feeds the frames of a single input to several encoders.
+ *
+ *  The input is decoded and composited once, and each frame is scaled to every
+ *  output's size before being encoded.
+ */
+class MLTMultiOutput : public MLTOutput
+{
+    public:
+        MLTMultiOutput();
+        explicit MLTMultiOutput( IProfile& profile );
+
+        /**
+         *  \brief Adds an encoder configured as output. Must be called before connect().
+         *
+         *  output is only used as a template, and can be deleted afterward.
+         */
+        void    addOutput( MLTFFmpegOutput& output );
+
+    private:
+        int     m_nbOutputs;
 };
 
 }
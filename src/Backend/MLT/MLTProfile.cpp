@@ -42,6 +42,21 @@ MLTProfile::MLTProfile( Mlt::Profile* profile )
 
 }
 
+MLTProfile::MLTProfile( const MLTProfile& profile )
+    : m_profile( new Mlt::Profile )
+{
+    auto p = profile.m_profile;
+    m_profile->set_width( p->width() );
+    m_profile->set_height( p->height() );
+    m_profile->set_frame_rate( p->frame_rate_num(), p->frame_rate_den() );
+    m_profile->set_display_aspect( p->display_aspect_num(), p->display_aspect_den() );
+    m_profile->set_sample_aspect( p->sample_aspect_num(), p->sample_aspect_den() );
+    m_profile->set_progressive( p->progressive() );
+    m_profile->set_colorspace( p->colorspace() );
+    // Documents loaded in it mustn't overwrite its settings with their own
+    m_profile->set_explicit( 1 );
+}
+
 MLTProfile::~MLTProfile()
 {
     delete m_profile;
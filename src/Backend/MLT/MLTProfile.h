@@ -42,6 +42,9 @@ class MLTProfile : public IProfile
     public:
         MLTProfile();
         MLTProfile( Mlt::Profile* profile );
+        // Copies the settings of profile in an independent Mlt::Profile
+        explicit MLTProfile( const MLTProfile& profile );
+        MLTProfile& operator=( const MLTProfile& ) = delete;
         virtual ~MLTProfile();
 
         virtual int     frameRateNum() const override;
@@ -68,6 +71,7 @@ class MLTProfile : public IProfile
     friend class MLTTrack;
     friend class MLTMultiTrack;
     friend class MLTService;
+    friend class MLTEffectsBenchmark;
     friend class MLTFilter;
     friend class MLTTransition;
 };
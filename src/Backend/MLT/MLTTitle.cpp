@@ -0,0 +1,163 @@
+/*****************************************************************************
+ * MLTTitle.cpp: Producer rendering the title clips
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MLTTitle.h"
+
+#include "Tools/GlyphAtlas.h"
+#include "Tools/Title.h"
+
+#include <mlt++/MltRepository.h>
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace Backend::MLT;
+
+const char* const MLTTitle::ServiceName = "vlmc_title";
+
+namespace
+{
+
+const char  StateProperty[] = "_vlmc_title";
+const char  ImageProperty[] = "_vlmc_title_image";
+
+using Image = std::shared_ptr<const std::vector<uint8_t>>;
+
+// The title, and its image at the last size it was asked for
+struct State
+{
+    explicit State( const Tools::Title& t ) : title( t ), width( 0 ), height( 0 ) {}
+
+    const Tools::Title      title;
+    std::mutex              mutex;
+    int                     width;
+    int                     height;
+    Image                   image;
+};
+
+void
+destroyState( void* data )
+{
+    delete static_cast<State*>( data );
+}
+
+void
+destroyImage( void* data )
+{
+    delete static_cast<Image*>( data );
+}
+
+int
+getImage( mlt_frame frame, uint8_t** image, mlt_image_format* format, int* width, int* height,
+          int writable )
+{
+    auto producer = static_cast<mlt_producer>( mlt_frame_pop_service( frame ) );
+    auto state = static_cast<State*>( mlt_properties_get_data( MLT_PRODUCER_PROPERTIES( producer ),
+                                                               StateProperty, nullptr ) );
+    if ( state == nullptr )
+        return 1;
+    auto profile = mlt_service_profile( MLT_PRODUCER_SERVICE( producer ) );
+    if ( *width <= 0 )
+        *width = profile->width;
+    if ( *height <= 0 )
+        *height = profile->height;
+
+    Image   img;
+    {
+        std::lock_guard<std::mutex> lock( state->mutex );
+        if ( state->image == nullptr || state->width != *width || state->height != *height )
+        {
+            auto buffer = std::make_shared<std::vector<uint8_t>>( static_cast<size_t>( *width ) * *height * 4 );
+            Tools::GlyphAtlas::render( state->title, *width, *height, buffer->data() );
+            state->image = buffer;
+            state->width = *width;
+            state->height = *height;
+        }
+        img = state->image;
+    }
+    auto size = static_cast<int>( img->size() );
+    if ( writable != 0 )
+    {
+        auto copy = static_cast<uint8_t*>( mlt_pool_alloc( size ) );
+        memcpy( copy, img->data(), size );
+        mlt_frame_set_image( frame, copy, size, mlt_pool_release );
+        *image = copy;
+    }
+    else
+    {
+        // Shared by every frame, the frame only keeps it alive
+        mlt_properties_set_data( MLT_FRAME_PROPERTIES( frame ), ImageProperty, new Image( img ),
+                                 0, destroyImage, nullptr );
+        *image = const_cast<uint8_t*>( img->data() );
+        mlt_frame_set_image( frame, *image, size, nullptr );
+    }
+    *format = mlt_image_rgb24a;
+    return 0;
+}
+
+int
+getFrame( mlt_producer producer, mlt_frame* frame, int )
+{
+    *frame = mlt_frame_init( MLT_PRODUCER_SERVICE( producer ) );
+    if ( *frame == nullptr )
+        return 1;
+    mlt_frame_set_position( *frame, mlt_producer_position( producer ) );
+    auto properties = MLT_FRAME_PROPERTIES( *frame );
+    auto profile = mlt_service_profile( MLT_PRODUCER_SERVICE( producer ) );
+    mlt_properties_set_int( properties, "progressive", 1 );
+    mlt_properties_set_double( properties, "aspect_ratio", mlt_profile_sar( profile ) );
+    mlt_frame_push_service( *frame, producer );
+    mlt_frame_push_get_image( *frame, getImage );
+    mlt_producer_prepare_next( producer );
+    return 0;
+}
+
+void*
+create( mlt_profile profile, mlt_service_type, const char*, const void* arg )
+{
+    auto path = static_cast<const char*>( arg );
+    Tools::Title    title;
+    if ( path == nullptr || Tools::Title::load( QString::fromUtf8( path ), title ) == false )
+        return nullptr;
+    auto producer = mlt_producer_new( profile );
+    if ( producer == nullptr )
+        return nullptr;
+    producer->get_frame = getFrame;
+    auto properties = MLT_PRODUCER_PROPERTIES( producer );
+    mlt_properties_set( properties, "resource", path );
+    mlt_properties_set_int( properties, "length", MLTTitle::DefaultLength );
+    mlt_properties_set_int( properties, "out", MLTTitle::DefaultLength - 1 );
+    mlt_properties_set_int( properties, "width", profile->width );
+    mlt_properties_set_int( properties, "height", profile->height );
+    mlt_properties_set_data( properties, StateProperty, new State( title ), 0, destroyState, nullptr );
+    return producer;
+}
+
+}
+
+void
+MLTTitle::registerService( Mlt::Repository& repository )
+{
+    repository.register_service( mlt_service_producer_type, ServiceName, create );
+}
@@ -1,5 +1,5 @@
 /*****************************************************************************
- * Transcoder.h: Handle file transcoding.
+ * MLTTitle.h: Producer rendering the title clips
  *****************************************************************************
  * Copyright (C) 2008-2016 VideoLAN
  *
@@ -20,46 +20,38 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
-#ifndef TRANSCODER_H
-#define TRANSCODER_H
+#ifndef MLTTITLE_H
+#define MLTTITLE_H
 
-#include <QObject>
-
-#include "Media.h"
+namespace Mlt
+{
+class Repository;
+}
 
 namespace Backend
 {
-namespace VLC
+namespace MLT
 {
-class VLCSourceRenderer;
-class RendererEventWatcher;
-}
-}
-
-class RendererEventWatcher;
 
-class Transcoder : public QObject
+/**
+ *  \brief  Produces the frames of a title, from its "resource" title file.
+ *
+ *  A title is static: its image is drawn once, the first time a frame of a given size
+ *  is asked for, and every frame of the title, and of all its cuts, is then served from
+ *  it. Editing a title gives it a new file content, which is opened as a new producer.
+ *  \sa Tools::Title, Tools::GlyphAtlas
+ */
+class MLTTitle
 {
-    Q_OBJECT
     public:
-        explicit    Transcoder( Media *media );
-        ~Transcoder();
-        void        transcodeToPs();
-
-    private:
-        Media*                      m_media;
-        QString                     m_destinationFile;
-        Backend::VLC::VLCSourceRenderer*   m_renderer;
-        Backend::VLC::RendererEventWatcher*       m_eventWatcher;
-
-    private slots:
-        void        transcodeFinished();
+        static const char* const    ServiceName;
+        // Titles last as long as images, and are trimmed by their clips
+        static const int            DefaultLength = 15000;
 
-    signals:
-        void        progress( float pos );
-        void        done();
-        //used for notification:
-        void        notify( QString );
+        static void                 registerService( Mlt::Repository& repository );
 };
 
-#endif // TRANSCODER_H
+}
+}
+
+#endif // MLTTITLE_H
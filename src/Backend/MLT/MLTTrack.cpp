@@ -27,11 +27,13 @@
 #include "MLTTrack.h"
 #include "MLTProfile.h"
 #include "MLTBackend.h"
+#include "MLTBinding.h"
 
 #include <mlt++/MltPlaylist.h>
 
 #include <cassert>
 #include <cstring>
+#include <memory>
 
 using namespace Backend::MLT;
 
@@ -87,9 +89,8 @@ MLTTrack::producer() const
 bool
 MLTTrack::insertAt( Backend::IInput& input, int64_t startFrame )
 {
-    auto mltInput = dynamic_cast<MLTInput*>( &input );
-    assert( mltInput );
-    return playlist()->insert_at( (int)startFrame, mltInput->producer(), 1 ) != -1;
+    auto& mltInput = native( input );
+    return playlist()->insert_at( (int)startFrame, mltInput.producer(), 1 ) != -1;
 }
 
 void
@@ -102,9 +103,8 @@ MLTTrack::remove( int index )
 bool
 MLTTrack::append( Backend::IInput& input )
 {
-    auto mltInput = dynamic_cast<MLTInput*>( &input );
-    assert( mltInput );
-    return !playlist()->append( *mltInput->producer() );
+    auto& mltInput = native( input );
+    return !playlist()->append( *mltInput.producer() );
 }
 
 bool
@@ -118,6 +118,238 @@ MLTTrack::move( int src, int dist )
     return playlist()->insert_at( dist, prod.get(), 1 ) != -1;
 }
 
+bool
+MLTTrack::reposition( int64_t src, int64_t dist )
+{
+    auto pl = playlist();
+    auto index = pl->get_clip_index_at( (int)src );
+    if ( index < 0 || index >= pl->count() || pl->is_blank( index ) )
+        return false;
+    auto delta = (int)dist - pl->clip_start( index );
+    if ( delta == 0 )
+        return true;
+    auto isLast = index + 1 == pl->count();
+    auto blankBefore = index > 0 && pl->is_blank( index - 1 ) ? pl->clip_length( index - 1 ) : 0;
+    auto blankAfter = isLast == false && pl->is_blank( index + 1 ) ? pl->clip_length( index + 1 ) : 0;
+
+    // Blanks are adjusted from the end, so the lower indexes stay valid
+    if ( delta > 0 )
+    {
+        if ( isLast == false && blankAfter < delta )
+            return move( (int)src, (int)dist );
+        if ( isLast == false )
+            resizeBlank( index + 1, blankAfter - delta );
+        if ( blankBefore > 0 )
+            resizeBlank( index - 1, blankBefore + delta );
+        else
+            pl->insert_blank( index, delta - 1 );
+    }
+    else
+    {
+        if ( blankBefore < -delta )
+            return move( (int)src, (int)dist );
+        if ( blankAfter > 0 )
+            resizeBlank( index + 1, blankAfter - delta );
+        else if ( isLast == false )
+            pl->insert_blank( index + 1, -delta - 1 );
+        resizeBlank( index - 1, blankBefore + delta );
+    }
+    return true;
+}
+
+void
+MLTTrack::resizeBlank( int index, int length )
+{
+    if ( length <= 0 )
+        playlist()->remove( index );
+    else
+        playlist()->resize_clip( index, 0, length - 1 );
+}
+
+bool
+MLTTrack::canTrim( int index, int inDelta, int outDelta ) const
+{
+    auto pl = playlist();
+    if ( index < 0 || index >= pl->count() )
+        return false;
+    if ( pl->is_blank( index ) )
+        return pl->clip_length( index ) - inDelta + outDelta >= 0;
+    std::unique_ptr<Mlt::ClipInfo> info( pl->clip_info( index ) );
+    auto in = info->frame_in + inDelta;
+    auto out = info->frame_out + outDelta;
+    return in >= 0 && out >= in && out < info->producer->get_length();
+}
+
+void
+MLTTrack::trim( int index, int inDelta, int outDelta )
+{
+    auto pl = playlist();
+    if ( pl->is_blank( index ) )
+    {
+        resizeBlank( index, pl->clip_length( index ) - inDelta + outDelta );
+        return;
+    }
+    std::unique_ptr<Mlt::ClipInfo> info( pl->clip_info( index ) );
+    pl->resize_clip( index, info->frame_in + inDelta, info->frame_out + outDelta );
+}
+
+bool
+MLTTrack::rippleRemove( int64_t position )
+{
+    auto pl = playlist();
+    auto index = pl->get_clip_index_at( (int)position );
+    if ( index < 0 || index >= pl->count() || pl->is_blank( index ) )
+        return false;
+    return pl->remove( index ) == 0;
+}
+
+bool
+MLTTrack::rippleInsert( Backend::IInput& input, int64_t startFrame )
+{
+    auto& mltInput = native( input );
+    auto pl = playlist();
+    if ( startFrame >= pl->get_playtime() )
+        return insertAt( input, startFrame );
+    auto index = pl->get_clip_index_at( (int)startFrame );
+    auto offset = (int)startFrame - pl->clip_start( index );
+    if ( offset > 0 )
+    {
+        // Inserting in the middle of a clip would cut it in two
+        if ( pl->is_blank( index ) == false )
+            return false;
+        pl->split( index, offset - 1 );
+        ++index;
+    }
+    return pl->insert( *mltInput.producer(), index ) == 0;
+}
+
+bool
+MLTTrack::roll( int64_t position, int64_t delta )
+{
+    auto pl = playlist();
+    auto right = pl->get_clip_index_at( (int)position );
+    if ( right <= 0 || right >= pl->count() || pl->clip_start( right ) != position )
+        return false;
+    auto left = right - 1;
+    if ( pl->is_blank( left ) == true && pl->is_blank( right ) == true )
+        return false;
+    if ( canTrim( left, 0, (int)delta ) == false || canTrim( right, (int)delta, 0 ) == false )
+        return false;
+    // The right entry first: a blank may vanish, and the left index has to stay valid
+    trim( right, (int)delta, 0 );
+    trim( left, 0, (int)delta );
+    return true;
+}
+
+bool
+MLTTrack::slip( int64_t position, int64_t delta )
+{
+    auto pl = playlist();
+    auto index = pl->get_clip_index_at( (int)position );
+    if ( index < 0 || index >= pl->count() || pl->is_blank( index ) )
+        return false;
+    if ( canTrim( index, (int)delta, (int)delta ) == false )
+        return false;
+    trim( index, (int)delta, (int)delta );
+    return true;
+}
+
+bool
+MLTTrack::slide( int64_t position, int64_t delta )
+{
+    auto pl = playlist();
+    auto index = pl->get_clip_index_at( (int)position );
+    if ( index < 0 || index >= pl->count() || pl->is_blank( index ) )
+        return false;
+    if ( delta == 0 )
+        return true;
+    auto hasRight = index + 1 < pl->count();
+    if ( index == 0 && delta < 0 )
+        return false;
+    if ( hasRight == true && canTrim( index + 1, (int)delta, 0 ) == false )
+        return false;
+    if ( index > 0 && canTrim( index - 1, 0, (int)delta ) == false )
+        return false;
+    if ( hasRight == true )
+        trim( index + 1, (int)delta, 0 );
+    if ( index > 0 )
+        trim( index - 1, 0, (int)delta );
+    else
+        pl->insert_blank( 0, (int)delta - 1 );
+    return true;
+}
+
+bool
+MLTTrack::replace( int64_t position, int count, const std::vector<IInput*>& inputs )
+{
+    auto pl = playlist();
+    auto index = pl->get_clip_index_at( (int)position );
+    if ( index < 0 || count <= 0 || index + count > pl->count() || inputs.empty() == true )
+        return false;
+    int64_t length = 0;
+    for ( auto i = index; i < index + count; ++i )
+    {
+        if ( pl->is_blank( i ) )
+            return false;
+        length += pl->clip_length( i );
+    }
+    for ( auto input : inputs )
+        length -= input->playableLength();
+    if ( length != 0 )
+        return false;
+    for ( auto i = 0; i < count; ++i )
+        pl->remove( index );
+    for ( size_t i = 0; i < inputs.size(); ++i )
+    {
+        auto& mltInput = native( *inputs[i] );
+        pl->insert( *mltInput.producer(), index + (int)i );
+    }
+    return true;
+}
+
+bool
+MLTTrack::insertMany( const std::vector<IInput*>& inputs, const std::vector<int64_t>& startFrames )
+{
+    if ( inputs.empty() == true || inputs.size() != startFrames.size() )
+        return false;
+    for ( size_t i = 1; i < inputs.size(); ++i )
+    {
+        if ( startFrames[i] < startFrames[i - 1] + inputs[i - 1]->playableLength() )
+            return false;
+    }
+    auto pl = playlist();
+    auto begin = startFrames.front();
+    auto end = startFrames.back() + inputs.back()->playableLength();
+    auto playtime = pl->get_playtime();
+    // Where the inputs go, and the blank they replace
+    auto index = pl->count();
+    int64_t blankBegin = playtime;
+    int64_t blankEnd = end;
+    if ( begin < playtime )
+    {
+        index = pl->get_clip_index_at( (int)begin );
+        if ( index < 0 || pl->is_blank( index ) == false )
+            return false;
+        blankBegin = pl->clip_start( index );
+        blankEnd = blankBegin + pl->clip_length( index );
+        if ( end > blankEnd )
+            return false;
+        pl->remove( index );
+    }
+    auto cursor = blankBegin;
+    for ( size_t i = 0; i < inputs.size(); ++i )
+    {
+        if ( startFrames[i] > cursor )
+            pl->insert_blank( index++, (int)( startFrames[i] - cursor ) - 1 );
+        auto& mltInput = native( *inputs[i] );
+        pl->insert( *mltInput.producer(), index++ );
+        cursor = startFrames[i] + inputs[i]->playableLength();
+    }
+    if ( blankEnd > cursor )
+        pl->insert_blank( index, (int)( blankEnd - cursor ) - 1 );
+    return true;
+}
+
 Backend::IInput*
 MLTTrack::clip( int index ) const
 {
@@ -133,13 +365,24 @@ MLTTrack::clipAt( int64_t position ) const
 bool
 MLTTrack::resizeClip( int clip, int64_t begin, int64_t end )
 {
-    auto oldEnd = playlist()->get_clip( clip )->get_out();
-    auto ret = playlist()->resize_clip( clip, (int)begin, (int)end );
-    if ( !ret && (int)end < oldEnd )
+    auto pl = playlist();
+    auto delta = (int)( end - begin + 1 ) - pl->clip_length( clip );
+    auto isLast = clip + 1 == pl->count();
+    auto blankAfter = isLast == false && pl->is_blank( clip + 1 ) ? pl->clip_length( clip + 1 ) : 0;
+    // Growing over the next clip would push it, and everything after it
+    if ( isLast == false && delta > blankAfter )
+        return false;
+    if ( pl->resize_clip( clip, (int)begin, (int)end ) != 0 )
+        return false;
+    // Keep the following clips in place by resizing the blank in between
+    if ( isLast == false && delta != 0 )
     {
-        playlist()->insert_blank( clip + 1, oldEnd - end - 1 );
+        if ( blankAfter > 0 )
+            resizeBlank( clip + 1, blankAfter - delta );
+        else
+            pl->insert_blank( clip + 1, -delta - 1 );
     }
-    return !ret;
+    return true;
 }
 
 int
@@ -55,6 +55,16 @@ class MLTTrack : public ITrack, public MLTInput
         virtual void        remove( int index ) override;
         virtual bool        append( IInput& input ) override;
         virtual bool        move( int src, int dist ) override;
+        virtual bool        reposition( int64_t src, int64_t dist ) override;
+        virtual bool        rippleRemove( int64_t position ) override;
+        virtual bool        rippleInsert( IInput& input, int64_t startFrame ) override;
+        virtual bool        roll( int64_t position, int64_t delta ) override;
+        virtual bool        slip( int64_t position, int64_t delta ) override;
+        virtual bool        slide( int64_t position, int64_t delta ) override;
+        virtual bool        replace( int64_t position, int count,
+                                     const std::vector<IInput*>& inputs ) override;
+        virtual bool        insertMany( const std::vector<IInput*>& inputs,
+                                        const std::vector<int64_t>& startFrames ) override;
         virtual IInput*  clip( int index ) const override;
         virtual IInput*  clipAt( int64_t position ) const override;
         virtual bool        resizeClip( int clip, int64_t begin, int64_t end ) override;
@@ -65,6 +75,17 @@ class MLTTrack : public ITrack, public MLTInput
         virtual void        setMute( bool muted ) override;
         virtual void        setVideoEnabled( bool enabled ) override;
 
+    private:
+        // Removes the blank when length isn't positive
+        void                resizeBlank( int index, int length );
+        /**
+         *  \brief  Moves the first and last frames of an entry by inDelta and outDelta.
+         *
+         *  A clip has to stay within its media, a blank may shrink down to nothing.
+         */
+        bool                canTrim( int index, int inDelta, int outDelta ) const;
+        void                trim( int index, int inDelta, int outDelta );
+
     private:
         Mlt::Playlist*                  m_playlist;
 };
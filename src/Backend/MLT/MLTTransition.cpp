@@ -39,6 +39,13 @@ MLTTransition::MLTTransition( Backend::IProfile& profile, const char *id )
         throw InvalidServiceException();
 }
 
+MLTTransition::MLTTransition( Mlt::Transition* transition )
+    : m_transition( transition )
+{
+    if ( isValid() == false )
+        throw InvalidServiceException();
+}
+
 MLTTransition::~MLTTransition()
 {
     delete m_transition;
@@ -53,6 +53,10 @@ namespace MLT
         virtual int64_t end() const override;
         virtual int64_t length() const override;
 
+    protected:
+        // Takes ownership of transition
+        explicit MLTTransition( Mlt::Transition* transition );
+
     private:
         Mlt::Transition*      m_transition;
     };
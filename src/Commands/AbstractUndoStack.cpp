@@ -26,6 +26,7 @@
 
 #include "AbstractUndoStack.h"
 #include "Commands.h"
+#include "Tools/Metrics.h"
 
 using namespace Commands;
 
@@ -41,9 +42,12 @@ AbstractUndoStack::redo()
 {
     if ( m_index >= m_stack.size() )
         return;
+    static auto& timing = Tools::Metrics::histogram( "edit.redo" );
+    Tools::Metrics::ScopedTimer timer( timing );
     m_stack[m_index]->redo();
     m_index++;
     _setClean( false );
+    emit indexChanged( m_index );
 }
 
 void
@@ -51,9 +55,12 @@ AbstractUndoStack::undo()
 {
     if ( m_index < 0 )
         return;
+    static auto& timing = Tools::Metrics::histogram( "edit.undo" );
+    Tools::Metrics::ScopedTimer timer( timing );
     m_stack[m_index]->undo();
     m_index--;
     _setClean( false );
+    emit indexChanged( m_index );
 }
 
 void
@@ -66,6 +73,7 @@ AbstractUndoStack::push( Generic* command )
     m_stack.push( command );
     command->redo();
     _setClean( false );
+    emit indexChanged( m_index );
 }
 
 void
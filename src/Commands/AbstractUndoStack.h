@@ -48,6 +48,8 @@ namespace Commands
 
         signals:
             void cleanChanged( bool val );
+            // Same as QUndoStack's: a command was pushed, undone or redone
+            void indexChanged( int idx );
 
         public slots:
             void redo();
@@ -28,6 +28,7 @@
 #include "Commands.h"
 #include "Project/Project.h"
 #include "Main/Core.h"
+#include "Library/Library.h"
 #include "Media/Clip.h"
 #include "EffectsEngine/EffectHelper.h"
 #include "Workflow/SequenceWorkflow.h"
@@ -35,6 +36,9 @@
 #include "AbstractUndoStack.h"
 #include "Backend/IFilter.h"
 
+#include <algorithm>
+#include <limits>
+
 Commands::Generic::Generic() :
         m_valid( true )
 {
@@ -45,6 +49,7 @@ Commands::Generic::Generic() :
     //       <3 qt4 connects
     // connect( Core::instance()->undoStack(), SIGNAL( retranslateRequired() ),
     //          this, SLOT( retranslate() ), Qt::DirectConnection );
+    m_lastUpdate.start();
 }
 
 void
@@ -61,6 +66,23 @@ Commands::Generic::isValid() const
     return m_valid;
 }
 
+void
+Commands::Generic::release()
+{
+}
+
+bool
+Commands::Generic::continuesWith( const Generic* next )
+{
+    // Long enough to span the gaps of a drag, short enough not to swallow the next one
+    static const qint64 MergeWindow = 500;
+
+    if ( m_valid == false || next->isValid() == false || m_lastUpdate.elapsed() > MergeWindow )
+        return false;
+    m_lastUpdate.restart();
+    return true;
+}
+
 #ifndef HAVE_GUI
 void
 Commands::Generic::setText( const QString& text )
@@ -89,6 +111,31 @@ Commands::Generic::undo()
         internalUndo();
 }
 
+namespace
+{
+// Swaps a clip that only the history still holds, and its producer, for its description
+void
+releaseClip( std::shared_ptr<Clip>& clip, QVariant& recipe )
+{
+    if ( !clip || clip.use_count() > 1 )
+        return;
+    recipe = clip->toVariant();
+    clip.reset();
+}
+
+bool
+restoreClip( std::shared_ptr<Clip>& clip, QVariant& recipe )
+{
+    if ( clip )
+        return true;
+    if ( recipe.isNull() == true )
+        return false;
+    clip = SequenceWorkflow::clipFromVariant( recipe.toMap() );
+    recipe.clear();
+    return clip != nullptr;
+}
+}
+
 Commands::Clip::Add::Add( std::shared_ptr<SequenceWorkflow> const& workflow,
                           const QUuid& uuid, quint32 trackId, qint32 pos, bool isAudioClip ) :
         m_workflow( workflow ),
@@ -146,6 +193,96 @@ Commands::Clip::Add::newClip()
     return m_clip;
 }
 
+Commands::Clip::AddMany::AddMany( std::shared_ptr<SequenceWorkflow> const& workflow,
+                                  const QList<QUuid>& uuids, quint32 trackId, qint64 pos,
+                                  bool audio, bool video ) :
+        m_workflow( workflow ),
+        m_linked( false )
+{
+    for ( const auto& uuid : uuids )
+    {
+        auto libraryClip = Core::instance()->library()->clip( uuid );
+        if ( libraryClip == nullptr )
+            continue;
+        std::shared_ptr<::Clip> audioClip;
+        std::shared_ptr<::Clip> videoClip;
+        if ( audio == true && libraryClip->formats().testFlag( ::Clip::Audio ) == true )
+            audioClip = workflow->createClip( uuid, true );
+        if ( video == true && libraryClip->formats().testFlag( ::Clip::Video ) == true )
+            videoClip = workflow->createClip( uuid, false );
+        if ( audioClip )
+            m_clips << std::make_tuple( audioClip, trackId, pos );
+        if ( videoClip )
+            m_clips << std::make_tuple( videoClip, trackId, pos );
+        if ( audioClip && videoClip )
+            m_links << qMakePair( audioClip->uuid(), videoClip->uuid() );
+        pos += libraryClip->length();
+    }
+    retranslate();
+    if ( m_clips.isEmpty() == true )
+        invalidate();
+}
+
+Commands::Clip::AddMany::AddMany( std::shared_ptr<SequenceWorkflow> const& workflow,
+                                  const QList<SequenceWorkflow::ClipTuple>& clips,
+                                  const QList<QPair<QUuid, QUuid>>& links ) :
+        m_workflow( workflow ),
+        m_clips( clips ),
+        m_links( links ),
+        m_linked( false )
+{
+    retranslate();
+    if ( m_clips.isEmpty() == true )
+        invalidate();
+}
+
+void
+Commands::Clip::AddMany::retranslate()
+{
+    setText( tr( "Adding %n clip(s)", "", m_clips.count() ) );
+}
+
+void
+Commands::Clip::AddMany::internalRedo()
+{
+    if ( m_workflow->addClips( m_clips ) == false )
+    {
+        QList<QUuid>    added;
+        for ( const auto& t : m_clips )
+            added << std::get<ClipTupleIndex::Clip>( t )->uuid();
+        m_workflow->removeClips( added );
+        invalidate();
+        return;
+    }
+    if ( m_linked == false )
+    {
+        for ( const auto& l : m_links )
+            m_workflow->linkClips( l.first, l.second );
+        m_linked = true;
+    }
+    emit Core::instance()->workflow()->clipsAdded( newClips() );
+}
+
+void
+Commands::Clip::AddMany::internalUndo()
+{
+    QList<QUuid>    uuids;
+    for ( const auto& t : m_clips )
+        uuids << std::get<ClipTupleIndex::Clip>( t )->uuid();
+    if ( m_workflow->removeClips( uuids ).count() != uuids.count() )
+        invalidate();
+    emit Core::instance()->workflow()->clipsRemoved( newClips() );
+}
+
+QStringList
+Commands::Clip::AddMany::newClips() const
+{
+    QStringList res;
+    for ( const auto& t : m_clips )
+        res << std::get<ClipTupleIndex::Clip>( t )->uuid().toString();
+    return res;
+}
+
 Commands::Clip::Move::Move(  std::shared_ptr<SequenceWorkflow> const& workflow,
                              const QString& uuid, quint32 trackId, qint64 pos ) :
     m_workflow( workflow ),
@@ -199,6 +336,26 @@ Commands::Clip::Move::internalUndo()
         invalidate();
 }
 
+#ifdef HAVE_GUI
+int
+Commands::Clip::Move::id() const
+{
+    return ClipMoveId;
+}
+
+bool
+Commands::Clip::Move::mergeWith( const QUndoCommand* command )
+{
+    auto next = static_cast<const Move*>( command );
+    if ( next->m_clip != m_clip || continuesWith( next ) == false )
+        return false;
+    m_newTrackId = next->m_newTrackId;
+    m_newPos = next->m_newPos;
+    retranslate();
+    return true;
+}
+#endif
+
 Commands::Clip::Remove::Remove( std::shared_ptr<SequenceWorkflow> const& workflow,
                                 const QUuid& uuid ) :
         m_workflow( workflow ),
@@ -233,7 +390,7 @@ Commands::Clip::Remove::internalRedo()
 void
 Commands::Clip::Remove::internalUndo()
 {
-    if ( !m_clip )
+    if ( restoreClip( m_clip, m_recipe ) == false )
     {
         invalidate();
         return;
@@ -245,6 +402,12 @@ Commands::Clip::Remove::internalUndo()
         invalidate();
 }
 
+void
+Commands::Clip::Remove::release()
+{
+    releaseClip( m_clip, m_recipe );
+}
+
 Commands::Clip::Resize::Resize( std::shared_ptr<SequenceWorkflow> const& workflow,
                                 const QUuid& uuid, qint64 newBegin, qint64 newEnd, qint64 newPos ) :
     m_workflow( workflow ),
@@ -261,7 +424,7 @@ Commands::Clip::Resize::Resize( std::shared_ptr<SequenceWorkflow> const& workflo
     }
     m_oldBegin = m_clip->begin();
     m_oldEnd = m_clip->end();
-    m_oldPos = workflow->trackId( uuid );
+    m_oldPos = workflow->position( uuid );
     retranslate();
 }
 
@@ -291,71 +454,510 @@ Commands::Clip::Resize::internalUndo()
         invalidate();
 }
 
-Commands::Clip::Split::Split( std::shared_ptr<SequenceWorkflow> const& workflow,
-                              const QUuid& uuid, qint64 newClipPos, qint64 newClipBegin ) :
+#ifdef HAVE_GUI
+int
+Commands::Clip::Resize::id() const
+{
+    return ClipResizeId;
+}
+
+bool
+Commands::Clip::Resize::mergeWith( const QUndoCommand* command )
+{
+    auto next = static_cast<const Resize*>( command );
+    if ( next->m_clip != m_clip || continuesWith( next ) == false )
+        return false;
+    m_newBegin = next->m_newBegin;
+    m_newEnd = next->m_newEnd;
+    m_newPos = next->m_newPos;
+    return true;
+}
+#endif
+
+Commands::Clip::EditMany::EditMany( std::shared_ptr<SequenceWorkflow> const& workflow,
+                                    const QList<SequenceWorkflow::ClipEdit>& edits ) :
     m_workflow( workflow ),
-    m_toSplit( workflow->clip( uuid ) ),
-    m_trackId( workflow->trackId( uuid ) ),
-    m_newClip( nullptr ),
-    m_newClipPos( newClipPos ),
-    m_newClipBegin( newClipBegin )
+    m_newEdits( edits )
 {
-    if ( !m_toSplit )
+    for ( const auto& e : edits )
     {
+        auto clip = workflow->clip( e.uuid );
+        if ( !clip )
+        {
+            invalidate();
+            break;
+        }
+        m_oldEdits << SequenceWorkflow::ClipEdit{ e.uuid, workflow->trackId( e.uuid ),
+                                                  workflow->position( e.uuid ),
+                                                  clip->begin(), clip->end() };
+    }
+    retranslate();
+}
+
+void
+Commands::Clip::EditMany::retranslate()
+{
+    setText( tr( "Moving %n clip(s)", "", m_newEdits.count() ) );
+}
+
+void
+Commands::Clip::EditMany::internalRedo()
+{
+    if ( m_workflow->editClips( m_newEdits ) == true )
+        notify( m_newEdits );
+    else
         invalidate();
-        retranslate();
+}
+
+void
+Commands::Clip::EditMany::internalUndo()
+{
+    if ( m_workflow->editClips( m_oldEdits ) == true )
+        notify( m_oldEdits );
+    else
+        invalidate();
+}
+
+void
+Commands::Clip::EditMany::notify( const QList<SequenceWorkflow::ClipEdit>& edits )
+{
+    auto mainWorkflow = Core::instance()->workflow();
+    for ( const auto& e : edits )
+    {
+        emit mainWorkflow->clipMoved( e.uuid.toString() );
+        if ( e.begin >= 0 || e.end >= 0 )
+            emit mainWorkflow->clipResized( e.uuid.toString() );
+    }
+}
+
+Commands::Clip::RemoveMany::RemoveMany( std::shared_ptr<SequenceWorkflow> const& workflow,
+                                        const QList<QUuid>& uuids ) :
+        m_workflow( workflow ),
+        m_uuids( uuids )
+{
+    retranslate();
+}
+
+void
+Commands::Clip::RemoveMany::retranslate()
+{
+    setText( tr( "Removing %n clip(s)", "", m_uuids.count() ) );
+}
+
+void
+Commands::Clip::RemoveMany::internalRedo()
+{
+    m_clips = m_workflow->removeClips( m_uuids );
+    if ( m_clips.isEmpty() == true )
+    {
+        invalidate();
+        return;
+    }
+    for ( const auto& t : m_clips )
+        emit Core::instance()->workflow()->clipRemoved( std::get<ClipTupleIndex::Clip>( t )->uuid().toString() );
+}
+
+void
+Commands::Clip::RemoveMany::internalUndo()
+{
+    for ( int i = 0; i < m_recipes.count(); ++i )
+    {
+        auto& clip = std::get<ClipTupleIndex::Clip>( m_clips[i] );
+        if ( restoreClip( clip, m_recipes[i] ) == false )
+        {
+            invalidate();
+            return;
+        }
+    }
+    m_recipes.clear();
+    if ( m_workflow->addClips( m_clips ) == false )
+        invalidate();
+    for ( const auto& t : m_clips )
+        emit Core::instance()->workflow()->clipAdded( std::get<ClipTupleIndex::Clip>( t )->uuid().toString() );
+}
+
+void
+Commands::Clip::RemoveMany::release()
+{
+    if ( m_recipes.isEmpty() == false )
         return;
+    // All or nothing, the clips are added back together
+    for ( const auto& t : m_clips )
+    {
+        if ( std::get<ClipTupleIndex::Clip>( t ).use_count() > 1 )
+            return;
+    }
+    for ( auto& t : m_clips )
+    {
+        m_recipes << QVariant();
+        releaseClip( std::get<ClipTupleIndex::Clip>( t ), m_recipes.last() );
     }
-    m_newClip = std::make_shared<::Clip>( m_toSplit.get(), newClipBegin - m_toSplit->begin(), m_toSplit->end() - m_toSplit->begin() );
-    m_oldEnd = m_toSplit->end();
+}
+
+Commands::Clip::Nest::Nest( std::shared_ptr<SequenceWorkflow> const& workflow, const QList<QUuid>& uuids,
+                            const QUuid& sequenceUuid, quint32 trackId, qint64 pos ) :
+        m_remove( new RemoveMany( workflow, uuids ) ),
+        m_add( new AddMany( workflow, QList<QUuid>() << sequenceUuid, trackId, pos, true, true ) )
+{
     retranslate();
+    if ( uuids.isEmpty() == true || m_add->isValid() == false )
+        invalidate();
 }
 
 void
-Commands::Clip::Split::retranslate()
+Commands::Clip::Nest::retranslate()
 {
-    setText( tr("Splitting clip") );
+    setText( tr( "Nesting clips" ) );
 }
 
 void
-Commands::Clip::Split::internalRedo()
+Commands::Clip::Nest::internalRedo()
 {
-    if ( !m_toSplit )
+    m_remove->redo();
+    if ( m_remove->isValid() == false )
     {
         invalidate();
         return;
     }
-    //If we don't remove 1, the clip will end exactly at the starting frame (ie. they will
-    //be rendering at the same time)
-    bool ret = m_workflow->resizeClip( m_toSplit->uuid(), m_toSplit->begin(),
-                                       m_newClipBegin - 1, m_workflow->position( m_toSplit->uuid() ) );
-    if ( ret == false )
+    // The nested clip goes where the clips were
+    m_add->redo();
+    if ( m_add->isValid() == false )
     {
+        m_remove->undo();
+        invalidate();
+    }
+}
+
+void
+Commands::Clip::Nest::internalUndo()
+{
+    m_add->undo();
+    m_remove->undo();
+    if ( m_add->isValid() == false || m_remove->isValid() == false )
         invalidate();
+}
+
+void
+Commands::Clip::Nest::release()
+{
+    m_remove->release();
+}
+
+QStringList
+Commands::Clip::Nest::newClips() const
+{
+    return m_add->newClips();
+}
+
+namespace
+{
+// The clips of the track following a ripple edit have all moved
+void
+notifyFollowingClips( SequenceWorkflow& workflow, const Clip& clip, quint32 trackId, qint64 from )
+{
+    auto index = workflow.clipIndex( SequenceWorkflow::trackType( clip ), trackId );
+    if ( index == nullptr )
         return;
+    for ( const auto& e : index->overlapping( from, std::numeric_limits<qint64>::max(), clip.uuid() ) )
+    {
+        if ( e.begin >= from )
+            emit Core::instance()->workflow()->clipMoved( e.uuid.toString() );
     }
+}
+}
 
-    ret = m_workflow->addClip( m_newClip, m_trackId, m_newClipPos );
-    if ( ret == true )
-        emit Core::instance()->workflow()->clipAdded( m_newClip->uuid().toString() );
+Commands::Clip::RippleRemove::RippleRemove( std::shared_ptr<SequenceWorkflow> const& workflow,
+                                            const QUuid& uuid ) :
+        m_workflow( workflow ),
+        m_clip( workflow->clip( uuid ) ),
+        m_trackId( workflow->trackId( uuid ) ),
+        m_pos( workflow->position( uuid ) )
+{
+    if ( !m_clip )
+        invalidate();
+    retranslate();
+}
+
+void
+Commands::Clip::RippleRemove::retranslate()
+{
+    setText( tr( "Removing clip and closing the gap" ) );
+}
+
+void
+Commands::Clip::RippleRemove::internalRedo()
+{
+    if ( !m_workflow->rippleRemoveClip( m_clip->uuid() ) )
+    {
+        invalidate();
+        return;
+    }
+    emit Core::instance()->workflow()->clipRemoved( m_clip->uuid().toString() );
+    notifyFollowingClips( *m_workflow, *m_clip, m_trackId, m_pos );
+}
+
+void
+Commands::Clip::RippleRemove::internalUndo()
+{
+    if ( restoreClip( m_clip, m_recipe ) == false ||
+         m_workflow->rippleInsertClip( m_clip, m_trackId, m_pos ) == false )
+    {
+        invalidate();
+        return;
+    }
+    emit Core::instance()->workflow()->clipAdded( m_clip->uuid().toString() );
+    notifyFollowingClips( *m_workflow, *m_clip, m_trackId, m_pos );
+}
+
+void
+Commands::Clip::RippleRemove::release()
+{
+    releaseClip( m_clip, m_recipe );
+}
+
+Commands::Clip::RippleInsert::RippleInsert( std::shared_ptr<SequenceWorkflow> const& workflow,
+                                            const QUuid& uuid, quint32 trackId, qint64 pos,
+                                            bool isAudioClip ) :
+        m_workflow( workflow ),
+        m_uuid( uuid ),
+        m_trackId( trackId ),
+        m_pos( pos ),
+        m_isAudioClip( isAudioClip )
+{
+    retranslate();
+}
+
+void
+Commands::Clip::RippleInsert::retranslate()
+{
+    setText( tr( "Inserting clip in track %1" ).arg( m_trackId ) );
+}
+
+void
+Commands::Clip::RippleInsert::internalRedo()
+{
+    if ( !m_clip )
+        m_clip = m_workflow->createClip( m_uuid, m_isAudioClip );
+    if ( !m_clip || m_workflow->rippleInsertClip( m_clip, m_trackId, m_pos ) == false )
+    {
+        invalidate();
+        return;
+    }
+    emit Core::instance()->workflow()->clipAdded( m_clip->uuid().toString() );
+    notifyFollowingClips( *m_workflow, *m_clip, m_trackId, m_pos );
+}
+
+void
+Commands::Clip::RippleInsert::internalUndo()
+{
+    if ( !m_workflow->rippleRemoveClip( m_clip->uuid() ) )
+    {
+        invalidate();
+        return;
+    }
+    emit Core::instance()->workflow()->clipRemoved( m_clip->uuid().toString() );
+    notifyFollowingClips( *m_workflow, *m_clip, m_trackId, m_pos );
+}
+
+Commands::Clip::Roll::Roll( std::shared_ptr<SequenceWorkflow> const& workflow,
+                            const QUuid& uuid, qint64 delta ) :
+        m_workflow( workflow ),
+        m_uuid( uuid ),
+        m_next( workflow->nextClip( uuid ) ),
+        m_delta( delta )
+{
+    retranslate();
+}
+
+void
+Commands::Clip::Roll::retranslate()
+{
+    setText( tr( "Rolling edit" ) );
+}
+
+void
+Commands::Clip::Roll::apply( qint64 delta )
+{
+    if ( m_workflow->rollClip( m_uuid, delta ) == false )
+    {
+        invalidate();
+        return;
+    }
+    emit Core::instance()->workflow()->clipResized( m_uuid.toString() );
+    if ( m_next.isNull() == false )
+        emit Core::instance()->workflow()->clipResized( m_next.toString() );
+}
+
+void
+Commands::Clip::Roll::internalRedo()
+{
+    apply( m_delta );
+}
+
+void
+Commands::Clip::Roll::internalUndo()
+{
+    apply( -m_delta );
+}
+
+Commands::Clip::Slip::Slip( std::shared_ptr<SequenceWorkflow> const& workflow,
+                            const QUuid& uuid, qint64 delta ) :
+        m_workflow( workflow ),
+        m_uuid( uuid ),
+        m_delta( delta )
+{
+    retranslate();
+}
+
+void
+Commands::Clip::Slip::retranslate()
+{
+    setText( tr( "Slipping clip" ) );
+}
+
+void
+Commands::Clip::Slip::apply( qint64 delta )
+{
+    if ( m_workflow->slipClip( m_uuid, delta ) == true )
+        emit Core::instance()->workflow()->clipResized( m_uuid.toString() );
     else
         invalidate();
+}
+
+void
+Commands::Clip::Slip::internalRedo()
+{
+    apply( m_delta );
+}
+
+void
+Commands::Clip::Slip::internalUndo()
+{
+    apply( -m_delta );
+}
+
+Commands::Clip::Slide::Slide( std::shared_ptr<SequenceWorkflow> const& workflow,
+                              const QUuid& uuid, qint64 delta ) :
+        m_workflow( workflow ),
+        m_previous( workflow->previousClip( uuid ) ),
+        m_uuid( uuid ),
+        m_next( workflow->nextClip( uuid ) ),
+        m_delta( delta )
+{
+    retranslate();
+}
+
+void
+Commands::Clip::Slide::retranslate()
+{
+    setText( tr( "Sliding clip" ) );
+}
+
+void
+Commands::Clip::Slide::apply( qint64 delta )
+{
+    if ( m_workflow->slideClip( m_uuid, delta ) == false )
+    {
+        invalidate();
+        return;
+    }
+    for ( const auto& uuid : { m_previous, m_uuid, m_next } )
+    {
+        if ( uuid.isNull() == false )
+            emit Core::instance()->workflow()->clipResized( uuid.toString() );
+    }
+}
+
+void
+Commands::Clip::Slide::internalRedo()
+{
+    apply( m_delta );
+}
+
+void
+Commands::Clip::Slide::internalUndo()
+{
+    apply( -m_delta );
+}
+
+Commands::Clip::MultiSplit::MultiSplit( std::shared_ptr<SequenceWorkflow> const& workflow,
+                                        const QUuid& uuid, QList<qint64> positions ) :
+    m_workflow( workflow ),
+    m_toSplit( workflow->clip( uuid ) )
+{
+    retranslate();
+    if ( !m_toSplit )
+    {
+        invalidate();
+        return;
+    }
+    auto pos = workflow->position( uuid );
+    auto end = pos + m_toSplit->length();
+    std::sort( positions.begin(), positions.end() );
+    positions.erase( std::unique( positions.begin(), positions.end() ), positions.end() );
+    QList<qint64>   cuts;
+    for ( auto p : positions )
+    {
+        if ( p > pos && p < end )
+            cuts << p;
+    }
+    // Cut from the library clip, as the pieces don't depend on the clip they came from
+    auto parent = m_toSplit->parent();
+    auto filters = EffectHelper::toVariant( m_toSplit->input() );
+    for ( int i = 0; i < cuts.count(); ++i )
+    {
+        auto begin = m_toSplit->begin() + cuts[i] - pos;
+        auto pieceEnd = i + 1 < cuts.count() ? m_toSplit->begin() + cuts[i + 1] - pos - 1
+                                             : m_toSplit->end();
+        auto piece = std::make_shared<::Clip>( parent, begin - parent->begin(), pieceEnd - parent->begin() );
+        piece->setFormats( m_toSplit->formats() );
+        // Cut from the same retimed media, whose frames begin and pieceEnd are
+        if ( m_toSplit->speed() != 1. )
+            piece->setRetiming( m_toSplit->speed(), m_toSplit->frameBlending(), begin, pieceEnd );
+        EffectHelper::loadFromVariant( filters, piece->input() );
+        m_pieces << piece;
+    }
+    if ( m_pieces.isEmpty() == true )
+        invalidate();
+}
+
+void
+Commands::Clip::MultiSplit::retranslate()
+{
+    setText( tr( "Splitting clip" ) );
+}
+
+void
+Commands::Clip::MultiSplit::internalRedo()
+{
+    if ( !m_toSplit || m_workflow->splitClip( m_toSplit->uuid(), m_pieces ) == false )
+    {
+        invalidate();
+        return;
+    }
+    QStringList uuids;
+    for ( const auto& p : m_pieces )
+        uuids << p->uuid().toString();
+    emit Core::instance()->workflow()->clipsAdded( uuids );
     emit Core::instance()->workflow()->clipResized( m_toSplit->uuid().toString() );
 }
 
 void
-Commands::Clip::Split::internalUndo()
+Commands::Clip::MultiSplit::internalUndo()
 {
-    m_newClip = m_workflow->removeClip( m_newClip->uuid() );
-    if ( !m_newClip )
+    QList<QUuid>    pieces;
+    QStringList     uuids;
+    for ( const auto& p : m_pieces )
+    {
+        pieces << p->uuid();
+        uuids << p->uuid().toString();
+    }
+    if ( m_workflow->joinClip( m_toSplit->uuid(), pieces ).isEmpty() == true )
     {
         invalidate();
         return;
     }
-    else
-        emit Core::instance()->workflow()->clipRemoved( m_newClip->uuid().toString() );
-    m_workflow->resizeClip( m_toSplit->uuid(), m_toSplit->begin(),
-                            m_oldEnd, m_workflow->position( m_toSplit->uuid() ) );
+    emit Core::instance()->workflow()->clipsRemoved( uuids );
     emit Core::instance()->workflow()->clipResized( m_toSplit->uuid().toString() );
 }
 
@@ -394,6 +996,71 @@ Commands::Clip::Link::internalUndo()
         invalidate();
 }
 
+Commands::Clip::Retime::Retime( std::shared_ptr<SequenceWorkflow> const& workflow,
+                                const QUuid& uuid, double speed, bool frameBlending )
+    : m_workflow( workflow )
+{
+    retranslate();
+    auto clip = workflow->clip( uuid );
+    if ( !clip || speed == 0. )
+    {
+        invalidate();
+        return;
+    }
+    QList<std::shared_ptr<::Clip>>  clips{ clip };
+    if ( clip->isLinked() == true )
+    {
+        auto linked = workflow->clip( clip->linkedClipUuid() );
+        if ( linked )
+            clips << linked;
+    }
+    for ( const auto& c : clips )
+    {
+        m_old << Retiming{ c->uuid(), c->speed(), c->frameBlending(), c->begin(), c->end() };
+        Retiming r{ c->uuid(), speed, frameBlending, 0, 0 };
+        c->retimedBoundaries( speed, r.begin, r.end );
+        m_new << r;
+    }
+}
+
+void
+Commands::Clip::Retime::retranslate()
+{
+    setText( tr( "Changing clip speed" ) );
+}
+
+void
+Commands::Clip::Retime::apply( const QList<Retiming>& to, const QList<Retiming>& from )
+{
+    for ( int i = 0; i < to.count(); ++i )
+    {
+        const auto& r = to[i];
+        if ( m_workflow->retimeClip( r.uuid, r.speed, r.frameBlending, r.begin, r.end ) == true )
+            continue;
+        while ( i-- > 0 )
+        {
+            const auto& f = from[i];
+            m_workflow->retimeClip( f.uuid, f.speed, f.frameBlending, f.begin, f.end );
+        }
+        invalidate();
+        return;
+    }
+    for ( const auto& r : to )
+        emit Core::instance()->workflow()->clipResized( r.uuid.toString() );
+}
+
+void
+Commands::Clip::Retime::internalRedo()
+{
+    apply( m_new, m_old );
+}
+
+void
+Commands::Clip::Retime::internalUndo()
+{
+    apply( m_old, m_new );
+}
+
 Commands::Effect::Add::Add( std::shared_ptr<EffectHelper> const& helper, Backend::IInput* target )
     : m_helper( helper )
     , m_target( target )
@@ -411,12 +1078,14 @@ void
 Commands::Effect::Add::internalRedo()
 {
     m_target->attach( *m_helper->filter() );
+    Core::instance()->workflow()->filterChanged( m_target, m_helper->begin(), m_helper->end() );
 }
 
 void
 Commands::Effect::Add::internalUndo()
 {
     m_target->detach( *m_helper->filter() );
+    Core::instance()->workflow()->filterChanged( m_target, m_helper->begin(), m_helper->end() );
 }
 
 Commands::Effect::Move::Move( std::shared_ptr<EffectHelper> const& helper, std::shared_ptr<Backend::IInput> const& from, Backend::IInput* to,
@@ -450,6 +1119,8 @@ Commands::Effect::Move::internalRedo()
     }
     else
         m_helper->setBoundaries( m_newPos, m_newEnd );
+    Core::instance()->workflow()->filterChanged( m_from.get(), m_oldPos, m_oldEnd );
+    Core::instance()->workflow()->filterChanged( m_to, m_newPos, m_newEnd );
 }
 
 void
@@ -463,6 +1134,8 @@ Commands::Effect::Move::internalUndo()
     }
     else
         m_helper->setBoundaries( m_oldPos, m_oldEnd );
+    Core::instance()->workflow()->filterChanged( m_to, m_newPos, m_newEnd );
+    Core::instance()->workflow()->filterChanged( m_from.get(), m_oldPos, m_oldEnd );
 }
 
 Commands::Effect::Resize::Resize( std::shared_ptr<EffectHelper> const& helper, qint64 newBegin, qint64 newEnd )
@@ -485,13 +1158,44 @@ void
 Commands::Effect::Resize::internalRedo()
 {
     m_helper->setBoundaries( m_newBegin, m_newEnd );
+    notify();
 }
 
 void
 Commands::Effect::Resize::internalUndo()
 {
     m_helper->setBoundaries( m_oldBegin, m_oldEnd );
+    notify();
+}
+
+void
+Commands::Effect::Resize::notify()
+{
+    auto target = m_helper->filter()->input();
+    if ( target == nullptr )
+        return;
+    Core::instance()->workflow()->filterChanged( target.get(), m_oldBegin, m_oldEnd );
+    Core::instance()->workflow()->filterChanged( target.get(), m_newBegin, m_newEnd );
+}
+
+#ifdef HAVE_GUI
+int
+Commands::Effect::Resize::id() const
+{
+    return EffectResizeId;
+}
+
+bool
+Commands::Effect::Resize::mergeWith( const QUndoCommand* command )
+{
+    auto next = static_cast<const Resize*>( command );
+    if ( next->m_helper != m_helper || continuesWith( next ) == false )
+        return false;
+    m_newBegin = next->m_newBegin;
+    m_newEnd = next->m_newEnd;
+    return true;
 }
+#endif
 
 Commands::Effect::Remove::Remove( std::shared_ptr<EffectHelper> const& helper )
     : m_helper( helper )
@@ -510,10 +1214,12 @@ void
 Commands::Effect::Remove::internalRedo()
 {
     m_target->detach( *m_helper->filter() );
+    Core::instance()->workflow()->filterChanged( m_target.get(), m_helper->begin(), m_helper->end() );
 }
 
 void
 Commands::Effect::Remove::internalUndo()
 {
     m_helper->setTarget( m_target.get() );
+    Core::instance()->workflow()->filterChanged( m_target.get(), m_helper->begin(), m_helper->end() );
 }
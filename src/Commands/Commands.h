@@ -29,10 +29,13 @@
 #ifdef HAVE_GUI
 # include <QUndoCommand>
 #endif
+#include <QElapsedTimer>
 #include <QObject>
 #include <QUuid>
 #include <memory>
 
+#include "Workflow/SequenceWorkflow.h"
+
 class   Clip;
 class   SequenceWorkflow;
 
@@ -44,6 +47,16 @@ class   EffectHelper;
 
 namespace Commands
 {
+    /**
+     *  \brief  QUndoCommand ids of the commands which can be merged together.
+     */
+    enum MergeId
+    {
+        ClipMoveId = 1,
+        ClipResizeId,
+        EffectResizeId,
+    };
+
 #ifdef HAVE_GUI
     class       Generic : public QObject, public QUndoCommand
 #else
@@ -59,13 +72,30 @@ namespace Commands
             void            redo();
             void            undo();
             bool            isValid() const;
+            /**
+             *  \brief  Drops the live objects only needed to undo this command.
+             *
+             *  Called on the commands deep in the history. They keep a description of
+             *  what they released instead, and rebuild it if they get undone.
+             */
+            virtual void    release();
 #ifndef HAVE_GUI
             void            setText( const QString& text ) ;
             QString         text() const;
 #endif
+        protected:
+            /**
+             *  \brief  Tells if next, which was just pushed, continues the same edit.
+             *
+             *  Successive updates of a continuous drag come in quick succession, and
+             *  are collapsed into a single undo step. Restarts the merge window.
+             */
+            bool            continuesWith( const Generic* next );
+
         private:
             bool            m_valid;
             QString         m_text;
+            QElapsedTimer   m_lastUpdate;
         protected slots:
             virtual void    retranslate() = 0;
             void            invalidate();
@@ -94,6 +124,36 @@ namespace Commands
                 bool                        m_isAudioClip;
         };
 
+        /**
+         *  \brief  Adds clips of the library one after the other, as a single undo step.
+         *
+         *  The audio and video parts of each clip are added, as requested and when the
+         *  media has them, and linked together.
+         */
+        class   AddMany : public Generic
+        {
+            public:
+                AddMany( std::shared_ptr<SequenceWorkflow> const& workflow, const QList<QUuid>& uuids,
+                         quint32 trackId, qint64 pos, bool audio, bool video );
+                // Clips which are already cut and placed, with the (audio, video) pairs to link
+                AddMany( std::shared_ptr<SequenceWorkflow> const& workflow,
+                         const QList<SequenceWorkflow::ClipTuple>& clips,
+                         const QList<QPair<QUuid, QUuid>>& links );
+                virtual void    internalRedo();
+                virtual void    internalUndo();
+                virtual void    retranslate();
+
+                QStringList     newClips() const;
+
+            private:
+                std::shared_ptr<SequenceWorkflow>       m_workflow;
+                QList<SequenceWorkflow::ClipTuple>      m_clips;
+                // The audio and video parts of the same clips
+                QList<QPair<QUuid, QUuid>>              m_links;
+                // The clips keep their links when removed by undo
+                bool                                    m_linked;
+        };
+
         class   Move : public Generic
         {
             public:
@@ -101,6 +161,10 @@ namespace Commands
                 virtual void    internalRedo();
                 virtual void    internalUndo();
                 virtual void    retranslate();
+#ifdef HAVE_GUI
+                virtual int     id() const override;
+                virtual bool    mergeWith( const QUndoCommand* command ) override;
+#endif
 
             private:
                 std::shared_ptr<SequenceWorkflow> m_workflow;
@@ -118,10 +182,13 @@ namespace Commands
                 virtual void internalRedo();
                 virtual void internalUndo();
                 virtual void    retranslate();
+                virtual void    release() override;
 
             private:
                 std::shared_ptr<SequenceWorkflow> m_workflow;
                 std::shared_ptr<::Clip>           m_clip;
+                // The removed clip's description, once released
+                QVariant                          m_recipe;
                 quint32         m_trackId;
                 qint64          m_pos;
         };
@@ -141,6 +208,10 @@ namespace Commands
                 virtual void    internalRedo();
                 virtual void    internalUndo();
                 virtual void    retranslate();
+#ifdef HAVE_GUI
+                virtual int     id() const override;
+                virtual bool    mergeWith( const QUndoCommand* command ) override;
+#endif
 
             private:
                 std::shared_ptr<SequenceWorkflow> m_workflow;
@@ -153,22 +224,181 @@ namespace Commands
                 qint64                      m_oldPos;
         };
 
-        class   Split : public Generic
+        /**
+         *  \brief  Moves and resizes several clips at once, as a single undo step.
+         *
+         *  The edits are validated and applied together, so the clips of a dragged
+         *  selection can take each other's places.
+         */
+        class   EditMany : public Generic
+        {
+            public:
+                EditMany( std::shared_ptr<SequenceWorkflow> const& workflow,
+                          const QList<SequenceWorkflow::ClipEdit>& edits );
+                virtual void    internalRedo();
+                virtual void    internalUndo();
+                virtual void    retranslate();
+
+            private:
+                void            notify( const QList<SequenceWorkflow::ClipEdit>& edits );
+
+            private:
+                std::shared_ptr<SequenceWorkflow>     m_workflow;
+                QList<SequenceWorkflow::ClipEdit>     m_newEdits;
+                QList<SequenceWorkflow::ClipEdit>     m_oldEdits;
+        };
+
+        /**
+         *  \brief  Removes several clips, such as a selection or a group, as a single undo step.
+         */
+        class   RemoveMany : public Generic
+        {
+            public:
+                RemoveMany( std::shared_ptr<SequenceWorkflow> const& workflow, const QList<QUuid>& uuids );
+                virtual void    internalRedo();
+                virtual void    internalUndo();
+                virtual void    retranslate();
+                virtual void    release() override;
+
+            private:
+                std::shared_ptr<SequenceWorkflow>       m_workflow;
+                QList<QUuid>                            m_uuids;
+                QList<SequenceWorkflow::ClipTuple>      m_clips;
+                // One per tuple of m_clips, once released
+                QList<QVariant>                         m_recipes;
+        };
+
+        class   RippleRemove : public Generic
         {
             public:
-                Split( std::shared_ptr<SequenceWorkflow> const& workflow,
-                       const QUuid& uuid, qint64 newClipPos, qint64 newClipBegin );
+                RippleRemove( std::shared_ptr<SequenceWorkflow> const& workflow, const QUuid& uuid );
+                virtual void    internalRedo();
+                virtual void    internalUndo();
+                virtual void    retranslate();
+                virtual void    release() override;
+
+            private:
+                std::shared_ptr<SequenceWorkflow> m_workflow;
+                std::shared_ptr<::Clip>     m_clip;
+                QVariant                    m_recipe;
+                quint32                     m_trackId;
+                qint64                      m_pos;
+        };
+
+        class   RippleInsert : public Generic
+        {
+            public:
+                RippleInsert( std::shared_ptr<SequenceWorkflow> const& workflow, const QUuid& uuid,
+                              quint32 trackId, qint64 pos, bool isAudioClip );
+                virtual void    internalRedo();
+                virtual void    internalUndo();
+                virtual void    retranslate();
+
+            private:
+                std::shared_ptr<SequenceWorkflow> m_workflow;
+                // The library clip to instantiate
+                QUuid                       m_uuid;
+                std::shared_ptr<::Clip>     m_clip;
+                quint32                     m_trackId;
+                qint64                      m_pos;
+                bool                        m_isAudioClip;
+        };
+
+        /**
+         *  \brief  Moves the cut between a clip and the one following it.
+         */
+        class   Roll : public Generic
+        {
+            public:
+                Roll( std::shared_ptr<SequenceWorkflow> const& workflow, const QUuid& uuid, qint64 delta );
+                virtual void    internalRedo();
+                virtual void    internalUndo();
+                virtual void    retranslate();
+
+            private:
+                void            apply( qint64 delta );
+
+            private:
+                std::shared_ptr<SequenceWorkflow> m_workflow;
+                QUuid                       m_uuid;
+                QUuid                       m_next;
+                qint64                      m_delta;
+        };
+
+        class   Slip : public Generic
+        {
+            public:
+                Slip( std::shared_ptr<SequenceWorkflow> const& workflow, const QUuid& uuid, qint64 delta );
+                virtual void    internalRedo();
+                virtual void    internalUndo();
+                virtual void    retranslate();
+
+            private:
+                void            apply( qint64 delta );
+
+            private:
+                std::shared_ptr<SequenceWorkflow> m_workflow;
+                QUuid                       m_uuid;
+                qint64                      m_delta;
+        };
+
+        class   Slide : public Generic
+        {
+            public:
+                Slide( std::shared_ptr<SequenceWorkflow> const& workflow, const QUuid& uuid, qint64 delta );
+                virtual void    internalRedo();
+                virtual void    internalUndo();
+                virtual void    retranslate();
+
+            private:
+                void            apply( qint64 delta );
+
+            private:
+                std::shared_ptr<SequenceWorkflow> m_workflow;
+                QUuid                       m_previous;
+                QUuid                       m_uuid;
+                QUuid                       m_next;
+                qint64                      m_delta;
+        };
+
+        /**
+         *  \brief  Splits a clip at many positions at once, in a single pass over its
+         *          track. The pieces keep the clip's formats and effects.
+         */
+        class   MultiSplit : public Generic
+        {
+            public:
+                // The positions are timeline frames, the first ones of the pieces
+                MultiSplit( std::shared_ptr<SequenceWorkflow> const& workflow,
+                            const QUuid& uuid, QList<qint64> positions );
                 virtual void    internalRedo();
                 virtual void    internalUndo();
                 virtual void    retranslate();
             private:
                 std::shared_ptr<SequenceWorkflow> m_workflow;
                 std::shared_ptr<::Clip>           m_toSplit;
-                quint32                           m_trackId;
-                std::shared_ptr<::Clip>           m_newClip;
-                qint64                      m_newClipPos;
-                qint64                      m_newClipBegin;
-                qint64                      m_oldEnd;
+                QList<std::shared_ptr<::Clip>>    m_pieces;
+        };
+
+        /**
+         *  \brief  Replaces clips with a clip of the nested sequence they were copied to,
+         *          as a single undo step. \sa MainWorkflow::nestClips()
+         */
+        class   Nest : public Generic
+        {
+            public:
+                Nest( std::shared_ptr<SequenceWorkflow> const& workflow, const QList<QUuid>& uuids,
+                      const QUuid& sequenceUuid, quint32 trackId, qint64 pos );
+                virtual void    internalRedo();
+                virtual void    internalUndo();
+                virtual void    retranslate();
+                virtual void    release() override;
+
+                QStringList     newClips() const;
+
+            private:
+                std::unique_ptr<RemoveMany>     m_remove;
+                std::unique_ptr<AddMany>        m_add;
         };
 
         class   Link : public Generic
@@ -184,6 +414,37 @@ namespace Commands
                 QUuid     m_clipA;
                 QUuid     m_clipB;
         };
+
+        /**
+         *  \brief  Plays a clip, and the clip linked to it, at another speed, over the
+         *          same part of their media. \sa SequenceWorkflow::retimeClip()
+         */
+        class   Retime : public Generic
+        {
+            public:
+                Retime( std::shared_ptr<SequenceWorkflow> const& workflow, const QUuid& uuid,
+                        double speed, bool frameBlending );
+                virtual void    internalRedo();
+                virtual void    internalUndo();
+                virtual void    retranslate();
+
+            private:
+                struct Retiming
+                {
+                    QUuid       uuid;
+                    double      speed;
+                    bool        frameBlending;
+                    qint64      begin;
+                    qint64      end;
+                };
+                // Puts back the clips done so far as they were in from, if one fails
+                void            apply( const QList<Retiming>& to, const QList<Retiming>& from );
+
+            private:
+                std::shared_ptr<SequenceWorkflow> m_workflow;
+                QList<Retiming>             m_old;
+                QList<Retiming>             m_new;
+        };
     }
     namespace   Effect
     {
@@ -223,7 +484,14 @@ namespace Commands
                 virtual void        internalRedo();
                 virtual void        internalUndo();
                 virtual void        retranslate();
+#ifdef HAVE_GUI
+                virtual int         id() const override;
+                virtual bool        mergeWith( const QUndoCommand* command ) override;
+#endif
             private:
+                // Both the old and the new ranges render differently
+                void                notify();
+
                 std::shared_ptr<EffectHelper>       m_helper;
                 qint64              m_newBegin;
                 qint64              m_newEnd;
@@ -34,6 +34,8 @@
 #include "Backend/IBackend.h"
 #include <mlt++/MltProperties.h>
 
+#include <algorithm>
+
 QVariant
 conv( std::string str, SettingValue::Type type )
 {
@@ -123,6 +125,7 @@ EffectHelper::initParams()
                                          paramInfo->description().c_str(), flags );
 
         connect( val, &SettingValue::changed, this, [this, val]( const QVariant& variant ) { set( val, variant ); } );
+        loadKeyframes( val );
     }
 }
 
@@ -142,6 +145,9 @@ void
 EffectHelper::set( SettingValue* value, const QVariant& variant )
 {
     auto key = value->key();
+    // The animation wins over the static value
+    if ( m_keyframes.contains( key ) == true )
+        return;
 
     switch ( value->type() )
     {
@@ -158,6 +164,7 @@ EffectHelper::set( SettingValue* value, const QVariant& variant )
         m_filter->properties()->set( qPrintable( key ), qPrintable( variant.toString() ) );
         break;
     } ;
+    emit changed();
 }
 
 QVariant
@@ -182,12 +189,140 @@ EffectHelper::value( const QString& key )
     return m_settings.value( key );
 }
 
+bool
+EffectHelper::setKeyframe( const QString& key, qint64 pos, const QVariant& value )
+{
+    auto val = m_settings.value( key );
+    if ( val == nullptr || val->type() == SettingValue::String )
+        return false;
+    m_keyframes[key].keyframes.insert( pos, value );
+    updateKeyframes( key );
+    return true;
+}
+
+void
+EffectHelper::removeKeyframe( const QString& key, qint64 pos )
+{
+    auto it = m_keyframes.find( key );
+    if ( it == m_keyframes.end() || it->keyframes.remove( pos ) == 0 )
+        return;
+    updateKeyframes( key );
+}
+
+void
+EffectHelper::clearKeyframes( const QString& key )
+{
+    auto it = m_keyframes.find( key );
+    if ( it == m_keyframes.end() )
+        return;
+    it->keyframes.clear();
+    updateKeyframes( key );
+}
+
+QMap<qint64, QVariant>
+EffectHelper::keyframes( const QString& key ) const
+{
+    return m_keyframes.value( key ).keyframes;
+}
+
+QVariant
+EffectHelper::valueAt( const QString& key, qint64 pos )
+{
+    auto val = m_settings.value( key );
+    auto it = m_keyframes.find( key );
+    if ( it == m_keyframes.end() )
+        return val != nullptr ? val->get() : QVariant();
+
+    const auto& table = it->table;
+    // The last segment starting at or before pos, the first one before the animation
+    auto seg = std::upper_bound( table.cbegin(), table.cend(), pos,
+                                 []( qint64 p, const Segment& s ) { return p < s.begin; } );
+    if ( seg != table.cbegin() )
+        --seg;
+    auto v = seg->value + seg->slope * ( qMax( pos, seg->begin ) - seg->begin );
+    switch ( val->type() )
+    {
+    case SettingValue::Int:
+        return QVariant( qRound( v ) );
+    case SettingValue::Bool:
+        return QVariant( v != 0.0 );
+    default:
+        return QVariant( v );
+    }
+}
+
+void
+EffectHelper::updateKeyframes( const QString& key )
+{
+    auto val = m_settings.value( key );
+    auto it = m_keyframes.find( key );
+    if ( it->keyframes.isEmpty() == true )
+    {
+        m_keyframes.erase( it );
+        // Back to the static value
+        set( val, val->get() );
+        return;
+    }
+
+    auto discrete = val->type() == SettingValue::Bool;
+    auto& table = it->table;
+    table.clear();
+    table.reserve( it->keyframes.size() );
+    QString animation;
+    for ( auto k = it->keyframes.cbegin(); k != it->keyframes.cend(); ++k )
+    {
+        auto v = discrete == true ? ( k.value().toBool() ? 1.0 : 0.0 ) : k.value().toDouble();
+        if ( table.isEmpty() == false && discrete == false )
+        {
+            auto& previous = table.last();
+            previous.slope = ( v - previous.value ) / ( k.key() - previous.begin );
+        }
+        table.append( Segment{ k.key(), v, 0.0 } );
+        if ( animation.isEmpty() == false )
+            animation += ';';
+        animation += QString::number( k.key() ) + ( discrete == true ? "|=" : "=" ) +
+                ( val->type() == SettingValue::Double ? QString::number( v, 'g', 10 )
+                                                      : QString::number( qRound( v ) ) );
+    }
+    m_filter->properties()->set( qPrintable( key ), qPrintable( animation ) );
+    emit changed();
+}
+
+void
+EffectHelper::loadKeyframes( SettingValue* value )
+{
+    if ( value->type() == SettingValue::String )
+        return;
+    auto key = value->key();
+    QString animation( m_filter->properties()->get( qPrintable( key ) ) );
+    if ( animation.contains( '=' ) == false )
+        return;
+    auto& track = m_keyframes[key];
+    for ( const auto& item : animation.split( ';', QString::SkipEmptyParts ) )
+    {
+        auto sep = item.indexOf( '=' );
+        // Drop the interpolation mark, if any
+        auto pos = item.left( sep ).remove( '|' ).remove( '~' ).toLongLong();
+        auto v = item.mid( sep + 1 );
+        track.keyframes.insert( pos, value->type() == SettingValue::Bool ? QVariant( v.toInt() != 0 )
+                                                                         : QVariant( v.toDouble() ) );
+    }
+    updateKeyframes( key );
+}
+
 void
 EffectHelper::loadFromVariant( const QVariant& variant )
 {
     auto m = variant.toMap()["parameters"].toMap();
     for ( auto it = m.cbegin(); it != m.cend(); ++it )
         value( it.key() )->set( it.value() );
+    auto keyframes = variant.toMap()["keyframes"].toMap();
+    for ( auto it = keyframes.cbegin(); it != keyframes.cend(); ++it )
+    {
+        auto track = it.value().toMap();
+        for ( auto k = track.cbegin(); k != track.cend(); ++k )
+            setKeyframe( it.key(), k.key().toLongLong(), k.value() );
+    }
 }
 
 QVariant
@@ -199,12 +334,21 @@ EffectHelper::toVariant()
         auto val = value( QString::fromStdString( param->identifier() ) );
         h.insert( val->key(), val->get() );
     }
+    QVariantHash keyframes;
+    for ( auto it = m_keyframes.cbegin(); it != m_keyframes.cend(); ++it )
+    {
+        QVariantHash track;
+        for ( auto k = it->keyframes.cbegin(); k != it->keyframes.cend(); ++k )
+            track.insert( QString::number( k.key() ), k.value() );
+        keyframes.insert( it.key(), track );
+    }
     return QVariantHash{
         { "begin", begin() },
         { "end", end() },
         { "length", length() },
         { "identifier", identifier() },
-        { "parameters", h }
+        { "parameters", h },
+        { "keyframes", keyframes }
     };
 }
 
@@ -246,12 +390,14 @@ void
 EffectHelper::setBegin( qint64 begin )
 {
     m_filter->setBoundaries( begin, end() );
+    emit changed();
 }
 
 void
 EffectHelper::setEnd( qint64 end )
 {
     m_filter->setBoundaries( begin(), end );
+    emit changed();
 }
 
 qint64
@@ -264,6 +410,7 @@ void
 EffectHelper::setBoundaries( qint64 begin, qint64 end )
 {
     m_filter->setBoundaries( begin, end );
+    emit changed();
 }
 
 bool
@@ -24,8 +24,11 @@
 #ifndef EFFECTHELPER_H
 #define EFFECTHELPER_H
 
+#include <QHash>
+#include <QMap>
 #include <QObject>
 #include <QMetaType>
+#include <QVector>
 #include <memory>
 
 #include "Settings/Settings.h"
@@ -78,6 +81,23 @@ class   EffectHelper : public Workflow::Helper
 
         SettingValue*                   value( const QString& key );
 
+        /**
+         *  \brief  Animates a parameter: its value at pos, relative to the filter's begin.
+         *
+         *  Between two keyframes, numeric parameters are interpolated linearly, while
+         *  booleans keep the value of the previous one. Once a parameter has keyframes,
+         *  its value() is no longer applied.
+         *  \returns false if the parameter can't be animated, which is the case of strings.
+         */
+        bool                            setKeyframe( const QString& key, qint64 pos, const QVariant& value );
+        void                            removeKeyframe( const QString& key, qint64 pos );
+        void                            clearKeyframes( const QString& key );
+        QMap<qint64, QVariant>          keyframes( const QString& key ) const;
+        /**
+         *  \returns    The value of the parameter pos frames after the filter's begin.
+         */
+        QVariant                        valueAt( const QString& key, qint64 pos );
+
         // Handle one filter.
         void                            loadFromVariant( const QVariant& variant );
         QVariant                        toVariant();
@@ -86,15 +106,43 @@ class   EffectHelper : public Workflow::Helper
         static QVariant                 toVariant( Backend::IInput* input );
         static void                     loadFromVariant( const QVariant& variant, Backend::IInput* input );
 
+    private:
+        struct Segment
+        {
+            qint64  begin;
+            double  value;
+            // Per frame, 0 for discrete parameters
+            double  slope;
+        };
+
+        struct KeyframeTrack
+        {
+            QMap<qint64, QVariant>  keyframes;
+            // One segment per keyframe, sorted by position
+            QVector<Segment>        table;
+        };
+
     private:
         std::shared_ptr<Backend::MLT::MLTFilter>    m_filter;
         Backend::IFilterInfo*       m_filterInfo;
 
         Settings                    m_settings;
+        QHash<QString, KeyframeTrack>   m_keyframes;
 
         void                        set( SettingValue* value, const QVariant& variant );
+        /**
+         *  \brief  Rebuilds the interpolation table of key, and hands the keyframes to
+         *          the filter as an animation, which MLT parses once.
+         */
+        void                        updateKeyframes( const QString& key );
+        // Reads the keyframes back from an animated filter property
+        void                        loadKeyframes( SettingValue* value );
         QVariant                    defaultValue( const char* id, SettingValue::Type type );
         void                        initParams();
+
+    signals:
+        // The filter's parameters or boundaries changed
+        void                        changed();
 };
 
 Q_DECLARE_METATYPE( Backend::IFilter* );
@@ -48,6 +48,10 @@ ClipProperty::ClipProperty( Clip* clip, QWidget *parent ) :
     setWindowTitle( m_clip->media()->fileInfo()->fileName() + " " + tr( "properties" ) );
     //Snapshot
     ui->snapshotLabel->setPixmap( m_clip->media()->snapshot().scaled( 128, 128, Qt::KeepAspectRatio ) );
+    connect( m_clip->media(), &Media::snapshotAvailable, this, [this]
+    {
+        ui->snapshotLabel->setPixmap( m_clip->media()->snapshot().scaled( 128, 128, Qt::KeepAspectRatio ) );
+    } );
     //Metatags
     const QPushButton* button = ui->buttonBox->button( QDialogButtonBox::Apply );
     Q_ASSERT( button != nullptr);
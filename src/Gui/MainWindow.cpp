@@ -25,9 +25,11 @@
 # include "config.h"
 #endif
 
+#include <QActionGroup>
 #include <QSizePolicy>
 #include <QDockWidget>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QSlider>
 #include <QMessageBox>
 #include <QDesktopServices>
@@ -43,6 +45,9 @@
 #include "Tools/VlmcLogger.h"
 #include "Backend/IBackend.h"
 #include "Workflow/MainWorkflow.h"
+#include "Workflow/Consolidation.h"
+#include "Workflow/RenderJob.h"
+#include "Workflow/TimelineImport.h"
 #include "Renderer/ClipRenderer.h"
 #include "Commands/AbstractUndoStack.h"
 
@@ -51,17 +56,23 @@
 #include "About.h"
 #include "export/RendererSettings.h"
 #include "export/ShareOnInternet.h"
+#include "WorkflowFileRendererDialog.h"
 #include "settings/SettingsDialog.h"
 
 /* Widgets */
 #include "effectsengine/EffectsListView.h"
 #include "import/ImportController.h"
 #include "library/MediaLibrary.h"
+#include "widgets/MemoryWidget.h"
 #include "widgets/NotificationZone.h"
 #include "preview/PreviewWidget.h"
+#include "preview/ScopesWidget.h"
+#include "preview/AudioMetersWidget.h"
+#include "preview/MulticamWidget.h"
 #include "timeline/Timeline.h"
 
 /* Settings / Preferences */
+#include "Project/ProjectManager.h"
 #include "Project/RecentProjects.h"
 #include "wizard/ProjectWizard.h"
 #include "Settings/Settings.h"
@@ -81,12 +92,14 @@ MainWindow::MainWindow( Backend::IBackend* backend, QWidget *parent )
     initVlmcPreferences();
     //All preferences have been created: restore them:
     Core::instance()->settings()->load();
+    VlmcLogger::startupPhase( "Main window: preferences" );
 
     // GUI
     createGlobalPreferences();
     initToolbar();
     createStatusBar();
     initializeDockWidgets();
+    VlmcLogger::startupPhase( "Main window: docks" );
     checkFolders();
     loadGlobalProxySettings();
     createProjectPreferences();
@@ -96,24 +109,22 @@ MainWindow::MainWindow( Backend::IBackend* backend, QWidget *parent )
     setupCrashTester();
 #endif
 
-    connect( Core::instance()->project(), SIGNAL( projectNameChanged(QString) ),
-             this, SLOT( projectNameChanged( QString ) ) );
-    connect( Core::instance()->project(), SIGNAL( outdatedBackupFileFound() ),
-             this, SLOT( onOudatedBackupFile() ) );
-    connect( Core::instance()->project(), SIGNAL( backupProjectLoaded() ),
-             this, SLOT( onBackupFileLoaded() ) );
-    connect( Core::instance()->project(), SIGNAL( projectSaved() ),
-             this, SLOT( onProjectSaved() ) );
-    connect( Core::instance()->project(), &Project::cleanStateChanged,
-             this, &MainWindow::cleanStateChanged );
+    connectProject();
     connect( Core::instance()->recentProjects(), &RecentProjects::updated,
              this, &MainWindow::updateRecentProjects );
+    auto projectManager = Core::instance()->projectManager();
+    connect( projectManager, &ProjectManager::aboutToSwitch, this, &MainWindow::projectAboutToSwitch );
+    connect( projectManager, &ProjectManager::activeChanged, this, &MainWindow::projectActivated );
+    connect( projectManager, &ProjectManager::sessionsChanged, this, &MainWindow::updateOpenProjects );
+    updateOpenProjects();
 
     //Connecting Library stuff:
     const ClipRenderer* clipRenderer = qobject_cast<const ClipRenderer*>( m_clipPreview->getAbstractRenderer() );
     Q_ASSERT( clipRenderer != nullptr );
     connect( m_mediaLibrary, SIGNAL( clipSelected( Clip* ) ),
              clipRenderer, SLOT( setClip( Clip* ) ) );
+    connect( m_mediaLibrary, SIGNAL( prefetchRequested( Clip* ) ),
+             clipRenderer, SLOT( prefetch( Clip* ) ) );
     connect( m_mediaLibrary, SIGNAL( importRequired() ),
              this, SLOT( on_actionImport_triggered() ) );
 
@@ -136,6 +147,102 @@ MainWindow::~MainWindow()
     delete m_timeline;
 }
 
+void
+MainWindow::connectProject()
+{
+    auto project = Core::instance()->project();
+    auto workflow = Core::instance()->workflow();
+    connect( project, SIGNAL( projectNameChanged(QString) ),
+             this, SLOT( projectNameChanged( QString ) ) );
+    connect( project, SIGNAL( outdatedBackupFileFound() ),
+             this, SLOT( onOudatedBackupFile() ) );
+    connect( project, SIGNAL( backupProjectLoaded() ),
+             this, SLOT( onBackupFileLoaded() ) );
+    connect( project, SIGNAL( projectSaved() ),
+             this, SLOT( onProjectSaved() ) );
+    connect( project, &Project::cleanStateChanged,
+             this, &MainWindow::cleanStateChanged );
+    connect( workflow, &MainWorkflow::consolidationProgress, this, []( int done, int total ) {
+        NotificationZone::instance()->progressUpdated( (float)done / total );
+    } );
+    connect( workflow, &MainWorkflow::consolidationFinished,
+             this, &MainWindow::consolidationFinished );
+    connect( workflow, &MainWorkflow::stillExportProgress, this, []( int done, int total ) {
+        NotificationZone::instance()->progressUpdated( (float)done / total );
+    } );
+    connect( workflow, &MainWorkflow::stillsExported,
+             this, &MainWindow::stillsExported );
+
+    auto stack = workflow->undoStack();
+    connect( stack, SIGNAL( canUndoChanged( bool ) ), this, SLOT( canUndoChanged( bool ) ) );
+    connect( stack, SIGNAL( canRedoChanged( bool ) ), this, SLOT( canRedoChanged( bool ) ) );
+    canUndoChanged( stack->canUndo() );
+    canRedoChanged( stack->canRedo() );
+    m_undoView->setStack( stack );
+
+    connect( Core::instance()->library(), SIGNAL( clipRemoved( const QUuid& ) ),
+             m_clipPreview->getAbstractRenderer(), SLOT( clipUnloaded( const QUuid& ) ) );
+}
+
+void
+MainWindow::projectAboutToSwitch()
+{
+    auto workflow = Core::instance()->workflow();
+    Core::instance()->project()->disconnect( this );
+    workflow->disconnect( this );
+    workflow->undoStack()->disconnect( this );
+    auto clipRenderer = qobject_cast<ClipRenderer*>( m_clipPreview->getAbstractRenderer() );
+    Core::instance()->library()->disconnect( clipRenderer );
+    // The clip belongs to the library of the previous project
+    clipRenderer->setClip( nullptr );
+}
+
+void
+MainWindow::projectActivated()
+{
+    auto project = Core::instance()->project();
+    auto workflow = Core::instance()->workflow();
+    connectProject();
+    m_projectPreview->setRenderer( workflow->renderer() );
+    m_audioMeters->setMeters( workflow->audioMeters() );
+    m_timeline->setWorkflow( workflow );
+    m_mediaLibrary->setLibrary( Core::instance()->library() );
+    // The dialog edits the settings of a single project
+    delete m_projectPreferences;
+    createProjectPreferences();
+    projectNameChanged( project->name() );
+    setWindowModified( project->isClean() == false );
+    updateOpenProjects();
+}
+
+void
+MainWindow::updateOpenProjects()
+{
+    auto projectManager = Core::instance()->projectManager();
+    auto menu = new QMenu( this );
+    auto group = new QActionGroup( menu );
+    for ( int i = 0; i < projectManager->count(); ++i )
+    {
+        auto project = projectManager->session( i ).project;
+        auto action = menu->addAction( project->hasProjectFile() == true ?
+                                           QString( "%1 - %2" ).arg( project->name() ).arg( project->fileName() ) :
+                                           project->name() );
+        action->setCheckable( true );
+        action->setChecked( i == projectManager->activeIndex() );
+        group->addAction( action );
+        connect( action, &QAction::triggered, this, [projectManager, i]()
+        {
+            projectManager->activate( i );
+        } );
+    }
+    // The previous menu may be the one whose action switched the project
+    if ( m_ui.actionOpen_Projects->menu() != nullptr )
+        m_ui.actionOpen_Projects->menu()->deleteLater();
+    m_ui.actionOpen_Projects->setMenu( menu );
+    m_ui.actionClose_Project->setEnabled( projectManager->count() > 1 ||
+                                          Core::instance()->project()->hasProjectFile() == true );
+}
+
 void
 MainWindow::showWizard()
 {
@@ -155,6 +262,9 @@ MainWindow::retranslateUi()
     m_dockedLibrary->setWindowTitle( tr( "Media Library" ) );
     m_dockedClipPreview->setWindowTitle( tr( "Clip Preview" ) );
     m_dockedProjectPreview->setWindowTitle( tr( "Project Preview" ) );
+    m_dockedScopes->setWindowTitle( tr( "Scopes" ) );
+    m_dockedAudioMeters->setWindowTitle( tr( "Audio Meters" ) );
+    m_dockedMulticam->setWindowTitle( tr( "Multicam" ) );
 }
 
 void
@@ -197,6 +307,16 @@ MainWindow::initVlmcPreferences()
                                      QT_TRANSLATE_NOOP( "PreferenceWidget", "Render preview" ),
                                      QT_TRANSLATE_NOOP( "PreferenceWidget", "Preview the project, or pause the current preview" ) );
 
+    VLMC_CREATE_PREFERENCE_KEYBOARD( "keyboard/shuttlereverse", "J",
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Shuttle backward" ),
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Play the project backward, faster each time it is pressed" ) );
+    VLMC_CREATE_PREFERENCE_KEYBOARD( "keyboard/shuttlepause", "K",
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Shuttle pause" ),
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Pause the project preview" ) );
+    VLMC_CREATE_PREFERENCE_KEYBOARD( "keyboard/shuttleforward", "L",
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Shuttle forward" ),
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Play the project forward, faster each time it is pressed" ) );
+
     //A bit nasty, but we better use what Qt's providing as default shortcut
     CREATE_MENU_SHORTCUT( "keyboard/undo",
                           QKeySequence( QKeySequence::Undo ).toString().toLocal8Bit(),
@@ -401,6 +521,45 @@ MainWindow::on_actionLoad_Project_triggered()
     Core::instance()->loadProject( fileName );
 }
 
+void
+MainWindow::on_actionOpen_Project_Alongside_triggered()
+{
+    QString folder = VLMC_GET_STRING( "vlmc/WorkspaceLocation" );
+    QString fileName = QFileDialog::getOpenFileName( nullptr, tr( "Please choose a project file" ),
+                                    folder, tr( "VLMC project file(*.vlmc)" ) );
+    if ( fileName.isEmpty() == true )
+        return ;
+    if ( Core::instance()->openProject( fileName ) == false )
+        QMessageBox::warning( this, tr( "Can't open the project" ),
+                              tr( "%1 can't be opened next to the current project. The projects open "
+                                  "at once must have the same frame rate and resolution." ).arg( fileName ) );
+}
+
+void
+MainWindow::on_actionClose_Project_triggered()
+{
+    if ( Core::instance()->project()->isClean() == false )
+    {
+        QMessageBox msgBox;
+        msgBox.setText( QObject::tr( "The project has been modified." ) );
+        msgBox.setInformativeText( QObject::tr( "Do you want to save it?" ) );
+        msgBox.setStandardButtons( QMessageBox::Save | QMessageBox::Discard | QMessageBox::Cancel );
+        msgBox.setDefaultButton( QMessageBox::Save );
+        switch ( msgBox.exec() )
+        {
+        case QMessageBox::Save:
+            on_actionSave_triggered();
+            break;
+        case QMessageBox::Discard:
+            break;
+        case QMessageBox::Cancel:
+            return;
+        }
+    }
+    auto projectManager = Core::instance()->projectManager();
+    projectManager->close( projectManager->activeIndex() );
+}
+
 void
 MainWindow::createNotificationZone()
 {
@@ -468,7 +627,10 @@ MainWindow::initializeDockWidgets()
     setupEffectsList();
     setupClipPreview();
     setupProjectPreview();
+    setupScopes();
+    setupAudioMeters();
     setupUndoRedoWidget();
+    setupMemoryWidget();
 }
 
 void
@@ -477,12 +639,6 @@ MainWindow::setupUndoRedoWidget()
     m_undoView = new QUndoView;
     m_undoView->setObjectName( QStringLiteral( "History" ) );
     m_dockedUndoView = dockWidget( m_undoView, Qt::TopDockWidgetArea );
-    auto stack = Core::instance()->workflow()->undoStack();
-    connect( stack, SIGNAL( canUndoChanged( bool ) ), this, SLOT( canUndoChanged( bool ) ) );
-    connect( stack, SIGNAL( canRedoChanged( bool ) ), this, SLOT( canRedoChanged( bool ) ) );
-    canUndoChanged( stack->canUndo() );
-    canRedoChanged( stack->canRedo() );
-    m_undoView->setStack( stack );
 }
 
 void
@@ -506,12 +662,11 @@ MainWindow::setupClipPreview()
     auto renderer = new ClipRenderer;
     renderer->setParent( m_clipPreview );
     m_clipPreview->setRenderer( renderer );
-    connect( Core::instance()->library(), SIGNAL( clipRemoved( const QUuid& ) ),
-             renderer, SLOT( clipUnloaded( const QUuid& ) ) );
 
     KeyboardShortcutHelper* clipShortcut = new KeyboardShortcutHelper( "keyboard/mediapreview", this );
     connect( clipShortcut, SIGNAL( activated() ), m_clipPreview, SLOT( on_pushButtonPlay_clicked() ) );
     m_dockedClipPreview = dockWidget( m_clipPreview, Qt::TopDockWidgetArea );
+    setupMulticam( renderer );
 }
 
 void
@@ -522,9 +677,50 @@ MainWindow::setupProjectPreview()
     m_projectPreview->setRenderer( Core::instance()->workflow()->renderer() );
     KeyboardShortcutHelper* renderShortcut = new KeyboardShortcutHelper( "keyboard/renderpreview", this );
     connect( renderShortcut, SIGNAL( activated() ), m_projectPreview, SLOT( on_pushButtonPlay_clicked() ) );
+    auto shuttleReverse = new KeyboardShortcutHelper( "keyboard/shuttlereverse", this );
+    connect( shuttleReverse, SIGNAL( activated() ), m_projectPreview, SLOT( shuttleReverse() ) );
+    auto shuttlePause = new KeyboardShortcutHelper( "keyboard/shuttlepause", this );
+    connect( shuttlePause, SIGNAL( activated() ), m_projectPreview, SLOT( shuttlePause() ) );
+    auto shuttleForward = new KeyboardShortcutHelper( "keyboard/shuttleforward", this );
+    connect( shuttleForward, SIGNAL( activated() ), m_projectPreview, SLOT( shuttleForward() ) );
     m_dockedProjectPreview = dockWidget( m_projectPreview, Qt::TopDockWidgetArea );
 }
 
+void
+MainWindow::setupScopes()
+{
+    m_scopes = new ScopesWidget( m_projectPreview );
+    m_dockedScopes = dockWidget( m_scopes, Qt::TopDockWidgetArea );
+    // Computing the scopes has a cost, only do it once they are asked for
+    m_dockedScopes->hide();
+}
+
+void
+MainWindow::setupAudioMeters()
+{
+    m_audioMeters = new AudioMetersWidget( Core::instance()->workflow()->audioMeters() );
+    m_dockedAudioMeters = dockWidget( m_audioMeters, Qt::TopDockWidgetArea );
+    m_dockedAudioMeters->hide();
+}
+
+void
+MainWindow::setupMulticam( ClipRenderer* renderer )
+{
+    m_multicam = new MulticamWidget( renderer );
+    m_dockedMulticam = dockWidget( m_multicam, Qt::TopDockWidgetArea );
+    // The angles are only decoded while shown
+    m_dockedMulticam->hide();
+}
+
+void
+MainWindow::setupMemoryWidget()
+{
+    auto memory = new MemoryWidget;
+    m_dockedMemory = dockWidget( memory, Qt::RightDockWidgetArea );
+    // A debug view, for sizing the caches and tracking leaks
+    m_dockedMemory->hide();
+}
+
 void
 MainWindow::initToolbar()
 {
@@ -633,13 +829,18 @@ MainWindow::checkVideoLength()
     return true;
 }
 
-bool
+RenderJob*
 MainWindow::renderVideoSettings( bool shareOnInternet )
 {
     RendererSettings settings( shareOnInternet );
+    qint64      begin;
+    qint64      end;
+    bool        region = m_projectPreview->markedRegion( begin, end );
+    if ( region == true )
+        settings.setRegion( begin, end );
 
     if ( settings.exec() == QDialog::Rejected )
-        return false;
+        return nullptr;
 
     QString     outputFileName = settings.outputFileName();
     quint32     width          = settings.width();
@@ -652,9 +853,23 @@ MainWindow::renderVideoSettings( bool shareOnInternet )
     auto        sampleRate     = settings.sampleRate();
 
 
-    return  Core::instance()->workflow()->startRenderToFile( outputFileName, width, height,
-                                                             fps, ar, vbitrate, abitrate,
-                                                             nbChannels, sampleRate );
+    if ( settings.exportsRegion() == false )
+    {
+        begin = 0;
+        end = -1;
+    }
+    // A shared video is uploaded while it's being rendered
+    auto job = Core::instance()->workflow()->startRenderToFile( outputFileName, width, height,
+                                                                fps, ar, vbitrate, abitrate,
+                                                                nbChannels, sampleRate, begin, end,
+                                                                shareOnInternet );
+    if ( job == nullptr )
+        return nullptr;
+
+    auto dialog = new WorkflowFileRendererDialog( width, height, job );
+    dialog->setOutputFileName( outputFileName );
+    dialog->show();
+    return job;
 }
 
 QDockWidget*
@@ -690,7 +905,8 @@ MainWindow::on_actionShare_On_Internet_triggered()
 {
     if ( checkVideoLength() )
     {
-        if( !renderVideoSettings( true ) )
+        auto job = renderVideoSettings( true );
+        if ( job == nullptr )
             return;
 
         checkFolders();
@@ -700,16 +916,13 @@ MainWindow::on_actionShare_On_Internet_triggered()
 
         loadGlobalProxySettings();
 
-        ShareOnInternet *shareVideo = new ShareOnInternet();
-        shareVideo->setVideoFile( fileName );
-
-        if ( shareVideo->exec() == QDialog::Rejected )
-        {
-            delete shareVideo;
-            return;
-        }
-
-        delete shareVideo;
+        // The upload follows the export, which is fragmented so that it can be read
+        // while it's being written
+        ShareOnInternet shareVideo;
+        shareVideo.setVideoFile( fileName );
+        shareVideo.setFileGrowing( true );
+        connect( job, &RenderJob::finished, &shareVideo, &ShareOnInternet::renderFinished );
+        shareVideo.exec();
     }
 }
 
@@ -920,6 +1133,107 @@ MainWindow::on_actionImport_triggered()
     m_importController->exec();
 }
 
+void
+MainWindow::on_actionImport_Timeline_triggered()
+{
+    auto fileName = QFileDialog::getOpenFileName( this, tr( "Please choose a timeline" ),
+                                                  QString(), TimelineImport::nameFilter() );
+    if ( fileName.isEmpty() == true )
+        return ;
+    QString error;
+    if ( Core::instance()->workflow()->importTimeline( fileName, &error ) == false )
+        QMessageBox::warning( this, tr( "Import Timeline" ),
+                              tr( "Couldn't import %1: %2" ).arg( QFileInfo( fileName ).fileName(), error ) );
+}
+
+void
+MainWindow::on_actionConsolidate_Project_triggered()
+{
+    if ( m_consolidatedProject.isEmpty() == false )
+        return;
+    auto dest = QFileDialog::getSaveFileName( this, tr( "Enter the consolidated project file name" ),
+                                              VLMC_GET_STRING( "vlmc/WorkspaceLocation" ),
+                                              tr( "VLMC project file(*.vlmc)" ) );
+    if ( dest.isEmpty() == true )
+        return;
+    if ( dest.endsWith( ".vlmc" ) == false )
+        dest += ".vlmc";
+    // The medias go next to the project
+    auto directory = QFileInfo( dest ).absolutePath() + "/media";
+    auto handles = qRound64( Core::instance()->project()->fps() * Consolidation::DefaultHandles );
+    if ( Core::instance()->workflow()->consolidate( directory, handles ) == false )
+    {
+        QMessageBox::warning( this, tr( "Consolidate Project" ),
+                              tr( "The medias couldn't be copied to %1." ).arg( directory ) );
+        return;
+    }
+    m_consolidatedProject = dest;
+    NotificationZone::instance()->notify( tr( "Consolidating the project medias..." ) );
+}
+
+void
+MainWindow::consolidationFinished( bool success )
+{
+    auto dest = m_consolidatedProject;
+    m_consolidatedProject.clear();
+    if ( success == false )
+    {
+        QMessageBox::warning( this, tr( "Consolidate Project" ),
+                              tr( "The medias couldn't be consolidated. The project still uses the original ones." ) );
+        return;
+    }
+    Core::instance()->project()->saveAs( dest );
+    NotificationZone::instance()->notify( tr( "Project consolidated to " ) + dest );
+}
+
+void
+MainWindow::on_actionExport_Frame_triggered()
+{
+    exportStills( false );
+}
+
+void
+MainWindow::on_actionExport_Marker_Frames_triggered()
+{
+    exportStills( true );
+}
+
+void
+MainWindow::exportStills( bool markers )
+{
+    auto dest = QFileDialog::getSaveFileName( this, tr( "Enter the image file name" ),
+                                              VLMC_GET_STRING( "vlmc/WorkspaceLocation" ),
+                                              tr( "PNG image (*.png);;JPEG image (*.jpg)" ) );
+    if ( dest.isEmpty() == true )
+        return;
+    if ( QFileInfo( dest ).suffix().isEmpty() == true )
+        dest += ".png";
+    auto workflow = Core::instance()->workflow();
+    auto started = markers == true ? workflow->exportMarkerFrames( dest ) : workflow->exportFrame( dest );
+    if ( started == false )
+    {
+        QMessageBox::warning( this, tr( "Export Frames" ),
+                              markers == true ? tr( "The frames at the markers couldn't be exported to %1." ).arg( dest )
+                                              : tr( "The frame couldn't be exported to %1." ).arg( dest ) );
+        return;
+    }
+    NotificationZone::instance()->notify( tr( "Exporting the frames..." ) );
+}
+
+void
+MainWindow::stillsExported( bool success, const QStringList& fileNames )
+{
+    if ( success == false )
+    {
+        QMessageBox::warning( this, tr( "Export Frames" ), tr( "Some frames couldn't be exported." ) );
+        return;
+    }
+    if ( fileNames.size() == 1 )
+        NotificationZone::instance()->notify( tr( "Frame exported to " ) + fileNames.first() );
+    else
+        NotificationZone::instance()->notify( tr( "%1 frames exported" ).arg( fileNames.size() ) );
+}
+
 void
 MainWindow::canUndoChanged( bool canUndo )
 {
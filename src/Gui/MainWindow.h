@@ -41,6 +41,11 @@ class   MediaLibrary;
 class   PreviewWidget;
 class   Project;
 class   ProjectWizard;
+class   RenderJob;
+class   ScopesWidget;
+class   ClipRenderer;
+class   MulticamWidget;
+class   AudioMetersWidget;
 class   SettingsDialog;
 class   Timeline;
 class   WorkflowRenderer;
@@ -79,6 +84,8 @@ private:
     void        createNotificationZone();
     void        createGlobalPreferences();
     void        createProjectPreferences();
+    // Connects the window to the active project, its workflow and its library
+    void        connectProject();
     void        clearTemporaryFiles();
     void        initVlmcPreferences();
     void        loadGlobalProxySettings();
@@ -87,6 +94,11 @@ private:
     void        setupLibrary();
     void        setupClipPreview();
     void        setupProjectPreview();
+    void        setupScopes();
+    void        setupAudioMeters();
+    // The angle viewer follows the clip preview
+    void        setupMulticam( ClipRenderer* renderer );
+    void        setupMemoryWidget();
     void        setupEffectsList();
     void        setupUndoRedoWidget();
     void        retranslateUi();
@@ -112,10 +124,10 @@ private:
      *  \brief  Gets video parameters from RendererSettings Dialog
      *          exportType when set to true, renders video to user defined location
      *          and when set to false, renders video to temporary folder.
-     *  \return same as renderVideo(),
-     *          true if video renders well or not cancelled by the user.
+     *  \return The running job, or nullptr if the export was cancelled or
+     *          couldn't be started.
      */
-    bool        renderVideoSettings( bool exportType );
+    RenderJob*  renderVideoSettings( bool exportType );
 
     QDockWidget* dockWidget( QWidget* widget, Qt::DockWidgetArea startArea );
 
@@ -133,11 +145,20 @@ private:
     MediaLibrary            *m_mediaLibrary;
     EffectsListView*        m_effectsList;
     QUndoView*              m_undoView;
+    ScopesWidget*           m_scopes;
+    AudioMetersWidget*      m_audioMeters;
+    MulticamWidget*         m_multicam;
     QDockWidget*            m_dockedUndoView;
     QDockWidget*            m_dockedEffectsList;
     QDockWidget*            m_dockedLibrary;
     QDockWidget*            m_dockedClipPreview;
     QDockWidget*            m_dockedProjectPreview;
+    QDockWidget*            m_dockedScopes;
+    QDockWidget*            m_dockedAudioMeters;
+    QDockWidget*            m_dockedMulticam;
+    QDockWidget*            m_dockedMemory;
+    // Where the project gets saved once its medias are consolidated
+    QString                 m_consolidatedProject;
 
 private slots:
     void                    on_actionFullscreen_triggered( bool checked );
@@ -148,6 +169,8 @@ private slots:
     void                    on_actionShare_On_Internet_triggered();
     void                    on_actionNew_Project_triggered();
     void                    on_actionLoad_Project_triggered();
+    void                    on_actionOpen_Project_Alongside_triggered();
+    void                    on_actionClose_Project_triggered();
     void                    on_actionSave_triggered();
     void                    on_actionSave_As_triggered();
     void                    on_actionHelp_triggered();
@@ -156,8 +179,19 @@ private slots:
     void                    on_actionRedo_triggered();
     void                    on_actionCrash_triggered();
     void                    on_actionImport_triggered();
+    void                    on_actionImport_Timeline_triggered();
+    void                    on_actionConsolidate_Project_triggered();
+    void                    consolidationFinished( bool success );
+    void                    on_actionExport_Frame_triggered();
+    void                    on_actionExport_Marker_Frames_triggered();
+    void                    stillsExported( bool success, const QStringList& fileNames );
     void                    toolButtonClicked( QAction *action );
+    // Asks where to save the images, and starts exporting them
+    void                    exportStills( bool markers );
     void                    updateRecentProjects();
+    void                    updateOpenProjects();
+    void                    projectAboutToSwitch();
+    void                    projectActivated();
     void                    projectNameChanged(const QString& projectName);
     void                    cleanStateChanged( bool isClean );
     void                    canUndoChanged( bool canUndo );
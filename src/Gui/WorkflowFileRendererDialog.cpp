@@ -29,28 +29,52 @@
 
 #include "Main/Core.h"
 #include "Project/Project.h"
+#include "Settings/Settings.h"
 #include "vlmc.h"
 #include "Workflow/MainWorkflow.h"
-#include "Tools/RendererEventWatcher.h"
-#include "Backend/IInput.h"
+#include "Workflow/RenderJob.h"
+#include "Workflow/RenderQueue.h"
 
 WorkflowFileRendererDialog::WorkflowFileRendererDialog( quint32 width, quint32 height,
-                                                        qint64 totalFrames, RendererEventWatcher* eventWatcher ) :
+                                                        RenderJob* job ) :
         m_width( width ),
         m_height( height ),
-        m_totalFrames( totalFrames )
+        m_totalFrames( job->totalFrames() )
 {
     m_ui.setupUi( this );
+    setAttribute( Qt::WA_DeleteOnClose );
     connect( m_ui.cancelButton, SIGNAL( clicked() ), this, SLOT( cancel() ) );
 
-    connect( eventWatcher, &RendererEventWatcher::positionChanged, this, &WorkflowFileRendererDialog::frameChanged );
+    if ( job->isRunning() == false )
+        m_ui.frameCounter->setText( tr( "Waiting for the other exports" ) );
+    connect( job, &RenderJob::started, this, [this, job]()
+    {
+        m_totalFrames = job->totalFrames();
+    } );
+    connect( job, &RenderJob::progress, this, &WorkflowFileRendererDialog::frameChanged );
+
+    auto interval = VLMC_GET_DOUBLE( "vlmc/RenderPreviewInterval" ) * job->parameters().fps;
+    if ( interval > 0 )
+    {
+        auto previewSize = QSize( m_width, m_height ).scaled( 400, 225, Qt::KeepAspectRatio );
+        m_ui.previewLabel->setMinimumSize( previewSize );
+        job->setPreview( previewSize, interval );
+        connect( job, &RenderJob::preview, this, &WorkflowFileRendererDialog::updatePreview );
+    }
+    else
+        m_ui.previewLabel->hide();
+    // Queued jobs are deleted without being started when cancelled
+    connect( job, &RenderJob::destroyed, this, &WorkflowFileRendererDialog::close );
+    connect( this, &WorkflowFileRendererDialog::stop, job, [job]()
+    {
+        Core::instance()->renderQueue()->cancel( job );
+    } );
 }
 
 void
 WorkflowFileRendererDialog::setOutputFileName( const QString& outputFileName )
 {
     m_ui.nameLabel->setText( outputFileName );
-    m_ui.previewLabel->setMinimumSize( m_width, m_height );
     setWindowTitle( "Rendering to " + outputFileName );
 }
 
@@ -61,11 +85,11 @@ WorkflowFileRendererDialog::setProgressBarValue( int val )
 }
 
 void
-WorkflowFileRendererDialog::updatePreview( const uchar* buff )
+WorkflowFileRendererDialog::updatePreview( const QImage& image )
 {
-    QImage img( buff, m_width, m_height,
-                QImage::Format_RGBA8888, []( void* buf ){ delete[] (uchar*) buf; } );
-    m_ui.previewLabel->setPixmap( QPixmap::fromImage( img ) );
+    if ( image.isNull() == true )
+        return;
+    m_ui.previewLabel->setPixmap( QPixmap::fromImage( image ) );
 }
 
 void
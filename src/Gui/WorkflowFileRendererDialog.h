@@ -26,14 +26,19 @@
 #include <QDialog>
 #include "ui/WorkflowFileRendererDialog.h"
 
-class   RendererEventWatcher;
+class   QImage;
+class   RenderJob;
 
 class   WorkflowFileRendererDialog : public QDialog
 {
     Q_OBJECT
     Q_DISABLE_COPY( WorkflowFileRendererDialog )
 public:
-    WorkflowFileRendererDialog( quint32 width, quint32 height, qint64 totalFrames, RendererEventWatcher* eventWatcher );
+    /**
+     *  \brief Follows job's progress, from the render queue. The dialog deletes
+     *         itself once closed.
+     */
+    WorkflowFileRendererDialog( quint32 width, quint32 height, RenderJob* job );
     void    setOutputFileName( const QString& filename );
     void    setProgressBarValue( int val );
 
@@ -47,10 +52,10 @@ signals:
     void    stop();
 
 public slots:
-    void    updatePreview( const uchar* buff );
+    void    updatePreview( const QImage& image );
+    void    frameChanged( qint64 );
 
 private slots:
-    void    frameChanged( qint64 );
     void    cancel();
 };
 
@@ -43,6 +43,7 @@
 
 EffectInstanceWidget::EffectInstanceWidget( QWidget *parent ) :
     QWidget( parent ),
+    m_populated( false ),
     m_ui( new Ui::EffectSettingWidget ),
     m_helper( nullptr )
 {
@@ -58,10 +59,26 @@ EffectInstanceWidget::setEffectHelper( std::shared_ptr<EffectHelper> const& help
     clear();
     m_helper = helper;
     m_ui->effectWidget->setFilterInfo( helper->filterInfo() );
+    if ( isVisible() == true )
+        populate();
+}
 
-    for ( auto param : helper->filterInfo()->paramInfos() )
+void
+EffectInstanceWidget::showEvent( QShowEvent* event )
+{
+    // An effect stack has a widget per filter, only the selected one gets shown
+    if ( m_populated == false && m_helper != nullptr )
+        populate();
+    QWidget::showEvent( event );
+}
+
+void
+EffectInstanceWidget::populate()
+{
+    m_populated = true;
+    for ( auto param : m_helper->filterInfo()->paramInfos() )
     {
-        SettingValue*               s = helper->value( QString::fromStdString( param->identifier() ) );
+        SettingValue*               s = m_helper->value( QString::fromStdString( param->identifier() ) );
         ISettingsCategoryWidget*    widget = widgetFactory( s );
         QLabel*                     label = new QLabel( tr( s->name() ), this );
         m_widgets.push_back( label );
@@ -80,6 +97,7 @@ EffectInstanceWidget::clear()
     m_settings.clear();
     qDeleteAll( m_widgets );
     m_widgets.clear();
+    m_populated = false;
 }
 
 ISettingsCategoryWidget*
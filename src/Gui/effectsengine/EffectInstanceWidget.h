@@ -43,11 +43,21 @@ class EffectInstanceWidget : public QWidget
 
     public:
         explicit EffectInstanceWidget( QWidget *parent = 0);
+        /**
+         *  \brief  Shows the filter. The widgets of its parameters are only built once
+         *          this gets shown.
+         */
         void     setEffectHelper( std::shared_ptr<EffectHelper> const& filter );
+
+    protected:
+        virtual void                        showEvent( QShowEvent* event ) override;
+
     private:
         ISettingsCategoryWidget*            widgetFactory( SettingValue *s );
         void                                clear();
+        void                                populate();
     private:
+        bool                                m_populated;
         QList<ISettingsCategoryWidget*>     m_settings;
         QList<QWidget*>                     m_widgets;
         Ui::EffectSettingWidget             *m_ui;
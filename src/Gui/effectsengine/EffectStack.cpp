@@ -34,6 +34,7 @@
 #include "EffectsEngine/EffectHelper.h"
 #include "EffectInstanceWidget.h"
 #include "EffectInstanceListModel.h"
+#include "EffectsListModel.h"
 
 #include <QStackedLayout>
 #include <QMessageBox>
@@ -54,8 +55,8 @@ EffectStack::EffectStack( Backend::IInput *input, QWidget *parent ):
     connect( m_ui->removeButton, SIGNAL( clicked() ), this, SLOT( remove() ) );
     connect( m_ui->addButton, SIGNAL( clicked() ), this, SLOT( add() ) );
 
-    for ( auto filter : Backend::instance()->availableFilters() )
-        m_ui->addComboBox->addItem( QString::fromStdString( filter.second->identifier() ) );
+    // Its popup fetches the filters as it scrolls, rather than reading them all now
+    m_ui->addComboBox->setModel( new EffectsListModel( m_ui->addComboBox ) );
 
     m_stackedLayout = new QStackedLayout;
     m_ui->horizontalLayout->addLayout( m_stackedLayout );
@@ -79,6 +80,7 @@ EffectStack::addEffectHelper( EffectHelper* helper )
     w->setEffectHelper( std::unique_ptr<EffectHelper>( helper ) );
     m_stackedLayout->addWidget( w );
     m_instanceWidgets[helper->identifier()] = w;
+    connect( helper, &EffectHelper::changed, this, &EffectStack::changed );
 }
 
 void
@@ -92,6 +94,7 @@ void
 EffectStack::moveUp()
 {
     m_model->moveUp( m_ui->list->currentIndex() );
+    emit changed();
     if ( m_ui->list->currentIndex().row() > 0 )
         m_ui->list->setCurrentIndex( m_ui->list->currentIndex().sibling( m_ui->list->currentIndex().row() - 1, 0 ) );
 }
@@ -100,6 +103,7 @@ void
 EffectStack::moveDown()
 {
     m_model->moveDown( m_ui->list->currentIndex() );
+    emit changed();
     if ( m_ui->list->currentIndex().row() < m_model->rowCount( QModelIndex() ) - 1 )
         m_ui->list->setCurrentIndex( m_ui->list->currentIndex().sibling( m_ui->list->currentIndex().row() + 1, 0 ) );
 }
@@ -108,6 +112,7 @@ void
 EffectStack::remove()
 {
     m_model->removeRow( m_ui->list->currentIndex().row() );
+    emit changed();
     if ( m_ui->list->currentIndex().isValid() == true )
         selectedChanged( m_ui->list->currentIndex() );
     else
@@ -122,5 +127,8 @@ EffectStack::add()
         QMessageBox::warning( this, tr( "An unexpected error has occurred" ),
                               tr( "We couldn't create an instance of '%1'.").arg( m_ui->addComboBox->currentText() ) );
     else
+    {
         addEffectHelper( helper );
+        emit changed();
+    }
 }
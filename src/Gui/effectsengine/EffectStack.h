@@ -67,6 +67,10 @@ class EffectStack : public QDialog
         Backend::IInput                 *m_input;
         QStackedLayout                  *m_stackedLayout;
         QHash<QString, EffectInstanceWidget*>   m_instanceWidgets;
+
+    signals:
+        // An effect of the input was added, removed, moved or edited
+        void        changed();
 };
 
 #endif // EFFECTSTACK_H
@@ -0,0 +1,103 @@
+/*****************************************************************************
+ * EffectsListModel.cpp: Lists the available filters, reading their metadata as they get shown
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "EffectsListModel.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IFilter.h"
+
+#include <QCoreApplication>
+
+EffectsListModel::EffectsListModel( QObject* parent )
+    : QAbstractListModel( parent )
+    , m_identifiers( Backend::instance()->filterIdentifiers() )
+    , m_next( 0 )
+    , m_gpu( Backend::instance()->gpuProcessing() )
+{
+}
+
+int
+EffectsListModel::rowCount( const QModelIndex& parent ) const
+{
+    if ( parent.isValid() == true )
+        return 0;
+    return (int)m_filters.size();
+}
+
+QVariant
+EffectsListModel::data( const QModelIndex& index, int role ) const
+{
+    if ( index.isValid() == false || index.row() >= (int)m_filters.size() )
+        return QVariant();
+    auto filter = m_filters[index.row()];
+    switch ( role )
+    {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        return QString::fromStdString( filter->identifier() );
+    case Qt::ToolTipRole:
+        if ( filter->isGpu() == false )
+            return QVariant();
+        return m_gpu == true ? QCoreApplication::translate( "EffectsListView", "Processed on the graphics card" )
+                             : QCoreApplication::translate( "EffectsListView", "Requires the GPU processing, enabled from the preferences" );
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags
+EffectsListModel::flags( const QModelIndex& index ) const
+{
+    auto flags = QAbstractListModel::flags( index );
+    // Movit filters don't render without the GPU processing
+    if ( index.isValid() == true && index.row() < (int)m_filters.size() &&
+         m_filters[index.row()]->isGpu() == true && m_gpu == false )
+        flags &= ~Qt::ItemIsEnabled;
+    return flags;
+}
+
+bool
+EffectsListModel::canFetchMore( const QModelIndex& parent ) const
+{
+    return parent.isValid() == false && m_next < m_identifiers.size();
+}
+
+void
+EffectsListModel::fetchMore( const QModelIndex& parent )
+{
+    if ( canFetchMore( parent ) == false )
+        return;
+    // Filters without metadata aren't meant to be used on their own. They're skipped
+    // until there's a full batch, so that the view gets rows to show every time.
+    std::vector<Backend::IFilterInfo*>  batch;
+    for ( ; m_next < m_identifiers.size() && batch.size() < BatchSize; ++m_next )
+    {
+        auto info = Backend::instance()->filterInfo( m_identifiers[m_next] );
+        if ( info != nullptr )
+            batch.push_back( info );
+    }
+    if ( batch.empty() == true )
+        return;
+    beginInsertRows( QModelIndex(), (int)m_filters.size(), (int)( m_filters.size() + batch.size() - 1 ) );
+    m_filters.insert( m_filters.end(), batch.begin(), batch.end() );
+    endInsertRows();
+}
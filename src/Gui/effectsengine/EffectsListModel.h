@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * EffectsListModel.h: Lists the available filters, reading their metadata as they get shown
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef EFFECTSLISTMODEL_H
+#define EFFECTSLISTMODEL_H
+
+#include <QAbstractListModel>
+
+#include <string>
+#include <vector>
+
+namespace Backend
+{
+class   IFilterInfo;
+}
+
+/**
+ *  \brief  The filters which can be added, fetched by the views as they scroll.
+ *
+ *  The identifiers are listed up front. Reading the metadata of a filter, which tells
+ *  whether it's meant to be used on its own, is only done when its row gets fetched:
+ *  BatchSize usable filters at a time, as the view scrolls to the last one fetched.
+ */
+class EffectsListModel : public QAbstractListModel
+{
+    public:
+        static const size_t BatchSize = 32;
+
+        explicit EffectsListModel( QObject* parent = nullptr );
+
+        virtual int             rowCount( const QModelIndex& parent = QModelIndex() ) const override;
+        virtual QVariant        data( const QModelIndex& index, int role ) const override;
+        virtual Qt::ItemFlags   flags( const QModelIndex& index ) const override;
+        virtual bool            canFetchMore( const QModelIndex& parent ) const override;
+        virtual void            fetchMore( const QModelIndex& parent ) override;
+
+    private:
+        const std::vector<std::string>      m_identifiers;
+        // The next identifier to fetch
+        size_t                              m_next;
+        std::vector<Backend::IFilterInfo*>  m_filters;
+        const bool                          m_gpu;
+};
+
+#endif // EFFECTSLISTMODEL_H
@@ -28,12 +28,12 @@
 #include "Backend/IBackend.h"
 #include "Backend/IFilter.h"
 #include "EffectsListView.h"
+#include "EffectsListModel.h"
 #include "EffectWidget.h"
 
 #include <QApplication>
 #include <QDialog>
 #include <QMouseEvent>
-#include <QStandardItem>
 #include <QVBoxLayout>
 #include <QMimeData>
 #include <QDrag>
@@ -41,15 +41,13 @@
 EffectsListView::EffectsListView( QWidget *parent ) :
     QListView(parent)
 {
-    m_model = new QStandardItemModel( this );
+    // Listing the filters reads their metadata, which is only done for the rows seen
+    m_model = new EffectsListModel( this );
     setModel( m_model );
     connect( this, SIGNAL( activated( QModelIndex ) ),
              this, SLOT( effectActivated( QModelIndex ) ) );
     setEditTriggers( QAbstractItemView::NoEditTriggers );
     setObjectName( QStringLiteral( "Effects List" ) );
-
-    for ( auto filter : Backend::instance()->availableFilters() )
-        m_model->appendRow( new QStandardItem( QString::fromStdString( filter.second->identifier() ) ) );
 }
 
 void
@@ -84,6 +82,8 @@ EffectsListView::effectActivated( const QModelIndex &index ) const
     if ( index.isValid() == false )
         return ;
     auto filterInfo = Backend::instance()->filterInfo( m_model->data( index, Qt::DisplayRole ).toString().toStdString() );
+    if ( filterInfo == nullptr )
+        return ;
 
     QDialog         *dialog = new QDialog();
     QVBoxLayout     *layout = new QVBoxLayout( dialog );
@@ -26,7 +26,7 @@
 
 #include <QListView>
 
-class   QStandardItemModel;
+class   EffectsListModel;
 
 class EffectsListView : public QListView
 {
@@ -40,7 +40,7 @@ class EffectsListView : public QListView
         void                mouseMoveEvent( QMouseEvent *event );
 
     private:
-        QStandardItemModel  *m_model;
+        EffectsListModel    *m_model;
         QPoint              m_dragStartPos;
 
     private slots:
@@ -25,6 +25,8 @@
 #endif
 
 #include "Media/Media.h"
+#include "Project/Project.h"
+#include "Workflow/EncoderProbe.h"
 #include "RendererSettings.h"
 #include "Settings/Settings.h"
 
@@ -36,6 +38,7 @@
 #include <QSslSocket>
 
 RendererSettings::RendererSettings( bool shareOnInternet )
+    : m_regionBox( nullptr )
 {
     m_ui.setupUi( this );
     auto project = Core::instance()->project();
@@ -59,6 +62,20 @@ RendererSettings::RendererSettings( bool shareOnInternet )
     m_ui.nbChannels->setValue( project->nbChannels() );
     m_ui.sampleRate->setValue( project->sampleRate() );
 
+    // Hardware encoders are only offered once they are known to work
+    for ( const auto& codec : Core::instance()->encoderProbe()->hardwareEncoders() )
+        m_ui.videoCodec->addItem( codec );
+
+    auto encoder = project->encoderOptions();
+    if ( encoder.videoCodec.empty() == false )
+        m_ui.videoCodec->setCurrentText( QString::fromStdString( encoder.videoCodec ) );
+    if ( encoder.preset.empty() == false )
+        m_ui.encoderPreset->setCurrentText( QString::fromStdString( encoder.preset ) );
+    m_ui.encoderThreads->setValue( encoder.encoderThreads );
+    m_ui.renderThreads->setValue( encoder.renderThreads );
+    m_ui.gopSize->setValue( encoder.gopSize );
+    m_ui.dropFrames->setChecked( encoder.dropFrames );
+
     QCompleter* completer = new QCompleter( this );
     completer->setModel( new QDirModel( completer ) );
     m_ui.outputFileName->setCompleter( completer );
@@ -147,9 +164,32 @@ RendererSettings::accept()
             return;
     }
 
+    // The encoder knobs are remembered by the project
+    Core::instance()->project()->setEncoderOptions( encoderOptions() );
     QDialog::accept();
 }
 
+void
+RendererSettings::setRegion( qint64 begin, qint64 end )
+{
+    if ( m_regionBox == nullptr )
+    {
+        m_regionBox = new QCheckBox( this );
+        m_regionBox->setChecked( true );
+        m_ui.formLayout->insertRow( 1, m_regionBox );
+    }
+    // The markers are in the project's frames, whatever the output frame rate
+    auto rate = qMax( 1.0, Core::instance()->project()->fps() );
+    m_regionBox->setText( tr( "Only export the marked region (%1 s to %2 s)" )
+                          .arg( begin / rate, 0, 'f', 2 ).arg( end / rate, 0, 'f', 2 ) );
+}
+
+bool
+RendererSettings::exportsRegion() const
+{
+    return m_regionBox != nullptr && m_regionBox->isChecked() == true;
+}
+
 quint32
 RendererSettings::width() const
 {
@@ -204,3 +244,20 @@ RendererSettings::outputFileName() const
 {
     return m_ui.outputFileName->text();
 }
+
+Backend::EncoderOptions
+RendererSettings::encoderOptions() const
+{
+    Backend::EncoderOptions options;
+    // The first entries stand for the defaults
+    auto codec = m_ui.videoCodec->currentText().trimmed();
+    if ( codec.isEmpty() == false && codec != m_ui.videoCodec->itemText( 0 ) )
+        options.videoCodec = codec.toStdString();
+    if ( m_ui.encoderPreset->currentIndex() != 0 )
+        options.preset = m_ui.encoderPreset->currentText().toStdString();
+    options.encoderThreads = m_ui.encoderThreads->value();
+    options.renderThreads = m_ui.renderThreads->value();
+    options.gopSize = m_ui.gopSize->value();
+    options.dropFrames = m_ui.dropFrames->isChecked();
+    return options;
+}
@@ -23,8 +23,10 @@
 #ifndef RENDERERSETTINGS_H
 #define RENDERERSETTINGS_H
 
+#include <QCheckBox>
 #include <QDialog>
 #include "ui/RendererSettings.h"
+#include "Backend/IOutput.h"
 
 class   RendererSettings : public QDialog
 {
@@ -55,6 +57,13 @@ class   RendererSettings : public QDialog
         quint32         videoBitrate() const;
         quint32         audioBitrate() const;
         QString         outputFileName() const;
+        Backend::EncoderOptions encoderOptions() const;
+        /**
+         *  \brief Offers to only export the frames [begin, end).
+         */
+        void            setRegion( qint64 begin, qint64 end );
+        // Whether only the region is to be exported
+        bool            exportsRegion() const;
 
     private slots:
         void            selectOutputFileName();
@@ -63,6 +72,7 @@ class   RendererSettings : public QDialog
 
     private:
         Ui::RendererSettings    m_ui;
+        QCheckBox*              m_regionBox;
         void                    setPreset( quint32 width, quint32 height, double fps );
 };
 
@@ -39,6 +39,8 @@ ShareOnInternet::ShareOnInternet( QWidget* parent )
 {
     m_service = nullptr;
     m_serviceProvider = 0;
+    m_fileGrowing = false;
+    m_uploading = false;
     m_ui.setupUi( this );
     m_ui.progressBar->setVisible( false );
 
@@ -125,6 +127,7 @@ ShareOnInternet::authFinished()
     AbstractVideoData videoData = getVideoData();
 
     m_service->setVideoParameters( m_fileName, videoData );
+    m_service->setFileGrowing( m_fileGrowing );
 
     connect( m_service, SIGNAL(uploadOver(QString)), this, SLOT(uploadFinished(QString)));
     connect( m_service, SIGNAL(uploadProgress(qint64,qint64)),
@@ -143,6 +146,7 @@ ShareOnInternet::authFinished()
 
         return;
     }
+    m_uploading = true;
     m_ui.statusLabel->setText( tr("Authenticated!") );
     m_ui.progressBar->setEnabled( true );
     m_ui.progressBar->setVisible( true );
@@ -155,6 +159,7 @@ void
 ShareOnInternet::uploadFinished( QString result )
 {
     vlmcDebug() << "[SHARE ON INTERNET]: UPLOAD FINISHED";
+    m_uploading = false;
 
     /* Add code here to abort stuff */
     m_ui.progressBar->setEnabled( false );
@@ -193,6 +198,27 @@ ShareOnInternet::uploadProgress(qint64 received, qint64 total)
     }
 }
 
+void
+ShareOnInternet::renderFinished( bool success )
+{
+    if( success == true )
+    {
+        m_fileGrowing = false;
+        if( m_service )
+            m_service->setFileGrowing( false );
+        return;
+    }
+    /* What was uploaded so far will never be complete */
+    if( m_uploading == true )
+    {
+        m_service->cancelUpload();
+        return;
+    }
+    QMessageBox::critical( this, tr("Error"),
+                           tr("The export of the video failed, it can't be shared.") );
+    reject();
+}
+
 void
 ShareOnInternet::serviceError(QString e)
 {
@@ -231,3 +257,9 @@ ShareOnInternet::setVideoFile( QString& fileName )
 {
     m_fileName = fileName;
 }
+
+void
+ShareOnInternet::setFileGrowing( bool growing )
+{
+    m_fileGrowing = growing;
+}
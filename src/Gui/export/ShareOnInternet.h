@@ -48,6 +48,13 @@ class ShareOnInternet : public QDialog
         AbstractVideoData        getVideoData() const;
 
         void                     setVideoFile( QString& fileName );
+        /**
+         *  \brief  Tells the video file is still being rendered.
+         *
+         *  The upload then starts right away, and follows the file as it grows until
+         *  renderFinished() is called.
+         */
+        void                     setFileGrowing( bool growing );
 
     private:
         void                     publish();
@@ -57,6 +64,11 @@ class ShareOnInternet : public QDialog
         int                      m_serviceProvider;
         QString                  m_devKey;
         QString                  m_fileName;
+        bool                     m_fileGrowing;
+        bool                     m_uploading;
+
+    public slots:
+        void                     renderFinished( bool success );
 
     private slots:
         void                     accept();
@@ -35,14 +35,13 @@
 #include "Renderer/ClipRenderer.h"
 #include "Backend/IInput.h"
 #include "Library/Library.h"
+#include "Library/MediaImporter.h"
 #include "Media/Media.h"
 #include "Settings/Settings.h"
 #include "TagWidget.h"
-#include "Media/Transcoder.h"
 #include "Tools/VlmcDebug.h"
 
 #include "media/ClipMetadataDisplayer.h"
-#include "library/MediaCellView.h"
 #include "library/MediaListView.h"
 #include "preview/PreviewWidget.h"
 
@@ -55,9 +54,7 @@
 
 ImportController::ImportController(QWidget *parent) :
     QDialog(parent),
-    m_ui(new Ui::ImportController),
-    m_nbMediaToLoad( 0 ),
-    m_nbMediaLoaded( 0 )
+    m_ui(new Ui::ImportController)
 {
     m_ui->setupUi(this);
     //The renderer will be deleted by the PreviewWidget
@@ -65,6 +62,7 @@ ImportController::ImportController(QWidget *parent) :
     m_ui->previewContainer->setRenderer( m_clipRenderer );
     m_stackNav = new StackViewController( m_ui->stackViewContainer );
     m_temporaryMedias = new MediaContainer;
+    m_importer = new MediaImporter( this );
     m_mediaListView = new MediaListView( m_stackNav );
     m_mediaListView->setMediaContainer( m_temporaryMedias );
 //    m_tag = new TagWidget( m_ui->tagContainer, 6 );
@@ -110,6 +108,10 @@ ImportController::ImportController(QWidget *parent) :
              this, SLOT( clipSelection( Clip* ) ) );
     connect( m_mediaListView, SIGNAL( clipRemoved( const QUuid& ) ),
              m_clipRenderer, SLOT( clipUnloaded( const QUuid& ) ) );
+
+    connect( m_importer, &MediaImporter::ready, this, &ImportController::mediasReady );
+    connect( m_importer, &MediaImporter::progress, this, &ImportController::importProgress );
+    connect( m_importer, &MediaImporter::finished, m_ui->progressBar, &QWidget::hide );
 }
 
 ImportController::~ImportController()
@@ -150,51 +152,41 @@ ImportController::clipSelection( Clip* clip )
 }
 
 void
-ImportController::importMedia( const QString &filePath )
+ImportController::mediasReady()
 {
-    vlmcDebug() << "Importing" << filePath;
-    if ( Core::instance()->library()->mediaAlreadyLoaded( filePath ) == true ||
-         m_temporaryMedias->mediaAlreadyLoaded( filePath ) == true )
-        return ;
-
-    Media*  media = m_temporaryMedias->addMedia( filePath );
-    if ( media == nullptr )
-        return ;
-
-    connect( media, SIGNAL( metaDataComputed() ), this, SLOT( mediaLoaded() ) );
-    Clip*   clip = new Clip( media );
-    media->setBaseClip( clip );
-    m_temporaryMedias->addClip( clip );
-    ++m_nbMediaToLoad;
-    m_ui->progressBar->setMaximum( m_nbMediaToLoad );
+    for ( auto& result : m_importer->takeReady() )
+    {
+        if ( result.input == nullptr )
+        {
+            failedToLoad( result.path );
+            continue;
+        }
+        if ( Core::instance()->library()->mediaAlreadyLoaded( result.path ) == true ||
+             m_temporaryMedias->mediaAlreadyLoaded( result.path ) == true )
+            continue;
+        vlmcDebug() << "Importing" << result.path;
+        Media*  media = new Media( result.path, std::move( result.input ) );
+        Clip*   clip = new Clip( media );
+        media->setBaseClip( clip );
+        m_temporaryMedias->addClip( clip );
+    }
 }
 
 void
-ImportController::importDir( const QString &path )
+ImportController::importProgress( int done, int found )
 {
-    QDir            dir( path );
-    QFileInfoList   files = dir.entryInfoList( m_nameFilters, QDir::NoDotAndDotDot | QDir::Readable
-                                               | QDir::AllEntries );
-
-    foreach ( QFileInfo fInfo, files )
-    {
-        if ( fInfo.isDir() == true )
-            importDir( fInfo.absoluteFilePath() );
-        else
-            importMedia( fInfo.absoluteFilePath() );
-    }
+    m_ui->progressBar->setMaximum( found );
+    m_ui->progressBar->setValue( done );
+    if ( found > 3 && done < found )
+        m_ui->progressBar->show();
 }
 
 void
 ImportController::forwardButtonClicked()
 {
     QModelIndex     index = m_ui->treeView->selectionModel()->currentIndex();
-    QString         filePath = m_filesModel->fileInfo( index ).filePath();
 
-    if ( !m_filesModel->isDir( index ) )
-        importMedia( filePath );
-    else
-        importDir( filePath );
+    m_importer->import( m_filesModel->fileInfo( index ).filePath(), m_nameFilters );
 }
 
 void
@@ -218,6 +210,8 @@ ImportController::treeViewDoubleClicked( const QModelIndex& index )
 void
 ImportController::reject()
 {
+    m_importer->cancel();
+    m_ui->progressBar->hide();
     m_clipRenderer->stop();
     m_mediaListView->clear();
     m_temporaryMedias->clear();
@@ -229,43 +223,39 @@ ImportController::reject()
 void
 ImportController::accept()
 {
-    bool    invalidMedias = false;
+    QStringList invalidMedias;
 
+    // Takes what is ready, what is still being probed is dropped
+    mediasReady();
+    m_importer->cancel();
+    m_ui->progressBar->hide();
     m_mediaListView->clear();
     m_clipRenderer->stop();
     collapseAllButCurrentPath();
     foreach ( Clip* clip, m_temporaryMedias->clips().values() )
     {
+        // MLT can't decode them, so neither can the proxy pipeline convert them
         if ( clip->media()->input()->length() == 0 )
-            invalidMedias = true;
-        Core::instance()->library()->addClip( clip );
+        {
+            invalidMedias << clip->media()->fileName();
+            m_temporaryMedias->deleteClip( clip->uuid() );
+        }
+        else
+            Core::instance()->library()->addClip( clip );
     }
-    if ( invalidMedias == true )
-        handleInvalidMedias();
+    if ( invalidMedias.isEmpty() == false )
+        handleInvalidMedias( invalidMedias );
     m_temporaryMedias->removeAll();
     m_clipRenderer->setClip( nullptr );
     done( Accepted );
 }
 
 void
-ImportController::handleInvalidMedias()
+ImportController::handleInvalidMedias( const QStringList& fileNames )
 {
-    QMessageBox::StandardButton res = QMessageBox::question( nullptr, tr( "Invalid medias" ),
-                                                             tr( "Some of the medias you loaded can't be used for video editing. Do you want VLMC to convert them"
-                                                                 " so you can use them in your project?" ),
-                           QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes );
-    if ( res == QMessageBox::Yes )
-    {
-        foreach ( Clip* clip, m_temporaryMedias->clips().values() )
-        {
-            if ( clip->media()->input()->length() == 0 )
-            {/* TODO
-                Transcoder  *transcoder = new Transcoder( clip->media() );
-                connect( transcoder, SIGNAL( done() ), transcoder, SLOT( deleteLater() ) );
-                transcoder->transcodeToPs();*/
-            }
-        }
-    }
+    QMessageBox::warning( nullptr, tr( "Invalid medias" ),
+                          tr( "These medias can't be decoded, and weren't imported:\n%1" )
+                          .arg( fileNames.join( '\n' ) ) );
 }
 
 void
@@ -300,34 +290,12 @@ ImportController::restoreCurrentPath()
 }
 
 void
-ImportController::mediaLoaded()
-{
-    ++m_nbMediaLoaded;
-    if ( m_nbMediaLoaded == m_nbMediaToLoad )
-    {
-        m_nbMediaLoaded = 0;
-        m_nbMediaToLoad = 0;
-        m_ui->progressBar->hide();
-    }
-    else
-    {
-        if ( m_nbMediaToLoad > 3 )
-            m_ui->progressBar->show();
-        m_ui->progressBar->setValue( m_nbMediaLoaded );
-    }
-
-}
-
-void
-ImportController::failedToLoad( Media *media )
+ImportController::failedToLoad( const QString& filePath )
 {
-    m_ui->errorLabel->setText( tr( "Failed to load %1").arg(
-            media->fileInfo()->fileName() ) );
+    m_ui->errorLabel->setText( tr( "Failed to load %1").arg( QFileInfo( filePath ).fileName() ) );
     m_ui->errorLabelImg->show();
     m_ui->errorLabel->show();
     QTimer::singleShot( 3000, this, SLOT( hideErrors() ) );
-    m_temporaryMedias->deleteClip( media->baseClip()->uuid() );
-    mediaLoaded();
 }
 
 void
@@ -33,6 +33,7 @@
 #include "Gui/library/StackViewController.h"
 
 #include <QDialog>
+#include <QStringList>
 #include <QUuid>
 
 class   Clip;
@@ -40,6 +41,7 @@ class   ClipMetadataDisplayer;
 class   ClipRenderer;
 class   Media;
 class   MediaContainer;
+class   MediaImporter;
 class   MediaListView;
 class   PreviewWidget;
 class   TagWidget;
@@ -71,9 +73,8 @@ class ImportController : public QDialog
         void                        saveCurrentPath();
         void                        restoreCurrentPath();
         void                        collapseAllButCurrentPath();
-        void                        importMedia( const QString &filePath );
-        void                        importDir( const QString &path );
-        void                        handleInvalidMedias();
+        // Tells which medias were dropped
+        void                        handleInvalidMedias( const QStringList& fileNames );
     private:
         Ui::ImportController*       m_ui;
         StackViewController*        m_stackNav;
@@ -83,8 +84,7 @@ class ImportController : public QDialog
         QString                     m_currentlyWatchedDir;
         QUuid                       m_currentUuid;
         MediaContainer              *m_temporaryMedias;
-        quint32                     m_nbMediaToLoad;
-        quint32                     m_nbMediaLoaded;
+        MediaImporter*              m_importer;
         ClipRenderer*               m_clipRenderer;
         QStringList                 m_nameFilters;
 
@@ -97,8 +97,10 @@ class ImportController : public QDialog
         void        forwardButtonClicked();
         void        treeViewClicked( const QModelIndex& index );
         void        treeViewDoubleClicked( const QModelIndex& index );
-        void        mediaLoaded();
-        void        failedToLoad( Media* media );
+        // Adds the medias the importer has probed so far
+        void        mediasReady();
+        void        importProgress( int done, int found );
+        void        failedToLoad( const QString& filePath );
         void        hideErrors();
 
     signals:
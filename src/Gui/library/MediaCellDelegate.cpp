@@ -0,0 +1,138 @@
+/*****************************************************************************
+ * MediaCellDelegate.cpp: Paints the cells of the media list
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "MediaCellDelegate.h"
+#include "MediaListModel.h"
+
+#include <QApplication>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QTime>
+
+namespace
+{
+const int   Margin = 4;
+const int   ThumbnailSize = 64;
+const int   IconSize = 16;
+}
+
+MediaCellDelegate::MediaCellDelegate( QObject* parent )
+    : QStyledItemDelegate( parent )
+    , m_deleteIcon( QPixmap( ":/images/clear" ).scaled( IconSize, IconSize, Qt::KeepAspectRatio,
+                                                        Qt::SmoothTransformation ) )
+    , m_arrowIcon( QPixmap( ":/images/marker_left" ).scaled( IconSize, IconSize, Qt::KeepAspectRatio,
+                                                             Qt::SmoothTransformation ) )
+{
+}
+
+void
+MediaCellDelegate::paint( QPainter* painter, const QStyleOptionViewItem& option,
+                          const QModelIndex& index ) const
+{
+    QStyleOptionViewItem opt = option;
+    initStyleOption( &opt, index );
+    // Only the background and the selection, the contents are laid out below
+    opt.text.clear();
+    opt.icon = QIcon();
+    auto style = opt.widget != nullptr ? opt.widget->style() : QApplication::style();
+    style->drawControl( QStyle::CE_ItemViewItem, &opt, painter, opt.widget );
+
+    painter->save();
+    auto cell = option.rect.adjusted( Margin, Margin, -Margin, -Margin );
+    auto thumbnail = index.data( Qt::DecorationRole ).value<QPixmap>();
+    QRect thumbnailRect( cell.left(), cell.top(), ThumbnailSize, ThumbnailSize );
+    auto pos = thumbnailRect.center() - QPoint( thumbnail.width() / 2, thumbnail.height() / 2 );
+    painter->drawPixmap( pos, thumbnail );
+
+    auto group = ( option.state & QStyle::State_Selected ) ? QPalette::HighlightedText : QPalette::Text;
+    painter->setPen( option.palette.color( group ) );
+    QRect text( thumbnailRect.right() + Margin * 2, cell.top(),
+                deleteRect( option.rect ).left() - thumbnailRect.right() - Margin * 3, cell.height() );
+
+    auto titleFont = option.font;
+    titleFont.setBold( true );
+    painter->setFont( titleFont );
+    auto title = QFontMetrics( titleFont ).elidedText( index.data( Qt::DisplayRole ).toString(),
+                                                       Qt::ElideMiddle, text.width() );
+    painter->drawText( text, Qt::AlignLeft | Qt::AlignTop, title );
+
+    painter->setFont( option.font );
+    QTime   duration( 0, 0 );
+    duration = duration.addMSecs( index.data( MediaListModel::LengthRole ).toLongLong() );
+    QString details = duration.toString( "hh:mm:ss" );
+    auto nbClips = index.data( MediaListModel::ClipCountRole ).toInt();
+    if ( nbClips > 0 )
+        details += '\n' + tr( "%n clip(s)", "", nbClips );
+    painter->drawText( text, Qt::AlignLeft | Qt::AlignBottom, details );
+
+    painter->drawPixmap( deleteRect( option.rect ), m_deleteIcon );
+    if ( nbClips > 0 )
+        painter->drawPixmap( arrowRect( option.rect ), m_arrowIcon );
+    painter->restore();
+}
+
+QSize
+MediaCellDelegate::sizeHint( const QStyleOptionViewItem& option, const QModelIndex& ) const
+{
+    return QSize( option.rect.width(), ThumbnailSize + Margin * 2 );
+}
+
+bool
+MediaCellDelegate::editorEvent( QEvent* event, QAbstractItemModel* model,
+                                const QStyleOptionViewItem& option, const QModelIndex& index )
+{
+    if ( event->type() == QEvent::MouseButtonRelease )
+    {
+        auto mouseEvent = static_cast<QMouseEvent*>( event );
+        if ( mouseEvent->button() == Qt::LeftButton )
+        {
+            if ( deleteRect( option.rect ).contains( mouseEvent->pos() ) == true )
+            {
+                emit deleteClicked( index );
+                return true;
+            }
+            if ( index.data( MediaListModel::ClipCountRole ).toInt() > 0 &&
+                 arrowRect( option.rect ).contains( mouseEvent->pos() ) == true )
+            {
+                emit arrowClicked( index );
+                return true;
+            }
+        }
+    }
+    return QStyledItemDelegate::editorEvent( event, model, option, index );
+}
+
+QRect
+MediaCellDelegate::deleteRect( const QRect& cell )
+{
+    return QRect( cell.right() - Margin - IconSize, cell.top() + Margin, IconSize, IconSize );
+}
+
+QRect
+MediaCellDelegate::arrowRect( const QRect& cell )
+{
+    return QRect( cell.right() - Margin - IconSize, cell.bottom() - Margin - IconSize, IconSize, IconSize );
+}
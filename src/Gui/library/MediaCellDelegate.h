@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * MediaCellDelegate.h: Paints the cells of the media list
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MEDIACELLDELEGATE_H
+#define MEDIACELLDELEGATE_H
+
+#include <QPixmap>
+#include <QStyledItemDelegate>
+
+/**
+ *  \brief  Paints a MediaListModel row: its snapshot, name, length, and the buttons
+ *          to delete the clip and to show its subclips.
+ */
+class MediaCellDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+    public:
+        explicit MediaCellDelegate( QObject* parent = nullptr );
+
+        virtual void    paint( QPainter* painter, const QStyleOptionViewItem& option,
+                               const QModelIndex& index ) const override;
+        virtual QSize   sizeHint( const QStyleOptionViewItem& option,
+                                  const QModelIndex& index ) const override;
+
+    protected:
+        virtual bool    editorEvent( QEvent* event, QAbstractItemModel* model,
+                                     const QStyleOptionViewItem& option,
+                                     const QModelIndex& index ) override;
+
+    private:
+        static QRect    deleteRect( const QRect& cell );
+        static QRect    arrowRect( const QRect& cell );
+
+    private:
+        QPixmap         m_deleteIcon;
+        QPixmap         m_arrowIcon;
+
+    signals:
+        void            deleteClicked( const QModelIndex& index );
+        void            arrowClicked( const QModelIndex& index );
+};
+
+#endif // MEDIACELLDELEGATE_H
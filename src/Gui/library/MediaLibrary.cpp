@@ -31,7 +31,6 @@
 #include "Library/Library.h"
 #include "Main/Core.h"
 #include "Media/Media.h"
-#include "MediaCellView.h"
 #include "MediaListView.h"
 #include "StackViewController.h"
 #include "ViewController.h"
@@ -41,22 +40,25 @@
 #include <QMimeData>
 
 MediaLibrary::MediaLibrary(QWidget *parent) : QWidget(parent),
-    m_ui( new Ui::MediaLibrary() )
+    m_ui( new Ui::MediaLibrary() ),
+    m_lastField( ClipSearchIndex::Name )
 {
     m_ui->setupUi( this );
     setAcceptDrops( true );
 
-    StackViewController *nav = new StackViewController( m_ui->mediaListContainer );
-    m_mediaListView = new MediaListView( nav );
-    nav->pushViewController( m_mediaListView );
+    m_nav = new StackViewController( m_ui->mediaListContainer );
+    m_mediaListView = new MediaListView( m_nav );
+    m_nav->pushViewController( m_mediaListView );
 
     connect( m_ui->importButton, SIGNAL( clicked() ),
              this, SIGNAL( importRequired() ) );
     connect( m_mediaListView, SIGNAL( clipSelected( Clip* ) ),
              this, SIGNAL( clipSelected( Clip* ) ) );
+    connect( m_mediaListView, SIGNAL( prefetchRequested( Clip* ) ),
+             this, SIGNAL( prefetchRequested( Clip* ) ) );
     connect( m_ui->filterInput, SIGNAL( textChanged( const QString& ) ),
              this, SLOT( filterUpdated( const QString& ) ) );
-    connect( nav, SIGNAL( viewChanged( ViewController* ) ),
+    connect( m_nav, SIGNAL( viewChanged( ViewController* ) ),
              this, SLOT( viewChanged( ViewController* ) ) );
     connect( m_ui->filterType, SIGNAL( currentIndexChanged( int ) ),
              this, SLOT( filterTypeChanged() ) );
@@ -67,6 +69,17 @@ MediaLibrary::~MediaLibrary()
     delete m_ui;
 }
 
+void
+MediaLibrary::setLibrary( Library* library )
+{
+    // The subclip views show the containers of the previous library
+    m_nav->popToRoot();
+    m_mediaListView->setMediaContainer( library );
+    m_lastFilter.clear();
+    m_matches.clear();
+    filterUpdated( m_ui->filterInput->text() );
+}
+
 void
 MediaLibrary::changeEvent( QEvent *e )
 {
@@ -84,30 +97,45 @@ MediaLibrary::changeEvent( QEvent *e )
 void
 MediaLibrary::filterUpdated( const QString &filter )
 {
-    const MediaListView::MediaList              &medias = m_mediaListView->mediaList();
-    MediaListView::MediaList::const_iterator    it = medias.begin();
-    MediaListView::MediaList::const_iterator    ite = medias.end();
+    auto    field = currentField();
 
-    while ( it != ite )
+    if ( filter.isEmpty() == true )
     {
-        MediaCellView  *mcv = it.value();
-
-        mcv->setVisible( currentFilter()( mcv->clip(), filter ) );
-        ++it;
+        m_lastFilter.clear();
+        m_matches.clear();
+        m_mediaListView->applyFilter( []( const Clip* ) { return true; } );
+        return;
     }
+    // While the user types, only the clips which matched so far can still match
+    auto refine = field == m_lastField && m_lastFilter.isEmpty() == false &&
+            filter.startsWith( m_lastFilter, Qt::CaseInsensitive ) == true;
+    m_matches = Core::instance()->library()->searchIndex().match( field, filter,
+                                                                  refine == true ? &m_matches : nullptr );
+    m_lastFilter = filter;
+    m_lastField = field;
+
+    m_mediaListView->applyFilter( [this, field]( const Clip* clip ) {
+        // The subclips have the tags of their parents
+        for ( auto c = clip; c != nullptr; c = field == ClipSearchIndex::Tags ? c->parent() : nullptr )
+        {
+            if ( m_matches.contains( c->uuid() ) == true )
+                return true;
+        }
+        return false;
+    } );
 }
 
-MediaLibrary::Filter
-MediaLibrary::currentFilter()
+ClipSearchIndex::Field
+MediaLibrary::currentField() const
 {
     switch ( m_ui->filterType->currentIndex() )
     {
-        case 0:
-            return &filterByName;
         case 1:
-            return &filterByTags;
+            return ClipSearchIndex::Tags;
+        case 2:
+            return ClipSearchIndex::Notes;
         default:
-            return &filterByName;
+            return ClipSearchIndex::Name;
     }
 }
 
@@ -121,24 +149,14 @@ MediaLibrary::viewChanged( ViewController *view )
 
     m_mediaListView = mlv;
     //Force an update as the media has changed
+    m_lastFilter.clear();
     filterUpdated( m_ui->filterInput->text() );
 }
 
-bool
-MediaLibrary::filterByName( const Clip *clip, const QString &filter )
-{
-    return ( clip->media()->fileName().contains( filter, Qt::CaseInsensitive ) );
-}
-
-bool
-MediaLibrary::filterByTags( const Clip *clip, const QString &filter )
-{
-    return ( clip->matchMetaTag( filter ) );
-}
-
 void
 MediaLibrary::filterTypeChanged()
 {
+    m_lastFilter.clear();
     filterUpdated( m_ui->filterInput->text() );
 }
 
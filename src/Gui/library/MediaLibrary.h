@@ -23,12 +23,17 @@
 #ifndef MEDIALIBRARY_H
 #define MEDIALIBRARY_H
 
+#include <QSet>
+#include <QUuid>
 #include <QWidget>
 
+#include "Library/ClipSearchIndex.h"
 #include "ui/MediaLibrary.h"
 class   Clip;
+class   Library;
 class   MediaListView;
 class   MediaContainer;
+class   StackViewController;
 class   ViewController;
 
 class MediaLibrary : public QWidget
@@ -37,9 +42,10 @@ class MediaLibrary : public QWidget
     Q_DISABLE_COPY( MediaLibrary )
 
     public:
-        typedef bool    (*Filter)( const Clip*, const QString& filter );
         explicit MediaLibrary( QWidget *parent = 0);
         virtual ~MediaLibrary();
+        // Shows the clips of another library, when the active project changes
+        void        setLibrary( Library* library );
 
     protected:
         void        dragEnterEvent( QDragEnterEvent *event );
@@ -50,20 +56,18 @@ class MediaLibrary : public QWidget
 
     private:
         /**
-         *  \return     The appropriate filter function
-         *
-         *  This will evaluate the currently selected filter, and return the appropriate
-         *  function.
+         *  \return     The field of the clips the currently selected filter searches
          */
-        Filter              currentFilter();
-
-    //Filters list :
-        static bool         filterByName( const Clip *clip, const QString &filter );
-        static bool         filterByTags( const Clip *clip, const QString &filter );
+        ClipSearchIndex::Field  currentField() const;
 
     private:
         Ui::MediaLibrary    *m_ui;
+        StackViewController *m_nav;
         MediaListView       *m_mediaListView;
+        // The last search, which the next one refines when the user keeps typing
+        QString                 m_lastFilter;
+        ClipSearchIndex::Field  m_lastField;
+        QSet<QUuid>             m_matches;
 
     private slots:
         void                filterUpdated( const QString &filter );
@@ -78,6 +82,7 @@ class MediaLibrary : public QWidget
     signals:
         void                importRequired();
         void                clipSelected( Clip* );
+        void                prefetchRequested( Clip* );
 };
 
 #endif // MEDIALIBRARY_H
@@ -0,0 +1,252 @@
+/*****************************************************************************
+ * MediaListModel.cpp: Model of the clips of a MediaContainer
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "MediaListModel.h"
+
+#include "Library/MediaContainer.h"
+#include "Media/Clip.h"
+#include "Media/Media.h"
+
+#include <QMimeData>
+
+#include <algorithm>
+
+namespace
+{
+    // Clips loaded each time the view scrolls to the end of the list
+    const int   FetchSize = 200;
+}
+
+MediaListModel::MediaListModel( MediaContainer* container, QObject* parent )
+    : QAbstractListModel( parent )
+    , m_container( container )
+{
+    // Short enough to go unnoticed, long enough to gather an import's burst
+    m_flushTimer.setSingleShot( true );
+    m_flushTimer.setInterval( 50 );
+    connect( &m_flushTimer, &QTimer::timeout, this, &MediaListModel::flush );
+
+    connect( m_container, &MediaContainer::newClipLoaded, this, &MediaListModel::clipLoaded );
+    connect( m_container, &MediaContainer::clipRemoved, this, &MediaListModel::clipRemoved );
+}
+
+int
+MediaListModel::rowCount( const QModelIndex& parent ) const
+{
+    if ( parent.isValid() == true )
+        return 0;
+    return m_clips.count();
+}
+
+QVariant
+MediaListModel::data( const QModelIndex& index, int role ) const
+{
+    auto c = clip( index );
+    if ( c == nullptr )
+        return QVariant();
+
+    switch ( role )
+    {
+    case Qt::DisplayRole:
+        return c->media()->fileName();
+    case Qt::DecorationRole:
+    {
+        auto it = m_thumbnails.find( c->uuid() );
+        if ( it == m_thumbnails.end() )
+            it = m_thumbnails.insert( c->uuid(), c->media()->snapshot().scaled( 64, 64, Qt::KeepAspectRatio ) );
+        return it.value();
+    }
+    case LengthRole:
+        return c->lengthSecond() * 1000;
+    case ClipCountRole:
+        return c->mediaContainer()->count();
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags
+MediaListModel::flags( const QModelIndex& index ) const
+{
+    if ( index.isValid() == false )
+        return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsDragEnabled;
+}
+
+QStringList
+MediaListModel::mimeTypes() const
+{
+    return QStringList() << "vlmc/uuid" << "vlmc/uuids";
+}
+
+QMimeData*
+MediaListModel::mimeData( const QModelIndexList& indexes ) const
+{
+    if ( indexes.isEmpty() == true || clip( indexes.first() ) == nullptr )
+        return nullptr;
+    auto sorted = indexes;
+    std::sort( sorted.begin(), sorted.end(), []( const QModelIndex& a, const QModelIndex& b ) {
+        return a.row() < b.row();
+    } );
+    QStringList uuids;
+    for ( const auto& index : sorted )
+    {
+        if ( clip( index ) != nullptr )
+            uuids << clip( index )->uuid().toString();
+    }
+    QMimeData* mimeData = new QMimeData;
+    // The first clip is the one previewed while dragging
+    mimeData->setData( "vlmc/uuid", uuids.first().toLatin1() );
+    if ( uuids.count() > 1 )
+        mimeData->setData( "vlmc/uuids", uuids.join( '\n' ).toLatin1() );
+    return mimeData;
+}
+
+Qt::DropActions
+MediaListModel::supportedDragActions() const
+{
+    return Qt::CopyAction | Qt::MoveAction;
+}
+
+bool
+MediaListModel::canFetchMore( const QModelIndex& parent ) const
+{
+    // Wait for the last page to be listed, before asking for the next one
+    if ( parent.isValid() == true || m_pending.isEmpty() == false )
+        return false;
+    return m_container->canFetchMore();
+}
+
+void
+MediaListModel::fetchMore( const QModelIndex& parent )
+{
+    if ( parent.isValid() == false )
+        m_container->fetchMore( FetchSize );
+}
+
+Clip*
+MediaListModel::clip( const QModelIndex& index ) const
+{
+    if ( index.isValid() == false || index.row() >= m_clips.count() )
+        return nullptr;
+    return m_clips[index.row()];
+}
+
+void
+MediaListModel::clear()
+{
+    m_flushTimer.stop();
+    beginResetModel();
+    for ( auto c : m_clips )
+    {
+        disconnect( c->media(), nullptr, this, nullptr );
+        disconnect( c->mediaContainer(), nullptr, this, nullptr );
+    }
+    m_clips.clear();
+    m_pending.clear();
+    m_uuids.clear();
+    m_thumbnails.clear();
+    endResetModel();
+}
+
+void
+MediaListModel::clipLoaded( Clip* clip )
+{
+    if ( m_uuids.contains( clip->uuid() ) == true )
+        return;
+    m_uuids.insert( clip->uuid() );
+    m_pending << clip;
+    if ( m_flushTimer.isActive() == false )
+        m_flushTimer.start();
+}
+
+void
+MediaListModel::clipRemoved( const QUuid& uuid )
+{
+    // Rows go in the order the clips arrived
+    flush();
+    if ( m_uuids.contains( uuid ) == false )
+        return;
+    auto r = row( uuid );
+    if ( r < 0 )
+        return;
+    beginRemoveRows( QModelIndex(), r, r );
+    auto c = m_clips.takeAt( r );
+    // The media may be shared with the clips left, its snapshot updates are then no-ops
+    disconnect( c->mediaContainer(), nullptr, this, nullptr );
+    m_uuids.remove( uuid );
+    m_thumbnails.remove( uuid );
+    endRemoveRows();
+}
+
+void
+MediaListModel::flush()
+{
+    m_flushTimer.stop();
+    if ( m_pending.isEmpty() == true )
+        return;
+    beginInsertRows( QModelIndex(), m_clips.count(), m_clips.count() + m_pending.count() - 1 );
+    for ( auto c : m_pending )
+    {
+        auto uuid = c->uuid();
+        connect( c->media(), &Media::snapshotAvailable, this, [this, uuid]
+        {
+            m_thumbnails.remove( uuid );
+            clipChanged( uuid );
+        }, Qt::QueuedConnection );
+        connect( c->mediaContainer(), &MediaContainer::newClipLoaded, this, [this, uuid]
+        {
+            clipChanged( uuid );
+        } );
+        connect( c->mediaContainer(), &MediaContainer::clipRemoved, this, [this, uuid]
+        {
+            clipChanged( uuid );
+        } );
+    }
+    m_clips += m_pending;
+    m_pending.clear();
+    endInsertRows();
+}
+
+void
+MediaListModel::clipChanged( const QUuid& uuid )
+{
+    auto r = row( uuid );
+    if ( r < 0 )
+        return;
+    emit dataChanged( index( r ), index( r ) );
+}
+
+int
+MediaListModel::row( const QUuid& uuid ) const
+{
+    for ( int i = 0; i < m_clips.count(); ++i )
+    {
+        if ( m_clips[i]->uuid() == uuid )
+            return i;
+    }
+    return -1;
+}
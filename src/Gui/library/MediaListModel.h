@@ -0,0 +1,92 @@
+/*****************************************************************************
+ * MediaListModel.h: Model of the clips of a MediaContainer
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MEDIALISTMODEL_H
+#define MEDIALISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QList>
+#include <QPixmap>
+#include <QSet>
+#include <QTimer>
+#include <QUuid>
+
+class   Clip;
+class   MediaContainer;
+
+/**
+ *  \brief  Lists the clips of a MediaContainer, for MediaListView.
+ *
+ *  Clips arriving in a burst, such as during an import, are inserted as a single
+ *  batch of rows. The snapshots are only requested once a row gets painted.
+ */
+class MediaListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+    public:
+        enum Roles
+        {
+            // The length, in ms
+            LengthRole = Qt::UserRole + 1,
+            ClipCountRole,
+        };
+
+        explicit MediaListModel( MediaContainer* container, QObject* parent = nullptr );
+
+        virtual int             rowCount( const QModelIndex& parent = QModelIndex() ) const override;
+        virtual QVariant        data( const QModelIndex& index, int role ) const override;
+        virtual Qt::ItemFlags   flags( const QModelIndex& index ) const override;
+        virtual QStringList     mimeTypes() const override;
+        virtual QMimeData*      mimeData( const QModelIndexList& indexes ) const override;
+        virtual Qt::DropActions supportedDragActions() const override;
+        // The container may hold more clips than it has loaded
+        virtual bool            canFetchMore( const QModelIndex& parent ) const override;
+        virtual void            fetchMore( const QModelIndex& parent ) override;
+
+        Clip*                   clip( const QModelIndex& index ) const;
+        /**
+         *  \brief  Removes every row, leaving the container untouched.
+         */
+        void                    clear();
+
+    private:
+        void                    clipLoaded( Clip* clip );
+        void                    clipRemoved( const QUuid& uuid );
+        // Inserts the clips loaded since the last call
+        void                    flush();
+        void                    clipChanged( const QUuid& uuid );
+        int                     row( const QUuid& uuid ) const;
+
+    private:
+        MediaContainer*         m_container;
+        QList<Clip*>            m_clips;
+        QList<Clip*>            m_pending;
+        // Both the listed and the pending ones
+        QSet<QUuid>             m_uuids;
+        QTimer                  m_flushTimer;
+        // Scaled down once, rather than on each paint
+        mutable QHash<QUuid, QPixmap>   m_thumbnails;
+};
+
+#endif // MEDIALISTMODEL_H
@@ -26,116 +26,184 @@
 
 #include "MediaListView.h"
 
+#include "ClipProperty.h"
 #include "Media/Clip.h"
-#include "MediaCellView.h"
+#include "Media/Media.h"
+#include "MediaCellDelegate.h"
+#include "MediaListModel.h"
 #include "Library/Library.h"
 #include "Main/Core.h"
 #include "Project/Project.h"
+#include "Project/Workspace.h"
 #include "StackViewController.h"
+#include "Workflow/MainWorkflow.h"
 
-#include <QApplication>
+#include <QListView>
+#include <QMenu>
+#include <QMessageBox>
 
 MediaListView::MediaListView(StackViewController *nav) :
-        ListViewController( nav ),
-        m_nav( nav )
+        m_nav( nav ),
+        m_model( nullptr ),
+        m_mediaContainer( nullptr )
 {
+    m_title = tr( "Media List" );
+    m_view = new QListView( nav );
+    m_view->setUniformItemSizes( true );
+    // Dragging a selection lays its clips one after the other on the timeline
+    m_view->setSelectionMode( QAbstractItemView::ExtendedSelection );
+    m_view->setDragEnabled( true );
+    m_view->setDragDropMode( QAbstractItemView::DragOnly );
+    m_view->setContextMenuPolicy( Qt::CustomContextMenu );
+    m_delegate = new MediaCellDelegate( this );
+    m_view->setItemDelegate( m_delegate );
+
+    connect( m_delegate, &MediaCellDelegate::deleteClicked, this, &MediaListView::removeClip );
+    connect( m_delegate, &MediaCellDelegate::arrowClicked, this, &MediaListView::showSubClips );
+    connect( m_view, &QListView::doubleClicked, this, &MediaListView::showProperties );
+    connect( m_view, &QListView::customContextMenuRequested, this, &MediaListView::showContextMenu );
     setMediaContainer( Core::instance()->library() );
 }
 
 MediaListView::~MediaListView()
 {
-    foreach ( MediaCellView* cell, m_cells )
-        delete cell;
-    m_cells.clear();
+    delete m_view;
 }
 
-void
-MediaListView::newClipLoaded( Clip *clip )
+QWidget*
+MediaListView::view() const
+{
+    return m_view;
+}
+
+const QString&
+MediaListView::title() const
 {
-    MediaCellView   *cell = new MediaCellView( clip, m_container );
-
-    connect( cell, SIGNAL ( cellSelected( QUuid ) ),
-             this, SLOT ( cellSelection( QUuid ) ) );
-    connect( cell, SIGNAL ( cellDeleted( const Clip* ) ),
-             this, SLOT( removeClip( const Clip* ) ) );
-    connect( cell, SIGNAL( arrowClicked( const QUuid& ) ),
-             this, SLOT( showSubClips( const QUuid& ) ) );
-    addCell( cell );
-    m_cells.insert( clip->uuid(), cell );
-    cellSelection( clip->uuid() );
+    return m_title;
 }
 
 void
-MediaListView::cellSelection( const QUuid &uuid )
+MediaListView::currentChanged( const QModelIndex& current )
 {
-    if ( m_currentUuid == uuid )
+    emit clipSelected( m_model->clip( current ) );
+    if ( current.isValid() == false )
         return;
-    if ( m_cells.contains( uuid ) )
+    for ( auto row : { current.row() + 1, current.row() - 1 } )
     {
-        if ( !m_currentUuid.isNull() && m_cells.contains( m_currentUuid ) )
-        {
-            MediaCellView   *cell = m_cells.value( m_currentUuid );
-            cell->setPalette( m_cells.value( uuid )->palette() );
-        }
-        QPalette p = m_cells.value( uuid )->palette();
-        p.setColor( QPalette::Window, QApplication::palette().brush( QPalette::Active, QPalette::Highlight ).color() );
-        m_cells.value( uuid )->setPalette( p );
-        m_currentUuid = uuid;
-        emit clipSelected( m_mediaContainer->clip( uuid ) );
+        auto clip = m_model->clip( m_model->index( row ) );
+        if ( clip != nullptr )
+            emit prefetchRequested( clip );
     }
 }
 
 void
-MediaListView::removeClip( const Clip *clip )
+MediaListView::clipsInserted( const QModelIndex&, int, int last )
+{
+    m_view->setCurrentIndex( m_model->index( last ) );
+}
+
+void
+MediaListView::removeClip( const QModelIndex& index )
 {
-    __clipRemoved( clip->uuid() );
+    auto clip = m_model->clip( index );
+    if ( clip == nullptr )
+        return;
+    if ( Core::instance()->workflow()->contains( clip->uuid() ) == true )
+    {
+        QMessageBox msgBox;
+        msgBox.setText( tr( "This clip or some of its children are contained in the timeline." ) );
+        msgBox.setInformativeText( tr( "Removing it will delete it from the timeline. Do you want to proceed?" ) );
+        msgBox.setStandardButtons( QMessageBox::Ok | QMessageBox::Cancel );
+        msgBox.setDefaultButton( QMessageBox::Ok );
+        if ( msgBox.exec() != QMessageBox::Ok )
+            return;
+    }
     emit clipRemoved( clip->uuid() );
 }
 
 void
-MediaListView::__clipRemoved( const QUuid &uuid )
+MediaListView::showProperties( const QModelIndex& index )
 {
-    MediaCellView*  cell = m_cells.take( uuid );
-    removeCell( cell );
-    m_currentUuid = QUuid();
-    // cancel out selection state (mostly to inform the renderer)
-    emit clipSelected( nullptr );
+    auto clip = m_model->clip( index );
+    if ( clip == nullptr )
+        return;
+    ClipProperty* cp = new ClipProperty( clip, m_view );
+    cp->setModal( true );
+    cp->exec();
+    delete cp;
+}
+
+void
+MediaListView::showContextMenu( const QPoint& pos )
+{
+    auto clip = m_model->clip( m_view->indexAt( pos ) );
+    // The actions all apply to the media, which only its root clip stands for
+    if ( clip == nullptr || clip->isRootClip() == false )
+        return ;
+
+    QMenu menu( m_view );
+    QAction* copyInWorkspace = menu.addAction( tr( "Copy in workspace" ) );
+    QAction* growing = menu.addAction( tr( "Still being recorded" ) );
+    growing->setCheckable( true );
+    growing->setChecked( clip->media()->isGrowing() );
+
+    QAction* selectedAction = menu.exec( m_view->viewport()->mapToGlobal( pos ) );
+    if ( selectedAction == nullptr )
+        return ;
+    if ( copyInWorkspace == selectedAction )
+    {
+        if ( Core::instance()->workspace()->copyToWorkspace( clip->media() ) == false )
+        {
+            QMessageBox::warning( nullptr, tr( "Can't copy to workspace" ),
+                                  tr( "Can't copy this media to workspace: %1" ).arg( Core::instance()->workspace()->lastError() ) );
+        }
+    }
+    else if ( growing == selectedAction )
+        Core::instance()->library()->setGrowing( clip->media(), growing->isChecked() );
 }
 
 void
 MediaListView::clear()
 {
-    foreach ( MediaCellView* cell, m_cells.values() )
-        removeCell( cell );
-    m_cells.clear();
+    m_model->clear();
+    // cancel out selection state (mostly to inform the renderer)
+    emit clipSelected( nullptr );
 }
 
 void
-MediaListView::showSubClips( const QUuid &uuid )
+MediaListView::showSubClips( const QModelIndex& index )
 {
-    Clip    *clip = m_mediaContainer->clip( uuid );
+    Clip    *clip = m_model->clip( index );
+    if ( clip == nullptr )
+        return;
     MediaListView* view = new MediaListView( m_nav );
     connect( view, &MediaListView::clipSelected, this, &MediaListView::clipSelected );
     connect( view, &MediaListView::clipRemoved, this, &MediaListView::clipRemoved );
+    connect( view, &MediaListView::prefetchRequested, this, &MediaListView::prefetchRequested );
     view->setMediaContainer( clip->mediaContainer() );
     clip->mediaContainer()->reloadAllClips();
     m_nav->pushViewController( view );
 }
 
-const MediaListView::MediaList&
-MediaListView::mediaList() const
+void
+MediaListView::applyFilter( const std::function<bool( const Clip* )>& filter )
 {
-    return m_cells;
+    for ( int row = 0; row < m_model->rowCount(); ++row )
+        m_view->setRowHidden( row, filter( m_model->clip( m_model->index( row ) ) ) == false );
 }
 
 void
 MediaListView::setMediaContainer( MediaContainer* container )
 {
+    if ( m_mediaContainer != nullptr )
+        disconnect( this, &MediaListView::clipRemoved, m_mediaContainer, &MediaContainer::deleteClip );
     m_mediaContainer = container;
-    connect( m_mediaContainer, SIGNAL( newClipLoaded( Clip* ) ),
-             this, SLOT( newClipLoaded( Clip* ) ) );
-    connect( this, SIGNAL( clipRemoved( const QUuid& ) ),
-             m_mediaContainer, SLOT( deleteClip( const QUuid& ) ) );
-    connect( m_mediaContainer, SIGNAL( clipRemoved( const QUuid& ) ),
-             this, SLOT( __clipRemoved( const QUuid& ) ) );
+    auto model = new MediaListModel( container, this );
+    m_view->setModel( model );
+    delete m_model;
+    m_model = model;
+
+    connect( m_view->selectionModel(), &QItemSelectionModel::currentChanged, this, &MediaListView::currentChanged );
+    connect( m_model, &MediaListModel::rowsInserted, this, &MediaListView::clipsInserted );
+    connect( this, &MediaListView::clipRemoved, m_mediaContainer, &MediaContainer::deleteClip );
 }
@@ -24,57 +24,62 @@
 #ifndef MEDIALISTVIEW_H
 #define MEDIALISTVIEW_H
 
-#include "ListViewController.h"
+#include "ViewController.h"
 
-#include <QHash>
 #include <QUuid>
 
+#include <functional>
+
 class   Clip;
-class   Media;
+class   MediaCellDelegate;
 class   MediaContainer;
-class   MediaCellView;
-class   Project;
+class   MediaListModel;
 class   StackViewController;
 
-class   QWidget;
+class   QListView;
+class   QModelIndex;
+class   QPoint;
 
-class MediaListView : public ListViewController
+class MediaListView : public ViewController
 {
     Q_OBJECT
 
 public:
-    typedef     QHash<QUuid, MediaCellView*>    MediaList;
-
     MediaListView( StackViewController *nav );
     virtual ~MediaListView();
 
-    const MediaList                 &mediaList() const;
+    QWidget*                        view() const;
+    const QString&                  title() const;
     void                            setMediaContainer( MediaContainer* container );
+    /**
+     *  \brief  Only shows the clips accepted by filter.
+     */
+    void                            applyFilter( const std::function<bool( const Clip* )>& filter );
 
 private:
     StackViewController             *m_nav;
-    QUuid                           m_currentUuid;
-    MediaList                       m_cells;
-    QUuid                           m_lastUuidClipListAsked;
+    QString                         m_title;
+    QListView                       *m_view;
+    MediaListModel                  *m_model;
+    MediaCellDelegate               *m_delegate;
     MediaContainer                  *m_mediaContainer;
 
 public slots:
-    void        cellSelection( const QUuid &uuid );
-    void        showSubClips( const QUuid &uuid );
+    void        showSubClips( const QModelIndex& index );
     void        clear();
 
 private slots:
-    void        removeClip( const Clip* );
-    /**
-     *  \brief  Called when the media container unload a clip
-     *
-     *  This slot will be triggered when a Clip is removed from the media container.
-     */
-    void        __clipRemoved( const QUuid& );
-    void        newClipLoaded( Clip *clip );
+    void        currentChanged( const QModelIndex& current );
+    // Selects the last clip of a batch of new ones
+    void        clipsInserted( const QModelIndex& parent, int first, int last );
+    void        removeClip( const QModelIndex& index );
+    void        showProperties( const QModelIndex& index );
+    void        showContextMenu( const QPoint& pos );
 
 signals:
     void        clipSelected( Clip* );
+    /// Emitted for the cells around the selected one, which are likely to be selected next.
+    void        prefetchRequested( Clip* );
     /// Used when the user clicks the deletion arrow.
     void        clipRemoved( const QUuid& );
 };
@@ -115,6 +115,13 @@ StackViewController::popViewController( bool /*animated*/ )
     delete m_current;
 }
 
+void
+StackViewController::popToRoot()
+{
+    while ( m_controllerStack->isEmpty() == false )
+        popViewController();
+}
+
 void
 StackViewController::previous()
 {
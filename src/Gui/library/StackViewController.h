@@ -45,6 +45,8 @@ public:
     void                    pushViewController( ViewController* viewController,
                                                 bool animated = false );
     void                    popViewController( bool animated = false );
+    // Goes back to the first view, deleting the others
+    void                    popToRoot();
 
 private:
     void                    restorePrevious();
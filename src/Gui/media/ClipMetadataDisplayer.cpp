@@ -26,17 +26,31 @@
 
 #include "ClipMetadataDisplayer.h"
 
+#include "Library/Library.h"
+#include "Main/Core.h"
 #include "Media/Clip.h"
 #include "Media/Media.h"
+#include "Project/Project.h"
+#include "Workflow/DecodeBenchmarkService.h"
+#include "Workflow/ProxyService.h"
 
+#include <QStringList>
 #include <QTime>
 
 ClipMetadataDisplayer::ClipMetadataDisplayer( QWidget *parent /*= nullptr*/ ) :
     QWidget( parent ),
     m_ui( new Ui::ClipMetadataDisplayer ),
-    m_watchedClip( nullptr )
+    m_watchedClip( nullptr ),
+    m_watchedMedia( nullptr )
 {
     m_ui->setupUi( this );
+    m_ui->optimizeButton->setVisible( false );
+    connect( m_ui->optimizeButton, &QPushButton::clicked, this, &ClipMetadataDisplayer::optimize );
+    connect( Core::instance()->proxyService(), &ProxyService::optimized, this, [this]( const QString& filePath )
+    {
+        if ( m_watchedMedia != nullptr && m_watchedMedia->fileInfo()->absoluteFilePath() == filePath )
+            updateDecodeSpeed();
+    } );
 }
 
 ClipMetadataDisplayer::~ClipMetadataDisplayer()
@@ -50,22 +64,60 @@ ClipMetadataDisplayer::metadataUpdated()
     QTime   duration;
     duration = duration.addSecs( m_watchedClip->lengthSecond() );
 
-    const auto* input = m_watchedMedia->input();
+    const auto& info = m_watchedMedia->info();
     updateInterface();
     //Duration
     m_ui->durationValueLabel->setText( duration.toString( "hh:mm:ss" ) );
     //Filename || title
     m_ui->nameValueLabel->setText( m_watchedMedia->fileInfo()->fileName() );
     //Resolution
-    m_ui->resolutionValueLabel->setText( QString::number( input->width() )
-                                       + " x " + QString::number( input->height() ) );
+    m_ui->resolutionValueLabel->setText( QString::number( info.width )
+                                       + " x " + QString::number( info.height ) );
     //FPS
-    m_ui->fpsValueLabel->setText( QString::number( input->fps() ) );
+    m_ui->fpsValueLabel->setText( QString::number( info.fps ) );
+    //Codecs
+    QStringList codecs;
+    for ( const auto& codec : { info.videoCodec, info.audioCodec } )
+        if ( codec.empty() == false )
+            codecs << QString::fromStdString( codec );
+    m_ui->codecsValueLabel->setText( codecs.isEmpty() ? "---" : codecs.join( ", " ) );
     //nb tracks :
-    m_ui->nbVideoTracksValueLabel->setText( QString::number( input->nbVideoTracks() ) );
-    m_ui->nbAudioTracksValueLabel->setText( QString::number( input->nbAudioTracks() ) );
+    m_ui->nbVideoTracksValueLabel->setText( QString::number( info.nbVideoTracks ) );
+    m_ui->nbAudioTracksValueLabel->setText( QString::number( info.nbAudioTracks ) );
     //Path:
     m_ui->pathValueLabel->setText( m_watchedMedia->fileInfo()->absoluteFilePath() );
+    updateDecodeSpeed();
+}
+
+void
+ClipMetadataDisplayer::updateDecodeSpeed()
+{
+    auto speed = m_watchedMedia->decodeSpeed();
+    auto slow = DecodeBenchmarkService::isSlow( speed, Core::instance()->project()->fps() );
+    auto optimized = Core::instance()->proxyService()->isOptimized(
+                m_watchedMedia->fileInfo()->absoluteFilePath() );
+    if ( speed <= 0 )
+        m_ui->decodeSpeedValueLabel->setText( "---" );
+    else if ( optimized == true )
+        m_ui->decodeSpeedValueLabel->setText( tr( "%1 fps, previewed from its optimized media" )
+                                              .arg( speed, 0, 'f', 1 ) );
+    else if ( slow == true )
+        m_ui->decodeSpeedValueLabel->setText( tr( "%1 fps, too slow for a smooth preview: "
+                                                  "optimizing it is recommended" ).arg( speed, 0, 'f', 1 ) );
+    else
+        m_ui->decodeSpeedValueLabel->setText( tr( "%1 fps" ).arg( speed, 0, 'f', 1 ) );
+    m_ui->optimizeButton->setVisible( slow == true && optimized == false );
+    m_ui->optimizeButton->setEnabled( true );
+}
+
+void
+ClipMetadataDisplayer::optimize()
+{
+    if ( m_watchedMedia == nullptr )
+        return;
+    Core::instance()->library()->optimizeMedia( m_watchedMedia );
+    // Until optimized() tells it's done
+    m_ui->optimizeButton->setEnabled( false );
 }
 
 void
@@ -78,11 +130,15 @@ ClipMetadataDisplayer::clear()
     m_ui->resolutionValueLabel->setText( "---" );
     //FPS
     m_ui->fpsValueLabel->setText( "---" );
+    //Codecs
+    m_ui->codecsValueLabel->setText( "---" );
     //nb tracks :
     m_ui->nbVideoTracksValueLabel->setText( "---" );
     m_ui->nbAudioTracksValueLabel->setText( "---" );
     //Path:
     m_ui->pathValueLabel->setText( "---" );
+    m_ui->decodeSpeedValueLabel->setText( "---" );
+    m_ui->optimizeButton->setVisible( false );
 }
 
 void
@@ -103,15 +159,18 @@ ClipMetadataDisplayer::setWatchedClip( const Clip *clip )
     m_watchedClip = clip;
     m_watchedMedia = clip->media();
     connect( m_watchedClip, SIGNAL( unloaded( Clip* ) ), this, SLOT( clipDestroyed( Clip* ) ) );
+    connect( m_watchedMedia, &Media::decodeSpeedChanged, this, &ClipMetadataDisplayer::updateDecodeSpeed );
     metadataUpdated();
 }
 
 void
 ClipMetadataDisplayer::updateInterface()
 {
-    bool visible = m_watchedMedia->input()->hasVideo();
+    bool visible = m_watchedMedia->info().nbVideoTracks > 0;
     m_ui->fpsLabel->setVisible( visible );
     m_ui->fpsValueLabel->setVisible( visible );
     m_ui->resolutionLabel->setVisible( visible );
     m_ui->resolutionValueLabel->setVisible( visible );
+    m_ui->decodeSpeedLabel->setVisible( visible );
+    m_ui->decodeSpeedValueLabel->setVisible( visible );
 }
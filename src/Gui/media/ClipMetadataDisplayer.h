@@ -48,6 +48,12 @@ class ClipMetadataDisplayer : public QWidget
          *              file type.
          */
         void                            updateInterface();
+        /**
+         *  \brief      Shows the decoding speed, and offers to optimize the media when
+         *              it's too slow. \sa DecodeBenchmarkService
+         */
+        void                            updateDecodeSpeed();
+        void                            optimize();
     private:
         Ui::ClipMetadataDisplayer       *m_ui;
         const Clip                      *m_watchedClip;
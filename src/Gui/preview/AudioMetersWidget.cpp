@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * AudioMetersWidget.cpp: Audio level meters of the project preview
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <QPainter>
+
+#include "AudioMetersWidget.h"
+#include "Workflow/AudioMeters.h"
+
+namespace
+{
+    const int   ChannelWidth = 6;
+    const int   ChannelSpacing = 2;
+    const int   MeterSpacing = 10;
+    // dBFS above which the levels are drawn in yellow, then in red
+    const float WarningDb = -18;
+    const float ClippingDb = -6;
+}
+
+AudioMetersWidget::AudioMetersWidget( AudioMeters* meters, QWidget* parent )
+    : QWidget( parent )
+    , m_meters( meters )
+{
+    setObjectName( QStringLiteral( "AudioMeters" ) );
+    setWindowTitle( tr( "Audio Meters" ) );
+    connect( m_meters, SIGNAL( levelsChanged() ), this, SLOT( update() ) );
+}
+
+AudioMetersWidget::~AudioMetersWidget()
+{
+    if ( m_meters != nullptr )
+        m_meters->setEnabled( false );
+}
+
+void
+AudioMetersWidget::setMeters( AudioMeters* meters )
+{
+    if ( m_meters != nullptr )
+    {
+        m_meters->disconnect( this );
+        m_meters->setEnabled( false );
+    }
+    m_meters = meters;
+    connect( m_meters, SIGNAL( levelsChanged() ), this, SLOT( update() ) );
+    m_meters->setEnabled( isVisible() );
+    update();
+}
+
+QSize
+AudioMetersWidget::sizeHint() const
+{
+    return QSize( 160, 200 );
+}
+
+void
+AudioMetersWidget::paintEvent( QPaintEvent* )
+{
+    QPainter    painter( this );
+    painter.fillRect( rect(), Qt::black );
+    if ( m_meters == nullptr )
+        return;
+    const auto& levels = m_meters->levels();
+    auto labelHeight = fontMetrics().height();
+    auto area = rect().adjusted( MeterSpacing / 2, MeterSpacing / 2, 0, -labelHeight - MeterSpacing / 2 );
+    auto range = float( -AudioMeters::MinimumDb );
+    auto toY = [&area, range]( float db ) {
+        return area.bottom() - static_cast<int>( ( db + range ) / range * area.height() );
+    };
+    auto color = []( float db, int alpha ) {
+        QColor c = db >= ClippingDb ? Qt::red : db >= WarningDb ? Qt::yellow : Qt::green;
+        c.setAlpha( alpha );
+        return c;
+    };
+
+    int x = area.left();
+    painter.setPen( palette().color( QPalette::BrightText ) );
+    for ( int i = 0; i < levels.size(); ++i )
+    {
+        const auto& level = levels[i];
+        auto width = level.peak.size() * ( ChannelWidth + ChannelSpacing ) - ChannelSpacing;
+        for ( int c = 0; c < level.peak.size(); ++c )
+        {
+            auto left = x + c * ( ChannelWidth + ChannelSpacing );
+            auto rmsY = toY( level.rms[c] );
+            auto peakY = toY( level.peak[c] );
+            painter.fillRect( left, peakY, ChannelWidth, area.bottom() - peakY, color( level.peak[c], 96 ) );
+            painter.fillRect( left, rmsY, ChannelWidth, area.bottom() - rmsY, color( level.rms[c], 255 ) );
+            auto holdY = toY( level.hold[c] );
+            painter.fillRect( left, holdY - 1, ChannelWidth, 2, color( level.hold[c], 255 ) );
+        }
+        auto label = i == 0 ? tr( "Master" ) : QString::number( i );
+        painter.drawText( QRect( x - MeterSpacing / 2, area.bottom() + MeterSpacing / 2,
+                                 width + MeterSpacing, labelHeight ),
+                          Qt::AlignHCenter | Qt::AlignTop, label );
+        x += width + MeterSpacing;
+    }
+}
+
+void
+AudioMetersWidget::showEvent( QShowEvent* event )
+{
+    m_meters->setEnabled( true );
+    QWidget::showEvent( event );
+}
+
+void
+AudioMetersWidget::hideEvent( QHideEvent* event )
+{
+    if ( m_meters != nullptr )
+        m_meters->setEnabled( false );
+    QWidget::hideEvent( event );
+}
@@ -0,0 +1,59 @@
+/*****************************************************************************
+ * AudioMetersWidget.h: Audio level meters of the project preview
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef AUDIOMETERSWIDGET_H
+#define AUDIOMETERSWIDGET_H
+
+#include <QPointer>
+#include <QWidget>
+
+class AudioMeters;
+
+/**
+ *  \brief  Displays the audio levels of the master and of each track.
+ *
+ *  The meters only measure anything while the widget is visible. For each channel,
+ *  the RMS is drawn as a bar, the peak over it, and the peak hold as a line.
+ */
+class AudioMetersWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit AudioMetersWidget( AudioMeters* meters, QWidget* parent = nullptr );
+    virtual ~AudioMetersWidget();
+
+    virtual QSize   sizeHint() const override;
+    // Shows the meters of another workflow, when the active project changes
+    void            setMeters( AudioMeters* meters );
+
+protected:
+    virtual void    paintEvent( QPaintEvent* event ) override;
+    virtual void    showEvent( QShowEvent* event ) override;
+    virtual void    hideEvent( QHideEvent* event ) override;
+
+private:
+    // Owned by the workflow, which may go first
+    QPointer<AudioMeters>   m_meters;
+};
+
+#endif // AUDIOMETERSWIDGET_H
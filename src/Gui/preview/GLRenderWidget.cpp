@@ -0,0 +1,224 @@
+/*****************************************************************************
+ * GLRenderWidget.cpp: Displays the preview frames through OpenGL
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "GLRenderWidget.h"
+
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QOpenGLShaderProgram>
+
+#include "Backend/IBackend.h"
+#include "Backend/IInput.h"
+#include "Backend/IProfile.h"
+#include "Tools/VlmcDebug.h"
+
+namespace
+{
+
+const char* const vertexShader =
+    "attribute vec2 position;\n"
+    "attribute vec2 texCoord;\n"
+    "varying vec2 coord;\n"
+    "void main()\n"
+    "{\n"
+    "    coord = texCoord;\n"
+    "    gl_Position = vec4( position, 0.0, 1.0 );\n"
+    "}\n";
+
+// BT.601 limited range, as rendered by MLT
+const char* const fragmentShader =
+    "#ifdef GL_ES\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "uniform sampler2D planeY;\n"
+    "uniform sampler2D planeU;\n"
+    "uniform sampler2D planeV;\n"
+    "varying vec2 coord;\n"
+    "void main()\n"
+    "{\n"
+    "    float y = 1.1644 * ( texture2D( planeY, coord ).r - 0.0627 );\n"
+    "    float u = texture2D( planeU, coord ).r - 0.5;\n"
+    "    float v = texture2D( planeV, coord ).r - 0.5;\n"
+    "    gl_FragColor = vec4( y + 1.5960 * v,\n"
+    "                         y - 0.3918 * u - 0.8130 * v,\n"
+    "                         y + 2.0172 * u, 1.0 );\n"
+    "}\n";
+
+// Full viewport quad, as a triangle strip. Textures have their origin on the first line
+const GLfloat vertices[] = { -1.f, -1.f, 1.f, -1.f, -1.f, 1.f, 1.f, 1.f };
+const GLfloat texCoords[] = { 0.f, 1.f, 1.f, 1.f, 0.f, 0.f, 1.f, 0.f };
+
+}
+
+GLRenderWidget::GLRenderWidget( QWidget* parent )
+    : QOpenGLWidget( parent )
+    , m_tap( nullptr )
+    , m_position( 0 )
+{
+}
+
+GLRenderWidget::~GLRenderWidget()
+{
+    if ( m_program == nullptr )
+        return;
+    makeCurrent();
+    glDeleteTextures( NbPlanes, m_textures );
+    m_program.reset();
+    doneCurrent();
+}
+
+bool
+GLRenderWidget::wantsImage( int64_t position )
+{
+    m_position = position;
+    return true;
+}
+
+void
+GLRenderWidget::onImage( std::shared_ptr<Backend::IVideoFrame> frame )
+{
+    if ( frame->format() != Backend::IVideoFrame::YUV420P )
+        return;
+    {
+        QMutexLocker    lock( &m_mutex );
+        if ( m_tap != nullptr && m_tap->wantsImage( m_position ) == true )
+            m_tap->onImage( frame );
+        m_pending = std::move( frame );
+    }
+    // Called from the output thread
+    QMetaObject::invokeMethod( this, "update", Qt::QueuedConnection );
+}
+
+void
+GLRenderWidget::setTap( Backend::IOutputFrameCb* tap )
+{
+    QMutexLocker    lock( &m_mutex );
+    m_tap = tap;
+}
+
+void
+GLRenderWidget::initializeGL()
+{
+    initializeOpenGLFunctions();
+
+    m_program.reset( new QOpenGLShaderProgram );
+    if ( m_program->addShaderFromSourceCode( QOpenGLShader::Vertex, vertexShader ) == false ||
+         m_program->addShaderFromSourceCode( QOpenGLShader::Fragment, fragmentShader ) == false ||
+         m_program->link() == false )
+        vlmcWarning() << "Failed to build the preview shaders:" << m_program->log();
+    m_program->bind();
+    m_program->setUniformValue( "planeY", PlaneY );
+    m_program->setUniformValue( "planeU", PlaneU );
+    m_program->setUniformValue( "planeV", PlaneV );
+    m_program->release();
+
+    glGenTextures( NbPlanes, m_textures );
+    for ( auto texture : m_textures )
+    {
+        glBindTexture( GL_TEXTURE_2D, texture );
+        // Let the sampler do the scaling
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    }
+    glBindTexture( GL_TEXTURE_2D, 0 );
+    m_frameSize = QSize();
+}
+
+void
+GLRenderWidget::upload( const Backend::IVideoFrame& frame )
+{
+    const GLsizei   widths[NbPlanes] = { (GLsizei)frame.width(), (GLsizei)frame.width() / 2,
+                                         (GLsizei)frame.width() / 2 };
+    const GLsizei   heights[NbPlanes] = { (GLsizei)frame.height(), (GLsizei)frame.height() / 2,
+                                          (GLsizei)frame.height() / 2 };
+    const QSize     size( frame.width(), frame.height() );
+    auto            data = frame.data();
+
+    // Chroma lines are rarely 4 bytes aligned
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    for ( int i = 0; i < NbPlanes; ++i )
+    {
+        glBindTexture( GL_TEXTURE_2D, m_textures[i] );
+        if ( size == m_frameSize )
+            glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, widths[i], heights[i],
+                             GL_LUMINANCE, GL_UNSIGNED_BYTE, data );
+        else
+            glTexImage2D( GL_TEXTURE_2D, 0, GL_LUMINANCE, widths[i], heights[i], 0,
+                          GL_LUMINANCE, GL_UNSIGNED_BYTE, data );
+        data += widths[i] * heights[i];
+    }
+    glBindTexture( GL_TEXTURE_2D, 0 );
+    m_frameSize = size;
+}
+
+void
+GLRenderWidget::paintGL()
+{
+    std::shared_ptr<Backend::IVideoFrame>   frame;
+    {
+        QMutexLocker    lock( &m_mutex );
+        frame = std::move( m_pending );
+    }
+    if ( frame != nullptr )
+        upload( *frame );
+
+    glClearColor( 0.f, 0.f, 0.f, 1.f );
+    glClear( GL_COLOR_BUFFER_BIT );
+    if ( m_frameSize.isEmpty() == true || m_program->isLinked() == false )
+        return;
+
+    // Letterbox the picture to the project's display aspect ratio
+    const qreal ratio = devicePixelRatioF();
+    const int   w = width() * ratio;
+    const int   h = height() * ratio;
+    const auto  aspect = Backend::instance()->profile().aspectRatio();
+    int         viewW = w;
+    int         viewH = h;
+    if ( w > h * aspect )
+        viewW = h * aspect;
+    else
+        viewH = w / aspect;
+    glViewport( ( w - viewW ) / 2, ( h - viewH ) / 2, viewW, viewH );
+
+    m_program->bind();
+    for ( int i = 0; i < NbPlanes; ++i )
+    {
+        glActiveTexture( GL_TEXTURE0 + i );
+        glBindTexture( GL_TEXTURE_2D, m_textures[i] );
+    }
+    m_program->enableAttributeArray( "position" );
+    m_program->enableAttributeArray( "texCoord" );
+    m_program->setAttributeArray( "position", vertices, 2 );
+    m_program->setAttributeArray( "texCoord", texCoords, 2 );
+    glDrawArrays( GL_TRIANGLE_STRIP, 0, 4 );
+    m_program->disableAttributeArray( "position" );
+    m_program->disableAttributeArray( "texCoord" );
+    m_program->release();
+
+    for ( int i = NbPlanes - 1; i >= 0; --i )
+    {
+        glActiveTexture( GL_TEXTURE0 + i );
+        glBindTexture( GL_TEXTURE_2D, 0 );
+    }
+}
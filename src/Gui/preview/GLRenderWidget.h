@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * GLRenderWidget.h: Displays the preview frames through OpenGL
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef GLRENDERWIDGET_H
+#define GLRENDERWIDGET_H
+
+#include <QMutex>
+#include <QOpenGLFunctions>
+#include <QOpenGLWidget>
+
+#include <memory>
+
+#include "Backend/IOutput.h"
+
+class QOpenGLShaderProgram;
+
+/**
+ *  \brief  Displays the YUV frames of an output, converting them to RGB and scaling
+ *          them to the widget on the graphics card.
+ *
+ *  The frames are received from the output thread, only the latest one is kept and
+ *  uploaded when the widget repaints.
+ */
+class GLRenderWidget : public QOpenGLWidget, protected QOpenGLFunctions,
+                       public Backend::IOutputFrameCb
+{
+    Q_OBJECT
+
+public:
+    explicit GLRenderWidget( QWidget* parent = nullptr );
+    virtual ~GLRenderWidget();
+
+    virtual bool    wantsImage( int64_t position ) override;
+    virtual void    onImage( std::shared_ptr<Backend::IVideoFrame> frame ) override;
+    /**
+     *  \brief  Hands the frames received over to tap as well, from the output thread.
+     *
+     *  Once this returns, the previous tap isn't called anymore. nullptr removes the tap.
+     */
+    void            setTap( Backend::IOutputFrameCb* tap );
+
+protected:
+    virtual void    initializeGL() override;
+    virtual void    paintGL() override;
+
+private:
+    void            upload( const Backend::IVideoFrame& frame );
+
+private:
+    enum Plane
+    {
+        PlaneY,
+        PlaneU,
+        PlaneV,
+        NbPlanes
+    };
+
+    QMutex                                  m_mutex;
+    // Last frame received, not uploaded yet. Guarded by m_mutex
+    std::shared_ptr<Backend::IVideoFrame>   m_pending;
+    // Guarded by m_mutex
+    Backend::IOutputFrameCb*                m_tap;
+    // Position of the frame being received, only used from the output thread
+    int64_t                                 m_position;
+    std::unique_ptr<QOpenGLShaderProgram>   m_program;
+    GLuint                                  m_textures[NbPlanes];
+    // Size of the frame held by the textures, empty until one is uploaded
+    QSize                                   m_frameSize;
+};
+
+#endif // GLRENDERWIDGET_H
@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * GpuContext.cpp: OpenGL contexts of the GPU rendering threads
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "GpuContext.h"
+
+#include <QApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+
+#include <memory>
+
+#include "Backend/IBackend.h"
+#include "Tools/VlmcDebug.h"
+
+namespace
+{
+// Surfaces can only be created by the GUI thread, every context renders to this one
+QOffscreenSurface*  surface = nullptr;
+}
+
+bool
+GpuContext::enable( Backend::IBackend* backend )
+{
+    if ( backend->isGpuProcessingAvailable() == false )
+    {
+        vlmcWarning() << "GPU processing isn't available, processing the effects on the CPU";
+        return false;
+    }
+    if ( surface == nullptr )
+    {
+        surface = new QOffscreenSurface;
+        surface->setParent( qApp );
+        surface->create();
+        if ( surface->isValid() == false )
+        {
+            vlmcWarning() << "Can't create an OpenGL surface, processing the effects on the CPU";
+            delete surface;
+            surface = nullptr;
+            return false;
+        }
+    }
+    return backend->setGpuProcessing( &GpuContext::makeCurrent );
+}
+
+bool
+GpuContext::makeCurrent()
+{
+    // Released with the thread, after the backend closed its OpenGL resources
+    thread_local std::unique_ptr<QOpenGLContext>    context;
+    if ( context == nullptr )
+    {
+        context.reset( new QOpenGLContext );
+        context->setFormat( surface->format() );
+        if ( context->create() == false )
+        {
+            context.reset();
+            return false;
+        }
+    }
+    return context->makeCurrent( surface );
+}
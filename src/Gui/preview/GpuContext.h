@@ -1,9 +1,9 @@
 /*****************************************************************************
- * UploaderIODevice.h: Custom IODevice for uploading mutipart data and video
+ * GpuContext.h: OpenGL contexts of the GPU rendering threads
  *****************************************************************************
- * Copyright (C) 2010 VideoLAN
+ * Copyright (C) 2008-2016 VideoLAN
  *
- * Authors: Rohit Yadav <rohityadav89 AT gmail.com>
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License
@@ -20,34 +20,30 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
-#ifndef UPLOADERIODEVICE_H
-#define UPLOADERIODEVICE_H
+#ifndef GPUCONTEXT_H
+#define GPUCONTEXT_H
 
-#include <QFile>
-#include <QIODevice>
-
-class UploaderIODevice : public QIODevice
+namespace Backend
 {
-    Q_OBJECT
+class IBackend;
+}
 
+/**
+ *  \brief  Provides the backend's rendering threads with an OpenGL context, on an
+ *          offscreen surface.
+ */
+class GpuContext
+{
 public:
-    UploaderIODevice( QObject *parent, const QString& fileName,
-                      const QByteArray& head, const QByteArray& tail );
-    ~UploaderIODevice();
-
-    void            setFile( const QString& fileName );
-    bool            openFile();
-    qint64          readData( char *data, qint64 maxlen );
-    qint64          writeData( const char *data, qint64 len );
-    qint64          size() const;
+    /**
+     *  \brief  Enables the backend's GPU processing. Must be called from the GUI thread.
+     *  \returns false if the backend or the graphics card can't process on the GPU.
+     */
+    static bool     enable( Backend::IBackend* backend );
 
 private:
-    QFile*          m_file;
-    QByteArray*     m_head;
-    QByteArray*     m_tail;
-    qint64          m_position;
-    qint64          sizepart() const;
-    qint64          sizefull() const;
+    // Called from a rendering thread
+    static bool     makeCurrent();
 };
 
-#endif // UPLOADERIODEVICE_H
+#endif // GPUCONTEXT_H
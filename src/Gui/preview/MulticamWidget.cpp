@@ -0,0 +1,156 @@
+/*****************************************************************************
+ * MulticamWidget.cpp: Angle viewer of the multicam clips
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MulticamWidget.h"
+
+#include "Library/Library.h"
+#include "Main/Core.h"
+#include "Media/Clip.h"
+#include "Media/Media.h"
+#include "Renderer/ClipRenderer.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QtMath>
+
+MulticamWidget::MulticamWidget( ClipRenderer* renderer, QWidget* parent )
+    : QWidget( parent )
+    , m_renderer( renderer )
+    , m_position( 0 )
+    , m_visible( false )
+{
+    setObjectName( QStringLiteral( "Multicam" ) );
+    setWindowTitle( tr( "Multicam" ) );
+    setMinimumSize( 200, 150 );
+    connect( renderer, &ClipRenderer::frameChanged, this, &MulticamWidget::frameChanged );
+    connect( &m_viewer, &MulticamViewer::angleReady, this, &MulticamWidget::angleReady,
+             Qt::QueuedConnection );
+}
+
+void
+MulticamWidget::frameChanged( qint64 frame, Vlmc::FrameChangedReason )
+{
+    auto clip = m_renderer != nullptr ? m_renderer->getClip() : nullptr;
+    QString path;
+    if ( clip != nullptr && clip->media()->fileType() == Media::Multicam )
+        path = clip->media()->fileInfo()->absoluteFilePath();
+    if ( path != m_viewer.multicam() )
+    {
+        m_viewer.setMulticam( path );
+        m_multicam = Tools::Multicam();
+        if ( path.isEmpty() == false )
+            Tools::Multicam::load( path, m_multicam );
+        m_images = QVector<QImage>( m_viewer.nbAngles() );
+        update();
+    }
+    if ( path.isEmpty() == true )
+        return;
+    m_position = clip->begin() + frame;
+    if ( m_visible == true )
+        m_viewer.request( m_position );
+    update();
+}
+
+void
+MulticamWidget::angleReady( int angle, qint64, const QImage& image )
+{
+    if ( angle >= m_images.size() )
+        return;
+    m_images[angle] = image;
+    update();
+}
+
+QRect
+MulticamWidget::cell( int angle ) const
+{
+    auto nbAngles = m_images.size();
+    auto columns = qCeil( qSqrt( nbAngles ) );
+    auto rows = ( nbAngles + columns - 1 ) / columns;
+    auto width = rect().width() / columns;
+    auto height = rect().height() / rows;
+    return QRect( angle % columns * width, angle / columns * height, width, height ).adjusted( 2, 2, -2, -2 );
+}
+
+void
+MulticamWidget::paintEvent( QPaintEvent* )
+{
+    QPainter    painter( this );
+    if ( m_images.isEmpty() == true )
+    {
+        painter.setPen( palette().color( QPalette::WindowText ) );
+        painter.drawText( rect(), Qt::AlignCenter | Qt::TextWordWrap,
+                          tr( "Preview a multicam clip to see its angles" ) );
+        return;
+    }
+    auto active = m_multicam.activeAngle( m_position );
+    painter.setRenderHint( QPainter::SmoothPixmapTransform );
+    for ( int i = 0; i < m_images.size(); ++i )
+    {
+        auto area = cell( i );
+        painter.fillRect( area, Qt::black );
+        if ( m_images[i].isNull() == false )
+        {
+            auto size = m_images[i].size().scaled( area.size(), Qt::KeepAspectRatio );
+            QRect target( QPoint( 0, 0 ), size );
+            target.moveCenter( area.center() );
+            painter.drawImage( target, m_images[i] );
+        }
+        painter.setPen( QPen( i == active ? Qt::red : Qt::darkGray, i == active ? 3 : 1 ) );
+        painter.drawRect( area );
+        painter.setPen( Qt::white );
+        painter.drawText( area.adjusted( 6, 4, -6, -4 ), Qt::AlignTop | Qt::AlignLeft,
+                          tr( "Angle %1" ).arg( i + 1 ) );
+    }
+}
+
+void
+MulticamWidget::mousePressEvent( QMouseEvent* event )
+{
+    auto clip = m_renderer != nullptr ? m_renderer->getClip() : nullptr;
+    if ( clip == nullptr || clip->media()->fileInfo()->absoluteFilePath() != m_viewer.multicam() )
+        return;
+    for ( int i = 0; i < m_images.size(); ++i )
+    {
+        if ( cell( i ).contains( event->pos() ) == false )
+            continue;
+        if ( Core::instance()->library()->switchAngle( clip->media(), m_position, i ) == true )
+            Tools::Multicam::load( m_viewer.multicam(), m_multicam );
+        update();
+        return;
+    }
+}
+
+void
+MulticamWidget::showEvent( QShowEvent* event )
+{
+    m_visible = true;
+    if ( m_viewer.nbAngles() > 0 )
+        m_viewer.request( m_position );
+    QWidget::showEvent( event );
+}
+
+void
+MulticamWidget::hideEvent( QHideEvent* event )
+{
+    m_visible = false;
+    QWidget::hideEvent( event );
+}
@@ -0,0 +1,75 @@
+/*****************************************************************************
+ * MulticamWidget.h: Angle viewer of the multicam clips
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MULTICAMWIDGET_H
+#define MULTICAMWIDGET_H
+
+#include <QImage>
+#include <QPointer>
+#include <QVector>
+#include <QWidget>
+
+#include "Tools/Multicam.h"
+#include "Workflow/MulticamViewer.h"
+#include "Workflow/Types.h"
+
+class ClipRenderer;
+
+/**
+ *  \brief  Shows every angle of the multicam clip being previewed, in a grid.
+ *
+ *  The angles follow the clip preview, and are only decoded while the widget is
+ *  visible. The active angle is outlined. Clicking an angle switches the program to it,
+ *  from the previewed position on. \sa MulticamViewer, Library::switchAngle()
+ */
+class MulticamWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MulticamWidget( ClipRenderer* renderer, QWidget* parent = nullptr );
+
+protected:
+    virtual void    paintEvent( QPaintEvent* event ) override;
+    virtual void    mousePressEvent( QMouseEvent* event ) override;
+    virtual void    showEvent( QShowEvent* event ) override;
+    virtual void    hideEvent( QHideEvent* event ) override;
+
+private:
+    // The rectangle of angle in the grid
+    QRect           cell( int angle ) const;
+
+private slots:
+    void            frameChanged( qint64 frame, Vlmc::FrameChangedReason reason );
+    void            angleReady( int angle, qint64 position, const QImage& image );
+
+private:
+    QPointer<ClipRenderer>  m_renderer;
+    MulticamViewer          m_viewer;
+    Tools::Multicam         m_multicam;
+    QVector<QImage>         m_images;
+    // In frames of the multicam clip
+    qint64                  m_position;
+    bool                    m_visible;
+};
+
+#endif // MULTICAMWIDGET_H
@@ -28,13 +28,17 @@
 #include <QPainter>
 #include <QPolygon>
 #include <QBrush>
+#include <QVector>
+#include <QtMath>
 #include "PreviewRuler.h"
 #include "Tools/RendererEventWatcher.h"
 
 PreviewRuler::PreviewRuler( QWidget* parent ) :
         QWidget( parent ),
         m_renderer( nullptr ),
-        m_frame( 0 )
+        m_frame( 0 ),
+        m_ticksLength( 0 ),
+        m_ticksFps( 0.0 )
 {
     setMouseTracking( true );
     m_isSliding = false;
@@ -46,110 +50,48 @@ void
 PreviewRuler::setRenderer( AbstractRenderer* renderer )
 {
     if ( m_renderer )
+    {
         m_renderer->disconnect( this );
+        m_renderer->eventWatcher()->disconnect( this );
+    }
     m_renderer = renderer;
 
-    connect( m_renderer->eventWatcher(), &RendererEventWatcher::positionChanged,
+    connect( m_renderer->eventWatcher(), &RendererEventWatcher::displayPositionChanged,
              this, &PreviewRuler::updateTimecode );
     connect( m_renderer->eventWatcher(), SIGNAL( stopped() ),
              this, SLOT( clear() ) );
     connect( m_renderer, SIGNAL( lengthChanged(qint64) ), this, SLOT( update() ) );
 }
 
+void
+PreviewRuler::resizeEvent( QResizeEvent* event )
+{
+    m_ticks = QPixmap();
+    QWidget::resizeEvent( event );
+}
+
 void
 PreviewRuler::paintEvent( QPaintEvent * event )
 {
     Q_UNUSED( event );
 
     QPainter painter( this );
-    QRect marks( 0, 3, width() - 1, MARK_LARGE + 1 );
+    qint64 length = m_renderer != nullptr ? m_renderer->length() : 0;
+    double fps = m_renderer != nullptr ? m_renderer->getFps() : 0.0;
 
-    painter.setPen( QPen( QColor( 50, 50, 50 ) ) );
-    painter.setBrush( QBrush( QColor( 50, 50, 50 ) ) );
-    painter.drawRect( marks );
+    // The ticks only depend on the size, length and fps, not on the current frame
+    if ( m_ticks.isNull() == true || m_ticksLength != length || m_ticksFps != fps )
+        renderTicks( length, fps );
+    painter.drawPixmap( 0, 0, m_ticks );
 
-    if ( m_renderer != nullptr && m_renderer->length() > 0 )
+    if ( length > 0 )
     {
-        qreal linesToDraw = 0;
-        qreal spacing = 0;
-        QRect r = marks.adjusted( 1, 0, -1, 0 );
-
-        // Draw the marks
-        if ( r.width() / 2  >= m_renderer->length() )
-        {   // Every frame
-            painter.setPen( QPen( Qt::cyan ) );
-            linesToDraw = (qreal)m_renderer->length();
-            if ( linesToDraw > 0 )
-            {
-                spacing = (qreal)r.width() / linesToDraw;
-                for ( int step = 0; step < linesToDraw; ++step )
-                    painter.drawLine( QLineF( r.left() + step * spacing, r.height() - MARK_XSMALL, r.left() + step * spacing, r.bottom() ) );
-            }
-        }
-        if ( r.width() / 2 >= ( m_renderer->length() / m_renderer->getFps() ) )
-        {   // Every second
-            painter.setPen( QPen( Qt::green ) );
-            linesToDraw = (qreal)m_renderer->length() / m_renderer->getFps();
-            if ( linesToDraw > 0 )
-            {
-                spacing = (qreal)r.width() / linesToDraw;
-                for ( int step = 0; step < linesToDraw; ++step )
-                    painter.drawLine( QLineF( r.left() + step * spacing, r.height() - MARK_XSMALL, r.left() + step * spacing, r.bottom() ) );
-            }
-        }
-        else if ( r.width() / 2 >= ( m_renderer->length() / m_renderer->getFps() / 12 ) )
-        {   // Every 5 seconds
-            painter.setPen( QPen( Qt::green ) );
-            linesToDraw = (qreal)m_renderer->length() / m_renderer->getFps() / 12;
-            if ( linesToDraw > 0 )
-            {
-                spacing = (qreal)r.width() / linesToDraw;
-                for ( int step = 0; step < linesToDraw; ++step )
-                    painter.drawLine( QLineF( r.left() + step * spacing, r.height() - MARK_SMALL, r.left() + step * spacing, r.bottom() ) );
-            }
-        }
-        if ( r.width() / 2 >= ( m_renderer->length() / m_renderer->getFps() / 60 ) )
-        {   // Every minute
-            painter.setPen( QPen( Qt::yellow ) );
-            linesToDraw = (qreal)m_renderer->length() / m_renderer->getFps() / 60;
-            if ( linesToDraw > 0 )
-            {
-                spacing = (qreal)r.width() / linesToDraw;
-                for ( int step = 0; step < linesToDraw; ++step )
-                    painter.drawLine( QLineF( r.left() + step * spacing, r.height() - MARK_MEDIUM, r.left() + step * spacing, r.bottom() ) );
-
-            }
-        }
-        else if ( r.width() / 2 >= ( m_renderer->length() / m_renderer->getFps() / 60 / 12 ) )
-        {   // Every 5 minutes
-            painter.setPen( QPen( Qt::yellow ) );
-            linesToDraw = (qreal)m_renderer->length() / m_renderer->getFps() / 60 / 12;
-            if ( linesToDraw > 0 )
-            {
-                spacing = (qreal)r.width() / linesToDraw;
-                for ( int step = 0; step < linesToDraw; ++step )
-                    painter.drawLine( QLineF( r.left() + step * spacing, r.height() - MARK_MEDIUM, r.left() + step * spacing, r.bottom() ) );
-
-            }
-        }
-        if ( r.width() / 2 >= ( m_renderer->length() / m_renderer->getFps() / 60 / 60 ) )
-        {   // Every hour
-            painter.setPen( QPen( Qt::red ) );
-            linesToDraw = (qreal)m_renderer->length() / m_renderer->getFps() / 60 / 60;
-            if ( linesToDraw > 0 )
-            {
-                spacing = (qreal)r.width() / linesToDraw;
-                for ( int step = 0; step < linesToDraw; ++step )
-                    painter.drawLine( QLineF( r.left() + step * spacing, r.height() - MARK_LARGE, r.left() + step * spacing, r.bottom() ) );
-            }
-        }
-
         // Draw the markers (if any)
         painter.setPen( QPen( Qt::green, 2 ) );
 
         if ( m_markerStart > MARKER_DEFAULT )
         {
-            int markerPos = m_markerStart * width() / m_renderer->length();
+            int markerPos = m_markerStart * width() / length;
             QPolygon marker( 4 );
             marker.setPoints( 4,
                               markerPos + 8,    1,
@@ -160,7 +102,7 @@ PreviewRuler::paintEvent( QPaintEvent * event )
         }
         if ( m_markerStop > MARKER_DEFAULT )
         {
-            int markerPos = m_markerStop * width() / m_renderer->length();
+            int markerPos = m_markerStop * width() / length;
             QPolygon marker( 4 );
             marker.setPoints( 4,
                               markerPos - 8,    1,
@@ -177,25 +119,86 @@ PreviewRuler::paintEvent( QPaintEvent * event )
     painter.setPen( QPen( Qt::white ) );
     QPolygon cursor( 3 );
 
-    int cursorPos;
+    int cursorPos = cursorPosition( m_frame );
+    cursor.setPoints( 3, cursorPos - 5, 20, cursorPos + 5, 20, cursorPos, 9 );
+    painter.setBrush( QBrush( QColor( 26, 82, 225, 255 ) ) );
+    painter.drawPolygon( cursor );
+}
 
-    if ( m_renderer != nullptr && m_renderer->length() > 0 )
+void
+PreviewRuler::renderTicks( qint64 length, double fps )
+{
+    m_ticksLength = length;
+    m_ticksFps = fps;
+    m_ticks = QPixmap( size() * devicePixelRatioF() );
+    m_ticks.setDevicePixelRatio( devicePixelRatioF() );
+    m_ticks.fill( Qt::transparent );
+
+    QPainter painter( &m_ticks );
+    QRect marks( 0, 3, width() - 1, MARK_LARGE + 1 );
+
+    painter.setPen( QPen( QColor( 50, 50, 50 ) ) );
+    painter.setBrush( QBrush( QColor( 50, 50, 50 ) ) );
+    painter.drawRect( marks );
+
+    if ( length <= 0 || fps <= 0 )
+        return;
+    QRect r = marks.adjusted( 1, 0, -1, 0 );
+    qreal seconds = (qreal)length / fps;
+
+    if ( r.width() / 2 >= length )
+        drawTicks( painter, r, length, MARK_XSMALL, Qt::cyan );                 // Every frame
+    if ( r.width() / 2 >= seconds )
+        drawTicks( painter, r, seconds, MARK_XSMALL, Qt::green );               // Every second
+    else if ( r.width() / 2 >= seconds / 12 )
+        drawTicks( painter, r, seconds / 12, MARK_SMALL, Qt::green );           // Every 5 seconds
+    if ( r.width() / 2 >= seconds / 60 )
+        drawTicks( painter, r, seconds / 60, MARK_MEDIUM, Qt::yellow );         // Every minute
+    else if ( r.width() / 2 >= seconds / 60 / 12 )
+        drawTicks( painter, r, seconds / 60 / 12, MARK_MEDIUM, Qt::yellow );    // Every 5 minutes
+    if ( r.width() / 2 >= seconds / 60 / 60 )
+        drawTicks( painter, r, seconds / 60 / 60, MARK_LARGE, Qt::red );        // Every hour
+}
+
+void
+PreviewRuler::drawTicks( QPainter& painter, const QRect& r, qreal count, int size, const QColor& color )
+{
+    if ( count <= 0 )
+        return;
+    qreal spacing = (qreal)r.width() / count;
+    QVector<QLineF> lines;
+    lines.reserve( qCeil( count ) );
+    for ( int step = 0; step < count; ++step )
     {
-        cursorPos = m_frame * width() / m_renderer->length();
+        qreal x = r.left() + step * spacing;
+        lines.append( QLineF( x, r.height() - size, x, r.bottom() ) );
     }
-    else
-        cursorPos = 0;
+    painter.setPen( QPen( color ) );
+    painter.drawLines( lines );
+}
 
-    cursorPos = qMin( qMax( cursorPos, 0 ), width() );
-    cursor.setPoints( 3, cursorPos - 5, 20, cursorPos + 5, 20, cursorPos, 9 );
-    painter.setBrush( QBrush( QColor( 26, 82, 225, 255 ) ) );
-    painter.drawPolygon( cursor );
+int
+PreviewRuler::cursorPosition( qint64 frame ) const
+{
+    int cursorPos = 0;
+    if ( m_renderer != nullptr && m_renderer->length() > 0 )
+        cursorPos = frame * width() / m_renderer->length();
+    return qMin( qMax( cursorPos, 0 ), width() );
+}
+
+QRect
+PreviewRuler::cursorRect( qint64 frame ) const
+{
+    // The cursor's polygon, plus some room for the antialiasing
+    int cursorPos = cursorPosition( frame );
+    return QRect( cursorPos - 7, 7, 15, 16 );
 }
 
 void
 PreviewRuler::mousePressEvent( QMouseEvent* event )
 {
     m_isSliding = true;
+    emit slidingChanged( true );
     if ( m_renderer->length() > 0 )
     {
         setFrame( (qreal)(event->pos().x() * m_renderer->length() ) / width(), true );
@@ -220,17 +223,24 @@ void
 PreviewRuler::mouseReleaseEvent( QMouseEvent* )
 {
     m_isSliding = false;
+    emit slidingChanged( false );
 }
 
 void
 PreviewRuler::setFrame( qint64 frame, bool broadcastEvent /*= false*/ )
 {
+    auto previous = m_frame;
     m_frame = frame;
     if ( m_isSliding && broadcastEvent == true )
     {
         emit frameChanged( frame, Vlmc::PreviewCursor );
     }
-    update();
+    // Only the cursor moves, and most frames don't even move it by a pixel
+    if ( cursorPosition( previous ) != cursorPosition( frame ) )
+    {
+        update( cursorRect( previous ) );
+        update( cursorRect( frame ) );
+    }
 }
 
 void
@@ -25,6 +25,7 @@
 
 #include <QWidget>
 #include <QPaintEvent>
+#include <QPixmap>
 #include "Renderer/AbstractRenderer.h"
 
 #define MARK_XSMALL 3
@@ -34,6 +35,9 @@
 
 #define MARKER_DEFAULT -1
 
+class QColor;
+class QPainter;
+
 class PreviewRuler : public QWidget
 {
     Q_OBJECT
@@ -56,6 +60,7 @@ public slots:
 
 protected:
     virtual void        paintEvent( QPaintEvent* event );
+    virtual void        resizeEvent( QResizeEvent* event );
     virtual void        mousePressEvent( QMouseEvent* event );
     virtual void        mouseMoveEvent( QMouseEvent* event );
     virtual void        mouseReleaseEvent( QMouseEvent * event );
@@ -64,15 +69,33 @@ private slots:
     void                updateTimecode( qint64 frames = -1 );
     void                clear();
 
+private:
+    /**
+     *  \brief  Draws the background and the ticks, which are cached until the size,
+     *          length or fps change.
+     */
+    void                renderTicks( qint64 length, double fps );
+    void                drawTicks( QPainter& painter, const QRect& r, qreal count, int size,
+                                   const QColor& color );
+    int                 cursorPosition( qint64 frame ) const;
+    QRect               cursorRect( qint64 frame ) const;
+
 private:
     AbstractRenderer*    m_renderer;
     qint64              m_frame;
     qint64              m_markerStart;
     qint64              m_markerStop;
     bool                m_isSliding;
+    QPixmap             m_ticks;
+    qint64              m_ticksLength;
+    double              m_ticksFps;
 
 signals:
     void                frameChanged( qint64, Vlmc::FrameChangedReason );
+    /**
+     *  \brief  Emitted when the user starts or stops dragging the cursor
+     */
+    void                slidingChanged( bool isSliding );
     void                timeChanged( int h, int m, int s, int f );
 };
 
@@ -27,15 +27,25 @@
 
 #include <memory>
 
+#include "Main/Core.h"
+#include "Workflow/PreviewCache.h"
 #include "Media/Clip.h"
+#include "Project/Project.h"
+#include "Settings/Settings.h"
+#include "Settings/SettingValue.h"
 #include "Renderer/ClipRenderer.h"
 #include "Backend/MLT/MLTOutput.h"
 #include "PreviewWidget.h"
 #include "PreviewRuler.h"
+#include "GLRenderWidget.h"
 #include "RenderWidget.h"
+#include "Tools/Metrics.h"
 #include "Tools/RendererEventWatcher.h"
+#include "Tools/VlmcDebug.h"
 #include "ui/PreviewWidget.h"
 
+#include <QComboBox>
+#include <QFontDatabase>
 #include <QMessageBox>
 #include <QLayout>
 
@@ -43,6 +53,8 @@ PreviewWidget::PreviewWidget( QWidget *parent )
     : QWidget( parent )
     , m_ui( new Ui::PreviewWidget )
     , m_renderer( nullptr )
+    , m_output( nullptr )
+    , m_glWidget( nullptr )
     , m_previewStopped( true )
 {
     m_ui->setupUi( this );
@@ -61,24 +73,116 @@ PreviewWidget::PreviewWidget( QWidget *parent )
     connect( m_ui->pushButtonMarkerStart, SIGNAL( clicked() ), this, SLOT( markerStartClicked() ) );
     connect( m_ui->pushButtonMarkerStop, SIGNAL( clicked() ), this, SLOT( markerStopClicked() ) );
     connect( m_ui->pushButtonCreateClip, SIGNAL( clicked() ), this, SLOT( createNewClipFromMarkers() ) );
+    connect( m_ui->pushButtonRenderRegion, &QPushButton::clicked, this, &PreviewWidget::renderRegionFromMarkers );
+    connect( m_ui->pushButtonLoop, &QPushButton::toggled, this, &PreviewWidget::updateLoop );
+
+    auto previewScale = Core::instance()->project()->settings()->value( "video/PreviewScale" );
+    connect( previewScale, &SettingValue::changed, this, &PreviewWidget::previewScaleChanged );
+    connect( m_ui->comboBoxPreviewScale, static_cast<void (QComboBox::*)( int )>( &QComboBox::activated ),
+             this, [previewScale]( int index )
+    {
+        // Full, 1/2, 1/4
+        previewScale->set( 1 << index );
+    } );
+    previewScaleChanged( previewScale->get() );
+
+    auto dropFrames = Core::instance()->settings()->value( "vlmc/PreviewDropFrames" );
+    connect( dropFrames, &SettingValue::changed, this, &PreviewWidget::framePolicyChanged );
+    auto previewThreads = Core::instance()->settings()->value( "vlmc/PreviewThreads" );
+    connect( previewThreads, &SettingValue::changed, this, &PreviewWidget::framePolicyChanged );
+    auto scrubAudio = Core::instance()->settings()->value( "vlmc/PreviewScrubAudio" );
+    connect( scrubAudio, &SettingValue::changed, this, &PreviewWidget::scrubAudioChanged );
+    auto audioBuffer = Core::instance()->settings()->value( "vlmc/PreviewAudioBuffer" );
+    connect( audioBuffer, &SettingValue::changed, this, &PreviewWidget::audioBufferChanged );
+
+    m_metricsLabel = new QLabel( this );
+    m_metricsLabel->setTextInteractionFlags( Qt::TextSelectableByMouse );
+    m_metricsLabel->setFont( QFontDatabase::systemFont( QFontDatabase::FixedFont ) );
+    m_ui->verticalLayout->addWidget( m_metricsLabel );
+    auto showMetrics = Core::instance()->settings()->value( "vlmc/PreviewMetrics" );
+    connect( showMetrics, &SettingValue::changed, m_metricsLabel, [this]( const QVariant& value )
+    {
+        m_metricsLabel->setVisible( value.toBool() );
+    } );
+    m_metricsLabel->setVisible( showMetrics->get().toBool() );
+
+    m_droppedFramesTimer.setInterval( 1000 );
+    connect( &m_droppedFramesTimer, &QTimer::timeout, this, &PreviewWidget::updateDroppedFrames );
 }
 
 PreviewWidget::~PreviewWidget()
 {
+    // The renderer owns the output, and may outlive the widget it draws to
+    if ( m_glWidget != nullptr && m_output != nullptr )
+    {
+        m_output->stop();
+        m_output->setFrameCallback( nullptr );
+    }
     delete m_ui;
 }
 
 void
 PreviewWidget::setRenderer( AbstractRenderer* renderer )
 {
-    delete m_renderer;
+    if ( m_renderer != nullptr )
+    {
+        // The project preview switches between the renderers of the open projects,
+        // which their workflows own. Only the clip renderer belongs to the widget.
+        m_renderer->stop();
+        if ( m_glWidget != nullptr && m_output != nullptr )
+        {
+            m_output->stop();
+            m_output->setFrameCallback( nullptr );
+        }
+        m_renderer->eventWatcher()->disconnect( this );
+        m_ui->rulerWidget->disconnect( m_renderer );
+        m_ui->volumeSlider->disconnect( this );
+        if ( m_renderer->parent() == this )
+            delete m_renderer;
+    }
     m_renderer = renderer;
 
     // Give the renderer to the ruler
     m_ui->rulerWidget->setRenderer( m_renderer );
-    auto output = new Backend::MLT::MLTSdlOutput;
-    output->setWindowId( (intptr_t)m_ui->renderWidget->id() );
-    m_renderer->setOutput( std::unique_ptr<Backend::IOutput>( output ) );
+    m_output = nullptr;
+    if ( VLMC_GET_BOOL( "vlmc/PreviewOpenGL" ) == true )
+    {
+        try
+        {
+            // Only the project preview is published, the clip preview would overwrite it
+            auto sharedMemory = VLMC_GET_STRING( "vlmc/PreviewSharedMemory" );
+            Backend::MLT::MLTSdlAudioOutput* output;
+            if ( sharedMemory.isEmpty() == false && renderer == Core::instance()->workflow()->renderer() )
+                output = new Backend::MLT::MLTSharedMemoryOutput( sharedMemory );
+            else
+                output = new Backend::MLT::MLTSdlAudioOutput;
+            if ( m_glWidget == nullptr )
+            {
+                m_glWidget = new GLRenderWidget( this );
+                m_glWidget->setSizePolicy( m_ui->renderWidget->sizePolicy() );
+                m_ui->verticalLayout->replaceWidget( m_ui->renderWidget, m_glWidget );
+                m_ui->renderWidget->hide();
+            }
+            output->setFrameCallback( m_glWidget, Backend::IVideoFrame::YUV420P );
+            m_output = output;
+        }
+        catch ( Backend::InvalidServiceException& )
+        {
+            vlmcWarning() << "Can't create the audio output, falling back to the native preview";
+        }
+    }
+    if ( m_output == nullptr )
+    {
+        auto output = new Backend::MLT::MLTSdlOutput;
+        output->setWindowId( (intptr_t)m_ui->renderWidget->id() );
+        m_output = output;
+    }
+    m_output->setScale( Core::instance()->project()->settings()->value( "video/PreviewScale" )->get().toInt() );
+    m_renderer->setOutput( std::unique_ptr<Backend::IOutput>( m_output ) );
+    framePolicyChanged();
+    scrubAudioChanged();
+    audioBufferChanged();
+    updateDroppedFrames();
 
 #if defined ( Q_OS_MAC )
     /* Releases the NSView in the RenderWidget*/
@@ -90,9 +194,12 @@ PreviewWidget::setRenderer( AbstractRenderer* renderer )
     connect( renderer->eventWatcher(), SIGNAL( playing() ), this, SLOT( videoPlaying() ) );
     connect( renderer->eventWatcher(), SIGNAL( errorEncountered() ), this, SLOT( error() ) );
     connect( renderer->eventWatcher(), SIGNAL( volumeChanged() ), this, SLOT( volumeChanged() ) );
+    connect( renderer->eventWatcher(), SIGNAL( audioUnderrun( quint32 ) ), this, SLOT( audioUnderrun() ) );
 
     connect( m_ui->rulerWidget, SIGNAL( frameChanged(qint64, Vlmc::FrameChangedReason) ),
              m_renderer,       SLOT( previewWidgetCursorChanged(qint64) ) );
+    connect( m_ui->rulerWidget, SIGNAL( slidingChanged(bool) ),
+             m_renderer,       SLOT( setScrubbing(bool) ) );
 
     connect( m_ui->volumeSlider, SIGNAL( valueChanged ( int ) ),
              this, SLOT( updateVolume( int ) ) );
@@ -100,12 +207,21 @@ PreviewWidget::setRenderer( AbstractRenderer* renderer )
              this, SLOT( updateVolume( int ) ) );
 }
 
+bool
+PreviewWidget::setFrameTap( Backend::IOutputFrameCb* tap )
+{
+    if ( m_glWidget == nullptr )
+        return false;
+    m_glWidget->setTap( tap );
+    return true;
+}
+
 void
 PreviewWidget::setClipEdition( bool enable )
 {
-    m_ui->pushButtonMarkerStart->setVisible( enable );
-    m_ui->pushButtonMarkerStop->setVisible( enable );
+    // The sequence preview uses the markers to choose what to render ahead
     m_ui->pushButtonCreateClip->setVisible( enable );
+    m_ui->pushButtonRenderRegion->setVisible( enable == false );
 }
 
 void
@@ -138,6 +254,26 @@ PreviewWidget::on_pushButtonPlay_clicked()
     m_renderer->togglePlayPause();
 }
 
+void
+PreviewWidget::shuttleReverse()
+{
+    m_previewStopped = false;
+    m_renderer->shuttle( -1 );
+}
+
+void
+PreviewWidget::shuttlePause()
+{
+    m_renderer->shuttle( 0 );
+}
+
+void
+PreviewWidget::shuttleForward()
+{
+    m_previewStopped = false;
+    m_renderer->shuttle( 1 );
+}
+
 void
 PreviewWidget::videoPaused()
 {
@@ -148,12 +284,15 @@ void
 PreviewWidget::videoStopped()
 {
     m_ui->pushButtonPlay->setIcon( QIcon( ":/images/play" ) );
+    m_droppedFramesTimer.stop();
+    updateDroppedFrames();
 }
 
 void
 PreviewWidget::videoPlaying()
 {
     m_ui->pushButtonPlay->setIcon( QIcon( ":/images/pause" ) );
+    m_droppedFramesTimer.start();
 }
 
 void
@@ -217,6 +356,7 @@ PreviewWidget::markerStartClicked()
     {
         m_ui->rulerWidget->hideMarker( PreviewRuler::Stop );;
     }
+    updateLoop();
 }
 
 void
@@ -229,6 +369,7 @@ PreviewWidget::markerStopClicked()
     {
         m_ui->rulerWidget->hideMarker( PreviewRuler::Start );;
     }
+    updateLoop();
 }
 
 void
@@ -257,6 +398,41 @@ PreviewWidget::createNewClipFromMarkers()
         delete part;
 }
 
+void
+PreviewWidget::renderRegionFromMarkers()
+{
+    qint64  beg;
+    qint64  end;
+    if ( markedRegion( beg, end ) == true )
+        Core::instance()->workflow()->previewCache()->addRegion( beg, end );
+}
+
+void
+PreviewWidget::updateLoop()
+{
+    if ( m_renderer == nullptr )
+        return;
+    qint64  beg;
+    qint64  end;
+    if ( m_ui->pushButtonLoop->isChecked() == true && markedRegion( beg, end ) == true )
+        m_renderer->setLoop( beg, end );
+    else
+        m_renderer->setLoop( 0, 0 );
+}
+
+bool
+PreviewWidget::markedRegion( qint64& begin, qint64& end ) const
+{
+    begin = m_ui->rulerWidget->getMarker( PreviewRuler::Start );
+    end = m_ui->rulerWidget->getMarker( PreviewRuler::Stop );
+
+    if ( begin < 0 && end < 0 )
+        return false;
+    begin = begin < 0 ? 0 : begin;
+    end = end < 0 ? m_renderer->length() : end + 1;
+    return end > begin;
+}
+
 void
 PreviewWidget::error()
 {
@@ -264,3 +440,70 @@ PreviewWidget::error()
                           tr( "An error occurred while rendering.\nPlease check your VLC installation"
                               " before reporting the issue.") );
 }
+
+void
+PreviewWidget::previewScaleChanged( const QVariant& divisor )
+{
+    auto d = divisor.toInt();
+    m_ui->comboBoxPreviewScale->setCurrentIndex( d >= 8 ? 3 : ( d >= 4 ? 2 : ( d >= 2 ? 1 : 0 ) ) );
+    if ( m_output != nullptr )
+        m_output->setScale( d );
+}
+
+void
+PreviewWidget::framePolicyChanged()
+{
+    bool dropFrames = VLMC_GET_BOOL( "vlmc/PreviewDropFrames" );
+    if ( m_output != nullptr )
+        m_output->setFramePolicy( dropFrames == true ? Backend::MLT::MLTPreviewOutput::DropLateFrames
+                                                     : Backend::MLT::MLTPreviewOutput::EveryFrame,
+                                  VLMC_GET_INT( "vlmc/PreviewThreads" ) );
+    // Nothing to count when every frame is shown
+    m_ui->labelDroppedFrames->setVisible( dropFrames );
+}
+
+void
+PreviewWidget::scrubAudioChanged()
+{
+    if ( m_output != nullptr )
+        m_output->setScrubAudio( VLMC_GET_BOOL( "vlmc/PreviewScrubAudio" ) );
+}
+
+void
+PreviewWidget::audioBufferChanged()
+{
+    m_audioBufferGrowth.invalidate();
+    if ( m_output != nullptr )
+        m_output->setAudioBuffer( VLMC_GET_INT( "vlmc/PreviewAudioBuffer" ) );
+}
+
+void
+PreviewWidget::audioUnderrun()
+{
+    // In ms. Past it, starting the preview lags noticeably
+    static const int    MaxAdaptiveBuffer = 500;
+    if ( m_output == nullptr || VLMC_GET_BOOL( "vlmc/PreviewAdaptiveAudioBuffer" ) == false )
+        return;
+    // The consumer restarts with the new buffer, which may itself cause an underrun
+    if ( m_audioBufferGrowth.isValid() == true && m_audioBufferGrowth.elapsed() < 1000 )
+        return;
+    auto current = m_output->audioBuffer();
+    if ( current >= MaxAdaptiveBuffer )
+        return;
+    m_output->setAudioBuffer( qMin( current * 2 + 1, MaxAdaptiveBuffer ) );
+    m_audioBufferGrowth.start();
+    vlmcDebug() << "The preview audio ran dry, its buffer is now" << m_output->audioBuffer() << "ms";
+}
+
+void
+PreviewWidget::updateDroppedFrames()
+{
+    if ( m_output == nullptr )
+        return;
+    auto dropped = m_output->droppedFrames();
+    m_ui->labelDroppedFrames->setText( tr( "%n dropped", "", dropped ) );
+    Tools::Metrics::gauge( "playback.droppedFrames" ).set( dropped );
+    if ( m_metricsLabel->isVisible() == true )
+        m_metricsLabel->setText( Tools::Metrics::toText( "playback." ) + '\n' +
+                                 tr( "decode " ) + Tools::Metrics::toText( "decode." ) );
+}
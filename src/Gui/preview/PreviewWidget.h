@@ -24,12 +24,25 @@
 #ifndef PREVIEWWIDGET_H
 #define PREVIEWWIDGET_H
 
+#include <QElapsedTimer>
+#include <QLabel>
+#include <QTimer>
 #include <QWidget>
 #include "Workflow/MainWorkflow.h"
 
 class AbstractRenderer;
+class GLRenderWidget;
 class RendererEventWatcher;
 
+namespace Backend
+{
+class IOutputFrameCb;
+namespace MLT
+{
+class MLTPreviewOutput;
+}
+}
+
 namespace Ui {
     class PreviewWidget;
 }
@@ -48,17 +61,42 @@ public:
      * @brief setClipEdition Allows to enable/disable markers & create clip buttons
      */
     void                    setClipEdition( bool enable );
+    /**
+     *  \brief Reads the region between the markers, end excluded. A missing marker
+     *         stands for the beginning, or the end.
+     *  \returns false if no marker is set.
+     */
+    bool                    markedRegion( qint64& begin, qint64& end ) const;
+    /**
+     *  \brief Hands the frames displayed over to tap as well, from the output thread.
+     *  \returns false if the preview isn't displayed through OpenGL, which is the only
+     *          one exposing its frames.
+     */
+    bool                    setFrameTap( Backend::IOutputFrameCb* tap );
 
 private:
     Ui::PreviewWidget*      m_ui;
     AbstractRenderer*        m_renderer;
+    // Owned by m_renderer
+    Backend::MLT::MLTPreviewOutput* m_output;
+    // Replaces the native render widget when the preview is displayed through OpenGL
+    GLRenderWidget*         m_glWidget;
+    // Refreshes the dropped frames counter while playing
+    QTimer                  m_droppedFramesTimer;
+    // Displays the playback metrics, when enabled in the preferences
+    QLabel*                 m_metricsLabel;
     bool                    m_previewStopped;
+    // Since the audio buffer was last grown after underruns
+    QElapsedTimer           m_audioBufferGrowth;
 
 protected:
     virtual void    changeEvent( QEvent *e );
 
 public slots:
     void            stop();
+    void            shuttleReverse();
+    void            shuttlePause();
+    void            shuttleForward();
 
 private slots:
     void            on_pushButtonPlay_clicked();
@@ -74,7 +112,17 @@ private slots:
     void            markerStartClicked();
     void            markerStopClicked();
     void            createNewClipFromMarkers();
+    void            renderRegionFromMarkers();
+    // Loops the playback between the markers while the loop button is checked
+    void            updateLoop();
     void            error();
+    void            previewScaleChanged( const QVariant& divisor );
+    void            framePolicyChanged();
+    void            scrubAudioChanged();
+    void            audioBufferChanged();
+    // Grows the audio buffer, when adapting it is enabled
+    void            audioUnderrun();
+    void            updateDroppedFrames();
 };
 
 #endif // PREVIEWWIDGET_H
@@ -0,0 +1,258 @@
+/*****************************************************************************
+ * ScopesWidget.cpp: Video scopes of the project preview
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <QComboBox>
+#include <QPainter>
+#include <QRunnable>
+#include <QVBoxLayout>
+#include <QtMath>
+
+#include <algorithm>
+#include <functional>
+
+#include "ScopesWidget.h"
+#include "PreviewWidget.h"
+#include "Backend/IInput.h"
+#include "Tools/FramePool.h"
+#include "Tools/VideoScopes.h"
+
+namespace
+{
+
+class ScopesJob : public QRunnable
+{
+public:
+    explicit ScopesJob( std::function<void()> job )
+        : m_job( std::move( job ) )
+    {
+    }
+
+    virtual void run() override
+    {
+        m_job();
+    }
+
+private:
+    std::function<void()>   m_job;
+};
+
+// Counts are displayed on a square root scale, for the sparse values to show up
+QVector<uchar>
+intensities( const std::vector<uint32_t>& counts )
+{
+    QVector<uchar> res( counts.size() );
+    auto max = std::max_element( counts.begin(), counts.end() );
+    if ( max == counts.end() || *max == 0 )
+        return res;
+    auto scale = 255.0 / qSqrt( *max );
+    for ( size_t i = 0; i < counts.size(); ++i )
+        res[i] = qMin( 255, qRound( qSqrt( counts[i] ) * scale ) );
+    return res;
+}
+
+}
+
+ScopesWidget::ScopesWidget( PreviewWidget* preview, QWidget* parent )
+    : QWidget( parent )
+    , m_preview( preview )
+    , m_visible( false )
+    , m_busy( false )
+    , m_available( false )
+{
+    setObjectName( QStringLiteral( "Scopes" ) );
+    setWindowTitle( tr( "Scopes" ) );
+    m_scope = new QComboBox( this );
+    m_scope->addItem( tr( "Waveform" ), Waveform );
+    m_scope->addItem( tr( "Vectorscope" ), Vectorscope );
+    m_scope->addItem( tr( "Histogram" ), Histogram );
+    connect( m_scope, SIGNAL( currentIndexChanged( int ) ), this, SLOT( update() ) );
+    auto layout = new QVBoxLayout( this );
+    layout->addWidget( m_scope );
+    layout->addStretch();
+    setMinimumSize( 200, 150 );
+
+    m_pool.setMaxThreadCount( 1 );
+    m_available = m_preview->setFrameTap( this );
+}
+
+ScopesWidget::~ScopesWidget()
+{
+    // Once the tap is removed, onImage can't start a new analysis
+    if ( m_preview != nullptr )
+        m_preview->setFrameTap( nullptr );
+    m_pool.waitForDone();
+}
+
+bool
+ScopesWidget::wantsImage( int64_t )
+{
+    if ( m_visible == false || m_busy == true )
+        return false;
+    auto now = std::chrono::steady_clock::now();
+    if ( now - m_lastAnalysis < std::chrono::milliseconds( 1000 / MaxRate ) )
+        return false;
+    m_lastAnalysis = now;
+    return true;
+}
+
+void
+ScopesWidget::onImage( std::shared_ptr<Backend::IVideoFrame> frame )
+{
+    if ( m_busy.exchange( true ) == true )
+        return;
+    m_pool.start( new ScopesJob( [this, frame] {
+        analyze( *frame );
+        m_busy = false;
+    } ) );
+}
+
+void
+ScopesWidget::analyze( const Backend::IVideoFrame& frame )
+{
+    Tools::ScopeData data;
+    auto rowStep = qMax( 1u, frame.height() / AnalyzedLines );
+    if ( Tools::computeScopes( frame, rowStep, WaveformColumns, data ) == false )
+        return;
+    const int levels = Tools::ScopeData::Levels;
+
+    // Level 0 at the bottom of the waveform, and v = 0 at the bottom of the vectorscope
+    // Rebuilt for every analyzed frame, the buffers come from the pool
+    auto waveform = Tools::FramePool::image( data.columns, levels, QImage::Format_RGB32 );
+    auto wave = intensities( data.waveform );
+    for ( int level = 0; level < levels; ++level )
+    {
+        auto line = reinterpret_cast<QRgb*>( waveform.scanLine( levels - 1 - level ) );
+        for ( uint32_t column = 0; column < data.columns; ++column )
+        {
+            auto i = wave[column * levels + level];
+            line[column] = qRgb( i / 3, i, i / 3 );
+        }
+    }
+
+    auto vectorscope = Tools::FramePool::image( levels, levels, QImage::Format_RGB32 );
+    auto vector = intensities( data.vectorscope );
+    for ( int v = 0; v < levels; ++v )
+    {
+        auto line = reinterpret_cast<QRgb*>( vectorscope.scanLine( levels - 1 - v ) );
+        for ( int u = 0; u < levels; ++u )
+        {
+            auto i = vector[v * levels + u];
+            line[u] = qRgb( i, i, i );
+        }
+    }
+
+    // The components are added, their overlaps show their mixed colors
+    const int height = 128;
+    auto histogram = Tools::FramePool::image( levels, height, QImage::Format_RGB32 );
+    histogram.fill( Qt::black );
+    uint32_t max = 1;
+    for ( const auto& component : data.histogram )
+        max = qMax( max, *std::max_element( component, component + levels ) );
+    for ( int c = 0; c < 3; ++c )
+    {
+        const QRgb mask = 0xff0000 >> ( c * 8 );
+        for ( int x = 0; x < levels; ++x )
+        {
+            auto barHeight = static_cast<int>( static_cast<uint64_t>( data.histogram[c][x] ) * height / max );
+            for ( int y = height - barHeight; y < height; ++y )
+            {
+                auto pixel = reinterpret_cast<QRgb*>( histogram.scanLine( y ) ) + x;
+                *pixel |= mask;
+            }
+        }
+    }
+    QMetaObject::invokeMethod( this, "scopesReady", Qt::QueuedConnection,
+                               Q_ARG( QImage, waveform ), Q_ARG( QImage, vectorscope ),
+                               Q_ARG( QImage, histogram ) );
+}
+
+void
+ScopesWidget::scopesReady( const QImage& waveform, const QImage& vectorscope,
+                           const QImage& histogram )
+{
+    m_images[Waveform] = waveform;
+    m_images[Vectorscope] = vectorscope;
+    m_images[Histogram] = histogram;
+    update();
+}
+
+void
+ScopesWidget::paintEvent( QPaintEvent* )
+{
+    QPainter    painter( this );
+    auto area = rect().adjusted( 4, m_scope->geometry().bottom() + 4, -4, -4 );
+    painter.fillRect( area, Qt::black );
+    if ( m_available == false )
+    {
+        painter.setPen( palette().color( QPalette::WindowText ) );
+        painter.drawText( area, Qt::AlignCenter | Qt::TextWordWrap,
+                          tr( "The scopes need the preview to be displayed with OpenGL, "
+                              "which can be enabled in the preferences" ) );
+        return;
+    }
+    auto scope = m_scope->currentData().toInt();
+    const auto& image = m_images[scope];
+    if ( image.isNull() == true )
+        return;
+    if ( scope == Vectorscope )
+    {
+        auto side = qMin( area.width(), area.height() );
+        area = QRect( area.center().x() - side / 2, area.center().y() - side / 2, side, side );
+    }
+    painter.setRenderHint( QPainter::SmoothPixmapTransform );
+    painter.drawImage( area, image );
+
+    painter.setPen( QColor( 255, 255, 255, 96 ) );
+    if ( scope == Waveform )
+    {
+        // The nominal range of the limited range luma
+        for ( auto level : { 16, 235 } )
+        {
+            auto y = area.bottom() - level * area.height() / 255;
+            painter.drawLine( area.left(), y, area.right(), y );
+        }
+    }
+    else if ( scope == Vectorscope )
+    {
+        painter.drawEllipse( area );
+        painter.drawLine( area.center().x(), area.top(), area.center().x(), area.bottom() );
+        painter.drawLine( area.left(), area.center().y(), area.right(), area.center().y() );
+    }
+}
+
+void
+ScopesWidget::showEvent( QShowEvent* event )
+{
+    m_visible = true;
+    QWidget::showEvent( event );
+}
+
+void
+ScopesWidget::hideEvent( QHideEvent* event )
+{
+    m_visible = false;
+    QWidget::hideEvent( event );
+}
@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * ScopesWidget.h: Video scopes of the project preview
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SCOPESWIDGET_H
+#define SCOPESWIDGET_H
+
+#include <QImage>
+#include <QPointer>
+#include <QThreadPool>
+#include <QWidget>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "Backend/IOutput.h"
+
+class QComboBox;
+class PreviewWidget;
+
+/**
+ *  \brief  Displays the luma waveform, the vectorscope or the RGB histogram of the
+ *          frames shown by a preview.
+ *
+ *  The frames are tapped from the preview output. The scopes are computed on a
+ *  worker thread, over a subset of the lines, at most MaxRate times a second and
+ *  only while the widget is visible. Frames arriving while a computation is running
+ *  are skipped rather than queued, so the preview never waits for the scopes.
+ */
+class ScopesWidget : public QWidget, public Backend::IOutputFrameCb
+{
+    Q_OBJECT
+
+public:
+    enum Scope
+    {
+        Waveform,
+        Vectorscope,
+        Histogram,
+        NbScopes
+    };
+
+    explicit ScopesWidget( PreviewWidget* preview, QWidget* parent = nullptr );
+    virtual ~ScopesWidget();
+
+    // Called from the output thread
+    virtual bool    wantsImage( int64_t position ) override;
+    virtual void    onImage( std::shared_ptr<Backend::IVideoFrame> frame ) override;
+
+protected:
+    virtual void    paintEvent( QPaintEvent* event ) override;
+    virtual void    showEvent( QShowEvent* event ) override;
+    virtual void    hideEvent( QHideEvent* event ) override;
+
+private:
+    // Runs on the worker thread
+    void            analyze( const Backend::IVideoFrame& frame );
+
+private slots:
+    void            scopesReady( const QImage& waveform, const QImage& vectorscope,
+                                 const QImage& histogram );
+
+private:
+    static const int        MaxRate = 10;
+    // Lines of each frame analyzed, at most
+    static const uint32_t   AnalyzedLines = 180;
+    static const uint32_t   WaveformColumns = 360;
+
+    QPointer<PreviewWidget> m_preview;
+    QComboBox*              m_scope;
+    // A single worker, the frames are analyzed one at a time
+    QThreadPool             m_pool;
+    std::atomic<bool>       m_visible;
+    std::atomic<bool>       m_busy;
+    // Only used from the output thread
+    std::chrono::steady_clock::time_point   m_lastAnalysis;
+    QImage                  m_images[NbScopes];
+    // Whether the preview exposes its frames
+    bool                    m_available;
+};
+
+#endif // SCOPESWIDGET_H
@@ -47,10 +47,27 @@
 PreferenceWidget::PreferenceWidget( const QString &name, const char *label, Settings* settings,
                                     QWidget *parent ) :
     QScrollArea( parent ),
-    m_category( label )
+    m_category( label ),
+    m_name( name ),
+    m_source( settings )
+{
+    setWidgetResizable( true );
+    setFrameStyle( QFrame::NoFrame );
+}
+
+void
+PreferenceWidget::showEvent( QShowEvent *e )
+{
+    if ( widget() == nullptr )
+        build();
+    QScrollArea::showEvent( e );
+}
+
+void
+PreferenceWidget::build()
 {
     QWidget     *container = new QWidget( this );
-    Settings::SettingList    settingList = settings->group( name );
+    Settings::SettingList    settingList = m_source->group( m_name );
     QFormLayout *layout = new QFormLayout( container );
     layout->setFieldGrowthPolicy( QFormLayout::AllNonFixedFieldsGrow );
 
@@ -69,8 +86,6 @@ PreferenceWidget::PreferenceWidget( const QString &name, const char *label, Sett
     }
 
     setWidget( container );
-    setWidgetResizable( true );
-    setFrameStyle( QFrame::NoFrame );
 }
 
 ISettingsCategoryWidget*
@@ -111,6 +126,16 @@ PreferenceWidget::save()
 void
 PreferenceWidget::reset()
 {
+    // Never shown, there's no widget to update
+    if ( widget() == nullptr )
+    {
+        foreach ( SettingValue* s, m_source->group( m_name ) )
+        {
+            if ( ( s->flags() & SettingValue::Private ) == 0 )
+                s->restoreDefault();
+        }
+        return;
+    }
     foreach ( ISettingsCategoryWidget* w, m_settings )
         w->setting()->restoreDefault();
     discard();
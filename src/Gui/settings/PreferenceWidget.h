@@ -34,7 +34,14 @@ class   ISettingsCategoryWidget;
 class   SettingValue;
 class   QLabel;
 class   QEvent;
+class   QShowEvent;
 
+/**
+ *  \brief  The panel of a settings category.
+ *
+ *  The widgets of its settings are created the first time it gets shown, and kept
+ *  until the dialog is destroyed: a panel which is never viewed costs nothing.
+ */
 class   PreferenceWidget : public QScrollArea
 {
     Q_OBJECT
@@ -49,13 +56,17 @@ class   PreferenceWidget : public QScrollArea
         const char      *category() const;
     protected:
         void            changeEvent( QEvent *e );
+        void            showEvent( QShowEvent *e );
 
     private:
+        void            build();
         ISettingsCategoryWidget        *widgetFactory( SettingValue* s );
         void            retranslateUi();
 
     private:
         const char                  *m_category;
+        const QString               m_name;
+        Settings                    *m_source;
         SettingsList                m_settings;
         QHash<SettingValue*, QLabel*>  m_labels;
 };
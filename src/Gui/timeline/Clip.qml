@@ -36,6 +36,17 @@ Rectangle {
     property bool selected: false
 
     property var clipInfo
+    // The delegates are loaded in their track, but aren't its direct children
+    readonly property Item trackItem: track
+    // Bumped once the peaks are computed, to reload the waveform
+    property int waveformRevision: 0
+    // Clips being dragged around stay rendered wherever they go
+    readonly property bool inViewport: visibleClips[uuid] === true || dragArea.drag.active
+    // Narrower clips are drawn by TrackRenderer instead, until zoomed back in
+    readonly property bool detailed: width >= lodWidth || selected || dragArea.drag.active ||
+                                     uuid === "videoUuid" || uuid === "audioUuid"
+
+    visible: detailed
 
     function setPixelPosition( pixels )
     {
@@ -61,7 +72,7 @@ Rectangle {
 
     function selectLinkedClip() {
         if ( selected === true && linked === true && linkedClip )
-            findClipItem( linkedClip ).selected = true;
+            selectClip( linkedClip );
     }
 
     function updateEffects( clipInfo ) {
@@ -77,10 +88,22 @@ Rectangle {
         effectsItem.text = str;
     }
 
+    // The provider is asynchronous: it queues the thumbnail itself when it isn't cached,
+    // so only ask for it once the clip is visible.
+    function requestThumbnail() {
+        if ( uuid === "videoUuid" || uuid === "audioUuid" || inViewport === false || detailed === false )
+            return;
+        updateThumbnail( begin );
+    }
+
     function updateThumbnail( pos ) {
         thumbnailSource = "image://thumbnail/" + uuid + "/" + pos;
     }
 
+    function updateWaveform() {
+        ++waveformRevision;
+    }
+
     onXChanged: {
         if ( sView.width - initPosOfCursor < width )
             return;
@@ -157,6 +180,10 @@ Rectangle {
     }
 
     onSelectedChanged: {
+        // Keeps the delegate loaded while selected
+        if ( clipInfo && clipInfo["selected"] !== selected )
+            clipInfo["selected"] = selected;
+
         for ( var i = 0; i < selectedClips.length; ++i )
             if ( !selectedClips[i] || selectedClips[i] === clip ) {
                 selectedClips.splice( i, 1 );
@@ -166,12 +193,9 @@ Rectangle {
         if ( selected === true ) {
             selectedClips.push( clip );
 
-            var group = findGroup( uuid );
-            for ( i = 0; i < ( group ? group.length : 0 ); ++i ) {
-                var clipItem = findClipItem( group[i] );
-                if ( clipItem )
-                    clipItem.selected = true;
-            }
+            var group = workflow.clipGroup( uuid );
+            for ( i = 0; i < group.length; ++i )
+                selectClip( group[i] );
             selectLinkedClip();
         }
     }
@@ -185,14 +209,18 @@ Rectangle {
         allClips.push( clip );
 
         updateEffects( workflow.clipInfo( uuid ) );
+        requestThumbnail();
+    }
 
-        if ( uuid === "videoUuid" || uuid === "audioUuid" )
-            return;
+    // Scrolled into view before the thumbnail was ever requested
+    onInViewportChanged: {
+        if ( inViewport === true && thumbnailImage.status === Image.Null )
+            requestThumbnail();
+    }
 
-        if ( thumbnailProvider.hasImage( uuid, begin ) )
-            updateThumbnail( begin );
-        else
-            workflow.takeThumbnail( uuid, begin );
+    onDetailedChanged: {
+        if ( detailed === true && thumbnailImage.status === Image.Null )
+            requestThumbnail();
     }
 
     Component.onDestruction: {
@@ -240,7 +268,24 @@ Rectangle {
         anchors.topMargin: 4
         anchors.bottomMargin: 4
         fillMode: Image.PreserveAspectFit
-        visible: width < clip.width
+        sourceSize.height: height
+        visible: inViewport && width < clip.width
+    }
+
+    Image {
+        id: waveformImage
+        anchors.left: clip.left
+        anchors.right: clip.right
+        anchors.top: text.bottom
+        anchors.bottom: effectsItem.visible ? effectsItem.top : clip.bottom
+        anchors.topMargin: 4
+        anchors.bottomMargin: 4
+        visible: inViewport && type === "Audio" && uuid !== "audioUuid"
+        cache: false
+        fillMode: Image.Stretch
+        sourceSize.width: width
+        sourceSize.height: height
+        source: visible ? "image://waveform/" + uuid + "/" + begin + "/" + end + "/" + waveformRevision : ""
     }
 
     MouseArea {
@@ -306,14 +351,15 @@ Rectangle {
 
         onClicked: {
             if ( mouse.button & Qt.RightButton ) {
-                clipContextMenu.popup();
+                clipContextMenuLoader.active = true;
+                clipContextMenuLoader.item.popup();
             }
             else if ( isCutMode === true ) {
                 var newClipPos = position + ptof( mouseX );
                 var newClipBegin = begin + ptof( mouseX );
                 if ( newClipPos - position < 1 || end - newClipBegin < 1 )
                     return;
-                workflow.splitClip( uuid, newClipPos, newClipBegin );
+                workflow.splitClipAt( uuid, [ newClipPos ] );
             }
         }
 
@@ -416,9 +462,13 @@ Rectangle {
         ]
     }
 
-    ClipContextMenu {
-        id: clipContextMenu
-        clip: clip
+    // Only built once needed: a menu per clip is a lot of items
+    Loader {
+        id: clipContextMenuLoader
+        active: false
+        sourceComponent: ClipContextMenu {
+            clip: clip
+        }
     }
 
     states: [
@@ -8,6 +8,7 @@ Menu {
 
     property var clip
     property bool grouped
+    property bool renderedInPlace
 
     MenuItem {
         text: grouped ? "Ungroup" : "Group"
@@ -17,14 +18,14 @@ Menu {
                 return;
 
             if ( grouped === true ) {
-                removeGroup( clip.uuid );
+                workflow.ungroupClips( clip.uuid );
             }
             else {
                 var l = [];
                 for ( var i = 0; i < selectedClips.length; ++i ) {
                     l.push( "" + selectedClips[i].uuid );
                 }
-                addGroup( l );
+                workflow.groupClips( l );
             }
         }
     }
@@ -37,6 +38,36 @@ Menu {
         }
     }
 
+    MenuItem {
+        text: "Sync Audio"
+        enabled: selectedClips.length > 1
+
+        onTriggered: {
+            // Aligned on the clip the menu was opened on
+            var l = [ "" + clip.uuid ];
+            for ( var i = 0; i < selectedClips.length; ++i ) {
+                if ( selectedClips[i].uuid !== clip.uuid )
+                    l.push( "" + selectedClips[i].uuid );
+            }
+            if ( workflow.syncClips( l ).length > 0 )
+                syncFailedDialog.visible = true;
+        }
+    }
+
+    MenuItem {
+        text: "Nest Clips"
+
+        onTriggered: {
+            var l = [ "" + clip.uuid ];
+            for ( var i = 0; i < selectedClips.length; ++i ) {
+                if ( selectedClips[i].uuid !== clip.uuid )
+                    l.push( "" + selectedClips[i].uuid );
+            }
+            if ( workflow.nestClips( l ).length === 0 )
+                nestFailedDialog.visible = true;
+        }
+    }
+
     MenuSeparator { }
 
     MenuItem {
@@ -58,8 +89,25 @@ Menu {
         }
     }
 
+    MessageDialog {
+        id: syncFailedDialog
+        title: "VLMC"
+        text: qsTr( "Some clips couldn't be synchronized: their audio doesn't match, or is still being analyzed." )
+        icon: StandardIcon.Warning
+        standardButtons: StandardButton.Ok
+    }
+
+    MessageDialog {
+        id: nestFailedDialog
+        title: "VLMC"
+        text: qsTr( "The clips couldn't be nested: other clips are in the way, or the sequence can't be written to the workspace." )
+        icon: StandardIcon.Warning
+        standardButtons: StandardButton.Ok
+    }
+
     onAboutToShow: {
-        grouped = findGroup( clip.uuid );
+        grouped = workflow.clipGroup( clip.uuid ).length > 0;
+        renderedInPlace = workflow.isRenderedInPlace( clip.uuid );
     }
 
     MenuSeparator { }
@@ -71,4 +119,15 @@ Menu {
             workflow.showEffectStack( clip.uuid );
         }
     }
+
+    MenuItem {
+        text: renderedInPlace ? "Revert Render" : "Render in Place"
+
+        onTriggered: {
+            if ( renderedInPlace === true )
+                workflow.revertRenderInPlace( clip.uuid );
+            else
+                workflow.renderInPlace( clip.uuid );
+        }
+    }
 }
@@ -13,6 +13,8 @@ Rectangle {
     property var markerModel
 
     onPositionChanged: {
+        if ( markerModel["position"] !== position )
+            workflow.moveMarker( markerModel["position"], position );
         markerModel["position"] = position;
         length = Math.max( length, position + 100 );
     }
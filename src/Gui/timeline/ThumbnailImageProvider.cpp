@@ -1,47 +1,244 @@
 #include "ThumbnailImageProvider.h"
 
 #include "Workflow/MainWorkflow.h"
+#include "Workflow/ThumbnailService.h"
 #include "Main/Core.h"
+#include "Settings/Settings.h"
+#include "Tools/FramePool.h"
+#include "Tools/Metrics.h"
 
-ThumbnailImageProvider::ThumbnailImageProvider()
-    : QQuickImageProvider( QQuickImageProvider::Pixmap )
+ThumbnailResponse::ThumbnailResponse( ThumbnailImageProvider* provider, const QString& id,
+                                      const QSize& requestedSize )
+    : m_provider( provider )
+    , m_id( id )
+    , m_requestedSize( requestedSize )
+    , m_done( false )
 {
-    connect( Core::instance()->workflow(), &MainWorkflow::thumbnailUpdated, this, [this]
-             ( const QString& uuid, quint32 pos, const QPixmap& pixmap )
-    {
-        auto id = uuid + "/" + QString::number( pos );
+}
 
-        auto it = m_pixMap.find( id );
-        if ( it == m_pixMap.end() )
-            m_pixMap.insert( id, pixmap );
+ThumbnailResponse::~ThumbnailResponse()
+{
+    QMutexLocker    lock( &m_provider->m_mutex );
+    m_provider->forget( this );
+}
 
-        emit imageReady( uuid, pos );
-    }, Qt::DirectConnection );
+QQuickTextureFactory*
+ThumbnailResponse::textureFactory() const
+{
+    return QQuickTextureFactory::textureFactoryForImage( m_image );
 }
 
-QPixmap
-ThumbnailImageProvider::requestPixmap( const QString& id, QSize* size, const QSize& requestedSize )
+void
+ThumbnailResponse::cancel()
+{
+    QMutexLocker    lock( &m_provider->m_mutex );
+    m_provider->forget( this );
+    if ( m_done == true )
+        return;
+    m_done = true;
+    emit finished();
+}
+
+void
+ThumbnailResponse::fulfill( const QImage& image )
+{
+    if ( m_done == true )
+        return;
+    m_image = image;
+    m_done = true;
+    // The image reader only connects to finished() once requestImageResponse() returned
+    QMetaObject::invokeMethod( this, "finished", Qt::QueuedConnection );
+}
+
+ThumbnailImageProvider::ThumbnailImageProvider()
+    : m_hits( 0 )
+    , m_misses( 0 )
+    , m_evictions( 0 )
+{
+    auto cacheSize = Core::instance()->settings()->value( "vlmc/ThumbnailCacheSize" );
+    connect( cacheSize, &SettingValue::changed, this, &ThumbnailImageProvider::setMaxCost );
+    setMaxCost( cacheSize->get() );
+
+    connect( Core::instance()->thumbnailService(), &ThumbnailService::thumbnailReady,
+             this, &ThumbnailImageProvider::thumbnailReady, Qt::DirectConnection );
+    connect( Core::instance()->thumbnailService(), &ThumbnailService::thumbnailFailed,
+             this, &ThumbnailImageProvider::thumbnailFailed, Qt::DirectConnection );
+}
+
+QQuickImageResponse*
+ThumbnailImageProvider::requestImageResponse( const QString& id, const QSize& requestedSize )
 {
     QString tmp = id;
     tmp.replace( "%7B", "{" );
     tmp.replace( "%7D", "}" );
 
-    auto it = m_pixMap.find( tmp );
-    if ( it == m_pixMap.end() )
+    auto response = new ThumbnailResponse( this, tmp, requestedSize );
+    QMutexLocker    lock( &m_mutex );
+    auto image = m_images.object( tmp );
+    if ( image != nullptr )
+    {
+        ++m_hits;
+        complete( response, *image );
+        return response;
+    }
+    ++m_misses;
+    auto& waiting = m_pending[tmp];
+    waiting << response;
+    // Already requested for another image
+    if ( waiting.count() > 1 )
+        return response;
+    lock.unlock();
+
+    auto uuid = tmp.section( '/', 0, 0 );
+    auto pos = tmp.section( '/', 1, 1 ).toUInt();
+    // The sequence is only accessed from the GUI thread
+    QMetaObject::invokeMethod( Core::instance()->workflow(), "takeThumbnail", Qt::QueuedConnection,
+                               Q_ARG( QString, uuid ), Q_ARG( quint32, pos ), Q_ARG( quint32, 0 ),
+                               Q_ARG( quint32, (quint32)qMax( 0, requestedSize.height() ) ),
+                               Q_ARG( bool, true ) );
+    return response;
+}
+
+void
+ThumbnailImageProvider::thumbnailReady( const QString& uuid, qint64 pos, const QImage& image )
+{
+    auto id = uuid + "/" + QString::number( pos );
+    QMutexLocker    lock( &m_mutex );
+    // The service is shared with the library snapshots, only keep what the timeline asked for
+    auto it = m_pending.find( id );
+    if ( it == m_pending.end() )
+        return;
+    auto responses = it.value();
+    m_pending.erase( it );
+    insert( id, image );
+    for ( auto response : responses )
+        complete( response, image );
+}
+
+void
+ThumbnailImageProvider::thumbnailFailed( const QString& uuid, qint64 pos )
+{
+    auto id = uuid + "/" + QString::number( pos );
+    QMutexLocker    lock( &m_mutex );
+    auto it = m_pending.find( id );
+    if ( it == m_pending.end() )
+        return;
+    auto responses = it.value();
+    m_pending.erase( it );
+    // Not cached, the thumbnail is requested again next time it's shown
+    for ( auto response : responses )
+        response->fulfill( QImage() );
+}
+
+void
+ThumbnailImageProvider::complete( ThumbnailResponse* response, const QImage& image )
+{
+    // Thumbnails are decoded at their displayed size already, this only happens when
+    // the track height changed since the request.
+    if ( needsScaling( image.size(), response->m_requestedSize ) == false )
     {
-        *size = QSize( requestedSize.width(), requestedSize.height() );
-        return QPixmap( requestedSize );
+        response->fulfill( image );
+        return;
     }
+    auto s = scaled( image, response->m_requestedSize );
+    insert( response->m_id, s );
+    response->fulfill( s );
+}
+
+void
+ThumbnailImageProvider::forget( ThumbnailResponse* response )
+{
+    auto it = m_pending.find( response->m_id );
+    if ( it == m_pending.end() )
+        return;
+    it->removeOne( response );
+    if ( it->isEmpty() == true )
+        m_pending.erase( it );
+}
 
-    auto pixmap = it.value();
-    *size = pixmap.size();
-    if ( requestedSize.isValid() == true )
-        return pixmap.scaled( requestedSize );
-    return pixmap;
+quint64
+ThumbnailImageProvider::hits() const
+{
+    QMutexLocker    lock( &m_mutex );
+    return m_hits;
+}
+
+quint64
+ThumbnailImageProvider::misses() const
+{
+    QMutexLocker    lock( &m_mutex );
+    return m_misses;
+}
+
+quint64
+ThumbnailImageProvider::evictions() const
+{
+    QMutexLocker    lock( &m_mutex );
+    return m_evictions;
+}
+
+int
+ThumbnailImageProvider::totalCost() const
+{
+    QMutexLocker    lock( &m_mutex );
+    return m_images.totalCost();
+}
+
+void
+ThumbnailImageProvider::insert( const QString& id, const QImage& image )
+{
+    auto replaced = m_images.contains( id );
+    auto count = m_images.count();
+    m_images.insert( id, new QImage( image ), cost( image ) );
+    auto expected = replaced == true ? count : count + 1;
+    if ( m_images.count() < expected )
+        m_evictions += expected - m_images.count();
+    publish();
+}
+
+void
+ThumbnailImageProvider::setMaxCost( const QVariant& megabytes )
+{
+    QMutexLocker    lock( &m_mutex );
+    m_images.setMaxCost( megabytes.toInt() * 1024 );
+    publish();
+}
+
+void
+ThumbnailImageProvider::publish()
+{
+    static auto& account = Tools::Metrics::memory( "thumbnails.images" );
+    // The costs are in KiB
+    account.set( static_cast<int64_t>( m_images.totalCost() ) * 1024, m_images.count() );
 }
 
 bool
-ThumbnailImageProvider::hasImage( const QString& uuid, quint32 pos )
+ThumbnailImageProvider::needsScaling( const QSize& size, const QSize& requestedSize )
+{
+    // A 0 dimension in the requested size means "keep the aspect ratio"
+    if ( requestedSize.width() > 0 && requestedSize.height() > 0 )
+        return ( size.width() != requestedSize.width() && size.height() != requestedSize.height() );
+    if ( requestedSize.height() > 0 )
+        return size.height() != requestedSize.height();
+    if ( requestedSize.width() > 0 )
+        return size.width() != requestedSize.width();
+    return false;
+}
+
+QImage
+ThumbnailImageProvider::scaled( const QImage& image, const QSize& requestedSize )
+{
+    // The filmstrips request the same few sizes over and over
+    auto size = requestedSize;
+    if ( size.width() <= 0 )
+        size.setWidth( qMax( 1, image.width() * size.height() / qMax( 1, image.height() ) ) );
+    else if ( size.height() <= 0 )
+        size.setHeight( qMax( 1, image.height() * size.width() / qMax( 1, image.width() ) ) );
+    return Tools::FramePool::scaled( image, size );
+}
+
+int
+ThumbnailImageProvider::cost( const QImage& image )
 {
-    return m_pixMap.find( uuid + "/" + QString::number( pos ) ) != m_pixMap.end();
+    return qMax( 1, image.width() * image.height() * image.depth() / 8 / 1024 );
 }
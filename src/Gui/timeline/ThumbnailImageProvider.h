@@ -1,27 +1,97 @@
 #ifndef THUMBNAILIMAGEPROVIDER_H
 #define THUMBNAILIMAGEPROVIDER_H
 
-#include <QMap>
-#include <QQuickImageProvider>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QQuickAsyncImageProvider>
 
-class ThumbnailImageProvider : public QObject, public QQuickImageProvider
+class ThumbnailImageProvider;
+
+/**
+ *  \brief  A thumbnail being waited for by a QML Image.
+ *
+ *  It's finished from the thread which served it: a thumbnail service worker, or the
+ *  QML image loader when the thumbnail was cached already.
+ */
+class ThumbnailResponse : public QQuickImageResponse
+{
+    Q_OBJECT
+
+public:
+    ThumbnailResponse( ThumbnailImageProvider* provider, const QString& id, const QSize& requestedSize );
+    ~ThumbnailResponse();
+
+    virtual QQuickTextureFactory*   textureFactory() const override;
+    virtual void                    cancel() override;
+
+private:
+    // Called with the provider's lock held
+    void    fulfill( const QImage& image );
+
+private:
+    ThumbnailImageProvider*     m_provider;
+    QString                     m_id;
+    QSize                       m_requestedSize;
+    QImage                      m_image;
+    bool                        m_done;
+
+    friend class ThumbnailImageProvider;
+};
+
+/**
+ *  \brief  Serves the timeline thumbnails to QML, without ever blocking its scene graph.
+ *
+ *  The ids are "uuid/pos". A thumbnail which isn't cached is requested from the thumbnail
+ *  service, whose workers then fulfill the responses waiting for it. Scaling a cached
+ *  thumbnail to another size happens on the QML image loader thread.
+ */
+class ThumbnailImageProvider : public QObject, public QQuickAsyncImageProvider
 {
     Q_OBJECT
 
 public:
     ThumbnailImageProvider();
 
-    virtual QPixmap requestPixmap( const QString& id, QSize* size, const QSize& requestedSize ) override;
+    virtual QQuickImageResponse*    requestImageResponse( const QString& id, const QSize& requestedSize ) override;
+
+    quint64 hits() const;
+    quint64 misses() const;
+    quint64 evictions() const;
+    /**
+     *  \returns    The current memory used by the cached images, in kilobytes.
+     */
+    int     totalCost() const;
 
-public slots:
-    bool    hasImage( const QString& uuid, quint32 pos );
+private:
+    // The following are called with m_mutex held
+    void    insert( const QString& id, const QImage& image );
+    void    complete( ThumbnailResponse* response, const QImage& image );
+    void    forget( ThumbnailResponse* response );
+    // Updates the memory account of the cache
+    void    publish();
 
-signals:
-    void    imageReady( const QString& uuid, quint32 pos );
+    // Called from the thumbnail service workers
+    void    thumbnailReady( const QString& uuid, qint64 pos, const QImage& image );
+    void    thumbnailFailed( const QString& uuid, qint64 pos );
+    void    setMaxCost( const QVariant& megabytes );
+    static bool     needsScaling( const QSize& size, const QSize& requestedSize );
+    static QImage   scaled( const QImage& image, const QSize& requestedSize );
+    static int      cost( const QImage& image );
 
 private:
-    // uuid/pos, pixmap
-    QMap<QString, QPixmap>  m_pixMap;
+    mutable QMutex              m_mutex;
+    // uuid/pos, image. Cost is in kilobytes
+    QCache<QString, QImage>     m_images;
+    // uuid/pos, the responses waiting for it
+    QHash<QString, QList<ThumbnailResponse*>>   m_pending;
+    quint64                     m_hits;
+    quint64                     m_misses;
+    quint64                     m_evictions;
+
+    friend class ThumbnailResponse;
 };
 
 #endif // THUMBNAILIMAGEPROVIDER_H
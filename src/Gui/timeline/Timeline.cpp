@@ -31,9 +31,13 @@
 #include "Gui/MainWindow.h"
 #include "Gui/effectsengine/EffectStack.h"
 #include "ThumbnailImageProvider.h"
+#include "TrackListModel.h"
+#include "TrackRenderer.h"
+#include "WaveformImageProvider.h"
 
 #include <QtQuick/QQuickView>
 #include <QtQml/QQmlContext>
+#include <QtQml/QQmlEngine>
 #include <QUrl>
 
 Timeline::Timeline( MainWindow* parent )
@@ -43,19 +47,38 @@ Timeline::Timeline( MainWindow* parent )
 {
     m_container->setSizePolicy( QSizePolicy::Expanding, QSizePolicy::Expanding );
     m_container->setFocusPolicy( Qt::TabFocus );
+    qmlRegisterType<TrackRenderer>( "org.videolan.vlmc", 1, 0, "TrackRenderer" );
+    qmlRegisterType<TrackListModel>( "org.videolan.vlmc", 1, 0, "TrackListModel" );
     auto p = new ThumbnailImageProvider;
     m_view->engine()->addImageProvider( QStringLiteral( "thumbnail" ), p );
-    m_view->rootContext()->setContextProperty( QStringLiteral( "thumbnailProvider" ), p );
+    auto wp = new WaveformImageProvider;
+    m_view->engine()->addImageProvider( QStringLiteral( "waveform" ), wp );
+    m_view->rootContext()->setContextProperty( QStringLiteral( "waveformProvider" ), wp );
     m_view->rootContext()->setContextProperty( QStringLiteral( "mainwindow" ), parent );
     m_view->rootContext()->setContextProperty( QStringLiteral( "workflow" ), Core::instance()->workflow() );
     m_view->setSource( QUrl( QStringLiteral( "qrc:/QML/main.qml" ) ) );
 
-    connect( Core::instance()->workflow(), &MainWorkflow::cleared, this, [this]()
-    {
-        m_view->setSource( QUrl() );
-        m_view->engine()->clearComponentCache();
-        m_view->setSource( QUrl( QStringLiteral( "qrc:/QML/main.qml" ) ) );
-    } );
+    m_clearedConnection = connect( Core::instance()->workflow(), &MainWorkflow::cleared,
+                                   this, &Timeline::reload );
+}
+
+void
+Timeline::setWorkflow( MainWorkflow* workflow )
+{
+    disconnect( m_clearedConnection );
+    m_view->rootContext()->setContextProperty( QStringLiteral( "workflow" ), workflow );
+    m_clearedConnection = connect( workflow, &MainWorkflow::cleared, this, &Timeline::reload );
+    reload();
+    // The clips of a loaded workflow are only added to the timeline once they are loaded
+    emit workflow->clipsLoaded();
+}
+
+void
+Timeline::reload()
+{
+    m_view->setSource( QUrl() );
+    m_view->engine()->clearComponentCache();
+    m_view->setSource( QUrl( QStringLiteral( "qrc:/QML/main.qml" ) ) );
 }
 
 Timeline::~Timeline()
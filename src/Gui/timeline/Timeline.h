@@ -28,6 +28,7 @@
 #include "Workflow/Types.h"
 
 class MainWindow;
+class MainWorkflow;
 class QQuickView;
 
 /**
@@ -42,6 +43,8 @@ public:
     virtual ~Timeline();
 
     QWidget*            container();
+    // Shows another workflow, when the active project changes
+    void                setWorkflow( MainWorkflow* workflow );
 
 public slots:
     /**
@@ -52,9 +55,13 @@ public slots:
 protected:
     virtual void changeEvent( QEvent *e ) { Q_UNUSED( e ) }
 
+private:
+    void                reload();
+
 private:
     QQuickView*         m_view;
     QWidget*            m_container;
+    QMetaObject::Connection m_clearedConnection;
 };
 
 #endif // TIMELINE_H
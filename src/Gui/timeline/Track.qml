@@ -1,4 +1,5 @@
 import QtQuick 2.0
+import org.videolan.vlmc 1.0
 
 Item {
     id: track
@@ -8,7 +9,8 @@ Item {
 
     property int trackId
     property string type
-    property ListModel clips
+    // The TrackModel of the clips of the track
+    property var clips
 
     Rectangle {
         id: clipArea
@@ -50,76 +52,22 @@ Item {
             property int lastX: 0
             property int deltaX: 0
 
+            // Snapping and collision detection are a single query to the workflow
             function findNewPosition( newX, target, useMagneticMode ) {
                 var oldX = target.pixelPosition();
 
-                if ( useMagneticMode === true ) {
-                    var leastDestance = magneticMargin;
-                    // Check two times
-                    for ( var k = 0; k < 2; ++k ) {
-                        for ( var j = 0; j < markers.count; ++j ) {
-                            var mx = ftop( markers.get( j ).position );
-                            if ( Math.abs( newX - mx ) < leastDestance ) {
-                                leastDestance = Math.abs( newX - mx );
-                                newX = mx;
-                            }
-                            else if ( Math.abs( newX + target.width - mx ) < leastDestance ) {
-                                leastDestance = Math.abs( newX + target.width - mx );
-                                newX = mx - target.width;
-                            }
-                        }
-                    }
-                }
-
-                // Collision detection
-                var isCollided = true;
-                var currentTrack = trackContainer( target.type )["tracks"].get( target.newTrackId );
-                if ( currentTrack )
-                    var clips = currentTrack["clips"];
-                else
+                var currentTrack = trackContainer( target.type ).get( target.newTrackId );
+                if ( !currentTrack )
                     return oldX;
-                for ( j = 0; j < clips.count + 2 && isCollided; ++j ) {
-                    isCollided = false;
-                    for ( k = 0; k < clips.count; ++k ) {
-                        var clip = clips.get( k );
-                        if ( clip.uuid === target.uuid )
-                            continue;
-                        var sw = target.width; // Width of the source clip
-                        var cx = ftop( clip["position"] );
-                        var cw = ftop( clip["end"] - clip["begin"] + 1);
-                        // Set a right position
-                        //
-                        // HACK: If magnetic mode, consider clips bigger.
-                        var clipMargin = useMagneticMode ? magneticMargin : 0;
-                        if ( cx  + cw > newX && newX + sw > cx )
-                            isCollided = true;
-
-                        cw += clipMargin * 2
-                        cx -= clipMargin
-                        if ( cx + cw > newX && newX + sw > cx ) {
-                            if ( cx > newX ) {
-                                if ( cx - sw > 0 )
-                                    newX = cx - sw + clipMargin;
-                                else
-                                    newX = oldX;
-                            } else {
-                                newX = cx + cw - clipMargin;
-                            }
-                        }
-                        if ( isCollided )
-                            break;
-                    }
-                }
-
-                if ( isCollided ) {
-                    for ( k = 0; k < clips.count; ++k ) {
-                        clip = clips.get( k );
-                        cx = ftop( clip["position"] );
-                        cw = ftop( clip["end"] - clip["begin"] + 1);
-                        newX = Math.max( newX, cx + cw );
-                    }
-                }
-                return newX;
+                var isAudio = target.type === "Audio";
+                if ( useMagneticMode === true )
+                    var frame = workflow.snapPosition( target.uuid, isAudio, target.newTrackId,
+                                                       ptof( newX ), ptof( target.width ),
+                                                       ptof( magneticMargin ), cursorPosition );
+                else
+                    frame = workflow.freePosition( target.uuid, isAudio, target.newTrackId,
+                                                   ptof( newX ), ptof( target.width ), 0 );
+                return ftop( frame );
             }
 
             function scrollToTarget( target ) {
@@ -141,18 +89,30 @@ Item {
                 if ( drop.keys.indexOf( "vlmc/uuid" ) >= 0 ) {
                     aClipInfo = findClipFromTrack( "Audio", trackId, "audioUuid" );
                     vClipInfo = findClipFromTrack( "Video", trackId, "videoUuid" );
-                    if ( aClipInfo ) {
-                        var pos = aClipInfo["position"];
-                        var audioClipUuid = workflow.addClip( currentUuid, trackId, pos, true );
+                    // A selection of the library goes in a single edit, from where its
+                    // first clip was dropped
+                    if ( drop.keys.indexOf( "vlmc/uuids" ) >= 0 && ( aClipInfo || vClipInfo ) ) {
+                        var uuids = drop.getDataAsString( "vlmc/uuids" ).split( "\n" );
+                        var firstPos = aClipInfo ? aClipInfo["position"] : vClipInfo["position"];
                         removeClipFromTrack( "Audio", trackId, "audioUuid" );
-                    }
-                    if ( vClipInfo ) {
-                        pos = vClipInfo["position"];
-                        var videoClipUuid = workflow.addClip( currentUuid, trackId, pos, false );
                         removeClipFromTrack( "Video", trackId, "videoUuid" );
+                        workflow.addClips( uuids, trackId, firstPos, aClipInfo ? true : false,
+                                           vClipInfo ? true : false );
                     }
-                    if ( audioClipUuid && videoClipUuid ) {
-                        workflow.linkClips( audioClipUuid, videoClipUuid );
+                    else {
+                        if ( aClipInfo ) {
+                            var pos = aClipInfo["position"];
+                            var audioClipUuid = workflow.addClip( currentUuid, trackId, pos, true );
+                            removeClipFromTrack( "Audio", trackId, "audioUuid" );
+                        }
+                        if ( vClipInfo ) {
+                            pos = vClipInfo["position"];
+                            var videoClipUuid = workflow.addClip( currentUuid, trackId, pos, false );
+                            removeClipFromTrack( "Video", trackId, "videoUuid" );
+                        }
+                        if ( audioClipUuid && videoClipUuid ) {
+                            workflow.linkClips( audioClipUuid, videoClipUuid );
+                        }
                     }
                     currentUuid = "";
                     aClipInfo = null;
@@ -311,7 +271,7 @@ Item {
                     // Let's move to the new tracks
                     if ( dMode === dropMode.Move ) {
                         if ( target.newTrackId !== target.trackId ) {
-                            drag.source.parent.parent.z = ++maxZ;
+                            drag.source.trackItem.z = ++maxZ;
                             if ( drag.source.uuid !== target.uuid ) {
                                 target.clipInfo["selected"] = true;
                                 addClip( target.type, target.newTrackId, target.clipInfo );
@@ -330,20 +290,58 @@ Item {
             }
         }
 
+        // Draws the clips which have no delegate, or one too narrow to be shown
+        TrackRenderer {
+            id: trackRenderer
+            width: parent.width
+            height: track.height - 3
+            trackId: track.trackId
+            audio: track.type === "Audio"
+            pixelsPerFrame: ftop( 1 )
+            threshold: lodWidth
+            liveBegin: liveRange.begin
+            liveEnd: liveRange.end
+        }
+
+        // Selects the clips drawn by trackRenderer, which have no visible delegate to
+        // be clicked. Everything else goes through to the timeline.
+        MouseArea {
+            anchors.fill: trackRenderer
+
+            onPressed: {
+                var uuid = trackRenderer.clipAt( mouse.x );
+                if ( uuid === "" ) {
+                    mouse.accepted = false;
+                    return;
+                }
+                if ( !( mouse.modifiers & Qt.ControlModifier ) )
+                    clearSelectedClips();
+                selectClip( uuid );
+            }
+        }
+
         Repeater {
             id: repeater
             model: clips
-            delegate: Clip {
-                height: track.height - 3
-                name: model.name
-                trackId: model.trackId
-                type: track.type
-                uuid: model.uuid
-                position: model.position
-                begin: model.begin
-                end: model.end
-                linkedClip: model.linkedClip
-                clipInfo: model
+            // Only the clips around the viewport, the selected ones and those being
+            // dropped have a delegate
+            delegate: Loader {
+                active: visibleClips[model.uuid] === true || model.selected === true ||
+                        model.uuid === "videoUuid" || model.uuid === "audioUuid"
+                sourceComponent: Component {
+                    Clip {
+                        height: track.height - 3
+                        name: model.name
+                        trackId: model.trackId
+                        type: track.type
+                        uuid: model.uuid
+                        position: model.position
+                        begin: model.begin
+                        end: model.end
+                        linkedClip: model.linkedClip
+                        clipInfo: model
+                    }
+                }
             }
         }
     }
@@ -376,6 +374,16 @@ Item {
             color: "#111111"
         }
 
+        // Dropped on the header, an effect applies to the whole track
+        DropArea {
+            anchors.fill: parent
+            keys: ["vlmc/effect_name"]
+
+            onDropped: {
+                workflow.addTrackEffect( trackId, drop.getDataAsString( "vlmc/effect_name" ) );
+            }
+        }
+
         Text {
             id: trackText
             anchors.verticalCenter: parent.verticalCenter
@@ -5,7 +5,8 @@ ListView {
 
     property bool isUpward
     property string type
-    property ListModel tracks
+    // A TrackListModel
+    property var tracks
 
     width: parent.width
     height: tracks.count * trackHeight
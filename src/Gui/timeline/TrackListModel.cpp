@@ -0,0 +1,161 @@
+#include "TrackListModel.h"
+
+#include "Main/Core.h"
+#include "TrackModel.h"
+#include "Workflow/MainWorkflow.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+
+TrackListModel::TrackListModel( QObject* parent )
+    : QAbstractListModel( parent )
+    , m_audio( false )
+{
+    addTrack();
+}
+
+int
+TrackListModel::rowCount( const QModelIndex& parent ) const
+{
+    if ( parent.isValid() == true )
+        return 0;
+    return m_tracks.count();
+}
+
+QVariant
+TrackListModel::data( const QModelIndex& index, int role ) const
+{
+    if ( index.isValid() == false || index.row() >= m_tracks.count() || role != ClipsRole )
+        return QVariant();
+    return QVariant::fromValue<QObject*>( m_tracks[index.row()] );
+}
+
+QHash<int, QByteArray>
+TrackListModel::roleNames() const
+{
+    return QHash<int, QByteArray>{ { ClipsRole, "clips" } };
+}
+
+bool
+TrackListModel::isAudio() const
+{
+    return m_audio;
+}
+
+void
+TrackListModel::setAudio( bool audio )
+{
+    if ( m_audio == audio )
+        return;
+    m_audio = audio;
+    emit audioChanged();
+}
+
+int
+TrackListModel::count() const
+{
+    return m_tracks.count();
+}
+
+QObject*
+TrackListModel::get( int trackId ) const
+{
+    if ( trackId < 0 || trackId >= m_tracks.count() )
+        return nullptr;
+    return m_tracks[trackId];
+}
+
+void
+TrackListModel::addClip( int trackId, const QVariantMap& clip )
+{
+    if ( trackId < 0 )
+        return;
+    while ( trackId >= m_tracks.count() )
+        addTrack();
+    m_tracks[trackId]->append( clip );
+}
+
+void
+TrackListModel::addClips( const QStringList& uuids )
+{
+    auto workflow = Core::instance()->workflow();
+    for ( const auto& uuid : uuids )
+        addClipInfo( workflow->clipInfo( uuid ).toVariantMap() );
+}
+
+void
+TrackListModel::loadClips()
+{
+    for ( const auto& info : Core::instance()->workflow()->clipsInfo() )
+        addClipInfo( info.toObject().toVariantMap() );
+}
+
+void
+TrackListModel::removeClip( const QString& uuid )
+{
+    for ( auto track : m_tracks )
+        track->remove( uuid );
+}
+
+QVariant
+TrackListModel::find( const QString& uuid ) const
+{
+    for ( auto track : m_tracks )
+    {
+        auto clip = track->get( uuid );
+        if ( clip.isValid() == true )
+            return clip;
+    }
+    return QVariant();
+}
+
+bool
+TrackListModel::setClipData( const QString& uuid, const QVariantMap& values )
+{
+    for ( auto track : m_tracks )
+    {
+        if ( track->setClipData( uuid, values ) == true )
+            return true;
+    }
+    return false;
+}
+
+void
+TrackListModel::adjustTracks()
+{
+    while ( m_tracks.count() > 1 && m_tracks.last()->count() == 0 &&
+            m_tracks[m_tracks.count() - 2]->count() == 0 )
+        removeTrack();
+    if ( m_tracks.last()->count() > 0 )
+        addTrack();
+}
+
+void
+TrackListModel::addTrack()
+{
+    beginInsertRows( QModelIndex(), m_tracks.count(), m_tracks.count() );
+    m_tracks.append( new TrackModel( m_tracks.count(), this ) );
+    endInsertRows();
+    emit countChanged();
+}
+
+void
+TrackListModel::removeTrack()
+{
+    // The delegate of the track goes before its model
+    beginRemoveRows( QModelIndex(), m_tracks.count() - 1, m_tracks.count() - 1 );
+    auto track = m_tracks.takeLast();
+    endRemoveRows();
+    track->deleteLater();
+    emit countChanged();
+}
+
+void
+TrackListModel::addClipInfo( QVariantMap clip )
+{
+    // The same description is used by both containers, for their own type of clips
+    if ( clip.isEmpty() == true || clip["audio"].toBool() != m_audio )
+        return;
+    clip["selected"] = false;
+    addClip( clip["trackId"].toInt(), clip );
+}
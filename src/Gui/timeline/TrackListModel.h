@@ -0,0 +1,81 @@
+#ifndef TRACKLISTMODEL_H
+#define TRACKLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+class TrackModel;
+
+/**
+ *  \brief  The audio or video tracks of the timeline, as the model of a TrackContainer.
+ *
+ *  Each track is a row, whose "clips" role is the TrackModel of its clips. The clips
+ *  are read from the workflow here, instead of being copied through QML.
+ *  There is always an empty track after the last one holding clips, for clips to be
+ *  dropped on.
+ */
+class TrackListModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY( bool audio READ isAudio WRITE setAudio NOTIFY audioChanged )
+    Q_PROPERTY( int count READ count NOTIFY countChanged )
+
+public:
+    enum Roles
+    {
+        ClipsRole = Qt::UserRole + 1,
+    };
+
+    explicit TrackListModel( QObject* parent = nullptr );
+
+    virtual int             rowCount( const QModelIndex& parent = QModelIndex() ) const override;
+    virtual QVariant        data( const QModelIndex& index, int role ) const override;
+    virtual QHash<int, QByteArray>  roleNames() const override;
+
+    bool                    isAudio() const;
+    void                    setAudio( bool audio );
+    int                     count() const;
+
+    // Returns the TrackModel of a track, or nullptr
+    Q_INVOKABLE
+    QObject*                get( int trackId ) const;
+    // Adds a clip from its description to a track, and the tracks up to it if needed
+    Q_INVOKABLE
+    void                    addClip( int trackId, const QVariantMap& clip );
+    // Adds the clips of the workflow of this type, unselected
+    Q_INVOKABLE
+    void                    addClips( const QStringList& uuids );
+    // Adds every clip of the workflow of this type, unselected
+    Q_INVOKABLE
+    void                    loadClips();
+    Q_INVOKABLE
+    void                    removeClip( const QString& uuid );
+    /**
+     *  \brief  Returns a copy of the roles of the clip, keyed by name, or an invalid
+     *          value if it isn't on any of the tracks. \sa TrackModel::get()
+     */
+    Q_INVOKABLE
+    QVariant                find( const QString& uuid ) const;
+    Q_INVOKABLE
+    bool                    setClipData( const QString& uuid, const QVariantMap& values );
+    // Leaves a single empty track after the last one holding clips
+    Q_INVOKABLE
+    void                    adjustTracks();
+
+signals:
+    void                    audioChanged();
+    void                    countChanged();
+
+private:
+    void                    addTrack();
+    void                    removeTrack();
+    void                    addClipInfo( QVariantMap clip );
+
+private:
+    bool                    m_audio;
+    QVector<TrackModel*>    m_tracks;
+};
+
+#endif // TRACKLISTMODEL_H
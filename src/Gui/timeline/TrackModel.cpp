@@ -0,0 +1,206 @@
+#include "TrackModel.h"
+
+TrackModel::TrackModel( quint32 trackId, QObject* parent )
+    : QAbstractListModel( parent )
+    , m_trackId( trackId )
+{
+}
+
+int
+TrackModel::rowCount( const QModelIndex& parent ) const
+{
+    if ( parent.isValid() == true )
+        return 0;
+    return m_clips.count();
+}
+
+QVariant
+TrackModel::data( const QModelIndex& index, int role ) const
+{
+    if ( index.isValid() == false || index.row() >= m_clips.count() )
+        return QVariant();
+    const auto& c = m_clips[index.row()];
+
+    switch ( role )
+    {
+    case UuidRole:
+        return c.uuid;
+    case NameRole:
+        return c.name;
+    case TrackIdRole:
+        return m_trackId;
+    case PositionRole:
+        return c.position;
+    case BeginRole:
+        return c.begin;
+    case EndRole:
+        return c.end;
+    case LengthRole:
+        return c.length;
+    case SelectedRole:
+        return c.selected;
+    case LinkedClipRole:
+        return c.linkedClip;
+    default:
+        return QVariant();
+    }
+}
+
+bool
+TrackModel::setData( const QModelIndex& index, const QVariant& value, int role )
+{
+    if ( index.isValid() == false || index.row() >= m_clips.count() )
+        return false;
+    auto& c = m_clips[index.row()];
+
+    bool changed;
+    switch ( role )
+    {
+    case UuidRole:
+        changed = c.uuid != value.toString();
+        c.uuid = value.toString();
+        break;
+    case NameRole:
+        changed = c.name != value.toString();
+        c.name = value.toString();
+        break;
+    case PositionRole:
+        changed = c.position != value.toLongLong();
+        c.position = value.toLongLong();
+        break;
+    case BeginRole:
+        changed = c.begin != value.toLongLong();
+        c.begin = value.toLongLong();
+        break;
+    case EndRole:
+        changed = c.end != value.toLongLong();
+        c.end = value.toLongLong();
+        break;
+    case LengthRole:
+        changed = c.length != value.toLongLong();
+        c.length = value.toLongLong();
+        break;
+    case SelectedRole:
+        changed = c.selected != value.toBool();
+        c.selected = value.toBool();
+        break;
+    case LinkedClipRole:
+        changed = c.linkedClip != value.toString();
+        c.linkedClip = value.toString();
+        break;
+    default:
+        // The track of a clip is the model it belongs to
+        return false;
+    }
+    if ( changed == true )
+        emit dataChanged( index, index, QVector<int>{ role } );
+    return true;
+}
+
+Qt::ItemFlags
+TrackModel::flags( const QModelIndex& index ) const
+{
+    if ( index.isValid() == false )
+        return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsEditable;
+}
+
+QHash<int, QByteArray>
+TrackModel::roleNames() const
+{
+    return QHash<int, QByteArray>{
+        { UuidRole, "uuid" },
+        { NameRole, "name" },
+        { TrackIdRole, "trackId" },
+        { PositionRole, "position" },
+        { BeginRole, "begin" },
+        { EndRole, "end" },
+        { LengthRole, "length" },
+        { SelectedRole, "selected" },
+        { LinkedClipRole, "linkedClip" },
+    };
+}
+
+int
+TrackModel::count() const
+{
+    return m_clips.count();
+}
+
+quint32
+TrackModel::trackId() const
+{
+    return m_trackId;
+}
+
+void
+TrackModel::append( const QVariantMap& clip )
+{
+    ClipData c;
+    c.uuid = clip["uuid"].toString();
+    c.name = clip["name"].toString();
+    c.position = clip["position"].toLongLong();
+    c.begin = clip["begin"].toLongLong();
+    c.end = clip["end"].toLongLong();
+    c.length = clip["length"].toLongLong();
+    c.selected = clip["selected"].toBool();
+    c.linkedClip = clip["linkedClip"].toString();
+
+    beginInsertRows( QModelIndex(), m_clips.count(), m_clips.count() );
+    m_clips.append( c );
+    endInsertRows();
+    emit countChanged();
+}
+
+bool
+TrackModel::remove( const QString& uuid )
+{
+    auto r = row( uuid );
+    if ( r < 0 )
+        return false;
+    beginRemoveRows( QModelIndex(), r, r );
+    m_clips.remove( r );
+    endRemoveRows();
+    emit countChanged();
+    return true;
+}
+
+QVariant
+TrackModel::get( const QString& uuid ) const
+{
+    auto r = row( uuid );
+    if ( r < 0 )
+        return QVariant();
+    QVariantMap res;
+    auto roles = roleNames();
+    for ( auto it = roles.cbegin(); it != roles.cend(); ++it )
+        res[it.value()] = data( index( r ), it.key() );
+    return res;
+}
+
+bool
+TrackModel::setClipData( const QString& uuid, const QVariantMap& values )
+{
+    auto r = row( uuid );
+    if ( r < 0 )
+        return false;
+    auto roles = roleNames();
+    for ( auto it = values.cbegin(); it != values.cend(); ++it )
+    {
+        auto role = roles.key( it.key().toUtf8(), -1 );
+        if ( role >= 0 )
+            setData( index( r ), it.value(), role );
+    }
+    return true;
+}
+
+int
+TrackModel::row( const QString& uuid ) const
+{
+    for ( int i = 0; i < m_clips.count(); ++i )
+    {
+        if ( m_clips[i].uuid == uuid )
+            return i;
+    }
+    return -1;
+}
@@ -0,0 +1,88 @@
+#ifndef TRACKMODEL_H
+#define TRACKMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+/**
+ *  \brief  The clips of a timeline track, as the model of its Repeater.
+ *
+ *  Each clip is a row, each of its properties a role, which the Clip.qml delegates
+ *  read and write through their model. A change only signals the row and the role
+ *  which changed, for the other delegates of the track to stay untouched.
+ */
+class TrackModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY( int count READ count NOTIFY countChanged )
+
+public:
+    enum Roles
+    {
+        UuidRole = Qt::UserRole + 1,
+        NameRole,
+        TrackIdRole,
+        PositionRole,
+        BeginRole,
+        EndRole,
+        // The length of the clip's media, in frames
+        LengthRole,
+        SelectedRole,
+        LinkedClipRole,
+    };
+
+    explicit TrackModel( quint32 trackId, QObject* parent = nullptr );
+
+    virtual int             rowCount( const QModelIndex& parent = QModelIndex() ) const override;
+    virtual QVariant        data( const QModelIndex& index, int role ) const override;
+    virtual bool            setData( const QModelIndex& index, const QVariant& value, int role ) override;
+    virtual Qt::ItemFlags   flags( const QModelIndex& index ) const override;
+    virtual QHash<int, QByteArray>  roleNames() const override;
+
+    int                     count() const;
+    quint32                 trackId() const;
+
+    /**
+     *  \brief  Adds a clip to the end of the track, from its description keyed by
+     *          role name, such as MainWorkflow::clipInfo()
+     */
+    Q_INVOKABLE
+    void                    append( const QVariantMap& clip );
+    Q_INVOKABLE
+    bool                    remove( const QString& uuid );
+    /**
+     *  \brief  Returns a copy of the roles of the clip, keyed by name, or an invalid
+     *          value if it isn't on this track.
+     */
+    Q_INVOKABLE
+    QVariant                get( const QString& uuid ) const;
+    // Changes the roles of the clip listed in values, keyed by name
+    Q_INVOKABLE
+    bool                    setClipData( const QString& uuid, const QVariantMap& values );
+
+signals:
+    void                    countChanged();
+
+private:
+    struct ClipData
+    {
+        QString     uuid;
+        QString     name;
+        qint64      position;
+        qint64      begin;
+        qint64      end;
+        qint64      length;
+        bool        selected;
+        QString     linkedClip;
+    };
+
+    int                     row( const QString& uuid ) const;
+
+private:
+    quint32                 m_trackId;
+    QVector<ClipData>       m_clips;
+};
+
+#endif // TRACKMODEL_H
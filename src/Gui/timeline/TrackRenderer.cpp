@@ -0,0 +1,306 @@
+#include "TrackRenderer.h"
+
+#include "Main/Core.h"
+#include "Workflow/ClipIndex.h"
+#include "Workflow/MainWorkflow.h"
+
+#include <QSGGeometryNode>
+#include <QSGVertexColorMaterial>
+
+#include <vector>
+
+namespace
+{
+    // A bar covered by a single clip of a frame is still visible
+    const double    MinOpacity = 0.35;
+
+    struct Bar
+    {
+        double  left;
+        double  right;
+        // In pixels, the part of the bar actually covered by clips
+        double  covered;
+    };
+
+    struct Rect
+    {
+        float   left;
+        float   top;
+        float   right;
+        float   bottom;
+        QColor  color;
+        double  opacity;
+    };
+
+    void
+    addRect( QSGGeometry::ColoredPoint2D*& v, const Rect& rect )
+    {
+        // The vertex color material expects premultiplied colors
+        auto a = rect.opacity * rect.color.alphaF();
+        uchar r = rect.color.redF() * a * 255;
+        uchar g = rect.color.greenF() * a * 255;
+        uchar b = rect.color.blueF() * a * 255;
+        uchar al = a * 255;
+        v[0].set( rect.left, rect.top, r, g, b, al );
+        v[1].set( rect.right, rect.top, r, g, b, al );
+        v[2].set( rect.left, rect.bottom, r, g, b, al );
+        v[3].set( rect.right, rect.top, r, g, b, al );
+        v[4].set( rect.right, rect.bottom, r, g, b, al );
+        v[5].set( rect.left, rect.bottom, r, g, b, al );
+        v += 6;
+    }
+}
+
+TrackRenderer::TrackRenderer( QQuickItem* parent )
+    : QQuickItem( parent )
+    , m_trackId( 0 )
+    , m_audio( false )
+    , m_pixelsPerFrame( 1.0 )
+    , m_threshold( 4.0 )
+    , m_liveBegin( 0 )
+    , m_liveEnd( 0 )
+    , m_color( "#4276a6" )
+    , m_borderColor( "#1f546f" )
+{
+    setFlag( ItemHasContents, true );
+    connect( Core::instance()->workflow(), &MainWorkflow::trackChanged,
+             this, &TrackRenderer::sequenceChanged );
+    connect( Core::instance()->workflow(), &MainWorkflow::cleared, this, &QQuickItem::update );
+}
+
+int
+TrackRenderer::trackId() const
+{
+    return m_trackId;
+}
+
+void
+TrackRenderer::setTrackId( int trackId )
+{
+    if ( m_trackId == trackId )
+        return;
+    m_trackId = trackId;
+    emit trackIdChanged();
+    update();
+}
+
+bool
+TrackRenderer::isAudio() const
+{
+    return m_audio;
+}
+
+void
+TrackRenderer::setAudio( bool audio )
+{
+    if ( m_audio == audio )
+        return;
+    m_audio = audio;
+    emit audioChanged();
+    update();
+}
+
+double
+TrackRenderer::pixelsPerFrame() const
+{
+    return m_pixelsPerFrame;
+}
+
+void
+TrackRenderer::setPixelsPerFrame( double pixelsPerFrame )
+{
+    if ( qFuzzyCompare( m_pixelsPerFrame, pixelsPerFrame ) == true )
+        return;
+    m_pixelsPerFrame = pixelsPerFrame;
+    emit pixelsPerFrameChanged();
+    update();
+}
+
+double
+TrackRenderer::threshold() const
+{
+    return m_threshold;
+}
+
+void
+TrackRenderer::setThreshold( double threshold )
+{
+    if ( qFuzzyCompare( m_threshold, threshold ) == true )
+        return;
+    m_threshold = threshold;
+    emit thresholdChanged();
+    update();
+}
+
+qint64
+TrackRenderer::liveBegin() const
+{
+    return m_liveBegin;
+}
+
+void
+TrackRenderer::setLiveBegin( qint64 liveBegin )
+{
+    if ( m_liveBegin == liveBegin )
+        return;
+    m_liveBegin = liveBegin;
+    emit liveRangeChanged();
+    update();
+}
+
+qint64
+TrackRenderer::liveEnd() const
+{
+    return m_liveEnd;
+}
+
+void
+TrackRenderer::setLiveEnd( qint64 liveEnd )
+{
+    if ( m_liveEnd == liveEnd )
+        return;
+    m_liveEnd = liveEnd;
+    emit liveRangeChanged();
+    update();
+}
+
+QColor
+TrackRenderer::color() const
+{
+    return m_color;
+}
+
+void
+TrackRenderer::setColor( const QColor& color )
+{
+    if ( m_color == color )
+        return;
+    m_color = color;
+    emit colorChanged();
+    update();
+}
+
+QColor
+TrackRenderer::borderColor() const
+{
+    return m_borderColor;
+}
+
+void
+TrackRenderer::setBorderColor( const QColor& color )
+{
+    if ( m_borderColor == color )
+        return;
+    m_borderColor = color;
+    emit colorChanged();
+    update();
+}
+
+QString
+TrackRenderer::clipAt( qreal x ) const
+{
+    auto idx = index();
+    if ( idx == nullptr || m_pixelsPerFrame <= 0.0 || x < 0 )
+        return QString();
+    auto frame = (qint64)( x / m_pixelsPerFrame );
+    auto e = idx->at( frame );
+    // A bar is at least a pixel wide, however short its clip is
+    if ( e.uuid.isNull() == true )
+    {
+        auto clips = idx->overlapping( frame, (qint64)( ( x + 1.0 ) / m_pixelsPerFrame ) + 1 );
+        if ( clips.isEmpty() == true )
+            return QString();
+        e = clips.first();
+    }
+    return e.uuid.toString();
+}
+
+void
+TrackRenderer::sequenceChanged( quint32 trackId )
+{
+    if ( m_trackId >= 0 && trackId == (quint32)m_trackId )
+        update();
+}
+
+std::shared_ptr<const ClipIndex>
+TrackRenderer::index() const
+{
+    if ( m_trackId < 0 )
+        return nullptr;
+    auto snapshot = Core::instance()->workflow()->indexSnapshot();
+    const auto& tracks = snapshot->tracks[m_audio == true ? Workflow::AudioTrack : Workflow::VideoTrack];
+    auto it = tracks.find( m_trackId );
+    if ( it == tracks.end() )
+        return nullptr;
+    return it.value();
+}
+
+QSGNode*
+TrackRenderer::updatePaintNode( QSGNode* oldNode, UpdatePaintNodeData* )
+{
+    // Called on the render thread, with the GUI thread blocked. The index snapshot can be
+    // read from any thread anyway.
+    std::vector<Bar>    bars;
+    std::vector<Bar>    bodies;
+    auto idx = index();
+    if ( idx != nullptr && m_pixelsPerFrame > 0.0 )
+    {
+        for ( const auto& e : idx->overlapping( 0, idx->end() ) )
+        {
+            auto left = e.begin * m_pixelsPerFrame;
+            auto right = e.end * m_pixelsPerFrame;
+            if ( right - left >= m_threshold )
+            {
+                // Those are drawn by their delegate
+                if ( e.begin < m_liveEnd && e.end > m_liveBegin )
+                    continue;
+                bodies.push_back( Bar{ left, right, right - left } );
+            }
+            else if ( bars.empty() == false && left - bars.back().right < 1.0 )
+            {
+                bars.back().right = right;
+                bars.back().covered += right - left;
+            }
+            else
+                bars.push_back( Bar{ left, right, right - left } );
+        }
+    }
+
+    auto node = static_cast<QSGGeometryNode*>( oldNode );
+    if ( bars.empty() == true && bodies.empty() == true )
+    {
+        delete node;
+        return nullptr;
+    }
+    if ( node == nullptr )
+    {
+        node = new QSGGeometryNode;
+        auto geometry = new QSGGeometry( QSGGeometry::defaultAttributes_ColoredPoint2D(), 0 );
+        geometry->setDrawingMode( GL_TRIANGLES );
+        node->setGeometry( geometry );
+        node->setFlag( QSGNode::OwnsGeometry );
+        node->setMaterial( new QSGVertexColorMaterial );
+        node->setFlag( QSGNode::OwnsMaterial );
+    }
+
+    // A body is its border, with the inside drawn over it
+    auto geometry = node->geometry();
+    geometry->allocate( (int)( bodies.size() * 2 + bars.size() ) * 6 );
+    auto v = geometry->vertexDataAsColoredPoint2D();
+    float top = 0;
+    float bottom = height();
+    for ( const auto& b : bodies )
+    {
+        addRect( v, Rect{ (float)b.left, top, (float)b.right, bottom, m_borderColor, 1.0 } );
+        addRect( v, Rect{ (float)b.left + 1, top + 1, (float)b.right - 1, bottom - 1, m_color, 1.0 } );
+    }
+    for ( const auto& b : bars )
+    {
+        // Bars are at least a pixel wide, however short their clips are
+        auto right = qMax( b.right, b.left + 1.0 );
+        auto opacity = MinOpacity + ( 1.0 - MinOpacity ) * qMin( 1.0, b.covered / ( right - b.left ) );
+        addRect( v, Rect{ (float)b.left, top, (float)right, bottom, m_color, opacity } );
+    }
+    node->markDirty( QSGNode::DirtyGeometry );
+    return node;
+}
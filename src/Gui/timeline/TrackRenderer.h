@@ -0,0 +1,89 @@
+#ifndef TRACKRENDERER_H
+#define TRACKRENDERER_H
+
+#include <QColor>
+#include <QQuickItem>
+
+#include <memory>
+
+class ClipIndex;
+
+/**
+ *  \brief  Draws the clips of a track which don't have a QML delegate, in a single
+ *          scene graph node.
+ *
+ *  Only the clips intersecting [liveBegin, liveEnd), around the viewport, get a full
+ *  Clip.qml delegate, for their label, thumbnail and interactions. Every other clip is
+ *  drawn here as its plain body, which keeps the number of QML objects bounded by what
+ *  can be seen, however long the timeline is.
+ *  The clips narrower than threshold pixels hide their delegate even in the live range.
+ *  They are merged with their neighbours closer than a pixel, and drawn as bars which
+ *  are more opaque the more of them their clips cover.
+ */
+class TrackRenderer : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY( int trackId READ trackId WRITE setTrackId NOTIFY trackIdChanged )
+    Q_PROPERTY( bool audio READ isAudio WRITE setAudio NOTIFY audioChanged )
+    Q_PROPERTY( double pixelsPerFrame READ pixelsPerFrame WRITE setPixelsPerFrame NOTIFY pixelsPerFrameChanged )
+    Q_PROPERTY( double threshold READ threshold WRITE setThreshold NOTIFY thresholdChanged )
+    Q_PROPERTY( qint64 liveBegin READ liveBegin WRITE setLiveBegin NOTIFY liveRangeChanged )
+    Q_PROPERTY( qint64 liveEnd READ liveEnd WRITE setLiveEnd NOTIFY liveRangeChanged )
+    Q_PROPERTY( QColor color READ color WRITE setColor NOTIFY colorChanged )
+    Q_PROPERTY( QColor borderColor READ borderColor WRITE setBorderColor NOTIFY colorChanged )
+
+public:
+    explicit TrackRenderer( QQuickItem* parent = nullptr );
+
+    int     trackId() const;
+    void    setTrackId( int trackId );
+    bool    isAudio() const;
+    void    setAudio( bool audio );
+    double  pixelsPerFrame() const;
+    void    setPixelsPerFrame( double pixelsPerFrame );
+    double  threshold() const;
+    void    setThreshold( double threshold );
+    qint64  liveBegin() const;
+    void    setLiveBegin( qint64 liveBegin );
+    qint64  liveEnd() const;
+    void    setLiveEnd( qint64 liveEnd );
+    QColor  color() const;
+    void    setColor( const QColor& color );
+    QColor  borderColor() const;
+    void    setBorderColor( const QColor& color );
+
+    /**
+     *  \brief  Returns the uuid of the clip under x, in the item coordinates, or an
+     *          empty string.
+     */
+    Q_INVOKABLE
+    QString clipAt( qreal x ) const;
+
+protected:
+    virtual QSGNode*    updatePaintNode( QSGNode* oldNode, UpdatePaintNodeData* ) override;
+
+private:
+    void    sequenceChanged( quint32 trackId );
+    // The clips as of the last edit, nullptr if the track is empty
+    std::shared_ptr<const ClipIndex>    index() const;
+
+signals:
+    void    trackIdChanged();
+    void    audioChanged();
+    void    pixelsPerFrameChanged();
+    void    thresholdChanged();
+    void    liveRangeChanged();
+    void    colorChanged();
+
+private:
+    int         m_trackId;
+    bool        m_audio;
+    double      m_pixelsPerFrame;
+    double      m_threshold;
+    qint64      m_liveBegin;
+    qint64      m_liveEnd;
+    QColor      m_color;
+    QColor      m_borderColor;
+};
+
+#endif // TRACKRENDERER_H
@@ -0,0 +1,103 @@
+#include "WaveformImageProvider.h"
+
+#include "Main/Core.h"
+#include "Workflow/MainWorkflow.h"
+#include "Workflow/WaveformService.h"
+#include "Tools/FramePool.h"
+
+#include <QPainter>
+#include <QStringList>
+
+#include <limits>
+
+namespace
+{
+    // Keeps the image allocation bounded on deep zoom levels
+    const int       MaxWidth = 8192;
+}
+
+WaveformImageProvider::WaveformImageProvider()
+    : QQuickImageProvider( QQuickImageProvider::Image )
+{
+    connect( Core::instance()->waveformService(), &WaveformService::peaksReady,
+             this, &WaveformImageProvider::peaksReady, Qt::QueuedConnection );
+}
+
+QImage
+WaveformImageProvider::requestImage( const QString& id, QSize* size, const QSize& requestedSize )
+{
+    QString tmp = id;
+    tmp.replace( "%7B", "{" );
+    tmp.replace( "%7D", "}" );
+
+    int width = qBound( 1, requestedSize.width(), MaxWidth );
+    int height = qMax( 1, requestedSize.height() );
+    *size = QSize( width, height );
+    auto image = Tools::FramePool::image( width, height, QImage::Format_ARGB32_Premultiplied );
+    image.fill( Qt::transparent );
+
+    auto parts = tmp.split( '/' );
+    if ( parts.size() < 3 )
+        return image;
+    auto uuid = parts[0];
+    auto begin = parts[1].toLongLong();
+    auto end = parts[2].toLongLong();
+
+    auto filePath = Core::instance()->workflow()->clipInfo( uuid )["filePath"].toString();
+    if ( filePath.isEmpty() == true || end <= begin )
+        return image;
+    auto peaks = Core::instance()->waveformService()->peaks( filePath );
+    if ( peaks == nullptr )
+    {
+        m_waiting[filePath].insert( uuid );
+        return image;
+    }
+    if ( peaks->fps() <= 0 )
+        return image;
+
+    double firstSample = begin * peaks->frequency() / peaks->fps();
+    double samplesPerPixel = ( end - begin ) * peaks->frequency() / peaks->fps() / width;
+    auto l = peaks->levelFor( samplesPerPixel );
+    const auto& level = peaks->level( l );
+    double blockSize = peaks->blockSize( l );
+    if ( level.isEmpty() == true )
+        return image;
+
+    QPainter    painter( &image );
+    const QColor    peakColor( 0x9F, 0xC5, 0xE8 );
+    const QColor    rmsColor( 0x5B, 0x8D, 0xBE );
+    double mid = height / 2.0;
+    double scale = mid / std::numeric_limits<qint16>::max();
+
+    for ( int x = 0; x < width; ++x )
+    {
+        int first = (int)( ( firstSample + x * samplesPerPixel ) / blockSize );
+        int last = (int)( ( firstSample + ( x + 1 ) * samplesPerPixel ) / blockSize );
+        if ( first >= level.size() )
+            break;
+        last = qBound( first + 1, last, level.size() );
+
+        int min = 0;
+        int max = 0;
+        int rms = 0;
+        for ( int i = first; i < last; ++i )
+        {
+            min = qMin( min, (int)level[i].min );
+            max = qMax( max, (int)level[i].max );
+            rms = qMax( rms, (int)level[i].rms );
+        }
+        painter.setPen( peakColor );
+        painter.drawLine( QPointF( x, mid - max * scale ), QPointF( x, mid - min * scale ) );
+        painter.setPen( rmsColor );
+        painter.drawLine( QPointF( x, mid - rms * scale ), QPointF( x, mid + rms * scale ) );
+    }
+    return image;
+}
+
+void
+WaveformImageProvider::peaksReady( const QString& filePath )
+{
+    auto uuids = m_waiting.take( filePath );
+    for ( const auto& uuid : uuids )
+        emit waveformReady( uuid );
+}
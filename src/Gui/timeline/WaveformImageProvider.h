@@ -0,0 +1,34 @@
+#ifndef WAVEFORMIMAGEPROVIDER_H
+#define WAVEFORMIMAGEPROVIDER_H
+
+#include <QHash>
+#include <QQuickImageProvider>
+#include <QSet>
+
+class WaveformImageProvider : public QObject, public QQuickImageProvider
+{
+    Q_OBJECT
+
+public:
+    WaveformImageProvider();
+
+    /**
+     *  \brief  Renders the waveform of a clip.
+     *
+     *  The id is "uuid/begin/end/revision". The revision is only there to defeat the
+     *  QML image cache once the peaks are available.
+     */
+    virtual QImage  requestImage( const QString& id, QSize* size, const QSize& requestedSize ) override;
+
+private:
+    void    peaksReady( const QString& filePath );
+
+signals:
+    void    waveformReady( const QString& uuid );
+
+private:
+    // file path, uuids of the clips waiting for its peaks
+    QHash<QString, QSet<QString>>   m_waiting;
+};
+
+#endif // WAVEFORMIMAGEPROVIDER_H
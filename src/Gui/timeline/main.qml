@@ -1,6 +1,7 @@
 import QtQuick 2.0
 import QtQuick.Controls 1.4
 import QtQuick.Dialogs 1.2
+import org.videolan.vlmc 1.0
 
 Rectangle {
     id: page
@@ -19,11 +20,19 @@ Rectangle {
     property int scale: 4
     property var allClips: [] // Actual clip item objects
     property var selectedClips: [] // Actual clip item objects
-    property var groups: [] // list of lists of clip uuids
+    // Uuids of the clips around the visible part of the timeline, in frames. Only those
+    // have a delegate, the tracks draw the others.
+    property var visibleClips: ({})
+    property var liveRange: ({ "begin": 0, "end": 0 })
+    // The clip whose following cut is being rolled with [ and ], while the preview
+    // plays around it
+    property string trimmedClip: ""
     property alias isMagneticMode: magneticModeButton.selected
     property alias isCutMode: cutModeButton.selected
 
     property int trackHeight: 60
+    // Clips narrower than this many pixels are drawn by their track as density bars
+    readonly property int lodWidth: 4
 
     function clearSelectedClips() {
         while ( selectedClips.length ) {
@@ -66,22 +75,12 @@ Rectangle {
         return Math.round( pixels * fps / 1000 / ppu * unit );
     }
 
+    // The TrackListModel of the tracks of this type
     function trackContainer( trackType )
     {
         if ( trackType === "Video" )
-            return trackContainers.get( 0 );
-        return trackContainers.get( 1 );
-    }
-
-    function addTrack( trackType )
-    {
-        trackContainer( trackType )["tracks"].append( { "clips": [] } );
-    }
-
-    function removeTrack( trackType )
-    {
-        var tracks = trackContainer( trackType )["tracks"];
-        tracks.remove( tracks.count - 1 );
+            return videoTracks;
+        return audioTracks;
     }
 
     function addClip( trackType, trackId, clipDict )
@@ -96,34 +95,19 @@ Rectangle {
         newDict["name"] = clipDict["name"];
         newDict["selected"] = clipDict["selected"] === false ? false : true ;
         newDict["linkedClip"] = clipDict["linkedClip"] ? clipDict["linkedClip"] : "";
-        var tracks = trackContainer( trackType )["tracks"];
-        while ( trackId > tracks.count - 1 )
-            addTrack( trackType );
-        tracks.get( trackId )["clips"].append( newDict );
+        trackContainer( trackType ).addClip( trackId, newDict );
         return newDict;
     }
 
     function removeClipFromTrack( trackType, trackId, uuid )
     {
-        var ret = false;
-        var tracks = trackContainer( trackType )["tracks"];
-        var clips = tracks.get( trackId )["clips"];
-
-        for ( var j = 0; j < clips.count; j++ ) {
-            var clip = clips.get( j );
-            if ( clip.uuid === uuid ) {
-                clips.remove( j );
-                ret = true;
-                j--;
-            }
-        }
-        return ret;
+        var clips = trackContainer( trackType ).get( trackId );
+        return clips ? clips.remove( uuid ) : false;
     }
 
     function removeClipFromTrackContainer( trackType, uuid )
     {
-        for ( var i = 0; i < trackContainer( trackType )["tracks"].count; i++  )
-            removeClipFromTrack( trackType, i, uuid );
+        trackContainer( trackType ).removeClip( uuid );
     }
 
     function removeClip( uuid )
@@ -132,37 +116,27 @@ Rectangle {
         removeClipFromTrackContainer( "Video", uuid );
     }
 
+    // The roles of the clip, as a copy: changing them goes through setClipData()
     function findClipFromTrackContainer( trackType, uuid )
     {
-        var tracks = trackContainer( trackType )["tracks"];
-        for ( var i = 0; i < tracks.count; i++  ) {
-            var clip = findClipFromTrack( trackType, i, uuid );
-            if( clip )
-                return clip;
-        }
-
-        return null;
+        var clip = trackContainer( trackType ).find( uuid );
+        return clip ? clip : null;
     }
 
     function findClipFromTrack( trackType, trackId, uuid )
     {
-        var clips = trackContainer( trackType )["tracks"].get( trackId )["clips"];
-        for ( var j = 0; j < clips.count; j++ ) {
-            var clip = clips.get( j );
-            if ( clip.uuid === uuid )
-                return clip;
-        }
-        return null;
+        var clips = trackContainer( trackType ).get( trackId );
+        var clip = clips ? clips.get( uuid ) : null;
+        return clip ? clip : null;
     }
 
-    function findClip( uuid )
+    // Changes the roles of a clip in its track model
+    function setClipData( uuid, values )
     {
-        var v = findClipFromTrackContainer( "Video", uuid );
-        if ( !v )
-            return findClipFromTrackContainer( "Audio", uuid );
-        return v;
+        return videoTracks.setClipData( uuid, values ) || audioTracks.setClipData( uuid, values );
     }
 
+    // Only the clips which have a delegate loaded have an item
     function findClipItem( uuid ) {
         for ( var i = 0; i < allClips.length; ++i ) {
             if ( uuid === allClips[i].uuid )
@@ -171,6 +145,39 @@ Rectangle {
         return null;
     }
 
+    // Loads the delegate of the clip if needed
+    function selectClip( uuid ) {
+        var item = findClipItem( uuid );
+        if ( item ) {
+            item.selected = true;
+            return;
+        }
+        setClipData( uuid, { "selected": true } );
+    }
+
+    // Updates the delegate of the clip, or its model when it has none
+    function updateClip( uuid, clipInfo ) {
+        var item = findClipItem( uuid );
+        if ( !item ) {
+            setClipData( uuid, { "position": clipInfo["position"], "begin": clipInfo["begin"],
+                                 "end": clipInfo["end"] } );
+            return;
+        }
+        item.position = clipInfo["position"];
+        item.begin = clipInfo["begin"];
+        item.end = clipInfo["end"];
+        item.updateEffects( clipInfo );
+    }
+
+    function setLinkedClip( uuid, linkedClip ) {
+        var item = findClipItem( uuid );
+        if ( item ) {
+            item.linkedClip = linkedClip;
+            return;
+        }
+        setClipData( uuid, { "linkedClip": linkedClip } );
+    }
+
     function moveClipTo( trackType, uuid, trackId, position )
     {
         var clip = findClipItem( uuid );
@@ -181,20 +188,14 @@ Rectangle {
     }
 
     function adjustTracks( trackType ) {
-        var tracks = trackContainer( trackType )["tracks"];
-
-        while ( tracks.count > 1 && tracks.get( tracks.count - 1 )["clips"].count === 0 &&
-               tracks.get( tracks.count - 2 )["clips"].count === 0 )
-            removeTrack( trackType );
-
-        if ( tracks.get( tracks.count - 1 )["clips"].count > 0 )
-            addTrack( trackType );
+        trackContainer( trackType ).adjustTracks();
     }
 
     function addMarker( pos ) {
         markers.append( {
                            "position": pos
                        } );
+        workflow.addMarker( pos );
     }
 
     function findMarker( pos ) {
@@ -210,38 +211,12 @@ Rectangle {
         for ( var i = 0; i < markers.count; ++i ) {
             if ( markers.get( i )["position"] === pos ) {
                 markers.remove( i );
+                workflow.removeMarker( pos );
                 return;
             }
         }
     }
 
-    function addGroup( clips ) {
-        groups.push( clips );
-    }
-
-    function findGroup( uuid ) {
-        for ( var i = 0; i < groups.length; ++i ) {
-            var group = groups[i];
-            for ( var j = 0; j < group.length; ++j ) {
-                if ( group[j] === uuid )
-                    return group;
-            }
-        }
-        return null;
-    }
-
-    function removeGroup( uuid ) {
-        for ( var i = 0; i < groups.length; ++i ) {
-            var group = groups[i];
-            for ( var j = 0; j < group.length; ++j ) {
-                if ( group[j] === uuid ) {
-                    groups.splice( i, 1 );
-                    return;
-                }
-            }
-        }
-    }
-
     function zoomIn( ratio ) {
         var newPpu = ppu;
         var newUnit = unit;
@@ -291,34 +266,57 @@ Rectangle {
         mainwindow.setScale( scale );
     }
 
+    function updateVisibleClips() {
+        // One screen on each side, so that scrolling doesn't show empty clips
+        var margin = sView.width;
+        var left = sView.flickableItem.contentX - initPosOfCursor;
+        var begin = Math.max( 0, ptof( left - margin ) );
+        var end = ptof( left + sView.width + margin );
+        var uuids = workflow.clipsInRange( begin, end );
+        var visible = {};
+        for ( var i = 0; i < uuids.length; ++i )
+            visible[uuids[i]] = true;
+        visibleClips = visible;
+        liveRange = { "begin": begin, "end": end };
+    }
+
+    // Coalesces the updates while scrolling or zooming
+    Timer {
+        id: visibleClipsTimer
+        interval: 50
+        onTriggered: updateVisibleClips()
+    }
+
+    Connections {
+        target: sView.flickableItem
+        onContentXChanged: visibleClipsTimer.restart()
+        onWidthChanged: visibleClipsTimer.restart()
+    }
+
+    onPpuChanged: visibleClipsTimer.restart()
+    onUnitChanged: visibleClipsTimer.restart()
+
     function dragFinished() {
         var _length = selectedClips.length;
+        workflow.beginBatch();
         for ( var i = _length - 1; i >= 0; --i ) {
             if ( selectedClips[i] ) {
                 selectedClips[i].move();
             }
         }
+        workflow.commitBatch();
         adjustTracks( "Audio" );
         adjustTracks( "Video" );
     }
 
-    ListModel {
-        id: trackContainers
-
-        ListElement {
-            name: "Video"
-            tracks: []
-        }
-
-        ListElement {
-            name: "Audio"
-            tracks: []
-        }
+    TrackListModel {
+        id: videoTracks
+        audio: false
+    }
 
-        Component.onCompleted: {
-            addTrack( "Video" );
-            addTrack( "Audio" );
-        }
+    TrackListModel {
+        id: audioTracks
+        audio: true
     }
 
     ListModel {
@@ -376,7 +374,7 @@ Rectangle {
                 id: videoTrackContainer
                 type: "Video"
                 isUpward: true
-                tracks: trackContainers.get( 0 )["tracks"]
+                tracks: videoTracks
             }
 
             Rectangle {
@@ -407,7 +405,7 @@ Rectangle {
                 id: audioTrackContainer
                 type: "Audio"
                 isUpward: false
-                tracks: trackContainers.get( 1 )["tracks"]
+                tracks: audioTracks
             }
 
             Item {
@@ -518,6 +516,16 @@ Rectangle {
                                 workflow.showEffectStack();
                                 selected = false;
                             }
+
+                            // Applies to the whole sequence
+                            DropArea {
+                                anchors.fill: parent
+                                keys: ["vlmc/effect_name"]
+
+                                onDropped: {
+                                    workflow.addSequenceEffect( drop.getDataAsString( "vlmc/effect_name" ) );
+                                }
+                            }
                         }
                     }
                 }
@@ -549,8 +557,10 @@ Rectangle {
         icon: StandardIcon.Question
         standardButtons: StandardButton.Yes | StandardButton.No
         onYes: {
-            while ( selectedClips.length )
-                workflow.removeClip( selectedClips[0].uuid );
+            var l = [];
+            for ( var i = 0; i < selectedClips.length; ++i )
+                l.push( "" + selectedClips[i].uuid );
+            workflow.removeClips( l );
         }
     }
 
@@ -568,6 +578,19 @@ Rectangle {
                  scale < 9 ) {
             zoomIn( 0.5 );
         }
+        else if ( ( event.key === Qt.Key_BracketLeft || event.key === Qt.Key_BracketRight ) &&
+                  selectedClips.length === 1 ) {
+            var uuid = "" + selectedClips[0].uuid;
+            if ( trimmedClip !== uuid ) {
+                trimmedClip = uuid;
+                workflow.startTrimPreview( uuid );
+            }
+            workflow.rollClip( uuid, event.key === Qt.Key_BracketLeft ? -1 : 1 );
+        }
+        else if ( event.key === Qt.Key_Escape && trimmedClip !== "" ) {
+            trimmedClip = "";
+            workflow.stopTrimPreview();
+        }
         event.accepted = true;
     }
 
@@ -578,31 +601,51 @@ Rectangle {
             page.fps = fps;
         }
 
+        // The workflow scaled its own copy of the markers already
+        onRescaled: {
+            for ( var i = 0; i < markers.count; ++i )
+                markers.setProperty( i, "position", Math.round( markers.get( i )["position"] * ratio ) );
+        }
+
         onLengthChanged: {
             page.length = length;
         }
 
         onClipAdded: {
-            var clipInfo = workflow.clipInfo( uuid );
-            var type = clipInfo["audio"] ? "Audio" : "Video";
-            clipInfo["selected"] = false;
-            addClip( type, clipInfo["trackId"], clipInfo );
-            adjustTracks( type );
+            visibleClipsTimer.restart();
+            // Each container only adds the clips of its type
+            videoTracks.addClips( [uuid] );
+            audioTracks.addClips( [uuid] );
+            adjustTracks( "Audio" );
+            adjustTracks( "Video" );
+
+            zoomIn( page.width / sView.flickableItem.contentWidth );
+        }
+
+        onClipsLoaded: {
+            visibleClipsTimer.restart();
+            videoTracks.loadClips();
+            audioTracks.loadClips();
+            adjustTracks( "Audio" );
+            adjustTracks( "Video" );
 
             zoomIn( page.width / sView.flickableItem.contentWidth );
         }
 
         onClipMoved: {
+            visibleClipsTimer.restart();
             var clipInfo = workflow.clipInfo( uuid );
             var type = clipInfo["audio"] ? "Audio" : "Video";
             var oldClip = findClipFromTrackContainer( type, uuid );
+            if ( !oldClip )
+                return;
 
             if ( clipInfo["trackId"] !== oldClip["trackId"] ) {
                 addClip( type, clipInfo["trackId"], clipInfo );
                 removeClipFromTrack( type, oldClip["trackId"], uuid );
             }
             else if ( oldClip["position"] !== clipInfo["position"] ) {
-                findClipItem( uuid ).position = clipInfo["position"];
+                updateClip( uuid, clipInfo );
             }
             adjustTracks( type );
         }
@@ -613,18 +656,29 @@ Rectangle {
             adjustTracks( "Video" );
         }
 
+        onClipsAdded: {
+            visibleClipsTimer.restart();
+            videoTracks.addClips( uuids );
+            audioTracks.addClips( uuids );
+            adjustTracks( "Audio" );
+            adjustTracks( "Video" );
+        }
+
+        onClipsRemoved: {
+            for ( var i = 0; i < uuids.length; ++i )
+                removeClip( uuids[i] );
+            adjustTracks( "Audio" );
+            adjustTracks( "Video" );
+        }
+
         onClipResized: {
-            var clipInfo = workflow.clipInfo( uuid );
-            var clip = findClipItem( uuid );
-            clip.position = clipInfo["position"];
-            clip.end = clipInfo["end"];
-            clip.begin = clipInfo["begin"];
-            clip.updateEffects( clipInfo );
+            visibleClipsTimer.restart();
+            updateClip( uuid, workflow.clipInfo( uuid ) );
         }
 
         onClipLinked: {
-            findClipItem( uuidA ).linkedClip = uuidB;
-            findClipItem( uuidB ).linkedClip = uuidA;
+            setLinkedClip( uuidA, uuidB );
+            setLinkedClip( uuidB, uuidA );
         }
 
         onEffectsUpdated: {
@@ -647,10 +701,11 @@ Rectangle {
     }
 
     Connections {
-        target: thumbnailProvider
-        onImageReady: {
+        target: waveformProvider
+        onWaveformReady: {
             var clipItem = findClipItem( uuid );
-            clipItem.updateThumbnail( clipItem.begin );
+            if ( clipItem )
+                clipItem.updateWaveform();
         }
     }
 }
@@ -0,0 +1,110 @@
+/*****************************************************************************
+ * MemoryWidget.cpp: Memory held by each subsystem
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <QHeaderView>
+#include <QJsonObject>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include "MemoryWidget.h"
+#include "Tools/Metrics.h"
+
+namespace
+{
+    enum Column
+    {
+        Subsystem,
+        Bytes,
+        Objects,
+        NbColumns
+    };
+
+    const QString   Prefix = QStringLiteral( "memory." );
+
+    QString
+    formatSize( qint64 bytes )
+    {
+        if ( bytes <= 0 )
+            return QStringLiteral( "-" );
+        if ( bytes < 1024 * 1024 )
+            return QObject::tr( "%1 KiB" ).arg( bytes / 1024.0, 0, 'f', 1 );
+        return QObject::tr( "%1 MiB" ).arg( bytes / ( 1024.0 * 1024.0 ), 0, 'f', 1 );
+    }
+}
+
+MemoryWidget::MemoryWidget( QWidget* parent )
+    : QWidget( parent )
+{
+    setObjectName( QStringLiteral( "Memory" ) );
+    setWindowTitle( tr( "Memory" ) );
+    m_accounts = new QTreeWidget( this );
+    m_accounts->setColumnCount( NbColumns );
+    m_accounts->setHeaderLabels( { tr( "Subsystem" ), tr( "Memory" ), tr( "Objects" ) } );
+    m_accounts->setRootIsDecorated( false );
+    m_accounts->setSortingEnabled( true );
+    m_accounts->sortByColumn( Subsystem, Qt::AscendingOrder );
+    m_accounts->header()->setSectionResizeMode( Subsystem, QHeaderView::Stretch );
+    auto layout = new QVBoxLayout( this );
+    layout->setContentsMargins( 0, 0, 0, 0 );
+    layout->addWidget( m_accounts );
+
+    m_timer.setInterval( 1000 );
+    connect( &m_timer, &QTimer::timeout, this, &MemoryWidget::refresh );
+}
+
+void
+MemoryWidget::showEvent( QShowEvent* event )
+{
+    refresh();
+    m_timer.start();
+    QWidget::showEvent( event );
+}
+
+void
+MemoryWidget::hideEvent( QHideEvent* event )
+{
+    m_timer.stop();
+    QWidget::hideEvent( event );
+}
+
+void
+MemoryWidget::refresh()
+{
+    // "memory.<subsystem>.bytes" and "memory.<subsystem>.objects"
+    auto metrics = Tools::Metrics::toJson( Prefix );
+    for ( auto it = metrics.constBegin(); it != metrics.constEnd(); ++it )
+    {
+        auto name = it.key().mid( Prefix.size() );
+        auto dot = name.lastIndexOf( '.' );
+        auto subsystem = name.left( dot );
+        auto column = name.mid( dot + 1 ) == QLatin1String( "bytes" ) ? Bytes : Objects;
+        auto items = m_accounts->findItems( subsystem, Qt::MatchExactly, Subsystem );
+        auto item = items.isEmpty() == true ? new QTreeWidgetItem( m_accounts, { subsystem } )
+                                            : items.first();
+        auto value = static_cast<qint64>( it.value().toDouble() );
+        if ( column == Bytes )
+            item->setText( Bytes, formatSize( value ) );
+        else
+            item->setText( Objects, QString::number( value ) );
+        item->setTextAlignment( column, Qt::AlignRight | Qt::AlignVCenter );
+    }
+}
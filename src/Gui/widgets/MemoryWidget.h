@@ -1,9 +1,9 @@
 /*****************************************************************************
- * ListViewController.h:
+ * MemoryWidget.h: Memory held by each subsystem
  *****************************************************************************
  * Copyright (C) 2008-2016 VideoLAN
  *
- * Authors: Thomas Boquet <thomas.boquet@gmail.com>
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License
@@ -20,40 +20,37 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
-#ifndef LISTVIEWCONTROLLER_H
-#define LISTVIEWCONTROLLER_H
+#ifndef MEMORYWIDGET_H
+#define MEMORYWIDGET_H
 
-#include "ViewController.h"
+#include <QTimer>
+#include <QWidget>
 
-#include <QObject>
+class QTreeWidget;
 
-class   StackViewController;
-
-class   QVBoxLayout;
-class   QScrollArea;
-
-class ListViewController : public ViewController
+/**
+ *  \brief  Debug view of the memory accounts, \sa Tools::Metrics::MemoryAccount
+ *
+ *  Lists the bytes and objects held by each subsystem, updated every second while the
+ *  widget is visible.
+ */
+class MemoryWidget : public QWidget
 {
     Q_OBJECT
 
 public:
-    ListViewController( StackViewController* nav );
-    ~ListViewController();
-
-    QWidget*        view() const;
-    const QString&  title() const;
-    void            addCell( QWidget* cell );
-    void            removeCell( QWidget* cell );
+    explicit MemoryWidget( QWidget* parent = nullptr );
 
 protected:
-    QVBoxLayout*                m_layout;
-    QWidget*                    m_container;
+    virtual void    showEvent( QShowEvent* event ) override;
+    virtual void    hideEvent( QHideEvent* event ) override;
 
-private:
-    QString                     m_title;
-    QScrollArea*                m_scrollArea;
+private slots:
+    void            refresh();
 
-    StackViewController*        m_nav;
+private:
+    QTreeWidget*    m_accounts;
+    QTimer          m_timer;
 };
 
-#endif // LISTVIEWCONTROLLER_H
+#endif // MEMORYWIDGET_H
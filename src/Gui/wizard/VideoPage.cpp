@@ -168,6 +168,14 @@ VideoPage::updateVideoPresets()
         setVideoResolution( 1920, 1080 );
         setVideoFPS( 29.97 );
         break;
+    case PRESET_2160p:
+        setVideoResolution( 3840, 2160 );
+        setVideoFPS( 29.97 );
+        break;
+    case PRESET_4320p:
+        setVideoResolution( 7680, 4320 );
+        setVideoFPS( 29.97 );
+        break;
     }
 }
 
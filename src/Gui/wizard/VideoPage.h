@@ -49,6 +49,8 @@ class VideoPage : public QWizardPage
             PRESET_720p,    // HDTV
             PRESET_1080i,   // HDTV
             PRESET_1080p,   // HDTV
+            PRESET_2160p,   // UHDTV
+            PRESET_4320p,   // UHDTV
         };
 
         enum AudioPresets
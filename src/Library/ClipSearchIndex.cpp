@@ -0,0 +1,154 @@
+/*****************************************************************************
+ * ClipSearchIndex.cpp: Inverted index of the clips names, tags and notes
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ClipSearchIndex.h"
+
+#include "Media/Clip.h"
+#include "Media/Media.h"
+
+#include <algorithm>
+
+namespace
+{
+    const int   MaxGramLength = 3;
+}
+
+QSet<QString>
+ClipSearchIndex::grams( const QString& text, int maxLength )
+{
+    QSet<QString>   res;
+    for ( int n = 1; n <= maxLength; ++n )
+    {
+        for ( int i = 0; i + n <= text.size(); ++i )
+            res.insert( text.mid( i, n ) );
+    }
+    return res;
+}
+
+bool
+ClipSearchIndex::matches( Field field, const QStringList& texts, const QString& query )
+{
+    for ( const auto& text : texts )
+    {
+        if ( field == Tags ? text.startsWith( query ) : text.contains( query ) )
+            return true;
+    }
+    return false;
+}
+
+void
+ClipSearchIndex::add( const Clip* clip )
+{
+    remove( clip->uuid() );
+    QStringList texts[NbFields];
+    texts[Name] << clip->media()->fileName().toLower();
+    for ( const auto& tag : clip->metaTags() )
+        texts[Tags] << tag.toLower();
+    if ( clip->notes().isEmpty() == false )
+        texts[Notes] << clip->notes().toLower();
+
+    for ( int f = 0; f < NbFields; ++f )
+    {
+        if ( texts[f].isEmpty() == true )
+            continue;
+        QSet<QString>   all;
+        for ( const auto& text : texts[f] )
+            all += grams( text, MaxGramLength );
+        for ( const auto& g : all )
+            m_postings[f][g].insert( clip->uuid() );
+        m_texts[f].insert( clip->uuid(), texts[f] );
+    }
+}
+
+void
+ClipSearchIndex::remove( const QUuid& uuid )
+{
+    for ( int f = 0; f < NbFields; ++f )
+    {
+        auto it = m_texts[f].find( uuid );
+        if ( it == m_texts[f].end() )
+            continue;
+        QSet<QString>   all;
+        for ( const auto& text : it.value() )
+            all += grams( text, MaxGramLength );
+        for ( const auto& g : all )
+        {
+            auto posting = m_postings[f].find( g );
+            if ( posting == m_postings[f].end() )
+                continue;
+            posting->remove( uuid );
+            if ( posting->isEmpty() == true )
+                m_postings[f].erase( posting );
+        }
+        m_texts[f].erase( it );
+    }
+}
+
+void
+ClipSearchIndex::clear()
+{
+    for ( int f = 0; f < NbFields; ++f )
+    {
+        m_texts[f].clear();
+        m_postings[f].clear();
+    }
+}
+
+QSet<QUuid>
+ClipSearchIndex::match( Field field, const QString& query, const QSet<QUuid>* within ) const
+{
+    QSet<QUuid> res;
+    auto q = query.toLower();
+    if ( q.isEmpty() == true )
+        return res;
+
+    const QSet<QUuid>*  candidates = within;
+    QSet<QUuid>         intersection;
+    if ( candidates == nullptr )
+    {
+        // The rarest grams first, so that the intersection shrinks right away
+        QList<const QSet<QUuid>*>   postings;
+        auto n = std::min( MaxGramLength, q.size() );
+        for ( int i = 0; i + n <= q.size(); ++i )
+        {
+            auto it = m_postings[field].find( q.mid( i, n ) );
+            if ( it == m_postings[field].end() )
+                return res;
+            postings << &it.value();
+        }
+        std::sort( postings.begin(), postings.end(), []( const QSet<QUuid>* a, const QSet<QUuid>* b ) {
+            return a->size() < b->size();
+        } );
+        intersection = *postings.first();
+        for ( int i = 1; i < postings.size() && intersection.isEmpty() == false; ++i )
+            intersection.intersect( *postings[i] );
+        candidates = &intersection;
+    }
+    // The grams don't tell where they are, nor whether they all are in the same text
+    for ( const auto& uuid : *candidates )
+    {
+        auto it = m_texts[field].find( uuid );
+        if ( it != m_texts[field].end() && matches( field, it.value(), q ) == true )
+            res.insert( uuid );
+    }
+    return res;
+}
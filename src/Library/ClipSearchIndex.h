@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * ClipSearchIndex.h: Inverted index of the clips names, tags and notes
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef CLIPSEARCHINDEX_H
+#define CLIPSEARCHINDEX_H
+
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QUuid>
+
+class Clip;
+
+/**
+ *  \brief  Finds the clips matching a search, without going through all of them.
+ *
+ *  Every piece of text of a clip is indexed by its 1, 2 and 3 characters long
+ *  substrings, lower cased. A search only checks the clips which contain every
+ *  trigram of the query, or its unigrams and bigrams when it's shorter.
+ */
+class ClipSearchIndex
+{
+    public:
+        enum Field
+        {
+            // The file name of the clip's media, matched anywhere
+            Name,
+            // The clip's tags, matched by their beginning
+            Tags,
+            // The clip's notes, matched anywhere
+            Notes,
+            NbFields
+        };
+
+        // Indexes the clip, or updates it if it already is
+        void            add( const Clip* clip );
+        void            remove( const QUuid& uuid );
+        void            clear();
+
+        /**
+         *  \brief  Returns the clips whose field matches query.
+         *
+         *  When within is given, only those clips are checked: this is meant for a
+         *  query which extends the previous one, as the user types.
+         *  An empty query matches nothing: the caller knows all the clips already.
+         */
+        QSet<QUuid>     match( Field field, const QString& query,
+                               const QSet<QUuid>* within = nullptr ) const;
+
+    private:
+        static QSet<QString>        grams( const QString& text, int maxLength );
+        static bool                 matches( Field field, const QStringList& texts, const QString& query );
+
+    private:
+        // Per field, what was indexed of each clip, lower cased
+        QHash<QUuid, QStringList>           m_texts[NbFields];
+        // Per field, the clips containing each gram
+        QHash<QString, QSet<QUuid>>         m_postings[NbFields];
+};
+
+#endif // CLIPSEARCHINDEX_H
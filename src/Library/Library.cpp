@@ -32,55 +32,669 @@
 #endif
 
 #include "Library.h"
+#include "ProbeCache.h"
+#include "Backend/IBackend.h"
+#include "Backend/MLT/MLTInput.h"
 #include "Media/Clip.h"
 #include "Media/Media.h"
 #include "Project/Project.h"
 #include "Settings/Settings.h"
+#include "Tools/Multicam.h"
+#include "Tools/NestedSequence.h"
+#include "Tools/Title.h"
 #include "Tools/VlmcDebug.h"
 #include "Project/Workspace.h"
+#include "Main/Core.h"
+#include "Workflow/AudioConformService.h"
+#include "Workflow/DecodeBenchmarkService.h"
+#include "Workflow/FrameIndexService.h"
+#include "Workflow/FrameRateConformService.h"
+#include "Workflow/ProxyService.h"
+#include "Workflow/SceneDetectionService.h"
+#include "Workflow/WaveformService.h"
 
 #include <QVariant>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
 #include <QUuid>
 
-Library::Library( Settings *projectSettings )
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+// The length of a placeholder whose file's length isn't known: 24 hours at 30fps
+const qint64    PlaceholderLength = 24 * 3600 * 30;
+
+/**
+ *  \brief Opens the input of a media being loaded, which is where the time goes: the
+ *         file gets opened and its streams probed.
+ *
+ *  Either nbDone gets incremented, or the library notified through mediaProbed(), once
+ *  input is set.
+ */
+class MediaProbe
+{
+public:
+    MediaProbe( const QString& path, const Backend::MLT::MLTInput::Properties& probed,
+                std::unique_ptr<Backend::IInput>& input, QAtomicInt* nbDone,
+                Library* library = nullptr )
+        : m_path( path )
+        , m_probed( probed )
+        , m_input( input )
+        , m_nbDone( nbDone )
+        , m_library( library )
+    {
+    }
+
+    void operator()( const Tools::JobScheduler::CancellationToken& )
+    {
+        try
+        {
+            if ( m_probed.empty() == false )
+            {
+                m_input.reset( new Backend::MLT::MLTInput( qPrintable( m_path ), m_probed ) );
+                // The other projects using this file needn't probe it either
+                Core::instance()->probeCache()->insert( m_path, Backend::MLT::MLTInput::mediaInfo( m_probed ) );
+            }
+            else
+                m_input = Media::openInput( m_path );
+        }
+        catch ( Backend::InvalidServiceException& )
+        {
+            // Left to the media to fail again, as it would without probing
+        }
+        if ( m_nbDone != nullptr )
+            m_nbDone->ref();
+        if ( m_library != nullptr )
+            QMetaObject::invokeMethod( m_library, "mediaProbed", Qt::QueuedConnection,
+                                       Q_ARG( QString, m_path ) );
+    }
+
+private:
+    QString                             m_path;
+    Backend::MLT::MLTInput::Properties  m_probed;
+    std::unique_ptr<Backend::IInput>&   m_input;
+    QAtomicInt*                         m_nbDone;
+    Library*                            m_library;
+};
+
+// The size and modification date tell whether the file changed since it was probed
+QVariantMap
+fileKey( const QString& path )
+{
+    QFileInfo   info( path );
+    return QVariantMap{
+        { "size", info.size() },
+        { "modified", info.lastModified().toMSecsSinceEpoch() }
+    };
+}
+
+bool
+isUnchanged( const QVariantMap& recorded, const QString& path )
+{
+    auto key = fileKey( path );
+    return recorded.isEmpty() == false && recorded["size"].toLongLong() == key["size"].toLongLong() &&
+            recorded["modified"].toLongLong() == key["modified"].toLongLong();
+}
+
+// The properties of the last probe, if the file didn't change since
+Backend::MLT::MLTInput::Properties
+lastProbe( const QVariantMap& probe, const QString& path )
+{
+    Backend::MLT::MLTInput::Properties  probed;
+    if ( isUnchanged( probe, path ) == false )
+        return probed;
+    auto properties = probe["properties"].toMap();
+    for ( auto it = properties.cbegin(); it != properties.cend(); ++it )
+        probed[it.key().toStdString()] = it.value().toString().toStdString();
+    return probed;
+}
+
+// The uuids of the subclips of clip, at any depth
+void
+subclipUuids( const Clip* clip, QList<QUuid>& uuids )
+{
+    auto childs = clip->mediaContainer();
+    if ( childs == nullptr )
+        return;
+    for ( auto c : childs->clips() )
+    {
+        uuids << c->uuid();
+        subclipUuids( c, uuids );
+    }
+}
+
+// Extends clip and its subclips which ended with their growing media
+void
+extendClips( Clip* clip, qint64 oldLength )
+{
+    if ( clip->end() == oldLength - 1 )
+        clip->setEnd( clip->media()->input()->length() - 1 );
+    auto childs = clip->mediaContainer();
+    if ( childs == nullptr )
+        return;
+    for ( auto c : childs->clips() )
+        extendClips( c, oldLength );
+}
+
+// Cuts the subclips of clip again, once it was
+void
+reloadSubclips( const Clip* clip )
+{
+    auto childs = clip->mediaContainer();
+    if ( childs == nullptr )
+        return;
+    for ( auto c : childs->clips() )
+    {
+        c->reloadInput( true );
+        reloadSubclips( c );
+    }
+}
+
+// Moves the boundaries of the subclips of clip, at any depth, to the frames map returns
+void
+remapSubclips( const Clip* clip, const std::function<qint64( qint64 )>& map )
+{
+    auto childs = clip->mediaContainer();
+    if ( childs == nullptr )
+        return;
+    for ( auto c : childs->clips() )
+    {
+        c->setBoundaries( map( c->begin() ), map( c->end() ) );
+        remapSubclips( c, map );
+    }
+}
+
+QByteArray
+toJson( const QVariant& var )
+{
+    return QJsonDocument::fromVariant( var ).toJson( QJsonDocument::Compact );
+}
+
+}
+
+Library::Library( Settings *projectSettings, Tools::JobScheduler* scheduler )
     : m_cleanState( true )
     , m_settings( new Settings )
+    , m_projectSettings( projectSettings )
+    , m_storeCount( 0 )
+    , m_storeOffset( 0 )
+    , m_scheduler( scheduler )
+    , m_growthTimer( new QTimer( this ) )
 {
     m_settings->createVar( SettingValue::List, QString( "medias" ), QVariantList(), "", "", SettingValue::Nothing );
     m_settings->createVar( SettingValue::List, QString( "clips" ), QVariantList(), "", "", SettingValue::Nothing );
+    // Media path, hardware decoding API override
+    m_settings->createVar( SettingValue::Map, QString( "hardwareDecoding" ), QVariantMap(), "", "", SettingValue::Nothing );
+    // Media path, number of decoding threads overriding the budget's share
+    m_settings->createVar( SettingValue::Map, QString( "decodeThreads" ), QVariantMap(), "", "", SettingValue::Nothing );
+    // Media path, properties of the last probe along with the file's key
+    m_settings->createVar( SettingValue::Map, QString( "probes" ), QVariantMap(), "", "", SettingValue::Nothing );
+    // Media path, EBU R128 measurement along with the file's key
+    m_settings->createVar( SettingValue::Map, QString( "loudness" ), QVariantMap(), "", "", SettingValue::Nothing );
+    // Media path, frame rate conform mode, for those which aren't left to the backend
+    m_settings->createVar( SettingValue::Map, QString( "frameRateConform" ), QVariantMap(), "", "", SettingValue::Nothing );
+    // The paths of the medias still being recorded
+    m_settings->createVar( SettingValue::List, QString( "growing" ), QVariantList(), "", "", SettingValue::Nothing );
+    // The id of the database holding the clips, when they aren't in the project
+    m_settings->createVar( SettingValue::String, QString( "store" ), QString(), "", "", SettingValue::Nothing );
     connect( m_settings, &Settings::postLoad, this, &Library::postLoad, Qt::DirectConnection );
     connect( m_settings, &Settings::preSave, this, &Library::preSave, Qt::DirectConnection );
+    connect( m_settings, &Settings::preSnapshot, this, &Library::preSave, Qt::DirectConnection );
 
     projectSettings->addSettings( "Library", *m_settings );
+
+    m_growthTimer->setInterval( GrowthInterval );
+    connect( m_growthTimer, &QTimer::timeout, this, &Library::checkGrowingMedias );
 }
 
 void
 Library::preSave()
 {
+    openStore();
     QVariantList l;
+    QVariantMap hardwareDecoding;
+    QVariantMap decodeThreads;
+    QVariantMap frameRateConform;
+    QVariantMap probes;
+    QVariantMap loudness;
+    QVariantList growing;
+    // The medias which weren't loaded from the database keep what was saved of them
+    if ( m_store != nullptr )
+    {
+        hardwareDecoding = m_settings->value( "hardwareDecoding" )->get().toMap();
+        decodeThreads = m_settings->value( "decodeThreads" )->get().toMap();
+        frameRateConform = m_settings->value( "frameRateConform" )->get().toMap();
+        loudness = m_settings->value( "loudness" )->get().toMap();
+        growing = m_settings->value( "growing" )->get().toList();
+    }
+    auto proxies = Backend::instance()->proxies();
     for ( auto val : m_medias )
+    {
         l << val->toVariant();
-    m_settings->value( "medias" )->set( l );
-    l.clear();
-    for ( auto val : m_clips )
-        l << val->toVariantFull();
-    m_settings->value( "clips" )->set( l );
+        auto path = val->fileInfo()->absoluteFilePath();
+        hardwareDecoding.remove( path );
+        decodeThreads.remove( path );
+        frameRateConform.remove( path );
+        loudness.remove( path );
+        growing.removeAll( path );
+        if ( val->hardwareDecoding().isEmpty() == false )
+            hardwareDecoding[path] = val->hardwareDecoding();
+        if ( val->decodeThreads() > 0 )
+            decodeThreads[path] = val->decodeThreads();
+        if ( val->frameRateConform() != FrameRateConformService::Nearest )
+            frameRateConform[path] = (int)val->frameRateConform();
+        if ( val->isGrowing() == true )
+            growing << path;
+        if ( val->loudness().isValid() == true )
+        {
+            auto measure = fileKey( path );
+            measure.insert( "integrated", val->loudness().integrated );
+            measure.insert( "maxShortTerm", val->loudness().maxShortTerm );
+            measure.insert( "truePeak", val->loudness().truePeak );
+            loudness.insert( path, measure );
+        }
+        // A proxy's properties aren't the media's, nor a placeholder's
+        auto input = dynamic_cast<const Backend::MLT::MLTInput*>( val->input() );
+        if ( input == nullptr || val->isPlaceholder() == true || proxies.count( path.toStdString() ) != 0 )
+            continue;
+        QVariantMap properties;
+        for ( const auto& p : input->probedProperties() )
+            properties.insert( QString::fromStdString( p.first ), QString::fromStdString( p.second ) );
+        auto probe = fileKey( path );
+        probe.insert( "properties", properties );
+        probes.insert( path, probe );
+    }
+    m_settings->value( "hardwareDecoding" )->set( hardwareDecoding );
+    m_settings->value( "decodeThreads" )->set( decodeThreads );
+    m_settings->value( "frameRateConform" )->set( frameRateConform );
+    m_settings->value( "loudness" )->set( loudness );
+    m_settings->value( "growing" )->set( growing );
+    if ( m_store != nullptr && saveStore( probes ) == true )
+    {
+        m_settings->value( "medias" )->set( QVariantList() );
+        m_settings->value( "probes" )->set( QVariantMap() );
+        m_settings->value( "clips" )->set( QVariantList() );
+    }
+    else
+    {
+        m_settings->value( "medias" )->set( l );
+        m_settings->value( "probes" )->set( probes );
+        l.clear();
+        for ( auto val : m_clips )
+            l << val->toVariantFull();
+        m_settings->value( "clips" )->set( l );
+    }
     setCleanState( true );
 }
 
+bool
+Library::saveStore( const QVariantMap& probes )
+{
+    QList<LibraryStore::Entry>  entries;
+    for ( auto c : m_clips )
+    {
+        LibraryStore::Entry entry;
+        entry.uuid = c->uuid();
+        entry.path = c->media()->fileInfo()->absoluteFilePath();
+        entry.clip = toJson( c->toVariantFull() );
+        if ( probes.contains( entry.path ) == true )
+            entry.probe = toJson( probes[entry.path] );
+        subclipUuids( c, entry.subclips );
+        entries << entry;
+    }
+    if ( m_store->save( entries, m_storeRemovals ) == false )
+    {
+        vlmcCritical() << "Can't save the library database, saving the loaded clips in the project instead";
+        return false;
+    }
+    m_storeRemovals.clear();
+    m_storeCount = m_store->count();
+    return true;
+}
+
+void
+Library::openStore()
+{
+    if ( m_store != nullptr )
+        return;
+    auto id = m_settings->value( "store" )->get().toString();
+    if ( id.isEmpty() == true )
+    {
+        if ( VLMC_GET_BOOL( "vlmc/LibraryDatabase" ) == false )
+            return;
+        id = QUuid::createUuid().toString().mid( 1, 36 );
+    }
+    auto dir = VLMC_GET_STRING( "vlmc/WorkspaceLocation" );
+    if ( dir.isEmpty() == true )
+    {
+        vlmcWarning() << "The library database needs a workspace";
+        return;
+    }
+    std::unique_ptr<LibraryStore>   store( new LibraryStore );
+    if ( store->open( dir + "/.library/" + id + ".sqlite" ) == false )
+    {
+        vlmcCritical() << "Can't open the library database" << id;
+        return;
+    }
+    m_settings->value( "store" )->set( id );
+    m_store = std::move( store );
+    m_storeCount = m_store->count();
+    m_storeOffset = 0;
+}
+
+Clip*
+Library::materialize( const LibraryStore::Entry& entry )
+{
+    if ( m_storeRemovals.contains( entry.uuid ) == true )
+        return nullptr;
+    auto c = MediaContainer::clip( entry.uuid );
+    if ( c != nullptr )
+        return c;
+    // Loading what the project already holds doesn't change it
+    auto clean = m_cleanState;
+    auto path = mapPath( entry.path );
+    auto media = m_medias.value( path );
+    if ( media == nullptr )
+    {
+        Core::instance()->proxyService()->useExisting( path );
+        std::unique_ptr<Backend::IInput>    input;
+        if ( QFile::exists( path ) == true )
+        {
+            Backend::MLT::MLTInput::Properties  probed;
+            if ( Backend::instance()->proxies().count( path.toStdString() ) == 0 )
+                probed = lastProbe( QJsonDocument::fromJson( entry.probe ).object().toVariantMap(), path );
+            MediaProbe( path, probed, input, nullptr ).run();
+        }
+        if ( input != nullptr )
+            media = addMedia( QFileInfo( path ), std::move( input ) );
+        else
+            media = createMediaFromVariant( path );
+        if ( media == nullptr )
+        {
+            setCleanState( clean );
+            return nullptr;
+        }
+        setupMedia( media );
+    }
+    auto var = QJsonDocument::fromJson( entry.clip ).object().toVariantMap();
+    var["media"] = path;
+    c = createClipFromVariant( var, nullptr );
+    setCleanState( clean );
+    return c;
+}
+
+Clip*
+Library::clip( const QUuid& uuid )
+{
+    auto c = MediaContainer::clip( uuid );
+    if ( c != nullptr || m_store == nullptr || m_storeRemovals.contains( uuid ) == true )
+        return c;
+    LibraryStore::Entry entry;
+    if ( m_store->find( uuid, entry ) == false || materialize( entry ) == nullptr )
+        return nullptr;
+    return MediaContainer::clip( uuid );
+}
+
+Clip*
+Library::clip( const QString& uuid )
+{
+    return clip( QUuid( uuid ) );
+}
+
+bool
+Library::canFetchMore() const
+{
+    return m_store != nullptr && m_storeOffset < m_storeCount;
+}
+
+void
+Library::fetchMore( int count )
+{
+    if ( m_store == nullptr )
+        return;
+    auto entries = m_store->page( m_storeOffset, count );
+    // The count is only refreshed on save, don't ask again for a page past the end
+    m_storeOffset = entries.isEmpty() == true ? m_storeCount : m_storeOffset + entries.size();
+    for ( const auto& entry : entries )
+        materialize( entry );
+}
+
+void
+Library::deleteClip( const QUuid& uuid )
+{
+    if ( m_store != nullptr && m_clips.contains( uuid ) == true )
+        m_storeRemovals << uuid;
+    MediaContainer::deleteClip( uuid );
+}
+
+void
+Library::clear()
+{
+    // The placeholders go along with their medias
+    m_scheduler->cancel( m_probes );
+    m_scheduler->wait( m_probes );
+    m_probes = Tools::JobScheduler::CancellationToken();
+    m_probing.clear();
+    m_growthTimer->stop();
+    m_scheduler->cancel( m_growthProbes );
+    m_scheduler->wait( m_growthProbes );
+    m_growthProbes = Tools::JobScheduler::CancellationToken();
+    m_growthSizes.clear();
+    m_growthProbing.clear();
+    MediaContainer::clear();
+    m_store.reset();
+    m_storeCount = 0;
+    m_storeOffset = 0;
+    m_storeRemovals.clear();
+    m_settings->value( "store" )->set( QString() );
+}
+
+void
+Library::setPathMappings( const QMap<QString, QString>& mappings )
+{
+    m_pathMappings = mappings;
+}
+
+QString
+Library::mapPath( const QString& path ) const
+{
+    QString prefix;
+    for ( auto it = m_pathMappings.cbegin(); it != m_pathMappings.cend(); ++it )
+    {
+        if ( it.key().size() > prefix.size() && path.startsWith( it.key() ) == true )
+            prefix = it.key();
+    }
+    if ( prefix.isEmpty() == true )
+        return path;
+    return m_pathMappings[prefix] + path.mid( prefix.size() );
+}
+
+void
+Library::remapPaths()
+{
+    auto medias = m_settings->value( "medias" )->get().toList();
+    for ( auto& var : medias )
+        var = mapPath( var.toString() );
+    m_settings->value( "medias" )->set( medias );
+    auto growing = m_settings->value( "growing" )->get().toList();
+    for ( auto& var : growing )
+        var = mapPath( var.toString() );
+    m_settings->value( "growing" )->set( growing );
+
+    for ( const auto name : { "hardwareDecoding", "decodeThreads", "frameRateConform", "probes", "loudness" } )
+    {
+        QVariantMap mapped;
+        auto map = m_settings->value( name )->get().toMap();
+        for ( auto it = map.cbegin(); it != map.cend(); ++it )
+            mapped.insert( mapPath( it.key() ), it.value() );
+        m_settings->value( name )->set( mapped );
+    }
+
+    // The clips refer to their media by path
+    auto clips = m_settings->value( "clips" )->get().toList();
+    for ( auto& var : clips )
+    {
+        auto h = var.toMap();
+        if ( h.contains( "media" ) == true )
+            h["media"] = mapPath( h["media"].toString() );
+        var = h;
+    }
+    m_settings->value( "clips" )->set( clips );
+}
+
 void
 Library::postLoad()
 {
-    for ( const auto& var : m_settings->value( "medias" )->get().toList() )
-        createMediaFromVariant( var );
+    if ( m_pathMappings.isEmpty() == false )
+        remapPaths();
+
+    // Overrides must be known before the medias open their inputs
+    auto hardwareDecoding = m_settings->value( "hardwareDecoding" )->get().toMap();
+    for ( auto it = hardwareDecoding.cbegin(); it != hardwareDecoding.cend(); ++it )
+        Backend::instance()->setMediaHardwareDecoding( it.key().toStdString(), it.value().toString().toStdString() );
+    auto decodeThreads = m_settings->value( "decodeThreads" )->get().toMap();
+    for ( auto it = decodeThreads.cbegin(); it != decodeThreads.cend(); ++it )
+        Backend::instance()->setMediaDecodeThreads( it.key().toStdString(), it.value().toInt() );
+
+    auto medias = m_settings->value( "medias" )->get().toList();
+    for ( const auto& var : medias )
+        Core::instance()->proxyService()->useExisting( var.toString() );
+
+    // Probed in parallel, as this is mostly waiting for the files to be read. The
+    // timeline needs every media it refers to, on return: those which have to be probed
+    // again are replaced by a placeholder until they are.
+    auto inputs = probeMedias( medias );
+    auto probes = m_settings->value( "probes" )->get().toMap();
+    for ( int i = 0; i < medias.size(); ++i )
+    {
+        auto path = medias[i].toString();
+        Media* media;
+        if ( inputs[i] != nullptr )
+            media = addMedia( QFileInfo( path ), std::move( inputs[i] ) );
+        else if ( m_probing.count( path ) != 0 )
+        {
+            // As long as it was, if it changed since
+            auto length = probes.value( path ).toMap()["properties"].toMap()["length"].toLongLong();
+            media = Media::createPlaceholder( path, length > 0 ? length : PlaceholderLength );
+            registerMedia( media );
+        }
+        else
+            media = createMediaFromVariant( medias[i] );
+        if ( media != nullptr )
+            setupMedia( media );
+    }
 
     for ( const auto& var : m_settings->value( "clips" )->get().toList() )
         createClipFromVariant( var, nullptr );
+
+    // The clips of the database get loaded when displayed, or used by the timeline
+    openStore();
+}
+
+void
+Library::setupMedia( Media* media )
+{
+    auto path = media->fileInfo()->absoluteFilePath();
+    media->setHardwareDecoding( m_settings->value( "hardwareDecoding" )->get().toMap().value( path ).toString() );
+    media->setDecodeThreads( m_settings->value( "decodeThreads" )->get().toMap().value( path ).toInt() );
+    if ( m_settings->value( "growing" )->get().toList().contains( path ) == true )
+        setGrowing( media, true );
+    auto conform = m_settings->value( "frameRateConform" )->get().toMap().value( path );
+    if ( conform.isValid() == true )
+        media->setFrameRateConform( (FrameRateConformService::Mode)conform.toInt() );
+    auto measure = m_settings->value( "loudness" )->get().toMap().value( path ).toMap();
+    if ( isUnchanged( measure, path ) == true )
+    {
+        Tools::Loudness l;
+        l.integrated = measure["integrated"].toDouble();
+        l.maxShortTerm = measure["maxShortTerm"].toDouble();
+        l.truePeak = measure["truePeak"].toDouble();
+        media->setLoudness( l );
+    }
+    requestProxy( media );
+    requestAudioConform( media );
+    requestFrameRateConform( media );
+    requestFrameIndex( media );
+    requestLoudness( media );
+    requestDecodeBenchmark( media );
+}
+
+std::vector<std::unique_ptr<Backend::IInput>>
+Library::probeMedias( const QVariantList& medias )
+{
+    std::vector<std::unique_ptr<Backend::IInput>>   inputs( medias.size() );
+    auto probes = m_settings->value( "probes" )->get().toMap();
+    auto proxies = Backend::instance()->proxies();
+    QAtomicInt      nbDone;
+    // The project is being opened, and waits for those
+    Tools::JobScheduler::CancellationToken  probing;
+    int nbProbed = 0;
+    for ( int i = 0; i < medias.size(); ++i )
+    {
+        auto path = medias[i].toString();
+        // Missing files are reported when adding them
+        if ( QFile::exists( path ) == false )
+            continue;
+        // Reuse the last probe when the file didn't change
+        Backend::MLT::MLTInput::Properties  probed;
+        if ( proxies.count( path.toStdString() ) == 0 )
+            probed = lastProbe( probes.value( path ).toMap(), path );
+        if ( probed.empty() == true )
+        {
+            auto& input = m_probing[path];
+            m_scheduler->schedule( Tools::JobScheduler::Visible,
+                                   MediaProbe( path, probed, input, nullptr, this ), m_probes );
+            continue;
+        }
+        m_scheduler->schedule( Tools::JobScheduler::Interactive,
+                               MediaProbe( path, probed, inputs[i], &nbDone ), probing );
+        ++nbProbed;
+    }
+    auto lastDone = -1;
+    while ( m_scheduler->wait( probing, 100 ) == false )
+    {
+        auto done = nbDone.load();
+        if ( done != lastDone )
+            emit loadingProgress( done, nbProbed );
+        lastDone = done;
+    }
+    emit loadingProgress( nbProbed, nbProbed );
+    return inputs;
+}
+
+Media*
+Library::addMedia( const QFileInfo& fileInfo, std::unique_ptr<Backend::IInput> input )
+{
+    auto media = new Media( fileInfo.filePath(), std::move( input ) );
+    registerMedia( media );
+    return media;
+}
+
+void
+Library::registerMedia( Media* media )
+{
+    setCleanState( false );
+    connect( media, SIGNAL( metaDataComputed( const Media* ) ),
+             this, SLOT( mediaLoaded( const Media* ) ), Qt::QueuedConnection );
+    m_medias[media->fileInfo()->absoluteFilePath()] = media;
 }
 
 Library::~Library()
 {
+    // The jobs still running write to m_probing
+    m_scheduler->cancel( m_probes );
+    m_scheduler->wait( m_probes );
+    m_scheduler->cancel( m_growthProbes );
+    m_scheduler->wait( m_growthProbes );
     delete m_settings;
 }
 
@@ -111,12 +725,7 @@ Library::addMedia( const QFileInfo &fileInfo )
 {
     Media* media = MediaContainer::addMedia( fileInfo );
     if ( media != nullptr )
-    {
-        setCleanState( false );
-        connect( media, SIGNAL( metaDataComputed( const Media* ) ),
-                 this, SLOT( mediaLoaded( const Media* ) ), Qt::QueuedConnection );
-        m_medias[fileInfo.absoluteFilePath()] = media;
-    }
+        registerMedia( media );
     return media;
 }
 
@@ -126,10 +735,572 @@ Library::addClip( Clip *clip )
     bool    ret = MediaContainer::addClip( clip );
     if ( ret != false )
         setCleanState( false );
-    m_medias[clip->media()->fileInfo()->absoluteFilePath()] = clip->media();
+    auto path = clip->media()->fileInfo()->absoluteFilePath();
+    if ( m_medias.contains( path ) == false )
+    {
+        requestProxy( clip->media() );
+        requestAudioConform( clip->media() );
+        requestFrameIndex( clip->media() );
+        requestLoudness( clip->media() );
+        requestSceneDetection( clip->media() );
+        requestDecodeBenchmark( clip->media() );
+    }
+    m_medias[path] = clip->media();
     return ret;
 }
 
+QList<Clip*>
+Library::importMedias( const QStringList& paths )
+{
+    QList<Clip*>    clips;
+    std::vector<std::unique_ptr<Backend::IInput>>   inputs( paths.size() );
+    Tools::JobScheduler::CancellationToken  probing;
+    for ( int i = 0; i < paths.size(); ++i )
+    {
+        auto path = QFileInfo( paths[i] ).absoluteFilePath();
+        auto it = m_medias.find( path );
+        clips << ( it != m_medias.end() ? ( *it )->baseClip() : nullptr );
+        if ( it == m_medias.end() && QFile::exists( path ) == true )
+            m_scheduler->schedule( Tools::JobScheduler::Interactive,
+                                   MediaProbe( path, {}, inputs[i], nullptr ), probing );
+    }
+    m_scheduler->wait( probing );
+    for ( int i = 0; i < paths.size(); ++i )
+    {
+        if ( inputs[i] == nullptr )
+            continue;
+        auto path = QFileInfo( paths[i] ).absoluteFilePath();
+        // Listed twice
+        if ( m_medias.contains( path ) == true )
+        {
+            clips[i] = m_medias[path]->baseClip();
+            continue;
+        }
+        auto media = addMedia( QFileInfo( path ), std::move( inputs[i] ) );
+        setupMedia( media );
+        requestSceneDetection( media );
+        auto clip = new Clip( media );
+        media->setBaseClip( clip );
+        addClip( clip );
+        clips[i] = clip;
+    }
+    return clips;
+}
+
+QString
+Library::documentPath( const QString& subDirectory, const char* extension )
+{
+    auto dir = VLMC_GET_STRING( "vlmc/WorkspaceLocation" );
+    if ( dir.isEmpty() == true )
+    {
+        vlmcWarning() << "Titles and multicam clips are stored in the workspace, which isn't set";
+        return QString();
+    }
+    dir += '/' + subDirectory;
+    if ( QDir().mkpath( dir ) == false )
+    {
+        vlmcCritical() << "Can't create" << dir;
+        return QString();
+    }
+    return dir + '/' + QUuid::createUuid().toString().mid( 1, 36 ) + extension;
+}
+
+Media*
+Library::addDocument( const QString& path )
+{
+    auto media = addMedia( QFileInfo( path ) );
+    if ( media == nullptr )
+        return nullptr;
+    auto clip = new Clip( media );
+    media->setBaseClip( clip );
+    addClip( clip );
+    return media;
+}
+
+bool
+Library::reopenDocument( Media* media )
+{
+    auto path = media->fileInfo()->absoluteFilePath();
+    // The producers only read their file once, a new one is needed
+    try
+    {
+        media->setFilePath( path );
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcCritical() << "Can't open" << path;
+        return false;
+    }
+    reloadClips( media );
+    emit mediaOnline( media );
+    return true;
+}
+
+Media*
+Library::addTitle( const Tools::Title& title )
+{
+    auto path = documentPath( "titles", Tools::Title::Extension );
+    if ( path.isEmpty() == true )
+        return nullptr;
+    if ( title.save( path ) == false )
+    {
+        vlmcCritical() << "Can't write the title" << path;
+        return nullptr;
+    }
+    return addDocument( path );
+}
+
+bool
+Library::setTitle( Media* media, const Tools::Title& title )
+{
+    if ( media->fileType() != Media::Title )
+        return false;
+    auto path = media->fileInfo()->absoluteFilePath();
+    Tools::Title current;
+    if ( Tools::Title::load( path, current ) == true && current == title )
+        return true;
+    if ( title.save( path ) == false )
+    {
+        vlmcCritical() << "Can't write the title" << path;
+        return false;
+    }
+    return reopenDocument( media );
+}
+
+Media*
+Library::addMulticam( const QList<Media*>& angles, const QList<qint64>& offsets )
+{
+    if ( angles.isEmpty() == true || angles.size() != offsets.size() )
+        return nullptr;
+    Tools::Multicam multicam;
+    // The multicam clip starts with its first angle
+    auto first = *std::min_element( offsets.begin(), offsets.end() );
+    for ( int i = 0; i < angles.size(); ++i )
+    {
+        auto offset = offsets[i] - first;
+        multicam.angles.append( Tools::Multicam::Angle{ angles[i]->fileInfo()->absoluteFilePath(), offset } );
+        multicam.nbFrames = std::max( multicam.nbFrames, offset + angles[i]->nbFrames() );
+    }
+    auto path = documentPath( "multicam", Tools::Multicam::Extension );
+    if ( path.isEmpty() == true )
+        return nullptr;
+    if ( multicam.save( path ) == false )
+    {
+        vlmcCritical() << "Can't write the multicam clip" << path;
+        return nullptr;
+    }
+    return addDocument( path );
+}
+
+Media*
+Library::addNestedSequence( const Tools::NestedSequence& sequence )
+{
+    auto path = documentPath( "sequences", Tools::NestedSequence::Extension );
+    if ( path.isEmpty() == true )
+        return nullptr;
+    if ( sequence.save( path ) == false )
+    {
+        vlmcCritical() << "Can't write the sequence" << path;
+        return nullptr;
+    }
+    return addDocument( path );
+}
+
+bool
+Library::switchAngle( Media* media, qint64 position, int angle )
+{
+    if ( media->fileType() != Media::Multicam )
+        return false;
+    auto path = media->fileInfo()->absoluteFilePath();
+    Tools::Multicam multicam;
+    if ( Tools::Multicam::load( path, multicam ) == false )
+        return false;
+    if ( multicam.activeAngle( position ) == angle )
+        return true;
+    multicam.switchAngle( position, angle );
+    if ( multicam.save( path ) == false )
+    {
+        vlmcCritical() << "Can't write the multicam clip" << path;
+        return false;
+    }
+    return reopenDocument( media );
+}
+
+void
+Library::requestProxy( Media* media )
+{
+    // Their flattened render, which the preview decodes instead of compositing their tracks
+    if ( media->fileType() == Media::NestedSequence )
+    {
+        optimizeMedia( media );
+        return;
+    }
+    if ( VLMC_GET_BOOL( "vlmc/GenerateProxies" ) == false )
+        return;
+    auto suffix = "*." + media->fileInfo()->suffix().toLower();
+    if ( Media::VideoExtensions.split( ' ' ).contains( suffix ) == true )
+        Core::instance()->proxyService()->request( media->fileInfo()->absoluteFilePath() );
+}
+
+void
+Library::requestAudioConform( Media* media )
+{
+    const auto& info = media->info();
+    if ( info.sampleRate <= 0 || info.nbChannels <= 0 )
+        return;
+    // This library's project, which may not be the active one anymore once the media is probed
+    auto sampleRate = m_projectSettings->value( "audio/AudioSampleRate" )->get().toUInt();
+    auto nbChannels = m_projectSettings->value( "audio/NbChannels" )->get().toUInt();
+    if ( (quint32)info.sampleRate == sampleRate && (quint32)info.nbChannels == nbChannels )
+        return;
+    Core::instance()->audioConformService()->request( media->fileInfo()->absoluteFilePath(),
+                                                      sampleRate, nbChannels );
+}
+
+void
+Library::requestFrameRateConform( Media* media )
+{
+    if ( media->fileType() != Media::Video || media->isPlaceholder() == true )
+        return;
+    auto fps = m_projectSettings->value( "video/VLMCOutputFPS" )->get().toDouble();
+    auto mode = media->frameRateConform();
+    // Nothing to convert when it has the project's frame rate already
+    if ( media->info().fps <= 0 || qFuzzyCompare( media->info().fps, fps ) == true )
+        mode = FrameRateConformService::Nearest;
+    Core::instance()->frameRateConformService()->request( media->fileInfo()->absoluteFilePath(),
+                                                          fps, mode );
+}
+
+void
+Library::requestFrameIndex( Media* media )
+{
+    if ( media->fileType() != Media::Video )
+        return;
+    auto path = media->fileInfo()->absoluteFilePath();
+    // The index of a partial file isn't worth saving
+    if ( media->isGrowing() == true )
+        Core::instance()->frameIndexService()->refresh( path );
+    else
+        Core::instance()->frameIndexService()->request( path );
+}
+
+void
+Library::requestLoudness( Media* media )
+{
+    if ( media->loudness().isValid() == true || media->info().nbChannels <= 0 )
+        return;
+    // Measured along with the peaks, on the waveform service threads
+    auto peaks = Core::instance()->waveformService()->peaks( media->fileInfo()->absoluteFilePath() );
+    if ( peaks != nullptr )
+        media->setLoudness( peaks->loudness() );
+}
+
+void
+Library::requestSceneDetection( Media* media )
+{
+    if ( VLMC_GET_BOOL( "vlmc/DetectScenes" ) == false )
+        return;
+    if ( media->fileType() != Media::Video || media->isPlaceholder() == true )
+        return;
+    Core::instance()->sceneDetectionService()->request( media->fileInfo()->absoluteFilePath(),
+                                                        media->nbFrames() );
+}
+
+void
+Library::requestDecodeBenchmark( Media* media )
+{
+    if ( media->fileType() != Media::Video || media->isPlaceholder() == true )
+        return;
+    Core::instance()->decodeBenchmarkService()->request( media->fileInfo()->absoluteFilePath(),
+                                                         media->nbFrames() );
+}
+
+void
+Library::peaksReady( const QString& filePath )
+{
+    auto media = m_medias.value( filePath );
+    if ( media == nullptr || media->loudness().isValid() == true )
+        return;
+    auto peaks = Core::instance()->waveformService()->peaks( filePath );
+    // Saved along with the next change, a measurement alone doesn't make the project dirty
+    if ( peaks != nullptr )
+        media->setLoudness( peaks->loudness() );
+}
+
+const ClipSearchIndex&
+Library::searchIndex() const
+{
+    return m_searchIndex;
+}
+
+void
+Library::clipIndexed( Clip* clip )
+{
+    m_searchIndex.add( clip );
+    connect( clip, &Clip::annotationsChanged, this, &Library::annotationsChanged, Qt::UniqueConnection );
+}
+
+void
+Library::clipUnindexed( Clip* clip )
+{
+    m_searchIndex.remove( clip->uuid() );
+    disconnect( clip, &Clip::annotationsChanged, this, &Library::annotationsChanged );
+}
+
+void
+Library::annotationsChanged( Clip* clip )
+{
+    m_searchIndex.add( clip );
+}
+
+void
+Library::mediaProbed( const QString& filePath )
+{
+    auto it = m_probing.find( filePath );
+    if ( it == m_probing.end() )
+        return;
+    auto input = std::move( it->second );
+    m_probing.erase( it );
+    auto media = m_medias.value( filePath );
+    if ( media == nullptr || media->isPlaceholder() == false )
+        return;
+    if ( input == nullptr )
+    {
+        vlmcWarning() << "Can't open" << filePath << "its clips are left as placeholders";
+        return;
+    }
+    media->setInput( std::move( input ) );
+    reloadClips( media );
+    // Those need the properties of the file
+    requestAudioConform( media );
+    requestFrameRateConform( media );
+    requestLoudness( media );
+    emit mediaOnline( media );
+}
+
+void
+Library::setGrowing( Media* media, bool growing )
+{
+    if ( media->isGrowing() == growing )
+        return;
+    media->setGrowing( growing );
+    setCleanState( false );
+    auto path = media->fileInfo()->absoluteFilePath();
+    m_growthSizes.remove( path );
+    if ( growing == true )
+    {
+        m_growthSizes.insert( path, QFileInfo( path ).size() );
+        m_growthTimer->start();
+        return;
+    }
+    for ( auto m : m_medias )
+    {
+        if ( m->isGrowing() == true )
+            return;
+    }
+    m_growthTimer->stop();
+}
+
+void
+Library::checkGrowingMedias()
+{
+    for ( auto media : m_medias )
+    {
+        if ( media->isGrowing() == false || media->isPlaceholder() == true )
+            continue;
+        auto path = media->fileInfo()->absoluteFilePath();
+        // Only the files which got written to since are probed again
+        auto size = QFileInfo( path ).size();
+        auto it = m_growthSizes.find( path );
+        if ( ( it != m_growthSizes.end() && it.value() == size ) || m_growthProbing.contains( path ) == true )
+            continue;
+        m_growthSizes[path] = size;
+        m_growthProbing.insert( path );
+        // Visible, as the editor waits for those even while the preview plays
+        m_scheduler->schedule( Tools::JobScheduler::Visible,
+                               [this, path]( const Tools::JobScheduler::CancellationToken& )
+        {
+            qint64 length = 0;
+            try
+            {
+                length = Backend::instance()->probe( path.toStdString() ).length;
+            }
+            catch ( Backend::InvalidServiceException& )
+            {
+                // The file may be in between two writes, it's tried again on the next check
+            }
+            QMetaObject::invokeMethod( this, "growthProbed", Qt::QueuedConnection,
+                                       Q_ARG( QString, path ), Q_ARG( qint64, length ) );
+        }, m_growthProbes );
+    }
+}
+
+void
+Library::growthProbed( const QString& filePath, qint64 length )
+{
+    m_growthProbing.remove( filePath );
+    auto media = m_medias.value( filePath );
+    if ( media == nullptr || media->isGrowing() == false )
+        return;
+    auto oldLength = media->input()->length();
+    if ( media->grow( length ) == false )
+        return;
+    for ( auto c : m_clips )
+    {
+        if ( c->media() == media )
+            extendClips( c, oldLength );
+    }
+    requestFrameIndex( media );
+    emit mediaGrown( media, oldLength );
+}
+
+void
+Library::waitForMedias()
+{
+    m_scheduler->wait( m_probes );
+    // Their notifications are still queued, and will find nothing left to do
+    while ( m_probing.empty() == false )
+        mediaProbed( m_probing.begin()->first );
+}
+
+void
+Library::audioConformed( const QString& filePath )
+{
+    auto media = m_medias.value( filePath );
+    if ( media != nullptr )
+        media->resetAudioInput();
+}
+
+void
+Library::frameRateConformed( const QString& filePath )
+{
+    auto media = m_medias.value( filePath );
+    if ( media == nullptr || media->isPlaceholder() == true )
+        return;
+    auto conformed = Core::instance()->frameRateConformService()->conformedPath( filePath );
+    if ( media->conformedVideo() == conformed || media->setConformedVideo( conformed ) == false )
+        return;
+    reloadClips( media );
+    emit mediaOnline( media );
+}
+
+void
+Library::decodeSpeedMeasured( const QString& filePath )
+{
+    auto media = m_medias.value( filePath );
+    if ( media != nullptr )
+        media->setDecodeSpeed( Core::instance()->decodeBenchmarkService()->speed( filePath ) );
+}
+
+void
+Library::optimizeMedia( const Media* media )
+{
+    if ( ( media->fileType() != Media::Video && media->fileType() != Media::NestedSequence ) ||
+         media->isPlaceholder() == true )
+        return;
+    Core::instance()->proxyService()->request( media->fileInfo()->absoluteFilePath(),
+                                               ProxyService::Optimized );
+}
+
+void
+Library::mediaOptimized( const QString& filePath )
+{
+    auto media = m_medias.value( filePath );
+    // A conformed video is decoded instead, which is intra-frame already
+    if ( media == nullptr || media->isPlaceholder() == true ||
+         media->conformedVideo().isEmpty() == false )
+        return;
+    reopenDocument( media );
+}
+
+void
+Library::setFrameRateConform( Media* media, FrameRateConformService::Mode mode )
+{
+    if ( media->frameRateConform() == mode )
+        return;
+    media->setFrameRateConform( mode );
+    setCleanState( false );
+    requestFrameRateConform( media );
+}
+
+void
+Library::conformFrameRates()
+{
+    for ( auto media : m_medias )
+        requestFrameRateConform( media );
+}
+
+void
+Library::rescale( double ratio )
+{
+    for ( auto media : m_medias )
+    {
+        media->rescale( ratio );
+        auto base = media->baseClip();
+        if ( base == nullptr )
+            continue;
+        auto last = media->input()->length() - 1;
+        auto map = [ratio, last]( qint64 frame ) { return qMin( last, qRound64( frame * ratio ) ); };
+        // From the frame after it, so that it still ends with the media
+        base->setBoundaries( map( base->begin() ), qMin( last, qRound64( ( base->end() + 1 ) * ratio ) - 1 ) );
+        remapSubclips( base, map );
+    }
+    setCleanState( false );
+}
+
+void
+Library::scenesDetected( const QString& filePath )
+{
+    auto media = m_medias.value( filePath );
+    if ( media == nullptr || media->isPlaceholder() == true )
+        return;
+    auto base = media->baseClip();
+    // Left alone once the user split it
+    if ( base->mediaContainer()->count() > 0 )
+        return;
+    auto cuts = Core::instance()->sceneDetectionService()->cuts( filePath );
+    if ( cuts.isEmpty() == true )
+        return;
+    cuts.append( base->length() );
+    qint64 begin = 0;
+    for ( auto cut : cuts )
+    {
+        if ( cut <= begin || cut > base->length() )
+            continue;
+        auto shot = new Clip( base, begin, cut - 1 );
+        if ( base->addSubclip( shot ) == false )
+            delete shot;
+        begin = cut;
+    }
+    setCleanState( false );
+}
+
+void
+Library::relinkMedia( Media* media, const QString& filePath, const std::function<qint64( qint64 )>& map )
+{
+    // While they are still cut from the current input
+    if ( media->baseClip() != nullptr )
+        remapSubclips( media->baseClip(), map );
+    m_medias.remove( media->fileInfo()->absoluteFilePath() );
+    media->setFilePath( filePath );
+    m_medias[media->fileInfo()->absoluteFilePath()] = media;
+    setCleanState( false );
+    reloadClips( media );
+    emit mediaOnline( media );
+}
+
+void
+Library::reloadClips( Media* media )
+{
+    for ( auto c : m_clips )
+    {
+        if ( c->media() != media )
+            continue;
+        c->reloadInput();
+        reloadSubclips( c );
+    }
+}
+
 bool
 Library::isInCleanState() const
 {
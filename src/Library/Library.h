@@ -30,14 +30,41 @@
 #ifndef LIBRARY_H
 #define LIBRARY_H
 
+#include "ClipSearchIndex.h"
+#include "LibraryStore.h"
 #include "MediaContainer.h"
+#include "Tools/JobScheduler.h"
+#include "Workflow/FrameRateConformService.h"
+#include <QHash>
+#include <QMap>
 #include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVariant>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace Backend
+{
+class IInput;
+}
+
+namespace Tools
+{
+struct Multicam;
+struct NestedSequence;
+struct Title;
+}
 
 class Clip;
 class Media;
 class ProjectManager;
 class Workspace;
 class Settings;
+class QTimer;
 
 /**
  *  \class Library
@@ -49,15 +76,213 @@ class Library : public MediaContainer
     Q_DISABLE_COPY( Library )
 
 public:
-    Library( Settings* projectSettings );
+    Library( Settings* projectSettings, Tools::JobScheduler* scheduler );
     virtual ~Library();
     virtual void    addMedia( Media* media );
     virtual Media   *addMedia( const QFileInfo &fileInfo );
     virtual bool    addClip( Clip *clip );
+    /**
+     *  \brief Writes a title file in the workspace, and imports it as a new media.
+     *  \returns nullptr without a workspace, or if the file can't be written.
+     */
+    Media*          addTitle( const Tools::Title& title );
+    /**
+     *  \brief Changes the text or style of a title media, and draws its clips again.
+     */
+    bool            setTitle( Media* media, const Tools::Title& title );
+    /**
+     *  \brief Writes a multicam file in the workspace, of the angles starting at offsets
+     *         in the multicam clip, and imports it as a new media.
+     *
+     *  The offsets can be found with MainWorkflow::syncClips(), which lines the audio of
+     *  the angles up.
+     *  \returns nullptr without a workspace, or if the file can't be written.
+     */
+    Media*          addMulticam( const QList<Media*>& angles, const QList<qint64>& offsets );
+    /**
+     *  \brief Writes a sequence file in the workspace, and imports it as a new media.
+     *  \returns nullptr without a workspace, or if the file can't be written.
+     *  \sa MainWorkflow::nestClips()
+     */
+    Media*          addNestedSequence( const Tools::NestedSequence& sequence );
+    /**
+     *  \brief Imports the medias of paths at once, opening them in parallel.
+     *
+     *  The medias already in the library are reused.
+     *  \returns The base clips of the medias, in the order of paths, null for the files
+     *          which couldn't be opened.
+     */
+    QList<Clip*>    importMedias( const QStringList& paths );
+    /**
+     *  \brief Shows angle from position in the multicam media, and plays its clips again.
+     */
+    bool            switchAngle( Media* media, qint64 position, int angle );
+    /**
+     *  \brief Also looks the clip up in the library database, creating it along with
+     *         its media when it wasn't loaded yet.
+     */
+    Clip*           clip( const QUuid& uuid );
+    Clip*           clip( const QString& uuid );
+    virtual bool    canFetchMore() const override;
+    virtual void    fetchMore( int count ) override;
+    virtual void    deleteClip( const QUuid& uuid ) override;
+    virtual void    clear() override;
     bool            isInCleanState() const;
+    /**
+     *  \brief Rewrites the paths of the medias starting with one of the keys, when the
+     *         next project gets loaded. The longest matching prefix is replaced.
+     *
+     *  Lets a project saved on one machine be opened where its medias are mounted
+     *  elsewhere, such as on render nodes.
+     */
+    void            setPathMappings( const QMap<QString, QString>& mappings );
+    /**
+     *  \brief Makes the audio clips of filePath use its conformed audio, from now on.
+     *  \sa    AudioConformService
+     */
+    void            audioConformed( const QString& filePath );
+    /**
+     *  \brief Swaps the conformed video of filePath in, or its own file back, and cuts
+     *         its clips again. \sa FrameRateConformService
+     */
+    void            frameRateConformed( const QString& filePath );
+    /**
+     *  \brief Keeps the decoding speed of filePath on its media.
+     *  \sa    DecodeBenchmarkService
+     */
+    void            decodeSpeedMeasured( const QString& filePath );
+    /**
+     *  \brief Transcodes a video media or a nested sequence to a full resolution,
+     *         intra-frame file in the background, from which it's previewed once done.
+     *         \sa mediaOptimized()
+     */
+    void            optimizeMedia( const Media* media );
+    /**
+     *  \brief Opens the optimized media of filePath, and cuts its clips again.
+     *  \sa    ProxyService::Optimized
+     */
+    void            mediaOptimized( const QString& filePath );
+    /**
+     *  \brief Sets how a media gets conformed to the project frame rate, and queues
+     *         its conform.
+     */
+    void            setFrameRateConform( Media* media, FrameRateConformService::Mode mode );
+    /**
+     *  \brief Queues the conform of every media again, once the project frame rate
+     *         changed.
+     */
+    void            conformFrameRates();
+    /**
+     *  \brief Scales the lengths of the medias and the boundaries of their clips by
+     *         ratio, once the project frame rate changed. \sa Media::rescale()
+     */
+    void            rescale( double ratio );
+    /**
+     *  \brief Splits the base clip of filePath in subclips at its shot changes, unless
+     *         it has subclips already. \sa SceneDetectionService
+     */
+    void            scenesDetected( const QString& filePath );
+    /**
+     *  \brief Points media to filePath, a file holding parts of it, and cuts its clips
+     *         again. The subclips get the boundaries map returns for their current ones.
+     *
+     *  mediaOnline() is emitted, for the timeline clips to be cut again too: they have to
+     *  be remapped first. \sa SequenceWorkflow::remapMedia()
+     */
+    void            relinkMedia( Media* media, const QString& filePath,
+                                 const std::function<qint64( qint64 )>& map );
+    /**
+     *  \brief Keeps the loudness measured along with the peaks of filePath.
+     *  \sa    WaveformService
+     */
+    void            peaksReady( const QString& filePath );
+    /**
+     *  \brief The index of the library clips and subclips, kept up to date with their
+     *         tags and notes.
+     */
+    const ClipSearchIndex&  searchIndex() const;
+    /**
+     *  \brief Waits for the medias which are still being opened, and brings their
+     *         clips online. Needed before rendering, which would use the placeholders.
+     */
+    void            waitForMedias();
+    /**
+     *  \brief Marks a media as being recorded. Its file is checked every GrowthInterval
+     *         ms, and the media extended when it got longer. \sa mediaGrown()
+     */
+    void            setGrowing( Media* media, bool growing );
+
+    static const int    GrowthInterval = 2000;
+
+protected:
+    virtual void    clipIndexed( Clip* clip ) override;
+    virtual void    clipUnindexed( Clip* clip ) override;
 
 private:
     void            setCleanState( bool newState );
+    /**
+     *  \brief Queue a proxy for a video media, when proxies are enabled, and the flattened
+     *         render of a nested sequence.
+     */
+    void            requestProxy( Media* media );
+    /**
+     *  \brief Queue a conform of the audio of a media which isn't in the project format.
+     */
+    void            requestAudioConform( Media* media );
+    /**
+     *  \brief Queue a conform of a video media which doesn't have the project frame
+     *         rate, unless it's left to the backend.
+     */
+    void            requestFrameRateConform( Media* media );
+    // Cuts the library clips of media and their subclips again, from its new input
+    void            reloadClips( Media* media );
+    // The path of a new title or multicam file of the workspace, or an empty string
+    QString         documentPath( const QString& subDirectory, const char* extension );
+    // Imports a new title or multicam file, with its base clip
+    Media*          addDocument( const QString& path );
+    // Opens the file of a media again, once it changed or got optimized
+    bool            reopenDocument( Media* media );
+    /**
+     *  \brief Queue the frame index of a video media. \sa Tools::FrameIndex
+     */
+    void            requestFrameIndex( Media* media );
+    /**
+     *  \brief Queue the loudness measurement of a media with audio, unless it's known.
+     */
+    void            requestLoudness( Media* media );
+    /**
+     *  \brief Queue the scene detection of a new video media, when it's enabled.
+     */
+    void            requestSceneDetection( Media* media );
+    /**
+     *  \brief Queue the measure of the decoding speed of a video media.
+     */
+    void            requestDecodeBenchmark( Media* media );
+    /**
+     *  \brief Opens the inputs of the medias as interactive jobs, and waits for them.
+     *
+     *  The inputs are in the same order as the medias, null if the file is missing or
+     *  couldn't be opened. The medias without a probe to reuse aren't waited for: they
+     *  are opened in the background, and listed in m_probing meanwhile.
+     */
+    std::vector<std::unique_ptr<Backend::IInput>>   probeMedias( const QVariantList& medias );
+    Media*          addMedia( const QFileInfo& fileInfo, std::unique_ptr<Backend::IInput> input );
+    void            registerMedia( Media* media );
+    // Restores what the project knows of a media, and queues its background jobs
+    void            setupMedia( Media* media );
+    /**
+     *  \brief Opens the database of the project's library, or creates one for a project
+     *         which doesn't have one, when vlmc/LibraryDatabase is set.
+     */
+    void            openStore();
+    // Creates the clip of a database entry, and its media. Doesn't alter the clean state.
+    Clip*           materialize( const LibraryStore::Entry& entry );
+    bool            saveStore( const QVariantMap& probes );
+    QString         mapPath( const QString& path ) const;
+    // Applies the mappings to the project settings, before anything uses them
+    void            remapPaths();
+    // Probes the growing medias which files changed since the last check
+    void            checkGrowingMedias();
 
 private:
     QAtomicInt  m_nbMediaToLoad;
@@ -65,11 +290,41 @@ private:
     Workspace*  m_workspace;
 
     Settings*   m_settings;
+    // The settings of the project this library belongs to
+    Settings*   m_projectSettings;
+    QMap<QString, QString>  m_pathMappings;
+    ClipSearchIndex         m_searchIndex;
+    // Null unless the project's clips are kept in a database
+    std::unique_ptr<LibraryStore>   m_store;
+    int                     m_storeCount;
+    // The number of entries already read by fetchMore()
+    int                     m_storeOffset;
+    // Deleted clips, to be removed from the database on the next save
+    QList<QUuid>            m_storeRemovals;
+    /**
+     *  The inputs of the medias opened in the background, set from the probing threads.
+     *  The map is only altered from the main thread, which only reads an input once
+     *  mediaProbed() was called for it.
+     */
+    std::map<QString, std::unique_ptr<Backend::IInput>>   m_probing;
+    Tools::JobScheduler*    m_scheduler;
+    // The jobs opening the medias in the background
+    Tools::JobScheduler::CancellationToken  m_probes;
+    // The size of the growing files when last checked, and those being probed
+    QTimer*                 m_growthTimer;
+    QHash<QString, qint64>  m_growthSizes;
+    QSet<QString>           m_growthProbing;
+    Tools::JobScheduler::CancellationToken  m_growthProbes;
     void        preSave();
     void        postLoad();
 
 private slots:
     void    mediaLoaded( const Media* m );
+    // Replaces the placeholder of filePath, once its input got opened in the background
+    void    mediaProbed( const QString& filePath );
+    // length is what the file measures now, in frames, or 0 if it couldn't be probed
+    void    growthProbed( const QString& filePath, qint64 length );
+    void    annotationsChanged( Clip* clip );
 
 signals:
     /**
@@ -77,6 +332,18 @@ signals:
      */
     void    projectLoaded();
     void    cleanStateChanged( bool newState );
+    // Emitted while the medias of a project are being opened
+    void    loadingProgress( int done, int total );
+    /**
+     *  \brief Emitted once the placeholder of a media was replaced by its file. The
+     *         library clips were cut again, the timeline's have to be.
+     */
+    void    mediaOnline( Media* media );
+    /**
+     *  \brief Emitted once a growing media got longer. The library clips which ended
+     *         with it were extended, the timeline's have to be.
+     */
+    void    mediaGrown( Media* media, qint64 oldLength );
 };
 
 #endif // LIBRARY_H
@@ -0,0 +1,223 @@
+/*****************************************************************************
+ * LibraryStore.cpp: Database of the medias and clips of a library
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "LibraryStore.h"
+#include "Tools/VlmcDebug.h"
+
+#ifdef HAVE_QTSQL
+# include <QSqlDatabase>
+# include <QSqlError>
+# include <QSqlQuery>
+#endif
+
+#include <QDir>
+#include <QFileInfo>
+
+#ifdef HAVE_QTSQL
+namespace
+{
+    const char* const   Schema[] = {
+        "CREATE TABLE IF NOT EXISTS clips ( id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "uuid TEXT UNIQUE NOT NULL, path TEXT NOT NULL, clip BLOB NOT NULL, probe BLOB )",
+        "CREATE TABLE IF NOT EXISTS subclips ( uuid TEXT PRIMARY KEY, root TEXT NOT NULL )",
+        "CREATE INDEX IF NOT EXISTS subclipsRoot ON subclips( root )",
+    };
+
+    LibraryStore::Entry
+    entry( const QSqlQuery& query )
+    {
+        return LibraryStore::Entry{ QUuid( query.value( 0 ).toString() ), query.value( 1 ).toString(),
+                                    query.value( 2 ).toByteArray(), query.value( 3 ).toByteArray(), {} };
+    }
+}
+#endif
+
+LibraryStore::LibraryStore()
+    : m_connection( "LibraryStore-" + QUuid::createUuid().toString() )
+{
+}
+
+LibraryStore::~LibraryStore()
+{
+#ifdef HAVE_QTSQL
+    if ( QSqlDatabase::contains( m_connection ) == false )
+        return;
+    QSqlDatabase::database( m_connection, false ).close();
+    QSqlDatabase::removeDatabase( m_connection );
+#endif
+}
+
+bool
+LibraryStore::open( const QString& path )
+{
+#ifdef HAVE_QTSQL
+    QDir().mkpath( QFileInfo( path ).absolutePath() );
+    auto db = QSqlDatabase::addDatabase( QStringLiteral( "QSQLITE" ), m_connection );
+    db.setDatabaseName( path );
+    if ( db.open() == false )
+    {
+        vlmcWarning() << "Can't open the library database" << path << ':' << db.lastError().text();
+        return false;
+    }
+    QSqlQuery   query( db );
+    // A crash while saving leaves the previous content
+    query.exec( QStringLiteral( "PRAGMA journal_mode=WAL" ) );
+    for ( auto statement : Schema )
+    {
+        if ( query.exec( QString::fromLatin1( statement ) ) == false )
+        {
+            vlmcWarning() << "Can't create the library database" << path << ':' << query.lastError().text();
+            db.close();
+            return false;
+        }
+    }
+    return true;
+#else
+    vlmcWarning() << "Can't open the library database" << path << ": built without Qt5Sql";
+    return false;
+#endif
+}
+
+int
+LibraryStore::count() const
+{
+#ifdef HAVE_QTSQL
+    QSqlQuery   query( QSqlDatabase::database( m_connection, false ) );
+    if ( query.exec( QStringLiteral( "SELECT COUNT(*) FROM clips" ) ) == false || query.next() == false )
+        return 0;
+    return query.value( 0 ).toInt();
+#else
+    return 0;
+#endif
+}
+
+QList<LibraryStore::Entry>
+LibraryStore::page( int offset, int count ) const
+{
+    QList<Entry>    entries;
+#ifdef HAVE_QTSQL
+    QSqlQuery   query( QSqlDatabase::database( m_connection, false ) );
+    query.prepare( QStringLiteral( "SELECT uuid, path, clip, probe FROM clips ORDER BY id LIMIT ? OFFSET ?" ) );
+    query.addBindValue( count );
+    query.addBindValue( offset );
+    if ( query.exec() == false )
+        return entries;
+    while ( query.next() == true )
+        entries << entry( query );
+#else
+    Q_UNUSED( offset );
+    Q_UNUSED( count );
+#endif
+    return entries;
+}
+
+bool
+LibraryStore::find( const QUuid& uuid, Entry& result ) const
+{
+#ifdef HAVE_QTSQL
+    auto db = QSqlDatabase::database( m_connection, false );
+    auto root = uuid.toString();
+    QSqlQuery   subclip( db );
+    subclip.prepare( QStringLiteral( "SELECT root FROM subclips WHERE uuid = ?" ) );
+    subclip.addBindValue( root );
+    if ( subclip.exec() == true && subclip.next() == true )
+        root = subclip.value( 0 ).toString();
+
+    QSqlQuery   query( db );
+    query.prepare( QStringLiteral( "SELECT uuid, path, clip, probe FROM clips WHERE uuid = ?" ) );
+    query.addBindValue( root );
+    if ( query.exec() == false || query.next() == false )
+        return false;
+    result = entry( query );
+    return true;
+#else
+    Q_UNUSED( uuid );
+    Q_UNUSED( result );
+    return false;
+#endif
+}
+
+bool
+LibraryStore::save( const QList<Entry>& entries, const QList<QUuid>& removed )
+{
+#ifdef HAVE_QTSQL
+    auto db = QSqlDatabase::database( m_connection, false );
+    if ( db.transaction() == false )
+        return false;
+    QSqlQuery   update( db );
+    QSqlQuery   insert( db );
+    QSqlQuery   removeSubclips( db );
+    QSqlQuery   insertSubclip( db );
+    QSqlQuery   remove( db );
+    update.prepare( QStringLiteral( "UPDATE clips SET path = ?, clip = ?, probe = ? WHERE uuid = ?" ) );
+    insert.prepare( QStringLiteral( "INSERT INTO clips ( path, clip, probe, uuid ) VALUES ( ?, ?, ?, ? )" ) );
+    removeSubclips.prepare( QStringLiteral( "DELETE FROM subclips WHERE root = ?" ) );
+    insertSubclip.prepare( QStringLiteral( "INSERT OR REPLACE INTO subclips ( uuid, root ) VALUES ( ?, ? )" ) );
+    remove.prepare( QStringLiteral( "DELETE FROM clips WHERE uuid = ?" ) );
+
+    auto ok = true;
+    for ( const auto& e : entries )
+    {
+        auto uuid = e.uuid.toString();
+        // Updated in place, so that the rows keep their order
+        for ( auto query : { &update, &insert } )
+        {
+            query->addBindValue( e.path );
+            query->addBindValue( e.clip );
+            query->addBindValue( e.probe );
+            query->addBindValue( uuid );
+            ok = ok && query->exec();
+            if ( query == &update && query->numRowsAffected() > 0 )
+                break;
+        }
+        removeSubclips.addBindValue( uuid );
+        ok = ok && removeSubclips.exec();
+        for ( const auto& sub : e.subclips )
+        {
+            insertSubclip.addBindValue( sub.toString() );
+            insertSubclip.addBindValue( uuid );
+            ok = ok && insertSubclip.exec();
+        }
+    }
+    for ( const auto& uuid : removed )
+    {
+        removeSubclips.addBindValue( uuid.toString() );
+        remove.addBindValue( uuid.toString() );
+        ok = ok && removeSubclips.exec() && remove.exec();
+    }
+    if ( ok == false )
+    {
+        vlmcWarning() << "Can't save the library database:" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+    return db.commit();
+#else
+    Q_UNUSED( entries );
+    Q_UNUSED( removed );
+    return false;
+#endif
+}
@@ -0,0 +1,76 @@
+/*****************************************************************************
+ * LibraryStore.h: Database of the medias and clips of a library
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBRARYSTORE_H
+#define LIBRARYSTORE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QUuid>
+
+/**
+ *  \brief  Keeps the root clips of a library in an SQLite database, for libraries
+ *          too large to be saved in, and loaded from, the project file.
+ *
+ *  Each row holds a root clip with its subclips, and the path and last probe of its
+ *  media, the way Library saves them in the project otherwise. The rows are read a
+ *  page at a time, or by the uuid of the clip or of one of its subclips, so that the
+ *  library only creates the medias it needs.
+ *  Without Qt5Sql, open() always fails.
+ */
+class LibraryStore
+{
+    public:
+        struct Entry
+        {
+            // The uuid of the root clip
+            QUuid           uuid;
+            QString         path;
+            // Clip::toVariantFull(), as JSON
+            QByteArray      clip;
+            // The probe, as Library keeps it in the project, as JSON
+            QByteArray      probe;
+            QList<QUuid>    subclips;
+        };
+
+        LibraryStore();
+        ~LibraryStore();
+
+        bool            open( const QString& path );
+        int             count() const;
+        // The entries in the order they were first saved
+        QList<Entry>    page( int offset, int count ) const;
+        // uuid may be the one of a subclip
+        bool            find( const QUuid& uuid, Entry& entry ) const;
+        /**
+         *  \brief  Replaces the given entries, and removes the removed ones, in a single
+         *          transaction. The other rows are kept as they are.
+         */
+        bool            save( const QList<Entry>& entries, const QList<QUuid>& removed );
+
+    private:
+        // The connection name, unique to this store
+        QString         m_connection;
+};
+
+#endif // LIBRARYSTORE_H
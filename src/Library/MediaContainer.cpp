@@ -24,6 +24,8 @@
 # include "config.h"
 #endif
 
+#include <QCryptographicHash>
+#include <QFile>
 #include <QHash>
 #include <QUuid>
 
@@ -33,10 +35,15 @@
 #include "Media/Media.h"
 #include "EffectsEngine/EffectHelper.h"
 #include "Settings/Settings.h"
+#include "Tools/Metrics.h"
 #include "Tools/VlmcDebug.h"
 #include "Project/Workspace.h"
 
-MediaContainer::MediaContainer( Clip* parent /*= nullptr*/ ) : m_parent( parent )
+#include <algorithm>
+
+MediaContainer::MediaContainer( Clip* parent /*= nullptr*/ )
+    : m_parent( parent )
+    , m_owner( nullptr )
 {
 }
 
@@ -50,29 +57,30 @@ MediaContainer::~MediaContainer()
 Clip*
 MediaContainer::clip( const QUuid& uuid )
 {
-    return clip( uuid.toString() );
+    return m_uuids.value( uuid, nullptr );
 }
 
 Clip*
 MediaContainer::clip( const QString &uuid )
 {
-    for ( const auto& clip : m_clips )
-        if ( clip->uuid().toString() == uuid )
-            return clip;
-        else
-        {
-            auto c = clip->mediaContainer()->clip( uuid );
-            if ( c != nullptr )
-                return c;
-        }
-    return nullptr;
+    return clip( QUuid( uuid ) );
 }
 
 void
 MediaContainer::addMedia( Media *media )
 {
-    m_clips[media->baseClip()->uuid()] = media->baseClip();
-    emit newClipLoaded( media->baseClip() );
+    static auto& timing = Tools::Metrics::histogram( "library.addMedia" );
+    Tools::Metrics::ScopedTimer timer( timing );
+    auto clip = media->baseClip();
+    if ( m_clips.contains( clip->uuid() ) == true )
+    {
+        unindex( m_clips[clip->uuid()] );
+        unindexUuids( m_clips[clip->uuid()] );
+    }
+    m_clips[clip->uuid()] = clip;
+    index( clip );
+    indexUuids( clip );
+    emit newClipLoaded( clip );
 }
 
 Media*
@@ -83,13 +91,10 @@ MediaContainer::addMedia( const QFileInfo& fileInfo )
         vlmcCritical() << "Can't add" << fileInfo.absoluteFilePath() << ": File not found";
         return nullptr;
     }
-    foreach( Clip* it, m_clips.values() )
+    if ( mediaAlreadyLoaded( fileInfo ) == true )
     {
-        if ( (*it->media()->fileInfo()) == fileInfo )
-        {
-            vlmcWarning() << "Ignoring aleady imported media" << fileInfo.absolutePath();
-            return nullptr;
-        }
+        vlmcWarning() << "Ignoring aleady imported media" << fileInfo.absoluteFilePath();
+        return nullptr;
     }
     Media* media = new Media( fileInfo.filePath() );
     return media;
@@ -98,10 +103,23 @@ MediaContainer::addMedia( const QFileInfo& fileInfo )
 bool
 MediaContainer::mediaAlreadyLoaded( const QFileInfo& fileInfo )
 {
-    foreach( Clip* clip, m_clips.values() )
+    if ( m_paths.contains( canonicalPath( fileInfo ) ) == true )
+        return true;
+
+    auto candidates = m_sizes.values( fileInfo.size() );
+    if ( candidates.isEmpty() == true )
+        return false;
+    auto print = fingerprint( fileInfo.absoluteFilePath() );
+    if ( print.isEmpty() == true )
+        return false;
+    for ( auto c : candidates )
     {
-        if ( clip->media()->fileInfo()->filePath() == fileInfo.filePath() )
+        if ( fingerprint( c ) == print )
+        {
+            vlmcDebug() << fileInfo.absoluteFilePath() << "is a copy of"
+                        << c->media()->fileInfo()->absoluteFilePath();
             return true;
+        }
     }
     return false;
 }
@@ -109,21 +127,135 @@ MediaContainer::mediaAlreadyLoaded( const QFileInfo& fileInfo )
 bool
 MediaContainer::addClip( Clip* clip )
 {
-    foreach ( Clip* c, m_clips.values() )
+    bool    duplicate = m_clips.contains( clip->uuid() );
+    if ( duplicate == false )
     {
-        if ( clip->uuid() == c->uuid() ||
-             ( clip->media()->fileInfo() == c->media()->fileInfo() &&
-                    ( clip->begin() == c->begin() && clip->end() == c->end() ) ) )
+        for ( auto c : m_paths.values( canonicalPath( *clip->media()->fileInfo() ) ) )
         {
-            vlmcWarning() << "Clip already loaded.";
-            return false;
+            if ( clip->media() == c->media() &&
+                 clip->begin() == c->begin() && clip->end() == c->end() )
+            {
+                duplicate = true;
+                break;
+            }
         }
     }
+    if ( duplicate == true )
+    {
+        vlmcWarning() << "Clip already loaded.";
+        return false;
+    }
     m_clips[clip->uuid()] = clip;
+    index( clip );
+    indexUuids( clip );
     emit newClipLoaded( clip );
     return true;
 }
 
+QString
+MediaContainer::canonicalPath( const QFileInfo& fileInfo )
+{
+    // Empty for a file which doesn't exist (anymore)
+    auto path = fileInfo.canonicalFilePath();
+    if ( path.isEmpty() == true )
+        return fileInfo.absoluteFilePath();
+    return path;
+}
+
+QByteArray
+MediaContainer::fingerprint( const QString& path )
+{
+    static const qint64 BlockSize = 64 * 1024;
+
+    QFile   file( path );
+    if ( file.open( QIODevice::ReadOnly ) == false )
+        return QByteArray();
+    auto size = file.size();
+    QCryptographicHash  hash( QCryptographicHash::Md5 );
+    hash.addData( reinterpret_cast<const char*>( &size ), sizeof( size ) );
+    for ( auto offset : { qint64( 0 ), ( size - BlockSize ) / 2, size - BlockSize } )
+    {
+        if ( file.seek( std::max( qint64( 0 ), offset ) ) == false )
+            return QByteArray();
+        hash.addData( file.read( BlockSize ) );
+    }
+    return hash.result();
+}
+
+const QByteArray&
+MediaContainer::fingerprint( Clip* clip )
+{
+    auto it = m_fingerprints.find( clip );
+    if ( it == m_fingerprints.end() )
+        it = m_fingerprints.insert( clip, fingerprint( clip->media()->fileInfo()->absoluteFilePath() ) );
+    return it.value();
+}
+
+void
+MediaContainer::index( Clip* clip )
+{
+    auto fileInfo = clip->media()->fileInfo();
+    m_paths.insert( canonicalPath( *fileInfo ), clip );
+    // A subclip's content is its parent's
+    if ( clip->isRootClip() == true )
+        m_sizes.insert( fileInfo->size(), clip );
+}
+
+void
+MediaContainer::unindex( Clip* clip )
+{
+    auto fileInfo = clip->media()->fileInfo();
+    m_paths.remove( canonicalPath( *fileInfo ), clip );
+    m_sizes.remove( fileInfo->size(), clip );
+    m_fingerprints.remove( clip );
+}
+
+void
+MediaContainer::indexUuids( Clip* clip )
+{
+    auto childs = clip->mediaContainer();
+    childs->m_owner = this;
+    auto root = this;
+    for ( auto c = this; c != nullptr; c = c->m_owner )
+    {
+        c->m_uuids.insert( clip->uuid(), clip );
+        for ( auto it = childs->m_uuids.cbegin(); it != childs->m_uuids.cend(); ++it )
+            c->m_uuids.insert( it.key(), it.value() );
+        root = c;
+    }
+    root->clipIndexed( clip );
+    for ( auto sub : childs->m_uuids )
+        root->clipIndexed( sub );
+}
+
+void
+MediaContainer::unindexUuids( Clip* clip )
+{
+    auto childs = clip->mediaContainer();
+    auto root = this;
+    for ( auto c = this; c != nullptr; c = c->m_owner )
+    {
+        c->m_uuids.remove( clip->uuid() );
+        for ( auto it = childs->m_uuids.cbegin(); it != childs->m_uuids.cend(); ++it )
+            c->m_uuids.remove( it.key() );
+        root = c;
+    }
+    root->clipUnindexed( clip );
+    for ( auto sub : childs->m_uuids )
+        root->clipUnindexed( sub );
+    childs->m_owner = nullptr;
+}
+
+void
+MediaContainer::clipIndexed( Clip* )
+{
+}
+
+void
+MediaContainer::clipUnindexed( Clip* )
+{
+}
+
 void
 MediaContainer::clear()
 {
@@ -133,11 +265,15 @@ MediaContainer::clear()
     while ( it != end )
     {
         emit clipRemoved( it.key() );
+        unindexUuids( it.value() );
         it.value()->clear();
         it.value()->deleteLater();
         ++it;
     }
     m_clips.clear();
+    m_paths.clear();
+    m_sizes.clear();
+    m_fingerprints.clear();
 }
 
 void
@@ -149,9 +285,13 @@ MediaContainer::removeAll()
     while ( it != end )
     {
         emit clipRemoved( it.key() );
+        unindexUuids( it.value() );
         ++it;
     }
     m_clips.clear();
+    m_paths.clear();
+    m_sizes.clear();
+    m_fingerprints.clear();
 }
 
 void
@@ -161,6 +301,8 @@ MediaContainer::deleteClip( const QUuid &uuid )
     if ( it != m_clips.end() )
     {
         Clip* clip = it.value();
+        unindex( clip );
+        unindexUuids( clip );
         m_clips.remove( uuid );
         emit clipRemoved( uuid );
         // don't use delete as the clip may be used in the slot that'll handle clipRemoved signal.
@@ -193,6 +335,17 @@ MediaContainer::count() const
     return m_clips.size();
 }
 
+bool
+MediaContainer::canFetchMore() const
+{
+    return false;
+}
+
+void
+MediaContainer::fetchMore( int )
+{
+}
+
 Media*
 MediaContainer::createMediaFromVariant( const QVariant& var )
 {
@@ -23,7 +23,9 @@
 #ifndef MEDIACONTAINER_H
 #define MEDIACONTAINER_H
 
+#include <QByteArray>
 #include <QHash>
+#include <QMultiHash>
 #include <QObject>
 #include <QUuid>
 
@@ -40,6 +42,8 @@ public:
     ~MediaContainer();
     /**
      *  \brief  returns the clip that match the unique identifier
+     *
+     *  The subclips are looked up as well, at any depth, in a single hash lookup.
      *  \param  uuid    the unique identifier of the media
      *  \return a pointer to the required clip, or nullptr if no clips matches
      */
@@ -47,9 +51,7 @@ public:
 
     /**
      *  \brief  returns the clip that match the unique identifier
-     *
-     *  The identifier may be a full id (ie the full path, starting at the root clip)
-     *  \param  uuid    the unique identifier of the media
+     *  \param  uuid    the unique identifier of the media, as a string
      *  \return a pointer to the required clip, or nullptr if no clips matches
      */
     Clip*   clip( const QString& uuid );
@@ -77,6 +79,9 @@ public:
     virtual Media       *addMedia( const QFileInfo& fileInfo );
     /**
      *  \brief  Check if a file has already been loaded into library.
+     *
+     *  The file is looked up by its canonical path, so links to a loaded file are
+     *  found as well. Copies of a loaded file are found by their content.
      *  \param  fileInfo    The file infos
      *  \return true if the file is already loaded, false otherwhise
      */
@@ -105,6 +110,13 @@ public:
     Clip*       getParent();
 
     quint32     count() const;
+    /**
+     *  \brief  Whether more clips can be loaded, when they are kept outside of the
+     *          container. \sa fetchMore()
+     */
+    virtual bool    canFetchMore() const;
+    // Loads up to count more clips, each announced through newClipLoaded
+    virtual void    fetchMore( int count );
 
 protected:
     /**
@@ -121,21 +133,50 @@ protected:
 
     Clip*                   m_parent;
 
+    /**
+     *  \brief  Called on the outermost container when a clip gets in one of the
+     *          containers it holds, at any depth, or when it gets out of it.
+     */
+    virtual void    clipIndexed( Clip* clip );
+    virtual void    clipUnindexed( Clip* clip );
+
     Media*          createMediaFromVariant( const QVariant& var );
     Clip*           createClipFromVariant( const QVariant& var, Clip* parent );
 
+private:
+    static QString          canonicalPath( const QFileInfo& fileInfo );
+    // Size and hash of a few blocks, enough to tell two medias apart
+    static QByteArray       fingerprint( const QString& path );
+    const QByteArray&       fingerprint( Clip* clip );
+    void                    index( Clip* clip );
+    void                    unindex( Clip* clip );
+    // Adds the clip and its subclips to the uuid index of this container and its owners
+    void                    indexUuids( Clip* clip );
+    void                    unindexUuids( Clip* clip );
+
+private:
+    // Canonical path -> clips of that file
+    QMultiHash<QString, Clip*>  m_paths;
+    // File size -> clips. Fingerprints are only computed on a size collision
+    QMultiHash<qint64, Clip*>   m_sizes;
+    QHash<Clip*, QByteArray>    m_fingerprints;
+    // Every clip of the container and of the containers of its subclips
+    QHash<QUuid, Clip*>         m_uuids;
+    // The container holding m_parent, if it was added to one
+    MediaContainer*             m_owner;
+
 public slots:
     /**
      *  \brief  Removes a Clip from the container and delete it
      *
      *  \param  uuid    The clip to remove's uuid.
      */
-    void    deleteClip( const QUuid& uuid );
+    virtual void    deleteClip( const QUuid& uuid );
     /**
      *  \brief  Clear the library (remove all the loaded Clip, delete their subclips, and
      *          delete them)
      */
-    void    clear();
+    virtual void    clear();
     /**
      *  \brief      Remove all the medias from the container, but doesn't clean nor
      *              delete them.
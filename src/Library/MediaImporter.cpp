@@ -0,0 +1,278 @@
+/*****************************************************************************
+ * MediaImporter.cpp: Scans and probes the medias to import in the background
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "MediaImporter.h"
+#include "Backend/IInput.h"
+#include "Backend/MLT/MLTService.h"
+#include "Main/Core.h"
+#include "Media/Media.h"
+#include "Settings/Settings.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QMap>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QThread>
+
+#include <iterator>
+
+namespace
+{
+
+class Job : public QRunnable
+{
+public:
+    explicit Job( std::function<void()> job )
+        : m_job( std::move( job ) )
+    {
+    }
+
+    virtual void run() override
+    {
+        m_job();
+    }
+
+private:
+    std::function<void()>   m_job;
+};
+
+}
+
+MediaImporter::MediaImporter( QObject* parent )
+    : QObject( parent )
+    , m_readyNotified( false )
+    , m_generation( 0 )
+    , m_nbJobs( 0 )
+    , m_nbFound( 0 )
+    , m_nbDone( 0 )
+{
+    // One directory walk at a time, waiting on the probes' slots without starving them
+    m_scanner.setMaxThreadCount( 1 );
+    // Opening a file is mostly waiting for it to be read
+    auto nbProbes = qMax( 2, QThread::idealThreadCount() * 2 );
+    m_pool.setMaxThreadCount( nbProbes );
+    m_slots.release( nbProbes * 2 );
+}
+
+MediaImporter::~MediaImporter()
+{
+    cancel();
+    m_scanner.waitForDone();
+    m_pool.waitForDone();
+}
+
+void
+MediaImporter::import( const QString& path, const QStringList& nameFilters )
+{
+    int generation = m_generation;
+    bool sequences = VLMC_GET_BOOL( "vlmc/ImportImageSequences" );
+    start( m_scanner, [this, path, nameFilters, sequences, generation]
+    {
+        scan( path, nameFilters, sequences, generation );
+    } );
+}
+
+void
+MediaImporter::cancel()
+{
+    // The queued jobs still run, to give their slot back, but do nothing
+    ++m_generation;
+    m_nbFound = 0;
+    m_nbDone = 0;
+    QMutexLocker    lock( &m_mutex );
+    m_ready.clear();
+    m_readyNotified = false;
+}
+
+std::vector<MediaImporter::Result>
+MediaImporter::takeReady()
+{
+    QMutexLocker    lock( &m_mutex );
+    std::vector<Result> ready;
+    ready.swap( m_ready );
+    m_readyNotified = false;
+    return ready;
+}
+
+void
+MediaImporter::scan( const QString& path, const QStringList& nameFilters, bool sequences,
+                     int generation )
+{
+    auto enqueue = [this, generation]( const QString& file )
+    {
+        // Blocks while the probes are falling behind
+        m_slots.acquire();
+        emit progress( m_nbDone, ++m_nbFound );
+        start( m_pool, [this, file, generation]
+        {
+            probe( file, generation );
+        } );
+    };
+
+    if ( QFileInfo( path ).isDir() == false )
+    {
+        enqueue( path );
+        return;
+    }
+    // Streamed, the files get probed while the rest of the tree is walked. The images
+    // are held back until the walk is done, to be grouped by directory.
+    QHash<QString, QStringList>     images;
+    QDirIterator    it( path, nameFilters, QDir::Files | QDir::Readable | QDir::NoDotAndDotDot,
+                        QDirIterator::Subdirectories );
+    while ( it.hasNext() == true && generation == m_generation )
+    {
+        auto file = it.next();
+        if ( sequences == true && QDir::match( Media::ImageExtensions, file ) == true )
+            images[it.fileInfo().path()] << file;
+        else
+            enqueue( file );
+    }
+    for ( const auto& dir : images )
+    {
+        for ( const auto& file : groupSequences( dir ) )
+        {
+            if ( generation != m_generation )
+                return;
+            enqueue( file );
+        }
+    }
+}
+
+QStringList
+MediaImporter::groupSequences( const QStringList& images )
+{
+    // The last number of the file name
+    static const QRegularExpression     numbered( "^(.*?)(\\d+)(\\.[^.]+)$" );
+    QStringList     res;
+    QList<QRegularExpressionMatch>  matches;
+    // The digits count of the zero padded numbers, by prefix and extension
+    QHash<QString, int>     padding;
+    for ( const auto& image : images )
+    {
+        auto match = numbered.match( image );
+        if ( match.hasMatch() == false )
+        {
+            res << image;
+            continue;
+        }
+        auto digits = match.captured( 2 );
+        if ( digits.size() > 1 && digits.startsWith( '0' ) == true )
+            padding[match.captured( 1 ) + '/' + match.captured( 3 )] = digits.size();
+        matches << match;
+    }
+    // By pattern, sorted by number
+    QHash<QString, QMap<qint64, QString>>  patterns;
+    for ( const auto& match : matches )
+    {
+        auto digits = match.captured( 2 );
+        auto pattern = match.captured( 1 );
+        pattern.replace( '%', "%%" );
+        // 0999 and 1000 belong to the same padded sequence, 9 and 10 to the same unpadded one
+        auto width = padding.value( match.captured( 1 ) + '/' + match.captured( 3 ), 0 );
+        if ( width > 0 && digits.size() == width )
+            pattern += "%0" + QString::number( width ) + 'd';
+        else
+            pattern += "%d";
+        pattern += match.captured( 3 );
+        patterns[pattern].insert( digits.toLongLong(), match.captured( 0 ) );
+    }
+    for ( auto it = patterns.cbegin(); it != patterns.cend(); ++it )
+    {
+        const auto& files = it.value();
+        auto first = files.cbegin();
+        while ( first != files.cend() )
+        {
+            auto last = first;
+            int length = 1;
+            for ( auto next = std::next( last ); next != files.cend() && next.key() == last.key() + 1; ++next )
+            {
+                last = next;
+                ++length;
+            }
+            if ( length >= MinSequenceLength )
+                res << it.key() + "?begin=" + QString::number( first.key() );
+            else
+            {
+                for ( auto i = first; i != std::next( last ); ++i )
+                    res << i.value();
+            }
+            first = std::next( last );
+        }
+    }
+    return res;
+}
+
+void
+MediaImporter::probe( const QString& path, int generation )
+{
+    std::unique_ptr<Backend::IInput>    input;
+    if ( generation == m_generation )
+    {
+        try
+        {
+            input = Media::openInput( path );
+        }
+        catch ( Backend::InvalidServiceException& )
+        {
+            vlmcWarning() << "Failed to open" << path;
+        }
+    }
+    m_slots.release();
+
+    bool    notify = false;
+    {
+        QMutexLocker    lock( &m_mutex );
+        if ( generation != m_generation )
+            return;
+        m_ready.push_back( Result{ path, std::move( input ) } );
+        notify = m_readyNotified == false;
+        m_readyNotified = true;
+    }
+    emit progress( ++m_nbDone, m_nbFound );
+    // The receiver collects everything ready so far at once
+    if ( notify == true )
+        emit ready();
+}
+
+void
+MediaImporter::start( QThreadPool& pool, std::function<void()> job )
+{
+    ++m_nbJobs;
+    pool.start( new Job( [this, job]
+    {
+        job();
+        if ( --m_nbJobs == 0 )
+        {
+            m_nbFound = 0;
+            m_nbDone = 0;
+            emit finished();
+        }
+    } ) );
+}
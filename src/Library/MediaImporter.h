@@ -0,0 +1,116 @@
+/*****************************************************************************
+ * MediaImporter.h: Scans and probes the medias to import in the background
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MEDIAIMPORTER_H
+#define MEDIAIMPORTER_H
+
+#include <QMutex>
+#include <QObject>
+#include <QSemaphore>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Backend
+{
+class IInput;
+}
+
+/**
+ *  \brief  Background import pipeline.
+ *
+ *  Directories are walked on a thread of their own, and the files found are probed
+ *  on a pool, a bounded number at a time. The opened inputs are handed back in
+ *  batches: ready() is emitted once per batch, which takeReady() then collects.
+ *  The Media themselves are left to the receiver to create, in its own thread.
+ */
+class MediaImporter : public QObject
+{
+    Q_OBJECT
+
+    public:
+        struct Result
+        {
+            QString                             path;
+            // nullptr if the file couldn't be opened
+            std::unique_ptr<Backend::IInput>    input;
+        };
+
+        explicit MediaImporter( QObject* parent = nullptr );
+        ~MediaImporter();
+
+        /**
+         *  \brief  Queues a file, or every file matching nameFilters below a directory.
+         *
+         *  Unless disabled in the settings, the runs of numbered images found in a
+         *  directory are imported as image sequences.
+         */
+        void                    import( const QString& path, const QStringList& nameFilters );
+        /**
+         *  \brief  Stops the running imports. Nothing queued so far gets delivered.
+         */
+        void                    cancel();
+        std::vector<Result>     takeReady();
+
+    private:
+        void                    scan( const QString& path, const QStringList& nameFilters,
+                                      bool sequences, int generation );
+        /**
+         *  \brief  Groups the numbered images of a directory.
+         *
+         *  Returns the paths to import: a "name%04d.png?begin=N" pattern for each run
+         *  of at least MinSequenceLength images, the image itself otherwise.
+         */
+        static QStringList      groupSequences( const QStringList& images );
+        void                    probe( const QString& path, int generation );
+        // Runs job on pool, finished() is emitted once no job is left
+        void                    start( QThreadPool& pool, std::function<void()> job );
+
+    private:
+        static const int        MinSequenceLength = 3;
+
+        QThreadPool             m_scanner;
+        QThreadPool             m_pool;
+        // Bounds the probes queued ahead of the pool
+        QSemaphore              m_slots;
+        QMutex                  m_mutex;
+        std::vector<Result>     m_ready;
+        bool                    m_readyNotified;
+        // Bumped on cancel, the jobs of a previous generation bail out
+        std::atomic<int>        m_generation;
+        std::atomic<int>        m_nbJobs;
+        std::atomic<int>        m_nbFound;
+        std::atomic<int>        m_nbDone;
+
+    signals:
+        // Emitted from the pool threads
+        void                    ready();
+        void                    progress( int done, int found );
+        void                    finished();
+};
+
+#endif // MEDIAIMPORTER_H
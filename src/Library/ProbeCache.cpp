@@ -0,0 +1,75 @@
+/*****************************************************************************
+ * ProbeCache.cpp: Media probes shared by the projects of the process
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ProbeCache.h"
+#include "Tools/Metrics.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+
+ProbeCache::ProbeCache()
+    : m_clock( 0 )
+{
+}
+
+bool
+ProbeCache::find( const QString& path, Backend::MediaInfo& info )
+{
+    QFileInfo       file( path );
+    QMutexLocker    lock( &m_mutex );
+    auto it = m_entries.find( path );
+    if ( it == m_entries.end() || it->size != file.size() ||
+         it->modified != file.lastModified().toMSecsSinceEpoch() )
+    {
+        Tools::Metrics::counter( "probeCache.misses" ).add();
+        return false;
+    }
+    it->lastUse = ++m_clock;
+    info = it->info;
+    Tools::Metrics::counter( "probeCache.hits" ).add();
+    return true;
+}
+
+void
+ProbeCache::insert( const QString& path, const Backend::MediaInfo& info )
+{
+    QFileInfo       file( path );
+    if ( file.exists() == false )
+        return;
+    QMutexLocker    lock( &m_mutex );
+    m_entries.insert( path, Entry{ info, file.size(), file.lastModified().toMSecsSinceEpoch(), ++m_clock } );
+    if ( m_entries.size() > MaxEntries )
+        evict();
+}
+
+void
+ProbeCache::evict()
+{
+    // Only once full, and there's no point in keeping the order up to date until then
+    auto oldest = m_entries.begin();
+    for ( auto it = m_entries.begin(); it != m_entries.end(); ++it )
+    {
+        if ( it->lastUse < oldest->lastUse )
+            oldest = it;
+    }
+    m_entries.erase( oldest );
+}
@@ -0,0 +1,69 @@
+/*****************************************************************************
+ * ProbeCache.h: Media probes shared by the projects of the process
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef PROBECACHE_H
+#define PROBECACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include "Backend/IBackend.h"
+
+/**
+ *  \brief  Remembers what probing the medias told about them, for as long as the
+ *          process runs, so that a file is only probed once whichever projects use it.
+ *
+ *  Entries are keyed by file path, and only served while the file keeps the size and
+ *  modification date it had when it was probed. The least recently used ones are
+ *  dropped past MaxEntries. The medias are probed from the job threads, all the
+ *  methods are thread safe.
+ */
+class ProbeCache
+{
+    public:
+        static const int        MaxEntries = 4096;
+
+        ProbeCache();
+
+        // Returns false if path wasn't probed, or changed since
+        bool                    find( const QString& path, Backend::MediaInfo& info );
+        void                    insert( const QString& path, const Backend::MediaInfo& info );
+
+    private:
+        struct Entry
+        {
+            Backend::MediaInfo  info;
+            qint64              size;
+            qint64              modified;
+            quint64             lastUse;
+        };
+
+        void                    evict();
+
+    private:
+        QMutex                  m_mutex;
+        QHash<QString, Entry>   m_entries;
+        quint64                 m_clock;
+};
+
+#endif // PROBECACHE_H
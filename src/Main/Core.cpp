@@ -30,15 +30,63 @@
 #include <QDir>
 #include <QtGlobal>
 #include <QStandardPaths>
+#include <QTimer>
 
 
 #include <Backend/IBackend.h>
+#include "Commands/AbstractUndoStack.h"
 #include "Library/Library.h"
+#include "Library/ProbeCache.h"
 #include "Project/RecentProjects.h"
+#include "Renderer/AbstractRenderer.h"
 #include "Project/Workspace.h"
 #include <Settings/Settings.h>
+#include "Tools/JobScheduler.h"
+#include "Tools/MediaIO.h"
+#include "Tools/RendererEventWatcher.h"
+#include "Tools/StallWatchdog.h"
+#include "Tools/ThreadRole.h"
 #include <Tools/VlmcLogger.h>
+#include "Workflow/EncoderProbe.h"
 #include "Workflow/MainWorkflow.h"
+#include "Workflow/PreviewCache.h"
+#include "Workflow/AudioConformService.h"
+#include "Workflow/DecodeBenchmarkService.h"
+#include "Workflow/FrameIndexService.h"
+#include "Workflow/FrameRateConformService.h"
+#include "Workflow/ProxyService.h"
+#include "Workflow/RenderQueue.h"
+#include "Workflow/SceneDetectionService.h"
+#include "Workflow/StabilizationService.h"
+#include "Workflow/ThumbnailService.h"
+#include "Workflow/WaveformService.h"
+
+namespace
+{
+    // The settings of the thread roles, in Tools::ThreadRole::Role order
+    struct ThreadRoleSettings
+    {
+        const char* key;
+        const char* priorityName;
+        const char* coresName;
+    };
+    const ThreadRoleSettings    threadRoleSettings[] = {
+        { "Gui", QT_TRANSLATE_NOOP( "Settings", "Interface thread priority" ),
+          QT_TRANSLATE_NOOP( "Settings", "Interface thread cores" ) },
+        { "Audio", QT_TRANSLATE_NOOP( "Settings", "Audio rendering priority" ),
+          QT_TRANSLATE_NOOP( "Settings", "Audio rendering cores" ) },
+        { "Preview", QT_TRANSLATE_NOOP( "Settings", "Preview rendering priority" ),
+          QT_TRANSLATE_NOOP( "Settings", "Preview rendering cores" ) },
+        { "Export", QT_TRANSLATE_NOOP( "Settings", "Export rendering priority" ),
+          QT_TRANSLATE_NOOP( "Settings", "Export rendering cores" ) },
+        { "Jobs", QT_TRANSLATE_NOOP( "Settings", "Jobs priority" ),
+          QT_TRANSLATE_NOOP( "Settings", "Jobs cores" ) },
+        { "Background", QT_TRANSLATE_NOOP( "Settings", "Background jobs priority" ),
+          QT_TRANSLATE_NOOP( "Settings", "Background jobs cores" ) },
+    };
+    static_assert( sizeof( threadRoleSettings ) / sizeof( threadRoleSettings[0] ) == Tools::ThreadRole::NbRoles,
+                   "Every thread role needs its settings" );
+}
 
 Core::Core()
 {
@@ -46,29 +94,248 @@ Core::Core()
     m_logger = new VlmcLogger;
 
     createSettings();
-    m_currentProject = new Project( m_settings );
-    m_library = new Library( m_currentProject->settings() );
+    VlmcLogger::startupPhase( "Core: settings" );
+    // Before the scheduler starts its threads
+    for ( int i = 0; i < Tools::ThreadRole::NbRoles; ++i )
+    {
+        auto role = static_cast<Tools::ThreadRole::Role>( i );
+        auto key = QString( "vlmc/" ) + threadRoleSettings[i].key;
+        auto priority = m_settings->value( key + "ThreadPriority" );
+        auto cores = m_settings->value( key + "ThreadCores" );
+        auto update = [role, priority, cores]
+        {
+            Tools::ThreadRole::setPolicy( role, static_cast<Tools::ThreadRole::Priority>( priority->get().toInt() ),
+                                          Tools::ThreadRole::parseCores( cores->get().toString() ) );
+            // The settings are changed from the GUI thread
+            if ( role == Tools::ThreadRole::Gui )
+                Tools::ThreadRole::apply( role );
+        };
+        QObject::connect( priority, &SettingValue::changed, update );
+        QObject::connect( cores, &SettingValue::changed, update );
+        update();
+    }
+    m_jobScheduler = new Tools::JobScheduler;
+
+    // The backtraces of the freezes make them actionable from the logs
+    m_stallWatchdog = new Tools::StallWatchdog;
+    auto stallThreshold = m_settings->value( "vlmc/StallThreshold" );
+    QObject::connect( stallThreshold, &SettingValue::changed, [this]( const QVariant& threshold )
+    {
+        m_stallWatchdog->setThreshold( threshold.toInt() );
+    } );
+    m_stallWatchdog->setThreshold( stallThreshold->get().toInt() );
+
+    m_probeCache = new ProbeCache;
     m_recentProjects = new RecentProjects( m_settings );
-    m_workspace = new Workspace( m_settings );
-    m_workflow = new MainWorkflow( m_currentProject->settings() );
+    m_workspace = new Workspace( m_settings, m_jobScheduler );
+    m_thumbnailService = new ThumbnailService( m_jobScheduler );
+    m_waveformService = new WaveformService;
+    m_proxyService = new ProxyService;
+    m_audioConformService = new AudioConformService;
+    m_frameIndexService = new FrameIndexService;
+    m_frameRateConformService = new FrameRateConformService;
+    m_stabilizationService = new StabilizationService( m_jobScheduler );
+    m_sceneDetectionService = new SceneDetectionService( m_jobScheduler );
+    m_decodeBenchmarkService = new DecodeBenchmarkService( m_jobScheduler );
+    VlmcLogger::startupPhase( "Core: services" );
+
+    auto workspaceLocation = m_settings->value( "vlmc/WorkspaceLocation" );
+    auto sharedCacheLocation = m_settings->value( "vlmc/SharedCacheLocation" );
+    // The files derived from the medias live in the shared cache when there's one, so
+    // that the workstations of a team only compute them once. The preview renders
+    // depend on the project, and stay in the workspace.
+    auto setCacheDirectory = [this, workspaceLocation, sharedCacheLocation]()
+    {
+        auto dir = sharedCacheLocation->get().toString();
+        if ( dir.isEmpty() == true )
+            dir = workspaceLocation->get().toString();
+        m_thumbnailService->store().setDirectory( dir );
+        m_waveformService->setDirectory( dir );
+        m_proxyService->setDirectory( dir );
+        m_audioConformService->setDirectory( dir );
+        m_frameIndexService->setDirectory( dir );
+        m_frameRateConformService->setDirectory( dir );
+        m_stabilizationService->setDirectory( dir );
+        m_sceneDetectionService->setDirectory( dir );
+    };
+    QObject::connect( workspaceLocation, &SettingValue::changed, m_thumbnailService,
+                      [setCacheDirectory]() { setCacheDirectory(); } );
+    QObject::connect( sharedCacheLocation, &SettingValue::changed, m_thumbnailService,
+                      [setCacheDirectory]() { setCacheDirectory(); } );
+    setCacheDirectory();
+    auto proxyWorkers = m_settings->value( "vlmc/ProxyWorkers" );
+    QObject::connect( proxyWorkers, &SettingValue::changed, m_proxyService, [this]( const QVariant& maxJobs )
+    {
+        m_proxyService->setMaxJobs( maxJobs.toUInt() );
+    } );
+    m_proxyService->setMaxJobs( proxyWorkers->get().toUInt() );
+
+    auto readAhead = m_settings->value( "vlmc/ReadAhead" );
+    QObject::connect( readAhead, &SettingValue::changed, []( const QVariant& size )
+    {
+        Tools::MediaIO::setReadAhead( size.toLongLong() * 1024 * 1024 );
+    } );
+    Tools::MediaIO::setReadAhead( readAhead->get().toLongLong() * 1024 * 1024 );
+
+    auto hardwareDecoding = m_settings->value( "vlmc/HardwareDecoding" );
+    QObject::connect( hardwareDecoding, &SettingValue::changed, [this]( const QVariant& api )
+    {
+        m_backend->setHardwareDecoding( api.toString().toStdString() );
+    } );
+    m_backend->setHardwareDecoding( hardwareDecoding->get().toString().toStdString() );
+
+    auto decodeThreads = m_settings->value( "vlmc/DecodeThreads" );
+    QObject::connect( decodeThreads, &SettingValue::changed, [this]( const QVariant& threads )
+    {
+        m_backend->setDecodeThreadBudget( threads.toInt() );
+    } );
+    m_backend->setDecodeThreadBudget( decodeThreads->get().toInt() );
+
+    // The probe encodes a few frames with each hardware encoder, which would compete with
+    // the startup. It runs once the event loop is up, or when first asked for.
+    m_encoderProbe = new EncoderProbe;
+    QTimer::singleShot( 0, m_encoderProbe, &EncoderProbe::start );
+
+    m_renderQueue = new RenderQueue;
+    auto renderConcurrency = m_settings->value( "vlmc/RenderConcurrency" );
+    QObject::connect( renderConcurrency, &SettingValue::changed, m_renderQueue, [this]( const QVariant& maxJobs )
+    {
+        m_renderQueue->setMaxConcurrentJobs( maxJobs.toUInt() );
+    } );
+    m_renderQueue->setMaxConcurrentJobs( renderConcurrency->get().toUInt() );
+    auto renderFanOut = m_settings->value( "vlmc/RenderFanOut" );
+    QObject::connect( renderFanOut, &SettingValue::changed, m_renderQueue, [this]( const QVariant& fanOut )
+    {
+        m_renderQueue->setFanOut( fanOut.toBool() );
+    } );
+    m_renderQueue->setFanOut( renderFanOut->get().toBool() );
+
+    // The background jobs make way for the exports
+    auto scheduler = m_jobScheduler;
+    QObject::connect( m_renderQueue, &RenderQueue::jobStarted, [scheduler]
+    {
+        scheduler->setThrottled( Tools::JobScheduler::Export, true );
+    } );
+    QObject::connect( m_renderQueue, &RenderQueue::idle, [scheduler]
+    {
+        scheduler->setThrottled( Tools::JobScheduler::Export, false );
+    } );
 
-    QObject::connect( m_workflow, &MainWorkflow::cleanChanged, m_currentProject, &Project::cleanChanged );
-    QObject::connect( m_currentProject, &Project::projectSaved, m_workflow, &MainWorkflow::setClean );
-    QObject::connect( m_library, &Library::cleanStateChanged, m_currentProject, &Project::libraryCleanChanged );
-    QObject::connect( m_currentProject, &Project::projectLoaded, m_recentProjects, &RecentProjects::projectLoaded );
-    QObject::connect( m_currentProject, &Project::projectClosed, m_library, &Library::clear );
-    QObject::connect( m_currentProject, &Project::projectClosed, m_workflow, &MainWorkflow::clear );
-    QObject::connect( m_currentProject, &Project::fpsChanged, m_workflow, &MainWorkflow::fpsChanged );
+    m_projectManager = new ProjectManager( [this]() { return createSession(); } );
+    VlmcLogger::startupPhase( "Core: project and workflow" );
 
     m_timer.start();
 }
 
+ProjectManager::Session
+Core::createSession()
+{
+    auto project = new Project( m_settings, m_jobScheduler );
+    auto library = new Library( project->settings(), m_jobScheduler );
+    auto workflow = new MainWorkflow( project->settings(), library, m_thumbnailService );
+
+    QObject::connect( workflow, &MainWorkflow::cleanChanged, project, &Project::cleanChanged );
+    QObject::connect( project, &Project::projectSaved, workflow, &MainWorkflow::setClean );
+    QObject::connect( library, &Library::cleanStateChanged, project, &Project::libraryCleanChanged );
+    QObject::connect( library, &Library::cleanStateChanged, project, &Project::scheduleEmergencyBackup );
+    QObject::connect( workflow->undoStack(), &Commands::AbstractUndoStack::indexChanged,
+                      project, &Project::scheduleEmergencyBackup );
+    QObject::connect( library, &Library::loadingProgress, project, &Project::projectLoadingProgress );
+    QObject::connect( project, &Project::projectLoaded, m_recentProjects, &RecentProjects::projectLoaded );
+    QObject::connect( project, &Project::projectClosed, library, &Library::clear );
+    QObject::connect( project, &Project::projectClosed, workflow, &MainWorkflow::clear );
+    QObject::connect( project, &Project::fpsChanged, workflow, &MainWorkflow::setFps );
+    QObject::connect( project, &Project::resolutionChanged, workflow, &MainWorkflow::setResolution );
+    QObject::connect( project, &Project::fpsChanged, library, &Library::conformFrameRates );
+
+    // The services are shared: each project picks the files it uses out of their results
+    QObject::connect( m_stabilizationService, &StabilizationService::analyzed,
+                      workflow, &MainWorkflow::stabilizationAnalyzed, Qt::QueuedConnection );
+    QObject::connect( m_audioConformService, &AudioConformService::conformed, library, &Library::audioConformed );
+    QObject::connect( m_frameRateConformService, &FrameRateConformService::conformed,
+                      library, &Library::frameRateConformed );
+    QObject::connect( m_sceneDetectionService, &SceneDetectionService::detected,
+                      library, &Library::scenesDetected, Qt::QueuedConnection );
+    QObject::connect( m_decodeBenchmarkService, &DecodeBenchmarkService::measured,
+                      library, &Library::decodeSpeedMeasured, Qt::QueuedConnection );
+    QObject::connect( m_proxyService, &ProxyService::optimized, library, &Library::mediaOptimized );
+    QObject::connect( library, &Library::mediaOnline, workflow, &MainWorkflow::mediaOnline );
+    QObject::connect( library, &Library::mediaGrown, workflow, &MainWorkflow::mediaGrown );
+    QObject::connect( m_waveformService, &WaveformService::peaksReady, library, &Library::peaksReady,
+                      Qt::QueuedConnection );
+
+    auto previewCache = workflow->previewCache();
+    auto workspaceLocation = m_settings->value( "vlmc/WorkspaceLocation" );
+    QObject::connect( workspaceLocation, &SettingValue::changed, workflow, [previewCache]( const QVariant& dir )
+    {
+        previewCache->setDirectory( dir.toString() );
+    } );
+    previewCache->setDirectory( workspaceLocation->get().toString() );
+    auto renderAhead = m_settings->value( "vlmc/PreviewRenderAhead" );
+    QObject::connect( renderAhead, &SettingValue::changed, workflow, [previewCache]( const QVariant& enabled )
+    {
+        previewCache->setEnabled( enabled.toBool() );
+    } );
+    previewCache->setEnabled( renderAhead->get().toBool() );
+    auto previewCacheSize = m_settings->value( "vlmc/PreviewCacheSize" );
+    QObject::connect( previewCacheSize, &SettingValue::changed, workflow, [previewCache]( const QVariant& size )
+    {
+        previewCache->setMaxSize( size.toLongLong() * 1024 * 1024 );
+    } );
+    previewCache->setMaxSize( previewCacheSize->get().toLongLong() * 1024 * 1024 );
+
+    auto undoLimit = m_settings->value( "vlmc/UndoLimit" );
+    auto undoLiveSteps = m_settings->value( "vlmc/UndoLiveSteps" );
+    auto undoBudgetChanged = [workflow, undoLimit, undoLiveSteps]
+    {
+        workflow->setUndoBudget( undoLimit->get().toInt(), undoLiveSteps->get().toInt() );
+    };
+    QObject::connect( undoLimit, &SettingValue::changed, workflow, undoBudgetChanged );
+    QObject::connect( undoLiveSteps, &SettingValue::changed, workflow, undoBudgetChanged );
+    undoBudgetChanged();
+
+    // The background jobs make way for the preview. A paused preview doesn't need the
+    // frames to come in time anymore.
+    auto scheduler = m_jobScheduler;
+    auto eventWatcher = workflow->renderer()->eventWatcher();
+    QObject::connect( eventWatcher, &RendererEventWatcher::playing, workflow, [scheduler]
+    {
+        scheduler->setThrottled( Tools::JobScheduler::Playback, true );
+    } );
+    auto playbackDone = [scheduler]
+    {
+        scheduler->setThrottled( Tools::JobScheduler::Playback, false );
+    };
+    QObject::connect( eventWatcher, &RendererEventWatcher::paused, workflow, playbackDone );
+    QObject::connect( eventWatcher, &RendererEventWatcher::stopped, workflow, playbackDone );
+
+    return ProjectManager::Session{ project, library, workflow };
+}
+
 Core::~Core()
 {
-    delete m_library;
-    delete m_workflow;
-    delete m_currentProject;
+    delete m_stallWatchdog;
+    // Cancels the exports, before their backend objects can get orphaned
+    delete m_renderQueue;
+    // The projects, along with their libraries and workflows
+    delete m_projectManager;
+    // Pending workers still use the backend
+    delete m_thumbnailService;
+    delete m_waveformService;
+    delete m_proxyService;
+    delete m_audioConformService;
+    delete m_frameIndexService;
+    delete m_frameRateConformService;
+    delete m_stabilizationService;
+    delete m_sceneDetectionService;
+    delete m_decodeBenchmarkService;
+    delete m_encoderProbe;
+    // The library's probes were cancelled along with it
+    delete m_probeCache;
+    Tools::MediaIO::logStats();
     delete m_workspace;
+    // Its users cancelled their jobs already
+    delete m_jobScheduler;
     delete m_settings;
     delete m_backend;
     delete m_logger;
@@ -85,15 +352,198 @@ Core::createSettings()
                                     QT_TRANSLATE_NOOP( "Settings", "Workspace location" ),
                                     QT_TRANSLATE_NOOP( "Settings", "VLMC's workspace location" ),
                                     SettingValue::Nothing );
+    m_settings->createVar( SettingValue::String, "vlmc/SharedCacheLocation", "",
+                                    QT_TRANSLATE_NOOP( "Settings", "Shared cache location" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Directory shared between workstations, "
+                                                       "where the thumbnails, waveforms and proxies of the "
+                                                       "medias are stored. Empty keeps them in the workspace" ),
+                                    SettingValue::Nothing );
+    SettingValue* thumbnailCacheSize = m_settings->createVar( SettingValue::Int, "vlmc/ThumbnailCacheSize", 128,
+                                    QT_TRANSLATE_NOOP( "Settings", "Thumbnail cache size" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Maximum memory used by the timeline "
+                                                       "thumbnails, in megabytes" ),
+                                    SettingValue::Clamped );
+    thumbnailCacheSize->setLimits( 8, 4096 );
+    SettingValue* renderWorkers = m_settings->createVar( SettingValue::Int, "vlmc/RenderWorkers", 1,
+                                    QT_TRANSLATE_NOOP( "Settings", "Export workers" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Number of segments encoded concurrently "
+                                                       "when exporting. 1 renders in a single pass" ),
+                                    SettingValue::Clamped );
+    renderWorkers->setLimits( 1, 64 );
+    SettingValue* renderConcurrency = m_settings->createVar( SettingValue::Int, "vlmc/RenderConcurrency", 1,
+                                    QT_TRANSLATE_NOOP( "Settings", "Concurrent exports" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Number of queued exports which "
+                                                       "are rendered at the same time" ),
+                                    SettingValue::Clamped );
+    renderConcurrency->setLimits( 1, 16 );
+    SettingValue* renderPreviewInterval = m_settings->createVar( SettingValue::Int, "vlmc/RenderPreviewInterval", 5,
+                                    QT_TRANSLATE_NOOP( "Settings", "Export preview interval" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Seconds of video between two previews "
+                                                       "while exporting. 0 disables the preview" ),
+                                    SettingValue::Clamped );
+    renderPreviewInterval->setLimits( 0, 3600 );
+    m_settings->createVar( SettingValue::Bool, "vlmc/SmartRender", false,
+                                    QT_TRANSLATE_NOOP( "Settings", "Copy the untouched clips" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "When exporting, copy the parts of the clips "
+                                                       "which play without any effect instead of reencoding "
+                                                       "them, when the medias match the output" ),
+                                    SettingValue::Nothing );
+    m_settings->createVar( SettingValue::Bool, "vlmc/RenderFanOut", true,
+                                    QT_TRANSLATE_NOOP( "Settings", "Share decoding between exports" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Decode the sequence once for all the "
+                                                       "renditions exported together" ),
+                                    SettingValue::Nothing );
+    m_settings->createVar( SettingValue::Bool, "vlmc/PreviewDropFrames", true,
+                                    QT_TRANSLATE_NOOP( "Settings", "Drop late preview frames" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Skip the frames which can't be rendered in time, "
+                                                       "to keep the preview in sync. Otherwise every frame "
+                                                       "is shown, and the playback slows down" ),
+                                    SettingValue::Nothing );
+    m_settings->createVar( SettingValue::Bool, "vlmc/PreviewScrubAudio", true,
+                                    QT_TRANSLATE_NOOP( "Settings", "Scrub audio" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Play a frame worth of audio when moving the "
+                                                       "cursor. The timeline reads it from the decoded audio "
+                                                       "cached in the workspace, when available" ),
+                                    SettingValue::Nothing );
+    SettingValue* previewThreads = m_settings->createVar( SettingValue::Int, "vlmc/PreviewThreads", 1,
+                                    QT_TRANSLATE_NOOP( "Settings", "Preview rendering threads" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Number of frames of the preview rendered in parallel" ),
+                                    SettingValue::Clamped );
+    previewThreads->setLimits( 1, 16 );
+    SettingValue* audioBuffer = m_settings->createVar( SettingValue::Int, "vlmc/PreviewAudioBuffer", 0,
+                                    QT_TRANSLATE_NOOP( "Settings", "Preview audio buffer (ms)" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Audio queued to the sound card. A smaller "
+                                                       "buffer starts and scrubs with less latency, a larger "
+                                                       "one doesn't crackle on a loaded machine. 0 uses "
+                                                       "SDL's default" ),
+                                    SettingValue::Clamped );
+    audioBuffer->setLimits( 0, 1000 );
+    m_settings->createVar( SettingValue::Bool, "vlmc/PreviewAdaptiveAudioBuffer", true,
+                                    QT_TRANSLATE_NOOP( "Settings", "Grow the audio buffer when it runs dry" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Double the preview audio buffer, up to about half "
+                                                       "a second, each time the sound card runs out of samples. "
+                                                       "It goes back to the configured size when the preview "
+                                                       "is set up again" ),
+                                    SettingValue::Nothing );
+    m_settings->createVar( SettingValue::Bool, "vlmc/PreviewMetrics", false,
+                                    QT_TRANSLATE_NOOP( "Settings", "Show the playback metrics" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Display the frame times and the dropped "
+                                                       "frames below the preview" ),
+                                    SettingValue::Nothing );
+    m_settings->createVar( SettingValue::Bool, "vlmc/PreviewOpenGL", false,
+                                    QT_TRANSLATE_NOOP( "Settings", "Display the preview with OpenGL" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Convert and scale the preview frames on the "
+                                                       "graphics card. Takes effect after a restart" ),
+                                    SettingValue::Nothing );
+    m_settings->createVar( SettingValue::String, "vlmc/PreviewSharedMemory", "",
+                                    QT_TRANSLATE_NOOP( "Settings", "Publish the preview in shared memory" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Name of the shared memory in which the project "
+                                                       "preview frames are published, for external monitors "
+                                                       "and scopes. Requires the OpenGL preview. Empty to "
+                                                       "disable. Takes effect after a restart" ),
+                                    SettingValue::Nothing );
+    m_settings->createVar( SettingValue::Bool, "vlmc/GpuProcessing", false,
+                                    QT_TRANSLATE_NOOP( "Settings", "Process the effects on the GPU" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Render the GPU capable effects with OpenGL, "
+                                                       "for the preview and the exports. Will render "
+                                                       "on a single thread. Takes effect after a restart" ),
+                                    SettingValue::Nothing );
+    SettingValue* readAhead = m_settings->createVar( SettingValue::Int, "vlmc/ReadAhead", 16,
+                                    QT_TRANSLATE_NOOP( "Settings", "Read ahead" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Data read in advance for the clips about to "
+                                                       "play, in MiB. Helps with medias on network storage. "
+                                                       "0 to disable" ),
+                                    SettingValue::Clamped );
+    readAhead->setLimits( 0, 1024 );
+    m_settings->createVar( SettingValue::Bool, "vlmc/ImportImageSequences", true,
+                                    QT_TRANSLATE_NOOP( "Settings", "Import numbered images as sequences" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "When importing a folder, import the runs of "
+                                                       "consecutively numbered images, such as frame0001.png, "
+                                                       "frame0002.png..., as a single video" ),
+                                    SettingValue::Nothing );
+    m_settings->createVar( SettingValue::Bool, "vlmc/PreviewRenderAhead", false,
+                                    QT_TRANSLATE_NOOP( "Settings", "Render the preview ahead" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "While the preview is stopped, render the marked "
+                                                       "regions and the frames after the cursor, so they "
+                                                       "play in real time" ),
+                                    SettingValue::Nothing );
+    SettingValue* previewCacheSize = m_settings->createVar( SettingValue::Int, "vlmc/PreviewCacheSize", 2048,
+                                    QT_TRANSLATE_NOOP( "Settings", "Preview cache size" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Disk space used by the rendered preview, in MiB" ),
+                                    SettingValue::Clamped );
+    previewCacheSize->setLimits( 64, 65536 );
+    SettingValue* undoLimit = m_settings->createVar( SettingValue::Int, "vlmc/UndoLimit", 200,
+                                    QT_TRANSLATE_NOOP( "Settings", "Undo levels" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Maximum number of actions which can be undone, "
+                                                       "0 for no limit. Applies from the next project" ),
+                                    SettingValue::Clamped );
+    undoLimit->setLimits( 0, 10000 );
+    SettingValue* undoLiveSteps = m_settings->createVar( SettingValue::Int, "vlmc/UndoLiveSteps", 20,
+                                    QT_TRANSLATE_NOOP( "Settings", "Instant undo levels" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Number of recent actions which keep the clips "
+                                                       "they removed in memory. Undoing older ones reopens "
+                                                       "the clips first" ),
+                                    SettingValue::Clamped );
+    undoLiveSteps->setLimits( 0, 10000 );
+    m_settings->createVar( SettingValue::Bool, "vlmc/LibraryDatabase", false,
+                                    QT_TRANSLATE_NOOP( "Settings", "Library database" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Store the library of the projects in a database "
+                                                       "of the workspace, and only load the medias which are "
+                                                       "shown or used. For libraries of many thousands of medias" ),
+                                    SettingValue::Nothing );
+    m_settings->createVar( SettingValue::Bool, "vlmc/GenerateProxies", false,
+                                    QT_TRANSLATE_NOOP( "Settings", "Generate proxies" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Transcode the imported videos to low resolution "
+                                                       "copies, used for the preview. Exports always use the "
+                                                       "original medias" ),
+                                    SettingValue::Nothing );
+    m_settings->createVar( SettingValue::Bool, "vlmc/DetectScenes", false,
+                                    QT_TRANSLATE_NOOP( "Settings", "Detect scenes" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Split the imported videos in subclips at "
+                                                       "their shot changes, in the background" ),
+                                    SettingValue::Nothing );
+    SettingValue* proxyWorkers = m_settings->createVar( SettingValue::Int, "vlmc/ProxyWorkers", 2,
+                                    QT_TRANSLATE_NOOP( "Settings", "Proxy workers" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Number of proxies generated concurrently" ),
+                                    SettingValue::Clamped );
+    proxyWorkers->setLimits( 1, 16 );
+    m_settings->createVar( SettingValue::String, "vlmc/HardwareDecoding", "",
+                                    QT_TRANSLATE_NOOP( "Settings", "Hardware decoding" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Decoding API used for the medias, such as "
+                                                       "vaapi, cuda or videotoolbox. Empty to decode in software" ),
+                                    SettingValue::Nothing );
+    SettingValue* decodeThreads = m_settings->createVar( SettingValue::Int, "vlmc/DecodeThreads", 0,
+                                    QT_TRANSLATE_NOOP( "Settings", "Decoding threads" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Threads shared by the decoders of the medias being "
+                                                       "played. 0 lets each decoder choose its own" ),
+                                    SettingValue::Clamped );
+    decodeThreads->setLimits( 0, 256 );
+    for ( int i = 0; i < Tools::ThreadRole::NbRoles; ++i )
+    {
+        auto role = static_cast<Tools::ThreadRole::Role>( i );
+        auto key = QString( "vlmc/" ) + threadRoleSettings[i].key;
+        SettingValue* priority = m_settings->createVar( SettingValue::Int, key + "ThreadPriority",
+                                    (int)Tools::ThreadRole::priority( role ), threadRoleSettings[i].priorityName,
+                                    QT_TRANSLATE_NOOP( "Settings", "From 0, only running when the system is idle, "
+                                                       "to 6, real time when the system allows it. 3 is the "
+                                                       "default of the system" ),
+                                    SettingValue::Clamped );
+        priority->setLimits( 0, Tools::ThreadRole::NbPriorities - 1 );
+        m_settings->createVar( SettingValue::String, key + "ThreadCores", "", threadRoleSettings[i].coresName,
+                                    QT_TRANSLATE_NOOP( "Settings", "The cores these threads run on, such as "
+                                                       "\"0-3,6\". Empty to run on any core" ),
+                                    SettingValue::Nothing );
+    }
+    SettingValue* stallThreshold = m_settings->createVar( SettingValue::Int, "vlmc/StallThreshold", 2000,
+                                    QT_TRANSLATE_NOOP( "Settings", "Freeze report threshold" ),
+                                    QT_TRANSLATE_NOOP( "Settings", "Logs what the interface is doing when it "
+                                                       "stops responding for longer than this, in "
+                                                       "milliseconds. 0 disables it" ),
+                                    SettingValue::Clamped );
+    stallThreshold->setLimits( 0, 60000 );
     m_settings->createVar( SettingValue::Bool, "private/FirstLaunchDone", false, "", "", SettingValue::Private );
 }
 
-Backend::IBackend*
-Core::backend()
-{
-    return m_backend;
-}
-
 VlmcLogger*
 Core::logger()
 {
@@ -112,15 +562,23 @@ Core::loadProject(const QString& fileName)
     if ( fileName.isEmpty() == true )
         return false;
     //FIXME: What if the project was unsaved, and the user wants to cancel the operation?
-    m_currentProject->load( fileName );
+    m_projectManager->project()->load( fileName );
 
     return true;
 }
 
+bool
+Core::openProject( const QString& fileName )
+{
+    if ( fileName.isEmpty() == true )
+        return false;
+    return m_projectManager->open( fileName );
+}
+
 bool
 Core::newProject( const QString& projectName, const QString& projectPath )
 {
-    m_currentProject->newProject( projectName, projectPath );
+    m_projectManager->project()->newProject( projectName, projectPath );
     return true;
 }
 
@@ -131,6 +589,79 @@ Core::settings()
 }
 
 
+ThumbnailService*
+Core::thumbnailService()
+{
+    return m_thumbnailService;
+}
+
+WaveformService*
+Core::waveformService()
+{
+    return m_waveformService;
+}
+
+EncoderProbe*
+Core::encoderProbe()
+{
+    m_encoderProbe->start();
+    return m_encoderProbe;
+}
+
+RenderQueue*
+Core::renderQueue()
+{
+    return m_renderQueue;
+}
+
+ProxyService*
+Core::proxyService()
+{
+    return m_proxyService;
+}
+
+AudioConformService*
+Core::audioConformService()
+{
+    return m_audioConformService;
+}
+
+FrameIndexService*
+Core::frameIndexService()
+{
+    return m_frameIndexService;
+}
+
+FrameRateConformService*
+Core::frameRateConformService()
+{
+    return m_frameRateConformService;
+}
+
+StabilizationService*
+Core::stabilizationService()
+{
+    return m_stabilizationService;
+}
+
+SceneDetectionService*
+Core::sceneDetectionService()
+{
+    return m_sceneDetectionService;
+}
+
+DecodeBenchmarkService*
+Core::decodeBenchmarkService()
+{
+    return m_decodeBenchmarkService;
+}
+
+Tools::JobScheduler*
+Core::jobScheduler()
+{
+    return m_jobScheduler;
+}
+
 Workspace*
 Core::workspace()
 {
@@ -139,19 +670,31 @@ Core::workspace()
 
 Project* Core::project()
 {
-    return m_currentProject;
+    return m_projectManager->project();
 }
 
 MainWorkflow*
 Core::workflow()
 {
-    return m_workflow;
+    return m_projectManager->workflow();
 }
 
 Library*
 Core::library()
 {
-    return m_library;
+    return m_projectManager->library();
+}
+
+ProjectManager*
+Core::projectManager()
+{
+    return m_projectManager;
+}
+
+ProbeCache*
+Core::probeCache()
+{
+    return m_probeCache;
 }
 
 qint64
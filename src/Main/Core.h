@@ -23,14 +23,26 @@
 #ifndef CORE_H
 #define CORE_H
 
+class AudioConformService;
 class AutomaticBackup;
+class DecodeBenchmarkService;
+class EncoderProbe;
+class FrameIndexService;
+class FrameRateConformService;
 class Library;
 class MainWorkflow;
 class NotificationZone;
+class ProbeCache;
 class Project;
+class ProxyService;
 class RecentProjects;
+class RenderQueue;
+class SceneDetectionService;
 class Settings;
+class StabilizationService;
+class ThumbnailService;
 class VlmcLogger;
+class WaveformService;
 class Workspace;
 
 namespace Backend
@@ -38,26 +50,51 @@ namespace Backend
     class IBackend;
 }
 
+namespace Tools
+{
+    class JobScheduler;
+    class StallWatchdog;
+}
+
 #include <QElapsedTimer>
+#include "Project/ProjectManager.h"
 #include "Tools/Singleton.hpp"
 
 class Core : public ScopedSingleton<Core>
 {
     public:
-        Backend::IBackend*      backend();
         Settings*               settings();
         VlmcLogger*             logger();
         RecentProjects*         recentProjects();
         Workspace*              workspace();
+        // The active project, and its workflow and library
         Project*                project();
         MainWorkflow*           workflow();
         Library*                library();
+        ProjectManager*         projectManager();
+        // Outlives the projects, which share it
+        ProbeCache*             probeCache();
+        ThumbnailService*       thumbnailService();
+        WaveformService*        waveformService();
+        EncoderProbe*           encoderProbe();
+        RenderQueue*            renderQueue();
+        ProxyService*           proxyService();
+        AudioConformService*    audioConformService();
+        FrameIndexService*      frameIndexService();
+        FrameRateConformService*    frameRateConformService();
+        StabilizationService*   stabilizationService();
+        SceneDetectionService*  sceneDetectionService();
+        DecodeBenchmarkService* decodeBenchmarkService();
+        Tools::JobScheduler*    jobScheduler();
         /**
          * @brief runtime returns the application runtime
          */
         qint64                  runtime();
 
+        // Loads fileName in place of the active project
         bool                    loadProject( const QString& fileName );
+        // Loads fileName next to the projects open already
+        bool                    openProject( const QString& fileName );
         bool                    newProject( const QString& projectName, const QString& projectPath );
 
     private:
@@ -66,6 +103,7 @@ class Core : public ScopedSingleton<Core>
 
         void                    createSettings();
         void                    connectComponents();
+        ProjectManager::Session createSession();
 
     private:
         Backend::IBackend*      m_backend;
@@ -73,9 +111,21 @@ class Core : public ScopedSingleton<Core>
         VlmcLogger*             m_logger;
         RecentProjects*         m_recentProjects;
         Workspace*              m_workspace;
-        Project*                m_currentProject;
-        MainWorkflow*           m_workflow;
-        Library*                m_library;
+        ProjectManager*         m_projectManager;
+        ProbeCache*             m_probeCache;
+        ThumbnailService*       m_thumbnailService;
+        WaveformService*        m_waveformService;
+        EncoderProbe*           m_encoderProbe;
+        RenderQueue*            m_renderQueue;
+        ProxyService*           m_proxyService;
+        AudioConformService*    m_audioConformService;
+        FrameIndexService*      m_frameIndexService;
+        FrameRateConformService*    m_frameRateConformService;
+        StabilizationService*   m_stabilizationService;
+        SceneDetectionService*  m_sceneDetectionService;
+        DecodeBenchmarkService* m_decodeBenchmarkService;
+        Tools::JobScheduler*    m_jobScheduler;
+        Tools::StallWatchdog*   m_stallWatchdog;
         QElapsedTimer           m_timer;
 
         friend Singleton_t::AllowInstantiation;
@@ -35,12 +35,22 @@
 #include "Renderer/ConsoleRenderer.h"
 #include "Project/Project.h"
 #include "Backend/IBackend.h"
+#include "Backend/IFilter.h"
+#include "Backend/MLT/MLTEffectsBenchmark.h"
+#include "Backend/MLT/MLTService.h"
 #include "Main/Core.h"
+#include "Project/Journal.h"
 #include "Settings/Settings.h"
+#include "Tools/SampleReduction.h"
+#include "Tools/VlmcLogger.h"
+#include "Workflow/EditingBenchmark.h"
+#include "Workflow/SeekBenchmark.h"
+#include "Workflow/TimelineBenchmark.h"
 #ifdef HAVE_GUI
 #include "Gui/MainWindow.h"
 #include "Gui/IntroDialog.h"
 #include "Gui/LanguageHelper.h"
+#include "Gui/preview/GpuContext.h"
 #include "Gui/wizard/firstlaunch/FirstLaunchWizard.h"
 #endif
 
@@ -51,11 +61,23 @@
 #else
 #include <QCoreApplication>
 #endif
+#include <QElapsedTimer>
 #include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
 #include <QSettings>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
 #include <QUuid>
 #include <QTextCodec>
 
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
 #ifdef Q_WS_X11
 #include <X11/Xlib.h>
 #endif
@@ -94,10 +116,17 @@ VLMCGuimain( int argc, char **argv )
 #endif
 
     QApplication app( argc, argv );
+    VlmcLogger::startupPhase( "Application" );
 
     Backend::IBackend* backend;
     VLMCmainCommon( app, &backend );
+    VlmcLogger::startupPhase( "Backend" );
     auto coreLock = Core::Policy_t::lock();
+    VlmcLogger::startupPhase( "Core" );
+
+    // Before any input gets opened, the backend then converts them for the GPU
+    if ( VLMC_GET_BOOL( "vlmc/GpuProcessing" ) == true )
+        GpuContext::enable( backend );
 
     /* Load a project file */
     bool        project = false;
@@ -159,6 +188,7 @@ VLMCGuimain( int argc, char **argv )
 #endif
 
     MainWindow w( backend );
+    VlmcLogger::startupPhase( "Main window" );
 
     if ( FirstLaunchWizard::shouldRun() == true )
     {
@@ -173,50 +203,577 @@ VLMCGuimain( int argc, char **argv )
 
     /* Main Window display */
     w.show();
+    // Once the first events are processed, which includes painting the window
+    QTimer::singleShot( 0, []{ VlmcLogger::startupPhase( "Window shown" ); } );
     auto res = app.exec();
     Core::instance()->settings()->save();
     return res;
 }
 #endif
 /**
- *  VLMC Entry point
- *  \brief this is the VLMC entry point
- *  \param argc
- *  \param argv
- *  \return Return value of vlmc
+ *  \brief Renders a project headless. \sa ConsoleRenderer
+ *
+ *  vlmc --render project.vlmc --out output_file [options]
+ *  \return One of ConsoleRenderer::ExitCode
  */
 int
 VLMCCoremain( int argc, char **argv )
 {
     QCoreApplication app( argc, argv );
+    VlmcLogger::startupPhase( "Application" );
 
     Backend::IBackend* backend;
     VLMCmainCommon( app, &backend );
+    VlmcLogger::startupPhase( "Backend" );
     auto coreLock = Core::Policy_t::lock();
+    VlmcLogger::startupPhase( "Core" );
 
-    /* Load a project file */
-    if ( app.arguments().count() < 3 )
+    ConsoleRenderer renderer;
+    if ( renderer.parseArguments( app.arguments() ) == false )
     {
-        vlmcCritical() << "Usage: ./vlmc project.vlmc output_file";
-        return 1;
+        QTextStream err( stderr );
+        err << "Usage: " << argv[0] << " --render project.vlmc --out output_file [options]\n"
+            << "Options:\n";
+        ConsoleRenderer::usage( err );
+        return ConsoleRenderer::InvalidArguments;
     }
+    QCoreApplication::connect( Core::instance()->project(), &Project::projectLoaded,
+                               []{ VlmcLogger::startupPhase( "Project loaded" ); } );
+    QTimer::singleShot( 0, &renderer, &ConsoleRenderer::startRender );
+    // The user's settings are left untouched by a render
+    return app.exec();
+}
 
+/**
+ *  \brief Times effect chains rendered over a generated source, and prints the results.
+ *
+ *  vlmc --benchmark-effects <filter,filter...|all> [frames] [WxH,WxH...]
+ */
+static int
+VLMCBenchmarkmain( int argc, char **argv )
+{
+    QCoreApplication app( argc, argv );
+    Backend::IBackend* backend;
+    VLMCmainCommon( app, &backend );
 
-#ifndef HAVE_GUI
-    ConsoleRenderer renderer;
-    Project  *p = Core::instance()->project();
+    auto args = app.arguments();
+    auto idx = args.indexOf( "--benchmark-effects" );
+    auto filtersArg = args.value( idx + 1, "all" );
+    auto nbFrames = args.value( idx + 2, "100" ).toUInt();
+    auto sizesArg = args.value( idx + 3, "640x360,1920x1080" );
 
-    QCoreApplication::connect( p, &Project::projectLoaded, &renderer, &ConsoleRenderer::startRender );
-    p->load( app.arguments()[1] );
-#endif
-    auto res = app.exec();
-    Core::instance()->settings()->save();
+    std::vector<std::string>    filters;
+    if ( filtersArg == "all" )
+    {
+        for ( const auto& f : backend->availableFilters() )
+        {
+            if ( f.second->isGpu() == false )
+                filters.push_back( f.first );
+        }
+    }
+    else
+    {
+        for ( const auto& f : filtersArg.split( ',', QString::SkipEmptyParts ) )
+            filters.push_back( f.toStdString() );
+    }
+
+    Backend::MLT::MLTEffectsBenchmark benchmark( filters, nbFrames );
+    for ( const auto& size : sizesArg.split( ',', QString::SkipEmptyParts ) )
+    {
+        auto dims = size.split( 'x' );
+        if ( dims.size() != 2 || dims[0].toUInt() == 0 || dims[1].toUInt() == 0 )
+        {
+            vlmcCritical() << "Invalid size" << size << ", expected WxH";
+            return 1;
+        }
+        auto res = benchmark.run( dims[0].toUInt(), dims[1].toUInt() );
+        printf( "%ux%u, %u frames\n", res.width, res.height, nbFrames );
+        printf( "    %-32s %8.3f ms/frame\n", "(source)", res.sourceMsPerFrame );
+        for ( const auto& f : res.filters )
+            printf( "    %-32s %8.3f ms/frame\n", f.identifier.c_str(), f.msPerFrame );
+        printf( "    %-32s %8.1f fps\n", "(total)", res.fps );
+    }
+    fflush( stdout );
+    return 0;
+}
+
+/**
+ *  \brief Times the preview and export of a generated timeline. \sa TimelineBenchmark
+ *
+ *  vlmc --benchmark-timeline [--tracks=n] [--clips=n] [--clip-length=frames]
+ *       [--effects=n] [--effect=filter] [--frames=n] [--size=WxH] [--no-export]
+ *       [--presets[=1080p,4k,8k]] [--out=results.json] [--baseline=results.json]
+ *       [--threshold=percent]
+ *  The results are printed as JSON. With --presets, the timeline is previewed and
+ *  exported at each of the frame sizes listed, all of them by default, instead of
+ *  --size, and the results are keyed by preset.
+ *  \return 0 on success, 1 for invalid arguments, 3 if a metric regressed from the
+ *          baseline by more than the threshold, 10% by default
+ */
+static int
+VLMCTimelineBenchmarkmain( int argc, char **argv )
+{
+    QCoreApplication app( argc, argv );
+    Backend::IBackend* backend;
+    VLMCmainCommon( app, &backend );
+    auto coreLock = Core::Policy_t::lock();
+
+    TimelineBenchmark::Config   config;
+    QStringList                 presets;
+    QString                     outFile;
+    QString                     baselineFile;
+    double                      threshold = 10;
+    for ( const auto& arg : app.arguments().mid( 1 ) )
+    {
+        auto name = arg.section( '=', 0, 0 );
+        auto value = arg.section( '=', 1 );
+        bool ok = true;
+        if ( name == "--tracks" )
+            config.tracks = value.toUInt( &ok );
+        else if ( name == "--clips" )
+            config.clipsPerTrack = value.toUInt( &ok );
+        else if ( name == "--clip-length" )
+            config.clipLength = value.toUInt( &ok );
+        else if ( name == "--effects" )
+            config.effectsPerClip = value.toUInt( &ok );
+        else if ( name == "--effect" )
+            config.effect = value;
+        else if ( name == "--frames" )
+            config.frames = value.toUInt( &ok );
+        else if ( name == "--size" )
+        {
+            auto dims = value.split( 'x' );
+            ok = dims.size() == 2 && ( config.width = dims[0].toUInt() ) > 0 &&
+                    ( config.height = dims[1].toUInt() ) > 0;
+        }
+        else if ( name == "--no-export" )
+            config.exportRender = false;
+        else if ( name == "--presets" )
+        {
+            presets = value.isEmpty() == true ? TimelineBenchmark::presets() : value.split( ',' );
+            for ( const auto& p : presets )
+                ok = ok && TimelineBenchmark::setPreset( config, p );
+        }
+        else if ( name == "--out" )
+            outFile = value;
+        else if ( name == "--baseline" )
+            baselineFile = value;
+        else if ( name == "--threshold" )
+            threshold = value.toDouble( &ok );
+        if ( ok == false )
+        {
+            vlmcCritical() << "Invalid value for" << name;
+            return 1;
+        }
+    }
+
+    QJsonObject baseline;
+    if ( baselineFile.isEmpty() == false )
+    {
+        QFile f( baselineFile );
+        if ( f.open( QFile::ReadOnly ) == false )
+        {
+            vlmcCritical() << "Can't read the baseline" << baselineFile;
+            return 1;
+        }
+        baseline = QJsonDocument::fromJson( f.readAll() ).object()["results"].toObject();
+    }
+
+    QJsonObject results;
+    QStringList regressions;
+    if ( presets.isEmpty() == true )
+    {
+        TimelineBenchmark benchmark( config );
+        results = benchmark.run();
+        regressions = TimelineBenchmark::regressions( results, baseline, threshold / 100 );
+    }
+    for ( const auto& p : presets )
+    {
+        TimelineBenchmark::setPreset( config, p );
+        TimelineBenchmark benchmark( config );
+        auto res = benchmark.run();
+        results[p] = res;
+        for ( const auto& r : TimelineBenchmark::regressions( res, baseline[p].toObject(), threshold / 100 ) )
+            regressions << QString( "%1: %2" ).arg( p, r );
+    }
+    QJsonObject doc;
+    QJsonObject docConfig{ { "tracks", (qint64)config.tracks },
+                           { "clips", (qint64)config.clipsPerTrack },
+                           { "clipLength", (qint64)config.clipLength },
+                           { "effects", (qint64)config.effectsPerClip },
+                           { "effect", config.effect },
+                           { "frames", (qint64)config.frames } };
+    // The presets set the frame size of each run
+    if ( presets.isEmpty() == true )
+    {
+        docConfig["width"] = (qint64)config.width;
+        docConfig["height"] = (qint64)config.height;
+    }
+    else
+        docConfig["presets"] = QJsonArray::fromStringList( presets );
+    doc["config"] = docConfig;
+    doc["results"] = results;
+    auto json = QJsonDocument( doc ).toJson();
+    fwrite( json.constData(), 1, json.size(), stdout );
+    fflush( stdout );
+    if ( outFile.isEmpty() == false )
+    {
+        QFile f( outFile );
+        if ( f.open( QFile::WriteOnly | QFile::Truncate ) == false || f.write( json ) != json.size() )
+            vlmcWarning() << "Can't write the results to" << outFile;
+    }
+
+    for ( const auto& r : regressions )
+        vlmcWarning() << "Regression:" << r;
+    return regressions.isEmpty() == true ? 0 : 3;
+}
+
+/**
+ *  \brief Times the edits of generated timelines of 100, 1000 and 10000 clips, or of
+ *         the given numbers of clips. \sa EditingBenchmark
+ *
+ *  vlmc --benchmark-editing [--clips=n[,n...]] [--tracks=n] [--clip-length=frames]
+ *       [--imports=n] [--out=results.json] [--baseline=results.json] [--threshold=percent]
+ *  The results are printed as JSON, keyed by number of clips.
+ *  \return 0 on success, 1 for invalid arguments, 3 if the edits didn't leave the
+ *          timeline as expected, or if a metric regressed from the baseline by more
+ *          than the threshold, 10% by default
+ */
+static int
+VLMCEditingBenchmarkmain( int argc, char **argv )
+{
+    QCoreApplication app( argc, argv );
+    Backend::IBackend* backend;
+    VLMCmainCommon( app, &backend );
+    auto coreLock = Core::Policy_t::lock();
+
+    EditingBenchmark::Config    config;
+    QList<quint32>              sizes{ 100, 1000, 10000 };
+    QString                     outFile;
+    QString                     baselineFile;
+    double                      threshold = 10;
+    for ( const auto& arg : app.arguments().mid( 1 ) )
+    {
+        auto name = arg.section( '=', 0, 0 );
+        auto value = arg.section( '=', 1 );
+        bool ok = true;
+        if ( name == "--clips" )
+        {
+            sizes.clear();
+            for ( const auto& s : value.split( ',' ) )
+            {
+                sizes << s.toUInt( &ok );
+                if ( ok == false || sizes.last() == 0 )
+                {
+                    ok = false;
+                    break;
+                }
+            }
+        }
+        else if ( name == "--tracks" )
+            config.tracks = value.toUInt( &ok );
+        else if ( name == "--clip-length" )
+            config.clipLength = value.toUInt( &ok );
+        else if ( name == "--imports" )
+            config.imports = value.toUInt( &ok );
+        else if ( name == "--out" )
+            outFile = value;
+        else if ( name == "--baseline" )
+            baselineFile = value;
+        else if ( name == "--threshold" )
+            threshold = value.toDouble( &ok );
+        if ( ok == false )
+        {
+            vlmcCritical() << "Invalid value for" << name;
+            return 1;
+        }
+    }
+
+    QJsonObject baseline;
+    if ( baselineFile.isEmpty() == false )
+    {
+        QFile f( baselineFile );
+        if ( f.open( QFile::ReadOnly ) == false )
+        {
+            vlmcCritical() << "Can't read the baseline" << baselineFile;
+            return 1;
+        }
+        baseline = QJsonDocument::fromJson( f.readAll() ).object()["results"].toObject();
+    }
+
+    QJsonObject results;
+    QStringList failures;
+    for ( auto size : sizes )
+    {
+        config.clips = size;
+        EditingBenchmark benchmark( config );
+        auto key = QString::number( size );
+        results[key] = benchmark.run();
+        for ( const auto& e : benchmark.errors() )
+            failures << QString( "%1 clips: %2" ).arg( key, e );
+        for ( const auto& r : TimelineBenchmark::regressions( results[key].toObject(),
+                                                              baseline[key].toObject(), threshold / 100 ) )
+            failures << QString( "%1 clips: regression: %2" ).arg( key, r );
+    }
+    QJsonObject doc;
+    doc["config"] = QJsonObject{ { "tracks", (qint64)config.tracks },
+                                 { "clipLength", (qint64)config.clipLength },
+                                 { "imports", (qint64)config.imports } };
+    doc["results"] = results;
+    auto json = QJsonDocument( doc ).toJson();
+    fwrite( json.constData(), 1, json.size(), stdout );
+    fflush( stdout );
+    if ( outFile.isEmpty() == false )
+    {
+        QFile f( outFile );
+        if ( f.open( QFile::WriteOnly | QFile::Truncate ) == false || f.write( json ) != json.size() )
+            vlmcWarning() << "Can't write the results to" << outFile;
+    }
+
+    for ( const auto& f : failures )
+        vlmcWarning() << f;
+    return failures.isEmpty() == true ? 0 : 3;
+}
+
+/**
+ *  \brief Times the exact and fast seeks of a file, and checks where the fast ones land.
+ *         \sa SeekBenchmark
+ *
+ *  vlmc --benchmark-seek <file> [seeks]
+ *  \return 0 on success, 1 for invalid arguments or a file which can't be decoded, 3 if
+ *          a fast seek didn't land on the requested frame
+ */
+static int
+VLMCSeekBenchmarkmain( int argc, char **argv )
+{
+    QCoreApplication app( argc, argv );
+    Backend::IBackend* backend;
+    VLMCmainCommon( app, &backend );
+
+    auto args = app.arguments();
+    auto idx = args.indexOf( "--benchmark-seek" );
+    auto filePath = args.value( idx + 1 );
+    auto nbSeeks = args.value( idx + 2, "50" ).toUInt();
+    if ( filePath.isEmpty() == true || nbSeeks == 0 )
+    {
+        vlmcCritical() << "Usage: vlmc --benchmark-seek <file> [seeks]";
+        return 1;
+    }
+    SeekBenchmark::Result   res;
+    try
+    {
+        res = SeekBenchmark( filePath, nbSeeks ).run();
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcCritical() << "Can't decode" << filePath;
+        return 1;
+    }
+    printf( "%s, %u seeks\n", qPrintable( filePath ), res.nbSeeks );
+    printf( "    %-16s %8.3f ms/seek\n", "exact", res.exactMs );
+    printf( "    %-16s %8.3f ms/seek\n", "fast", res.fastMs );
+    printf( "    %-16s %8.1f dB\n", "min PSNR", res.minPsnr );
+    printf( "    %-16s %8u\n", "misplaced", res.nbMisplaced );
+    fflush( stdout );
+    return res.nbMisplaced == 0 ? 0 : 3;
+}
+
+/**
+ *  \brief Times the waveform reduction kernels the CPU supports, over generated audio.
+ *         \sa Tools::sampleReducers
+ *
+ *  vlmc --benchmark-reduction [seconds]
+ *  The audio is 48kHz stereo, 10 minutes of it by default.
+ *  \return 0 on success, 1 for invalid arguments, 3 if a kernel disagrees with the
+ *          scalar one
+ */
+static int
+VLMCReductionBenchmarkmain( int argc, char **argv )
+{
+    QCoreApplication app( argc, argv );
+    auto args = app.arguments();
+    auto idx = args.indexOf( "--benchmark-reduction" );
+    auto seconds = args.value( idx + 1, "600" ).toUInt();
+    if ( seconds == 0 )
+    {
+        vlmcCritical() << "Usage: vlmc --benchmark-reduction [seconds]";
+        return 1;
+    }
+    size_t  count = (size_t)seconds * 48000 * 2;
+    std::vector<int16_t>    s16( count );
+    std::vector<float>      f32( count );
+    // Seeded, so that runs compare
+    std::mt19937            rng( 42 );
+    std::uniform_int_distribution<int>  distribution( -32768, 32767 );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        s16[i] = distribution( rng );
+        f32[i] = s16[i] / 32768.f;
+    }
+
+    auto reducers = Tools::sampleReducers();
+    auto s16Reference = reducers.front().s16( s16.data(), count );
+    auto f32Reference = reducers.front().f32( f32.data(), count );
+    double  s16ScalarMs = 0;
+    double  f32ScalarMs = 0;
+    int     res = 0;
+    printf( "%u s of 48kHz stereo, %zu samples\n", seconds, count );
+    for ( const auto& r : reducers )
+    {
+        QElapsedTimer   timer;
+        timer.start();
+        auto s = r.s16( s16.data(), count );
+        double s16Ms = timer.nsecsElapsed() / 1e6;
+        timer.start();
+        auto f = r.f32( f32.data(), count );
+        double f32Ms = timer.nsecsElapsed() / 1e6;
+        if ( &r == &reducers.front() )
+        {
+            s16ScalarMs = s16Ms;
+            f32ScalarMs = f32Ms;
+        }
+        printf( "    %-8s s16 %8.2f ms %6.1fx    float %8.2f ms %6.1fx\n", r.name,
+                s16Ms, s16ScalarMs / s16Ms, f32Ms, f32ScalarMs / f32Ms );
+        if ( s.min != s16Reference.min || s.max != s16Reference.max || s.sumSq != s16Reference.sumSq ||
+             f.min != f32Reference.min || f.max != f32Reference.max ||
+             std::fabs( f.sumSq - f32Reference.sumSq ) > 1e-5 * f32Reference.sumSq )
+        {
+            vlmcWarning() << r.name << "disagrees with the scalar reduction";
+            res = 3;
+        }
+    }
+    fflush( stdout );
     return res;
 }
 
+/**
+ *  \brief Crashes and recovers a journal, the way MainWorkflow replays it when a
+ *         project is loaded. \sa Journal
+ *
+ *  vlmc --check-journal
+ *  The edits made after a recovery must survive the next one, a torn record must not
+ *  hide the ones appended after it, and compacting must only drop what a snapshot holds.
+ *  \return 0 on success, 1 if the journal can't be written, 3 if an edit was lost
+ */
+static int
+VLMCJournalCheckmain( int argc, char **argv )
+{
+    QCoreApplication app( argc, argv );
+    QTemporaryDir   dir;
+    auto fileName = dir.filePath( "check.vlmc.journal" );
+    // The number of the last record of the snapshot, which MainWorkflow loads with the project
+    quint64         snapshotSeq = 0;
+    quint64         seq = 0;
+    int             nbEdits = 0;
+
+    // What MainWorkflow::openJournal does, but for the edits, which are their numbers
+    auto recover = [&fileName, &snapshotSeq, &seq]( Journal& journal, QList<int>& edits ) {
+        seq = snapshotSeq;
+        if ( journal.open( fileName ) == false )
+            return false;
+        for ( const auto& record : journal.records( seq ) )
+        {
+            seq = record.seq;
+            edits << record.changes["edit"].toInt();
+        }
+        return true;
+    };
+    auto edit = [&seq, &nbEdits]( Journal& journal ) {
+        return journal.append( ++seq, QVariantHash{ { "edit", ++nbEdits } } );
+    };
+    auto expect = [&nbEdits]( const QList<int>& edits, int first, const char* step ) {
+        QList<int>  expected;
+        for ( int i = first; i <= nbEdits; ++i )
+            expected << i;
+        if ( edits == expected )
+            return true;
+        vlmcWarning() << "Recovered the edits" << edits << "instead of" << expected << step;
+        return false;
+    };
+
+    {
+        Journal journal;
+        QList<int>  edits;
+        if ( recover( journal, edits ) == false || edit( journal ) == false || edit( journal ) == false )
+            return 1;
+        // Crashes, without saving
+    }
+    bool success = true;
+    {
+        Journal journal;
+        QList<int>  edits;
+        if ( recover( journal, edits ) == false )
+            return 1;
+        success &= expect( edits, 1, "after a crash" );
+        if ( edit( journal ) == false )
+            return 1;
+    }
+    {
+        // Crashes while appending a record
+        QFile file( fileName );
+        if ( file.open( QFile::WriteOnly | QFile::Append ) == false || file.write( "{\"edit\":" ) < 0 )
+            return 1;
+    }
+    {
+        Journal journal;
+        QList<int>  edits;
+        if ( recover( journal, edits ) == false )
+            return 1;
+        success &= expect( edits, 1, "after a second crash" );
+        if ( edit( journal ) == false )
+            return 1;
+        // The torn record doesn't come before it
+        auto records = journal.records( snapshotSeq );
+        if ( records.isEmpty() == true || records.last().seq != seq )
+        {
+            vlmcWarning() << "The edit appended after a torn record can't be read back";
+            success = false;
+        }
+        // Saves, then edits again
+        snapshotSeq = seq;
+        journal.compact( snapshotSeq );
+        if ( edit( journal ) == false )
+            return 1;
+    }
+    {
+        Journal journal;
+        QList<int>  edits;
+        if ( recover( journal, edits ) == false )
+            return 1;
+        success &= expect( edits, nbEdits, "after saving" );
+        if ( journal.records( 0 ).size() != 1 )
+        {
+            vlmcWarning() << "Compacting kept" << journal.records( 0 ).size() << "records instead of 1";
+            success = false;
+        }
+    }
+    printf( "%d edits, %s\n", nbEdits, success == true ? "all recovered" : "some lost" );
+    return success == true ? 0 : 3;
+}
+
 int
 VLMCmain( int argc, char **argv )
 {
+    // A developer tool, which needs neither a project nor the GUI
+    for ( int i = 1; i < argc; ++i )
+    {
+        if ( strcmp( argv[i], "--benchmark-effects" ) == 0 )
+            return VLMCBenchmarkmain( argc, argv );
+        if ( strcmp( argv[i], "--benchmark-timeline" ) == 0 )
+            return VLMCTimelineBenchmarkmain( argc, argv );
+        if ( strcmp( argv[i], "--benchmark-editing" ) == 0 )
+            return VLMCEditingBenchmarkmain( argc, argv );
+        if ( strcmp( argv[i], "--check-journal" ) == 0 )
+            return VLMCJournalCheckmain( argc, argv );
+        if ( strcmp( argv[i], "--benchmark-seek" ) == 0 )
+            return VLMCSeekBenchmarkmain( argc, argv );
+        if ( strcmp( argv[i], "--benchmark-reduction" ) == 0 )
+            return VLMCReductionBenchmarkmain( argc, argv );
+        // Never needs a display, even when VLMC is built with its GUI
+        if ( strcmp( argv[i], "--render" ) == 0 || strncmp( argv[i], "--render=", 9 ) == 0 )
+            return VLMCCoremain( argc, argv );
+    }
+
 #ifdef HAVE_GUI
     int res = VLMCGuimain( argc, argv );
 #else
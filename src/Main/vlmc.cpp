@@ -28,6 +28,7 @@
 #include "Workflow/Types.h"
 #include "Tools/VlmcDebug.h"
 #include "Project/Project.h"
+#include "Renderer/ConsoleRenderer.h"
 
 #include <QMetaType>
 #include <QTextStream>
@@ -54,7 +55,7 @@ signalHandler( int sig )
 {
     signal( sig, SIG_DFL );
 
-    Core::instance()->project()->emergencyBackup();
+    Project::emergencyBackup();
 
     #ifdef WITH_CRASHHANDLER_GUI
         CrashHandler* ch = new CrashHandler( sig );
@@ -90,8 +91,9 @@ usage( QString const& appName )
     out << "Usage: " << appName << " [options] [filename|URI]...\n"
         << "Options:\n"
         << "\t[--project|-p projectfile]\tload the given VLMC project\n"
-        << "\t[--version]\tversion information\n"
-        << "\t[--help|-?]\tthis text\n\n"
+        << "\t[--version]\tversion information\n";
+    ConsoleRenderer::usage( out );
+    out << "\t[--help|-?]\tthis text\n\n"
         << "\tFILES:\n"
         << "\t\tFiles specified on the command line should include \n"
         << "\t\tVLMC project files (.vlmc)\n";
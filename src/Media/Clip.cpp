@@ -38,14 +38,40 @@
 #include "EffectsEngine/EffectHelper.h"
 #include <QVariant>
 
+#include <utility>
+
+namespace
+{
+// From a frame of the media played at speed, to a frame of the file, and back. The
+// reversed media starts with the end of the file.
+double
+toFileFrame( qint64 frame, double speed, qint64 length )
+{
+    if ( speed > 0. )
+        return frame * speed;
+    return length - 1 + frame * speed;
+}
+
+qint64
+fromFileFrame( double frame, double speed, qint64 length )
+{
+    if ( speed > 0. )
+        return qRound64( frame / speed );
+    return qRound64( ( length - 1 - frame ) / -speed );
+}
+}
+
 Clip::Clip( Media *media, qint64 begin /*= 0*/, qint64 end /*= Backend::IInput::EndOfMedia */, const QString& uuid /*= QString()*/ ) :
         Workflow::Helper( uuid ),
         m_media( media ),
         m_input( std::move( m_media->input()->cut( begin, end ) ) ),
+        m_childs( nullptr ),
         m_parent( media->baseClip() ),
-        m_isLinked( false )
+        m_isLinked( false ),
+        m_audioOnlyInput( false ),
+        m_speed( 1. ),
+        m_frameBlending( false )
 {
-    m_childs = new MediaContainer( this );
     m_rootClip = media->baseClip();
     Formats f;
     if ( media->input()->hasAudio() == true )
@@ -53,6 +79,7 @@ Clip::Clip( Media *media, qint64 begin /*= 0*/, qint64 end /*= Backend::IInput::
     if ( media->input()->hasVideo() == true )
         f |= Clip::Video;
     setFormats( f );
+    connect( m_media, &Media::lengthChanged, this, &Clip::mediaLengthChanged );
 }
 
 Clip::Clip( Clip *parent, qint64 begin /*= -1*/, qint64 end /*= -2*/,
@@ -60,9 +87,12 @@ Clip::Clip( Clip *parent, qint64 begin /*= -1*/, qint64 end /*= -2*/,
         Workflow::Helper( uuid ),
         m_media( parent->media() ),
         m_rootClip( parent->rootClip() ),
-        m_parent( parent )
+        m_childs( nullptr ),
+        m_parent( parent ),
+        m_audioOnlyInput( parent->m_audioOnlyInput ),
+        m_speed( parent->m_speed ),
+        m_frameBlending( parent->m_frameBlending )
 {
-    m_childs = new MediaContainer( this );
     if ( begin == -1 )
         begin = parent->begin();
     else
@@ -74,6 +104,7 @@ Clip::Clip( Clip *parent, qint64 begin /*= -1*/, qint64 end /*= -2*/,
         end = parent->begin() + end;
     m_input = parent->input()->cut( begin, end );
     setFormats( parent->formats() );
+    connect( m_media, &Media::lengthChanged, this, &Clip::mediaLengthChanged );
 }
 
 Clip::~Clip()
@@ -105,13 +136,23 @@ Clip::lengthSecond() const
 const QStringList&
 Clip::metaTags() const
 {
-    return m_metaTags;
+    static const QStringList    none;
+    if ( m_libraryData == nullptr )
+        return none;
+    return m_libraryData->metaTags;
 }
 
 void
 Clip::setMetaTags( const QStringList &tags )
 {
-    m_metaTags = tags;
+    if ( m_libraryData == nullptr )
+    {
+        if ( tags.isEmpty() == true )
+            return;
+        m_libraryData.reset( new LibraryData );
+    }
+    m_libraryData->metaTags = tags;
+    emit annotationsChanged( this );
 }
 
 bool
@@ -122,7 +163,7 @@ Clip::matchMetaTag( const QString &tag ) const
     if ( m_parent && m_parent->matchMetaTag( tag ) == true )
         return true;
     QString metaTag;
-    foreach ( metaTag, m_metaTags )
+    foreach ( metaTag, metaTags() )
     {
         if ( metaTag.startsWith( tag, Qt::CaseInsensitive ) == true )
             return true;
@@ -133,13 +174,23 @@ Clip::matchMetaTag( const QString &tag ) const
 const QString&
 Clip::notes() const
 {
-    return m_notes;
+    static const QString    none;
+    if ( m_libraryData == nullptr )
+        return none;
+    return m_libraryData->notes;
 }
 
 void
 Clip::setNotes( const QString &notes )
 {
-    m_notes = notes;
+    if ( m_libraryData == nullptr )
+    {
+        if ( notes.isEmpty() == true )
+            return;
+        m_libraryData.reset( new LibraryData );
+    }
+    m_libraryData->notes = notes;
+    emit annotationsChanged( this );
 }
 
 const QUuid&
@@ -244,6 +295,8 @@ Clip::parent() const
 MediaContainer*
 Clip::mediaContainer()
 {
+    if ( m_childs == nullptr )
+        m_childs = new MediaContainer( this );
     return m_childs;
 }
 
@@ -256,13 +309,14 @@ Clip::mediaContainer() const
 bool
 Clip::addSubclip( Clip *clip )
 {
-    return m_childs->addClip( clip );
+    return mediaContainer()->addClip( clip );
 }
 
 void
 Clip::clear()
 {
-    m_childs->clear();
+    if ( m_childs != nullptr )
+        m_childs->clear();
 }
 
 bool
@@ -284,8 +338,8 @@ Clip::toVariant() const
 {
     QVariantHash h = {
         { "uuid", m_uuid.toString() },
-        { "metatags", m_metaTags },
-        { "notes", m_notes },
+        { "metatags", metaTags() },
+        { "notes", notes() },
         { "formats", (int)formats() }
     };
     if ( isRootClip() )
@@ -303,6 +357,11 @@ Clip::toVariant() const
     }
     else
         h.insert( "linked", false );
+    if ( m_speed != 1. )
+    {
+        h.insert( "speed", m_speed );
+        h.insert( "frameBlending", m_frameBlending );
+    }
     h.insert( "filters", EffectHelper::toVariant( m_input.get() ) );
     return QVariant( h );
 
@@ -312,7 +371,7 @@ QVariant
 Clip::toVariantFull() const
 {
     QVariantHash h = toVariant().toHash();
-    if ( m_childs->count() > 0 )
+    if ( m_childs != nullptr && m_childs->count() > 0 )
     {
         QVariantList l;
         for ( const auto& c : m_childs->clips() )
@@ -334,6 +393,48 @@ Clip::setFormats( Formats formats )
     if ( formats.testFlag( Clip::None ) )
         m_formats = Clip::None;
     m_formats = formats;
+
+    // Audio clips don't need the video of their file. Cut them from an input which
+    // doesn't decode it instead.
+    // The retimed clips keep the frames of the retimed media
+    if ( m_formats != Clip::Audio || m_audioOnlyInput == true || m_input == nullptr ||
+         m_speed != 1. || m_media->input()->hasVideo() == false )
+        return;
+    auto audioInput = m_media->audioInput();
+    if ( audioInput == nullptr )
+        return;
+    m_input = audioInput->cut( begin(), end() );
+    m_audioOnlyInput = true;
+}
+
+void
+Clip::reloadInput( bool inheritFormats )
+{
+    auto filters = EffectHelper::toVariant( m_input.get() );
+    Formats f = m_formats;
+    if ( isRootClip() == true )
+    {
+        m_input = m_media->input()->cut();
+        f = Formats();
+        if ( m_media->input()->hasAudio() == true )
+            f |= Clip::Audio;
+        if ( m_media->input()->hasVideo() == true )
+            f |= Clip::Video;
+    }
+    else
+    {
+        Backend::IInput* source = nullptr;
+        if ( m_speed != 1. )
+            source = m_media->retimedInput( m_speed, m_frameBlending );
+        if ( source == nullptr )
+            source = m_media->input();
+        m_input = source->cut( begin(), end() );
+        if ( inheritFormats == true )
+            f = m_parent->formats();
+    }
+    m_audioOnlyInput = false;
+    setFormats( f );
+    EffectHelper::loadFromVariant( filters, m_input.get() );
 }
 
 Backend::IInput*
@@ -342,8 +443,65 @@ Clip::input()
     return m_input.get();
 }
 
+double
+Clip::speed() const
+{
+    return m_speed;
+}
+
+bool
+Clip::frameBlending() const
+{
+    return m_frameBlending;
+}
+
+void
+Clip::retimedBoundaries( double speed, qint64& begin, qint64& end ) const
+{
+    Q_ASSERT( speed != 0. );
+    auto length = m_media->input()->length();
+    auto first = toFileFrame( this->begin(), m_speed, length );
+    auto last = toFileFrame( this->end(), m_speed, length );
+    begin = fromFileFrame( first, speed, length );
+    end = fromFileFrame( last, speed, length );
+    // Reversing the playback swaps them
+    if ( begin > end )
+        std::swap( begin, end );
+}
+
+bool
+Clip::setRetiming( double speed, bool frameBlending, qint64 begin, qint64 end )
+{
+    Backend::IInput* source;
+    if ( speed == 1. )
+        source = m_media->input();
+    else
+        source = m_media->retimedInput( speed, frameBlending );
+    if ( source == nullptr )
+        return false;
+    auto filters = EffectHelper::toVariant( m_input.get() );
+    m_input = source->cut( begin, qMin( end, source->length() - 1 ) );
+    m_speed = speed;
+    m_frameBlending = speed != 1. && frameBlending;
+    m_audioOnlyInput = false;
+    setFormats( m_formats );
+    EffectHelper::loadFromVariant( filters, m_input.get() );
+    return true;
+}
+
 void
 Clip::mediaMetadataUpdated()
 {
 }
 
+void
+Clip::mediaLengthChanged( qint64, qint64 newLength )
+{
+    // Its retimed media keeps its length, the next ones cut get the new one
+    if ( m_speed != 1. )
+        return;
+    auto input = dynamic_cast<Backend::MLT::MLTInput*>( m_input.get() );
+    if ( input != nullptr )
+        input->setLength( newLength );
+}
+
@@ -89,6 +89,13 @@ class   Clip : public Workflow::Helper
 
         Clip                *parent();
         const Clip          *parent() const;
+        /**
+         *  \brief          The container of the clip subclips, created on first use.
+         *
+         *  Only the library clips need one: the clips of the timeline never get
+         *  subclips, and don't pay for it. The const version returns nullptr until
+         *  the container gets created.
+         */
         MediaContainer*     mediaContainer();
         const MediaContainer*     mediaContainer() const;
 
@@ -143,13 +150,52 @@ class   Clip : public Workflow::Helper
         void                setFormats( Formats formats );
 
         Backend::IInput* input();
+        /**
+         *  \brief          Cuts the clip again from its media input, once the media
+         *                  replaced its placeholder. The boundaries and filters are kept.
+         *
+         *  A root clip takes the formats of the file. The others keep theirs, unless
+         *  inheritFormats is set, for the subclips, in which case they take their
+         *  parent's. The parent must be reloaded first.
+         */
+        void                reloadInput( bool inheritFormats = false );
+
+        /**
+         *  \brief          The speed the clip plays its media at. Negative speeds play
+         *                  it backward.
+         *
+         *  Once it isn't 1, the clip is cut from Media::retimedInput(), and its
+         *  boundaries are frames of the retimed media.
+         */
+        double              speed() const;
+        /**
+         *  \brief          True if the frames a slowed down clip repeats are blended
+         *                  with the following ones.
+         */
+        bool                frameBlending() const;
+        /**
+         *  \brief          The boundaries of the same part of the media, played at speed.
+         */
+        void                retimedBoundaries( double speed, qint64& begin, qint64& end ) const;
+        /**
+         *  \brief          Cuts the clip again from its media played at speed, from begin
+         *                  to end, in frames of the retimed media. The filters are kept.
+         *
+         *  Returns false if the media can't be retimed, in which case nothing changes.
+         */
+        bool                setRetiming( double speed, bool frameBlending, qint64 begin, qint64 end );
 
     private:
         Media*              m_media;
         std::unique_ptr<Backend::IInput> m_input;
 
-        QStringList         m_metaTags;
-        QString             m_notes;
+        // What the library shows about a clip, which only its clips get to set
+        struct LibraryData
+        {
+            QStringList     metaTags;
+            QString         notes;
+        };
+        std::unique_ptr<LibraryData>    m_libraryData;
 
         /**
          *  \brief          Return the root clip.
@@ -158,23 +204,32 @@ class   Clip : public Workflow::Helper
          */
         Clip*               m_rootClip;
 
+        // See mediaContainer()
         MediaContainer*     m_childs;
 
         Clip*               m_parent;
 
         QUuid               m_linkedClipUuid;
         bool                m_isLinked;
+        // True once m_input is cut from the media's audio only input
+        bool                m_audioOnlyInput;
+        double              m_speed;
+        bool                m_frameBlending;
 
         Formats             m_formats;
 
     private slots:
         void                mediaMetadataUpdated();
+        // Lengthens the cut, so that the clip can be extended over the new frames
+        void                mediaLengthChanged( qint64 oldLength, qint64 newLength );
 
     signals:
         /**
          *  \brief          Act just like QObject::destroyed(), but before the clip deletion.
          */
         void                unloaded( Clip* );
+        // Emitted when the tags or the notes change
+        void                annotationsChanged( Clip* );
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( Clip::Formats )
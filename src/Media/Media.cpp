@@ -31,6 +31,7 @@
 # include "config.h"
 #endif
 
+#include <QDir>
 #include <QUrl>
 
 #include "Media.h"
@@ -38,8 +39,17 @@
 #include "Clip.h"
 #include "Main/Core.h"
 #include "Library/Library.h"
+#include "Library/ProbeCache.h"
+#include "Tools/MediaIO.h"
+#include "Tools/Metrics.h"
+#include "Tools/Multicam.h"
+#include "Tools/NestedSequence.h"
+#include "Tools/Title.h"
 #include "Tools/VlmcDebug.h"
+#include "Workflow/AudioConformService.h"
+#include "Workflow/ThumbnailService.h"
 #include "Project/Workspace.h"
+#include "Backend/IBackend.h"
 #include "Backend/MLT/MLTInput.h"
 
 
@@ -60,18 +70,94 @@ const QString   Media::streamPrefix = "stream://";
 
 #ifdef HAVE_GUI
 QPixmap*        Media::defaultSnapshot = nullptr;
+
+namespace
+{
+    int64_t
+    snapshotSize( const QPixmap& snapshot )
+    {
+        return static_cast<int64_t>( snapshot.width() ) * snapshot.height() * snapshot.depth() / 8;
+    }
+
+    Tools::Metrics::MemoryAccount&
+    snapshots()
+    {
+        static auto& account = Tools::Metrics::memory( "library.snapshots" );
+        return account;
+    }
+}
 #endif
 
 Media::Media(const QString &path )
     : m_input( nullptr )
     , m_fileInfo( nullptr )
     , m_baseClip( nullptr )
+    , m_decodeThreads( 0 )
+    , m_frameRateConform( FrameRateConformService::Nearest )
+    , m_placeholder( false )
+    , m_growing( false )
+    , m_decodeSpeed( 0 )
 {
     setFilePath( path );
 }
 
+Media::Media( const QString& path, std::unique_ptr<Backend::IInput> input )
+    : m_input( std::move( input ) )
+    , m_fileInfo( nullptr )
+    , m_baseClip( nullptr )
+    , m_decodeThreads( 0 )
+    , m_frameRateConform( FrameRateConformService::Nearest )
+    , m_placeholder( false )
+    , m_growing( false )
+    , m_decodeSpeed( 0 )
+{
+    setFileInfo( path );
+    updateInfo();
+}
+
+Media::Media( const QString& path, qint64 nbFrames )
+    : m_input( Backend::MLT::MLTInput::generator( "color", "#000000", nbFrames ) )
+    , m_fileInfo( nullptr )
+    , m_baseClip( nullptr )
+    , m_decodeThreads( 0 )
+    , m_frameRateConform( FrameRateConformService::Nearest )
+    , m_placeholder( true )
+    , m_growing( false )
+    , m_decodeSpeed( 0 )
+{
+    // Nothing is known of the file yet
+    setFileInfo( path );
+}
+
+Media*
+Media::createPlaceholder( const QString& path, qint64 nbFrames )
+{
+    return new Media( path, nbFrames );
+}
+
+bool
+Media::isPlaceholder() const
+{
+    return m_placeholder;
+}
+
+void
+Media::setInput( std::unique_ptr<Backend::IInput> input )
+{
+    m_input = std::move( input );
+    m_audioInput.reset();
+    m_retimedInputs.clear();
+    m_conformedVideo.clear();
+    m_placeholder = false;
+    updateInfo();
+}
+
 Media::~Media()
 {
+#ifdef HAVE_GUI
+    if ( m_snapshot.isNull() == false )
+        snapshots().remove( snapshotSize( m_snapshot ) );
+#endif
     delete m_fileInfo;
 }
 
@@ -117,6 +203,78 @@ Media::toVariant() const
     return QVariant( m_fileInfo->absoluteFilePath() );
 }
 
+void
+Media::setHardwareDecoding( const QString& api )
+{
+    m_hardwareDecoding = api;
+    Backend::instance()->setMediaHardwareDecoding( m_fileInfo->absoluteFilePath().toStdString(),
+                                                   api.toStdString() );
+}
+
+const QString&
+Media::hardwareDecoding() const
+{
+    return m_hardwareDecoding;
+}
+
+void
+Media::setDecodeThreads( int threads )
+{
+    m_decodeThreads = threads;
+    Backend::instance()->setMediaDecodeThreads( m_fileInfo->absoluteFilePath().toStdString(), threads );
+}
+
+int
+Media::decodeThreads() const
+{
+    return m_decodeThreads;
+}
+
+FrameRateConformService::Mode
+Media::frameRateConform() const
+{
+    return m_frameRateConform;
+}
+
+void
+Media::setFrameRateConform( FrameRateConformService::Mode mode )
+{
+    m_frameRateConform = mode;
+}
+
+bool
+Media::setConformedVideo( const QString& path )
+{
+    if ( m_placeholder == true )
+        return false;
+    if ( path == m_conformedVideo )
+        return true;
+    std::unique_ptr<Backend::IInput>    input;
+    try
+    {
+        if ( path.isEmpty() == true )
+            input = openInput( m_fileInfo->absoluteFilePath() );
+        else
+            input.reset( new Backend::MLT::MLTInput( qPrintable( path ) ) );
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Can't open" << ( path.isEmpty() == true ? m_fileInfo->absoluteFilePath() : path );
+        return false;
+    }
+    // The audio only input has the same frames either way
+    m_input = std::move( input );
+    m_retimedInputs.clear();
+    m_conformedVideo = path;
+    return true;
+}
+
+const QString&
+Media::conformedVideo() const
+{
+    return m_conformedVideo;
+}
+
 Backend::IInput*
 Media::input()
 {
@@ -129,16 +287,233 @@ Media::input() const
     return m_input.get();
 }
 
+const Backend::MediaInfo&
+Media::info() const
+{
+    return m_info;
+}
+
 void
-Media::setFilePath( const QString &filePath )
+Media::updateInfo()
+{
+    auto path = m_fileInfo->absoluteFilePath();
+    auto input = dynamic_cast<const Backend::MLT::MLTInput*>( m_input.get() );
+    try
+    {
+        // A proxy's properties aren't the media's
+        if ( input != nullptr && isProxied( path ) == false )
+            m_info = Backend::MLT::MLTInput::mediaInfo( input->probedProperties() );
+        else
+            m_info = probe( path );
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Can't probe" << path;
+        m_info = Backend::MediaInfo();
+    }
+}
+
+Backend::IInput*
+Media::audioInput()
+{
+    // The clips of a placeholder are cut again once the file is opened
+    if ( m_audioInput == nullptr && m_placeholder == false && m_input->hasAudio() == true )
+    {
+        try
+        {
+            auto path = m_fileInfo->absoluteFilePath();
+            auto conformed = Core::instance()->audioConformService()->conformedPath( path );
+            auto mainInput = dynamic_cast<Backend::MLT::MLTInput*>( m_input.get() );
+            Backend::MLT::MLTInput* input;
+            // Already in the project format, so it doesn't need resampling
+            if ( conformed.isEmpty() == false )
+                input = new Backend::MLT::MLTInput( qPrintable( conformed ) );
+            // Same as the main input: only opened once decoded
+            else if ( mainInput != nullptr && isProxied( path ) == false )
+                input = new Backend::MLT::MLTInput( qPrintable( path ), mainInput->probedProperties() );
+            else
+                input = new Backend::MLT::MLTInput( qPrintable( path ) );
+            input->disableVideo();
+            m_audioInput.reset( input );
+        }
+        catch ( Backend::InvalidServiceException& )
+        {
+            vlmcWarning() << "Can't open an audio only input for" << m_fileInfo->absoluteFilePath();
+            return nullptr;
+        }
+    }
+    return m_audioInput.get();
+}
+
+void
+Media::resetAudioInput()
+{
+    m_audioInput.reset();
+}
+
+Backend::IInput*
+Media::retimedInput( double speed, bool frameBlending )
+{
+    if ( m_placeholder == true || m_fileType == Image || m_fileType == Title ||
+         m_fileType == Multicam || m_fileType == NestedSequence )
+        return nullptr;
+    auto key = std::make_pair( speed, frameBlending );
+    auto it = m_retimedInputs.find( key );
+    if ( it != m_retimedInputs.end() )
+        return it->second.get();
+    try
+    {
+        auto path = m_conformedVideo.isEmpty() == true ? m_fileInfo->absoluteFilePath() : m_conformedVideo;
+        auto input = Backend::MLT::MLTInput::retimed( qPrintable( path ), speed, frameBlending );
+        auto res = input.get();
+        m_retimedInputs[key] = std::move( input );
+        return res;
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Can't retime" << m_fileInfo->absoluteFilePath() << "at speed" << speed;
+        return nullptr;
+    }
+}
+
+const Tools::Loudness&
+Media::loudness() const
+{
+    return m_loudness;
+}
+
+void
+Media::setLoudness( const Tools::Loudness& loudness )
+{
+    m_loudness = loudness;
+}
+
+double
+Media::decodeSpeed() const
+{
+    return m_decodeSpeed;
+}
+
+void
+Media::setDecodeSpeed( double speed )
+{
+    if ( speed == m_decodeSpeed )
+        return;
+    m_decodeSpeed = speed;
+    emit decodeSpeedChanged();
+}
+
+bool
+Media::isGrowing() const
+{
+    return m_growing;
+}
+
+void
+Media::setGrowing( bool growing )
+{
+    m_growing = growing;
+}
+
+bool
+Media::grow( qint64 length )
+{
+    if ( m_placeholder == true || length <= m_input->length() )
+        return false;
+    setLength( length );
+    return true;
+}
+
+void
+Media::rescale( double ratio )
+{
+    if ( m_placeholder == true )
+        return;
+    setLength( qMax( 1ll, qRound64( m_input->length() * ratio ) ) );
+}
+
+void
+Media::setLength( qint64 length )
+{
+    auto oldLength = m_input->length();
+    for ( auto input : { m_input.get(), m_audioInput.get() } )
+    {
+        auto mltInput = dynamic_cast<Backend::MLT::MLTInput*>( input );
+        if ( mltInput != nullptr )
+            mltInput->setLength( length );
+    }
+    m_info.length = length;
+    // Cut again with the new length by the clips which get retimed next
+    m_retimedInputs.clear();
+    emit lengthChanged( oldLength, length );
+}
+
+void
+Media::setFileInfo( const QString& filePath )
 {
     if ( m_fileInfo )
         delete m_fileInfo;
     m_fileInfo = new QFileInfo( filePath );
     m_fileName = m_fileInfo->fileName();
+    if ( Tools::Title::isTitle( m_fileName ) == true )
+        m_fileType = Title;
+    else if ( Tools::Multicam::isMulticam( m_fileName ) == true )
+        m_fileType = Multicam;
+    else if ( Tools::NestedSequence::isNestedSequence( m_fileName ) == true )
+        m_fileType = NestedSequence;
+    else if ( QDir::match( ImageExtensions, m_fileName.section( '?', 0, 0 ) ) == true )
+        m_fileType = Image;
+    else if ( QDir::match( VideoExtensions, m_fileName ) == false &&
+              QDir::match( AudioExtensions, m_fileName ) == true )
+        m_fileType = Audio;
+    else
+        m_fileType = Video;
     m_mrl = "file:///" + QUrl::toPercentEncoding( filePath, "/" );
+}
 
-    m_input.reset( new Backend::MLT::MLTInput( qPrintable( filePath ) ) );
+void
+Media::setFilePath( const QString &filePath )
+{
+    setFileInfo( filePath );
+    m_input = openInput( filePath );
+    m_audioInput.reset();
+    m_retimedInputs.clear();
+    m_conformedVideo.clear();
+    updateInfo();
+}
+
+bool
+Media::isProxied( const QString& path )
+{
+    return Backend::instance()->proxies().count( path.toStdString() ) != 0;
+}
+
+std::unique_ptr<Backend::IInput>
+Media::openInput( const QString& path )
+{
+    Tools::MediaIO::Timer   timer( path, Tools::MediaIO::Probe );
+    // The proxy is the file which gets decoded, it has to be opened right away.
+    // So are images and titles, which are drawn once and for all anyway, multicam
+    // clips, whose angles are only opened once shown, and nested sequences.
+    if ( isProxied( path ) == true || Backend::MLT::MLTInput::isImage( qPrintable( path ) ) == true ||
+         Backend::MLT::MLTInput::isTitle( qPrintable( path ) ) == true ||
+         Backend::MLT::MLTInput::isMulticam( qPrintable( path ) ) == true ||
+         Backend::MLT::MLTInput::isNestedSequence( qPrintable( path ) ) == true )
+        return std::unique_ptr<Backend::IInput>( new Backend::MLT::MLTInput( qPrintable( path ) ) );
+    auto info = probe( path );
+    return std::unique_ptr<Backend::IInput>( new Backend::MLT::MLTInput( qPrintable( path ), info.properties ) );
+}
+
+Backend::MediaInfo
+Media::probe( const QString& path )
+{
+    Backend::MediaInfo  info;
+    auto cache = Core::instance()->probeCache();
+    if ( cache->find( path, info ) == true )
+        return info;
+    info = Backend::instance()->probe( qPrintable( path ) );
+    cache->insert( path, info );
+    return info;
 }
 
 #ifdef HAVE_GUI
@@ -148,16 +523,57 @@ Media::snapshot()
     if ( Media::defaultSnapshot == nullptr )
         Media::defaultSnapshot = new QPixmap( ":/images/vlmc" );
 
-    if ( m_snapshot.isNull() == true ) {
-        int height = 200;
-        int width = height * m_input->aspectRatio();
-        m_input->setPosition( m_input->length() / 3 );
-        QImage img( m_input->image( width, height ), width, height,
-                    QImage::Format_RGBA8888, []( void* buf ){ delete[] (uchar*) buf; } );
-        m_input->setPosition( 0 );
-        m_snapshot.convertFromImage( img );
-    }
+    if ( m_snapshot.isNull() == true )
+        requestSnapshot();
 
     return m_snapshot.isNull() ? *Media::defaultSnapshot : m_snapshot;
 }
+
+void
+Media::requestSnapshot()
+{
+    // The thumbnail is requested again when painted, once the file is open
+    if ( m_snapshotRequest || m_placeholder == true )
+        return;
+
+    int height = 200;
+    int width = height * m_input->aspectRatio();
+    auto path = m_fileInfo->absoluteFilePath();
+    auto service = Core::instance()->thumbnailService();
+    // Only listen while the request is pending, as the service is shared by every media
+    m_snapshotRequest = connect( service, &ThumbnailService::thumbnailReady, this,
+                                 [this, path]( const QString& id, qint64, const QImage& image )
+    {
+        if ( id != path )
+            return;
+        snapshotDone();
+        if ( m_snapshot.isNull() == false )
+            snapshots().remove( snapshotSize( m_snapshot ) );
+        m_snapshot.convertFromImage( image );
+        snapshots().add( snapshotSize( m_snapshot ) );
+        emit snapshotAvailable();
+    } );
+    m_snapshotFailure = connect( service, &ThumbnailService::thumbnailFailed, this,
+                                 [this, path]( const QString& id, qint64 )
+    {
+        if ( id != path )
+            return;
+        snapshotDone();
+        vlmcWarning() << "Failed to decode the snapshot of" << path;
+        // Kept as the snapshot, so that it isn't requested again on each paint
+        m_snapshot = *Media::defaultSnapshot;
+        snapshots().add( snapshotSize( m_snapshot ) );
+        emit snapshotAvailable();
+    } );
+    service->request( path, path, m_input->length() / 3, width, height, ThumbnailService::High );
+}
+
+void
+Media::snapshotDone()
+{
+    disconnect( m_snapshotRequest );
+    disconnect( m_snapshotFailure );
+    m_snapshotRequest = QMetaObject::Connection();
+    m_snapshotFailure = QMetaObject::Connection();
+}
 #endif
@@ -32,6 +32,7 @@
 
 #include "config.h"
 
+#include <map>
 #include <memory>
 
 #include <QString>
@@ -39,6 +40,10 @@
 #include <QFileInfo>
 #include <QXmlStreamWriter>
 
+#include "Backend/IBackend.h"
+#include "Tools/Loudness.h"
+#include "Workflow/FrameRateConformService.h"
+
 #ifdef HAVE_GUI
 #include <QPixmap>
 #include <QImage>
@@ -70,7 +75,13 @@ public:
     {
         Audio,
         Video,
-        Image
+        Image,
+        // Drawn by the backend, from a title file. \sa Tools::Title
+        Title,
+        // Synchronized angles, from a multicam file. \sa Tools::Multicam
+        Multicam,
+        // Clips rendered as a single one, from a sequence file. \sa Tools::NestedSequence
+        NestedSequence
     };
     static const QString        VideoExtensions;
     static const QString        AudioExtensions;
@@ -78,8 +89,43 @@ public:
     static const QString        streamPrefix;
 
     Media( const QString& path );
+    /**
+     *  \brief  Creates a media from an input that was already opened, possibly
+     *          from another thread.
+     */
+    Media( const QString& path, std::unique_ptr<Backend::IInput> input );
     virtual ~Media();
 
+    /**
+     *  \brief  Opens the input a media keeps around, from any thread.
+     *
+     *  The file is probed, and then only kept open once the input gets decoded: a media
+     *  which isn't played holds no demuxer. Throws InvalidServiceException if the file
+     *  can't be opened.
+     */
+    static std::unique_ptr<Backend::IInput>     openInput( const QString& path );
+    /**
+     *  \brief  Probes path, unless it was already and didn't change since.
+     *
+     *  The results are shared by every project opened by the process. \sa ProbeCache
+     */
+    static Backend::MediaInfo   probe( const QString& path );
+    /**
+     *  \brief  Creates a media standing for a file which is still being opened.
+     *
+     *  It shows a black picture lasting nbFrames, until setInput() gives it the file's
+     *  input. The timeline can be built from it meanwhile.
+     */
+    static Media*               createPlaceholder( const QString& path, qint64 nbFrames );
+    bool                        isPlaceholder() const;
+    /**
+     *  \brief  Replaces the input of a placeholder with the file's input.
+     *
+     *  The clips which were cut from the placeholder have to be cut again.
+     *  \sa     Clip::reloadInput()
+     */
+    void                        setInput( std::unique_ptr<Backend::IInput> input );
+
     const QFileInfo             *fileInfo() const;
     const QString               &mrl() const;
     const QString               &fileName() const;
@@ -105,29 +151,164 @@ public:
 
     QVariant                    toVariant() const;
 
+    /**
+     *  \brief     Overrides the global hardware decoding setting for this media.
+     *
+     *  \param      api     A decoding API, "none" to force software decoding, or an
+     *                      empty string to use the global setting.
+     *  Only affects the decoders opened afterward.
+     */
+    void                        setHardwareDecoding( const QString& api );
+    const QString&              hardwareDecoding() const;
+    /**
+     *  \brief     Overrides this media's share of the decode thread budget.
+     *
+     *  0 restores the share. Only affects the decoders opened afterward.
+     */
+    void                        setDecodeThreads( int threads );
+    int                         decodeThreads() const;
+
+    /**
+     *  \brief     How the media gets conformed to the project frame rate. It's only
+     *             kept here, the library requests the conforming.
+     *  \sa        FrameRateConformService
+     */
+    FrameRateConformService::Mode   frameRateConform() const;
+    void                        setFrameRateConform( FrameRateConformService::Mode mode );
+    /**
+     *  \brief     Decodes the media from its conformed file at path, or from its own
+     *             file again if path is empty.
+     *
+     *  The conformed file lasts as long as the media at the project frame rate, so the
+     *  clips keep their boundaries, but they have to be cut again, as when a placeholder
+     *  gets replaced. The properties stay those of the media file.
+     *  Returns false if the file can't be opened, in which case nothing changes.
+     */
+    bool                        setConformedVideo( const QString& path );
+    const QString&              conformedVideo() const;
+
     Backend::IInput*         input();
     const Backend::IInput*   input() const;
+    /**
+     *  \brief     The properties of the media file, which are the original's even when
+     *             a proxy gets decoded instead.
+     */
+    const Backend::MediaInfo&   info() const;
+    /**
+     *  \brief     Returns an input on the same file with the video streams disabled,
+     *             opening it on first use.
+     *
+     *  Audio clips are cut from it, so that they don't pay for video decoding.
+     *  Returns nullptr if the media has no audio, or if it couldn't be opened.
+     */
+    Backend::IInput*         audioInput();
+    /**
+     *  \brief     Drops the audio only input, which gets opened again on next use.
+     *
+     *  The clips which were cut from it keep it alive as long as they need it.
+     */
+    void                        resetAudioInput();
+    /**
+     *  \brief     Returns an input on the same file played at speed, opening it on
+     *             first use. \sa Backend::MLT::MLTInput::retimed()
+     *
+     *  The clips whose speed was changed are cut from it. Returns nullptr for the
+     *  images and the placeholders, or if it couldn't be opened.
+     */
+    Backend::IInput*            retimedInput( double speed, bool frameBlending );
+    /**
+     *  \brief     The loudness of the media audio, invalid until it gets measured.
+     *
+     *  It's measured by the waveform service, along with the peaks, and saved with the
+     *  project so that rendering can normalize the media without analysing it again.
+     */
+    const Tools::Loudness&      loudness() const;
+    void                        setLoudness( const Tools::Loudness& loudness );
+    /**
+     *  \brief  Tells if the file is still being recorded, and gets longer.
+     *  \sa     Library::setGrowing()
+     */
+    bool                        isGrowing() const;
+    void                        setGrowing( bool growing );
+    /**
+     *  \brief  Extends the inputs to the new length of a growing file. The decoders
+     *          aren't opened again.
+     *
+     *  \param  length  In frames, as probed. Returns false if it isn't longer.
+     */
+    bool                        grow( qint64 length );
+    /**
+     *  \brief  Scales the length of the inputs by ratio, once the project frame rate
+     *          changed. The decoders aren't opened again.
+     */
+    void                        rescale( double ratio );
+    /**
+     *  \brief  The frames per second the original file decodes at on this machine, at
+     *          the project size. 0 until it gets measured. \sa DecodeBenchmarkService
+     */
+    double                      decodeSpeed() const;
+    void                        setDecodeSpeed( double speed );
 
 #ifdef HAVE_GUI
-    // This has to be called from the GUI thread.
+    /**
+     *  \brief     Returns the media snapshot, or a placeholder while it's being computed.
+     *
+     *  The snapshot is decoded asynchronously by the thumbnail service, and
+     *  snapshotAvailable() is emitted once it's ready, or once it failed, in which case
+     *  the placeholder is kept as the snapshot.
+     *  This has to be called from the GUI thread.
+     */
     QPixmap&                    snapshot();
 #endif
 protected:
+    // A placeholder
+    Media( const QString& path, qint64 nbFrames );
+#ifdef HAVE_GUI
+    void                        requestSnapshot();
+    // Stops listening to the thumbnail service
+    void                        snapshotDone();
+#endif
+    // Updates the path, but not the inputs
+    void                        setFileInfo( const QString& path );
+    void                        setLength( qint64 length );
+    void                        updateInfo();
+    static bool                 isProxied( const QString& path );
+
     std::unique_ptr<Backend::IInput>         m_input;
+    std::unique_ptr<Backend::IInput>         m_audioInput;
+    // By speed and frame blending. Dropped along with the audio input
+    std::map<std::pair<double, bool>, std::unique_ptr<Backend::IInput>>  m_retimedInputs;
     QString                     m_mrl;
     QFileInfo*                  m_fileInfo;
     FileType                    m_fileType;
     QString                     m_fileName;
     Clip*                       m_baseClip;
+    QString                     m_hardwareDecoding;
+    int                         m_decodeThreads;
+    FrameRateConformService::Mode   m_frameRateConform;
+    // Empty unless the media decodes its conformed file
+    QString                     m_conformedVideo;
+    Backend::MediaInfo          m_info;
+    Tools::Loudness             m_loudness;
+    bool                        m_placeholder;
+    bool                        m_growing;
+    double                      m_decodeSpeed;
 
 #ifdef HAVE_GUI
     static QPixmap*             defaultSnapshot;
     QPixmap                     m_snapshot;
+    QMetaObject::Connection     m_snapshotRequest;
+    QMetaObject::Connection     m_snapshotFailure;
 #endif
 
 signals:
     void                        metaDataComputed();
     void                        snapshotAvailable();
+    /**
+     *  \brief  Emitted once a growing file got longer, before its clips are extended.
+     */
+    void                        lengthChanged( qint64 oldLength, qint64 newLength );
+    void                        decodeSpeedChanged();
 };
 
 #endif // MEDIA_H__
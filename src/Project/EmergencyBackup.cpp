@@ -0,0 +1,111 @@
+/*****************************************************************************
+ * EmergencyBackup.cpp: Project snapshot written from a signal handler
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "EmergencyBackup.h"
+
+#include <QFile>
+#include <QMutexLocker>
+
+#ifdef Q_OS_UNIX
+# include <cerrno>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+EmergencyBackup::EmergencyBackup()
+    : m_current( nullptr )
+    , m_generation( 0 )
+{
+}
+
+EmergencyBackup::~EmergencyBackup()
+{
+    delete m_current.exchange( nullptr );
+}
+
+void
+EmergencyBackup::update( quint64 generation, const QString& fileName, const QByteArray& data )
+{
+    // Built outside of the lock, data is only copied by reference
+    auto snapshot = new Snapshot{ QFile::encodeName( fileName ).toStdString(),
+                                  QFile::encodeName( fileName + ".tmp" ).toStdString(), data };
+    QMutexLocker    lock( &m_mutex );
+    if ( generation <= m_generation )
+    {
+        delete snapshot;
+        return;
+    }
+    m_generation = generation;
+    publish( snapshot );
+}
+
+void
+EmergencyBackup::clear( quint64 generation )
+{
+    QMutexLocker    lock( &m_mutex );
+    if ( generation > m_generation )
+        m_generation = generation;
+    publish( nullptr );
+}
+
+void
+EmergencyBackup::publish( Snapshot* snapshot )
+{
+    m_previous.reset( m_current.exchange( snapshot ) );
+}
+
+bool
+EmergencyBackup::write() const
+{
+#ifdef Q_OS_UNIX
+    const Snapshot* snapshot = m_current.load();
+    if ( snapshot == nullptr )
+        return false;
+    auto fd = ::open( snapshot->tmpFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if ( fd < 0 )
+        return false;
+    auto data = snapshot->data.constData();
+    auto left = static_cast<size_t>( snapshot->data.size() );
+    while ( left > 0 )
+    {
+        auto written = ::write( fd, data, left );
+        if ( written < 0 )
+        {
+            if ( errno == EINTR )
+                continue;
+            ::close( fd );
+            ::unlink( snapshot->tmpFileName.c_str() );
+            return false;
+        }
+        data += written;
+        left -= static_cast<size_t>( written );
+    }
+    if ( ::close( fd ) != 0 )
+    {
+        ::unlink( snapshot->tmpFileName.c_str() );
+        return false;
+    }
+    return ::rename( snapshot->tmpFileName.c_str(), snapshot->fileName.c_str() ) == 0;
+#else
+    return false;
+#endif
+}
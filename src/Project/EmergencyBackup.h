@@ -0,0 +1,85 @@
+/*****************************************************************************
+ * EmergencyBackup.h: Project snapshot written from a signal handler
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef EMERGENCYBACKUP_H
+#define EMERGENCYBACKUP_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+/**
+ *  \brief  Pre-serialized copy of the project, which a signal handler can write.
+ *
+ *  The project is serialized ahead of time, after it was edited, so that saving it once
+ *  crashed only takes async-signal-safe calls: no allocation, no lock, no Qt.
+ *  Each snapshot comes with a generation, and the ones older than the current one are
+ *  dropped, as they can be encoded out of order.
+ */
+class EmergencyBackup
+{
+    public:
+        EmergencyBackup();
+        ~EmergencyBackup();
+
+        /**
+         *  \brief  Publishes a new snapshot, to be written to fileName.
+         *
+         *  Can be called from any thread.
+         */
+        void            update( quint64 generation, const QString& fileName, const QByteArray& data );
+        /**
+         *  \brief  Drops the snapshot, and the ones older than generation still to come.
+         */
+        void            clear( quint64 generation );
+        /**
+         *  \brief  Writes the last snapshot to its file.
+         *
+         *  This is async-signal-safe. The snapshot is written next to its file, and renamed
+         *  over it, so that a failed write doesn't destroy a previous backup.
+         *  \returns    false if there is no snapshot, or it couldn't be written.
+         */
+        bool            write() const;
+
+    private:
+        struct Snapshot
+        {
+            std::string     fileName;
+            std::string     tmpFileName;
+            QByteArray      data;
+        };
+
+        void            publish( Snapshot* snapshot );
+
+    private:
+        std::atomic<Snapshot*>      m_current;
+        // The one replaced last, kept alive for a handler which could still be writing it
+        std::unique_ptr<Snapshot>   m_previous;
+        quint64                     m_generation;
+        QMutex                      m_mutex;
+};
+
+#endif // EMERGENCYBACKUP_H
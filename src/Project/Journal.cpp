@@ -0,0 +1,169 @@
+/*****************************************************************************
+ * Journal.cpp: Append-only log of the sequence edits
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "Journal.h"
+
+#include "Tools/VlmcDebug.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+Journal::Journal()
+{
+}
+
+Journal::~Journal()
+{
+    close();
+}
+
+QString
+Journal::fileName( const QString& projectFile )
+{
+    return projectFile + ".journal";
+}
+
+bool
+Journal::open( const QString& fileName )
+{
+    close();
+    m_file.setFileName( fileName );
+    if ( m_file.open( QFile::ReadWrite | QFile::Append ) == false )
+    {
+        vlmcWarning() << "Failed to open journal" << fileName << ':' << m_file.errorString();
+        return false;
+    }
+    // A crash while appending leaves a record without its end of line
+    auto size = m_file.size();
+    if ( size > 0 && m_file.seek( size - 1 ) == true && m_file.peek( 1 ) != "\n" )
+    {
+        m_file.seek( 0 );
+        auto end = m_file.readAll().lastIndexOf( '\n' ) + 1;
+        vlmcWarning() << "Dropping a torn record at the end of journal" << fileName;
+        m_file.resize( end );
+    }
+    return true;
+}
+
+void
+Journal::close()
+{
+    if ( m_file.isOpen() == true )
+        m_file.close();
+}
+
+void
+Journal::remove()
+{
+    close();
+    if ( m_file.fileName().isEmpty() == false )
+        m_file.remove();
+}
+
+bool
+Journal::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+bool
+Journal::append( quint64 seq, const QVariantHash& record )
+{
+    if ( m_file.isOpen() == false )
+        return false;
+    auto object = QJsonObject::fromVariantHash( record );
+    object.insert( "seq", QString::number( seq ) );
+    auto line = QJsonDocument( object ).toJson( QJsonDocument::Compact );
+    line += '\n';
+    if ( m_file.write( line ) != line.size() || m_file.flush() == false )
+    {
+        vlmcWarning() << "Failed to append to journal" << m_file.fileName() << ':' << m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QList<QByteArray>
+Journal::read( const QString& fileName )
+{
+    QList<QByteArray>   lines;
+    QFile   file( fileName );
+    if ( file.open( QFile::ReadOnly ) == false )
+        return lines;
+    for ( const auto& line : file.readAll().split( '\n' ) )
+    {
+        if ( line.isEmpty() == false )
+            lines << line;
+    }
+    return lines;
+}
+
+QList<Journal::Record>
+Journal::records( quint64 seq ) const
+{
+    QList<Record>           res;
+    for ( const auto& line : read( m_file.fileName() ) )
+    {
+        QJsonParseError error;
+        auto doc = QJsonDocument::fromJson( line, &error );
+        if ( error.error != QJsonParseError::NoError )
+        {
+            vlmcWarning() << "Ignoring a corrupted journal record:" << error.errorString();
+            break;
+        }
+        auto changes = doc.object().toVariantHash();
+        auto recordSeq = changes.take( "seq" ).toString().toULongLong();
+        if ( recordSeq > seq )
+            res << Record{ recordSeq, changes };
+    }
+    return res;
+}
+
+bool
+Journal::compact( quint64 seq )
+{
+    auto fileName = m_file.fileName();
+    if ( fileName.isEmpty() == true )
+        return false;
+    QSaveFile   file( fileName );
+    if ( file.open( QFile::WriteOnly ) == false )
+        return false;
+    for ( const auto& line : read( fileName ) )
+    {
+        auto doc = QJsonDocument::fromJson( line );
+        if ( doc.isNull() == true )
+            break;
+        if ( doc.object()["seq"].toString().toULongLong() <= seq )
+            continue;
+        file.write( line );
+        file.write( "\n" );
+    }
+    auto wasOpen = m_file.isOpen();
+    close();
+    auto ret = file.commit();
+    if ( ret == false )
+        vlmcWarning() << "Failed to compact journal" << fileName << ':' << file.errorString();
+    if ( wasOpen == true )
+        open( fileName );
+    return ret;
+}
@@ -0,0 +1,85 @@
+/*****************************************************************************
+ * Journal.h: Append-only log of the sequence edits
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QVariantHash>
+
+/**
+ *  \brief  Append-only log of the edits made since the last snapshot of a project.
+ *
+ *  Each record is a line of compact JSON, flushed as soon as it's appended, so that
+ *  saving an edit costs as much as the edit itself rather than the whole project.
+ *  Records are numbered: a snapshot stores the number of the last record it includes,
+ *  recovering is replaying the records which follow it, and compacting is dropping
+ *  the ones it includes.
+ */
+class Journal
+{
+    public:
+        struct Record
+        {
+            quint64         seq;
+            QVariantHash    changes;
+        };
+
+        Journal();
+        ~Journal();
+
+        // The journal of the project saved in projectFile
+        static QString          fileName( const QString& projectFile );
+
+        /**
+         *  \brief  Opens the journal, creating it if needed.
+         *
+         *  Records get appended after the existing ones. A torn record at the end is
+         *  dropped first, so that it doesn't hide the records appended after it.
+         */
+        bool                    open( const QString& fileName );
+        void                    close();
+        // Closes and deletes the journal
+        void                    remove();
+        bool                    isOpen() const;
+
+        bool                    append( quint64 seq, const QVariantHash& record );
+        /**
+         *  \brief  Returns the records numbered after seq, in order.
+         *
+         *  The numbering goes on from the last one, once they are replayed.
+         *  A torn record at the end, left by a crash while appending, is ignored.
+         */
+        QList<Record>           records( quint64 seq ) const;
+        // Drops the records numbered up to seq, once a snapshot includes them
+        bool                    compact( quint64 seq );
+
+    private:
+        static QList<QByteArray>    read( const QString& fileName );
+
+    private:
+        QFile                   m_file;
+};
+
+#endif // JOURNAL_H
@@ -30,40 +30,88 @@
 #include <QFileInfo>
 #include <QTimer>
 
+#include <atomic>
 
 #include "Backend/IBackend.h"
 #include "Backend/IProfile.h"
+#include "EmergencyBackup.h"
+#include "Journal.h"
+#include "Main/Core.h"
 #include "Project.h"
 #include "RecentProjects.h"
 #include "Settings/Settings.h"
 #include "Tools/VlmcDebug.h"
+#include "Workflow/MainWorkflow.h"
 
 const QString   Project::unNamedProject = Project::tr( "Untitled Project" );
 const QString   Project::backupSuffix = "~";
 
-Project::Project( Settings* settings )
+namespace
+{
+
+// Edits usually come in bursts, there's no point in serializing the project for each of them
+const int       EmergencyBackupDelay = 1000;
+// The one of the active project, for the signal handlers
+std::atomic<const EmergencyBackup*>     s_emergencyBackup( nullptr );
+
+// The format of the new project files
+Settings::Format
+preferredFormat()
+{
+    if ( Core::instance()->settings()->value( "vlmc/BinaryProjects" )->get().toBool() == true )
+        return Settings::Binary;
+    return Settings::Json;
+}
+
+}
+
+Project::Project( Settings* settings, Tools::JobScheduler* scheduler )
     : m_projectFile( nullptr )
     , m_isClean( true )
+    , m_loading( false )
     , m_libraryCleanState( true )
     , m_timer( new QTimer( this ) )
+    , m_backupTimer( new QTimer( this ) )
+    , m_emergencyBackup( new EmergencyBackup )
+    , m_backupGeneration( 0 )
+    , m_scheduler( scheduler )
     , m_settings( new Settings )
 {
     initSettings();
 
+    // Application wide: the projects open side by side share them, the first one creates them
     SettingValue    *automaticBackup = settings->createVar( SettingValue::Bool, "vlmc/AutomaticBackup", false,
                                      QT_TRANSLATE_NOOP( "PreferenceWidget", "Automatic save" ),
                                      QT_TRANSLATE_NOOP( "PreferenceWidget", "When this option is activated,"
                                                          "VLMC will automatically save your project "
                                                          "at a specified interval" ), SettingValue::Nothing );
+    if ( automaticBackup == nullptr )
+        automaticBackup = settings->value( "vlmc/AutomaticBackup" );
     SettingValue    *automaticBackupInterval = settings->createVar( SettingValue::Int, "vlmc/AutomaticBackupInterval", 5,
                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Automatic save interval" ),
                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "This is the interval that VLMC will wait "
                                                        "between two automatic save" ), SettingValue::Clamped );
-    automaticBackupInterval->setLimits( 1, QVariant( QVariant::Invalid ) );
+    if ( automaticBackupInterval != nullptr )
+        automaticBackupInterval->setLimits( 1, QVariant( QVariant::Invalid ) );
+    else
+        automaticBackupInterval = settings->value( "vlmc/AutomaticBackupInterval" );
+    settings->createVar( SettingValue::Bool, "vlmc/BinaryProjects", false,
+                         QT_TRANSLATE_NOOP( "PreferenceWidget", "Save projects in binary format" ),
+                         QT_TRANSLATE_NOOP( "PreferenceWidget", "Binary projects load faster, but can't "
+                                            "be edited as text. Existing projects keep their format" ),
+                         SettingValue::Nothing );
 
     connect( m_timer, &QTimer::timeout, this, &Project::autoSaveRequired );
     connect( this, &Project::destroyed, m_timer, &QTimer::stop );
 
+    m_backupTimer->setSingleShot( true );
+    m_backupTimer->setInterval( EmergencyBackupDelay );
+    connect( m_backupTimer, &QTimer::timeout, this, &Project::refreshEmergencyBackup );
+    connect( this, &Project::projectLoaded, this, &Project::scheduleEmergencyBackup );
+    // The first project is the active one, ProjectManager activates the others
+    const EmergencyBackup* none = nullptr;
+    s_emergencyBackup.compare_exchange_strong( none, m_emergencyBackup );
+
     connect( automaticBackup, &SettingValue::changed,
              this, &Project::autoSaveEnabledChanged );
     connect( automaticBackupInterval, &SettingValue::changed,
@@ -72,6 +120,12 @@ Project::Project( Settings* settings )
 
 Project::~Project()
 {
+    m_scheduler->cancel( m_backupToken );
+    m_scheduler->wait( m_backupToken );
+    // Another project may be the one backed up by now
+    const EmergencyBackup* self = m_emergencyBackup;
+    s_emergencyBackup.compare_exchange_strong( self, nullptr );
+    delete m_emergencyBackup;
     delete m_projectFile;
     delete m_settings;
     delete m_timer;
@@ -134,17 +188,23 @@ Project::load( const QString& path )
         m_settings->setSettingsFile( path );
     }
 
+    m_loading = true;
     m_settings->load();
+    m_loading = false;
+    // Replays the edits made after the snapshot we just loaded, if we crashed
+    auto journaled = Core::instance()->workflow()->openJournal( Journal::fileName( path ) );
+    if ( journaled > 0 )
+        vlmcDebug() << "Recovered" << journaled << "edits from the journal";
     auto projectName = m_settings->value( "vlmc/ProjectName" )->get().toString();
     emit projectLoading( projectName );
-    m_isClean = autoBackupFound == false;
+    m_isClean = autoBackupFound == false && journaled == 0;
     emit cleanStateChanged( m_isClean );
     if ( autoBackupFound == false )
         m_projectFile->close();
     emit projectLoaded( projectName, path );
     if ( outdatedBackupFound == true )
         emit outdatedBackupFileFound();
-    if ( autoBackupFound == true )
+    if ( autoBackupFound == true || journaled > 0 )
         emit backupProjectLoaded();
     return true;
 }
@@ -161,6 +221,8 @@ Project::saveAs( const QString& fileName )
 {
     delete m_projectFile;
     m_projectFile = new QFile( fileName );
+    Core::instance()->workflow()->resetJournal( Journal::fileName( fileName ) );
+    m_settings->setFormat( preferredFormat() );
     saveProject( fileName );
     emit projectSaved();
 }
@@ -171,6 +233,8 @@ Project::newProject( const QString& projectName, const QString& projectFilePath
     closeProject();
     m_settings->setValue( "vlmc/ProjectName", projectName );
     m_projectFile = new QFile( projectFilePath );
+    Core::instance()->workflow()->resetJournal( Journal::fileName( projectFilePath ) );
+    m_settings->setFormat( preferredFormat() );
     save();
 }
 
@@ -186,12 +250,23 @@ Project::initSettings()
                              QT_TRANSLATE_NOOP( "PreferenceWidget", "Video width" ),
                              QT_TRANSLATE_NOOP( "PreferenceWidget", "Width resolution of the output video" ),
                              SettingValue::Clamped | SettingValue::EightMultiple );
-    width->setLimits( 32, 2048 );
+    width->setLimits( 32, 8192 );
     SettingValue    *height = m_settings->createVar( SettingValue::Int, "video/VideoProjectHeight", 320,
                              QT_TRANSLATE_NOOP( "PreferenceWidget", "Video height" ),
                              QT_TRANSLATE_NOOP( "PreferenceWidget", "Height resolution of the output video" ),
                              SettingValue::Clamped | SettingValue::EightMultiple );
-    height->setLimits( 32, 2048 );
+    height->setLimits( 32, 8192 );
+    SettingValue    *previewScale = m_settings->createVar( SettingValue::Int, "video/PreviewScale", 1,
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Preview scale" ),
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Divides the resolution the preview is rendered at: 1, 2, 4 or 8. "
+                                                "Exports always use the full resolution" ),
+                             SettingValue::Clamped );
+    previewScale->setLimits( 1, 8 );
+    m_settings->createVar( SettingValue::String, "video/Transition", "dissolve",
+                                QT_TRANSLATE_NOOP( "PreferenceWidget", "Transitions" ),
+                                QT_TRANSLATE_NOOP( "PreferenceWidget", "How overlapping clips of two tracks are blended: "
+                                                   "dissolve, wipe or none. Their audio is always cross faded" ),
+                                SettingValue::Nothing );
     m_settings->createVar( SettingValue::String, "video/AspectRatio", "16/9",
                                 QT_TRANSLATE_NOOP("PreferenceWidget", "Video aspect ratio" ),
                                 QT_TRANSLATE_NOOP("PreferenceWidget", "The rendered video aspect ratio" ),
@@ -210,34 +285,132 @@ Project::initSettings()
                              QT_TRANSLATE_NOOP( "PreferenceWidget", "Video bitrate" ),
                              QT_TRANSLATE_NOOP( "PreferenceWidget", "Output project Video bitrate (kbps)"),
                              SettingValue::Clamped );
-    vBitRate->setLimits( 8, 8192 );
+    // UHD exports commonly need several dozens of Mbps
+    vBitRate->setLimits( 8, 200000 );
+    m_settings->createVar( SettingValue::String, "video/VideoCodec", "",
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Video codec" ),
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Encoder used when rendering. Empty to use the container's default" ),
+                             SettingValue::Nothing );
+    m_settings->createVar( SettingValue::String, "video/EncoderPreset", "",
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Encoder preset" ),
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Speed/quality preset of the encoder, such as \"fast\" or \"slow\"" ),
+                             SettingValue::Nothing );
+    SettingValue    *encoderThreads = m_settings->createVar( SettingValue::Int, "video/EncoderThreads", 0,
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Encoder threads" ),
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Threads used by the encoder, 0 for automatic" ),
+                             SettingValue::Clamped );
+    encoderThreads->setLimits( 0, 64 );
+    SettingValue    *renderThreads = m_settings->createVar( SettingValue::Int, "video/RenderThreads", 1,
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Rendering threads" ),
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Threads used to render the frames before encoding them" ),
+                             SettingValue::Clamped );
+    renderThreads->setLimits( 1, 64 );
+    m_settings->createVar( SettingValue::Bool, "video/DropFrames", false,
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Drop frames" ),
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Drop frames to render in real time, instead of rendering as fast as possible" ),
+                             SettingValue::Nothing );
+    SettingValue    *gopSize = m_settings->createVar( SettingValue::Int, "video/GopSize", 0,
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Keyframe interval" ),
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Maximum number of frames between two keyframes, 0 for the encoder default" ),
+                             SettingValue::Clamped );
+    gopSize->setLimits( 0, 1000 );
+    m_settings->createVar( SettingValue::Bool, "video/TwoPass", false,
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Two pass encoding" ),
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Analyze the video before encoding it, to spend the bitrate where it is needed" ),
+                             SettingValue::Nothing );
     SettingValue    *audioChannel = m_settings->createVar( SettingValue::Int, "audio/NbChannels", 2,
                                                              QT_TRANSLATE_NOOP("PreferenceWidget", "Audio channels" ),
                                                              QT_TRANSLATE_NOOP("PreferenceWidget", "Number of audio channels" ),
                                                              SettingValue::Clamped );
     audioChannel->setLimits( 2, 2 );
+    m_settings->createVar( SettingValue::Bool, "audio/NormalizeLoudness", false,
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Normalize loudness" ),
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Bring the audio of each media to the target loudness when rendering" ),
+                             SettingValue::Nothing );
+    SettingValue    *loudnessTarget = m_settings->createVar( SettingValue::Double, "audio/LoudnessTarget", -23.0,
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Target loudness" ),
+                             QT_TRANSLATE_NOOP( "PreferenceWidget", "Integrated loudness of the normalized medias (LUFS). EBU R128 recommends -23" ),
+                             SettingValue::Clamped );
+    loudnessTarget->setLimits( -40, -5 );
     SettingValue    *pName = m_settings->createVar( SettingValue::String, "vlmc/ProjectName", unNamedProject,
                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Project name" ),
                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "The project name" ),
                                     SettingValue::NotEmpty );
     connect( pName, SIGNAL( changed( QVariant ) ), this, SLOT( projectNameChanged( QVariant ) ) );
     connect( fps, &SettingValue::changed, this, [this]( const QVariant& var ){ emit fpsChanged( var.toDouble() ); } );
+    auto sizeChanged = [this]{ emit resolutionChanged( this->width(), this->height() ); };
+    connect( width, &SettingValue::changed, this, sizeChanged );
+    connect( height, &SettingValue::changed, this, sizeChanged );
 }
 
 void
-Project::saveProject( const QString& fileName )
+Project::saveProject( const QString& fileName, bool async )
 {
     m_settings->setSettingsFile( fileName );
-    m_settings->save();
+    m_settings->save( async );
     emit projectSaved();
 }
 
-void
+bool
 Project::emergencyBackup()
 {
-    const QString& name = m_projectFile->fileName() + Project::backupSuffix;
-    saveProject( name );
-    Core::instance()->settings()->setValue( "private/EmergencyBackup", name );
+    auto backup = s_emergencyBackup.load();
+    return backup != nullptr && backup->write();
+}
+
+void
+Project::setEmergencyBackupActive()
+{
+    s_emergencyBackup = m_emergencyBackup;
+    if ( m_projectFile != nullptr )
+    {
+        // Points the setting at this project's backup, and makes sure it's up to date
+        refreshEmergencyBackup();
+        return;
+    }
+    auto lastBackup = Core::instance()->settings()->value( "private/EmergencyBackup" );
+    if ( lastBackup != nullptr )
+        lastBackup->set( QString() );
+}
+
+bool
+Project::isEmergencyBackupActive() const
+{
+    return s_emergencyBackup.load() == m_emergencyBackup;
+}
+
+void
+Project::scheduleEmergencyBackup()
+{
+    if ( m_projectFile != nullptr )
+        m_backupTimer->start();
+}
+
+void
+Project::refreshEmergencyBackup()
+{
+    if ( m_projectFile == nullptr )
+        return;
+    const QString name = m_projectFile->fileName() + Project::backupSuffix;
+    // The signal handler can't update it, it's known for as long as the snapshot is.
+    // It's a GUI preference, which doesn't exist when rendering from the console.
+    // The projects in the background keep their backup current, but the setting
+    // names the active one's.
+    auto lastBackup = Core::instance()->settings()->value( "private/EmergencyBackup" );
+    if ( lastBackup != nullptr && isEmergencyBackupActive() == true && lastBackup->get().toString() != name )
+        lastBackup->set( name );
+
+    // The settings are only read from here, the encoding is what takes time
+    auto doc = m_settings->snapshot();
+    auto format = m_settings->format();
+    auto generation = ++m_backupGeneration;
+    m_scheduler->schedule( Tools::JobScheduler::Background,
+                           [this, doc, format, generation, name]( const Tools::JobScheduler::CancellationToken& token )
+    {
+        if ( token.isCanceled() == true )
+            return;
+        m_emergencyBackup->update( generation, name, Settings::encode( doc, format ) );
+    }, m_backupToken );
 }
 
 bool
@@ -251,7 +424,14 @@ Project::closeProject()
 {
     if ( m_projectFile == nullptr )
         return;
+    m_backupTimer->stop();
+    m_emergencyBackup->clear( ++m_backupGeneration );
+    auto lastBackup = Core::instance()->settings()->value( "private/EmergencyBackup" );
+    if ( lastBackup != nullptr && isEmergencyBackupActive() == true )
+        lastBackup->set( QString() );
+    m_loading = true;
     m_settings->restoreDefaultValues();
+    m_loading = false;
     emit projectClosed();
     delete m_projectFile;
     m_projectFile = nullptr;
@@ -263,6 +443,18 @@ Project::hasProjectFile() const
     return m_projectFile != nullptr;
 }
 
+QString
+Project::fileName() const
+{
+    return m_projectFile != nullptr ? m_projectFile->fileName() : QString();
+}
+
+bool
+Project::isLoading() const
+{
+    return m_loading;
+}
+
 void
 Project::removeBackupFile()
 {
@@ -326,6 +518,44 @@ Project::nbChannels() const
     return m_settings->value( "audio/NbChannels" )->get().toUInt();
 }
 
+bool
+Project::normalizeLoudness() const
+{
+    return m_settings->value( "audio/NormalizeLoudness" )->get().toBool();
+}
+
+double
+Project::loudnessTarget() const
+{
+    return m_settings->value( "audio/LoudnessTarget" )->get().toDouble();
+}
+
+Backend::EncoderOptions
+Project::encoderOptions() const
+{
+    Backend::EncoderOptions options;
+    options.videoCodec = m_settings->value( "video/VideoCodec" )->get().toString().toStdString();
+    options.preset = m_settings->value( "video/EncoderPreset" )->get().toString().toStdString();
+    options.encoderThreads = m_settings->value( "video/EncoderThreads" )->get().toInt();
+    options.renderThreads = m_settings->value( "video/RenderThreads" )->get().toInt();
+    options.dropFrames = m_settings->value( "video/DropFrames" )->get().toBool();
+    options.gopSize = m_settings->value( "video/GopSize" )->get().toInt();
+    options.twoPass = m_settings->value( "video/TwoPass" )->get().toBool();
+    return options;
+}
+
+void
+Project::setEncoderOptions( const Backend::EncoderOptions& options )
+{
+    m_settings->value( "video/VideoCodec" )->set( QString::fromStdString( options.videoCodec ) );
+    m_settings->value( "video/EncoderPreset" )->set( QString::fromStdString( options.preset ) );
+    m_settings->value( "video/EncoderThreads" )->set( options.encoderThreads );
+    m_settings->value( "video/RenderThreads" )->set( options.renderThreads );
+    m_settings->value( "video/DropFrames" )->set( options.dropFrames );
+    m_settings->value( "video/GopSize" )->set( options.gopSize );
+    m_settings->value( "video/TwoPass" )->set( options.twoPass );
+}
+
 QFile*
 Project::emergencyBackupFile()
 {
@@ -363,7 +593,7 @@ Project::autoSaveRequired()
 {
     if ( m_projectFile == nullptr )
         return ;
-    saveProject( m_projectFile->fileName() + Project::backupSuffix );
+    saveProject( m_projectFile->fileName() + Project::backupSuffix, true );
 }
 
 
@@ -27,11 +27,15 @@
 
 #include <QObject>
 
+#include "Backend/IOutput.h"
+#include "Tools/JobScheduler.h"
+
 class QFile;
 class QString;
 class QTimer;
 
 class AutomaticBackup;
+class EmergencyBackup;
 class Library;
 class MainWorkflow;
 class ProjectManager;
@@ -46,7 +50,7 @@ class Project : public QObject
 
     public:
         Q_DISABLE_COPY( Project )
-        Project( Settings* settings );
+        Project( Settings* settings, Tools::JobScheduler* scheduler );
 
         virtual ~Project();
 
@@ -60,10 +64,31 @@ class Project : public QObject
          *                  an absolute file path.
          */
         bool            load( const QString& path );
-        void            emergencyBackup();
+        /**
+         *  \brief  Writes the last snapshot of the project to its backup file.
+         *
+         *  This is async-signal-safe: the project was serialized after its last edits
+         *  already, by scheduleEmergencyBackup(). It doesn't go through the Core instance
+         *  either, which could be allocated.
+         */
+        static bool     emergencyBackup();
+        /**
+         *  \brief  Makes this project the one emergencyBackup() writes, and the one
+         *          private/EmergencyBackup names. Only the active project is recovered
+         *          after a crash, when several are open. \sa ProjectManager
+         */
+        void            setEmergencyBackupActive();
+        bool            isEmergencyBackupActive() const;
         bool            isClean() const;
         void            closeProject();
         bool            hasProjectFile() const;
+        // Empty until the project is saved
+        QString         fileName() const;
+        /**
+         *  \brief  True while the settings are loaded, or restored to their defaults:
+         *          their changes then aren't edits of the project.
+         */
+        bool            isLoading() const;
         /**
          * @brief removeBackupFile Removes the current project backup file, if any
          */
@@ -79,13 +104,19 @@ class Project : public QObject
         unsigned int    videoBitrate() const;
         unsigned int    sampleRate() const;
         unsigned int    nbChannels() const;
+        bool            normalizeLoudness() const;
+        // In LUFS
+        double          loudnessTarget() const;
+        Backend::EncoderOptions encoderOptions() const;
+        void            setEncoderOptions( const Backend::EncoderOptions& options );
 
     public:
         static QFile* emergencyBackupFile();
 
     private:
         void                initSettings();
-        void                saveProject( const QString& filename );
+        void                saveProject( const QString& filename, bool async = false );
+        void                refreshEmergencyBackup();
 
 
     public slots:
@@ -95,6 +126,10 @@ class Project : public QObject
         void                autoSaveRequired();
         void                autoSaveEnabledChanged( const QVariant& enabled );
         void                autoSaveIntervalChanged( const QVariant& interval );
+        /**
+         *  \brief  Serializes the project again for emergencyBackup(), once the edits settle.
+         */
+        void                scheduleEmergencyBackup();
 
 
     signals:
@@ -120,17 +155,26 @@ class Project : public QObject
         void                cleanStateChanged( bool value );
 
         void                projectLoading( const QString& projectName );
+        // Number of medias of the project being loaded which are ready
+        void                projectLoadingProgress( int done, int total );
         void                projectLoaded( const QString& projectName, const QString& projectFilePath );
         void                projectClosed();
         void                backupProjectLoaded();
         void                outdatedBackupFileFound();
         void                fpsChanged( double fps );
+        void                resolutionChanged( unsigned int width, unsigned int height );
 
     private:
         QFile*              m_projectFile;
         bool                m_isClean;
+        bool                m_loading;
         bool                m_libraryCleanState;
         QTimer*             m_timer;
+        QTimer*             m_backupTimer;
+        EmergencyBackup*    m_emergencyBackup;
+        quint64             m_backupGeneration;
+        Tools::JobScheduler*        m_scheduler;
+        Tools::JobScheduler::CancellationToken  m_backupToken;
 
     ///////////////////////////////////
     // Dependent components part below:
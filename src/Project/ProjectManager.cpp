@@ -0,0 +1,199 @@
+/*****************************************************************************
+ * ProjectManager.cpp: The projects open side by side
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ProjectManager.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IProfile.h"
+#include "Library/Library.h"
+#include "Project.h"
+#include "Renderer/AbstractRenderer.h"
+#include "Tools/VlmcDebug.h"
+#include "Workflow/MainWorkflow.h"
+
+#include <QFileInfo>
+
+ProjectManager::ProjectManager( Factory factory )
+    : m_factory( std::move( factory ) )
+    , m_active( 0 )
+{
+    create();
+}
+
+ProjectManager::~ProjectManager()
+{
+    while ( m_sessions.isEmpty() == false )
+        destroy( m_sessions.count() - 1 );
+}
+
+int
+ProjectManager::count() const
+{
+    return m_sessions.count();
+}
+
+int
+ProjectManager::activeIndex() const
+{
+    return m_active;
+}
+
+const ProjectManager::Session&
+ProjectManager::session( int index ) const
+{
+    return m_sessions[index];
+}
+
+Project*
+ProjectManager::project() const
+{
+    return m_sessions[m_active].project;
+}
+
+Library*
+ProjectManager::library() const
+{
+    return m_sessions[m_active].library;
+}
+
+MainWorkflow*
+ProjectManager::workflow() const
+{
+    return m_sessions[m_active].workflow;
+}
+
+int
+ProjectManager::indexOf( const QString& fileName ) const
+{
+    auto path = QFileInfo( fileName ).absoluteFilePath();
+    for ( int i = 0; i < m_sessions.count(); ++i )
+    {
+        if ( m_sessions[i].project->hasProjectFile() == true &&
+             QFileInfo( m_sessions[i].project->fileName() ).absoluteFilePath() == path )
+            return i;
+    }
+    return -1;
+}
+
+bool
+ProjectManager::open( const QString& fileName )
+{
+    auto index = indexOf( fileName );
+    if ( index >= 0 )
+        return activate( index );
+    auto current = project();
+    if ( current->hasProjectFile() == false && current->isClean() == true )
+    {
+        auto res = current->load( fileName );
+        emit sessionsChanged();
+        return res;
+    }
+    auto previous = m_active;
+    auto fps = current->fps();
+    auto width = current->width();
+    auto height = current->height();
+    index = create();
+    // The components of the project look themselves up through Core while loading
+    activate( index );
+    auto loaded = project()->load( fileName );
+    if ( loaded == false || qFuzzyCompare( project()->fps(), fps ) == false ||
+         project()->width() != width || project()->height() != height )
+    {
+        if ( loaded == true )
+            vlmcWarning() << "Can't open" << fileName << "next to" << current->name()
+                          << ": their frame rates or resolutions differ";
+        activate( previous );
+        destroy( index );
+        emit sessionsChanged();
+        return false;
+    }
+    emit sessionsChanged();
+    return true;
+}
+
+bool
+ProjectManager::activate( int index )
+{
+    if ( index < 0 || index >= m_sessions.count() )
+        return false;
+    if ( index == m_active )
+        return true;
+    emit aboutToSwitch();
+    workflow()->renderer()->stop();
+    m_active = index;
+    applyProfile( project() );
+    project()->setEmergencyBackupActive();
+    emit activeChanged();
+    return true;
+}
+
+bool
+ProjectManager::close( int index )
+{
+    if ( index < 0 || index >= m_sessions.count() )
+        return false;
+    // Drops its journal and its backup, as closing the only project does
+    m_sessions[index].project->closeProject();
+    if ( m_sessions.count() == 1 )
+    {
+        emit sessionsChanged();
+        return true;
+    }
+    if ( index == m_active )
+        activate( index > 0 ? index - 1 : index + 1 );
+    destroy( index );
+    emit sessionsChanged();
+    return true;
+}
+
+int
+ProjectManager::create()
+{
+    auto session = m_factory();
+    connect( session.project, static_cast<void(Project::*)(const QString&)>( &Project::projectNameChanged ),
+             this, &ProjectManager::sessionsChanged );
+    m_sessions.append( session );
+    return m_sessions.count() - 1;
+}
+
+void
+ProjectManager::destroy( int index )
+{
+    Q_ASSERT( index != m_active || m_sessions.count() == 1 );
+    auto session = m_sessions.takeAt( index );
+    if ( index < m_active )
+        --m_active;
+    // In the order Core used to delete them in: the library's medias go first
+    delete session.library;
+    delete session.workflow;
+    delete session.project;
+}
+
+void
+ProjectManager::applyProfile( const Project* project )
+{
+    // The frames of the other projects keep their meaning, as they share the profile
+    auto& profile = Backend::instance()->profile();
+    profile.setFrameRate( project->fps() * 100, 100 );
+    profile.setWidth( project->width() );
+    profile.setHeight( project->height() );
+}
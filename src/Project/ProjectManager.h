@@ -0,0 +1,114 @@
+/*****************************************************************************
+ * ProjectManager.h: The projects open side by side
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef PROJECTMANAGER_H
+#define PROJECTMANAGER_H
+
+#include <QObject>
+#include <QList>
+
+#include <functional>
+
+class   Library;
+class   MainWorkflow;
+class   Project;
+
+/**
+ *  \brief  The projects open at once, each with its own library and workflow.
+ *
+ *  One of them is active: it is the one Core::project(), Core::library() and
+ *  Core::workflow() return, and the one the interface shows. The others stay loaded,
+ *  so that switching back to them doesn't open their medias again. The services, the
+ *  probe cache and the decoders are shared by all of them.
+ *
+ *  The backend has a single profile: the projects open side by side must have the
+ *  same frame rate and resolution.
+ */
+class ProjectManager : public QObject
+{
+    Q_OBJECT
+
+    public:
+        struct Session
+        {
+            Project*        project;
+            Library*        library;
+            MainWorkflow*   workflow;
+        };
+        // Creates the components of a project, connected to the shared services
+        using Factory = std::function<Session()>;
+
+        explicit ProjectManager( Factory factory );
+        ~ProjectManager();
+
+        int             count() const;
+        int             activeIndex() const;
+        const Session&  session( int index ) const;
+
+        Project*        project() const;
+        Library*        library() const;
+        MainWorkflow*   workflow() const;
+
+        // Returns the index of the project which has fileName open, -1 if none does
+        int             indexOf( const QString& fileName ) const;
+        /**
+         *  \brief  Loads fileName next to the projects open already, and makes it active.
+         *
+         *  A project which is open already is only made active. The active project is
+         *  used when it is empty and has no file yet.
+         *  \returns false if the project can't be loaded, or its frame rate or resolution
+         *          don't match the other projects'. The previous project is active again.
+         */
+        bool            open( const QString& fileName );
+        /**
+         *  \brief  Shows the project at index, in place of the active one.
+         *
+         *  The preview of the active project is stopped, and the backend profile takes
+         *  the frame rate and resolution of the project at index.
+         */
+        bool            activate( int index );
+        /**
+         *  \brief  Closes the project at index, without saving it, and deletes its
+         *          components. The last project is only closed, as Project::closeProject()
+         *          does.
+         */
+        bool            close( int index );
+
+    signals:
+        // Emitted before the active project changes, while the current one is still valid
+        void            aboutToSwitch();
+        void            activeChanged();
+        // A project was opened or closed, or its name changed
+        void            sessionsChanged();
+
+    private:
+        int             create();
+        void            destroy( int index );
+        void            applyProfile( const Project* project );
+
+    private:
+        Factory         m_factory;
+        QList<Session>  m_sessions;
+        int             m_active;
+};
+
+#endif // PROJECTMANAGER_H
@@ -44,10 +44,17 @@
 
 const QString   Workspace::workspacePrefix = "workspace://";
 
-Workspace::Workspace(Settings *settings)
-    : m_copyInProgress( false )
+Workspace::Workspace( Settings *settings, Tools::JobScheduler* scheduler )
+    : m_nbCopies( 0 )
+    , m_scheduler( scheduler )
 {
     settings->createVar( SettingValue::String, "vlmc/Workspace", "", "", "", SettingValue::Private );
+    m_verifyCopies = settings->createVar( SettingValue::Bool, "vlmc/VerifyWorkspaceCopies", true,
+                                          QT_TRANSLATE_NOOP( "Settings", "Verify the copies to the workspace" ),
+                                          QT_TRANSLATE_NOOP( "Settings", "Check the medias copied to the workspace "
+                                                             "against their original. The copy can't be "
+                                                             "offloaded to the file system then" ),
+                                          SettingValue::Nothing );
     SettingValue* workspaceDir = settings->value( "vlmc/Workspace" );
     connect(workspaceDir, SIGNAL( changed( QVariant ) ),
             this, SLOT( workspaceChanged( QVariant ) ) );
@@ -56,11 +63,16 @@ Workspace::Workspace(Settings *settings)
 #ifdef HAVE_GUI
     connect( this, SIGNAL( notify( QString ) ),
              NotificationZone::instance(), SLOT( notify( QString ) ) );
+    connect( this, SIGNAL( progressUpdated( int ) ),
+             NotificationZone::instance(), SLOT( progressUpdated( int ) ) );
 #endif
 }
 
 Workspace::~Workspace()
 {
+    // The interrupted copies remove what they wrote
+    m_scheduler->cancel( m_copies );
+    m_scheduler->wait( m_copies );
     delete m_mediasToCopyMutex;
 }
 
@@ -72,20 +84,33 @@ Workspace::copyToWorkspace( Media *media )
         setError( "There is no current workspace. Please create a project first.");
         return false;
     }
-    QMutexLocker    lock( m_mediasToCopyMutex );
-
-    if ( m_copyInProgress == true )
+    Q_ASSERT( this->isInWorkspace( media ) == false );
     {
+        QMutexLocker    lock( m_mediasToCopyMutex );
         m_mediasToCopy.enqueue( media );
     }
-    else
+    startCopies();
+    return true;
+}
+
+void
+Workspace::startCopies()
+{
+    for ( ;; )
     {
+        Media*  media;
+        {
+            QMutexLocker    lock( m_mediasToCopyMutex );
+            if ( m_nbCopies >= MaxCopies || m_mediasToCopy.isEmpty() == true )
+                return;
+            media = m_mediasToCopy.dequeue();
+            if ( isInWorkspace( media ) == true )
+                continue;
+            ++m_nbCopies;
+        }
         vlmcDebug() << "Copying media:" << media->fileInfo()->absoluteFilePath() << "to workspace.";
-        m_copyInProgress = true;
-        Q_ASSERT( this->isInWorkspace( media ) == false );
         startCopyWorker( media );
     }
-    return true;
 }
 
 void
@@ -103,16 +128,32 @@ Workspace::startCopyWorker( Media *media )
                                        QMessageBox::Yes | QMessageBox::No,
                                        QMessageBox::No );
         if ( b == QMessageBox::No )
+        {
             copyTerminated( media, dest );
+            return;
+        }
 #else
         copyTerminated( media, dest );
+        return;
 #endif
     }
-    WorkspaceWorker *worker = new WorkspaceWorker( media, dest );
-    //This one is direct connected since the thread is terminated just after emitting the signal.
+    WorkspaceWorker *worker = new WorkspaceWorker( media, dest, m_verifyCopies->get().toBool(),
+                                                   m_scheduler );
+    // Deleted along with the workspace if its job got dropped
+    worker->setParent( this );
+    // Queued, the media is updated from this thread
     connect( worker, SIGNAL( copied( Media*, QString ) ),
-             this, SLOT( copyTerminated( Media*, QString ) ), Qt::DirectConnection );
-    worker->start();
+             this, SLOT( copyTerminated( Media*, QString ) ) );
+    connect( worker, SIGNAL( failed( Media*, QString ) ),
+             this, SLOT( copyFailed( Media*, QString ) ) );
+    connect( worker, SIGNAL( progress( Media*, qint64, qint64 ) ),
+             this, SLOT( copyProgressed( Media*, qint64, qint64 ) ) );
+    m_scheduler->schedule( Tools::JobScheduler::Background,
+                           [worker]( const Tools::JobScheduler::CancellationToken& token )
+    {
+        worker->run( token );
+        worker->deleteLater();
+    }, m_copies );
 }
 
 void
@@ -134,22 +175,42 @@ Workspace::copyTerminated( Media *media, QString dest )
 
     media->setFilePath( dest );
     media->disconnect( this );
+    copyDone( media );
+}
 
-    QMutexLocker    lock( m_mediasToCopyMutex );
-    if ( m_mediasToCopy.size() > 0 )
+void
+Workspace::copyFailed( Media *media, QString dest )
+{
+    emit notify( tr( "Workspace: failed to copy " ) + media->fileInfo()->fileName() + tr( " to " ) + dest );
+    copyDone( media );
+}
+
+void
+Workspace::copyDone( Media* media )
+{
     {
-        while ( m_mediasToCopy.size() > 0 )
-        {
-            Media   *toCopy = m_mediasToCopy.dequeue();
-            if ( isInWorkspace( media ) == true )
-            {
-                startCopyWorker( toCopy );
-                break ;
-            }
-        }
+        QMutexLocker    lock( m_mediasToCopyMutex );
+        --m_nbCopies;
+    }
+    m_progress.remove( media );
+    startCopies();
+}
+
+void
+Workspace::copyProgressed( Media *media, qint64 done, qint64 total )
+{
+    m_progress[media] = qMakePair( done, total );
+    emit copyProgress( media, done, total );
+    // Every running copy, as a whole
+    qint64  allDone = 0;
+    qint64  allTotal = 0;
+    for ( const auto& p : m_progress )
+    {
+        allDone += p.first;
+        allTotal += p.second;
     }
-    else
-        m_copyInProgress = false;
+    if ( allTotal > 0 )
+        emit progressUpdated( static_cast<int>( allDone * 100 / allTotal ) );
 }
 
 void
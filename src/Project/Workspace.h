@@ -23,10 +23,13 @@
 #ifndef WORKSPACE_H
 #define WORKSPACE_H
 
+#include <QHash>
 #include <QObject>
+#include <QPair>
 #include <QQueue>
 
 #include "Tools/ErrorHandler.h"
+#include "Tools/JobScheduler.h"
 
 class   QMutex;
 class   QFileInfo;
@@ -34,6 +37,7 @@ class   QFileInfo;
 class   Clip;
 class   Media;
 class   Settings;
+class   SettingValue;
 
 class Workspace : public QObject, public ErrorHandler
 {
@@ -42,29 +46,46 @@ class Workspace : public QObject, public ErrorHandler
     public:
         static const QString        workspacePrefix;
 
-        Workspace( Settings* settings );
+        Workspace( Settings* settings, Tools::JobScheduler* scheduler );
         ~Workspace();
         bool                        isInWorkspace( const QString &path );
         bool                        isInWorkspace( const Media *media );
 
         bool                        copyToWorkspace( Media* media );
     private:
+        // Copying more files at once would just have them compete for the disks
+        static const int            MaxCopies = 2;
+
+        // Starts copying the queued medias, up to MaxCopies at a time
+        void                        startCopies();
         void                        startCopyWorker( Media *media );
+        void                        copyDone( Media* media );
         bool                        isInWorkspace( const QFileInfo &fInfo );
     private:
         QQueue<Media*>              m_mediasToCopy;
         QMutex                      *m_mediasToCopyMutex;
-        bool                        m_copyInProgress;
+        int                         m_nbCopies;
         QString                     m_workspaceDir;
+        SettingValue*               m_verifyCopies;
+        Tools::JobScheduler*        m_scheduler;
+        Tools::JobScheduler::CancellationToken  m_copies;
+        // Bytes copied and to copy, by running copy
+        QHash<Media*, QPair<qint64, qint64>>    m_progress;
 
     public slots:
         void                        clipLoaded( Clip* clip );
     private slots:
         void                        copyTerminated( Media* media, QString dest );
+        void                        copyFailed( Media* media, QString dest );
+        void                        copyProgressed( Media* media, qint64 done, qint64 total );
         void                        workspaceChanged( const QVariant& newWorkspace );
 
     signals:
         void                        notify( QString );
+        // In bytes, for each media being copied
+        void                        copyProgress( Media* media, qint64 done, qint64 total );
+        // The progress of all the running copies, in percent
+        void                        progressUpdated( int percent );
 };
 
 #endif // WORKSPACE_H
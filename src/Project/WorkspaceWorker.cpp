@@ -30,28 +30,53 @@
 #include "Settings/Settings.h"
 #include "Tools/VlmcDebug.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <cstring>
 #include <unistd.h>
 
+#ifdef Q_OS_UNIX
+# include <fcntl.h>
+# include <sys/stat.h>
+#endif
+#ifdef Q_OS_LINUX
+# include <linux/fs.h>
+# include <sys/ioctl.h>
+# include <sys/sendfile.h>
+#endif
+
+#include <QCryptographicHash>
 #include <QFile>
 #include <QFileInfo>
 
-WorkspaceWorker::WorkspaceWorker( Media *media, const QString &dest ) :
+namespace
+{
+    const qint64    BlockSize = 8 * 1024 * 1024;
+}
+
+WorkspaceWorker::WorkspaceWorker( Media *media, const QString &dest, bool verify,
+                                  Tools::JobScheduler* scheduler ) :
     m_media( media ),
-    m_dest( dest )
+    m_source( media->fileInfo()->absoluteFilePath() ),
+    m_dest( dest ),
+    m_verify( verify ),
+    m_size( media->fileInfo()->size() ),
+    m_lastProgress( -1 ),
+    m_scheduler( scheduler ),
+    m_token( nullptr )
 {
-    connect( this, SIGNAL( finished() ), this, SLOT( deleteLater() ) );
 }
 
 void
-WorkspaceWorker::run()
+WorkspaceWorker::run( const Tools::JobScheduler::CancellationToken& token )
 {
     bool            hardLinkOk = false;
 
+    m_token = &token;
+
 #ifdef Q_OS_UNIX
     errno = 0;
-    if ( link( m_media->fileInfo()->absoluteFilePath().toUtf8().constData(),
-          m_dest.toUtf8().constData() ) < 0 )
+    if ( link( m_source.toUtf8().constData(), m_dest.toUtf8().constData() ) < 0 )
     {
         vlmcDebug() << "Can't create hard link:" << strerror(errno) << "falling back to"
                 " hard copy mode.";
@@ -63,12 +88,174 @@ WorkspaceWorker::run()
     }
 #endif
 
-    if ( hardLinkOk == false )
+    if ( hardLinkOk == false && copy() == false )
     {
-        QFile           file( m_media->fileInfo()->absoluteFilePath() );
+        vlmcWarning() << "Failed to copy" << m_source << "to" << m_dest;
+        QFile::remove( m_dest );
+        emit failed( m_media, m_dest );
+        return;
+    }
+    emit copied( m_media, m_dest );
+}
 
-        file.copy( m_media->fileInfo()->absoluteFilePath(), m_dest );
+bool
+WorkspaceWorker::copy()
+{
+#ifdef Q_OS_UNIX
+    int in = open( m_source.toUtf8().constData(), O_RDONLY | O_CLOEXEC );
+    if ( in < 0 )
+        return false;
+    int out = open( m_dest.toUtf8().constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+    if ( out < 0 )
+    {
+        close( in );
+        return false;
+    }
+    bool res;
+    // The clone shares the source's extents, there's nothing to verify
+    if ( clone( in, out ) == true )
+    {
+        vlmcDebug() << "Media reflinked to:" << m_dest;
+        res = true;
+    }
+    else if ( m_verify == true )
+        res = copyAndVerify( in, out );
+    else
+        res = copyInKernel( in, out ) || copyAndVerify( in, out );
+    if ( close( out ) < 0 )
+        res = false;
+    close( in );
+    if ( res == true )
         vlmcDebug() << "Media copied to:" << m_dest;
+    return res;
+#else
+    return QFile::copy( m_source, m_dest );
+#endif
+}
+
+bool
+WorkspaceWorker::clone( int in, int out )
+{
+#if defined( Q_OS_LINUX ) && defined( FICLONE )
+    return ioctl( out, FICLONE, in ) == 0;
+#else
+    Q_UNUSED( in );
+    Q_UNUSED( out );
+    return false;
+#endif
+}
+
+bool
+WorkspaceWorker::copyInKernel( int in, int out )
+{
+#ifdef Q_OS_LINUX
+    // Neither call copies through userspace. copy_file_range() may even let the file
+    // system or the NFS server copy the data itself.
+    qint64 done = 0;
+    bool useSendfile = false;
+    while ( done < m_size )
+    {
+        // Pauses while the preview plays or an export runs
+        if ( m_scheduler->yield( *m_token ) == false )
+            return false;
+        auto chunk = std::min( BlockSize, m_size - done );
+        ssize_t n;
+        if ( useSendfile == false )
+        {
+            n = copy_file_range( in, nullptr, out, nullptr, chunk, 0 );
+            // Unsupported for this pair of files, which is known before anything got copied
+            if ( n < 0 && done == 0 && ( errno == ENOSYS || errno == EXDEV || errno == EINVAL ||
+                                         errno == EOPNOTSUPP ) )
+            {
+                useSendfile = true;
+                continue;
+            }
+        }
+        else
+            n = sendfile( out, in, nullptr, chunk );
+        if ( n < 0 && errno == EINTR )
+            continue;
+        // The copy gets started over from userspace
+        if ( n <= 0 )
+            return false;
+        done += n;
+        reportProgress( done );
     }
-    emit copied( m_media, m_dest );
+    return true;
+#else
+    Q_UNUSED( in );
+    Q_UNUSED( out );
+    return false;
+#endif
+}
+
+bool
+WorkspaceWorker::copyAndVerify( int in, int out )
+{
+#ifdef Q_OS_UNIX
+    if ( lseek( in, 0, SEEK_SET ) != 0 || lseek( out, 0, SEEK_SET ) != 0 || ftruncate( out, 0 ) != 0 )
+        return false;
+#ifdef Q_OS_LINUX
+    posix_fadvise( in, 0, 0, POSIX_FADV_SEQUENTIAL );
+#endif
+    // The source is hashed as it's read for the copy, only the written file is read again
+    QCryptographicHash  sourceHash( QCryptographicHash::Sha1 );
+    QByteArray          buffer( BlockSize, Qt::Uninitialized );
+    qint64 done = 0;
+    for ( ;; )
+    {
+        if ( m_scheduler->yield( *m_token ) == false )
+            return false;
+        auto n = read( in, buffer.data(), BlockSize );
+        if ( n < 0 && errno == EINTR )
+            continue;
+        if ( n < 0 )
+            return false;
+        if ( n == 0 )
+            break;
+        if ( m_verify == true )
+            sourceHash.addData( buffer.constData(), n );
+        for ( ssize_t written = 0; written < n; )
+        {
+            auto w = write( out, buffer.constData() + written, n - written );
+            if ( w < 0 && errno == EINTR )
+                continue;
+            if ( w < 0 )
+                return false;
+            written += w;
+        }
+        done += n;
+        reportProgress( done );
+    }
+    if ( m_verify == false )
+        return true;
+    if ( fdatasync( out ) < 0 )
+        return false;
+
+    QFile   copy( m_dest );
+    if ( copy.open( QFile::ReadOnly ) == false )
+        return false;
+    QCryptographicHash  destHash( QCryptographicHash::Sha1 );
+    if ( destHash.addData( &copy ) == false || destHash.result() != sourceHash.result() )
+    {
+        vlmcWarning() << "The copy of" << m_source << "doesn't match the original";
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED( in );
+    Q_UNUSED( out );
+    return false;
+#endif
+}
+
+void
+WorkspaceWorker::reportProgress( qint64 done )
+{
+    // Once per percent
+    auto percent = m_size > 0 ? done * 100 / m_size : 100;
+    if ( percent == m_lastProgress )
+        return;
+    m_lastProgress = percent;
+    emit progress( m_media, done, m_size );
 }
@@ -23,23 +23,51 @@
 #ifndef WORKSPACEWORKER_H
 #define WORKSPACEWORKER_H
 
-#include <QThread>
+#include <QObject>
+
+#include "Tools/JobScheduler.h"
 
 class Media;
 
-class WorkspaceWorker : public QThread
+/**
+ *  \brief Copies a media to the workspace.
+ *
+ *  The cheapest way the file systems allow is used: a hard link, a reflink (a copy on
+ *  write clone), then a copy done by the kernel, and last a plain copy. When verify is
+ *  true, the copy is always made from userspace, hashing the source as it's read, so
+ *  the written file can be checked against it.
+ *  It runs as a job of the scheduler, and gives up the copy once its token gets
+ *  cancelled.
+ */
+class WorkspaceWorker : public QObject
 {
     Q_OBJECT
     public:
-        explicit WorkspaceWorker( Media *filePath, const QString &dest );
+        WorkspaceWorker( Media *filePath, const QString &dest, bool verify,
+                         Tools::JobScheduler* scheduler );
+
+        void                run( const Tools::JobScheduler::CancellationToken& token );
+    private:
+        bool                copy();
+        bool                clone( int in, int out );
+        bool                copyInKernel( int in, int out );
+        bool                copyAndVerify( int in, int out );
+        void                reportProgress( qint64 done );
 
-    protected:
-        void                run();
     private:
         Media*              m_media;
+        QString             m_source;
         QString             m_dest;
+        bool                m_verify;
+        qint64              m_size;
+        qint64              m_lastProgress;
+        Tools::JobScheduler*                            m_scheduler;
+        const Tools::JobScheduler::CancellationToken*   m_token;
     signals:
         void                copied( Media*, QString dest );
+        void                failed( Media*, QString dest );
+        // In bytes
+        void                progress( Media*, qint64 done, qint64 total );
 };
 
 #endif // WORKSPACEWORKER_H
@@ -28,23 +28,56 @@
 #include "AbstractRenderer.h"
 
 #include "Tools/RendererEventWatcher.h"
+#include "Backend/MLT/MLTLoopCache.h"
 #include "Backend/MLT/MLTOutput.h"
+#include "Backend/IInput.h"
+#include "Tools/Trace.h"
 
 #include <QtGlobal>
 
+#include <algorithm>
+
 AbstractRenderer::AbstractRenderer()
     : m_input( nullptr )
+    , m_scrubPosition( -1 )
+    , m_pendingSeek( -1 )
+    , m_tracedSeek( -1 )
+    , m_loopBegin( 0 )
+    , m_loopEnd( 0 )
+    , m_lastPosition( -1 )
 {
+    // About one refresh of a 60Hz display
+    m_seekTimer.setInterval( 16 );
+    m_seekTimer.setSingleShot( true );
+    connect( &m_seekTimer, &QTimer::timeout, this, &AbstractRenderer::flushSeek );
+
     m_eventWatcher = new RendererEventWatcher;
     connect( m_eventWatcher, &RendererEventWatcher::stopped, this, &AbstractRenderer::stop );
-    connect( m_eventWatcher, &RendererEventWatcher::positionChanged, this, [this]( qint64 pos ){ emit frameChanged( pos, Vlmc::Renderer ); } );
+    connect( m_eventWatcher, &RendererEventWatcher::positionChanged, this, [this]( qint64 pos )
+    {
+        if ( pos == m_tracedSeek )
+        {
+            Tools::Trace::add( Tools::Trace::SeekCompleted, pos, this );
+            m_tracedSeek = -1;
+        }
+        emit frameChanged( pos, Vlmc::Renderer );
+        wrapLoop( pos );
+    } );
     connect( m_eventWatcher, &RendererEventWatcher::lengthChanged, this, &AbstractRenderer::lengthChanged );
-    connect( m_eventWatcher, &RendererEventWatcher::endReached, this, &AbstractRenderer::stop );
+    connect( m_eventWatcher, &RendererEventWatcher::endReached, this, [this]
+    {
+        // A loop ending with the input doesn't get to report the crossing
+        if ( isLooping() == true && m_input != nullptr && m_input->speed() >= 0 )
+            seek( m_loopBegin );
+        else
+            stop();
+    } );
 }
 
 AbstractRenderer::~AbstractRenderer()
 {
     stop();
+    m_loopCache.reset();
     delete m_eventWatcher;
 }
 
@@ -66,7 +99,32 @@ void
 AbstractRenderer::setPosition( qint64 pos )
 {
     if ( m_input )
-        m_input->setPosition( pos );
+        seek( pos );
+}
+
+void
+AbstractRenderer::seek( qint64 pos )
+{
+    m_pendingSeek = pos;
+    // A seek was just applied, this one waits for the next refresh and may be
+    // superseded by then
+    if ( m_seekTimer.isActive() == true )
+        return;
+    flushSeek();
+}
+
+void
+AbstractRenderer::flushSeek()
+{
+    if ( m_pendingSeek < 0 || m_input == nullptr )
+        return;
+    // Don't wait for the frames rendered from the previous position
+    if ( m_output != nullptr && m_output->isStopped() == false )
+        m_output->purge();
+    m_input->setPosition( m_pendingSeek );
+    m_tracedSeek = m_pendingSeek;
+    m_pendingSeek = -1;
+    m_seekTimer.start();
 }
 
 void
@@ -75,6 +133,7 @@ AbstractRenderer::togglePlayPause()
     if ( m_input == nullptr || !m_output )
         return;
 
+    enterLoop();
     if ( m_output->isStopped() )
     {
         m_output->start();
@@ -84,6 +143,82 @@ AbstractRenderer::togglePlayPause()
         m_input->playPause();
 }
 
+void
+AbstractRenderer::setLoop( qint64 begin, qint64 end )
+{
+    m_loopBegin = end > begin ? begin : 0;
+    m_loopEnd = end > begin ? end : 0;
+    m_lastPosition = -1;
+    if ( isLooping() == false || m_input == nullptr )
+    {
+        m_loopCache.reset();
+        return;
+    }
+    if ( m_loopCache == nullptr )
+        m_loopCache.reset( new Backend::MLT::MLTLoopCache( *m_input ) );
+    m_loopCache->setRange( m_loopBegin, m_loopEnd );
+}
+
+bool
+AbstractRenderer::isLooping() const
+{
+    return m_loopEnd > m_loopBegin;
+}
+
+void
+AbstractRenderer::invalidateLoop( qint64 begin, qint64 end )
+{
+    if ( m_loopCache != nullptr )
+        m_loopCache->invalidate( begin, end );
+}
+
+void
+AbstractRenderer::enterLoop()
+{
+    if ( isLooping() == false || m_input == nullptr )
+        return;
+    if ( m_input->position() < m_loopBegin || m_input->position() >= m_loopEnd )
+        seek( m_loopBegin );
+}
+
+void
+AbstractRenderer::wrapLoop( qint64 pos )
+{
+    auto last = m_lastPosition;
+    m_lastPosition = pos;
+    if ( isLooping() == false || last < 0 || isRendering() == false || m_input->isPaused() == true )
+        return;
+    if ( m_input->speed() > 0 && last < m_loopEnd && pos >= m_loopEnd )
+        seek( m_loopBegin );
+    else if ( m_input->speed() < 0 && last >= m_loopBegin && pos < m_loopBegin )
+        seek( m_loopEnd - 1 );
+}
+
+void
+AbstractRenderer::shuttle( int direction )
+{
+    if ( m_input == nullptr || !m_output )
+        return;
+    if ( direction == 0 )
+    {
+        if ( isRendering() == true )
+            m_input->setPause( true );
+        return;
+    }
+    // Let the renderer start the playback as it would for play
+    if ( m_output->isStopped() == true )
+        togglePlayPause();
+    if ( m_input == nullptr || m_output->isStopped() == true )
+        return;
+
+    double speed = m_input->isPaused() == true ? 0.0 : m_input->speed();
+    if ( direction > 0 )
+        speed = speed > 0.0 ? std::min( speed * 2.0, (double)MaxShuttleSpeed ) : 1.0;
+    else
+        speed = speed < 0.0 ? std::max( speed * 2.0, (double)-MaxShuttleSpeed ) : -1.0;
+    m_input->setSpeed( speed );
+}
+
 int
 AbstractRenderer::getVolume() const
 {
@@ -159,7 +294,12 @@ AbstractRenderer::isRendering() const
 void
 AbstractRenderer::setInput( Backend::IInput* input )
 {
+    // The frames of the loop were those of the previous input
+    m_loopCache.reset();
     m_input = input;
+    // Pending seeks were meant for the previous input
+    m_pendingSeek = -1;
+    setLoop( m_loopBegin, m_loopEnd );
 
     if ( m_input )
     {
@@ -188,6 +328,30 @@ AbstractRenderer::previewWidgetCursorChanged( qint64 newFrame )
 {
     if ( isRendering() == true )
     {
-        m_input->setPosition( newFrame );
+        seek( newFrame );
+        m_scrubPosition = newFrame;
+    }
+}
+
+void
+AbstractRenderer::setScrubbing( bool scrubbing )
+{
+    if ( m_input == nullptr )
+        return;
+    if ( scrubbing == true )
+    {
+        m_scrubPosition = -1;
+        emit scrubbingChanged( true );
+        m_input->setSeekPrecision( Backend::IInput::Fast );
+        return;
+    }
+    m_input->setSeekPrecision( Backend::IInput::Exact );
+    emit scrubbingChanged( false );
+    // The final position is sought right away, replacing any pending seek
+    if ( m_scrubPosition >= 0 && isRendering() == true )
+    {
+        m_pendingSeek = m_scrubPosition;
+        flushSeek();
     }
+    m_scrubPosition = -1;
 }
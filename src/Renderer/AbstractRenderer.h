@@ -27,6 +27,7 @@
 #include "config.h"
 #include <memory>
 #include <QObject>
+#include <QTimer>
 
 #include "Workflow/Types.h"
 #include "Backend/IOutput.h"
@@ -40,6 +41,10 @@ namespace Backend
 {
 class IOutput;
 class IInput;
+namespace MLT
+{
+class MLTLoopCache;
+}
 }
 
 /**
@@ -75,6 +80,34 @@ public:
      */
     virtual void        togglePlayPause();
 
+    /**
+     *  \brief  Shuttle playback, as bound to the J, K and L keys.
+     *
+     *  A positive direction plays forward, doubling the speed each time it is
+     *  repeated up to MaxShuttleSpeed. A negative one does the same backward, and 0
+     *  pauses. Changing direction restarts at normal speed.
+     */
+    virtual void        shuttle( int direction );
+
+    static const int    MaxShuttleSpeed = 8;
+
+    /**
+     *  \brief  Loops the playback over the frames [begin, end). An empty range stops
+     *          looping.
+     *
+     *  Once the playback crosses end, it goes back to begin, and starts from begin if
+     *  it was started out of the range. The frames of the range are kept in memory
+     *  from the first pass on, so the following ones don't render them again.
+     *  \sa     Backend::MLT::MLTLoopCache
+     */
+    void                setLoop( qint64 begin, qint64 end );
+    bool                isLooping() const;
+    /**
+     *  \brief  Drops the frames kept for the loop between begin and end, which
+     *          changed. A negative end stands for the end of the input.
+     */
+    void                invalidateLoop( qint64 begin, qint64 end = -1 );
+
     /**
      *  \brief Render the next frame
      *  \sa     previousFrame()
@@ -93,6 +126,12 @@ public:
      */
     virtual void                    stop();
 
+    /**
+     *  \brief  Seek to pos.
+     *
+     *  Consecutive seeks are coalesced: at most one is applied per display refresh,
+     *  and only the latest one requested in the meantime is kept.
+     */
     virtual void                    setPosition( qint64 pos );
 
     /**
@@ -149,10 +188,33 @@ public:
 
     RendererEventWatcher*           eventWatcher();
 protected:
+    // Seeks to the beginning of the loop when starting the playback out of it
+    void                                          enterLoop();
+
     std::unique_ptr<Backend::IOutput>             m_output;
 
     Backend::IInput*                             m_input;
     RendererEventWatcher*                           m_eventWatcher;
+    qint64                                          m_scrubPosition;
+
+private:
+    void                                            seek( qint64 pos );
+    void                                            flushSeek();
+    // Goes back to the other end of the loop, once pos crossed it
+    void                                            wrapLoop( qint64 pos );
+
+private:
+    // Latest seek not applied yet, -1 if none
+    qint64                                          m_pendingSeek;
+    // The last seek applied, until the position reaches it
+    qint64                                          m_tracedSeek;
+    // Running while a seek was applied less than a display refresh ago
+    QTimer                                          m_seekTimer;
+    qint64                                          m_loopBegin;
+    qint64                                          m_loopEnd;
+    // The last position reported, to tell when it crosses an end of the loop
+    qint64                                          m_lastPosition;
+    std::unique_ptr<Backend::MLT::MLTLoopCache>     m_loopCache;
 
 
 public slots:
@@ -164,11 +226,19 @@ public slots:
      */
     virtual void                    previewWidgetCursorChanged( qint64 newFrame );
 
+    /**
+     *  \brief      Switch to approximate seeking while the user drags the cursor.
+     *
+     *  When scrubbing ends, the last requested frame is sought again, exactly.
+     */
+    virtual void                    setScrubbing( bool scrubbing );
+
 
 signals:
     void                            frameChanged( qint64 newFrame,
                                                 Vlmc::FrameChangedReason reason );
     void                            lengthChanged( qint64 length ); // In frames
+    void                            scrubbingChanged( bool scrubbing );
 };
 
 #endif // ABSTRACTRENDERER_H
@@ -28,6 +28,8 @@
 
 #include <QtGlobal>
 #include <QtCore/qmath.h>
+#include <QFileInfo>
+#include <QRunnable>
 
 #include "Media/Clip.h"
 #include "ClipRenderer.h"
@@ -40,22 +42,70 @@
 #include "Workflow/MainWorkflow.h"
 #include "Gui/preview/RenderWidget.h"
 
+namespace
+{
+
+class PrefetchJob : public QRunnable
+{
+public:
+    PrefetchJob( const QString& path, qint64 begin )
+        : m_path( path )
+        , m_begin( begin )
+    {
+    }
+
+    virtual void run() override
+    {
+        try
+        {
+            // Decoding a frame opens the decoders, the input is then released
+            // to the cache ready to be used. The frame is dropped, it doesn't need
+            // converting.
+            auto input = Backend::instance()->acquireInput( qPrintable( m_path ) );
+            input->setPosition( m_begin );
+            input->image( 64, 64, Backend::IVideoFrame::YUV420P );
+        }
+        catch ( Backend::InvalidServiceException& )
+        {
+        }
+    }
+
+private:
+    QString     m_path;
+    qint64      m_begin;
+};
+
+QString
+clipPath( const Clip* clip )
+{
+    return clip->media()->fileInfo()->absoluteFilePath();
+}
+
+}
+
 ClipRenderer::ClipRenderer() :
     AbstractRenderer(),
     m_clipLoaded( false ),
     m_selectedClip( nullptr ),
     m_mediaChanged( false )
 {
+    m_prefetchPool.setMaxThreadCount( 1 );
 }
 
 ClipRenderer::~ClipRenderer()
 {
+    m_prefetchPool.clear();
+    m_prefetchPool.waitForDone();
     stop();
+    m_input = nullptr;
+    releasePreviewInput();
 }
 
 void
 ClipRenderer::setClip( Clip* clip )
 {
+    // The neighbours of the previous selection aren't likely to be needed anymore
+    m_prefetchPool.clear();
     // if the clip is different (or nullptr) we have to stop playback.
     if ( m_selectedClip != nullptr &&
          ( ( clip != nullptr && clip->uuid() != m_selectedClip->uuid() ) || clip == nullptr ) )
@@ -67,6 +117,7 @@ ClipRenderer::setClip( Clip* clip )
         m_selectedClip = nullptr;
         m_clipLoaded = false;
         m_input = nullptr;
+        releasePreviewInput();
         return ;
     }
     m_selectedClip = clip;
@@ -90,15 +141,47 @@ ClipRenderer::startPreview()
     if ( m_selectedClip == nullptr || m_selectedClip->length() == 0 )
         return ;
     updateInfos( m_selectedClip );
-    setInput( m_selectedClip->input() );
+
+    // Keep the previous input until the output is connected to the new one
+    auto previousSource = std::move( m_source );
+    auto previousInput = std::move( m_previewInput );
+    try
+    {
+        m_source = Backend::instance()->acquireInput( qPrintable( clipPath( m_selectedClip ) ) );
+        m_previewInput = m_source->cut( m_selectedClip->begin(), m_selectedClip->end() );
+        setInput( m_previewInput.get() );
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        m_previewInput.reset();
+        m_source.reset();
+        setInput( m_selectedClip->input() );
+    }
 
     m_output->start();
     m_input->setPosition( 0 );
+    enterLoop();
 
     m_clipLoaded = true;
     m_mediaChanged = false;
 }
 
+void
+ClipRenderer::releasePreviewInput()
+{
+    // The cut must go before the input it was cut from
+    m_previewInput.reset();
+    m_source.reset();
+}
+
+void
+ClipRenderer::prefetch( Clip* clip )
+{
+    if ( clip == nullptr || clip == m_selectedClip || clip->length() == 0 )
+        return;
+    m_prefetchPool.start( new PrefetchJob( clipPath( clip ), clip->begin() ) );
+}
+
 void
 ClipRenderer::stop()
 {
@@ -121,6 +204,7 @@ ClipRenderer::togglePlayPause()
         startPreview();
         return ;
     }
+    enterLoop();
     if ( m_output->isStopped() )
     {
         m_output->start();
@@ -154,6 +238,8 @@ ClipRenderer::clipUnloaded( const QUuid& uuid )
         stop();
         m_clipLoaded = false;
         m_selectedClip = nullptr;
+        m_input = nullptr;
+        releasePreviewInput();
     }
 }
 
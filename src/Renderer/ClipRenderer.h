@@ -27,6 +27,9 @@
 #include "AbstractRenderer.h"
 
 #include <QObject>
+#include <QThreadPool>
+
+#include <memory>
 
 class   Clip;
 class   Media;
@@ -48,10 +51,17 @@ public:
 
 private:
     void                    startPreview();
+    void                    releasePreviewInput();
 
 private:
     bool                    m_clipLoaded;
     Clip*                   m_selectedClip;
+    // Checked out from the backend's input cache while the clip is previewed, so
+    // that the library clip's own input is left alone
+    std::shared_ptr<Backend::IInput>    m_source;
+    std::unique_ptr<Backend::IInput>    m_previewInput;
+    // Warms up the inputs of the clips likely to be previewed next
+    QThreadPool             m_prefetchPool;
     /**
      *  \brief  This flags is used to know if a new media has been selected in the
      * library. If so, we must relaunch the render if the play button is clicked again.
@@ -64,6 +74,14 @@ public slots:
      *  \param      clip    The clip to render
      */
     void                    setClip( Clip* clip );
+    /**
+     *  \brief      Open and decode the first frame of clip in the background.
+     *
+     *  The input then waits in the backend's cache, and previewing the clip later
+     *  doesn't have to open the file again. Pending prefetches are dropped when a
+     *  new clip is set.
+     */
+    void                    prefetch( Clip* clip );
     void                    clipUnloaded( const QUuid& uuid );
     void                    updateInfos( Clip* clip );
 
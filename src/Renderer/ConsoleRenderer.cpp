@@ -1,5 +1,5 @@
 /*****************************************************************************
- * ConsoleRenderer.h: Handle the "server" mode rendering
+ * ConsoleRenderer.cpp: Handle the "server" mode rendering
  *****************************************************************************
  * Copyright (C) 2008-2010 VideoLAN
  *
@@ -25,49 +25,724 @@
 #endif
 
 #include "ConsoleRenderer.h"
+#include "Backend/MLT/MLTOutput.h"
 #include "Main/Core.h"
 #include "Project/Project.h"
+#include "Tools/Metrics.h"
+#include "Tools/OutputEventWatcher.h"
 #include "Tools/VlmcDebug.h"
-#include "Renderer/WorkflowRenderer.h"
+#include "Library/Library.h"
+#include "Workflow/DistributedRender.h"
+#include "Workflow/MainWorkflow.h"
+#include "Workflow/RenderQueue.h"
 
 #include <QCoreApplication>
-#include <QStringList>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSocketNotifier>
+#include <QTextStream>
+#include <QTimer>
+
+#include <cstdio>
+#ifdef Q_OS_UNIX
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef Q_OS_UNIX
+// Written to from the signal handler, which can't do anything else safely
+int     signalFds[2] = { -1, -1 };
+
+void
+onSignal( int )
+{
+    char c = 1;
+    auto res = ::write( signalFds[0], &c, sizeof( c ) );
+    Q_UNUSED( res );
+}
+#endif
+
+// Accepts both "--name value" and "--name=value". Returns false if name isn't at i
+bool
+takeValue( const QStringList& args, int& i, const QString& name, QString& value )
+{
+    if ( args[i] == name )
+    {
+        if ( i + 1 >= args.size() )
+            return false;
+        value = args[++i];
+        return true;
+    }
+    if ( args[i].startsWith( name + '=' ) == false )
+        return false;
+    value = args[i].mid( name.size() + 1 );
+    return true;
+}
+
+// "a:b", where either bound may be omitted
+bool
+parseRange( const QString& value, qint64& begin, qint64& end )
+{
+    auto bounds = value.split( ':' );
+    if ( bounds.size() != 2 )
+        return false;
+    bool ok = true;
+    begin = bounds[0].isEmpty() == true ? 0 : bounds[0].toLongLong( &ok );
+    if ( ok == false || begin < 0 )
+        return false;
+    end = bounds[1].isEmpty() == true ? -1 : bounds[1].toLongLong( &ok );
+    return ok == true && ( end < 0 || end > begin );
+}
+
+// "file=track,track...", the tracks numbered from 0
+bool
+parseStem( const QString& value, StemParameters& stem )
+{
+    auto sep = value.lastIndexOf( '=' );
+    if ( sep <= 0 )
+        return false;
+    stem.outputFileName = value.left( sep );
+    stem.tracks.clear();
+    for ( const auto& t : value.mid( sep + 1 ).split( ',' ) )
+    {
+        bool ok;
+        stem.tracks.append( t.toUInt( &ok ) );
+        if ( ok == false )
+            return false;
+    }
+    return true;
+}
+
+// "file=WxH[@fps][:kbps]", the other settings being the main export's
+bool
+parseRendition( const QString& value, RenderParameters& params )
+{
+    auto sep = value.lastIndexOf( '=' );
+    if ( sep <= 0 )
+        return false;
+    params.outputFileName = value.left( sep );
+    auto spec = value.mid( sep + 1 );
+    bool ok = true;
+    auto bitrate = spec.indexOf( ':' );
+    if ( bitrate >= 0 )
+    {
+        params.videoBitrate = spec.mid( bitrate + 1 ).toUInt( &ok );
+        if ( ok == false || params.videoBitrate == 0 )
+            return false;
+        spec.truncate( bitrate );
+    }
+    auto fps = spec.indexOf( '@' );
+    if ( fps >= 0 )
+    {
+        params.fps = spec.mid( fps + 1 ).toDouble( &ok );
+        if ( ok == false || params.fps <= 0. )
+            return false;
+        spec.truncate( fps );
+    }
+    auto dims = spec.split( 'x' );
+    if ( dims.size() != 2 )
+        return false;
+    params.width = dims[0].toUInt( &ok );
+    if ( ok == true )
+        params.height = dims[1].toUInt( &ok );
+    // Encoders mostly require even dimensions
+    return ok == true && params.width > 0 && params.height > 0 &&
+            params.width % 2 == 0 && params.height % 2 == 0;
+}
+}
 
 ConsoleRenderer::ConsoleRenderer(QObject *parent) :
     QObject(parent)
+    , m_width( 0 )
+    , m_height( 0 )
+    , m_videoBitrate( 0 )
+    , m_audioBitrate( 0 )
+    , m_threads( 0 )
+    , m_gopSize( 0 )
+    , m_rangeBegin( 0 )
+    , m_rangeEnd( -1 )
+    , m_benchmark( false )
+    , m_twoPass( false )
+    , m_stats( false )
+    , m_xml( false )
+    , m_xmlRangeLength( 0 )
+    , m_totalFrames( 0 )
+    , m_percent( -1 )
+    , m_lastReport( 0 )
+    , m_failed( false )
+    , m_cancelled( false )
+    , m_done( false )
+    , m_signalNotifier( nullptr )
+    , m_distributed( nullptr )
+    , m_streamWatcher( nullptr )
+    , m_droppedFrames( 0 )
 {
-    m_outputFileName = qApp->arguments()[2];
-    connect( Core::instance()->workflow(), &MainWorkflow::frameChanged,
-             this, &ConsoleRenderer::frameChanged);
-    connect( Core::instance()->workflowRenderer(), SIGNAL( renderComplete() ), qApp, SLOT( quit() ) );
+#ifdef Q_OS_UNIX
+    if ( ::socketpair( AF_UNIX, SOCK_STREAM, 0, signalFds ) == 0 )
+    {
+        m_signalNotifier = new QSocketNotifier( signalFds[1], QSocketNotifier::Read, this );
+        connect( m_signalNotifier, &QSocketNotifier::activated, this, &ConsoleRenderer::signalReceived );
+        signal( SIGINT, onSignal );
+        signal( SIGTERM, onSignal );
+    }
+    else
+        vlmcWarning() << "Can't watch for signals, the render won't be cancelled cleanly";
+#endif
+
+    auto queue = Core::instance()->renderQueue();
+    connect( queue, &RenderQueue::jobStarted, this, &ConsoleRenderer::jobStarted );
+    connect( queue, &RenderQueue::jobFinished, this, &ConsoleRenderer::jobFinished );
+    connect( queue, &RenderQueue::idle, this, [this]
+    {
+        if ( m_cancelled == true )
+            exit( Cancelled );
+        else
+            exit( m_failed == true ? RenderError : Success );
+    } );
 }
 
-void
-ConsoleRenderer::frameChanged( qint64 frame ) const
+ConsoleRenderer::~ConsoleRenderer()
 {
-    static int      percent = 0;
-    int             newPercent;
+#ifdef Q_OS_UNIX
+    if ( m_signalNotifier == nullptr )
+        return;
+    signal( SIGINT, SIG_DFL );
+    signal( SIGTERM, SIG_DFL );
+    ::close( signalFds[0] );
+    ::close( signalFds[1] );
+#endif
+}
 
-    newPercent = frame * 100 / Core::instance()->workflow()->getLengthFrame();
-    if ( newPercent != percent )
+bool
+ConsoleRenderer::parseArguments( const QStringList& args )
+{
+    QStringList positional;
+    for ( int i = 1; i < args.size(); ++i )
+    {
+        QString value;
+        bool ok = true;
+        if ( takeValue( args, i, "--render", m_projectFileName ) == true ||
+             takeValue( args, i, "--out", m_outputFileName ) == true ||
+             takeValue( args, i, "--vcodec", m_videoCodec ) == true ||
+             takeValue( args, i, "--acodec", m_audioCodec ) == true ||
+             takeValue( args, i, "--nodes", m_nodesFileName ) == true ||
+             takeValue( args, i, "--stream", m_streamUrl ) == true ||
+             takeValue( args, i, "--frame-hashes", m_frameHashFile ) == true ||
+             takeValue( args, i, "--verify-hashes", m_referenceHashFile ) == true )
+            continue;
+        if ( takeValue( args, i, "--size", value ) == true )
+        {
+            auto dims = value.split( 'x' );
+            ok = dims.size() == 2;
+            if ( ok == true )
+            {
+                m_width = dims[0].toUInt( &ok );
+                if ( ok == true )
+                    m_height = dims[1].toUInt( &ok );
+            }
+            // Encoders mostly require even dimensions
+            ok = ok == true && m_width > 0 && m_height > 0 && m_width % 2 == 0 && m_height % 2 == 0;
+        }
+        else if ( takeValue( args, i, "--vbitrate", value ) == true )
+            m_videoBitrate = value.toUInt( &ok );
+        else if ( takeValue( args, i, "--abitrate", value ) == true )
+            m_audioBitrate = value.toUInt( &ok );
+        else if ( takeValue( args, i, "--threads", value ) == true )
+            m_threads = value.toInt( &ok );
+        else if ( takeValue( args, i, "--gop", value ) == true )
+            ok = ( m_gopSize = value.toInt() ) > 0;
+        else if ( takeValue( args, i, "--map-path", value ) == true )
+        {
+            auto sep = value.indexOf( '=' );
+            ok = sep > 0;
+            if ( ok == true )
+                m_pathMappings.insert( value.left( sep ), value.mid( sep + 1 ) );
+        }
+        else if ( takeValue( args, i, "--range", value ) == true )
+            ok = parseRange( value, m_rangeBegin, m_rangeEnd );
+        else if ( takeValue( args, i, "--stem", value ) == true )
+        {
+            StemParameters  stem;
+            ok = parseStem( value, stem );
+            m_stems.append( value );
+        }
+        else if ( takeValue( args, i, "--rendition", value ) == true )
+        {
+            RenderParameters    rendition;
+            ok = parseRendition( value, rendition );
+            m_renditions.append( value );
+        }
+        else if ( args[i] == "--benchmark" )
+            m_benchmark = true;
+        else if ( args[i] == "--two-pass" )
+            m_twoPass = true;
+        else if ( args[i] == "--stats" )
+            m_stats = true;
+        else if ( args[i] == "--xml" )
+            m_xml = true;
+        else if ( takeValue( args, i, "--xml-split", value ) == true )
+        {
+            m_xml = true;
+            ok = ( m_xmlRangeLength = value.toLongLong() ) > 0;
+        }
+        else if ( args[i].startsWith( '-' ) == false )
+            positional.append( args[i] );
+        // Other options, such as the logger's, are handled by their owners
+        else
+            continue;
+        if ( ok == false || m_threads < 0 )
+        {
+            fprintf( stderr, "Invalid value for %s\n", qPrintable( args[i] ) );
+            return false;
+        }
+    }
+    // Historical form: vlmc project.vlmc output_file
+    if ( m_projectFileName.isEmpty() == true && positional.isEmpty() == false )
+        m_projectFileName = positional.takeFirst();
+    if ( m_outputFileName.isEmpty() == true && positional.isEmpty() == false )
+        m_outputFileName = positional.takeFirst();
+    if ( m_projectFileName.isEmpty() == true ||
+         ( m_outputFileName.isEmpty() == true && m_benchmark == false && m_streamUrl.isEmpty() == true ) )
     {
-        percent = newPercent;
-        vlmcDebug() << "ConsoleRenderer: " << percent << "%";
+        fprintf( stderr, "A project and an output file are required\n" );
+        return false;
     }
+    if ( m_renditions.isEmpty() == false &&
+         ( m_benchmark == true || m_xml == true || m_streamUrl.isEmpty() == false ||
+           m_nodesFileName.isEmpty() == false || m_stems.isEmpty() == false ) )
+    {
+        fprintf( stderr, "--rendition only applies to the exports to files\n" );
+        return false;
+    }
+    return true;
+}
+
+void
+ConsoleRenderer::usage( QTextStream& out )
+{
+    out << "\t[--render project --out file]\trender a project without the GUI\n"
+        << "\t\t[--size WxH]\t\toverride the project's resolution\n"
+        << "\t\t[--vbitrate kbps]\toverride the video bitrate\n"
+        << "\t\t[--abitrate kbps]\toverride the audio bitrate\n"
+        << "\t\t[--vcodec name]\t\tvideo encoder, as known by libavcodec\n"
+        << "\t\t[--acodec name]\t\taudio encoder, as known by libavcodec\n"
+        << "\t\t[--threads n]\t\tencoding and rendering threads\n"
+        << "\t\t[--range begin:end]\tonly render these frames, end excluded\n"
+        << "\t\t[--gop frames]\t\tmaximum distance between keyframes\n"
+        << "\t\t[--two-pass]\t\tanalyze the video in a first pass, reused by the next exports\n"
+        << "\t\t[--map-path from=to]\tread the medias under from in to instead\n"
+        << "\t\t[--stem file=t1,t2...]\talso write these tracks' audio to file, and only the\n"
+        << "\t\t\t\t\taudio mix to the output file, as WAV\n"
+        << "\t\t[--rendition file=WxH[@fps][:kbps]]\talso export this size, frame rate or\n"
+        << "\t\t\t\t\tvideo bitrate to file, may be repeated. The renditions\n"
+        << "\t\t\t\t\tof a frame rate share a decoding pass with vlmc/RenderFanOut\n"
+        << "\t\t[--nodes file.json]\tsplit the render accross these render nodes\n"
+        << "\t\t[--frame-hashes file]\twrite a hash of each rendered frame to file\n"
+        << "\t\t[--verify-hashes file]\tfail if a frame differs from the hashes of a\n"
+        << "\t\t\t\t\tsingle pass render, as written by --frame-hashes\n"
+        << "\t\t[--benchmark]\t\trender without encoding, and report the frame times\n"
+        << "\t\t[--stream url]\t\tsend the project live to an rtmp:// or srt:// url instead\n"
+        << "\t\t[--stats]\t\talso report the memory held by each subsystem\n"
+        << "\t\t[--xml]\t\t\twrite the sequence as MLT XML for melt, instead of rendering it\n"
+        << "\t\t[--xml-split frames]\tsame as --xml, in a file per range of that many frames\n";
 }
 
 void
 ConsoleRenderer::startRender()
 {
     auto project = Core::instance()->project();
-    Core::instance()->workflowRenderer()->startRenderToFile( m_outputFileName,
-                                                             project->width(),
-                                                             project->height(),
-                                                             project->fps(),
-                                                             project->aspectRatio(),
-                                                             project->videoBitrate(),
-                                                             project->audioBitrate(),
-                                                             project->nbChannels(),
-                                                             project->sampleRate()
-                                                             );
+    Core::instance()->library()->setPathMappings( m_pathMappings );
+    if ( project->load( m_projectFileName ) == false )
+    {
+        vlmcCritical() << "Can't load project" << m_projectFileName;
+        exit( ProjectError );
+        return;
+    }
+    auto workflow = Core::instance()->workflow();
+    if ( workflow->canRender() == false )
+    {
+        vlmcCritical() << "There is nothing to render in" << m_projectFileName;
+        exit( ProjectError );
+        return;
+    }
+
+    int aspectNum;
+    int aspectDen;
+    if ( MainWorkflow::parseAspectRatio( project->aspectRatio(), aspectNum, aspectDen ) == false )
+    {
+        vlmcCritical() << "Invalid aspect ratio" << project->aspectRatio() << "in" << m_projectFileName;
+        exit( ProjectError );
+        return;
+    }
+    RenderParameters params{ m_outputFileName,
+                m_width > 0 ? m_width : project->width(),
+                m_height > 0 ? m_height : project->height(),
+                project->fps(), aspectNum, aspectDen,
+                m_videoBitrate > 0 ? m_videoBitrate : project->videoBitrate(),
+                m_audioBitrate > 0 ? m_audioBitrate : project->audioBitrate(),
+                project->nbChannels(), project->sampleRate(), project->encoderOptions() };
+    if ( m_videoCodec.isEmpty() == false )
+        params.encoder.videoCodec = m_videoCodec.toStdString();
+    if ( m_audioCodec.isEmpty() == false )
+        params.encoder.audioCodec = m_audioCodec.toStdString();
+    if ( m_threads > 0 )
+    {
+        params.encoder.encoderThreads = m_threads;
+        params.encoder.renderThreads = m_threads;
+    }
+    if ( m_gopSize > 0 )
+        params.encoder.gopSize = m_gopSize;
+    if ( m_twoPass == true )
+        params.encoder.twoPass = true;
+    for ( const auto& value : m_stems )
+    {
+        StemParameters  stem;
+        parseStem( value, stem );
+        params.stems.append( stem );
+    }
+    params.frameHashFile = m_frameHashFile;
+    params.referenceHashFile = m_referenceHashFile;
+
+    m_timer.start();
+    if ( m_xml == true )
+    {
+        exportXml();
+        return;
+    }
+    if ( m_benchmark == true )
+    {
+        startBenchmark( params );
+        return;
+    }
+    if ( m_streamUrl.isEmpty() == false )
+    {
+        startStream( params );
+        return;
+    }
+    if ( m_nodesFileName.isEmpty() == false )
+    {
+        startDistributedRender( params );
+        return;
+    }
+    QList<RenderParameters> renditions{ params };
+    for ( const auto& value : m_renditions )
+    {
+        auto rendition = params;
+        parseRendition( value, rendition );
+        renditions.append( rendition );
+    }
+    if ( workflow->startRender( renditions, m_rangeBegin, m_rangeEnd ).isEmpty() == true )
+        exit( RenderError );
+}
+
+void
+ConsoleRenderer::exportXml()
+{
+    auto workflow = Core::instance()->workflow();
+    QStringList files;
+    if ( m_xmlRangeLength > 0 )
+        files = workflow->exportMltXmlRanges( m_outputFileName, m_xmlRangeLength, m_rangeBegin, m_rangeEnd );
+    else if ( workflow->exportMltXml( m_outputFileName, m_rangeBegin, m_rangeEnd ) == true )
+        files << m_outputFileName;
+    if ( files.isEmpty() == true )
+    {
+        vlmcCritical() << "Failed to write the MLT XML of" << m_projectFileName;
+        exit( RenderError );
+        return;
+    }
+    QJsonObject event;
+    event["event"] = "xml";
+    event["files"] = QJsonArray::fromStringList( files );
+    report( event );
+    exit( Success );
+}
+
+void
+ConsoleRenderer::startDistributedRender( const RenderParameters& params )
+{
+    auto nodes = DistributedRender::loadNodes( m_nodesFileName );
+    if ( nodes.isEmpty() == true )
+    {
+        vlmcCritical() << "No render node to render on";
+        exit( InvalidArguments );
+        return;
+    }
+    auto end = m_rangeEnd >= 0 ? qMin( m_rangeEnd, Core::instance()->workflow()->playableLength() )
+                               : Core::instance()->workflow()->playableLength();
+    if ( end <= m_rangeBegin )
+    {
+        vlmcCritical() << "The range to render is empty";
+        exit( InvalidArguments );
+        return;
+    }
+    m_distributed = new DistributedRender( m_projectFileName, params, m_rangeBegin, end, nodes, this );
+    connect( m_distributed, &DistributedRender::progress, this, [this]( qint64 frames ) {
+        progress( frames - 1 );
+    } );
+    connect( m_distributed, &DistributedRender::finished, this, [this]( bool success ) {
+        if ( m_cancelled == true )
+            exit( Cancelled );
+        else
+            exit( success == true ? Success : RenderError );
+    } );
+    m_totalFrames = m_distributed->totalFrames();
+    QJsonObject event;
+    event["event"] = "started";
+    event["output"] = params.outputFileName;
+    event["total"] = m_totalFrames;
+    report( event );
+    if ( m_distributed->start() == false )
+        exit( RenderError );
+}
+
+void
+ConsoleRenderer::startBenchmark( const RenderParameters& params )
+{
+    auto workflow = Core::instance()->workflow();
+    auto end = m_rangeEnd >= 0 ? qMin( m_rangeEnd, workflow->playableLength() )
+                               : workflow->playableLength();
+    if ( end <= m_rangeBegin )
+    {
+        vlmcCritical() << "The range to render is empty";
+        exit( InvalidArguments );
+        return;
+    }
+    auto input = workflow->sequenceInput();
+    input->setBoundaries( m_rangeBegin, end - 1 );
+    m_totalFrames = end - m_rangeBegin;
+
+    Tools::Metrics::reset( "benchmark." );
+    m_nullOutput.reset( new Backend::MLT::MLTNullOutput( m_threads > 0 ? m_threads : 1 ) );
+    m_nullOutput->setSize( params.width, params.height );
+    m_nullOutput->connect( *input );
+
+    QJsonObject event;
+    event["event"] = "started";
+    event["total"] = m_totalFrames;
+    report( event );
+
+    // The output stops by itself once the last frame is rendered
+    auto poll = new QTimer( this );
+    connect( poll, &QTimer::timeout, this, [this, poll] {
+        const auto& frameTime = Tools::Metrics::histogram( "benchmark.frameTime" );
+        if ( m_nullOutput->isStopped() == false )
+        {
+            progress( frameTime.count() - 1 );
+            return;
+        }
+        poll->stop();
+        auto elapsed = m_timer.elapsed();
+        QJsonObject event;
+        event["event"] = "benchmark";
+        event["frames"] = static_cast<qint64>( frameTime.count() );
+        event["fps"] = elapsed > 0 ? frameTime.count() * 1000.0 / elapsed : 0.0;
+        event["msPerFrame"] = frameTime.mean() / 1000;
+        event["p95Ms"] = frameTime.percentile( 0.95 ) / 1000.0;
+        event["maxMs"] = frameTime.max() / 1000.0;
+        report( event );
+        exit( m_cancelled == true ? Cancelled : Success );
+    } );
+    m_timer.start();
+    m_nullOutput->start();
+    poll->start( 100 );
+}
+
+void
+ConsoleRenderer::startStream( const RenderParameters& params )
+{
+    auto workflow = Core::instance()->workflow();
+    auto end = m_rangeEnd >= 0 ? qMin( m_rangeEnd, workflow->playableLength() )
+                               : workflow->playableLength();
+    if ( end <= m_rangeBegin )
+    {
+        vlmcCritical() << "The range to stream is empty";
+        exit( InvalidArguments );
+        return;
+    }
+    auto input = workflow->sequenceInput();
+    input->setBoundaries( m_rangeBegin, end - 1 );
+    m_totalFrames = end - m_rangeBegin;
+
+    try
+    {
+        m_streamOutput.reset( new Backend::MLT::MLTStreamOutput( qPrintable( m_streamUrl ) ) );
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcCritical() << "Can't stream to" << m_streamUrl;
+        exit( RenderError );
+        return;
+    }
+    m_streamOutput->setWidth( params.width );
+    m_streamOutput->setHeight( params.height );
+    m_streamOutput->setFrameRate( params.fps * 100, 100 );
+    m_streamOutput->setAspectRatio( params.aspectNum, params.aspectDen );
+    m_streamOutput->setVideoBitrate( params.videoBitrate );
+    m_streamOutput->setAudioBitrate( params.audioBitrate );
+    m_streamOutput->setChannels( params.nbChannels );
+    m_streamOutput->setAudioSampleRate( params.sampleRate );
+    // The low latency settings are kept, unless asked otherwise
+    Backend::EncoderOptions encoder;
+    encoder.videoCodec = m_videoCodec.toStdString();
+    encoder.audioCodec = m_audioCodec.toStdString();
+    encoder.encoderThreads = m_threads;
+    encoder.renderThreads = m_threads > 0 ? m_threads : 1;
+    encoder.dropFrames = true;
+    encoder.gopSize = m_gopSize;
+    m_streamOutput->setEncoderOptions( encoder );
+
+    m_streamWatcher = new OutputEventWatcher( this );
+    connect( m_streamWatcher, &OutputEventWatcher::framesDropped, this, [this]( quint32 nbDropped ) {
+        m_droppedFrames += nbDropped;
+    } );
+    m_streamOutput->setCallback( m_streamWatcher );
+    if ( m_streamOutput->connect( *input ) == false )
+    {
+        exit( RenderError );
+        return;
+    }
+
+    QJsonObject event;
+    event["event"] = "started";
+    event["output"] = m_streamUrl;
+    event["total"] = m_totalFrames;
+    report( event );
+
+    auto poll = new QTimer( this );
+    connect( poll, &QTimer::timeout, this, [this, poll] {
+        const auto& frameTime = Tools::Metrics::histogram( "export.frameTime" );
+        if ( m_streamOutput->isStopped() == false )
+        {
+            progress( frameTime.count() - 1 );
+            return;
+        }
+        poll->stop();
+        QJsonObject event;
+        event["event"] = "stream";
+        event["frames"] = static_cast<qint64>( frameTime.count() );
+        event["dropped"] = m_droppedFrames;
+        report( event );
+        exit( m_cancelled == true ? Cancelled : Success );
+    } );
+    Tools::Metrics::reset( "export." );
+    m_timer.start();
+    m_streamOutput->start();
+    poll->start( 100 );
+}
+
+void
+ConsoleRenderer::jobStarted( RenderJob* job )
+{
+    m_totalFrames = job->totalFrames();
+    m_timer.start();
+    connect( job, &RenderJob::progress, this, &ConsoleRenderer::progress );
+    QJsonObject event;
+    event["event"] = "started";
+    event["output"] = job->parameters().outputFileName;
+    event["total"] = m_totalFrames;
+    report( event );
+}
+
+void
+ConsoleRenderer::progress( qint64 frame )
+{
+    if ( m_totalFrames <= 0 )
+        return;
+    auto done = frame + 1;
+    auto percent = static_cast<int>( done * 100 / m_totalFrames );
+    auto elapsed = m_timer.elapsed();
+    // At most once a second, unless the percentage changed
+    if ( percent == m_percent && elapsed - m_lastReport < 1000 )
+        return;
+    m_percent = percent;
+    m_lastReport = elapsed;
+
+    QJsonObject event;
+    event["event"] = "progress";
+    event["frame"] = done;
+    event["total"] = m_totalFrames;
+    event["percent"] = percent;
+    if ( elapsed > 0 )
+    {
+        auto fps = done * 1000.0 / elapsed;
+        event["fps"] = fps;
+        event["eta"] = static_cast<qint64>( ( m_totalFrames - done ) / fps );
+    }
+    if ( m_streamOutput != nullptr )
+        event["dropped"] = m_droppedFrames;
+    report( event );
+    reportStats();
+}
+
+void
+ConsoleRenderer::jobFinished( RenderJob* job, bool success )
+{
+    if ( success == false )
+    {
+        vlmcCritical() << "Failed to render" << job->parameters().outputFileName;
+        m_failed = true;
+    }
+}
+
+void
+ConsoleRenderer::signalReceived()
+{
+#ifdef Q_OS_UNIX
+    char c;
+    auto res = ::read( signalFds[1], &c, sizeof( c ) );
+    Q_UNUSED( res );
+#endif
+    if ( m_cancelled == true )
+        return;
+    vlmcWarning() << "Cancelling the render";
+    m_cancelled = true;
+    if ( m_nullOutput != nullptr )
+        m_nullOutput->stop();
+    else if ( m_streamOutput != nullptr )
+        m_streamOutput->stop();
+    else if ( m_distributed != nullptr )
+        m_distributed->cancel();
+    else if ( Core::instance()->renderQueue()->nbPendingJobs() == 0 &&
+         Core::instance()->renderQueue()->nbRunningJobs() == 0 )
+        exit( Cancelled );
+    else
+        Core::instance()->renderQueue()->cancelAll();
+}
+
+void
+ConsoleRenderer::report( const QJsonObject& event ) const
+{
+    fprintf( stdout, "%s\n", QJsonDocument( event ).toJson( QJsonDocument::Compact ).constData() );
+    fflush( stdout );
+}
+
+void
+ConsoleRenderer::reportStats() const
+{
+    if ( m_stats == false )
+        return;
+    QJsonObject event;
+    event["event"] = "stats";
+    event["memory"] = Tools::Metrics::toJson( "memory." );
+    report( event );
+}
+
+void
+ConsoleRenderer::exit( ExitCode code )
+{
+    if ( m_done == true )
+        return;
+    m_done = true;
+    reportStats();
+    QJsonObject event;
+    event["event"] = "finished";
+    event["success"] = code == Success;
+    event["code"] = code;
+    event["elapsed"] = m_timer.isValid() == true ? m_timer.elapsed() / 1000.0 : 0.0;
+    report( event );
+    QCoreApplication::exit( code );
 }
@@ -23,27 +23,139 @@
 #ifndef CONSOLERENDERER_H
 #define CONSOLERENDERER_H
 
-class   WorkflowFileRenderer;
-
+#include <QElapsedTimer>
+#include <QMap>
 #include <QObject>
 #include <QString>
+#include <QStringList>
+
+#include <memory>
+
+class QJsonObject;
+class QSocketNotifier;
+class QTextStream;
+
+namespace Backend
+{
+namespace MLT
+{
+class MLTNullOutput;
+class MLTStreamOutput;
+}
+}
+class DistributedRender;
+class OutputEventWatcher;
+class RenderJob;
+struct RenderParameters;
 
+/**
+ *  \brief  Renders a project without any GUI, for scripts and render nodes.
+ *
+ *  vlmc --render project.vlmc --out file [options]
+ *
+ *  The project's export settings can be overridden from the command line. With a list
+ *  of render nodes, the render is split accross them. \sa DistributedRender
+ *  With --benchmark, the frames are rendered and discarded, to time the rendering alone.
+ *  With --stream, the project is sent live to an RTMP or SRT server instead.
+ *  With --stem, only the audio is exported: the master mix to the output file, and a
+ *  file per group of tracks.
+ *  With --rendition, more sizes or bitrates of the project are exported at once.
+ *  Progress is
+ *  reported on stdout, as one JSON object per line, while the log goes to stderr.
+ *  SIGINT and SIGTERM cancel the render; the process exits with one of ExitCode.
+ */
 class ConsoleRenderer : public QObject
 {
     Q_OBJECT
 
 public:
+    // 2 is avoided: the crash handler restarts VLMC when it gets it
+    enum ExitCode
+    {
+        Success = 0,
+        InvalidArguments = 1,
+        ProjectError = 3,
+        RenderError = 4,
+        Cancelled = 5,
+    };
+
     explicit ConsoleRenderer( QObject *parent = 0 );
+    ~ConsoleRenderer();
+
+    /**
+     *  \brief  Reads the render options. Prints why on stderr and returns false if they
+     *          are invalid.
+     */
+    bool        parseArguments( const QStringList& args );
+    static void usage( QTextStream& out );
 
 public slots:
+    /**
+     *  \brief  Loads the project and queues its export. The application exits once done.
+     */
     void        startRender();
 
-private slots:
-    void        frameChanged( qint64 frame ) const;
+private:
+    void        jobStarted( RenderJob* job );
+    void        progress( qint64 frame );
+    void        jobFinished( RenderJob* job, bool success );
+    void        signalReceived();
+    void        report( const QJsonObject& event ) const;
+    // The memory accounts, along with the progress, when asked for with --stats
+    void        reportStats() const;
+    void        exit( ExitCode code );
+    void        startDistributedRender( const RenderParameters& params );
+    void        startBenchmark( const RenderParameters& params );
+    void        startStream( const RenderParameters& params );
+    void        exportXml();
 
 private:
-    WorkflowFileRenderer    *m_renderer;
+    QString                 m_projectFileName;
     QString                 m_outputFileName;
+    // 0 for the project's settings
+    quint32                 m_width;
+    quint32                 m_height;
+    quint32                 m_videoBitrate;
+    quint32                 m_audioBitrate;
+    QString                 m_videoCodec;
+    QString                 m_audioCodec;
+    int                     m_threads;
+    int                     m_gopSize;
+    // Media path prefixes to rewrite
+    QMap<QString, QString>  m_pathMappings;
+    QString                 m_nodesFileName;
+    // In frames, end excluded. A negative end renders the whole project
+    qint64                  m_rangeBegin;
+    qint64                  m_rangeEnd;
+    bool                    m_benchmark;
+    bool                    m_twoPass;
+    bool                    m_stats;
+    // Writes MLT XML to the output file, in ranges of m_xmlRangeLength frames if positive
+    bool                    m_xml;
+    qint64                  m_xmlRangeLength;
+    QString                 m_streamUrl;
+    // "file=track,track...", exporting the audio alone. \sa StemExport
+    QStringList             m_stems;
+    // "file=WxH[@fps][:kbps]", exported along with the output file.
+    // \sa MainWorkflow::startRender()
+    QStringList             m_renditions;
+    // \sa RenderParameters::frameHashFile
+    QString                 m_frameHashFile;
+    QString                 m_referenceHashFile;
+
+    qint64                  m_totalFrames;
+    int                     m_percent;
+    QElapsedTimer           m_timer;
+    qint64                  m_lastReport;
+    bool                    m_failed;
+    bool                    m_cancelled;
+    bool                    m_done;
+    QSocketNotifier*        m_signalNotifier;
+    DistributedRender*      m_distributed;
+    std::unique_ptr<Backend::MLT::MLTNullOutput>    m_nullOutput;
+    std::unique_ptr<Backend::MLT::MLTStreamOutput>  m_streamOutput;
+    OutputEventWatcher*     m_streamWatcher;
+    qint64                  m_droppedFrames;
 };
 
 #endif // CONSOLERENDERER_H
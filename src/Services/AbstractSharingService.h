@@ -42,12 +42,15 @@ class AbstractSharingService : public QObject
     public:
         virtual void    authenticate() = 0;        // Authenticate the service
         virtual bool    upload() = 0;              // Upload video
+        virtual void    cancelUpload() = 0;        // Abort the running upload, if any
 
         virtual const   AbstractVideoData& getVideoData() = 0;
 
         virtual void    setCredentials( const QString&, const QString& ) = 0;
         virtual void    setDeveloperKey( const QString& ) = 0;
         virtual void    setVideoParameters( const QString&, const AbstractVideoData& ) = 0;
+        // The video file is still being written, and may be uploaded as it grows
+        virtual void    setFileGrowing( bool ) = 0;
 
     signals:
         void            authOver();
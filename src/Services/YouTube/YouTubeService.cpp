@@ -47,6 +47,7 @@ YouTubeService::YouTubeService( const QString& devKey,
     m_devKey   = devKey;
     m_username = username;
     m_password = password;
+    m_fileGrowing = false;
 
     /* Pointers for Authenticator and Uploader Objects */
     m_auth     = nullptr;
@@ -96,6 +97,7 @@ YouTubeService::upload()
             m_uploader->setVideoFile( m_fileName );
 
         m_uploader->setVideoData( m_videoData );
+        m_uploader->setFileGrowing( m_fileGrowing );
 
         /* Tell world on successful uploading */
         connect( m_uploader, SIGNAL( uploadOver( QString ) ),
@@ -110,6 +112,13 @@ YouTubeService::upload()
     return false;
 }
 
+void
+YouTubeService::cancelUpload()
+{
+    if( m_uploader )
+        m_uploader->cancel();
+}
+
 const QString&
 YouTubeService::getAuthString()
 {
@@ -148,6 +157,14 @@ YouTubeService::setVideoParameters( const QString& fileName, const VideoData& da
     m_videoData = data;
 }
 
+void
+YouTubeService::setFileGrowing( bool growing )
+{
+    m_fileGrowing = growing;
+    if( m_uploader )
+        m_uploader->setFileGrowing( growing );
+}
+
 void
 YouTubeService::authError( QString e )
 {
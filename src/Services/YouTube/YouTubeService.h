@@ -53,12 +53,14 @@ class YouTubeService : public AbstractSharingService
         /* Service Interfaces */
         void authenticate();            // Authenticate the service
         bool upload();                  // Upload video
+        void cancelUpload();            // Abort the running upload
 
         const VideoData& getVideoData();
 
         void setCredentials( const QString& username, const QString& password );
         void setDeveloperKey( const QString& devKey );
         void setVideoParameters( const QString& fileName, const VideoData& data );
+        void setFileGrowing( bool growing );
 
     private:
 
@@ -71,6 +73,7 @@ class YouTubeService : public AbstractSharingService
 
         QString                m_fileName;
         VideoData              m_videoData;
+        bool                   m_fileGrowing;
 
         YouTubeAuthenticator*  m_auth;
         YouTubeUploader*       m_uploader;
@@ -24,22 +24,32 @@
 # include "config.h"
 #endif
 
-#include "Services/UploaderIODevice.h"
+#include "Tools/Metrics.h"
 #include "Tools/VlmcDebug.h"
 #include "YouTubeService.h"
 #include "YouTubeUploader.h"
 #include "YouTubeFeedParser.h"
 
 #include <QByteArray>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QSettings>
 #include <QString>
 #include <QStringList>
-#include <QUrl>
+#include <QTimer>
 
 using namespace YouTube;
 
 YouTubeUploader::YouTubeUploader( YouTubeService* service,
                                   const QString& fileName )
+    : m_offset( 0 )
+    , m_retries( 0 )
+    , m_reply( nullptr )
+    , m_fileGrowing( false )
 {
     /* Stores pointer to main service object and video file path */
     m_service  = service;
@@ -52,26 +62,24 @@ YouTubeUploader::YouTubeUploader( YouTubeService* service,
     connect( m_nam, SIGNAL( sslErrors( QNetworkReply*, QList<QSslError> ) ),
              m_service, SLOT( sslErrors( QNetworkReply*, QList<QSslError> ) ) );
     #endif
+    connect( m_nam, &QNetworkAccessManager::finished, this, &YouTubeUploader::replyFinished );
+
+    m_pollTimer.setSingleShot( true );
+    m_pollTimer.setInterval( GrowingPollInterval );
+    connect( &m_pollTimer, &QTimer::timeout, this, [this] { sendChunk( m_offset ); } );
 
-    /* Pointer for custom IODevice needed to upload video */
-    m_ioDevice = nullptr;
     uploadInit();
 }
 
 YouTubeUploader::~YouTubeUploader()
 {
-    /* Checks and deletes objects */
+    /* Pending replies are aborted, the session stays saved for later */
     delete m_nam;
-    if( m_ioDevice )
-        delete m_ioDevice;
 }
 
 void
 YouTubeUploader::uploadInit()
 {
-    /* Random 10 digit boundary string, as per protocol */
-    m_boundary = QString( QString::number( qrand(), 10 ).toLatin1() );
-
     QString privateToken = "";
 
     if( m_videoData.isPrivate )
@@ -101,46 +109,223 @@ YouTubeUploader::uploadInit()
 bool
 YouTubeUploader::upload()
 {
-    /* Creates IODevice with all details */
-    if( !m_ioDevice )
-        m_ioDevice = new UploaderIODevice( this, m_fileName,
-                                           getMimeHead(), getMimeTail() );
+    m_file.close();
+    m_file.setFileName( m_fileName );
+    if( m_file.open( QFile::ReadOnly ) == false ||
+        ( m_file.size() == 0 && m_fileGrowing == false ) )
+    {
+        vlmcDebug() << "[YT UPLOADER]: File opening failed.";
+        return false;
+    }
+    m_service->m_state = UploadStart;
+    m_offset = 0;
+    m_retries = 0;
+
+    /* A previous upload of this file was interrupted. A growing file can't be
+       identified across runs, its session isn't saved */
+    if( m_fileGrowing == false && loadSession() == true )
+    {
+        vlmcDebug() << "[YT UPLOADER]: Resuming the upload of" << m_fileName;
+        queryStatus();
+    }
+    else
+        startSession();
+    return true;
+}
+
+void
+YouTubeUploader::startSession()
+{
+    m_sessionUrl.clear();
+    QNetworkRequest request = getNetworkRequest( QUrl( UPLOAD_URL ) );
+    request.setHeader( QNetworkRequest::ContentTypeHeader, "application/atom+xml; charset=UTF-8" );
+    m_reply = m_nam->post( request, API_XML_REQUEST.toUtf8() );
+}
+
+void
+YouTubeUploader::sendChunk( qint64 offset )
+{
+    m_offset = offset;
+    if( m_fileGrowing == true && m_file.size() - offset < ChunkSize )
+    {
+        m_pollTimer.start();
+        return;
+    }
+    /* Everything was sent while the file was growing, only the size is missing */
+    if( m_fileGrowing == false && offset == m_file.size() )
+    {
+        queryStatus();
+        return;
+    }
+    auto size = qMin( ChunkSize, m_file.size() - offset );
+    if( size <= 0 )
+    {
+        fail();
+        return;
+    }
+    /* The chunk is sent straight from the mapping, without being copied in between.
+       Reading it is the fallback for files which can't be mapped */
+    QByteArray data;
+    auto mapped = m_file.map( offset, size );
+    if( mapped != nullptr )
+        data = QByteArray::fromRawData( reinterpret_cast<const char*>( mapped ), size );
     else
-        m_ioDevice->setFile( m_fileName );
+    {
+        if( m_file.seek( offset ) == false )
+        {
+            fail();
+            return;
+        }
+        data = m_file.read( size );
+        if( data.size() != size )
+        {
+            fail();
+            return;
+        }
+    }
+
+    QNetworkRequest request = getNetworkRequest( m_sessionUrl );
+    request.setHeader( QNetworkRequest::ContentTypeHeader, "application/octet-stream" );
+    request.setRawHeader( "Content-Range", QString( "bytes %1-%2/%3" ).arg( offset )
+                          .arg( offset + data.size() - 1 ).arg( totalSize() ).toLatin1() );
+    m_chunkTimer.start();
+    QNetworkReply* reply = m_nam->put( request, data );
+    m_reply = reply;
+    /* The request body references the mapping for as long as the reply lives */
+    if( mapped != nullptr )
+        connect( reply, &QObject::destroyed, this, [this, mapped] { m_file.unmap( mapped ); } );
+    connect( reply, &QNetworkReply::uploadProgress, this, [this]( qint64 sent, qint64 ) {
+        emit uploadProgress( m_offset + sent, m_file.size() );
+    } );
+}
+
+void
+YouTubeUploader::queryStatus()
+{
+    QNetworkRequest request = getNetworkRequest( m_sessionUrl );
+    request.setHeader( QNetworkRequest::ContentLengthHeader, 0 );
+    request.setRawHeader( "Content-Range", QString( "bytes */%1" ).arg( totalSize() ).toLatin1() );
+    m_reply = m_nam->put( request, QByteArray() );
+}
 
-    /* Creates HTTP header */
-    QNetworkRequest request = getNetworkRequest();
-    request.setHeader( QNetworkRequest::ContentLengthHeader, m_ioDevice->size() );
-    request.setRawHeader( "Connection", "close" );
+QString
+YouTubeUploader::totalSize()
+{
+    if( m_fileGrowing == true )
+        return "*";
+    return QString::number( m_file.size() );
+}
 
-    /* Tries to open file and send a HTTP POST */
-    if( m_ioDevice->openFile() )
+void
+YouTubeUploader::replyFinished( QNetworkReply* reply )
+{
+    reply->deleteLater();
+    if( reply == m_reply )
+        m_reply = nullptr;
+    auto status = reply->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt();
+    auto networkError = reply->error();
+    bool creating = m_sessionUrl.isEmpty() == true;
+
+    if( networkError == QNetworkReply::OperationCanceledError )
+        return;
+
+    if( creating == true && ( status == 200 || status == 201 ) )
     {
-        QNetworkReply* reply = m_nam->post( request, m_ioDevice );
-        m_service->m_state = UploadStart;
+        m_sessionUrl = reply->header( QNetworkRequest::LocationHeader ).toUrl();
+        if( m_sessionUrl.isValid() == false )
+        {
+            vlmcWarning() << "[YT UPLOADER]: No upload session was returned";
+            fail();
+            return;
+        }
+        if( m_fileGrowing == false )
+            saveSession();
+        m_retries = 0;
+        sendChunk( 0 );
+        return;
+    }
 
-        connect( reply, SIGNAL( finished() ),
-                 this, SLOT( uploadFinished() ) );
-        connect( reply, SIGNAL( uploadProgress( qint64, qint64 ) ),
-                 this, SIGNAL( uploadProgress( qint64, qint64 ) ) );
-        connect( reply, SIGNAL( error( QNetworkReply::NetworkError ) ),
-                 m_service, SLOT( networkError( QNetworkReply::NetworkError ) ) );
+    /* Done, the server replies with the video entry */
+    if( creating == false && ( status == 200 || status == 201 ) )
+    {
+        finish( reply->readAll() );
+        return;
+    }
+
+    /* Resume Incomplete: the Range header tells what the server has */
+    if( creating == false && status == 308 )
+    {
+        qint64 next = 0;
+        auto range = QString::fromLatin1( reply->rawHeader( "Range" ) );
+        if( range.isEmpty() == false )
+            next = range.section( '-', 1 ).toLongLong() + 1;
+        if( next > m_offset && m_chunkTimer.isValid() == true )
+        {
+            auto elapsed = m_chunkTimer.nsecsElapsed() / 1000;
+            Tools::Metrics::counter( "upload.bytes" ).add( next - m_offset );
+            Tools::Metrics::histogram( "upload.chunkTime" ).record( elapsed );
+            if( elapsed > 0 )
+                Tools::Metrics::gauge( "upload.throughput" ).set( ( next - m_offset ) * 1e6 / elapsed );
+            m_retries = 0;
+        }
+        m_chunkTimer.invalidate();
+        emit uploadProgress( next, m_file.size() );
+        sendChunk( next );
+        return;
+    }
+
+    /* The session expired, or was never known: start over */
+    if( creating == false && ( status == 404 || status == 410 ) )
+    {
+        vlmcWarning() << "[YT UPLOADER]: The upload session expired, restarting";
+        clearSession();
+        startSession();
+        return;
+    }
 
-        return true;
+    /* Transient errors are retried, others aren't going to get better */
+    if( networkError != QNetworkReply::NoError && status == 0 )
+        vlmcDebug() << "[YT UPLOADER]: Network error" << networkError;
+    else if( status < 500 && status != 408 && status != 429 )
+    {
+        vlmcWarning() << "[YT UPLOADER]: Upload rejected with status" << status << reply->readAll();
+        clearSession();
+        fail();
+        return;
     }
-    vlmcDebug() << "[YT UPLOADER]: File opening failed.";
-    return false;
+    retry();
 }
 
 void
-YouTubeUploader::uploadFinished()
+YouTubeUploader::retry()
 {
-    /* Captures data received after uploading the video */
-    QNetworkReply *reply = static_cast<QNetworkReply *>( sender() );
-    const QByteArray data = reply->readAll();
+    m_chunkTimer.invalidate();
+    if( ++m_retries > MaxRetries )
+    {
+        vlmcWarning() << "[YT UPLOADER]: Giving up after" << MaxRetries << "retries";
+        fail();
+        return;
+    }
+    Tools::Metrics::counter( "upload.retries" ).add();
+    /* 1s, 2s, 4s... up to a minute, plus some jitter */
+    auto delay = qMin( 1 << ( m_retries - 1 ), 64 ) * 1000 + qrand() % 1000;
+    vlmcDebug() << "[YT UPLOADER]: Retrying in" << delay << "ms";
+    QTimer::singleShot( delay, this, [this] {
+        if( m_sessionUrl.isEmpty() == true )
+            startSession();
+        else
+            queryStatus();
+    } );
+}
 
+void
+YouTubeUploader::finish( const QByteArray& data )
+{
     vlmcDebug() << "In YouTubeUploader::uploadFinished: data received = " << data;
+    Tools::Metrics::counter( "upload.bytes" ).add( m_file.size() - m_offset );
     m_service->m_state = UploadFinish;
+    clearSession();
+    m_file.close();
 
     /* Feed parser called to parse the XML data received */
     YouTubeFeedParser parser( data );
@@ -154,28 +339,66 @@ YouTubeUploader::uploadFinished()
         videoUrl = ""; /* Some error may've occured at YouTube */
 
     emit uploadOver( QString( videoUrl ) );
+}
 
-    disconnect( reply, SIGNAL( finished() ),
-                this, SLOT( uploadFinished() ) );
-    disconnect( reply, SIGNAL( uploadProgress( qint64, qint64 ) ),
-                this, SIGNAL( uploadProgress( qint64, qint64 ) ) );
-    disconnect( reply, SIGNAL( error( QNetworkReply::NetworkError ) ),
-                m_service, SLOT( networkError( QNetworkReply::NetworkError ) ) );
+void
+YouTubeUploader::cancel()
+{
+    if( m_file.isOpen() == false )
+        return;
+    m_pollTimer.stop();
+    if( m_reply != nullptr )
+        m_reply->abort();
+    clearSession();
+    fail();
+}
 
-    reply->close();
-    reply->deleteLater();
+void
+YouTubeUploader::fail()
+{
+    /* The session is kept, if any, so that a later upload resumes */
+    m_service->m_state = UploadFinish;
+    m_pollTimer.stop();
+    m_file.close();
+    emit uploadOver( QString() );
+}
 
-    if( m_ioDevice )
-        delete m_ioDevice;
+QString
+YouTubeUploader::sessionKey() const
+{
+    /* A modified file doesn't resume its previous upload */
+    QFileInfo   info( m_fileName );
+    auto id = info.absoluteFilePath() + '|' + QString::number( info.size() ) + '|' +
+            QString::number( info.lastModified().toMSecsSinceEpoch() );
+    return "YouTubeUploads/" +
+            QCryptographicHash::hash( id.toUtf8(), QCryptographicHash::Sha1 ).toHex();
+}
 
-    m_ioDevice = nullptr;
+bool
+YouTubeUploader::loadSession()
+{
+    QSettings   s;
+    m_sessionUrl = s.value( sessionKey() ).toUrl();
+    return m_sessionUrl.isValid() == true && m_sessionUrl.isEmpty() == false;
 }
 
-QNetworkRequest
-YouTubeUploader::getNetworkRequest()
+void
+YouTubeUploader::saveSession()
+{
+    QSettings   s;
+    s.setValue( sessionKey(), m_sessionUrl );
+}
+
+void
+YouTubeUploader::clearSession()
 {
-    QUrl url( UPLOAD_URL );
+    QSettings   s;
+    s.remove( sessionKey() );
+}
 
+QNetworkRequest
+YouTubeUploader::getNetworkRequest( const QUrl& url )
+{
     QNetworkRequest request;
     request.setUrl(url);
 
@@ -191,39 +414,11 @@ YouTubeUploader::getNetworkRequest()
                           .append( m_service->getDeveloperKey() ) );
 
     /* Name of the video, the user is uploading */
-    request.setRawHeader( "Slug", QByteArray( "" ).append( m_fileName ) );
-
-    request.setRawHeader( "Content-Type",
-                          QByteArray( "multipart/related; boundary=" )
-                          .append( m_boundary ) );
+    request.setRawHeader( "Slug", QFileInfo( m_fileName ).fileName().toUtf8() );
 
     return request;
 }
 
-QByteArray
-YouTubeUploader::getMimeHead()
-{
-    /* Head ByteArray data, as per the protocol */
-    QByteArray data;
-    data.append( "\r\n\r\n--" + m_boundary + "\r\n" );
-    data.append( "Content-Type: application/atom+xml; charset=UTF-8\r\n\r\n" );
-    data.append( API_XML_REQUEST );
-    data.append( "--" + m_boundary + "\r\n" );
-    data.append( "Content-Type: application/octet-stream\r\nContent-Transfer-Encoding: binary\r\n\r\n" );
-
-    return data;
-}
-
-QByteArray
-YouTubeUploader::getMimeTail()
-{
-    /* Tail ByteArray data, as per the protocol */
-    QByteArray data;
-    data.append( "\r\n--" + m_boundary + "--\r\n\r\n" );
-
-    return data;
-}
-
 const VideoData&
 YouTubeUploader::getVideoData()
 {
@@ -242,6 +437,18 @@ YouTubeUploader::setVideoFile( const QString& fileName )
     m_fileName = fileName;
 }
 
+void
+YouTubeUploader::setFileGrowing( bool growing )
+{
+    m_fileGrowing = growing;
+    /* The remaining bytes, however few, can now be sent */
+    if( growing == false && m_pollTimer.isActive() == true )
+    {
+        m_pollTimer.stop();
+        sendChunk( m_offset );
+    }
+}
+
 void
 YouTubeUploader::setVideoData( const VideoData& data )
 {
@@ -25,50 +25,93 @@
 
 #include "YouTubeCommon.h"
 
+#include <QElapsedTimer>
+#include <QFile>
 #include <QObject>
+#include <QTimer>
+#include <QUrl>
 
-#define UPLOAD_URL "http://uploads.gdata.youtube.com/feeds/api/users/default/uploads"
+#define UPLOAD_URL "http://uploads.gdata.youtube.com/resumable/feeds/api/users/default/uploads"
 #define VIDEO_URL  "http://www.youtube.com/watch?v="
 
-class QIODevice;
 class QNetworkAccessManager;
+class QNetworkReply;
 class QNetworkRequest;
-class UploaderIODevice;
 class YouTubeService;
 
+/**
+ *  \brief  Uploads a video with the resumable upload protocol.
+ *
+ *  The metadata opens an upload session, then the file is sent in fixed size chunks.
+ *  After a network error, or a server side one, the server is asked how much it
+ *  received and the upload resumes from there, after an exponential backoff.
+ *  The session is remembered until the upload completes, so an upload interrupted
+ *  by closing VLMC resumes the next time the same file is uploaded.
+ *  A file which is still being written can be uploaded as it grows: only full chunks
+ *  are sent, with an unknown total size, until setFileGrowing( false ) is called.
+ */
 class YouTubeUploader : public QObject
 {
     Q_OBJECT
 
     public:
+        // A multiple of 256KiB, as required by the protocol
+        static const qint64     ChunkSize = 8 * 1024 * 1024;
+        static const int        MaxRetries = 8;
+        // How often a growing file is checked for a new chunk, in milliseconds
+        static const int        GrowingPollInterval = 500;
+
         YouTubeUploader( YouTubeService* service = 0, const QString& fileName = "" );
         ~YouTubeUploader();
 
         bool upload();
+        // Aborts the upload, and forgets its session
+        void cancel();
 
         void setServiceProvider( YouTubeService* service );
         void setVideoFile( const QString& fileName );
         void setVideoData( const VideoData& data );
+        void setFileGrowing( bool growing );
         
-        QNetworkRequest         getNetworkRequest();
-        QByteArray              getMimeHead();
-        QByteArray              getMimeTail();
+        QNetworkRequest         getNetworkRequest( const QUrl& url );
         const VideoData&        getVideoData();
 
     private:
         void                    uploadInit();
+        // Opens a new upload session, with the video metadata
+        void                    startSession();
+        void                    sendChunk( qint64 offset );
+        // Asks the server how much of the file it has
+        void                    queryStatus();
+        void                    replyFinished( QNetworkReply* reply );
+        void                    retry();
+        void                    finish( const QByteArray& feed );
+        void                    fail();
+        // The total size, as announced in the Content-Range headers
+        QString                 totalSize();
+
+        QString                 sessionKey() const;
+        bool                    loadSession();
+        void                    saveSession();
+        void                    clearSession();
 
         QString                 API_XML_REQUEST;
-        QString                 m_boundary;
         QString                 m_fileName;
         VideoData               m_videoData;
 
         YouTubeService*         m_service;
-        UploaderIODevice*       m_ioDevice;
         QNetworkAccessManager*  m_nam;
 
-    private slots:
-        void                    uploadFinished();
+        QFile                   m_file;
+        qint64                  m_offset;
+        QUrl                    m_sessionUrl;
+        int                     m_retries;
+        // Measures the throughput of the chunk being sent
+        QElapsedTimer           m_chunkTimer;
+        QNetworkReply*          m_reply;
+        bool                    m_fileGrowing;
+        // Waits for a growing file to have a full chunk to send
+        QTimer                  m_pollTimer;
 
     signals:
         void                    uploadOver( QString );
@@ -0,0 +1,124 @@
+/*****************************************************************************
+ * SettingHandle.h: Typed and pre-resolved accessor to a setting
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SETTINGHANDLE_H
+#define SETTINGHANDLE_H
+
+#include "Settings.h"
+#include "SettingValue.h"
+
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+
+/**
+ *  \brief  Typed access to a setting, which is only looked up once.
+ *
+ *  The setting is resolved either when the handle is built from its SettingValue, or
+ *  from its key on the first read. Reading an Int, Double or Bool setting is then an
+ *  atomic load, without locking the Settings nor converting a QVariant.
+ *  Other types are still read from the setting's QVariant, but skip the lookup.
+ *  The handle must not outlive the Settings owning the value.
+ */
+template <typename T>
+class SettingHandle
+{
+    public:
+        explicit SettingHandle( SettingValue* value )
+            : m_value( value )
+        {
+        }
+
+        explicit SettingHandle( const char* key, Settings* settings = nullptr )
+            : m_key( key )
+            , m_settings( settings )
+            , m_value( nullptr )
+        {
+        }
+
+        T               get() const
+        {
+            return resolve()->get().value<T>();
+        }
+
+        SettingValue*   value() const
+        {
+            return resolve();
+        }
+
+    private:
+        SettingValue*   resolve() const
+        {
+            auto value = m_value.load( std::memory_order_acquire );
+            if ( value == nullptr )
+            {
+                // Racing threads resolve the same value, either store is fine
+                auto settings = m_settings != nullptr ? m_settings : Core::instance()->settings();
+                value = settings->value( QString::fromLatin1( m_key ) );
+                m_value.store( value, std::memory_order_release );
+            }
+            return value;
+        }
+
+    private:
+        const char*                         m_key = nullptr;
+        Settings*                           m_settings = nullptr;
+        mutable std::atomic<SettingValue*>  m_value;
+};
+
+template <>
+inline bool
+SettingHandle<bool>::get() const
+{
+    return resolve()->toBool();
+}
+
+template <>
+inline int
+SettingHandle<int>::get() const
+{
+    return static_cast<int>( resolve()->toInt() );
+}
+
+template <>
+inline uint
+SettingHandle<uint>::get() const
+{
+    return static_cast<uint>( resolve()->toInt() );
+}
+
+template <>
+inline double
+SettingHandle<double>::get() const
+{
+    return resolve()->toDouble();
+}
+
+/**
+ *  \brief  A handle to an application setting, resolved on the first use of each
+ *          expansion. The key must therefore be a constant.
+ */
+#define VLMC_SETTING( type, key ) \
+        ( []() -> const SettingHandle<type>& { static const SettingHandle<type> h( key ); return h; }() )
+
+#endif // SETTINGHANDLE_H
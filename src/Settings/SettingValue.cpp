@@ -35,8 +35,11 @@ SettingValue::SettingValue( const QString& key, SettingValue::Type type, const Q
         m_desc( desc ),
         m_type( type ),
         m_flags( flags ),
-        m_initLoad( true )
+        m_initLoad( true ),
+        m_intVal( 0 ),
+        m_doubleVal( 0 )
 {
+    updateScalars();
 }
 
 void
@@ -55,6 +58,7 @@ SettingValue::set( const QVariant& _val )
         if ( ( m_flags & EightMultiple ) != 0 )
             val = ( val.toInt() + 7 ) & ~7;
         m_val = val;
+        updateScalars();
         emit changed( m_val );
     }
     else if ( m_initLoad )
@@ -68,6 +72,33 @@ SettingValue::get()
     return m_val;
 }
 
+bool
+SettingValue::toBool() const
+{
+    return m_intVal.load( std::memory_order_acquire ) != 0;
+}
+
+qint64
+SettingValue::toInt() const
+{
+    return m_intVal.load( std::memory_order_acquire );
+}
+
+double
+SettingValue::toDouble() const
+{
+    return m_doubleVal.load( std::memory_order_acquire );
+}
+
+void
+SettingValue::updateScalars()
+{
+    if ( m_type != Int && m_type != Double && m_type != Bool )
+        return;
+    m_intVal.store( m_val.toLongLong(), std::memory_order_release );
+    m_doubleVal.store( m_val.toDouble(), std::memory_order_release );
+}
+
 const char*
 SettingValue::description() const
 {
@@ -26,6 +26,8 @@
 #include <QObject>
 #include <QVariant>
 
+#include <atomic>
+
 /**
  * 'class SettingValue
  *
@@ -91,6 +93,12 @@ class   SettingValue : public QObject
          * \brief getter for the m_val member
          */
         virtual const QVariant& get(); //Not const to avoid a mess with EffectSettingValue.
+        /**
+         *  \brief Lock-free reads of Int, Double and Bool values, safe from any thread.
+         */
+        bool            toBool() const;
+        qint64          toInt() const;
+        double          toDouble() const;
         /**
          *  \return The setting's description
          */
@@ -134,6 +142,12 @@ class   SettingValue : public QObject
         QVariant        m_min;
         QVariant        m_max;
         bool            m_initLoad;
+        // Copies of m_val, for the lock-free accessors
+        std::atomic<qint64> m_intVal;
+        std::atomic<double> m_doubleVal;
+
+    private:
+        void            updateScalars();
     signals:
         /**
          * \brief This signal is emmited while the m_val
@@ -37,23 +37,105 @@
 #include <QFileInfo>
 #include <QDir>
 
+#include <QCborMap>
+#include <QCborStreamReader>
+#include <QCborValue>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QRunnable>
+#include <QSaveFile>
+
+namespace
+{
+
+/**
+ *  \brief Writes a serialized document out of the GUI thread.
+ *
+ *  QSaveFile writes to a temporary file and renames it over the target on commit, so a
+ *  crash while writing never leaves a truncated project behind.
+ */
+class SettingsWriter : public QRunnable
+{
+public:
+    SettingsWriter( Settings* settings, const QString& fileName, const QJsonDocument& doc,
+                    Settings::Format format )
+        : m_settings( settings )
+        , m_fileName( fileName )
+        , m_doc( doc )
+        , m_format( format )
+    {
+    }
+
+    virtual void run() override
+    {
+        emit m_settings->saved( write( m_fileName, m_doc, m_format ) );
+    }
+
+    static bool write( const QString& fileName, const QJsonDocument& doc, Settings::Format format )
+    {
+        QSaveFile file( fileName );
+        if ( file.open( QFile::WriteOnly ) == false )
+        {
+            vlmcWarning() << "Failed to open settings file" << fileName << "for writing";
+            return false;
+        }
+        file.write( Settings::encode( doc, format ) );
+        if ( file.commit() == false )
+        {
+            vlmcWarning() << "Failed to write settings file" << fileName << ':' << file.errorString();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    Settings*       m_settings;
+    QString         m_fileName;
+    QJsonDocument   m_doc;
+    Settings::Format    m_format;
+};
+
+// The keys of the CBOR maps are text strings, which may come in chunks
+bool
+readKey( QCborStreamReader& reader, QString& key )
+{
+    if ( reader.isString() == false )
+        return false;
+    key.clear();
+    auto r = reader.readString();
+    while ( r.status == QCborStreamReader::Ok )
+    {
+        key += r.data;
+        r = reader.readString();
+    }
+    return r.status == QCborStreamReader::EndOfString;
+}
+
+}
 
 Settings::Settings()
     : m_settingsFile( nullptr )
+    , m_dirty( true )
+    , m_format( Json )
+    , m_cborLock( QMutex::Recursive )
 {
-
+    // A single writer keeps the writes to a file in order
+    m_writer.setMaxThreadCount( 1 );
 }
 
 Settings::Settings( const QString &settingsFile )
     : m_settingsFile( nullptr )
+    , m_dirty( true )
+    , m_format( Json )
+    , m_cborLock( QMutex::Recursive )
 {
+    m_writer.setMaxThreadCount( 1 );
     setSettingsFile( settingsFile );
 }
 
 Settings::~Settings()
 {
+    m_writer.waitForDone();
     qDeleteAll( m_settings );
     delete m_settingsFile;
 }
@@ -77,24 +159,77 @@ Settings::setSettingsFile( const QString &settingsFile )
         m_settingsFile = nullptr;
 }
 
-QJsonDocument
-Settings::readSettingsFromFile()
+bool
+Settings::readSettingsFromFile( QJsonObject& top, QHash<QString, QByteArray>& sections )
 {
     if ( m_settingsFile->open( QFile::ReadOnly ) == false )
     {
         vlmcWarning() << "Failed to open settings file" << m_settingsFile->fileName();
-        return QJsonDocument( QJsonObject() );
+        return false;
+    }
+    auto data = m_settingsFile->readAll();
+    m_settingsFile->close();
+    // The binary format starts with the CBOR signature tag, which can't start a JSON document
+    if ( data.startsWith( "\xd9\xd9\xf7" ) == true )
+    {
+        m_format = Binary;
+        if ( readCbor( data, top, sections ) == false )
+        {
+            vlmcWarning() << "Failed to load binary settings file" << m_settingsFile->fileName();
+            top = QJsonObject();
+            sections.clear();
+            return false;
+        }
+        return true;
     }
     QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson( m_settingsFile->readAll(), &error );
+    QJsonDocument doc = QJsonDocument::fromJson( data, &error );
     if ( error.error != QJsonParseError::NoError )
     {
         vlmcWarning() << "Failed to load settings file" << m_settingsFile->fileName();
         vlmcWarning() << error.errorString();
-        return QJsonDocument( QJsonObject() );
+        return false;
     }
-    m_settingsFile->close();
-    return doc;
+    m_format = Json;
+    top = doc.object();
+    return true;
+}
+
+bool
+Settings::readCbor( const QByteArray& data, QJsonObject& top, QHash<QString, QByteArray>& sections ) const
+{
+    QCborStreamReader   reader( data );
+    if ( reader.isTag() == false || reader.toTag() != QCborKnownTags::Signature )
+        return false;
+    reader.next();
+    if ( reader.isMap() == false || reader.enterContainer() == false )
+        return false;
+    QString key;
+    while ( reader.lastError() == QCborError::NoError && reader.hasNext() == true )
+    {
+        if ( readKey( reader, key ) == false )
+            return false;
+        bool isChildSettings = false;
+        for ( const auto& pair : m_settingsChildren )
+        {
+            if ( pair.first == key )
+            {
+                isChildSettings = true;
+                break;
+            }
+        }
+        if ( isChildSettings == true && reader.isMap() == true )
+        {
+            // Skipped over, its bytes are only decoded once the section gets accessed
+            auto begin = reader.currentOffset();
+            if ( reader.next() == false )
+                return false;
+            sections.insert( key, data.mid( begin, reader.currentOffset() - begin ) );
+        }
+        else
+            top.insert( key, QCborValue::fromCbor( reader ).toJsonValue() );
+    }
+    return reader.lastError() == QCborError::NoError && reader.leaveContainer() == true;
 }
 
 bool
@@ -103,48 +238,128 @@ Settings::load()
     if ( m_settingsFile == nullptr )
         return false;
 
-    QJsonObject top = readSettingsFromFile().object();
+    QJsonObject                 top;
+    QHash<QString, QByteArray>  sections;
+    readSettingsFromFile( top, sections );
 
     loadJsonFrom( top );
 
     for ( const auto& child : m_settingsChildren )
     {
-        child.second->loadJsonFrom( top[ child.first ].toObject() );
+        auto it = sections.find( child.first );
+        if ( it != sections.end() )
+            child.second->loadCborFrom( *it );
+        else
+            child.second->loadJsonFrom( top[ child.first ].toObject() );
     }
 
     return true;
 }
 
 bool
-Settings::save()
+Settings::save( bool async )
 {
     if ( m_settingsFile == nullptr )
         return false;
 
     QReadLocker lock( &m_rwLock );
 
-    QJsonDocument doc = readSettingsFromFile();
-    QJsonObject top = doc.object();
+    auto doc = document( false );
+    if ( async == true )
+    {
+        m_writer.start( new SettingsWriter( this, m_settingsFile->fileName(), doc, m_format ) );
+        return true;
+    }
+    // Don't let a pending write land after this one
+    m_writer.waitForDone();
+    auto ret = SettingsWriter::write( m_settingsFile->fileName(), doc, m_format );
+    emit saved( ret );
+    return ret;
+}
+
+QJsonDocument
+Settings::snapshot()
+{
+    QReadLocker lock( &m_rwLock );
+    return document( true );
+}
 
-    saveJsonTo( top );
+QByteArray
+Settings::encode( const QJsonDocument& doc, Format format )
+{
+    if ( format == Binary )
+        return QCborValue( QCborKnownTags::Signature, QCborMap::fromJsonObject( doc.object() ) ).toCbor();
+    return doc.toJson( QJsonDocument::Compact );
+}
+
+QJsonDocument
+Settings::document( bool snapshot )
+{
+    // Start from the last loaded/saved content instead of parsing the file again, this
+    // still preserves the keys we don't know about.
+    QJsonObject top = serialize( snapshot );
 
     for ( const auto& child : m_settingsChildren )
+        top.insert( child.first, QJsonValue( child.second->serialize( snapshot ) ) );
+    return QJsonDocument( top );
+}
+
+const QJsonObject&
+Settings::serialize( bool snapshot )
+{
+    decode();
+    if ( snapshot == true )
+        emit preSnapshot();
+    else
+        emit preSave();
+    if ( m_dirty == true )
     {
-        QJsonObject object;
-        child.second->saveJsonTo( object );
-        top.insert( child.first, QJsonValue( object ) );
+        saveJsonTo( m_json );
+        m_dirty = false;
     }
+    return m_json;
+}
 
-    doc.setObject( top );
+void
+Settings::loadJsonFrom( const QJsonObject &object )
+{
+    {
+        QMutexLocker    lock( &m_cborLock );
+        m_cbor.clear();
+    }
+    applyJson( object );
+    emit postLoad();
+}
 
-    m_settingsFile->open( QFile::WriteOnly );
-    m_settingsFile->write( doc.toJson( QJsonDocument::Compact ) );
-    m_settingsFile->close();
-    return true;
+void
+Settings::loadCborFrom( const QByteArray& section )
+{
+    {
+        QMutexLocker    lock( &m_cborLock );
+        m_cbor = section;
+    }
+    // Until then, the section would be saved as it was loaded
+    m_dirty = false;
+    emit postLoad();
 }
 
 void
-Settings::loadJsonFrom( const QJsonObject &object )
+Settings::decode()
+{
+    // Recursive, as applying the values accesses them
+    QMutexLocker    lock( &m_cborLock );
+    if ( m_cbor.isEmpty() == true )
+        return;
+    QCborParserError    error;
+    auto section = QCborValue::fromCbor( m_cbor, &error );
+    m_cbor.clear();
+    if ( error.error != QCborError::NoError )
+        vlmcWarning() << "Failed to decode settings section:" << error.errorString();
+    applyJson( section.toMap().toJsonObject() );
+}
+
+void
+Settings::applyJson( const QJsonObject &object )
 {
     for ( auto it = object.constBegin();
           it != object.constEnd();
@@ -172,13 +387,14 @@ Settings::loadJsonFrom( const QJsonObject &object )
         else
             val->set( (*it).toVariant() );
     }
-    emit postLoad();
+    // What we just loaded is what we'd save, until a value changes
+    m_json = object;
+    m_dirty = false;
 }
 
 void
 Settings::saveJsonTo( QJsonObject &object )
 {
-    emit preSave();
     for ( const auto& val : m_settings )
     {
         if ( ( val->flags() & SettingValue::Runtime ) != 0 )
@@ -190,6 +406,18 @@ Settings::saveJsonTo( QJsonObject &object )
     }
 }
 
+void
+Settings::setFormat( Format format )
+{
+    m_format = format;
+}
+
+Settings::Format
+Settings::format() const
+{
+    return m_format;
+}
+
 void
 Settings::addSettings( const QString &name, Settings &settings )
 {
@@ -199,6 +427,7 @@ Settings::addSettings( const QString &name, Settings &settings )
 bool
 Settings::setValue( const QString &key, const QVariant &value )
 {
+    decode();
     SettingMap::iterator   it = m_settings.find( key );
     if ( it != m_settings.end() )
     {
@@ -211,6 +440,11 @@ Settings::setValue( const QString &key, const QVariant &value )
 void
 Settings::restoreDefaultValues()
 {
+    {
+        // The values still encoded would override the defaults once accessed
+        QMutexLocker    lock( &m_cborLock );
+        m_cbor.clear();
+    }
     QReadLocker lock( &m_rwLock );
     for (auto s : m_settings)
     {
@@ -223,6 +457,7 @@ Settings::restoreDefaultValues()
 SettingValue*
 Settings::value( const QString &key )
 {
+    decode();
     QReadLocker lock( &m_rwLock );
 
     SettingMap::iterator it = m_settings.find( key );
@@ -241,20 +476,22 @@ Settings::createVar( SettingValue::Type type, const QString &key, const QVariant
         return nullptr;
     SettingValue* val = new SettingValue( key, type, defaultValue, name, desc, flags );
     m_settings.insert( key, val );
+    m_dirty = true;
+    connect( val, &SettingValue::changed, this, [this]{ m_dirty = true; }, Qt::DirectConnection );
     return val;
 }
 
 Settings::SettingList
-Settings::group( const QString &groupName ) const
+Settings::group( const QString &groupName )
 {
+    decode();
     QReadLocker lock( &m_rwLock );
     SettingList        ret;
 
+    // The map is sorted by key, a group's settings are contiguous
     QString grp = groupName + '/';
-    for ( auto s : m_settings )
-    {
-        if ( s->key().startsWith( grp ) )
-            ret.push_back( s );
-    }
+    for ( auto it = m_settings.lowerBound( grp ); it != m_settings.end() &&
+          it.key().startsWith( grp ) == true; ++it )
+        ret.push_back( it.value() );
     return ret;
 }
@@ -28,10 +28,13 @@
 #include "SettingValue.h"
 
 #include <QString>
+#include <QHash>
 #include <QMap>
+#include <QMutex>
 #include <QPair>
 #include <QObject>
 #include <QReadWriteLock>
+#include <QThreadPool>
 #include <QVariant>
 #include <QXmlStreamWriter>
 #include <QJsonObject>
@@ -43,14 +46,14 @@ class QFile;
 class QJsonDocument;
 
 
-//Var helpers :
-#define VLMC_GET_STRING( key )      Core::instance()->settings()->value( key )->get().toString()
-#define VLMC_GET_INT( key )         Core::instance()->settings()->value( key )->get().toInt()
-#define VLMC_GET_UINT( key )        Core::instance()->settings()->value( key )->get().toUInt()
-#define VLMC_GET_DOUBLE( key )      Core::instance()->settings()->value( key )->get().toDouble()
-#define VLMC_GET_BOOL( key )        Core::instance()->settings()->value( key )->get().toBool()
-#define VLMC_GET_STRINGLIST( key )  Core::instance()->settings()->value( key )->get().toStringList()
-#define VLMC_GET_BYTEARRAY( key )   Core::instance()->settings()->value( key )->get().toByteArray()
+//Var helpers : the keys must be constants, each one is only looked up once. See SettingHandle
+#define VLMC_GET_STRING( key )      VLMC_SETTING( QString, key ).get()
+#define VLMC_GET_INT( key )         VLMC_SETTING( int, key ).get()
+#define VLMC_GET_UINT( key )        VLMC_SETTING( uint, key ).get()
+#define VLMC_GET_DOUBLE( key )      VLMC_SETTING( double, key ).get()
+#define VLMC_GET_BOOL( key )        VLMC_SETTING( bool, key ).get()
+#define VLMC_GET_STRINGLIST( key )  VLMC_SETTING( QStringList, key ).get()
+#define VLMC_GET_BYTEARRAY( key )   VLMC_SETTING( QByteArray, key ).get()
 
 #define VLMC_CREATE_PROJECT_VAR( type, key, defaultValue, name, desc, flags )  \
         Core::instance()->currentProject()->settings()->createVar( type, key, defaultValue, name, \
@@ -109,18 +112,49 @@ class   Settings: public QObject
         typedef QList<SettingValue*>                SettingList;
         typedef QMap<QString, SettingValue*>        SettingMap;
 
+        /**
+         *  Binary is CBOR, starting with its signature tag: quicker to load, as the child
+         *  sections are skipped over and their values only decoded once accessed.
+         *  JSON stays the interchange format. The format of a loaded file is detected,
+         *  and kept when saving.
+         */
+        enum Format
+        {
+            Json,
+            Binary
+        };
+
         Settings();
         Settings( const QString& settingsFile );
         ~Settings();
         bool                        setValue(const QString &key, const QVariant &value );
         SettingValue*               value( const QString &key );
         SettingValue*               createVar( SettingValue::Type type, const QString &key, const QVariant &defaultValue, const char *name, const char *desc, SettingValue::Flags flags );
-        SettingList                 group( const QString &groupName ) const;
+        /**
+         *  \brief Returns the settings whose key starts with "groupName/", sorted by key.
+         */
+        SettingList                 group( const QString &groupName );
         bool                        load();
-        bool                        save();
+        /**
+         *  \brief Saves the settings and their children to the settings file.
+         *
+         *  Only the sections which changed since the last load or save are serialized
+         *  again, the others are reused as is.
+         *  \param async   If true, the file is written from a background thread.
+         */
+        bool                        save( bool async = false );
+        /**
+         *  \brief Returns what save() would write, without touching the settings file.
+         *
+         *  preSnapshot is emitted instead of preSave, as nothing gets saved.
+         */
+        QJsonDocument               snapshot();
+        static QByteArray           encode( const QJsonDocument& doc, Format format );
         void                        addSettings( const QString& name, Settings& settings );
         void                        restoreDefaultValues();
         void                        setSettingsFile( const QString& settingsFile );
+        void                        setFormat( Format format );
+        Format                      format() const;
 
     private:
         SettingMap                  m_settings;
@@ -128,13 +162,42 @@ class   Settings: public QObject
         QFile*                      m_settingsFile;
 
         QList<QPair<QString, Settings*>>                 m_settingsChildren;
-
-        QJsonDocument               readSettingsFromFile();
+        // Last loaded or saved content of this section
+        QJsonObject                 m_json;
+        // Set when a value changed since m_json was last updated
+        bool                        m_dirty;
+        Format                      m_format;
+        QThreadPool                 m_writer;
+        // The loaded section, until it's decoded
+        QByteArray                  m_cbor;
+        QMutex                      m_cborLock;
+
+        // The child sections of a CBOR file are kept encoded in sections, by name
+        bool                        readSettingsFromFile( QJsonObject& top,
+                                                          QHash<QString, QByteArray>& sections );
+        bool                        readCbor( const QByteArray& data, QJsonObject& top,
+                                              QHash<QString, QByteArray>& sections ) const;
+        QJsonDocument               document( bool snapshot );
+        const QJsonObject&          serialize( bool snapshot );
         void                        loadJsonFrom( const QJsonObject& object );
+        // Keeps the CBOR of the section, to decode it when a value is first accessed
+        void                        loadCborFrom( const QByteArray& section );
+        void                        decode();
+        void                        applyJson( const QJsonObject& object );
         void                        saveJsonTo( QJsonObject& object );
     signals:
         void                        postLoad();
         void                        preSave();
+        // Same as preSave, for a snapshot which doesn't replace the settings file
+        void                        preSnapshot();
+        /**
+         *  \brief Emitted once the file is written, or failed to be, from the writer
+         *         thread for asynchronous saves.
+         */
+        void                        saved( bool success );
 };
 
+// Needs the complete Settings class
+#include "SettingHandle.h"
+
 #endif
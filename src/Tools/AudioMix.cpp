@@ -0,0 +1,148 @@
+/*****************************************************************************
+ * AudioMix.cpp: Vectorized accumulation of float audio buffers
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "AudioMix.h"
+
+#if defined( __SSE2__ )
+# include <emmintrin.h>
+#endif
+#if ( defined( __x86_64__ ) || defined( __i386__ ) ) && defined( __GNUC__ )
+# include <immintrin.h>
+# define HAVE_AVX2_DISPATCH
+#endif
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+# include <arm_neon.h>
+# define HAVE_NEON
+#endif
+
+namespace
+{
+    using MixFunction = void (*)( float*, const float*, size_t, uint32_t, const float* );
+
+    // Mixes the floats [from, count), from being the first float of a sample
+    void
+    accumulate( float* dst, const float* src, size_t from, size_t count, uint32_t channels,
+                const float* gains )
+    {
+        for ( size_t i = from; i < count; ++i )
+            dst[i] += src[i] * gains[i % channels];
+    }
+
+#if defined( __SSE2__ )
+    void
+    mixSSE2( float* dst, const float* src, size_t nbSamples, uint32_t channels, const float* gains )
+    {
+        auto count = nbSamples * channels;
+        if ( 4 % channels != 0 )
+        {
+            accumulate( dst, src, 0, count, channels, gains );
+            return;
+        }
+        // The gains of the channels, repeated over the lanes
+        auto vgain = _mm_setr_ps( gains[0], gains[1 % channels], gains[2 % channels], gains[3 % channels] );
+        size_t i = 0;
+        for ( ; i + 4 <= count; i += 4 )
+        {
+            auto s = _mm_mul_ps( _mm_loadu_ps( src + i ), vgain );
+            _mm_storeu_ps( dst + i, _mm_add_ps( _mm_loadu_ps( dst + i ), s ) );
+        }
+        accumulate( dst, src, i, count, channels, gains );
+    }
+#endif
+
+#if defined( HAVE_AVX2_DISPATCH )
+    __attribute__(( target( "avx2" ) )) void
+    mixAVX2( float* dst, const float* src, size_t nbSamples, uint32_t channels, const float* gains )
+    {
+        auto count = nbSamples * channels;
+        if ( 8 % channels != 0 )
+        {
+            accumulate( dst, src, 0, count, channels, gains );
+            return;
+        }
+        auto vgain = _mm256_setr_ps( gains[0], gains[1 % channels], gains[2 % channels], gains[3 % channels],
+                                     gains[4 % channels], gains[5 % channels], gains[6 % channels],
+                                     gains[7 % channels] );
+        size_t i = 0;
+        for ( ; i + 8 <= count; i += 8 )
+        {
+            auto s = _mm256_mul_ps( _mm256_loadu_ps( src + i ), vgain );
+            _mm256_storeu_ps( dst + i, _mm256_add_ps( _mm256_loadu_ps( dst + i ), s ) );
+        }
+        accumulate( dst, src, i, count, channels, gains );
+    }
+#endif
+
+#if defined( HAVE_NEON )
+    void
+    mixNEON( float* dst, const float* src, size_t nbSamples, uint32_t channels, const float* gains )
+    {
+        auto count = nbSamples * channels;
+        if ( 4 % channels != 0 )
+        {
+            accumulate( dst, src, 0, count, channels, gains );
+            return;
+        }
+        const float lanes[4] = { gains[0], gains[1 % channels], gains[2 % channels], gains[3 % channels] };
+        auto vgain = vld1q_f32( lanes );
+        size_t i = 0;
+        for ( ; i + 4 <= count; i += 4 )
+            vst1q_f32( dst + i, vmlaq_f32( vld1q_f32( dst + i ), vld1q_f32( src + i ), vgain ) );
+        accumulate( dst, src, i, count, channels, gains );
+    }
+#endif
+
+    MixFunction
+    resolve()
+    {
+#if defined( HAVE_AVX2_DISPATCH )
+        __builtin_cpu_init();
+        if ( __builtin_cpu_supports( "avx2" ) )
+            return &mixAVX2;
+#endif
+#if defined( __SSE2__ )
+        return &mixSSE2;
+#elif defined( HAVE_NEON )
+        return &mixNEON;
+#else
+        return &Tools::mixSamplesScalar;
+#endif
+    }
+}
+
+void
+Tools::mixSamplesScalar( float* dst, const float* src, size_t nbSamples, uint32_t channels,
+                         const float* gains )
+{
+    accumulate( dst, src, 0, nbSamples * channels, channels, gains );
+}
+
+void
+Tools::mixSamples( float* dst, const float* src, size_t nbSamples, uint32_t channels,
+                   const float* gains )
+{
+    if ( channels == 0 )
+        return;
+    // Resolved once, thread safe since C++11
+    static const MixFunction mix = resolve();
+    mix( dst, src, nbSamples, channels, gains );
+}
@@ -0,0 +1,49 @@
+/*****************************************************************************
+ * AudioMix.h: Vectorized accumulation of float audio buffers
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef AUDIOMIX_H
+#define AUDIOMIX_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Tools
+{
+    /**
+     *  \brief  Adds nbSamples interleaved float samples of src to dst, channel c being
+     *          scaled by gains[c].
+     *
+     *  This uses the widest vector unit available on the running CPU (AVX2, SSE2 or
+     *  NEON) when the gain pattern fits in a vector, that is for 1, 2, 4 or 8 channels,
+     *  and falls back to a scalar loop otherwise.
+     */
+    void    mixSamples( float* dst, const float* src, size_t nbSamples, uint32_t channels,
+                        const float* gains );
+
+    /**
+     *  \brief  Scalar reference implementation of mixSamples
+     */
+    void    mixSamplesScalar( float* dst, const float* src, size_t nbSamples, uint32_t channels,
+                              const float* gains );
+}
+
+#endif // AUDIOMIX_H
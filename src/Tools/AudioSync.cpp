@@ -0,0 +1,210 @@
+/*****************************************************************************
+ * AudioSync.cpp: Alignment of recordings from their audio
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "AudioSync.h"
+#include "PcmCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    /**
+     *  \brief  Radix-2 FFT over split real and imaginary parts.
+     *
+     *  The butterflies of a stage read their twiddles, and both halves of their group,
+     *  from contiguous arrays: the compiler vectorizes the inner loop.
+     */
+    class Fft
+    {
+        public:
+            explicit Fft( size_t size )
+                : m_size( size )
+            {
+                // The twiddles of each stage, one after the other
+                m_re.reserve( size );
+                m_im.reserve( size );
+                for ( size_t half = 1; half < size; half *= 2 )
+                {
+                    for ( size_t j = 0; j < half; ++j )
+                    {
+                        auto angle = -M_PI * j / half;
+                        m_re.push_back( static_cast<float>( std::cos( angle ) ) );
+                        m_im.push_back( static_cast<float>( std::sin( angle ) ) );
+                    }
+                }
+            }
+
+            void forward( float* re, float* im ) const
+            {
+                for ( size_t i = 1, j = 0; i < m_size; ++i )
+                {
+                    auto bit = m_size >> 1;
+                    for ( ; ( j & bit ) != 0; bit >>= 1 )
+                        j ^= bit;
+                    j ^= bit;
+                    if ( i < j )
+                    {
+                        std::swap( re[i], re[j] );
+                        std::swap( im[i], im[j] );
+                    }
+                }
+                auto twRe = m_re.data();
+                auto twIm = m_im.data();
+                for ( size_t half = 1; half < m_size; half *= 2 )
+                {
+                    for ( size_t k = 0; k < m_size; k += 2 * half )
+                    {
+                        auto aRe = re + k;
+                        auto aIm = im + k;
+                        auto bRe = aRe + half;
+                        auto bIm = aIm + half;
+                        for ( size_t j = 0; j < half; ++j )
+                        {
+                            auto tRe = bRe[j] * twRe[j] - bIm[j] * twIm[j];
+                            auto tIm = bRe[j] * twIm[j] + bIm[j] * twRe[j];
+                            bRe[j] = aRe[j] - tRe;
+                            bIm[j] = aIm[j] - tIm;
+                            aRe[j] += tRe;
+                            aIm[j] += tIm;
+                        }
+                    }
+                    twRe += half;
+                    twIm += half;
+                }
+            }
+
+        private:
+            size_t              m_size;
+            std::vector<float>  m_re;
+            std::vector<float>  m_im;
+    };
+}
+
+std::vector<float>
+Tools::audioEnvelope( const PcmCache& pcm, int64_t begin, int64_t nbSamples )
+{
+    std::vector<float>  envelope;
+    auto step = std::max<int64_t>( 1, pcm.frequency() / AudioEnvelopeRate );
+    auto channels = pcm.channels();
+    if ( nbSamples < step || channels == 0 )
+        return envelope;
+    envelope.reserve( nbSamples / step );
+
+    // A second at a time
+    std::vector<int16_t>    buffer( step * AudioEnvelopeRate * channels );
+    float previous = 0.f;
+    for ( int64_t pos = 0; pos + step <= nbSamples; )
+    {
+        auto nbSteps = std::min<int64_t>( AudioEnvelopeRate, ( nbSamples - pos ) / step );
+        pcm.read( begin + pos, buffer.data(), nbSteps * step );
+        for ( int64_t s = 0; s < nbSteps; ++s )
+        {
+            auto samples = buffer.data() + s * step * channels;
+            float sum = 0.f;
+            for ( int64_t i = 0; i < step * channels; ++i )
+                sum += std::abs( static_cast<float>( samples[i] ) );
+            auto level = sum / ( step * channels );
+            envelope.push_back( std::max( 0.f, level - previous ) );
+            previous = level;
+        }
+        pos += nbSteps * step;
+    }
+
+    // Centered, so that the lags with more overlap aren't favored
+    double mean = 0.;
+    for ( auto e : envelope )
+        mean += e;
+    mean /= envelope.size();
+    for ( auto& e : envelope )
+        e -= static_cast<float>( mean );
+    return envelope;
+}
+
+Tools::AudioMatch
+Tools::alignAudio( const std::vector<float>& reference, const std::vector<float>& other )
+{
+    AudioMatch  match{ 0, 0. };
+    if ( reference.empty() == true || other.empty() == true )
+        return match;
+
+    // Padded so that the correlation doesn't wrap around
+    size_t n = 1;
+    while ( n < reference.size() + other.size() )
+        n *= 2;
+    // Both real envelopes are transformed at once, as z = reference + i.other
+    std::vector<float>  re( n, 0.f );
+    std::vector<float>  im( n, 0.f );
+    std::copy( reference.begin(), reference.end(), re.begin() );
+    std::copy( other.begin(), other.end(), im.begin() );
+    Fft fft( n );
+    fft.forward( re.data(), im.data() );
+
+    // R[k] = ( Z[k] + conj( Z[-k] ) ) / 2 and O[k] = ( Z[k] - conj( Z[-k] ) ) / 2i,
+    // replaced by R[k].conj( O[k] ), whose value at -k is the conjugate
+    for ( size_t k = 0; k <= n / 2; ++k )
+    {
+        auto m = ( n - k ) & ( n - 1 );
+        auto rRe = ( re[k] + re[m] ) / 2.f;
+        auto rIm = ( im[k] - im[m] ) / 2.f;
+        auto oRe = ( im[k] + im[m] ) / 2.f;
+        auto oIm = ( re[m] - re[k] ) / 2.f;
+        auto pRe = rRe * oRe + rIm * oIm;
+        auto pIm = rIm * oRe - rRe * oIm;
+        re[k] = pRe;
+        im[k] = pIm;
+        re[m] = pRe;
+        im[m] = -pIm;
+    }
+    // The inverse transform, as the conjugate of the forward one. Only the real part,
+    // which is the correlation, is needed.
+    for ( auto& v : im )
+        v = -v;
+    fft.forward( re.data(), im.data() );
+
+    // re[lag] is the sum of reference[i + lag].other[i], negative lags being at the end
+    auto best = -std::numeric_limits<float>::infinity();
+    for ( int64_t lag = -static_cast<int64_t>( other.size() ) + 1; lag < static_cast<int64_t>( reference.size() ); ++lag )
+    {
+        auto value = re[lag >= 0 ? lag : n + lag];
+        if ( value > best )
+        {
+            best = value;
+            match.lag = lag;
+        }
+    }
+    // Over the overlapping parts only, so that a short recording matching a part of
+    // a long one is as confident as two recordings of the same length
+    auto first = std::max<int64_t>( 0, -match.lag );
+    auto last = std::min<int64_t>( other.size(), reference.size() - match.lag );
+    double energyRef = 0.;
+    double energyOther = 0.;
+    for ( auto i = first; i < last; ++i )
+    {
+        energyRef += reference[i + match.lag] * reference[i + match.lag];
+        energyOther += other[i] * other[i];
+    }
+    if ( energyRef > 0. && energyOther > 0. )
+        match.confidence = std::max( 0., std::min( 1., best / n / std::sqrt( energyRef * energyOther ) ) );
+    return match;
+}
@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * AudioSync.h: Alignment of recordings from their audio
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef AUDIOSYNC_H
+#define AUDIOSYNC_H
+
+#include <cstdint>
+#include <vector>
+
+namespace Tools
+{
+    class PcmCache;
+
+    // Rate of the audio envelopes, in Hz: 2ms steps, well below a frame
+    const uint32_t  AudioEnvelopeRate = 500;
+
+    /**
+     *  \brief  Computes the onsets of nbSamples samples of a PCM cache, from begin, at
+     *          AudioEnvelopeRate.
+     *
+     *  This is how loud the audio gets over the previous step, which the same sound
+     *  recorded by different microphones mostly agrees on, whatever their level.
+     */
+    std::vector<float>  audioEnvelope( const PcmCache& pcm, int64_t begin, int64_t nbSamples );
+
+    struct AudioMatch
+    {
+        // In envelope steps: other[i] plays along with reference[i + lag]
+        int64_t     lag;
+        // The normalized correlation of the overlapping parts at lag, from 0 to 1
+        double      confidence;
+    };
+
+    /**
+     *  \brief  Finds the lag maximizing the cross-correlation of two envelopes.
+     *
+     *  The correlation is computed for every lag at once, with a single FFT of both
+     *  envelopes packed together and an inverse one, so that hour long recordings are
+     *  aligned in a few seconds.
+     */
+    AudioMatch          alignAudio( const std::vector<float>& reference, const std::vector<float>& other );
+}
+
+#endif // AUDIOSYNC_H
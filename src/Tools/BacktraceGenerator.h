@@ -23,11 +23,21 @@
 #ifndef BACKTRACEGENERATOR_H
 #define BACKTRACEGENERATOR_H
 
+#include <QtGlobal>
+
 class   QStringList;
 
 namespace Tools
 {
     QStringList         generateBacktrace( int levelsToSkip );
+    /**
+     *  \brief Returns the stack of another thread of the process, as it is when called.
+     *
+     *  The thread is interrupted with SIGUSR2, which records its stack from the signal
+     *  handler. Gives up if it doesn't run within timeout milliseconds.
+     *  \param thread  The QThread::currentThreadId() of the thread.
+     */
+    QStringList         generateBacktrace( Qt::HANDLE thread, int timeout );
     static const int    backtraceSize = 256;
 }
 
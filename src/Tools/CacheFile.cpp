@@ -0,0 +1,56 @@
+/*****************************************************************************
+ * CacheFile.cpp: Files derived from the medias, shared between writers
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "CacheFile.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QLockFile>
+#include <QSysInfo>
+
+QString
+Tools::CacheFile::partPath( const QString& path, const QString& suffix )
+{
+    // Writers on other hosts may have the same pid
+    return path + ".part-" + QSysInfo::machineHostName() + '-' +
+            QString::number( QCoreApplication::applicationPid() ) + suffix;
+}
+
+bool
+Tools::CacheFile::publish( const QString& partPath, const QString& path )
+{
+    if ( QFile::exists( path ) == false && QFile::rename( partPath, path ) == true )
+        return true;
+    // Or it got published in between
+    QFile::remove( partPath );
+    return QFile::exists( path );
+}
+
+std::unique_ptr<QLockFile>
+Tools::CacheFile::claim( const QString& path )
+{
+    std::unique_ptr<QLockFile>  lock( new QLockFile( path + ".lock" ) );
+    lock->setStaleLockTime( ClaimTimeout );
+    if ( lock->tryLock( 0 ) == false )
+        return nullptr;
+    return lock;
+}
@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * CacheFile.h: Files derived from the medias, shared between writers
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef CACHEFILE_H
+#define CACHEFILE_H
+
+#include <QString>
+
+#include <memory>
+
+class   QLockFile;
+
+namespace Tools
+{
+    /**
+     *  \brief  Writes the files derived from the medias, which several workstations may
+     *          be computing at once when they share a cache directory.
+     *
+     *  Those files are named after the content hash of their media and their
+     *  parameters, so every writer produces the same file. Each one writes to its own
+     *  partial file, and the first to complete publishes it. The others drop theirs.
+     *  \sa Tools::contentHash()
+     */
+    namespace CacheFile
+    {
+        /**
+         *  \brief  A claim older than that is taken over, from a writer which died.
+         *
+         *  In ms. Long enough for a proxy of a feature length media to be rendered.
+         */
+        const int           ClaimTimeout = 4 * 3600 * 1000;
+        // How often the files claimed by another writer are looked for, in ms
+        const int           ClaimRetry = 30 * 1000;
+
+        /**
+         *  \brief  The partial file of path, for this process only.
+         *
+         *  It ends with suffix, from which the muxers pick their format.
+         */
+        QString             partPath( const QString& path, const QString& suffix = QString() );
+        /**
+         *  \brief  Renames partPath to path, unless another writer published it first,
+         *          in which case partPath is removed.
+         *
+         *  \returns    true if path exists on return.
+         */
+        bool                publish( const QString& partPath, const QString& path );
+        /**
+         *  \brief  Claims the computation of path, for the jobs too long to be done twice.
+         *
+         *  The claim is held until the lock gets destroyed.
+         *  \returns    nullptr if another writer claimed it already.
+         */
+        std::unique_ptr<QLockFile>  claim( const QString& path );
+    }
+}
+
+#endif // CACHEFILE_H
@@ -0,0 +1,121 @@
+/*****************************************************************************
+ * EventBridge.cpp: Batches backend events to the watcher's thread
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "Tools/EventBridge.h"
+
+using namespace Tools;
+
+EventBridge::EventBridge( QObject* parent )
+    : QObject( parent )
+    , m_position( -1 )
+    , m_length( -1 )
+    , m_framesDropped( 0 )
+    , m_audioUnderruns( 0 )
+    , m_scheduled( false )
+{
+}
+
+void
+EventBridge::post( Event event )
+{
+    if ( m_events.push( event ) == false )
+    {
+        QMetaObject::invokeMethod( this, "flushOverflow", Qt::QueuedConnection, Q_ARG( int, event ) );
+        return;
+    }
+    schedule();
+}
+
+void
+EventBridge::postPosition( qint64 position )
+{
+    m_position.store( position, std::memory_order_release );
+    schedule();
+}
+
+void
+EventBridge::postLength( qint64 length )
+{
+    m_length.store( length, std::memory_order_release );
+    schedule();
+}
+
+void
+EventBridge::postFramesDropped( quint32 nbDropped )
+{
+    m_framesDropped.fetch_add( nbDropped, std::memory_order_acq_rel );
+    schedule();
+}
+
+void
+EventBridge::postAudioUnderruns( quint32 nbUnderruns )
+{
+    m_audioUnderruns.fetch_add( nbUnderruns, std::memory_order_acq_rel );
+    schedule();
+}
+
+void
+EventBridge::schedule()
+{
+    // Pairs with the one in flush(): either it sees what was just posted, or this sees
+    // the flag cleared and schedules the next one
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    if ( m_scheduled.exchange( true, std::memory_order_acq_rel ) == false )
+        QMetaObject::invokeMethod( this, "flush", Qt::QueuedConnection );
+}
+
+void
+EventBridge::flush()
+{
+    // Cleared before draining: whatever is posted from now on schedules another flush
+    m_scheduled.store( false, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+
+    Batch   batch;
+    Event   event;
+    while ( m_events.pop( event ) == true )
+        batch.events.append( event );
+    batch.position = m_position.exchange( -1, std::memory_order_acq_rel );
+    batch.length = m_length.exchange( -1, std::memory_order_acq_rel );
+    batch.framesDropped = m_framesDropped.exchange( 0, std::memory_order_acq_rel );
+    batch.audioUnderruns = m_audioUnderruns.exchange( 0, std::memory_order_acq_rel );
+    if ( batch.events.isEmpty() == true && batch.position < 0 &&
+         batch.length < 0 && batch.framesDropped == 0 && batch.audioUnderruns == 0 )
+        return;
+    deliver( batch );
+}
+
+void
+EventBridge::flushOverflow( int event )
+{
+    Batch   batch;
+    batch.events.append( static_cast<Event>( event ) );
+    batch.position = -1;
+    batch.length = -1;
+    batch.framesDropped = 0;
+    batch.audioUnderruns = 0;
+    deliver( batch );
+}
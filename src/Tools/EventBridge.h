@@ -0,0 +1,108 @@
+/*****************************************************************************
+ * EventBridge.h: Batches backend events to the watcher's thread
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef EVENTBRIDGE_H
+#define EVENTBRIDGE_H
+
+#include <QObject>
+#include <QVector>
+
+#include <atomic>
+
+#include "Tools/MpscRing.h"
+
+namespace Tools
+{
+/**
+ *  \brief  Collects the events posted from the backend threads, and delivers them to
+ *          the bridge's thread in batches.
+ *
+ *  Posting never locks nor allocates. Discrete events are queued in order, while
+ *  positions and lengths are coalesced (the latest one wins) and dropped frames and
+ *  audio underruns are summed up. However many events are posted in between, at most one delivery is
+ *  waiting in the event loop.
+ */
+class EventBridge : public QObject
+{
+    Q_OBJECT
+
+    public:
+        enum Event : quint8
+        {
+            Playing,
+            Paused,
+            Stopped,
+            EndReached,
+            VolumeChanged,
+            ErrorEncountered,
+        };
+
+        struct Batch
+        {
+            // In the order they were posted
+            QVector<Event>  events;
+            // -1 when none was posted since the previous batch
+            qint64          position;
+            qint64          length;
+            quint32         framesDropped;
+            quint32         audioUnderruns;
+        };
+
+    protected:
+        explicit EventBridge( QObject* parent );
+
+        // Safe from any thread
+        void            post( Event event );
+        void            postPosition( qint64 position );
+        void            postLength( qint64 length );
+        void            postFramesDropped( quint32 nbDropped );
+        void            postAudioUnderruns( quint32 nbUnderruns );
+
+        /**
+         *  \brief  Called from the bridge's thread with everything posted since the
+         *          previous batch.
+         */
+        virtual void    deliver( const Batch& batch ) = 0;
+
+    private:
+        void            schedule();
+
+    private slots:
+        void            flush();
+        // Used when the queue is full, which may deliver it out of order
+        void            flushOverflow( int event );
+
+    private:
+        // More than a few events a frame means the event loop is stalled anyway
+        static const size_t     QueueSize = 64;
+
+        MpscRing<Event, QueueSize>  m_events;
+        std::atomic<qint64>     m_position;
+        std::atomic<qint64>     m_length;
+        std::atomic<quint32>    m_framesDropped;
+        std::atomic<quint32>    m_audioUnderruns;
+        // Set while a flush waits in the event loop
+        std::atomic<bool>       m_scheduled;
+};
+}
+
+#endif // EVENTBRIDGE_H
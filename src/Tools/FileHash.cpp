@@ -0,0 +1,78 @@
+/*****************************************************************************
+ * FileHash.cpp: Cheap content hash of media files
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "FileHash.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+namespace
+{
+    // Hashing a whole multi gigabytes file would defeat the purpose of the caches
+    // relying on this.
+    const qint64        HashedChunkSize = 64 * 1024;
+
+    struct HashEntry
+    {
+        QDateTime       lastModified;
+        QByteArray      hash;
+    };
+
+    QMutex                      hashesMutex;
+    QHash<QString, HashEntry>   hashes;
+}
+
+QByteArray
+Tools::contentHash( const QString& filePath )
+{
+    QFileInfo   info( filePath );
+    auto lastModified = info.lastModified();
+    {
+        QMutexLocker    lock( &hashesMutex );
+        auto it = hashes.find( filePath );
+        if ( it != hashes.end() && it.value().lastModified == lastModified )
+            return it.value().hash;
+    }
+
+    QFile   file( filePath );
+    if ( file.open( QFile::ReadOnly ) == false )
+        return QByteArray();
+    QCryptographicHash  hash( QCryptographicHash::Sha1 );
+    auto size = file.size();
+    hash.addData( reinterpret_cast<const char*>( &size ), sizeof( size ) );
+    hash.addData( file.read( HashedChunkSize ) );
+    if ( size > HashedChunkSize * 2 )
+    {
+        file.seek( size - HashedChunkSize );
+        hash.addData( file.read( HashedChunkSize ) );
+    }
+    auto res = hash.result().toHex();
+
+    QMutexLocker    lock( &hashesMutex );
+    hashes.insert( filePath, HashEntry{ lastModified, res } );
+    return res;
+}
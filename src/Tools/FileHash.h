@@ -0,0 +1,43 @@
+/*****************************************************************************
+ * FileHash.h: Cheap content hash of media files
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef FILEHASH_H
+#define FILEHASH_H
+
+#include <QByteArray>
+
+class   QString;
+
+namespace Tools
+{
+    /**
+     *  \brief  Returns a hex encoded hash identifying the file content.
+     *
+     *  Only the size, the beginning and the end of the file are hashed, so this is
+     *  cheap enough to be used on multi gigabytes medias. Results are cached until
+     *  the file modification date changes. This is thread safe.
+     *  \returns    The hash, or an empty array if the file can't be read.
+     */
+    QByteArray      contentHash( const QString& filePath );
+}
+
+#endif // FILEHASH_H
@@ -0,0 +1,464 @@
+/*****************************************************************************
+ * FrameHash.cpp: Fast hashes of the rendered frames
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "FrameHash.h"
+
+#include "VlmcDebug.h"
+
+#include <QFile>
+#include <QString>
+#include <QTextStream>
+
+#include <cstring>
+
+#if defined( __SSE2__ )
+# include <emmintrin.h>
+#endif
+#if ( defined( __x86_64__ ) || defined( __i386__ ) ) && defined( __GNUC__ )
+# include <immintrin.h>
+# define HAVE_AVX2_DISPATCH
+#endif
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+# include <arm_neon.h>
+# define HAVE_NEON
+#endif
+
+namespace
+{
+    // The data is read in stripes, each one feeding the 8 accumulators. They are
+    // scrambled after each block of stripes, so that the blocks don't just add up.
+    const size_t        StripeSize = 64;
+    const size_t        StripesPerBlock = 16;
+    // One key per stripe of a block, offset by a word each time, then the scrambling keys
+    const size_t        NbKeys = StripesPerBlock + 8;
+    // How many mismatching positions are kept by compare()
+    const int           MaxReportedMismatches = 16;
+
+    const uint32_t      Prime32_1 = 0x9E3779B1u;
+    const uint32_t      Prime32_2 = 0x85EBCA77u;
+    const uint32_t      Prime32_3 = 0xC2B2AE3Du;
+    const uint64_t      Prime64_1 = 0x9E3779B185EBCA87ull;
+    const uint64_t      Prime64_2 = 0xC2B2AE3D27D4EB4Full;
+    const uint64_t      Prime64_3 = 0x165667B19E3779F9ull;
+    const uint64_t      Prime64_4 = 0x85EBCA77C2B2AE63ull;
+    const uint64_t      Prime64_5 = 0x27D4EB2F165667C5ull;
+
+    using AccumulateFunction = void (*)( uint64_t*, const uint8_t*, size_t, const uint64_t* );
+
+    const uint64_t*
+    keys()
+    {
+        // Thread safe since C++11
+        static const struct Keys
+        {
+            Keys()
+            {
+                // splitmix64, so that the keys don't have to be spelled out
+                uint64_t x = 0;
+                for ( auto& k : values )
+                {
+                    auto z = ( x += 0x9E3779B97F4A7C15ull );
+                    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+                    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+                    k = z ^ ( z >> 31 );
+                }
+            }
+            uint64_t    values[NbKeys];
+        } k;
+        return k.values;
+    }
+
+    uint64_t
+    read64( const uint8_t* p )
+    {
+        // The vector loads are little endian as well
+        uint64_t v;
+        memcpy( &v, p, sizeof( v ) );
+        return v;
+    }
+
+    void
+    stripeScalar( uint64_t* acc, const uint8_t* data, const uint64_t* key )
+    {
+        for ( size_t j = 0; j < 8; ++j )
+        {
+            auto d = read64( data + j * 8 );
+            auto dk = d ^ key[j];
+            // The neighbour lane gets the data itself, so that no byte is lost when
+            // the product is 0
+            acc[j ^ 1] += d;
+            acc[j] += ( dk & 0xFFFFFFFFu ) * ( dk >> 32 );
+        }
+    }
+
+    void
+    scrambleScalar( uint64_t* acc, const uint64_t* key )
+    {
+        for ( size_t j = 0; j < 8; ++j )
+        {
+            auto a = acc[j];
+            a ^= a >> 47;
+            a ^= key[j];
+            acc[j] = a * Prime32_1;
+        }
+    }
+
+    void
+    accumulateScalar( uint64_t* acc, const uint8_t* data, size_t nbStripes, const uint64_t* key )
+    {
+        for ( size_t s = 0; s < nbStripes; ++s )
+        {
+            stripeScalar( acc, data + s * StripeSize, key + s % StripesPerBlock );
+            if ( s % StripesPerBlock == StripesPerBlock - 1 )
+                scrambleScalar( acc, key + StripesPerBlock );
+        }
+    }
+
+#if defined( __SSE2__ )
+    void
+    accumulateSSE2( uint64_t* acc, const uint8_t* data, size_t nbStripes, const uint64_t* key )
+    {
+        __m128i a[4];
+        for ( int i = 0; i < 4; ++i )
+            a[i] = _mm_loadu_si128( reinterpret_cast<const __m128i*>( acc + i * 2 ) );
+        const auto prime = _mm_set1_epi32( (int)Prime32_1 );
+        for ( size_t s = 0; s < nbStripes; ++s )
+        {
+            auto p = data + s * StripeSize;
+            auto k = key + s % StripesPerBlock;
+            for ( int i = 0; i < 4; ++i )
+            {
+                auto d = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p + i * 16 ) );
+                auto dk = _mm_xor_si128( d, _mm_loadu_si128( reinterpret_cast<const __m128i*>( k + i * 2 ) ) );
+                // The high halves moved down, multiplied by the low ones
+                auto product = _mm_mul_epu32( dk, _mm_shuffle_epi32( dk, _MM_SHUFFLE( 0, 3, 0, 1 ) ) );
+                auto swapped = _mm_shuffle_epi32( d, _MM_SHUFFLE( 1, 0, 3, 2 ) );
+                a[i] = _mm_add_epi64( a[i], _mm_add_epi64( product, swapped ) );
+            }
+            if ( s % StripesPerBlock != StripesPerBlock - 1 )
+                continue;
+            for ( int i = 0; i < 4; ++i )
+            {
+                auto v = _mm_xor_si128( a[i], _mm_srli_epi64( a[i], 47 ) );
+                v = _mm_xor_si128( v, _mm_loadu_si128( reinterpret_cast<const __m128i*>(
+                                                       key + StripesPerBlock + i * 2 ) ) );
+                // 64 by 32 bits multiplication, from two 32 by 32 bits ones
+                auto lo = _mm_mul_epu32( v, prime );
+                auto hi = _mm_mul_epu32( _mm_srli_epi64( v, 32 ), prime );
+                a[i] = _mm_add_epi64( lo, _mm_slli_epi64( hi, 32 ) );
+            }
+        }
+        for ( int i = 0; i < 4; ++i )
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( acc + i * 2 ), a[i] );
+    }
+#endif
+
+#if defined( HAVE_AVX2_DISPATCH )
+    __attribute__(( target( "avx2" ) )) void
+    accumulateAVX2( uint64_t* acc, const uint8_t* data, size_t nbStripes, const uint64_t* key )
+    {
+        __m256i a[2];
+        for ( int i = 0; i < 2; ++i )
+            a[i] = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( acc + i * 4 ) );
+        const auto prime = _mm256_set1_epi32( (int)Prime32_1 );
+        for ( size_t s = 0; s < nbStripes; ++s )
+        {
+            auto p = data + s * StripeSize;
+            auto k = key + s % StripesPerBlock;
+            for ( int i = 0; i < 2; ++i )
+            {
+                auto d = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p + i * 32 ) );
+                auto dk = _mm256_xor_si256( d, _mm256_loadu_si256( reinterpret_cast<const __m256i*>( k + i * 4 ) ) );
+                auto product = _mm256_mul_epu32( dk, _mm256_shuffle_epi32( dk, _MM_SHUFFLE( 0, 3, 0, 1 ) ) );
+                auto swapped = _mm256_shuffle_epi32( d, _MM_SHUFFLE( 1, 0, 3, 2 ) );
+                a[i] = _mm256_add_epi64( a[i], _mm256_add_epi64( product, swapped ) );
+            }
+            if ( s % StripesPerBlock != StripesPerBlock - 1 )
+                continue;
+            for ( int i = 0; i < 2; ++i )
+            {
+                auto v = _mm256_xor_si256( a[i], _mm256_srli_epi64( a[i], 47 ) );
+                v = _mm256_xor_si256( v, _mm256_loadu_si256( reinterpret_cast<const __m256i*>(
+                                                             key + StripesPerBlock + i * 4 ) ) );
+                auto lo = _mm256_mul_epu32( v, prime );
+                auto hi = _mm256_mul_epu32( _mm256_srli_epi64( v, 32 ), prime );
+                a[i] = _mm256_add_epi64( lo, _mm256_slli_epi64( hi, 32 ) );
+            }
+        }
+        for ( int i = 0; i < 2; ++i )
+            _mm256_storeu_si256( reinterpret_cast<__m256i*>( acc + i * 4 ), a[i] );
+    }
+#endif
+
+#if defined( HAVE_NEON )
+    void
+    accumulateNEON( uint64_t* acc, const uint8_t* data, size_t nbStripes, const uint64_t* key )
+    {
+        uint64x2_t a[4];
+        for ( int i = 0; i < 4; ++i )
+            a[i] = vld1q_u64( acc + i * 2 );
+        const auto prime = vdup_n_u32( Prime32_1 );
+        for ( size_t s = 0; s < nbStripes; ++s )
+        {
+            auto p = data + s * StripeSize;
+            auto k = key + s % StripesPerBlock;
+            for ( int i = 0; i < 4; ++i )
+            {
+                auto d = vreinterpretq_u64_u8( vld1q_u8( p + i * 16 ) );
+                auto dk = veorq_u64( d, vld1q_u64( k + i * 2 ) );
+                auto product = vmull_u32( vmovn_u64( dk ), vshrn_n_u64( dk, 32 ) );
+                a[i] = vaddq_u64( a[i], vaddq_u64( product, vextq_u64( d, d, 1 ) ) );
+            }
+            if ( s % StripesPerBlock != StripesPerBlock - 1 )
+                continue;
+            for ( int i = 0; i < 4; ++i )
+            {
+                auto v = veorq_u64( a[i], vshrq_n_u64( a[i], 47 ) );
+                v = veorq_u64( v, vld1q_u64( key + StripesPerBlock + i * 2 ) );
+                auto lo = vmull_u32( vmovn_u64( v ), prime );
+                auto hi = vmull_u32( vshrn_n_u64( v, 32 ), prime );
+                a[i] = vaddq_u64( lo, vshlq_n_u64( hi, 32 ) );
+            }
+        }
+        for ( int i = 0; i < 4; ++i )
+            vst1q_u64( acc + i * 2, a[i] );
+    }
+#endif
+
+    AccumulateFunction
+    resolve()
+    {
+#if defined( HAVE_AVX2_DISPATCH )
+        __builtin_cpu_init();
+        if ( __builtin_cpu_supports( "avx2" ) )
+            return &accumulateAVX2;
+#endif
+#if defined( __SSE2__ )
+        return &accumulateSSE2;
+#elif defined( HAVE_NEON )
+        return &accumulateNEON;
+#else
+        return &accumulateScalar;
+#endif
+    }
+
+    uint64_t
+    rotl( uint64_t v, int bits )
+    {
+        return ( v << bits ) | ( v >> ( 64 - bits ) );
+    }
+
+    uint64_t
+    hash( const uint8_t* data, size_t size, AccumulateFunction accumulate )
+    {
+        uint64_t acc[8] = { Prime32_3, Prime64_1, Prime64_2, Prime64_3,
+                            Prime64_4, Prime32_2, Prime64_5, Prime32_1 };
+        auto key = keys();
+        auto nbStripes = size / StripeSize;
+        accumulate( acc, data, nbStripes, key );
+        auto tail = size % StripeSize;
+        if ( tail > 0 )
+        {
+            // Zero padded, the size being part of the hash
+            uint8_t last[StripeSize] = {};
+            memcpy( last, data + nbStripes * StripeSize, tail );
+            stripeScalar( acc, last, key + StripesPerBlock - 1 );
+        }
+
+        uint64_t h = size * Prime64_1;
+        for ( auto a : acc )
+        {
+            h ^= rotl( a * Prime64_2, 31 ) * Prime64_1;
+            h = h * Prime64_1 + Prime64_4;
+        }
+        h ^= h >> 33;
+        h *= Prime64_2;
+        h ^= h >> 29;
+        h *= Prime64_3;
+        h ^= h >> 32;
+        return h;
+    }
+}
+
+uint64_t
+Tools::hashFrameScalar( const uint8_t* data, size_t size )
+{
+    return hash( data, size, &accumulateScalar );
+}
+
+uint64_t
+Tools::hashFrame( const uint8_t* data, size_t size )
+{
+    // Resolved once, thread safe since C++11
+    static const AccumulateFunction accumulate = resolve();
+    return hash( data, size, accumulate );
+}
+
+Tools::FrameHashes::FrameHashes( const FrameHashes& other )
+    : m_hashes( other.hashes() )
+{
+}
+
+Tools::FrameHashes&
+Tools::FrameHashes::operator=( const FrameHashes& other )
+{
+    if ( this == &other )
+        return *this;
+    auto hashes = other.hashes();
+    QMutexLocker    lock( &m_lock );
+    m_hashes = hashes;
+    return *this;
+}
+
+void
+Tools::FrameHashes::add( qint64 position, uint64_t hash )
+{
+    QMutexLocker    lock( &m_lock );
+    m_hashes.insert( position, hash );
+}
+
+void
+Tools::FrameHashes::merge( const FrameHashes& other )
+{
+    auto hashes = other.hashes();
+    QMutexLocker    lock( &m_lock );
+    for ( auto it = hashes.cbegin(); it != hashes.cend(); ++it )
+        m_hashes.insert( it.key(), it.value() );
+}
+
+void
+Tools::FrameHashes::clear()
+{
+    QMutexLocker    lock( &m_lock );
+    m_hashes.clear();
+}
+
+bool
+Tools::FrameHashes::isEmpty() const
+{
+    QMutexLocker    lock( &m_lock );
+    return m_hashes.isEmpty();
+}
+
+QMap<qint64, uint64_t>
+Tools::FrameHashes::hashes() const
+{
+    QMutexLocker    lock( &m_lock );
+    return m_hashes;
+}
+
+bool
+Tools::FrameHashes::save( const QString& fileName ) const
+{
+    auto hashes = this->hashes();
+    QFile   file( fileName );
+    if ( file.open( QFile::WriteOnly | QFile::Truncate | QFile::Text ) == false )
+    {
+        vlmcWarning() << "Can't write the frame hashes to" << fileName;
+        return false;
+    }
+    QTextStream stream( &file );
+    for ( auto it = hashes.cbegin(); it != hashes.cend(); ++it )
+        stream << it.key() << ' ' << QString::number( it.value(), 16 ).rightJustified( 16, '0' ) << '\n';
+    stream.flush();
+    return file.error() == QFile::NoError;
+}
+
+bool
+Tools::FrameHashes::load( const QString& fileName )
+{
+    QFile   file( fileName );
+    if ( file.open( QFile::ReadOnly | QFile::Text ) == false )
+        return false;
+    QMap<qint64, uint64_t>  hashes;
+    QTextStream stream( &file );
+    while ( stream.atEnd() == false )
+    {
+        auto line = stream.readLine().trimmed();
+        if ( line.isEmpty() == true )
+            continue;
+        auto fields = line.split( ' ', QString::SkipEmptyParts );
+        bool okPos = false;
+        bool okHash = false;
+        auto pos = fields.value( 0 ).toLongLong( &okPos );
+        auto hash = fields.value( 1 ).toULongLong( &okHash, 16 );
+        if ( fields.size() != 2 || okPos == false || okHash == false )
+        {
+            vlmcWarning() << "Invalid frame hash file" << fileName;
+            return false;
+        }
+        hashes.insert( pos, hash );
+    }
+    QMutexLocker    lock( &m_lock );
+    for ( auto it = hashes.cbegin(); it != hashes.cend(); ++it )
+        m_hashes.insert( it.key(), it.value() );
+    return true;
+}
+
+Tools::FrameHashes::Comparison
+Tools::FrameHashes::compare( const FrameHashes& reference ) const
+{
+    auto hashes = this->hashes();
+    auto ref = reference.hashes();
+    Comparison  res{ 0, QList<qint64>(), 0, 0 };
+    for ( auto it = hashes.cbegin(); it != hashes.cend(); ++it )
+    {
+        auto r = ref.constFind( it.key() );
+        if ( r == ref.cend() )
+        {
+            ++res.nbMissing;
+            continue;
+        }
+        ++res.nbCompared;
+        if ( r.value() == it.value() )
+            continue;
+        if ( res.nbMismatches++ < MaxReportedMismatches )
+            res.mismatches.append( it.key() );
+    }
+    res.nbMissing += ref.size() - res.nbCompared;
+    return res;
+}
+
+bool
+Tools::FrameHashes::verify( const QString& referenceFileName ) const
+{
+    FrameHashes reference;
+    if ( reference.load( referenceFileName ) == false )
+    {
+        vlmcCritical() << "Can't read the reference frame hashes" << referenceFileName;
+        return false;
+    }
+    auto res = compare( reference );
+    if ( res.nbMissing > 0 )
+    {
+        vlmcWarning() << res.nbMissing << "frames were only hashed by one of the renders, compared to"
+                      << referenceFileName;
+    }
+    if ( res.nbMismatches > 0 )
+    {
+        vlmcCritical() << res.nbMismatches << "of" << res.nbCompared << "frames differ from"
+                       << referenceFileName << "starting with frames" << res.mismatches;
+        return false;
+    }
+    vlmcDebug() << res.nbCompared << "frames match" << referenceFileName;
+    return true;
+}
@@ -0,0 +1,103 @@
+/*****************************************************************************
+ * FrameHash.h: Fast hashes of the rendered frames
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef FRAMEHASH_H
+#define FRAMEHASH_H
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+
+#include <cstddef>
+#include <cstdint>
+
+class   QString;
+
+namespace Tools
+{
+    /**
+     *  \brief  Hashes size bytes of a frame's planes, to tell identical renders apart
+     *          from different ones. This isn't a cryptographic hash.
+     *
+     *  This uses the widest vector unit available on the running CPU (AVX2, SSE2 or
+     *  NEON), and falls back to a scalar loop otherwise. They all give the same hash.
+     */
+    uint64_t        hashFrame( const uint8_t* data, size_t size );
+
+    /**
+     *  \brief  Scalar reference implementation of hashFrame
+     */
+    uint64_t        hashFrameScalar( const uint8_t* data, size_t size );
+
+    /**
+     *  \brief  The hashes of the frames of a render, by position.
+     *
+     *  They are saved as text, a "position hash" line per frame, the hash being written
+     *  as 16 hexadecimal digits. This is thread safe.
+     */
+    class FrameHashes
+    {
+        public:
+            struct Comparison
+            {
+                // Positions hashed on both sides
+                qint64          nbCompared;
+                // The first 16 positions whose hashes differ, and how many do
+                QList<qint64>   mismatches;
+                qint64          nbMismatches;
+                // Positions hashed on a single side
+                qint64          nbMissing;
+            };
+
+            FrameHashes() = default;
+            FrameHashes( const FrameHashes& other );
+            FrameHashes&    operator=( const FrameHashes& other );
+
+            void            add( qint64 position, uint64_t hash );
+            // Adds other's hashes, replacing the ones at the same positions
+            void            merge( const FrameHashes& other );
+            void            clear();
+            bool            isEmpty() const;
+            QMap<qint64, uint64_t>  hashes() const;
+
+            bool            save( const QString& fileName ) const;
+            // Adds the hashes of the file. Returns false if it can't be read
+            bool            load( const QString& fileName );
+
+            Comparison      compare( const FrameHashes& reference ) const;
+            /**
+             *  \brief  Compares the hashes with the reference ones, from a single pass
+             *          render of the same frames, and logs the differences.
+             *
+             *  Frames only hashed on one side, such as the ones copied by a smart render
+             *  or kept from a previous export, aren't considered mismatches.
+             *  \returns    false if any frame is different, or the reference can't be read.
+             */
+            bool            verify( const QString& referenceFileName ) const;
+
+        private:
+            mutable QMutex              m_lock;
+            QMap<qint64, uint64_t>      m_hashes;
+    };
+}
+
+#endif // FRAMEHASH_H
@@ -0,0 +1,263 @@
+/*****************************************************************************
+ * FrameIndex.cpp: Presentation times and keyframes of a video stream
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "FrameIndex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#ifdef HAVE_AVFORMAT
+extern "C"
+{
+# include <libavformat/avformat.h>
+}
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace Tools;
+
+namespace
+{
+    const char          Magic[4] = { 'V', 'F', 'I', 'X' };
+    const uint32_t      Version = 1;
+
+    struct Header
+    {
+        char        magic[4];
+        uint32_t    version;
+        int64_t     nbFrames;
+    };
+}
+
+#ifdef HAVE_AVFORMAT
+namespace
+{
+    using Frames = std::vector<std::pair<int64_t, bool>>;
+
+    // Returns the stream to index, or -1. The packets of the others are discarded.
+    int
+    openVideo( const QString& path, AVFormatContext*& context )
+    {
+        if ( avformat_open_input( &context, QFile::encodeName( path ).constData(), nullptr, nullptr ) < 0 )
+            return -1;
+        auto stream = -1;
+        if ( avformat_find_stream_info( context, nullptr ) >= 0 )
+            stream = av_find_best_stream( context, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0 );
+        // Still images only have a single frame, there's nothing to index
+        if ( stream < 0 || ( context->streams[stream]->disposition & AV_DISPOSITION_ATTACHED_PIC ) != 0 )
+            return -1;
+        for ( unsigned int i = 0; i < context->nb_streams; ++i )
+            context->streams[i]->discard = (int)i == stream ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+        return stream;
+    }
+
+    // Reads the packets up to the end of the file, in decoding order
+    void
+    readPackets( AVFormatContext* context, int stream, const std::atomic_bool& abort,
+                 Frames& frames, int64_t& lastKeyframePos )
+    {
+        auto packet = av_packet_alloc();
+        while ( abort == false && av_read_frame( context, packet ) >= 0 )
+        {
+            if ( packet->stream_index == stream )
+            {
+                auto pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+                auto keyframe = ( packet->flags & AV_PKT_FLAG_KEY ) != 0;
+                if ( pts != AV_NOPTS_VALUE )
+                    frames.emplace_back( pts, keyframe );
+                if ( keyframe == true && packet->pos >= 0 )
+                    lastKeyframePos = packet->pos;
+            }
+            av_packet_unref( packet );
+        }
+        av_packet_free( &packet );
+    }
+}
+#endif
+
+std::shared_ptr<FrameIndex>
+FrameIndex::build( const QString& path, const std::atomic_bool& abort )
+{
+#ifdef HAVE_AVFORMAT
+    AVFormatContext* context = nullptr;
+    std::shared_ptr<FrameIndex> index;
+    Frames frames;
+    int64_t lastKeyframePos = -1;
+    auto stream = openVideo( path, context );
+    if ( stream >= 0 )
+        readPackets( context, stream, abort, frames, lastKeyframePos );
+    if ( abort == false && frames.empty() == false )
+    {
+        // Packets come in decoding order, B frames are shown before the ones they
+        // depend on
+        std::sort( frames.begin(), frames.end() );
+        index.reset( new FrameIndex );
+        index->m_firstPts = frames.front().first;
+        index->m_timeBase = av_q2d( context->streams[stream]->time_base );
+        index->m_resumePos = lastKeyframePos;
+        index->m_times.reserve( frames.size() );
+        index->m_keyframes.reserve( frames.size() );
+        index->append( frames.cbegin(), frames.cend() );
+    }
+    avformat_close_input( &context );
+    return index;
+#else
+    Q_UNUSED( path );
+    Q_UNUSED( abort );
+    return nullptr;
+#endif
+}
+
+std::shared_ptr<FrameIndex>
+FrameIndex::extend( const FrameIndex& index, const QString& path, const std::atomic_bool& abort )
+{
+#ifdef HAVE_AVFORMAT
+    if ( index.m_resumePos < 0 || index.m_times.empty() == true )
+        return build( path, abort );
+    AVFormatContext* context = nullptr;
+    std::shared_ptr<FrameIndex> extended;
+    Frames frames;
+    auto lastKeyframePos = index.m_resumePos;
+    // The frames shown from the last keyframe on may not all have been written when
+    // the index was built: they are indexed again
+    auto keyframe = index.m_previousKeyframe.back();
+    auto keyframePts = index.m_firstPts + std::llround( index.m_times[keyframe] / index.m_timeBase );
+    auto stream = openVideo( path, context );
+    if ( stream >= 0 && av_seek_frame( context, -1, index.m_resumePos, AVSEEK_FLAG_BYTE ) >= 0 )
+        readPackets( context, stream, abort, frames, lastKeyframePos );
+    std::sort( frames.begin(), frames.end() );
+    auto first = std::lower_bound( frames.cbegin(), frames.cend(), std::make_pair( keyframePts, false ) );
+    if ( abort == false && frames.cend() - first > (ptrdiff_t)( index.m_times.size() - keyframe ) )
+    {
+        extended.reset( new FrameIndex( index ) );
+        extended->m_times.resize( keyframe );
+        extended->m_keyframes.resize( keyframe );
+        extended->m_resumePos = lastKeyframePos;
+        extended->append( first, frames.cend() );
+    }
+    avformat_close_input( &context );
+    return extended;
+#else
+    Q_UNUSED( index );
+    Q_UNUSED( path );
+    Q_UNUSED( abort );
+    return nullptr;
+#endif
+}
+
+void
+FrameIndex::append( std::vector<std::pair<int64_t, bool>>::const_iterator begin,
+                    std::vector<std::pair<int64_t, bool>>::const_iterator end )
+{
+    for ( auto f = begin; f != end; ++f )
+    {
+        m_times.push_back( ( f->first - m_firstPts ) * m_timeBase );
+        m_keyframes.push_back( f->second == true ? 1 : 0 );
+    }
+    finalize();
+}
+
+void
+FrameIndex::finalize()
+{
+    m_previousKeyframe.resize( m_times.size() );
+    uint32_t keyframe = 0;
+    for ( size_t i = 0; i < m_times.size(); ++i )
+    {
+        if ( m_keyframes[i] != 0 )
+            keyframe = i;
+        m_previousKeyframe[i] = keyframe;
+    }
+}
+
+std::shared_ptr<FrameIndex>
+FrameIndex::load( const QString& path )
+{
+    QFile   file( path );
+    if ( file.open( QFile::ReadOnly ) == false )
+        return nullptr;
+    Header header;
+    if ( file.read( reinterpret_cast<char*>( &header ), sizeof( header ) ) != sizeof( header ) ||
+         memcmp( header.magic, Magic, sizeof( Magic ) ) != 0 || header.version != Version ||
+         header.nbFrames <= 0 ||
+         file.size() != (qint64)sizeof( header ) + header.nbFrames * (qint64)( sizeof( double ) + 1 ) )
+        return nullptr;
+
+    std::shared_ptr<FrameIndex> index( new FrameIndex );
+    index->m_times.resize( header.nbFrames );
+    index->m_keyframes.resize( header.nbFrames );
+    auto timesSize = header.nbFrames * (qint64)sizeof( double );
+    if ( file.read( reinterpret_cast<char*>( index->m_times.data() ), timesSize ) != timesSize ||
+         file.read( reinterpret_cast<char*>( index->m_keyframes.data() ), header.nbFrames ) != header.nbFrames )
+        return nullptr;
+    index->finalize();
+    return index;
+}
+
+bool
+FrameIndex::save( const QString& path ) const
+{
+    if ( QDir().mkpath( QFileInfo( path ).absolutePath() ) == false )
+        return false;
+    Header header;
+    memcpy( header.magic, Magic, sizeof( Magic ) );
+    header.version = Version;
+    header.nbFrames = m_times.size();
+
+    QSaveFile   file( path );
+    if ( file.open( QFile::WriteOnly ) == false )
+        return false;
+    file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    file.write( reinterpret_cast<const char*>( m_times.data() ), m_times.size() * sizeof( double ) );
+    file.write( reinterpret_cast<const char*>( m_keyframes.data() ), m_keyframes.size() );
+    return file.commit();
+}
+
+FrameIndex::Seek
+FrameIndex::seek( int64_t position, double fps ) const
+{
+    // The frame shown at a position is the last one starting before it ends, give or
+    // take a rounding error
+    auto time = ( position + 0.5 ) / fps;
+    auto it = std::upper_bound( m_times.begin(), m_times.end(), time );
+    size_t frame = it == m_times.begin() ? 0 : it - m_times.begin() - 1;
+    auto keyframe = m_previousKeyframe[frame];
+    Seek s;
+    s.keyframe = static_cast<int64_t>( std::ceil( m_times[keyframe] * fps - 0.5 ) );
+    s.nbFrames = frame - keyframe;
+    return s;
+}
+
+int64_t
+FrameIndex::nbFrames() const
+{
+    return m_times.size();
+}
@@ -0,0 +1,102 @@
+/*****************************************************************************
+ * FrameIndex.h: Presentation times and keyframes of a video stream
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef FRAMEINDEX_H
+#define FRAMEINDEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class   QString;
+
+namespace Tools
+{
+    /**
+     *  \brief  The presentation time of every frame of a media's video, and whether it
+     *          is a keyframe.
+     *
+     *  Built by demuxing the file, without decoding it, so this is mostly bound by the
+     *  file read speed. It is exact for variable frame rate streams, and tells how far
+     *  back a decoder has to start for any frame of a long GOP stream.
+     */
+    class FrameIndex
+    {
+        public:
+            struct Seek
+            {
+                // The first position, in frames at the given fps, showing the keyframe
+                int64_t     keyframe;
+                // The frames to decode from the keyframe to reach the position
+                int64_t     nbFrames;
+            };
+
+            /**
+             *  \brief  Demuxes the whole file. Returns nullptr if it has no video, when
+             *          aborted, or when built without libavformat.
+             */
+            static std::shared_ptr<FrameIndex>  build( const QString& path,
+                                                       const std::atomic_bool& abort );
+            /**
+             *  \brief  Indexes the frames written to a growing file since index was
+             *          built, without demuxing it again from the beginning.
+             *
+             *  Returns nullptr when aborted, or when no frame was added. Loaded indexes
+             *  don't know where to resume from, the file gets indexed again.
+             */
+            static std::shared_ptr<FrameIndex>  extend( const FrameIndex& index, const QString& path,
+                                                        const std::atomic_bool& abort );
+            static std::shared_ptr<FrameIndex>  load( const QString& path );
+            bool            save( const QString& path ) const;
+
+            /**
+             *  \brief  Locates the frame shown at position, in frames at fps from the
+             *          beginning of the media, and the keyframe its decoding starts from.
+             */
+            Seek            seek( int64_t position, double fps ) const;
+            int64_t         nbFrames() const;
+
+        private:
+            FrameIndex() = default;
+            // Appends frames, as sorted (pts, keyframe) pairs, and links them to their keyframes
+            void            append( std::vector<std::pair<int64_t, bool>>::const_iterator begin,
+                                    std::vector<std::pair<int64_t, bool>>::const_iterator end );
+            // Links each frame to its keyframe, once the times are sorted
+            void            finalize();
+
+        private:
+            // In seconds from the first frame, in presentation order
+            std::vector<double>     m_times;
+            std::vector<uint8_t>    m_keyframes;
+            // Not stored: the index of the keyframe preceding each frame
+            std::vector<uint32_t>   m_previousKeyframe;
+            // Not stored either: how to convert the timestamps, and the file offset of the
+            // last keyframe, to resume demuxing from. -1 when unknown
+            int64_t                 m_firstPts = 0;
+            double                  m_timeBase = 0;
+            int64_t                 m_resumePos = -1;
+    };
+}
+
+#endif // FRAMEINDEX_H
@@ -0,0 +1,201 @@
+/*****************************************************************************
+ * FramePool.cpp: Recycled image buffers
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "FramePool.h"
+#include "Tools/Metrics.h"
+
+#include <QMutex>
+#include <QPainter>
+
+#include <vector>
+
+namespace
+{
+    const size_t    Alignment = 64;
+    const int       MinClassBits = 12;
+    // 64MiB, larger buffers aren't pooled
+    const int       NbClasses = 15;
+
+    class Pool
+    {
+        public:
+            Pool() : m_cached( 0 ), m_maxCached( 64 * 1024 * 1024 ) {}
+
+            uint8_t*    take( int sizeClass )
+            {
+                {
+                    QMutexLocker    lock( &m_mutex );
+                    auto& free = m_free[sizeClass];
+                    if ( free.empty() == false )
+                    {
+                        auto buffer = free.back();
+                        free.pop_back();
+                        m_cached -= classSize( sizeClass );
+                        publish();
+                        return buffer;
+                    }
+                }
+                static auto& misses = Tools::Metrics::counter( "framepool.misses" );
+                misses.add();
+                return static_cast<uint8_t*>( qMallocAligned( classSize( sizeClass ), Alignment ) );
+            }
+
+            void        give( uint8_t* buffer, int sizeClass )
+            {
+                {
+                    QMutexLocker    lock( &m_mutex );
+                    if ( m_cached + classSize( sizeClass ) <= m_maxCached )
+                    {
+                        m_free[sizeClass].push_back( buffer );
+                        m_cached += classSize( sizeClass );
+                        publish();
+                        return;
+                    }
+                }
+                qFreeAligned( buffer );
+            }
+
+            void        setMaxCached( size_t bytes )
+            {
+                QMutexLocker    lock( &m_mutex );
+                m_maxCached = bytes;
+                // The largest buffers go first
+                for ( int c = NbClasses - 1; c >= 0 && m_cached > m_maxCached; --c )
+                {
+                    auto& free = m_free[c];
+                    while ( free.empty() == false && m_cached > m_maxCached )
+                    {
+                        qFreeAligned( free.back() );
+                        free.pop_back();
+                        m_cached -= classSize( c );
+                    }
+                }
+                publish();
+            }
+
+            size_t      cached()
+            {
+                QMutexLocker    lock( &m_mutex );
+                return m_cached;
+            }
+
+            static size_t   classSize( int sizeClass )
+            {
+                return static_cast<size_t>( 1 ) << ( MinClassBits + sizeClass );
+            }
+
+        private:
+            // Called with m_mutex held
+            void        publish()
+            {
+                static auto& account = Tools::Metrics::memory( "framepool" );
+                int64_t nbBuffers = 0;
+                for ( const auto& free : m_free )
+                    nbBuffers += free.size();
+                account.set( m_cached, nbBuffers );
+            }
+
+        private:
+            QMutex                  m_mutex;
+            std::vector<uint8_t*>   m_free[NbClasses];
+            size_t                  m_cached;
+            size_t                  m_maxCached;
+    };
+
+    Pool&
+    pool()
+    {
+        // Never destroyed: static images can be released after it would be
+        static auto p = new Pool;
+        return *p;
+    }
+
+    int
+    sizeClass( size_t size )
+    {
+        int c = 0;
+        while ( c < NbClasses && Pool::classSize( c ) < size )
+            ++c;
+        return c;
+    }
+}
+
+Tools::FramePool::Buffer
+Tools::FramePool::acquire( size_t size )
+{
+    auto c = sizeClass( size );
+    if ( c == NbClasses )
+        return Buffer( static_cast<uint8_t*>( qMallocAligned( size, Alignment ) ), []( uint8_t* buffer )
+        {
+            qFreeAligned( buffer );
+        } );
+    return Buffer( pool().take( c ), [c]( uint8_t* buffer )
+    {
+        pool().give( buffer, c );
+    } );
+}
+
+QImage
+Tools::FramePool::image( int width, int height, QImage::Format format )
+{
+    if ( width <= 0 || height <= 0 || format == QImage::Format_Invalid )
+        return QImage();
+    auto depth = QImage::toPixelFormat( format ).bitsPerPixel();
+    auto bytesPerLine = ( ( static_cast<size_t>( width ) * depth + 7 ) / 8 + Alignment - 1 ) & ~( Alignment - 1 );
+    auto ref = new Buffer( acquire( bytesPerLine * height ) );
+    return QImage( ref->get(), width, height, static_cast<int>( bytesPerLine ), format, []( void* ref )
+    {
+        delete static_cast<Buffer*>( ref );
+    }, ref );
+}
+
+QImage
+Tools::FramePool::scaled( const QImage& image, const QSize& size, Qt::AspectRatioMode aspectMode,
+                          Qt::TransformationMode mode )
+{
+    if ( image.isNull() == true || size.isEmpty() == true )
+        return QImage();
+    auto target = image.size().scaled( size, aspectMode );
+    if ( target == image.size() )
+        return image;
+    auto res = FramePool::image( target.width(), target.height(), image.format() );
+    QPainter    painter;
+    // The formats QPainter can't draw on, such as the indexed ones, are left to Qt
+    if ( painter.begin( &res ) == false )
+        return image.scaled( size, aspectMode, mode );
+    painter.setCompositionMode( QPainter::CompositionMode_Source );
+    painter.setRenderHint( QPainter::SmoothPixmapTransform, mode == Qt::SmoothTransformation );
+    painter.drawImage( QRect( QPoint( 0, 0 ), target ), image );
+    return res;
+}
+
+void
+Tools::FramePool::setMaxCached( size_t bytes )
+{
+    pool().setMaxCached( bytes );
+}
+
+size_t
+Tools::FramePool::cachedSize()
+{
+    return pool().cached();
+}
@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * FramePool.h: Recycled image buffers
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QImage>
+#include <QSize>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Tools
+{
+/**
+ *  \brief  Process wide pool of the buffers of the images built for display.
+ *
+ *  The scopes, waveforms, thumbnails and export previews build a new image many times
+ *  per second, mostly of the same few sizes. Buffers are rounded up to a power of two,
+ *  at least 4KiB, and each size class keeps the buffers given back to it, up to a
+ *  total set by setMaxCached(). Buffers are 64 bytes aligned, and so are the lines of
+ *  the images.
+ *  All the functions are thread safe.
+ */
+namespace FramePool
+{
+    typedef std::shared_ptr<uint8_t>    Buffer;
+
+    /**
+     *  \brief  Returns a buffer of at least size bytes, recycled once its last
+     *          reference is released. Its content is undefined.
+     */
+    Buffer      acquire( size_t size );
+    /**
+     *  \brief  Returns an image using a pooled buffer. Its content is undefined.
+     *
+     *  Copies of the image share the buffer, which is given back to the pool along
+     *  with the last of them.
+     */
+    QImage      image( int width, int height, QImage::Format format );
+    /**
+     *  \brief  Same as QImage::scaled(), into a pooled image of the same format.
+     */
+    QImage      scaled( const QImage& image, const QSize& size,
+                        Qt::AspectRatioMode aspectMode = Qt::KeepAspectRatio,
+                        Qt::TransformationMode mode = Qt::SmoothTransformation );
+
+    // In bytes. The buffers in excess are freed as they're given back.
+    void        setMaxCached( size_t bytes );
+    size_t      cachedSize();
+}
+}
+
+#endif // FRAMEPOOL_H
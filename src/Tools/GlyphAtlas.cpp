@@ -0,0 +1,203 @@
+/*****************************************************************************
+ * GlyphAtlas.cpp: Rasterized glyphs shared by the titles
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "GlyphAtlas.h"
+#include "Title.h"
+
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QRawFont>
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+
+struct Glyph
+{
+    QRect   rect;
+    // From the pen position on the baseline to the top left corner of the glyph
+    int     left;
+    int     top;
+};
+
+struct Font
+{
+    QRawFont                raw;
+    QImage                  atlas;
+    QHash<quint32, Glyph>   glyphs;
+    // Where the next glyph gets packed
+    int                     x = 0;
+    int                     y = 0;
+    int                     rowHeight = 0;
+};
+
+std::mutex                                      mutex;
+std::map<QString, std::unique_ptr<Font>>        fonts;
+
+// Must be called with the lock held
+Font&
+font( const Tools::Title& title, int pixelSize )
+{
+    auto key = title.fontFamily + '/' + QString::number( pixelSize ) + '/' +
+            QString::number( title.bold ) + QString::number( title.italic );
+    auto& f = fonts[key];
+    if ( f == nullptr )
+    {
+        f.reset( new Font );
+        QFont qFont( title.fontFamily );
+        qFont.setPixelSize( pixelSize );
+        qFont.setBold( title.bold );
+        qFont.setItalic( title.italic );
+        f->raw = QRawFont::fromFont( qFont );
+        f->atlas = QImage( Tools::GlyphAtlas::Width, 256, QImage::Format_Alpha8 );
+        f->atlas.fill( 0 );
+    }
+    return *f;
+}
+
+// Returns the glyph, rasterizing it if it isn't in the atlas yet. Must be called with
+// the lock held
+const Glyph*
+glyph( Font& f, quint32 index )
+{
+    auto it = f.glyphs.constFind( index );
+    if ( it != f.glyphs.constEnd() )
+        return &it.value();
+    auto mask = f.raw.alphaMapForGlyph( index, QRawFont::PixelAntialiasing );
+    // Alpha maps are 8 bits coverages, with a grey palette when indexed
+    if ( mask.format() != QImage::Format_Indexed8 && mask.format() != QImage::Format_Alpha8 &&
+         mask.format() != QImage::Format_Grayscale8 )
+        mask = mask.convertToFormat( QImage::Format_Grayscale8 );
+    auto w = mask.width();
+    auto h = mask.height();
+    if ( w > Tools::GlyphAtlas::Width )
+        return nullptr;
+    if ( f.x + w > Tools::GlyphAtlas::Width )
+    {
+        f.x = 0;
+        f.y += f.rowHeight;
+        f.rowHeight = 0;
+    }
+    if ( f.y + h > f.atlas.height() )
+    {
+        auto height = std::max( f.atlas.height() * 2, f.y + h );
+        if ( height > Tools::GlyphAtlas::MaxHeight )
+        {
+            // Full: start over rather than keep every glyph of every text ever shown
+            f.glyphs.clear();
+            f.x = f.y = f.rowHeight = 0;
+            f.atlas.fill( 0 );
+            if ( h > f.atlas.height() )
+                return nullptr;
+        }
+        else
+        {
+            QImage atlas( Tools::GlyphAtlas::Width, height, QImage::Format_Alpha8 );
+            atlas.fill( 0 );
+            for ( int line = 0; line < f.atlas.height(); ++line )
+                memcpy( atlas.scanLine( line ), f.atlas.constScanLine( line ), Tools::GlyphAtlas::Width );
+            f.atlas = atlas;
+        }
+    }
+    for ( int line = 0; line < h; ++line )
+        memcpy( f.atlas.scanLine( f.y + line ) + f.x, mask.constScanLine( line ), w );
+    auto bounds = f.raw.boundingRect( index );
+    Glyph g{ QRect( f.x, f.y, w, h ), static_cast<int>( std::floor( bounds.left() ) ),
+             static_cast<int>( std::floor( bounds.top() ) ) };
+    f.x += w;
+    f.rowHeight = std::max( f.rowHeight, h );
+    return &f.glyphs.insert( index, g ).value();
+}
+
+// Draws a glyph of the atlas, with its top left corner at (x, y)
+void
+blit( const Font& f, const Glyph& g, int x, int y, QRgb colour, uint32_t width, uint32_t height,
+      uint8_t* rgba )
+{
+    auto first = std::max( 0, -y );
+    auto last = std::min( g.rect.height(), static_cast<int>( height ) - y );
+    auto begin = std::max( 0, -x );
+    auto end = std::min( g.rect.width(), static_cast<int>( width ) - x );
+    auto alpha = static_cast<uint32_t>( qAlpha( colour ) );
+    for ( int line = first; line < last; ++line )
+    {
+        auto src = f.atlas.constScanLine( g.rect.y() + line ) + g.rect.x();
+        auto dst = rgba + ( static_cast<size_t>( y + line ) * width + x ) * 4;
+        for ( int i = begin; i < end; ++i )
+        {
+            auto a = src[i] * alpha / 255;
+            if ( a == 0 )
+                continue;
+            auto px = dst + i * 4;
+            // Every glyph has the same colour, only the coverages add up
+            px[0] = qRed( colour );
+            px[1] = qGreen( colour );
+            px[2] = qBlue( colour );
+            px[3] = static_cast<uint8_t>( a + px[3] * ( 255 - a ) / 255 );
+        }
+    }
+}
+
+}
+
+void
+Tools::GlyphAtlas::render( const Title& title, uint32_t width, uint32_t height, uint8_t* rgba )
+{
+    memset( rgba, 0, static_cast<size_t>( width ) * height * 4 );
+    auto pixelSize = static_cast<int>( std::lround( title.size * height ) );
+    if ( title.text.isEmpty() == true || pixelSize <= 0 )
+        return;
+
+    std::lock_guard<std::mutex> lock( mutex );
+    auto& f = font( title, pixelSize );
+    if ( f.raw.isValid() == false )
+        return;
+    auto lines = title.text.split( '\n' );
+    auto lineHeight = f.raw.ascent() + f.raw.descent() + f.raw.leading();
+    auto top = title.y * height - ( lines.size() * lineHeight - f.raw.leading() ) / 2;
+    for ( int i = 0; i < lines.size(); ++i )
+    {
+        auto indexes = f.raw.glyphIndexesForString( lines[i] );
+        auto advances = f.raw.advancesForGlyphIndexes( indexes );
+        qreal lineWidth = 0;
+        for ( const auto& a : advances )
+            lineWidth += a.x();
+        auto pen = title.x * width - lineWidth / 2;
+        auto baseline = static_cast<int>( std::lround( top + i * lineHeight + f.raw.ascent() ) );
+        for ( int j = 0; j < indexes.size(); ++j )
+        {
+            auto g = glyph( f, indexes[j] );
+            if ( g != nullptr )
+                blit( f, *g, static_cast<int>( std::lround( pen ) ) + g->left, baseline + g->top,
+                      title.colour, width, height, rgba );
+            pen += advances[j].x();
+        }
+    }
+}
@@ -0,0 +1,58 @@
+/*****************************************************************************
+ * GlyphAtlas.h: Rasterized glyphs shared by the titles
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include <cstdint>
+
+namespace Tools
+{
+    struct Title;
+
+    /**
+     *  \brief  Draws titles from glyphs which are only ever rasterized once.
+     *
+     *  Each font, at each pixel size, gets an alpha atlas the glyphs are packed in as
+     *  they're first needed. Drawing a title then only copies the glyphs it uses out of
+     *  the atlas, with the title colour. The atlases are shared by every title, and kept
+     *  for the lifetime of the process: a project only ever uses a few fonts.
+     *  This is thread safe.
+     */
+    class GlyphAtlas
+    {
+        public:
+            // The width of the atlases, which grow in height up to MaxHeight
+            static const int    Width = 1024;
+            static const int    MaxHeight = 4096;
+
+            /**
+             *  \brief  Draws title in a width x height RGBA buffer, with straight alpha.
+             *
+             *  The buffer is transparent outside of the text.
+             */
+            static void     render( const Title& title, uint32_t width, uint32_t height,
+                                    uint8_t* rgba );
+    };
+}
+
+#endif // GLYPHATLAS_H
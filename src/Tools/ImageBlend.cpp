@@ -0,0 +1,160 @@
+/*****************************************************************************
+ * ImageBlend.cpp: Vectorized cross-fade of 8 bit images
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ImageBlend.h"
+
+#if defined( __SSE2__ )
+# include <emmintrin.h>
+#endif
+#if ( defined( __x86_64__ ) || defined( __i386__ ) ) && defined( __GNUC__ )
+# include <immintrin.h>
+# define HAVE_AVX2_DISPATCH
+#endif
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+# include <arm_neon.h>
+# define HAVE_NEON
+#endif
+
+namespace
+{
+    using BlendFunction = void (*)( uint8_t*, const uint8_t*, size_t, uint32_t );
+
+    // Blends the bytes [from, size)
+    void
+    accumulate( uint8_t* a, const uint8_t* b, size_t from, size_t size, uint32_t weight )
+    {
+        const uint32_t inverse = 256 - weight;
+        for ( size_t i = from; i < size; ++i )
+            a[i] = (uint8_t)( ( a[i] * inverse + b[i] * weight + 128 ) >> 8 );
+    }
+
+    // The weighted sum of two bytes is at most 255 * 256 + 128, the 16 bit lanes hold it
+    // without overflowing, and weight = 256 still fits in them.
+
+#if defined( __SSE2__ )
+    void
+    blendSSE2( uint8_t* a, const uint8_t* b, size_t size, uint32_t weight )
+    {
+        const auto zero = _mm_setzero_si128();
+        const auto vweight = _mm_set1_epi16( (short)weight );
+        const auto vinverse = _mm_set1_epi16( (short)( 256 - weight ) );
+        const auto round = _mm_set1_epi16( 128 );
+        size_t i = 0;
+        for ( ; i + 16 <= size; i += 16 )
+        {
+            auto va = _mm_loadu_si128( (const __m128i*)( a + i ) );
+            auto vb = _mm_loadu_si128( (const __m128i*)( b + i ) );
+            auto lo = _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( va, zero ), vinverse ),
+                                     _mm_mullo_epi16( _mm_unpacklo_epi8( vb, zero ), vweight ) );
+            auto hi = _mm_add_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( va, zero ), vinverse ),
+                                     _mm_mullo_epi16( _mm_unpackhi_epi8( vb, zero ), vweight ) );
+            lo = _mm_srli_epi16( _mm_add_epi16( lo, round ), 8 );
+            hi = _mm_srli_epi16( _mm_add_epi16( hi, round ), 8 );
+            _mm_storeu_si128( (__m128i*)( a + i ), _mm_packus_epi16( lo, hi ) );
+        }
+        accumulate( a, b, i, size, weight );
+    }
+#endif
+
+#if defined( HAVE_AVX2_DISPATCH )
+    // The unpacks and the pack work within 128 bit lanes, which keeps the bytes in order
+    __attribute__(( target( "avx2" ) )) void
+    blendAVX2( uint8_t* a, const uint8_t* b, size_t size, uint32_t weight )
+    {
+        const auto zero = _mm256_setzero_si256();
+        const auto vweight = _mm256_set1_epi16( (short)weight );
+        const auto vinverse = _mm256_set1_epi16( (short)( 256 - weight ) );
+        const auto round = _mm256_set1_epi16( 128 );
+        size_t i = 0;
+        for ( ; i + 32 <= size; i += 32 )
+        {
+            auto va = _mm256_loadu_si256( (const __m256i*)( a + i ) );
+            auto vb = _mm256_loadu_si256( (const __m256i*)( b + i ) );
+            auto lo = _mm256_add_epi16( _mm256_mullo_epi16( _mm256_unpacklo_epi8( va, zero ), vinverse ),
+                                        _mm256_mullo_epi16( _mm256_unpacklo_epi8( vb, zero ), vweight ) );
+            auto hi = _mm256_add_epi16( _mm256_mullo_epi16( _mm256_unpackhi_epi8( va, zero ), vinverse ),
+                                        _mm256_mullo_epi16( _mm256_unpackhi_epi8( vb, zero ), vweight ) );
+            lo = _mm256_srli_epi16( _mm256_add_epi16( lo, round ), 8 );
+            hi = _mm256_srli_epi16( _mm256_add_epi16( hi, round ), 8 );
+            _mm256_storeu_si256( (__m256i*)( a + i ), _mm256_packus_epi16( lo, hi ) );
+        }
+        accumulate( a, b, i, size, weight );
+    }
+#endif
+
+#if defined( HAVE_NEON )
+    void
+    blendNEON( uint8_t* a, const uint8_t* b, size_t size, uint32_t weight )
+    {
+        const auto vweight = vdupq_n_u16( (uint16_t)weight );
+        const auto vinverse = vdupq_n_u16( (uint16_t)( 256 - weight ) );
+        const auto round = vdupq_n_u16( 128 );
+        size_t i = 0;
+        for ( ; i + 16 <= size; i += 16 )
+        {
+            auto va = vld1q_u8( a + i );
+            auto vb = vld1q_u8( b + i );
+            auto lo = vmlaq_u16( vmulq_u16( vmovl_u8( vget_low_u8( va ) ), vinverse ),
+                                 vmovl_u8( vget_low_u8( vb ) ), vweight );
+            auto hi = vmlaq_u16( vmulq_u16( vmovl_u8( vget_high_u8( va ) ), vinverse ),
+                                 vmovl_u8( vget_high_u8( vb ) ), vweight );
+            lo = vaddq_u16( lo, round );
+            hi = vaddq_u16( hi, round );
+            vst1q_u8( a + i, vcombine_u8( vshrn_n_u16( lo, 8 ), vshrn_n_u16( hi, 8 ) ) );
+        }
+        accumulate( a, b, i, size, weight );
+    }
+#endif
+
+    BlendFunction
+    resolve()
+    {
+#if defined( HAVE_AVX2_DISPATCH )
+        __builtin_cpu_init();
+        if ( __builtin_cpu_supports( "avx2" ) )
+            return &blendAVX2;
+#endif
+#if defined( __SSE2__ )
+        return &blendSSE2;
+#elif defined( HAVE_NEON )
+        return &blendNEON;
+#else
+        return &Tools::blendImagesScalar;
+#endif
+    }
+}
+
+void
+Tools::blendImagesScalar( uint8_t* a, const uint8_t* b, size_t size, uint32_t weight )
+{
+    accumulate( a, b, 0, size, weight );
+}
+
+void
+Tools::blendImages( uint8_t* a, const uint8_t* b, size_t size, uint32_t weight )
+{
+    if ( weight > 256 )
+        weight = 256;
+    // Resolved once, thread safe since C++11
+    static const BlendFunction blend = resolve();
+    blend( a, b, size, weight );
+}
@@ -0,0 +1,46 @@
+/*****************************************************************************
+ * ImageBlend.h: Vectorized cross-fade of 8 bit images
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef IMAGEBLEND_H
+#define IMAGEBLEND_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Tools
+{
+    /**
+     *  \brief  Blends size bytes of b into a, b weighing weight out of 256:
+     *          a = ( a * ( 256 - weight ) + b * weight + 128 ) >> 8
+     *
+     *  This uses the widest vector unit available on the running CPU (AVX2, SSE2 or
+     *  NEON), and gives the same bytes as the scalar loop.
+     */
+    void    blendImages( uint8_t* a, const uint8_t* b, size_t size, uint32_t weight );
+
+    /**
+     *  \brief  Scalar reference implementation of blendImages
+     */
+    void    blendImagesScalar( uint8_t* a, const uint8_t* b, size_t size, uint32_t weight );
+}
+
+#endif // IMAGEBLEND_H
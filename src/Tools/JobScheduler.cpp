@@ -0,0 +1,364 @@
+/*****************************************************************************
+ * JobScheduler.cpp: Prioritized pool for the background jobs
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "JobScheduler.h"
+#include "Tools/Metrics.h"
+#include "Tools/ThreadRole.h"
+
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <algorithm>
+
+using namespace Tools;
+
+namespace
+{
+    const char* const   QueuedGauges[JobScheduler::NbPriority] = {
+        "jobs.background.queued",
+        "jobs.visible.queued",
+        "jobs.interactive.queued",
+    };
+}
+
+JobScheduler::CancellationToken::CancellationToken()
+    : m_state( std::make_shared<State>() )
+{
+}
+
+bool
+JobScheduler::CancellationToken::isCanceled() const
+{
+    return m_state->canceled.load( std::memory_order_relaxed );
+}
+
+JobScheduler::JobScheduler( int nbThreads )
+    : m_lastId( 0 )
+    , m_throttle( 0 )
+    , m_stop( false )
+    , m_nbBackgroundThreads( 0 )
+{
+    if ( nbThreads <= 0 )
+        nbThreads = qMax( 2, QThread::idealThreadCount() * 2 );
+    auto cores = qMax( 1, QThread::idealThreadCount() );
+    for ( int i = 0; i < NbPriority; ++i )
+        m_nbRunning[i] = 0;
+    // Background jobs leave the other half of the threads to what's being looked at
+    m_maxConcurrency[Background] = qMax( 1, cores / 2 );
+    m_maxConcurrency[Visible] = cores;
+    m_maxConcurrency[Interactive] = 0;
+    // With a single thread, it has to serve every class
+    m_nbBackgroundThreads = nbThreads > 1 ? qMin( m_maxConcurrency[Background], nbThreads - 1 ) : 0;
+    for ( int i = 0; i < nbThreads; ++i )
+    {
+        bool background = i < m_nbBackgroundThreads;
+        m_threads.emplace_back( [this, background] { run( background ); } );
+    }
+}
+
+JobScheduler::~JobScheduler()
+{
+    {
+        QMutexLocker    lock( &m_mutex );
+        m_stop = true;
+        wakeAll();
+    }
+    for ( auto& t : m_threads )
+        t.join();
+}
+
+JobScheduler::JobId
+JobScheduler::schedule( Priority priority, Job job, const CancellationToken& token,
+                        const QVector<JobId>& dependencies )
+{
+    QMutexLocker    lock( &m_mutex );
+    auto id = ++m_lastId;
+    if ( token.isCanceled() == true )
+        return id;
+    Entry entry{ priority, std::move( job ), token, 0, QVector<JobId>(), false };
+    for ( auto dep : dependencies )
+    {
+        auto it = m_jobs.find( dep );
+        // Already completed
+        if ( it == m_jobs.end() )
+            continue;
+        it->dependents << id;
+        ++entry.nbBlockers;
+    }
+    ++token.m_state->nbJobs;
+    auto blocked = entry.nbBlockers > 0;
+    m_jobs.insert( id, std::move( entry ) );
+    if ( blocked == false )
+    {
+        m_queues[priority].push_back( id );
+        Metrics::gauge( QueuedGauges[priority] ).set( m_queues[priority].size() );
+        wakeOne( priority );
+    }
+    return id;
+}
+
+void
+JobScheduler::setPriority( JobId id, Priority priority )
+{
+    QMutexLocker    lock( &m_mutex );
+    auto it = m_jobs.find( id );
+    if ( it == m_jobs.end() || it->running == true || it->priority == priority )
+        return;
+    auto& queue = m_queues[it->priority];
+    auto qIt = std::find( queue.begin(), queue.end(), id );
+    auto old = it->priority;
+    it->priority = priority;
+    // Still waiting for its dependencies
+    if ( qIt == queue.end() )
+        return;
+    queue.erase( qIt );
+    m_queues[priority].push_back( id );
+    Metrics::gauge( QueuedGauges[old] ).set( m_queues[old].size() );
+    Metrics::gauge( QueuedGauges[priority] ).set( m_queues[priority].size() );
+    wakeOne( priority );
+}
+
+void
+JobScheduler::cancel( const CancellationToken& token )
+{
+    QMutexLocker    lock( &m_mutex );
+    token.m_state->canceled = true;
+    QVector<JobId>  dropped;
+    for ( auto it = m_jobs.cbegin(); it != m_jobs.cend(); ++it )
+    {
+        if ( it->running == false && it->token.m_state == token.m_state )
+            dropped << it.key();
+    }
+    for ( auto id : dropped )
+    {
+        // Dropped along with one of its dependencies already
+        auto it = m_jobs.find( id );
+        if ( it == m_jobs.end() )
+            continue;
+        auto& queue = m_queues[it->priority];
+        auto qIt = std::find( queue.begin(), queue.end(), id );
+        if ( qIt != queue.end() )
+            queue.erase( qIt );
+        complete( id );
+    }
+    for ( int i = 0; i < NbPriority; ++i )
+        Metrics::gauge( QueuedGauges[i] ).set( m_queues[i].size() );
+    // Yielding jobs of that token return
+    m_unthrottled.wakeAll();
+}
+
+bool
+JobScheduler::wait( const CancellationToken& token, int msecs )
+{
+    QElapsedTimer   timer;
+    timer.start();
+    QMutexLocker    lock( &m_mutex );
+    while ( token.m_state->nbJobs > 0 )
+    {
+        if ( msecs < 0 )
+            m_done.wait( &m_mutex );
+        else
+        {
+            auto left = msecs - timer.elapsed();
+            if ( left <= 0 || m_done.wait( &m_mutex, left ) == false )
+                return token.m_state->nbJobs == 0;
+        }
+    }
+    return true;
+}
+
+void
+JobScheduler::setMaxConcurrency( Priority priority, int nbThreads )
+{
+    QMutexLocker    lock( &m_mutex );
+    m_maxConcurrency[priority] = qMax( 0, nbThreads );
+    wakeAll();
+}
+
+int
+JobScheduler::maxConcurrency( Priority priority ) const
+{
+    QMutexLocker    lock( &m_mutex );
+    return m_maxConcurrency[priority];
+}
+
+int
+JobScheduler::nbThreads() const
+{
+    return (int)m_threads.size();
+}
+
+void
+JobScheduler::setThrottled( ThrottleReason reason, bool throttled )
+{
+    QMutexLocker    lock( &m_mutex );
+    auto old = m_throttle;
+    if ( throttled == true )
+        m_throttle |= reason;
+    else
+        m_throttle &= ~reason;
+    if ( ( old == 0 ) == ( m_throttle == 0 ) )
+        return;
+    Metrics::gauge( "jobs.throttled" ).set( m_throttle != 0 ? 1 : 0 );
+    if ( m_throttle == 0 )
+    {
+        m_unthrottled.wakeAll();
+        wakeAll();
+    }
+}
+
+bool
+JobScheduler::isThrottled() const
+{
+    QMutexLocker    lock( &m_mutex );
+    return m_throttle != 0;
+}
+
+bool
+JobScheduler::yield( const CancellationToken& token )
+{
+    QMutexLocker    lock( &m_mutex );
+    while ( m_throttle != 0 && token.isCanceled() == false && m_stop == false )
+        m_unthrottled.wait( &m_mutex );
+    return token.isCanceled() == false;
+}
+
+void
+JobScheduler::run( bool background )
+{
+    auto role = background == true ? ThreadRole::Background : ThreadRole::Jobs;
+    // The policies are usually only loaded from the settings once the threads started
+    unsigned int    policies = 0;
+    QMutexLocker    lock( &m_mutex );
+    for ( ;; )
+    {
+        JobId   id;
+        Entry*  entry;
+        if ( takeNext( id, entry, background ) == false )
+        {
+            if ( m_stop == true && m_jobs.isEmpty() == true )
+            {
+                // The threads of the other kind may be waiting for the last jobs
+                wakeAll();
+                return;
+            }
+            ( background == true ? m_backgroundWakeUp : m_wakeUp ).wait( &m_mutex );
+            continue;
+        }
+        auto priority = entry->priority;
+        // The entry stays in m_jobs until completed, but the hash can be rehashed
+        auto job = std::move( entry->job );
+        auto token = entry->token;
+        lock.unlock();
+        if ( policies != ThreadRole::version() )
+        {
+            policies = ThreadRole::version();
+            ThreadRole::apply( role );
+        }
+        job( token );
+        job = nullptr;
+        lock.relock();
+        --m_nbRunning[priority];
+        complete( id );
+        // A slot of a capped class just freed up
+        wakeOne( priority );
+    }
+}
+
+bool
+JobScheduler::takeNext( JobId& id, Entry*& entry, bool background )
+{
+    for ( int p = NbPriority - 1; p >= 0; --p )
+    {
+        if ( background != ( p == Background && m_nbBackgroundThreads > 0 ) )
+            continue;
+        auto& queue = m_queues[p];
+        if ( queue.empty() == true )
+            continue;
+        auto cap = capacity( p );
+        if ( cap < 0 || ( cap > 0 && m_nbRunning[p] >= cap ) )
+            continue;
+        id = queue.front();
+        queue.pop_front();
+        Metrics::gauge( QueuedGauges[p] ).set( queue.size() );
+        entry = &m_jobs[id];
+        entry->running = true;
+        ++m_nbRunning[p];
+        return true;
+    }
+    return false;
+}
+
+int
+JobScheduler::capacity( int priority ) const
+{
+    if ( m_throttle == 0 || priority == Interactive )
+        return m_maxConcurrency[priority];
+    // Background jobs are held back until the playback or the export stops: -1 means
+    // no thread at all
+    if ( priority == Background )
+        return -1;
+    return 1;
+}
+
+void
+JobScheduler::wakeOne( int priority )
+{
+    if ( priority == Background && m_nbBackgroundThreads > 0 )
+        m_backgroundWakeUp.wakeOne();
+    else
+        m_wakeUp.wakeOne();
+}
+
+void
+JobScheduler::wakeAll()
+{
+    m_wakeUp.wakeAll();
+    m_backgroundWakeUp.wakeAll();
+}
+
+void
+JobScheduler::complete( JobId id )
+{
+    auto it = m_jobs.find( id );
+    if ( it == m_jobs.end() )
+        return;
+    auto dependents = it->dependents;
+    auto state = it->token.m_state;
+    m_jobs.erase( it );
+    for ( auto dep : dependents )
+    {
+        auto d = m_jobs.find( dep );
+        if ( d == m_jobs.end() || --d->nbBlockers > 0 )
+            continue;
+        if ( d->token.isCanceled() == true )
+        {
+            complete( dep );
+            continue;
+        }
+        m_queues[d->priority].push_back( dep );
+        Metrics::gauge( QueuedGauges[d->priority] ).set( m_queues[d->priority].size() );
+        wakeOne( d->priority );
+    }
+    --state->nbJobs;
+    m_done.wakeAll();
+}
@@ -0,0 +1,193 @@
+/*****************************************************************************
+ * JobScheduler.h: Prioritized pool for the background jobs
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef JOBSCHEDULER_H
+#define JOBSCHEDULER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace Tools
+{
+
+/**
+ *  \brief  Runs the background work of the application on a single set of threads.
+ *
+ *  Jobs are served by priority class, highest first, and each class can be capped to a
+ *  number of threads, so that background work never takes all of them: a job the user
+ *  is waiting for always finds a thread soon.
+ *  A job can depend on other jobs, in which case it's only queued once they all
+ *  completed, or were dropped.
+ *  Jobs are scheduled along with a cancellation token, which they are expected to check
+ *  during long operations. Cancelling a token drops its jobs which didn't start.
+ *  While the preview plays or an export runs, the scheduler is throttled: no Background
+ *  job starts, and Visible ones are served one at a time, so that they don't compete
+ *  with the frames being rendered for the CPU and the disk.
+ *  Background jobs run on threads of their own, as many as their class is initially
+ *  capped to, with the Background thread role. \sa ThreadRole
+ */
+class JobScheduler
+{
+    public:
+        enum Priority
+        {
+            // Prefetching, analysis, copies...
+            Background,
+            // Things being displayed, such as the thumbnails of the visible clips
+            Visible,
+            // The user is waiting for it
+            Interactive,
+            NbPriority
+        };
+
+        // 0 is never a valid job
+        typedef quint64     JobId;
+
+        class CancellationToken
+        {
+            public:
+                CancellationToken();
+                bool        isCanceled() const;
+
+            private:
+                struct State
+                {
+                    State() : canceled( false ), nbJobs( 0 ) {}
+                    std::atomic<bool>   canceled;
+                    // Guarded by the scheduler lock
+                    int                 nbJobs;
+                };
+                std::shared_ptr<State>  m_state;
+
+                friend class JobScheduler;
+        };
+
+        typedef std::function<void( const CancellationToken& )>    Job;
+
+        // Why the scheduler is throttled. They can be combined.
+        enum ThrottleReason
+        {
+            Playback    = 1 << 0,
+            Export      = 1 << 1,
+        };
+
+        /**
+         *  \param  nbThreads   The number of threads, 0 for twice the number of cores:
+         *                      most jobs spend a good part of their time waiting for
+         *                      a file to be read.
+         */
+        explicit JobScheduler( int nbThreads = 0 );
+        // Waits for all the jobs, which should have been cancelled by their owners
+        ~JobScheduler();
+
+        JobId               schedule( Priority priority, Job job,
+                                      const CancellationToken& token = CancellationToken(),
+                                      const QVector<JobId>& dependencies = QVector<JobId>() );
+        /**
+         *  \brief  Moves a job which didn't start yet to another priority class.
+         */
+        void                setPriority( JobId id, Priority priority );
+        /**
+         *  \brief  Flags the token as cancelled, and drops its jobs which didn't start.
+         *
+         *  A token never gets reset: a new one has to be used afterward.
+         */
+        void                cancel( const CancellationToken& token );
+        /**
+         *  \brief  Blocks until every job of the token has completed, or was dropped.
+         *
+         *  Never to be called from one of these jobs.
+         *  \returns    false if it timed out.
+         */
+        bool                wait( const CancellationToken& token, int msecs = -1 );
+
+        // The number of threads running jobs of a class at once. 0 means no cap.
+        // Background jobs are also limited to their own threads.
+        void                setMaxConcurrency( Priority priority, int nbThreads );
+        int                 maxConcurrency( Priority priority ) const;
+        int                 nbThreads() const;
+
+        void                setThrottled( ThrottleReason reason, bool throttled );
+        bool                isThrottled() const;
+        /**
+         *  \brief  Blocks a running Background job for as long as the scheduler is throttled.
+         *
+         *  Long jobs call this between two chunks of work, so that they pause instead of
+         *  only being prevented from starting.
+         *  \returns    false if the token was cancelled meanwhile.
+         */
+        bool                yield( const CancellationToken& token );
+
+    private:
+        struct Entry
+        {
+            Priority                priority;
+            Job                     job;
+            CancellationToken       token;
+            // Dependencies which didn't complete yet
+            int                     nbBlockers;
+            QVector<JobId>          dependents;
+            bool                    running;
+        };
+
+        void                run( bool background );
+        // Called with m_mutex held
+        bool                takeNext( JobId& id, Entry*& entry, bool background );
+        // Same as m_maxConcurrency, once throttled. -1 when the class can't run.
+        int                 capacity( int priority ) const;
+        // Wake the threads which serve these jobs. Called with m_mutex held
+        void                wakeOne( int priority );
+        void                wakeAll();
+        void                complete( JobId id );
+
+    private:
+        mutable QMutex              m_mutex;
+        QWaitCondition              m_wakeUp;
+        QWaitCondition              m_backgroundWakeUp;
+        QWaitCondition              m_done;
+        QWaitCondition              m_unthrottled;
+        QHash<JobId, Entry>         m_jobs;
+        // The jobs ready to run, in order
+        std::deque<JobId>           m_queues[NbPriority];
+        int                         m_nbRunning[NbPriority];
+        int                         m_maxConcurrency[NbPriority];
+        JobId                       m_lastId;
+        // A set of ThrottleReason
+        int                         m_throttle;
+        bool                        m_stop;
+        // The first ones of m_threads, 0 when the others run the Background jobs too
+        int                         m_nbBackgroundThreads;
+        std::vector<std::thread>    m_threads;
+};
+
+}
+
+#endif // JOBSCHEDULER_H
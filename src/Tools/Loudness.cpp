@@ -0,0 +1,222 @@
+/*****************************************************************************
+ * Loudness.cpp: EBU R128 loudness measurement
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "Loudness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Tools;
+
+namespace
+{
+    const uint32_t  SubBlock = LoudnessMeter::Frequency / 10;
+    // 400ms gating blocks, and 3s short-term windows, in 100ms steps
+    const size_t    BlockLength = 4;
+    const size_t    ShortTermLength = 30;
+    const double    AbsoluteGate = -70.;
+    const double    RelativeGate = -10.;
+
+    // The 3 interpolated phases of a 4 times oversampling windowed sinc filter
+    const int       Oversampling = 4;
+    const int       NbTaps = 12;
+
+    struct Interpolator
+    {
+        float   taps[Oversampling - 1][NbTaps];
+
+        Interpolator()
+        {
+            const double pi = 3.14159265358979323846;
+            for ( int p = 1; p < Oversampling; ++p )
+            {
+                for ( int k = 0; k < NbTaps; ++k )
+                {
+                    // Distance from the interpolated point to the sample k
+                    auto x = ( NbTaps / 2 - 1 - k ) + static_cast<double>( p ) / Oversampling;
+                    auto sinc = std::sin( pi * x ) / ( pi * x );
+                    auto window = 0.5 + 0.5 * std::cos( pi * x / ( NbTaps / 2 ) );
+                    taps[p - 1][k] = sinc * window;
+                }
+            }
+        }
+    };
+
+    const Interpolator&
+    interpolator()
+    {
+        static const Interpolator i;
+        return i;
+    }
+
+    double
+    loudness( double meanSquare )
+    {
+        if ( meanSquare <= 0 )
+            return -std::numeric_limits<double>::infinity();
+        return -0.691 + 10. * std::log10( meanSquare );
+    }
+}
+
+Loudness::Loudness()
+    : integrated( -std::numeric_limits<double>::infinity() )
+    , maxShortTerm( -std::numeric_limits<double>::infinity() )
+    , truePeak( -std::numeric_limits<double>::infinity() )
+{
+}
+
+bool
+Loudness::isValid() const
+{
+    return std::isfinite( integrated );
+}
+
+double
+Loudness::normalizationGain( double target, double maxTruePeak ) const
+{
+    if ( isValid() == false )
+        return 1.;
+    auto gain = target - integrated;
+    if ( std::isfinite( truePeak ) == true )
+        gain = std::min( gain, maxTruePeak - truePeak );
+    return std::pow( 10., gain / 20. );
+}
+
+double
+LoudnessMeter::Biquad::process( double x )
+{
+    // Transposed direct form II
+    auto y = b0 * x + z1;
+    z1 = b1 * x - a1 * y + z2;
+    z2 = b2 * x - a2 * y;
+    return y;
+}
+
+LoudnessMeter::LoudnessMeter( uint32_t channels )
+    : m_channels( channels )
+    , m_sum( 0 )
+    , m_count( 0 )
+    , m_historyPos( 0 )
+    , m_peak( 0 )
+{
+    Channel c;
+    c.shelf = Biquad{ 1.53512485958697, -2.69169618940638, 1.19839281085285,
+                      -1.69065929318241, 0.73248077421585, 0, 0 };
+    c.highPass = Biquad{ 1.0, -2.0, 1.0, -1.99004745483398, 0.99007225036621, 0, 0 };
+    c.history.assign( NbTaps, 0.f );
+    m_measured.assign( std::min( channels, 2u ), c );
+}
+
+void
+LoudnessMeter::addSample( Channel& channel, float x )
+{
+    auto y = channel.highPass.process( channel.shelf.process( x ) );
+    m_sum += y * y;
+
+    channel.history[m_historyPos] = x;
+    m_peak = std::max( m_peak, std::abs( x ) );
+    const auto& taps = interpolator().taps;
+    for ( int p = 0; p < Oversampling - 1; ++p )
+    {
+        float v = 0;
+        // The history is a ring, the oldest sample being right after the newest one
+        for ( int k = 0; k < NbTaps; ++k )
+            v += taps[p][k] * channel.history[( m_historyPos + 1 + k ) % NbTaps];
+        m_peak = std::max( m_peak, std::abs( v ) );
+    }
+}
+
+void
+LoudnessMeter::add( const int16_t* samples, uint32_t nbSamples )
+{
+    if ( m_measured.empty() == true )
+        return;
+    for ( uint32_t i = 0; i < nbSamples; ++i )
+    {
+        for ( size_t c = 0; c < m_measured.size(); ++c )
+            addSample( m_measured[c], samples[i * m_channels + c] / 32768.f );
+        m_historyPos = ( m_historyPos + 1 ) % NbTaps;
+        if ( ++m_count == SubBlock )
+        {
+            m_subBlocks.push_back( m_sum / SubBlock );
+            m_sum = 0;
+            m_count = 0;
+        }
+    }
+}
+
+Loudness
+LoudnessMeter::result() const
+{
+    Loudness res;
+    if ( m_peak > 0 )
+        res.truePeak = 20. * std::log10( m_peak );
+
+    // Overlapping by 75%
+    std::vector<double> blocks;
+    for ( size_t i = 0; i + BlockLength <= m_subBlocks.size(); ++i )
+    {
+        double sum = 0;
+        for ( size_t j = 0; j < BlockLength; ++j )
+            sum += m_subBlocks[i + j];
+        blocks.push_back( sum / BlockLength );
+    }
+    double sum = 0;
+    size_t count = 0;
+    for ( auto b : blocks )
+    {
+        if ( loudness( b ) > AbsoluteGate )
+        {
+            sum += b;
+            ++count;
+        }
+    }
+    if ( count > 0 )
+    {
+        auto threshold = loudness( sum / count ) + RelativeGate;
+        sum = 0;
+        count = 0;
+        for ( auto b : blocks )
+        {
+            auto l = loudness( b );
+            if ( l > AbsoluteGate && l > threshold )
+            {
+                sum += b;
+                ++count;
+            }
+        }
+        if ( count > 0 )
+            res.integrated = loudness( sum / count );
+    }
+
+    double window = 0;
+    for ( size_t i = 0; i < m_subBlocks.size(); ++i )
+    {
+        window += m_subBlocks[i];
+        if ( i >= ShortTermLength )
+            window -= m_subBlocks[i - ShortTermLength];
+        if ( i + 1 >= ShortTermLength )
+            res.maxShortTerm = std::max( res.maxShortTerm, loudness( window / ShortTermLength ) );
+    }
+    return res;
+}
@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * Loudness.h: EBU R128 loudness measurement
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LOUDNESS_H
+#define LOUDNESS_H
+
+#include <cstdint>
+#include <vector>
+
+namespace Tools
+{
+    /**
+     *  \brief  The loudness of a whole program, as defined by EBU R128.
+     */
+    struct Loudness
+    {
+        // In LUFS, gated. -inf for silence
+        double      integrated;
+        // In LUFS, the loudest 3 seconds window
+        double      maxShortTerm;
+        // In dBTP, estimated from 4 times oversampled samples
+        double      truePeak;
+
+        // Unmeasured, which is also what silence measures
+        Loudness();
+        bool        isValid() const;
+        /**
+         *  \returns    The linear gain bringing the integrated loudness to target,
+         *              lowered so that the true peak doesn't exceed maxTruePeak.
+         */
+        double      normalizationGain( double target, double maxTruePeak ) const;
+    };
+
+    /**
+     *  \brief  Measures the loudness of interleaved s16 samples, at 48kHz.
+     *
+     *  The first two channels are measured, as left and right, and the others are
+     *  ignored. The K-weighting filter coefficients are the ones BS.1770 gives for
+     *  48kHz, which is why no other frequency is supported.
+     */
+    class LoudnessMeter
+    {
+        public:
+            static const uint32_t   Frequency = 48000;
+
+            explicit LoudnessMeter( uint32_t channels );
+
+            void        add( const int16_t* samples, uint32_t nbSamples );
+            Loudness    result() const;
+
+        private:
+            struct Biquad
+            {
+                double  b0, b1, b2, a1, a2;
+                double  z1, z2;
+
+                double  process( double x );
+            };
+
+            struct Channel
+            {
+                Biquad              shelf;
+                Biquad              highPass;
+                // The last samples, to interpolate the true peak
+                std::vector<float>  history;
+            };
+
+            void        addSample( Channel& channel, float x );
+
+        private:
+            uint32_t                m_channels;
+            std::vector<Channel>    m_measured;
+            // The mean square of each 100ms of K-weighted audio, summed over channels
+            std::vector<double>     m_subBlocks;
+            double                  m_sum;
+            uint32_t                m_count;
+            uint32_t                m_historyPos;
+            float                   m_peak;
+    };
+}
+
+#endif // LOUDNESS_H
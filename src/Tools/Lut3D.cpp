@@ -0,0 +1,413 @@
+/*****************************************************************************
+ * Lut3D.cpp: 3D colour lookup tables
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "Lut3D.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined( __SSE2__ )
+# include <emmintrin.h>
+#endif
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+# include <arm_neon.h>
+# define HAVE_NEON
+#endif
+
+namespace
+{
+    struct CacheEntry
+    {
+        std::weak_ptr<const Tools::Lut3D>   lut;
+        QDateTime                           modified;
+        qint64                              size;
+    };
+
+    // Smaller slices cost more to hand over than to map
+    const size_t    MinSlicePixels = 64 * 1024;
+
+    QMutex                          cacheMutex;
+    // Indexed by canonical path, the tables are released along with their last user
+    QHash<QString, CacheEntry>      cache;
+
+    // The 4 corners of the tetrahedron containing a colour, and their weights
+    struct Tetrahedron
+    {
+        uint32_t    base;
+        uint32_t    first;
+        uint32_t    second;
+        float       weights[4];
+    };
+
+    inline void
+    tetrahedron( const uint32_t (*offsets)[256], const float (*fractions)[256],
+                 uint32_t greenStride, uint32_t blueStride, const uint8_t* pixel, Tetrahedron& t )
+    {
+        const uint32_t redStride = 4;
+        auto r = fractions[0][pixel[0]];
+        auto g = fractions[1][pixel[1]];
+        auto b = fractions[2][pixel[2]];
+        t.base = offsets[0][pixel[0]] + offsets[1][pixel[1]] + offsets[2][pixel[2]];
+        // The tetrahedron runs from the cell's origin to its opposite corner, along the
+        // axis of the largest fraction first, then the second largest one
+        if ( r > g )
+        {
+            if ( g > b )
+            {
+                t.first = redStride;
+                t.second = redStride + greenStride;
+                t.weights[0] = 1.f - r; t.weights[1] = r - g; t.weights[2] = g - b; t.weights[3] = b;
+            }
+            else if ( r > b )
+            {
+                t.first = redStride;
+                t.second = redStride + blueStride;
+                t.weights[0] = 1.f - r; t.weights[1] = r - b; t.weights[2] = b - g; t.weights[3] = g;
+            }
+            else
+            {
+                t.first = blueStride;
+                t.second = blueStride + redStride;
+                t.weights[0] = 1.f - b; t.weights[1] = b - r; t.weights[2] = r - g; t.weights[3] = g;
+            }
+        }
+        else
+        {
+            if ( b > g )
+            {
+                t.first = blueStride;
+                t.second = blueStride + greenStride;
+                t.weights[0] = 1.f - b; t.weights[1] = b - g; t.weights[2] = g - r; t.weights[3] = r;
+            }
+            else if ( b > r )
+            {
+                t.first = greenStride;
+                t.second = greenStride + blueStride;
+                t.weights[0] = 1.f - g; t.weights[1] = g - b; t.weights[2] = b - r; t.weights[3] = r;
+            }
+            else
+            {
+                t.first = greenStride;
+                t.second = greenStride + redStride;
+                t.weights[0] = 1.f - g; t.weights[1] = g - r; t.weights[2] = r - b; t.weights[3] = b;
+            }
+        }
+    }
+
+    inline uint8_t
+    toComponent( float v )
+    {
+        return static_cast<uint8_t>( std::max( 0.f, std::min( 255.f, v * 255.f + .5f ) ) );
+    }
+
+    class SliceJob : public QRunnable
+    {
+        public:
+            SliceJob( const Tools::Lut3D& lut, uint8_t* rgba, size_t count, QSemaphore& done )
+                : m_lut( lut )
+                , m_rgba( rgba )
+                , m_count( count )
+                , m_done( done )
+            {
+            }
+
+            virtual void run() override
+            {
+                m_lut.apply( m_rgba, m_count );
+                m_done.release();
+            }
+
+        private:
+            const Tools::Lut3D&     m_lut;
+            uint8_t*                m_rgba;
+            size_t                  m_count;
+            QSemaphore&             m_done;
+    };
+
+    QThreadPool&
+    slicePool()
+    {
+        static QThreadPool* pool = []() {
+            auto p = new QThreadPool;
+            // The calling thread maps a slice as well
+            p->setMaxThreadCount( std::max( 1, QThread::idealThreadCount() - 1 ) );
+            return p;
+        }();
+        return *pool;
+    }
+
+    // Reads count floats from the fields of a line, starting at first
+    bool
+    readFloats( const QList<QByteArray>& fields, int first, int count, float* out )
+    {
+        if ( fields.size() != first + count )
+            return false;
+        for ( int i = 0; i < count; ++i )
+        {
+            bool ok;
+            // Unlike strtof, this doesn't depend on the locale
+            out[i] = fields[first + i].toFloat( &ok );
+            if ( ok == false )
+                return false;
+        }
+        return true;
+    }
+}
+
+std::shared_ptr<const Tools::Lut3D>
+Tools::Lut3D::load( const std::string& path )
+{
+    QFileInfo   info( QFile::decodeName( path.c_str() ) );
+    auto key = info.canonicalFilePath();
+    if ( key.isEmpty() == true )
+        return nullptr;
+
+    // Parsed while holding the lock, so that the clips sharing a table starting at the
+    // same time don't all parse it
+    QMutexLocker    lock( &cacheMutex );
+    auto it = cache.find( key );
+    if ( it != cache.end() && it->modified == info.lastModified() && it->size == info.size() )
+    {
+        auto lut = it->lut.lock();
+        if ( lut != nullptr )
+            return lut;
+    }
+    std::shared_ptr<const Lut3D> lut = parse( key );
+    if ( lut == nullptr )
+        return nullptr;
+    for ( auto e = cache.begin(); e != cache.end(); )
+    {
+        if ( e->lut.expired() == true )
+            e = cache.erase( e );
+        else
+            ++e;
+    }
+    cache.insert( key, CacheEntry{ lut, info.lastModified(), info.size() } );
+    return lut;
+}
+
+std::shared_ptr<Tools::Lut3D>
+Tools::Lut3D::parse( const QString& path )
+{
+    QFile   file( path );
+    if ( file.open( QFile::ReadOnly ) == false )
+    {
+        vlmcWarning() << "Can't open LUT" << path;
+        return nullptr;
+    }
+    std::shared_ptr<Lut3D>  lut( new Lut3D );
+    lut->m_size = 0;
+    float domainMin[3] = { 0.f, 0.f, 0.f };
+    float domainMax[3] = { 1.f, 1.f, 1.f };
+    size_t nbEntries = 0;
+    auto lines = file.readAll().split( '\n' );
+    for ( int i = 0; i < lines.size(); ++i )
+    {
+        auto line = lines[i].simplified();
+        if ( line.isEmpty() == true || line.startsWith( '#' ) == true )
+            continue;
+        auto fields = line.split( ' ' );
+        if ( fields[0] == "TITLE" )
+            continue;
+        auto ok = true;
+        if ( fields[0] == "LUT_3D_SIZE" )
+        {
+            auto size = fields.size() == 2 ? fields[1].toUInt( &ok ) : 0;
+            if ( size < 2 || size > MaxSize || lut->m_size != 0 )
+                ok = false;
+            else
+            {
+                lut->m_size = size;
+                lut->m_table.resize( size * size * size * 4 );
+            }
+        }
+        else if ( fields[0] == "LUT_1D_SIZE" )
+        {
+            vlmcWarning() << "1D LUTs aren't supported:" << path;
+            return nullptr;
+        }
+        else if ( fields[0] == "DOMAIN_MIN" )
+            ok = readFloats( fields, 1, 3, domainMin );
+        else if ( fields[0] == "DOMAIN_MAX" )
+            ok = readFloats( fields, 1, 3, domainMax );
+        else
+        {
+            if ( nbEntries >= lut->m_table.size() / 4 )
+                ok = false;
+            else
+            {
+                auto entry = lut->m_table.data() + nbEntries * 4;
+                ok = readFloats( fields, 0, 3, entry );
+                entry[3] = 0.f;
+                ++nbEntries;
+            }
+        }
+        if ( ok == false )
+        {
+            vlmcWarning() << "Invalid line" << i + 1 << "in LUT" << path;
+            return nullptr;
+        }
+    }
+    if ( lut->m_size == 0 || nbEntries != lut->m_table.size() / 4 )
+    {
+        vlmcWarning() << "LUT" << path << "has" << nbEntries << "entries instead of" << lut->m_table.size() / 4;
+        return nullptr;
+    }
+    for ( int c = 0; c < 3; ++c )
+    {
+        if ( domainMax[c] <= domainMin[c] )
+        {
+            vlmcWarning() << "Invalid domain in LUT" << path;
+            return nullptr;
+        }
+    }
+    lut->prepare( domainMin, domainMax );
+    return lut;
+}
+
+void
+Tools::Lut3D::prepare( const float domainMin[3], const float domainMax[3] )
+{
+    const uint32_t strides[3] = { 4, m_size * 4, m_size * m_size * 4 };
+    for ( int c = 0; c < 3; ++c )
+    {
+        for ( int v = 0; v < 256; ++v )
+        {
+            auto x = ( v / 255.f - domainMin[c] ) / ( domainMax[c] - domainMin[c] );
+            auto pos = std::max( 0.f, std::min( 1.f, x ) ) * ( m_size - 1 );
+            // The last cell also holds the upper bound, with a fraction of 1
+            auto cell = std::min( static_cast<uint32_t>( pos ), m_size - 2 );
+            m_offsets[c][v] = cell * strides[c];
+            m_fractions[c][v] = pos - cell;
+        }
+    }
+}
+
+uint32_t
+Tools::Lut3D::size() const
+{
+    return m_size;
+}
+
+void
+Tools::Lut3D::applyScalar( uint8_t* rgba, size_t count ) const
+{
+    const auto table = m_table.data();
+    const auto greenStride = m_size * 4;
+    const auto blueStride = m_size * m_size * 4;
+    const auto last = 4 + greenStride + blueStride;
+    Tetrahedron t;
+    for ( size_t i = 0; i < count; ++i, rgba += 4 )
+    {
+        tetrahedron( m_offsets, m_fractions, greenStride, blueStride, rgba, t );
+        for ( int c = 0; c < 3; ++c )
+        {
+            auto v = t.weights[0] * table[t.base + c] +
+                     t.weights[1] * table[t.base + t.first + c] +
+                     t.weights[2] * table[t.base + t.second + c] +
+                     t.weights[3] * table[t.base + last + c];
+            rgba[c] = toComponent( v );
+        }
+    }
+}
+
+void
+Tools::Lut3D::applySliced( uint8_t* rgba, size_t count ) const
+{
+    auto& pool = slicePool();
+    auto nbSlices = std::min( static_cast<size_t>( pool.maxThreadCount() + 1 ), count / MinSlicePixels );
+    if ( nbSlices <= 1 )
+    {
+        apply( rgba, count );
+        return;
+    }
+    auto sliceSize = ( count + nbSlices - 1 ) / nbSlices;
+    QSemaphore  done;
+    size_t nbJobs = 0;
+    for ( size_t begin = sliceSize; begin < count; begin += sliceSize, ++nbJobs )
+        pool.start( new SliceJob( *this, rgba + begin * 4, std::min( sliceSize, count - begin ), done ) );
+    apply( rgba, sliceSize );
+    done.acquire( static_cast<int>( nbJobs ) );
+}
+
+void
+Tools::Lut3D::apply( uint8_t* rgba, size_t count ) const
+{
+#if defined( __SSE2__ ) || defined( HAVE_NEON )
+    const auto table = m_table.data();
+    const auto greenStride = m_size * 4;
+    const auto blueStride = m_size * m_size * 4;
+    const auto last = 4 + greenStride + blueStride;
+    Tetrahedron t;
+    // The padding component of the entries lets each corner be a single vector load
+# if defined( __SSE2__ )
+    const auto scale = _mm_set1_ps( 255.f );
+    for ( size_t i = 0; i < count; ++i, rgba += 4 )
+    {
+        tetrahedron( m_offsets, m_fractions, greenStride, blueStride, rgba, t );
+        auto v = _mm_mul_ps( _mm_loadu_ps( table + t.base ), _mm_set1_ps( t.weights[0] ) );
+        v = _mm_add_ps( v, _mm_mul_ps( _mm_loadu_ps( table + t.base + t.first ), _mm_set1_ps( t.weights[1] ) ) );
+        v = _mm_add_ps( v, _mm_mul_ps( _mm_loadu_ps( table + t.base + t.second ), _mm_set1_ps( t.weights[2] ) ) );
+        v = _mm_add_ps( v, _mm_mul_ps( _mm_loadu_ps( table + t.base + last ), _mm_set1_ps( t.weights[3] ) ) );
+        // Rounded to the nearest, then saturated to 8 bits
+        auto i32 = _mm_cvtps_epi32( _mm_mul_ps( v, scale ) );
+        auto i16 = _mm_packs_epi32( i32, i32 );
+        auto packed = static_cast<uint32_t>( _mm_cvtsi128_si32( _mm_packus_epi16( i16, i16 ) ) );
+        rgba[0] = packed & 0xFF;
+        rgba[1] = ( packed >> 8 ) & 0xFF;
+        rgba[2] = ( packed >> 16 ) & 0xFF;
+    }
+# else
+    const auto half = vdupq_n_f32( .5f );
+    for ( size_t i = 0; i < count; ++i, rgba += 4 )
+    {
+        tetrahedron( m_offsets, m_fractions, greenStride, blueStride, rgba, t );
+        auto v = vmulq_n_f32( vld1q_f32( table + t.base ), t.weights[0] );
+        v = vmlaq_n_f32( v, vld1q_f32( table + t.base + t.first ), t.weights[1] );
+        v = vmlaq_n_f32( v, vld1q_f32( table + t.base + t.second ), t.weights[2] );
+        v = vmlaq_n_f32( v, vld1q_f32( table + t.base + last ), t.weights[3] );
+        // Truncated after adding the rounding, negative values saturate to 0 anyway
+        auto i32 = vcvtq_s32_f32( vaddq_f32( vmulq_n_f32( v, 255.f ), half ) );
+        auto u16 = vqmovun_s32( i32 );
+        auto u8 = vqmovn_u16( vcombine_u16( u16, u16 ) );
+        rgba[0] = vget_lane_u8( u8, 0 );
+        rgba[1] = vget_lane_u8( u8, 1 );
+        rgba[2] = vget_lane_u8( u8, 2 );
+    }
+# endif
+#else
+    applyScalar( rgba, count );
+#endif
+}
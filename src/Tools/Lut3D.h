@@ -0,0 +1,92 @@
+/*****************************************************************************
+ * Lut3D.h: 3D colour lookup tables
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LUT3D_H
+#define LUT3D_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class   QString;
+
+namespace Tools
+{
+    /**
+     *  \brief  A 3D colour lookup table, loaded from a .cube file.
+     *
+     *  Colours are mapped through tetrahedral interpolation: each one falls in a cube of
+     *  the lattice, which is split in 6 tetrahedrons, and only the 4 corners of the one
+     *  containing the colour are weighted. This is cheaper than the trilinear 8, and
+     *  keeps the neutral axis neutral.
+     *  Tables are immutable once loaded, and shared between their users.
+     */
+    class Lut3D
+    {
+        public:
+            static const uint32_t   MaxSize = 256;
+
+            /**
+             *  \brief  Returns the table of a .cube file, or nullptr if it can't be parsed.
+             *
+             *  Files are only parsed once for as long as a table is in use: the same one
+             *  applied to many clips is shared by all of them, until the file is modified.
+             *  This is thread safe.
+             */
+            static std::shared_ptr<const Lut3D>     load( const std::string& path );
+
+            uint32_t        size() const;
+            /**
+             *  \brief  Maps count RGBA pixels in place. Alpha is left untouched.
+             */
+            void            apply( uint8_t* rgba, size_t count ) const;
+            /**
+             *  \brief  Same as apply(), splitting the pixels in slices which are mapped in
+             *          parallel, the calling thread taking one of them.
+             *
+             *  Slices never wait for anything, so this can be called from any thread,
+             *  including the ones rendering several frames in parallel.
+             */
+            void            applySliced( uint8_t* rgba, size_t count ) const;
+            // Same as apply(), without the vector instructions
+            void            applyScalar( uint8_t* rgba, size_t count ) const;
+
+        private:
+            Lut3D() = default;
+
+            static std::shared_ptr<Lut3D>   parse( const QString& path );
+            void            prepare( const float domainMin[3], const float domainMax[3] );
+
+        private:
+            uint32_t            m_size;
+            // RGB plus a padding component per entry, red changing fastest, then green
+            std::vector<float>  m_table;
+            // The lattice cell of each 8 bits component, as an offset in m_table, and
+            // where the component lies in it, per channel
+            uint32_t            m_offsets[3][256];
+            float               m_fractions[3][256];
+    };
+}
+
+#endif // LUT3D_H
@@ -0,0 +1,232 @@
+/*****************************************************************************
+ * MediaIO.cpp: Read-ahead and I/O latency metrics of the medias
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MediaIO.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+
+#ifdef Q_OS_UNIX
+# include <fcntl.h>
+#endif
+
+const qint64    Tools::MediaIO::SlowThreshold = 500 * 1000;
+
+namespace
+{
+    const qint64        BlockSize = 1024 * 1024;
+    const char* const   OperationNames[] = { "probe", "open", "seek", "prefetch" };
+
+    struct Entry
+    {
+        Tools::MediaIO::Stats   stats;
+        bool                    warned[Tools::MediaIO::NbOperations] = {};
+    };
+
+    QMutex                  statsMutex;
+    QHash<QString, Entry>   entries;
+    // The files being prefetched
+    QSet<QString>           prefetching;
+    std::atomic<qint64>     readAheadSize( 0 );
+
+    struct PrefetchPool : public QThreadPool
+    {
+        PrefetchPool()
+        {
+            setMaxThreadCount( 2 );
+        }
+    };
+
+    QThreadPool&
+    pool()
+    {
+        // Waits for the pending reads on exit
+        static PrefetchPool p;
+        return p;
+    }
+
+    class PrefetchJob : public QRunnable
+    {
+    public:
+        PrefetchJob( const QString& filePath, qint64 offset, qint64 size )
+            : m_filePath( filePath )
+            , m_offset( offset )
+            , m_size( size )
+        {
+        }
+
+        virtual void run() override
+        {
+            QElapsedTimer   timer;
+            timer.start();
+            qint64  read = 0;
+            QFile   file( m_filePath );
+            if ( file.open( QFile::ReadOnly ) == true && file.seek( m_offset ) == true )
+            {
+#ifdef Q_OS_UNIX
+                // Lets the kernel read ahead asynchronously too, where it supports it
+                posix_fadvise( file.handle(), m_offset, m_size, POSIX_FADV_WILLNEED );
+#endif
+                QByteArray  buffer( BlockSize, Qt::Uninitialized );
+                while ( read < m_size )
+                {
+                    auto n = file.read( buffer.data(), std::min( BlockSize, m_size - read ) );
+                    if ( n <= 0 )
+                        break;
+                    read += n;
+                }
+            }
+            Tools::MediaIO::record( m_filePath, Tools::MediaIO::Prefetch, timer.nsecsElapsed() / 1000, read );
+            QMutexLocker    lock( &statsMutex );
+            prefetching.remove( m_filePath );
+        }
+
+    private:
+        QString     m_filePath;
+        qint64      m_offset;
+        qint64      m_size;
+    };
+}
+
+void
+Tools::MediaIO::record( const QString& filePath, Operation op, qint64 usec, qint64 bytes )
+{
+    bool    slow = false;
+    {
+        QMutexLocker    lock( &statsMutex );
+        auto& e = entries[filePath];
+        e.stats.count[op]++;
+        e.stats.total[op] += usec;
+        e.stats.max[op] = std::max( e.stats.max[op], usec );
+        e.stats.bytes += bytes;
+        // Reading ahead takes time by design, it's only slow if it crawls
+        auto threshold = op == Prefetch ? SlowThreshold * ( bytes / BlockSize + 1 ) : SlowThreshold;
+        if ( usec > threshold && e.warned[op] == false )
+        {
+            e.warned[op] = true;
+            slow = true;
+        }
+    }
+    if ( slow == true )
+        vlmcWarning() << "Slow I/O:" << OperationNames[op] << "of" << filePath << "took"
+                      << usec / 1000 << "ms";
+}
+
+Tools::MediaIO::Stats
+Tools::MediaIO::stats( const QString& filePath )
+{
+    QMutexLocker    lock( &statsMutex );
+    return entries.value( filePath ).stats;
+}
+
+QHash<QString, Tools::MediaIO::Stats>
+Tools::MediaIO::allStats()
+{
+    QMutexLocker    lock( &statsMutex );
+    QHash<QString, Stats>   res;
+    for ( auto it = entries.cbegin(); it != entries.cend(); ++it )
+        res.insert( it.key(), it.value().stats );
+    return res;
+}
+
+void
+Tools::MediaIO::logStats()
+{
+    auto all = allStats();
+    // By worst latency, whatever the operation
+    QList<QPair<qint64, QString>>   sorted;
+    for ( auto it = all.cbegin(); it != all.cend(); ++it )
+    {
+        qint64 worst = 0;
+        for ( int op = 0; op < Prefetch; ++op )
+            worst = std::max( worst, it.value().max[op] );
+        sorted << qMakePair( worst, it.key() );
+    }
+    std::sort( sorted.begin(), sorted.end(), []( const QPair<qint64, QString>& a,
+                                                 const QPair<qint64, QString>& b ) {
+        return a.first > b.first;
+    } );
+    for ( const auto& s : sorted )
+    {
+        const auto& st = all[s.second];
+        QString line;
+        for ( int op = 0; op < NbOperations; ++op )
+        {
+            if ( st.count[op] == 0 )
+                continue;
+            line += QStringLiteral( " %1: %2x avg %3ms max %4ms" ).arg( OperationNames[op] )
+                    .arg( st.count[op] ).arg( st.total[op] / st.count[op] / 1000 )
+                    .arg( st.max[op] / 1000 );
+        }
+        if ( st.bytes > 0 )
+            line += QStringLiteral( " read ahead: %1 MiB" ).arg( st.bytes / BlockSize );
+        vlmcDebug() << "I/O:" << s.second << qPrintable( line );
+    }
+}
+
+void
+Tools::MediaIO::prefetch( const QString& filePath, qint64 offset )
+{
+    auto size = readAheadSize.load();
+    if ( size <= 0 )
+        return;
+    {
+        QMutexLocker    lock( &statsMutex );
+        if ( prefetching.contains( filePath ) == true )
+            return;
+        prefetching.insert( filePath );
+    }
+    pool().start( new PrefetchJob( filePath, std::max<qint64>( 0, offset ), size ) );
+}
+
+void
+Tools::MediaIO::setReadAhead( qint64 size )
+{
+    readAheadSize = size;
+}
+
+qint64
+Tools::MediaIO::readAhead()
+{
+    return readAheadSize;
+}
+
+Tools::MediaIO::Timer::Timer( const QString& filePath, Operation op )
+    : m_filePath( filePath )
+    , m_op( op )
+{
+    m_timer.start();
+}
+
+Tools::MediaIO::Timer::~Timer()
+{
+    record( m_filePath, m_op, m_timer.nsecsElapsed() / 1000 );
+}
@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * MediaIO.h: Read-ahead and I/O latency metrics of the medias
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MEDIAIO_H
+#define MEDIAIO_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+
+namespace Tools
+{
+namespace MediaIO
+{
+    enum    Operation
+    {
+        // Reading a file's headers and streams
+        Probe,
+        // Opening a decoder, up to its first decoded frame
+        Open,
+        // Decoding a frame at a given position
+        Seek,
+        // Reading ahead, see prefetch()
+        Prefetch,
+        NbOperations
+    };
+
+    struct  Stats
+    {
+        quint64     count[NbOperations] = {};
+        // In microseconds
+        qint64      total[NbOperations] = {};
+        qint64      max[NbOperations] = {};
+        // Read by prefetch()
+        qint64      bytes = 0;
+    };
+
+    /**
+     *  \brief  Adds a timed operation to the statistics of filePath.
+     *
+     *  Operations slower than SlowThreshold are logged, once per file and operation, so
+     *  the medias on a slow mount stand out. This is thread safe.
+     */
+    void            record( const QString& filePath, Operation op, qint64 usec, qint64 bytes = 0 );
+    Stats           stats( const QString& filePath );
+    QHash<QString, Stats>   allStats();
+    // Logs the statistics of every media, slowest first
+    void            logStats();
+
+    /**
+     *  \brief  Reads [offset, offset + readAhead()) of filePath from a pool thread.
+     *
+     *  The data is dropped, this is only meant to get it in the system's page cache
+     *  before a decoder asks for it, which on network storage saves a round trip per
+     *  read. Does nothing if the read-ahead is disabled, or if the file is already
+     *  being prefetched.
+     */
+    void            prefetch( const QString& filePath, qint64 offset );
+    // In bytes, 0 disables prefetch()
+    void            setReadAhead( qint64 size );
+    qint64          readAhead();
+
+    extern const qint64     SlowThreshold;
+
+    /**
+     *  \brief  Records the time spent in its scope.
+     */
+    class   Timer
+    {
+        public:
+            Timer( const QString& filePath, Operation op );
+            ~Timer();
+
+        private:
+            QString         m_filePath;
+            Operation       m_op;
+            QElapsedTimer   m_timer;
+    };
+}
+}
+
+#endif // MEDIAIO_H
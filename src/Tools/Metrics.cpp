@@ -0,0 +1,275 @@
+/*****************************************************************************
+ * Metrics.cpp: Counters, gauges and histograms of the playback and exports
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "Metrics.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QMap>
+#include <QMutex>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace
+{
+    const double    BucketGrowth = 1.25;
+
+    // Sorted, for the dumps to read well
+    QMutex                                                          registryMutex;
+    QMap<QString, std::shared_ptr<Tools::Metrics::Counter>>         counters;
+    QMap<QString, std::shared_ptr<Tools::Metrics::Gauge>>           gauges;
+    QMap<QString, std::shared_ptr<Tools::Metrics::Histogram>>       histograms;
+    // Not dumped themselves, their gauges are
+    QMap<QString, std::shared_ptr<Tools::Metrics::MemoryAccount>>   memoryAccounts;
+
+    template <typename T>
+    T&
+    get( QMap<QString, std::shared_ptr<T>>& metrics, const QString& name )
+    {
+        QMutexLocker    lock( &registryMutex );
+        auto& m = metrics[name];
+        if ( m == nullptr )
+            m = std::make_shared<T>();
+        return *m;
+    }
+
+    int
+    bucket( int64_t usec )
+    {
+        if ( usec <= 1 )
+            return 0;
+        auto b = static_cast<int>( std::log( static_cast<double>( usec ) ) / std::log( BucketGrowth ) ) + 1;
+        return std::min( b, Tools::Metrics::Histogram::NbBuckets - 1 );
+    }
+
+    int64_t
+    bucketUpperBound( int b )
+    {
+        return static_cast<int64_t>( std::pow( BucketGrowth, b ) );
+    }
+}
+
+Tools::Metrics::Histogram::Histogram()
+    : m_count( 0 )
+    , m_total( 0 )
+    , m_max( 0 )
+{
+    for ( auto& b : m_buckets )
+        b.store( 0, std::memory_order_relaxed );
+}
+
+void
+Tools::Metrics::Histogram::record( int64_t usec )
+{
+    m_buckets[bucket( usec )].fetch_add( 1, std::memory_order_relaxed );
+    m_count.fetch_add( 1, std::memory_order_relaxed );
+    m_total.fetch_add( usec, std::memory_order_relaxed );
+    auto max = m_max.load( std::memory_order_relaxed );
+    while ( usec > max && m_max.compare_exchange_weak( max, usec, std::memory_order_relaxed ) == false )
+        ;
+}
+
+uint64_t
+Tools::Metrics::Histogram::count() const
+{
+    return m_count.load( std::memory_order_relaxed );
+}
+
+double
+Tools::Metrics::Histogram::mean() const
+{
+    auto c = count();
+    return c > 0 ? static_cast<double>( m_total.load( std::memory_order_relaxed ) ) / c : 0;
+}
+
+int64_t
+Tools::Metrics::Histogram::percentile( double p ) const
+{
+    auto c = count();
+    if ( c == 0 )
+        return 0;
+    auto rank = static_cast<uint64_t>( std::ceil( p * c ) );
+    uint64_t seen = 0;
+    for ( int b = 0; b < NbBuckets; ++b )
+    {
+        seen += m_buckets[b].load( std::memory_order_relaxed );
+        if ( seen >= rank && seen > 0 )
+            return std::min( bucketUpperBound( b ), max() );
+    }
+    return max();
+}
+
+int64_t
+Tools::Metrics::Histogram::max() const
+{
+    return m_max.load( std::memory_order_relaxed );
+}
+
+void
+Tools::Metrics::Histogram::reset()
+{
+    for ( auto& b : m_buckets )
+        b.store( 0, std::memory_order_relaxed );
+    m_count = 0;
+    m_total = 0;
+    m_max = 0;
+}
+
+Tools::Metrics::Counter&
+Tools::Metrics::counter( const QString& name )
+{
+    return get( counters, name );
+}
+
+Tools::Metrics::Gauge&
+Tools::Metrics::gauge( const QString& name )
+{
+    return get( gauges, name );
+}
+
+Tools::Metrics::Histogram&
+Tools::Metrics::histogram( const QString& name )
+{
+    return get( histograms, name );
+}
+
+Tools::Metrics::MemoryAccount::MemoryAccount( Gauge& bytes, Gauge& objects )
+    : m_bytes( 0 )
+    , m_objects( 0 )
+    , m_bytesGauge( bytes )
+    , m_objectsGauge( objects )
+{
+}
+
+void
+Tools::Metrics::MemoryAccount::add( int64_t bytes, int64_t objects )
+{
+    m_bytesGauge.set( m_bytes.fetch_add( bytes, std::memory_order_relaxed ) + bytes );
+    m_objectsGauge.set( m_objects.fetch_add( objects, std::memory_order_relaxed ) + objects );
+}
+
+void
+Tools::Metrics::MemoryAccount::remove( int64_t bytes, int64_t objects )
+{
+    add( -bytes, -objects );
+}
+
+void
+Tools::Metrics::MemoryAccount::set( int64_t bytes, int64_t objects )
+{
+    m_bytes = bytes;
+    m_objects = objects;
+    m_bytesGauge.set( bytes );
+    m_objectsGauge.set( objects );
+}
+
+Tools::Metrics::MemoryAccount&
+Tools::Metrics::memory( const QString& name )
+{
+    // The gauges are created first: the registry lock isn't recursive
+    auto& bytes = gauge( "memory." + name + ".bytes" );
+    auto& objects = gauge( "memory." + name + ".objects" );
+    QMutexLocker    lock( &registryMutex );
+    auto& m = memoryAccounts[name];
+    if ( m == nullptr )
+        m = std::make_shared<MemoryAccount>( bytes, objects );
+    return *m;
+}
+
+QJsonObject
+Tools::Metrics::toJson( const QString& prefix )
+{
+    QMutexLocker    lock( &registryMutex );
+    QJsonObject     res;
+    for ( auto it = counters.cbegin(); it != counters.cend(); ++it )
+        if ( it.key().startsWith( prefix ) == true )
+            res.insert( it.key(), static_cast<double>( it.value()->value() ) );
+    for ( auto it = gauges.cbegin(); it != gauges.cend(); ++it )
+        if ( it.key().startsWith( prefix ) == true )
+            res.insert( it.key(), it.value()->value() );
+    for ( auto it = histograms.cbegin(); it != histograms.cend(); ++it )
+    {
+        if ( it.key().startsWith( prefix ) == false )
+            continue;
+        const auto& h = *it.value();
+        // In milliseconds, as the durations are displayed
+        res.insert( it.key(), QJsonObject{
+            { "count", static_cast<double>( h.count() ) },
+            { "mean", h.mean() / 1000 },
+            { "p50", h.percentile( 0.5 ) / 1000.0 },
+            { "p90", h.percentile( 0.9 ) / 1000.0 },
+            { "p99", h.percentile( 0.99 ) / 1000.0 },
+            { "max", h.max() / 1000.0 },
+        } );
+    }
+    return res;
+}
+
+QString
+Tools::Metrics::toText( const QString& prefix )
+{
+    auto json = toJson( prefix );
+    QString res;
+    for ( auto it = json.constBegin(); it != json.constEnd(); ++it )
+    {
+        if ( res.isEmpty() == false )
+            res += '\n';
+        res += it.key().mid( prefix.size() ) + ": ";
+        if ( it.value().isObject() == true )
+        {
+            auto h = it.value().toObject();
+            res += QStringLiteral( "p50 %1 p90 %2 p99 %3 max %4 ms (%5)" )
+                    .arg( h["p50"].toDouble(), 0, 'f', 1 ).arg( h["p90"].toDouble(), 0, 'f', 1 )
+                    .arg( h["p99"].toDouble(), 0, 'f', 1 ).arg( h["max"].toDouble(), 0, 'f', 1 )
+                    .arg( h["count"].toDouble() );
+        }
+        else
+            res += QString::number( it.value().toDouble(), 'g', 4 );
+    }
+    return res;
+}
+
+bool
+Tools::Metrics::dump( const QString& filePath )
+{
+    QFile   file( filePath );
+    if ( file.open( QFile::WriteOnly | QFile::Truncate ) == false )
+        return false;
+    return file.write( QJsonDocument( toJson() ).toJson() ) > 0;
+}
+
+void
+Tools::Metrics::reset( const QString& prefix )
+{
+    QMutexLocker    lock( &registryMutex );
+    for ( auto it = counters.begin(); it != counters.end(); ++it )
+        if ( it.key().startsWith( prefix ) == true )
+            it.value()->reset();
+    for ( auto it = gauges.begin(); it != gauges.end(); ++it )
+        if ( it.key().startsWith( prefix ) == true )
+            it.value()->reset();
+    for ( auto it = histograms.begin(); it != histograms.end(); ++it )
+        if ( it.key().startsWith( prefix ) == true )
+            it.value()->reset();
+}
@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * Metrics.h: Counters, gauges and histograms of the playback and exports
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QJsonObject>
+#include <QString>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace Tools
+{
+/**
+ *  \brief  Process wide registry of named metrics.
+ *
+ *  The metrics are created on first use and live until the process exits, so the
+ *  references returned by counter(), gauge() and histogram() can be kept around,
+ *  typically in a function local static. Updating a metric is lock free.
+ *  Names are dotted, the first part being the subsystem: "playback.fps",
+ *  "export.frames"...
+ */
+namespace Metrics
+{
+    class   Counter
+    {
+        public:
+            Counter() : m_value( 0 ) {}
+            void            add( uint64_t n = 1 ) { m_value.fetch_add( n, std::memory_order_relaxed ); }
+            uint64_t        value() const { return m_value.load( std::memory_order_relaxed ); }
+            void            reset() { m_value = 0; }
+
+        private:
+            std::atomic<uint64_t>   m_value;
+    };
+
+    class   Gauge
+    {
+        public:
+            Gauge() : m_value( 0 ) {}
+            void            set( double value ) { m_value.store( value, std::memory_order_relaxed ); }
+            double          value() const { return m_value.load( std::memory_order_relaxed ); }
+            void            reset() { m_value = 0; }
+
+        private:
+            std::atomic<double>     m_value;
+    };
+
+    /**
+     *  \brief  Distribution of durations, in microseconds.
+     *
+     *  The values are counted in buckets growing by 25%, which bounds the error of
+     *  the percentiles to that much.
+     */
+    class   Histogram
+    {
+        public:
+            static const int    NbBuckets = 100;
+
+            Histogram();
+            void            record( int64_t usec );
+            uint64_t        count() const;
+            double          mean() const;
+            // p in [0, 1], the result in microseconds
+            int64_t         percentile( double p ) const;
+            int64_t         max() const;
+            void            reset();
+
+        private:
+            std::atomic<uint64_t>   m_buckets[NbBuckets];
+            std::atomic<uint64_t>   m_count;
+            std::atomic<int64_t>    m_total;
+            std::atomic<int64_t>    m_max;
+    };
+
+    /**
+     *  \brief  Records the lifetime of the scope in a histogram.
+     */
+    class   ScopedTimer
+    {
+        public:
+            explicit ScopedTimer( Histogram& histogram )
+                : m_histogram( histogram )
+                , m_start( std::chrono::steady_clock::now() )
+            {
+            }
+            ~ScopedTimer()
+            {
+                auto elapsed = std::chrono::steady_clock::now() - m_start;
+                m_histogram.record( std::chrono::duration_cast<std::chrono::microseconds>( elapsed ).count() );
+            }
+
+        private:
+            Histogram&                              m_histogram;
+            std::chrono::steady_clock::time_point   m_start;
+    };
+
+    /**
+     *  \brief  Memory held by a subsystem, in bytes and objects.
+     *
+     *  Published as the gauges "memory.<name>.bytes" and "memory.<name>.objects". The
+     *  bytes are left at 0 by the subsystems which can only count their objects.
+     */
+    class   MemoryAccount
+    {
+        public:
+            MemoryAccount( Gauge& bytes, Gauge& objects );
+            void            add( int64_t bytes, int64_t objects = 1 );
+            void            remove( int64_t bytes, int64_t objects = 1 );
+            // For the subsystems which know their totals, such as the caches
+            void            set( int64_t bytes, int64_t objects );
+            int64_t         bytes() const { return m_bytes.load( std::memory_order_relaxed ); }
+            int64_t         objects() const { return m_objects.load( std::memory_order_relaxed ); }
+
+        private:
+            std::atomic<int64_t>    m_bytes;
+            std::atomic<int64_t>    m_objects;
+            Gauge&                  m_bytesGauge;
+            Gauge&                  m_objectsGauge;
+    };
+
+    Counter&        counter( const QString& name );
+    Gauge&          gauge( const QString& name );
+    Histogram&      histogram( const QString& name );
+    MemoryAccount&  memory( const QString& name );
+
+    // The metrics whose name starts with prefix, or all of them
+    QJsonObject     toJson( const QString& prefix = QString() );
+    // A line per metric, for the debug views
+    QString         toText( const QString& prefix = QString() );
+    bool            dump( const QString& filePath );
+    void            reset( const QString& prefix = QString() );
+}
+}
+
+#endif // METRICS_H
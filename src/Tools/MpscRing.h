@@ -0,0 +1,111 @@
+/*****************************************************************************
+ * MpscRing.h: Bounded lock-free multi-producer queue
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MPSCRING_H
+#define MPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Tools
+{
+/**
+ *  \brief  Bounded lock-free queue between any number of producer threads and a
+ *          single consumer thread.
+ *
+ *  Each slot carries a sequence number telling whether it is free for the producer
+ *  of a given position, or ready for the consumer. Producers only contend on the
+ *  position they reserve. Like SpscRing, push() fails when the queue is full, and
+ *  pop() when it is empty. Capacity must be a power of two.
+ */
+template <typename T, size_t Capacity>
+class MpscRing
+{
+    static_assert( Capacity > 0 && ( Capacity & ( Capacity - 1 ) ) == 0,
+                   "The capacity must be a power of two" );
+
+    public:
+        MpscRing()
+            : m_head( 0 )
+            , m_tail( 0 )
+        {
+            for ( size_t i = 0; i < Capacity; ++i )
+                m_slots[i].sequence.store( i, std::memory_order_relaxed );
+        }
+
+        // Safe from any thread
+        bool
+        push( const T& value )
+        {
+            auto tail = m_tail.load( std::memory_order_relaxed );
+            Slot* slot;
+            for ( ;; )
+            {
+                slot = &m_slots[tail & ( Capacity - 1 )];
+                auto seq = slot->sequence.load( std::memory_order_acquire );
+                auto diff = static_cast<intptr_t>( seq ) - static_cast<intptr_t>( tail );
+                if ( diff == 0 )
+                {
+                    if ( m_tail.compare_exchange_weak( tail, tail + 1, std::memory_order_relaxed ) == true )
+                        break;
+                }
+                // Still holding the item pushed a lap earlier
+                else if ( diff < 0 )
+                    return false;
+                else
+                    tail = m_tail.load( std::memory_order_relaxed );
+            }
+            slot->value = value;
+            slot->sequence.store( tail + 1, std::memory_order_release );
+            return true;
+        }
+
+        // Only called from the consumer thread
+        bool
+        pop( T& value )
+        {
+            auto head = m_head.load( std::memory_order_relaxed );
+            auto& slot = m_slots[head & ( Capacity - 1 )];
+            if ( slot.sequence.load( std::memory_order_acquire ) != head + 1 )
+                return false;
+            value = slot.value;
+            // Free for the producer which reaches this slot on the next lap
+            slot.sequence.store( head + Capacity, std::memory_order_release );
+            m_head.store( head + 1, std::memory_order_relaxed );
+            return true;
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+            T                   value;
+        };
+
+        Slot                                m_slots[Capacity];
+        alignas( 64 ) std::atomic<size_t>   m_head;
+        alignas( 64 ) std::atomic<size_t>   m_tail;
+};
+}
+
+#endif // MPSCRING_H
@@ -0,0 +1,150 @@
+/*****************************************************************************
+ * Multicam.cpp: Synchronized angles of a multicam clip
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "Multicam.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+
+const char* const   Tools::Multicam::Extension = ".vlmcmulticam";
+
+Tools::Multicam::Multicam()
+    : nbFrames( 0 )
+{
+}
+
+bool
+Tools::Multicam::isMulticam( const QString& path )
+{
+    return path.endsWith( Extension, Qt::CaseInsensitive );
+}
+
+bool
+Tools::Multicam::load( const QString& path, Multicam& multicam )
+{
+    QFile   file( path );
+    if ( file.open( QIODevice::ReadOnly ) == false )
+        return false;
+    auto doc = QJsonDocument::fromJson( file.readAll() );
+    if ( doc.isObject() == false )
+        return false;
+    auto obj = doc.object();
+    Multicam m;
+    for ( const auto& a : obj["angles"].toArray() )
+    {
+        auto angle = a.toObject();
+        auto filePath = angle["path"].toString();
+        if ( filePath.isEmpty() == true )
+            return false;
+        m.angles.append( Angle{ filePath, static_cast<qint64>( angle["offset"].toDouble() ) } );
+    }
+    for ( const auto& s : obj["switches"].toArray() )
+    {
+        auto sw = s.toObject();
+        auto angle = sw["angle"].toInt();
+        if ( angle < 0 || angle >= m.angles.size() )
+            return false;
+        m.switches.append( Switch{ static_cast<qint64>( sw["position"].toDouble() ), angle } );
+    }
+    std::sort( m.switches.begin(), m.switches.end(), []( const Switch& a, const Switch& b ) {
+        return a.position < b.position;
+    } );
+    m.nbFrames = static_cast<qint64>( obj["nbFrames"].toDouble() );
+    if ( m.angles.isEmpty() == true || m.nbFrames <= 0 )
+        return false;
+    multicam = m;
+    return true;
+}
+
+bool
+Tools::Multicam::save( const QString& path ) const
+{
+    QJsonArray  a;
+    for ( const auto& angle : angles )
+    {
+        QJsonObject obj;
+        obj["path"] = angle.filePath;
+        obj["offset"] = static_cast<double>( angle.offset );
+        a.append( obj );
+    }
+    QJsonArray  s;
+    for ( const auto& sw : switches )
+    {
+        QJsonObject obj;
+        obj["position"] = static_cast<double>( sw.position );
+        obj["angle"] = sw.angle;
+        s.append( obj );
+    }
+    QJsonObject obj;
+    obj["angles"] = a;
+    obj["switches"] = s;
+    obj["nbFrames"] = static_cast<double>( nbFrames );
+    auto partPath = path + ".part";
+    QFile   file( partPath );
+    if ( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) == false )
+        return false;
+    auto data = QJsonDocument( obj ).toJson();
+    if ( file.write( data ) != data.size() || file.flush() == false )
+    {
+        file.close();
+        QFile::remove( partPath );
+        return false;
+    }
+    file.close();
+    QFile::remove( path );
+    return QFile::rename( partPath, path );
+}
+
+int
+Tools::Multicam::activeAngle( qint64 position ) const
+{
+    auto it = std::upper_bound( switches.begin(), switches.end(), position,
+                                []( qint64 pos, const Switch& s ) { return pos < s.position; } );
+    return it == switches.begin() ? 0 : ( it - 1 )->angle;
+}
+
+void
+Tools::Multicam::switchAngle( qint64 position, int angle )
+{
+    if ( angle < 0 || angle >= angles.size() )
+        return;
+    auto it = std::lower_bound( switches.begin(), switches.end(), position,
+                                []( const Switch& s, qint64 pos ) { return s.position < pos; } );
+    if ( it != switches.end() && it->position == position )
+        it->angle = angle;
+    else
+        it = switches.insert( it, Switch{ position, angle } );
+    // Switching to the angle which is shown already is a no-op: drop the redundant switches
+    QVector<Switch> res;
+    int previous = 0;
+    for ( const auto& s : switches )
+    {
+        if ( s.angle != previous )
+            res.append( s );
+        previous = s.angle;
+    }
+    switches = res;
+}
@@ -0,0 +1,79 @@
+/*****************************************************************************
+ * Multicam.h: Synchronized angles of a multicam clip
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MULTICAM_H
+#define MULTICAM_H
+
+#include <QString>
+#include <QVector>
+
+namespace Tools
+{
+    /**
+     *  \brief  The angles of a multicam clip, and which one is shown when.
+     *
+     *  As titles, multicam clips are stored as small JSON files, imported as any other
+     *  media and played by a producer of their own. \sa Backend::MLT::MLTMulticam
+     *  Positions are in frames of the multicam clip, which starts with its first angle.
+     */
+    struct Multicam
+    {
+        struct Angle
+        {
+            QString     filePath;
+            // Where the angle starts in the multicam clip
+            qint64      offset;
+        };
+
+        struct Switch
+        {
+            qint64      position;
+            int         angle;
+        };
+
+        static const char* const    Extension;
+
+        Multicam();
+
+        static bool     isMulticam( const QString& path );
+        /**
+         *  \brief  Reads a multicam file. Returns false if it can't be parsed.
+         */
+        static bool     load( const QString& path, Multicam& multicam );
+        // Written next to the file first, so that a reader never gets half of it
+        bool            save( const QString& path ) const;
+
+        // The angle shown at position
+        int             activeAngle( qint64 position ) const;
+        /**
+         *  \brief  Shows angle from position, until the next switch.
+         */
+        void            switchAngle( qint64 position, int angle );
+
+        QVector<Angle>  angles;
+        // Sorted by position. The first angle is shown until the first switch
+        QVector<Switch> switches;
+        qint64          nbFrames;
+    };
+}
+
+#endif // MULTICAM_H
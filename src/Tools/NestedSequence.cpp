@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * NestedSequence.cpp: A sequence placed in another one, as a clip
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "NestedSequence.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+
+const char* const   Tools::NestedSequence::Extension = ".vlmcsequence";
+
+Tools::NestedSequence::NestedSequence()
+    : nbFrames( 0 )
+    , hasAudio( false )
+    , hasVideo( false )
+{
+}
+
+bool
+Tools::NestedSequence::isNestedSequence( const QString& path )
+{
+    return path.endsWith( Extension, Qt::CaseInsensitive );
+}
+
+bool
+Tools::NestedSequence::load( const QString& path, NestedSequence& sequence )
+{
+    QFile   file( path );
+    if ( file.open( QIODevice::ReadOnly ) == false )
+        return false;
+    auto doc = QJsonDocument::fromJson( file.readAll() );
+    if ( doc.isObject() == false )
+        return false;
+    auto obj = doc.object();
+    NestedSequence s;
+    s.tracks = obj["tracks"].toVariant();
+    s.graph = obj["graph"].toString().toUtf8();
+    s.nbFrames = static_cast<qint64>( obj["nbFrames"].toDouble() );
+    s.hasAudio = obj["audio"].toBool();
+    s.hasVideo = obj["video"].toBool();
+    if ( s.graph.isEmpty() == true || s.nbFrames <= 0 || ( s.hasAudio == false && s.hasVideo == false ) )
+        return false;
+    sequence = s;
+    return true;
+}
+
+bool
+Tools::NestedSequence::save( const QString& path ) const
+{
+    QJsonObject obj;
+    obj["tracks"] = QJsonValue::fromVariant( tracks );
+    obj["graph"] = QString::fromUtf8( graph );
+    obj["nbFrames"] = static_cast<double>( nbFrames );
+    obj["audio"] = hasAudio;
+    obj["video"] = hasVideo;
+    auto partPath = path + ".part";
+    QFile   file( partPath );
+    if ( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) == false )
+        return false;
+    auto data = QJsonDocument( obj ).toJson();
+    if ( file.write( data ) != data.size() || file.flush() == false )
+    {
+        file.close();
+        QFile::remove( partPath );
+        return false;
+    }
+    file.close();
+    QFile::remove( path );
+    return QFile::rename( partPath, path );
+}
@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * NestedSequence.h: A sequence placed in another one, as a clip
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef NESTEDSEQUENCE_H
+#define NESTEDSEQUENCE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+
+namespace Tools
+{
+    /**
+     *  \brief  Clips nested into a sequence of their own, which plays as a single clip.
+     *
+     *  As multicam clips, nested sequences are stored as small JSON files, imported as any
+     *  other media and played by a producer of their own. \sa Backend::MLT::MLTNestedSequence
+     *  The producer plays the composited tracks of the sequence, as the backend serialized
+     *  them, so that the sequence doesn't have to be built again from its clips.
+     */
+    struct NestedSequence
+    {
+        static const char* const    Extension;
+
+        NestedSequence();
+
+        static bool     isNestedSequence( const QString& path );
+        /**
+         *  \brief  Reads a nested sequence file. Returns false if it can't be parsed.
+         */
+        static bool     load( const QString& path, NestedSequence& sequence );
+        // Written next to the file first, so that a reader never gets half of it
+        bool            save( const QString& path ) const;
+
+        // The clips, as SequenceWorkflow::toVariant() describes them
+        QVariant        tracks;
+        // The composited tracks, as IInput::snapshot() serialized them
+        QByteArray      graph;
+        qint64          nbFrames;
+        bool            hasAudio;
+        bool            hasVideo;
+    };
+}
+
+#endif // NESTEDSEQUENCE_H
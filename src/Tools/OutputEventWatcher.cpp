@@ -27,30 +27,71 @@
 #include "Tools/OutputEventWatcher.h"
 
 OutputEventWatcher::OutputEventWatcher( QObject* parent ) :
-    QObject( parent )
+    Tools::EventBridge( parent )
 {
 }
 
 void
 OutputEventWatcher::onPlaying()
 {
-    emit playing();
+    post( Playing );
 }
 
 void
 OutputEventWatcher::onStopped()
 {
-    emit stopped();
+    post( Stopped );
 }
 
 void
 OutputEventWatcher::onVolumeChanged()
 {
-    emit volumeChanged();
+    post( VolumeChanged );
 }
 
 void
 OutputEventWatcher::onErrorEncountered()
 {
-    emit errorEncountered();
+    post( ErrorEncountered );
+}
+
+void
+OutputEventWatcher::onFramesDropped( uint32_t nbDropped )
+{
+    postFramesDropped( nbDropped );
+}
+
+void
+OutputEventWatcher::onAudioUnderrun( uint32_t nbUnderruns )
+{
+    postAudioUnderruns( nbUnderruns );
+}
+
+void
+OutputEventWatcher::deliver( const Batch& batch )
+{
+    for ( auto event : batch.events )
+    {
+        switch ( event )
+        {
+        case Playing:
+            emit playing();
+            break;
+        case Stopped:
+            emit stopped();
+            break;
+        case VolumeChanged:
+            emit volumeChanged();
+            break;
+        case ErrorEncountered:
+            emit errorEncountered();
+            break;
+        default:
+            break;
+        }
+    }
+    if ( batch.framesDropped > 0 )
+        emit framesDropped( batch.framesDropped );
+    if ( batch.audioUnderruns > 0 )
+        emit audioUnderrun( batch.audioUnderruns );
 }
@@ -23,11 +23,14 @@
 #ifndef OUTPUTEVENTWATCHER_H
 #define OUTPUTEVENTWATCHER_H
 
-
-#include <QObject>
 #include "Backend/IOutput.h"
+#include "Tools/EventBridge.h"
 
-class OutputEventWatcher : public QObject, public Backend::IOutputEventCb
+/**
+ *  \brief Forwards the output events as signals, emitted in batches from the
+ *         watcher's thread.
+ */
+class OutputEventWatcher : public Tools::EventBridge, public Backend::IOutputEventCb
 {
     Q_OBJECT
 public:
@@ -38,12 +41,18 @@ private:
     virtual void    onStopped();
     virtual void    onVolumeChanged();
     virtual void    onErrorEncountered();
+    virtual void    onFramesDropped( uint32_t nbDropped );
+    virtual void    onAudioUnderrun( uint32_t nbUnderruns );
+
+    virtual void    deliver( const Batch& batch );
 
 signals:
     void            playing();
     void            stopped();
     void            volumeChanged();
     void            errorEncountered();
+    void            framesDropped( quint32 nbDropped );
+    void            audioUnderrun( quint32 nbUnderruns );
 };
 
 #endif // OUTPUTEVENTWATCHER_H
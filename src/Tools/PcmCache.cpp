@@ -0,0 +1,152 @@
+/*****************************************************************************
+ * PcmCache.cpp: Memory-mapped cache of the decoded audio of a media
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "PcmCache.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Tools;
+
+namespace
+{
+    const char          Magic[4] = { 'V', 'P', 'C', 'M' };
+    const uint32_t      Version = 1;
+
+    struct Header
+    {
+        char        magic[4];
+        uint32_t    version;
+        uint32_t    frequency;
+        uint32_t    channels;
+        int64_t     nbSamples;
+    };
+}
+
+PcmCache::Writer::Writer( const QString& path, uint32_t frequency, uint32_t channels )
+    : m_file( path )
+    , m_frequency( frequency )
+    , m_channels( channels )
+    , m_nbSamples( 0 )
+{
+    m_valid = channels > 0 &&
+            QDir().mkpath( QFileInfo( path ).absolutePath() ) == true &&
+            m_file.open( QFile::WriteOnly ) == true;
+    // Written again with the sample count, once known
+    Header header{};
+    m_valid = m_valid && m_file.write( reinterpret_cast<const char*>( &header ),
+                                       sizeof( header ) ) == sizeof( header );
+}
+
+bool
+PcmCache::Writer::write( const int16_t* samples, uint32_t nbSamples )
+{
+    if ( m_valid == false )
+        return false;
+    auto size = (qint64)nbSamples * m_channels * sizeof( int16_t );
+    m_valid = m_file.write( reinterpret_cast<const char*>( samples ), size ) == size;
+    m_nbSamples += nbSamples;
+    return m_valid;
+}
+
+bool
+PcmCache::Writer::commit()
+{
+    if ( m_valid == false )
+    {
+        m_file.cancelWriting();
+        return false;
+    }
+    Header header;
+    memcpy( header.magic, Magic, sizeof( Magic ) );
+    header.version = Version;
+    header.frequency = m_frequency;
+    header.channels = m_channels;
+    header.nbSamples = m_nbSamples;
+    if ( m_file.seek( 0 ) == false ||
+         m_file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) ) != sizeof( header ) )
+    {
+        m_file.cancelWriting();
+        return false;
+    }
+    return m_file.commit();
+}
+
+std::shared_ptr<PcmCache>
+PcmCache::open( const QString& path )
+{
+    std::shared_ptr<PcmCache> cache( new PcmCache );
+    cache->m_file.setFileName( path );
+    if ( cache->m_file.open( QFile::ReadOnly ) == false )
+        return nullptr;
+    Header header;
+    if ( cache->m_file.read( reinterpret_cast<char*>( &header ), sizeof( header ) ) != sizeof( header ) ||
+         memcmp( header.magic, Magic, sizeof( Magic ) ) != 0 || header.version != Version ||
+         header.channels == 0 || header.nbSamples < 0 )
+        return nullptr;
+    auto size = header.nbSamples * header.channels * (qint64)sizeof( int16_t );
+    if ( cache->m_file.size() != (qint64)sizeof( header ) + size )
+        return nullptr;
+    auto data = cache->m_file.map( sizeof( header ), std::max<qint64>( size, 1 ) );
+    if ( data == nullptr && size > 0 )
+        return nullptr;
+    cache->m_samples = reinterpret_cast<const int16_t*>( data );
+    cache->m_frequency = header.frequency;
+    cache->m_channels = header.channels;
+    cache->m_nbSamples = header.nbSamples;
+    return cache;
+}
+
+uint32_t
+PcmCache::frequency() const
+{
+    return m_frequency;
+}
+
+uint32_t
+PcmCache::channels() const
+{
+    return m_channels;
+}
+
+int64_t
+PcmCache::nbSamples() const
+{
+    return m_nbSamples;
+}
+
+void
+PcmCache::read( int64_t offset, int16_t* dst, int64_t nbSamples ) const
+{
+    auto begin = std::max<int64_t>( 0, std::min( offset, m_nbSamples ) );
+    auto end = std::max<int64_t>( begin, std::min( offset + nbSamples, m_nbSamples ) );
+    auto before = std::min( begin - offset, nbSamples );
+    std::fill( dst, dst + std::max<int64_t>( 0, before ) * m_channels, 0 );
+    if ( end > begin )
+        memcpy( dst + ( begin - offset ) * m_channels, m_samples + begin * m_channels,
+                ( end - begin ) * m_channels * sizeof( int16_t ) );
+    auto written = std::max<int64_t>( 0, before ) + ( end - begin );
+    std::fill( dst + written * m_channels, dst + nbSamples * m_channels, 0 );
+}
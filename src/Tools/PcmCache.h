@@ -0,0 +1,88 @@
+/*****************************************************************************
+ * PcmCache.h: Memory-mapped cache of the decoded audio of a media
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef PCMCACHE_H
+#define PCMCACHE_H
+
+#include <QFile>
+#include <QSaveFile>
+
+#include <cstdint>
+#include <memory>
+
+namespace Tools
+{
+    /**
+     *  \brief  The decoded audio of a media, as interleaved s16 samples in a file.
+     *
+     *  The file is memory-mapped, so reading any part of it costs a copy, instead of a
+     *  seek and a decode. This is meant for scrubbing. Reading is thread safe.
+     */
+    class PcmCache
+    {
+        public:
+            /**
+             *  \brief  Writes a cache file. Nothing replaces path until commit() succeeds.
+             */
+            class Writer
+            {
+                public:
+                    Writer( const QString& path, uint32_t frequency, uint32_t channels );
+
+                    // nbSamples is per channel
+                    bool        write( const int16_t* samples, uint32_t nbSamples );
+                    bool        commit();
+
+                private:
+                    QSaveFile   m_file;
+                    uint32_t    m_frequency;
+                    uint32_t    m_channels;
+                    int64_t     m_nbSamples;
+                    bool        m_valid;
+            };
+
+            static std::shared_ptr<PcmCache>    open( const QString& path );
+
+            uint32_t        frequency() const;
+            uint32_t        channels() const;
+            // Per channel
+            int64_t         nbSamples() const;
+            /**
+             *  \brief  Copies nbSamples samples per channel starting at offset.
+             *
+             *  The samples out of the cached range are silent.
+             */
+            void            read( int64_t offset, int16_t* dst, int64_t nbSamples ) const;
+
+        private:
+            PcmCache() = default;
+
+        private:
+            QFile           m_file;
+            const int16_t*  m_samples;
+            uint32_t        m_frequency;
+            uint32_t        m_channels;
+            int64_t         m_nbSamples;
+    };
+}
+
+#endif // PCMCACHE_H
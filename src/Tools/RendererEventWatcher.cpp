@@ -28,54 +28,127 @@
 #include "Tools/RendererEventWatcher.h"
 
 RendererEventWatcher::RendererEventWatcher(QObject *parent) :
-    QObject(parent)
+    Tools::EventBridge(parent),
+    m_latestPosition( 0 ),
+    m_publishQueued( false ),
+    m_publishTimer( this )
 {
+    m_publishTimer.setInterval( DisplayInterval );
+    m_publishTimer.setSingleShot( true );
+    connect( &m_publishTimer, &QTimer::timeout, this, &RendererEventWatcher::publishPosition );
 }
 
 void
 RendererEventWatcher::onPlaying()
 {
-    emit playing();
+    post( Playing );
 }
 
 void
 RendererEventWatcher::onPaused()
 {
-    emit paused();
+    post( Paused );
 }
 
 void
 RendererEventWatcher::onStopped()
 {
-    emit stopped();
+    post( Stopped );
 }
 
 void
 RendererEventWatcher::onEndReached()
 {
-    emit endReached();
+    post( EndReached );
 }
 
 void
 RendererEventWatcher::onVolumeChanged()
 {
-    emit volumeChanged();
+    post( VolumeChanged );
 }
 
 void
 RendererEventWatcher::onPositionChanged( int64_t pos )
 {
-    emit positionChanged( pos );
+    postPosition( pos );
 }
 
 void
 RendererEventWatcher::onLengthChanged( int64_t length )
 {
-    emit lengthChanged( length );
+    postLength( length );
 }
 
 void
 RendererEventWatcher::onErrorEncountered()
 {
-    emit errorEncountered();
+    post( ErrorEncountered );
+}
+
+void
+RendererEventWatcher::onFramesDropped( uint32_t nbDropped )
+{
+    postFramesDropped( nbDropped );
+}
+
+void
+RendererEventWatcher::onAudioUnderrun( uint32_t nbUnderruns )
+{
+    postAudioUnderruns( nbUnderruns );
+}
+
+void
+RendererEventWatcher::deliver( const Batch& batch )
+{
+    if ( batch.length >= 0 )
+        emit lengthChanged( batch.length );
+    // Before the events: the position was reached before a stop or end which
+    // may have been posted after it
+    if ( batch.position >= 0 )
+    {
+        emit positionChanged( batch.position );
+        m_latestPosition = batch.position;
+        m_publishQueued = true;
+        publishPosition();
+    }
+    for ( auto event : batch.events )
+    {
+        switch ( event )
+        {
+        case Playing:
+            emit playing();
+            break;
+        case Paused:
+            emit paused();
+            break;
+        case Stopped:
+            emit stopped();
+            break;
+        case EndReached:
+            emit endReached();
+            break;
+        case VolumeChanged:
+            emit volumeChanged();
+            break;
+        case ErrorEncountered:
+            emit errorEncountered();
+            break;
+        }
+    }
+    if ( batch.framesDropped > 0 )
+        emit framesDropped( batch.framesDropped );
+    if ( batch.audioUnderruns > 0 )
+        emit audioUnderrun( batch.audioUnderruns );
+}
+
+void
+RendererEventWatcher::publishPosition()
+{
+    // Within the current refresh: the timeout publishes the latest position
+    if ( m_publishTimer.isActive() == true || m_publishQueued == false )
+        return;
+    m_publishQueued = false;
+    emit displayPositionChanged( m_latestPosition );
+    m_publishTimer.start();
 }
@@ -24,17 +24,33 @@
 #ifndef RENDEREREVENTWATCHER_H
 #define RENDEREREVENTWATCHER_H
 
-#include <QObject>
+#include <QTimer>
 
 #include "Backend/IOutput.h"
 #include "Backend/IInput.h"
+#include "Tools/EventBridge.h"
 
-class RendererEventWatcher : public QObject, public Backend::IOutputEventCb, public Backend::IInputEventCb
+/**
+ *  \brief Forwards the backend events, which are received from its threads, as signals.
+ *
+ *  The signals are emitted from the watcher's thread, in batches: positionChanged is
+ *  emitted once per batch with the latest position, which is as often as the event
+ *  loop keeps up with. Widgets should rather use displayPositionChanged: it is
+ *  delivered at most once per display refresh.
+ */
+class RendererEventWatcher : public Tools::EventBridge, public Backend::IOutputEventCb,
+                             public Backend::IInputEventCb
 {
     Q_OBJECT
 public:
+    // About one refresh of a 60Hz display
+    static const int    DisplayInterval = 16;
+
     explicit RendererEventWatcher(QObject *parent = 0);
 
+private slots:
+    void            publishPosition();
+
 private:
     virtual void    onPlaying();
     virtual void    onPaused();
@@ -44,6 +60,15 @@ private:
     virtual void    onPositionChanged( int64_t );
     virtual void    onLengthChanged( int64_t );
     virtual void    onErrorEncountered();
+    virtual void    onFramesDropped( uint32_t nbDropped );
+    virtual void    onAudioUnderrun( uint32_t nbUnderruns );
+
+    virtual void    deliver( const Batch& batch );
+
+    qint64              m_latestPosition;
+    // Set while a position waits for the end of the current refresh
+    bool                m_publishQueued;
+    QTimer              m_publishTimer;
 
 signals:
     void            playing();
@@ -52,8 +77,14 @@ signals:
     void            endReached();
     void            volumeChanged();
     void            positionChanged( qint64 );
+    /**
+     *  \brief Emitted at most once per display refresh, with the latest position.
+     */
+    void            displayPositionChanged( qint64 );
     void            lengthChanged( qint64 );
     void            errorEncountered();
+    void            framesDropped( quint32 nbDropped );
+    void            audioUnderrun( quint32 nbUnderruns );
 };
 
 #endif // RENDEREREVENTWATCHER_H
@@ -0,0 +1,367 @@
+/*****************************************************************************
+ * SampleReduction.cpp: SIMD min/max/energy reduction of audio samples
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "SampleReduction.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined( __SSE2__ )
+# include <emmintrin.h>
+#endif
+#if ( defined( __x86_64__ ) || defined( __i386__ ) ) && defined( __GNUC__ )
+# include <immintrin.h>
+# define HAVE_AVX2_DISPATCH
+#endif
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+# include <arm_neon.h>
+# define HAVE_NEON
+#endif
+
+namespace
+{
+    using ReduceFunction = Tools::SampleStats (*)( const int16_t*, size_t );
+    using ReduceFloatFunction = Tools::FloatSampleStats (*)( const float*, size_t );
+
+    Tools::SampleStats
+    initialStats()
+    {
+        return Tools::SampleStats{ std::numeric_limits<int16_t>::max(),
+                                   std::numeric_limits<int16_t>::min(), 0 };
+    }
+
+    void
+    accumulate( const int16_t* samples, size_t count, Tools::SampleStats& stats )
+    {
+        for ( size_t i = 0; i < count; ++i )
+        {
+            auto s = samples[i];
+            stats.min = std::min( stats.min, s );
+            stats.max = std::max( stats.max, s );
+            stats.sumSq += (uint64_t)( (int32_t)s * s );
+        }
+    }
+
+    Tools::FloatSampleStats
+    initialFloatStats()
+    {
+        return Tools::FloatSampleStats{ std::numeric_limits<float>::infinity(),
+                                        -std::numeric_limits<float>::infinity(), 0 };
+    }
+
+    void
+    accumulate( const float* samples, size_t count, Tools::FloatSampleStats& stats )
+    {
+        for ( size_t i = 0; i < count; ++i )
+        {
+            auto s = samples[i];
+            stats.min = std::min( stats.min, s );
+            stats.max = std::max( stats.max, s );
+            stats.sumSq += (double)s * s;
+        }
+    }
+
+    void
+    fold( const float* mins, const float* maxs, size_t nbLanes, Tools::FloatSampleStats& stats )
+    {
+        for ( size_t i = 0; i < nbLanes; ++i )
+        {
+            stats.min = std::min( stats.min, mins[i] );
+            stats.max = std::max( stats.max, maxs[i] );
+        }
+    }
+
+    double
+    sum( const float* lanes, size_t nbLanes )
+    {
+        double res = 0;
+        for ( size_t i = 0; i < nbLanes; ++i )
+            res += lanes[i];
+        return res;
+    }
+
+    // Folds the vector lanes into stats. mins and maxs hold nbLanes values.
+    void
+    fold( const int16_t* mins, const int16_t* maxs, size_t nbLanes,
+          const uint64_t* sums, size_t nbSums, Tools::SampleStats& stats )
+    {
+        for ( size_t i = 0; i < nbLanes; ++i )
+        {
+            stats.min = std::min( stats.min, mins[i] );
+            stats.max = std::max( stats.max, maxs[i] );
+        }
+        for ( size_t i = 0; i < nbSums; ++i )
+            stats.sumSq += sums[i];
+    }
+
+#if defined( __SSE2__ )
+    Tools::SampleStats
+    reduceSSE2( const int16_t* samples, size_t count )
+    {
+        auto stats = initialStats();
+        auto vmin = _mm_set1_epi16( stats.min );
+        auto vmax = _mm_set1_epi16( stats.max );
+        auto vsum = _mm_setzero_si128();
+        const auto zero = _mm_setzero_si128();
+        size_t i = 0;
+        for ( ; i + 8 <= count; i += 8 )
+        {
+            auto v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( samples + i ) );
+            vmin = _mm_min_epi16( vmin, v );
+            vmax = _mm_max_epi16( vmax, v );
+            // Pairs of squares fit in an unsigned 32 bits lane, even for -32768
+            auto sq = _mm_madd_epi16( v, v );
+            vsum = _mm_add_epi64( vsum, _mm_unpacklo_epi32( sq, zero ) );
+            vsum = _mm_add_epi64( vsum, _mm_unpackhi_epi32( sq, zero ) );
+        }
+        int16_t mins[8];
+        int16_t maxs[8];
+        uint64_t sums[2];
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( mins ), vmin );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( maxs ), vmax );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( sums ), vsum );
+        fold( mins, maxs, 8, sums, 2, stats );
+        accumulate( samples + i, count - i, stats );
+        return stats;
+    }
+
+    Tools::FloatSampleStats
+    reduceFloatSSE2( const float* samples, size_t count )
+    {
+        auto stats = initialFloatStats();
+        auto vmin = _mm_set1_ps( stats.min );
+        auto vmax = _mm_set1_ps( stats.max );
+        float   lanes[4];
+        size_t i = 0;
+        while ( i + 4 <= count )
+        {
+            // Flushed to the double precision sum every block
+            auto vsum = _mm_setzero_ps();
+            auto end = std::min( count - count % 4, i + Tools::FloatBlockSize );
+            for ( ; i < end; i += 4 )
+            {
+                auto v = _mm_loadu_ps( samples + i );
+                vmin = _mm_min_ps( vmin, v );
+                vmax = _mm_max_ps( vmax, v );
+                vsum = _mm_add_ps( vsum, _mm_mul_ps( v, v ) );
+            }
+            _mm_storeu_ps( lanes, vsum );
+            stats.sumSq += sum( lanes, 4 );
+        }
+        float mins[4];
+        float maxs[4];
+        _mm_storeu_ps( mins, vmin );
+        _mm_storeu_ps( maxs, vmax );
+        fold( mins, maxs, 4, stats );
+        accumulate( samples + i, count - i, stats );
+        return stats;
+    }
+#endif
+
+#if defined( HAVE_AVX2_DISPATCH )
+    __attribute__(( target( "avx2" ) )) Tools::SampleStats
+    reduceAVX2( const int16_t* samples, size_t count )
+    {
+        auto stats = initialStats();
+        auto vmin = _mm256_set1_epi16( stats.min );
+        auto vmax = _mm256_set1_epi16( stats.max );
+        auto vsum = _mm256_setzero_si256();
+        const auto zero = _mm256_setzero_si256();
+        size_t i = 0;
+        for ( ; i + 16 <= count; i += 16 )
+        {
+            auto v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( samples + i ) );
+            vmin = _mm256_min_epi16( vmin, v );
+            vmax = _mm256_max_epi16( vmax, v );
+            auto sq = _mm256_madd_epi16( v, v );
+            vsum = _mm256_add_epi64( vsum, _mm256_unpacklo_epi32( sq, zero ) );
+            vsum = _mm256_add_epi64( vsum, _mm256_unpackhi_epi32( sq, zero ) );
+        }
+        int16_t mins[16];
+        int16_t maxs[16];
+        uint64_t sums[4];
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( mins ), vmin );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( maxs ), vmax );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( sums ), vsum );
+        fold( mins, maxs, 16, sums, 4, stats );
+        accumulate( samples + i, count - i, stats );
+        return stats;
+    }
+
+    __attribute__(( target( "avx2" ) )) Tools::FloatSampleStats
+    reduceFloatAVX2( const float* samples, size_t count )
+    {
+        auto stats = initialFloatStats();
+        auto vmin = _mm256_set1_ps( stats.min );
+        auto vmax = _mm256_set1_ps( stats.max );
+        float   lanes[8];
+        size_t i = 0;
+        while ( i + 8 <= count )
+        {
+            auto vsum = _mm256_setzero_ps();
+            auto end = std::min( count - count % 8, i + Tools::FloatBlockSize );
+            for ( ; i < end; i += 8 )
+            {
+                auto v = _mm256_loadu_ps( samples + i );
+                vmin = _mm256_min_ps( vmin, v );
+                vmax = _mm256_max_ps( vmax, v );
+                vsum = _mm256_add_ps( vsum, _mm256_mul_ps( v, v ) );
+            }
+            _mm256_storeu_ps( lanes, vsum );
+            stats.sumSq += sum( lanes, 8 );
+        }
+        float mins[8];
+        float maxs[8];
+        _mm256_storeu_ps( mins, vmin );
+        _mm256_storeu_ps( maxs, vmax );
+        fold( mins, maxs, 8, stats );
+        accumulate( samples + i, count - i, stats );
+        return stats;
+    }
+#endif
+
+#if defined( HAVE_NEON )
+    Tools::SampleStats
+    reduceNEON( const int16_t* samples, size_t count )
+    {
+        auto stats = initialStats();
+        auto vmin = vdupq_n_s16( stats.min );
+        auto vmax = vdupq_n_s16( stats.max );
+        auto vsum = vdupq_n_s64( 0 );
+        size_t i = 0;
+        for ( ; i + 8 <= count; i += 8 )
+        {
+            auto v = vld1q_s16( samples + i );
+            vmin = vminq_s16( vmin, v );
+            vmax = vmaxq_s16( vmax, v );
+            // A single square always fits in a signed 32 bits lane
+            vsum = vpadalq_s32( vsum, vmull_s16( vget_low_s16( v ), vget_low_s16( v ) ) );
+            vsum = vpadalq_s32( vsum, vmull_s16( vget_high_s16( v ), vget_high_s16( v ) ) );
+        }
+        int16_t mins[8];
+        int16_t maxs[8];
+        int64_t sums[2];
+        vst1q_s16( mins, vmin );
+        vst1q_s16( maxs, vmax );
+        vst1q_s64( sums, vsum );
+        const uint64_t usums[2] = { (uint64_t)sums[0], (uint64_t)sums[1] };
+        fold( mins, maxs, 8, usums, 2, stats );
+        accumulate( samples + i, count - i, stats );
+        return stats;
+    }
+
+    Tools::FloatSampleStats
+    reduceFloatNEON( const float* samples, size_t count )
+    {
+        auto stats = initialFloatStats();
+        auto vmin = vdupq_n_f32( stats.min );
+        auto vmax = vdupq_n_f32( stats.max );
+        float   lanes[4];
+        size_t i = 0;
+        while ( i + 4 <= count )
+        {
+            // 32 bits ARM has no double precision vectors
+            auto vsum = vdupq_n_f32( 0 );
+            auto end = std::min( count - count % 4, i + Tools::FloatBlockSize );
+            for ( ; i < end; i += 4 )
+            {
+                auto v = vld1q_f32( samples + i );
+                vmin = vminq_f32( vmin, v );
+                vmax = vmaxq_f32( vmax, v );
+                vsum = vmlaq_f32( vsum, v, v );
+            }
+            vst1q_f32( lanes, vsum );
+            stats.sumSq += sum( lanes, 4 );
+        }
+        float mins[4];
+        float maxs[4];
+        vst1q_f32( mins, vmin );
+        vst1q_f32( maxs, vmax );
+        fold( mins, maxs, 4, stats );
+        accumulate( samples + i, count - i, stats );
+        return stats;
+    }
+#endif
+
+    std::vector<Tools::SampleReducer>
+    reducers()
+    {
+        std::vector<Tools::SampleReducer>   res;
+        res.push_back( Tools::SampleReducer{ "scalar", &Tools::reduceSamplesScalar,
+                                             &Tools::reduceSamplesScalar } );
+#if defined( __SSE2__ )
+        res.push_back( Tools::SampleReducer{ "SSE2", &reduceSSE2, &reduceFloatSSE2 } );
+#elif defined( HAVE_NEON )
+        res.push_back( Tools::SampleReducer{ "NEON", &reduceNEON, &reduceFloatNEON } );
+#endif
+#if defined( HAVE_AVX2_DISPATCH )
+        __builtin_cpu_init();
+        if ( __builtin_cpu_supports( "avx2" ) )
+            res.push_back( Tools::SampleReducer{ "AVX2", &reduceAVX2, &reduceFloatAVX2 } );
+#endif
+        return res;
+    }
+
+    // The widest one the CPU runs
+    Tools::SampleReducer
+    resolve()
+    {
+        return reducers().back();
+    }
+}
+
+std::vector<Tools::SampleReducer>
+Tools::sampleReducers()
+{
+    return reducers();
+}
+
+Tools::SampleStats
+Tools::reduceSamplesScalar( const int16_t* samples, size_t count )
+{
+    auto stats = initialStats();
+    accumulate( samples, count, stats );
+    return stats;
+}
+
+Tools::SampleStats
+Tools::reduceSamples( const int16_t* samples, size_t count )
+{
+    // Resolved once, thread safe since C++11
+    static const ReduceFunction reduce = resolve().s16;
+    return reduce( samples, count );
+}
+
+Tools::FloatSampleStats
+Tools::reduceSamplesScalar( const float* samples, size_t count )
+{
+    auto stats = initialFloatStats();
+    accumulate( samples, count, stats );
+    return stats;
+}
+
+Tools::FloatSampleStats
+Tools::reduceSamples( const float* samples, size_t count )
+{
+    static const ReduceFloatFunction reduce = resolve().f32;
+    return reduce( samples, count );
+}
@@ -0,0 +1,88 @@
+/*****************************************************************************
+ * SampleReduction.h: SIMD min/max/energy reduction of audio samples
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SAMPLEREDUCTION_H
+#define SAMPLEREDUCTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Tools
+{
+    struct SampleStats
+    {
+        int16_t     min;
+        int16_t     max;
+        // Sum of the squared samples
+        uint64_t    sumSq;
+    };
+
+    struct FloatSampleStats
+    {
+        float       min;
+        float       max;
+        double      sumSq;
+    };
+
+    /**
+     *  \brief  Computes the min, max and energy of count s16 samples.
+     *
+     *  Interleaved channels are reduced together. This uses the widest vector unit
+     *  available on the running CPU (AVX2, SSE2 or NEON), and falls back to a scalar
+     *  loop otherwise.
+     */
+    SampleStats     reduceSamples( const int16_t* samples, size_t count );
+
+    /**
+     *  \brief  Scalar reference implementation of reduceSamples
+     */
+    SampleStats     reduceSamplesScalar( const int16_t* samples, size_t count );
+
+    /**
+     *  \brief  Same as reduceSamples, for float samples.
+     *
+     *  The vector paths sum the squares of up to FloatBlockSize samples in single
+     *  precision before adding them up in double precision, so their sumSq may differ
+     *  from the scalar one by a few ulps of a float.
+     */
+    FloatSampleStats    reduceSamples( const float* samples, size_t count );
+    FloatSampleStats    reduceSamplesScalar( const float* samples, size_t count );
+
+    static const size_t FloatBlockSize = 1024;
+
+    // One implementation of the reductions, for benchmarks
+    struct SampleReducer
+    {
+        const char*     name;
+        SampleStats     (*s16)( const int16_t* samples, size_t count );
+        FloatSampleStats    (*f32)( const float* samples, size_t count );
+    };
+
+    /**
+     *  \returns   The implementations the running CPU supports: the scalar one first,
+     *             the one reduceSamples() uses last.
+     */
+    std::vector<SampleReducer>  sampleReducers();
+}
+
+#endif // SAMPLEREDUCTION_H
@@ -0,0 +1,154 @@
+/*****************************************************************************
+ * SceneDetection.cpp: Shot change detection
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "SceneDetection.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined( __SSE2__ )
+# include <emmintrin.h>
+#endif
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+# include <arm_neon.h>
+# define HAVE_NEON
+#endif
+
+namespace
+{
+    // Frames on each side a distance is compared to
+    const int64_t   Neighbourhood = 6;
+    // How far above its neighbours' mean a distance has to be
+    const float     ContrastRatio = 3.f;
+
+    static_assert( Tools::HistogramSize % 4 == 0, "The distance handles 4 bins at a time" );
+}
+
+void
+Tools::colourHistogram( const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t stride,
+                        float* histogram )
+{
+    const uint32_t  shift = 8 - 5;
+    static_assert( HistogramBins == 1 << 5, "The bins are the 5 upper bits of the components" );
+    uint32_t counts[HistogramSize] = {};
+    for ( uint32_t y = 0; y < height; ++y )
+    {
+        auto line = rgba + static_cast<size_t>( y ) * stride;
+        uint32_t x = 0;
+#if defined( __SSE2__ )
+        // Bins of 4 pixels at once, only the counting is scalar
+        const auto mask = _mm_set1_epi8( HistogramBins - 1 );
+        alignas( 16 ) uint8_t bins[16];
+        for ( ; x + 4 <= width; x += 4 )
+        {
+            auto px = _mm_loadu_si128( reinterpret_cast<const __m128i*>( line + x * 4 ) );
+            _mm_store_si128( reinterpret_cast<__m128i*>( bins ),
+                             _mm_and_si128( _mm_srli_epi16( px, shift ), mask ) );
+            for ( int i = 0; i < 16; i += 4 )
+            {
+                ++counts[bins[i]];
+                ++counts[HistogramBins + bins[i + 1]];
+                ++counts[2 * HistogramBins + bins[i + 2]];
+            }
+        }
+#elif defined( HAVE_NEON )
+        uint8_t bins[16];
+        for ( ; x + 4 <= width; x += 4 )
+        {
+            vst1q_u8( bins, vshrq_n_u8( vld1q_u8( line + x * 4 ), shift ) );
+            for ( int i = 0; i < 16; i += 4 )
+            {
+                ++counts[bins[i]];
+                ++counts[HistogramBins + bins[i + 1]];
+                ++counts[2 * HistogramBins + bins[i + 2]];
+            }
+        }
+#endif
+        for ( ; x < width; ++x )
+        {
+            auto px = line + x * 4;
+            ++counts[px[0] >> shift];
+            ++counts[HistogramBins + ( px[1] >> shift )];
+            ++counts[2 * HistogramBins + ( px[2] >> shift )];
+        }
+    }
+    auto nbPixels = static_cast<float>( width ) * height;
+    for ( uint32_t i = 0; i < HistogramSize; ++i )
+        histogram[i] = nbPixels > 0 ? counts[i] / nbPixels : 0.f;
+}
+
+float
+Tools::histogramDistance( const float* a, const float* b )
+{
+    float sum;
+#if defined( __SSE2__ )
+    const auto absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7FFFFFFF ) );
+    auto acc = _mm_setzero_ps();
+    for ( uint32_t i = 0; i < HistogramSize; i += 4 )
+    {
+        auto diff = _mm_sub_ps( _mm_loadu_ps( a + i ), _mm_loadu_ps( b + i ) );
+        acc = _mm_add_ps( acc, _mm_and_ps( diff, absMask ) );
+    }
+    alignas( 16 ) float lanes[4];
+    _mm_store_ps( lanes, acc );
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined( HAVE_NEON )
+    auto acc = vdupq_n_f32( 0.f );
+    for ( uint32_t i = 0; i < HistogramSize; i += 4 )
+        acc = vaddq_f32( acc, vabdq_f32( vld1q_f32( a + i ), vld1q_f32( b + i ) ) );
+    sum = vgetq_lane_f32( acc, 0 ) + vgetq_lane_f32( acc, 1 ) +
+          vgetq_lane_f32( acc, 2 ) + vgetq_lane_f32( acc, 3 );
+#else
+    sum = 0.f;
+    for ( uint32_t i = 0; i < HistogramSize; ++i )
+        sum += std::fabs( a[i] - b[i] );
+#endif
+    // Each component's differences add up to 2 at most
+    return sum / 6.f;
+}
+
+std::vector<int64_t>
+Tools::sceneCuts( const std::vector<float>& distances, float threshold, int64_t minLength )
+{
+    std::vector<int64_t>    cuts;
+    auto nbFrames = static_cast<int64_t>( distances.size() );
+    // Sums of the distances before each frame, for the means of the neighbourhoods
+    std::vector<double>     sums( nbFrames + 1, 0. );
+    for ( int64_t i = 0; i < nbFrames; ++i )
+        sums[i + 1] = sums[i] + distances[i];
+    int64_t last = 0;
+    for ( int64_t i = 1; i < nbFrames; ++i )
+    {
+        auto d = distances[i];
+        if ( d <= threshold || i - last < minLength || nbFrames - i < minLength )
+            continue;
+        auto first = std::max<int64_t>( 1, i - Neighbourhood );
+        auto end = std::min( nbFrames, i + Neighbourhood + 1 );
+        auto count = end - first - 1;
+        auto mean = count > 0 ? ( sums[end] - sums[first] - d ) / count : 0.;
+        if ( d < mean * ContrastRatio )
+            continue;
+        cuts.push_back( i );
+        last = i;
+    }
+    return cuts;
+}
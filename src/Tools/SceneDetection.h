@@ -0,0 +1,65 @@
+/*****************************************************************************
+ * SceneDetection.h: Shot change detection
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SCENEDETECTION_H
+#define SCENEDETECTION_H
+
+#include <cstdint>
+#include <vector>
+
+namespace Tools
+{
+    // Bins per colour component. Coarse enough for noise and small motion not to count.
+    const uint32_t  HistogramBins = 32;
+    // Red, green and blue bins, one after the other
+    const uint32_t  HistogramSize = HistogramBins * 3;
+
+    /**
+     *  \brief  Computes the colour histogram of an RGBA picture, in histogram, which
+     *          holds HistogramSize values.
+     *
+     *  Each component's bins are normalized to add up to 1, so pictures of any size
+     *  compare.
+     */
+    void                    colourHistogram( const uint8_t* rgba, uint32_t width, uint32_t height,
+                                             uint32_t stride, float* histogram );
+    /**
+     *  \brief  How different two histograms are, from 0 for the same colours to 1 for
+     *          pictures which share none.
+     *
+     *  This is the sum of the absolute differences of the bins, vectorized.
+     */
+    float                   histogramDistance( const float* a, const float* b );
+    /**
+     *  \brief  Finds the shot changes in the distances between consecutive frames.
+     *
+     *  distances[i] compares frame i to frame i - 1. A frame starts a new shot when
+     *  its distance exceeds threshold, and stands out from the frames around it, so
+     *  that fast motion, which keeps every distance high, doesn't cut the shot in
+     *  pieces. Shots last at least minLength frames.
+     *  \returns    The first frame of each shot but the first one, in ascending order.
+     */
+    std::vector<int64_t>    sceneCuts( const std::vector<float>& distances, float threshold,
+                                       int64_t minLength );
+}
+
+#endif // SCENEDETECTION_H
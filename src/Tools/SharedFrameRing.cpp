@@ -0,0 +1,242 @@
+/*****************************************************************************
+ * SharedFrameRing.cpp: Video frames published in shared memory
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "SharedFrameRing.h"
+#include "Backend/IInput.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QtGlobal>
+
+#ifdef Q_OS_UNIX
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#else
+# include <QSharedMemory>
+#endif
+
+#include <chrono>
+#include <cstring>
+
+using namespace Tools;
+
+namespace
+{
+    const char  Magic[8] = { 'V', 'L', 'M', 'C', 'R', 'I', 'N', 'G' };
+    // Keeps the images aligned for the readers' SIMD loads
+    const uint64_t  Alignment = 64;
+
+    uint64_t
+    align( uint64_t size )
+    {
+        return ( size + Alignment - 1 ) & ~( Alignment - 1 );
+    }
+}
+
+struct SharedFrameRing::Mapping
+{
+#ifdef Q_OS_UNIX
+    std::string     name;
+    void*           address = nullptr;
+    size_t          size = 0;
+#else
+    QSharedMemory   memory;
+#endif
+};
+
+SharedFrameRing::SharedFrameRing( const QString& name, uint32_t nbSlots )
+    : m_name( name )
+    , m_nbSlots( qMax( 2u, nbSlots ) )
+    , m_mapping( new Mapping )
+    , m_header( nullptr )
+    , m_capacity( 0 )
+    , m_failed( false )
+{
+#ifdef Q_OS_UNIX
+    // POSIX shared memory object names start with a single slash
+    m_mapping->name = m_name.startsWith( '/' ) == true ? m_name.toStdString()
+                                                          : '/' + m_name.toStdString();
+#endif
+}
+
+SharedFrameRing::~SharedFrameRing()
+{
+    close();
+}
+
+const QString&
+SharedFrameRing::name() const
+{
+    return m_name;
+}
+
+uint64_t
+SharedFrameRing::imageSize( const Backend::IVideoFrame& frame )
+{
+    uint64_t size = static_cast<uint64_t>( frame.stride() ) * frame.height();
+    // Both chroma planes are a quarter of the luma plane
+    if ( frame.format() == Backend::IVideoFrame::YUV420P )
+        size += size / 2;
+    return size;
+}
+
+bool
+SharedFrameRing::reserve( uint64_t size )
+{
+    if ( m_header != nullptr && size <= m_capacity )
+        return true;
+    // Don't retry on every frame when the system refuses the mapping
+    if ( m_failed == true && size <= m_capacity )
+        return false;
+    unmap();
+    m_capacity = align( size );
+    auto slotSize = align( sizeof( Slot ) ) + m_capacity;
+    auto slotsOffset = align( sizeof( Header ) );
+    if ( map( slotsOffset + slotSize * m_nbSlots ) == false )
+    {
+        vlmcWarning() << "Can't create the shared memory ring" << m_name;
+        m_failed = true;
+        return false;
+    }
+    m_failed = false;
+    memcpy( m_header->magic, Magic, sizeof( Magic ) );
+    m_header->version = Version;
+    m_header->nbSlots = m_nbSlots;
+    m_header->slotsOffset = slotsOffset;
+    m_header->slotSize = slotSize;
+    m_header->published.store( 0, std::memory_order_relaxed );
+    for ( uint32_t i = 0; i < m_nbSlots; ++i )
+        slot( i )->sequence.store( 0, std::memory_order_relaxed );
+    m_header->open.store( 1, std::memory_order_release );
+    return true;
+}
+
+void
+SharedFrameRing::publish( const Backend::IVideoFrame& frame, int64_t position, int64_t pts )
+{
+    auto size = imageSize( frame );
+    if ( reserve( size ) == false )
+        return;
+    auto published = m_header->published.load( std::memory_order_relaxed );
+    auto s = slot( published % m_nbSlots );
+    auto sequence = s->sequence.load( std::memory_order_relaxed );
+    s->sequence.store( sequence + 1, std::memory_order_relaxed );
+    // Readers must see the odd sequence before any of the image changes
+    std::atomic_thread_fence( std::memory_order_release );
+
+    s->frame = position;
+    s->pts = pts;
+    s->timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count();
+    s->format = frame.format();
+    s->width = frame.width();
+    s->height = frame.height();
+    s->stride = frame.stride();
+    s->dataOffset = align( sizeof( Slot ) );
+    s->dataSize = size;
+    memcpy( reinterpret_cast<uint8_t*>( s ) + s->dataOffset, frame.data(), size );
+
+    s->sequence.store( sequence + 2, std::memory_order_release );
+    m_header->published.store( published + 1, std::memory_order_release );
+}
+
+void
+SharedFrameRing::close()
+{
+    unmap();
+    m_capacity = 0;
+    m_failed = false;
+}
+
+SharedFrameRing::Slot*
+SharedFrameRing::slot( uint64_t index )
+{
+    auto base = reinterpret_cast<uint8_t*>( m_header ) + m_header->slotsOffset;
+    return reinterpret_cast<Slot*>( base + index * m_header->slotSize );
+}
+
+#ifdef Q_OS_UNIX
+
+bool
+SharedFrameRing::map( uint64_t size )
+{
+    // Readers still holding the previous ring keep their mapping, and see it closed
+    shm_unlink( m_mapping->name.c_str() );
+    auto fd = shm_open( m_mapping->name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644 );
+    if ( fd < 0 )
+        return false;
+    if ( ftruncate( fd, size ) != 0 )
+    {
+        ::close( fd );
+        shm_unlink( m_mapping->name.c_str() );
+        return false;
+    }
+    auto address = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    ::close( fd );
+    if ( address == MAP_FAILED )
+    {
+        shm_unlink( m_mapping->name.c_str() );
+        return false;
+    }
+    m_mapping->address = address;
+    m_mapping->size = size;
+    m_header = static_cast<Header*>( address );
+    return true;
+}
+
+void
+SharedFrameRing::unmap()
+{
+    if ( m_header == nullptr )
+        return;
+    m_header->open.store( 0, std::memory_order_release );
+    munmap( m_mapping->address, m_mapping->size );
+    shm_unlink( m_mapping->name.c_str() );
+    m_mapping->address = nullptr;
+    m_mapping->size = 0;
+    m_header = nullptr;
+}
+
+#else
+
+bool
+SharedFrameRing::map( uint64_t size )
+{
+    // The native key is the name of the file mapping, as other processes open it
+    m_mapping->memory.setNativeKey( m_name );
+    if ( m_mapping->memory.create( size ) == false )
+        return false;
+    m_header = static_cast<Header*>( m_mapping->memory.data() );
+    return true;
+}
+
+void
+SharedFrameRing::unmap()
+{
+    if ( m_header == nullptr )
+        return;
+    m_header->open.store( 0, std::memory_order_release );
+    m_mapping->memory.detach();
+    m_header = nullptr;
+}
+
+#endif
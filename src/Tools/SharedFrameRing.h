@@ -0,0 +1,129 @@
+/*****************************************************************************
+ * SharedFrameRing.h: Video frames published in shared memory
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SHAREDFRAMERING_H
+#define SHAREDFRAMERING_H
+
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Backend
+{
+    class IVideoFrame;
+}
+
+namespace Tools
+{
+/**
+ *  \brief  Publishes video frames in a named shared-memory ring buffer, which other
+ *          processes, such as scopes or a monitoring bridge, read in place.
+ *
+ *  The mapping starts with a Header, followed by nbSlots slots of slotSize bytes.
+ *  Each slot starts with a Slot, and its image follows at Slot::dataOffset. The most
+ *  recent frame is in slot ( published - 1 ) % nbSlots, and the writer overwrites the
+ *  oldest one, leaving readers nbSlots - 1 frames of time.
+ *  A slot's sequence is odd while it is being written: a reader checks that it is even
+ *  before reading the image, and unchanged afterward, and otherwise drops that frame.
+ *  The writer never waits for the readers.
+ *
+ *  On Unix the ring is a POSIX shared memory object, opened with shm_open( name ),
+ *  on Windows a file mapping of that name. When the ring has to grow, or the writer
+ *  goes away, Header::open is cleared, and readers are expected to reopen it.
+ */
+class SharedFrameRing
+{
+    public:
+        static const uint32_t   Version = 1;
+
+        struct Header
+        {
+            // "VLMCRING"
+            char                    magic[8];
+            uint32_t                version;
+            std::atomic<uint32_t>   open;
+            uint32_t                nbSlots;
+            // Offset of the first slot from the start of the mapping
+            uint32_t                slotsOffset;
+            uint64_t                slotSize;
+            // Number of frames published so far
+            std::atomic<uint64_t>   published;
+        };
+
+        struct Slot
+        {
+            std::atomic<uint64_t>   sequence;
+            // Position of the frame in the sequence
+            int64_t                 frame;
+            // Presentation time, in microseconds from the start of the sequence
+            int64_t                 pts;
+            // Time at which the frame was published, in microseconds of the monotonic clock
+            int64_t                 timestamp;
+            // A Backend::IVideoFrame::Format
+            uint32_t                format;
+            uint32_t                width;
+            uint32_t                height;
+            // Bytes per line of the first plane
+            uint32_t                stride;
+            // Offset of the image from the start of the slot, and its size in bytes
+            uint32_t                dataOffset;
+            uint32_t                dataSize;
+        };
+
+        SharedFrameRing( const QString& name, uint32_t nbSlots = 4 );
+        ~SharedFrameRing();
+
+        const QString&  name() const;
+        /**
+         *  \brief  Creates the ring if it can't hold frames of size bytes yet.
+         *
+         *  Called by publish() as needed. Calling it before the first frame avoids
+         *  doing so from the thread which publishes them.
+         */
+        bool            reserve( uint64_t size );
+        // Copies the frame to the oldest slot
+        void            publish( const Backend::IVideoFrame& frame, int64_t position, int64_t pts );
+        void            close();
+
+        // Size in bytes of the frame's image
+        static uint64_t imageSize( const Backend::IVideoFrame& frame );
+
+    private:
+        bool            map( uint64_t size );
+        void            unmap();
+        Slot*           slot( uint64_t index );
+
+    private:
+        struct Mapping;
+
+        QString                     m_name;
+        uint32_t                    m_nbSlots;
+        std::unique_ptr<Mapping>    m_mapping;
+        Header*                     m_header;
+        uint64_t                    m_capacity;
+        bool                        m_failed;
+};
+}
+
+#endif // SHAREDFRAMERING_H
@@ -0,0 +1,82 @@
+/*****************************************************************************
+ * SpscRing.h: Lock-free single producer, single consumer queue
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace Tools
+{
+/**
+ *  \brief  Bounded lock-free queue between one producer thread and one consumer thread.
+ *
+ *  Neither side ever blocks nor allocates: push() fails when the queue is full, and
+ *  pop() when it is empty. Capacity must be a power of two.
+ */
+template <typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert( Capacity > 0 && ( Capacity & ( Capacity - 1 ) ) == 0,
+                   "The capacity must be a power of two" );
+
+    public:
+        SpscRing()
+            : m_head( 0 )
+            , m_tail( 0 )
+        {
+        }
+
+        // Only called from the producer thread
+        bool
+        push( const T& value )
+        {
+            auto tail = m_tail.load( std::memory_order_relaxed );
+            if ( tail - m_head.load( std::memory_order_acquire ) == Capacity )
+                return false;
+            m_items[tail & ( Capacity - 1 )] = value;
+            m_tail.store( tail + 1, std::memory_order_release );
+            return true;
+        }
+
+        // Only called from the consumer thread
+        bool
+        pop( T& value )
+        {
+            auto head = m_head.load( std::memory_order_relaxed );
+            if ( head == m_tail.load( std::memory_order_acquire ) )
+                return false;
+            value = m_items[head & ( Capacity - 1 )];
+            m_head.store( head + 1, std::memory_order_release );
+            return true;
+        }
+
+    private:
+        T                                   m_items[Capacity];
+        // On lines of their own, each side only writes to its index
+        alignas( 64 ) std::atomic<size_t>   m_head;
+        alignas( 64 ) std::atomic<size_t>   m_tail;
+};
+}
+
+#endif // SPSCRING_H
@@ -0,0 +1,119 @@
+/*****************************************************************************
+ * StallWatchdog.cpp: Reports the stalls of the GUI thread's event loop
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "Tools/StallWatchdog.h"
+
+#include <QStringList>
+#include <QThread>
+
+#include "Tools/BacktraceGenerator.h"
+#include "Tools/Metrics.h"
+#include "Tools/VlmcDebug.h"
+
+using namespace Tools;
+
+StallWatchdog::StallWatchdog()
+    : m_guiThread( QThread::currentThreadId() )
+    , m_lastBeat( 0 )
+    , m_threshold( 0 )
+    , m_stop( false )
+{
+    m_clock.start();
+    m_heartbeat.setInterval( HeartbeatInterval );
+    QObject::connect( &m_heartbeat, &QTimer::timeout, [this] { heartbeat(); } );
+    m_watcher = std::thread( &StallWatchdog::watch, this );
+}
+
+StallWatchdog::~StallWatchdog()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    m_watcher.join();
+}
+
+void
+StallWatchdog::setThreshold( int threshold )
+{
+    m_lastBeat = m_clock.elapsed();
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_threshold = threshold;
+    }
+    m_cond.notify_all();
+    if ( threshold > 0 )
+        m_heartbeat.start();
+    else
+        m_heartbeat.stop();
+}
+
+void
+StallWatchdog::heartbeat()
+{
+    auto now = m_clock.elapsed();
+    auto stalled = now - m_lastBeat.exchange( now );
+    auto threshold = m_threshold.load();
+    if ( threshold <= 0 || stalled < threshold )
+        return;
+    static auto& stalls = Metrics::counter( "gui.stalls" );
+    static auto& stallTime = Metrics::histogram( "gui.stallTime" );
+    stalls.add();
+    stallTime.record( stalled * 1000 );
+    vlmcWarning() << "The interface was unresponsive for" << stalled << "ms";
+}
+
+void
+StallWatchdog::watch()
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    // The beat which was late when the current stall got reported
+    qint64  reportedBeat = -1;
+    while ( m_stop == false )
+    {
+        auto threshold = m_threshold.load();
+        if ( threshold <= 0 )
+        {
+            m_cond.wait( lock );
+            continue;
+        }
+        m_cond.wait_for( lock, std::chrono::milliseconds( HeartbeatInterval ) );
+        if ( m_stop == true )
+            break;
+        auto lastBeat = m_lastBeat.load();
+        auto stalled = m_clock.elapsed() - lastBeat;
+        if ( stalled < threshold || lastBeat == reportedBeat )
+            continue;
+        reportedBeat = lastBeat;
+        // The capture waits for the GUI thread, which mustn't be kept from its settings
+        lock.unlock();
+        auto backtrace = generateBacktrace( m_guiThread, CaptureTimeout );
+        vlmcWarning() << "The interface has been unresponsive for" << stalled << "ms, in:\n   "
+                      << qPrintable( backtrace.join( "\n    " ) );
+        lock.lock();
+    }
+}
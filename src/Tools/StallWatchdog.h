@@ -0,0 +1,82 @@
+/*****************************************************************************
+ * StallWatchdog.h: Reports the stalls of the GUI thread's event loop
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef STALLWATCHDOG_H
+#define STALLWATCHDOG_H
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Tools
+{
+/**
+ *  \brief  Logs what the GUI thread is doing when its event loop stops processing
+ *          events for longer than a threshold.
+ *
+ *  The GUI thread checks in from a timer. When it doesn't for threshold milliseconds,
+ *  the watchdog thread logs its backtrace, once per stall. The GUI thread then logs
+ *  how long the stall lasted when it gets back to its event loop.
+ */
+class StallWatchdog
+{
+    public:
+        // How often the GUI thread checks in, in milliseconds
+        static const int    HeartbeatInterval = 100;
+        // How long the GUI thread is given to record its backtrace
+        static const int    CaptureTimeout = 500;
+
+        /**
+         *  \brief  Must be created from the GUI thread. Disabled until a threshold is set.
+         */
+        StallWatchdog();
+        ~StallWatchdog();
+
+        /**
+         *  \brief  Sets the stall duration to report, in milliseconds. 0 disables it.
+         */
+        void            setThreshold( int threshold );
+
+    private:
+        void            heartbeat();
+        // Runs on the watchdog thread
+        void            watch();
+
+    private:
+        Qt::HANDLE              m_guiThread;
+        QTimer                  m_heartbeat;
+        QElapsedTimer           m_clock;
+        std::atomic<qint64>     m_lastBeat;
+        std::atomic<int>        m_threshold;
+
+        std::mutex              m_mutex;
+        std::condition_variable m_cond;
+        bool                    m_stop;
+        std::thread             m_watcher;
+};
+}
+
+#endif // STALLWATCHDOG_H
@@ -0,0 +1,259 @@
+/*****************************************************************************
+ * ThreadRole.cpp: OS scheduling of the application's threads, by what they do
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ThreadRole.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QMutex>
+#include <QStringList>
+
+#include <algorithm>
+#include <atomic>
+
+#if defined( Q_OS_LINUX )
+# include <pthread.h>
+# include <sched.h>
+# include <sys/resource.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#elif defined( Q_OS_WIN )
+# include <windows.h>
+#elif defined( Q_OS_UNIX )
+# include <pthread.h>
+# include <sched.h>
+#endif
+
+using namespace Tools;
+
+namespace
+{
+    const char* const   RoleNames[] = { "GUI", "audio", "preview", "export", "job", "background" };
+
+    struct Policy
+    {
+        ThreadRole::Priority    priority;
+        QList<int>              cores;
+    };
+
+    QMutex      policiesMutex;
+    Policy      policies[ThreadRole::NbRoles] = {
+        { ThreadRole::Normal, {} },
+        { ThreadRole::Highest, {} },
+        { ThreadRole::High, {} },
+        { ThreadRole::Normal, {} },
+        { ThreadRole::Normal, {} },
+        { ThreadRole::Low, {} },
+    };
+    // The policies the system refused, which were logged already
+    std::atomic<bool>   warned[ThreadRole::NbRoles];
+    std::atomic<unsigned int>   policiesVersion( 1 );
+
+#if defined( Q_OS_LINUX )
+    // What the process was started with, such as a taskset restriction. The threads
+    // which run anywhere get it back, instead of the cores of the thread which
+    // created them.
+    const cpu_set_t&
+    initialCores()
+    {
+        static const cpu_set_t set = []
+        {
+            cpu_set_t s;
+            CPU_ZERO( &s );
+            if ( sched_getaffinity( getpid(), sizeof( s ), &s ) != 0 )
+            {
+                for ( int i = 0; i < CPU_SETSIZE; ++i )
+                    CPU_SET( i, &s );
+            }
+            return s;
+        }();
+        return set;
+    }
+
+    bool
+    applyPriority( ThreadRole::Priority priority )
+    {
+        // Linux threads each have their own nice value
+        static const int    nice[] = { 19, 15, 5, 0, -5, -10, -15 };
+        sched_param param = {};
+        if ( priority == ThreadRole::TimeCritical )
+        {
+            param.sched_priority = sched_get_priority_min( SCHED_RR );
+            if ( pthread_setschedparam( pthread_self(), SCHED_RR, &param ) == 0 )
+                return true;
+            // Without a real time budget, as high as a nice value goes
+            param.sched_priority = 0;
+        }
+        else if ( priority == ThreadRole::Idle &&
+                  pthread_setschedparam( pthread_self(), SCHED_IDLE, &param ) == 0 )
+            return true;
+        return setpriority( PRIO_PROCESS, (id_t)syscall( SYS_gettid ), nice[priority] ) == 0;
+    }
+
+    bool
+    applyCores( const QList<int>& cores )
+    {
+        if ( cores.isEmpty() == true )
+            return pthread_setaffinity_np( pthread_self(), sizeof( cpu_set_t ), &initialCores() ) == 0;
+        cpu_set_t set;
+        CPU_ZERO( &set );
+        for ( auto core : cores )
+        {
+            if ( core < CPU_SETSIZE )
+                CPU_SET( core, &set );
+        }
+        return pthread_setaffinity_np( pthread_self(), sizeof( set ), &set ) == 0;
+    }
+#elif defined( Q_OS_WIN )
+    bool
+    applyPriority( ThreadRole::Priority priority )
+    {
+        static const int    priorities[] = { THREAD_PRIORITY_IDLE, THREAD_PRIORITY_LOWEST,
+                                             THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL,
+                                             THREAD_PRIORITY_ABOVE_NORMAL, THREAD_PRIORITY_HIGHEST,
+                                             THREAD_PRIORITY_TIME_CRITICAL };
+        return SetThreadPriority( GetCurrentThread(), priorities[priority] ) != 0;
+    }
+
+    bool
+    applyCores( const QList<int>& cores )
+    {
+        DWORD_PTR   process;
+        DWORD_PTR   system;
+        if ( GetProcessAffinityMask( GetCurrentProcess(), &process, &system ) == 0 )
+            return false;
+        DWORD_PTR   mask = 0;
+        for ( auto core : cores )
+        {
+            if ( core < (int)sizeof( mask ) * 8 )
+                mask |= (DWORD_PTR)1 << core;
+        }
+        return SetThreadAffinityMask( GetCurrentThread(), cores.isEmpty() == true ? process : mask ) != 0;
+    }
+#elif defined( Q_OS_UNIX )
+    bool
+    applyPriority( ThreadRole::Priority priority )
+    {
+        int policy = priority == ThreadRole::TimeCritical ? SCHED_RR : SCHED_OTHER;
+        auto min = sched_get_priority_min( policy );
+        auto max = sched_get_priority_max( policy );
+        sched_param param = {};
+        param.sched_priority = priority == ThreadRole::TimeCritical ? max :
+                min + ( max - min ) * priority / ( ThreadRole::TimeCritical - 1 );
+        return pthread_setschedparam( pthread_self(), policy, &param ) == 0;
+    }
+
+    // Threads can't be bound to cores here, they can only be given affinity hints
+    bool
+    applyCores( const QList<int>& cores )
+    {
+        return cores.isEmpty() == true;
+    }
+#else
+    bool
+    applyPriority( ThreadRole::Priority priority )
+    {
+        return priority == ThreadRole::Normal;
+    }
+
+    bool
+    applyCores( const QList<int>& cores )
+    {
+        return cores.isEmpty() == true;
+    }
+#endif
+}
+
+void
+ThreadRole::setPolicy( Role role, Priority priority, const QList<int>& cores )
+{
+#if defined( Q_OS_LINUX )
+    // Before any thread gets bound to some cores
+    initialCores();
+#endif
+    QMutexLocker    lock( &policiesMutex );
+    policies[role] = Policy{ priority, cores };
+    warned[role] = false;
+    // Skips 0 on overflow, so that it can mean "never applied"
+    if ( ++policiesVersion == 0 )
+        ++policiesVersion;
+}
+
+unsigned int
+ThreadRole::version()
+{
+    return policiesVersion;
+}
+
+ThreadRole::Priority
+ThreadRole::priority( Role role )
+{
+    QMutexLocker    lock( &policiesMutex );
+    return policies[role].priority;
+}
+
+QList<int>
+ThreadRole::cores( Role role )
+{
+    QMutexLocker    lock( &policiesMutex );
+    return policies[role].cores;
+}
+
+void
+ThreadRole::apply( Role role )
+{
+    Policy  policy;
+    {
+        QMutexLocker    lock( &policiesMutex );
+        policy = policies[role];
+    }
+    auto prioritySet = applyPriority( policy.priority );
+    auto coresSet = applyCores( policy.cores );
+    if ( ( prioritySet == false || coresSet == false ) && warned[role].exchange( true ) == false )
+    {
+        vlmcWarning() << "The system refused the" << ( prioritySet == false ? "priority" : "cores" )
+                      << "of the" << RoleNames[role] << "threads, which keep their current scheduling";
+    }
+}
+
+QList<int>
+ThreadRole::parseCores( const QString& cores )
+{
+    QList<int>  res;
+    for ( const auto& part : cores.split( ',', QString::SkipEmptyParts ) )
+    {
+        auto range = part.trimmed().split( '-' );
+        bool firstOk = false;
+        bool lastOk = false;
+        auto first = range.first().toInt( &firstOk );
+        auto last = range.size() == 2 ? range.last().toInt( &lastOk ) : first;
+        if ( firstOk == false || ( range.size() == 2 && lastOk == false ) || range.size() > 2 ||
+             first < 0 || last < first )
+            continue;
+        for ( auto core = first; core <= last; ++core )
+        {
+            if ( res.contains( core ) == false )
+                res << core;
+        }
+    }
+    std::sort( res.begin(), res.end() );
+    return res;
+}
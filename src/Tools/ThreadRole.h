@@ -0,0 +1,91 @@
+/*****************************************************************************
+ * ThreadRole.h: OS scheduling of the application's threads, by what they do
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef THREADROLE_H
+#define THREADROLE_H
+
+#include <QList>
+#include <QString>
+
+namespace Tools
+{
+namespace ThreadRole
+{
+    enum    Role
+    {
+        // The Qt event loop
+        Gui,
+        // The rendering threads of the preview which feeds the sound card
+        Audio,
+        // The rendering threads of the other previews
+        Preview,
+        // The rendering threads of the exports and benchmarks
+        Export,
+        // The job scheduler threads running Visible and Interactive jobs
+        Jobs,
+        // The job scheduler threads running Background jobs
+        Background,
+        NbRoles
+    };
+
+    // As QThread::Priority, for the threads Qt didn't start
+    enum    Priority
+    {
+        Idle,
+        Lowest,
+        Low,
+        Normal,
+        High,
+        Highest,
+        // Real time scheduling, when the system allows it
+        TimeCritical,
+        NbPriorities
+    };
+
+    /**
+     *  \brief  Sets the priority and the cores of the threads which take role afterward.
+     *
+     *  An empty cores list lets them run on any core. This is thread safe.
+     */
+    void            setPolicy( Role role, Priority priority, const QList<int>& cores );
+    Priority        priority( Role role );
+    QList<int>      cores( Role role );
+    // Changes with every setPolicy() call, and is never 0
+    unsigned int    version();
+
+    /**
+     *  \brief  Applies the policy of role to the calling thread.
+     *
+     *  Meant to be called when the thread starts, and after the policies changed. An
+     *  unprivileged thread can lower its priority, but usually not raise it back. A policy the system refuses
+     *  is logged once per role, and the thread keeps its current scheduling.
+     */
+    void            apply( Role role );
+
+    /**
+     *  \brief  Parses a list of cores such as "0-3,6". Invalid parts are skipped.
+     */
+    QList<int>      parseCores( const QString& cores );
+}
+}
+
+#endif // THREADROLE_H
@@ -0,0 +1,116 @@
+/*****************************************************************************
+ * Title.cpp: Text and style of a title clip
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "Title.h"
+
+#include <QColor>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+const char* const   Tools::Title::Extension = ".vlmctitle";
+
+Tools::Title::Title()
+    : fontFamily( "Sans" )
+    , size( 0.08 )
+    , bold( false )
+    , italic( false )
+    , colour( qRgba( 255, 255, 255, 255 ) )
+    , x( 0.5 )
+    , y( 0.85 )
+{
+}
+
+bool
+Tools::Title::isTitle( const QString& path )
+{
+    return path.endsWith( Extension, Qt::CaseInsensitive );
+}
+
+bool
+Tools::Title::load( const QString& path, Title& title )
+{
+    QFile   file( path );
+    if ( file.open( QIODevice::ReadOnly ) == false )
+        return false;
+    auto doc = QJsonDocument::fromJson( file.readAll() );
+    if ( doc.isObject() == false )
+        return false;
+    auto obj = doc.object();
+    Title t;
+    t.text = obj["text"].toString();
+    t.fontFamily = obj["font"].toString( t.fontFamily );
+    t.size = obj["size"].toDouble( t.size );
+    t.bold = obj["bold"].toBool( t.bold );
+    t.italic = obj["italic"].toBool( t.italic );
+    QColor colour( obj["colour"].toString() );
+    if ( colour.isValid() == true )
+        t.colour = colour.rgba();
+    t.x = obj["x"].toDouble( t.x );
+    t.y = obj["y"].toDouble( t.y );
+    if ( t.size <= 0. )
+        return false;
+    title = t;
+    return true;
+}
+
+bool
+Tools::Title::save( const QString& path ) const
+{
+    QJsonObject obj;
+    obj["text"] = text;
+    obj["font"] = fontFamily;
+    obj["size"] = size;
+    obj["bold"] = bold;
+    obj["italic"] = italic;
+    obj["colour"] = QColor::fromRgba( colour ).name( QColor::HexArgb );
+    obj["x"] = x;
+    obj["y"] = y;
+    auto partPath = path + ".part";
+    QFile   file( partPath );
+    if ( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) == false )
+        return false;
+    auto data = QJsonDocument( obj ).toJson();
+    if ( file.write( data ) != data.size() || file.flush() == false )
+    {
+        file.close();
+        QFile::remove( partPath );
+        return false;
+    }
+    file.close();
+    QFile::remove( path );
+    return QFile::rename( partPath, path );
+}
+
+bool
+Tools::Title::operator==( const Title& other ) const
+{
+    return text == other.text && fontFamily == other.fontFamily && size == other.size &&
+            bold == other.bold && italic == other.italic && colour == other.colour &&
+            x == other.x && y == other.y;
+}
+
+bool
+Tools::Title::operator!=( const Title& other ) const
+{
+    return ( *this == other ) == false;
+}
@@ -0,0 +1,70 @@
+/*****************************************************************************
+ * Title.h: Text and style of a title clip
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef TITLE_H
+#define TITLE_H
+
+#include <QRgb>
+#include <QString>
+
+namespace Tools
+{
+    /**
+     *  \brief  The text of a title clip, and how it's drawn.
+     *
+     *  Titles are stored as small JSON files, which are imported as any other media:
+     *  the backend renders them through its own producer. \sa Backend::MLT::MLTTitle
+     *  Sizes and positions are relative to the frame, so that a title looks the same
+     *  at any resolution, proxies and previews included.
+     */
+    struct Title
+    {
+        static const char* const    Extension;
+
+        Title();
+
+        static bool     isTitle( const QString& path );
+        /**
+         *  \brief  Reads a title file. Returns false if it can't be parsed.
+         */
+        static bool     load( const QString& path, Title& title );
+        // Written next to the file first, so that a reader never gets half of it
+        bool            save( const QString& path ) const;
+
+        bool            operator==( const Title& other ) const;
+        bool            operator!=( const Title& other ) const;
+
+        // Lines are separated by '\n'
+        QString         text;
+        QString         fontFamily;
+        // The height of the font, relative to the frame height
+        double          size;
+        bool            bold;
+        bool            italic;
+        QRgb            colour;
+        // Where the centre of the text lays, relative to the frame
+        double          x;
+        double          y;
+    };
+}
+
+#endif // TITLE_H
@@ -0,0 +1,143 @@
+/*****************************************************************************
+ * Trace.cpp: Binary trace of the render and playback events
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "Trace.h"
+
+#include <QFile>
+#include <QString>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+std::atomic<bool>   Tools::Trace::enabled( false );
+
+namespace
+{
+    const char* const   EventNames[] = { "frame requested", "frame decoded", "frame displayed",
+                                         "frame encoded",
+                                         "seek issued", "seek completed", "clip boundary",
+                                         "render started" };
+    static_assert( sizeof( EventNames ) / sizeof( *EventNames ) == Tools::Trace::NbEvents,
+                   "An event is missing a name" );
+    // The binary file starts with this, followed by the records
+    const char                      Magic[8] = { 'V', 'L', 'M', 'C', 'T', 'R', 'C', '1' };
+
+    QString                             filePath;
+    std::vector<Tools::Trace::Record>   records;
+    std::atomic<uint32_t>               nbRecords( 0 );
+    std::atomic<uint64_t>               nbDropped( 0 );
+    std::chrono::steady_clock::time_point   origin;
+
+    uint32_t
+    threadId()
+    {
+        // Small and stable ids read better in the trace viewers than the native ones
+        static std::atomic<uint32_t>    next( 1 );
+        thread_local uint32_t           id = next++;
+        return id;
+    }
+
+    void
+    writeChromeTrace( const QString& path, uint32_t count )
+    {
+        FILE* f = fopen( QFile::encodeName( path ).constData(), "w" );
+        if ( f == nullptr )
+            return;
+        fputs( "{\"traceEvents\":[\n", f );
+        // One row per source, numbered in order of appearance. The events which don't
+        // have one go on their thread's row.
+        std::unordered_map<uint64_t, uint32_t>  rows;
+        for ( uint32_t i = 0; i < count; ++i )
+        {
+            const auto& r = records[i];
+            uint32_t row = r.thread;
+            if ( r.source != 0 )
+                row = rows.emplace( r.source, 1000 + rows.size() ).first->second;
+            fprintf( f, "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,"
+                        "\"tid\":%u,\"args\":{\"arg\":%lld,\"source\":\"0x%llx\",\"thread\":%u}}\n",
+                     i > 0 ? "," : "", EventNames[r.event], r.timestamp / 1000.0,
+                     row,
+                     static_cast<long long>( r.arg ), static_cast<unsigned long long>( r.source ),
+                     r.thread );
+        }
+        fprintf( f, "],\"otherData\":{\"dropped\":%llu}}\n",
+                 static_cast<unsigned long long>( nbDropped.load() ) );
+        fclose( f );
+    }
+}
+
+bool
+Tools::Trace::start( const QString& path, uint32_t capacity )
+{
+    if ( enabled == true || capacity == 0 )
+        return false;
+    filePath = path;
+    records.resize( capacity );
+    nbRecords = 0;
+    nbDropped = 0;
+    origin = std::chrono::steady_clock::now();
+    enabled = true;
+    return true;
+}
+
+void
+Tools::Trace::stop()
+{
+    if ( enabled.exchange( false ) == false )
+        return;
+    // Lets the threads which were recording finish copying their event
+    std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    auto count = std::min<uint32_t>( nbRecords, records.size() );
+
+    FILE* f = fopen( QFile::encodeName( filePath ).constData(), "wb" );
+    if ( f != nullptr )
+    {
+        fwrite( Magic, sizeof( Magic ), 1, f );
+        fwrite( records.data(), sizeof( Record ), count, f );
+        fclose( f );
+    }
+    writeChromeTrace( filePath + ".json", count );
+    records.clear();
+    records.shrink_to_fit();
+}
+
+void
+Tools::Trace::record( Event event, int64_t arg, const void* source )
+{
+    auto i = nbRecords.fetch_add( 1, std::memory_order_relaxed );
+    if ( i >= records.size() )
+    {
+        nbDropped.fetch_add( 1, std::memory_order_relaxed );
+        return;
+    }
+    auto& r = records[i];
+    r.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - origin ).count();
+    r.arg = arg;
+    r.source = reinterpret_cast<uintptr_t>( source );
+    r.thread = threadId();
+    r.event = event;
+}
@@ -0,0 +1,87 @@
+/*****************************************************************************
+ * Trace.h: Binary trace of the render and playback events
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+
+class   QString;
+
+namespace Tools
+{
+/**
+ *  \brief  Opt-in trace of timestamped, fixed size events, enabled with --trace=<file>.
+ *
+ *  Recording an event is a relaxed load when tracing is off, and an atomic increment
+ *  plus a copy in a preallocated buffer when it's on: this can be called from the
+ *  render threads. Once the buffer is full, the events are counted and dropped.
+ *  On stop(), the events are written to the file in their binary form, and to
+ *  <file>.json in the Chrome trace format, which chrome://tracing and Perfetto open.
+ */
+namespace Trace
+{
+    enum    Event : uint8_t
+    {
+        FrameRequested,
+        FrameDecoded,
+        FrameDisplayed,
+        FrameEncoded,
+        SeekIssued,
+        SeekCompleted,
+        ClipBoundary,
+        RenderStarted,
+        NbEvents
+    };
+
+    struct  Record
+    {
+        // Nanoseconds, from a monotonic clock
+        int64_t         timestamp;
+        // A frame position, most of the time
+        int64_t         arg;
+        // Identifies the object the event happened on: the events of a given source
+        // are shown on a row of their own
+        uint64_t        source;
+        uint32_t        thread;
+        Event           event;
+        uint8_t         padding[3];
+    };
+
+    extern std::atomic<bool>    enabled;
+
+    // Preallocates room for capacity events, then starts recording
+    bool        start( const QString& filePath, uint32_t capacity = 1 << 20 );
+    void        stop();
+    void        record( Event event, int64_t arg, const void* source );
+
+    inline void
+    add( Event event, int64_t arg = 0, const void* source = nullptr )
+    {
+        if ( enabled.load( std::memory_order_relaxed ) == true )
+            record( event, arg, source );
+    }
+}
+}
+
+#endif // TRACE_H
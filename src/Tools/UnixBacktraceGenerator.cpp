@@ -30,41 +30,102 @@
 #include <cxxabi.h>
 #include <stdlib.h> //free()
 
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <mutex>
+
+#include <QObject>
 #include <QStringList>
 
-QStringList
-Tools::generateBacktrace( int levelsToSkip )
+namespace
 {
-    void    *buff[backtraceSize];
-    QStringList res;
+    // Filled by the handler, from the interrupted thread
+    void*               capturedFrames[Tools::backtraceSize];
+    std::atomic<int>    nbCapturedFrames( -1 );
 
-    int     nbSymb = backtrace( buff, backtraceSize );
-    char**  backtraceStr = backtrace_symbols( buff, nbSymb );
-    char*   symbName;
-    char*   mangledName;
-    int     status;
-    int     pos;
-    for ( int i = levelsToSkip; i < nbSymb; ++i )
+    void
+    captureHandler( int )
     {
-        mangledName = strchr( backtraceStr[i], '(' );
-        char* endPos = strchr( mangledName, '+' );
-        if ( endPos != NULL && endPos != NULL )
+        nbCapturedFrames.store( backtrace( capturedFrames, Tools::backtraceSize ),
+                                std::memory_order_release );
+    }
+
+    QStringList
+    symbolize( void** buff, int nbSymb, int levelsToSkip )
+    {
+        QStringList res;
+        char**  backtraceStr = backtrace_symbols( buff, nbSymb );
+        char*   symbName;
+        char*   mangledName;
+        int     status;
+        int     pos;
+        for ( int i = levelsToSkip; i < nbSymb; ++i )
         {
-            pos = endPos - mangledName;
-            char *copy = strdup( mangledName + 1 );  //Skipping the parenthesis
-            copy[pos - 1] = 0;
-            symbName = abi::__cxa_demangle( copy, NULL, 0, &status);
-            if ( status == 0 )
+            mangledName = strchr( backtraceStr[i], '(' );
+            char* endPos = strchr( mangledName, '+' );
+            if ( endPos != NULL && endPos != NULL )
             {
-                res.append( QString( symbName ) );
-                free( symbName );
-                continue ;
+                pos = endPos - mangledName;
+                char *copy = strdup( mangledName + 1 );  //Skipping the parenthesis
+                copy[pos - 1] = 0;
+                symbName = abi::__cxa_demangle( copy, NULL, 0, &status);
+                if ( status == 0 )
+                {
+                    res.append( QString( symbName ) );
+                    free( symbName );
+                    continue ;
+                }
+                free(symbName);
+                free(copy);
             }
-            free(symbName);
-            free(copy);
+            res.append( backtraceStr[i] );
         }
-        res.append( backtraceStr[i] );
+        free(backtraceStr);
+        return res;
+    }
+}
+
+QStringList
+Tools::generateBacktrace( int levelsToSkip )
+{
+    void    *buff[backtraceSize];
+    int     nbSymb = backtrace( buff, backtraceSize );
+    return symbolize( buff, nbSymb, levelsToSkip );
+}
+
+QStringList
+Tools::generateBacktrace( Qt::HANDLE thread, int timeout )
+{
+    static std::once_flag   installed;
+    static std::mutex       mutex;
+
+    std::call_once( installed, []
+    {
+        // backtrace() loads its unwinder on the first call, which can't happen
+        // from a signal handler
+        void* frame;
+        backtrace( &frame, 1 );
+        struct sigaction action = {};
+        action.sa_handler = captureHandler;
+        action.sa_flags = SA_RESTART;
+        sigemptyset( &action.sa_mask );
+        sigaction( SIGUSR2, &action, nullptr );
+    } );
+
+    std::lock_guard<std::mutex> lock( mutex );
+    nbCapturedFrames.store( -1, std::memory_order_relaxed );
+    auto failed = QStringList() << QObject::tr( "Unable to get backtrace" );
+    if ( pthread_kill( reinterpret_cast<pthread_t>( thread ), SIGUSR2 ) != 0 )
+        return failed;
+    for ( int waited = 0; nbCapturedFrames.load( std::memory_order_acquire ) < 0; ++waited )
+    {
+        if ( waited >= timeout )
+            return failed;
+        usleep( 1000 );
     }
-    free(backtraceStr);
-    return res;
+    // Skipping the handler and the signal trampoline
+    return symbolize( capturedFrames, nbCapturedFrames.load( std::memory_order_acquire ), 2 );
 }
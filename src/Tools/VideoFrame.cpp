@@ -0,0 +1,39 @@
+/*****************************************************************************
+ * VideoFrame.cpp: Qt helpers for backend video frames
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "VideoFrame.h"
+
+#include "Backend/IInput.h"
+
+QImage
+Tools::toQImage( std::shared_ptr<Backend::IVideoFrame> frame )
+{
+    if ( frame == nullptr )
+        return QImage();
+    Q_ASSERT( frame->format() == Backend::IVideoFrame::RGBA );
+    auto ref = new std::shared_ptr<Backend::IVideoFrame>( std::move( frame ) );
+    return QImage( (*ref)->data(), (*ref)->width(), (*ref)->height(), (*ref)->stride(),
+                   QImage::Format_RGBA8888, []( void* ref )
+    {
+        delete static_cast<std::shared_ptr<Backend::IVideoFrame>*>( ref );
+    }, ref );
+}
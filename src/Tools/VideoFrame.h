@@ -0,0 +1,46 @@
+/*****************************************************************************
+ * VideoFrame.h: Qt helpers for backend video frames
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Yikei Lu <luyikei.qmltu@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VIDEOFRAME_H
+#define VIDEOFRAME_H
+
+#include <memory>
+
+#include <QImage>
+
+namespace Backend
+{
+class IVideoFrame;
+}
+
+namespace Tools
+{
+    /**
+     *  \brief  Wraps a frame in a QImage, without copying its buffer.
+     *
+     *  The returned image holds a reference to the frame, which is released along with
+     *  the last copy of the image. Returns a null image if frame is nullptr.
+     */
+    QImage      toQImage( std::shared_ptr<Backend::IVideoFrame> frame );
+}
+
+#endif // VIDEOFRAME_H
@@ -0,0 +1,251 @@
+/*****************************************************************************
+ * VideoScopes.cpp: Waveform, vectorscope and histogram of video frames
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "VideoScopes.h"
+#include "Backend/IInput.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined( __SSE2__ )
+# include <emmintrin.h>
+#endif
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+# include <arm_neon.h>
+# define HAVE_NEON
+#endif
+
+namespace
+{
+    using ConvertFunction = void (*)( const uint8_t*, const uint8_t*, const uint8_t*, size_t,
+                                      uint8_t*, uint8_t*, uint8_t* );
+
+    // BT.601 limited range, as the OpenGL preview converts the frames, in 1/64th.
+    // The largest sums overflow 16 bits: the vector versions saturate them, which
+    // the clamp to 255 makes harmless.
+    const int   CoefY = 74;
+    const int   CoefRV = 102;
+    const int   CoefGU = 25;
+    const int   CoefGV = 52;
+    const int   CoefBU = 129;
+
+    inline int
+    saturate16( int v )
+    {
+        return std::max( -32768, std::min( 32767, v ) );
+    }
+
+    inline uint8_t
+    toComponent( int v )
+    {
+        // Same operations as the vector versions: a saturated add of the rounding,
+        // then an arithmetic shift and an unsigned saturation
+        return static_cast<uint8_t>( std::max( 0, std::min( 255, saturate16( v + 32 ) >> 6 ) ) );
+    }
+
+    void
+    convert( const uint8_t* y, const uint8_t* u, const uint8_t* v, size_t begin, size_t end,
+             uint8_t* r, uint8_t* g, uint8_t* b )
+    {
+        for ( size_t i = begin; i < end; ++i )
+        {
+            int luma = ( y[i] - 16 ) * CoefY;
+            int cu = u[i / 2] - 128;
+            int cv = v[i / 2] - 128;
+            r[i] = toComponent( saturate16( luma + cv * CoefRV ) );
+            g[i] = toComponent( saturate16( saturate16( luma - cu * CoefGU ) - cv * CoefGV ) );
+            b[i] = toComponent( saturate16( luma + cu * CoefBU ) );
+        }
+    }
+
+#if defined( __SSE2__ )
+    void
+    convertSSE2( const uint8_t* y, const uint8_t* u, const uint8_t* v, size_t count,
+                 uint8_t* r, uint8_t* g, uint8_t* b )
+    {
+        const auto zero = _mm_setzero_si128();
+        const auto c16 = _mm_set1_epi16( 16 );
+        const auto c128 = _mm_set1_epi16( 128 );
+        const auto round = _mm_set1_epi16( 32 );
+        const auto coefY = _mm_set1_epi16( CoefY );
+        const auto coefRV = _mm_set1_epi16( CoefRV );
+        const auto coefGU = _mm_set1_epi16( CoefGU );
+        const auto coefGV = _mm_set1_epi16( CoefGV );
+        const auto coefBU = _mm_set1_epi16( CoefBU );
+        size_t i = 0;
+        for ( ; i + 16 <= count; i += 16 )
+        {
+            auto y8 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( y + i ) );
+            // Each chroma sample covers two pixels
+            auto u8 = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( u + i / 2 ) );
+            auto v8 = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( v + i / 2 ) );
+            u8 = _mm_unpacklo_epi8( u8, u8 );
+            v8 = _mm_unpacklo_epi8( v8, v8 );
+            __m128i out[3][2];
+            for ( int half = 0; half < 2; ++half )
+            {
+                auto luma = half == 0 ? _mm_unpacklo_epi8( y8, zero ) : _mm_unpackhi_epi8( y8, zero );
+                auto cu = half == 0 ? _mm_unpacklo_epi8( u8, zero ) : _mm_unpackhi_epi8( u8, zero );
+                auto cv = half == 0 ? _mm_unpacklo_epi8( v8, zero ) : _mm_unpackhi_epi8( v8, zero );
+                luma = _mm_mullo_epi16( _mm_sub_epi16( luma, c16 ), coefY );
+                cu = _mm_sub_epi16( cu, c128 );
+                cv = _mm_sub_epi16( cv, c128 );
+                auto rr = _mm_adds_epi16( luma, _mm_mullo_epi16( cv, coefRV ) );
+                auto gg = _mm_subs_epi16( _mm_subs_epi16( luma, _mm_mullo_epi16( cu, coefGU ) ),
+                                          _mm_mullo_epi16( cv, coefGV ) );
+                auto bb = _mm_adds_epi16( luma, _mm_mullo_epi16( cu, coefBU ) );
+                out[0][half] = _mm_srai_epi16( _mm_adds_epi16( rr, round ), 6 );
+                out[1][half] = _mm_srai_epi16( _mm_adds_epi16( gg, round ), 6 );
+                out[2][half] = _mm_srai_epi16( _mm_adds_epi16( bb, round ), 6 );
+            }
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( r + i ), _mm_packus_epi16( out[0][0], out[0][1] ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( g + i ), _mm_packus_epi16( out[1][0], out[1][1] ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( b + i ), _mm_packus_epi16( out[2][0], out[2][1] ) );
+        }
+        convert( y, u, v, i, count, r, g, b );
+    }
+#endif
+
+#if defined( HAVE_NEON )
+    void
+    convertNEON( const uint8_t* y, const uint8_t* u, const uint8_t* v, size_t count,
+                 uint8_t* r, uint8_t* g, uint8_t* b )
+    {
+        const auto c16 = vdupq_n_s16( 16 );
+        const auto c128 = vdupq_n_s16( 128 );
+        const auto round = vdupq_n_s16( 32 );
+        size_t i = 0;
+        for ( ; i + 16 <= count; i += 16 )
+        {
+            auto y8 = vld1q_u8( y + i );
+            auto u8 = vld1_u8( u + i / 2 );
+            auto v8 = vld1_u8( v + i / 2 );
+            // Each chroma sample covers two pixels
+            auto u16 = vzip_u8( u8, u8 );
+            auto v16 = vzip_u8( v8, v8 );
+            int16x8_t out[3][2];
+            for ( int half = 0; half < 2; ++half )
+            {
+                auto luma = vreinterpretq_s16_u16( vmovl_u8( half == 0 ? vget_low_u8( y8 ) : vget_high_u8( y8 ) ) );
+                auto cu = vreinterpretq_s16_u16( vmovl_u8( u16.val[half] ) );
+                auto cv = vreinterpretq_s16_u16( vmovl_u8( v16.val[half] ) );
+                luma = vmulq_n_s16( vsubq_s16( luma, c16 ), CoefY );
+                cu = vsubq_s16( cu, c128 );
+                cv = vsubq_s16( cv, c128 );
+                auto rr = vqaddq_s16( luma, vmulq_n_s16( cv, CoefRV ) );
+                auto gg = vqsubq_s16( vqsubq_s16( luma, vmulq_n_s16( cu, CoefGU ) ),
+                                      vmulq_n_s16( cv, CoefGV ) );
+                auto bb = vqaddq_s16( luma, vmulq_n_s16( cu, CoefBU ) );
+                out[0][half] = vshrq_n_s16( vqaddq_s16( rr, round ), 6 );
+                out[1][half] = vshrq_n_s16( vqaddq_s16( gg, round ), 6 );
+                out[2][half] = vshrq_n_s16( vqaddq_s16( bb, round ), 6 );
+            }
+            vst1q_u8( r + i, vcombine_u8( vqmovun_s16( out[0][0] ), vqmovun_s16( out[0][1] ) ) );
+            vst1q_u8( g + i, vcombine_u8( vqmovun_s16( out[1][0] ), vqmovun_s16( out[1][1] ) ) );
+            vst1q_u8( b + i, vcombine_u8( vqmovun_s16( out[2][0] ), vqmovun_s16( out[2][1] ) ) );
+        }
+        convert( y, u, v, i, count, r, g, b );
+    }
+#endif
+
+    ConvertFunction
+    resolve()
+    {
+#if defined( __SSE2__ )
+        return &convertSSE2;
+#elif defined( HAVE_NEON )
+        return &convertNEON;
+#else
+        return &Tools::yuvToRgbRowScalar;
+#endif
+    }
+}
+
+void
+Tools::yuvToRgbRowScalar( const uint8_t* y, const uint8_t* u, const uint8_t* v, size_t count,
+                          uint8_t* r, uint8_t* g, uint8_t* b )
+{
+    convert( y, u, v, 0, count, r, g, b );
+}
+
+void
+Tools::yuvToRgbRow( const uint8_t* y, const uint8_t* u, const uint8_t* v, size_t count,
+                    uint8_t* r, uint8_t* g, uint8_t* b )
+{
+    static const ConvertFunction convert = resolve();
+    convert( y, u, v, count, r, g, b );
+}
+
+bool
+Tools::computeScopes( const Backend::IVideoFrame& frame, uint32_t rowStep, uint32_t maxColumns,
+                      ScopeData& data )
+{
+    if ( frame.format() != Backend::IVideoFrame::YUV420P || frame.width() == 0 || frame.height() == 0 )
+        return false;
+    const auto width = frame.width();
+    const auto height = frame.height();
+    const auto stride = frame.stride();
+    const auto chromaStride = ( stride + 1 ) / 2;
+    const auto planeY = frame.data();
+    const auto planeU = planeY + stride * height;
+    const auto planeV = planeU + chromaStride * ( ( height + 1 ) / 2 );
+    rowStep = std::max( 1u, rowStep );
+
+    data.columns = std::max( 1u, std::min( width, maxColumns ) );
+    data.waveform.assign( data.columns * ScopeData::Levels, 0 );
+    data.vectorscope.assign( ScopeData::Levels * ScopeData::Levels, 0 );
+    memset( data.histogram, 0, sizeof( data.histogram ) );
+    data.samples = 0;
+
+    // The waveform column of each pixel
+    std::vector<uint32_t> columnOffsets( width );
+    for ( uint32_t x = 0; x < width; ++x )
+        columnOffsets[x] = static_cast<uint64_t>( x ) * data.columns / width * ScopeData::Levels;
+
+    std::vector<uint8_t> rgb( width * 3 );
+    auto r = rgb.data();
+    auto g = r + width;
+    auto b = g + width;
+    const auto chromaWidth = ( width + 1 ) / 2;
+    for ( uint32_t row = 0; row < height; row += rowStep )
+    {
+        auto y = planeY + row * stride;
+        auto u = planeU + ( row / 2 ) * chromaStride;
+        auto v = planeV + ( row / 2 ) * chromaStride;
+        yuvToRgbRow( y, u, v, width, r, g, b );
+        for ( uint32_t x = 0; x < width; ++x )
+        {
+            ++data.waveform[columnOffsets[x] + y[x]];
+            ++data.histogram[0][r[x]];
+            ++data.histogram[1][g[x]];
+            ++data.histogram[2][b[x]];
+        }
+        // Chroma lines are shared by two luma lines, count each of them once
+        if ( rowStep > 1 || row % 2 == 0 )
+        {
+            for ( uint32_t x = 0; x < chromaWidth; ++x )
+                ++data.vectorscope[v[x] * ScopeData::Levels + u[x]];
+        }
+        data.samples += width;
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * VideoScopes.h: Waveform, vectorscope and histogram of video frames
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VIDEOSCOPES_H
+#define VIDEOSCOPES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Backend
+{
+    class IVideoFrame;
+}
+
+namespace Tools
+{
+    struct ScopeData
+    {
+        static const uint32_t   Levels = 256;
+
+        // Number of luma samples in each of the Levels rows of a waveform column,
+        // column major: waveform[column * Levels + level]
+        std::vector<uint32_t>   waveform;
+        uint32_t                columns = 0;
+        // Number of chroma samples of each value: vectorscope[v * Levels + u]
+        std::vector<uint32_t>   vectorscope;
+        // Number of pixels of each value, for the red, green and blue components
+        uint32_t                histogram[3][Levels];
+        // Number of pixels analyzed
+        uint32_t                samples = 0;
+    };
+
+    /**
+     *  \brief  Computes the scopes of a YUV420P frame.
+     *
+     *  Only one line out of rowStep is analyzed. The waveform is reduced to at most
+     *  maxColumns columns. The conversion to RGB is vectorized (SSE2 or NEON), the
+     *  counting is not, but the cost of both scales with the lines analyzed.
+     *  Returns false when the frame isn't YUV420P.
+     */
+    bool    computeScopes( const Backend::IVideoFrame& frame, uint32_t rowStep, uint32_t maxColumns,
+                           ScopeData& data );
+
+    /**
+     *  \brief  Converts count pixels of a YUV420P line to planar RGB, using the
+     *          BT.601 limited range coefficients.
+     *
+     *  u and v hold ( count + 1 ) / 2 samples.
+     */
+    void    yuvToRgbRow( const uint8_t* y, const uint8_t* u, const uint8_t* v, size_t count,
+                         uint8_t* r, uint8_t* g, uint8_t* b );
+
+    /**
+     *  \brief  Scalar reference implementation of yuvToRgbRow, with identical results
+     */
+    void    yuvToRgbRowScalar( const uint8_t* y, const uint8_t* u, const uint8_t* v, size_t count,
+                               uint8_t* r, uint8_t* g, uint8_t* b );
+}
+
+#endif // VIDEOSCOPES_H
@@ -27,17 +27,28 @@
 #include <QThread>
 #include <QTime>
 
+#include <atomic>
+
+// Maintained by VlmcLogger: false when the debug messages would be dropped anyway
+extern std::atomic<bool>    vlmcDebugEnabled;
+
 inline QDebug operator<<( QDebug& qdbg, const std::string& str )
 {
     qdbg << str.c_str();
     return qdbg;
 }
 
-inline QDebug vlmcDebug()
+inline QDebug vlmcDebugStream()
 {
     return (qDebug().nospace() << '[' << qPrintable(QTime::currentTime().toString("hh:mm:ss.zzz")) << "] T #" << QThread::currentThreadId() << " D:").space();
 }
 
+// Like qCDebug(), the streamed expression isn't even evaluated when debug logging is off
+#define vlmcDebug() \
+    for ( bool vlmcDebugOn = vlmcDebugEnabled.load( std::memory_order_relaxed ); \
+          vlmcDebugOn == true; vlmcDebugOn = false ) \
+        vlmcDebugStream()
+
 inline QDebug vlmcWarning()
 {
     return (qWarning().nospace() << '[' << qPrintable(QTime::currentTime().toString("hh:mm:ss.zzz")) << "] T #" << QThread::currentThreadId() << " W:").space();
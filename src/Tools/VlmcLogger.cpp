@@ -26,6 +26,7 @@
 #endif
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QStringList>
 #include <QThread>
 
@@ -33,10 +34,166 @@
 #include "Settings/Settings.h"
 #include "Tools/VlmcLogger.h"
 #include "Tools/VlmcDebug.h"
+#include "Tools/Metrics.h"
+#include "Tools/Trace.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+std::atomic<bool>   vlmcDebugEnabled( true );
+
+/**
+ *  \brief  Writes the log messages from a thread of its own.
+ *
+ *  The messages are copied in a fixed size ring, which any number of threads fill
+ *  without taking a lock (this is Dmitry Vyukov's bounded queue, each slot carries a
+ *  sequence number telling whether it's free). When the ring is full, the message is
+ *  dropped and counted instead of blocking the thread logging it, and the writer
+ *  reports the drops once it catches up.
+ */
+class AsyncLogWriter
+{
+    public:
+        static const size_t     NbRecords = 4096;
+        // Longer messages are truncated
+        static const size_t     RecordSize = 512;
+
+        AsyncLogWriter( FILE* logFile, FILE* console )
+            : m_logFile( logFile )
+            , m_console( console )
+            , m_head( 0 )
+            , m_tail( 0 )
+            , m_dropped( 0 )
+            , m_reportedDrops( 0 )
+            , m_stop( false )
+        {
+            for ( size_t i = 0; i < NbRecords; ++i )
+                m_records[i].sequence.store( i, std::memory_order_relaxed );
+            m_thread = std::thread( [this] { run(); } );
+        }
+
+        ~AsyncLogWriter()
+        {
+            m_stop = true;
+            m_thread.join();
+        }
+
+        void push( int level, bool toConsole, const char* msg )
+        {
+            auto pos = m_tail.load( std::memory_order_relaxed );
+            Record* record;
+            for ( ;; )
+            {
+                record = &m_records[pos % NbRecords];
+                auto seq = record->sequence.load( std::memory_order_acquire );
+                auto diff = static_cast<intptr_t>( seq ) - static_cast<intptr_t>( pos );
+                if ( diff == 0 )
+                {
+                    if ( m_tail.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) == true )
+                        break;
+                }
+                else if ( diff < 0 )
+                {
+                    m_dropped.fetch_add( 1, std::memory_order_relaxed );
+                    return;
+                }
+                else
+                    pos = m_tail.load( std::memory_order_relaxed );
+            }
+            record->level = level;
+            record->toConsole = toConsole;
+            strncpy( record->msg, msg, RecordSize - 1 );
+            record->msg[RecordSize - 1] = 0;
+            record->sequence.store( pos + 1, std::memory_order_release );
+        }
+
+        quint64 dropped() const
+        {
+            return m_dropped.load( std::memory_order_relaxed );
+        }
+
+    private:
+        struct Record
+        {
+            std::atomic<size_t>     sequence;
+            int                     level;
+            bool                    toConsole;
+            char                    msg[RecordSize];
+        };
+
+        // Returns false if the ring was empty
+        bool drain()
+        {
+            bool any = false;
+            for ( ;; )
+            {
+                auto& record = m_records[m_head % NbRecords];
+                if ( record.sequence.load( std::memory_order_acquire ) != m_head + 1 )
+                    break;
+                if ( m_logFile != nullptr )
+                {
+                    fputs( record.msg, m_logFile );
+                    fputc( '\n', m_logFile );
+                }
+                if ( record.toConsole == true )
+                    fprintf( record.level >= QtCriticalMsg ? stderr : m_console, "%s\n", record.msg );
+                record.sequence.store( m_head + NbRecords, std::memory_order_release );
+                ++m_head;
+                any = true;
+            }
+            auto dropped = m_dropped.load( std::memory_order_relaxed );
+            if ( dropped != m_reportedDrops )
+            {
+                char msg[64];
+                snprintf( msg, sizeof( msg ), "[Logger] %llu messages dropped",
+                          static_cast<unsigned long long>( dropped - m_reportedDrops ) );
+                if ( m_logFile != nullptr )
+                {
+                    fputs( msg, m_logFile );
+                    fputc( '\n', m_logFile );
+                }
+                fprintf( m_console, "%s\n", msg );
+                m_reportedDrops = dropped;
+            }
+            if ( any == true )
+            {
+                if ( m_logFile != nullptr )
+                    fflush( m_logFile );
+                fflush( m_console );
+            }
+            return any;
+        }
+
+        void run()
+        {
+            while ( m_stop == false )
+            {
+                if ( drain() == false )
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+            }
+            drain();
+        }
+
+    private:
+        FILE*                   m_logFile;
+        FILE*                   m_console;
+        Record                  m_records[NbRecords];
+        // Only read and written by the writer thread
+        size_t                  m_head;
+        std::atomic<size_t>     m_tail;
+        std::atomic<quint64>    m_dropped;
+        quint64                 m_reportedDrops;
+        std::atomic<bool>       m_stop;
+        std::thread             m_thread;
+};
 
 VlmcLogger::VlmcLogger()
     : m_logFile( nullptr )
+    , m_console( stdout )
+    , m_currentLogLevel( Quiet )
     , m_backendLogLevel( Backend::IBackend::None )
 {
 }
@@ -44,6 +201,11 @@ VlmcLogger::VlmcLogger()
 VlmcLogger::~VlmcLogger()
 {
     qInstallMessageHandler( 0 );
+    Tools::Trace::stop();
+    if ( m_metricsFile.isEmpty() == false && Tools::Metrics::dump( m_metricsFile ) == false )
+        vlmcWarning() << "Failed to write the metrics to" << m_metricsFile;
+    // Flushes what's left in the ring
+    m_asyncWriter.reset();
     if ( m_logFile )
         fclose( m_logFile );
 }
@@ -103,14 +265,63 @@ VlmcLogger::setup()
                 vlmcWarning() << tr("Invalid value supplied for argument --backendverbose" );
         }
     }
+    pos = args.indexOf( QRegExp( "--trace=.*" ) );
+    if ( pos > 0 )
+    {
+        auto traceFile = args[pos].mid( 8 );
+        if ( traceFile.isEmpty() == true || Tools::Trace::start( traceFile ) == false )
+            vlmcWarning() << tr("Invalid value supplied for argument --trace" );
+    }
+    pos = args.indexOf( QRegExp( "--metrics=.*" ) );
+    if ( pos > 0 )
+    {
+        m_metricsFile = args[pos].mid( 10 );
+        if ( m_metricsFile.isEmpty() == true )
+            vlmcWarning() << tr("Invalid value supplied for argument --metrics" );
+    }
+
+    // When rendering headless, stdout carries the progress reports
+    if ( args.filter( QRegExp( "^--render(=.*)?$" ) ).isEmpty() == false )
+        m_console = stderr;
+
+    // The writer owns the log file from now on
+    if ( args.contains( "--async-log" ) == true )
+        m_asyncWriter.reset( new AsyncLogWriter( m_logFile, m_console ) );
+
     auto* backend = Backend::instance();
     backend->setLogHandler( [this]( Backend::IBackend::LogLevel lvl, const QString& msg ) {
         backendLogHandler( lvl, msg );
     } );
+    updateThresholds();
 
     qInstallMessageHandler( VlmcLogger::vlmcMessageHandler );
 }
 
+void
+VlmcLogger::startupPhase( const char* phase )
+{
+    static const bool       enabled = qApp != nullptr &&
+                                      qApp->arguments().contains( "--startup-trace" );
+    static QElapsedTimer    timer;
+    static qint64           last = 0;
+
+    if ( enabled == false )
+        return ;
+    if ( timer.isValid() == false )
+        timer.start();
+    auto now = timer.elapsed();
+    // Regardless of the log level, and before the message handler gets installed
+    fprintf( stdout, "[startup] %6lld ms (+%lld ms) %s\n", now, now - last, phase );
+    fflush( stdout );
+    last = now;
+}
+
+quint64
+VlmcLogger::droppedMessages() const
+{
+    return m_asyncWriter != nullptr ? m_asyncWriter->dropped() : 0;
+}
+
 void
 VlmcLogger::logLevelChanged( const QVariant &logLevel )
 {
@@ -119,6 +330,27 @@ VlmcLogger::logLevelChanged( const QVariant &logLevel )
                logLevel.toInt() <= (int)VlmcLogger::Quiet,
                "Setting log level", "Invalid value for log level");
     m_currentLogLevel = (VlmcLogger::LogLevel)logLevel.toInt();
+    updateThresholds();
+}
+
+void
+VlmcLogger::updateThresholds()
+{
+    // The log file gets everything
+    vlmcDebugEnabled = m_logFile != nullptr || m_currentLogLevel <= Debug;
+
+    auto backendLevel = Backend::IBackend::None;
+    if ( m_logFile != nullptr )
+        backendLevel = Backend::IBackend::Debug;
+    else
+    {
+        // Shown on the console if both levels allow it
+        auto consoleLevel = m_currentLogLevel <= Debug ? Backend::IBackend::Debug :
+                            m_currentLogLevel <= Verbose ? Backend::IBackend::Warning :
+                                                           Backend::IBackend::Error;
+        backendLevel = std::max( consoleLevel, m_backendLogLevel );
+    }
+    Backend::instance()->setLogLevel( backendLevel );
 }
 
 /*********************************************************************
@@ -137,16 +369,33 @@ VlmcLogger::writeToFile(const char *msg)
 void
 VlmcLogger::vlmcMessageHandler( QtMsgType type, const QMessageLogContext&, const QString& str )
 {
+    VlmcLogger* self = Core::instance()->logger();
+    // Before converting anything
+    if ( self->m_logFile == nullptr && type != QtFatalMsg && (int)type < (int)self->m_currentLogLevel )
+        return;
+
     const QByteArray byteArray = str.toLocal8Bit();
     const char* msg = byteArray.constData();
+    self->output( (int)type, (int)type >= (int)self->m_currentLogLevel, msg );
+}
 
-    VlmcLogger* self = Core::instance()->logger();
-    if ( self->m_logFile != nullptr )
+void
+VlmcLogger::output( int level, bool toConsole, const char* msg )
+{
+    // A fatal message aborts right away, it can't wait for the writer
+    if ( m_asyncWriter != nullptr && level != QtFatalMsg )
+    {
+        if ( m_logFile != nullptr || toConsole == true )
+            m_asyncWriter->push( level, toConsole, msg );
+        return;
+    }
+    if ( m_logFile != nullptr )
     {
         //FIXME: Messages are not guaranteed to arrive in order
-        self->writeToFile(msg);
+        writeToFile( msg );
     }
-    self->outputToConsole( (int)type, msg );
+    if ( toConsole == true || level == QtFatalMsg )
+        outputToConsole( level, msg );
 }
 
 void
@@ -162,7 +411,7 @@ VlmcLogger::outputToConsole( int level, const char *msg )
 #endif
     case QtWarningMsg:
     case QtCriticalMsg:
-        fprintf(stdout, "%s\n", msg);
+        fprintf(m_console, "%s\n", msg);
         break;
     case QtFatalMsg:
         fprintf(stderr, "%s\n", msg);
@@ -173,31 +422,31 @@ VlmcLogger::outputToConsole( int level, const char *msg )
 void
 VlmcLogger::backendLogHandler( Backend::IBackend::LogLevel logLevel, const QString& msg )
 {
+    // The backend already drops most of what's below the threshold, but not all of it
+    if ( m_logFile == nullptr && logLevel < m_backendLogLevel )
+        return ;
     char* newMsg = nullptr;
     if ( asprintf( &newMsg, "[%s] T #%p [Backend] %s", qPrintable( QTime::currentTime().toString( "hh:mm:ss.zzz" ) ),
               QThread::currentThreadId(), qPrintable( msg ) ) < 0 )
         return ;
 
-    if ( m_logFile != nullptr )
-        writeToFile( newMsg );
-    if ( logLevel < m_backendLogLevel )
-    {
-        free( newMsg );
-        return ;
-    }
+    int level;
     switch ( logLevel )
     {
         case Backend::IBackend::Debug:
-            outputToConsole( Debug, newMsg );
+            level = Debug;
             break;
         case Backend::IBackend::Warning:
-            outputToConsole( Verbose, newMsg );
+            level = Verbose;
             break;
         case Backend::IBackend::Error:
-            outputToConsole( Quiet, newMsg );
+            level = Quiet;
             break;
         default:
             Q_ASSERT(false);
+            free( newMsg );
+            return ;
     }
+    output( level, logLevel >= m_backendLogLevel && level >= (int)m_currentLogLevel, newMsg );
     free( newMsg );
 }
@@ -25,9 +25,12 @@
 
 #include <QObject>
 #include <cstdio>
+#include <memory>
 
 #include "Backend/IBackend.h"
 
+class   AsyncLogWriter;
+
 /**
  *  \warning    Do not use qDebug() qWarning() etc... from here, unless you know exactly what you're doing
  *              Chances are very high that you end up with a stack overflow !!
@@ -53,13 +56,34 @@ class   VlmcLogger : public QObject
         void            backendLogHandler( Backend::IBackend::LogLevel logLevel, const QString& msg );
 
         void            setup();
+        /**
+         *  \brief      Prints the time elapsed since the first phase, when vlmc runs with
+         *              --startup-trace.
+         *
+         *  Can be called before the logger exists. Meant for the main thread only.
+         */
+        static void     startupPhase( const char* phase );
+        /**
+         *  \brief      Returns the number of messages dropped by the asynchronous mode
+         *              (--async-log) since the start, because the writer fell behind.
+         */
+        quint64         droppedMessages() const;
     private:
         void            writeToFile(const char* msg);
         void            outputToConsole( int level, const char* msg );
+        // Hands the message over to the writer thread in asynchronous mode, or writes it
+        void            output( int level, bool toConsole, const char* msg );
+        // Lets the cheaper checks drop the messages which would be dropped here anyway
+        void            updateThresholds();
 
         FILE*                           m_logFile;
+        // Where the messages are printed, stdout unless it's used for something else
+        FILE*                           m_console;
         LogLevel                        m_currentLogLevel;
         Backend::IBackend::LogLevel     m_backendLogLevel;
+        std::unique_ptr<AsyncLogWriter> m_asyncWriter;
+        // Where the metrics are written on exit, if requested
+        QString                         m_metricsFile;
 
     private slots:
         void            logLevelChanged( const QVariant& logLevel );
@@ -36,3 +36,9 @@ Tools::generateBacktrace( int )
     res.append( QObject::tr( "Unable to get backtrace" ) );
     return res;
 }
+
+QStringList
+Tools::generateBacktrace( Qt::HANDLE, int )
+{
+    return generateBacktrace( 0 );
+}
@@ -0,0 +1,223 @@
+/*****************************************************************************
+ * AudioConformService.cpp: Conforms the audio of the medias to the project format
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "AudioConformService.h"
+#include "RenderJob.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IProfile.h"
+#include "Backend/MLT/MLTInput.h"
+#include "Backend/MLT/MLTService.h"
+#include "Tools/CacheFile.h"
+#include "Tools/FileHash.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QTimer>
+
+const QString   AudioConformService::SubDirectory = ".conformed";
+
+AudioConformService::AudioConformService( QObject* parent )
+    : QObject( parent )
+{
+}
+
+AudioConformService::~AudioConformService()
+{
+    m_pending.clear();
+    for ( auto it = m_running.begin(); it != m_running.end(); ++it )
+    {
+        // Cancels the job, and releases the partial file
+        delete it.key();
+        QFile::remove( it.value().partPath );
+    }
+}
+
+void
+AudioConformService::setDirectory( const QString& cacheDir )
+{
+    if ( cacheDir.isEmpty() == true )
+        m_directory.clear();
+    else
+        m_directory = cacheDir + '/' + SubDirectory;
+}
+
+QString
+AudioConformService::outputPath( const QString& filePath, quint32 sampleRate, quint32 nbChannels ) const
+{
+    if ( m_directory.isEmpty() == true )
+        return QString();
+    auto hash = Tools::contentHash( filePath );
+    if ( hash.isEmpty() == true )
+        return QString();
+    return m_directory + '/' + QString::fromLatin1( hash ) + '_' + QString::number( sampleRate ) +
+            '_' + QString::number( nbChannels ) + ".wav";
+}
+
+void
+AudioConformService::request( const QString& filePath, quint32 sampleRate, quint32 nbChannels )
+{
+    auto path = outputPath( filePath, sampleRate, nbChannels );
+    if ( path.isEmpty() == true || m_conformed.value( filePath ) == path )
+        return;
+    if ( QFile::exists( path ) == true )
+    {
+        m_conformed.insert( filePath, path );
+        return;
+    }
+    // A previous format may still be conformed, which doesn't match anymore
+    m_conformed.remove( filePath );
+    for ( const auto& job : m_pending )
+    {
+        if ( job.outputPath == path )
+            return;
+    }
+    for ( const auto& job : m_running )
+    {
+        if ( job.outputPath == path )
+            return;
+    }
+    Job j;
+    j.filePath = filePath;
+    j.outputPath = path;
+    j.sampleRate = sampleRate;
+    j.nbChannels = nbChannels;
+    m_pending.append( j );
+    schedule();
+}
+
+QString
+AudioConformService::conformedPath( const QString& filePath ) const
+{
+    return m_conformed.value( filePath );
+}
+
+void
+AudioConformService::cancelAll()
+{
+    m_pending.clear();
+    for ( auto job : m_running.keys() )
+        job->cancel();
+}
+
+void
+AudioConformService::schedule()
+{
+    // Conforming is mostly decoding, a single job at a time keeps it out of the way
+    while ( m_pending.isEmpty() == false && m_running.isEmpty() == true )
+    {
+        auto j = m_pending.takeFirst();
+        if ( QDir().mkpath( QFileInfo( j.outputPath ).absolutePath() ) == false )
+            continue;
+        // Another workstation sharing the cache may be conforming it already
+        j.claim = Tools::CacheFile::claim( j.outputPath );
+        if ( j.claim == nullptr )
+        {
+            retry( j.filePath, j.sampleRate, j.nbChannels );
+            continue;
+        }
+        if ( QFile::exists( j.outputPath ) == true )
+        {
+            m_conformed.insert( j.filePath, j.outputPath );
+            emit conformed( j.filePath );
+            continue;
+        }
+        j.partPath = Tools::CacheFile::partPath( j.outputPath, ".wav" );
+        try
+        {
+            // Not shared with anyone else, so it can be copied from this thread
+            auto input = new Backend::MLT::MLTInput( Backend::instance()->profile(),
+                                                     qPrintable( j.filePath ) );
+            input->disableVideo();
+            j.input.reset( input );
+        }
+        catch ( Backend::InvalidServiceException& )
+        {
+            vlmcWarning() << "Can't conform the audio of" << j.filePath;
+            continue;
+        }
+
+        auto& profile = Backend::instance()->profile();
+        RenderParameters params;
+        params.outputFileName = j.partPath;
+        params.width = profile.width();
+        params.height = profile.height();
+        params.fps = profile.fps();
+        params.aspectNum = profile.aspectRatioNum();
+        params.aspectDen = profile.aspectRatioDen();
+        params.videoBitrate = 0;
+        params.audioBitrate = 0;
+        params.nbChannels = j.nbChannels;
+        params.sampleRate = j.sampleRate;
+        // The container has no video stream, so no image gets rendered
+        params.encoder.audioCodec = "pcm_s16le";
+
+        auto job = new RenderJob( params, 1, this );
+        connect( job, &RenderJob::finished, this, [this, job]( bool success )
+        {
+            jobFinished( job, success );
+        } );
+        if ( job->start( *j.input ) == false )
+        {
+            vlmcWarning() << "Failed to start conforming the audio of" << j.filePath;
+            delete job;
+            continue;
+        }
+        m_running.insert( job, j );
+    }
+}
+
+void
+AudioConformService::jobFinished( RenderJob* job, bool success )
+{
+    auto j = m_running.take( job );
+    job->deleteLater();
+    if ( success == true )
+        success = Tools::CacheFile::publish( j.partPath, j.outputPath );
+    if ( success == true )
+    {
+        m_conformed.insert( j.filePath, j.outputPath );
+        emit conformed( j.filePath );
+    }
+    else
+        QFile::remove( j.partPath );
+    schedule();
+}
+
+void
+AudioConformService::retry( const QString& filePath, quint32 sampleRate, quint32 nbChannels )
+{
+    QTimer::singleShot( Tools::CacheFile::ClaimRetry, this,
+                        [this, filePath, sampleRate, nbChannels]() {
+        auto path = outputPath( filePath, sampleRate, nbChannels );
+        if ( path.isEmpty() == false && QFile::exists( path ) == true )
+        {
+            m_conformed.insert( filePath, path );
+            emit conformed( filePath );
+        }
+        else
+            request( filePath, sampleRate, nbChannels );
+    } );
+}
@@ -0,0 +1,108 @@
+/*****************************************************************************
+ * AudioConformService.h: Conforms the audio of the medias to the project format
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef AUDIOCONFORMSERVICE_H
+#define AUDIOCONFORMSERVICE_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+#include <memory>
+
+class QLockFile;
+class RenderJob;
+
+namespace Backend
+{
+class IInput;
+}
+
+/**
+ *  \brief  Resamples the audio of the medias to the project format once, in the background.
+ *
+ *  Medias whose sample rate or channel count differ from the project's would otherwise
+ *  be resampled every time they are played or exported. Their audio is rendered to PCM
+ *  files in the cache directory, keyed by the media content hash and the format, and
+ *  the audio clips are cut from these from then on. \sa Media::audioInput()
+ */
+class AudioConformService : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static const QString    SubDirectory;
+
+        explicit AudioConformService( QObject* parent = nullptr );
+        ~AudioConformService();
+
+        /**
+         *  \brief  Sets the cache directory. An empty path disables the conforming.
+         */
+        void                    setDirectory( const QString& cacheDir );
+
+        /**
+         *  \brief  Conforms the audio of filePath, unless it was conformed already.
+         *
+         *  If the file exists already, it is used right away. Otherwise conformed() is
+         *  emitted once it's rendered.
+         */
+        void                    request( const QString& filePath, quint32 sampleRate, quint32 nbChannels );
+        /**
+         *  \returns    The conformed audio of filePath, or an empty string if there's none.
+         */
+        QString                 conformedPath( const QString& filePath ) const;
+        void                    cancelAll();
+
+    private:
+        QString                 outputPath( const QString& filePath, quint32 sampleRate,
+                                            quint32 nbChannels ) const;
+        void                    schedule();
+        void                    jobFinished( RenderJob* job, bool success );
+        // Looks for the file claimed by another writer again, in a while
+        void                    retry( const QString& filePath, quint32 sampleRate,
+                                       quint32 nbChannels );
+
+    private:
+        struct Job
+        {
+            QString                             filePath;
+            QString                             outputPath;
+            QString                             partPath;
+            quint32                             sampleRate;
+            quint32                             nbChannels;
+            std::shared_ptr<Backend::IInput>    input;
+            // Held until the file is published
+            std::shared_ptr<QLockFile>          claim;
+        };
+
+        QString                 m_directory;
+        QList<Job>              m_pending;
+        QHash<RenderJob*, Job>  m_running;
+        // Indexed by the original media path
+        QHash<QString, QString> m_conformed;
+
+    signals:
+        void                    conformed( const QString& filePath );
+};
+
+#endif // AUDIOCONFORMSERVICE_H
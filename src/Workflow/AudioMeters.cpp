@@ -0,0 +1,175 @@
+/*****************************************************************************
+ * AudioMeters.cpp: Audio level meters of the sequence preview
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "AudioMeters.h"
+#include "SequenceWorkflow.h"
+
+#include <algorithm>
+#include <cmath>
+
+using Backend::MLT::MLTAudioMeter;
+
+namespace
+{
+
+float
+toDb( double linear )
+{
+    if ( linear <= 0 )
+        return AudioMeters::MinimumDb;
+    return std::max<float>( AudioMeters::MinimumDb, 20 * std::log10( linear ) );
+}
+
+}
+
+AudioMeters::AudioMeters( Backend::IInput* master, SequenceWorkflow* sequence, QObject* parent )
+    : QObject( parent )
+    , m_master( master )
+    , m_sequence( sequence )
+    , m_lastUpdate( 0 )
+{
+    m_clock.start();
+    m_timer.setInterval( UpdateInterval );
+    connect( &m_timer, &QTimer::timeout, this, &AudioMeters::update );
+}
+
+AudioMeters::~AudioMeters()
+{
+    setEnabled( false );
+}
+
+void
+AudioMeters::setEnabled( bool enabled )
+{
+    if ( enabled == isEnabled() )
+        return;
+    if ( enabled == false )
+    {
+        m_timer.stop();
+        m_meters.clear();
+        m_levels.clear();
+        emit levelsChanged();
+        return;
+    }
+    m_lastUpdate = m_clock.elapsed();
+    syncMeters();
+    m_timer.start();
+}
+
+bool
+AudioMeters::isEnabled() const
+{
+    return m_timer.isActive();
+}
+
+const QVector<AudioMeters::Level>&
+AudioMeters::levels() const
+{
+    return m_levels;
+}
+
+void
+AudioMeters::reset( Meter& meter, Backend::IInput* input )
+{
+    meter.input = input;
+    meter.meter.reset( new MLTAudioMeter( *input ) );
+    meter.channels = 2;
+    for ( uint32_t c = 0; c < MLTAudioMeter::MaxChannels; ++c )
+    {
+        meter.meanSquare[c] = 0;
+        meter.peak[c] = MinimumDb;
+        meter.hold[c] = MinimumDb;
+        meter.holdTime[c] = 0;
+    }
+}
+
+void
+AudioMeters::syncMeters()
+{
+    // Tracks come and go as clips are added and removed, follow them
+    auto nbMeters = 1 + m_sequence->allocatedTracks();
+    m_meters.resize( nbMeters );
+    for ( quint32 i = 0; i < nbMeters; ++i )
+    {
+        auto input = i == 0 ? m_master : m_sequence->trackInput( i - 1 );
+        auto& meter = m_meters[i];
+        if ( meter.meter == nullptr || meter.input != input || meter.meter->isAttached() == false )
+            reset( meter, input );
+    }
+    m_levels.resize( nbMeters );
+}
+
+void
+AudioMeters::collect( Meter& meter, qint64 now, double elapsed, Level& level )
+{
+    float peaks[MLTAudioMeter::MaxChannels] = {};
+    bool received = false;
+    MLTAudioMeter::Level measure;
+    while ( meter.meter->pop( measure ) == true )
+    {
+        received = true;
+        meter.channels = std::max( 1u, measure.channels );
+        // Integrate the RMS over the frame's duration
+        auto duration = measure.frequency > 0 ? 1000.0 * measure.samples / measure.frequency : 0;
+        auto weight = 1 - std::exp( -duration / RmsWindow );
+        for ( uint32_t c = 0; c < meter.channels; ++c )
+        {
+            peaks[c] = std::max( peaks[c], measure.peak[c] );
+            meter.meanSquare[c] += ( measure.meanSquare[c] - meter.meanSquare[c] ) * weight;
+        }
+    }
+    // Nothing played, the RMS falls back as it would with silence
+    if ( received == false )
+    {
+        for ( uint32_t c = 0; c < meter.channels; ++c )
+            meter.meanSquare[c] *= std::exp( -elapsed / RmsWindow );
+    }
+
+    level.peak.resize( meter.channels );
+    level.rms.resize( meter.channels );
+    level.hold.resize( meter.channels );
+    for ( uint32_t c = 0; c < meter.channels; ++c )
+    {
+        auto fallen = meter.peak[c] - PeakFallRate * elapsed / 1000;
+        meter.peak[c] = std::max<float>( { toDb( peaks[c] ), float( fallen ), float( MinimumDb ) } );
+        if ( meter.peak[c] >= meter.hold[c] || now - meter.holdTime[c] > PeakHoldTime )
+        {
+            meter.hold[c] = meter.peak[c];
+            meter.holdTime[c] = now;
+        }
+        level.peak[c] = meter.peak[c];
+        level.rms[c] = toDb( std::sqrt( meter.meanSquare[c] ) );
+        level.hold[c] = meter.hold[c];
+    }
+}
+
+void
+AudioMeters::update()
+{
+    syncMeters();
+    auto now = m_clock.elapsed();
+    double elapsed = now - m_lastUpdate;
+    m_lastUpdate = now;
+    for ( size_t i = 0; i < m_meters.size(); ++i )
+        collect( m_meters[i], now, elapsed, m_levels[i] );
+    emit levelsChanged();
+}
@@ -0,0 +1,115 @@
+/*****************************************************************************
+ * AudioMeters.h: Audio level meters of the sequence preview
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef AUDIOMETERS_H
+#define AUDIOMETERS_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+#include "Backend/MLT/MLTAudioMeter.h"
+
+class   SequenceWorkflow;
+
+namespace Backend
+{
+class IInput;
+}
+
+/**
+ *  \brief  Level meters of the sequence preview: the master, and each track.
+ *
+ *  Only while enabled, a meter is attached to the input the preview plays, and to each
+ *  track of the sequence. Their measures are collected from this object's thread every
+ *  UpdateInterval, and smoothed like a PPM: peaks fall back at PeakFallRate, the peak
+ *  hold stays for PeakHoldTime, and the RMS is integrated over RmsWindow.
+ */
+class AudioMeters : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static const int        UpdateInterval = 33;
+        // dB per second
+        static const int        PeakFallRate = 20;
+        // Milliseconds
+        static const int        PeakHoldTime = 1500;
+        static const int        RmsWindow = 300;
+        // The displayed range, in dBFS
+        static const int        MinimumDb = -60;
+
+        struct Level
+        {
+            // Per channel, in dBFS, MinimumDb for silence
+            QVector<float>      peak;
+            QVector<float>      rms;
+            QVector<float>      hold;
+        };
+
+        AudioMeters( Backend::IInput* master, SequenceWorkflow* sequence, QObject* parent = nullptr );
+        ~AudioMeters();
+
+        void                    setEnabled( bool enabled );
+        bool                    isEnabled() const;
+        // The master's first, then each track's
+        const QVector<Level>&   levels() const;
+
+    private slots:
+        void                    update();
+
+    private:
+        struct Meter
+        {
+            Backend::IInput*                                input;
+            std::unique_ptr<Backend::MLT::MLTAudioMeter>    meter;
+            uint32_t                                        channels;
+            // Linear
+            float       meanSquare[Backend::MLT::MLTAudioMeter::MaxChannels];
+            // dBFS
+            float       peak[Backend::MLT::MLTAudioMeter::MaxChannels];
+            float       hold[Backend::MLT::MLTAudioMeter::MaxChannels];
+            qint64      holdTime[Backend::MLT::MLTAudioMeter::MaxChannels];
+        };
+
+        void                    syncMeters();
+        void                    reset( Meter& meter, Backend::IInput* input );
+        void                    collect( Meter& meter, qint64 now, double elapsed, Level& level );
+
+    private:
+        Backend::IInput*        m_master;
+        SequenceWorkflow*       m_sequence;
+        std::vector<Meter>      m_meters;
+        QVector<Level>          m_levels;
+        QTimer                  m_timer;
+        QElapsedTimer           m_clock;
+        qint64                  m_lastUpdate;
+
+    signals:
+        void                    levelsChanged();
+};
+
+#endif // AUDIOMETERS_H
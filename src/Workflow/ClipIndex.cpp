@@ -0,0 +1,137 @@
+/*****************************************************************************
+ * ClipIndex.cpp: Positional index of the clips of a track
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ClipIndex.h"
+
+#include <QtGlobal>
+
+void
+ClipIndex::insert( const QUuid& uuid, qint64 begin, qint64 end )
+{
+    remove( uuid );
+    m_entries[begin] = Entry{ uuid, begin, end };
+    m_begins.insert( uuid, begin );
+}
+
+void
+ClipIndex::remove( const QUuid& uuid )
+{
+    auto it = m_begins.find( uuid );
+    if ( it == m_begins.end() )
+        return;
+    auto entry = m_entries.find( it.value() );
+    if ( entry != m_entries.end() && entry->second.uuid == uuid )
+        m_entries.erase( entry );
+    m_begins.erase( it );
+}
+
+void
+ClipIndex::clear()
+{
+    m_entries.clear();
+    m_begins.clear();
+}
+
+int
+ClipIndex::count() const
+{
+    return (int)m_entries.size();
+}
+
+bool
+ClipIndex::isEmpty() const
+{
+    return m_entries.empty();
+}
+
+QList<ClipIndex::Entry>
+ClipIndex::overlapping( qint64 begin, qint64 end, const QUuid& ignore ) const
+{
+    QList<Entry>    res;
+    // The clip starting before begin may still be playing at begin
+    auto it = m_entries.upper_bound( begin );
+    if ( it != m_entries.begin() )
+        --it;
+    for ( ; it != m_entries.end() && it->first < end; ++it )
+    {
+        if ( it->second.end > begin && it->second.uuid != ignore )
+            res << it->second;
+    }
+    return res;
+}
+
+ClipIndex::Entry
+ClipIndex::at( qint64 position ) const
+{
+    auto it = m_entries.upper_bound( position );
+    if ( it == m_entries.begin() )
+        return Entry{ QUuid(), 0, 0 };
+    --it;
+    if ( it->second.end <= position )
+        return Entry{ QUuid(), 0, 0 };
+    return it->second;
+}
+
+qint64
+ClipIndex::nearestEdge( qint64 position, qint64 maxDistance, const QUuid& ignore ) const
+{
+    qint64  best = -1;
+    auto    consider = [&best, &maxDistance, position]( qint64 edge )
+    {
+        if ( qAbs( edge - position ) > maxDistance )
+            return;
+        maxDistance = qAbs( edge - position );
+        best = edge;
+    };
+
+    // Only the closest clips on each side can hold the closest edge, once the
+    // ignored one is skipped
+    auto it = m_entries.lower_bound( position );
+    auto after = it;
+    for ( int i = 0; i < 2 && after != m_entries.end(); ++after )
+    {
+        if ( after->second.uuid == ignore )
+            continue;
+        consider( after->second.begin );
+        consider( after->second.end );
+        ++i;
+    }
+    auto before = it;
+    for ( int i = 0; i < 2 && before != m_entries.begin(); )
+    {
+        --before;
+        if ( before->second.uuid == ignore )
+            continue;
+        consider( before->second.begin );
+        consider( before->second.end );
+        ++i;
+    }
+    return best;
+}
+
+qint64
+ClipIndex::end() const
+{
+    if ( m_entries.empty() == true )
+        return 0;
+    return m_entries.rbegin()->second.end;
+}
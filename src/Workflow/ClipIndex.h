@@ -0,0 +1,81 @@
+/*****************************************************************************
+ * ClipIndex.h: Positional index of the clips of a track
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef CLIPINDEX_H
+#define CLIPINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QUuid>
+
+#include <map>
+
+/**
+ *  \brief  The [begin, end) frame ranges of the clips of a single track, sorted by
+ *          position.
+ *
+ *  Clips of a track don't overlap, so sorting them by their first frame sorts their
+ *  ends as well: every query is a lookup in the sorted map, in O(log n), plus the
+ *  number of clips returned.
+ */
+class ClipIndex
+{
+    public:
+        struct Entry
+        {
+            QUuid       uuid;
+            qint64      begin;
+            qint64      end;
+        };
+
+        // Replaces the previous range of uuid, if any
+        void                insert( const QUuid& uuid, qint64 begin, qint64 end );
+        void                remove( const QUuid& uuid );
+        void                clear();
+        int                 count() const;
+        bool                isEmpty() const;
+
+        /**
+         *  \brief  Returns the clips intersecting [begin, end), in position order.
+         */
+        QList<Entry>        overlapping( qint64 begin, qint64 end,
+                                         const QUuid& ignore = QUuid() ) const;
+        /**
+         *  \brief  Returns the clip playing at position, or an entry with a null uuid.
+         */
+        Entry               at( qint64 position ) const;
+        /**
+         *  \brief  Returns the clip boundary closest to position, or -1 if none is
+         *          within maxDistance frames.
+         */
+        qint64              nearestEdge( qint64 position, qint64 maxDistance,
+                                         const QUuid& ignore = QUuid() ) const;
+        // First frame after the last clip, 0 if the track is empty
+        qint64              end() const;
+
+    private:
+        // Keyed by first frame
+        std::map<qint64, Entry>     m_entries;
+        QHash<QUuid, qint64>        m_begins;
+};
+
+#endif // CLIPINDEX_H
@@ -0,0 +1,162 @@
+/*****************************************************************************
+ * ClipPrefetcher.cpp: Warms the decoders of the clips about to play
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ClipPrefetcher.h"
+#include "SequenceWorkflow.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IInput.h"
+#include "Backend/IProfile.h"
+#include "Backend/MLT/MLTService.h"
+#include "Media/Clip.h"
+#include "Media/Media.h"
+#include "Tools/MediaIO.h"
+#include "Tools/Trace.h"
+
+#include <QFileInfo>
+#include <QList>
+#include <QPair>
+#include <QRunnable>
+
+namespace
+{
+
+class PrefetchJob : public QRunnable
+{
+public:
+    PrefetchJob( std::unique_ptr<Backend::IInput> input, const QString& filePath, bool audio )
+        : m_input( std::move( input ) )
+        , m_filePath( filePath )
+        , m_audio( audio )
+    {
+    }
+
+    virtual void run() override
+    {
+        Tools::MediaIO::Timer   timer( m_filePath, Tools::MediaIO::Open );
+        try
+        {
+            // The cut shares its decoder with the clip: decoding its first frame opens
+            // the file and leaves the decoder right there. The frame itself is dropped,
+            // so it's kept in the decoder's format.
+            m_input->setPosition( 0 );
+            if ( m_audio == true )
+                m_input->audio( 48000, 2 );
+            else
+                m_input->image( 64, 36, Backend::IVideoFrame::YUV420P );
+        }
+        catch ( Backend::InvalidServiceException& )
+        {
+        }
+    }
+
+private:
+    std::unique_ptr<Backend::IInput>    m_input;
+    QString                             m_filePath;
+    bool                                m_audio;
+};
+
+}
+
+ClipPrefetcher::ClipPrefetcher( std::shared_ptr<SequenceWorkflow> sequence, quint32 trackCount )
+    : m_sequence( std::move( sequence ) )
+    , m_trackCount( trackCount )
+    , m_playing( false )
+    , m_playhead( 0 )
+{
+    m_pool.setMaxThreadCount( 2 );
+}
+
+ClipPrefetcher::~ClipPrefetcher()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void
+ClipPrefetcher::setPlaying( bool playing )
+{
+    m_playing = playing;
+    if ( playing == false )
+    {
+        m_pool.clear();
+        m_done.clear();
+    }
+}
+
+void
+ClipPrefetcher::setPlayhead( qint64 frame )
+{
+    qint64 lookahead = Lookahead * Backend::instance()->profile().fps();
+    // After a seek, the clips already prefetched may have been moved away from
+    if ( frame < m_playhead || frame > m_playhead + lookahead )
+        m_done.clear();
+    auto previous = m_playhead;
+    m_playhead = frame;
+    if ( m_playing == false )
+        return;
+
+    // A clip of a media which is playing shares its decoder: seeking it now would only
+    // stall the clip being played
+    QSet<const Media*>  playing;
+    QList<QPair<ClipIndex::Entry, Workflow::TrackType>>    upcoming;
+    for ( int type = 0; type < Workflow::NbTrackType; ++type )
+    {
+        for ( quint32 trackId = 0; trackId < m_trackCount; ++trackId )
+        {
+            auto index = m_sequence->clipIndex( static_cast<Workflow::TrackType>( type ), trackId );
+            if ( index == nullptr )
+                continue;
+            for ( const auto& e : index->overlapping( frame, frame + lookahead ) )
+            {
+                if ( e.begin > previous && e.begin <= frame )
+                    Tools::Trace::add( Tools::Trace::ClipBoundary, e.begin, this );
+                if ( e.begin <= frame )
+                {
+                    auto clip = m_sequence->clip( e.uuid );
+                    if ( clip != nullptr )
+                        playing.insert( clip->media() );
+                }
+                else if ( m_done.contains( e.uuid ) == false )
+                    upcoming << qMakePair( e, static_cast<Workflow::TrackType>( type ) );
+            }
+        }
+    }
+    for ( const auto& u : upcoming )
+    {
+        auto clip = m_sequence->clip( u.first.uuid );
+        if ( clip == nullptr || playing.contains( clip->media() ) == true )
+            continue;
+        m_done.insert( u.first.uuid );
+        auto media = clip->media();
+        if ( media == nullptr || media->fileType() == Media::Image || media->fileType() == Media::Title ||
+             media->fileType() == Media::Multicam || media->fileType() == Media::NestedSequence )
+            continue;
+        auto input = clip->input();
+        auto filePath = media->fileInfo()->absoluteFilePath();
+        // Assuming a constant bitrate, which is close enough to get the right area on disk
+        if ( input->length() > 0 )
+            Tools::MediaIO::prefetch( filePath, media->fileInfo()->size() * input->begin() / input->length() );
+        m_pool.start( new PrefetchJob( input->cut( input->begin(), input->begin() ), filePath,
+                                       u.second == Workflow::AudioTrack ) );
+    }
+}
@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * ClipPrefetcher.h: Warms the decoders of the clips about to play
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef CLIPPREFETCHER_H
+#define CLIPPREFETCHER_H
+
+#include <QSet>
+#include <QThreadPool>
+#include <QUuid>
+
+#include <memory>
+
+class SequenceWorkflow;
+
+/**
+ *  \brief  Opens and seeks the inputs of the clips which are about to play.
+ *
+ *  A clip's decoder is only opened, and seeked to the clip's first frame, once the
+ *  playback reaches it, which stutters on slow storage. While the preview plays, the
+ *  clips starting within Lookahead seconds of the playhead get a frame decoded from
+ *  a pool thread, so their decoder is already positioned when the cut comes.
+ */
+class ClipPrefetcher
+{
+    public:
+        static const int        Lookahead = 3;
+
+        ClipPrefetcher( std::shared_ptr<SequenceWorkflow> sequence, quint32 trackCount );
+        ~ClipPrefetcher();
+
+        void                    setPlayhead( qint64 frame );
+        // Nothing is prefetched while stopped
+        void                    setPlaying( bool playing );
+
+    private:
+        std::shared_ptr<SequenceWorkflow>   m_sequence;
+        const quint32                       m_trackCount;
+        QThreadPool                         m_pool;
+        bool                                m_playing;
+        qint64                              m_playhead;
+        // The clips prefetched since the playback last started or jumped
+        QSet<QUuid>                         m_done;
+};
+
+#endif // CLIPPREFETCHER_H
@@ -0,0 +1,99 @@
+/*****************************************************************************
+ * ClipRegistry.cpp: Clips of a sequence, addressed by handle
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ClipRegistry.h"
+
+#include "Media/Clip.h"
+
+constexpr ClipRegistry::Handle ClipRegistry::InvalidHandle;
+
+ClipRegistry::Handle
+ClipRegistry::insert( std::shared_ptr<Clip> const& clip, quint32 trackId, qint64 position )
+{
+    auto handle = this->handle( clip->uuid() );
+    if ( handle == InvalidHandle )
+    {
+        if ( m_freeSlots.isEmpty() == false )
+        {
+            handle = m_freeSlots.takeLast();
+        }
+        else
+        {
+            handle = m_clips.size();
+            m_clips.append( nullptr );
+            m_trackIds.append( 0 );
+            m_positions.append( 0 );
+        }
+        m_handles.insert( clip->uuid(), handle );
+    }
+    m_clips[handle] = clip;
+    m_trackIds[handle] = trackId;
+    m_positions[handle] = position;
+    return handle;
+}
+
+std::shared_ptr<Clip>
+ClipRegistry::remove( Handle handle )
+{
+    if ( handle >= (Handle)m_clips.size() || !m_clips[handle] )
+        return nullptr;
+    auto clip = m_clips[handle];
+    m_handles.remove( clip->uuid() );
+    m_clips[handle] = nullptr;
+    m_freeSlots.append( handle );
+    return clip;
+}
+
+void
+ClipRegistry::clear()
+{
+    m_clips.clear();
+    m_trackIds.clear();
+    m_positions.clear();
+    m_freeSlots.clear();
+    m_handles.clear();
+}
+
+int
+ClipRegistry::count() const
+{
+    return m_handles.size();
+}
+
+bool
+ClipRegistry::isEmpty() const
+{
+    return m_handles.isEmpty();
+}
+
+QVector<ClipRegistry::Handle>
+ClipRegistry::handles() const
+{
+    QVector<Handle>     res;
+    res.reserve( m_handles.size() );
+    for ( Handle h = 0; h < (Handle)m_clips.size(); ++h )
+    {
+        if ( m_clips[h] )
+            res << h;
+    }
+    return res;
+}
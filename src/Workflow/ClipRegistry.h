@@ -0,0 +1,94 @@
+/*****************************************************************************
+ * ClipRegistry.h: Clips of a sequence, addressed by handle
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef CLIPREGISTRY_H
+#define CLIPREGISTRY_H
+
+#include <QHash>
+#include <QUuid>
+#include <QVector>
+
+#include <limits>
+#include <memory>
+
+class Clip;
+
+/**
+ *  \brief  The clips of a sequence, along with their track and position.
+ *
+ *  Each clip gets a slot in a set of parallel arrays, and the integer handle of that
+ *  slot stays the same until the clip is removed, after which it may be reused.
+ *  Looking a handle up from a uuid is a hash lookup, everything else is an array
+ *  access: the accessors are inline, as the timeline goes through them constantly.
+ */
+class ClipRegistry
+{
+    public:
+        using Handle = quint32;
+        static constexpr Handle     InvalidHandle = std::numeric_limits<Handle>::max();
+
+        // Replaces the previous entry of the clip, if any
+        Handle                  insert( std::shared_ptr<Clip> const& clip, quint32 trackId,
+                                        qint64 position );
+        std::shared_ptr<Clip>   remove( Handle handle );
+        void                    clear();
+
+        Handle                  handle( const QUuid& uuid ) const
+        {
+            return m_handles.value( uuid, InvalidHandle );
+        }
+        bool                    contains( const QUuid& uuid ) const
+        {
+            return m_handles.contains( uuid );
+        }
+        int                     count() const;
+        bool                    isEmpty() const;
+        // The handles in use, in no particular order
+        QVector<Handle>         handles() const;
+
+        const std::shared_ptr<Clip>&    clip( Handle handle ) const
+        {
+            return m_clips[handle];
+        }
+        quint32                 trackId( Handle handle ) const
+        {
+            return m_trackIds[handle];
+        }
+        qint64                  position( Handle handle ) const
+        {
+            return m_positions[handle];
+        }
+        void                    setPosition( Handle handle, qint64 position )
+        {
+            m_positions[handle] = position;
+        }
+
+    private:
+        // A null clip marks a free slot
+        QVector<std::shared_ptr<Clip>>  m_clips;
+        QVector<quint32>                m_trackIds;
+        QVector<qint64>                 m_positions;
+        QVector<Handle>                 m_freeSlots;
+        QHash<QUuid, Handle>            m_handles;
+};
+
+#endif // CLIPREGISTRY_H
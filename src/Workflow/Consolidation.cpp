@@ -0,0 +1,321 @@
+/*****************************************************************************
+ * Consolidation.cpp: Copies the used parts of the medias to a new workspace
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "Consolidation.h"
+
+#include "Backend/MLT/MLTInput.h"
+#include "Media/Media.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+// Sorts the pieces, and merges those which overlap or touch
+void
+merge( QList<Consolidation::Piece>& pieces )
+{
+    std::sort( pieces.begin(), pieces.end(), []( const Consolidation::Piece& a, const Consolidation::Piece& b ) {
+        return a.begin < b.begin;
+    } );
+    QList<Consolidation::Piece>     merged;
+    for ( const auto& p : pieces )
+    {
+        if ( merged.isEmpty() == false && p.begin <= merged.last().end )
+            merged.last().end = std::max( merged.last().end, p.end );
+        else
+            merged << p;
+    }
+    pieces = merged;
+}
+
+}
+
+Consolidation::Consolidation( Tools::JobScheduler* scheduler, QObject* parent )
+    : QObject( parent )
+    , m_scheduler( scheduler )
+    , m_fps( 0 )
+    , m_nbDone( 0 )
+{
+}
+
+Consolidation::~Consolidation()
+{
+    m_scheduler->cancel( m_token );
+    m_scheduler->wait( m_token );
+}
+
+void
+Consolidation::add( Media* media, const QList<QPair<qint64, qint64>>& ranges )
+{
+    auto path = media->fileInfo()->absoluteFilePath();
+    if ( media->isPlaceholder() == true || Backend::MLT::MLTInput::isImageSequence( qPrintable( path ) ) == true )
+        return;
+    Source  source{ media, path, QString(), media->input()->length(), {}, false };
+    // Those are drawn from the whole file
+    if ( Backend::MLT::MLTInput::isImage( qPrintable( path ) ) == true ||
+         Backend::MLT::MLTInput::isTitle( qPrintable( path ) ) == true ||
+         Backend::MLT::MLTInput::isMulticam( qPrintable( path ) ) == true ||
+         Backend::MLT::MLTInput::isNestedSequence( qPrintable( path ) ) == true )
+        source.pieces << Piece{ 0, source.length, 0 };
+    else
+    {
+        for ( const auto& r : ranges )
+            source.pieces << Piece{ r.first, r.second + 1, 0 };
+    }
+    m_sources.push_back( source );
+}
+
+bool
+Consolidation::start( const QString& directory, qint64 handles, double fps )
+{
+    if ( m_sources.empty() == true )
+        return false;
+    m_ffmpeg = QStandardPaths::findExecutable( "ffmpeg" );
+    m_ffprobe = QStandardPaths::findExecutable( "ffprobe" );
+    if ( m_ffmpeg.isEmpty() == true || m_ffprobe.isEmpty() == true )
+    {
+        vlmcWarning() << "ffmpeg and ffprobe are required to consolidate the medias";
+        return false;
+    }
+    QDir    dir( directory );
+    if ( dir.mkpath( "." ) == false )
+    {
+        vlmcWarning() << "Can't create" << directory;
+        return false;
+    }
+    m_fps = fps;
+
+    QSet<QString>   names;
+    for ( auto& s : m_sources )
+    {
+        // Medias of the same name, from different directories
+        QFileInfo   info( s.filePath );
+        auto        name = info.fileName();
+        for ( int i = 1; names.contains( name ) == true || dir.exists( name ) == true; ++i )
+            name = info.completeBaseName() + '_' + QString::number( i ) +
+                    ( info.suffix().isEmpty() == true ? QString() : '.' + info.suffix() );
+        names.insert( name );
+        s.copyPath = dir.absoluteFilePath( name );
+        for ( auto& p : s.pieces )
+        {
+            p.begin = std::max( 0ll, p.begin - handles );
+            p.end = std::min( s.length, p.end + handles );
+        }
+        merge( s.pieces );
+    }
+    for ( size_t i = 0; i < m_sources.size(); ++i )
+    {
+        m_scheduler->schedule( Tools::JobScheduler::Background,
+                               [this, i]( const Tools::JobScheduler::CancellationToken& token )
+        {
+            auto& source = m_sources[i];
+            source.success = copy( source, token );
+            if ( source.success == false && token.isCanceled() == false )
+                vlmcWarning() << "Failed to consolidate" << source.filePath;
+            QMetaObject::invokeMethod( this, "sourceDone", Qt::QueuedConnection );
+        }, m_token );
+    }
+    return true;
+}
+
+const std::vector<Consolidation::Source>&
+Consolidation::sources() const
+{
+    return m_sources;
+}
+
+qint64
+Consolidation::map( const QList<Piece>& pieces, qint64 frame )
+{
+    if ( pieces.isEmpty() == true )
+        return frame;
+    for ( const auto& p : pieces )
+    {
+        // In between two pieces: the first frame of the next one
+        if ( frame < p.begin )
+            return p.offset;
+        if ( frame < p.end )
+            return p.offset + frame - p.begin;
+    }
+    return pieces.last().offset + pieces.last().end - pieces.last().begin - 1;
+}
+
+bool
+Consolidation::run( const QString& program, const QStringList& arguments,
+                    const Tools::JobScheduler::CancellationToken& token, QByteArray* output ) const
+{
+    QProcess    process;
+    process.setProcessChannelMode( output != nullptr ? QProcess::SeparateChannels
+                                                     : QProcess::ForwardedErrorChannel );
+    process.start( program, arguments );
+    if ( process.waitForStarted() == false )
+    {
+        vlmcWarning() << "Failed to start" << program;
+        return false;
+    }
+    while ( process.state() != QProcess::NotRunning )
+    {
+        if ( token.isCanceled() == true )
+        {
+            process.kill();
+            process.waitForFinished();
+            return false;
+        }
+        process.waitForFinished( 200 );
+    }
+    if ( output != nullptr )
+        *output = process.readAllStandardOutput();
+    return process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
+}
+
+bool
+Consolidation::copy( Source& source, const Tools::JobScheduler::CancellationToken& token ) const
+{
+    if ( source.pieces.size() == 1 && source.pieces[0].begin == 0 && source.pieces[0].end >= source.length )
+        return QFile::copy( source.filePath, source.copyPath );
+
+    // The keyframes of the video, and where the frames of the media start from
+    QByteArray  output;
+    if ( run( m_ffprobe, QStringList{ "-v", "error", "-select_streams", "v:0", "-of", "compact",
+                                      "-show_entries", "packet=pts_time,flags:format=start_time",
+                                      source.filePath }, token, &output ) == false )
+        return false;
+    double          startTime = INFINITY;
+    double          formatStart = 0;
+    QVector<double> keyframes;
+    for ( const auto& line : output.split( '\n' ) )
+    {
+        auto fields = QString::fromUtf8( line ).trimmed().split( '|' );
+        bool keyframe = false;
+        bool ok = false;
+        double time = 0;
+        for ( int i = 1; i < fields.size(); ++i )
+        {
+            if ( fields[i].startsWith( "pts_time=" ) == true || fields[i].startsWith( "start_time=" ) == true )
+                time = fields[i].section( '=', 1 ).toDouble( &ok );
+            else if ( fields[i].startsWith( "flags=" ) == true )
+                keyframe = fields[i].contains( 'K' );
+        }
+        if ( ok == false )
+            continue;
+        if ( fields[0] == "format" )
+            formatStart = time;
+        else if ( fields[0] == "packet" )
+        {
+            startTime = std::min( startTime, time );
+            if ( keyframe == true )
+                keyframes.append( time );
+        }
+    }
+    // The audio medias can be cut anywhere
+    if ( std::isinf( startTime ) == true )
+        startTime = formatStart;
+    std::sort( keyframes.begin(), keyframes.end() );
+
+    // Each piece is copied from the keyframe before it
+    auto            epsilon = 0.5 / m_fps;
+    QList<Piece>    aligned;
+    QVector<double> inPoints;
+    for ( auto p : source.pieces )
+    {
+        auto inTime = startTime + p.begin / m_fps;
+        if ( keyframes.isEmpty() == false )
+        {
+            auto it = std::upper_bound( keyframes.begin(), keyframes.end(), inTime + epsilon );
+            if ( it == keyframes.begin() )
+                inTime = startTime;
+            else
+                inTime = *( it - 1 );
+            p.begin = std::max( 0ll, qRound64( ( inTime - startTime ) * m_fps ) );
+        }
+        if ( aligned.isEmpty() == false && p.begin <= aligned.last().end )
+        {
+            aligned.last().end = std::max( aligned.last().end, p.end );
+            continue;
+        }
+        aligned << p;
+        inPoints << inTime;
+    }
+    qint64  offset = 0;
+    for ( auto& p : aligned )
+    {
+        p.offset = offset;
+        offset += p.end - p.begin;
+    }
+
+    auto    listPath = source.copyPath + ".txt";
+    QFile   list( listPath );
+    if ( list.open( QFile::WriteOnly | QFile::Truncate ) == false )
+        return false;
+    {
+        QTextStream stream( &list );
+        auto escaped = source.filePath;
+        escaped.replace( "'", "'\\''" );
+        for ( int i = 0; i < aligned.size(); ++i )
+        {
+            stream << "file '" << escaped << "'\n";
+            stream << "inpoint " << QString::number( inPoints[i], 'f', 6 ) << '\n';
+            // Up to the end of the file, otherwise
+            if ( aligned[i].end < source.length )
+                stream << "outpoint " << QString::number( startTime + aligned[i].end / m_fps, 'f', 6 ) << '\n';
+        }
+    }
+    list.close();
+    auto partPath = source.copyPath + ".part." + QFileInfo( source.copyPath ).suffix();
+    auto success = run( m_ffmpeg, QStringList{ "-y", "-v", "error", "-f", "concat", "-safe", "0", "-i", listPath,
+                                              "-map", "0:v?", "-map", "0:a?", "-c", "copy", partPath }, token );
+    QFile::remove( listPath );
+    if ( success == true )
+        success = QFile::rename( partPath, source.copyPath );
+    if ( success == false )
+    {
+        QFile::remove( partPath );
+        return false;
+    }
+    source.pieces = aligned;
+    return true;
+}
+
+void
+Consolidation::sourceDone()
+{
+    ++m_nbDone;
+    emit progress( m_nbDone, static_cast<int>( m_sources.size() ) );
+    if ( m_nbDone < static_cast<int>( m_sources.size() ) )
+        return;
+    auto success = std::all_of( m_sources.cbegin(), m_sources.cend(), []( const Source& s ) {
+        return s.success;
+    } );
+    emit finished( success );
+}
@@ -0,0 +1,133 @@
+/*****************************************************************************
+ * Consolidation.h: Copies the used parts of the medias to a new workspace
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef CONSOLIDATION_H
+#define CONSOLIDATION_H
+
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QString>
+
+#include "Tools/JobScheduler.h"
+
+#include <vector>
+
+class Media;
+
+/**
+ *  \brief  Copies the parts of the medias which the sequence plays to a directory,
+ *          without reencoding them, so that the project can be archived without its
+ *          whole sources.
+ *
+ *  The frames used by each media are extended by handles, and each range starts from
+ *  the keyframe before it, which ffprobe lists. ffmpeg then joins the ranges of the
+ *  media into a single file, with the concat demuxer and a stream copy, as a smart
+ *  render does. \sa SmartRender
+ *  The medias are copied in parallel, as background jobs. Images and titles are copied
+ *  as they are.
+ */
+class Consolidation : public QObject
+{
+    Q_OBJECT
+
+    public:
+        // The handles kept around the used frames, in seconds
+        static const int        DefaultHandles = 2;
+
+        struct Piece
+        {
+            // Frames of the media, end excluded
+            qint64      begin;
+            qint64      end;
+            // The frame of the copy showing begin
+            qint64      offset;
+        };
+
+        struct Source
+        {
+            // Only used from the main thread
+            Media*          media;
+            QString         filePath;
+            QString         copyPath;
+            qint64          length;
+            // Sorted and merged, the pieces are aligned on keyframes by the job
+            QList<Piece>    pieces;
+            bool            success;
+        };
+
+        explicit Consolidation( Tools::JobScheduler* scheduler, QObject* parent = nullptr );
+        // Stops the running copies, and waits for them
+        ~Consolidation();
+
+        /**
+         *  \brief  Adds the frames of media to copy, as [first, last] pairs. Must be called
+         *          before start().
+         *
+         *  Image sequences and placeholders can't be copied, and are left out.
+         */
+        void                    add( Media* media, const QList<QPair<qint64, qint64>>& ranges );
+        /**
+         *  \brief  Starts copying to directory, with handles frames around the used ones.
+         *
+         *  Returns false without ffmpeg or ffprobe, when nothing was added, or if the
+         *  directory can't be created.
+         */
+        bool                    start( const QString& directory, qint64 handles, double fps );
+        /**
+         *  \brief  The medias, where they got copied, and which of their frames. Only
+         *          valid once finished() was emitted.
+         */
+        const std::vector<Source>&  sources() const;
+        /**
+         *  \returns    The frame of the copy showing frame of the media, or the closest
+         *              one copied.
+         */
+        static qint64           map( const QList<Piece>& pieces, qint64 frame );
+
+    private:
+        // Run from a scheduler thread
+        bool                    copy( Source& source, const Tools::JobScheduler::CancellationToken& token ) const;
+        bool                    run( const QString& program, const QStringList& arguments,
+                                     const Tools::JobScheduler::CancellationToken& token,
+                                     QByteArray* output = nullptr ) const;
+
+    private:
+        Tools::JobScheduler*    m_scheduler;
+        Tools::JobScheduler::CancellationToken  m_token;
+        // Not resized once the jobs are started: each one writes to its own source
+        std::vector<Source>     m_sources;
+        QString                 m_ffmpeg;
+        QString                 m_ffprobe;
+        double                  m_fps;
+        int                     m_nbDone;
+
+    private slots:
+        void                    sourceDone();
+
+    signals:
+        void                    progress( int done, int total );
+        // Emitted once every media was copied, success is false if any failed
+        void                    finished( bool success );
+};
+
+#endif // CONSOLIDATION_H
@@ -0,0 +1,135 @@
+/*****************************************************************************
+ * DecodeBenchmarkService.cpp: Measures how fast the medias decode on this machine
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "DecodeBenchmarkService.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IInput.h"
+#include "Backend/IProfile.h"
+#include "Backend/MLT/MLTInput.h"
+#include "Backend/MLT/MLTService.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <memory>
+
+const double    DecodeBenchmarkService::SlowRatio = 1.5;
+
+DecodeBenchmarkService::DecodeBenchmarkService( Tools::JobScheduler* scheduler, QObject* parent )
+    : QObject( parent )
+    , m_scheduler( scheduler )
+{
+}
+
+DecodeBenchmarkService::~DecodeBenchmarkService()
+{
+    m_scheduler->cancel( m_token );
+    m_scheduler->wait( m_token );
+}
+
+void
+DecodeBenchmarkService::request( const QString& filePath, qint64 nbFrames )
+{
+    if ( nbFrames <= 0 )
+        return;
+    {
+        QMutexLocker    lock( &m_mutex );
+        if ( m_pending.contains( filePath ) == true )
+            return;
+        if ( m_speeds.contains( filePath ) == false )
+        {
+            m_pending.insert( filePath );
+            m_scheduler->schedule( Tools::JobScheduler::Background,
+                                   [this, filePath, nbFrames]( const Tools::JobScheduler::CancellationToken& token )
+            {
+                measure( filePath, nbFrames, token );
+            }, m_token );
+            return;
+        }
+    }
+    emit measured( filePath );
+}
+
+double
+DecodeBenchmarkService::speed( const QString& filePath ) const
+{
+    QMutexLocker    lock( &m_mutex );
+    return m_speeds.value( filePath );
+}
+
+bool
+DecodeBenchmarkService::isSlow( double speed, double fps )
+{
+    return speed > 0 && fps > 0 && speed < fps * SlowRatio;
+}
+
+void
+DecodeBenchmarkService::measure( const QString& filePath, qint64 nbFrames,
+                                 const Tools::JobScheduler::CancellationToken& token )
+{
+    double speed = 0;
+    try
+    {
+        auto& profile = Backend::instance()->profile();
+        // Not shared with anyone else. The proxy, if any, isn't what gets measured.
+        std::unique_ptr<Backend::IInput> input( new Backend::MLT::MLTInput( profile,
+                                                                            qPrintable( filePath ) ) );
+        input = input->cloneOriginals();
+        auto pos = std::max<qint64>( 0, ( nbFrames - NbFrames ) / 2 );
+        auto end = std::min( nbFrames, pos + NbFrames + 1 );
+        input->setPosition( pos );
+        if ( input->image( profile.width(), profile.height() ) != nullptr )
+        {
+            QElapsedTimer   timer;
+            timer.start();
+            qint64 nbDecoded = 0;
+            for ( ++pos; pos < end && token.isCanceled() == false; ++pos, ++nbDecoded )
+            {
+                input->setPosition( pos );
+                if ( input->image( profile.width(), profile.height() ) == nullptr )
+                    break;
+            }
+            auto elapsed = timer.nsecsElapsed();
+            if ( token.isCanceled() == false && nbDecoded > 0 && elapsed > 0 )
+                speed = nbDecoded * 1e9 / elapsed;
+        }
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Can't measure the decoding speed of" << filePath;
+    }
+    {
+        QMutexLocker    lock( &m_mutex );
+        m_pending.remove( filePath );
+        // A failure isn't measured again either
+        if ( token.isCanceled() == false )
+            m_speeds.insert( filePath, speed );
+    }
+    if ( speed > 0 )
+    {
+        vlmcDebug() << filePath << "decodes at" << speed << "fps";
+        emit measured( filePath );
+    }
+}
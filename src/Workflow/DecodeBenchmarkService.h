@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * DecodeBenchmarkService.h: Measures how fast the medias decode on this machine
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef DECODEBENCHMARKSERVICE_H
+#define DECODEBENCHMARKSERVICE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+#include "Tools/JobScheduler.h"
+
+/**
+ *  \brief  Measures the decoding speed of the medias in the background, once per media.
+ *
+ *  A few frames from the middle of the original file are decoded at the project size,
+ *  which tells how many frames per second this machine decodes: long GOP, high bit
+ *  depth or high resolution medias are often too slow to be previewed in real time.
+ *  Those are better optimized. \sa ProxyService::Optimized
+ *  The speeds only hold for this machine, and aren't saved.
+ */
+class DecodeBenchmarkService : public QObject
+{
+    Q_OBJECT
+
+    public:
+        // Decoded after the first frame, which also measures the opening and the seek
+        static const qint64     NbFrames = 48;
+        /**
+         *  \brief  The medias decoding under that many times the project frame rate
+         *          should be optimized.
+         *
+         *  Previewing also composites, and often decodes more than a track at once.
+         */
+        static const double     SlowRatio;
+
+        explicit DecodeBenchmarkService( Tools::JobScheduler* scheduler, QObject* parent = nullptr );
+        ~DecodeBenchmarkService();
+
+        /**
+         *  \brief  Measures the decoding speed of filePath, unless it's known already.
+         *
+         *  measured() is emitted once done, right away if it's known already.
+         */
+        void                    request( const QString& filePath, qint64 nbFrames );
+        /**
+         *  \returns    The frames per second filePath decodes at, or 0 if it wasn't
+         *              measured.
+         */
+        double                  speed( const QString& filePath ) const;
+        static bool             isSlow( double speed, double fps );
+
+    private:
+        // Called from the scheduler threads
+        void                    measure( const QString& filePath, qint64 nbFrames,
+                                         const Tools::JobScheduler::CancellationToken& token );
+
+    private:
+        Tools::JobScheduler*                    m_scheduler;
+        Tools::JobScheduler::CancellationToken  m_token;
+        mutable QMutex                          m_mutex;
+        QHash<QString, double>                  m_speeds;
+        QSet<QString>                           m_pending;
+
+    signals:
+        /**
+         *  \brief  Emitted once filePath was measured, from a worker thread.
+         */
+        void                    measured( const QString& filePath );
+};
+
+#endif // DECODEBENCHMARKSERVICE_H
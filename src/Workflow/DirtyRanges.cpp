@@ -0,0 +1,75 @@
+/*****************************************************************************
+ * DirtyRanges.cpp: Merges the frame ranges invalidated by an edit
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "DirtyRanges.h"
+
+#include <limits>
+
+void
+DirtyRanges::add( qint64 begin, qint64 end )
+{
+    begin = qMax( 0ll, begin );
+    if ( end < 0 )
+        end = std::numeric_limits<qint64>::max();
+    if ( end <= begin )
+        return;
+
+    // Skip the ranges ending before this one starts, then absorb the ones it touches
+    auto it = m_ranges.begin();
+    while ( it != m_ranges.end() && it->second < begin )
+        ++it;
+    while ( it != m_ranges.end() && it->first <= end )
+    {
+        begin = qMin( begin, it->first );
+        end = qMax( end, it->second );
+        it = m_ranges.erase( it );
+    }
+    m_ranges.insert( it, qMakePair( begin, end ) );
+}
+
+void
+DirtyRanges::add( const DirtyRanges& ranges )
+{
+    for ( const auto& r : ranges.m_ranges )
+        add( r.first, r.second );
+}
+
+bool
+DirtyRanges::isEmpty() const
+{
+    return m_ranges.isEmpty();
+}
+
+void
+DirtyRanges::clear()
+{
+    m_ranges.clear();
+}
+
+QList<DirtyRanges::Range>
+DirtyRanges::ranges() const
+{
+    auto ranges = m_ranges;
+    if ( ranges.isEmpty() == false && ranges.last().second == std::numeric_limits<qint64>::max() )
+        ranges.last().second = -1;
+    return ranges;
+}
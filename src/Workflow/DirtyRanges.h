@@ -0,0 +1,52 @@
+/*****************************************************************************
+ * DirtyRanges.h: Merges the frame ranges invalidated by an edit
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef DIRTYRANGES_H
+#define DIRTYRANGES_H
+
+#include <QList>
+#include <QPair>
+
+/**
+ *  \brief  A set of disjoint [begin, end) frame ranges, kept sorted.
+ *
+ *  Overlapping and adjacent ranges are merged as they are added. A negative end
+ *  stands for "up to the end of the sequence", including when it grows.
+ */
+class DirtyRanges
+{
+    public:
+        using Range = QPair<qint64, qint64>;
+
+        void                add( qint64 begin, qint64 end );
+        void                add( const DirtyRanges& ranges );
+        bool                isEmpty() const;
+        void                clear();
+        // With negative ends for the unbounded range
+        QList<Range>        ranges() const;
+
+    private:
+        // Unbounded ends are stored as the largest qint64, which keeps them sorted
+        QList<Range>        m_ranges;
+};
+
+#endif // DIRTYRANGES_H
@@ -0,0 +1,456 @@
+/*****************************************************************************
+ * DistributedRender.cpp: Splits an export accross render nodes
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "DistributedRender.h"
+
+#include "Tools/FrameHash.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTextStream>
+
+#include <algorithm>
+
+namespace
+{
+// Chunks per slot, so that the faster nodes end up rendering more of them
+const int       ChunksPerSlot = 4;
+// Before the whole render is given up
+const int       MaxAttempts = 3;
+// Before a node isn't given chunks anymore
+const int       MaxNodeFailures = 2;
+
+QString
+shellQuote( QString arg )
+{
+    arg.replace( "'", "'\\''" );
+    return '\'' + arg + '\'';
+}
+}
+
+QList<DistributedRender::Node>
+DistributedRender::loadNodes( const QString& fileName )
+{
+    QList<Node>     nodes;
+    QFile           file( fileName );
+    if ( file.open( QFile::ReadOnly ) == false )
+    {
+        vlmcWarning() << "Can't open the render nodes file" << fileName;
+        return nodes;
+    }
+    QJsonParseError error;
+    auto doc = QJsonDocument::fromJson( file.readAll(), &error );
+    if ( doc.isArray() == false )
+    {
+        vlmcWarning() << "Invalid render nodes file" << fileName << ':' << error.errorString();
+        return nodes;
+    }
+    for ( const auto& value : doc.array() )
+    {
+        auto obj = value.toObject();
+        Node n;
+        n.host = obj["host"].toString();
+        if ( n.host.isEmpty() == true )
+        {
+            vlmcWarning() << "Ignoring a render node without a host";
+            continue;
+        }
+        n.program = obj["program"].toString();
+        n.slots = qMax( 1, obj["slots"].toInt( 1 ) );
+        n.threads = qMax( 0, obj["threads"].toInt() );
+        auto paths = obj["paths"].toObject();
+        for ( auto it = paths.constBegin(); it != paths.constEnd(); ++it )
+            n.paths.insert( it.key(), it.value().toString() );
+        nodes.append( n );
+    }
+    return nodes;
+}
+
+DistributedRender::DistributedRender( const QString& projectFileName, const RenderParameters& params,
+                                      qint64 begin, qint64 end, const QList<Node>& nodes,
+                                      QObject* parent )
+    : QObject( parent )
+    , m_projectFileName( QFileInfo( projectFileName ).absoluteFilePath() )
+    , m_params( params )
+    , m_begin( begin )
+    , m_end( end )
+    // Like segmented exports, chunks are made of whole GOPs to keep the keyframe cadence
+    , m_gopSize( params.encoder.gopSize > 0 ? params.encoder.gopSize : qMax( 1, qRound( params.fps * 2 ) ) )
+    , m_nodes( nodes )
+    , m_concatenation( nullptr )
+    , m_running( false )
+    , m_cancelled( false )
+{
+    m_params.encoder.gopSize = m_gopSize;
+
+    int nbSlots = 0;
+    for ( int i = 0; i < m_nodes.size(); ++i )
+    {
+        m_failures.append( 0 );
+        for ( int s = 0; s < m_nodes[i].slots; ++s )
+            m_workers.append( Worker{ i, -1, nullptr } );
+        nbSlots += m_nodes[i].slots;
+    }
+
+    qint64 total = m_end - m_begin;
+    qint64 nbGops = ( total + m_gopSize - 1 ) / m_gopSize;
+    qint64 nbChunks = qBound<qint64>( 1, nbSlots * ChunksPerSlot, qMax<qint64>( 1, nbGops ) );
+    qint64 chunkLength = ( nbGops + nbChunks - 1 ) / nbChunks * m_gopSize;
+    QFileInfo   info( m_params.outputFileName );
+    for ( qint64 b = m_begin; b < m_end; b += chunkLength )
+    {
+        Chunk c;
+        c.begin = b;
+        c.end = qMin( m_end, b + chunkLength );
+        c.fileName = info.absolutePath() + '/' + '.' + info.completeBaseName() + ".part" +
+                QString::number( m_chunks.size() ) + '.' + info.suffix();
+        c.rendered = 0;
+        c.attempts = 0;
+        c.done = false;
+        m_chunks.append( c );
+    }
+}
+
+DistributedRender::~DistributedRender()
+{
+    cancel();
+    // The processes are waited for, without notifying a half destroyed render
+    for ( auto& w : m_workers )
+    {
+        if ( w.process == nullptr )
+            continue;
+        disconnect( w.process, nullptr, this, nullptr );
+        delete w.process;
+    }
+    if ( m_concatenation != nullptr )
+    {
+        disconnect( m_concatenation, nullptr, this, nullptr );
+        delete m_concatenation;
+    }
+    for ( const auto& c : m_chunks )
+    {
+        QFile::remove( c.fileName );
+        QFile::remove( hashFileName( c ) );
+    }
+    if ( m_chunks.isEmpty() == false )
+        QFile::remove( m_chunks.first().fileName + ".txt" );
+}
+
+bool
+DistributedRender::start()
+{
+    Q_ASSERT( m_running == false );
+    if ( m_workers.isEmpty() == true || m_chunks.isEmpty() == true )
+        return false;
+    m_running = true;
+    vlmcDebug() << "Rendering" << m_chunks.size() << "chunks on" << m_nodes.size() << "nodes";
+    schedule();
+    return m_running;
+}
+
+void
+DistributedRender::cancel()
+{
+    if ( m_running == false )
+        return;
+    m_cancelled = true;
+    for ( auto& w : m_workers )
+    {
+        if ( w.process != nullptr )
+            w.process->kill();
+    }
+    if ( m_concatenation != nullptr )
+        m_concatenation->kill();
+    finish( false );
+}
+
+qint64
+DistributedRender::totalFrames() const
+{
+    return m_end - m_begin;
+}
+
+QString
+DistributedRender::mapPath( const Node& node, const QString& path )
+{
+    QString prefix;
+    for ( auto it = node.paths.cbegin(); it != node.paths.cend(); ++it )
+    {
+        if ( it.key().size() > prefix.size() && path.startsWith( it.key() ) == true )
+            prefix = it.key();
+    }
+    if ( prefix.isEmpty() == true )
+        return path;
+    return node.paths[prefix] + path.mid( prefix.size() );
+}
+
+QStringList
+DistributedRender::renderArguments( const Node& node, const Chunk& chunk ) const
+{
+    QStringList args{ "--render", mapPath( node, m_projectFileName ),
+                      "--out", mapPath( node, chunk.fileName ),
+                      "--range", QString( "%1:%2" ).arg( chunk.begin ).arg( chunk.end ),
+                      "--size", QString( "%1x%2" ).arg( m_params.width ).arg( m_params.height ),
+                      "--vbitrate", QString::number( m_params.videoBitrate ),
+                      "--abitrate", QString::number( m_params.audioBitrate ),
+                      "--gop", QString::number( m_gopSize ) };
+    // Every chunk must be encoded alike to be joined
+    if ( m_params.encoder.videoCodec.empty() == false )
+        args << "--vcodec" << QString::fromStdString( m_params.encoder.videoCodec );
+    if ( m_params.encoder.audioCodec.empty() == false )
+        args << "--acodec" << QString::fromStdString( m_params.encoder.audioCodec );
+    if ( node.threads > 0 )
+        args << "--threads" << QString::number( node.threads );
+    for ( auto it = node.paths.cbegin(); it != node.paths.cend(); ++it )
+        args << "--map-path" << it.key() + '=' + it.value();
+    if ( hashesFrames() == true )
+        args << "--frame-hashes" << mapPath( node, hashFileName( chunk ) );
+    return args;
+}
+
+bool
+DistributedRender::hashesFrames() const
+{
+    return m_params.frameHashFile.isEmpty() == false || m_params.referenceHashFile.isEmpty() == false;
+}
+
+QString
+DistributedRender::hashFileName( const Chunk& chunk )
+{
+    return chunk.fileName + ".hashes";
+}
+
+bool
+DistributedRender::checkHashes() const
+{
+    // The nodes hash their frames at their position in the project
+    Tools::FrameHashes  hashes;
+    for ( const auto& c : m_chunks )
+    {
+        if ( hashes.load( hashFileName( c ) ) == false )
+        {
+            vlmcCritical() << "Frames" << c.begin << "to" << c.end << "weren't hashed";
+            return false;
+        }
+    }
+    if ( m_params.frameHashFile.isEmpty() == false && hashes.save( m_params.frameHashFile ) == false )
+        return false;
+    return m_params.referenceHashFile.isEmpty() == true || hashes.verify( m_params.referenceHashFile );
+}
+
+void
+DistributedRender::schedule()
+{
+    if ( m_running == false )
+        return;
+    int chunk = 0;
+    for ( int i = 0; i < m_workers.size(); ++i )
+    {
+        auto& w = m_workers[i];
+        if ( w.process != nullptr || m_failures[w.node] >= MaxNodeFailures )
+            continue;
+        // The next chunk neither done nor being rendered
+        while ( chunk < m_chunks.size() )
+        {
+            const auto& c = m_chunks[chunk];
+            auto busy = std::any_of( m_workers.cbegin(), m_workers.cend(), [chunk]( const Worker& other ) {
+                return other.chunk == chunk;
+            } );
+            if ( c.done == false && busy == false )
+                break;
+            ++chunk;
+        }
+        if ( chunk >= m_chunks.size() )
+            break;
+
+        const auto& node = m_nodes[w.node];
+        auto args = renderArguments( node, m_chunks[chunk] );
+        QString program;
+        if ( node.host == "local" )
+            program = node.program.isEmpty() == true ? QCoreApplication::applicationFilePath() : node.program;
+        else
+        {
+            QString command = shellQuote( node.program.isEmpty() == true ? "vlmc" : node.program );
+            for ( const auto& a : args )
+                command += ' ' + shellQuote( a );
+            program = QStandardPaths::findExecutable( "ssh" );
+            args = QStringList{ "-o", "BatchMode=yes", node.host, command };
+        }
+
+        w.chunk = chunk;
+        m_chunks[chunk].rendered = 0;
+        ++m_chunks[chunk].attempts;
+        w.process = new QProcess( this );
+        // The nodes' logs end up in ours
+        w.process->setProcessChannelMode( QProcess::ForwardedErrorChannel );
+        connect( w.process, &QProcess::readyReadStandardOutput, this, [this, i] {
+            readProgress( m_workers[i] );
+        } );
+        connect( w.process, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>( &QProcess::finished ),
+                 this, [this, i]( int code, QProcess::ExitStatus status ) {
+            chunkFinished( m_workers[i], status == QProcess::NormalExit && code == 0 );
+        } );
+        vlmcDebug() << "Rendering frames" << m_chunks[chunk].begin << "to" << m_chunks[chunk].end
+                    << "on" << node.host;
+        w.process->start( program, args );
+        if ( w.process->waitForStarted() == false )
+        {
+            // Not the chunk's fault, another node may render it
+            vlmcWarning() << "Failed to start a render on" << node.host;
+            disconnect( w.process, nullptr, this, nullptr );
+            delete w.process;
+            w.process = nullptr;
+            w.chunk = -1;
+            --m_chunks[chunk].attempts;
+            m_failures[w.node] = MaxNodeFailures;
+            continue;
+        }
+        ++chunk;
+    }
+
+    auto anyBusy = std::any_of( m_workers.cbegin(), m_workers.cend(), []( const Worker& w ) {
+        return w.process != nullptr;
+    } );
+    auto anyLeft = std::any_of( m_chunks.cbegin(), m_chunks.cend(), []( const Chunk& c ) {
+        return c.done == false;
+    } );
+    if ( anyBusy == false && anyLeft == true )
+    {
+        vlmcWarning() << "No render node left to render the remaining chunks";
+        finish( false );
+    }
+}
+
+void
+DistributedRender::readProgress( Worker& worker )
+{
+    while ( worker.process->canReadLine() == true )
+    {
+        auto event = QJsonDocument::fromJson( worker.process->readLine() ).object();
+        if ( event["event"].toString() != "progress" || worker.chunk < 0 )
+            continue;
+        m_chunks[worker.chunk].rendered = event["frame"].toVariant().toLongLong();
+        qint64 frames = 0;
+        for ( const auto& c : m_chunks )
+            frames += c.done == true ? c.end - c.begin : c.rendered;
+        emit progress( frames );
+    }
+}
+
+void
+DistributedRender::chunkFinished( Worker& worker, bool success )
+{
+    auto& chunk = m_chunks[worker.chunk];
+    const auto& node = m_nodes[worker.node];
+    worker.process->deleteLater();
+    worker.process = nullptr;
+    worker.chunk = -1;
+    if ( m_running == false )
+        return;
+
+    if ( success == true && QFile::exists( chunk.fileName ) == true )
+    {
+        chunk.done = true;
+        chunk.rendered = chunk.end - chunk.begin;
+    }
+    else
+    {
+        vlmcWarning() << "Failed to render frames" << chunk.begin << "to" << chunk.end << "on" << node.host;
+        chunk.rendered = 0;
+        if ( ++m_failures[worker.node] >= MaxNodeFailures )
+            vlmcWarning() << "Not rendering on" << node.host << "anymore";
+        if ( chunk.attempts >= MaxAttempts )
+        {
+            cancel();
+            return;
+        }
+    }
+
+    if ( std::all_of( m_chunks.cbegin(), m_chunks.cend(), []( const Chunk& c ) { return c.done; } ) == true )
+        concatenate();
+    else
+        schedule();
+}
+
+void
+DistributedRender::concatenate()
+{
+    if ( m_chunks.size() == 1 )
+    {
+        QFile::remove( m_params.outputFileName );
+        finish( QFile::rename( m_chunks.first().fileName, m_params.outputFileName ) );
+        return;
+    }
+
+    auto program = QStandardPaths::findExecutable( "ffmpeg" );
+    if ( program.isEmpty() == true )
+    {
+        vlmcWarning() << "ffmpeg is required to join the rendered chunks";
+        finish( false );
+        return;
+    }
+    auto listFileName = m_chunks.first().fileName + ".txt";
+    QFile   list( listFileName );
+    if ( list.open( QFile::WriteOnly | QFile::Truncate ) == false )
+    {
+        finish( false );
+        return;
+    }
+    QTextStream stream( &list );
+    for ( const auto& c : m_chunks )
+    {
+        auto escaped = c.fileName;
+        escaped.replace( "'", "'\\''" );
+        stream << "file '" << escaped << "'\n";
+    }
+    stream.flush();
+    list.close();
+
+    m_concatenation = new QProcess( this );
+    connect( m_concatenation, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>( &QProcess::finished ),
+             this, [this]( int code, QProcess::ExitStatus status ) {
+        m_concatenation->deleteLater();
+        m_concatenation = nullptr;
+        finish( status == QProcess::NormalExit && code == 0 );
+    } );
+    m_concatenation->start( program, QStringList{ "-y", "-v", "error", "-f", "concat", "-safe", "0",
+                                                  "-i", listFileName, "-c", "copy",
+                                                  m_params.outputFileName } );
+}
+
+void
+DistributedRender::finish( bool success )
+{
+    if ( m_running == false )
+        return;
+    m_running = false;
+    if ( success == true && m_cancelled == false && hashesFrames() == true )
+        success = checkHashes();
+    emit finished( success && m_cancelled == false );
+}
@@ -0,0 +1,150 @@
+/*****************************************************************************
+ * DistributedRender.h: Splits an export accross render nodes
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef DISTRIBUTEDRENDER_H
+#define DISTRIBUTEDRENDER_H
+
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include "RenderJob.h"
+
+class QProcess;
+
+/**
+ *  \brief  Renders a project on several machines, and joins the results.
+ *
+ *  The range to render is split in GOP aligned chunks, which are dispatched to the
+ *  nodes' free slots as headless renders (vlmc --render, \sa ConsoleRenderer), run
+ *  over ssh or locally. There are more chunks than slots, so faster nodes take more of
+ *  them. A failed chunk is retried on another node, and a node failing repeatedly is
+ *  not given chunks anymore. The chunks are then remuxed into the output, like a
+ *  segmented export. \sa SegmentedExport
+ *
+ *  The nodes must see the project, the medias and the output directory, possibly at
+ *  other paths: each node lists the prefixes it has to rewrite.
+ *  When the frames are hashed, each node writes the hashes of its chunk next to it,
+ *  and they are joined once the render is done. \sa RenderParameters::frameHashFile
+ */
+class DistributedRender : public QObject
+{
+    Q_OBJECT
+
+    public:
+        struct Node
+        {
+            // ssh destination, or "local" to render on this machine
+            QString                 host;
+            // The vlmc executable on the node
+            QString                 program;
+            // Number of chunks rendered at once
+            int                     slots;
+            // Threads given to each chunk, 0 for the node's default
+            int                     threads;
+            // Local path prefix -> the node's
+            QMap<QString, QString>  paths;
+        };
+
+        /**
+         *  \brief  Reads the nodes from a JSON array of objects:
+         *
+         *  { "host": "render1", "program": "vlmc", "slots": 2, "threads": 8,
+         *    "paths": { "/home/me/videos": "/mnt/videos" } }
+         *  Only host is mandatory.
+         *  \returns    An empty list if the file can't be read.
+         */
+        static QList<Node>      loadNodes( const QString& fileName );
+
+        /**
+         *  \param  params      The output of the whole render. Its encoder options
+         *                      override the project's on every node.
+         *  \param  begin, end  The frames of the project to render, end excluded.
+         */
+        DistributedRender( const QString& projectFileName, const RenderParameters& params,
+                           qint64 begin, qint64 end, const QList<Node>& nodes,
+                           QObject* parent = nullptr );
+        // Removes the chunks
+        ~DistributedRender();
+
+        bool                    start();
+        void                    cancel();
+        qint64                  totalFrames() const;
+
+    private:
+        struct Chunk
+        {
+            qint64      begin;
+            qint64      end;
+            QString     fileName;
+            qint64      rendered;
+            int         attempts;
+            bool        done;
+        };
+
+        struct Worker
+        {
+            int         node;
+            // -1 when idle
+            int         chunk;
+            QProcess*   process;
+        };
+
+        static QString          mapPath( const Node& node, const QString& path );
+        QStringList             renderArguments( const Node& node, const Chunk& chunk ) const;
+        bool                    hashesFrames() const;
+        static QString          hashFileName( const Chunk& chunk );
+        // Joins the hashes of the chunks, and checks them against the reference ones
+        bool                    checkHashes() const;
+        // Gives the pending chunks to the idle workers
+        void                    schedule();
+        void                    readProgress( Worker& worker );
+        void                    chunkFinished( Worker& worker, bool success );
+        void                    concatenate();
+        void                    finish( bool success );
+
+    private:
+        QString                 m_projectFileName;
+        RenderParameters        m_params;
+        qint64                  m_begin;
+        qint64                  m_end;
+        qint64                  m_gopSize;
+        QList<Node>             m_nodes;
+        // Failures per node
+        QList<int>              m_failures;
+        QList<Chunk>            m_chunks;
+        QList<Worker>           m_workers;
+        QProcess*               m_concatenation;
+        bool                    m_running;
+        bool                    m_cancelled;
+
+    signals:
+        /**
+         *  \param  frames  The number of frames rendered so far, accross all nodes.
+         */
+        void                    progress( qint64 frames );
+        void                    finished( bool success );
+};
+
+#endif // DISTRIBUTEDRENDER_H
@@ -0,0 +1,265 @@
+/*****************************************************************************
+ * EditingBenchmark.cpp: Times the edits of generated timelines
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "EditingBenchmark.h"
+
+#include "Backend/MLT/MLTInput.h"
+#include "Commands/AbstractUndoStack.h"
+#include "Commands/Commands.h"
+#include "Library/Library.h"
+#include "Main/Core.h"
+#include "Media/Clip.h"
+#include "Media/Media.h"
+#include "SequenceWorkflow.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSet>
+#include <QTemporaryDir>
+
+EditingBenchmark::EditingBenchmark( const Config& config )
+    : m_config( config )
+    , m_media( nullptr )
+{
+    m_config.tracks = qMax( 1u, m_config.tracks );
+    m_config.clips = qMax( 1u, m_config.clips );
+    // Splitting a clip in its middle needs two frames
+    m_config.clipLength = qMax( 2u, m_config.clipLength );
+}
+
+EditingBenchmark::~EditingBenchmark()
+{
+    m_undoStack.reset();
+    m_sequence.reset();
+    // The library deletes its clips later, and the clips their medias
+    Core::instance()->library()->clear();
+    QCoreApplication::sendPostedEvents( nullptr, QEvent::DeferredDelete );
+}
+
+QJsonObject
+EditingBenchmark::run()
+{
+    QJsonObject results;
+    m_errors.clear();
+    import( results );
+    build( results );
+    edit( results );
+    return results;
+}
+
+const QStringList&
+EditingBenchmark::errors() const
+{
+    return m_errors;
+}
+
+void
+EditingBenchmark::import( QJsonObject& results )
+{
+    if ( m_config.imports == 0 )
+        return;
+    QTemporaryDir dir;
+    if ( dir.isValid() == false )
+    {
+        m_errors << "Can't create the files to import";
+        return;
+    }
+    // Of different sizes, for the library not to compare their contents
+    QStringList paths;
+    for ( quint32 i = 0; i < m_config.imports; ++i )
+    {
+        QFile f( dir.filePath( QString( "import%1.bin" ).arg( i ) ) );
+        if ( f.open( QFile::WriteOnly ) == false || f.write( QByteArray( i + 1, 'x' ) ) != (qint64)( i + 1 ) )
+        {
+            m_errors << QString( "Can't write %1" ).arg( f.fileName() );
+            return;
+        }
+        paths << f.fileName();
+    }
+
+    // The files aren't probed: the bookkeeping of the library is what is timed
+    auto library = Core::instance()->library();
+    QElapsedTimer timer;
+    timer.start();
+    for ( const auto& path : paths )
+    {
+        if ( library->mediaAlreadyLoaded( QFileInfo( path ) ) == true )
+        {
+            m_errors << QString( "%1 was already imported" ).arg( path );
+            continue;
+        }
+        library->addMedia( new Media( path, Backend::MLT::MLTInput::generator( "color", "#336699",
+                                                                               m_config.clipLength ) ) );
+    }
+    results["import.ms"] = timer.nsecsElapsed() / 1e6;
+    if ( library->count() != (quint32)paths.size() )
+        m_errors << QString( "%1 medias instead of %2 after importing" ).arg( library->count() )
+                    .arg( paths.size() );
+}
+
+void
+EditingBenchmark::build( QJsonObject& results )
+{
+    m_undoStack.reset( new Commands::AbstractUndoStack );
+    m_sequence.reset( new SequenceWorkflow );
+    m_media = new Media( "generated", Backend::MLT::MLTInput::generator( "color", "#336699",
+                                                                         m_config.clipLength ) );
+    Core::instance()->library()->addMedia( m_media );
+
+    // A blank as long as a clip follows each of them, for the moves to stay between neighbours
+    QElapsedTimer timer;
+    timer.start();
+    for ( quint32 i = 0; i < m_config.clips; ++i )
+    {
+        auto clip = std::make_shared<Clip>( m_media, 0, m_config.clipLength - 1 );
+        auto pos = ( i / m_config.tracks ) * 2 * m_config.clipLength;
+        if ( m_sequence->addClip( clip, i % m_config.tracks, pos ) == false )
+            m_errors << QString( "Can't add clip %1" ).arg( i );
+    }
+    results["add.ms"] = timer.nsecsElapsed() / 1e6;
+    results["clips"] = (qint64)m_config.clips;
+}
+
+void
+EditingBenchmark::edit( QJsonObject& results )
+{
+    QList<QUuid>    uuids;
+    QList<qint64>   built;
+    for ( const auto& handle : m_sequence->clipsInRange( 0, -1 ) )
+    {
+        uuids << m_sequence->clips().clip( handle )->uuid();
+        built << m_sequence->position( uuids.last() );
+    }
+    auto nbClips = uuids.size();
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<qint64>   moved;
+    for ( int i = 0; i < nbClips; ++i )
+    {
+        moved << built[i] + m_config.clipLength / 2;
+        m_undoStack->push( new Commands::Clip::Move( m_sequence, uuids[i].toString(),
+                                                     m_sequence->trackId( uuids[i] ), moved[i] ) );
+    }
+    results["move.ms"] = timer.nsecsElapsed() / 1e6;
+
+    timer.start();
+    for ( int i = 0; i < nbClips; ++i )
+    {
+        auto half = (qint64)m_sequence->clip( uuids[i] )->length() / 2;
+        m_undoStack->push( new Commands::Clip::MultiSplit( m_sequence, uuids[i],
+                                                           QList<qint64>{ moved[i] + half } ) );
+    }
+    results["split.ms"] = timer.nsecsElapsed() / 1e6;
+    check( uuids, moved, nbClips * 2, "splitting" );
+
+    // The clips kept their uuid as the left halves
+    const auto lefts = uuids.toSet();
+    QList<QUuid>    rights;
+    auto handles = m_sequence->clipsInRange( 0, -1 );
+    for ( const auto& handle : handles )
+    {
+        const auto& uuid = m_sequence->clips().clip( handle )->uuid();
+        if ( lefts.contains( uuid ) == false )
+            rights << uuid;
+    }
+
+    timer.start();
+    for ( const auto& handle : handles )
+        m_sequence->clipInfo( handle );
+    results["clipinfo.ms"] = timer.nsecsElapsed() / 1e6;
+
+    QList<qint64>   ends;
+    timer.start();
+    for ( int i = 0; i < nbClips; ++i )
+    {
+        auto clip = m_sequence->clip( uuids[i] );
+        ends << clip->end() - 1;
+        m_undoStack->push( new Commands::Clip::Resize( m_sequence, uuids[i], clip->begin(),
+                                                       ends[i], moved[i] ) );
+    }
+    results["resize.ms"] = timer.nsecsElapsed() / 1e6;
+    check( uuids, moved, nbClips * 2, "resizing" );
+    for ( int i = 0; i < nbClips; ++i )
+    {
+        auto clip = m_sequence->clip( uuids[i] );
+        if ( clip != nullptr && clip->end() != ends[i] )
+            m_errors << QString( "Clip %1 ends at %2 instead of %3 after resizing" )
+                        .arg( uuids[i].toString() ).arg( clip->end() ).arg( ends[i] );
+    }
+
+    timer.start();
+    for ( const auto& uuid : rights )
+        m_undoStack->push( new Commands::Clip::Remove( m_sequence, uuid ) );
+    results["remove.ms"] = timer.nsecsElapsed() / 1e6;
+    check( uuids, moved, nbClips, "removing" );
+
+    timer.start();
+    auto variant = m_sequence->toVariant();
+    results["snapshot.ms"] = timer.nsecsElapsed() / 1e6;
+
+    {
+        SequenceWorkflow loaded;
+        timer.start();
+        loaded.loadFromVariant( variant );
+        results["load.ms"] = timer.nsecsElapsed() / 1e6;
+        if ( loaded.clips().count() != nbClips )
+            m_errors << QString( "%1 clips instead of %2 after loading" ).arg( loaded.clips().count() )
+                        .arg( nbClips );
+    }
+
+    auto nbCommands = nbClips * 3 + rights.size();
+    timer.start();
+    for ( int i = 0; i < nbCommands; ++i )
+        m_undoStack->undo();
+    results["undo.ms"] = timer.nsecsElapsed() / 1e6;
+    check( uuids, built, nbClips, "undoing" );
+
+    timer.start();
+    for ( int i = 0; i < nbCommands; ++i )
+        m_undoStack->redo();
+    results["redo.ms"] = timer.nsecsElapsed() / 1e6;
+    check( uuids, moved, nbClips, "redoing" );
+}
+
+void
+EditingBenchmark::check( const QList<QUuid>& uuids, const QList<qint64>& positions, int count,
+                         const char* step )
+{
+    const auto& clips = m_sequence->clips();
+    if ( clips.count() != count )
+        m_errors << QString( "%1 clips instead of %2 after %3" ).arg( clips.count() ).arg( count ).arg( step );
+    for ( int i = 0; i < uuids.size(); ++i )
+    {
+        auto handle = clips.handle( uuids[i] );
+        if ( handle == ClipRegistry::InvalidHandle )
+            m_errors << QString( "Clip %1 is missing after %2" ).arg( uuids[i].toString() ).arg( step );
+        else if ( clips.position( handle ) != positions[i] )
+            m_errors << QString( "Clip %1 is at %2 instead of %3 after %4" ).arg( uuids[i].toString() )
+                        .arg( clips.position( handle ) ).arg( positions[i] ).arg( step );
+    }
+}
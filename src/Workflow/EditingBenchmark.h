@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * EditingBenchmark.h: Times the edits of generated timelines
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef EDITINGBENCHMARK_H
+#define EDITINGBENCHMARK_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QStringList>
+#include <QUuid>
+
+#include <memory>
+
+namespace Commands
+{
+class AbstractUndoStack;
+}
+class Media;
+class SequenceWorkflow;
+
+/**
+ *  \brief  Builds a timeline of clips cut from a single generated media, and times its edits.
+ *
+ *  The clips are added through SequenceWorkflow, then every one of them is moved, split
+ *  and resized, and the halves split off are removed, through the same commands as the
+ *  timeline's, which are all undone and redone. The timeline is also described as the
+ *  GUI does, saved, and loaded back in another sequence, and files are imported in the
+ *  library. Nothing is rendered: this measures the bookkeeping of an edit, which grows
+ *  with the number of clips of the timeline. The timeline is checked after each step,
+ *  and to be back to how it was built once everything is undone.
+ *
+ *  The media is added to the library of the Core, as the saved clips are loaded back
+ *  from their parent in the library.
+ */
+class EditingBenchmark
+{
+    public:
+        struct Config
+        {
+            quint32     tracks = 4;
+            quint32     clips = 1000;
+            // In frames
+            quint32     clipLength = 50;
+            // Files imported in the library
+            quint32     imports = 100;
+        };
+
+        explicit EditingBenchmark( const Config& config );
+        ~EditingBenchmark();
+
+        /**
+         *  \brief  Runs the benchmark, and returns its results, keyed by metric.
+         *
+         *  The metrics are durations in milliseconds, of all the edits of a kind.
+         *  They compare with TimelineBenchmark::regressions()
+         */
+        QJsonObject         run();
+
+        // What went wrong while editing, empty when the timeline behaved
+        const QStringList&  errors() const;
+
+    private:
+        void                import( QJsonObject& results );
+        void                build( QJsonObject& results );
+        void                edit( QJsonObject& results );
+        // Checks that the timeline has count clips, and that the uuids are at positions
+        void                check( const QList<QUuid>& uuids, const QList<qint64>& positions,
+                                   int count, const char* step );
+
+    private:
+        Config                                      m_config;
+        QStringList                                 m_errors;
+        // Owned by the library. The commands hold clips of the sequence, which are cuts of it
+        Media*                                      m_media;
+        std::shared_ptr<SequenceWorkflow>           m_sequence;
+        std::unique_ptr<Commands::AbstractUndoStack> m_undoStack;
+};
+
+#endif // EDITINGBENCHMARK_H
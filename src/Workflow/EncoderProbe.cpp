@@ -0,0 +1,173 @@
+/*****************************************************************************
+ * EncoderProbe.cpp: Detects the usable hardware video encoders
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "EncoderProbe.h"
+
+#include "Backend/IBackend.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QFileInfo>
+#include <QRunnable>
+#include <QTemporaryDir>
+#include <QThreadPool>
+
+namespace
+{
+    struct Candidates
+    {
+        const char*     software;
+        const char*     hardware[4];
+    };
+
+    // Ordered by preference
+    const Candidates    Formats[] = {
+        { "libx264", { "h264_nvenc", "h264_videotoolbox", "h264_vaapi", "h264_qsv" } },
+        { "libx265", { "hevc_nvenc", "hevc_videotoolbox", "hevc_vaapi", "hevc_qsv" } },
+    };
+}
+
+class EncoderProbeJob : public QRunnable
+{
+    public:
+        explicit EncoderProbeJob( EncoderProbe* probe ) : m_probe( probe ) {}
+        virtual void run() override { m_probe->probe(); }
+
+    private:
+        EncoderProbe*   m_probe;
+};
+
+EncoderProbe::EncoderProbe( QObject* parent )
+    : QObject( parent )
+    , m_done( false )
+    , m_started( false )
+{
+}
+
+EncoderProbe::~EncoderProbe()
+{
+    // The job holds a pointer to us
+    QMutexLocker    lock( &m_mutex );
+    while ( m_started == true && m_done == false )
+        m_doneCond.wait( &m_mutex );
+}
+
+void
+EncoderProbe::start()
+{
+    {
+        QMutexLocker    lock( &m_mutex );
+        if ( m_started == true )
+            return;
+        m_started = true;
+    }
+    QThreadPool::globalInstance()->start( new EncoderProbeJob( this ) );
+}
+
+bool
+EncoderProbe::isDone() const
+{
+    QMutexLocker    lock( &m_mutex );
+    return m_done;
+}
+
+void
+EncoderProbe::wait()
+{
+    start();
+    QMutexLocker    lock( &m_mutex );
+    if ( m_done == true )
+        return;
+    vlmcDebug() << "Waiting for the hardware encoders to be probed";
+    while ( m_done == false )
+        m_doneCond.wait( &m_mutex );
+}
+
+QStringList
+EncoderProbe::hardwareEncoders() const
+{
+    QMutexLocker    lock( &m_mutex );
+    return m_hardwareEncoders;
+}
+
+bool
+EncoderProbe::isHardwareEncoder( const QString& codec )
+{
+    for ( const auto& f : Formats )
+    {
+        for ( auto hw : f.hardware )
+        {
+            if ( codec == hw )
+                return true;
+        }
+    }
+    return false;
+}
+
+QString
+EncoderProbe::resolve( const QString& codec )
+{
+    if ( isHardwareEncoder( codec ) == true )
+        wait();
+    QMutexLocker    lock( &m_mutex );
+    for ( const auto& f : Formats )
+    {
+        for ( auto hw : f.hardware )
+        {
+            if ( codec != hw )
+                continue;
+            if ( m_hardwareEncoders.contains( codec ) == true )
+                return codec;
+            vlmcWarning() << codec << "isn't usable, falling back to" << f.software;
+            return f.software;
+        }
+    }
+    return codec;
+}
+
+void
+EncoderProbe::probe()
+{
+    QStringList     encoders;
+    QTemporaryDir   dir;
+    if ( dir.isValid() == true )
+    {
+        for ( const auto& f : Formats )
+        {
+            for ( auto hw : f.hardware )
+            {
+                auto target = dir.path() + '/' + hw + ".mkv";
+                // Failing to open the encoder leaves nothing behind
+                if ( Backend::instance()->probeVideoEncoder( hw, target.toStdString() ) == true &&
+                     QFileInfo( target ).size() > 0 )
+                    encoders << hw;
+            }
+        }
+    }
+    vlmcDebug() << "Usable hardware encoders:" << encoders;
+    {
+        QMutexLocker    lock( &m_mutex );
+        m_hardwareEncoders = encoders;
+        m_done = true;
+        m_doneCond.wakeAll();
+    }
+    emit done();
+}
@@ -0,0 +1,85 @@
+/*****************************************************************************
+ * EncoderProbe.h: Detects the usable hardware video encoders
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef ENCODERPROBE_H
+#define ENCODERPROBE_H
+
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QWaitCondition>
+
+/**
+ *  \brief  Detects which hardware video encoders actually work on this machine.
+ *
+ *  Being compiled in libavcodec isn't enough for a hardware encoder to be usable: it
+ *  also needs the matching device and driver. Each candidate is therefore probed by
+ *  encoding a few frames, once, in the background.
+ */
+class EncoderProbe : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit EncoderProbe( QObject* parent = nullptr );
+        ~EncoderProbe();
+
+        /**
+         *  \brief  Starts probing the candidates in the background
+         */
+        void                    start();
+        bool                    isDone() const;
+        // Starts the probe if needed, and blocks until it is done
+        void                    wait();
+
+        /**
+         *  \returns    The hardware encoders which passed the probe, best first.
+         */
+        QStringList             hardwareEncoders() const;
+        /**
+         *  \returns    codec, or the software encoder of the same format if codec is a
+         *              hardware encoder which isn't usable.
+         *
+         *  A hardware codec waits for the probe to be done, rather than falling back
+         *  because it wasn't probed yet.
+         */
+        QString                 resolve( const QString& codec );
+
+        static bool             isHardwareEncoder( const QString& codec );
+
+    private:
+        void                    probe();
+
+    private:
+        mutable QMutex          m_mutex;
+        QWaitCondition          m_doneCond;
+        QStringList             m_hardwareEncoders;
+        bool                    m_done;
+        bool                    m_started;
+
+        friend class EncoderProbeJob;
+
+    signals:
+        void                    done();
+};
+
+#endif // ENCODERPROBE_H
@@ -0,0 +1,148 @@
+/*****************************************************************************
+ * FrameIndexService.cpp: Indexes the frames of the medias in the background
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "FrameIndexService.h"
+
+#include "Tools/FileHash.h"
+#include "Tools/FrameIndex.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QRunnable>
+
+const QString   FrameIndexService::SubDirectory = ".frameindex";
+
+class FrameIndexJob : public QRunnable
+{
+    public:
+        FrameIndexJob( FrameIndexService* service, const QString& filePath, bool refresh )
+            : m_service( service )
+            , m_filePath( filePath )
+            , m_refresh( refresh )
+        {
+        }
+
+        virtual void run() override
+        {
+            m_service->process( m_filePath, m_refresh );
+        }
+
+    private:
+        FrameIndexService*  m_service;
+        QString             m_filePath;
+        bool                m_refresh;
+};
+
+FrameIndexService::FrameIndexService( QObject* parent )
+    : QObject( parent )
+    , m_abort( false )
+{
+    // Reading the files is the bottleneck, more threads would only make them seek
+    m_pool.setMaxThreadCount( 1 );
+}
+
+FrameIndexService::~FrameIndexService()
+{
+    m_abort = true;
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void
+FrameIndexService::setDirectory( const QString& cacheDir )
+{
+    QMutexLocker    lock( &m_mutex );
+    if ( cacheDir.isEmpty() == true )
+        m_directory.clear();
+    else
+        m_directory = cacheDir + '/' + SubDirectory;
+}
+
+void
+FrameIndexService::request( const QString& filePath )
+{
+    QMutexLocker    lock( &m_mutex );
+    if ( m_indexes.contains( filePath ) == true || m_pending.contains( filePath ) == true )
+        return;
+    m_pending.insert( filePath );
+    m_pool.start( new FrameIndexJob( this, filePath, false ) );
+}
+
+void
+FrameIndexService::refresh( const QString& filePath )
+{
+    QMutexLocker    lock( &m_mutex );
+    // The file is read up to its current end either way
+    if ( m_pending.contains( filePath ) == true )
+        return;
+    m_pending.insert( filePath );
+    m_pool.start( new FrameIndexJob( this, filePath, true ) );
+}
+
+std::shared_ptr<const Tools::FrameIndex>
+FrameIndexService::index( const QString& filePath ) const
+{
+    QMutexLocker    lock( &m_mutex );
+    return m_indexes.value( filePath );
+}
+
+QString
+FrameIndexService::indexPath( const QString& filePath ) const
+{
+    QString directory;
+    {
+        QMutexLocker    lock( &m_mutex );
+        directory = m_directory;
+    }
+    if ( directory.isEmpty() == true )
+        return QString();
+    auto hash = Tools::contentHash( filePath );
+    if ( hash.isEmpty() == true )
+        return QString();
+    return directory + '/' + QString::fromLatin1( hash ) + ".idx";
+}
+
+void
+FrameIndexService::process( const QString& filePath, bool refresh )
+{
+    auto path = refresh == false ? indexPath( filePath ) : QString();
+    std::shared_ptr<Tools::FrameIndex> index;
+    if ( refresh == true )
+    {
+        auto previous = this->index( filePath );
+        index = previous != nullptr ? Tools::FrameIndex::extend( *previous, filePath, m_abort )
+                                    : Tools::FrameIndex::build( filePath, m_abort );
+    }
+    else if ( path.isEmpty() == false )
+        index = Tools::FrameIndex::load( path );
+    if ( index == nullptr && refresh == false )
+    {
+        index = Tools::FrameIndex::build( filePath, m_abort );
+        if ( index != nullptr && path.isEmpty() == false && index->save( path ) == false )
+            vlmcWarning() << "Failed to save the frame index to" << path;
+    }
+
+    QMutexLocker    lock( &m_mutex );
+    // Medias without video, or which can't be demuxed, are tried again next session
+    m_pending.remove( filePath );
+    if ( index != nullptr )
+        m_indexes.insert( filePath, index );
+}
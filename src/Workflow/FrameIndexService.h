@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * FrameIndexService.h: Indexes the frames of the medias in the background
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef FRAMEINDEXSERVICE_H
+#define FRAMEINDEXSERVICE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+
+#include <atomic>
+#include <memory>
+
+namespace Tools
+{
+class FrameIndex;
+}
+
+/**
+ *  \brief  Builds the frame index of the medias once, in the background.
+ *
+ *  Indexes are stored in the cache directory, keyed by the media content hash, and
+ *  are reused across sessions. \sa Tools::FrameIndex
+ */
+class FrameIndexService : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static const QString    SubDirectory;
+
+        explicit FrameIndexService( QObject* parent = nullptr );
+        ~FrameIndexService();
+
+        /**
+         *  \brief  Sets the cache directory. An empty path disables the disk cache.
+         */
+        void                    setDirectory( const QString& cacheDir );
+        /**
+         *  \brief  Indexes filePath, unless it's indexed already or being indexed.
+         */
+        void                    request( const QString& filePath );
+        /**
+         *  \brief  Indexes the frames written to filePath since it was indexed, for the
+         *          files which are still being recorded.
+         *
+         *  Those indexes aren't saved, the file's content keeps changing.
+         */
+        void                    refresh( const QString& filePath );
+        /**
+         *  \returns    The index of filePath, or nullptr if it isn't available yet.
+         *
+         *  This is thread safe.
+         */
+        std::shared_ptr<const Tools::FrameIndex>    index( const QString& filePath ) const;
+
+    private:
+        void                    process( const QString& filePath, bool refresh );
+        QString                 indexPath( const QString& filePath ) const;
+
+    private:
+        QThreadPool                                                 m_pool;
+        mutable QMutex                                              m_mutex;
+        QString                                                     m_directory;
+        QHash<QString, std::shared_ptr<const Tools::FrameIndex>>    m_indexes;
+        QSet<QString>                                               m_pending;
+        std::atomic_bool                                            m_abort;
+
+        friend class FrameIndexJob;
+};
+
+#endif // FRAMEINDEXSERVICE_H
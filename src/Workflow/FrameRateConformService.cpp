@@ -0,0 +1,244 @@
+/*****************************************************************************
+ * FrameRateConformService.cpp: Conforms the medias to the project frame rate
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "FrameRateConformService.h"
+
+#include "Tools/CacheFile.h"
+#include "Tools/FileHash.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTimer>
+
+const QString   FrameRateConformService::SubDirectory = ".conformed";
+
+namespace
+{
+QString
+videoFilter( double fps, FrameRateConformService::Mode mode )
+{
+    auto rate = QString::number( fps, 'g', 8 );
+    if ( mode == FrameRateConformService::Blend )
+        return "framerate=fps=" + rate;
+    return "minterpolate=fps=" + rate + ":mi_mode=mci:mc_mode=aobmc:me_mode=bidir:vsbmc=1";
+}
+}
+
+FrameRateConformService::FrameRateConformService( QObject* parent )
+    : QObject( parent )
+    , m_process( nullptr )
+{
+}
+
+FrameRateConformService::~FrameRateConformService()
+{
+    m_pending.clear();
+    stopJob();
+}
+
+void
+FrameRateConformService::setDirectory( const QString& cacheDir )
+{
+    if ( cacheDir.isEmpty() == true )
+        m_directory.clear();
+    else
+        m_directory = cacheDir + '/' + SubDirectory;
+}
+
+QString
+FrameRateConformService::outputPath( const QString& filePath, double fps, Mode mode ) const
+{
+    if ( m_directory.isEmpty() == true )
+        return QString();
+    auto hash = Tools::contentHash( filePath );
+    if ( hash.isEmpty() == true )
+        return QString();
+    return m_directory + '/' + QString::fromLatin1( hash ) + '_' + QString::number( fps, 'g', 8 ) +
+            ( mode == Blend ? "_blend" : "_mci" ) + ".mkv";
+}
+
+void
+FrameRateConformService::request( const QString& filePath, double fps, Mode mode )
+{
+    if ( mode == Nearest )
+    {
+        drop( filePath );
+        return;
+    }
+    auto path = outputPath( filePath, fps, mode );
+    if ( path.isEmpty() == true || m_conformed.value( filePath ) == path )
+        return;
+    if ( QFile::exists( path ) == true )
+    {
+        m_conformed.insert( filePath, path );
+        emit conformed( filePath );
+        return;
+    }
+    // Another frame rate or mode may still be conformed, which doesn't match anymore
+    drop( filePath );
+    m_pending.append( Job{ filePath, path, fps, mode } );
+    schedule();
+}
+
+QString
+FrameRateConformService::conformedPath( const QString& filePath ) const
+{
+    return m_conformed.value( filePath );
+}
+
+void
+FrameRateConformService::drop( const QString& filePath )
+{
+    m_waiting.remove( filePath );
+    for ( auto it = m_pending.begin(); it != m_pending.end(); )
+    {
+        if ( it->filePath == filePath )
+            it = m_pending.erase( it );
+        else
+            ++it;
+    }
+    if ( m_process != nullptr && m_running.filePath == filePath )
+    {
+        stopJob();
+        schedule();
+    }
+    if ( m_conformed.remove( filePath ) > 0 )
+        emit conformed( filePath );
+}
+
+void
+FrameRateConformService::cancelAll()
+{
+    m_pending.clear();
+    stopJob();
+}
+
+void
+FrameRateConformService::stopJob()
+{
+    if ( m_process == nullptr )
+        return;
+    disconnect( m_process, nullptr, this, nullptr );
+    m_process->kill();
+    m_process->waitForFinished();
+    delete m_process;
+    m_process = nullptr;
+    QFile::remove( m_running.partPath );
+    m_running = Job();
+}
+
+void
+FrameRateConformService::schedule()
+{
+    // Interpolating keeps every core busy, so a single job at a time
+    if ( m_process != nullptr || m_pending.isEmpty() == true )
+        return;
+    if ( m_program.isEmpty() == true )
+        m_program = QStandardPaths::findExecutable( "ffmpeg" );
+    if ( m_program.isEmpty() == true )
+    {
+        vlmcWarning() << "ffmpeg is required to conform the frame rate of the medias";
+        m_pending.clear();
+        return;
+    }
+    while ( m_pending.isEmpty() == false )
+    {
+        auto j = m_pending.takeFirst();
+        if ( QDir().mkpath( QFileInfo( j.outputPath ).absolutePath() ) == false )
+            continue;
+        // Another workstation sharing the cache may be conforming it already
+        j.claim = Tools::CacheFile::claim( j.outputPath );
+        if ( j.claim == nullptr )
+        {
+            retry( j );
+            continue;
+        }
+        if ( QFile::exists( j.outputPath ) == true )
+        {
+            m_conformed.insert( j.filePath, j.outputPath );
+            emit conformed( j.filePath );
+            continue;
+        }
+        j.partPath = Tools::CacheFile::partPath( j.outputPath, ".mkv" );
+        m_running = j;
+        break;
+    }
+    if ( m_running.filePath.isEmpty() == true )
+        return;
+
+    m_process = new QProcess( this );
+    m_process->setProcessChannelMode( QProcess::ForwardedErrorChannel );
+    connect( m_process, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>( &QProcess::finished ),
+             this, [this]( int code, QProcess::ExitStatus status ) {
+        jobFinished( status == QProcess::NormalExit && code == 0 );
+    } );
+    // Intra-frame, as the preview seeks a lot, and the same streams otherwise
+    m_process->start( m_program, QStringList{ "-y", "-v", "error", "-i", m_running.filePath,
+                                              "-map", "0:v:0", "-map", "0:a?",
+                                              "-vf", videoFilter( m_running.fps, m_running.mode ),
+                                              "-c:v", "mjpeg", "-q:v", "2", "-c:a", "pcm_s16le",
+                                              m_running.partPath } );
+}
+
+void
+FrameRateConformService::jobFinished( bool success )
+{
+    m_process->deleteLater();
+    m_process = nullptr;
+    auto j = m_running;
+    m_running = Job();
+    if ( success == true )
+        success = Tools::CacheFile::publish( j.partPath, j.outputPath );
+    if ( success == true )
+    {
+        m_conformed.insert( j.filePath, j.outputPath );
+        emit conformed( j.filePath );
+    }
+    else
+    {
+        vlmcWarning() << "Failed to conform the frame rate of" << j.filePath;
+        QFile::remove( j.partPath );
+    }
+    schedule();
+}
+
+void
+FrameRateConformService::retry( const Job& job )
+{
+    m_waiting.insert( job.filePath, job.outputPath );
+    auto filePath = job.filePath;
+    auto path = job.outputPath;
+    auto fps = job.fps;
+    auto mode = job.mode;
+    QTimer::singleShot( Tools::CacheFile::ClaimRetry, this, [this, filePath, path, fps, mode]() {
+        // Dropped or requested in another format since
+        if ( m_waiting.value( filePath ) != path )
+            return;
+        m_waiting.remove( filePath );
+        request( filePath, fps, mode );
+    } );
+}
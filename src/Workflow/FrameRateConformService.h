@@ -0,0 +1,121 @@
+/*****************************************************************************
+ * FrameRateConformService.h: Conforms the medias to the project frame rate
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef FRAMERATECONFORMSERVICE_H
+#define FRAMERATECONFORMSERVICE_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+#include <memory>
+
+class QLockFile;
+class QProcess;
+
+/**
+ *  \brief  Converts the video of the medias to the project frame rate once, in the
+ *          background, by blending or interpolating their frames.
+ *
+ *  The backend only drops or repeats frames of a media which doesn't have the project's
+ *  frame rate. The smoother modes are too expensive to be computed while playing: ffmpeg
+ *  renders them to intra-frame files in the cache directory, keyed by the media
+ *  content hash, the frame rate and the mode, and the media decodes these from then on.
+ *  \sa Media::setConformedVideo()
+ */
+class FrameRateConformService : public QObject
+{
+    Q_OBJECT
+
+    public:
+        enum Mode
+        {
+            // Left to the backend, nothing is rendered
+            Nearest,
+            // Each frame is the mix of the two source frames around it
+            Blend,
+            // Motion compensated interpolation. Much slower than blending.
+            Interpolate,
+        };
+        static const QString    SubDirectory;
+
+        explicit FrameRateConformService( QObject* parent = nullptr );
+        ~FrameRateConformService();
+
+        /**
+         *  \brief  Sets the cache directory. An empty path disables the conforming.
+         */
+        void                    setDirectory( const QString& cacheDir );
+
+        /**
+         *  \brief  Conforms the video of filePath, unless it was conformed already.
+         *
+         *  conformed() is emitted once the file is rendered, or right away if it was in
+         *  the cache already. The Nearest mode drops the conformed video instead.
+         */
+        void                    request( const QString& filePath, double fps, Mode mode );
+        /**
+         *  \returns    The conformed video of filePath, or an empty string if there's none.
+         */
+        QString                 conformedPath( const QString& filePath ) const;
+        /**
+         *  \brief  Forgets the conformed video of filePath, and cancels its job.
+         */
+        void                    drop( const QString& filePath );
+        void                    cancelAll();
+
+    private:
+        struct Job
+        {
+            QString             filePath;
+            QString             outputPath;
+            double              fps;
+            Mode                mode;
+            QString             partPath;
+            // Held until the file is published
+            std::shared_ptr<QLockFile>  claim;
+        };
+
+        QString                 outputPath( const QString& filePath, double fps, Mode mode ) const;
+        void                    schedule();
+        void                    jobFinished( bool success );
+        void                    stopJob();
+        // Looks for the file claimed by another writer again, in a while
+        void                    retry( const Job& job );
+
+    private:
+        QString                 m_directory;
+        QString                 m_program;
+        QList<Job>              m_pending;
+        Job                     m_running;
+        QProcess*               m_process;
+        // Indexed by the original media path
+        QHash<QString, QString> m_conformed;
+        // The files claimed by other writers, indexed by the original media path
+        QHash<QString, QString> m_waiting;
+
+    signals:
+        // Emitted when the conformed video of filePath changed, or was dropped
+        void                    conformed( const QString& filePath );
+};
+
+#endif // FRAMERATECONFORMSERVICE_H
@@ -0,0 +1,268 @@
+/*****************************************************************************
+ * ImageSequenceExport.cpp: Renders a sequence to numbered image files, encoded in parallel
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ImageSequenceExport.h"
+
+#include "Backend/IInput.h"
+#include "Backend/MLT/MLTOutput.h"
+#include "Backend/MLT/MLTService.h"
+#include "Tools/Metrics.h"
+#include "Tools/VideoFrame.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThread>
+
+#include <algorithm>
+
+namespace
+{
+    // A printf style frame number, optionally zero padded
+    const QRegularExpression    FramePlaceholder( "%(0(\\d+))?d" );
+    // The frames rendered ahead of the encoders, per encoder thread
+    const int                   QueuedPerEncoder = 2;
+}
+
+class ImageWriteJob : public QRunnable
+{
+    public:
+        ImageWriteJob( ImageSequenceExport* sequence, qint64 frame,
+                       std::shared_ptr<Backend::IVideoFrame> image )
+            : m_sequence( sequence )
+            , m_frame( frame )
+            , m_image( std::move( image ) )
+        {
+        }
+
+        virtual void run() override
+        {
+            m_sequence->write( m_frame, std::move( m_image ) );
+        }
+
+    private:
+        ImageSequenceExport*                    m_sequence;
+        qint64                                  m_frame;
+        std::shared_ptr<Backend::IVideoFrame>   m_image;
+};
+
+ImageSequenceExport::ImageSequenceExport( Backend::IInput& input, const RenderParameters& params,
+                                          quint32 nbEncoders, qint64 begin, qint64 end )
+    : m_source( input )
+    , m_params( params )
+    , m_outputCallback( nullptr )
+    , m_inputCallback( nullptr )
+    , m_begin( begin )
+    , m_end( end )
+    , m_placeholder( FramePlaceholder.match( params.outputFileName ) )
+    , m_firstMissing( begin )
+    , m_nbQueued( 0 )
+    , m_failed( false )
+    , m_nextFrame( begin )
+    , m_currentFrame( begin )
+    , m_stopping( false )
+{
+    m_encoders.setMaxThreadCount( nbEncoders > 0 ? nbEncoders : QThread::idealThreadCount() );
+    m_done.fill( false, std::max( 0ll, end - begin ) );
+}
+
+ImageSequenceExport::~ImageSequenceExport()
+{
+    stop();
+    m_output.reset();
+    m_encoders.waitForDone();
+}
+
+bool
+ImageSequenceExport::isImageSequence( const QString& fileName )
+{
+    if ( FramePlaceholder.match( fileName ).hasMatch() == false )
+        return false;
+    auto format = QFileInfo( fileName ).suffix().toLower().toLatin1();
+    return QImageWriter::supportedImageFormats().contains( format );
+}
+
+void
+ImageSequenceExport::setCallbacks( Backend::IOutputEventCb* output, Backend::IInputEventCb* input )
+{
+    m_outputCallback = output;
+    m_inputCallback = input;
+}
+
+QString
+ImageSequenceExport::fileName( qint64 frame ) const
+{
+    auto path = m_params.outputFileName;
+    auto width = m_placeholder.captured( 2 ).toInt();
+    return path.replace( m_placeholder.capturedStart(), m_placeholder.capturedLength(),
+                         QString( "%1" ).arg( frame, width, 10, QChar( '0' ) ) );
+}
+
+bool
+ImageSequenceExport::start()
+{
+    if ( m_placeholder.hasMatch() == false )
+        return false;
+    // Resume after the files of a previous export
+    for ( auto frame = m_begin; frame < m_end; ++frame )
+        m_done[frame - m_begin] = QFile::exists( fileName( frame ) );
+    while ( m_firstMissing < m_end && m_done[m_firstMissing - m_begin] == true )
+        ++m_firstMissing;
+    if ( m_firstMissing == m_end )
+        return true;
+    if ( m_firstMissing > m_begin )
+        vlmcDebug() << "Resuming the image sequence from frame" << m_firstMissing;
+    if ( QDir().mkpath( QFileInfo( fileName( m_firstMissing ) ).absolutePath() ) == false )
+    {
+        vlmcWarning() << "Can't create the directory of" << m_params.outputFileName;
+        return false;
+    }
+
+    try
+    {
+        m_input = m_source.clone();
+        m_input->setBoundaries( m_firstMissing, m_end - 1 );
+        m_output.reset( new Backend::MLT::MLTNullOutput( std::max( 1, m_params.encoder.renderThreads ) ) );
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Failed to set up the rendering of the image sequence";
+        m_input.reset();
+        m_output.reset();
+        return false;
+    }
+    m_output->setSize( m_params.width, m_params.height );
+    m_nextFrame = m_firstMissing;
+    if ( m_inputCallback != nullptr )
+        m_input->setCallback( m_inputCallback );
+    if ( m_outputCallback != nullptr )
+        m_output->setCallback( m_outputCallback );
+    m_output->setFrameCallback( this );
+    if ( m_output->connect( *m_input ) == false )
+        return false;
+    m_input->setPosition( 0 );
+    m_output->start();
+    return true;
+}
+
+void
+ImageSequenceExport::stop()
+{
+    {
+        QMutexLocker    lock( &m_lock );
+        m_stopping = true;
+        m_written.wakeAll();
+    }
+    if ( m_output != nullptr )
+        m_output->stop();
+}
+
+void
+ImageSequenceExport::waitForWrites()
+{
+    m_encoders.waitForDone();
+}
+
+bool
+ImageSequenceExport::isComplete() const
+{
+    QMutexLocker    lock( &m_lock );
+    return m_firstMissing == m_end && m_failed == false;
+}
+
+bool
+ImageSequenceExport::hasFailed() const
+{
+    QMutexLocker    lock( &m_lock );
+    return m_failed;
+}
+
+qint64
+ImageSequenceExport::writtenFrames() const
+{
+    QMutexLocker    lock( &m_lock );
+    return m_firstMissing - m_begin;
+}
+
+bool
+ImageSequenceExport::wantsImage( int64_t )
+{
+    // No frame is dropped, and they come in order: they are counted rather than
+    // converted from the position
+    m_currentFrame = m_nextFrame++;
+    if ( m_currentFrame >= m_end || m_stopping == true )
+        return false;
+    QMutexLocker    lock( &m_lock );
+    return m_done[m_currentFrame - m_begin] == false;
+}
+
+void
+ImageSequenceExport::onImage( std::shared_ptr<Backend::IVideoFrame> frame )
+{
+    {
+        QMutexLocker    lock( &m_lock );
+        // Hold the rendering back, rather than piling the frames up in memory
+        while ( m_nbQueued >= m_encoders.maxThreadCount() * QueuedPerEncoder && m_stopping == false )
+            m_written.wait( &m_lock );
+        if ( m_stopping == true )
+            return;
+        ++m_nbQueued;
+    }
+    m_encoders.start( new ImageWriteJob( this, m_currentFrame, std::move( frame ) ) );
+}
+
+void
+ImageSequenceExport::write( qint64 frame, std::shared_ptr<Backend::IVideoFrame> image )
+{
+    static auto& timing = Tools::Metrics::histogram( "export.imageWrite" );
+    Tools::Metrics::ScopedTimer timer( timing );
+    // Only renamed once complete, for the export to be resumed
+    auto path = fileName( frame );
+    QSaveFile   file( path );
+    auto success = file.open( QIODevice::WriteOnly ) == true &&
+            QImageWriter( &file, QFileInfo( path ).suffix().toLower().toLatin1() )
+                .write( Tools::toQImage( std::move( image ) ) ) == true &&
+            file.commit() == true;
+    if ( success == false )
+        vlmcWarning() << "Failed to write" << path;
+    done( frame, success );
+}
+
+void
+ImageSequenceExport::done( qint64 frame, bool success )
+{
+    QMutexLocker    lock( &m_lock );
+    --m_nbQueued;
+    if ( success == true )
+    {
+        m_done[frame - m_begin] = true;
+        while ( m_firstMissing < m_end && m_done[m_firstMissing - m_begin] == true )
+            ++m_firstMissing;
+    }
+    else
+        m_failed = true;
+    m_written.wakeAll();
+}
@@ -0,0 +1,138 @@
+/*****************************************************************************
+ * ImageSequenceExport.h: Renders a sequence to numbered image files, encoded in parallel
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef IMAGESEQUENCEEXPORT_H
+#define IMAGESEQUENCEEXPORT_H
+
+#include <QMutex>
+#include <QRegularExpression>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "Backend/IOutput.h"
+#include "RenderJob.h"
+
+#include <atomic>
+#include <memory>
+
+namespace Backend
+{
+class IInput;
+class IInputEventCb;
+class IVideoFrame;
+namespace MLT
+{
+class MLTNullOutput;
+}
+}
+
+/**
+ *  \brief  Renders a sequence to one image file per frame, such as "shot_%04d.png".
+ *
+ *  The frames are rendered once, in order, and handed to a pool of encoder threads
+ *  which write the files concurrently. Each file is written to a temporary name and
+ *  renamed once complete, so a file which exists is a complete frame: an export
+ *  started again skips them, and only renders from the first missing one.
+ *  The formats are those Qt can write: PNG, and TIFF or EXR with the matching image
+ *  plugins. There is no audio.
+ */
+class ImageSequenceExport : private Backend::IOutputFrameCb
+{
+    public:
+        /**
+         *  \param  nbEncoders  The number of files written at once. 0 picks one per core.
+         *  \param  begin, end  The frames of input to export, end excluded.
+         */
+        ImageSequenceExport( Backend::IInput& input, const RenderParameters& params,
+                             quint32 nbEncoders, qint64 begin, qint64 end );
+        // Waits for the files being written
+        ~ImageSequenceExport();
+
+        /**
+         *  \brief  Tells if fileName has a frame number placeholder, as in "%04d", and
+         *          an image format Qt can write.
+         */
+        static bool             isImageSequence( const QString& fileName );
+
+        void                    setCallbacks( Backend::IOutputEventCb* output,
+                                              Backend::IInputEventCb* input );
+        /**
+         *  \brief  Starts rendering from the first frame which isn't written yet. Returns
+         *          false if it can't. When every frame exists, the output isn't started
+         *          and nothing is left to do.
+         */
+        bool                    start();
+        void                    stop();
+        /**
+         *  \brief  Waits for the frames already rendered to be written. To be called
+         *          once the output stopped.
+         */
+        void                    waitForWrites();
+        bool                    isComplete() const;
+        // Whether a file couldn't be written. The export should then be stopped.
+        bool                    hasFailed() const;
+        /**
+         *  \returns    The number of consecutive frames written from the first one.
+         */
+        qint64                  writtenFrames() const;
+
+    private:
+        QString                 fileName( qint64 frame ) const;
+        virtual bool            wantsImage( int64_t position ) override;
+        virtual void            onImage( std::shared_ptr<Backend::IVideoFrame> frame ) override;
+        // Called from the encoder threads
+        void                    write( qint64 frame, std::shared_ptr<Backend::IVideoFrame> image );
+        void                    done( qint64 frame, bool success );
+
+    private:
+        Backend::IInput&                                    m_source;
+        std::unique_ptr<Backend::IInput>                    m_input;
+        std::unique_ptr<Backend::MLT::MLTNullOutput>        m_output;
+        RenderParameters                                    m_params;
+        Backend::IOutputEventCb*                            m_outputCallback;
+        Backend::IInputEventCb*                             m_inputCallback;
+        qint64                                              m_begin;
+        qint64                                              m_end;
+        QRegularExpressionMatch                             m_placeholder;
+        QThreadPool                                         m_encoders;
+
+        mutable QMutex                                      m_lock;
+        // Signaled whenever a file got written
+        QWaitCondition                                      m_written;
+        // One per frame of the range: whether its file exists
+        QVector<bool>                                       m_done;
+        // The first frame left to write, all the previous ones are done
+        qint64                                              m_firstMissing;
+        int                                                 m_nbQueued;
+        bool                                                m_failed;
+
+        // Accessed from the output thread
+        qint64                                              m_nextFrame;
+        qint64                                              m_currentFrame;
+        std::atomic_bool                                    m_stopping;
+
+        friend class ImageWriteJob;
+};
+
+#endif // IMAGESEQUENCEEXPORT_H
@@ -29,6 +29,8 @@
 #include "vlmc.h"
 #include "Commands/Commands.h"
 #include "Commands/AbstractUndoStack.h"
+#include "Backend/IBackend.h"
+#include "Backend/IProfile.h"
 #include "Backend/MLT/MLTOutput.h"
 #include "Backend/MLT/MLTMultiTrack.h"
 #include "Backend/MLT/MLTTrack.h"
@@ -36,59 +38,177 @@
 #ifdef HAVE_GUI
 #include "EffectsEngine/EffectHelper.h"
 #include "Gui/effectsengine/EffectStack.h"
-#include "Gui/WorkflowFileRendererDialog.h"
 #endif
 #include "Project/Project.h"
 #include "Media/Clip.h"
 #include "Media/Media.h"
 #include "Library/Library.h"
+#include "Main/Core.h"
 #include "MainWorkflow.h"
 #include "Project/Project.h"
+#include "ClipPrefetcher.h"
+#include "Consolidation.h"
+#include "EncoderProbe.h"
+#include "PreviewCache.h"
+#include "AudioMeters.h"
+#include "RenderJob.h"
+#include "RenderQueue.h"
 #include "SequenceWorkflow.h"
+#include "StabilizationService.h"
+#include "StillExport.h"
+#include "TimelineImport.h"
+#include "TrimPreview.h"
 #include "Settings/Settings.h"
+#include "Tools/Metrics.h"
+#include "Tools/NestedSequence.h"
 #include "Tools/VlmcDebug.h"
 #include "Tools/RendererEventWatcher.h"
-#include "Tools/OutputEventWatcher.h"
+#include "Tools/Trace.h"
+#include "Tools/VideoFrame.h"
 #include "Workflow/Types.h"
-#include "ThumbnailWorker.h"
+#include "ThumbnailService.h"
 
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
 #include <QMutex>
+#include <QSet>
 
-MainWorkflow::MainWorkflow( Settings* projectSettings, int trackCount ) :
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+MainWorkflow::MainWorkflow( Settings* projectSettings, Library* library,
+                            ThumbnailService* thumbnailService, int trackCount ) :
         m_trackCount( trackCount ),
         m_settings( new Settings ),
         m_renderer( new AbstractRenderer ),
         m_undoStack( new Commands::AbstractUndoStack ),
-        m_sequenceWorkflow( new SequenceWorkflow( trackCount ) )
+        m_undoLimit( 0 ),
+        m_undoLiveSteps( 0 ),
+        m_sequenceWorkflow( new SequenceWorkflow( trackCount ) ),
+        m_previewCache( new PreviewCache( m_sequenceWorkflow->input() ) ),
+        m_audioMeters( new AudioMeters( m_previewCache->input(), m_sequenceWorkflow.get() ) ),
+        m_prefetcher( new ClipPrefetcher( m_sequenceWorkflow, trackCount ) ),
+        m_thumbnailService( thumbnailService ),
+        m_library( library ),
+        m_batching( false ),
+        m_consolidation( nullptr ),
+        m_stillExport( nullptr ),
+        m_journalSeq( 0 )
 {
-    m_renderer->setInput( m_sequenceWorkflow->input() );
+    m_renderer->setInput( m_previewCache->input() );
+
+    auto transition = projectSettings->value( "video/Transition" );
+    auto transitionChanged = [this]( const QVariant& style )
+    {
+        auto s = style.toString();
+        m_sequenceWorkflow->setTransitionStyle( s == "none" ? SequenceWorkflow::NoTransition :
+                                                s == "wipe" ? SequenceWorkflow::Wipe :
+                                                              SequenceWorkflow::Dissolve );
+    };
+    connect( transition, &SettingValue::changed, this, transitionChanged );
+    transitionChanged( transition->get() );
+    connect( m_sequenceWorkflow.get(), &SequenceWorkflow::changed, m_previewCache.get(), &PreviewCache::invalidate );
+    connect( m_sequenceWorkflow.get(), &SequenceWorkflow::changed, m_renderer, &AbstractRenderer::invalidateLoop );
+    connect( m_sequenceWorkflow.get(), &SequenceWorkflow::frozenChanged, this, [this]( const QUuid& uuid, bool frozen )
+    {
+        emit clipRenderedInPlace( uuid.toString(), frozen );
+    } );
+    connect( m_sequenceWorkflow.get(), &SequenceWorkflow::trackChanged, this, [this]( quint32 trackId, qint64, qint64 )
+    {
+        emit trackChanged( trackId );
+    } );
+    connect( this, &MainWorkflow::clipResized, this, [this]
+    {
+        if ( m_trimPreview != nullptr && m_trimPreview->update() == false )
+            m_trimPreview.reset();
+    } );
 
     connect( m_renderer->eventWatcher(), &RendererEventWatcher::lengthChanged, this, &MainWorkflow::lengthChanged );
     connect( m_renderer->eventWatcher(), &RendererEventWatcher::endReached, this, &MainWorkflow::mainWorkflowEndReached );
     connect( m_renderer->eventWatcher(), &RendererEventWatcher::positionChanged, this, [this]( qint64 pos )
+    {
+        m_previewCache->setPlayhead( pos );
+        m_prefetcher->setPlayhead( pos );
+    } );
+    // Drives the timeline cursor, which doesn't need more than one update per refresh
+    connect( m_renderer->eventWatcher(), &RendererEventWatcher::displayPositionChanged, this, [this]( qint64 pos )
     {
         emit frameChanged( pos, Vlmc::Renderer );
     } );
+    // The audio clips are read from their PCM caches while scrubbing, which are looked
+    // up once per gesture
+    connect( m_renderer, &AbstractRenderer::scrubbingChanged, this, [this]( bool scrubbing )
+    {
+        if ( scrubbing == true )
+            m_sequenceWorkflow->updateScrubSources();
+    } );
+    // A paused preview keeps rendering the current frame, the cache waits for a full stop
+    connect( m_renderer->eventWatcher(), &RendererEventWatcher::playing, this, [this]
+    {
+        m_previewCache->setIdle( false );
+        m_prefetcher->setPlaying( true );
+    } );
+    connect( m_renderer->eventWatcher(), &RendererEventWatcher::stopped, this, [this]
+    {
+        m_previewCache->setIdle( true );
+        m_prefetcher->setPlaying( false );
+    } );
 
     m_settings->createVar( SettingValue::List, "tracks", QVariantList(), "", "", SettingValue::Nothing );
+    m_settings->createVar( SettingValue::String, "journalSeq", "0", "", "", SettingValue::Nothing );
     connect( m_settings, &Settings::postLoad, this, &MainWorkflow::postLoad, Qt::DirectConnection );
     connect( m_settings, &Settings::preSave, this, &MainWorkflow::preSave, Qt::DirectConnection );
+    connect( m_settings, &Settings::preSnapshot, this, &MainWorkflow::preSnapshot, Qt::DirectConnection );
     projectSettings->addSettings( "Workspace", *m_settings );
 
     connect( m_undoStack.get(), &Commands::AbstractUndoStack::cleanChanged, this, &MainWorkflow::cleanChanged );
+    connect( m_undoStack.get(), &Commands::AbstractUndoStack::indexChanged, this, &MainWorkflow::journalChanges );
+    connect( m_undoStack.get(), &Commands::AbstractUndoStack::indexChanged, this, &MainWorkflow::releaseHistory );
+    // Asynchronous saves notify from the writer thread
+    connect( projectSettings, &Settings::saved, this, &MainWorkflow::compactJournal );
 }
 
 MainWorkflow::~MainWorkflow()
 {
+    for ( auto job : m_freezeJobs )
+    {
+        auto path = job->parameters().outputFileName;
+        delete job;
+        QFile::remove( path );
+    }
+    m_trimPreview.reset();
     m_renderer->stop();
     delete m_renderer;
     delete m_settings;
 }
 
+void
+MainWorkflow::muteTrack( unsigned int trackId, Workflow::TrackType trackType )
+{
+    m_sequenceWorkflow->setTrackMuted( trackId, trackType, true );
+}
+
 void
 MainWorkflow::unmuteTrack( unsigned int trackId, Workflow::TrackType trackType )
 {
-    // TODO
+    m_sequenceWorkflow->setTrackMuted( trackId, trackType, false );
+}
+
+void
+MainWorkflow::setTrackGain( quint32 trackId, double gainDb )
+{
+    m_sequenceWorkflow->setTrackGain( trackId, std::pow( 10., gainDb / 20. ) );
+}
+
+void
+MainWorkflow::setTrackPan( quint32 trackId, double pan )
+{
+    m_sequenceWorkflow->setTrackPan( trackId, pan );
 }
 
 void
@@ -118,7 +238,24 @@ MainWorkflow::trigger( Commands::Generic* command )
 void
 MainWorkflow::clear()
 {
+    m_thumbnailService->cancelAll();
+    m_previewCache->clearRegions();
+    // Its medias are about to be deleted
+    delete m_consolidation;
+    m_consolidation = nullptr;
+    m_trimPreview.reset();
     m_sequenceWorkflow->clear();
+    // Closing without saving discards the edits
+    m_journal.remove();
+    m_journalSeq = 0;
+    m_snapshotSeqs.clear();
+    m_markers.clear();
+    m_stabilizations.clear();
+#ifdef HAVE_GUI
+    // The history belongs to the closed project
+    m_undoStack->clear();
+    m_undoStack->setUndoLimit( m_undoLimit );
+#endif
     emit cleared();
 }
 
@@ -137,15 +274,64 @@ MainWorkflow::setPosition( qint64 newFrame )
 void
 MainWorkflow::setFps( double fps )
 {
-    Backend::instance()->profile().setFrameRate( fps * 100, 100 );
+    auto& profile = Backend::instance()->profile();
+    auto oldFps = profile.fps();
+    if ( Core::instance()->project()->isLoading() == true || oldFps <= 0. )
+    {
+        profile.setFrameRate( fps * 100, 100 );
+        emit fpsChanged( fps );
+        return;
+    }
+    // The consumer and the loops run at the previous rate
+    m_trimPreview.reset();
+    m_renderer->setLoop( 0, 0 );
+    m_renderer->stop();
+    profile.setFrameRate( fps * 100, 100 );
+    auto ratio = profile.fps() / oldFps;
+    if ( qFuzzyCompare( ratio, 1. ) == false )
+    {
+        m_library->rescale( ratio );
+        const auto rescaled = m_sequenceWorkflow->rescale( ratio );
+        m_previewCache->invalidate( 0 );
+        std::multiset<qint64>   markers;
+        for ( auto marker : m_markers )
+            markers.insert( qRound64( marker * ratio ) );
+        m_markers = markers;
+#ifdef HAVE_GUI
+        m_undoStack->clear();
+#endif
+        for ( const auto& uuid : rescaled )
+            emit clipResized( uuid.toString() );
+        emit rescaled( ratio );
+    }
     emit fpsChanged( fps );
 }
 
+void
+MainWorkflow::setResolution( unsigned int width, unsigned int height )
+{
+    auto& profile = Backend::instance()->profile();
+    if ( (unsigned int)profile.width() == width && (unsigned int)profile.height() == height )
+        return;
+    m_renderer->stop();
+    profile.setWidth( width );
+    profile.setHeight( height );
+    if ( Core::instance()->project()->isLoading() == true )
+        return;
+    // The loops only serve the images of the size requested, the others just use memory
+    m_previewCache->invalidate( 0 );
+    m_renderer->invalidateLoop( 0 );
+}
+
 void
 MainWorkflow::showEffectStack()
 {
 #ifdef HAVE_GUI
     auto w = new EffectStack( m_sequenceWorkflow->input() );
+    connect( w, &EffectStack::changed, this, [this]
+    {
+        m_sequenceWorkflow->filterChanged( m_sequenceWorkflow->input(), 0, -1 );
+    } );
     w->show();
 #endif
 }
@@ -155,6 +341,10 @@ MainWorkflow::showEffectStack( quint32 trackId )
 {
 #ifdef HAVE_GUI
     auto w = new EffectStack( m_sequenceWorkflow->trackInput( trackId ) );
+    connect( w, &EffectStack::changed, this, [this, trackId]
+    {
+        m_sequenceWorkflow->filterChanged( m_sequenceWorkflow->trackInput( trackId ), 0, -1 );
+    } );
     w->show();
 #endif
 }
@@ -164,6 +354,12 @@ MainWorkflow::showEffectStack( const QString& uuid )
 {
 #ifdef HAVE_GUI
     auto w = new EffectStack( m_sequenceWorkflow->clip( uuid )->input() );
+    connect( w, &EffectStack::changed, this, [this, uuid]
+    {
+        auto clip = m_sequenceWorkflow->clip( uuid );
+        if ( clip != nullptr )
+            filterChanged( clip->input(), 0, -1 );
+    } );
     connect( w, &EffectStack::finished, Core::instance()->workflow(), [uuid]{ emit Core::instance()->workflow()->effectsUpdated( uuid ); } );
     w->show();
 #endif
@@ -175,12 +371,60 @@ MainWorkflow::renderer()
     return m_renderer;
 }
 
+PreviewCache*
+MainWorkflow::previewCache()
+{
+    return m_previewCache.get();
+}
+
+AudioMeters*
+MainWorkflow::audioMeters()
+{
+    return m_audioMeters.get();
+}
+
+void
+MainWorkflow::filterChanged( const Backend::IInput* target, qint64 begin, qint64 end )
+{
+    m_sequenceWorkflow->filterChanged( target, begin, end );
+    if ( m_trimPreview != nullptr )
+        m_trimPreview->filterChanged( target );
+}
+
 Commands::AbstractUndoStack*
 MainWorkflow::undoStack()
 {
     return m_undoStack.get();
 }
 
+void
+MainWorkflow::setUndoBudget( int limit, int liveSteps )
+{
+    m_undoLimit = limit;
+    m_undoLiveSteps = liveSteps;
+#ifdef HAVE_GUI
+    // QUndoStack ignores a new limit while it holds commands
+    if ( m_undoStack->count() == 0 )
+        m_undoStack->setUndoLimit( limit );
+#endif
+    releaseHistory();
+}
+
+void
+MainWorkflow::releaseHistory()
+{
+#ifdef HAVE_GUI
+    for ( int i = 0; i < m_undoStack->index() - m_undoLiveSteps; ++i )
+    {
+        auto command = const_cast<QUndoCommand*>( m_undoStack->command( i ) );
+        static_cast<Commands::Generic*>( command )->release();
+    }
+    // Only the live steps hold on to their clips and effects
+    static auto& history = Tools::Metrics::memory( "undo.commands" );
+    history.set( 0, m_undoStack->count() );
+#endif
+}
+
 int
 MainWorkflow::getTrackCount() const
 {
@@ -211,10 +455,177 @@ MainWorkflow::addClip( const QString& uuid, quint32 trackId, qint32 pos, bool is
     return QUuid().toString();
 }
 
+QStringList
+MainWorkflow::addClips( const QStringList& uuids, quint32 trackId, qint64 pos, bool audio, bool video )
+{
+    QList<QUuid>    libraryUuids;
+    for ( const auto& uuid : uuids )
+        libraryUuids << QUuid( uuid );
+    auto command = new Commands::Clip::AddMany( m_sequenceWorkflow, libraryUuids, trackId, pos, audio, video );
+    trigger( command );
+    QStringList newClips;
+    for ( const auto& uuid : command->newClips() )
+    {
+        if ( m_sequenceWorkflow->clip( uuid ) )
+            newClips << uuid;
+    }
+    return newClips;
+}
+
+bool
+MainWorkflow::importTimeline( const QString& path, QString* error )
+{
+    static auto& timing = Tools::Metrics::histogram( "edit.importTimeline" );
+    Tools::Metrics::ScopedTimer timer( timing );
+
+    auto fps = Backend::instance()->profile().fps();
+    QList<TimelineImport::Event>    events;
+    QString                         reason;
+    if ( TimelineImport::parse( path, fps, events, reason ) == false )
+    {
+        vlmcWarning() << "Couldn't import" << path << ':' << reason;
+        if ( error != nullptr )
+            *error = reason;
+        return false;
+    }
+    QStringList paths;
+    for ( const auto& e : events )
+    {
+        if ( paths.contains( e.path ) == false )
+            paths << e.path;
+    }
+    auto libraryClips = m_library->importMedias( paths );
+
+    // Source timecodes of an EDL count from 01:00:00:00, when the medias don't have one
+    const qint64                    hour = qRound64( fps * 3600 );
+    auto                            offset = playableLength();
+    QList<SequenceWorkflow::ClipTuple>  clips;
+    QHash<int, QPair<QUuid, QUuid>> links;
+    for ( const auto& e : events )
+    {
+        auto libraryClip = libraryClips[paths.indexOf( e.path )];
+        if ( libraryClip == nullptr || e.trackId >= m_trackCount )
+            continue;
+        auto format = e.type == Workflow::AudioTrack ? Clip::Audio : Clip::Video;
+        if ( libraryClip->formats().testFlag( format ) == false )
+            continue;
+        auto mediaLength = libraryClip->length();
+        auto begin = e.begin;
+        if ( e.sourceTimecode == true && begin + e.length > mediaLength )
+            begin %= hour;
+        begin = qBound( 0ll, begin, mediaLength - 1 );
+        auto length = std::min( e.length, mediaLength - begin );
+        auto clip = std::make_shared<Clip>( libraryClip, begin, begin + length - 1 );
+        clip->setFormats( format );
+        clips << std::make_tuple( clip, e.trackId, offset + e.position );
+        if ( e.link < 0 )
+            continue;
+        auto& link = links[e.link];
+        ( format == Clip::Audio ? link.first : link.second ) = clip->uuid();
+    }
+    QList<QPair<QUuid, QUuid>>      pairs;
+    for ( const auto& l : links )
+    {
+        if ( l.first.isNull() == false && l.second.isNull() == false )
+            pairs << l;
+    }
+    vlmcDebug() << "Importing" << clips.size() << "clips out of" << events.size() << "events from" << path;
+    trigger( new Commands::Clip::AddMany( m_sequenceWorkflow, clips, pairs ) );
+    return true;
+}
+
+bool
+MainWorkflow::consolidate( const QString& directory, qint64 handles )
+{
+    if ( m_consolidation != nullptr )
+        return false;
+    m_consolidation = new Consolidation( Core::instance()->jobScheduler(), this );
+    auto ranges = m_sequenceWorkflow->mediaRanges();
+    for ( auto it = ranges.cbegin(); it != ranges.cend(); ++it )
+        m_consolidation->add( it.key(), it.value() );
+    connect( m_consolidation, &Consolidation::progress, this, &MainWorkflow::consolidationProgress );
+    connect( m_consolidation, &Consolidation::finished, this, &MainWorkflow::consolidated );
+    if ( m_consolidation->start( directory, handles, Backend::instance()->profile().fps() ) == false )
+    {
+        delete m_consolidation;
+        m_consolidation = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void
+MainWorkflow::consolidated( bool success )
+{
+    if ( success == true )
+    {
+        for ( const auto& s : m_consolidation->sources() )
+        {
+            auto pieces = s.pieces;
+            auto map = [pieces]( qint64 frame ) { return Consolidation::map( pieces, frame ); };
+            m_sequenceWorkflow->remapMedia( s.media, map );
+            // Cuts the timeline clips again too, through mediaOnline()
+            m_library->relinkMedia( s.media, s.copyPath, map );
+        }
+#ifdef HAVE_GUI
+        // They refer to the frames of the original medias
+        m_undoStack->clear();
+#endif
+    }
+    m_consolidation->deleteLater();
+    m_consolidation = nullptr;
+    emit consolidationFinished( success );
+}
+
+bool
+MainWorkflow::exportFrame( const QString& fileName )
+{
+    return exportStills( QList<qint64>{ m_renderer->getCurrentFrame() }, fileName );
+}
+
+bool
+MainWorkflow::exportMarkerFrames( const QString& fileName )
+{
+    QList<qint64>   positions;
+    for ( auto pos : m_markers )
+        positions.append( pos );
+    return exportStills( positions, fileName );
+}
+
+bool
+MainWorkflow::exportStills( const QList<qint64>& positions, const QString& fileName )
+{
+    if ( m_stillExport != nullptr )
+        return false;
+    // The snapshot the preview cache renders from spares stopping the preview
+    auto sequence = m_previewCache->sequenceSnapshot();
+    if ( sequence == nullptr )
+    {
+        m_renderer->stop();
+        sequence = m_sequenceWorkflow->input();
+    }
+    auto project = Core::instance()->project();
+    m_stillExport = new StillExport( Core::instance()->jobScheduler(), this );
+    connect( m_stillExport, &StillExport::progress, this, &MainWorkflow::stillExportProgress );
+    connect( m_stillExport, &StillExport::finished, this, [this]( bool success ) {
+        auto fileNames = m_stillExport->fileNames();
+        m_stillExport->deleteLater();
+        m_stillExport = nullptr;
+        emit stillsExported( success, fileNames );
+    });
+    if ( m_stillExport->start( *sequence, positions, fileName, project->width(), project->height() ) == false )
+    {
+        delete m_stillExport;
+        m_stillExport = nullptr;
+        return false;
+    }
+    return true;
+}
+
 QJsonObject
 MainWorkflow::clipInfo( const QString& uuid )
 {
-    auto lClip = Core::instance()->library()->clip( uuid );
+    auto lClip = m_library->clip( uuid );
     if ( lClip != nullptr )
     {
         auto h = lClip->toVariant().toHash();
@@ -230,29 +641,138 @@ MainWorkflow::clipInfo( const QString& uuid )
         return QJsonObject::fromVariantHash( h );
     }
 
-    auto clip = m_sequenceWorkflow->clip( uuid );
-    if ( !clip )
+    auto handle = m_sequenceWorkflow->clipHandle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
         return QJsonObject();
+    return m_sequenceWorkflow->clipInfo( handle );
+}
+
+QJsonArray
+MainWorkflow::clipsInfo( qint64 begin, qint64 end ) const
+{
+    QJsonArray  res;
+    for ( auto handle : m_sequenceWorkflow->clipsInRange( begin, end ) )
+        res.append( m_sequenceWorkflow->clipInfo( handle ) );
+    return res;
+}
 
-    auto h = clip->toVariant().toHash();
-    h["length"] = (qint64)( clip->input()->length() );
-    h["name"] = clip->media()->fileName();
-    h["audio"] = clip->formats().testFlag( Clip::Audio );
-    h["video"] = clip->formats().testFlag( Clip::Video );
-    h["position"] = m_sequenceWorkflow->position( uuid );
-    h["trackId"] = m_sequenceWorkflow->trackId( uuid );
-    return QJsonObject::fromVariantHash( h );
+QStringList
+MainWorkflow::clipsInRange( qint64 begin, qint64 end ) const
+{
+    QStringList res;
+    const auto& clips = m_sequenceWorkflow->clips();
+    for ( auto handle : m_sequenceWorkflow->clipsInRange( begin, end ) )
+        res << clips.clip( handle )->uuid().toString();
+    return res;
+}
+
+std::shared_ptr<const SequenceWorkflow::IndexSnapshot>
+MainWorkflow::indexSnapshot() const
+{
+    return m_sequenceWorkflow->indexSnapshot();
 }
 
 void
 MainWorkflow::moveClip( const QString& uuid, quint32 trackId, qint64 startFrame )
 {
+    if ( m_batching == true )
+    {
+        m_batch << SequenceWorkflow::ClipEdit{ uuid, trackId, startFrame, -1, -1 };
+        return;
+    }
     trigger( new Commands::Clip::Move( m_sequenceWorkflow, uuid, trackId, startFrame ) );
 }
 
+void
+MainWorkflow::beginBatch()
+{
+    m_batching = true;
+}
+
+void
+MainWorkflow::commitBatch()
+{
+    m_batching = false;
+    if ( m_batch.isEmpty() == true )
+        return;
+    trigger( new Commands::Clip::EditMany( m_sequenceWorkflow, m_batch ) );
+    m_batch.clear();
+}
+
+qint64
+MainWorkflow::freePosition( const QString& uuid, bool isAudioClip, quint32 trackId,
+                            qint64 startFrame, qint64 length, qint64 margin )
+{
+    return m_sequenceWorkflow->freePosition( isAudioClip == true ? Workflow::AudioTrack : Workflow::VideoTrack,
+                                             trackId, startFrame, length, QUuid( uuid ), margin );
+}
+
+qint64
+MainWorkflow::snapPosition( const QString& uuid, bool isAudioClip, quint32 trackId, qint64 startFrame,
+                            qint64 length, qint64 margin, qint64 cursor )
+{
+    auto type = isAudioClip == true ? Workflow::AudioTrack : Workflow::VideoTrack;
+    QUuid ignore( uuid );
+    startFrame = qMax( 0ll, startFrame );
+    auto index = m_sequenceWorkflow->clipIndex( type, trackId );
+
+    // Offset to apply to the clip so that one of its ends sticks to the closest edge
+    qint64  best = 0;
+    qint64  bestDistance = margin + 1;
+    auto    consider = [&best, &bestDistance]( qint64 from, qint64 edge )
+    {
+        if ( edge < 0 || qAbs( edge - from ) >= bestDistance )
+            return;
+        bestDistance = qAbs( edge - from );
+        best = edge - from;
+    };
+    for ( auto from : { startFrame, startFrame + length } )
+    {
+        if ( index != nullptr )
+            consider( from, index->nearestEdge( from, margin, ignore ) );
+        consider( from, cursor );
+        // The closest markers are on each side of the first one after from
+        auto it = m_markers.lower_bound( from );
+        if ( it != m_markers.end() )
+            consider( from, *it );
+        if ( it != m_markers.begin() )
+            consider( from, *std::prev( it ) );
+    }
+    if ( bestDistance > margin )
+        best = 0;
+    return m_sequenceWorkflow->freePosition( type, trackId, qMax( 0ll, startFrame + best ), length, ignore );
+}
+
+void
+MainWorkflow::addMarker( qint64 position )
+{
+    m_markers.insert( position );
+}
+
+void
+MainWorkflow::removeMarker( qint64 position )
+{
+    auto it = m_markers.find( position );
+    if ( it != m_markers.end() )
+        m_markers.erase( it );
+}
+
+void
+MainWorkflow::moveMarker( qint64 from, qint64 to )
+{
+    removeMarker( from );
+    addMarker( to );
+}
+
 void
 MainWorkflow::resizeClip( const QString& uuid, qint64 newBegin, qint64 newEnd, qint64 newPos )
 {
+    if ( m_batching == true )
+    {
+        m_batch << SequenceWorkflow::ClipEdit{ uuid, m_sequenceWorkflow->trackId( uuid ),
+                                               newPos, newBegin, newEnd };
+        return;
+    }
     trigger( new Commands::Clip::Resize( m_sequenceWorkflow, uuid, newBegin, newEnd, newPos ) );
 }
 
@@ -263,9 +783,209 @@ MainWorkflow::removeClip( const QString& uuid )
 }
 
 void
-MainWorkflow::splitClip( const QUuid& uuid, qint64 newClipPos, qint64 newClipBegin )
+MainWorkflow::removeClips( const QStringList& uuids )
+{
+    QList<QUuid>    l;
+    for ( const auto& uuid : uuids )
+        l << QUuid( uuid );
+    trigger( new Commands::Clip::RemoveMany( m_sequenceWorkflow, l ) );
+}
+
+void
+MainWorkflow::groupClips( const QStringList& uuids )
+{
+    QList<QUuid>    l;
+    for ( const auto& uuid : uuids )
+        l << QUuid( uuid );
+    m_sequenceWorkflow->groupClips( l );
+}
+
+void
+MainWorkflow::ungroupClips( const QString& uuid )
+{
+    m_sequenceWorkflow->ungroupClips( uuid );
+}
+
+QStringList
+MainWorkflow::clipGroup( const QString& uuid ) const
+{
+    QStringList res;
+    for ( const auto& member : m_sequenceWorkflow->group( uuid ) )
+        res << member.toString();
+    return res;
+}
+
+QStringList
+MainWorkflow::syncClips( const QStringList& uuids )
+{
+    QList<QUuid>    clips;
+    for ( const auto& uuid : uuids )
+        clips << QUuid( uuid );
+    auto positions = m_sequenceWorkflow->audioSyncPositions( clips );
+
+    // The reference's group stays in place, and a group only moves once
+    QSet<QUuid>     moved;
+    for ( const auto& member : m_sequenceWorkflow->group( clips.value( 0 ) ) )
+        moved.insert( member );
+    QStringList     failed;
+    beginBatch();
+    for ( int i = 1; i < clips.size(); ++i )
+    {
+        if ( moved.contains( clips[i] ) == true )
+            continue;
+        auto it = positions.find( clips[i] );
+        if ( it == positions.end() )
+        {
+            failed << uuids[i];
+            continue;
+        }
+        auto delta = it.value() - m_sequenceWorkflow->position( clips[i] );
+        auto group = m_sequenceWorkflow->group( clips[i] );
+        if ( group.isEmpty() == true )
+            group << clips[i];
+        for ( const auto& member : group )
+        {
+            if ( moved.contains( member ) == true )
+                continue;
+            moved.insert( member );
+            moveClip( member.toString(), m_sequenceWorkflow->trackId( member ),
+                      m_sequenceWorkflow->position( member ) + delta );
+        }
+    }
+    commitBatch();
+    return failed;
+}
+
+void
+MainWorkflow::splitClipAt( const QString& uuid, const QVariantList& positions )
+{
+    QList<qint64>   l;
+    for ( const auto& p : positions )
+        l << p.toLongLong();
+    trigger( new Commands::Clip::MultiSplit( m_sequenceWorkflow, uuid, l ) );
+}
+
+QStringList
+MainWorkflow::nestClips( const QStringList& uuids )
+{
+    QList<QUuid>    clips;
+    for ( const auto& uuid : uuids )
+    {
+        auto clip = m_sequenceWorkflow->clip( uuid );
+        if ( !clip )
+            continue;
+        if ( clips.contains( clip->uuid() ) == false )
+            clips << clip->uuid();
+        if ( clip->isLinked() == true && m_sequenceWorkflow->clip( clip->linkedClipUuid() ) &&
+             clips.contains( clip->linkedClipUuid() ) == false )
+            clips << clip->linkedClipUuid();
+    }
+    if ( clips.isEmpty() == true )
+        return QStringList();
+
+    // The nested sequence starts with its first clip, on its first track
+    qint64  begin = std::numeric_limits<qint64>::max();
+    qint64  end = 0;
+    quint32 trackId = std::numeric_limits<quint32>::max();
+    for ( const auto& uuid : clips )
+    {
+        auto handle = m_sequenceWorkflow->clipHandle( uuid );
+        const auto& registry = m_sequenceWorkflow->clips();
+        begin = std::min<qint64>( begin, registry.position( handle ) );
+        end = std::max<qint64>( end, registry.position( handle ) + registry.clip( handle )->length() );
+        trackId = std::min( trackId, registry.trackId( handle ) );
+    }
+    QVariantList    variants;
+    bool            hasAudio = false;
+    bool            hasVideo = false;
+    for ( const auto& uuid : clips )
+    {
+        auto handle = m_sequenceWorkflow->clipHandle( uuid );
+        const auto& registry = m_sequenceWorkflow->clips();
+        auto clip = registry.clip( handle );
+        auto h = clip->toVariant().toHash();
+        h.insert( "position", registry.position( handle ) - begin );
+        h.insert( "trackId", registry.trackId( handle ) );
+        variants << h;
+        if ( SequenceWorkflow::trackType( *clip ) == Workflow::AudioTrack )
+            hasAudio = true;
+        else
+            hasVideo = true;
+    }
+
+    Tools::NestedSequence   sequence;
+    {
+        SequenceWorkflow    nested( m_trackCount );
+        nested.loadFromVariant( QVariantHash{ { "clips", variants } } );
+        if ( nested.clips().count() != clips.count() )
+        {
+            vlmcWarning() << "Can't nest clips whose medias are missing";
+            return QStringList();
+        }
+        sequence.tracks = nested.toVariant();
+        sequence.graph = QByteArray::fromStdString( nested.input()->snapshot() );
+    }
+    sequence.nbFrames = end - begin;
+    sequence.hasAudio = hasAudio;
+    sequence.hasVideo = hasVideo;
+    auto media = m_library->addNestedSequence( sequence );
+    if ( media == nullptr )
+        return QStringList();
+
+    auto command = new Commands::Clip::Nest( m_sequenceWorkflow, clips, media->baseClip()->uuid(),
+                                             trackId, begin );
+    trigger( command );
+    QStringList newClips;
+    for ( const auto& uuid : command->newClips() )
+    {
+        if ( m_sequenceWorkflow->clip( uuid ) )
+            newClips << uuid;
+    }
+    return newClips;
+}
+
+void
+MainWorkflow::rippleRemoveClip( const QString& uuid )
+{
+    trigger( new Commands::Clip::RippleRemove( m_sequenceWorkflow, uuid ) );
+}
+
+void
+MainWorkflow::rippleInsertClip( const QString& uuid, quint32 trackId, qint64 pos, bool isAudioClip )
+{
+    trigger( new Commands::Clip::RippleInsert( m_sequenceWorkflow, uuid, trackId, pos, isAudioClip ) );
+}
+
+void
+MainWorkflow::rollClip( const QString& uuid, qint64 delta )
+{
+    trigger( new Commands::Clip::Roll( m_sequenceWorkflow, uuid, delta ) );
+}
+
+void
+MainWorkflow::slipClip( const QString& uuid, qint64 delta )
+{
+    trigger( new Commands::Clip::Slip( m_sequenceWorkflow, uuid, delta ) );
+}
+
+void
+MainWorkflow::slideClip( const QString& uuid, qint64 delta )
+{
+    trigger( new Commands::Clip::Slide( m_sequenceWorkflow, uuid, delta ) );
+}
+
+void
+MainWorkflow::startTrimPreview( const QString& uuid )
 {
-    trigger( new Commands::Clip::Split( m_sequenceWorkflow, uuid, newClipPos, newClipBegin ) );
+    m_trimPreview.reset( new TrimPreview( m_sequenceWorkflow, m_renderer, uuid ) );
+    if ( m_trimPreview->update() == false )
+        m_trimPreview.reset();
+}
+
+void
+MainWorkflow::stopTrimPreview()
+{
+    m_trimPreview.reset();
 }
 
 void
@@ -274,8 +994,183 @@ MainWorkflow::linkClips( const QString& uuidA, const QString& uuidB )
     trigger( new Commands::Clip::Link( m_sequenceWorkflow, uuidA, uuidB ) );
 }
 
+void
+MainWorkflow::setClipSpeed( const QString& uuid, double speed, bool frameBlending )
+{
+    trigger( new Commands::Clip::Retime( m_sequenceWorkflow, uuid, speed, frameBlending ) );
+    auto clip = m_sequenceWorkflow->clip( uuid );
+    if ( clip == nullptr || clip->frameBlending() == false ||
+         clip->speed() <= 0. || clip->speed() >= 1. )
+        return;
+    auto pos = m_sequenceWorkflow->position( uuid );
+    m_previewCache->addRegion( pos, pos + clip->length() );
+}
+
+void
+MainWorkflow::renderInPlace( const QString& uuid )
+{
+    auto clip = m_sequenceWorkflow->clip( uuid );
+    if ( clip == nullptr || m_freezeJobs.contains( uuid ) == true )
+        return;
+    auto dir = VLMC_GET_STRING( "vlmc/WorkspaceLocation" );
+    if ( dir.isEmpty() == true )
+        dir = QDir::tempPath();
+    dir += "/.rendered";
+    if ( QDir().mkpath( dir ) == false )
+    {
+        vlmcWarning() << "Can't create" << dir;
+        return;
+    }
+
+    auto& profile = Backend::instance()->profile();
+    RenderParameters params;
+    params.outputFileName = dir + '/' + clip->uuid().toString().mid( 1, 36 ) + ".mkv";
+    params.width = profile.width();
+    params.height = profile.height();
+    params.fps = profile.fps();
+    params.aspectNum = profile.aspectRatioNum();
+    params.aspectDen = profile.aspectRatioDen();
+    // Twice the preview chunks' bitrate, as the rendition also ends up in the exports
+    params.videoBitrate = profile.width() * profile.height() * profile.fps() * 4 / 1000;
+    params.audioBitrate = 256;
+    params.nbChannels = 2;
+    params.sampleRate = 48000;
+    // Intra frames only, so that seeking and trimming the rendition stays cheap
+    params.encoder.videoCodec = "mjpeg";
+    params.encoder.audioCodec = "pcm_s16le";
+    params.encoder.gopSize = 1;
+
+    // The clip is copied when the job starts, it must not be played meanwhile
+    m_renderer->stop();
+    m_sequenceWorkflow->prepareFreeze( clip->uuid() );
+    auto job = new RenderJob( params, 1, this );
+    auto clipUuid = clip->uuid();
+    connect( job, &RenderJob::finished, this, [this, job, clipUuid]( bool success )
+    {
+        m_freezeJobs.remove( clipUuid );
+        job->deleteLater();
+        auto path = job->parameters().outputFileName;
+        if ( success == false || m_sequenceWorkflow->freezeClip( clipUuid, path ) == false )
+            QFile::remove( path );
+    } );
+    if ( job->start( *clip->input() ) == false )
+    {
+        vlmcWarning() << "Failed to render clip" << uuid << "in place";
+        delete job;
+        m_sequenceWorkflow->thawClip( clipUuid );
+        return;
+    }
+    m_freezeJobs.insert( clipUuid, job );
+}
+
+void
+MainWorkflow::revertRenderInPlace( const QString& uuid )
+{
+    auto job = m_freezeJobs.take( uuid );
+    if ( job != nullptr )
+    {
+        auto path = job->parameters().outputFileName;
+        // Stops the encoder synchronously, finished() won't be emitted
+        delete job;
+        QFile::remove( path );
+    }
+    m_sequenceWorkflow->thawClip( uuid );
+}
+
+bool
+MainWorkflow::isRenderedInPlace( const QString& uuid ) const
+{
+    return m_freezeJobs.contains( uuid ) == true || m_sequenceWorkflow->isFrozen( uuid ) == true;
+}
+
+bool
+MainWorkflow::stabilizeClip( const QString& uuid, bool onProxy )
+{
+    auto clip = m_sequenceWorkflow->clip( uuid );
+    if ( clip == nullptr || clip->input() == nullptr || clip->input()->hasVideo() == false )
+        return false;
+    Stabilization s{ clip->media()->fileInfo()->absoluteFilePath(), clip->begin(), clip->end() };
+    // Inserted first, as the transforms may exist already, and be notified right away
+    m_stabilizations.insert( clip->uuid(), s );
+    if ( Core::instance()->stabilizationService()->request( s.filePath, s.begin, s.end, onProxy ) == false )
+    {
+        m_stabilizations.remove( clip->uuid() );
+        return false;
+    }
+    return true;
+}
+
+void
+MainWorkflow::stabilizationAnalyzed( const QString& filePath, qint64 begin, qint64 end, bool success )
+{
+    for ( auto it = m_stabilizations.begin(); it != m_stabilizations.end(); )
+    {
+        if ( it->filePath != filePath || it->begin != begin || it->end != end )
+        {
+            ++it;
+            continue;
+        }
+        auto clip = m_sequenceWorkflow->clip( it.key() );
+        it = m_stabilizations.erase( it );
+        // The clip may have been trimmed meanwhile, the transforms wouldn't match anymore
+        if ( success == false || clip == nullptr || clip->begin() != begin || clip->end() != end )
+            continue;
+        auto path = Core::instance()->stabilizationService()->transformsPath( filePath, begin, end );
+        if ( path.isEmpty() == true )
+            continue;
+
+        std::shared_ptr<EffectHelper> helper;
+        try
+        {
+            helper.reset( new EffectHelper( StabilizationService::FilterId ) );
+        }
+        catch ( Backend::InvalidServiceException& )
+        {
+            vlmcWarning() << "Can't create the stabilization filter";
+            return;
+        }
+        // As a parameter, so that it's saved along with the project. With the results,
+        // the filter applies them instead of analyzing the frames again.
+        auto results = helper->value( "results" );
+        if ( results == nullptr )
+        {
+            vlmcWarning() << "The stabilization filter can't be given its transforms";
+            return;
+        }
+        results->set( path );
+        trigger( new Commands::Effect::Add( helper, clip->input() ) );
+        emit effectsUpdated( clip->uuid().toString() );
+    }
+}
+
 QString
 MainWorkflow::addEffect( const QString &clipUuid, const QString &effectId )
+{
+    auto clip = m_sequenceWorkflow->clip( clipUuid );
+    if ( clip == nullptr || clip->input() == nullptr )
+        return QStringLiteral( "" );
+    auto uuid = addEffect( clip->input(), effectId );
+    if ( uuid.isEmpty() == false )
+        emit effectsUpdated( clipUuid );
+    return uuid;
+}
+
+QString
+MainWorkflow::addTrackEffect( quint32 trackId, const QString& effectId )
+{
+    if ( trackId >= m_trackCount )
+        return QStringLiteral( "" );
+    return addEffect( m_sequenceWorkflow->trackInput( trackId ), effectId );
+}
+
+QString
+MainWorkflow::addSequenceEffect( const QString& effectId )
+{
+    return addEffect( m_sequenceWorkflow->input(), effectId );
+}
+
+QString
+MainWorkflow::addEffect( Backend::IInput* target, const QString& effectId )
 {
     std::shared_ptr<EffectHelper> newEffect;
 
@@ -288,106 +1183,364 @@ MainWorkflow::addEffect( const QString &clipUuid, const QString &effectId )
         return QStringLiteral( "" );
     }
 
-    auto clip = m_sequenceWorkflow->clip( clipUuid );
-    if ( clip && clip->input() )
+    trigger( new Commands::Effect::Add( newEffect, target ) );
+    return newEffect->uuid().toString();
+}
+
+void
+MainWorkflow::takeThumbnail( const QString& uuid, quint32 pos, quint32 width, quint32 height,
+                             bool visible )
+{
+    auto clip = m_sequenceWorkflow->clip( uuid );
+    if ( clip == nullptr )
+        return;
+    thumbnailSize( clip->input(), width, height );
+    m_thumbnailService->request( uuid, clip->media()->fileInfo()->absoluteFilePath(),
+                                 pos, width, height,
+                                 visible == true ? ThumbnailService::High : ThumbnailService::Low );
+}
+
+QVariantList
+MainWorkflow::takeFilmstrip( const QString& uuid, quint32 count, quint32 width, quint32 height,
+                             bool visible )
+{
+    QVariantList    ret;
+    auto clip = m_sequenceWorkflow->clip( uuid );
+    if ( clip == nullptr || count == 0 )
+        return ret;
+    thumbnailSize( clip->input(), width, height );
+
+    QVector<qint64> positions;
+    for ( quint32 i = 0; i < count; ++i )
     {
-        trigger( new Commands::Effect::Add( newEffect, clip->input() ) );
-        emit effectsUpdated( clipUuid );
-        return newEffect->uuid().toString();
+        auto pos = clip->begin() + clip->length() * i / count;
+        positions.append( pos );
+        ret.append( pos );
     }
-
-    return QStringLiteral( "" );
+    m_thumbnailService->request( uuid, clip->media()->fileInfo()->absoluteFilePath(),
+                                 positions, width, height,
+                                 visible == true ? ThumbnailService::High : ThumbnailService::Low );
+    return ret;
 }
 
 void
-MainWorkflow::takeThumbnail( const QString& uuid, quint32 pos )
+MainWorkflow::thumbnailSize( const Backend::IInput* input, quint32& width, quint32& height )
 {
-    auto clip = m_sequenceWorkflow->clip( uuid );
-    auto worker = new ThumbnailWorker( uuid, clip->media()->fileInfo()->absoluteFilePath(),
-                                       pos, clip->input()->width(), clip->input()->height() );
-    auto t = new QThread;
-    worker->moveToThread( t );
-    connect( t, &QThread::started, worker, &ThumbnailWorker::run );
-    connect( worker, &ThumbnailWorker::imageReady, this, &MainWorkflow::thumbnailUpdated, Qt::DirectConnection );
-    connect( worker, &ThumbnailWorker::imageReady, t, &QThread::quit );
-    connect( t, &QThread::finished, worker, &ThumbnailWorker::deleteLater );
-    connect( t, &QThread::finished, t, &QThread::deleteLater );
-    t->start();
+    // Never upscale, and preserve the source aspect ratio when only one side is given
+    if ( height == 0 || height > (quint32)input->height() )
+        height = input->height();
+    if ( width == 0 || width > (quint32)input->width() )
+        width = input->height() > 0 ? height * input->width() / input->height() : input->width();
 }
 
 bool
+MainWorkflow::parseAspectRatio( const QString& ar, int& num, int& den )
+{
+    auto parts = ar.split( '/' );
+    if ( parts.size() != 2 )
+        return false;
+    bool numOk;
+    bool denOk;
+    auto n = parts[0].trimmed().toInt( &numOk );
+    auto d = parts[1].trimmed().toInt( &denOk );
+    if ( numOk == false || denOk == false || n <= 0 || d <= 0 )
+        return false;
+    num = n;
+    den = d;
+    return true;
+}
+
+RenderJob*
 MainWorkflow::startRenderToFile( const QString &outputFileName, quint32 width, quint32 height,
                                  double fps, const QString &ar, quint32 vbitrate, quint32 abitrate,
-                                 quint32 nbChannels, quint32 sampleRate )
+                                 quint32 nbChannels, quint32 sampleRate, qint64 begin, qint64 end,
+                                 bool streamable )
+{
+    int aspectNum;
+    int aspectDen;
+    if ( parseAspectRatio( ar, aspectNum, aspectDen ) == false )
+    {
+        vlmcCritical() << "Invalid aspect ratio" << ar;
+        return nullptr;
+    }
+    RenderParameters params{ outputFileName, width, height, fps,
+                aspectNum, aspectDen, vbitrate, abitrate, nbChannels, sampleRate,
+                Core::instance()->project()->encoderOptions() };
+    params.encoder.fragmented = streamable;
+
+    auto jobs = startRender( { params }, begin, end );
+    if ( jobs.isEmpty() == true )
+        return nullptr;
+    return jobs.first();
+}
+
+RenderJob*
+MainWorkflow::startStemExport( const QString& masterFileName, const QList<StemParameters>& stems,
+                               qint64 begin, qint64 end )
 {
+    if ( stems.isEmpty() == true )
+        return nullptr;
+    auto project = Core::instance()->project();
+    int aspectNum;
+    int aspectDen;
+    if ( parseAspectRatio( project->aspectRatio(), aspectNum, aspectDen ) == false )
+    {
+        vlmcCritical() << "Invalid aspect ratio" << project->aspectRatio();
+        return nullptr;
+    }
+    RenderParameters params{ masterFileName, project->width(), project->height(), project->fps(),
+                aspectNum, aspectDen, 0, 0,
+                project->nbChannels(), project->sampleRate(), project->encoderOptions() };
+    params.stems = stems;
+    auto jobs = startRender( { params }, begin, end );
+    if ( jobs.isEmpty() == true )
+        return nullptr;
+    return jobs.first();
+}
+
+QList<RenderJob*>
+MainWorkflow::startRender( QList<RenderParameters> renditions, qint64 begin, qint64 end )
+{
+    // The sequence is copied when the jobs are queued, it must not be played meanwhile
     m_renderer->stop();
+    // Placeholders would get rendered in place of the medias still being opened
+    m_library->waitForMedias();
 
     if ( canRender() == false )
-        return false;
+        return {};
 
-    Backend::MLT::MLTFFmpegOutput output;
-    auto input = m_sequenceWorkflow->input();
-    OutputEventWatcher            cEventWatcher;
-    output.setCallback( &cEventWatcher );
-    output.setTarget( qPrintable( outputFileName ) );
-    output.setWidth( width );
-    output.setHeight( height );
-    output.setFrameRate( fps * 100, 100 );
-    auto temp = ar.split( "/" );
-    output.setAspectRatio( temp[0].toInt(), temp[1].toInt() );
-    output.setVideoBitrate( vbitrate );
-    output.setAudioBitrate( abitrate );
-    output.setChannels( nbChannels );
-    output.setAudioSampleRate( sampleRate );
-    output.connect( *input );
+    // A file which is read while it's rendered must be written in order, in a single
+    // pass: neither segments nor passthrough ranges are concatenated afterward
+    bool streamable = false;
+    // Two pass encodes analyze the whole sequence, in order, before encoding it
+    bool twoPass = false;
+    for ( const auto& params : renditions )
+    {
+        streamable = streamable || params.encoder.fragmented;
+        twoPass = twoPass || params.encoder.twoPass;
+    }
 
-#ifdef HAVE_GUI
-    WorkflowFileRendererDialog  dialog( width, height, input->playableLength(), m_renderer->eventWatcher() );
-    dialog.setModal( true );
-    dialog.setOutputFileName( outputFileName );
-    connect( &cEventWatcher, &OutputEventWatcher::stopped, &dialog, &WorkflowFileRendererDialog::accept );
-    connect( &dialog, &WorkflowFileRendererDialog::stop, this, [&output]{ output.stop(); } );
-    connect( m_renderer->eventWatcher(), &RendererEventWatcher::positionChanged, &dialog,
-             [this, input, &dialog, width, height]( qint64 pos )
-    {
-        // Update the preview per five seconds
-        if ( pos % qRound( input->fps() * 5 ) == 0 )
-        {
-            dialog.updatePreview( input->image( width, height ) );
-        }
-    });
-#endif
+    // From the loudness each media got measured with, rather than from a first pass
+    // over the rendered audio
+    auto project = Core::instance()->project();
+    auto normalize = project->normalizeLoudness();
+    if ( normalize == true )
+    {
+        auto nbUnmeasured = m_sequenceWorkflow->setLoudnessNormalization( true, project->loudnessTarget() );
+        if ( nbUnmeasured > 0 )
+            vlmcWarning() << nbUnmeasured << "audio clips aren't normalized, their loudness isn't measured yet";
+    }
 
-    connect( &cEventWatcher, &OutputEventWatcher::stopped, this, [&output]{ output.stop(); } );
-    connect( this, &MainWorkflow::mainWorkflowEndReached, this, [&output]{ output.stop(); } );
+    // The passthrough ranges are planned for the whole sequence. Their audio is copied,
+    // and can't be normalized.
+    auto smartRender = end < 0 && streamable == false && twoPass == false && normalize == false &&
+            VLMC_GET_BOOL( "vlmc/SmartRender" );
+    for ( auto& params : renditions )
+    {
+        params.encoder.videoCodec = Core::instance()->encoderProbe()->resolve(
+                    QString::fromStdString( params.encoder.videoCodec ) ).toStdString();
+        if ( smartRender == true && params.stems.isEmpty() == true )
+            params.passthrough = m_sequenceWorkflow->passthroughRanges();
+        if ( params.encoder.twoPass == true )
+            params.encoder.passLogFile = passLogFile( params, begin, end ).toStdString();
+    }
+    auto nbWorkers = VLMC_GET_UINT( "vlmc/RenderWorkers" );
+    if ( streamable == true || twoPass == true )
+        nbWorkers = 1;
+    Tools::Trace::add( Tools::Trace::RenderStarted, renditions.size(), this );
+    auto jobs = Core::instance()->renderQueue()->enqueue( *m_sequenceWorkflow->input(),
+                                                          renditions, nbWorkers, begin, end );
+    // The jobs have their own copy, the preview plays the clips at their level
+    if ( normalize == true )
+        m_sequenceWorkflow->setLoudnessNormalization( false, 0 );
+    return jobs;
+}
 
-    input->setPosition( 0 );
-    output.start();
+QString
+MainWorkflow::passLogFile( const RenderParameters& params, qint64 begin, qint64 end ) const
+{
+    auto dir = VLMC_GET_STRING( "vlmc/WorkspaceLocation" );
+    if ( dir.isEmpty() == true )
+        return QString();
+    dir += "/.passlogs";
+    if ( QDir().mkpath( dir ) == false )
+        return QString();
+    std::string document;
+    try
+    {
+        document = m_sequenceWorkflow->input()->toXml();
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        return QString();
+    }
+    QCryptographicHash  hash( QCryptographicHash::Sha1 );
+    hash.addData( document.data(), document.size() );
+    const auto& encoder = params.encoder;
+    auto settings = QString( "%1:%2 %3x%4@%5 %6k %7 %8 %9 %10" ).arg( begin ).arg( end )
+            .arg( params.width ).arg( params.height ).arg( params.fps ).arg( params.videoBitrate )
+            .arg( QString::fromStdString( encoder.videoCodec ), QString::fromStdString( encoder.preset ),
+                  QString::fromStdString( encoder.pixelFormat ) ).arg( encoder.gopSize );
+    hash.addData( settings.toUtf8() );
+    return dir + '/' + QString::fromLatin1( hash.result().toHex() );
+}
 
-#ifdef HAVE_GUI
-    if ( dialog.exec() == QDialog::Rejected )
+bool
+MainWorkflow::exportMltXml( const QString& fileName, qint64 begin, qint64 end )
+{
+    // The document would reference the placeholders of the medias being opened
+    m_library->waitForMedias();
+    if ( end < 0 || end > playableLength() )
+        end = playableLength();
+    if ( end <= begin )
         return false;
-#else
-    while ( output.isStopped() == false )
-        SleepS( 1 );
-#endif
+    std::string document;
+    try
+    {
+        // The preview's boundaries are left alone
+        auto copy = m_sequenceWorkflow->input()->clone();
+        copy->setBoundaries( begin, end - 1 );
+        document = copy->toXml();
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Can't serialize the sequence";
+        return false;
+    }
+    QFile file( fileName );
+    if ( file.open( QFile::WriteOnly | QFile::Truncate ) == false ||
+         file.write( document.data(), document.size() ) != (qint64)document.size() )
+    {
+        vlmcWarning() << "Can't write" << fileName << ':' << file.errorString();
+        return false;
+    }
     return true;
 }
 
+QStringList
+MainWorkflow::exportMltXmlRanges( const QString& fileName, qint64 rangeLength, qint64 begin, qint64 end )
+{
+    if ( end < 0 || end > playableLength() )
+        end = playableLength();
+    if ( rangeLength <= 0 || end <= begin )
+        return {};
+    QFileInfo   info( fileName );
+    auto suffix = info.suffix().isEmpty() == true ? QStringLiteral( "mlt" ) : info.suffix();
+    QStringList files;
+    for ( qint64 pos = begin, i = 1; pos < end; pos += rangeLength, ++i )
+    {
+        auto path = info.dir().filePath( QStringLiteral( "%1-%2.%3" ).arg( info.completeBaseName() )
+                                         .arg( i, 4, 10, QChar( '0' ) ).arg( suffix ) );
+        if ( exportMltXml( path, pos, qMin( end, pos + rangeLength ) ) == false )
+            return {};
+        files << path;
+    }
+    return files;
+}
+
 bool
 MainWorkflow::canRender()
 {
-    return m_sequenceWorkflow->input()->playableLength() > 0;
+    return playableLength() > 0;
+}
+
+qint64
+MainWorkflow::playableLength()
+{
+    return m_sequenceWorkflow->input()->playableLength();
+}
+
+Backend::IInput*
+MainWorkflow::sequenceInput()
+{
+    return m_sequenceWorkflow->input();
 }
 
 void
 MainWorkflow::preSave()
 {
+    preSnapshot();
+    m_snapshotSeqs.enqueue( m_journalSeq );
+}
+
+void
+MainWorkflow::preSnapshot()
+{
+    // Edits made outside of a command, such as grouping clips, get their own record
+    journalChanges();
     m_settings->value( "tracks" )->set( m_sequenceWorkflow->toVariant() );
+    m_settings->value( "journalSeq" )->set( QString::number( m_journalSeq ) );
 }
 
 void
 MainWorkflow::postLoad()
 {
     m_sequenceWorkflow->loadFromVariant( m_settings->value( "tracks" )->get() );
+    m_journalSeq = m_settings->value( "journalSeq" )->get().toString().toULongLong();
+    vlmcDebug() << "Loaded" << m_sequenceWorkflow->clips().count() << "clips, with"
+                << Backend::instance()->nbDecoders() << "decoders alive";
+    emit clipsLoaded();
+}
+
+void
+MainWorkflow::mediaOnline( Media* media )
+{
+    auto nbReloaded = m_sequenceWorkflow->reloadMedia( media );
+    if ( nbReloaded > 0 )
+        vlmcDebug() << "Reloaded" << nbReloaded << "clips of" << media->fileInfo()->fileName();
+}
+
+void
+MainWorkflow::mediaGrown( Media* media, qint64 oldLength )
+{
+    // Not an edit of the user: nothing to undo
+    for ( const auto& uuid : m_sequenceWorkflow->growMedia( media, oldLength ) )
+        emit clipResized( uuid.toString() );
+}
+
+void
+MainWorkflow::journalChanges()
+{
+    auto changes = m_sequenceWorkflow->takeChanges();
+    if ( changes.isEmpty() == true || m_journal.isOpen() == false )
+        return;
+    m_journal.append( ++m_journalSeq, changes );
+}
+
+void
+MainWorkflow::compactJournal( bool saved )
+{
+    if ( m_snapshotSeqs.isEmpty() == true )
+        return;
+    auto seq = m_snapshotSeqs.dequeue();
+    if ( saved == true && m_journal.isOpen() == true )
+        m_journal.compact( seq );
+}
+
+int
+MainWorkflow::openJournal( const QString& fileName )
+{
+    m_journal.close();
+    if ( m_journal.open( fileName ) == false )
+        return 0;
+    auto records = m_journal.records( m_journalSeq );
+    for ( const auto& record : records )
+    {
+        // New edits are numbered after the replayed ones, for the next replay to include them
+        m_journalSeq = record.seq;
+        m_sequenceWorkflow->applyChanges( record.changes );
+    }
+    // Already in the journal
+    m_sequenceWorkflow->takeChanges();
+    if ( records.isEmpty() == false )
+        emit clipsLoaded();
+    return records.size();
+}
+
+void
+MainWorkflow::resetJournal( const QString& fileName )
+{
+    m_journal.remove();
+    QFile::remove( fileName );
+    m_journal.open( fileName );
 }
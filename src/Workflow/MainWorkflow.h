@@ -30,15 +30,30 @@
 #endif
 
 #include "Types.h"
+#include "SequenceWorkflow.h"
+#include "Project/Journal.h"
+#include <QJsonArray>
 #include <QJsonObject>
 
 #include <memory>
+#include <set>
 
 class   Clip;
+class   Media;
 class   EffectsEngine;
 class   Effect;
 class   AbstractRenderer;
-class   SequenceWorkflow;
+class   ClipPrefetcher;
+class   Consolidation;
+class   PreviewCache;
+class   AudioMeters;
+class   RenderJob;
+class   StillExport;
+struct  RenderParameters;
+struct  StemParameters;
+class   ThumbnailService;
+class   TrimPreview;
+class   Library;
 
 namespace Commands
 {
@@ -58,6 +73,8 @@ class   MediaContainer;
 #include <QObject>
 #include <QUuid>
 #include <QMap>
+#include <QQueue>
+#include <QVariant>
 
 /**
  *  \class  Represent the Timeline backend.
@@ -67,7 +84,9 @@ class   MainWorkflow : public QObject
     Q_OBJECT
 
     public:
-        MainWorkflow( Settings* projectSettings, int trackCount = 64 );
+        // library is the one of the same project, whose medias the clips play
+        MainWorkflow( Settings* projectSettings, Library* library, ThumbnailService* thumbnailService,
+                      int trackCount = 64 );
         ~MainWorkflow();
 
         /**
@@ -89,6 +108,17 @@ class   MainWorkflow : public QObject
          */
         void                    unmuteTrack( unsigned int trackId, Workflow::TrackType trackType );
 
+        /**
+         *  \brief      Sets the level of an audio track in the mix.
+         *
+         *  \param  gainDb      The gain, in dB
+         *  \param  pan         From -1, left only, to 1, right only
+         */
+        Q_INVOKABLE
+        void                    setTrackGain( quint32 trackId, double gainDb );
+        Q_INVOKABLE
+        void                    setTrackPan( quint32 trackId, double pan );
+
         /**
          *  \brief      Mute a clip.
          *
@@ -130,13 +160,113 @@ class   MainWorkflow : public QObject
 
         Q_INVOKABLE
         QString                 addClip( const QString& uuid, quint32 trackId, qint32 pos, bool isAudioClip );
+        /**
+         *  \brief  Adds library clips one after the other from pos, as a single edit.
+         *
+         *  Their audio and video parts are linked. Returns the uuids of the new clips,
+         *  which are announced with a single clipsAdded().
+         */
+        Q_INVOKABLE
+        QStringList             addClips( const QStringList& uuids, quint32 trackId, qint64 pos,
+                                          bool audio, bool video );
+
+        /**
+         *  \brief  Imports the EDL, FCPXML or OTIO timeline at path after the end of the
+         *          sequence, as a single edit.
+         *
+         *  Its medias are opened in parallel and added to the library. The events of
+         *  missing medias, or of tracks the sequence doesn't have, are left out.
+         *  \returns false if the timeline couldn't be read, with the reason in error.
+         *  \sa     TimelineImport
+         */
+        bool                    importTimeline( const QString& path, QString* error = nullptr );
+        /**
+         *  \brief  Copies the frames of the medias which the sequence plays to directory,
+         *          with handles frames around them, and relinks the project to the copies.
+         *
+         *  The copies are made in the background, consolidationFinished() is emitted once
+         *  the project uses them. The edits can't be undone past it. Returns false if the
+         *  copies can't start. \sa Consolidation
+         */
+        bool                    consolidate( const QString& directory, qint64 handles );
+
+        /**
+         *  \brief  Renders the frame under the playhead to fileName, at the project size.
+         *
+         *  The format follows the suffix of fileName, stillsExported() is emitted once the
+         *  file is written. Returns false if the export can't start. \sa StillExport
+         */
+        Q_INVOKABLE
+        bool                    exportFrame( const QString& fileName );
+        // Same, for the frame at each marker, named after its position
+        Q_INVOKABLE
+        bool                    exportMarkerFrames( const QString& fileName );
 
         Q_INVOKABLE
         QJsonObject             clipInfo( const QString& uuid );
 
+        /**
+         *  \brief  Returns the info of every clip of the sequence playing between begin
+         *          and end, in a single call. A negative end reaches the end of the
+         *          sequence.
+         */
+        Q_INVOKABLE
+        QJsonArray              clipsInfo( qint64 begin = 0, qint64 end = -1 ) const;
+        // Same as clipsInfo(), with the uuids only
+        Q_INVOKABLE
+        QStringList             clipsInRange( qint64 begin, qint64 end ) const;
+        /**
+         *  \brief  The clip positions as of the last edit. Can be called from any thread.
+         *  \sa     SequenceWorkflow::indexSnapshot()
+         */
+        std::shared_ptr<const SequenceWorkflow::IndexSnapshot>  indexSnapshot() const;
+
         Q_INVOKABLE
         void                    moveClip( const QString& uuid, quint32 trackId, qint64 startFrame );
 
+        /**
+         *  \brief  Queues the following moves and resizes until commitBatch().
+         *
+         *  They are then applied as a single edit, and undone as a single step.
+         */
+        Q_INVOKABLE
+        void                    beginBatch();
+        Q_INVOKABLE
+        void                    commitBatch();
+
+        /**
+         *  \brief  Returns where a clip dropped at startFrame would fit, snapped to the
+         *          clips closer than margin frames and without overlapping any of them.
+         */
+        Q_INVOKABLE
+        qint64                  freePosition( const QString& uuid, bool isAudioClip, quint32 trackId,
+                                              qint64 startFrame, qint64 length, qint64 margin );
+        /**
+         *  \brief  Returns where a clip dragged to startFrame goes, for the magnetic mode.
+         *
+         *  The start or the end of the clip sticks to the closest of the other clips
+         *  boundaries on the track, the markers and the cursor, if it's closer than margin
+         *  frames. The clip is then moved out of the clips it would overlap, as with
+         *  freePosition(). Meant to be called once per mouse move: it's made of lookups
+         *  in the sorted clips and markers only.
+         */
+        Q_INVOKABLE
+        qint64                  snapPosition( const QString& uuid, bool isAudioClip, quint32 trackId,
+                                              qint64 startFrame, qint64 length, qint64 margin,
+                                              qint64 cursor );
+
+        /**
+         *  \brief  Mirrors the timeline markers, for snapPosition().
+         *
+         *  Several markers may share a position.
+         */
+        Q_INVOKABLE
+        void                    addMarker( qint64 position );
+        Q_INVOKABLE
+        void                    removeMarker( qint64 position );
+        Q_INVOKABLE
+        void                    moveMarker( qint64 from, qint64 to );
+
         Q_INVOKABLE
         void                    resizeClip( const QString& uuid, qint64 newBegin,
                                             qint64 newEnd, qint64 newPos );
@@ -144,27 +274,258 @@ class   MainWorkflow : public QObject
         Q_INVOKABLE
         void                    removeClip( const QString& uuid );
 
+        // Removes the clips as a single undo step
         Q_INVOKABLE
-        void                    splitClip( const QUuid& uuid, qint64 newClipPos, qint64 newClipBegin );
+        void                    removeClips( const QStringList& uuids );
+
+        Q_INVOKABLE
+        void                    groupClips( const QStringList& uuids );
+        Q_INVOKABLE
+        void                    ungroupClips( const QString& uuid );
+        // Returns the clips grouped with uuid, including it, or an empty list
+        Q_INVOKABLE
+        QStringList             clipGroup( const QString& uuid ) const;
+
+        /**
+         *  \brief  Splits the clip at each of the positions, in timeline frames, as a
+         *          single edit. The cut tool splits at a single one.
+         *          \sa Commands::Clip::MultiSplit
+         */
+        Q_INVOKABLE
+        void                    splitClipAt( const QString& uuid, const QVariantList& positions );
+
+        /**
+         *  \brief  Moves the clips, and the ones linked to them, to a sequence of their
+         *          own, which replaces them as a single clip, as a single undo step.
+         *
+         *  The sequence is written to the workspace and added to the library, it can then
+         *  be placed in other sequences as any media. It is a copy: editing the clips it
+         *  was made of doesn't change it. The nested clip goes on the first track of the
+         *  clips, where the first of them started.
+         *  \returns The uuids of the nested clip's parts, an empty list if the clips
+         *          can't be nested, such as without a workspace, or when other clips are
+         *          in the way. \sa Tools::NestedSequence
+         */
+        Q_INVOKABLE
+        QStringList             nestClips( const QStringList& uuids );
+
+        /**
+         *  \brief  Trimming edits, each undone in a single step.
+         *
+         *  Ripple edits move the following clips of the track, roll, slip and
+         *  slide keep everything else in place. delta is in frames.
+         */
+        Q_INVOKABLE
+        void                    rippleRemoveClip( const QString& uuid );
+        Q_INVOKABLE
+        void                    rippleInsertClip( const QString& uuid, quint32 trackId,
+                                                  qint64 pos, bool isAudioClip );
+        Q_INVOKABLE
+        void                    rollClip( const QString& uuid, qint64 delta );
+        Q_INVOKABLE
+        void                    slipClip( const QString& uuid, qint64 delta );
+        Q_INVOKABLE
+        void                    slideClip( const QString& uuid, qint64 delta );
+
+        /**
+         *  \brief  Plays around the cut following the clip, looping, while it gets trimmed.
+         *
+         *  Every resize of a clip then plays the loop again from its beginning.
+         *  stopTrimPreview() is left to the caller. \sa TrimPreview
+         */
+        Q_INVOKABLE
+        void                    startTrimPreview( const QString& uuid );
+        Q_INVOKABLE
+        void                    stopTrimPreview();
 
         Q_INVOKABLE
         void                    linkClips( const QString& uuidA, const QString& uuidB );
+        /**
+         *  \brief  Plays the clip, and the one linked to it, at speed. Negative speeds play
+         *          them backward. \sa Commands::Clip::Retime
+         *
+         *  With frameBlending, the slowed down video blends the frames it would repeat, and
+         *  its part of the sequence is marked for the preview cache, so that the blending
+         *  is computed once rather than on every playback.
+         */
+        Q_INVOKABLE
+        void                    setClipSpeed( const QString& uuid, double speed,
+                                              bool frameBlending = false );
+
+        /**
+         *  \brief  Moves the clips so that their audio lines up with the one of the first
+         *          clip, as a single undo step. Their groups move along with them.
+         *
+         *  Returns the clips which couldn't be aligned. The PCM caches of their medias
+         *  may still be computed: aligning them again later can succeed.
+         *  \sa    SequenceWorkflow::audioSyncPositions()
+         */
+        Q_INVOKABLE
+        QStringList             syncClips( const QStringList& uuids );
+
+        /**
+         *  \brief     Renders the clip with its effects to an intra-frame file of the
+         *             workspace, which then plays in place of the clip.
+         *
+         *  Changing the clip's boundaries or effects reverts it to the live clip.
+         *  \sa        SequenceWorkflow::freezeClip()
+         */
+        Q_INVOKABLE
+        void                    renderInPlace( const QString& uuid );
+        // Goes back to the live clip, cancelling its rendering if it's still running
+        Q_INVOKABLE
+        void                    revertRenderInPlace( const QString& uuid );
+        // true while the clip plays from its rendition, or is being rendered
+        Q_INVOKABLE
+        bool                    isRenderedInPlace( const QString& uuid ) const;
+
+        /**
+         *  \brief     Stabilizes the clip, once its motion is analyzed in the background.
+         *
+         *  The transforms are cached per media and range, a clip which was analyzed before
+         *  is stabilized right away. They only match the range which was analyzed: the
+         *  clip has to be stabilized again once trimmed.
+         *  \param     onProxy     Analyzes the proxy of the media, if it has one.
+         *  \returns   false if the clip can't be analyzed, such as without a workspace.
+         *  \sa        StabilizationService
+         */
+        Q_INVOKABLE
+        bool                    stabilizeClip( const QString& uuid, bool onProxy = false );
 
         Q_INVOKABLE
         QString                 addEffect( const QString& clipUuid, const QString& effectId );
+        /**
+         *  \brief     Adds an effect to a whole track, processing the composited track
+         *             with a single filter instead of one per clip.
+         */
+        Q_INVOKABLE
+        QString                 addTrackEffect( quint32 trackId, const QString& effectId );
+        /**
+         *  \brief     Adds an effect to the whole sequence, after the tracks are composited.
+         */
+        Q_INVOKABLE
+        QString                 addSequenceEffect( const QString& effectId );
 
+        /**
+         *  \brief     Queue a thumbnail request for the given clip.
+         *
+         *  The frame is scaled by the backend, off the GUI thread, so the image
+         *  given to ThumbnailService::thumbnailReady() can be displayed as is.
+         *  \param     width       The displayed width, or 0 to keep the clip aspect ratio
+         *  \param     height      The displayed height, or 0 for the source height
+         *  \param     visible     true if the clip is currently in the timeline viewport,
+         *                          in which case the request is served first.
+         *  \sa        ThumbnailImageProvider
+         */
         Q_INVOKABLE
-        void                    takeThumbnail( const QString& uuid, quint32 pos );
+        void                    takeThumbnail( const QString& uuid, quint32 pos, quint32 width,
+                                               quint32 height, bool visible = true );
 
-        bool                    startRenderToFile( const QString& outputFileName, quint32 width, quint32 height,
+        /**
+         *  \brief     Queue count evenly spaced thumbnails of the given clip.
+         *
+         *  All frames are decoded in a single forward pass through one input, instead
+         *  of count independent requests. Each of them is notified through
+         *  ThumbnailService::thumbnailReady() as soon as it is decoded.
+         *  \returns   The requested positions, in frames relative to the media.
+         *  \sa        takeThumbnail()
+         */
+        Q_INVOKABLE
+        QVariantList            takeFilmstrip( const QString& uuid, quint32 count, quint32 width,
+                                               quint32 height, bool visible = true );
+
+        /**
+         *  \brief     Parses an aspect ratio such as "16/9".
+         *  \returns   false, leaving num and den untouched, unless ar has two parts
+         *             which are both strictly positive integers.
+         */
+        static bool             parseAspectRatio( const QString& ar, int& num, int& den );
+        /**
+         *  \brief     Queues an export of the sequence, rendered in the background.
+         *
+         *  The returned job is owned by the render queue, and is deleted once finished.
+         *  A positive end only renders the frames [begin, end).
+         *  A streamable export writes a fragmented file, in a single pass, so that it can
+         *  be read while it is being rendered.
+         *  \returns   The job, or nullptr if it couldn't be queued, or if ar isn't a valid
+         *             aspect ratio. \sa parseAspectRatio()
+         *  \sa        RenderQueue
+         */
+        RenderJob*              startRenderToFile( const QString& outputFileName, quint32 width, quint32 height,
                                                    double fps, const QString& ar, quint32 vbitrate, quint32 abitrate,
-                                                   quint32 nbChannels, quint32 sampleRate );
+                                                   quint32 nbChannels, quint32 sampleRate,
+                                                   qint64 begin = 0, qint64 end = -1,
+                                                   bool streamable = false );
+        /**
+         *  \brief     Queues exports of the sequence, one per rendition.
+         *
+         *  Depending on "vlmc/RenderFanOut", renditions may be rendered by the same job.
+         *  A positive end only renders the frames [begin, end), without smart rendering.
+         *  \returns   The queued jobs, which are owned by the render queue.
+         */
+        QList<RenderJob*>       startRender( QList<RenderParameters> renditions,
+                                             qint64 begin = 0, qint64 end = -1 );
+        /**
+         *  \brief     Queues an export of the sequence's audio alone, in a single pass:
+         *             the master mix to masterFileName, and each group of tracks to its
+         *             own file, as WAV. \sa StemExport
+         */
+        RenderJob*              startStemExport( const QString& masterFileName,
+                                                 const QList<StemParameters>& stems,
+                                                 qint64 begin = 0, qint64 end = -1 );
+
+        /**
+         *  \brief     Writes the sequence as an MLT XML document, which melt can render.
+         *
+         *  The document holds the profile, the tracks, the clips with their effects and
+         *  the transitions. It references the original medias rather than their proxies.
+         *  A positive end only keeps the frames [begin, end).
+         */
+        bool                    exportMltXml( const QString& fileName, qint64 begin = 0, qint64 end = -1 );
+        /**
+         *  \brief     Same as exportMltXml(), split into documents of rangeLength frames.
+         *
+         *  The range index is appended to the base name of each file: "project-0001.mlt"...
+         *  \returns   The written files, in order, or an empty list on failure.
+         */
+        QStringList             exportMltXmlRanges( const QString& fileName, qint64 rangeLength,
+                                                    qint64 begin = 0, qint64 end = -1 );
 
         bool                    canRender();
+        // The number of frames an export of the whole sequence renders
+        qint64                  playableLength();
+        // The composited sequence, as the preview plays it
+        Backend::IInput*        sequenceInput();
 
         AbstractRenderer*       renderer();
+        PreviewCache*           previewCache();
+        // Levels of the audio the preview plays
+        AudioMeters*            audioMeters();
+        /**
+         *  \brief Notifies the caches of a filter change. \sa SequenceWorkflow::filterChanged()
+         */
+        void                    filterChanged( const Backend::IInput* target, qint64 begin, qint64 end );
 
         Commands::AbstractUndoStack*       undoStack();
+        /**
+         *  \brief  Bounds the undo history.
+         *
+         *  \param  limit       The maximum number of undo steps, 0 for no limit. Only
+         *                      applied once the history is empty, as when a project closes.
+         *  \param  liveSteps   The number of recent steps keeping the clips they removed
+         *                      alive. Older ones only keep their description.
+         */
+        void                    setUndoBudget( int limit, int liveSteps );
+
+        /**
+         *  \brief  Journals the edits to fileName from now on.
+         *
+         *  The records which aren't part of the loaded project yet are replayed first.
+         *  \returns    The number of replayed records.
+         */
+        int                     openJournal( const QString& fileName );
+        // Starts an empty journal in fileName, dropping the current one
+        void                    resetJournal( const QString& fileName );
 
     private:
 
@@ -177,9 +538,34 @@ class   MainWorkflow : public QObject
         std::shared_ptr<Clip>                   clip( const QUuid& uuid, unsigned int trackId );
 
         void                    trigger( Commands::Generic* command );
+        /**
+         *  \brief  Where the first pass of a two pass export keeps its statistics, in the
+         *          workspace. Empty if there is no workspace.
+         *
+         *  The statistics only depend on the sequence's images and on the video encoder
+         *  settings, so the file is named after them: exporting an unchanged sequence
+         *  again reuses it.
+         */
+        QString                 passLogFile( const RenderParameters& params, qint64 begin, qint64 end ) const;
+        // Returns the new effect's uuid, or an empty string on failure
+        QString                 addEffect( Backend::IInput* target, const QString& effectId );
+
+        static void             thumbnailSize( const Backend::IInput* input, quint32& width,
+                                               quint32& height );
 
         void                    preSave();
+        // The journal isn't compacted up to a snapshot, as it isn't saved
+        void                    preSnapshot();
         void                    postLoad();
+        // Appends what the last command changed to the journal
+        void                    journalChanges();
+        // Drops the records included in the snapshot that was just written
+        void                    compactJournal( bool saved );
+        // Releases the commands which are deeper in the history than m_undoLiveSteps
+        void                    releaseHistory();
+        // Relinks the medias to their copies, once they're all done
+        void                    consolidated( bool success );
+        bool                    exportStills( const QList<qint64>& positions, const QString& fileName );
 
     private:
         const quint32                   m_trackCount;
@@ -189,7 +575,45 @@ class   MainWorkflow : public QObject
         AbstractRenderer*               m_renderer;
 
         std::unique_ptr<Commands::AbstractUndoStack> m_undoStack;
+        int                                          m_undoLimit;
+        int                                          m_undoLiveSteps;
         std::shared_ptr<SequenceWorkflow>            m_sequenceWorkflow;
+        std::unique_ptr<PreviewCache>                m_previewCache;
+        std::unique_ptr<AudioMeters>                 m_audioMeters;
+        std::unique_ptr<ClipPrefetcher>              m_prefetcher;
+        std::unique_ptr<TrimPreview>                 m_trimPreview;
+
+        ThumbnailService*               m_thumbnailService;
+        Library*                        m_library;
+
+        // The clips being rendered in place
+        QHash<QUuid, RenderJob*>            m_freezeJobs;
+
+        struct Stabilization
+        {
+            QString     filePath;
+            qint64      begin;
+            qint64      end;
+        };
+        // The clips waiting for their motion analysis
+        QHash<QUuid, Stabilization>         m_stabilizations;
+
+        bool                                m_batching;
+        QList<SequenceWorkflow::ClipEdit>   m_batch;
+
+        // Set while the medias are being consolidated
+        Consolidation*                      m_consolidation;
+        // Set while frames are being exported as images
+        StillExport*                        m_stillExport;
+
+        // The timeline markers positions
+        std::multiset<qint64>               m_markers;
+
+        Journal                         m_journal;
+        // Number of the last journaled record
+        quint64                         m_journalSeq;
+        // Last record included in each snapshot being written, in order
+        QQueue<quint64>                 m_snapshotSeqs;
 
     public slots:
         /**
@@ -204,10 +628,41 @@ class   MainWorkflow : public QObject
         void                            clear();
 
         void                            setClean();
+        /**
+         *  \brief      Plays the file of media in place of its placeholder, from now on.
+         *  \sa         Library::mediaOnline()
+         */
+        void                            mediaOnline( Media* media );
+        /**
+         *  \brief      Extends the clips which reached the end of a growing media.
+         *  \sa         Library::mediaGrown()
+         */
+        void                            mediaGrown( Media* media, qint64 oldLength );
+        /**
+         *  \brief      Adds the stabilization to the clips which were waiting for the range.
+         *  \sa         StabilizationService::analyzed()
+         */
+        void                            stabilizationAnalyzed( const QString& filePath, qint64 begin,
+                                                               qint64 end, bool success );
 
         void                            setPosition( qint64 newFrame );
 
+        /**
+         *  \brief  Changes the frame rate of the profile, in place.
+         *
+         *  The medias keep their decoders, and the clips their inputs and tracks: their
+         *  lengths, positions and boundaries, and the ones of the effects, are scaled to
+         *  the new rate. The frames the sequence caches kept get rendered again, and the
+         *  history is dropped, since its commands hold frames of the previous rate.
+         *  While a project loads, its frames are already at its rate: only the profile
+         *  changes.
+         */
         void                            setFps( double fps );
+        /**
+         *  \brief  Changes the size of the profile. The producers adapt to it on their
+         *          own, the images cached at the previous size are dropped.
+         */
+        void                            setResolution( unsigned int width, unsigned int height );
 
         // FIXME: We can't use #ifdef HAVE_GUI here because qml files can't find them
         //        You'll get:
@@ -220,6 +675,7 @@ class   MainWorkflow : public QObject
         /**
          *  \brief      Used to notify a change to the timeline and preview widget cursor
          *
+         *  While playing, this is emitted at most once per display refresh.
          *  \param      newFrame    The new rendered frame
          *  \param      reason      The reason for clipanging frame. Usually, if emitted
          *                          from the MainWorkflow, this should be "Renderer"
@@ -250,19 +706,51 @@ class   MainWorkflow : public QObject
         void                    lengthChanged( qint64 length );
 
         void                    fpsChanged( double fps );
+        /**
+         *  \brief  Emitted once the frames of the sequence were scaled by ratio, for the
+         *          markers to follow. \sa setFps()
+         */
+        void                    rescaled( double ratio );
 
         void                    cleanChanged( bool isClean );
 
         void                    clipAdded( const QString& uuid );
+        /**
+         *  \brief  Emitted once the clips of a project are loaded, instead of clipAdded()
+         *          for each of them.
+         */
+        void                    clipsLoaded();
         void                    clipResized( const QString& uuid );
         void                    clipRemoved( const QString& uuid );
+        /**
+         *  \brief  Emitted once for the clips an edit added, or removed, all at once,
+         *          instead of clipAdded() or clipRemoved() for each of them.
+         */
+        void                    clipsAdded( const QStringList& uuids );
+        void                    clipsRemoved( const QStringList& uuids );
         void                    clipMoved( const QString& uuid );
         void                    clipLinked( const QString& uuidA, const QString& uuidB );
         void                    clipUnlinked( const QString& uuidA, const QString& uuidB );
 
         void                    effectsUpdated( const QString& clipUuid );
+        void                    clipRenderedInPlace( const QString& uuid, bool rendered );
+        /**
+         *  \brief  Emitted after each edit of the clips or filters of a track, once the
+         *          new indexSnapshot() is available.
+         */
+        void                    trackChanged( quint32 trackId );
+
+        // The number of medias copied so far, while consolidating
+        void                    consolidationProgress( int done, int total );
+        /**
+         *  \brief  Emitted once the project uses the consolidated medias, or when their
+         *          copy failed, in which case it still uses the original ones.
+         */
+        void                    consolidationFinished( bool success );
 
-        void                    thumbnailUpdated( const QString& uuid, quint32 pos, const QPixmap& pixmap );
+        void                    stillExportProgress( int done, int total );
+        // fileNames are the files written
+        void                    stillsExported( bool success, const QStringList& fileNames );
 };
 
 #endif // MAINWORKFLOW_H
@@ -0,0 +1,147 @@
+/*****************************************************************************
+ * MulticamViewer.cpp: Decodes every angle of a multicam clip
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "MulticamViewer.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IInput.h"
+#include "Tools/MediaIO.h"
+#include "Tools/Multicam.h"
+#include "Tools/VideoFrame.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QRunnable>
+
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+
+class AngleJob : public QRunnable
+{
+public:
+    explicit AngleJob( std::function<void()> job )
+        : m_job( std::move( job ) )
+    {
+    }
+
+    virtual void run() override
+    {
+        m_job();
+    }
+
+private:
+    std::function<void()>   m_job;
+};
+
+}
+
+MulticamViewer::MulticamViewer( QObject* parent )
+    : QObject( parent )
+{
+}
+
+MulticamViewer::~MulticamViewer()
+{
+    m_pool.waitForDone();
+}
+
+void
+MulticamViewer::setMulticam( const QString& filePath )
+{
+    if ( filePath == m_multicam )
+        return;
+    // The angles' threads use their decoders
+    m_pool.waitForDone();
+    m_angles.clear();
+    m_multicam = filePath;
+    Tools::Multicam multicam;
+    if ( filePath.isEmpty() == true || Tools::Multicam::load( filePath, multicam ) == false )
+        return;
+    for ( const auto& a : multicam.angles )
+    {
+        std::unique_ptr<Angle> angle( new Angle );
+        angle->filePath = a.filePath;
+        angle->offset = a.offset;
+        angle->nbFrames = -1;
+        angle->busy = false;
+        m_angles.push_back( std::move( angle ) );
+    }
+    m_pool.setMaxThreadCount( std::max<int>( 1, m_angles.size() ) );
+}
+
+const QString&
+MulticamViewer::multicam() const
+{
+    return m_multicam;
+}
+
+int
+MulticamViewer::nbAngles() const
+{
+    return static_cast<int>( m_angles.size() );
+}
+
+void
+MulticamViewer::request( qint64 position )
+{
+    for ( size_t i = 0; i < m_angles.size(); ++i )
+    {
+        auto angle = m_angles[i].get();
+        if ( angle->busy.exchange( true ) == true )
+            continue;
+        m_pool.start( new AngleJob( [this, angle, i, position] {
+            decode( *angle, static_cast<int>( i ), position );
+            angle->busy = false;
+        } ) );
+    }
+}
+
+void
+MulticamViewer::decode( Angle& angle, int index, qint64 position )
+{
+    QImage  image;
+    auto pos = position - angle.offset;
+    try
+    {
+        // -1 until the angle is opened, 0 if it can't be
+        if ( angle.input == nullptr && angle.nbFrames < 0 )
+        {
+            Tools::MediaIO::Timer   timer( angle.filePath, Tools::MediaIO::Open );
+            angle.input = Backend::instance()->acquireInput( qPrintable( angle.filePath ) );
+            angle.nbFrames = angle.input->length();
+        }
+        if ( angle.input != nullptr && pos >= 0 && pos < angle.nbFrames )
+        {
+            angle.input->setPosition( pos );
+            image = Tools::toQImage( angle.input->image( AngleWidth, AngleHeight ) );
+        }
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Can't decode the angle" << angle.filePath;
+        if ( angle.input == nullptr )
+            angle.nbFrames = 0;
+    }
+    emit angleReady( index, position, image );
+}
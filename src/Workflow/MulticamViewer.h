@@ -0,0 +1,97 @@
+/*****************************************************************************
+ * MulticamViewer.h: Decodes every angle of a multicam clip
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MULTICAMVIEWER_H
+#define MULTICAMVIEWER_H
+
+#include <QImage>
+#include <QObject>
+#include <QThreadPool>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace Backend
+{
+class IInput;
+}
+
+/**
+ *  \brief  Decodes all the angles of a multicam clip at once, for an angle viewer grid.
+ *
+ *  Each angle has its own thread and its own decoder, checked out from the backend's
+ *  input cache, which decodes its proxy when it has one. The angles are decoded at
+ *  AngleWidth x AngleHeight: only the program output, which plays the active angle,
+ *  decodes at full resolution. \sa Backend::MLT::MLTMulticam
+ *  An angle which is still decoding a previous position skips the new one, so that the
+ *  grid keeps up with the playback rather than queueing frames.
+ */
+class MulticamViewer : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static const uint32_t   AngleWidth = 320;
+        static const uint32_t   AngleHeight = 180;
+
+        explicit MulticamViewer( QObject* parent = nullptr );
+        ~MulticamViewer();
+
+        /**
+         *  \brief  Sets the multicam file whose angles are shown, none if it's empty.
+         */
+        void                    setMulticam( const QString& filePath );
+        const QString&          multicam() const;
+        int                     nbAngles() const;
+        /**
+         *  \brief  Decodes every angle at position of the multicam clip.
+         */
+        void                    request( qint64 position );
+
+    private:
+        struct Angle
+        {
+            QString                             filePath;
+            qint64                              offset;
+            qint64                              nbFrames;
+            // Only used from the angle's thread
+            std::shared_ptr<Backend::IInput>    input;
+            std::atomic<bool>                   busy;
+        };
+
+        // Runs on a worker thread
+        void                    decode( Angle& angle, int index, qint64 position );
+
+    private:
+        QThreadPool                         m_pool;
+        QString                             m_multicam;
+        std::vector<std::unique_ptr<Angle>> m_angles;
+
+    signals:
+        /**
+         *  \brief  Emitted from a worker thread, with a null image outside of the angle.
+         */
+        void                    angleReady( int angle, qint64 position, const QImage& image );
+};
+
+#endif // MULTICAMVIEWER_H
@@ -0,0 +1,363 @@
+/*****************************************************************************
+ * PreviewCache.cpp: Renders the sequence ahead of its preview
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "PreviewCache.h"
+#include "RenderJob.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IProfile.h"
+#include "Backend/MLT/MLTInput.h"
+#include "Backend/MLT/MLTMultiTrack.h"
+#include "Backend/MLT/MLTService.h"
+#include "Backend/MLT/MLTTrack.h"
+#include "Tools/Metrics.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <limits>
+
+const QString   PreviewCache::SubDirectory = ".preview";
+
+PreviewCache::PreviewCache( Backend::IInput* sequence, QObject* parent )
+    : QObject( parent )
+    , m_sequence( sequence )
+    , m_track( new Backend::MLT::MLTTrack )
+    , m_tractor( new Backend::MLT::MLTMultiTrack )
+    , m_enabled( false )
+    , m_idle( true )
+    , m_maxSize( 0 )
+    , m_size( 0 )
+    , m_playhead( 0 )
+    , m_job( nullptr )
+    , m_jobChunk( -1 )
+{
+    // The topmost track which isn't blank provides the frame
+    m_tractor->setTrack( *m_sequence, 0 );
+    m_tractor->setTrack( *m_track, 1 );
+}
+
+PreviewCache::~PreviewCache()
+{
+    // Stops the encoder before its directory gets removed
+    stopJob();
+}
+
+Backend::IInput*
+PreviewCache::input()
+{
+    return m_tractor.get();
+}
+
+void
+PreviewCache::setDirectory( const QString& workspaceDir )
+{
+    invalidate( 0 );
+    m_staleHashes.clear();
+    m_directory.reset();
+    // The chunks depend on the sequence being edited, they don't outlive the session
+    auto dir = workspaceDir + '/' + SubDirectory;
+    if ( workspaceDir.isEmpty() == false && QDir().mkpath( dir ) == true )
+    {
+        m_directory.reset( new QTemporaryDir( dir + "/XXXXXX" ) );
+        if ( m_directory->isValid() == false )
+            m_directory.reset();
+    }
+    schedule();
+}
+
+void
+PreviewCache::setEnabled( bool enabled )
+{
+    m_enabled = enabled;
+    if ( enabled == false )
+        invalidate( 0 );
+    schedule();
+}
+
+void
+PreviewCache::setMaxSize( qint64 maxSize )
+{
+    m_maxSize = maxSize;
+    while ( m_maxSize > 0 && m_size > m_maxSize && evict() == true )
+        ;
+    schedule();
+}
+
+void
+PreviewCache::setPlayhead( qint64 frame )
+{
+    m_playhead = frame;
+    schedule();
+}
+
+void
+PreviewCache::setIdle( bool idle )
+{
+    m_idle = idle;
+    // Leave the processor to the preview
+    if ( idle == false )
+        stopJob();
+    schedule();
+}
+
+void
+PreviewCache::addRegion( qint64 begin, qint64 end )
+{
+    if ( end <= begin )
+        return;
+    m_regions.append( qMakePair( begin, end ) );
+    schedule();
+}
+
+void
+PreviewCache::clearRegions()
+{
+    m_regions.clear();
+}
+
+void
+PreviewCache::invalidate( qint64 begin, qint64 end )
+{
+    if ( end >= 0 && end <= begin )
+        return;
+    auto first = qMax( 0ll, begin ) / ChunkSize;
+    auto last = end < 0 ? std::numeric_limits<qint64>::max() : ( end - 1 ) / ChunkSize;
+
+    if ( m_jobChunk >= first && m_jobChunk <= last )
+        stopJob();
+    QList<qint64>   indexes;
+    for ( auto it = m_chunks.lowerBound( first ); it != m_chunks.end() && it.key() <= last; ++it )
+        indexes << it.key();
+    for ( auto index : indexes )
+    {
+        m_staleHashes.insert( index, m_chunks[index].hashes );
+        removeChunk( index );
+    }
+    // A running job renders its own copy, which is still valid outside [begin, end)
+    m_snapshot.reset();
+    // Also picks the sequence's new length up
+    m_tractor->refresh();
+    schedule();
+}
+
+bool
+PreviewCache::isWanted( qint64 index ) const
+{
+    for ( const auto& region : m_regions )
+    {
+        if ( index >= region.first / ChunkSize && index <= ( region.second - 1 ) / ChunkSize )
+            return true;
+    }
+    auto playhead = m_playhead / ChunkSize;
+    return index >= playhead && index <= playhead + ChunksAhead;
+}
+
+qint64
+PreviewCache::nextChunk() const
+{
+    auto nbChunks = ( m_sequence->playableLength() + ChunkSize - 1 ) / ChunkSize;
+    for ( const auto& region : m_regions )
+    {
+        for ( auto i = region.first / ChunkSize; i <= ( region.second - 1 ) / ChunkSize && i < nbChunks; ++i )
+        {
+            if ( m_chunks.contains( i ) == false )
+                return i;
+        }
+    }
+    auto playhead = m_playhead / ChunkSize;
+    for ( auto i = playhead; i <= playhead + ChunksAhead && i < nbChunks; ++i )
+    {
+        if ( m_chunks.contains( i ) == false )
+            return i;
+    }
+    return -1;
+}
+
+bool
+PreviewCache::evict()
+{
+    auto playhead = m_playhead / ChunkSize;
+    qint64  farthest = -1;
+    for ( auto it = m_chunks.begin(); it != m_chunks.end(); ++it )
+    {
+        if ( isWanted( it.key() ) == true )
+            continue;
+        if ( farthest < 0 || qAbs( it.key() - playhead ) > qAbs( farthest - playhead ) )
+            farthest = it.key();
+    }
+    if ( farthest < 0 )
+        return false;
+    removeChunk( farthest );
+    m_tractor->refresh();
+    return true;
+}
+
+void
+PreviewCache::removeChunk( qint64 index )
+{
+    auto chunk = m_chunks.take( index );
+    m_track->remove( m_track->clipIndexAt( index * ChunkSize ) );
+    m_size -= chunk.size;
+    QFile::remove( chunk.filePath );
+}
+
+void
+PreviewCache::stopJob()
+{
+    if ( m_job == nullptr )
+        return;
+    auto path = m_job->parameters().outputFileName;
+    // Stops the encoder synchronously, finished() won't be emitted
+    delete m_job;
+    m_job = nullptr;
+    m_jobChunk = -1;
+    QFile::remove( path );
+}
+
+Backend::IInput*
+PreviewCache::snapshot()
+{
+    if ( m_snapshot != nullptr )
+        return m_snapshot.get();
+    try
+    {
+        m_snapshot = m_sequence->clone();
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Failed to take a snapshot of the sequence";
+    }
+    return m_snapshot.get();
+}
+
+const Backend::IInput*
+PreviewCache::sequenceSnapshot()
+{
+    if ( m_snapshot == nullptr && m_idle == false )
+        return nullptr;
+    return snapshot();
+}
+
+void
+PreviewCache::schedule()
+{
+    // The sequence can only be copied while it isn't played
+    if ( m_enabled == false || m_idle == false || m_job != nullptr || m_directory == nullptr )
+        return;
+    auto index = nextChunk();
+    if ( index < 0 )
+        return;
+    while ( m_maxSize > 0 && m_size >= m_maxSize )
+    {
+        if ( evict() == false )
+            return;
+    }
+
+    auto source = snapshot();
+    if ( source == nullptr )
+        return;
+
+    auto& profile = Backend::instance()->profile();
+    RenderParameters params;
+    params.outputFileName = m_directory->path() + '/' + QString::number( index ) + ".mkv";
+    params.width = profile.width();
+    params.height = profile.height();
+    params.fps = profile.fps();
+    params.aspectNum = profile.aspectRatioNum();
+    params.aspectDen = profile.aspectRatioDen();
+    // Around 2 bits per pixel, so the chunks look like what they replace
+    params.videoBitrate = profile.width() * profile.height() * profile.fps() * 2 / 1000;
+    params.audioBitrate = 256;
+    params.nbChannels = 2;
+    params.sampleRate = 48000;
+    // Intra frames only, so seeking into a chunk is as cheap as playing it
+    params.encoder.videoCodec = "mjpeg";
+    params.encoder.audioCodec = "pcm_s16le";
+    params.encoder.gopSize = 1;
+
+    m_job = new RenderJob( params, 1, this );
+    m_job->setRange( index * ChunkSize, ( index + 1 ) * ChunkSize );
+    m_job->setHashFrames( true );
+    m_jobChunk = index;
+    connect( m_job, &RenderJob::finished, this, &PreviewCache::jobFinished );
+    if ( m_job->start( *source ) == false )
+    {
+        vlmcWarning() << "Failed to render the preview of frame" << index * ChunkSize;
+        delete m_job;
+        m_job = nullptr;
+        m_jobChunk = -1;
+    }
+}
+
+void
+PreviewCache::jobFinished( bool success )
+{
+    auto job = m_job;
+    auto index = m_jobChunk;
+    m_job = nullptr;
+    m_jobChunk = -1;
+    job->deleteLater();
+    auto path = job->parameters().outputFileName;
+    // A failed chunk is retried once the playhead moves, or the sequence changes
+    if ( success == false )
+    {
+        QFile::remove( path );
+        return;
+    }
+
+    Chunk c;
+    c.filePath = path;
+    c.size = QFileInfo( path ).size();
+    c.hashes = job->frameHashes();
+    auto stale = m_staleHashes.find( index );
+    if ( stale != m_staleHashes.end() )
+    {
+        auto cmp = c.hashes.compare( stale.value() );
+        if ( cmp.nbMismatches == 0 && cmp.nbMissing == 0 )
+            Tools::Metrics::counter( "previewCache.unchangedChunks" ).add();
+        m_staleHashes.erase( stale );
+    }
+    try
+    {
+        c.input.reset( new Backend::MLT::MLTInput( Backend::instance()->profile(), qPrintable( path ) ) );
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Can't open the rendered preview" << path;
+        QFile::remove( path );
+        return;
+    }
+    c.input->setBoundaries( 0, job->totalFrames() - 1 );
+    if ( m_track->insertAt( *c.input, index * ChunkSize ) == false )
+    {
+        QFile::remove( path );
+        return;
+    }
+    m_size += c.size;
+    m_chunks.insert( index, c );
+    m_tractor->refresh();
+    schedule();
+}
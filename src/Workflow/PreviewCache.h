@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * PreviewCache.h: Renders the sequence ahead of its preview
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef PREVIEWCACHE_H
+#define PREVIEWCACHE_H
+
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QPair>
+#include <QString>
+
+#include "Tools/FrameHash.h"
+
+#include <memory>
+
+class QTemporaryDir;
+class RenderJob;
+
+namespace Backend
+{
+class IInput;
+class IMultiTrack;
+class ITrack;
+}
+
+/**
+ *  \brief  Renders parts of the sequence ahead of time, so they play back cheaply.
+ *
+ *  The sequence is split in chunks of ChunkSize frames, which are rendered to
+ *  intra-frame files while the preview is stopped: the regions marked by the user
+ *  first, then the chunks following the playhead. Rendered chunks are laid over the
+ *  sequence in input(), where they hide the tracks below them, so the effects and
+ *  the compositing aren't computed again. Exports keep using the sequence itself.
+ *
+ *  The chunks are rendered from a snapshot of the sequence, which is taken once after
+ *  each change and shared by the following jobs, so the live sequence is only copied
+ *  when it was edited, and every chunk of a generation sees the same timeline.
+ *
+ *  Changing a part of the sequence must be notified through invalidate(). The frames of
+ *  the chunks are hashed, so that a chunk rendered again after being invalidated can
+ *  be told apart from the one it replaces: the previewCache.unchangedChunks metric
+ *  counts the invalidations which didn't change anything.
+ */
+class PreviewCache : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static const QString    SubDirectory;
+        static const qint64     ChunkSize = 100;
+        // Chunks rendered from the playhead onward when nothing is marked
+        static const qint64     ChunksAhead = 4;
+
+        explicit PreviewCache( Backend::IInput* sequence, QObject* parent = nullptr );
+        ~PreviewCache();
+
+        /**
+         *  \brief  The sequence, with the rendered chunks laid over it. Meant for the preview.
+         */
+        Backend::IInput*        input();
+
+        /**
+         *  \brief  Sets the workspace directory. This drops the rendered chunks.
+         */
+        void                    setDirectory( const QString& workspaceDir );
+        void                    setEnabled( bool enabled );
+        // In bytes. The chunks farthest from the playhead are dropped first.
+        void                    setMaxSize( qint64 maxSize );
+
+        void                    setPlayhead( qint64 frame );
+        /**
+         *  \brief  Nothing is rendered while the preview runs, as the sequence can't be
+         *          copied in the meantime.
+         */
+        void                    setIdle( bool idle );
+
+        // Renders the frames [begin, end) before the ones around the playhead
+        void                    addRegion( qint64 begin, qint64 end );
+        void                    clearRegions();
+
+        /**
+         *  \brief  Drops the chunks which overlap [begin, end). A negative end drops
+         *          every chunk after begin.
+         */
+        void                    invalidate( qint64 begin, qint64 end = -1 );
+
+        /**
+         *  \brief  The frozen copy of the sequence the chunks are rendered from, to be
+         *          copied instead of the live sequence, as it isn't played.
+         *
+         *  Returns nullptr if the snapshot is out of date, and can't be taken again as
+         *  the preview runs.
+         */
+        const Backend::IInput*  sequenceSnapshot();
+
+    private:
+        struct Chunk
+        {
+            QString                             filePath;
+            qint64                              size;
+            std::shared_ptr<Backend::IInput>    input;
+            Tools::FrameHashes                  hashes;
+        };
+
+        bool                    isWanted( qint64 index ) const;
+        qint64                  nextChunk() const;
+        // Drops an unwanted chunk to make room. Returns false if there is none.
+        bool                    evict();
+        void                    removeChunk( qint64 index );
+        void                    stopJob();
+        // Copies the sequence if it changed since the last snapshot
+        Backend::IInput*        snapshot();
+        void                    schedule();
+        void                    jobFinished( bool success );
+
+    private:
+        Backend::IInput*                        m_sequence;
+        // Frozen copy of m_sequence the jobs render from. Dropped by invalidate()
+        std::unique_ptr<Backend::IInput>        m_snapshot;
+        std::unique_ptr<Backend::ITrack>        m_track;
+        std::unique_ptr<Backend::IMultiTrack>   m_tractor;
+        std::unique_ptr<QTemporaryDir>          m_directory;
+        bool                                    m_enabled;
+        bool                                    m_idle;
+        qint64                                  m_maxSize;
+        qint64                                  m_size;
+        qint64                                  m_playhead;
+        QList<QPair<qint64, qint64>>            m_regions;
+        QMap<qint64, Chunk>                     m_chunks;
+        // The hashes of the invalidated chunks, until they are rendered again
+        QMap<qint64, Tools::FrameHashes>        m_staleHashes;
+        RenderJob*                              m_job;
+        // The chunk being rendered, or -1
+        qint64                                  m_jobChunk;
+};
+
+#endif // PREVIEWCACHE_H
@@ -0,0 +1,259 @@
+/*****************************************************************************
+ * ProxyService.cpp: Generates low resolution proxies of the medias
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ProxyService.h"
+#include "RenderJob.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IProfile.h"
+#include "Backend/MLT/MLTInput.h"
+#include "Backend/MLT/MLTService.h"
+#include "Tools/CacheFile.h"
+#include "Tools/FileHash.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QTimer>
+
+const QString   ProxyService::SubDirectory = ".proxies";
+
+ProxyService::ProxyService( QObject* parent )
+    : QObject( parent )
+    , m_maxJobs( 1 )
+{
+}
+
+ProxyService::~ProxyService()
+{
+    m_pending.clear();
+    for ( auto it = m_running.begin(); it != m_running.end(); ++it )
+    {
+        // Cancels the job, and releases the partial file
+        delete it.key();
+        QFile::remove( it.value().partPath );
+    }
+}
+
+void
+ProxyService::setDirectory( const QString& cacheDir )
+{
+    if ( cacheDir.isEmpty() == true )
+        m_directory.clear();
+    else
+        m_directory = cacheDir + '/' + SubDirectory;
+}
+
+void
+ProxyService::setMaxJobs( quint32 maxJobs )
+{
+    m_maxJobs = qMax( 1u, maxJobs );
+    schedule();
+}
+
+QString
+ProxyService::proxyPath( const QString& filePath, Kind kind ) const
+{
+    if ( m_directory.isEmpty() == true )
+        return QString();
+    auto hash = Tools::contentHash( filePath );
+    if ( hash.isEmpty() == true )
+        return QString();
+    // Rendered at the project frame rate
+    auto size = kind == Optimized ? QString( "full" ) : QString::number( Height ) + 'p';
+    return m_directory + '/' + QString::fromLatin1( hash ) + '_' + size + '_' +
+            QString::number( Backend::instance()->profile().fps(), 'g', 8 ) + ".mkv";
+}
+
+bool
+ProxyService::useExisting( const QString& filePath )
+{
+    for ( auto kind : { Optimized, Proxy } )
+    {
+        auto path = proxyPath( filePath, kind );
+        if ( path.isEmpty() == false && QFile::exists( path ) == true )
+        {
+            Backend::instance()->setProxy( filePath.toStdString(), path.toStdString() );
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+ProxyService::isOptimized( const QString& filePath ) const
+{
+    auto proxies = Backend::instance()->proxies();
+    auto it = proxies.find( filePath.toStdString() );
+    return it != proxies.end() &&
+            QString::fromStdString( it->second ) == proxyPath( filePath, Optimized );
+}
+
+void
+ProxyService::request( const QString& filePath, Kind kind )
+{
+    if ( m_directory.isEmpty() == true )
+        return;
+    if ( kind == Proxy && useExisting( filePath ) == true )
+        return;
+    if ( kind == Optimized && QFile::exists( proxyPath( filePath, Optimized ) ) == true )
+    {
+        if ( isOptimized( filePath ) == false )
+            ready( filePath, kind );
+        return;
+    }
+    if ( m_pending.contains( qMakePair( filePath, kind ) ) == true )
+        return;
+    for ( const auto& job : m_running )
+    {
+        if ( job.filePath == filePath && job.kind == kind )
+            return;
+    }
+    m_pending.append( qMakePair( filePath, kind ) );
+    schedule();
+}
+
+void
+ProxyService::cancelAll()
+{
+    m_pending.clear();
+    for ( auto job : m_running.keys() )
+        job->cancel();
+}
+
+void
+ProxyService::schedule()
+{
+    while ( m_pending.isEmpty() == false && (quint32)m_running.size() < m_maxJobs )
+    {
+        Job j;
+        auto next = m_pending.takeFirst();
+        j.filePath = next.first;
+        j.kind = next.second;
+        j.proxyPath = proxyPath( j.filePath, j.kind );
+        if ( j.proxyPath.isEmpty() == true ||
+             QDir().mkpath( QFileInfo( j.proxyPath ).absolutePath() ) == false )
+            continue;
+        // Another workstation sharing the cache may be rendering it, or just did
+        j.claim = Tools::CacheFile::claim( j.proxyPath );
+        if ( j.claim == nullptr )
+        {
+            retry( j.filePath, j.kind );
+            continue;
+        }
+        if ( QFile::exists( j.proxyPath ) == true )
+        {
+            ready( j.filePath, j.kind );
+            continue;
+        }
+        j.partPath = Tools::CacheFile::partPath( j.proxyPath, ".mkv" );
+        try
+        {
+            // Not shared with anyone else, so it can be copied from this thread
+            j.input.reset( new Backend::MLT::MLTInput( Backend::instance()->profile(),
+                                                       qPrintable( j.filePath ) ) );
+        }
+        catch ( Backend::InvalidServiceException& )
+        {
+            vlmcWarning() << "Can't generate a proxy for" << j.filePath;
+            continue;
+        }
+        // Already cheap enough to decode
+        if ( j.input->hasVideo() == false ||
+             ( j.kind == Proxy && j.input->height() <= (int)Height ) )
+            continue;
+
+        quint32 height = j.kind == Optimized ? ( j.input->height() + 1 ) / 2 * 2 : Height;
+        auto displayAspect = j.input->width() * j.input->aspectRatio() / j.input->height();
+        RenderParameters params;
+        params.outputFileName = j.partPath;
+        params.height = height;
+        params.width = qRound( height * displayAspect / 2 ) * 2;
+        params.fps = Backend::instance()->profile().fps();
+        params.aspectNum = params.width;
+        params.aspectDen = params.height;
+        // The same quality per pixel at any size
+        params.videoBitrate = 8000 * ( params.width * params.height ) / ( 640 * Height );
+        params.audioBitrate = 256;
+        params.nbChannels = 2;
+        params.sampleRate = 48000;
+        // Every frame being a keyframe makes seeking and scrubbing cheap
+        params.encoder.videoCodec = "mjpeg";
+        params.encoder.audioCodec = "pcm_s16le";
+        params.encoder.gopSize = 1;
+
+        auto job = new RenderJob( params, 1, this );
+        auto filePath = j.filePath;
+        connect( job, &RenderJob::finished, this, [this, job]( bool success )
+        {
+            jobFinished( job, success );
+        } );
+        connect( job, &RenderJob::progress, this, [this, job, filePath]( qint64 frame )
+        {
+            if ( job->totalFrames() > 0 )
+                emit progress( filePath, ( frame + 1 ) * 100 / job->totalFrames() );
+        } );
+        if ( job->start( *j.input ) == false )
+        {
+            vlmcWarning() << "Failed to start generating a proxy for" << j.filePath;
+            delete job;
+            continue;
+        }
+        m_running.insert( job, j );
+    }
+}
+
+void
+ProxyService::jobFinished( RenderJob* job, bool success )
+{
+    auto j = m_running.take( job );
+    job->deleteLater();
+    if ( success == true )
+        success = Tools::CacheFile::publish( j.partPath, j.proxyPath );
+    if ( success == true )
+        ready( j.filePath, j.kind );
+    else
+        QFile::remove( j.partPath );
+    schedule();
+}
+
+void
+ProxyService::ready( const QString& filePath, Kind kind )
+{
+    useExisting( filePath );
+    emit proxyReady( filePath );
+    if ( kind == Optimized )
+        emit optimized( filePath );
+}
+
+void
+ProxyService::retry( const QString& filePath, Kind kind )
+{
+    QTimer::singleShot( Tools::CacheFile::ClaimRetry, this, [this, filePath, kind]() {
+        if ( QFile::exists( proxyPath( filePath, kind ) ) == true )
+            ready( filePath, kind );
+        else
+            request( filePath, kind );
+    } );
+}
@@ -0,0 +1,131 @@
+/*****************************************************************************
+ * ProxyService.h: Generates low resolution proxies of the medias
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef PROXYSERVICE_H
+#define PROXYSERVICE_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPair>
+
+#include <memory>
+
+class QLockFile;
+class RenderJob;
+
+namespace Backend
+{
+class IInput;
+}
+
+/**
+ *  \brief  Transcodes medias to low resolution, intra-frame proxies in the background.
+ *
+ *  Proxies are stored in the cache directory, keyed by the media content hash, their
+ *  height and frame rate. Workstations sharing the directory render each one once.
+ *  Once a proxy is registered to the backend, the inputs opened for its media decode
+ *  it instead, which makes the preview and the thumbnails cheaper. Exports keep using
+ *  the original medias. \sa Backend::IInput::cloneOriginals()
+ *  The medias too expensive to decode at all can be optimized instead: they get
+ *  transcoded to the same intra-frame format at their full resolution, which is then
+ *  decoded in place of their proxy, for the preview only as well.
+ */
+class ProxyService : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static const QString    SubDirectory;
+        static const quint32    Height = 360;
+
+        enum Kind
+        {
+            Proxy,
+            // Full resolution, from which the preview looks like the export would
+            Optimized,
+        };
+
+        explicit ProxyService( QObject* parent = nullptr );
+        ~ProxyService();
+
+        /**
+         *  \brief  Sets the cache directory. An empty path disables the proxies.
+         */
+        void                    setDirectory( const QString& cacheDir );
+        void                    setMaxJobs( quint32 maxJobs );
+
+        /**
+         *  \brief  Uses the proxy of filePath, if it was generated already. Its
+         *          optimized media is preferred.
+         *
+         *  This must be called before the media's inputs are opened to affect them.
+         *  \returns    true if there is one.
+         */
+        bool                    useExisting( const QString& filePath );
+        bool                    isOptimized( const QString& filePath ) const;
+        /**
+         *  \brief  Generates a proxy of filePath, unless it has one already.
+         *
+         *  proxyReady() is emitted once it's generated, and is used from then on. An
+         *  optimized media is used even if it has a proxy, and emits optimized() too.
+         */
+        void                    request( const QString& filePath, Kind kind = Proxy );
+        void                    cancelAll();
+
+    private:
+        QString                 proxyPath( const QString& filePath, Kind kind ) const;
+        void                    schedule();
+        void                    jobFinished( RenderJob* job, bool success );
+        // Uses the proxy which just got published
+        void                    ready( const QString& filePath, Kind kind );
+        // Looks for the proxy claimed by another writer again, in a while
+        void                    retry( const QString& filePath, Kind kind );
+
+    private:
+        struct Job
+        {
+            QString                             filePath;
+            QString                             proxyPath;
+            QString                             partPath;
+            Kind                                kind;
+            std::shared_ptr<Backend::IInput>    input;
+            // Held until the proxy is published
+            std::shared_ptr<QLockFile>          claim;
+        };
+
+        QString                 m_directory;
+        quint32                 m_maxJobs;
+        QList<QPair<QString, Kind>> m_pending;
+        QHash<RenderJob*, Job>  m_running;
+
+    signals:
+        void                    proxyReady( const QString& filePath );
+        // The inputs of filePath have to be opened again to decode it
+        void                    optimized( const QString& filePath );
+        /**
+         *  \param  percent     The progress of the proxy being generated for filePath.
+         */
+        void                    progress( const QString& filePath, int percent );
+};
+
+#endif // PROXYSERVICE_H
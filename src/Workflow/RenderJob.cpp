@@ -0,0 +1,609 @@
+/*****************************************************************************
+ * RenderJob.cpp: Asynchronous export of a sequence to a file
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "RenderJob.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IInput.h"
+#include "Backend/IProfile.h"
+#include "Backend/MLT/MLTOutput.h"
+#include "Backend/MLT/MLTService.h"
+#include "ImageSequenceExport.h"
+#include "SegmentedExport.h"
+#include "StemExport.h"
+#include "Tools/FramePool.h"
+#include "Tools/Metrics.h"
+#include "Tools/VideoFrame.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QFile>
+#include <QProcess>
+#include <QTimer>
+
+namespace
+{
+    // Appended to the pass log file name by MLT, and by x264 for its macroblock tree
+    const char* const   PassFileSuffixes[] = { "_2pass.log", "_2pass.log.mbtree" };
+}
+
+RenderJob::RenderJob( const RenderParameters& params, quint32 nbWorkers, QObject* parent )
+    : QObject( parent )
+    , m_renditions( { params } )
+    , m_nbWorkers( qMax( 1u, nbWorkers ) )
+    , m_totalFrames( 0 )
+    , m_rangeBegin( 0 )
+    , m_rangeEnd( -1 )
+    , m_running( false )
+    , m_cancelled( false )
+    , m_pass( 0 )
+    , m_reusedStats( false )
+    , m_previewInterval( 0 )
+    , m_nextPreview( 0 )
+    , m_hashFrames( false )
+    , m_hashOffset( 0 )
+    , m_concatenation( nullptr )
+    , m_smartRender( nullptr )
+{
+    connect( &m_outputWatcher, &OutputEventWatcher::stopped, this, &RenderJob::outputStopped,
+             Qt::QueuedConnection );
+    connect( &m_inputWatcher, &RendererEventWatcher::positionChanged, this, &RenderJob::positionChanged,
+             Qt::QueuedConnection );
+}
+
+RenderJob::RenderJob( const QList<RenderParameters>& renditions, QObject* parent )
+    : RenderJob( renditions.first(), 1, parent )
+{
+    m_renditions = renditions;
+}
+
+RenderJob::~RenderJob()
+{
+    cancel();
+}
+
+bool
+RenderJob::start( Backend::IInput& input )
+{
+    Q_ASSERT( m_running == false );
+    m_totalFrames = input.playableLength();
+    if ( m_rangeEnd >= 0 )
+    {
+        Q_ASSERT( m_nbWorkers == 1 && parameters().passthrough.isEmpty() == true );
+        m_totalFrames = qMin( m_totalFrames, m_rangeEnd ) - m_rangeBegin;
+    }
+    if ( m_totalFrames <= 0 )
+        return false;
+
+    if ( m_renditions.size() == 1 && parameters().passthrough.isEmpty() == false &&
+         parameters().stems.isEmpty() == true &&
+         ImageSequenceExport::isImageSequence( parameters().outputFileName ) == false )
+    {
+        // Keep a copy of the sequence around while the medias are being probed
+        try
+        {
+            m_input = input.clone();
+        }
+        catch ( Backend::InvalidServiceException& )
+        {
+            vlmcWarning() << "Failed to copy the sequence for rendering";
+            return false;
+        }
+        m_smartRender = new SmartRender( parameters(), m_totalFrames, this );
+        connect( m_smartRender, &SmartRender::planned, this, &RenderJob::smartRenderPlanned );
+        if ( m_smartRender->start() == false )
+        {
+            delete m_smartRender;
+            m_smartRender = nullptr;
+        }
+        else
+        {
+            m_running = true;
+            m_timer.start();
+            emit started();
+            return true;
+        }
+    }
+
+    if ( render( m_input != nullptr ? *m_input : input ) == false )
+        return false;
+    m_running = true;
+    m_timer.start();
+    emit started();
+    return true;
+}
+
+bool
+RenderJob::render( Backend::IInput& input )
+{
+    if ( m_renditions.size() == 1 && parameters().stems.isEmpty() == false )
+    {
+        m_stems.reset( new StemExport( input, parameters(), m_rangeBegin, m_rangeBegin + m_totalFrames ) );
+        m_stems->setCallbacks( &m_outputWatcher, &m_inputWatcher );
+        if ( m_stems->start() == false )
+        {
+            m_stems.reset();
+            return false;
+        }
+        return true;
+    }
+    if ( m_renditions.size() == 1 && ImageSequenceExport::isImageSequence( parameters().outputFileName ) == true )
+    {
+        m_sequence.reset( new ImageSequenceExport( input, parameters(), parameters().encoder.encoderThreads,
+                                                   m_rangeBegin, m_rangeBegin + m_totalFrames ) );
+        m_sequence->setCallbacks( &m_outputWatcher, &m_inputWatcher );
+        if ( m_sequence->start() == false )
+        {
+            m_sequence.reset();
+            return false;
+        }
+        // Every file was written by a previous export: there's no output to stop
+        if ( m_sequence->isComplete() == true )
+            QTimer::singleShot( 0, this, &RenderJob::outputStopped );
+        return true;
+    }
+    if ( m_nbWorkers > 1 )
+    {
+        Q_ASSERT( m_renditions.size() == 1 );
+        m_segments.reset( new SegmentedExport( input, m_renditions.first(), m_nbWorkers ) );
+        m_segments->setCallbacks( &m_outputWatcher, &m_inputWatcher );
+        if ( hashesFrames() == true )
+            m_segments->setHashCallback( this );
+        if ( m_segments->start() == false )
+        {
+            m_segments.reset();
+            return false;
+        }
+        // Every segment was rendered by a previous run: they only need to be joined
+        if ( m_segments->isStopped() == true )
+            QTimer::singleShot( 0, this, &RenderJob::outputStopped );
+        return true;
+    }
+
+    try
+    {
+        // The copy renders in a profile of its own: at the export's size and frame rate
+        // rather than scaled by the encoder, and unaffected by the project's settings or
+        // by the other exports. Renditions are still scaled by their own encoders.
+        m_profile = Backend::instance()->createProfile();
+        if ( m_renditions.size() == 1 )
+        {
+            const auto& params = parameters();
+            m_profile->setWidth( params.width );
+            m_profile->setHeight( params.height );
+            m_profile->setFrameRate( params.fps * 100, 100 );
+            m_profile->setAspectRatio( params.aspectNum, params.aspectDen );
+        }
+        m_input = input.clone( *m_profile );
+        // From now on, positions are in frames at the export's frame rate
+        auto ratio = m_profile->fps() / Backend::instance()->profile().fps();
+        if ( m_rangeEnd >= 0 )
+        {
+            auto begin = qRound64( m_rangeBegin * ratio );
+            m_totalFrames = qRound64( ( m_rangeBegin + m_totalFrames ) * ratio ) - begin;
+            m_input->setBoundaries( begin, begin + m_totalFrames - 1 );
+            m_hashOffset = begin;
+        }
+        else
+            m_totalFrames = m_input->playableLength();
+        if ( m_renditions.size() == 1 )
+        {
+            auto output = new Backend::MLT::MLTFFmpegOutput( *m_profile );
+            m_output.reset( output );
+            if ( parameters().encoder.twoPass == true )
+            {
+                // Skips the analysis when an export of the same sequence left its statistics
+                m_reusedStats = QFile::exists( passLogFile() + PassFileSuffixes[0] );
+                m_pass = m_reusedStats == true ? 2 : 1;
+            }
+            configure( *output, passParameters() );
+        }
+        else
+        {
+            auto output = new Backend::MLT::MLTMultiOutput( *m_profile );
+            m_output.reset( output );
+            for ( const auto& params : m_renditions )
+            {
+                Backend::MLT::MLTFFmpegOutput rendition( *m_profile );
+                configure( rendition, params );
+                output->addOutput( rendition );
+            }
+        }
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Failed to set up the rendering of the sequence";
+        m_output.reset();
+        m_input.reset();
+        m_profile.reset();
+        return false;
+    }
+    m_input->setCallback( &m_inputWatcher );
+    m_output->setCallback( &m_outputWatcher );
+    m_output->setFrameCallback( this );
+    // The analysis pass is rendered again
+    if ( hashesFrames() == true && m_pass != 1 )
+        m_output->setHashCallback( this );
+    if ( m_output->connect( *m_input ) == false )
+        return false;
+    m_input->setPosition( 0 );
+    m_output->start();
+    return true;
+}
+
+void
+RenderJob::setRange( qint64 begin, qint64 end )
+{
+    Q_ASSERT( m_running == false );
+    m_rangeBegin = qMax( 0ll, begin );
+    m_rangeEnd = end;
+}
+
+void
+RenderJob::setHashFrames( bool hashFrames )
+{
+    Q_ASSERT( m_running == false );
+    m_hashFrames = hashFrames;
+}
+
+const Tools::FrameHashes&
+RenderJob::frameHashes() const
+{
+    return m_hashes;
+}
+
+bool
+RenderJob::hashesFrames() const
+{
+    return m_hashFrames == true || parameters().frameHashFile.isEmpty() == false ||
+            parameters().referenceHashFile.isEmpty() == false;
+}
+
+void
+RenderJob::cancel()
+{
+    if ( m_running == false )
+        return;
+    m_cancelled = true;
+    if ( m_concatenation != nullptr )
+        m_concatenation->kill();
+    else if ( m_segments != nullptr )
+        m_segments->stop();
+    else if ( m_sequence != nullptr )
+        m_sequence->stop();
+    else if ( m_stems != nullptr )
+        m_stems->stop();
+    else if ( m_output != nullptr )
+        m_output->stop();
+    else if ( m_smartRender != nullptr )
+        // Still probing the medias, nothing was rendered yet
+        finish( false );
+}
+
+bool
+RenderJob::isRunning() const
+{
+    return m_running;
+}
+
+const RenderParameters&
+RenderJob::parameters() const
+{
+    return m_renditions.first();
+}
+
+const QList<RenderParameters>&
+RenderJob::renditions() const
+{
+    return m_renditions;
+}
+
+qint64
+RenderJob::totalFrames() const
+{
+    return m_totalFrames;
+}
+
+void
+RenderJob::setPreview( const QSize& size, qint64 interval )
+{
+    QMutexLocker    lock( &m_previewLock );
+    m_previewSize = size;
+    m_previewInterval = interval;
+    m_nextPreview = 0;
+}
+
+bool
+RenderJob::wantsImage( int64_t position )
+{
+    QMutexLocker    lock( &m_previewLock );
+    if ( m_previewInterval <= 0 || m_previewSize.isEmpty() == true || position < m_nextPreview )
+        return false;
+    m_nextPreview = position + m_previewInterval;
+    return true;
+}
+
+void
+RenderJob::onImage( std::shared_ptr<Backend::IVideoFrame> frame )
+{
+    QSize   size;
+    {
+        QMutexLocker    lock( &m_previewLock );
+        size = m_previewSize;
+    }
+    // The scaled copy is pooled, and the frame gets released right away unless it's
+    // already at the preview size
+    emit preview( Tools::FramePool::scaled( Tools::toQImage( frame ), size, Qt::KeepAspectRatio,
+                                            Qt::FastTransformation ) );
+}
+
+void
+RenderJob::onFrameHash( int64_t position, uint64_t hash )
+{
+    m_hashes.add( position + m_hashOffset, hash );
+}
+
+void
+RenderJob::configure( Backend::MLT::MLTFFmpegOutput& output, const RenderParameters& params )
+{
+    output.setTarget( qPrintable( params.outputFileName ) );
+    output.setWidth( params.width );
+    output.setHeight( params.height );
+    output.setFrameRate( params.fps * 100, 100 );
+    output.setAspectRatio( params.aspectNum, params.aspectDen );
+    output.setVideoBitrate( params.videoBitrate );
+    output.setAudioBitrate( params.audioBitrate );
+    output.setChannels( params.nbChannels );
+    output.setAudioSampleRate( params.sampleRate );
+    output.setEncoderOptions( params.encoder );
+}
+
+void
+RenderJob::positionChanged( qint64 pos )
+{
+    if ( m_running == false )
+        return;
+    // Stopping leads to outputStopped(), which reports the failure
+    if ( m_sequence != nullptr && m_sequence->hasFailed() == true )
+        m_sequence->stop();
+    if ( m_stems != nullptr && m_stems->hasFailed() == true )
+        m_stems->stop();
+    auto done = m_segments != nullptr ? m_segments->renderedFrames() - 1 :
+                m_sequence != nullptr ? m_sequence->writtenFrames() - 1 : pos;
+    // The analysis is reported as the first half of the export
+    if ( m_pass == 1 )
+        done /= 2;
+    else if ( m_pass == 2 && m_reusedStats == false )
+        done = ( m_totalFrames + done ) / 2;
+    auto elapsed = m_timer.elapsed();
+    if ( elapsed > 0 )
+        Tools::Metrics::gauge( "export.fps" ).set( done * 1000.0 / elapsed );
+    emit progress( done );
+}
+
+void
+RenderJob::outputStopped()
+{
+    if ( m_running == false || m_concatenation != nullptr )
+        return;
+    if ( m_sequence != nullptr )
+    {
+        m_sequence->waitForWrites();
+        finish( m_cancelled == false && m_sequence->isComplete() == true );
+        return;
+    }
+    if ( m_stems != nullptr )
+    {
+        finish( m_stems->finish( m_cancelled == false ) );
+        return;
+    }
+    if ( m_pass == 1 )
+    {
+        if ( m_cancelled == true || secondPass() == false )
+            finish( false );
+        return;
+    }
+    if ( m_segments == nullptr )
+    {
+        finish( m_cancelled == false );
+        return;
+    }
+    // Notified once per segment
+    if ( m_cancelled == false )
+        m_segments->startPending();
+    if ( m_segments->isStopped() == false )
+        return;
+    if ( m_cancelled == true )
+    {
+        finish( false );
+        return;
+    }
+
+    QString         program;
+    QStringList     arguments;
+    if ( m_segments->prepareConcatenation( program, arguments ) == false )
+    {
+        finish( false );
+        return;
+    }
+    if ( program.isEmpty() == true )
+    {
+        finish( true );
+        return;
+    }
+    m_concatenation = new QProcess( this );
+    connect( m_concatenation, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>( &QProcess::finished ),
+             this, &RenderJob::concatenationFinished );
+    m_concatenation->start( program, arguments );
+    if ( m_concatenation->waitForStarted() == false )
+    {
+        vlmcWarning() << "Failed to start" << program;
+        delete m_concatenation;
+        m_concatenation = nullptr;
+        finish( false );
+    }
+}
+
+void
+RenderJob::smartRenderPlanned()
+{
+    auto success = false;
+    if ( m_smartRender->hasPassthrough() == true )
+    {
+        // The rendered spans must be encoded like the copied ones to be joined
+        auto params = parameters();
+        params.encoder.videoCodec = m_smartRender->videoEncoder().toStdString();
+        params.encoder.audioCodec = m_smartRender->audioEncoder().toStdString();
+        params.encoder.pixelFormat = m_smartRender->pixelFormat().toStdString();
+        m_segments.reset( new SegmentedExport( *m_input, params, m_nbWorkers, m_smartRender->spans() ) );
+        m_segments->setCallbacks( &m_outputWatcher, &m_inputWatcher );
+        if ( hashesFrames() == true )
+            m_segments->setHashCallback( this );
+        success = m_segments->start();
+        if ( success == true && m_segments->isStopped() == true )
+            QTimer::singleShot( 0, this, &RenderJob::outputStopped );
+    }
+    else
+        success = render( *m_input );
+    if ( success == false )
+        finish( false );
+}
+
+void
+RenderJob::concatenationFinished()
+{
+    auto success = m_cancelled == false && m_concatenation->exitStatus() == QProcess::NormalExit &&
+            m_concatenation->exitCode() == 0;
+    if ( success == false )
+        vlmcWarning() << "Failed to join the exported segments:" << m_concatenation->readAllStandardError();
+    m_concatenation->deleteLater();
+    m_concatenation = nullptr;
+    finish( success );
+}
+
+QString
+RenderJob::passLogFile() const
+{
+    const auto& passLogFile = parameters().encoder.passLogFile;
+    if ( passLogFile.empty() == true )
+        return parameters().outputFileName + ".pass";
+    return QString::fromStdString( passLogFile );
+}
+
+RenderParameters
+RenderJob::passParameters() const
+{
+    auto params = parameters();
+    params.encoder.pass = m_pass;
+    // The first pass writes aside, as it may not complete
+    if ( m_pass > 0 )
+        params.encoder.passLogFile = ( m_pass == 1 ? passLogFile() + ".part" : passLogFile() ).toStdString();
+    return params;
+}
+
+bool
+RenderJob::secondPass()
+{
+    auto base = passLogFile();
+    for ( auto suffix : PassFileSuffixes )
+    {
+        if ( QFile::exists( base + ".part" + suffix ) == false )
+            continue;
+        QFile::remove( base + suffix );
+        QFile::rename( base + ".part" + suffix, base + suffix );
+    }
+    if ( QFile::exists( base + PassFileSuffixes[0] ) == false )
+    {
+        vlmcWarning() << "The first pass didn't write any statistics to" << base;
+        return false;
+    }
+
+    m_pass = 2;
+    // The sequence copy is encoded again, from its first frame
+    m_output.reset();
+    try
+    {
+        auto output = new Backend::MLT::MLTFFmpegOutput( *m_profile );
+        m_output.reset( output );
+        configure( *output, passParameters() );
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Failed to set up the second pass";
+        m_output.reset();
+        return false;
+    }
+    m_output->setCallback( &m_outputWatcher );
+    m_output->setFrameCallback( this );
+    if ( hashesFrames() == true )
+        m_output->setHashCallback( this );
+    if ( m_output->connect( *m_input ) == false )
+        return false;
+    m_input->setPosition( 0 );
+    m_output->start();
+    return true;
+}
+
+void
+RenderJob::finish( bool success )
+{
+    m_running = false;
+    if ( success == true && hashesFrames() == true )
+    {
+        const auto& params = parameters();
+        if ( params.frameHashFile.isEmpty() == false )
+            m_hashes.save( params.frameHashFile );
+        if ( params.referenceHashFile.isEmpty() == false &&
+             m_hashes.verify( params.referenceHashFile ) == false )
+            success = false;
+    }
+    Tools::Metrics::counter( success == true ? "export.succeeded" : "export.failed" ).add();
+    Tools::Metrics::histogram( "export.duration" ).record( m_timer.nsecsElapsed() / 1000 );
+    // Release the consumers, and the temporary segments
+    m_output.reset();
+    m_input.reset();
+    m_profile.reset();
+    if ( success == true && m_segments != nullptr )
+        m_segments->removeCheckpoint();
+    m_segments.reset();
+    m_sequence.reset();
+    m_stems.reset();
+    if ( m_pass > 0 )
+    {
+        // Incomplete statistics are never kept, nor any outside of the workspace
+        auto base = passLogFile();
+        for ( auto suffix : PassFileSuffixes )
+        {
+            QFile::remove( base + ".part" + suffix );
+            if ( parameters().encoder.passLogFile.empty() == true )
+                QFile::remove( base + suffix );
+        }
+        m_pass = 0;
+        m_reusedStats = false;
+    }
+    if ( m_smartRender != nullptr )
+    {
+        // finish() may be called from one of its signals
+        m_smartRender->deleteLater();
+        m_smartRender = nullptr;
+    }
+    emit finished( success );
+}
@@ -0,0 +1,199 @@
+/*****************************************************************************
+ * RenderJob.h: Asynchronous export of a sequence to a file
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef RENDERJOB_H
+#define RENDERJOB_H
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QSize>
+#include <QString>
+
+#include "Backend/IOutput.h"
+#include "RenderParameters.h"
+#include "SmartRender.h"
+#include "Tools/FrameHash.h"
+#include "Tools/OutputEventWatcher.h"
+#include "Tools/RendererEventWatcher.h"
+
+#include <memory>
+
+class ImageSequenceExport;
+class QProcess;
+class SegmentedExport;
+class StemExport;
+
+namespace Backend
+{
+class IInput;
+class IProfile;
+namespace MLT
+{
+class MLTFFmpegOutput;
+class MLTOutput;
+}
+}
+
+/**
+ *  \brief  Renders a copy of a sequence to a file, without blocking the caller.
+ *
+ *  The sequence is copied when the job starts, so it can keep being edited and
+ *  previewed, and several jobs can run at once. Completion is notified by the
+ *  consumers themselves, through finished().
+ *  An output file name with a frame number, such as "shot_%04d.png", is exported as
+ *  an image sequence. \sa ImageSequenceExport
+ *  With stems, the audio alone is exported, to a file per stem. \sa StemExport
+ *  A two pass encode first renders the sequence to a quick analysis pass, unless its
+ *  statistics were kept from a previous export of the same sequence.
+ *  The frames given to the encoder can be hashed, to check that segmented or distributed
+ *  renders match a single pass one. Image sequences and audio exports aren't hashed.
+ */
+class RenderJob : public QObject, private Backend::IOutputFrameCb, private Backend::IOutputHashCb
+{
+    Q_OBJECT
+
+    public:
+        /**
+         *  \param  nbWorkers   The number of segments encoded concurrently. 1 renders in
+         *                      a single pass. \sa SegmentedExport
+         */
+        RenderJob( const RenderParameters& params, quint32 nbWorkers, QObject* parent = nullptr );
+        /**
+         *  \brief Renders all renditions from a single decoding pass of the sequence.
+         *
+         *  The renditions must share the same frame rate. They can't be segmented.
+         *  \sa    Backend::MLT::MLTMultiOutput
+         */
+        RenderJob( const QList<RenderParameters>& renditions, QObject* parent = nullptr );
+        ~RenderJob();
+
+        /**
+         *  \brief  Copies input and starts rendering it. Returns false if it can't.
+         *
+         *  This must be called from the GUI thread, while input isn't being played.
+         */
+        bool                    start( Backend::IInput& input );
+        void                    cancel();
+        bool                    isRunning() const;
+        /**
+         *  \brief Emits preview() with one of the rendered frames, every interval frames.
+         *
+         *  The frames are taken from the encoder's input and downscaled to fit size, so
+         *  nothing gets rendered twice. 0 disables the previews, which is the default.
+         *  Segmented exports don't provide previews.
+         */
+        void                    setPreview( const QSize& size, qint64 interval );
+        /**
+         *  \brief Only renders the frames [begin, end) of the input. Must be called before
+         *         start(), and is only supported by single pass renders.
+         */
+        void                    setRange( qint64 begin, qint64 end );
+        /**
+         *  \brief Hashes the frames, even without a frame hash file in the parameters.
+         *         Must be called before start(). \sa frameHashes()
+         */
+        void                    setHashFrames( bool hashFrames );
+        /**
+         *  \brief By frame of the sequence, at the export's frame rate. Complete once
+         *         finished() is emitted.
+         */
+        const Tools::FrameHashes&   frameHashes() const;
+
+        // The first rendition's parameters
+        const RenderParameters& parameters() const;
+        const QList<RenderParameters>&  renditions() const;
+        qint64                  totalFrames() const;
+
+    private:
+        static void             configure( Backend::MLT::MLTFFmpegOutput& output,
+                                           const RenderParameters& params );
+        virtual bool            wantsImage( int64_t position ) override;
+        virtual void            onImage( std::shared_ptr<Backend::IVideoFrame> frame ) override;
+        virtual void            onFrameHash( int64_t position, uint64_t hash ) override;
+        bool                    hashesFrames() const;
+        // Renders a single pass, or in segments
+        bool                    render( Backend::IInput& input );
+        void                    positionChanged( qint64 pos );
+        void                    outputStopped();
+        void                    smartRenderPlanned();
+        void                    concatenationFinished();
+        void                    finish( bool success );
+        // Without the encoder's suffix. In the output's directory without a workspace
+        QString                 passLogFile() const;
+        // The first rendition's, set up for the current pass of a two pass encode
+        RenderParameters        passParameters() const;
+        // Keeps the statistics of the first pass, and encodes the second one
+        bool                    secondPass();
+
+    private:
+        QList<RenderParameters>                         m_renditions;
+        quint32                                         m_nbWorkers;
+        qint64                                          m_totalFrames;
+        qint64                                          m_rangeBegin;
+        qint64                                          m_rangeEnd;
+        bool                                            m_running;
+        bool                                            m_cancelled;
+        // The pass of a two pass encode, 0 for a single pass one
+        int                                             m_pass;
+        // Whether the statistics of a previous export were reused, skipping the first pass
+        bool                                            m_reusedStats;
+        // Declared first, as the backend objects below hold pointers to them
+        OutputEventWatcher                              m_outputWatcher;
+        RendererEventWatcher                            m_inputWatcher;
+        // Accessed from the output thread
+        QMutex                                          m_previewLock;
+        QSize                                           m_previewSize;
+        qint64                                          m_previewInterval;
+        qint64                                          m_nextPreview;
+        bool                                            m_hashFrames;
+        // Added to the positions of the hashed frames, when only a range is rendered
+        qint64                                          m_hashOffset;
+        Tools::FrameHashes                              m_hashes;
+        // The sequence copy and its output are rendered in it, so it outlives them
+        std::unique_ptr<Backend::IProfile>              m_profile;
+        std::unique_ptr<Backend::IInput>                m_input;
+        std::unique_ptr<Backend::MLT::MLTOutput>        m_output;
+        std::unique_ptr<SegmentedExport>                m_segments;
+        std::unique_ptr<ImageSequenceExport>            m_sequence;
+        std::unique_ptr<StemExport>                     m_stems;
+        QProcess*                                       m_concatenation;
+        SmartRender*                                    m_smartRender;
+        // Measures the throughput reported in the export metrics
+        QElapsedTimer                                   m_timer;
+
+    signals:
+        void                    started();
+        /**
+         *  \param  frame   The last rendered frame, 0 indexed.
+         */
+        void                    progress( qint64 frame );
+        /**
+         *  \brief Emitted from the output thread. \sa setPreview()
+         */
+        void                    preview( const QImage& image );
+        void                    finished( bool success );
+};
+
+#endif // RENDERJOB_H
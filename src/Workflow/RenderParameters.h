@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * RenderParameters.h: What an export renders, and where
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef RENDERPARAMETERS_H
+#define RENDERPARAMETERS_H
+
+#include <QList>
+#include <QString>
+
+#include "Backend/IOutput.h"
+
+/**
+ *  \brief  A range of the sequence in which a single clip plays, unmodified.
+ */
+struct PassthroughRange
+{
+    // In sequence frames, end excluded
+    qint64      begin;
+    qint64      end;
+    QString     filePath;
+    // The media frame played at begin
+    qint64      sourceBegin;
+};
+
+// A group of tracks exported to a file of its own. \sa StemExport
+struct StemParameters
+{
+    QString         outputFileName;
+    QList<quint32>  tracks;
+};
+
+struct RenderParameters
+{
+    QString     outputFileName;
+    quint32     width;
+    quint32     height;
+    double      fps;
+    int         aspectNum;
+    int         aspectDen;
+    quint32     videoBitrate;
+    quint32     audioBitrate;
+    quint32     nbChannels;
+    quint32     sampleRate;
+    Backend::EncoderOptions encoder;
+    // Parts of the sequence which may be stream-copied. \sa SmartRender
+    QList<PassthroughRange> passthrough;
+    // When set, only the audio is exported: the master mix to outputFileName, and each
+    // stem to its own file
+    QList<StemParameters>   stems;
+    // When set, the hash of every frame is written there once the export succeeds.
+    // \sa Tools::FrameHashes
+    QString     frameHashFile;
+    // When set, the frames are checked against these hashes, from a single pass render
+    // of the same sequence, and the export fails if any of them differs
+    QString     referenceHashFile;
+};
+
+#endif // RENDERPARAMETERS_H
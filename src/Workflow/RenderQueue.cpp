@@ -0,0 +1,200 @@
+/*****************************************************************************
+ * RenderQueue.cpp: Schedules the export jobs
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "RenderQueue.h"
+
+#include "Backend/IInput.h"
+#include "Backend/MLT/MLTService.h"
+#include "Tools/VlmcDebug.h"
+
+#include <algorithm>
+
+RenderQueue::RenderQueue( QObject* parent )
+    : QObject( parent )
+    , m_maxJobs( 1 )
+    , m_fanOut( false )
+{
+}
+
+QList<RenderJob*>
+RenderQueue::enqueue( Backend::IInput& sequence, const QList<RenderParameters>& renditions,
+                      quint32 nbWorkers, qint64 begin, qint64 end )
+{
+    QList<RenderJob*>   jobs;
+    if ( renditions.isEmpty() == true )
+        return jobs;
+
+    std::shared_ptr<Backend::IInput>    source;
+    try
+    {
+        // Exports always decode the original medias
+        source = sequence.cloneOriginals();
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Failed to copy the sequence for rendering";
+        return jobs;
+    }
+
+    // Smart renders copy parts of the medias, they can't share a stream. Stems are
+    // rendered without their video, and two pass encodes render the sequence twice.
+    auto shareable = []( const RenderParameters& params ) {
+        return params.passthrough.isEmpty() == true && params.stems.isEmpty() == true &&
+                params.encoder.twoPass == false;
+    };
+    QList<QList<RenderParameters>>  groups;
+    for ( const auto& params : renditions )
+    {
+        auto it = groups.end();
+        if ( m_fanOut == true && shareable( params ) == true )
+        {
+            it = std::find_if( groups.begin(), groups.end(), [&params, &shareable]( const QList<RenderParameters>& g )
+            {
+                return shareable( g.first() ) == true &&
+                        qFuzzyCompare( g.first().fps, params.fps );
+            } );
+        }
+        if ( it == groups.end() )
+            groups.append( QList<RenderParameters>{ params } );
+        else
+            ( *it ).append( params );
+    }
+
+    for ( const auto& group : groups )
+    {
+        auto job = group.size() == 1 ? new RenderJob( group.first(), end >= 0 ? 1 : nbWorkers, this )
+                                     : new RenderJob( group, this );
+        if ( end >= 0 )
+            job->setRange( begin, end );
+        connect( job, &RenderJob::finished, this, [this, job]( bool success )
+        {
+            finished( job, success );
+        } );
+        m_pending.append( Entry{ job, source } );
+        jobs.append( job );
+    }
+    schedule();
+    checkIdle();
+    return jobs;
+}
+
+void
+RenderQueue::cancel( RenderJob* job )
+{
+    if ( m_running.contains( job ) == true )
+    {
+        job->cancel();
+        return;
+    }
+    for ( auto it = m_pending.begin(); it != m_pending.end(); ++it )
+    {
+        if ( ( *it ).job != job )
+            continue;
+        m_pending.erase( it );
+        emit jobFinished( job, false );
+        job->deleteLater();
+        checkIdle();
+        return;
+    }
+}
+
+void
+RenderQueue::cancelAll()
+{
+    // Drop the pending jobs first, so that none starts when the running ones stop
+    while ( m_pending.isEmpty() == false )
+        cancel( m_pending.first().job );
+    for ( auto job : m_running )
+        job->cancel();
+}
+
+quint32
+RenderQueue::maxConcurrentJobs() const
+{
+    return m_maxJobs;
+}
+
+void
+RenderQueue::setMaxConcurrentJobs( quint32 maxJobs )
+{
+    m_maxJobs = qMax( 1u, maxJobs );
+    schedule();
+}
+
+bool
+RenderQueue::fanOut() const
+{
+    return m_fanOut;
+}
+
+void
+RenderQueue::setFanOut( bool fanOut )
+{
+    m_fanOut = fanOut;
+}
+
+int
+RenderQueue::nbPendingJobs() const
+{
+    return m_pending.size();
+}
+
+int
+RenderQueue::nbRunningJobs() const
+{
+    return m_running.size();
+}
+
+void
+RenderQueue::schedule()
+{
+    while ( m_pending.isEmpty() == false && (quint32)m_running.size() < m_maxJobs )
+    {
+        auto entry = m_pending.takeFirst();
+        if ( entry.job->start( *entry.source ) == false )
+        {
+            vlmcWarning() << "Failed to start rendering" << entry.job->parameters().outputFileName;
+            emit jobFinished( entry.job, false );
+            entry.job->deleteLater();
+            continue;
+        }
+        m_running.append( entry.job );
+        emit jobStarted( entry.job );
+    }
+}
+
+void
+RenderQueue::checkIdle()
+{
+    if ( m_pending.isEmpty() == true && m_running.isEmpty() == true )
+        emit idle();
+}
+
+void
+RenderQueue::finished( RenderJob* job, bool success )
+{
+    m_running.removeOne( job );
+    emit jobFinished( job, success );
+    job->deleteLater();
+    schedule();
+    checkIdle();
+}
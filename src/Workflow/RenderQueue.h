@@ -0,0 +1,119 @@
+/*****************************************************************************
+ * RenderQueue.h: Schedules the export jobs
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <QList>
+#include <QObject>
+
+#include "RenderJob.h"
+
+#include <memory>
+
+namespace Backend
+{
+class IInput;
+}
+
+/**
+ *  \brief  Runs export jobs in order, with at most maxConcurrentJobs() at once.
+ *
+ *  The sequence is copied when jobs are queued, so they render the timeline as it
+ *  was at that time, even if they only start later. The jobs queued together share
+ *  this copy. With fan-out enabled, renditions queued together are even rendered by
+ *  a single job, decoding the copy once for all of them.
+ *  Jobs are owned by the queue, and deleted once finished.
+ */
+class RenderQueue : public QObject
+{
+    Q_OBJECT
+
+    public:
+        /**
+         *  \brief Running jobs are cancelled when the queue gets deleted.
+         */
+        explicit RenderQueue( QObject* parent = nullptr );
+
+        /**
+         *  \brief  Queues the renditions of sequence.
+         *
+         *  This must be called from the GUI thread, while sequence isn't being played.
+         *  \param  nbWorkers   The number of segments each job encodes concurrently.
+         *                      Ignored for the renditions rendered by a fan-out job.
+         *  \param  begin, end  Only renders the frames [begin, end) of the sequence when
+         *                      end is positive. Such jobs render in a single pass.
+         *  \returns    The queued jobs, or an empty list if the sequence couldn't be copied.
+         */
+        QList<RenderJob*>       enqueue( Backend::IInput& sequence,
+                                         const QList<RenderParameters>& renditions,
+                                         quint32 nbWorkers, qint64 begin = 0, qint64 end = -1 );
+        /**
+         *  \brief  Cancels job, whether it's running or still pending.
+         */
+        void                    cancel( RenderJob* job );
+        void                    cancelAll();
+
+        quint32                 maxConcurrentJobs() const;
+        void                    setMaxConcurrentJobs( quint32 maxJobs );
+        bool                    fanOut() const;
+        /**
+         *  \brief  Renders the renditions queued together which share a frame rate
+         *          from a single pass. \sa RenderJob
+         */
+        void                    setFanOut( bool fanOut );
+        int                     nbPendingJobs() const;
+        int                     nbRunningJobs() const;
+
+    private:
+        struct Entry
+        {
+            RenderJob*                          job;
+            // Shared by the jobs queued together
+            std::shared_ptr<Backend::IInput>    source;
+        };
+
+        void                    schedule();
+        void                    checkIdle();
+        void                    finished( RenderJob* job, bool success );
+
+    private:
+        quint32                 m_maxJobs;
+        bool                    m_fanOut;
+        QList<Entry>            m_pending;
+        QList<RenderJob*>       m_running;
+
+    signals:
+        void                    jobStarted( RenderJob* job );
+        /**
+         *  \brief  Emitted for each queued job, including the ones which failed to start.
+         *
+         *  The job is deleted afterward.
+         */
+        void                    jobFinished( RenderJob* job, bool success );
+        /**
+         *  \brief  Emitted when the last job finished.
+         */
+        void                    idle();
+};
+
+#endif // RENDERQUEUE_H
@@ -0,0 +1,254 @@
+/*****************************************************************************
+ * SceneDetectionService.cpp: Detects the shot changes of the medias
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "SceneDetectionService.h"
+#include "FrameIndexService.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IInput.h"
+#include "Backend/IProfile.h"
+#include "Main/Core.h"
+#include "Tools/CacheFile.h"
+#include "Tools/FileHash.h"
+#include "Tools/FrameIndex.h"
+#include "Tools/SceneDetection.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QAtomicInt>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QTextStream>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    // The size of the analyzed frames. Histograms don't need more.
+    const uint32_t  AnalysisWidth = 64;
+    const uint32_t  AnalysisHeight = 36;
+    // Segments shorter than this aren't worth their own decoder
+    const qint64    MinSegmentLength = 250;
+    const float     CutThreshold = 0.25f;
+    const qint64    MinShotLength = 12;
+}
+
+const QString   SceneDetectionService::SubDirectory = ".scenes";
+
+struct SceneDetectionService::Analysis
+{
+    QString             filePath;
+    QString             outputPath;
+    // distances[i] compares frame i to frame i - 1. Each job writes its own segment.
+    std::vector<float>  distances;
+    QAtomicInt          remaining;
+    QAtomicInt          failed;
+};
+
+SceneDetectionService::SceneDetectionService( Tools::JobScheduler* scheduler, QObject* parent )
+    : QObject( parent )
+    , m_scheduler( scheduler )
+{
+}
+
+SceneDetectionService::~SceneDetectionService()
+{
+    m_scheduler->cancel( m_token );
+    m_scheduler->wait( m_token );
+}
+
+void
+SceneDetectionService::setDirectory( const QString& cacheDir )
+{
+    QMutexLocker    lock( &m_mutex );
+    if ( cacheDir.isEmpty() == true )
+        m_directory.clear();
+    else
+        m_directory = cacheDir + '/' + SubDirectory;
+}
+
+QString
+SceneDetectionService::outputPath( const QString& filePath ) const
+{
+    QString directory;
+    {
+        QMutexLocker    lock( &m_mutex );
+        directory = m_directory;
+    }
+    if ( directory.isEmpty() == true )
+        return QString();
+    auto hash = Tools::contentHash( filePath );
+    if ( hash.isEmpty() == true )
+        return QString();
+    // The cuts are frame numbers
+    return directory + '/' + QString::fromLatin1( hash ) + '_' +
+            QString::number( Backend::instance()->profile().fps(), 'g', 8 ) + ".cuts";
+}
+
+bool
+SceneDetectionService::request( const QString& filePath, qint64 nbFrames )
+{
+    auto path = outputPath( filePath );
+    if ( path.isEmpty() == true || nbFrames <= 0 )
+        return false;
+    if ( QFile::exists( path ) == true )
+    {
+        emit detected( filePath );
+        return true;
+    }
+    if ( QDir().mkpath( QFileInfo( path ).absolutePath() ) == false )
+    {
+        vlmcWarning() << "Can't create the scene detection directory for" << path;
+        return false;
+    }
+    {
+        QMutexLocker    lock( &m_mutex );
+        if ( m_pending.contains( path ) == true )
+            return true;
+        m_pending.insert( path );
+    }
+
+    // A proxy only has keyframes, and is what gets decoded instead of the indexed file
+    std::shared_ptr<const Tools::FrameIndex>    index;
+    if ( Backend::instance()->proxies().count( filePath.toStdString() ) == 0 )
+        index = Core::instance()->frameIndexService()->index( filePath );
+    auto nbSegments = qBound<qint64>( 1, nbFrames / MinSegmentLength, m_scheduler->nbThreads() );
+    std::vector<qint64> boundaries{ 0 };
+    for ( qint64 i = 1; i < nbSegments; ++i )
+    {
+        auto pos = i * nbFrames / nbSegments;
+        if ( index != nullptr )
+            pos = index->seek( pos, Backend::instance()->profile().fps() ).keyframe;
+        if ( pos > boundaries.back() )
+            boundaries.push_back( pos );
+    }
+    boundaries.push_back( nbFrames );
+
+    auto analysis = std::make_shared<Analysis>();
+    analysis->filePath = filePath;
+    analysis->outputPath = path;
+    analysis->distances.resize( nbFrames, 0.f );
+    analysis->remaining = static_cast<int>( boundaries.size() - 1 );
+    for ( size_t i = 0; i + 1 < boundaries.size(); ++i )
+    {
+        auto begin = boundaries[i];
+        auto end = boundaries[i + 1];
+        m_scheduler->schedule( Tools::JobScheduler::Background,
+                               [this, analysis, begin, end]( const Tools::JobScheduler::CancellationToken& token )
+        {
+            analyze( analysis, begin, end, token );
+        }, m_token );
+    }
+    return true;
+}
+
+QList<qint64>
+SceneDetectionService::cuts( const QString& filePath ) const
+{
+    QList<qint64>   res;
+    auto path = outputPath( filePath );
+    if ( path.isEmpty() == true )
+        return res;
+    QFile   file( path );
+    if ( file.open( QIODevice::ReadOnly | QIODevice::Text ) == false )
+        return res;
+    QTextStream stream( &file );
+    while ( stream.atEnd() == false )
+    {
+        bool ok;
+        auto pos = stream.readLine().toLongLong( &ok );
+        if ( ok == true )
+            res.append( pos );
+    }
+    return res;
+}
+
+void
+SceneDetectionService::analyze( const std::shared_ptr<Analysis>& analysis, qint64 begin, qint64 end,
+                                const Tools::JobScheduler::CancellationToken& token )
+{
+    // Starts a frame early, to compare the first frame of the segment to the one before
+    auto pos = std::max<qint64>( 0, begin - 1 );
+    try
+    {
+        auto input = Backend::instance()->acquireInput( qPrintable( analysis->filePath ) );
+        float   histograms[2][Tools::HistogramSize];
+        auto previous = histograms[0];
+        auto current = histograms[1];
+        for ( ; pos < end && token.isCanceled() == false; ++pos )
+        {
+            input->setPosition( pos );
+            auto frame = input->image( AnalysisWidth, AnalysisHeight );
+            if ( frame == nullptr )
+                break;
+            Tools::colourHistogram( frame->data(), frame->width(), frame->height(),
+                                    frame->stride(), current );
+            if ( pos >= begin && pos > 0 )
+                analysis->distances[pos] = Tools::histogramDistance( previous, current );
+            std::swap( previous, current );
+        }
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Can't detect the scenes of" << analysis->filePath;
+    }
+    if ( pos < end )
+        analysis->failed.ref();
+    if ( analysis->remaining.deref() == false )
+        finish( *analysis );
+}
+
+void
+SceneDetectionService::finish( Analysis& analysis )
+{
+    auto success = analysis.failed.load() == 0;
+    if ( success == true )
+    {
+        auto partPath = Tools::CacheFile::partPath( analysis.outputPath );
+        QFile   file( partPath );
+        success = file.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text );
+        if ( success == true )
+        {
+            QTextStream stream( &file );
+            for ( auto cut : Tools::sceneCuts( analysis.distances, CutThreshold, MinShotLength ) )
+                stream << cut << '\n';
+            stream.flush();
+            file.close();
+            success = file.error() == QFile::NoError;
+        }
+        if ( success == true )
+            success = Tools::CacheFile::publish( partPath, analysis.outputPath );
+        if ( success == false )
+        {
+            vlmcWarning() << "Can't write the scene cuts of" << analysis.filePath;
+            QFile::remove( partPath );
+        }
+    }
+    {
+        QMutexLocker    lock( &m_mutex );
+        m_pending.remove( analysis.outputPath );
+    }
+    if ( success == true )
+        emit detected( analysis.filePath );
+}
@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * SceneDetectionService.h: Detects the shot changes of the medias
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SCENEDETECTIONSERVICE_H
+#define SCENEDETECTIONSERVICE_H
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+#include <memory>
+
+#include "Tools/JobScheduler.h"
+
+/**
+ *  \brief  Finds the shot changes of a media in the background, once per media.
+ *
+ *  The media is decoded at a very low resolution, from its proxy when it has one, and
+ *  consecutive frames get compared by their colour histograms. \sa Tools::sceneCuts()
+ *  The media is split in as many segments as there are scheduler threads, each one
+ *  analyzed by its own job. Without a proxy, the segments start at keyframes, so that
+ *  none of them decodes frames another one needs.
+ *  The cuts are stored in the cache directory, keyed by the media content hash.
+ */
+class SceneDetectionService : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static const QString    SubDirectory;
+
+        explicit SceneDetectionService( Tools::JobScheduler* scheduler, QObject* parent = nullptr );
+        ~SceneDetectionService();
+
+        /**
+         *  \brief  Sets the cache directory. An empty path disables the detection.
+         */
+        void                    setDirectory( const QString& cacheDir );
+        /**
+         *  \brief  Detects the shot changes of the nbFrames first frames of filePath,
+         *          unless they are known already.
+         *
+         *  detected() is emitted once done, right away if the cuts are known already.
+         *  \returns    false if there's no cache directory to store the cuts in.
+         */
+        bool                    request( const QString& filePath, qint64 nbFrames );
+        /**
+         *  \returns    The first frame of every shot but the first one, in ascending order.
+         *              Empty if filePath wasn't analyzed, or is a single shot.
+         */
+        QList<qint64>           cuts( const QString& filePath ) const;
+
+    private:
+        struct Analysis;
+
+        QString                 outputPath( const QString& filePath ) const;
+        // Called from the scheduler threads
+        void                    analyze( const std::shared_ptr<Analysis>& analysis, qint64 begin,
+                                         qint64 end, const Tools::JobScheduler::CancellationToken& token );
+        void                    finish( Analysis& analysis );
+
+    private:
+        Tools::JobScheduler*                    m_scheduler;
+        Tools::JobScheduler::CancellationToken  m_token;
+        mutable QMutex                          m_mutex;
+        QString                                 m_directory;
+        // The output paths of the queued and running analysis
+        QSet<QString>                           m_pending;
+
+    signals:
+        /**
+         *  \brief  Emitted once filePath was analyzed, from a worker thread.
+         */
+        void                    detected( const QString& filePath );
+};
+
+#endif // SCENEDETECTIONSERVICE_H
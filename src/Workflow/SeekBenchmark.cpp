@@ -0,0 +1,132 @@
+/*****************************************************************************
+ * SeekBenchmark.cpp: Times and checks the seeks of a media file
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "SeekBenchmark.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IInput.h"
+#include "Backend/MLT/MLTService.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Small enough for the scaling not to weigh on the timings
+    const uint32_t  Width = 480;
+}
+
+constexpr double SeekBenchmark::MinPsnr;
+
+SeekBenchmark::SeekBenchmark( const QString& filePath, quint32 nbSeeks )
+    : m_filePath( filePath )
+    , m_nbSeeks( nbSeeks )
+{
+}
+
+SeekBenchmark::Result
+SeekBenchmark::run()
+{
+    auto exact = Backend::instance()->acquireInput( qPrintable( m_filePath ), Backend::IInput::Exact );
+    auto fast = Backend::instance()->acquireInput( qPrintable( m_filePath ), Backend::IInput::Fast );
+    if ( exact->hasVideo() == false || exact->length() <= 0 )
+        throw Backend::InvalidServiceException();
+    auto height = std::max<uint32_t>( 2, std::lround( Width / exact->aspectRatio() ) & ~1 );
+
+    // Seeded, so that runs compare
+    std::mt19937_64     rng( 42 );
+    std::uniform_int_distribution<int64_t>  distribution( 0, exact->length() - 1 );
+    std::vector<int64_t>    positions( m_nbSeeks );
+    for ( auto& pos : positions )
+        pos = distribution( rng );
+
+    Result          res;
+    res.minPsnr = std::numeric_limits<double>::infinity();
+    qint64          exactNs = 0;
+    qint64          fastNs = 0;
+    QElapsedTimer   timer;
+    for ( auto pos : positions )
+    {
+        timer.start();
+        exact->setPosition( pos );
+        auto reference = exact->image( Width, height );
+        exactNs += timer.nsecsElapsed();
+
+        timer.start();
+        fast->setPosition( pos );
+        auto frame = fast->image( Width, height );
+        fastNs += timer.nsecsElapsed();
+
+        if ( reference == nullptr || frame == nullptr )
+        {
+            vlmcWarning() << "Couldn't decode the frame" << pos << "of" << m_filePath;
+            ++res.nbMisplaced;
+            continue;
+        }
+        auto p = psnr( *reference, *frame );
+        res.minPsnr = std::min( res.minPsnr, p );
+        if ( p < MinPsnr )
+        {
+            vlmcWarning() << "Fast seek to" << pos << "gave another frame, with a PSNR of" << p << "dB";
+            ++res.nbMisplaced;
+        }
+    }
+    res.nbSeeks = m_nbSeeks;
+    if ( m_nbSeeks > 0 )
+    {
+        res.exactMs = exactNs / 1e6 / m_nbSeeks;
+        res.fastMs = fastNs / 1e6 / m_nbSeeks;
+    }
+    return res;
+}
+
+double
+SeekBenchmark::psnr( const Backend::IVideoFrame& a, const Backend::IVideoFrame& b )
+{
+    if ( a.width() != b.width() || a.height() != b.height() ||
+         a.format() != Backend::IVideoFrame::RGBA || b.format() != Backend::IVideoFrame::RGBA )
+        return 0;
+    double  sum = 0;
+    for ( uint32_t y = 0; y < a.height(); ++y )
+    {
+        auto pa = a.data() + y * a.stride();
+        auto pb = b.data() + y * b.stride();
+        for ( uint32_t x = 0; x < a.width() * 4; ++x )
+        {
+            // The alpha carries nothing
+            if ( x % 4 == 3 )
+                continue;
+            double d = (int)pa[x] - (int)pb[x];
+            sum += d * d;
+        }
+    }
+    auto mse = sum / ( (double)a.width() * a.height() * 3 );
+    if ( mse == 0 )
+        return std::numeric_limits<double>::infinity();
+    return 10 * std::log10( 255.0 * 255.0 / mse );
+}
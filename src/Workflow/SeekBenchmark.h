@@ -0,0 +1,76 @@
+/*****************************************************************************
+ * SeekBenchmark.h: Times and checks the seeks of a media file
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SEEKBENCHMARK_H
+#define SEEKBENCHMARK_H
+
+#include <QString>
+
+#include <cstdint>
+
+namespace Backend
+{
+class IVideoFrame;
+}
+
+/**
+ *  \brief  Seeks through a file with both seek precisions, times them, and checks that
+ *          the fast seeks land on the requested frames.
+ *
+ *  The same positions are decoded by an Exact and a Fast input. A fast seek whose
+ *  picture is further from the exact one than the skipped deblocking can explain,
+ *  such as the next keyframe's, counts as misplaced.
+ */
+class SeekBenchmark
+{
+    public:
+        // Below this PSNR, a fast frame isn't the exact one decoded a bit blockier
+        static constexpr double MinPsnr = 30;
+
+        struct Result
+        {
+            quint32     nbSeeks = 0;
+            // Per seek, decoding included
+            double      exactMs = 0;
+            double      fastMs = 0;
+            quint32     nbMisplaced = 0;
+            double      minPsnr = 0;
+        };
+
+        SeekBenchmark( const QString& filePath, quint32 nbSeeks );
+
+        /**
+         *  \brief  Runs the seeks, in the same pseudo random order on each run.
+         *
+         *  Throws InvalidServiceException if the file can't be opened, or has no video.
+         */
+        Result          run();
+
+        // In dB, over the RGB components. Infinite for identical pictures
+        static double   psnr( const Backend::IVideoFrame& a, const Backend::IVideoFrame& b );
+
+    private:
+        QString         m_filePath;
+        quint32         m_nbSeeks;
+};
+
+#endif // SEEKBENCHMARK_H
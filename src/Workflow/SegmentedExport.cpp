@@ -0,0 +1,447 @@
+/*****************************************************************************
+ * SegmentedExport.cpp: Renders a sequence as concurrently encoded segments
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "SegmentedExport.h"
+
+#include "Backend/IInput.h"
+#include "Backend/MLT/MLTOutput.h"
+#include "Backend/MLT/MLTService.h"
+#include "Settings/Settings.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTextStream>
+
+namespace
+{
+    // Longest segment of a checkpointed export, so that little is lost when it stops
+    const int   CheckpointSeconds = 60;
+}
+
+SegmentedExport::SegmentedExport( Backend::IInput& input, const RenderParameters& params, quint32 nbWorkers )
+    : m_input( input )
+    , m_params( params )
+    , m_outputCallback( nullptr )
+    , m_inputCallback( nullptr )
+    , m_hashCallback( nullptr )
+    // Two seconds GOPs by default. Segments are a multiple of it so the keyframe
+    // cadence is preserved accross the joins.
+    , m_nbWorkers( qMax( 1u, nbWorkers ) )
+    , m_gopSize( params.encoder.gopSize > 0 ? params.encoder.gopSize : qMax( 1, qRound( params.fps * 2 ) ) )
+    , m_nextSegment( 0 )
+    , m_stopped( false )
+{
+    qint64 total = input.playableLength();
+    qint64 nbGops = ( total + m_gopSize - 1 ) / m_gopSize;
+    qint64 nbSegments = nbWorkers;
+    if ( VLMC_GET_STRING( "vlmc/WorkspaceLocation" ).isEmpty() == false )
+    {
+        auto checkpointLength = qMax<qint64>( 1, qRound( params.fps * CheckpointSeconds ) );
+        nbSegments = qMax( nbSegments, ( total + checkpointLength - 1 ) / checkpointLength );
+    }
+    nbSegments = qBound<qint64>( 1, nbSegments, qMax<qint64>( 1, nbGops ) );
+    qint64 segmentLength = ( nbGops + nbSegments - 1 ) / nbSegments * m_gopSize;
+
+    for ( qint64 begin = 0; begin < total; begin += segmentLength )
+    {
+        Segment s;
+        s.begin = begin;
+        s.end = qMin( total, begin + segmentLength ) - 1;
+        s.inPoint = s.outPoint = 0;
+        s.done = false;
+        m_segments.push_back( std::move( s ) );
+    }
+    initCheckpoint();
+    for ( size_t i = 0; i < m_segments.size(); ++i )
+        m_segments[i].fileName = segmentFileName( i );
+}
+
+SegmentedExport::SegmentedExport( Backend::IInput& input, const RenderParameters& params, quint32 nbWorkers,
+                                  const QList<SmartRender::Span>& spans )
+    : m_input( input )
+    , m_params( params )
+    , m_outputCallback( nullptr )
+    , m_inputCallback( nullptr )
+    , m_hashCallback( nullptr )
+    , m_nbWorkers( qMax( 1u, nbWorkers ) )
+    // The rendered spans have their own keyframe cadence, starting on a keyframe
+    , m_gopSize( params.encoder.gopSize )
+    , m_nextSegment( 0 )
+    , m_stopped( false )
+{
+    for ( const auto& span : spans )
+    {
+        Segment s;
+        s.begin = span.begin;
+        s.end = span.end - 1;
+        s.source = span.source;
+        s.inPoint = span.inPoint;
+        s.outPoint = span.outPoint;
+        s.done = false;
+        m_segments.push_back( std::move( s ) );
+    }
+    initCheckpoint();
+    for ( size_t i = 0; i < m_segments.size(); ++i )
+    {
+        if ( m_segments[i].source.isEmpty() == true )
+            m_segments[i].fileName = segmentFileName( i );
+    }
+}
+
+SegmentedExport::~SegmentedExport()
+{
+    stop();
+    for ( auto& s : m_segments )
+    {
+        // Release the consumers before their input
+        s.output.reset();
+        s.input.reset();
+        // The rendered segments are kept for the export to be resumed
+        if ( s.fileName.isEmpty() == false && ( s.done == false || m_manifestFileName.isEmpty() == true ) )
+            QFile::remove( s.fileName );
+    }
+    QFile::remove( listFileName() );
+}
+
+void
+SegmentedExport::setCallbacks( Backend::IOutputEventCb* output, Backend::IInputEventCb* input )
+{
+    m_outputCallback = output;
+    m_inputCallback = input;
+}
+
+void
+SegmentedExport::setHashCallback( Backend::IOutputHashCb* callback )
+{
+    m_hashCallback = callback;
+}
+
+SegmentedExport::SegmentHashes::SegmentHashes( Backend::IOutputHashCb* callback, qint64 offset )
+    : m_callback( callback )
+    , m_offset( offset )
+{
+}
+
+void
+SegmentedExport::SegmentHashes::onFrameHash( int64_t position, uint64_t hash )
+{
+    m_callback->onFrameHash( position + m_offset, hash );
+}
+
+QString
+SegmentedExport::segmentFileName( size_t index ) const
+{
+    QFileInfo   info( m_params.outputFileName );
+    auto job = m_jobId.isEmpty() == true ? QString() : '.' + m_jobId;
+    return info.absolutePath() + '/' + '.' + info.completeBaseName() + job + ".part" +
+            QString::number( index ) + '.' + info.suffix();
+}
+
+QString
+SegmentedExport::listFileName() const
+{
+    return segmentFileName( m_segments.size() ) + ".txt";
+}
+
+void
+SegmentedExport::configure( Backend::MLT::MLTFFmpegOutput& output ) const
+{
+    output.setWidth( m_params.width );
+    output.setHeight( m_params.height );
+    output.setFrameRate( m_params.fps * 100, 100 );
+    output.setAspectRatio( m_params.aspectNum, m_params.aspectDen );
+    output.setVideoBitrate( m_params.videoBitrate );
+    output.setAudioBitrate( m_params.audioBitrate );
+    output.setChannels( m_params.nbChannels );
+    output.setAudioSampleRate( m_params.sampleRate );
+    output.setEncoderOptions( m_params.encoder );
+    if ( m_gopSize > 0 )
+        output.setGopSize( m_gopSize );
+}
+
+void
+SegmentedExport::initCheckpoint()
+{
+    auto dir = VLMC_GET_STRING( "vlmc/WorkspaceLocation" );
+    if ( dir.isEmpty() == true )
+        return;
+    std::string snapshot;
+    try
+    {
+        snapshot = m_input.snapshot();
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        return;
+    }
+    QCryptographicHash  hash( QCryptographicHash::Sha1 );
+    hash.addData( snapshot.data(), snapshot.size() );
+    QString     settings;
+    QTextStream s( &settings );
+    // Everything which changes the encoded segments. The encoder's threads do, for x264's
+    // lookahead, the render threads don't: dropFrames tells whether frames may be missing
+    const auto& encoder = m_params.encoder;
+    s << m_params.outputFileName << ' ' << m_params.width << 'x' << m_params.height << '@' << m_params.fps
+      << ' ' << m_params.aspectNum << '/' << m_params.aspectDen << ' ' << m_params.videoBitrate << ' '
+      << m_params.audioBitrate << ' ' << m_params.nbChannels << ' ' << m_params.sampleRate << ' '
+      << QString::fromStdString( encoder.videoCodec ) << ' ' << QString::fromStdString( encoder.audioCodec ) << ' '
+      << QString::fromStdString( encoder.pixelFormat ) << ' ' << QString::fromStdString( encoder.preset ) << ' '
+      << QString::fromStdString( encoder.hardwareDevice ) << ' ' << encoder.encoderThreads << ' '
+      << encoder.dropFrames << ' ' << m_gopSize << ' ' << encoder.fragmented << ' ' << encoder.twoPass << ' '
+      << encoder.pass << ' ' << QString::fromStdString( encoder.passLogFile ) << ' ' << m_input.begin();
+    for ( const auto& segment : m_segments )
+    {
+        s << ' ' << segment.begin << '-' << segment.end << ' ' << segment.source << ' '
+          << segment.inPoint << ' ' << segment.outPoint;
+    }
+    s.flush();
+    hash.addData( settings.toUtf8() );
+    auto id = hash.result().toHex();
+    m_jobId = QString::fromLatin1( id.left( 12 ) );
+    m_manifestFileName = dir + "/.exports/" + QString::fromLatin1( id ) + ".json";
+}
+
+void
+SegmentedExport::resume()
+{
+    if ( m_manifestFileName.isEmpty() == true )
+        return;
+    QFile   file( m_manifestFileName );
+    if ( file.open( QFile::ReadOnly ) == false )
+        return;
+    auto segments = QJsonDocument::fromJson( file.readAll() ).object().value( "segments" ).toArray();
+    int nbResumed = 0;
+    for ( const auto& value : segments )
+    {
+        auto segment = value.toObject();
+        auto index = segment.value( "index" ).toInt( -1 );
+        if ( index < 0 || index >= (int)m_segments.size() )
+            continue;
+        auto& s = m_segments[index];
+        // A segment which got removed or altered since is rendered again
+        if ( s.source.isEmpty() == false ||
+             QFileInfo( s.fileName ).size() != (qint64)segment.value( "size" ).toDouble() )
+            continue;
+        s.done = true;
+        ++nbResumed;
+    }
+    if ( nbResumed > 0 )
+    {
+        vlmcDebug() << "Resuming the export of" << m_params.outputFileName << ":" << nbResumed
+                    << "segments were already rendered";
+    }
+}
+
+void
+SegmentedExport::checkpoint()
+{
+    if ( m_manifestFileName.isEmpty() == true || m_stopped == true )
+        return;
+    bool changed = false;
+    for ( size_t i = 0; i < m_nextSegment; ++i )
+    {
+        auto& s = m_segments[i];
+        if ( s.done == true || s.output == nullptr || s.output->isStopped() == false )
+            continue;
+        s.done = true;
+        changed = true;
+    }
+    if ( changed == false )
+        return;
+
+    QJsonArray  segments;
+    for ( size_t i = 0; i < m_segments.size(); ++i )
+    {
+        const auto& s = m_segments[i];
+        if ( s.done == false || s.source.isEmpty() == false )
+            continue;
+        segments.append( QJsonObject{ { "index", (int)i },
+                                      { "size", (double)QFileInfo( s.fileName ).size() } } );
+    }
+    QJsonObject manifest{ { "output", m_params.outputFileName }, { "segments", segments } };
+    // Written aside and renamed, as VLMC may crash at any point
+    QSaveFile   file( m_manifestFileName );
+    if ( QDir().mkpath( QFileInfo( m_manifestFileName ).absolutePath() ) == false ||
+         file.open( QFile::WriteOnly ) == false ||
+         file.write( QJsonDocument( manifest ).toJson() ) < 0 || file.commit() == false )
+        vlmcWarning() << "Can't write the export manifest" << m_manifestFileName;
+}
+
+void
+SegmentedExport::removeCheckpoint()
+{
+    if ( m_manifestFileName.isEmpty() == true )
+        return;
+    QFile::remove( m_manifestFileName );
+    m_manifestFileName.clear();
+}
+
+bool
+SegmentedExport::start()
+{
+    resume();
+    auto offset = m_input.begin();
+    try
+    {
+        // Cloning is done upfront from the calling thread: the sequence must not change
+        // while it is being serialized.
+        for ( auto& s : m_segments )
+        {
+            if ( s.source.isEmpty() == false || s.done == true )
+                continue;
+            s.input = m_input.clone();
+            s.input->setBoundaries( offset + s.begin, offset + s.end );
+            s.output.reset( new Backend::MLT::MLTFFmpegOutput );
+            configure( *s.output );
+            s.output->setTarget( qPrintable( s.fileName ) );
+            s.input->setCallback( m_inputCallback );
+            s.output->setCallback( m_outputCallback );
+            if ( m_hashCallback != nullptr )
+            {
+                s.hashes.reset( new SegmentHashes( m_hashCallback, s.begin ) );
+                s.output->setHashCallback( s.hashes.get() );
+            }
+            if ( s.output->connect( *s.input ) == false )
+                return false;
+        }
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Failed to copy the sequence for a segmented export";
+        return false;
+    }
+    startPending();
+    return true;
+}
+
+void
+SegmentedExport::startPending()
+{
+    checkpoint();
+    quint32 nbRunning = 0;
+    for ( size_t i = 0; i < m_nextSegment; ++i )
+    {
+        if ( m_segments[i].output != nullptr && m_segments[i].output->isStopped() == false )
+            ++nbRunning;
+    }
+    for ( ; m_nextSegment < m_segments.size() && nbRunning < m_nbWorkers; ++m_nextSegment )
+    {
+        auto& s = m_segments[m_nextSegment];
+        if ( s.output == nullptr )
+            continue;
+        s.input->setPosition( 0 );
+        s.output->start();
+        ++nbRunning;
+    }
+}
+
+void
+SegmentedExport::stop()
+{
+    // Don't let any pending segment start afterward, nor be recorded as complete
+    m_nextSegment = m_segments.size();
+    m_stopped = true;
+    for ( auto& s : m_segments )
+    {
+        if ( s.output != nullptr && s.output->isStopped() == false )
+            s.output->stop();
+    }
+}
+
+bool
+SegmentedExport::isStopped() const
+{
+    if ( m_nextSegment < m_segments.size() )
+        return false;
+    for ( const auto& s : m_segments )
+    {
+        if ( s.output != nullptr && s.output->isStopped() == false )
+            return false;
+    }
+    return true;
+}
+
+qint64
+SegmentedExport::renderedFrames() const
+{
+    qint64 frames = 0;
+    for ( size_t i = 0; i < m_segments.size(); ++i )
+    {
+        const auto& s = m_segments[i];
+        // Copied segments don't cost anything compared to the rendered ones
+        if ( s.input == nullptr )
+            frames += s.end - s.begin + 1;
+        else if ( i >= m_nextSegment )
+            continue;
+        else if ( s.output->isStopped() == true )
+            frames += s.end - s.begin + 1;
+        else
+            frames += qBound<qint64>( 0, s.input->position(), s.end - s.begin + 1 );
+    }
+    return frames;
+}
+
+bool
+SegmentedExport::prepareConcatenation( QString& program, QStringList& arguments )
+{
+    program.clear();
+    arguments.clear();
+    if ( m_segments.size() == 1 && m_segments[0].source.isEmpty() == true )
+    {
+        QFile::remove( m_params.outputFileName );
+        return QFile::rename( m_segments[0].fileName, m_params.outputFileName );
+    }
+
+    program = QStandardPaths::findExecutable( "ffmpeg" );
+    if ( program.isEmpty() == true )
+    {
+        vlmcWarning() << "ffmpeg is required to join the exported segments";
+        return false;
+    }
+
+    QFile   list( listFileName() );
+    if ( list.open( QFile::WriteOnly | QFile::Truncate ) == false )
+        return false;
+    QTextStream stream( &list );
+    for ( const auto& s : m_segments )
+    {
+        auto escaped = s.source.isEmpty() == true ? s.fileName : s.source;
+        escaped.replace( "'", "'\\''" );
+        stream << "file '" << escaped << "'\n";
+        if ( s.source.isEmpty() == false )
+        {
+            stream << "inpoint " << QString::number( s.inPoint, 'f', 6 ) << '\n';
+            stream << "outpoint " << QString::number( s.outPoint, 'f', 6 ) << '\n';
+        }
+    }
+    arguments = QStringList{ "-y", "-v", "error", "-f", "concat", "-safe", "0",
+                             "-i", listFileName(), "-c", "copy", m_params.outputFileName };
+    return true;
+}
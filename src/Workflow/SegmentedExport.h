@@ -0,0 +1,173 @@
+/*****************************************************************************
+ * SegmentedExport.h: Renders a sequence as concurrently encoded segments
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SEGMENTEDEXPORT_H
+#define SEGMENTEDEXPORT_H
+
+#include <QString>
+#include <QStringList>
+
+#include "Backend/IOutput.h"
+#include "RenderJob.h"
+#include "SmartRender.h"
+
+#include <memory>
+#include <vector>
+
+namespace Backend
+{
+class IInput;
+class IInputEventCb;
+class IOutputEventCb;
+namespace MLT
+{
+class MLTFFmpegOutput;
+}
+}
+
+/**
+ *  \brief  Splits a sequence in GOP aligned segments, encoded concurrently.
+ *
+ *  Each segment renders an independent copy of the sequence to a temporary file next
+ *  to the output, on its own consumer. Once they are all done, they are remuxed into
+ *  the final file without reencoding. \sa prepareConcatenation()
+ *
+ *  With a workspace, the completed segments are recorded in a manifest as soon as they
+ *  are rendered, and kept when the export is cancelled or VLMC crashes. The manifest
+ *  is named after the sequence's snapshot, the settings and the segments, so exporting
+ *  the same sequence again only renders the segments which are missing.
+ */
+class SegmentedExport
+{
+    public:
+        SegmentedExport( Backend::IInput& input, const RenderParameters& params, quint32 nbWorkers );
+        /**
+         *  \brief Renders the spans which aren't copied, and joins them with the copied
+         *         ones. At most nbWorkers spans are rendered at once. \sa SmartRender
+         */
+        SegmentedExport( Backend::IInput& input, const RenderParameters& params, quint32 nbWorkers,
+                         const QList<SmartRender::Span>& spans );
+        // Removes the temporary segments
+        ~SegmentedExport();
+
+        /**
+         *  \brief  Sets the callbacks given to every segment. Must be called before start().
+         */
+        void                    setCallbacks( Backend::IOutputEventCb* output,
+                                              Backend::IInputEventCb* input );
+        /**
+         *  \brief  Hashes the frames of every segment, at their position in the input.
+         *          Must be called before start().
+         *
+         *  The segments kept from a previous export, and the copied ones, aren't hashed.
+         */
+        void                    setHashCallback( Backend::IOutputHashCb* callback );
+
+        /**
+         *  \brief  Starts encoding the first segments. Returns false if any failed to start.
+         */
+        bool                    start();
+        /**
+         *  \brief  Starts the segments waiting for a free worker, once others are stopped.
+         *
+         *  The segments which completed are recorded in the manifest first.
+         */
+        void                    startPending();
+        void                    stop();
+        bool                    isStopped() const;
+        /**
+         *  \returns    The number of frames rendered so far, accross all segments.
+         */
+        qint64                  renderedFrames() const;
+        /**
+         *  \brief  Prepares joining the segments, once they are all stopped.
+         *
+         *  The caller is expected to run program with arguments, which writes the
+         *  output. When there is a single segment, it is moved in place directly and
+         *  program is left empty.
+         *  \returns    false if the segments can't be joined.
+         */
+        bool                    prepareConcatenation( QString& program, QStringList& arguments );
+        /**
+         *  \brief  Drops the manifest once the output is written, so that the segments
+         *          get removed along with this object.
+         */
+        void                    removeCheckpoint();
+
+    private:
+        // Moves the positions of a segment's frames to the input's
+        class SegmentHashes : public Backend::IOutputHashCb
+        {
+            public:
+                SegmentHashes( Backend::IOutputHashCb* callback, qint64 offset );
+                virtual void    onFrameHash( int64_t position, uint64_t hash ) override;
+
+            private:
+                Backend::IOutputHashCb*     m_callback;
+                qint64                      m_offset;
+        };
+
+        struct Segment
+        {
+            std::unique_ptr<Backend::IInput>                input;
+            // Declared first, as the output holds a pointer to it
+            std::unique_ptr<SegmentHashes>                  hashes;
+            std::unique_ptr<Backend::MLT::MLTFFmpegOutput>  output;
+            QString                                         fileName;
+            qint64                                          begin;
+            qint64                                          end;
+            // The media copied in place of rendering the segment, if any
+            QString                                         source;
+            double                                          inPoint;
+            double                                          outPoint;
+            // Rendered completely, by this export or by a previous one
+            bool                                            done;
+        };
+
+        QString                 segmentFileName( size_t index ) const;
+        // Names the manifest and the segments after the job. Called once they are laid out
+        void                    initCheckpoint();
+        // Marks the segments rendered by a previous run of the same job as done
+        void                    resume();
+        void                    checkpoint();
+        QString                 listFileName() const;
+        void                    configure( Backend::MLT::MLTFFmpegOutput& output ) const;
+
+    private:
+        Backend::IInput&        m_input;
+        RenderParameters        m_params;
+        Backend::IOutputEventCb*    m_outputCallback;
+        Backend::IInputEventCb*     m_inputCallback;
+        Backend::IOutputHashCb*     m_hashCallback;
+        quint32                 m_nbWorkers;
+        quint32                 m_gopSize;
+        std::vector<Segment>    m_segments;
+        // The next segment to render
+        size_t                  m_nextSegment;
+        bool                    m_stopped;
+        // Empty when not checkpointing
+        QString                 m_manifestFileName;
+        // Part of the segment file names, so that different jobs don't share them
+        QString                 m_jobId;
+};
+
+#endif // SEGMENTEDEXPORT_H
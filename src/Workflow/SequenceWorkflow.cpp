@@ -26,19 +26,58 @@
 
 #include "SequenceWorkflow.h"
 
+#include "Backend/IBackend.h"
+#include "Backend/IProfile.h"
+#include "Backend/MLT/MLTAudioMixer.h"
+#include "Backend/MLT/MLTDissolve.h"
+#include "Backend/MLT/MLTInput.h"
+#include "Backend/MLT/MLTService.h"
 #include "Backend/MLT/MLTTrack.h"
 #include "Backend/MLT/MLTMultiTrack.h"
+#include "Backend/MLT/MLTTransition.h"
 #include "EffectsEngine/EffectHelper.h"
 #include "Workflow/MainWorkflow.h"
 #include "Main/Core.h"
 #include "Library/Library.h"
+#include "Media/Media.h"
+#include "Tools/AudioSync.h"
+#include "Tools/Metrics.h"
+#include "Tools/PcmCache.h"
 #include "Tools/VlmcDebug.h"
+#include "Workflow/WaveformService.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QSet>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 SequenceWorkflow::SequenceWorkflow( size_t trackCount )
     : m_multitrack( new Backend::MLT::MLTMultiTrack )
+    , m_tracksTractor( new Backend::MLT::MLTMultiTrack )
     , m_trackCount( trackCount )
+    , m_nextGroupId( 0 )
+    , m_groupsChanged( false )
+    , m_filtersChanged( false )
+    , m_transitionStyle( Dissolve )
+    , m_editDepth( 0 )
+    , m_indexSnapshot( std::make_shared<IndexSnapshot>() )
+{
+    m_multitrack->setTrack( *m_tracksTractor, 0 );
+    // The tracks' audio is summed once, rather than through transitions
+    m_mixer.reset( new Backend::MLT::MLTAudioMixer( *m_tracksTractor ) );
+}
+
+void
+SequenceWorkflow::allocateTracks( quint32 trackId )
 {
-    for ( int i = 0; i < trackCount; ++i )
+    Q_ASSERT( trackId < m_trackCount );
+    // Tracks are stacked by index in the tractor, so every track below trackId has
+    // to exist as well
+    for ( int i = m_multiTracks.size(); i <= (int)trackId; ++i )
     {
         auto audioTrack = std::shared_ptr<Backend::ITrack>( new Backend::MLT::MLTTrack );
         audioTrack->setVideoEnabled( false );
@@ -53,122 +92,1361 @@ SequenceWorkflow::SequenceWorkflow( size_t trackCount )
         multitrack->setTrack( *audioTrack, 1 );
         m_multiTracks << multitrack;
 
-        m_multitrack->setTrack( *multitrack, i );
+        // Nothing to render until a clip gets added
+        auto placeholder = std::shared_ptr<Backend::ITrack>( new Backend::MLT::MLTTrack );
+        m_placeholders << placeholder;
+        m_active << false;
+        m_tracksTractor->setTrack( *placeholder, i );
+    }
+}
+
+Workflow::TrackType
+SequenceWorkflow::trackType( const Clip& clip )
+{
+    // Same rule as trackFromFormats()
+    return clip.formats().testFlag( Clip::Audio ) ? Workflow::AudioTrack : Workflow::VideoTrack;
+}
+
+void
+SequenceWorkflow::indexClip( const QUuid& uuid )
+{
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
+        return;
+    const auto& clip = m_clips.clip( handle );
+    auto trackId = m_clips.trackId( handle );
+    auto pos = m_clips.position( handle );
+    mutableIndex( trackType( *clip ), trackId ).insert( uuid, pos, pos + clip->length() );
+    m_changedClips.insert( uuid );
+}
+
+void
+SequenceWorkflow::shiftClips( Workflow::TrackType type, quint32 trackId, qint64 from, qint64 delta )
+{
+    auto index = m_clipIndex[type].find( trackId );
+    if ( index == m_clipIndex[type].end() )
+        return;
+    QList<QUuid>    uuids;
+    for ( const auto& e : index->overlapping( from, std::numeric_limits<qint64>::max() ) )
+    {
+        if ( e.begin < from )
+            continue;
+        auto handle = m_clips.handle( e.uuid );
+        m_clips.setPosition( handle, m_clips.position( handle ) + delta );
+        uuids << e.uuid;
+    }
+    reindexClips( uuids );
+}
+
+void
+SequenceWorkflow::reindexClips( const QList<QUuid>& uuids )
+{
+    // Drop them all first: an updated position may still be the key of another clip
+    for ( const auto& uuid : uuids )
+    {
+        auto handle = m_clips.handle( uuid );
+        if ( handle == ClipRegistry::InvalidHandle )
+            continue;
+        const auto& clip = m_clips.clip( handle );
+        mutableIndex( trackType( *clip ), m_clips.trackId( handle ) ).remove( uuid );
+    }
+    for ( const auto& uuid : uuids )
+        indexClip( uuid );
+}
+
+const ClipIndex*
+SequenceWorkflow::clipIndex( Workflow::TrackType type, quint32 trackId ) const
+{
+    if ( type >= Workflow::NbTrackType )
+        return nullptr;
+    auto it = m_clipIndex[type].find( trackId );
+    if ( it == m_clipIndex[type].end() )
+        return nullptr;
+    return &it.value();
+}
+
+ClipIndex&
+SequenceWorkflow::mutableIndex( Workflow::TrackType type, quint32 trackId )
+{
+    m_changedIndexes[type].insert( trackId );
+    return m_clipIndex[type][trackId];
+}
+
+std::shared_ptr<const SequenceWorkflow::IndexSnapshot>
+SequenceWorkflow::indexSnapshot() const
+{
+    return std::atomic_load( &m_indexSnapshot );
+}
+
+void
+SequenceWorkflow::publishIndexes()
+{
+    bool changed = false;
+    for ( const auto& trackIds : m_changedIndexes )
+        changed = changed || trackIds.isEmpty() == false;
+    if ( changed == false )
+        return;
+
+    // Only the writer, on the GUI thread, ever replaces the snapshot
+    auto previous = std::atomic_load( &m_indexSnapshot );
+    auto snapshot = std::make_shared<IndexSnapshot>( *previous );
+    ++snapshot->version;
+    for ( int type = 0; type < Workflow::NbTrackType; ++type )
+    {
+        for ( auto trackId : m_changedIndexes[type] )
+        {
+            auto it = m_clipIndex[type].find( trackId );
+            if ( it == m_clipIndex[type].end() || it->isEmpty() == true )
+                snapshot->tracks[type].remove( trackId );
+            else
+                snapshot->tracks[type].insert( trackId, std::make_shared<const ClipIndex>( it.value() ) );
+        }
+        m_changedIndexes[type].clear();
+    }
+    std::atomic_store( &m_indexSnapshot, std::shared_ptr<const IndexSnapshot>( std::move( snapshot ) ) );
+}
+
+qint64
+SequenceWorkflow::freePosition( Workflow::TrackType type, quint32 trackId, qint64 pos,
+                                qint64 length, const QUuid& ignore, qint64 margin ) const
+{
+    pos = qMax( 0ll, pos );
+    auto index = clipIndex( type, trackId );
+    if ( index == nullptr )
+        return pos;
+    if ( margin > 0 )
+    {
+        // Stick the clip's start or end to the closest clip boundary
+        auto edge = index->nearestEdge( pos, margin, ignore );
+        auto endEdge = index->nearestEdge( pos + length, margin, ignore );
+        if ( edge >= 0 && ( endEdge < 0 || qAbs( edge - pos ) <= qAbs( endEdge - pos - length ) ) )
+            pos = edge;
+        else if ( endEdge >= 0 )
+            pos = qMax( 0ll, endEdge - length );
+    }
+    // Each iteration steps over one obstacle. Past that many, give up and go after
+    // the last clip
+    for ( int i = 0; i <= index->count(); ++i )
+    {
+        auto obstacles = index->overlapping( pos, pos + length, ignore );
+        if ( obstacles.isEmpty() == true )
+            return pos;
+        const auto& obstacle = obstacles.first();
+        if ( obstacle.begin > pos && obstacle.begin - length >= 0 )
+            pos = obstacle.begin - length;
+        else
+            pos = obstacle.end;
+    }
+    return index->end();
+}
+
+void
+SequenceWorkflow::updateTrackActivity( quint32 trackId )
+{
+    if ( trackId >= (quint32)m_multiTracks.size() )
+        return;
+    bool active = false;
+    for ( int type = 0; type < Workflow::NbTrackType && active == false; ++type )
+    {
+        auto index = clipIndex( (Workflow::TrackType)type, trackId );
+        active = index != nullptr && index->isEmpty() == false &&
+                m_mutedTracks[type].contains( trackId ) == false;
+    }
+    if ( active == true && isOccluded( trackId ) == true )
+        active = false;
+    if ( active == m_active[trackId] )
+        return;
+    // The tractor pulls a frame from each of its tracks, for every frame. Swap the
+    // inactive ones for an empty track, which costs next to nothing.
+    if ( active == true )
+        m_tracksTractor->setTrack( *m_multiTracks[trackId], trackId );
+    else
+        m_tracksTractor->setTrack( *m_placeholders[trackId], trackId );
+    m_active[trackId] = active;
+}
+
+bool
+SequenceWorkflow::isOccluded( quint32 trackId ) const
+{
+    auto video = m_clipIndex[Workflow::VideoTrack].find( trackId );
+    if ( video == m_clipIndex[Workflow::VideoTrack].end() || video->isEmpty() == true )
+        return false;
+    // Its sound would go along with the picture
+    auto audio = m_clipIndex[Workflow::AudioTrack].find( trackId );
+    if ( audio != m_clipIndex[Workflow::AudioTrack].end() && audio->isEmpty() == false &&
+         m_mutedTracks[Workflow::AudioTrack].contains( trackId ) == false )
+        return false;
+    for ( const auto& t : m_transitions )
+    {
+        if ( t.aTrack == trackId || t.bTrack == trackId )
+            return false;
+    }
+    for ( const auto& entry : video->overlapping( 0, video->end() ) )
+    {
+        if ( isCovered( entry.begin, entry.end, trackId ) == false )
+            return false;
+    }
+    return true;
+}
+
+bool
+SequenceWorkflow::isCovered( qint64 begin, qint64 end, quint32 trackId ) const
+{
+    QVector<QPair<qint64, qint64>>  covers;
+    const auto& indexes = m_clipIndex[Workflow::VideoTrack];
+    for ( auto it = indexes.cbegin(); it != indexes.cend(); ++it )
+    {
+        if ( it.key() <= trackId || m_mutedTracks[Workflow::VideoTrack].contains( it.key() ) == true )
+            continue;
+        for ( const auto& entry : it->overlapping( begin, end ) )
+        {
+            if ( isOpaque( entry.uuid, it.key() ) == true )
+                covers << qMakePair( entry.begin, entry.end );
+        }
+    }
+    std::sort( covers.begin(), covers.end() );
+    auto pos = begin;
+    for ( const auto& c : covers )
+    {
+        if ( c.first > pos )
+            return false;
+        pos = std::max( pos, c.second );
+        if ( pos >= end )
+            return true;
+    }
+    return pos >= end;
+}
+
+bool
+SequenceWorkflow::isOpaque( const QUuid& uuid, quint32 trackId ) const
+{
+    // Codecs which may carry an alpha channel
+    static const std::string alphaCodecs[] = { "png", "apng", "gif", "qtrle", "prores",
+                                               "vp8", "vp9", "ffv1", "utvideo", "rawvideo", "hap" };
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
+        return false;
+    const auto& clip = m_clips.clip( handle );
+    // Effects may key, move or fade the picture
+    if ( clip->input()->filterCount() > 0 || m_multiTracks[trackId]->filterCount() > 0 ||
+         m_tracks[Workflow::VideoTrack][trackId]->filterCount() > 0 )
+        return false;
+    auto media = clip->media();
+    if ( media == nullptr || media->fileType() != Media::Video )
+        return false;
+    const auto& codec = media->info().videoCodec;
+    return std::find( std::begin( alphaCodecs ), std::end( alphaCodecs ), codec ) == std::end( alphaCodecs );
+}
+
+void
+SequenceWorkflow::setTrackMuted( quint32 trackId, Workflow::TrackType type, bool muted )
+{
+    if ( trackId >= (quint32)m_trackCount || type >= Workflow::NbTrackType )
+        return;
+    if ( m_mutedTracks[type].contains( trackId ) == muted )
+        return;
+    Edit    edit( this );
+    allocateTracks( trackId );
+    if ( muted == true )
+        m_mutedTracks[type].insert( trackId );
+    else
+        m_mutedTracks[type].remove( trackId );
+    if ( type == Workflow::AudioTrack )
+        m_tracks[Workflow::AudioTrack][trackId]->setMute( muted );
+    else
+        m_tracks[Workflow::VideoTrack][trackId]->setVideoEnabled( muted == false );
+    markDirty( 0, -1, trackId );
+}
+
+bool
+SequenceWorkflow::isTrackMuted( quint32 trackId, Workflow::TrackType type ) const
+{
+    if ( type >= Workflow::NbTrackType )
+        return false;
+    return m_mutedTracks[type].contains( trackId );
+}
+
+void
+SequenceWorkflow::setTransitionStyle( TransitionStyle style )
+{
+    if ( style == m_transitionStyle )
+        return;
+    Edit    edit( this );
+    m_transitionStyle = style;
+    // Only the video transitions change, but they're few
+    removeTransitions();
+    updateTransitions();
+    markDirty( 0, -1, -1 );
+}
+
+void
+SequenceWorkflow::setTrackGain( quint32 trackId, float gain )
+{
+    if ( trackId >= (quint32)m_trackCount )
+        return;
+    Edit    edit( this );
+    m_mixer->setGain( trackId, gain );
+    markDirty( 0, -1, trackId );
+}
+
+void
+SequenceWorkflow::setTrackPan( quint32 trackId, float pan )
+{
+    if ( trackId >= (quint32)m_trackCount )
+        return;
+    Edit    edit( this );
+    m_mixer->setPan( trackId, pan );
+    markDirty( 0, -1, trackId );
+}
+
+void
+SequenceWorkflow::updateScrubSources()
+{
+    std::vector<Backend::MLT::MLTAudioMixer::ScrubSource>   sources;
+    auto waveforms = Core::instance()->waveformService();
+    const auto& indexes = m_clipIndex[Workflow::AudioTrack];
+    for ( auto it = indexes.cbegin(); it != indexes.cend(); ++it )
+    {
+        for ( const auto& e : it.value().overlapping( 0, it.value().end() ) )
+        {
+            // Renditions include the effects, and aren't cached
+            if ( isFrozen( e.uuid ) == true )
+                continue;
+            const auto& clip = m_clips.clip( m_clips.handle( e.uuid ) );
+            auto pcm = waveforms->pcm( clip->media()->fileInfo()->absoluteFilePath() );
+            if ( pcm == nullptr )
+                continue;
+            sources.push_back( { it.key(), e.begin, e.end, clip->begin(), pcm } );
+        }
+    }
+    m_mixer->setScrubSources( std::move( sources ) );
+}
+
+QHash<QUuid, qint64>
+SequenceWorkflow::audioSyncPositions( const QList<QUuid>& uuids )
+{
+    // Below this, the best lag is hardly better than any other
+    const double    minConfidence = 0.25;
+    QHash<QUuid, qint64>    positions;
+    auto waveforms = Core::instance()->waveformService();
+    auto fps = Backend::instance()->profile().fps();
+    auto envelope = [this, waveforms, fps]( ClipRegistry::Handle handle ) {
+        const auto& clip = m_clips.clip( handle );
+        auto pcm = waveforms->pcm( clip->media()->fileInfo()->absoluteFilePath() );
+        if ( pcm == nullptr )
+            return std::vector<float>();
+        return Tools::audioEnvelope( *pcm, static_cast<int64_t>( clip->begin() / fps * pcm->frequency() ),
+                                     static_cast<int64_t>( clip->length() / fps * pcm->frequency() ) );
+    };
+    if ( uuids.size() < 2 || fps <= 0 )
+        return positions;
+    auto refHandle = m_clips.handle( uuids.first() );
+    if ( refHandle == ClipRegistry::InvalidHandle )
+        return positions;
+    auto reference = envelope( refHandle );
+    if ( reference.empty() == true )
+        return positions;
+    auto refPos = m_clips.position( refHandle );
+
+    for ( int i = 1; i < uuids.size(); ++i )
+    {
+        auto handle = m_clips.handle( uuids[i] );
+        if ( handle == ClipRegistry::InvalidHandle )
+            continue;
+        auto match = Tools::alignAudio( reference, envelope( handle ) );
+        if ( match.confidence < minConfidence )
+        {
+            vlmcDebug() << "Couldn't sync the audio of clip" << uuids[i] << "confidence:" << match.confidence;
+            continue;
+        }
+        auto pos = refPos + std::llround( match.lag * fps / Tools::AudioEnvelopeRate );
+        if ( pos >= 0 )
+            positions.insert( uuids[i], pos );
+    }
+    return positions;
+}
+
+int
+SequenceWorkflow::setLoudnessNormalization( bool enabled, double target )
+{
+    // What EBU R128 allows for distribution
+    const double    maxTruePeak = -1.;
+    std::vector<Backend::MLT::MLTAudioMixer::ClipGain>  gains;
+    int nbUnmeasured = 0;
+    const auto& indexes = m_clipIndex[Workflow::AudioTrack];
+    for ( auto it = indexes.cbegin(); it != indexes.cend() && enabled == true; ++it )
+    {
+        for ( const auto& e : it.value().overlapping( 0, it.value().end() ) )
+        {
+            const auto& clip = m_clips.clip( m_clips.handle( e.uuid ) );
+            const auto& loudness = clip->media()->loudness();
+            if ( loudness.isValid() == false )
+            {
+                ++nbUnmeasured;
+                continue;
+            }
+            gains.push_back( { it.key(), e.begin, e.end,
+                               (float)loudness.normalizationGain( target, maxTruePeak ) } );
+        }
+    }
+    m_mixer->setClipGains( gains );
+    return nbUnmeasured;
+}
+
+void
+SequenceWorkflow::prepareFreeze( const QUuid& uuid )
+{
+    if ( m_clips.handle( uuid ) == ClipRegistry::InvalidHandle )
+        return;
+    // Rendering it again replaces the current rendition once done
+    thawClip( uuid );
+    m_frozenClips.insert( uuid, FrozenClip{ QString(), nullptr } );
+}
+
+bool
+SequenceWorkflow::freezeClip( const QUuid& uuid, const QString& filePath )
+{
+    auto it = m_frozenClips.find( uuid );
+    if ( it == m_frozenClips.end() || it->input != nullptr )
+        return false;
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
+    {
+        m_frozenClips.erase( it );
+        return false;
+    }
+    const auto& clip = m_clips.clip( handle );
+    std::shared_ptr<Backend::IInput>    input;
+    try
+    {
+        input.reset( new Backend::MLT::MLTInput( Backend::instance()->profile(), qPrintable( filePath ) ) );
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Failed to load the rendition of clip" << uuid;
+        m_frozenClips.erase( it );
+        return false;
+    }
+    // Depending on the container, the file may hold an extra frame
+    input->setBoundaries( 0, clip->length() - 1 );
+
+    auto pos = m_clips.position( handle );
+    auto track = trackFromFormats( m_clips.trackId( handle ), clip->formats() );
+    track->remove( track->clipIndexAt( pos ) );
+    if ( track->insertAt( *input, pos ) == false )
+    {
+        track->insertAt( *clip->input(), pos );
+        m_frozenClips.erase( it );
+        return false;
+    }
+    it->filePath = filePath;
+    it->input = std::move( input );
+    emit frozenChanged( uuid, true );
+    return true;
+}
+
+void
+SequenceWorkflow::thawClip( const QUuid& uuid )
+{
+    auto it = m_frozenClips.find( uuid );
+    if ( it == m_frozenClips.end() )
+        return;
+    auto frozen = it.value();
+    m_frozenClips.erase( it );
+    // Still being rendered: freezeClip() will fail, and its caller drop the file
+    if ( frozen.input == nullptr )
+        return;
+    auto handle = m_clips.handle( uuid );
+    if ( handle != ClipRegistry::InvalidHandle )
+    {
+        const auto& clip = m_clips.clip( handle );
+        auto pos = m_clips.position( handle );
+        auto track = trackFromFormats( m_clips.trackId( handle ), clip->formats() );
+        track->remove( track->clipIndexAt( pos ) );
+        if ( track->insertAt( *clip->input(), pos ) == false )
+            vlmcCritical() << "Couldn't insert clip" << uuid << "back";
+    }
+    QFile::remove( frozen.filePath );
+    emit frozenChanged( uuid, false );
+}
+
+bool
+SequenceWorkflow::isFrozen( const QUuid& uuid ) const
+{
+    auto it = m_frozenClips.find( uuid );
+    return it != m_frozenClips.end() && it->input != nullptr;
+}
+
+int
+SequenceWorkflow::reloadMedia( const Media* media )
+{
+    Edit    edit( this );
+    int nbReloaded = 0;
+    for ( auto handle : m_clips.handles() )
+    {
+        const auto& clip = m_clips.clip( handle );
+        if ( clip->media() != media )
+            continue;
+        clip->reloadInput();
+        ++nbReloaded;
+        // The rendition stays in the track
+        if ( isFrozen( clip->uuid() ) == true )
+            continue;
+        auto pos = m_clips.position( handle );
+        auto trackId = m_clips.trackId( handle );
+        auto track = trackFromFormats( trackId, clip->formats() );
+        track->remove( track->clipIndexAt( pos ) );
+        if ( track->insertAt( *clip->input(), pos ) == false )
+            vlmcCritical() << "Couldn't insert clip" << clip->uuid() << "back";
+        markDirty( pos, pos + clip->length(), trackId );
+    }
+    return nbReloaded;
+}
+
+QHash<Media*, QList<QPair<qint64, qint64>>>
+SequenceWorkflow::mediaRanges() const
+{
+    QHash<Media*, QList<QPair<qint64, qint64>>>   ranges;
+    for ( auto handle : m_clips.handles() )
+    {
+        const auto& clip = m_clips.clip( handle );
+        auto media = clip->media();
+        if ( clip->speed() != 1. )
+            ranges[media] << qMakePair( 0ll, media->input()->length() - 1 );
+        else
+            ranges[media] << qMakePair( clip->begin(), clip->end() );
+    }
+    return ranges;
+}
+
+void
+SequenceWorkflow::remapMedia( const Media* media, const std::function<qint64( qint64 )>& map )
+{
+    for ( auto handle : m_clips.handles() )
+    {
+        const auto& clip = m_clips.clip( handle );
+        if ( clip->media() == media && clip->speed() == 1. )
+            clip->setBoundaries( map( clip->begin() ), map( clip->end() ) );
+    }
+}
+
+QList<QUuid>
+SequenceWorkflow::growMedia( const Media* media, qint64 oldLength )
+{
+    Edit    edit( this );
+    QList<QUuid>    candidates;
+    for ( auto handle : m_clips.handles() )
+    {
+        const auto& clip = m_clips.clip( handle );
+        // A frozen clip keeps playing its rendition, until it's edited
+        if ( clip->media() == media && clip->end() == oldLength - 1 &&
+             isFrozen( clip->uuid() ) == false )
+            candidates << clip->uuid();
+    }
+    QList<QUuid>    grown;
+    auto end = media->input()->length() - 1;
+    for ( const auto& uuid : candidates )
+    {
+        auto handle = m_clips.handle( uuid );
+        const auto& clip = m_clips.clip( handle );
+        if ( resizeClip( uuid, clip->begin(), end, m_clips.position( handle ) ) == true )
+            grown << uuid;
+    }
+    return grown;
+}
+
+QList<QUuid>
+SequenceWorkflow::rescale( double ratio )
+{
+    Edit    edit( this );
+    auto map = [ratio]( qint64 frame ) { return qRound64( frame * ratio ); };
+    // Growing clips are handled from the last one, so that they only grow over the
+    // blanks left by the following ones, shrinking ones from the first one.
+    QList<QPair<qint64, QUuid>>    clips;
+    for ( auto handle : m_clips.handles() )
+        clips << qMakePair( (qint64)m_clips.position( handle ), m_clips.clip( handle )->uuid() );
+    std::sort( clips.begin(), clips.end() );
+    if ( ratio > 1. )
+        std::reverse( clips.begin(), clips.end() );
+
+    QList<QUuid>    rescaled;
+    for ( const auto& p : clips )
+    {
+        auto handle = m_clips.handle( p.second );
+        const auto& clip = m_clips.clip( handle );
+        auto input = clip->input();
+        // Its retimed media isn't the one of the library
+        if ( clip->speed() != 1. )
+        {
+            auto mltInput = dynamic_cast<Backend::MLT::MLTInput*>( input );
+            if ( mltInput != nullptr )
+                mltInput->setLength( map( input->length() ) );
+        }
+        auto last = input->length() - 1;
+        if ( last < 0 )
+            continue;
+        auto pos = map( p.first );
+        // From the rescaled end, so that adjacent clips stay adjacent
+        auto length = qMax( 1ll, map( p.first + clip->length() ) - pos );
+        auto begin = qMin( map( clip->begin() ), last );
+        auto end = qMin( begin + length - 1, last );
+        rescaleFilters( *input, ratio );
+        m_changedClips.insert( p.second );
+        if ( resizeClip( p.second, begin, end, pos ) == true )
+            rescaled << p.second;
+        else
+            vlmcWarning() << "Couldn't rescale clip" << p.second;
+    }
+    rescaleFilters( *m_multitrack, ratio );
+    for ( quint32 i = 0; i < (quint32)m_multiTracks.size(); ++i )
+    {
+        rescaleFilters( *m_multiTracks[i], ratio );
+        rescaleFilters( *m_tracks[Workflow::AudioTrack][i], ratio );
+        rescaleFilters( *m_tracks[Workflow::VideoTrack][i], ratio );
+        m_changedTrackFilters.insert( i );
+    }
+    m_filtersChanged = true;
+    return rescaled;
+}
+
+void
+SequenceWorkflow::rescaleFilters( Backend::IInput& input, double ratio )
+{
+    for ( int i = 0; i < input.filterCount(); ++i )
+    {
+        auto filter = input.filter( i );
+        // Filters without an end apply to the whole input
+        if ( filter == nullptr || filter->end() <= 0 )
+            continue;
+        filter->setBoundaries( qRound64( filter->begin() * ratio ), qRound64( filter->end() * ratio ) );
+    }
+}
+
+void
+SequenceWorkflow::updateTransitions()
+{
+    QList<AutoTransition>   wanted;
+    std::vector<Backend::MLT::MLTAudioMixer::Fade>  fades;
+    for ( int type = 0; type < Workflow::NbTrackType; ++type )
+    {
+        if ( type == Workflow::VideoTrack && m_transitionStyle == NoTransition )
+            continue;
+        const auto& indexes = m_clipIndex[type];
+        for ( auto a = indexes.cbegin(); a != indexes.cend(); ++a )
+        {
+            if ( m_mutedTracks[type].contains( a.key() ) == true )
+                continue;
+            for ( auto b = indexes.cbegin(); b != indexes.cend(); ++b )
+            {
+                if ( b.key() <= a.key() || m_mutedTracks[type].contains( b.key() ) == true )
+                    continue;
+                for ( const auto& lower : a.value().overlapping( 0, a.value().end() ) )
+                {
+                    for ( const auto& upper : b.value().overlapping( lower.begin, lower.end ) )
+                    {
+                        // A clip covering the other one entirely stays on top
+                        auto fadeIn = upper.begin > lower.begin && upper.end > lower.end;
+                        auto fadeOut = upper.begin < lower.begin && upper.end < lower.end;
+                        if ( fadeIn == false && fadeOut == false )
+                            continue;
+                        // The mixer cross fades the audio itself
+                        if ( type == Workflow::AudioTrack )
+                        {
+                            fades.push_back( { a.key(), b.key(), std::max( lower.begin, upper.begin ),
+                                               std::min( lower.end, upper.end ), fadeOut } );
+                            continue;
+                        }
+                        wanted << AutoTransition{ (Workflow::TrackType)type, a.key(), b.key(),
+                                                  std::max( lower.begin, upper.begin ),
+                                                  std::min( lower.end, upper.end ), fadeOut, nullptr };
+                    }
+                }
+            }
+        }
+    }
+    m_mixer->setFades( fades );
+
+    auto same = []( const AutoTransition& t1, const AutoTransition& t2 ) {
+        return t1.type == t2.type && t1.aTrack == t2.aTrack && t1.bTrack == t2.bTrack &&
+                t1.begin == t2.begin && t1.end == t2.end && t1.fadeOut == t2.fadeOut;
+    };
+    for ( auto it = m_transitions.begin(); it != m_transitions.end(); )
+    {
+        auto kept = std::find_if( wanted.begin(), wanted.end(), [&]( const AutoTransition& t ) {
+            return same( t, *it );
+        } );
+        if ( kept != wanted.end() )
+        {
+            wanted.erase( kept );
+            ++it;
+            continue;
+        }
+        m_tracksTractor->removeTransition( *it->transition );
+        it = m_transitions.erase( it );
+    }
+
+    for ( auto& t : wanted )
+    {
+        try
+        {
+            Backend::MLT::MLTTransition* transition;
+            if ( m_transitionStyle == Wipe )
+            {
+                transition = new Backend::MLT::MLTTransition( Backend::instance()->profile(), "luma" );
+                transition->properties()->set( "resource", "%luma01.pgm" );
+                transition->properties()->set( "reverse", t.fadeOut ? 1 : 0 );
+            }
+            else
+                transition = new Backend::MLT::MLTDissolve( t.fadeOut );
+            t.transition.reset( transition );
+        }
+        catch ( Backend::InvalidServiceException& )
+        {
+            vlmcWarning() << "Can't create the transition between tracks" << t.aTrack << "and" << t.bTrack;
+            continue;
+        }
+        t.transition->setBoundaries( t.begin, t.end - 1 );
+        m_tracksTractor->addTransition( *t.transition, t.aTrack, t.bTrack );
+        m_transitions << t;
+    }
+}
+
+void
+SequenceWorkflow::removeTransitions()
+{
+    for ( const auto& t : m_transitions )
+        m_tracksTractor->removeTransition( *t.transition );
+    m_transitions.clear();
+}
+
+void
+SequenceWorkflow::compactTracks()
+{
+    // Clips reference their track by index, only the unused tracks on top can go.
+    // A muted track is kept as well, for it to still be muted once it gets clips again
+    QSet<quint32>   used;
+    for ( auto handle : m_clips.handles() )
+        used.insert( m_clips.trackId( handle ) );
+    while ( m_multiTracks.isEmpty() == false )
+    {
+        auto i = m_multiTracks.size() - 1;
+        if ( used.contains( i ) == true || m_multiTracks[i]->filterCount() > 0 ||
+             m_tracks[Workflow::AudioTrack][i]->filterCount() > 0 ||
+             m_tracks[Workflow::VideoTrack][i]->filterCount() > 0 ||
+             m_mutedTracks[Workflow::AudioTrack].contains( i ) == true ||
+             m_mutedTracks[Workflow::VideoTrack].contains( i ) == true )
+            break;
+        m_tracksTractor->removeTrack( i );
+        m_multiTracks.removeLast();
+        m_placeholders.removeLast();
+        m_active.removeLast();
+        m_tracks[Workflow::AudioTrack].removeLast();
+        m_tracks[Workflow::VideoTrack].removeLast();
+    }
+}
+
+SequenceWorkflow::~SequenceWorkflow()
+{
+    // Clearing goes through the tractor
+    clear();
+    removeTransitions();
+    m_mixer.reset();
+    delete m_multitrack;
+    delete m_tracksTractor;
+}
+
+bool
+SequenceWorkflow::addClip( std::shared_ptr<Clip> const& clip, quint32 trackId, qint32 pos )
+{
+    static auto& timing = Tools::Metrics::histogram( "edit.addClip" );
+    Tools::Metrics::ScopedTimer timer( timing );
+    Edit    edit( this );
+    auto ret = trackFromFormats( trackId, clip->formats() )->insertAt( *clip->input(), pos );
+    if ( ret == false )
+        return false;
+    m_clips.insert( clip, trackId, pos );
+    indexClip( clip->uuid() );
+    markDirty( pos, pos + clip->length(), trackId );
+    return true;
+}
+
+std::shared_ptr<Clip>
+SequenceWorkflow::createClip( const QUuid& libraryUuid, bool isAudioClip )
+{
+    Clip* clip = Core::instance()->library()->clip( libraryUuid );
+    if ( clip == nullptr )
+    {
+        vlmcCritical() << "Couldn't find an acceptable parent to be added.";
+        return nullptr;
+    }
+
+    auto newClip = std::make_shared<Clip>( clip );
+
+    if ( isAudioClip == true )
+        newClip->setFormats( Clip::Audio );
+    else
+        newClip->setFormats( Clip::Video );
+    return newClip;
+}
+
+QString
+SequenceWorkflow::addClip( const QUuid& uuid, quint32 trackId, qint32 pos, bool isAudioClip )
+{
+    Edit    edit( this );
+    auto newClip = createClip( uuid, isAudioClip );
+    if ( !newClip )
+        return QUuid().toString();
+
+    bool ret = trackFromFormats( trackId, newClip->formats() )->insertAt( *newClip->input(), pos );
+    if ( ret == false )
+        return QUuid().toString();
+    m_clips.insert( newClip, trackId, pos );
+    indexClip( newClip->uuid() );
+    markDirty( pos, pos + newClip->length(), trackId );
+    return newClip->uuid().toString();
+}
+
+bool
+SequenceWorkflow::moveClip( const QUuid& uuid, quint32 trackId, qint64 pos )
+{
+    static auto& timing = Tools::Metrics::histogram( "edit.moveClip" );
+    Tools::Metrics::ScopedTimer timer( timing );
+    Edit    edit( this );
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
+    {
+        vlmcCritical() << "Couldn't find a clip " << uuid;
+        return false;
+    }
+    auto clip = m_clips.clip( handle );
+    auto oldTrackId = m_clips.trackId( handle );
+    auto oldPosition = m_clips.position( handle );
+    if ( oldPosition == pos )
+        return true;
+    auto track = trackFromFormats( oldTrackId, clip->formats() );
+    if ( trackId != oldTrackId )
+    {
+        // Both mark their range dirty. it is invalidated by removeClip()
+        removeClip( uuid );
+        return addClip( clip, trackId, pos );
+    }
+    // Only resizes the blanks around the clip, when it stays between its neighbours
+    bool ret = track->reposition( oldPosition, pos );
+    m_clips.setPosition( handle, pos );
+    indexClip( uuid );
+    markDirty( oldPosition, oldPosition + clip->length(), oldTrackId );
+    markDirty( pos, pos + clip->length(), trackId );
+    return ret;
+}
+
+bool
+SequenceWorkflow::resizeClip( const QUuid& uuid, qint64 newBegin, qint64 newEnd, qint64 newPos )
+{
+    static auto& timing = Tools::Metrics::histogram( "edit.resizeClip" );
+    Tools::Metrics::ScopedTimer timer( timing );
+    Edit    edit( this );
+    thawClip( uuid );
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
+    {
+        vlmcCritical() << "Couldn't find a clip " << uuid;
+        return false;
+    }
+    auto clip = m_clips.clip( handle );
+    auto trackId = m_clips.trackId( handle );
+    auto position = m_clips.position( handle );
+    auto track = trackFromFormats( trackId, clip->formats() );
+    auto oldEnd = position + clip->length();
+    // The track grows the clip over the following blank: when it grows from its
+    // beginning, move it first so that the blank is there.
+    if ( newPos < position && moveClip( uuid, trackId, newPos ) == false )
+        return false;
+    auto ret = track->resizeClip( track->clipIndexAt( qMin( position, newPos ) ), newBegin, newEnd );
+    if ( ret == false )
+        return false;
+    indexClip( uuid );
+    // moveClip() doesn't mark anything when the position doesn't change
+    markDirty( position, oldEnd, trackId );
+    markDirty( newPos, newPos + clip->length(), trackId );
+    if ( newPos > position )
+        ret = moveClip( uuid, trackId, newPos );
+    return ret;
+}
+
+bool
+SequenceWorkflow::retimeClip( const QUuid& uuid, double speed, bool frameBlending,
+                              qint64 begin, qint64 end )
+{
+    Edit    edit( this );
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
+    {
+        vlmcCritical() << "Couldn't find a clip " << uuid;
+        return false;
+    }
+    auto clip = m_clips.clip( handle );
+    auto trackId = m_clips.trackId( handle );
+    auto pos = m_clips.position( handle );
+    auto index = clipIndex( trackType( *clip ), trackId );
+    if ( index != nullptr &&
+         index->overlapping( pos, pos + end - begin + 1, uuid ).isEmpty() == false )
+        return false;
+    thawClip( uuid );
+    auto oldLength = clip->length();
+    auto track = trackFromFormats( trackId, clip->formats() );
+    if ( clip->setRetiming( speed, frameBlending, begin, end ) == false )
+        return false;
+    track->remove( track->clipIndexAt( pos ) );
+    if ( track->insertAt( *clip->input(), pos ) == false )
+    {
+        vlmcCritical() << "Couldn't insert clip" << uuid << "back";
+        return false;
+    }
+    indexClip( uuid );
+    markDirty( pos, pos + qMax( oldLength, clip->length() ), trackId );
+    return true;
+}
+
+bool
+SequenceWorkflow::editClips( const QList<ClipEdit>& edits )
+{
+    // Lay the batch out on copies of the indexes of the tracks it touches
+    QHash<QPair<int, quint32>, ClipIndex>   layout;
+    QList<std::shared_ptr<Clip>>            clips;
+    for ( const auto& e : edits )
+    {
+        auto handle = m_clips.handle( e.uuid );
+        if ( handle == ClipRegistry::InvalidHandle )
+        {
+            vlmcCritical() << "Couldn't find a clip " << e.uuid;
+            return false;
+        }
+        auto clip = m_clips.clip( handle );
+        auto type = trackType( *clip );
+        auto from = qMakePair( (int)type, m_clips.trackId( handle ) );
+        auto to = qMakePair( (int)type, e.trackId );
+        if ( layout.contains( from ) == false )
+            layout.insert( from, m_clipIndex[type].value( from.second ) );
+        if ( layout.contains( to ) == false )
+            layout.insert( to, m_clipIndex[type].value( to.second ) );
+        layout[from].remove( e.uuid );
+        clips << clip;
+    }
+    for ( int i = 0; i < edits.count(); ++i )
+    {
+        const auto& e = edits[i];
+        const auto& clip = clips[i];
+        auto begin = e.begin < 0 ? clip->begin() : e.begin;
+        auto end = e.end < 0 ? clip->end() : e.end;
+        auto& index = layout[qMakePair( (int)trackType( *clip ), e.trackId )];
+        if ( index.overlapping( e.pos, e.pos + end - begin + 1 ).isEmpty() == false )
+            return false;
+        index.insert( e.uuid, e.pos, e.pos + end - begin + 1 );
+    }
+
+    Edit    edit( this );
+    // Take every clip out first, so none of them is in the way of another one
+    for ( const auto& e : edits )
+        removeClip( e.uuid );
+    auto ret = true;
+    for ( int i = 0; i < edits.count(); ++i )
+    {
+        const auto& e = edits[i];
+        const auto& clip = clips[i];
+        if ( e.begin >= 0 || e.end >= 0 )
+            clip->setBoundaries( e.begin < 0 ? clip->begin() : e.begin,
+                                 e.end < 0 ? clip->end() : e.end );
+        if ( addClip( clip, e.trackId, e.pos ) == false )
+        {
+            vlmcCritical() << "Couldn't insert clip " << e.uuid << " back";
+            ret = false;
+        }
+    }
+    return ret;
+}
+
+std::shared_ptr<Clip>
+SequenceWorkflow::rippleRemoveClip( const QUuid& uuid )
+{
+    Edit    edit( this );
+    thawClip( uuid );
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
+    {
+        vlmcCritical() << "Couldn't find a clip " << uuid;
+        return nullptr;
     }
+    auto clip = m_clips.clip( handle );
+    auto trackId = m_clips.trackId( handle );
+    auto position = m_clips.position( handle );
+    if ( trackFromFormats( trackId, clip->formats() )->rippleRemove( position ) == false )
+        return nullptr;
+    mutableIndex( trackType( *clip ), trackId ).remove( uuid );
+    m_clips.remove( handle );
+    m_changedClips.insert( uuid );
+    clip->disconnect( this );
+    shiftClips( trackType( *clip ), trackId, position, -clip->length() );
+    markDirty( position, -1, trackId );
+    return clip;
 }
 
-SequenceWorkflow::~SequenceWorkflow()
+bool
+SequenceWorkflow::rippleInsertClip( std::shared_ptr<Clip> const& clip, quint32 trackId, qint64 pos )
 {
-    delete m_multitrack;
-    clear();
+    Edit    edit( this );
+    if ( trackFromFormats( trackId, clip->formats() )->rippleInsert( *clip->input(), pos ) == false )
+        return false;
+    shiftClips( trackType( *clip ), trackId, pos, clip->length() );
+    m_clips.insert( clip, trackId, pos );
+    indexClip( clip->uuid() );
+    markDirty( pos, -1, trackId );
+    return true;
 }
 
 bool
-SequenceWorkflow::addClip( std::shared_ptr<Clip> const& clip, quint32 trackId, qint32 pos )
+SequenceWorkflow::rollClip( const QUuid& uuid, qint64 delta )
 {
-    auto ret = trackFromFormats( trackId, clip->formats() )->insertAt( *clip->input(), pos );
-    if ( ret == false )
+    Edit    edit( this );
+    thawClip( uuid );
+    thawClip( nextClip( uuid ) );
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
+    {
+        vlmcCritical() << "Couldn't find a clip " << uuid;
+        return false;
+    }
+    auto clip = m_clips.clip( handle );
+    auto trackId = m_clips.trackId( handle );
+    auto cut = m_clips.position( handle ) + clip->length();
+    auto next = nextClip( uuid );
+    if ( trackFromFormats( trackId, clip->formats() )->roll( cut, delta ) == false )
         return false;
-    m_clips.insert( clip->uuid(), std::make_tuple( clip, trackId, pos ) );
+    if ( next.isNull() == false )
+    {
+        auto nextHandle = m_clips.handle( next );
+        m_clips.setPosition( nextHandle, m_clips.position( nextHandle ) + delta );
+    }
+    reindexClips( { uuid, next } );
+    markDirty( qMin( cut, cut + delta ), qMax( cut, cut + delta ), trackId );
     return true;
 }
 
-QString
-SequenceWorkflow::addClip( const QUuid& uuid, quint32 trackId, qint32 pos, bool isAudioClip )
+bool
+SequenceWorkflow::slipClip( const QUuid& uuid, qint64 delta )
 {
-    Clip* clip = Core::instance()->library()->clip( uuid );
-    if ( clip == nullptr )
+    Edit    edit( this );
+    thawClip( uuid );
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
     {
-        vlmcCritical() << "Couldn't find an acceptable parent to be added.";
-        return QUuid().toString();
+        vlmcCritical() << "Couldn't find a clip " << uuid;
+        return false;
     }
-
-    auto newClip = std::make_shared<Clip>( clip );
-
-    if ( isAudioClip == true )
-        newClip->setFormats( Clip::Audio );
-    else
-        newClip->setFormats( Clip::Video );
-
-    bool ret = trackFromFormats( trackId, newClip->formats() )->insertAt( *newClip->input(), pos );
-    if ( ret == false )
-        return QUuid().toString();
-    m_clips.insert( newClip->uuid(), std::make_tuple( newClip, trackId, pos ) );
-    return newClip->uuid().toString();
+    auto clip = m_clips.clip( handle );
+    auto trackId = m_clips.trackId( handle );
+    auto position = m_clips.position( handle );
+    if ( trackFromFormats( trackId, clip->formats() )->slip( position, delta ) == false )
+        return false;
+    m_changedClips.insert( uuid );
+    markDirty( position, position + clip->length(), trackId );
+    return true;
 }
 
 bool
-SequenceWorkflow::moveClip( const QUuid& uuid, quint32 trackId, qint64 pos )
+SequenceWorkflow::splitClip( const QUuid& uuid, const QList<std::shared_ptr<Clip>>& pieces )
 {
-    auto it = m_clips.find( uuid );
-    if ( it == m_clips.end() )
+    static auto& timing = Tools::Metrics::histogram( "edit.splitClip" );
+    Tools::Metrics::ScopedTimer timer( timing );
+    Edit    edit( this );
+    thawClip( uuid );
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
     {
         vlmcCritical() << "Couldn't find a clip " << uuid;
         return false;
     }
-    auto clip = std::get<ClipTupleIndex::Clip>( it.value() );
-    auto oldTrackId = std::get<ClipTupleIndex::TrackId>( it.value() );
-    auto oldPosition = std::get<ClipTupleIndex::Position>( it.value() );
-    if ( oldPosition == pos )
+    if ( pieces.isEmpty() == true )
         return true;
-    auto track = trackFromFormats( oldTrackId, clip->formats() );
-    bool ret = true;
-    if ( trackId != oldTrackId )
+    auto clip = m_clips.clip( handle );
+    auto trackId = m_clips.trackId( handle );
+    auto position = m_clips.position( handle );
+    auto oldEnd = clip->end();
+    std::vector<Backend::IInput*>   inputs{ clip->input() };
+    for ( const auto& p : pieces )
+        inputs.push_back( p->input() );
+    clip->setEnd( pieces.first()->begin() - 1 );
+    if ( trackFromFormats( trackId, clip->formats() )->replace( position, 1, inputs ) == false )
     {
-        removeClip( uuid );
-        ret = addClip( clip, trackId, pos );
+        clip->setEnd( oldEnd );
+        return false;
     }
-    else
+    indexClip( uuid );
+    for ( const auto& p : pieces )
     {
-        ret = track->move( std::get<ClipTupleIndex::Position>( it.value() ), pos );
+        m_clips.insert( p, trackId, position + p->begin() - clip->begin() );
+        indexClip( p->uuid() );
     }
-    m_clips.erase( it );
-    m_clips.insert( uuid, std::make_tuple( clip, trackId, pos ) );
-    // TODO: If we detect collision too strictly, there will be a problem if we want to move multiple
-    //       clips at the same time.
-    return ret;
+    markDirty( position, position + clip->length() + oldEnd - clip->end(), trackId );
+    return true;
+}
+
+QList<std::shared_ptr<Clip>>
+SequenceWorkflow::joinClip( const QUuid& uuid, const QList<QUuid>& pieces )
+{
+    Edit    edit( this );
+    thawClip( uuid );
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
+    {
+        vlmcCritical() << "Couldn't find a clip " << uuid;
+        return {};
+    }
+    auto clip = m_clips.clip( handle );
+    auto trackId = m_clips.trackId( handle );
+    auto position = m_clips.position( handle );
+    QList<std::shared_ptr<Clip>>    removed;
+    QList<ClipRegistry::Handle>     handles;
+    for ( const auto& p : pieces )
+    {
+        thawClip( p );
+        auto h = m_clips.handle( p );
+        if ( h == ClipRegistry::InvalidHandle )
+        {
+            vlmcCritical() << "Couldn't find a clip " << p;
+            return {};
+        }
+        removed << m_clips.clip( h );
+        handles << h;
+    }
+    if ( removed.isEmpty() == true )
+        return removed;
+    auto oldEnd = clip->end();
+    clip->setEnd( removed.last()->end() );
+    if ( trackFromFormats( trackId, clip->formats() )->replace( position, pieces.count() + 1,
+                                                                  { clip->input() } ) == false )
+    {
+        clip->setEnd( oldEnd );
+        return {};
+    }
+    for ( int i = 0; i < removed.count(); ++i )
+    {
+        mutableIndex( trackType( *removed[i] ), trackId ).remove( pieces[i] );
+        m_clips.remove( handles[i] );
+        m_changedClips.insert( pieces[i] );
+        removed[i]->disconnect( this );
+    }
+    indexClip( uuid );
+    markDirty( position, position + clip->length(), trackId );
+    return removed;
 }
 
 bool
-SequenceWorkflow::resizeClip( const QUuid& uuid, qint64 newBegin, qint64 newEnd, qint64 newPos )
+SequenceWorkflow::slideClip( const QUuid& uuid, qint64 delta )
 {
-    auto it = m_clips.find( uuid );
-    if ( it == m_clips.end() )
+    Edit    edit( this );
+    thawClip( previousClip( uuid ) );
+    thawClip( uuid );
+    thawClip( nextClip( uuid ) );
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
     {
         vlmcCritical() << "Couldn't find a clip " << uuid;
         return false;
     }
-    auto clip = std::get<ClipTupleIndex::Clip>( it.value() );
-    auto trackId = std::get<ClipTupleIndex::TrackId>( it.value() );
-    auto position = std::get<ClipTupleIndex::Position>( it.value() );
-    auto track = trackFromFormats( trackId, clip->formats() );
-    auto ret = track->resizeClip( track->clipIndexAt( position ), newBegin, newEnd );
-    if ( ret == false )
+    auto clip = m_clips.clip( handle );
+    auto trackId = m_clips.trackId( handle );
+    auto position = m_clips.position( handle );
+    auto previous = previousClip( uuid );
+    auto next = nextClip( uuid );
+    if ( trackFromFormats( trackId, clip->formats() )->slide( position, delta ) == false )
         return false;
-    ret = moveClip( uuid, trackId, newPos );
-    return ret;
+    m_clips.setPosition( handle, m_clips.position( handle ) + delta );
+    if ( next.isNull() == false )
+    {
+        auto nextHandle = m_clips.handle( next );
+        m_clips.setPosition( nextHandle, m_clips.position( nextHandle ) + delta );
+    }
+    reindexClips( { previous, uuid, next } );
+    markDirty( qMin( position, position + delta ),
+               qMax( position, position + delta ) + clip->length(), trackId );
+    return true;
+}
+
+QUuid
+SequenceWorkflow::previousClip( const QUuid& uuid ) const
+{
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
+        return QUuid();
+    const auto& clip = m_clips.clip( handle );
+    auto position = m_clips.position( handle );
+    auto index = clipIndex( trackType( *clip ), m_clips.trackId( handle ) );
+    if ( index == nullptr || position == 0 )
+        return QUuid();
+    auto entry = index->at( position - 1 );
+    return entry.end == position ? entry.uuid : QUuid();
+}
+
+QUuid
+SequenceWorkflow::nextClip( const QUuid& uuid ) const
+{
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
+        return QUuid();
+    const auto& clip = m_clips.clip( handle );
+    auto end = m_clips.position( handle ) + clip->length();
+    auto index = clipIndex( trackType( *clip ), m_clips.trackId( handle ) );
+    if ( index == nullptr )
+        return QUuid();
+    auto entry = index->at( end );
+    return entry.begin == end ? entry.uuid : QUuid();
 }
 
 std::shared_ptr<Clip>
 SequenceWorkflow::removeClip( const QUuid& uuid )
 {
-    auto it = m_clips.find( uuid );
-    if ( it == m_clips.end() )
+    static auto& timing = Tools::Metrics::histogram( "edit.removeClip" );
+    Tools::Metrics::ScopedTimer timer( timing );
+    Edit    edit( this );
+    thawClip( uuid );
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
     {
         vlmcCritical() << "Couldn't find a clip " << uuid;
         return std::shared_ptr<Clip>( nullptr );
     }
-    auto clip = std::get<ClipTupleIndex::Clip>( it.value() );
-    auto trackId = std::get<ClipTupleIndex::TrackId>( it.value() );
-    auto position = std::get<ClipTupleIndex::Position>( it.value() );
+    auto clip = m_clips.clip( handle );
+    auto trackId = m_clips.trackId( handle );
+    auto position = m_clips.position( handle );
     auto track = trackFromFormats( trackId, clip->formats() );
     track->remove( track->clipIndexAt( position ) );
-    m_clips.erase( it );
+    mutableIndex( trackType( *clip ), trackId ).remove( uuid );
+    m_clips.remove( handle );
+    m_changedClips.insert( uuid );
     clip->disconnect( this );
+    markDirty( position, position + clip->length(), trackId );
     return clip;
 
 }
 
+QList<SequenceWorkflow::ClipTuple>
+SequenceWorkflow::removeClips( const QList<QUuid>& uuids )
+{
+    Edit    edit( this );
+    QList<ClipTuple>    res;
+    for ( const auto& uuid : uuids )
+    {
+        auto handle = m_clips.handle( uuid );
+        if ( handle == ClipRegistry::InvalidHandle )
+            continue;
+        auto t = std::make_tuple( m_clips.clip( handle ), m_clips.trackId( handle ),
+                                  m_clips.position( handle ) );
+        if ( removeClip( uuid ) )
+            res << t;
+    }
+    return res;
+}
+
+bool
+SequenceWorkflow::addClips( const QList<ClipTuple>& clips )
+{
+    static auto& timing = Tools::Metrics::histogram( "edit.addClips" );
+    Tools::Metrics::ScopedTimer timer( timing );
+    Edit    edit( this );
+    // The clips going to the same track are inserted in a single pass over it
+    QMap<QPair<int, quint32>, QList<ClipTuple>> tracks;
+    for ( const auto& t : clips )
+    {
+        const auto& clip = std::get<ClipTupleIndex::Clip>( t );
+        tracks[qMakePair( (int)trackType( *clip ), std::get<ClipTupleIndex::TrackId>( t ) )] << t;
+    }
+    auto ret = true;
+    for ( auto& trackClips : tracks )
+    {
+        if ( trackClips.count() > 1 && insertClips( trackClips ) == true )
+            continue;
+        // They don't all fit in the same blank
+        for ( const auto& t : trackClips )
+        {
+            if ( addClip( std::get<ClipTupleIndex::Clip>( t ), std::get<ClipTupleIndex::TrackId>( t ),
+                          std::get<ClipTupleIndex::Position>( t ) ) == false )
+                ret = false;
+        }
+    }
+    return ret;
+}
+
+bool
+SequenceWorkflow::insertClips( QList<ClipTuple>& clips )
+{
+    std::sort( clips.begin(), clips.end(), []( const ClipTuple& a, const ClipTuple& b ) {
+        return std::get<ClipTupleIndex::Position>( a ) < std::get<ClipTupleIndex::Position>( b );
+    } );
+    std::vector<Backend::IInput*>   inputs;
+    std::vector<int64_t>            positions;
+    for ( const auto& t : clips )
+    {
+        inputs.push_back( std::get<ClipTupleIndex::Clip>( t )->input() );
+        positions.push_back( std::get<ClipTupleIndex::Position>( t ) );
+    }
+    const auto& last = std::get<ClipTupleIndex::Clip>( clips.last() );
+    auto trackId = std::get<ClipTupleIndex::TrackId>( clips.first() );
+    if ( trackFromFormats( trackId, last->formats() )->insertMany( inputs, positions ) == false )
+        return false;
+    for ( const auto& t : clips )
+    {
+        const auto& clip = std::get<ClipTupleIndex::Clip>( t );
+        m_clips.insert( clip, trackId, std::get<ClipTupleIndex::Position>( t ) );
+        indexClip( clip->uuid() );
+    }
+    markDirty( positions.front(), positions.back() + last->length(), trackId );
+    return true;
+}
+
+void
+SequenceWorkflow::groupClips( const QList<QUuid>& uuids )
+{
+    for ( const auto& uuid : uuids )
+        ungroupClips( uuid );
+    if ( uuids.count() < 2 )
+        return;
+    m_groupsChanged = true;
+    auto id = ++m_nextGroupId;
+    auto& members = m_groups[id];
+    for ( const auto& uuid : uuids )
+    {
+        members.insert( uuid );
+        m_clipGroups.insert( uuid, id );
+    }
+}
+
+void
+SequenceWorkflow::ungroupClips( const QUuid& uuid )
+{
+    auto it = m_clipGroups.find( uuid );
+    if ( it == m_clipGroups.end() )
+        return;
+    m_groupsChanged = true;
+    for ( const auto& member : m_groups.take( it.value() ) )
+        m_clipGroups.remove( member );
+}
+
+QList<QUuid>
+SequenceWorkflow::group( const QUuid& uuid ) const
+{
+    QList<QUuid>    res;
+    auto it = m_clipGroups.find( uuid );
+    if ( it == m_clipGroups.end() )
+        return res;
+    for ( const auto& member : m_groups.value( it.value() ) )
+    {
+        // Removed clips keep their place in the group, in case they come back
+        if ( m_clips.contains( member ) == true )
+            res << member;
+    }
+    return res;
+}
+
 bool
 SequenceWorkflow::linkClips( const QUuid& uuidA, const QUuid& uuidB )
 {
@@ -183,6 +1461,7 @@ SequenceWorkflow::linkClips( const QUuid& uuidA, const QUuid& uuidB )
     clipB->setLinkedClipUuid( clipA->uuid() );
     clipA->setLinked( true );
     clipB->setLinked( true );
+    m_changedClips << uuidA << uuidB;
     return true;
 }
 
@@ -198,96 +1477,462 @@ SequenceWorkflow::unlinkClips( const QUuid& uuidA, const QUuid& uuidB )
     }
     clipA->setLinked( false );
     clipB->setLinked( false );
+    m_changedClips << uuidA << uuidB;
     return true;
 }
 
+QList<PassthroughRange>
+SequenceWorkflow::passthroughRanges() const
+{
+    QList<PassthroughRange> ranges;
+    if ( m_multitrack->filterCount() > 0 )
+        return ranges;
+
+    // The clips playing don't change in between two clip boundaries
+    QVector<qint64> bounds;
+    for ( auto handle : m_clips.handles() )
+    {
+        auto pos = m_clips.position( handle );
+        bounds << pos << pos + m_clips.clip( handle )->length();
+    }
+    std::sort( bounds.begin(), bounds.end() );
+    bounds.erase( std::unique( bounds.begin(), bounds.end() ), bounds.end() );
+
+    for ( int i = 0; i + 1 < bounds.size(); ++i )
+    {
+        auto begin = bounds[i];
+        auto end = bounds[i + 1];
+        auto video = ClipRegistry::InvalidHandle;
+        auto audio = ClipRegistry::InvalidHandle;
+        auto valid = true;
+        for ( int type = 0; type < Workflow::NbTrackType && valid == true; ++type )
+        {
+            const auto& indexes = m_clipIndex[type];
+            for ( auto idx = indexes.cbegin(); idx != indexes.cend(); ++idx )
+            {
+                auto entry = idx.value().at( begin );
+                auto handle = m_clips.handle( entry.uuid );
+                if ( entry.uuid.isNull() == true || handle == ClipRegistry::InvalidHandle )
+                    continue;
+                const auto& clip = m_clips.clip( handle );
+                auto trackId = idx.key();
+                auto& slot = type == Workflow::AudioTrack ? audio : video;
+                const auto& track = m_tracks[type][trackId];
+                // A retimed clip plays a timewarped input, which has no filter to tell, and
+                // its boundaries are frames of that input: the source can't be copied.
+                if ( slot != ClipRegistry::InvalidHandle || clip->input()->filterCount() > 0 ||
+                     clip->speed() != 1. || clip->frameBlending() == true ||
+                     m_multiTracks[trackId]->filterCount() > 0 || track->filterCount() > 0 )
+                {
+                    valid = false;
+                    break;
+                }
+                slot = handle;
+            }
+        }
+        // The media's audio gets copied along with its video
+        if ( valid == false || video == ClipRegistry::InvalidHandle ||
+             audio == ClipRegistry::InvalidHandle )
+            continue;
+        const auto& videoClip = m_clips.clip( video );
+        const auto& audioClip = m_clips.clip( audio );
+        auto videoOffset = videoClip->begin() - m_clips.position( video );
+        if ( videoClip->media() != audioClip->media() ||
+             audioClip->begin() - m_clips.position( audio ) != videoOffset )
+            continue;
+
+        auto filePath = videoClip->media()->fileInfo()->absoluteFilePath();
+        if ( ranges.isEmpty() == false && ranges.last().end == begin &&
+             ranges.last().filePath == filePath &&
+             ranges.last().sourceBegin + ( begin - ranges.last().begin ) == videoOffset + begin )
+            ranges.last().end = end;
+        else
+            ranges.append( PassthroughRange{ begin, end, filePath, videoOffset + begin } );
+    }
+    return ranges;
+}
+
+void
+SequenceWorkflow::filterChanged( const Backend::IInput* target, qint64 begin, qint64 end )
+{
+    Edit    edit( this );
+    if ( target == m_multitrack )
+    {
+        m_filtersChanged = true;
+        markDirty( begin, end, -1 );
+        return;
+    }
+    for ( quint32 i = 0; i < (quint32)m_multiTracks.size(); ++i )
+    {
+        if ( target == m_multiTracks[i].get() || target == m_tracks[Workflow::AudioTrack][i].get() ||
+             target == m_tracks[Workflow::VideoTrack][i].get() )
+        {
+            if ( target == m_multiTracks[i].get() )
+                m_changedTrackFilters.insert( i );
+            markDirty( begin, end, i );
+            return;
+        }
+    }
+    for ( auto handle : m_clips.handles() )
+    {
+        const auto& clip = m_clips.clip( handle );
+        if ( clip->input() != target )
+            continue;
+        thawClip( clip->uuid() );
+        m_changedClips.insert( clip->uuid() );
+        auto pos = m_clips.position( handle );
+        auto clipEnd = pos + clip->length();
+        markDirty( qMin( pos + qMax( 0ll, begin ), clipEnd ),
+                   end < 0 ? clipEnd : qMin( pos + end, clipEnd ),
+                   m_clips.trackId( handle ) );
+        return;
+    }
+}
+
+SequenceWorkflow::Edit::Edit( SequenceWorkflow* sequence )
+    : m_sequence( sequence )
+{
+    ++m_sequence->m_editDepth;
+}
+
+SequenceWorkflow::Edit::~Edit()
+{
+    if ( --m_sequence->m_editDepth == 0 )
+        m_sequence->flushDirty();
+}
+
+void
+SequenceWorkflow::markDirty( qint64 begin, qint64 end, qint32 trackId )
+{
+    m_dirty.add( begin, end );
+    if ( trackId >= 0 )
+        m_dirtyTracks[trackId].add( begin, end );
+}
+
+void
+SequenceWorkflow::flushDirty()
+{
+    // Swapped out first, as the receivers may edit the sequence in turn
+    auto dirty = m_dirty;
+    auto dirtyTracks = m_dirtyTracks;
+    m_dirty.clear();
+    m_dirtyTracks.clear();
+    publishIndexes();
+    if ( dirtyTracks.isEmpty() == false )
+    {
+        updateTransitions();
+        // A track can hide the ones below it
+        for ( quint32 i = 0; i < (quint32)m_multiTracks.size(); ++i )
+            updateTrackActivity( i );
+    }
+    for ( auto it = dirtyTracks.cbegin(); it != dirtyTracks.cend(); ++it )
+    {
+        for ( const auto& r : it.value().ranges() )
+            emit trackChanged( it.key(), r.first, r.second );
+    }
+    for ( const auto& r : dirty.ranges() )
+        emit changed( r.first, r.second );
+}
+
+QVariant
+SequenceWorkflow::clipToVariant( ClipRegistry::Handle handle ) const
+{
+    auto    h = m_clips.clip( handle )->toVariant().toHash();
+    h.insert( "position", m_clips.position( handle ) );
+    h.insert( "trackId", m_clips.trackId( handle ) );
+    return h;
+}
+
+QVariantList
+SequenceWorkflow::groupsToVariant() const
+{
+    QVariantList groups;
+    for ( const auto& members : m_groups )
+    {
+        QStringList g;
+        for ( const auto& uuid : members )
+        {
+            if ( m_clips.contains( uuid ) == true )
+                g << uuid.toString();
+        }
+        if ( g.count() > 1 )
+            groups << g;
+    }
+    return groups;
+}
+
 QVariant
 SequenceWorkflow::toVariant() const
 {
+    static auto& timing = Tools::Metrics::histogram( "project.saveSequence" );
+    Tools::Metrics::ScopedTimer timer( timing );
     QVariantList l;
-    for ( auto it = m_clips.begin(); it != m_clips.end(); ++it )
+    for ( auto handle : m_clips.handles() )
+        l << clipToVariant( handle );
+    QVariantHash h{ { "clips", l }, { "groups", groupsToVariant() },
+                    { "filters", EffectHelper::toVariant( m_multitrack ) },
+                    { "trackFilters", trackFiltersToVariant() } };
+    return h;
+}
+
+QVariantList
+SequenceWorkflow::trackFiltersToVariant( const QSet<quint32>& trackIds ) const
+{
+    QVariantList    tracks;
+    for ( quint32 i = 0; i < (quint32)m_multiTracks.size(); ++i )
     {
-        auto clip = std::get<ClipTupleIndex::Clip>( it.value() );
-        auto trackId = std::get<ClipTupleIndex::TrackId>( it.value() );
-        auto position = std::get<ClipTupleIndex::Position>( it.value() );
-        auto    h = clip->toVariant().toHash();
-        h.insert( "position", position );
-        h.insert( "trackId", trackId );
-        l << h;
+        if ( trackIds.isEmpty() == true ? m_multiTracks[i]->filterCount() == 0
+                                        : trackIds.contains( i ) == false )
+            continue;
+        tracks << QVariantHash{ { "trackId", i },
+                                { "filters", EffectHelper::toVariant( m_multiTracks[i].get() ) } };
     }
-    QVariantHash h{ { "clips", l }, { "filters", EffectHelper::toVariant( m_multitrack ) } };
-    return h;
+    return tracks;
 }
 
 void
-SequenceWorkflow::loadFromVariant( const QVariant& variant )
+SequenceWorkflow::loadTrackFilters( const QVariantList& tracks )
 {
-    for ( auto& var : variant.toMap()["clips"].toList() )
+    for ( const auto& var : tracks )
     {
         auto m = var.toMap();
-        auto parentClip = Core::instance()->library()->clip( m["parent"].toString() );
-
-        if ( parentClip == nullptr )
-        {
-            vlmcCritical() << "Couldn't find an acceptable parent to be added.";
+        auto trackId = m["trackId"].toUInt();
+        if ( trackId >= (quint32)m_trackCount )
             continue;
-        }
+        auto input = trackInput( trackId );
+        while ( input->filterCount() > 0 )
+            input->detach( 0 );
+        EffectHelper::loadFromVariant( m["filters"], input );
+        markDirty( 0, -1, trackId );
+    }
+}
 
-        auto c = std::make_shared<Clip>( parentClip, m["begin"].toLongLong(), m["end"].toLongLong() );
-        c->setUuid( m["uuid"].toString() );
-        c->setFormats( (Clip::Formats)m["formats"].toInt() );
+std::shared_ptr<Clip>
+SequenceWorkflow::clipFromVariant( const QVariantMap& m )
+{
+    auto parentClip = Core::instance()->library()->clip( m["parent"].toString() );
+
+    if ( parentClip == nullptr )
+    {
+        vlmcCritical() << "Couldn't find an acceptable parent to be added.";
+        return nullptr;
+    }
+
+    auto c = std::make_shared<Clip>( parentClip, m["begin"].toLongLong(), m["end"].toLongLong() );
+    c->setUuid( m["uuid"].toString() );
+    c->setFormats( (Clip::Formats)m["formats"].toInt() );
+    // The boundaries of a retimed clip are frames of its retimed media
+    auto speed = m.value( "speed", 1. ).toDouble();
+    if ( speed != 1. && c->setRetiming( speed, m["frameBlending"].toBool(),
+                                        m["begin"].toLongLong(), m["end"].toLongLong() ) == false )
+    {
+        vlmcCritical() << "Couldn't play clip" << c->uuid() << "at speed" << speed;
+        return nullptr;
+    }
+
+    auto isLinked = m["linked"].toBool();
+    c->setLinked( isLinked );
+    if ( isLinked == true )
+        c->setLinkedClipUuid( m["linkedClip"].toString() );
 
-        addClip( c, m["trackId"].toUInt(), m["position"].toLongLong() );
+    EffectHelper::loadFromVariant( m["filters"], c->input() );
+    return c;
+}
+
+bool
+SequenceWorkflow::loadClip( const QVariantMap& m )
+{
+    auto c = clipFromVariant( m );
+    if ( c == nullptr )
+        return false;
+    return addClip( c, m["trackId"].toUInt(), m["position"].toLongLong() );
+}
 
-        auto isLinked = m["linked"].toBool();
-        c->setLinked( isLinked );
-        if ( isLinked == true )
-            c->setLinkedClipUuid( m["linkedClip"].toString() );
+void
+SequenceWorkflow::loadGroups( const QVariantList& groups )
+{
+    m_groups.clear();
+    m_clipGroups.clear();
+    for ( const auto& g : groups )
+    {
+        QList<QUuid>    uuids;
+        for ( const auto& uuid : g.toStringList() )
+            uuids << QUuid( uuid );
+        groupClips( uuids );
+    }
+}
 
-        EffectHelper::loadFromVariant( m["filters"], c->input() );
+QVariantHash
+SequenceWorkflow::takeChanges()
+{
+    QVariantHash    changes;
+    if ( m_changedClips.isEmpty() == false )
+    {
+        // A removed clip is listed in both, a changed one is removed and added back
+        QVariantList    clips;
+        QStringList     removed;
+        for ( const auto& uuid : m_changedClips )
+        {
+            removed << uuid.toString();
+            auto handle = m_clips.handle( uuid );
+            if ( handle != ClipRegistry::InvalidHandle )
+                clips << clipToVariant( handle );
+        }
+        changes.insert( "removed", removed );
+        changes.insert( "clips", clips );
+    }
+    if ( m_groupsChanged == true )
+        changes.insert( "groups", groupsToVariant() );
+    if ( m_filtersChanged == true )
+        changes.insert( "filters", EffectHelper::toVariant( m_multitrack ) );
+    if ( m_changedTrackFilters.isEmpty() == false )
+        changes.insert( "trackFilters", trackFiltersToVariant( m_changedTrackFilters ) );
+    m_changedClips.clear();
+    m_groupsChanged = false;
+    m_filtersChanged = false;
+    m_changedTrackFilters.clear();
+    return changes;
+}
 
-        emit Core::instance()->workflow()->clipAdded( c->uuid().toString() );
+void
+SequenceWorkflow::applyChanges( const QVariantHash& changes )
+{
+    Edit    edit( this );
+    for ( const auto& uuid : changes["removed"].toStringList() )
+    {
+        if ( m_clips.contains( uuid ) == true )
+            removeClip( uuid );
     }
+    for ( const auto& var : changes["clips"].toList() )
+        loadClip( var.toMap() );
+    if ( changes.contains( "groups" ) == true )
+        loadGroups( changes["groups"].toList() );
+    if ( changes.contains( "filters" ) == true )
+    {
+        while ( m_multitrack->filterCount() > 0 )
+            m_multitrack->detach( 0 );
+        EffectHelper::loadFromVariant( changes["filters"], m_multitrack );
+        markDirty( 0, -1, -1 );
+    }
+    loadTrackFilters( changes["trackFilters"].toList() );
+}
+
+void
+SequenceWorkflow::loadFromVariant( const QVariant& variant )
+{
+    static auto& timing = Tools::Metrics::histogram( "project.loadSequence" );
+    Tools::Metrics::ScopedTimer timer( timing );
+    Edit    edit( this );
+    for ( auto& var : variant.toMap()["clips"].toList() )
+        loadClip( var.toMap() );
+    loadGroups( variant.toMap()["groups"].toList() );
     EffectHelper::loadFromVariant( variant.toMap()["filters"], m_multitrack );
+    loadTrackFilters( variant.toMap()["trackFilters"].toList() );
+    markDirty( 0, -1, -1 );
+    // Loaded as saved, nothing to journal
+    takeChanges();
 }
 
 void
 SequenceWorkflow::clear()
 {
-    auto it = m_clips.begin();
-    while ( it != m_clips.end() )
+    Edit    edit( this );
+    for ( auto handle : m_clips.handles() )
+        removeClip( m_clips.clip( handle )->uuid() );
+    m_clips.clear();
+    for ( int type = 0; type < Workflow::NbTrackType; ++type )
     {
-        removeClip( it.key() );
-        // m_clips.begin() can be changed
-        it = m_clips.begin();
+        for ( auto it = m_clipIndex[type].cbegin(); it != m_clipIndex[type].cend(); ++it )
+            m_changedIndexes[type].insert( it.key() );
+        m_clipIndex[type].clear();
     }
+    m_groups.clear();
+    m_clipGroups.clear();
+    // The tracks and the sequence belong to the project being closed, and so do their effects
+    while ( m_multitrack->filterCount() > 0 )
+        m_multitrack->detach( 0 );
+    for ( auto& track : m_multiTracks )
+    {
+        while ( track->filterCount() > 0 )
+            track->detach( 0 );
+    }
+    compactTracks();
+    takeChanges();
 }
 
 std::shared_ptr<Clip>
 SequenceWorkflow::clip( const QUuid& uuid )
 {
-    auto it = m_clips.find( uuid );
-    if ( it == m_clips.end() )
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
         return std::shared_ptr<Clip>( nullptr );
-    return std::get<ClipTupleIndex::Clip>( it.value() );
+    return m_clips.clip( handle );
 }
 
 quint32
 SequenceWorkflow::trackId( const QUuid& uuid )
 {
-    auto it = m_clips.find( uuid );
-    if ( it == m_clips.end() )
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
         return 0;
-    return std::get<ClipTupleIndex::TrackId>( it.value() );
+    return m_clips.trackId( handle );
 }
 
 qint32
 SequenceWorkflow::position( const QUuid& uuid )
 {
-    auto it = m_clips.find( uuid );
-    if ( it == m_clips.end() )
+    auto handle = m_clips.handle( uuid );
+    if ( handle == ClipRegistry::InvalidHandle )
         return 0;
-    return std::get<ClipTupleIndex::Position>( it.value() );
+    return m_clips.position( handle );
+}
+
+ClipRegistry::Handle
+SequenceWorkflow::clipHandle( const QUuid& uuid ) const
+{
+    return m_clips.handle( uuid );
+}
+
+const ClipRegistry&
+SequenceWorkflow::clips() const
+{
+    return m_clips;
+}
+
+QJsonObject
+SequenceWorkflow::clipInfo( ClipRegistry::Handle handle ) const
+{
+    // A single lookup for the clip, its track and its position
+    const auto& clip = m_clips.clip( handle );
+
+    auto h = clip->toVariant().toHash();
+    h["length"] = (qint64)( clip->input()->length() );
+    h["name"] = clip->media()->fileName();
+    h["filePath"] = clip->media()->fileInfo()->absoluteFilePath();
+    h["audio"] = clip->formats().testFlag( Clip::Audio );
+    h["video"] = clip->formats().testFlag( Clip::Video );
+    h["position"] = m_clips.position( handle );
+    h["trackId"] = m_clips.trackId( handle );
+    return QJsonObject::fromVariantHash( h );
+}
+
+QVector<ClipRegistry::Handle>
+SequenceWorkflow::clipsInRange( qint64 begin, qint64 end ) const
+{
+    if ( end < 0 )
+        end = std::numeric_limits<qint64>::max();
+    QVector<ClipRegistry::Handle>   res;
+    for ( const auto& indexes : m_clipIndex )
+    {
+        auto trackIds = indexes.keys();
+        std::sort( trackIds.begin(), trackIds.end() );
+        for ( auto trackId : trackIds )
+        {
+            for ( const auto& e : indexes.find( trackId )->overlapping( begin, end ) )
+                res << m_clips.handle( e.uuid );
+        }
+    }
+    return res;
 }
 
 Backend::IInput*
@@ -299,15 +1944,23 @@ SequenceWorkflow::input()
 Backend::IInput*
 SequenceWorkflow::trackInput( quint32 trackId )
 {
-    Q_ASSERT( trackId < m_multiTracks.size() );
+    allocateTracks( trackId );
     return m_multiTracks[trackId].get();
 }
 
+quint32
+SequenceWorkflow::allocatedTracks() const
+{
+    return m_multiTracks.size();
+}
+
 std::shared_ptr<Backend::ITrack>
 SequenceWorkflow::trackFromFormats( quint32 trackId, Clip::Formats formats )
 {
-    if ( trackId >= (quint32)m_trackCount )
+    if ( trackId >= (quint32)m_trackCount ||
+         ( formats.testFlag( Clip::Audio ) == false && formats.testFlag( Clip::Video ) == false ) )
         return nullptr;
+    allocateTracks( trackId );
     if ( formats.testFlag( Clip::Audio ) )
         return m_tracks[Workflow::AudioTrack][trackId];
     else if ( formats.testFlag( Clip::Video ) )
@@ -23,13 +23,21 @@
 #ifndef SEQUENCEWORKFLOW_H
 #define SEQUENCEWORKFLOW_H
 
+#include <functional>
 #include <memory>
 #include <tuple>
 
 #include <QUuid>
+#include <QHash>
+#include <QJsonObject>
 #include <QMap>
+#include <QSet>
 
 #include "Media/Clip.h"
+#include "ClipIndex.h"
+#include "ClipRegistry.h"
+#include "DirtyRanges.h"
+#include "SmartRender.h"
 #include "Types.h"
 
 namespace Backend
@@ -37,6 +45,11 @@ namespace Backend
 class IMultiTrack;
 class ITrack;
 class IInput;
+class ITransition;
+namespace MLT
+{
+class MLTAudioMixer;
+}
 }
 
 namespace ClipTupleIndex
@@ -48,6 +61,15 @@ namespace ClipTupleIndex
     };
 }
 
+/**
+ *  \brief  The tracks of the project's sequence, and the clips laid on them.
+ *
+ *  A project holds a single editable sequence. Clips of it can be nested into a sequence
+ *  of their own, which then plays as a single clip. \sa MainWorkflow::nestClips()
+ *  The nested sequences are frozen: the preview decodes their flattened render once
+ *  ProxyService made it. Caching the frames composited from this sequence is left to
+ *  PreviewCache, which follows changed().
+ */
 class SequenceWorkflow : public QObject
 {
     Q_OBJECT
@@ -59,36 +81,451 @@ class SequenceWorkflow : public QObject
         // Clip, Track Id, and Position
         using ClipTuple = std::tuple<std::shared_ptr<Clip>, quint32, qint64>;
 
+        /**
+         *  \brief  Where a clip goes in a batch of edits. A negative begin or end keeps
+         *          the current boundary.
+         */
+        struct ClipEdit
+        {
+            QUuid       uuid;
+            quint32     trackId;
+            qint64      pos;
+            qint64      begin;
+            qint64      end;
+        };
+
         bool                    addClip( std::shared_ptr<Clip> const& clip, quint32 trackId, qint32 pos );
         QString                 addClip( const QUuid& uuid, quint32 trackId, qint32 pos, bool isAudioClip );
         bool                    moveClip( const QUuid& uuid, quint32 trackId, qint64 pos );
         bool                    resizeClip( const QUuid& uuid, qint64 newBegin,
                                             qint64 newEnd, qint64 newPos );
+        /**
+         *  \brief  Moves and resizes several clips as a single edit.
+         *
+         *  Overlaps are checked once, against the final layout: a clip may take the place
+         *  another clip of the batch is leaving. If any clip would overlap another one,
+         *  nothing changes and false is returned.
+         */
+        bool                    editClips( const QList<ClipEdit>& edits );
+        /**
+         *  \brief  Plays the clip at speed, from begin to end, which are frames of its
+         *          media played at that speed. \sa Clip::retimedBoundaries()
+         *
+         *  The clip stays at its position, and its length changes. Returns false if it
+         *  would run over the following clip, or if its media can't be retimed.
+         */
+        bool                    retimeClip( const QUuid& uuid, double speed, bool frameBlending,
+                                            qint64 begin, qint64 end );
+
+        /**
+         *  Trimming edits, each done in a single pass over the playlist of the clip's
+         *  track. delta is in frames.
+         */
+        // Removes the clip, and moves the following clips of its track back over the gap
+        std::shared_ptr<Clip>   rippleRemoveClip( const QUuid& uuid );
+        // Inserts the clip at pos, moving the following clips of the track forward
+        bool                    rippleInsertClip( std::shared_ptr<Clip> const& clip,
+                                                  quint32 trackId, qint64 pos );
+        // Moves the cut between the clip and what follows it
+        bool                    rollClip( const QUuid& uuid, qint64 delta );
+        // Shows another part of the clip's media, at the same place
+        bool                    slipClip( const QUuid& uuid, qint64 delta );
+        // Moves the clip, trimming its neighbours so that nothing else moves
+        bool                    slideClip( const QUuid& uuid, qint64 delta );
+        /**
+         *  \brief  Splits a clip in many pieces, in a single pass over its track.
+         *
+         *  The pieces are cuts of the same media as the clip, sorted, and following
+         *  each other up to the clip's end. The clip is shortened to end where the first
+         *  one begins. joinClip() puts the clip back as it was, and returns the pieces.
+         */
+        bool                    splitClip( const QUuid& uuid, const QList<std::shared_ptr<Clip>>& pieces );
+        QList<std::shared_ptr<Clip>>    joinClip( const QUuid& uuid, const QList<QUuid>& pieces );
+        /**
+         *  \brief  Returns the clip ending right where uuid starts, or beginning right
+         *          where it ends, a null uuid if there's a blank in between.
+         */
+        QUuid                   previousClip( const QUuid& uuid ) const;
+        QUuid                   nextClip( const QUuid& uuid ) const;
+
+        /**
+         *  \brief  Groups the clips. The groups they were part of are dissolved.
+         *
+         *  Groups refer to clips by uuid, so a removed clip gets back in its group when
+         *  the removal is undone.
+         */
+        void                    groupClips( const QList<QUuid>& uuids );
+        // Dissolves the group of the clip
+        void                    ungroupClips( const QUuid& uuid );
+        /**
+         *  \brief  Returns the clips of the sequence grouped with uuid, including it, or
+         *          an empty list.
+         */
+        QList<QUuid>            group( const QUuid& uuid ) const;
+
+        // Instantiates a clip of the library, to be added to the sequence
+        std::shared_ptr<Clip>   createClip( const QUuid& libraryUuid, bool isAudioClip );
+        /**
+         *  \brief  Builds a clip back from its Clip::toVariant() description, without
+         *          adding it to the sequence. Returns nullptr if its parent is gone.
+         */
+        static std::shared_ptr<Clip>    clipFromVariant( const QVariantMap& variant );
         std::shared_ptr<Clip>   removeClip( const QUuid& uuid );
+        // Removes and adds back several clips, as a single edit
+        QList<ClipTuple>        removeClips( const QList<QUuid>& uuids );
+        /**
+         *  \brief  Adds several clips, as a single edit.
+         *
+         *  The clips going to the same free stretch of a track, such as clips dropped
+         *  one after the other, are inserted in a single pass over it.
+         */
+        bool                    addClips( const QList<ClipTuple>& clips );
         bool                    linkClips( const QUuid& uuidA, const QUuid& uuidB );
         bool                    unlinkClips( const QUuid& uuidA, const QUuid& uuidB );
 
         QVariant                toVariant() const;
         void                    loadFromVariant( const QVariant& variant );
+        /**
+         *  \brief  Returns what changed since the last call, as a journal record, empty
+         *          if nothing did.
+         *
+         *  The record holds the full state of each changed or removed clip, and of the
+         *  groups and sequence filters if they changed, rather than the edit which was
+         *  made: replaying it only takes applyChanges(), whatever the edit was.
+         */
+        QVariantHash            takeChanges();
+        void                    applyChanges( const QVariantHash& changes );
         void                    clear();
 
         std::shared_ptr<Clip>   clip( const QUuid& uuid );
         quint32                 trackId( const QUuid& uuid );
         qint32                  position( const QUuid& uuid );
 
+        /**
+         *  \brief  Returns a handle to the clip, valid until the clip is removed.
+         *
+         *  For callers querying the same clip repeatedly: the handle based accessors
+         *  don't need any lookup.
+         */
+        ClipRegistry::Handle    clipHandle( const QUuid& uuid ) const;
+        const ClipRegistry&     clips() const;
+        /**
+         *  \brief  Describes the clip for the timeline: its Clip::toVariant() description,
+         *          with its media, formats, track and position.
+         */
+        QJsonObject             clipInfo( ClipRegistry::Handle handle ) const;
+        /**
+         *  \brief  Returns the clips intersecting [begin, end), by track type, track
+         *          and position. A negative end reaches the end of the sequence.
+         */
+        QVector<ClipRegistry::Handle>   clipsInRange( qint64 begin, qint64 end ) const;
+
         Backend::IInput*        input();
         Backend::IInput*        trackInput( quint32 trackId );
+        // The tracks created so far, trackInput() creates them as needed
+        quint32                 allocatedTracks() const;
+
+        /**
+         *  \brief  Lists the ranges in which a single clip plays, without any effect.
+         *
+         *  In those ranges, a video clip is the only one playing along with its linked
+         *  audio clip, which starts at the same point of the same media.
+         */
+        QList<PassthroughRange> passthroughRanges() const;
+
+        /**
+         *  \brief  Notifies that the filters of target changed, between begin and end.
+         *
+         *  target is the sequence, a track, or a clip, in which case begin and end are
+         *  relative to its first frame. A negative end covers the whole target.
+         */
+        void                    filterChanged( const Backend::IInput* target, qint64 begin, qint64 end );
+
+        /**
+         *  \brief  Returns the positions of the clips of a track, nullptr if it never
+         *          held any.
+         */
+        const ClipIndex*        clipIndex( Workflow::TrackType type, quint32 trackId ) const;
+
+        /**
+         *  \brief  A frozen copy of the clip indexes, as they were after an edit.
+         *
+         *  Never modified once published: the tracks which didn't change in an edit are
+         *  shared with the previous version.
+         */
+        struct IndexSnapshot
+        {
+            // Incremented by each published edit
+            quint64                                         version;
+            QHash<quint32, std::shared_ptr<const ClipIndex>> tracks[Workflow::NbTrackType];
+        };
+        /**
+         *  \brief  Returns the clip indexes as of the last completed edit.
+         *
+         *  Unlike the rest of this class, it can be called from any thread, and is
+         *  lock free: background workers keep the version they got for as long as they
+         *  need it, while the GUI thread publishes the next ones.
+         */
+        std::shared_ptr<const IndexSnapshot>    indexSnapshot() const;
+        // The kind of track the clip goes to
+        static Workflow::TrackType  trackType( const Clip& clip );
+        /**
+         *  \brief  Returns the position closest to pos where a clip of length frames
+         *          doesn't overlap any other clip of the track.
+         *
+         *  The clip first snaps to the boundaries of the other clips closer than margin
+         *  frames. ignore is the clip being moved.
+         */
+        qint64                  freePosition( Workflow::TrackType type, quint32 trackId, qint64 pos,
+                                              qint64 length, const QUuid& ignore, qint64 margin = 0 ) const;
+
+        /**
+         *  \brief  Mutes the audio, or hides the video of a track.
+         *
+         *  A track which has no clip left to render is taken out of the tractor.
+         */
+        void                    setTrackMuted( quint32 trackId, Workflow::TrackType type, bool muted );
+        bool                    isTrackMuted( quint32 trackId, Workflow::TrackType type ) const;
+
+        enum TransitionStyle
+        {
+            NoTransition,
+            Dissolve,
+            Wipe,
+        };
+        /**
+         *  \brief  Sets how the video of clips overlapping on two tracks is blended.
+         *
+         *  Where a clip starts above another one still playing, or ends above another
+         *  one which already started, the overlap becomes a transition from the clip
+         *  leaving to the one entering. Their audio is then cross faded.
+         */
+        void                    setTransitionStyle( TransitionStyle style );
+
+        /**
+         *  \brief  The level of a track in the audio mix. gain is linear, pan goes from
+         *          -1, left only, to 1, right only.
+         */
+        void                    setTrackGain( quint32 trackId, float gain );
+        void                    setTrackPan( quint32 trackId, float pan );
+        /**
+         *  \brief  Hands the PCM caches of the audio clips over to the mixer, which reads
+         *          them while scrubbing. \sa Backend::MLT::MLTAudioMixer::setScrubSources()
+         *
+         *  The clips whose media isn't cached yet keep being decoded, and the cache gets
+         *  built in the background for the next time.
+         */
+        void                    updateScrubSources();
+        /**
+         *  \brief  Brings the audio clips to the target loudness, in LUFS, using their
+         *          media's measurement, or restores their level when disabled.
+         *          \sa Media::loudness()
+         *
+         *  The clips are only amplified as long as their true peak stays below -1 dBTP.
+         *  The preview cache isn't invalidated, as this is meant to be enabled while a
+         *  copy of the sequence gets rendered.
+         *  Returns the number of clips whose media isn't measured yet, which are left as
+         *  they are.
+         */
+        int                     setLoudnessNormalization( bool enabled, double target );
+        /**
+         *  \brief  Finds where the clips should be for their audio to line up with the
+         *          one of the first clip, which stays in place.
+         *
+         *  The audio is read from the PCM caches of the medias, see Tools::alignAudio().
+         *  The clips whose media isn't cached yet, or whose audio doesn't match, are
+         *  left out of the returned positions.
+         */
+        QHash<QUuid, qint64>    audioSyncPositions( const QList<QUuid>& uuids );
+
+        /**
+         *  \brief  Render in place: plays a rendition of the clip, its effects included,
+         *          instead of the clip itself.
+         *
+         *  prepareFreeze() marks the clip as being rendered, and freezeClip() swaps the
+         *  rendered file in, unless the clip was thawed in the meantime. Changing the
+         *  boundaries or the effects of a frozen clip, or removing it, thaws it back and
+         *  deletes its rendition. Moving it doesn't.
+         */
+        void                    prepareFreeze( const QUuid& uuid );
+        // Returns false if the clip changed since prepareFreeze(), or the file is unusable
+        bool                    freezeClip( const QUuid& uuid, const QString& filePath );
+        void                    thawClip( const QUuid& uuid );
+        bool                    isFrozen( const QUuid& uuid ) const;
+        /**
+         *  \brief  Cuts the clips of media again once it replaced its placeholder, and
+         *          swaps them in their tracks. Returns the number of clips reloaded.
+         */
+        int                     reloadMedia( const Media* media );
+        /**
+         *  \brief  Extends the clips which ended with a growing media, once it got longer,
+         *          over the blank which follows them. Returns the uuids of those clips.
+         */
+        QList<QUuid>            growMedia( const Media* media, qint64 oldLength );
+        /**
+         *  \brief  Scales the positions and boundaries of the clips, and the ones of the
+         *          effects, by ratio once the frame rate changed. Returns the uuids of
+         *          the clips rescaled.
+         *
+         *  The clips stay in their tracks and keep their inputs, only the frames they
+         *  play change. The medias must have been rescaled first. \sa Media::rescale()
+         */
+        QList<QUuid>            rescale( double ratio );
+        /**
+         *  \brief  The frames of each media which the clips play, as [first, last] pairs.
+         *
+         *  The retimed clips play frames of their retimed media: they need the whole of it.
+         */
+        QHash<Media*, QList<QPair<qint64, qint64>>> mediaRanges() const;
+        /**
+         *  \brief  Moves the boundaries of the clips of media to the frames map returns,
+         *          before it gets relinked to a file holding a part of it.
+         *
+         *  The clips aren't cut again: reloadMedia() does, once the media was relinked.
+         *  The retimed clips are left as they are.
+         */
+        void                    remapMedia( const Media* media, const std::function<qint64( qint64 )>& map );
 
     private:
+        /**
+         *  \brief  Collects the ranges marked dirty while it lives, to notify them once.
+         *
+         *  Edits nest, as they're implemented on top of each other: only the outermost
+         *  one notifies.
+         */
+        class Edit
+        {
+            public:
+                explicit Edit( SequenceWorkflow* sequence );
+                ~Edit();
+
+            private:
+                SequenceWorkflow*   m_sequence;
+        };
+
+        // Inserts clips of the same track with a single ITrack::insertMany(), sorting them
+        bool                    insertClips( QList<ClipTuple>& clips );
+        // trackId < 0 marks a sequence wide change
+        void                    markDirty( qint64 begin, qint64 end, qint32 trackId );
+        void                    flushDirty();
+        // Returns the index of the track, marking it changed for the next snapshot
+        ClipIndex&              mutableIndex( Workflow::TrackType type, quint32 trackId );
+        // Publishes a new snapshot, if an index changed since the last one
+        void                    publishIndexes();
+
+        QVariant                clipToVariant( ClipRegistry::Handle handle ) const;
+        QVariantList            groupsToVariant() const;
+        bool                    loadClip( const QVariantMap& variant );
+        // Replaces the groups
+        void                    loadGroups( const QVariantList& groups );
+        // Only lists the tracks which have filters, or the ones in trackIds if not empty
+        QVariantList            trackFiltersToVariant( const QSet<quint32>& trackIds = {} ) const;
+        void                    loadTrackFilters( const QVariantList& tracks );
 
         inline std::shared_ptr<Backend::ITrack>         trackFromFormats( quint32 trackId, Clip::Formats formats );
+        // Updates the positional index from the clip's entry in the registry
+        void                    indexClip( const QUuid& uuid );
+        // Moves the clips of a track starting at or after from by delta frames
+        void                    shiftClips( Workflow::TrackType type, quint32 trackId,
+                                            qint64 from, qint64 delta );
+        // Reindexes clips whose positions and lengths all changed together
+        void                    reindexClips( const QList<QUuid>& uuids );
+        static void             rescaleFilters( Backend::IInput& input, double ratio );
+        /**
+         *  \brief  Creates the tracks up to trackId, if they don't exist yet.
+         *
+         *  Tracks are only created when used, as the tractor goes through every one of
+         *  them for each frame.
+         */
+        void                    allocateTracks( quint32 trackId );
+        // Releases the unused tracks on top of the used ones, those without effects or muting
+        void                    compactTracks();
+        /**
+         *  \brief  Connects the track to the tractor if it has clips to render, or
+         *          an empty placeholder otherwise.
+         *
+         *  A track whose every frame is hidden by opaque clips above, and which has no
+         *  sound to play, isn't rendered either.
+         */
+        void                    updateTrackActivity( quint32 trackId );
+        bool                    isOccluded( quint32 trackId ) const;
+        // true if opaque clips of the tracks above trackId cover [begin, end)
+        bool                    isCovered( qint64 begin, qint64 end, quint32 trackId ) const;
+        // false if the clip may let the tracks below show through
+        bool                    isOpaque( const QUuid& uuid, quint32 trackId ) const;
+        /**
+         *  \brief  Matches the transitions with the overlaps of the clips, only
+         *          replacing the ones which changed.
+         */
+        void                    updateTransitions();
+        void                    removeTransitions();
 
-        QMap<QUuid, ClipTuple>          m_clips;
+        ClipRegistry                    m_clips;
 
+        // Holds the sequence effects, above m_tracks, so that they apply to the audio mix
         Backend::IMultiTrack*           m_multitrack;
+        Backend::IMultiTrack*           m_tracksTractor;
+        std::unique_ptr<Backend::MLT::MLTAudioMixer>    m_mixer;
         QList<std::shared_ptr<Backend::ITrack>>         m_tracks[Workflow::NbTrackType];
         QList<std::shared_ptr<Backend::IMultiTrack>>    m_multiTracks;
+        // Connected in place of the inactive tracks
+        QList<std::shared_ptr<Backend::ITrack>>         m_placeholders;
+        QList<bool>                     m_active;
+        QSet<quint32>                   m_mutedTracks[Workflow::NbTrackType];
+        QHash<quint32, ClipIndex>       m_clipIndex[Workflow::NbTrackType];
+        QSet<quint32>                   m_changedIndexes[Workflow::NbTrackType];
+        // Only accessed through std::atomic_load/store
+        std::shared_ptr<const IndexSnapshot>    m_indexSnapshot;
+        QHash<quint32, QSet<QUuid>>     m_groups;
+        QHash<QUuid, quint32>           m_clipGroups;
+        struct FrozenClip
+        {
+            QString                             filePath;
+            // nullptr while the rendition is being rendered
+            std::shared_ptr<Backend::IInput>    input;
+        };
+        QHash<QUuid, FrozenClip>        m_frozenClips;
+        quint32                         m_nextGroupId;
+        // What changed since the last takeChanges()
+        QSet<QUuid>                     m_changedClips;
+        bool                            m_groupsChanged;
+        bool                            m_filtersChanged;
+        QSet<quint32>                   m_changedTrackFilters;
+
+        struct AutoTransition
+        {
+            Workflow::TrackType     type;
+            // The lower track, the upper one being b
+            quint32                 aTrack;
+            quint32                 bTrack;
+            qint64                  begin;
+            qint64                  end;
+            // From b to a, the clip of b track leaving
+            bool                    fadeOut;
+            std::shared_ptr<Backend::ITransition>   transition;
+        };
+        QList<AutoTransition>           m_transitions;
+        TransitionStyle                 m_transitionStyle;
         const size_t                    m_trackCount;
+
+        DirtyRanges                     m_dirty;
+        QMap<quint32, DirtyRanges>      m_dirtyTracks;
+        int                             m_editDepth;
+
+    signals:
+        /**
+         *  \brief Emitted once per edit, for each merged range of frames which may render
+         *         differently.
+         *
+         *  A negative end means every frame after begin.
+         */
+        void                    changed( qint64 begin, qint64 end );
+        /**
+         *  \brief Same as changed(), per track. Changes to the sequence's own filters are
+         *         only notified through changed().
+         */
+        void                    trackChanged( quint32 trackId, qint64 begin, qint64 end );
+        void                    frozenChanged( const QUuid& uuid, bool frozen );
 };
 
 #endif // SEQUENCEWORKFLOW_H
@@ -0,0 +1,320 @@
+/*****************************************************************************
+ * SmartRender.cpp: Finds the parts of a sequence which can be stream-copied
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "SmartRender.h"
+#include "RenderJob.h"
+
+#include "Tools/VlmcDebug.h"
+
+#include <QProcess>
+#include <QStandardPaths>
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+SmartRender::SmartRender( const RenderParameters& params, qint64 totalFrames, QObject* parent )
+    : QObject( parent )
+    , m_params( params )
+    , m_totalFrames( totalFrames )
+    , m_probe( nullptr )
+{
+}
+
+SmartRender::~SmartRender()
+{
+    if ( m_probe != nullptr )
+    {
+        m_probe->disconnect( this );
+        m_probe->kill();
+        m_probe->waitForFinished();
+    }
+}
+
+bool
+SmartRender::start()
+{
+    if ( m_params.passthrough.isEmpty() == true )
+        return false;
+    m_ffprobe = QStandardPaths::findExecutable( "ffprobe" );
+    if ( m_ffprobe.isEmpty() == true )
+    {
+        vlmcWarning() << "ffprobe is required to copy the untouched parts of the sequence";
+        return false;
+    }
+    for ( const auto& range : m_params.passthrough )
+    {
+        if ( m_pendingSources.contains( range.filePath ) == false )
+            m_pendingSources.append( range.filePath );
+    }
+    probeNext();
+    return true;
+}
+
+const QList<SmartRender::Span>&
+SmartRender::spans() const
+{
+    return m_spans;
+}
+
+bool
+SmartRender::hasPassthrough() const
+{
+    for ( const auto& s : m_spans )
+    {
+        if ( s.source.isEmpty() == false )
+            return true;
+    }
+    return false;
+}
+
+const QString&
+SmartRender::videoEncoder() const
+{
+    return m_videoEncoder;
+}
+
+const QString&
+SmartRender::audioEncoder() const
+{
+    return m_audioEncoder;
+}
+
+const QString&
+SmartRender::pixelFormat() const
+{
+    return m_pixelFormat;
+}
+
+QString
+SmartRender::encoderFor( const QString& codec )
+{
+    // The encoders producing streams which can be joined with the copied ones
+    static const QHash<QString, QString> encoders = {
+        { "h264", "libx264" },
+        { "hevc", "libx265" },
+        { "mpeg4", "mpeg4" },
+        { "mpeg2video", "mpeg2video" },
+        { "vp8", "libvpx" },
+        { "vp9", "libvpx-vp9" },
+        { "prores", "prores_ks" },
+        { "dnxhd", "dnxhd" },
+        { "mjpeg", "mjpeg" },
+        { "aac", "aac" },
+        { "mp3", "libmp3lame" },
+        { "ac3", "ac3" },
+        { "opus", "libopus" },
+        { "vorbis", "libvorbis" },
+        { "pcm_s16le", "pcm_s16le" },
+        { "pcm_s24le", "pcm_s24le" },
+    };
+    return encoders.value( codec );
+}
+
+SmartRender::SourceInfo
+SmartRender::parse( const QByteArray& output )
+{
+    SourceInfo  info;
+    int         videoIndex = -1;
+    int         audioIndex = -1;
+    // Packets are listed before the streams, the video stream's index isn't known yet
+    QVector<std::tuple<int, double, bool>>  packets;
+
+    for ( const auto& line : output.split( '\n' ) )
+    {
+        auto fields = QString::fromUtf8( line ).trimmed().split( '|' );
+        if ( fields.size() < 2 )
+            continue;
+        QHash<QString, QString>     values;
+        for ( int i = 1; i < fields.size(); ++i )
+        {
+            auto idx = fields[i].indexOf( '=' );
+            if ( idx > 0 )
+                values.insert( fields[i].left( idx ), fields[i].mid( idx + 1 ) );
+        }
+        if ( fields[0] == "packet" )
+        {
+            bool ok = false;
+            auto pts = values.value( "pts_time" ).toDouble( &ok );
+            if ( ok == true )
+                packets.append( std::make_tuple( values.value( "stream_index" ).toInt(), pts,
+                                                 values.value( "flags" ).contains( 'K' ) ) );
+        }
+        else if ( fields[0] == "stream" )
+        {
+            auto type = values.value( "codec_type" );
+            if ( type == "video" && videoIndex < 0 )
+            {
+                videoIndex = values.value( "index" ).toInt();
+                info.videoCodec = values.value( "codec_name" );
+                info.pixelFormat = values.value( "pix_fmt" );
+                info.width = values.value( "width" ).toInt();
+                info.height = values.value( "height" ).toInt();
+                auto rate = values.value( "avg_frame_rate" ).split( '/' );
+                if ( rate.size() == 2 && rate[1].toDouble() > 0 )
+                    info.fps = rate[0].toDouble() / rate[1].toDouble();
+            }
+            else if ( type == "audio" && audioIndex < 0 )
+            {
+                audioIndex = values.value( "index" ).toInt();
+                info.audioCodec = values.value( "codec_name" );
+                info.sampleRate = values.value( "sample_rate" ).toInt();
+                info.channels = values.value( "channels" ).toInt();
+            }
+        }
+    }
+    if ( videoIndex < 0 || audioIndex < 0 || info.fps <= 0 )
+        return info;
+
+    info.startTime = INFINITY;
+    for ( const auto& p : packets )
+    {
+        if ( std::get<0>( p ) != videoIndex )
+            continue;
+        info.startTime = std::min( info.startTime, std::get<1>( p ) );
+        if ( std::get<2>( p ) == true )
+            info.keyframes.append( std::get<1>( p ) );
+    }
+    std::sort( info.keyframes.begin(), info.keyframes.end() );
+    info.valid = info.keyframes.isEmpty() == false;
+    return info;
+}
+
+bool
+SmartRender::isCompatible( const SourceInfo& info ) const
+{
+    if ( info.valid == false )
+        return false;
+    if ( info.width != (int)m_params.width || info.height != (int)m_params.height ||
+         std::abs( info.fps - m_params.fps ) > 0.01 ||
+         info.sampleRate != (int)m_params.sampleRate || info.channels != (int)m_params.nbChannels )
+        return false;
+
+    auto videoEncoder = encoderFor( info.videoCodec );
+    auto audioEncoder = encoderFor( info.audioCodec );
+    if ( videoEncoder.isEmpty() == true || audioEncoder.isEmpty() == true )
+        return false;
+    // An explicitly requested encoder must produce the same streams
+    auto requestedVideo = QString::fromStdString( m_params.encoder.videoCodec );
+    auto requestedAudio = QString::fromStdString( m_params.encoder.audioCodec );
+    return ( requestedVideo.isEmpty() == true || requestedVideo == videoEncoder ) &&
+           ( requestedAudio.isEmpty() == true || requestedAudio == audioEncoder );
+}
+
+void
+SmartRender::probeNext()
+{
+    if ( m_pendingSources.isEmpty() == true )
+    {
+        plan();
+        return;
+    }
+    m_probe = new QProcess( this );
+    m_probe->setProcessChannelMode( QProcess::SeparateChannels );
+    connect( m_probe, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>( &QProcess::finished ),
+             this, &SmartRender::probeFinished );
+    m_probe->start( m_ffprobe, QStringList{ "-v", "error", "-of", "compact", "-show_entries",
+                    "packet=stream_index,pts_time,flags:"
+                    "stream=index,codec_type,codec_name,width,height,pix_fmt,avg_frame_rate,sample_rate,channels",
+                    m_pendingSources.first() } );
+    if ( m_probe->waitForStarted() == false )
+    {
+        vlmcWarning() << "Failed to start" << m_ffprobe;
+        delete m_probe;
+        m_probe = nullptr;
+        // Everything will be rendered
+        m_pendingSources.clear();
+        plan();
+    }
+}
+
+void
+SmartRender::probeFinished()
+{
+    auto source = m_pendingSources.takeFirst();
+    if ( m_probe->exitStatus() == QProcess::NormalExit && m_probe->exitCode() == 0 )
+        m_sources.insert( source, parse( m_probe->readAllStandardOutput() ) );
+    else
+        vlmcWarning() << "Failed to probe" << source << ':' << m_probe->readAllStandardError();
+    m_probe->deleteLater();
+    m_probe = nullptr;
+    probeNext();
+}
+
+void
+SmartRender::plan()
+{
+    m_spans.clear();
+    QList<Span>         copies;
+    const SourceInfo*   reference = nullptr;
+
+    for ( const auto& range : m_params.passthrough )
+    {
+        auto it = m_sources.constFind( range.filePath );
+        if ( it == m_sources.constEnd() || isCompatible( *it ) == false )
+            continue;
+        // The first copied source decides the streams of the whole output
+        if ( reference == nullptr )
+        {
+            reference = &*it;
+            m_videoEncoder = encoderFor( reference->videoCodec );
+            m_audioEncoder = encoderFor( reference->audioCodec );
+            m_pixelFormat = reference->pixelFormat;
+        }
+        else if ( it->videoCodec != reference->videoCodec || it->audioCodec != reference->audioCodec ||
+                  it->pixelFormat != reference->pixelFormat )
+            continue;
+
+        // Only copy whole GOPs: from the first keyframe in the range, up to the last one
+        const auto& keyframes = it->keyframes;
+        double inTime = it->startTime + range.sourceBegin / it->fps;
+        double outTime = inTime + ( range.end - range.begin ) / it->fps;
+        double epsilon = 0.5 / it->fps;
+        auto first = std::lower_bound( keyframes.begin(), keyframes.end(), inTime - epsilon );
+        auto last = std::upper_bound( keyframes.begin(), keyframes.end(), outTime + epsilon );
+        if ( first == keyframes.end() || last == keyframes.begin() )
+            continue;
+        --last;
+        if ( last <= first )
+            continue;
+
+        qint64 begin = range.begin + qRound64( ( *first - inTime ) * it->fps );
+        qint64 end = qMin( range.end, range.begin + qRound64( ( *last - inTime ) * it->fps ) );
+        // Copying a handful of frames isn't worth an extra join
+        if ( end - begin < qRound64( it->fps ) )
+            continue;
+        copies.append( Span{ begin, end, range.filePath, *first, *last } );
+    }
+
+    qint64 pos = 0;
+    for ( const auto& c : copies )
+    {
+        if ( c.begin > pos )
+            m_spans.append( Span{ pos, c.begin, QString(), 0, 0 } );
+        m_spans.append( c );
+        pos = c.end;
+    }
+    if ( pos < m_totalFrames )
+        m_spans.append( Span{ pos, m_totalFrames, QString(), 0, 0 } );
+    emit planned();
+}
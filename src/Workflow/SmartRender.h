@@ -0,0 +1,125 @@
+/*****************************************************************************
+ * SmartRender.h: Finds the parts of a sequence which can be stream-copied
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SMARTRENDER_H
+#define SMARTRENDER_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include "RenderParameters.h"
+
+class QProcess;
+
+/**
+ *  \brief  Plans a smart render: which parts of the sequence are copied from the
+ *          medias without being reencoded, and which ones need to be rendered.
+ *
+ *  The sources of the passthrough ranges are probed with ffprobe. A range is only
+ *  copied if its media's streams match the output, and only in between keyframes,
+ *  so the frames around the cut points are still reencoded.
+ */
+class SmartRender : public QObject
+{
+    Q_OBJECT
+
+    public:
+        struct Span
+        {
+            // In sequence frames, end excluded
+            qint64      begin;
+            qint64      end;
+            // Empty for the spans which have to be rendered
+            QString     source;
+            // Timestamps in the source, in seconds
+            double      inPoint;
+            double      outPoint;
+        };
+
+        SmartRender( const RenderParameters& params, qint64 totalFrames, QObject* parent = nullptr );
+        ~SmartRender();
+
+        /**
+         *  \brief  Starts probing the sources in the background, until planned() gets
+         *          emitted. Returns false if there is nothing to plan, or no ffprobe.
+         */
+        bool                    start();
+
+        /**
+         *  \returns    The spans covering the whole sequence, in order. Only valid once
+         *              planned() has been emitted.
+         */
+        const QList<Span>&      spans() const;
+        bool                    hasPassthrough() const;
+        /**
+         *  \brief  The encoders and pixel format matching the copied streams, which the
+         *          rendered spans must use.
+         */
+        const QString&          videoEncoder() const;
+        const QString&          audioEncoder() const;
+        const QString&          pixelFormat() const;
+
+    private:
+        struct SourceInfo
+        {
+            bool            valid = false;
+            QString         videoCodec;
+            QString         audioCodec;
+            QString         pixelFormat;
+            int             width = 0;
+            int             height = 0;
+            double          fps = 0;
+            int             sampleRate = 0;
+            int             channels = 0;
+            // Presentation time of the first video frame
+            double          startTime = 0;
+            QVector<double> keyframes;
+        };
+
+        static QString          encoderFor( const QString& codec );
+        static SourceInfo       parse( const QByteArray& output );
+        bool                    isCompatible( const SourceInfo& info ) const;
+        void                    probeNext();
+        void                    probeFinished();
+        void                    plan();
+
+    private:
+        // Copied, for the plan not to depend on the lifetime of the caller's parameters
+        const RenderParameters      m_params;
+        qint64                      m_totalFrames;
+        QString                     m_ffprobe;
+        QList<QString>              m_pendingSources;
+        QHash<QString, SourceInfo>  m_sources;
+        QProcess*                   m_probe;
+        QList<Span>                 m_spans;
+        QString                     m_videoEncoder;
+        QString                     m_audioEncoder;
+        QString                     m_pixelFormat;
+
+    signals:
+        void                    planned();
+};
+
+#endif // SMARTRENDER_H
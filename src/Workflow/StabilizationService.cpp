@@ -0,0 +1,169 @@
+/*****************************************************************************
+ * StabilizationService.cpp: Caches the motion analysis of the stabilization
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "StabilizationService.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IProfile.h"
+#include "Backend/MLT/MLTFilter.h"
+#include "Backend/MLT/MLTInput.h"
+#include "Tools/CacheFile.h"
+#include "Tools/FileHash.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+#include <mlt++/MltProperties.h>
+
+const QString   StabilizationService::SubDirectory = ".stabilization";
+const char*     StabilizationService::FilterId = "vidstab";
+
+StabilizationService::StabilizationService( Tools::JobScheduler* scheduler, QObject* parent )
+    : QObject( parent )
+    , m_scheduler( scheduler )
+{
+}
+
+StabilizationService::~StabilizationService()
+{
+    m_scheduler->cancel( m_token );
+    m_scheduler->wait( m_token );
+}
+
+void
+StabilizationService::setDirectory( const QString& cacheDir )
+{
+    QMutexLocker    lock( &m_mutex );
+    if ( cacheDir.isEmpty() == true )
+        m_directory.clear();
+    else
+        m_directory = cacheDir + '/' + SubDirectory;
+}
+
+QString
+StabilizationService::outputPath( const QString& filePath, qint64 begin, qint64 end ) const
+{
+    QString directory;
+    {
+        QMutexLocker    lock( &m_mutex );
+        directory = m_directory;
+    }
+    if ( directory.isEmpty() == true )
+        return QString();
+    auto hash = Tools::contentHash( filePath );
+    if ( hash.isEmpty() == true )
+        return QString();
+    return directory + '/' + QString::fromLatin1( hash ) + '_' + QString::number( begin ) +
+            '_' + QString::number( end ) + '_' +
+            QString::number( Backend::instance()->profile().fps(), 'g', 8 ) + ".trf";
+}
+
+bool
+StabilizationService::request( const QString& filePath, qint64 begin, qint64 end, bool onProxy )
+{
+    auto path = outputPath( filePath, begin, end );
+    if ( path.isEmpty() == true )
+        return false;
+    if ( QFile::exists( path ) == true )
+    {
+        emit analyzed( filePath, begin, end, true );
+        return true;
+    }
+    if ( QDir().mkpath( QFileInfo( path ).absolutePath() ) == false )
+    {
+        vlmcWarning() << "Can't create the stabilization directory for" << path;
+        return false;
+    }
+
+    QMutexLocker    lock( &m_mutex );
+    if ( m_pending.contains( path ) == true )
+        return true;
+    m_pending.insert( path );
+    Job job{ filePath, begin, end, onProxy, path };
+    m_scheduler->schedule( Tools::JobScheduler::Background,
+                           [this, job]( const Tools::JobScheduler::CancellationToken& token )
+    {
+        analyze( job, token );
+    }, m_token );
+    return true;
+}
+
+QString
+StabilizationService::transformsPath( const QString& filePath, qint64 begin, qint64 end ) const
+{
+    auto path = outputPath( filePath, begin, end );
+    if ( path.isEmpty() == true || QFile::exists( path ) == false )
+        return QString();
+    return path;
+}
+
+void
+StabilizationService::analyze( const Job& job, const Tools::JobScheduler::CancellationToken& token )
+{
+    auto partPath = Tools::CacheFile::partPath( job.outputPath );
+    auto success = false;
+    try
+    {
+        auto& profile = Backend::instance()->profile();
+        // Not shared with anyone else, the filter is only attached for the analysis
+        std::unique_ptr<Backend::IInput> input( new Backend::MLT::MLTInput( profile,
+                                                                            qPrintable( job.filePath ) ) );
+        if ( job.onProxy == false )
+            input = input->cloneOriginals();
+        auto cut = input->cut( job.begin, job.end );
+        Backend::MLT::MLTFilter filter( profile, FilterId );
+        // Without results, the filter analyzes the frames it gets, and writes the
+        // transforms once it got the last one
+        filter.properties()->set( "filename", qPrintable( partPath ) );
+        cut->attach( filter );
+
+        auto length = cut->playableLength();
+        qint64 pos = 0;
+        for ( ; pos < length && token.isCanceled() == false; ++pos )
+        {
+            cut->setPosition( pos );
+            if ( cut->image( profile.width(), profile.height(),
+                             Backend::IVideoFrame::YUV420P ) == nullptr )
+                break;
+        }
+        cut->detach( filter );
+        success = pos == length && QFile::exists( partPath ) == true;
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Can't analyze the motion of" << job.filePath;
+    }
+
+    if ( success == true )
+        success = Tools::CacheFile::publish( partPath, job.outputPath );
+    if ( success == false )
+        QFile::remove( partPath );
+    {
+        QMutexLocker    lock( &m_mutex );
+        m_pending.remove( job.outputPath );
+    }
+    if ( token.isCanceled() == false )
+        emit analyzed( job.filePath, job.begin, job.end, success );
+}
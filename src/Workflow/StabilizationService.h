@@ -0,0 +1,104 @@
+/*****************************************************************************
+ * StabilizationService.h: Caches the motion analysis of the stabilization
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef STABILIZATIONSERVICE_H
+#define STABILIZATIONSERVICE_H
+
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+#include "Tools/JobScheduler.h"
+
+/**
+ *  \brief  Runs the motion analysis of the stabilization once per clip, in the background.
+ *
+ *  The vidstab filter needs a first pass over the frames, which it would otherwise run
+ *  while the clip plays. The analysis is done from the job scheduler instead, one job
+ *  per clip, and the transforms are stored in the cache directory, keyed by the
+ *  media content hash and the analyzed range. The filter then reads them back, both
+ *  when previewing and exporting. \sa MainWorkflow::stabilizeClip()
+ */
+class StabilizationService : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static const QString    SubDirectory;
+        // The identifier of the MLT filter which analyzes and applies the transforms
+        static const char*      FilterId;
+
+        explicit StabilizationService( Tools::JobScheduler* scheduler, QObject* parent = nullptr );
+        ~StabilizationService();
+
+        /**
+         *  \brief  Sets the cache directory. An empty path disables the stabilization.
+         */
+        void                    setDirectory( const QString& cacheDir );
+        /**
+         *  \brief  Analyzes filePath between begin and end, unless it was analyzed already.
+         *
+         *  analyzed() is emitted once done, right away if the transforms exist already.
+         *  \param onProxy  Analyzes the proxy of the media, if it has one. The frames are
+         *                  scaled to the profile size before the analysis, so the transforms
+         *                  still apply to the original, with less precision.
+         *  \returns    false if there's no cache directory to store the transforms in.
+         */
+        bool                    request( const QString& filePath, qint64 begin, qint64 end,
+                                         bool onProxy );
+        /**
+         *  \returns    The transforms of the range, or an empty string if it isn't analyzed.
+         */
+        QString                 transformsPath( const QString& filePath, qint64 begin, qint64 end ) const;
+
+    private:
+        struct Job
+        {
+            QString     filePath;
+            qint64      begin;
+            qint64      end;
+            bool        onProxy;
+            QString     outputPath;
+        };
+
+        QString                 outputPath( const QString& filePath, qint64 begin, qint64 end ) const;
+        // Called from the scheduler threads
+        void                    analyze( const Job& job, const Tools::JobScheduler::CancellationToken& token );
+
+    private:
+        Tools::JobScheduler*                    m_scheduler;
+        Tools::JobScheduler::CancellationToken  m_token;
+        mutable QMutex                          m_mutex;
+        QString                                 m_directory;
+        // The output paths of the queued and running analysis
+        QSet<QString>                           m_pending;
+
+    signals:
+        /**
+         *  \brief  Emitted once a range was analyzed, or failed to be, from a worker thread.
+         */
+        void                    analyzed( const QString& filePath, qint64 begin, qint64 end,
+                                          bool success );
+};
+
+#endif // STABILIZATIONSERVICE_H
@@ -0,0 +1,281 @@
+/*****************************************************************************
+ * StemExport.cpp: Renders the audio of a sequence to a file per group of tracks
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "StemExport.h"
+
+#include "Backend/IInput.h"
+#include "Backend/MLT/MLTAudioMixer.h"
+#include "Backend/MLT/MLTOutput.h"
+#include "Backend/MLT/MLTService.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStringList>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    // RIFF, fmt with an empty extension, fact, and the data chunk header
+    const quint32   HeaderSize = 12 + 8 + 18 + 8 + 4 + 8;
+    const quint16   WaveFormatFloat = 3;
+}
+
+// A 32 bits float WAV file, which only replaces its target once committed
+class WavFile
+{
+    public:
+        WavFile( const QString& fileName, quint32 sampleRate, quint32 nbChannels )
+            : m_file( fileName )
+            , m_sampleRate( sampleRate )
+            , m_nbChannels( nbChannels )
+            , m_dataSize( 0 )
+        {
+        }
+
+        bool open()
+        {
+            if ( m_file.open( QIODevice::WriteOnly ) == false )
+                return false;
+            // Completed once the size is known
+            return m_file.write( header() ) == HeaderSize;
+        }
+
+        // Writes silence when samples is nullptr
+        bool write( const float* samples, quint32 count )
+        {
+            auto size = count * sizeof( float );
+            if ( m_dataSize + size > std::numeric_limits<quint32>::max() - HeaderSize )
+                return false;
+            m_buffer.resize( size );
+            auto out = reinterpret_cast<uchar*>( m_buffer.data() );
+            if ( samples == nullptr )
+                std::fill( out, out + size, 0 );
+            else
+            {
+                for ( quint32 i = 0; i < count; ++i )
+                {
+                    quint32 bits;
+                    memcpy( &bits, samples + i, sizeof( bits ) );
+                    qToLittleEndian<quint32>( bits, out + i * sizeof( bits ) );
+                }
+            }
+            if ( m_file.write( m_buffer ) != (qint64)size )
+                return false;
+            m_dataSize += size;
+            return true;
+        }
+
+        bool commit()
+        {
+            return m_file.seek( 0 ) == true && m_file.write( header() ) == HeaderSize &&
+                    m_file.commit() == true;
+        }
+
+        QString fileName() const
+        {
+            return m_file.fileName();
+        }
+
+    private:
+        QByteArray header() const
+        {
+            QByteArray  h;
+            auto put = [&h]( quint32 value, int size ) {
+                uchar   bytes[4];
+                qToLittleEndian<quint32>( value, bytes );
+                h.append( reinterpret_cast<const char*>( bytes ), size );
+            };
+            auto frameSize = m_nbChannels * (quint32)sizeof( float );
+            h.append( "RIFF" );
+            put( HeaderSize - 8 + m_dataSize, 4 );
+            h.append( "WAVEfmt " );
+            put( 18, 4 );
+            put( WaveFormatFloat, 2 );
+            put( m_nbChannels, 2 );
+            put( m_sampleRate, 4 );
+            put( m_sampleRate * frameSize, 4 );
+            put( frameSize, 2 );
+            put( 32, 2 );
+            put( 0, 2 );
+            // Required for the formats other than integer PCM
+            h.append( "fact" );
+            put( 4, 4 );
+            put( m_dataSize / frameSize, 4 );
+            h.append( "data" );
+            put( m_dataSize, 4 );
+            return h;
+        }
+
+    private:
+        QSaveFile   m_file;
+        quint32     m_sampleRate;
+        quint32     m_nbChannels;
+        quint32     m_dataSize;
+        QByteArray  m_buffer;
+};
+
+StemExport::StemExport( Backend::IInput& input, const RenderParameters& params, qint64 begin, qint64 end )
+    : m_source( input )
+    , m_params( params )
+    , m_outputCallback( nullptr )
+    , m_inputCallback( nullptr )
+    , m_begin( begin )
+    , m_end( end )
+    , m_failed( false )
+    , m_stopping( false )
+{
+}
+
+StemExport::~StemExport()
+{
+    stop();
+    // The files which weren't committed are discarded along with them
+    m_output.reset();
+}
+
+void
+StemExport::setCallbacks( Backend::IOutputEventCb* output, Backend::IInputEventCb* input )
+{
+    m_outputCallback = output;
+    m_inputCallback = input;
+}
+
+bool
+StemExport::start()
+{
+    if ( m_params.stems.isEmpty() == true || m_end <= m_begin )
+        return false;
+    QStringList fileNames{ m_params.outputFileName };
+    // The stem of each track, the last one listing it wins
+    std::vector<int>    trackStems;
+    for ( int s = 0; s < m_params.stems.size(); ++s )
+    {
+        fileNames << m_params.stems[s].outputFileName;
+        for ( auto track : m_params.stems[s].tracks )
+        {
+            if ( track >= trackStems.size() )
+                trackStems.resize( track + 1, -1 );
+            trackStems[track] = s;
+        }
+    }
+    for ( const auto& fileName : fileNames )
+    {
+        std::unique_ptr<WavFile>    file( new WavFile( fileName, m_params.sampleRate, m_params.nbChannels ) );
+        if ( QDir().mkpath( QFileInfo( fileName ).absolutePath() ) == false || file->open() == false )
+        {
+            vlmcWarning() << "Can't write the stem" << fileName;
+            m_files.clear();
+            return false;
+        }
+        m_files.push_back( std::move( file ) );
+    }
+
+    try
+    {
+        m_input = m_source.clone();
+        m_input->setBoundaries( m_begin, m_end - 1 );
+        m_output.reset( new Backend::MLT::MLTNullOutput );
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Failed to set up the rendering of the stems";
+        m_input.reset();
+        m_output.reset();
+        return false;
+    }
+    if ( Backend::MLT::MLTAudioMixer::setStems( *m_input, trackStems ) == false )
+    {
+        vlmcWarning() << "The sequence has no mixer to render the stems with";
+        return false;
+    }
+    if ( m_inputCallback != nullptr )
+        m_input->setCallback( m_inputCallback );
+    if ( m_outputCallback != nullptr )
+        m_output->setCallback( m_outputCallback );
+    m_output->setAudioCallback( this, m_params.sampleRate, m_params.nbChannels );
+    if ( m_output->connect( *m_input ) == false )
+        return false;
+    m_input->setPosition( 0 );
+    m_output->start();
+    return true;
+}
+
+void
+StemExport::stop()
+{
+    m_stopping = true;
+    if ( m_output != nullptr )
+        m_output->stop();
+}
+
+bool
+StemExport::finish( bool success )
+{
+    // Nothing gets written anymore
+    m_output.reset();
+    m_input.reset();
+    success = success == true && m_failed == false && m_files.empty() == false;
+    for ( auto& file : m_files )
+    {
+        if ( success == true && file->commit() == false )
+        {
+            vlmcWarning() << "Failed to complete the stem" << file->fileName();
+            success = false;
+        }
+    }
+    m_files.clear();
+    return success;
+}
+
+bool
+StemExport::hasFailed() const
+{
+    return m_failed;
+}
+
+void
+StemExport::onAudio( int64_t, const float* master, const float* stems, uint32_t nbStems,
+                     uint32_t nbSamples, uint32_t nbChannels )
+{
+    if ( m_stopping == true || m_failed == true )
+        return;
+    // A frame which couldn't be rendered is left silent, to keep the files in sync
+    auto count = nbSamples * nbChannels;
+    for ( size_t i = 0; i < m_files.size(); ++i )
+    {
+        auto samples = master;
+        if ( i > 0 )
+            samples = stems != nullptr && i <= nbStems ? stems + ( i - 1 ) * count : nullptr;
+        if ( m_files[i]->write( samples, count ) == false )
+        {
+            vlmcWarning() << "Failed to write the stem" << m_files[i]->fileName();
+            m_failed = true;
+            return;
+        }
+    }
+}
@@ -0,0 +1,100 @@
+/*****************************************************************************
+ * StemExport.h: Renders the audio of a sequence to a file per group of tracks
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef STEMEXPORT_H
+#define STEMEXPORT_H
+
+#include <QString>
+
+#include "Backend/IOutput.h"
+#include "RenderJob.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace Backend
+{
+class IInput;
+class IInputEventCb;
+namespace MLT
+{
+class MLTNullOutput;
+}
+}
+
+class WavFile;
+
+/**
+ *  \brief  Renders the audio of a sequence once, to the master mix and to a file per
+ *          stem, a group of tracks.
+ *
+ *  The mixer sums the tracks of each stem along with the master, so the stems add up
+ *  to it, before the sequence's own effects. No image is rendered, so no video gets
+ *  decoded. The files are 32 bits float WAV, each written to a temporary name and
+ *  renamed once complete.
+ *  \sa Backend::MLT::MLTAudioMixer::setStems()
+ */
+class StemExport : private Backend::IOutputAudioCb
+{
+    public:
+        /**
+         *  \param  begin, end  The frames of input to export, end excluded.
+         */
+        StemExport( Backend::IInput& input, const RenderParameters& params, qint64 begin, qint64 end );
+        ~StemExport();
+
+        void                    setCallbacks( Backend::IOutputEventCb* output,
+                                              Backend::IInputEventCb* input );
+        bool                    start();
+        void                    stop();
+        /**
+         *  \brief  Completes the files once the output stopped, or removes them if the
+         *          export failed.
+         *  \returns    Whether every file got written.
+         */
+        bool                    finish( bool success );
+        // Whether a file couldn't be written. The export should then be stopped.
+        bool                    hasFailed() const;
+
+    private:
+        virtual void            onAudio( int64_t position, const float* master, const float* stems,
+                                         uint32_t nbStems, uint32_t nbSamples,
+                                         uint32_t nbChannels ) override;
+
+    private:
+        Backend::IInput&                                m_source;
+        std::unique_ptr<Backend::IInput>                m_input;
+        std::unique_ptr<Backend::MLT::MLTNullOutput>    m_output;
+        RenderParameters                                m_params;
+        Backend::IOutputEventCb*                        m_outputCallback;
+        Backend::IInputEventCb*                         m_inputCallback;
+        qint64                                          m_begin;
+        qint64                                          m_end;
+        // The master first, then one per stem
+        std::vector<std::unique_ptr<WavFile>>           m_files;
+        std::atomic_bool                                m_failed;
+        // Accessed from the output thread
+        std::atomic_bool                                m_stopping;
+};
+
+#endif // STEMEXPORT_H
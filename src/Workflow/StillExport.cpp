@@ -0,0 +1,156 @@
+/*****************************************************************************
+ * StillExport.cpp: Renders single frames of a sequence to images
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "StillExport.h"
+
+#include "Backend/IInput.h"
+#include "Backend/MLT/MLTService.h"
+#include "Tools/VideoFrame.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QFileInfo>
+#include <QImage>
+#include <QImageWriter>
+
+#include <algorithm>
+
+StillExport::StillExport( Tools::JobScheduler* scheduler, QObject* parent )
+    : QObject( parent )
+    , m_scheduler( scheduler )
+    , m_batch( false )
+    , m_width( 0 )
+    , m_height( 0 )
+    , m_nbFrames( 0 )
+    , m_nbDone( 0 )
+    , m_nbFailed( 0 )
+{
+}
+
+StillExport::~StillExport()
+{
+    m_scheduler->cancel( m_token );
+    m_scheduler->wait( m_token );
+}
+
+QString
+StillExport::fileName( const QString& fileName, qint64 position )
+{
+    QFileInfo   info( fileName );
+    return info.path() + '/' + info.completeBaseName() + '_' +
+            QString::number( position ).rightJustified( 6, '0' ) + '.' + info.suffix();
+}
+
+bool
+StillExport::start( const Backend::IInput& sequence, QList<qint64> positions,
+                    const QString& fileName, quint32 width, quint32 height )
+{
+    Q_ASSERT( m_workers.empty() == true );
+    auto suffix = QFileInfo( fileName ).suffix().toLower().toLatin1();
+    if ( QImageWriter::supportedImageFormats().contains( suffix ) == false )
+    {
+        vlmcWarning() << "Can't write images to" << fileName;
+        return false;
+    }
+    auto length = sequence.playableLength();
+    positions.erase( std::remove_if( positions.begin(), positions.end(), [length]( qint64 pos ) {
+        return pos < 0 || pos >= length;
+    } ), positions.end() );
+    std::sort( positions.begin(), positions.end() );
+    positions.erase( std::unique( positions.begin(), positions.end() ), positions.end() );
+    if ( positions.isEmpty() == true || width == 0 || height == 0 )
+        return false;
+
+    m_fileName = fileName;
+    m_batch = positions.size() > 1;
+    m_width = width;
+    m_height = height;
+    m_nbFrames = positions.size();
+    // Contiguous runs of frames, so that each copy only ever seeks forward
+    auto nbWorkers = std::min( MaxWorkers, m_nbFrames );
+    try
+    {
+        for ( int i = 0; i < nbWorkers; ++i )
+        {
+            Worker  w;
+            w.input = sequence.clone();
+            auto begin = m_nbFrames * i / nbWorkers;
+            w.positions = positions.mid( begin, m_nbFrames * ( i + 1 ) / nbWorkers - begin );
+            m_workers.push_back( std::move( w ) );
+        }
+    }
+    catch ( Backend::InvalidServiceException& )
+    {
+        vlmcWarning() << "Failed to copy the sequence to export its frames";
+        m_workers.clear();
+        return false;
+    }
+    for ( size_t i = 0; i < m_workers.size(); ++i )
+    {
+        m_scheduler->schedule( Tools::JobScheduler::Interactive,
+                               [this, i]( const Tools::JobScheduler::CancellationToken& token )
+        {
+            render( m_workers[i], token );
+        }, m_token );
+    }
+    return true;
+}
+
+void
+StillExport::render( Worker& worker, const Tools::JobScheduler::CancellationToken& token )
+{
+    auto jpeg = m_fileName.endsWith( ".jpg", Qt::CaseInsensitive ) == true ||
+            m_fileName.endsWith( ".jpeg", Qt::CaseInsensitive ) == true;
+    for ( auto pos : worker.positions )
+    {
+        if ( token.isCanceled() == true )
+            return;
+        auto name = m_batch == true ? fileName( m_fileName, pos ) : m_fileName;
+        worker.input->setPosition( pos );
+        auto image = Tools::toQImage( worker.input->image( m_width, m_height ) );
+        auto success = image.isNull() == false && image.save( name, nullptr, jpeg == true ? Quality : -1 );
+        if ( success == true )
+            worker.fileNames << name;
+        else
+            vlmcWarning() << "Failed to export frame" << pos << "to" << name;
+        QMetaObject::invokeMethod( this, "frameDone", Qt::QueuedConnection, Q_ARG( bool, success ) );
+    }
+}
+
+QStringList
+StillExport::fileNames() const
+{
+    QStringList res;
+    for ( const auto& w : m_workers )
+        res << w.fileNames;
+    return res;
+}
+
+void
+StillExport::frameDone( bool success )
+{
+    ++m_nbDone;
+    if ( success == false )
+        ++m_nbFailed;
+    emit progress( m_nbDone, m_nbFrames );
+    if ( m_nbDone == m_nbFrames )
+        emit finished( m_nbFailed == 0 );
+}
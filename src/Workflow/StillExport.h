@@ -0,0 +1,110 @@
+/*****************************************************************************
+ * StillExport.h: Renders single frames of a sequence to images
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef STILLEXPORT_H
+#define STILLEXPORT_H
+
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include "Tools/JobScheduler.h"
+
+#include <memory>
+#include <vector>
+
+namespace Backend
+{
+class IInput;
+}
+
+/**
+ *  \brief  Renders frames of a sequence to PNG or JPEG files, for thumbnails or a
+ *          storyboard, without going through an export.
+ *
+ *  The frames are rendered from copies of the sequence, so the preview isn't
+ *  disturbed, and encoded from the job threads. A batch is split between up to
+ *  MaxWorkers copies, each one rendering its frames in order.
+ */
+class StillExport : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static const int        MaxWorkers = 4;
+        // Of the JPEG files
+        static const int        Quality = 95;
+
+        explicit StillExport( Tools::JobScheduler* scheduler, QObject* parent = nullptr );
+        // Stops the running jobs, and waits for them
+        ~StillExport();
+
+        /**
+         *  \brief  Starts rendering the frames at positions of sequence, at width x height.
+         *
+         *  sequence is copied from the calling thread, which must be the GUI one. The
+         *  format follows the suffix of fileName. With several positions, each image is
+         *  named after its frame. \sa fileName()
+         *  \returns    false if the format isn't supported, or there is no frame to render.
+         */
+        bool                    start( const Backend::IInput& sequence, QList<qint64> positions,
+                                       const QString& fileName, quint32 width, quint32 height );
+        // The files written, once finished() was emitted
+        QStringList             fileNames() const;
+        // "shot.png" gives "shot_000120.png" for the frame 120
+        static QString          fileName( const QString& fileName, qint64 position );
+
+    private:
+        struct Worker
+        {
+            std::unique_ptr<Backend::IInput>    input;
+            QList<qint64>                       positions;
+            QStringList                         fileNames;
+        };
+
+        // Run from a scheduler thread
+        void                    render( Worker& worker, const Tools::JobScheduler::CancellationToken& token );
+
+    private:
+        Tools::JobScheduler*    m_scheduler;
+        Tools::JobScheduler::CancellationToken  m_token;
+        // Not resized once the jobs are started: each one renders its own copy
+        std::vector<Worker>     m_workers;
+        QString                 m_fileName;
+        bool                    m_batch;
+        quint32                 m_width;
+        quint32                 m_height;
+        int                     m_nbFrames;
+        int                     m_nbDone;
+        int                     m_nbFailed;
+
+    private slots:
+        void                    frameDone( bool success );
+
+    signals:
+        void                    progress( int done, int total );
+        // Emitted once every frame was handled, success is false if any failed
+        void                    finished( bool success );
+};
+
+#endif // STILLEXPORT_H
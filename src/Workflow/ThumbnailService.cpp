@@ -0,0 +1,146 @@
+/*****************************************************************************
+ * ThumbnailService.cpp: Bounded pool of thumbnail workers
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ThumbnailService.h"
+#include "ThumbnailWorker.h"
+#include "Tools/Metrics.h"
+
+#include <algorithm>
+
+ThumbnailService::ThumbnailService( Tools::JobScheduler* scheduler, QObject* parent )
+    : QObject( parent )
+    , m_scheduler( scheduler )
+{
+}
+
+ThumbnailService::~ThumbnailService()
+{
+    cancelAll();
+    m_scheduler->cancel( m_token );
+    m_scheduler->wait( m_token );
+}
+
+QString
+ThumbnailService::key( const QString& uuid, const QVector<qint64>& positions )
+{
+    auto k = uuid;
+    for ( auto pos : positions )
+        k += '/' + QString::number( pos );
+    return k;
+}
+
+Tools::JobScheduler::Priority
+ThumbnailService::jobPriority( Priority priority )
+{
+    return priority == High ? Tools::JobScheduler::Visible : Tools::JobScheduler::Background;
+}
+
+void
+ThumbnailService::request( const QString& uuid, const QString& filePath, qint64 pos,
+                           quint32 width, quint32 height, Priority priority )
+{
+    request( uuid, filePath, QVector<qint64>{ pos }, width, height, priority );
+}
+
+void
+ThumbnailService::request( const QString& uuid, const QString& filePath,
+                           QVector<qint64> positions, quint32 width, quint32 height,
+                           Priority priority )
+{
+    if ( positions.isEmpty() == true )
+        return;
+    std::sort( positions.begin(), positions.end() );
+
+    QMutexLocker    lock( &m_mutex );
+
+    auto k = key( uuid, positions );
+    if ( m_running.contains( k ) == true )
+        return;
+
+    auto it = m_pending.find( k );
+    if ( it != m_pending.end() )
+    {
+        if ( it->priority < priority )
+        {
+            it->priority = priority;
+            m_scheduler->setPriority( it->job, jobPriority( priority ) );
+        }
+        return;
+    }
+
+    auto job = m_scheduler->schedule( jobPriority( priority ),
+                                      [this, k]( const Tools::JobScheduler::CancellationToken& token )
+    {
+        Request req;
+        if ( take( k, req ) == false )
+            return;
+        ThumbnailWorker( this ).run( req, token );
+        finished( req );
+    }, m_token );
+    m_pending.insert( k, Pending{ Request{ uuid, filePath, positions, width, height }, priority, job } );
+    Tools::Metrics::gauge( "thumbnails.queued" ).set( m_pending.size() );
+}
+
+void
+ThumbnailService::cancelAll()
+{
+    QMutexLocker    lock( &m_mutex );
+    // Their jobs find nothing left to do once they run
+    m_pending.clear();
+    Tools::Metrics::gauge( "thumbnails.queued" ).set( 0 );
+}
+
+ThumbnailStore&
+ThumbnailService::store()
+{
+    return m_store;
+}
+
+bool
+ThumbnailService::take( const QString& key, Request& request )
+{
+    QMutexLocker    lock( &m_mutex );
+    auto it = m_pending.find( key );
+    if ( it == m_pending.end() )
+        return false;
+    request = it->request;
+    m_pending.erase( it );
+    m_running.insert( key );
+    Tools::Metrics::gauge( "thumbnails.queued" ).set( m_pending.size() );
+    return true;
+}
+
+void
+ThumbnailService::done( const Request& request, qint64 pos, const QImage& image )
+{
+    if ( image.isNull() == false )
+        emit thumbnailReady( request.uuid, pos, image );
+    else
+        emit thumbnailFailed( request.uuid, pos );
+}
+
+void
+ThumbnailService::finished( const Request& request )
+{
+    QMutexLocker    lock( &m_mutex );
+    m_running.remove( key( request.uuid, request.positions ) );
+}
@@ -0,0 +1,129 @@
+/*****************************************************************************
+ * ThumbnailService.h: Bounded pool of thumbnail workers
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef THUMBNAILSERVICE_H
+#define THUMBNAILSERVICE_H
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+#include "ThumbnailStore.h"
+#include "Tools/JobScheduler.h"
+
+class ThumbnailWorker;
+
+/**
+ *  \brief  Queues thumbnail requests and serves them from the job scheduler.
+ *
+ *  Requests are de-duplicated by (uuid, positions): asking again for a thumbnail which
+ *  is already queued only bumps its priority, and asking for one which is being decoded
+ *  is a no-op.
+ *  A request may contain several positions, which are then decoded in a single forward
+ *  pass through the same input.
+ *  High priority requests (clips visible in the timeline) are always served first: they
+ *  run as Visible jobs, the others as Background ones.
+ */
+class ThumbnailService : public QObject
+{
+    Q_OBJECT
+
+    public:
+        enum Priority
+        {
+            Low,
+            High,
+            NbPriority
+        };
+
+        struct Request
+        {
+            // Identifies the requester's object: a clip uuid, a media path...
+            QString     uuid;
+            QString     filePath;
+            // Sorted in ascending order
+            QVector<qint64> positions;
+            quint32     width;
+            quint32     height;
+        };
+
+        explicit ThumbnailService( Tools::JobScheduler* scheduler, QObject* parent = nullptr );
+        ~ThumbnailService();
+
+        void                    request( const QString& uuid, const QString& filePath,
+                                         qint64 pos, quint32 width, quint32 height,
+                                         Priority priority );
+        /**
+         *  \brief  Queue several thumbnails of the same file, as a single job.
+         */
+        void                    request( const QString& uuid, const QString& filePath,
+                                         QVector<qint64> positions, quint32 width, quint32 height,
+                                         Priority priority );
+        /**
+         *  \brief  Drop every queued request. Running ones are left to complete.
+         */
+        void                    cancelAll();
+
+        ThumbnailStore&         store();
+
+    private:
+        static QString          key( const QString& uuid, const QVector<qint64>& positions );
+        static Tools::JobScheduler::Priority    jobPriority( Priority priority );
+        /**
+         *  \brief  Takes the request to process.
+         *
+         *  Called from the scheduler threads. Returns false if it was cancelled since.
+         */
+        bool                    take( const QString& key, Request& request );
+        void                    done( const Request& request, qint64 pos, const QImage& image );
+        void                    finished( const Request& request );
+
+    private:
+        struct Pending
+        {
+            Request                     request;
+            Priority                    priority;
+            Tools::JobScheduler::JobId  job;
+        };
+
+        Tools::JobScheduler*        m_scheduler;
+        Tools::JobScheduler::CancellationToken  m_token;
+        ThumbnailStore              m_store;
+        QMutex                      m_mutex;
+        QHash<QString, Pending>     m_pending;
+        QSet<QString>               m_running;
+
+        friend class ThumbnailWorker;
+
+    signals:
+        /**
+         *  \brief  Emitted from a worker thread once a thumbnail has been decoded.
+         */
+        void                    thumbnailReady( const QString& uuid, qint64 pos, const QImage& image );
+        // Emitted from a worker thread when the thumbnail couldn't be decoded
+        void                    thumbnailFailed( const QString& uuid, qint64 pos );
+};
+
+#endif // THUMBNAILSERVICE_H
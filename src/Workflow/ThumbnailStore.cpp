@@ -0,0 +1,148 @@
+/*****************************************************************************
+ * ThumbnailStore.cpp: Persistent thumbnail cache
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ThumbnailStore.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IProfile.h"
+#include "Tools/FileHash.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <cstring>
+
+const QString   ThumbnailStore::SubDirectory = ".thumbnails";
+
+namespace
+{
+    const char          Magic[4] = { 'V', 'T', 'H', 'B' };
+    const quint32       Version = 1;
+
+    struct Header
+    {
+        char        magic[4];
+        quint32     version;
+        quint32     width;
+        quint32     height;
+    };
+}
+
+ThumbnailStore::ThumbnailStore()
+{
+}
+
+void
+ThumbnailStore::setDirectory( const QString& cacheDir )
+{
+    QMutexLocker    lock( &m_mutex );
+    if ( cacheDir.isEmpty() == true )
+        m_directory.clear();
+    else
+        m_directory = cacheDir + '/' + SubDirectory;
+}
+
+QImage
+ThumbnailStore::load( const QString& filePath, qint64 pos, quint32 width, quint32 height )
+{
+    auto path = thumbnailPath( filePath, pos, width, height );
+    if ( path.isEmpty() == true )
+        return QImage();
+
+    auto file = new QFile( path );
+    if ( file->open( QFile::ReadOnly ) == false || file->size() < (qint64)sizeof( Header ) )
+    {
+        delete file;
+        return QImage();
+    }
+    auto data = file->map( 0, file->size() );
+    if ( data == nullptr )
+    {
+        delete file;
+        return QImage();
+    }
+    // The decoder may not have honored the requested size, so trust the header
+    auto header = reinterpret_cast<const Header*>( data );
+    if ( memcmp( header->magic, Magic, sizeof( Magic ) ) != 0 || header->version != Version ||
+         file->size() != (qint64)sizeof( Header ) + (qint64)header->width * header->height * 4 )
+    {
+        delete file;
+        return QImage();
+    }
+    // The mapping is released along with the file, once the last copy of the image is gone
+    return QImage( data + sizeof( Header ), header->width, header->height, header->width * 4,
+                   QImage::Format_RGBA8888,
+                   []( void* file ) { delete static_cast<QFile*>( file ); }, file );
+}
+
+bool
+ThumbnailStore::save( const QString& filePath, qint64 pos, quint32 width, quint32 height,
+                      const QImage& image )
+{
+    auto path = thumbnailPath( filePath, pos, width, height );
+    if ( path.isEmpty() == true )
+        return false;
+    if ( QDir().mkpath( QFileInfo( path ).absolutePath() ) == false )
+        return false;
+
+    auto rgba = image.convertToFormat( QImage::Format_RGBA8888 );
+    Header header;
+    memcpy( header.magic, Magic, sizeof( Magic ) );
+    header.version = Version;
+    header.width = rgba.width();
+    header.height = rgba.height();
+
+    QSaveFile file( path );
+    if ( file.open( QFile::WriteOnly ) == false )
+        return false;
+    file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    for ( int y = 0; y < rgba.height(); ++y )
+        file.write( reinterpret_cast<const char*>( rgba.constScanLine( y ) ), rgba.width() * 4 );
+    if ( file.commit() == false )
+    {
+        vlmcWarning() << "Failed to save thumbnail to" << path;
+        return false;
+    }
+    return true;
+}
+
+QString
+ThumbnailStore::thumbnailPath( const QString& filePath, qint64 pos, quint32 width, quint32 height )
+{
+    QString directory;
+    {
+        QMutexLocker    lock( &m_mutex );
+        directory = m_directory;
+    }
+    if ( directory.isEmpty() == true )
+        return QString();
+    auto hash = Tools::contentHash( filePath );
+    if ( hash.isEmpty() == true )
+        return QString();
+    // Positions are frame numbers, in the project frame rate
+    return QString( "%1/%2/%3-%4x%5-%6.thumb" ).arg( directory, QString::fromLatin1( hash ) )
+            .arg( pos ).arg( width ).arg( height )
+            .arg( QString::number( Backend::instance()->profile().fps(), 'g', 8 ) );
+}
@@ -0,0 +1,70 @@
+/*****************************************************************************
+ * ThumbnailStore.h: Persistent thumbnail cache
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef THUMBNAILSTORE_H
+#define THUMBNAILSTORE_H
+
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+/**
+ *  \brief  On-disk thumbnail cache, living in the cache directory.
+ *
+ *  Thumbnails are keyed by the media content hash rather than its path or the clip
+ *  uuid, so they survive restarts, file moves, and are shared between projects.
+ *  Each thumbnail is stored as raw RGBA, and memory-mapped back when loaded.
+ *  All methods are thread safe.
+ */
+class ThumbnailStore
+{
+    public:
+        static const QString    SubDirectory;
+
+        ThumbnailStore();
+
+        /**
+         *  \brief  Sets the cache directory. An empty path disables the store.
+         */
+        void                    setDirectory( const QString& cacheDir );
+
+        /**
+         *  \returns    The cached thumbnail, or a null image if there is none.
+         */
+        QImage                  load( const QString& filePath, qint64 pos,
+                                      quint32 width, quint32 height );
+        /**
+         *  \brief  Stores image as the thumbnail requested for the given width & height
+         */
+        bool                    save( const QString& filePath, qint64 pos, quint32 width,
+                                      quint32 height, const QImage& image );
+
+    private:
+        QString                 thumbnailPath( const QString& filePath, qint64 pos,
+                                               quint32 width, quint32 height );
+
+    private:
+        QMutex                      m_mutex;
+        QString                     m_directory;
+};
+
+#endif // THUMBNAILSTORE_H
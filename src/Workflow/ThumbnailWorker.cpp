@@ -1,32 +1,76 @@
 #include "ThumbnailWorker.h"
+#include "ThumbnailService.h"
+#include "FrameIndexService.h"
 
-#include <QPixmap>
-#include <QUuid>
+#include <QImage>
 
-#include "Backend/MLT/MLTInput.h"
+#include "Backend/IBackend.h"
+#include "Backend/IInput.h"
+#include "Backend/IProfile.h"
+#include "Backend/MLT/MLTService.h"
+#include "Main/Core.h"
+#include "Tools/FrameIndex.h"
+#include "Tools/MediaIO.h"
+#include "Tools/VideoFrame.h"
 
-ThumbnailWorker::ThumbnailWorker( const QString& uuid, const QString& filePath,
-                                  qint64 pos, quint32 width, quint32 height, QObject* parent )
-    : QObject( parent )
-    , m_uuid( uuid )
-    , m_filePath( filePath )
-    , m_pos( pos )
-    , m_width( width )
-    , m_height( height )
+namespace
 {
+    // Decoding up to this many frames after a keyframe is cheap enough for a thumbnail
+    const int64_t   MaxExactDecode = 12;
+}
 
+ThumbnailWorker::ThumbnailWorker( ThumbnailService* service )
+    : m_service( service )
+{
 }
 
 void
-ThumbnailWorker::run()
+ThumbnailWorker::run( const ThumbnailService::Request& req,
+                      const Tools::JobScheduler::CancellationToken& token )
 {
-    Backend::MLT::MLTInput input( qPrintable( m_filePath ) );
-    input.setPosition( m_pos );
-    auto image = input.image( m_width, m_height );
-    QImage qImg( image, m_width, m_height,
-                QImage::Format_RGBA8888, []( void* buf ){ delete[] (uchar*) buf; } );
-    auto qPix = QPixmap::fromImage( qImg );
-
-    // Use Qt::DirectConnection or the pixmap will be deleted!
-    emit imageReady( m_uuid, m_pos, qPix );
+    // Only open a decoder if one of the positions isn't in the store already.
+    // Positions are sorted, so the input is only ever moving forward.
+    std::shared_ptr<Backend::IInput>    input;
+    // A proxy is decoded instead of the indexed file, and it only has keyframes
+    std::shared_ptr<const Tools::FrameIndex>    index;
+    // Once the file can't be opened, the remaining positions are reported as failed
+    bool                                        failed = false;
+    if ( Backend::instance()->proxies().count( req.filePath.toStdString() ) == 0 )
+        index = Core::instance()->frameIndexService()->index( req.filePath );
+    for ( auto pos : req.positions )
+    {
+        if ( token.isCanceled() == true )
+            break;
+        auto qImg = m_service->store().load( req.filePath, pos, req.width, req.height );
+        if ( qImg.isNull() == true && failed == false )
+        {
+            try
+            {
+                Tools::MediaIO::Timer   timer( req.filePath, input == nullptr ? Tools::MediaIO::Open
+                                                                           : Tools::MediaIO::Seek );
+                // With an index, the thumbnail is either exact, or the keyframe shown
+                // before pos, which decodes right away. Without one, the frames up to pos
+                // are decoded without their in-loop filters.
+                if ( input == nullptr )
+                    input = Backend::instance()->acquireInput( qPrintable( req.filePath ),
+                                                               index != nullptr ? Backend::IInput::Exact
+                                                                                : Backend::IInput::Fast );
+                if ( index != nullptr )
+                {
+                    auto seek = index->seek( pos, Backend::instance()->profile().fps() );
+                    input->setPosition( seek.nbFrames <= MaxExactDecode ? pos : seek.keyframe );
+                }
+                else
+                    input->setPosition( pos );
+                qImg = Tools::toQImage( input->image( req.width, req.height ) );
+            }
+            catch ( Backend::InvalidServiceException& )
+            {
+                failed = true;
+            }
+            if ( qImg.isNull() == false )
+                m_service->store().save( req.filePath, pos, req.width, req.height, qImg );
+        }
+        m_service->done( req, pos, qImg );
+    }
 }
@@ -1,29 +1,21 @@
 #ifndef THUMBNAILWORKER_H
 #define THUMBNAILWORKER_H
 
-#include <QObject>
+#include "ThumbnailService.h"
 
-class QPixmap;
-
-class ThumbnailWorker : public QObject
+/**
+ *  \brief  Decodes the thumbnails of a request, from a scheduler job.
+ */
+class ThumbnailWorker
 {
-    Q_OBJECT
 public:
-    explicit ThumbnailWorker( const QString& uuid, const QString& filePath,
-                              qint64 pos, quint32 width, quint32 height , QObject* parent = 0 );
-
-signals:
-    void    imageReady( const QString& uuid, qint64 pos, const QPixmap& pixmap );
+    explicit ThumbnailWorker( ThumbnailService* service );
 
-public slots:
-    void    run();
+    void    run( const ThumbnailService::Request& req,
+                 const Tools::JobScheduler::CancellationToken& token );
 
 private:
-    QString     m_uuid;
-    QString     m_filePath;
-    qint64      m_pos;
-    quint32     m_width;
-    quint32     m_height;
+    ThumbnailService*   m_service;
 };
 
 #endif // THUMBNAILWORKER_H
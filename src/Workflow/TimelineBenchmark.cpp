@@ -0,0 +1,222 @@
+/*****************************************************************************
+ * TimelineBenchmark.cpp: Times the preview and export of generated timelines
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "TimelineBenchmark.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IFilter.h"
+#include "Backend/MLT/MLTFilter.h"
+#include "Backend/MLT/MLTInput.h"
+#include "Backend/MLT/MLTOutput.h"
+#include "Main/Core.h"
+#include "Media/Clip.h"
+#include "Media/Media.h"
+#include "RenderJob.h"
+#include "RenderQueue.h"
+#include "SequenceWorkflow.h"
+#include "Tools/Metrics.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTemporaryDir>
+
+#include <chrono>
+#include <thread>
+
+TimelineBenchmark::TimelineBenchmark( const Config& config )
+    : m_config( config )
+{
+    m_config.tracks = qMax( 1u, m_config.tracks );
+    m_config.clipsPerTrack = qMax( 1u, m_config.clipsPerTrack );
+    m_config.clipLength = qMax( 1u, m_config.clipLength );
+    m_config.frames = qMax( 1u, m_config.frames );
+}
+
+TimelineBenchmark::~TimelineBenchmark()
+{
+}
+
+QJsonObject
+TimelineBenchmark::run()
+{
+    QJsonObject results;
+    build( results );
+    measurePreview( results );
+    if ( m_config.exportRender == true )
+        measureExport( results );
+    return results;
+}
+
+void
+TimelineBenchmark::build( QJsonObject& results )
+{
+    m_sequence.reset( new SequenceWorkflow );
+
+    QElapsedTimer timer;
+    timer.start();
+    for ( quint32 track = 0; track < m_config.tracks; ++track )
+    {
+        for ( quint32 i = 0; i < m_config.clipsPerTrack; ++i )
+        {
+            // Noise costs about as much as decoding a video, the colors next to nothing
+            auto input = ( i % 2 ) == 0 ?
+                        Backend::MLT::MLTInput::generator( "noise", nullptr, m_config.clipLength ) :
+                        Backend::MLT::MLTInput::generator( "color", "#336699", m_config.clipLength );
+            m_medias.emplace_back( new Media( QString( "generated-%1-%2" ).arg( track ).arg( i ),
+                                              std::move( input ) ) );
+            auto clip = std::make_shared<Clip>( m_medias.back().get(), 0, m_config.clipLength - 1 );
+            for ( quint32 e = 0; e < m_config.effectsPerClip; ++e )
+            {
+                try
+                {
+                    m_filters.emplace_back( new Backend::MLT::MLTFilter( qPrintable( m_config.effect ) ) );
+                }
+                catch ( Backend::InvalidServiceException& )
+                {
+                    vlmcWarning() << "Can't create filter" << m_config.effect << ", no effect is applied";
+                    m_config.effectsPerClip = 0;
+                    break;
+                }
+                clip->input()->attach( *m_filters.back() );
+            }
+            // Video tracks overlap, so every track is composited
+            m_sequence->addClip( clip, track, i * m_config.clipLength );
+        }
+    }
+    results["build.ms"] = timer.nsecsElapsed() / 1e6;
+    results["clips"] = (qint64)m_medias.size();
+}
+
+void
+TimelineBenchmark::measurePreview( QJsonObject& results )
+{
+    // A single render thread, so that a frame's time is its cost alone
+    auto input = m_sequence->input();
+    input->setBoundaries( 0, m_config.frames - 1 );
+    Tools::Metrics::reset( "benchmark." );
+    Backend::MLT::MLTNullOutput output( 1 );
+    output.setSize( m_config.width, m_config.height );
+    output.connect( *input );
+
+    QElapsedTimer timer;
+    timer.start();
+    output.start();
+    while ( output.isStopped() == false )
+        std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+    auto elapsed = timer.nsecsElapsed() / 1e6;
+
+    const auto& frameTime = Tools::Metrics::histogram( "benchmark.frameTime" );
+    results["preview.msPerFrame"] = frameTime.mean() / 1000.;
+    results["preview.p95Ms"] = frameTime.percentile( 0.95 ) / 1000.;
+    results["preview.fps"] = elapsed > 0 ? frameTime.count() * 1000. / elapsed : 0.;
+}
+
+void
+TimelineBenchmark::measureExport( QJsonObject& results )
+{
+    QTemporaryDir   dir;
+    auto& profile = Backend::instance()->profile();
+    RenderParameters params{ dir.filePath( "benchmark.mp4" ), m_config.width, m_config.height,
+                profile.fps(), 16, 9, 8000, 128, 2, 48000, Backend::EncoderOptions() };
+
+    QElapsedTimer   timer;
+    timer.start();
+    auto jobs = Core::instance()->renderQueue()->enqueue( *m_sequence->input(), { params }, 1,
+                                                          0, m_config.frames );
+    if ( jobs.isEmpty() == true )
+    {
+        vlmcWarning() << "Can't export the benchmark timeline";
+        return;
+    }
+    QEventLoop  loop;
+    bool        success = false;
+    QObject::connect( jobs.first(), &RenderJob::finished, &loop, [&loop, &success]( bool s ) {
+        success = s;
+        loop.quit();
+    } );
+    loop.exec();
+    if ( success == false )
+    {
+        vlmcWarning() << "The benchmark export failed";
+        return;
+    }
+    auto elapsed = timer.nsecsElapsed() / 1e6;
+    results["export.ms"] = elapsed;
+    results["export.fps"] = elapsed > 0 ? m_config.frames * 1000. / elapsed : 0.;
+}
+
+QStringList
+TimelineBenchmark::regressions( const QJsonObject& results, const QJsonObject& baseline,
+                                double threshold )
+{
+    QStringList res;
+    for ( auto it = results.begin(); it != results.end(); ++it )
+    {
+        if ( baseline.contains( it.key() ) == false || it.key() == "clips" )
+            continue;
+        auto value = it.value().toDouble();
+        auto reference = baseline[it.key()].toDouble();
+        if ( reference <= 0 )
+            continue;
+        bool higherIsBetter = it.key().endsWith( "fps" );
+        auto change = higherIsBetter == true ? ( reference - value ) / reference
+                                             : ( value - reference ) / reference;
+        if ( change > threshold )
+            res << QString( "%1: %2 instead of %3" ).arg( it.key() ).arg( value ).arg( reference );
+    }
+    return res;
+}
+
+QStringList
+TimelineBenchmark::presets()
+{
+    return QStringList{ "1080p", "4k", "8k" };
+}
+
+bool
+TimelineBenchmark::setPreset( Config& config, const QString& preset )
+{
+    // UHD sizes, as delivered rather than as DCI
+    if ( preset == "1080p" )
+    {
+        config.width = 1920;
+        config.height = 1080;
+    }
+    else if ( preset == "4k" )
+    {
+        config.width = 3840;
+        config.height = 2160;
+    }
+    else if ( preset == "8k" )
+    {
+        config.width = 7680;
+        config.height = 4320;
+    }
+    else
+        return false;
+    return true;
+}
@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * TimelineBenchmark.h: Times the preview and export of generated timelines
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef TIMELINEBENCHMARK_H
+#define TIMELINEBENCHMARK_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+#include <vector>
+
+namespace Backend
+{
+class IFilter;
+}
+class Media;
+class SequenceWorkflow;
+
+/**
+ *  \brief  Builds a timeline out of generated sources, and times its preview and export.
+ *
+ *  Nothing but VLMC and MLT is measured: the clips play MLT's noise and color
+ *  generators, and are added through SequenceWorkflow like the timeline would.
+ *  The preview is rendered to a null output, which doesn't display anything.
+ *  The results can be compared with the ones of a previous run, to catch regressions.
+ */
+class TimelineBenchmark
+{
+    public:
+        struct Config
+        {
+            quint32     tracks = 4;
+            quint32     clipsPerTrack = 20;
+            // In frames
+            quint32     clipLength = 50;
+            quint32     effectsPerClip = 0;
+            QString     effect = "brightness";
+            // Frames previewed and exported, from the beginning of the timeline
+            quint32     frames = 250;
+            quint32     width = 1280;
+            quint32     height = 720;
+            bool        exportRender = true;
+        };
+
+        explicit TimelineBenchmark( const Config& config );
+        ~TimelineBenchmark();
+
+        /**
+         *  \brief  Runs the benchmark, and returns its results, keyed by metric.
+         *
+         *  The metrics ending with "fps" are better when higher, the others are
+         *  durations in milliseconds.
+         */
+        QJsonObject     run();
+
+        /**
+         *  \brief  Lists the metrics which got worse than in baseline by more than
+         *          threshold, a ratio: 0.1 tolerates 10% worse results.
+         */
+        static QStringList  regressions( const QJsonObject& results, const QJsonObject& baseline,
+                                         double threshold );
+
+        // The frame size presets, from the smallest: 1080p, 4k and 8k
+        static QStringList  presets();
+        /**
+         *  \brief  Sets the frame size of config to the one of a preset.
+         *  \returns false if there is no such preset.
+         */
+        static bool         setPreset( Config& config, const QString& preset );
+
+    private:
+        void            build( QJsonObject& results );
+        void            measurePreview( QJsonObject& results );
+        void            measureExport( QJsonObject& results );
+
+    private:
+        Config                                          m_config;
+        // The sequence goes first, then the filters attached to its clips, then the medias
+        std::vector<std::unique_ptr<Media>>             m_medias;
+        std::vector<std::unique_ptr<Backend::IFilter>>  m_filters;
+        std::unique_ptr<SequenceWorkflow>               m_sequence;
+};
+
+#endif // TIMELINEBENCHMARK_H
@@ -0,0 +1,502 @@
+/*****************************************************************************
+ * TimelineImport.cpp: Reads the edit decision lists of other editors
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "Workflow/TimelineImport.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QUrl>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using TimelineImport::Event;
+
+namespace
+{
+
+// Medias are referred to by URL or by path, relative to the document
+QString
+resolvePath( const QDir& base, const QString& reference )
+{
+    auto path = reference;
+    QUrl url( reference );
+    if ( url.isLocalFile() == true )
+        path = url.toLocalFile();
+    if ( QFileInfo( path ).isRelative() == true )
+        path = base.absoluteFilePath( path );
+    return QFileInfo( path ).absoluteFilePath();
+}
+
+/*
+ *  CMX 3600
+ */
+
+// HH:MM:SS:FF, with a ';' before the frames for drop frame timecodes
+qint64
+parseTimecode( const QString& timecode, double fps )
+{
+    auto parts = timecode.split( QRegularExpression( "[:;.]" ) );
+    if ( parts.size() != 4 )
+        return -1;
+    qint64 nominal = qRound( fps );
+    qint64 h = parts[0].toLongLong();
+    qint64 m = parts[1].toLongLong();
+    auto frames = ( ( h * 60 + m ) * 60 + parts[2].toLongLong() ) * nominal + parts[3].toLongLong();
+    if ( timecode.contains( ';' ) == true && std::abs( fps - nominal ) > 0.001 )
+    {
+        // 2 frame numbers per 30 are skipped each minute, but every tenth one
+        auto dropped = nominal / 15;
+        auto minutes = h * 60 + m;
+        frames -= dropped * ( minutes - minutes / 10 );
+    }
+    return frames;
+}
+
+struct EdlEntry
+{
+    QString     reel;
+    QString     channels;
+    qint64      sourceIn;
+    qint64      recordIn;
+    qint64      recordOut;
+    // From the comments following the event
+    QString     clipName;
+    QString     sourceFile;
+};
+
+bool
+parseEdl( QFile& file, const QDir& base, double fps, QList<Event>& events, QString& error )
+{
+    static const QString timecode = "(\\d{2}[:;]\\d{2}[:;]\\d{2}[:;.]\\d{2})";
+    // Number, reel, channels, transition and its duration, source and record in & out
+    static const QRegularExpression eventLine( "^\\s*\\d+\\s+(\\S+)\\s+(\\S+)\\s+(?:C|D|W\\d+|K[BO]?)"
+                                               "(?:\\s+\\d+)?\\s+" + timecode + "\\s+" + timecode +
+                                               "\\s+" + timecode + "\\s+" + timecode + "\\s*$" );
+    static const QRegularExpression clipName( "^\\*\\s*FROM CLIP NAME:\\s*(.+)$" );
+    static const QRegularExpression sourceFile( "^\\*\\s*SOURCE FILE:\\s*(.+)$" );
+
+    QList<EdlEntry> entries;
+    QTextStream stream( &file );
+    while ( stream.atEnd() == false )
+    {
+        auto line = stream.readLine().trimmed();
+        auto match = eventLine.match( line );
+        if ( match.hasMatch() == true )
+        {
+            entries << EdlEntry{ match.captured( 1 ), match.captured( 2 ).toUpper(),
+                                 parseTimecode( match.captured( 3 ), fps ),
+                                 parseTimecode( match.captured( 5 ), fps ),
+                                 parseTimecode( match.captured( 6 ), fps ), QString(), QString() };
+            continue;
+        }
+        if ( entries.isEmpty() == true )
+            continue;
+        match = clipName.match( line );
+        if ( match.hasMatch() == true )
+            entries.last().clipName = match.captured( 1 ).trimmed();
+        match = sourceFile.match( line );
+        if ( match.hasMatch() == true )
+            entries.last().sourceFile = match.captured( 1 ).trimmed();
+    }
+    if ( entries.isEmpty() == true )
+    {
+        error = QObject::tr( "No event found" );
+        return false;
+    }
+
+    int link = 0;
+    for ( const auto& e : entries )
+    {
+        // Black and the outgoing side of transitions
+        if ( e.reel == "BL" || e.reel == "BLK" || e.recordOut <= e.recordIn || e.sourceIn < 0 )
+            continue;
+        auto reference = e.sourceFile;
+        if ( reference.isEmpty() == true )
+            reference = e.clipName.isEmpty() == false ? e.clipName : e.reel;
+        auto path = resolvePath( base, reference );
+        // The files of a conform are usually handed next to their list
+        if ( QFile::exists( path ) == false )
+            path = resolvePath( base, QFileInfo( reference ).fileName() );
+
+        // V, A, A2, AA, AA/V, B (both)...
+        bool video = e.channels == "B";
+        int audioTrack = e.channels == "B" ? 0 : -1;
+        for ( const auto& channel : e.channels.split( '/' ) )
+        {
+            if ( channel == "V" )
+                video = true;
+            else if ( channel == "A" || channel == "AA" || channel == "A1" )
+                audioTrack = 0;
+            else if ( channel.startsWith( 'A' ) == true && channel.mid( 1 ).toInt() > 1 )
+                audioTrack = channel.mid( 1 ).toInt() - 1;
+        }
+        auto length = e.recordOut - e.recordIn;
+        auto linkId = video == true && audioTrack >= 0 ? link++ : -1;
+        if ( video == true )
+            events << Event{ path, Workflow::VideoTrack, 0, e.recordIn, e.sourceIn, length, true, linkId };
+        if ( audioTrack >= 0 )
+            events << Event{ path, Workflow::AudioTrack, (quint32)audioTrack, e.recordIn, e.sourceIn,
+                             length, true, linkId };
+    }
+    return true;
+}
+
+/*
+ *  Final Cut Pro XML
+ */
+
+class FcpXmlReader
+{
+    public:
+        FcpXmlReader( QIODevice& device, const QDir& base, double fps )
+            : m_xml( &device )
+            , m_base( base )
+            , m_fps( fps )
+            , m_events( nullptr )
+            , m_nextLink( 0 )
+        {
+        }
+
+        bool
+        read( QList<Event>& events, QString& error )
+        {
+            m_events = &events;
+            while ( m_xml.atEnd() == false )
+            {
+                if ( m_xml.readNext() != QXmlStreamReader::StartElement )
+                    continue;
+                if ( m_xml.name() == "asset" )
+                    readAsset();
+                else if ( m_xml.name() == "sequence" )
+                    readSequence();
+            }
+            if ( m_xml.hasError() == true )
+            {
+                error = m_xml.errorString();
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        struct Asset
+        {
+            QString     path;
+            // The timestamp of the media's first frame
+            qint64      start;
+            bool        audio;
+            bool        video;
+        };
+
+        // Rational seconds, such as "1001/30000s"
+        qint64
+        time( const QXmlStreamAttributes& attributes, const char* name ) const
+        {
+            auto t = attributes.value( name ).toString();
+            if ( t.endsWith( 's' ) == true )
+                t.chop( 1 );
+            if ( t.isEmpty() == true )
+                return 0;
+            auto slash = t.indexOf( '/' );
+            double seconds = slash < 0 ? t.toDouble() : t.left( slash ).toDouble() / t.mid( slash + 1 ).toDouble();
+            return std::llround( seconds * m_fps );
+        }
+
+        void
+        readAsset()
+        {
+            auto attributes = m_xml.attributes();
+            Asset   asset{ attributes.value( "src" ).toString(), time( attributes, "start" ),
+                           attributes.value( "hasAudio" ) == "1", attributes.value( "hasVideo" ) == "1" };
+            auto id = attributes.value( "id" ).toString();
+            while ( m_xml.readNextStartElement() == true )
+            {
+                // Where the source is, from version 1.9 on
+                if ( m_xml.name() == "media-rep" && asset.path.isEmpty() == true )
+                    asset.path = m_xml.attributes().value( "src" ).toString();
+                m_xml.skipCurrentElement();
+            }
+            asset.path = resolvePath( m_base, asset.path );
+            m_assets.insert( id, asset );
+        }
+
+        void
+        readSequence()
+        {
+            auto start = time( m_xml.attributes(), "tcStart" );
+            while ( m_xml.readNextStartElement() == true )
+            {
+                if ( m_xml.name() == "spine" )
+                    readSpine( 0, start, 0 );
+                else
+                    m_xml.skipCurrentElement();
+            }
+        }
+
+        // The offsets of its items are in the time of the parent, which starts at parentStart
+        void
+        readSpine( qint64 parentPosition, qint64 parentStart, int lane )
+        {
+            while ( m_xml.readNextStartElement() == true )
+            {
+                if ( m_xml.name() == "transition" )
+                    m_xml.skipCurrentElement();
+                else
+                    readItem( parentPosition, parentStart, lane );
+            }
+        }
+
+        /*
+         *  Reads any item of a spine: clips, but also the gaps and titles, which may have
+         *  clips connected to them. Connected items have a lane, and their offset is in
+         *  the time of the item they are connected to.
+         */
+        void
+        readItem( qint64 parentPosition, qint64 parentStart, int lane )
+        {
+            auto name = m_xml.name().toString();
+            auto attributes = m_xml.attributes();
+            auto start = time( attributes, "start" );
+            auto duration = time( attributes, "duration" );
+            auto position = parentPosition + time( attributes, "offset" ) - parentStart;
+            if ( attributes.hasAttribute( "lane" ) == true )
+                lane = attributes.value( "lane" ).toInt();
+
+            QString     videoRef;
+            QString     audioRef;
+            // Where the media plays in the item's time, for the clips holding it in a child
+            qint64      videoDelta = 0;
+            qint64      audioDelta = 0;
+            if ( name == "asset-clip" || name == "video" )
+                videoRef = attributes.value( "ref" ).toString();
+            if ( name == "asset-clip" || name == "audio" )
+                audioRef = attributes.value( "ref" ).toString();
+            while ( m_xml.readNextStartElement() == true )
+            {
+                auto child = m_xml.attributes();
+                if ( child.hasAttribute( "lane" ) == true )
+                    readItem( position, start, lane );
+                else if ( m_xml.name() == "spine" )
+                    readSpine( position + time( child, "offset" ) - start, time( child, "start" ), lane );
+                else if ( m_xml.name() == "video" && videoRef.isEmpty() == true )
+                {
+                    videoRef = child.value( "ref" ).toString();
+                    videoDelta = time( child, "start" ) - time( child, "offset" );
+                    m_xml.skipCurrentElement();
+                }
+                else if ( m_xml.name() == "audio" && audioRef.isEmpty() == true )
+                {
+                    audioRef = child.value( "ref" ).toString();
+                    audioDelta = time( child, "start" ) - time( child, "offset" );
+                    m_xml.skipCurrentElement();
+                }
+                else
+                    m_xml.skipCurrentElement();
+            }
+            if ( duration <= 0 )
+                return;
+
+            auto video = m_assets.find( videoRef );
+            auto audio = m_assets.find( audioRef );
+            auto hasVideo = video != m_assets.end() && video->video == true;
+            auto hasAudio = audio != m_assets.end() && audio->audio == true;
+            auto link = hasVideo == true && hasAudio == true ? m_nextLink++ : -1;
+            // Lanes above the spine are video tracks, lanes below are audio tracks
+            quint32 trackId = std::abs( lane );
+            if ( hasVideo == true )
+                *m_events << Event{ video->path, Workflow::VideoTrack, trackId, position,
+                                    start + videoDelta - video->start, duration, false, link };
+            if ( hasAudio == true )
+                *m_events << Event{ audio->path, Workflow::AudioTrack, trackId, position,
+                                    start + audioDelta - audio->start, duration, false, link };
+        }
+
+    private:
+        QXmlStreamReader        m_xml;
+        QDir                    m_base;
+        double                  m_fps;
+        QHash<QString, Asset>   m_assets;
+        QList<Event>*           m_events;
+        int                     m_nextLink;
+};
+
+/*
+ *  OpenTimelineIO
+ */
+
+QString
+schema( const QJsonObject& object )
+{
+    // "Clip.1", "Clip.2"...
+    return object["OTIO_SCHEMA"].toString().section( '.', 0, 0 );
+}
+
+qint64
+rationalTime( const QJsonValue& time, double fps )
+{
+    auto object = time.toObject();
+    auto rate = object["rate"].toDouble();
+    if ( rate <= 0 )
+        return 0;
+    return std::llround( object["value"].toDouble() / rate * fps );
+}
+
+bool
+parseOtio( QFile& file, const QDir& base, double fps, QList<Event>& events, QString& error )
+{
+    QJsonParseError parseError;
+    auto document = QJsonDocument::fromJson( file.readAll(), &parseError );
+    if ( document.isObject() == false )
+    {
+        error = parseError.errorString();
+        return false;
+    }
+    auto timeline = document.object();
+    if ( schema( timeline ) != "Timeline" )
+    {
+        error = QObject::tr( "The document isn't a timeline" );
+        return false;
+    }
+    quint32 nbTracks[Workflow::NbTrackType] = {};
+    for ( const auto& t : timeline["tracks"].toObject()["children"].toArray() )
+    {
+        auto track = t.toObject();
+        if ( schema( track ) != "Track" )
+            continue;
+        auto type = track["kind"].toString() == "Audio" ? Workflow::AudioTrack : Workflow::VideoTrack;
+        auto trackId = nbTracks[type]++;
+        qint64 position = 0;
+        for ( const auto& i : track["children"].toArray() )
+        {
+            auto item = i.toObject();
+            // They overlap the items around them, and take no time
+            if ( schema( item ) == "Transition" )
+                continue;
+            auto range = item["source_range"].toObject();
+            auto reference = item["media_reference"].toObject();
+            // Clips hold several references from version 2 on
+            if ( item.contains( "media_references" ) == true )
+            {
+                auto key = QJsonValue( item["active_media_reference_key"] ).toString( "DEFAULT_MEDIA" );
+                reference = item["media_references"].toObject()[key].toObject();
+            }
+            auto available = reference["available_range"].toObject();
+            if ( range.isEmpty() == true )
+                range = available;
+            auto duration = rationalTime( range["duration"], fps );
+            if ( schema( item ) == "Clip" && schema( reference ) == "ExternalReference" && duration > 0 )
+            {
+                auto begin = rationalTime( range["start_time"], fps ) -
+                             rationalTime( available["start_time"], fps );
+                events << Event{ resolvePath( base, reference["target_url"].toString() ), type, trackId,
+                                 position, begin, duration, false, -1 };
+            }
+            position += duration;
+        }
+    }
+    return true;
+}
+
+}
+
+bool
+TimelineImport::parse( const QString& path, double fps, QList<Event>& events, QString& error )
+{
+    QFileInfo   info( path );
+    auto suffix = info.suffix().toLower();
+    // Bundles hold the document along with their medias
+    QFile       file( suffix == "fcpxmld" ? QDir( path ).filePath( "Info.fcpxml" ) : path );
+    if ( file.open( QIODevice::ReadOnly | QIODevice::Text ) == false )
+    {
+        error = file.errorString();
+        return false;
+    }
+    auto base = info.absoluteDir();
+    events.clear();
+    bool ret;
+    if ( suffix == "edl" )
+        ret = parseEdl( file, base, fps, events, error );
+    else if ( suffix == "fcpxml" || suffix == "fcpxmld" )
+        ret = FcpXmlReader( file, base, fps ).read( events, error );
+    else if ( suffix == "otio" )
+        ret = parseOtio( file, base, fps, events, error );
+    else
+    {
+        error = QObject::tr( "Unsupported format" );
+        return false;
+    }
+    if ( ret == false )
+        return false;
+
+    // Record timecodes usually start at 01:00:00:00
+    qint64 start = std::numeric_limits<qint64>::max();
+    for ( const auto& e : events )
+        start = std::min( start, e.position );
+    std::sort( events.begin(), events.end(), []( const Event& a, const Event& b ) {
+        if ( a.type != b.type )
+            return a.type < b.type;
+        if ( a.trackId != b.trackId )
+            return a.trackId < b.trackId;
+        return a.position < b.position;
+    } );
+    QList<Event>    res;
+    for ( auto e : events )
+    {
+        e.position -= start;
+        if ( res.isEmpty() == false && res.last().type == e.type && res.last().trackId == e.trackId )
+        {
+            // Transitions become cuts
+            auto overlap = res.last().position + res.last().length - e.position;
+            if ( overlap > 0 )
+            {
+                e.position += overlap;
+                e.begin += overlap;
+                e.length -= overlap;
+            }
+        }
+        if ( e.length > 0 )
+            res << e;
+    }
+    events = res;
+    return true;
+}
+
+QString
+TimelineImport::nameFilter()
+{
+    return QObject::tr( "Edit decision lists (*.edl *.fcpxml *.otio)" );
+}
@@ -0,0 +1,70 @@
+/*****************************************************************************
+ * TimelineImport.h: Reads the edit decision lists of other editors
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef TIMELINEIMPORT_H
+#define TIMELINEIMPORT_H
+
+#include <QList>
+#include <QString>
+
+#include "Workflow/Types.h"
+
+/**
+ *  \brief  Parsers of the timelines exchanged with other editors.
+ *
+ *  CMX 3600 EDLs (.edl), Final Cut Pro XML (.fcpxml) and OpenTimelineIO (.otio) are
+ *  read. They are reduced to the events VLMC can lay on its tracks: cuts of a media,
+ *  without their transitions and effects.
+ */
+namespace TimelineImport
+{
+    struct Event
+    {
+        // Absolute path of the media
+        QString             path;
+        Workflow::TrackType type;
+        quint32             trackId;
+        // On the imported timeline, which starts at 0, in frames of the project
+        qint64              position;
+        // First frame of the media played
+        qint64              begin;
+        qint64              length;
+        // begin is a source timecode, which may count from the media's own start
+        bool                sourceTimecode;
+        // The audio and video parts of the same clip share it, -1 for none
+        int                 link;
+    };
+
+    /**
+     *  \brief  Reads the timeline at path, picking the format from its extension.
+     *
+     *  Events are returned sorted by track and position. Those overlapping the
+     *  previous one of their track, such as the incoming side of a dissolve, are
+     *  trimmed so that they follow it.
+     *  \returns false if the file can't be read, with the reason in error.
+     */
+    bool            parse( const QString& path, double fps, QList<Event>& events, QString& error );
+    // The file dialog filter of the formats parse() reads
+    QString         nameFilter();
+}
+
+#endif // TIMELINEIMPORT_H
@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * TrimPreview.cpp: Plays around an edit point while it gets trimmed
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "TrimPreview.h"
+#include "SequenceWorkflow.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IProfile.h"
+#include "Backend/MLT/MLTLoopCache.h"
+#include "Media/Clip.h"
+#include "Renderer/AbstractRenderer.h"
+
+#include <cmath>
+
+TrimPreview::TrimPreview( std::shared_ptr<SequenceWorkflow> sequence, AbstractRenderer* renderer,
+                          const QUuid& uuid )
+    : m_sequence( std::move( sequence ) )
+    , m_renderer( renderer )
+    , m_uuid( uuid )
+{
+}
+
+TrimPreview::~TrimPreview()
+{
+    m_renderer->setLoop( 0, 0 );
+}
+
+bool
+TrimPreview::update()
+{
+    auto clip = m_sequence->clip( m_uuid );
+    if ( clip == nullptr )
+        return false;
+    auto roll = (qint64)std::lround( Roll * Backend::instance()->profile().fps() );
+    auto cut = m_sequence->position( m_uuid ) + clip->length();
+    pin( m_outgoing, m_uuid, true, roll );
+    pin( m_incoming, m_sequence->nextClip( m_uuid ), false, roll );
+    m_renderer->setLoop( qMax( 0ll, cut - roll ), cut + roll );
+    m_renderer->setPosition( qMax( 0ll, cut - roll ) );
+    if ( m_renderer->isRendering() == false || m_renderer->isPaused() == true )
+        m_renderer->togglePlayPause();
+    return true;
+}
+
+void
+TrimPreview::filterChanged( const Backend::IInput* target )
+{
+    for ( auto pinned : { &m_outgoing, &m_incoming } )
+    {
+        if ( pinned->input == target && pinned->cache != nullptr )
+            pinned->cache->clear();
+    }
+}
+
+void
+TrimPreview::pin( Pinned& pinned, const QUuid& uuid, bool tail, qint64 roll )
+{
+    auto clip = uuid.isNull() == true ? nullptr : m_sequence->clip( uuid );
+    auto input = clip != nullptr ? clip->input() : nullptr;
+    if ( input == nullptr )
+    {
+        pinned.cache.reset();
+        pinned.input = nullptr;
+        return;
+    }
+    // Rendered in place, or replaced by another clip
+    if ( input != pinned.input )
+    {
+        pinned.cache.reset( new Backend::MLT::MLTLoopCache( *input,
+                                    Backend::MLT::MLTLoopCache::MaxBytes / 4 ) );
+        pinned.input = input;
+    }
+    // The frames the cut may move over are kept too, so that going back and forth
+    // over the same frames doesn't decode them again
+    if ( tail == true )
+        pinned.cache->setRange( clip->length() - 2 * roll, clip->length() + roll );
+    else
+        pinned.cache->setRange( -roll, 2 * roll );
+}
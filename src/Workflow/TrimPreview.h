@@ -0,0 +1,86 @@
+/*****************************************************************************
+ * TrimPreview.h: Plays around an edit point while it gets trimmed
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef TRIMPREVIEW_H
+#define TRIMPREVIEW_H
+
+#include <QUuid>
+
+#include <memory>
+
+class AbstractRenderer;
+class SequenceWorkflow;
+
+namespace Backend
+{
+class IInput;
+namespace MLT
+{
+class MLTLoopCache;
+}
+}
+
+/**
+ *  \brief  Loops the playback around the cut following a clip, while it gets trimmed.
+ *
+ *  The renderer loops from Roll seconds before the cut to Roll seconds after it. The
+ *  end of the outgoing clip and the beginning of the incoming one are pinned in memory
+ *  as well, with a margin for the cut to move: the sequence frames a trim changes only
+ *  get composited again, their clips aren't decoded nor their effects applied.
+ */
+class TrimPreview
+{
+    public:
+        static const int        Roll = 2;
+
+        TrimPreview( std::shared_ptr<SequenceWorkflow> sequence, AbstractRenderer* renderer,
+                     const QUuid& uuid );
+        ~TrimPreview();
+
+        /**
+         *  \brief  Moves the loop back around the cut, after the clips were edited, and
+         *          plays it from its beginning.
+         *
+         *  Returns false once the clip is gone.
+         */
+        bool                    update();
+        // The effects of target changed, the images pinned for it are stale
+        void                    filterChanged( const Backend::IInput* target );
+
+    private:
+        struct Pinned
+        {
+            const Backend::IInput*                      input = nullptr;
+            std::unique_ptr<Backend::MLT::MLTLoopCache> cache;
+        };
+
+        void                    pin( Pinned& pinned, const QUuid& uuid, bool tail, qint64 roll );
+
+    private:
+        std::shared_ptr<SequenceWorkflow>   m_sequence;
+        AbstractRenderer*       m_renderer;
+        const QUuid             m_uuid;
+        Pinned                  m_outgoing;
+        Pinned                  m_incoming;
+};
+
+#endif // TRIMPREVIEW_H
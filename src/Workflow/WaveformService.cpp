@@ -0,0 +1,454 @@
+/*****************************************************************************
+ * WaveformService.cpp: Computes and caches audio peaks of the medias
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "WaveformService.h"
+
+#include "Backend/IBackend.h"
+#include "Backend/IInput.h"
+#include "Backend/MLT/MLTService.h"
+#include "Tools/FileHash.h"
+#include "Tools/SampleReduction.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSaveFile>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+const QString   WaveformService::SubDirectory = ".waveforms";
+
+namespace
+{
+    const char          Magic[4] = { 'V', 'W', 'F', 'P' };
+    const quint32       Version = 2;
+
+    struct Header
+    {
+        char        magic[4];
+        quint32     version;
+        double      fps;
+        qint64      nbSamples;
+        quint32     counts[WaveformPeaks::NbLevels];
+        Tools::Loudness     loudness;
+    };
+
+    class Accumulator
+    {
+        public:
+            Accumulator() { reset(); }
+            void    add( const Tools::SampleStats& stats, quint32 nbSamples, quint32 channels )
+            {
+                m_min = std::min( m_min, stats.min );
+                m_max = std::max( m_max, stats.max );
+                m_sumSq += stats.sumSq;
+                m_count += nbSamples;
+                m_nbValues += nbSamples * channels;
+            }
+            void    add( const WaveformPeaks::Peak& peak )
+            {
+                m_min = std::min( m_min, peak.min );
+                m_max = std::max( m_max, peak.max );
+                m_sumSq += (double)peak.rms * peak.rms;
+                ++m_count;
+                ++m_nbValues;
+            }
+            quint32 count() const { return m_count; }
+            WaveformPeaks::Peak peak() const
+            {
+                return WaveformPeaks::Peak{ m_min, m_max,
+                            (quint16)std::sqrt( m_sumSq / std::max( 1u, m_nbValues ) ) };
+            }
+            void    reset()
+            {
+                m_min = std::numeric_limits<qint16>::max();
+                m_max = std::numeric_limits<qint16>::min();
+                m_sumSq = 0;
+                m_count = 0;
+                m_nbValues = 0;
+            }
+
+        private:
+            qint16      m_min;
+            qint16      m_max;
+            double      m_sumSq;
+            quint32     m_count;
+            quint32     m_nbValues;
+    };
+}
+
+class WaveformJob : public QRunnable
+{
+    public:
+        WaveformJob( WaveformService* service, const QString& filePath )
+            : m_service( service )
+            , m_filePath( filePath )
+        {
+        }
+
+        virtual void run() override
+        {
+            m_service->process( m_filePath );
+        }
+
+    private:
+        WaveformService*    m_service;
+        QString             m_filePath;
+};
+
+WaveformPeaks::WaveformPeaks()
+    : m_fps( 0 )
+    , m_nbSamples( 0 )
+{
+}
+
+double
+WaveformPeaks::fps() const
+{
+    return m_fps;
+}
+
+quint32
+WaveformPeaks::frequency() const
+{
+    return Frequency;
+}
+
+qint64
+WaveformPeaks::nbSamples() const
+{
+    return m_nbSamples;
+}
+
+quint32
+WaveformPeaks::blockSize( int level ) const
+{
+    quint32 size = BaseBlockSize;
+    for ( int i = 0; i < level; ++i )
+        size *= LevelFactor;
+    return size;
+}
+
+const QVector<WaveformPeaks::Peak>&
+WaveformPeaks::level( int level ) const
+{
+    Q_ASSERT( level >= 0 && level < NbLevels );
+    return m_levels[level];
+}
+
+const Tools::Loudness&
+WaveformPeaks::loudness() const
+{
+    return m_loudness;
+}
+
+int
+WaveformPeaks::levelFor( double samplesPerPixel ) const
+{
+    int level = 0;
+    while ( level + 1 < NbLevels && blockSize( level + 1 ) <= samplesPerPixel )
+        ++level;
+    return level;
+}
+
+bool
+WaveformPeaks::save( const QString& path ) const
+{
+    if ( QDir().mkpath( QFileInfo( path ).absolutePath() ) == false )
+        return false;
+    Header header;
+    memcpy( header.magic, Magic, sizeof( Magic ) );
+    header.version = Version;
+    header.fps = m_fps;
+    header.nbSamples = m_nbSamples;
+    for ( int i = 0; i < NbLevels; ++i )
+        header.counts[i] = m_levels[i].size();
+    header.loudness = m_loudness;
+
+    QSaveFile   file( path );
+    if ( file.open( QFile::WriteOnly ) == false )
+        return false;
+    file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    for ( const auto& l : m_levels )
+        file.write( reinterpret_cast<const char*>( l.constData() ), l.size() * sizeof( Peak ) );
+    return file.commit();
+}
+
+std::shared_ptr<WaveformPeaks>
+WaveformPeaks::load( const QString& path )
+{
+    QFile   file( path );
+    if ( file.open( QFile::ReadOnly ) == false )
+        return nullptr;
+    Header header;
+    if ( file.read( reinterpret_cast<char*>( &header ), sizeof( header ) ) != sizeof( header ) ||
+         memcmp( header.magic, Magic, sizeof( Magic ) ) != 0 || header.version != Version )
+        return nullptr;
+    qint64 expected = sizeof( header );
+    for ( auto c : header.counts )
+        expected += (qint64)c * sizeof( Peak );
+    if ( file.size() != expected )
+        return nullptr;
+
+    std::shared_ptr<WaveformPeaks> peaks( new WaveformPeaks );
+    peaks->m_fps = header.fps;
+    peaks->m_nbSamples = header.nbSamples;
+    peaks->m_loudness = header.loudness;
+    for ( int i = 0; i < NbLevels; ++i )
+    {
+        peaks->m_levels[i].resize( header.counts[i] );
+        auto size = (qint64)header.counts[i] * sizeof( Peak );
+        if ( file.read( reinterpret_cast<char*>( peaks->m_levels[i].data() ), size ) != size )
+            return nullptr;
+    }
+    return peaks;
+}
+
+std::shared_ptr<WaveformPeaks>
+WaveformPeaks::compute( Backend::IInput& input, const std::atomic_bool& abort,
+                        Tools::PcmCache::Writer* pcm )
+{
+    std::shared_ptr<WaveformPeaks> peaks( new WaveformPeaks );
+    peaks->m_fps = input.fps();
+    if ( peaks->m_fps <= 0 )
+        return nullptr;
+
+    static_assert( Frequency == Tools::LoudnessMeter::Frequency, "The loudness is measured on the decoded samples" );
+    Tools::LoudnessMeter    meter( Channels );
+    Accumulator acc;
+    auto& base = peaks->m_levels[0];
+    // Splits a frame worth of samples along the block boundaries, and hands each chunk
+    // to the vectorized reduction. Interleaved channels are reduced together.
+    auto feed = [&acc, &base]( const int16_t* samples, quint32 nbSamples, quint32 channels )
+    {
+        while ( nbSamples > 0 )
+        {
+            auto chunk = std::min( nbSamples, BaseBlockSize - acc.count() );
+            acc.add( Tools::reduceSamples( samples, chunk * channels ), chunk, channels );
+            samples += chunk * channels;
+            nbSamples -= chunk;
+            if ( acc.count() == BaseBlockSize )
+            {
+                base.append( acc.peak() );
+                acc.reset();
+            }
+        }
+    };
+
+    QVector<int16_t> silence;
+    auto length = input.length();
+    // Positions are consecutive, so the producer decodes forward without seeking
+    for ( int64_t f = 0; f < length; ++f )
+    {
+        if ( abort == true )
+            return nullptr;
+        input.setPosition( f );
+        auto audio = input.audio( Frequency, Channels );
+        if ( audio == nullptr || audio->channels() == 0 )
+        {
+            // Keep the following peaks aligned with their frames
+            auto missing = (quint32)( Frequency / peaks->m_fps );
+            if ( (quint32)silence.size() < missing * Channels )
+                silence.fill( 0, missing * Channels );
+            feed( silence.constData(), missing, Channels );
+            meter.add( silence.constData(), missing );
+            if ( pcm != nullptr )
+                pcm->write( silence.constData(), missing );
+            peaks->m_nbSamples += missing;
+            continue;
+        }
+        feed( audio->samples(), audio->nbSamples(), audio->channels() );
+        // The cache and the meter expect a fixed layout, whatever the backend returned
+        auto samples = audio->samples();
+        QVector<int16_t> converted;
+        if ( audio->channels() != Channels )
+        {
+            converted.resize( audio->nbSamples() * Channels );
+            for ( quint32 i = 0; i < audio->nbSamples(); ++i )
+            {
+                for ( quint32 c = 0; c < Channels; ++c )
+                    converted[i * Channels + c] = samples[i * audio->channels() +
+                                                          std::min( c, audio->channels() - 1 )];
+            }
+            samples = converted.constData();
+        }
+        meter.add( samples, audio->nbSamples() );
+        if ( pcm != nullptr )
+            pcm->write( samples, audio->nbSamples() );
+        peaks->m_nbSamples += audio->nbSamples();
+    }
+    if ( acc.count() > 0 )
+        base.append( acc.peak() );
+
+    for ( int l = 1; l < NbLevels; ++l )
+    {
+        acc.reset();
+        for ( const auto& p : peaks->m_levels[l - 1] )
+        {
+            acc.add( p );
+            if ( acc.count() == LevelFactor )
+            {
+                peaks->m_levels[l].append( acc.peak() );
+                acc.reset();
+            }
+        }
+        if ( acc.count() > 0 )
+            peaks->m_levels[l].append( acc.peak() );
+    }
+    peaks->m_loudness = meter.result();
+    return peaks;
+}
+
+WaveformService::WaveformService( QObject* parent )
+    : QObject( parent )
+    , m_abort( false )
+{
+    // This is mostly IO bound, and meant to run alongside the thumbnails
+    m_pool.setMaxThreadCount( 2 );
+}
+
+WaveformService::~WaveformService()
+{
+    m_abort = true;
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void
+WaveformService::setDirectory( const QString& cacheDir )
+{
+    QMutexLocker    lock( &m_mutex );
+    if ( cacheDir.isEmpty() == true )
+        m_directory.clear();
+    else
+        m_directory = cacheDir + '/' + SubDirectory;
+}
+
+std::shared_ptr<const WaveformPeaks>
+WaveformService::peaks( const QString& filePath )
+{
+    QMutexLocker    lock( &m_mutex );
+    auto it = m_peaks.find( filePath );
+    if ( it != m_peaks.end() )
+        return it.value();
+    schedule( filePath );
+    return nullptr;
+}
+
+std::shared_ptr<const Tools::PcmCache>
+WaveformService::pcm( const QString& filePath )
+{
+    QMutexLocker    lock( &m_mutex );
+    auto it = m_pcm.find( filePath );
+    if ( it != m_pcm.end() )
+        return it.value();
+    // The peaks being known means the cache couldn't be written, don't try again
+    if ( m_peaks.contains( filePath ) == false )
+        schedule( filePath );
+    return nullptr;
+}
+
+void
+WaveformService::schedule( const QString& filePath )
+{
+    if ( m_pending.contains( filePath ) == true )
+        return;
+    m_pending.insert( filePath );
+    m_pool.start( new WaveformJob( this, filePath ) );
+}
+
+QString
+WaveformService::cachePath( const QString& filePath )
+{
+    QString directory;
+    {
+        QMutexLocker    lock( &m_mutex );
+        directory = m_directory;
+    }
+    if ( directory.isEmpty() == true )
+        return QString();
+    auto hash = Tools::contentHash( filePath );
+    if ( hash.isEmpty() == true )
+        return QString();
+    return directory + '/' + QString::fromLatin1( hash );
+}
+
+void
+WaveformService::process( const QString& filePath )
+{
+    auto path = cachePath( filePath );
+    auto peaksPath = path + ".peaks";
+    auto pcmPath = path + ".pcm";
+    std::shared_ptr<WaveformPeaks> peaks;
+    std::shared_ptr<Tools::PcmCache> pcm;
+    if ( path.isEmpty() == false )
+    {
+        peaks = WaveformPeaks::load( peaksPath );
+        pcm = Tools::PcmCache::open( pcmPath );
+    }
+    // Caches from before the PCM one existed get decoded again
+    if ( peaks == nullptr || ( pcm == nullptr && path.isEmpty() == false ) )
+    {
+        peaks = nullptr;
+        std::unique_ptr<Tools::PcmCache::Writer> writer;
+        if ( path.isEmpty() == false )
+            writer.reset( new Tools::PcmCache::Writer( pcmPath, WaveformPeaks::Frequency,
+                                                       WaveformPeaks::Channels ) );
+        try
+        {
+            auto input = Backend::instance()->acquireInput( qPrintable( filePath ) );
+            if ( input->hasAudio() == true )
+                peaks = WaveformPeaks::compute( *input, m_abort, writer.get() );
+        }
+        catch ( Backend::InvalidServiceException& )
+        {
+            vlmcWarning() << "Can't compute the waveform of" << filePath;
+        }
+        if ( peaks != nullptr && path.isEmpty() == false )
+        {
+            if ( peaks->save( peaksPath ) == false )
+                vlmcWarning() << "Failed to save waveform peaks to" << peaksPath;
+            if ( writer->commit() == true )
+                pcm = Tools::PcmCache::open( pcmPath );
+            else
+                vlmcWarning() << "Failed to save the PCM cache to" << pcmPath;
+        }
+    }
+
+    {
+        QMutexLocker    lock( &m_mutex );
+        m_pending.remove( filePath );
+        // Don't try again for medias without audio: an empty set of peaks is cached
+        if ( peaks == nullptr && m_abort == false )
+            peaks.reset( new WaveformPeaks );
+        if ( peaks != nullptr )
+            m_peaks.insert( filePath, peaks );
+        if ( pcm != nullptr )
+            m_pcm.insert( filePath, pcm );
+    }
+    if ( m_abort == false )
+        emit peaksReady( filePath );
+}
@@ -0,0 +1,167 @@
+/*****************************************************************************
+ * WaveformService.h: Computes and caches audio peaks of the medias
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef WAVEFORMSERVICE_H
+#define WAVEFORMSERVICE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+#include "Tools/Loudness.h"
+#include "Tools/PcmCache.h"
+
+namespace Backend
+{
+class IInput;
+}
+
+/**
+ *  \brief  Audio peaks of a whole media, at several zoom levels.
+ *
+ *  Each peak summarizes a fixed block of samples, of every channel.
+ *  Every level is LevelFactor times coarser than the previous one.
+ */
+class WaveformPeaks
+{
+    public:
+        struct Peak
+        {
+            qint16      min;
+            qint16      max;
+            quint16     rms;
+        };
+
+        static const quint32    Frequency = 48000;
+        static const quint32    Channels = 2;
+        static const quint32    BaseBlockSize = 256;
+        static const quint32    LevelFactor = 8;
+        static const int        NbLevels = 4;
+
+        double                  fps() const;
+        quint32                 frequency() const;
+        qint64                  nbSamples() const;
+        quint32                 blockSize( int level ) const;
+        const QVector<Peak>&    level( int level ) const;
+        /**
+         *  \brief  The EBU R128 loudness of the media, measured along with the peaks.
+         */
+        const Tools::Loudness&  loudness() const;
+        /**
+         *  \returns    The coarsest level which still has a peak per samplesPerPixel
+         */
+        int                     levelFor( double samplesPerPixel ) const;
+
+        bool                    save( const QString& path ) const;
+        static std::shared_ptr<WaveformPeaks>   load( const QString& path );
+        /**
+         *  \brief  Decodes the whole input audio. Returns nullptr when aborted.
+         *
+         *  \param  pcm     If not null, receives the decoded samples, which saves a second
+         *                  decoding pass to build the PCM cache.
+         */
+        static std::shared_ptr<WaveformPeaks>   compute( Backend::IInput& input,
+                                                         const std::atomic_bool& abort,
+                                                         Tools::PcmCache::Writer* pcm = nullptr );
+
+    private:
+        WaveformPeaks();
+
+    private:
+        double          m_fps;
+        qint64          m_nbSamples;
+        QVector<Peak>   m_levels[NbLevels];
+        Tools::Loudness m_loudness;
+
+        friend class WaveformService;
+};
+
+/**
+ *  \brief  Serves the peaks of a media, computing them once in the background.
+ *
+ *  Peaks are stored in the cache directory, keyed by the media content hash. The
+ *  same decoding pass stores the samples in a PCM cache, next to them, which serves
+ *  the audio when scrubbing. \sa Tools::PcmCache
+ */
+class WaveformService : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static const QString    SubDirectory;
+
+        explicit WaveformService( QObject* parent = nullptr );
+        ~WaveformService();
+
+        /**
+         *  \brief  Sets the cache directory. An empty path disables the disk cache.
+         */
+        void                    setDirectory( const QString& cacheDir );
+
+        /**
+         *  \brief  Returns the peaks for the given file, if they are available.
+         *
+         *  Otherwise, this schedules their computation and returns nullptr.
+         *  peaksReady() will be emitted once they are.
+         */
+        std::shared_ptr<const WaveformPeaks>    peaks( const QString& filePath );
+        /**
+         *  \brief  Returns the PCM cache of the given file, if it is available.
+         *
+         *  Otherwise, this schedules its computation along with the peaks, and returns
+         *  nullptr. It is never available without a cache directory.
+         */
+        std::shared_ptr<const Tools::PcmCache>  pcm( const QString& filePath );
+
+    private:
+        void                    schedule( const QString& filePath );
+        void                    process( const QString& filePath );
+        // Without the extension
+        QString                 cachePath( const QString& filePath );
+
+    private:
+        QThreadPool                                             m_pool;
+        QMutex                                                  m_mutex;
+        QString                                                 m_directory;
+        QHash<QString, std::shared_ptr<const WaveformPeaks>>    m_peaks;
+        QHash<QString, std::shared_ptr<const Tools::PcmCache>>  m_pcm;
+        QSet<QString>                                           m_pending;
+        std::atomic_bool                                        m_abort;
+
+        friend class WaveformJob;
+
+    signals:
+        /**
+         *  \brief  Emitted from a worker thread, once the peaks of filePath are available.
+         *
+         *  Its PCM cache is available as well by then, unless it couldn't be written.
+         */
+        void                    peaksReady( const QString& filePath );
+};
+
+#endif // WAVEFORMSERVICE_H